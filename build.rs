@@ -22,6 +22,34 @@ fn build_pixelscript_h() {
         .write_to_file(output_file);
 }
 
+/// Flags for the wasm32 targets, false when not building for one.
+///
+/// `-msimd128` when Rust targets `simd128` (`-C target-feature=+simd128`) so the C/C++ kernels get vector paths,
+/// shared memory and pthreads when it targets `atomics` (the threads variant).
+fn build_wasm(build: &mut cc::Build) -> bool {
+    if env::var("CARGO_CFG_TARGET_ARCH").unwrap_or_default() != "wasm32" {
+        return false;
+    }
+    let features = env::var("CARGO_CFG_TARGET_FEATURE").unwrap_or_default();
+    let has = |name: &str| features.split(',').any(|f| f == name);
+
+    if has("simd128") {
+        build.flag("-msimd128");
+    }
+    if has("atomics") {
+        build.flag("-matomics");
+        build.flag("-mbulk-memory");
+        build.flag("-pthread");
+    }
+    true
+}
+
+/// Threads are only there in the shared memory variant of wasm32.
+fn wasm_threads() -> bool {
+    env::var("CARGO_CFG_TARGET_ARCH").unwrap_or_default() == "wasm32"
+        && env::var("CARGO_CFG_TARGET_FEATURE").unwrap_or_default().split(',').any(|f| f == "atomics")
+}
+
 #[cfg(feature = "lua")]
 fn build_lua(target_os: &str, target_env: &str) {
     let mut build = cc::Build::new();
@@ -54,6 +82,15 @@ fn build_lua(target_os: &str, target_env: &str) {
         build.flag("-fPIC");
         build.std("c99");
     }
+    build_wasm(&mut build);
+
+    // LuaJIT is not vendored, `luajit` builds the same interpreter tuned for speed.
+    if cfg!(feature = "luajit") && target_env != "msvc" {
+        build.flag("-fomit-frame-pointer");
+        build.flag_if_supported("-fno-plt");
+        build.flag_if_supported("-fno-semantic-interposition");
+        build.flag_if_supported("-fno-stack-protector");
+    }
 
     if target_os == "linux" {
         build.define("LUA_USE_LINUX", None);
@@ -79,13 +116,19 @@ fn build_pocketpy(_target_os: &str, target_env: &str) {
     // Set c11
     build.std("c11");
 
+    // PK_MALLOC and friends, so pocketpy allocates through `pxs_setalloc`.
+    let alloc_header = PathBuf::from(env::var("CARGO_MANIFEST_DIR").unwrap()).join("libs/pxs_python/pxs_python_alloc.h");
+
     // When MSVC, gotta set some stuff
     if target_env == "msvc" {
+        build.flag(format!("/FI{}", alloc_header.display()));
         build.flag("/utf-8");
         build.flag("/experimental:c11atomics");
         // Compile as a static lib
         build.static_crt(true);
     } else {
+        build.flag("-include");
+        build.flag(alloc_header.display().to_string());
         build.flag("-O3");
         build.flag("-fPIC");
     }
@@ -100,6 +143,10 @@ fn build_pocketpy(_target_os: &str, target_env: &str) {
     // Remove PK_ENABLE_THREADS since PixelScript is single threaded (in theory at least)
     build.define("PK_ENABLE_THREADS", "0");
 
+    // Used for the time limit of `pxs_setbudget`.
+    build.define("PK_ENABLE_WATCHDOG", "1");
+    build_wasm(&mut build);
+
     // Now we can compile pocketpy.
     build.compile("pocketpy");
 }
@@ -123,13 +170,14 @@ fn build_quickjsng(_target_os: &str, target_env: &str) {
         build.flag("-fno-exceptions");
         build.flag("-fno-asynchronous-unwind-tables");
     }
+    build_wasm(&mut build);
 
     build.compile("quickjs");
 }
 
 /// Build the yoyo core.
 #[cfg(feature="yoyo")]
-fn build_yoyo(_target_os: &str, target_env: &str) {
+fn build_yoyo(target_os: &str, target_env: &str) {
     let mut build = cc::Build::new();
     build.warnings(false);
     build.cpp(true);
@@ -140,6 +188,26 @@ fn build_yoyo(_target_os: &str, target_env: &str) {
     build.include("./");
     build.file("core/yoyo/src/yoyo.cpp");
     build.file("core/yoyo/src/utils/exceptions.cpp");
+    build.file("core/yoyo/src/utils/cpu.cpp");
+
+    // Without the threads variant the worker pool runs its jobs inline and what needs threads of its own is left out.
+    let wasm = build_wasm(&mut build);
+    let threads = !wasm || wasm_threads();
+    if !threads {
+        build.define("YOYO_NO_THREADS", None);
+    }
+    if target_os == "emscripten" {
+        // yaml and zip catch exceptions, emscripten aborts on a throw by default.
+        build.flag("-fwasm-exceptions");
+        println!("cargo:rustc-link-arg=-fwasm-exceptions");
+    }
+
+    // `read_json` of `yoyo.fs` and `yoyo.zip` stream into `pxs_json_newstream`.
+    #[cfg(feature="pxs_json")]
+    build.define("PXS_JSON", None);
+
+    #[cfg(any(feature="yoyo_net", feature="yoyo_zip", feature="yoyo_compress"))]
+    build.file("core/yoyo/src/utils/miniz.cpp");
 
     #[cfg(feature="yoyo_os")] 
     {
@@ -147,29 +215,114 @@ fn build_yoyo(_target_os: &str, target_env: &str) {
         build.define("YOYO_OS", None);
     }
     #[cfg(feature="yoyo_net")]
-    {
+    if wasm {
+        println!("cargo:warning=yoyo_net has no sockets on wasm32, left out.");
+    } else {
         build.file("core/yoyo/src/net.cpp");
+        build.file("core/yoyo/src/net_server.cpp");
         build.define("YOYO_NET", None);
+
+        if target_os == "windows" {
+            // Winsock for `net.serve`.
+            println!("cargo:rustc-link-lib=ws2_32");
+        }
+
+        if target_os == "macos" || target_os == "ios" {
+            // SecureTransport
+            println!("cargo:rustc-link-lib=framework=Security");
+            println!("cargo:rustc-link-lib=framework=CoreFoundation");
+        }
+
+        #[cfg(feature="yoyo_net_tls")]
+        if target_os != "windows" && target_os != "macos" && target_os != "ios" {
+            build.define("YOYO_NET_OPENSSL", None);
+            println!("cargo:rustc-link-lib=ssl");
+            println!("cargo:rustc-link-lib=crypto");
+        }
     }
-    #[cfg(feature="yoyo_shell")]
+    #[cfg(feature="yoyo_pxs")]
     {
+        build.file("core/yoyo/src/pxs.cpp");
+        build.define("YOYO_PXS", None);
+    }
+    #[cfg(feature="yoyo_task")]
+    if !threads {
+        println!("cargo:warning=yoyo_task needs the wasm32 threads variant (`-C target-feature=+atomics,+bulk-memory`), left out.");
+    } else {
+        build.file("core/yoyo/src/task.cpp");
+        build.define("YOYO_TASK", None);
+    }
+    #[cfg(feature="yoyo_channel")]
+    {
+        build.file("core/yoyo/src/channel.cpp");
+        build.define("YOYO_CHANNEL", None);
+    }
+    #[cfg(feature="yoyo_time")]
+    {
+        build.file("core/yoyo/src/time.cpp");
+        build.define("YOYO_TIME", None);
+    }
+    #[cfg(feature="yoyo_shm")]
+    if wasm {
+        println!("cargo:warning=yoyo_shm has no shared memory objects on wasm32, left out.");
+    } else {
+        build.file("core/yoyo/src/shm.cpp");
+        build.define("YOYO_SHM", None);
+
+        if target_os == "linux" {
+            // `shm_open` before glibc 2.34.
+            println!("cargo:rustc-link-lib=rt");
+        }
+    }
+    #[cfg(feature="yoyo_compress")]
+    {
+        build.file("core/yoyo/src/compress.cpp");
+        build.define("YOYO_COMPRESS", None);
+    }
+    #[cfg(feature="yoyo_hash")]
+    {
+        build.file("core/yoyo/src/hash.cpp");
+        build.define("YOYO_HASH", None);
+    }
+    #[cfg(feature="yoyo_shell")]
+    if wasm {
+        println!("cargo:warning=yoyo_shell can not start processes on wasm32, left out.");
+    } else {
         build.file("core/yoyo/src/shell.cpp");
         build.define("YOYO_SHELL", None);
     }
     #[cfg(feature="yoyo_core")]
     {
+        build.file("core/yoyo/src/utils/log.cpp");
         build.define("YOYO_CORE", None);
     }
     #[cfg(feature="yoyo_fs")]
     {
         build.file("core/yoyo/src/fs.cpp");
+        build.file("core/yoyo/src/fs_watch.cpp");
         build.define("YOYO_FS", None);
+
+        if target_os == "macos" {
+            // FSEvents for `fs.watch`.
+            println!("cargo:rustc-link-lib=framework=CoreServices");
+            println!("cargo:rustc-link-lib=framework=CoreFoundation");
+        }
     }
     #[cfg(feature="yoyo_zip")]
     {
         build.file("core/yoyo/src/zip.cpp");
         build.define("YOYO_ZIP", None);
     }
+    #[cfg(feature="yoyo_yaml")]
+    {
+        build.file("core/yoyo/src/yaml.cpp");
+        build.define("YOYO_YAML", None);
+    }
+    #[cfg(feature="yoyo_array")]
+    {
+        build.file("core/yoyo/src/array.cpp");
+        build.define("YOYO_ARRAY", None);
+    }
 
     if target_env == "msvc" {
         build.static_crt(true);
@@ -292,6 +445,16 @@ fn main() {
     let target_os = env::var("CARGO_CFG_TARGET_OS").unwrap();
     let target_env = env::var("CARGO_CFG_TARGET_ENV").unwrap_or_default();
 
+    if target_os == "emscripten" {
+        // The heap of a page grows with its scripts.
+        println!("cargo:rustc-link-arg=-sALLOW_MEMORY_GROWTH=1");
+        if wasm_threads() {
+            // Workers are made up front, a page can not block waiting for one.
+            println!("cargo:rustc-link-arg=-pthread");
+            println!("cargo:rustc-link-arg=-sPTHREAD_POOL_SIZE=navigator.hardwareConcurrency");
+        }
+    }
+
     // Compile lua
     #[cfg(feature = "lua")]
     {
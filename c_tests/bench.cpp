@@ -0,0 +1,225 @@
+// Throughput benchmarks for `yoyo.fs` and `yoyo.zip`.
+//
+// Every measurement runs a small python loop through `pxs_exec` and is timed from the host, so the numbers
+// include one script call per operation (what scripts actually pay).
+// Results are written to stdout as JSON. Pass a directory to use instead of `pxs_bench` in the cwd.
+
+#include "pixelscript.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+    struct Result {
+        std::string name;
+        double value;
+    };
+
+    // Peak resident set size of the process so far in KiB.
+    uint64_t peak_rss_kb() {
+    #if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            return counters.PeakWorkingSetSize / 1024;
+        }
+        return 0;
+    #else
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+    #if defined(__APPLE__)
+        return static_cast<uint64_t>(usage.ru_maxrss) / 1024;
+    #else
+        return static_cast<uint64_t>(usage.ru_maxrss);
+    #endif
+    #endif
+    }
+
+    // Run `code` and return the seconds it took, negative when it failed.
+    double run(const std::string& code) {
+        auto start = std::chrono::steady_clock::now();
+        auto res = pxs_exec(pxs_Python, code.c_str(), "bench");
+        auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (res && !pxs_varis(res, pxs_Null)) {
+            auto msg = pxs_getstring(res);
+            std::fprintf(stderr, "bench script failed: %s\n", msg ? msg : "unknown error");
+            if (msg) {
+                pxs_freestr(msg);
+            }
+            seconds = -1;
+        }
+        if (res) {
+            pxs_freevar(res);
+        }
+        return seconds;
+    }
+
+    double mb_per_s(uint64_t bytes, double seconds) {
+        return seconds > 0 ? static_cast<double>(bytes) / (1024.0 * 1024.0) / seconds : 0;
+    }
+
+    void write_file(const std::filesystem::path& path, size_t size) {
+        std::string data(size, '\0');
+        for (size_t i = 0; i < size; i++) {
+            // Text, so it can be read as a string. Repeats enough to be compressible but not trivially.
+            data[i] = static_cast<char>('a' + (i * 7 + i / 13) % 26);
+        }
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    // Iterations so a measurement moves about `target` bytes.
+    size_t iterations_for(size_t size, size_t target = 64 << 20) {
+        auto n = target / size;
+        return n < 4 ? 4 : (n > 20000 ? 20000 : n);
+    }
+
+    void print_results(const char* name, const std::vector<Result>& results, bool last = false) {
+        std::printf("    \"%s\": {", name);
+        for (size_t i = 0; i < results.size(); i++) {
+            std::printf("%s\"%s\": %.3f", i == 0 ? "" : ", ", results[i].name.c_str(), results[i].value);
+        }
+        std::printf("}%s\n", last ? "" : ",");
+    }
+}
+
+int main(int argc, char** argv) {
+    std::filesystem::path root = argc > 1 ? argv[1] : "pxs_bench";
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root);
+    auto dir = root.generic_string();
+
+    pxs_initialize();
+    pxs_yoyoinit();
+
+    std::vector<size_t> sizes = {4 << 10, 64 << 10, 1 << 20, 16 << 20};
+
+    // fs.read_file by size, text and mapped.
+    std::vector<Result> read_results;
+    std::vector<Result> mapped_results;
+    std::vector<Result> write_results;
+    for (auto size : sizes) {
+        auto path = dir + "/read_" + std::to_string(size) + ".txt";
+        write_file(path, size);
+        auto n = iterations_for(size);
+        auto key = std::to_string(size);
+
+        auto seconds = run(
+            "from yoyo import fs\n"
+            "for _ in range(" + std::to_string(n) + "):\n"
+            "    fs.read_file('" + path + "')\n"
+        );
+        read_results.push_back({key, mb_per_s(static_cast<uint64_t>(size) * n, seconds)});
+
+        seconds = run(
+            "from yoyo import fs\n"
+            "for _ in range(" + std::to_string(n) + "):\n"
+            "    fs.read_file('" + path + "', fs.FILE_READ_TYPE_MAPPED)\n"
+        );
+        mapped_results.push_back({key, mb_per_s(static_cast<uint64_t>(size) * n, seconds)});
+
+        // The string is built once, outside of the timed loop's cost per byte.
+        seconds = run(
+            "from yoyo import fs\n"
+            "data = fs.read_file('" + path + "')\n"
+            "for _ in range(" + std::to_string(n) + "):\n"
+            "    fs.write_file('" + dir + "/write.txt', data)\n"
+        );
+        write_results.push_back({key, mb_per_s(static_cast<uint64_t>(size) * n, seconds)});
+    }
+
+    // fs.read_dir entries/s.
+    const size_t dir_entries = 2000;
+    const size_t dir_iterations = 50;
+    auto list_dir = root / "dir";
+    std::filesystem::create_directories(list_dir);
+    for (size_t i = 0; i < dir_entries; i++) {
+        std::ofstream(list_dir / ("f" + std::to_string(i) + ".txt")) << i;
+    }
+    auto seconds = run(
+        "from yoyo import fs\n"
+        "for _ in range(" + std::to_string(dir_iterations) + "):\n"
+        "    fs.read_dir('" + list_dir.generic_string() + "')\n"
+    );
+    std::vector<Result> dir_results = {
+        {"entries", static_cast<double>(dir_entries)},
+        {"entries_per_s", seconds > 0 ? dir_entries * dir_iterations / seconds : 0},
+    };
+
+    // A synthetic archive: files of 64 KiB spread over a few directories.
+    const size_t zip_entries = 512;
+    const size_t zip_entry_size = 64 << 10;
+    const uint64_t zip_bytes = static_cast<uint64_t>(zip_entries) * zip_entry_size;
+    auto entry_path = dir + "/read_" + std::to_string(zip_entry_size) + ".txt";
+    auto zip_path = dir + "/bench.zip";
+    std::vector<Result> zip_results;
+
+    seconds = run(
+        "from yoyo import fs\n"
+        "from yoyo import zip as yzip\n"
+        "data = fs.read_file('" + entry_path + "')\n"
+        "a = yzip.open()\n"
+        "for i in range(" + std::to_string(zip_entries) + "):\n"
+        "    a.write('d' + str(i % 8) + '/f' + str(i) + '.txt', data)\n"
+        "a.save('" + zip_path + "')\n"
+    );
+    zip_results.push_back({"write_mb_per_s", mb_per_s(zip_bytes, seconds)});
+    zip_results.push_back({"archive_bytes", static_cast<double>(std::filesystem::exists(zip_path) ? std::filesystem::file_size(zip_path) : 0)});
+
+    const size_t opens = 200;
+    seconds = run(
+        "from yoyo import zip as yzip\n"
+        "for _ in range(" + std::to_string(opens) + "):\n"
+        "    yzip.open('" + zip_path + "').listdir('')\n"
+    );
+    zip_results.push_back({"open_per_s", seconds > 0 ? opens / seconds : 0});
+
+    seconds = run(
+        "from yoyo import zip as yzip\n"
+        "a = yzip.open('" + zip_path + "')\n"
+        "for p in a.listdir('', True):\n"
+        "    if not p.endswith('/'):\n"
+        "        a.read(p)\n"
+    );
+    zip_results.push_back({"read_mb_per_s", mb_per_s(zip_bytes, seconds)});
+
+    seconds = run(
+        "from yoyo import zip as yzip\n"
+        "yzip.open('" + zip_path + "').extract('/', '" + dir + "/extract')\n"
+    );
+    zip_results.push_back({"extract_mb_per_s", mb_per_s(zip_bytes, seconds)});
+
+    seconds = run(
+        "from yoyo import zip as yzip\n"
+        "yzip.open('" + zip_path + "').extract('/', '" + dir + "/extract_par', 0)\n"
+    );
+    zip_results.push_back({"extract_parallel_mb_per_s", mb_per_s(zip_bytes, seconds)});
+    zip_results.push_back({"peak_rss_kb", static_cast<double>(peak_rss_kb())});
+
+    std::printf("{\n");
+    std::printf("  \"fs\": {\n");
+    print_results("read_file_mb_per_s", read_results);
+    print_results("read_file_mapped_mb_per_s", mapped_results);
+    print_results("write_file_mb_per_s", write_results);
+    print_results("read_dir", dir_results, true);
+    std::printf("  },\n");
+    std::printf("  \"zip\": {\n");
+    print_results("synthetic", zip_results, true);
+    std::printf("  }\n");
+    std::printf("}\n");
+
+    pxs_finalize();
+    std::filesystem::remove_all(root);
+    return 0;
+}
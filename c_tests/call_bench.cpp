@@ -0,0 +1,357 @@
+// Call overhead benchmarks for every runtime.
+//
+// For Lua, Python and JS this measures:
+//  - host to script calls (`pxs_call`), timed in a host loop, in ns per call.
+//  - script to host calls through `pxs_addfunc` and `pxs_addfuncv` functions, in ns per call.
+//  - argument conversion by type and size, ns per call above a call without args (building the args is not counted).
+//  - host object method calls and property reads/writes (`pxs_newclass`), in ns per access.
+//  - `pxs_exec`, `pxs_compile` and `pxs_execobject` of a small script, in runs per second.
+//
+// Script side loops are timed from the host and the time of the same loop with an empty body is taken off.
+// Results are written to stdout as JSON, one object per runtime. Pass a iteration scale (default 1) to run longer.
+
+#include "pixelscript.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Result {
+        std::string name;
+        double value;
+    };
+
+    struct Lang {
+        const char* name;
+        pxs_Runtime runtime;
+        // Imports the `bench` module.
+        const char* prelude;
+        // Defines the global functions `noop()`, `take(x)` and `add(a, b)`.
+        const char* functions;
+
+        // A loop running `body` `n` times.
+        std::string loop(size_t n, const std::string& body) const {
+            auto count = std::to_string(n);
+            switch (runtime) {
+                case pxs_Lua: return "for i = 1, " + count + " do " + body + " end\n";
+                case pxs_Python: return "for i in range(" + count + "):\n    " + (body.empty() ? "pass" : body) + "\n";
+                default: return "for (let i = 0; i < " + count + "; i++) { " + body + "; }\n";
+            }
+        }
+    };
+
+    const Lang LANGS[] = {
+        {
+            "lua", pxs_Lua,
+            "local bench = require('bench')\n",
+            "function noop() end\nfunction take(x) end\nfunction add(a, b) return a + b end\n",
+        },
+        {
+            "python", pxs_Python,
+            "import bench\n",
+            "def noop():\n    pass\ndef take(x):\n    pass\ndef add(a, b):\n    return a + b\n",
+        },
+        {
+            "js", pxs_JavaScript,
+            "import * as bench from 'bench';\n",
+            "globalThis.noop = () => {};\nglobalThis.take = (x) => {};\nglobalThis.add = (a, b) => a + b;\n",
+        },
+    };
+
+    size_t SCALE = 1;
+
+    size_t iterations(size_t n) {
+        return n * SCALE;
+    }
+
+    double seconds_since(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    // Print `res` to stderr when it is a exception and free it. True when it was not.
+    bool check(pxs_VarT res, const char* what) {
+        bool ok = true;
+        if (res && pxs_varis(res, pxs_Exception)) {
+            auto msg = pxs_getstring(res);
+            std::fprintf(stderr, "%s failed: %s\n", what, msg ? msg : "unknown error");
+            if (msg) {
+                pxs_freestr(msg);
+            }
+            ok = false;
+        }
+        if (res) {
+            pxs_freevar(res);
+        }
+        return ok;
+    }
+
+    // Run `code` and return the seconds it took, negative when it failed.
+    double run(const Lang& lang, const std::string& code) {
+        auto start = Clock::now();
+        auto res = pxs_exec(lang.runtime, code.c_str(), "<bench>");
+        auto seconds = seconds_since(start);
+        return check(res, lang.name) ? seconds : -1;
+    }
+
+    // ns per run of `body` in a script loop, without the cost of the loop itself.
+    double script_ns(const Lang& lang, const std::string& setup, const std::string& body, size_t n) {
+        auto empty = run(lang, std::string(lang.prelude) + setup + lang.loop(n, ""));
+        auto full = run(lang, std::string(lang.prelude) + setup + lang.loop(n, body));
+        if (empty < 0 || full < 0) {
+            return -1;
+        }
+        auto ns = (full - empty) * 1e9 / static_cast<double>(n);
+        return ns > 0 ? ns : 0;
+    }
+
+    // ns per `make` call, the args are freed after each one.
+    double build_ns(const std::function<pxs_VarT()>& make, size_t n) {
+        auto start = Clock::now();
+        for (size_t i = 0; i < n; i++) {
+            pxs_freevar(make());
+        }
+        return seconds_since(start) * 1e9 / static_cast<double>(n);
+    }
+
+    // ns per `pxs_call(rt, method, make())`.
+    double call_ns(pxs_VarT rt, const char* method, const std::function<pxs_VarT()>& make, size_t n) {
+        if (!check(pxs_call(rt, method, make()), method)) {
+            return -1;
+        }
+        auto start = Clock::now();
+        for (size_t i = 0; i < n; i++) {
+            pxs_freevar(pxs_call(rt, method, make()));
+        }
+        return seconds_since(start) * 1e9 / static_cast<double>(n);
+    }
+
+    pxs_VarT args_of(pxs_VarT arg) {
+        auto args = pxs_newlist();
+        pxs_listadd(args, arg);
+        return args;
+    }
+
+    pxs_VarT int_list(size_t size) {
+        auto list = pxs_newlist_with_capacity(size);
+        for (size_t i = 0; i < size; i++) {
+            pxs_listadd(list, pxs_newint(static_cast<int64_t>(i)));
+        }
+        return list;
+    }
+
+    pxs_VarT int_map(size_t size) {
+        auto map = pxs_newmap();
+        for (size_t i = 0; i < size; i++) {
+            auto key = "k" + std::to_string(i);
+            pxs_map_addpair(map, pxs_newstring(key.c_str()), pxs_newint(static_cast<int64_t>(i)));
+        }
+        return map;
+    }
+
+    std::vector<uint8_t> BYTES(64 << 10, 7);
+
+    // Host to script results, filled in by `bench.measure()` while the script that defined the functions runs.
+    std::vector<Result> CALL_RESULTS;
+    std::vector<Result> ARG_RESULTS;
+
+    // `bench.measure()` times `pxs_call` into the functions the calling script defined.
+    pxs_VarT measure(pxs_VarT args) {
+        auto rt = pxs_listget(args, 0);
+        auto n = iterations(100000);
+        auto no_args = [] { return pxs_newlist(); };
+        auto noop = call_ns(rt, "noop", no_args, n);
+        auto empty = build_ns(no_args, n);
+        auto add = call_ns(rt, "add", [] {
+            auto args = pxs_newlist();
+            pxs_listadd(args, pxs_newint(1));
+            pxs_listadd(args, pxs_newint(2));
+            return args;
+        }, n);
+        CALL_RESULTS = {{"noop", noop}, {"add_ints", add}};
+
+        struct Arg {
+            std::string name;
+            size_t n;
+            std::function<pxs_VarT()> make;
+        };
+        static const std::string SMALL(16, 'a');
+        static const std::string MEDIUM(1 << 10, 'a');
+        static const std::string LARGE(64 << 10, 'a');
+        std::vector<Arg> arg_kinds = {
+            {"int", n, [] { return args_of(pxs_newint(42)); }},
+            {"float", n, [] { return args_of(pxs_newfloat(4.2)); }},
+            {"bool", n, [] { return args_of(pxs_newbool(true)); }},
+            {"string_16", n, [] { return args_of(pxs_newstring(SMALL.c_str())); }},
+            {"string_1k", n, [] { return args_of(pxs_newstring(MEDIUM.c_str())); }},
+            {"string_64k", n / 20, [] { return args_of(pxs_newstring(LARGE.c_str())); }},
+            {"list_16", n / 4, [] { return args_of(int_list(16)); }},
+            {"list_1k", n / 100, [] { return args_of(int_list(1 << 10)); }},
+            {"map_16", n / 4, [] { return args_of(int_map(16)); }},
+            {"map_1k", n / 200, [] { return args_of(int_map(1 << 10)); }},
+            {"buffer_64k", n / 4, [] { return args_of(pxs_newbytes_borrowed(BYTES.data(), BYTES.size(), nullptr)); }},
+        };
+        ARG_RESULTS.clear();
+        for (auto& kind : arg_kinds) {
+            auto count = kind.n < 10 ? 10 : kind.n;
+            auto ns = call_ns(rt, "take", kind.make, count) - build_ns(kind.make, count) - (noop - empty);
+            ARG_RESULTS.push_back({kind.name, ns > 0 ? ns : 0});
+        }
+        return pxs_newnull();
+    }
+
+    pxs_VarT host_noop(pxs_VarT args) {
+        return pxs_newnull();
+    }
+
+    pxs_VarT host_noopv(pxs_VarT rt, int32_t argc, pxs_VarT* argv) {
+        return pxs_newnull();
+    }
+
+    pxs_VarT host_add(pxs_VarT args) {
+        return pxs_newint(pxs_getint(pxs_listget(args, 1)) + pxs_getint(pxs_listget(args, 2)));
+    }
+
+    struct Counter {
+        int64_t value = 0;
+    };
+
+    void free_counter(void* ptr) {
+        delete static_cast<Counter*>(ptr);
+    }
+
+    pxs_PixelClass* COUNTER_CLASS = nullptr;
+
+    Counter* counter_of(pxs_VarT args) {
+        return static_cast<Counter*>(pxs_gethost(pxs_listget(args, 0), pxs_listget(args, 1)));
+    }
+
+    pxs_VarT counter_inc(pxs_VarT args) {
+        counter_of(args)->value++;
+        return pxs_newnull();
+    }
+
+    pxs_VarT counter_value(pxs_VarT args) {
+        auto counter = counter_of(args);
+        if (pxs_listlen(args) == 2) {
+            return pxs_newint(counter->value);
+        }
+        counter->value = pxs_getint(pxs_listget(args, 2));
+        return pxs_newnull();
+    }
+
+    // `bench.counter()` a new `Counter` host object.
+    pxs_VarT new_counter(pxs_VarT args) {
+        return pxs_newhost(pxs_newinstance(COUNTER_CLASS, new Counter(), free_counter));
+    }
+
+    void print_results(const char* name, const std::vector<Result>& results, bool last = false) {
+        std::printf("    \"%s\": {", name);
+        for (size_t i = 0; i < results.size(); i++) {
+            std::printf("%s\"%s\": %.3f", i == 0 ? "" : ", ", results[i].name.c_str(), results[i].value);
+        }
+        std::printf("}%s\n", last ? "" : ",");
+    }
+
+    void bench_lang(const Lang& lang, bool last) {
+        auto n = iterations(200000);
+
+        // Host to script, measured from inside the script run that defines the functions.
+        CALL_RESULTS.clear();
+        ARG_RESULTS.clear();
+        run(lang, std::string(lang.prelude) + lang.functions + (lang.runtime == pxs_JavaScript ? "bench.measure();\n" : "bench.measure()\n"));
+
+        std::vector<Result> host_results = {
+            {"func", script_ns(lang, "", "bench.noop()", n)},
+            {"funcv", script_ns(lang, "", "bench.noopv()", n)},
+            {"add_ints", script_ns(lang, "", "bench.add(1, 2)", n)},
+        };
+
+        auto setup = lang.runtime == pxs_Lua ? "local c = bench.counter()\n" : (lang.runtime == pxs_Python ? "c = bench.counter()\n" : "let c = bench.counter();\n");
+        std::vector<Result> object_results = {
+            {"method", script_ns(lang, setup, lang.runtime == pxs_Lua ? "c:inc()" : "c.inc()", n)},
+            {"prop_get", script_ns(lang, setup, lang.runtime == pxs_Lua ? "local v = c.value" : (lang.runtime == pxs_Python ? "v = c.value" : "let v = c.value"), n)},
+            {"prop_set", script_ns(lang, setup, "c.value = 1", n)},
+        };
+
+        // A small script with a function, a loop and a table.
+        std::string code;
+        switch (lang.runtime) {
+            case pxs_Lua: code = "local t = {}\nfor i = 1, 10 do t[i] = i * 2 end\nlocal function f(x) return x + 1 end\nf(t[10])\n"; break;
+            case pxs_Python: code = "t = [i * 2 for i in range(10)]\ndef f(x):\n    return x + 1\nf(t[9])\n"; break;
+            default: code = "let t = [];\nfor (let i = 0; i < 10; i++) { t.push(i * 2); }\nfunction f(x) { return x + 1; }\nf(t[9]);\n"; break;
+        }
+        auto runs = iterations(2000);
+        auto start = Clock::now();
+        for (size_t i = 0; i < runs; i++) {
+            check(pxs_exec(lang.runtime, code.c_str(), "<bench>"), lang.name);
+        }
+        auto exec_s = seconds_since(start);
+
+        auto object = pxs_compile(lang.runtime, code.c_str(), pxs_newnull());
+        bool compiled = !pxs_varis(object, pxs_Exception);
+        start = Clock::now();
+        for (size_t i = 0; i < runs; i++) {
+            pxs_freevar(pxs_compile(lang.runtime, code.c_str(), pxs_newnull()));
+        }
+        auto compile_s = seconds_since(start);
+
+        start = Clock::now();
+        for (size_t i = 0; compiled && i < runs; i++) {
+            check(pxs_execobject(pxs_new_shallowcopy(object), pxs_newnull()), lang.name);
+        }
+        auto execobject_s = seconds_since(start);
+        check(object, lang.name);
+
+        std::vector<Result> run_results = {
+            {"exec", exec_s > 0 ? runs / exec_s : 0},
+            {"compile", compiled && compile_s > 0 ? runs / compile_s : 0},
+            {"execobject", compiled && execobject_s > 0 ? runs / execobject_s : 0},
+        };
+
+        std::printf("  \"%s\": {\n", lang.name);
+        print_results("host_to_script_ns", CALL_RESULTS);
+        print_results("script_to_host_ns", host_results);
+        print_results("arg_conversion_ns", ARG_RESULTS);
+        print_results("host_object_ns", object_results);
+        print_results("runs_per_s", run_results, true);
+        std::printf("  }%s\n", last ? "" : ",");
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        auto scale = std::strtoull(argv[1], nullptr, 10);
+        SCALE = scale > 0 ? static_cast<size_t>(scale) : 1;
+    }
+
+    pxs_initialize();
+
+    COUNTER_CLASS = pxs_newclass("Counter", -1);
+    pxs_class_addfunc(COUNTER_CLASS, "inc", counter_inc);
+    pxs_class_addprop(COUNTER_CLASS, "value", counter_value);
+
+    auto module = pxs_newmod("bench");
+    pxs_addfunc(module, "measure", measure);
+    pxs_addfunc(module, "noop", host_noop);
+    pxs_addfuncv(module, "noopv", host_noopv);
+    pxs_addfunc(module, "add", host_add);
+    pxs_addobject(module, "counter", new_counter);
+    pxs_addmod(module);
+
+    std::printf("{\n");
+    size_t count = sizeof(LANGS) / sizeof(LANGS[0]);
+    for (size_t i = 0; i < count; i++) {
+        bench_lang(LANGS[i], i + 1 == count);
+    }
+    std::printf("}\n");
+
+    pxs_freeclass(COUNTER_CLASS);
+    pxs_finalize();
+    return 0;
+}
@@ -0,0 +1,376 @@
+// Conversion and marshaling benchmarks for large containers.
+//
+// Containers of 1K, 100K and 1M elements: lists of ints, maps of string keys, nested trees (n / 4 records of
+// `{id, name, tags: [a, b]}`, so n values) and byte buffers (`pxs_newbytes_borrowed`). For each of them this measures:
+//  - host side: building it, `pxs_newcopy` (copy on write, so O(1)), a copy written once (the write copies the items)
+//    and `pxs_json_encode`/`pxs_json_decode` of it.
+//  - host to script, per runtime: `pxs_call` of a script `take(x)` with the container.
+//  - script to host, per runtime: `pxs_call` of a script `give()` returning the container it got before. Maps come
+//    back as a reference to the script value (`pxs_Object`), not a copy.
+//
+// Each measurement has the ms per run (freeing what it made included), the growth of the peak RSS in KiB and the
+// allocations and bytes asked for per run. Allocations are counted by a `pxs_setalloc` hook, so they cover the
+// language states, and the Rust side too when pixelscript is built with `host_alloc`.
+// Sizes run smallest first, so a peak RSS growth belongs to the measurement that caused it.
+// Results are written to stdout as JSON. Pass a repetition scale (default 1) to run longer.
+
+#include "pixelscript.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Lang {
+        const char* name;
+        pxs_Runtime runtime;
+        // Imports the `bench` module and calls `bench.measure()`.
+        const char* prelude;
+        // Defines the global functions `take(x)`, `keep(x)` and `give()`.
+        const char* functions;
+    };
+
+    const Lang LANGS[] = {
+        {
+            "lua", pxs_Lua,
+            "local bench = require('bench')\nbench.measure()\n",
+            "local held = nil\nfunction take(x) end\nfunction keep(x) held = x end\nfunction give() return held end\n",
+        },
+        {
+            "python", pxs_Python,
+            "import bench\nbench.measure()\n",
+            "held = None\ndef take(x):\n    pass\ndef keep(x):\n    global held\n    held = x\ndef give():\n    return held\n",
+        },
+        {
+            "js", pxs_JavaScript,
+            "import * as bench from 'bench';\nbench.measure();\n",
+            "globalThis.held = null;\nglobalThis.take = (x) => {};\nglobalThis.keep = (x) => { globalThis.held = x; };\n"
+            "globalThis.give = () => globalThis.held;\n",
+        },
+    };
+
+    enum class Kind { List, Map, Tree, Bytes };
+
+    struct Shape {
+        const char* name;
+        Kind kind;
+    };
+
+    const Shape SHAPES[] = {
+        {"list", Kind::List},
+        {"map", Kind::Map},
+        {"tree", Kind::Tree},
+        {"bytes", Kind::Bytes},
+    };
+
+    struct Size {
+        const char* name;
+        size_t n;
+    };
+
+    const Size SIZES[] = {
+        {"1k", 1000},
+        {"100k", 100000},
+        {"1m", 1000000},
+    };
+
+    size_t SCALE = 1;
+
+    // Runs of a measurement on `n` elements, at least one.
+    size_t reps(size_t n) {
+        auto count = 200000 * SCALE / n;
+        return count > 0 ? count : 1;
+    }
+
+    std::atomic<uint64_t> ALLOCS{0};
+    std::atomic<uint64_t> ALLOC_BYTES{0};
+
+    // Counts what pixelscript asks for, on top of the C allocator.
+    void* count_alloc(pxs_Opaque tag, void* ptr, uintptr_t size) {
+        if (!ptr) {
+            ALLOCS.fetch_add(1, std::memory_order_relaxed);
+        }
+        ALLOC_BYTES.fetch_add(size, std::memory_order_relaxed);
+        return std::realloc(ptr, size);
+    }
+
+    void count_free(pxs_Opaque tag, void* ptr) {
+        std::free(ptr);
+    }
+
+    // Peak resident set size of the process so far in KiB.
+    uint64_t peak_rss_kb() {
+    #if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            return counters.PeakWorkingSetSize / 1024;
+        }
+        return 0;
+    #else
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+    #if defined(__APPLE__)
+        return static_cast<uint64_t>(usage.ru_maxrss) / 1024;
+    #else
+        return static_cast<uint64_t>(usage.ru_maxrss);
+    #endif
+    #endif
+    }
+
+    // Print `res` to stderr when it is a exception and free it. True when it was not.
+    bool check(pxs_VarT res, const char* what) {
+        bool ok = true;
+        if (res && pxs_varis(res, pxs_Exception)) {
+            auto msg = pxs_getstring(res);
+            std::fprintf(stderr, "%s failed: %s\n", what, msg ? msg : "unknown error");
+            if (msg) {
+                pxs_freestr(msg);
+            }
+            ok = false;
+        }
+        if (res) {
+            pxs_freevar(res);
+        }
+        return ok;
+    }
+
+    struct Result {
+        std::string name;
+        // Per run. `ms` is negative when it failed, `skipped` when the shape has no such measurement.
+        double ms = 0;
+        uint64_t rss_kb = 0;
+        double allocs = 0;
+        double bytes = 0;
+        bool skipped = false;
+    };
+
+    // Run `body` `count` times, freeing what it returns. Stops at the first exception.
+    Result measure_runs(const std::string& name, size_t count, const std::function<pxs_VarT()>& body) {
+        Result result{name};
+        auto rss = peak_rss_kb();
+        auto allocs = ALLOCS.load(std::memory_order_relaxed);
+        auto bytes = ALLOC_BYTES.load(std::memory_order_relaxed);
+        auto start = Clock::now();
+        for (size_t i = 0; i < count; i++) {
+            if (!check(body(), name.c_str())) {
+                result.ms = -1;
+                return result;
+            }
+        }
+        auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        auto runs = static_cast<double>(count);
+        result.ms = seconds * 1e3 / runs;
+        result.rss_kb = peak_rss_kb() - rss;
+        result.allocs = static_cast<double>(ALLOCS.load(std::memory_order_relaxed) - allocs) / runs;
+        result.bytes = static_cast<double>(ALLOC_BYTES.load(std::memory_order_relaxed) - bytes) / runs;
+        return result;
+    }
+
+    Result skipped(const std::string& name) {
+        Result result{name};
+        result.skipped = true;
+        return result;
+    }
+
+    pxs_VarT args_of(pxs_VarT arg) {
+        auto args = pxs_newlist();
+        pxs_listadd(args, arg);
+        return args;
+    }
+
+    // Kept alive for every buffer, which only borrow it.
+    std::vector<uint8_t> BYTES(1000000, 7);
+
+    pxs_VarT build(Kind kind, size_t n) {
+        switch (kind) {
+            case Kind::List: {
+                auto list = pxs_newlist_with_capacity(n);
+                for (size_t i = 0; i < n; i++) {
+                    pxs_listadd(list, pxs_newint(static_cast<int64_t>(i)));
+                }
+                return list;
+            }
+            case Kind::Map: {
+                auto map = pxs_newmap();
+                for (size_t i = 0; i < n; i++) {
+                    auto key = "k" + std::to_string(i);
+                    pxs_map_addpair(map, pxs_newstring(key.c_str()), pxs_newint(static_cast<int64_t>(i)));
+                }
+                return map;
+            }
+            case Kind::Tree: {
+                auto records = n / 4;
+                auto list = pxs_newlist_with_capacity(records);
+                for (size_t i = 0; i < records; i++) {
+                    auto record = pxs_newmap();
+                    auto name = "record " + std::to_string(i);
+                    auto tags = pxs_newlist_with_capacity(2);
+                    pxs_listadd(tags, pxs_newint(static_cast<int64_t>(i % 7)));
+                    pxs_listadd(tags, pxs_newfloat(static_cast<double>(i) * 0.5));
+                    pxs_map_addpair(record, pxs_newstring("id"), pxs_newint(static_cast<int64_t>(i)));
+                    pxs_map_addpair(record, pxs_newstring("name"), pxs_newstring(name.c_str()));
+                    pxs_map_addpair(record, pxs_newstring("tags"), tags);
+                    pxs_listadd(list, record);
+                }
+                return list;
+            }
+            default:
+                return pxs_newbytes_borrowed(BYTES.data(), n, nullptr);
+        }
+    }
+
+    // A copy of `var` written once, the write makes it copy the items it shared.
+    pxs_VarT written_copy(Kind kind, pxs_VarT var) {
+        auto copy = pxs_newcopy(var);
+        if (kind == Kind::Map) {
+            pxs_map_addpair(copy, pxs_newstring("written"), pxs_newint(1));
+        } else {
+            pxs_listset(copy, 0, pxs_newint(-1));
+        }
+        return copy;
+    }
+
+    void print_results(const char* name, const std::vector<Result>& results, bool last) {
+        std::printf("    \"%s\": {", name);
+        for (size_t i = 0; i < results.size(); i++) {
+            auto& result = results[i];
+            std::printf("%s\"%s\": ", i == 0 ? "" : ", ", result.name.c_str());
+            if (result.skipped) {
+                std::printf("null");
+            } else {
+                std::printf("{\"ms\": %.4f, \"rss_kb\": %llu, \"allocs\": %.1f, \"bytes\": %.1f}", result.ms,
+                    static_cast<unsigned long long>(result.rss_kb), result.allocs, result.bytes);
+            }
+        }
+        std::printf("}%s\n", last ? "" : ",");
+    }
+
+    struct Case {
+        std::string name;
+        std::vector<Result> results;
+    };
+
+    void print_cases(const char* name, const std::vector<Case>& cases, bool last) {
+        std::printf("  \"%s\": {\n", name);
+        for (size_t i = 0; i < cases.size(); i++) {
+            print_results(cases[i].name.c_str(), cases[i].results, i + 1 == cases.size());
+        }
+        std::printf("  }%s\n", last ? "" : ",");
+    }
+
+    // Host side only, no runtime is involved.
+    std::vector<Case> bench_host() {
+        // `rt` is only looked at for script objects, there are none here.
+        auto rt = pxs_newint(pxs_Lua);
+        std::vector<Case> cases;
+        for (auto& size : SIZES) {
+            for (auto& shape : SHAPES) {
+                auto kind = shape.kind;
+                auto n = size.n;
+                auto count = reps(n);
+                Case c{std::string(shape.name) + "_" + size.name};
+                c.results.push_back(measure_runs("build", count, [&] { return build(kind, n); }));
+
+                auto var = build(kind, n);
+                c.results.push_back(measure_runs("newcopy", count, [&] { return pxs_newcopy(var); }));
+                if (kind == Kind::Bytes) {
+                    c.results.push_back(skipped("newcopy_write"));
+                } else {
+                    c.results.push_back(measure_runs("newcopy_write", count, [&] { return written_copy(kind, var); }));
+                }
+
+                c.results.push_back(measure_runs("json_encode", count, [&] {
+                    return pxs_json_encode(rt, args_of(pxs_newcopy(var)));
+                }));
+                auto encoded = pxs_json_encode(rt, args_of(pxs_newcopy(var)));
+                auto text = pxs_varis(encoded, pxs_String) ? pxs_getstring(encoded) : nullptr;
+                if (text) {
+                    c.results.push_back(measure_runs("json_decode", count, [&] {
+                        return pxs_json_decode(rt, args_of(pxs_newstring(text)));
+                    }));
+                    pxs_freestr(text);
+                } else {
+                    c.results.push_back(skipped("json_decode"));
+                }
+                check(encoded, "json_encode");
+                pxs_freevar(var);
+                cases.push_back(std::move(c));
+            }
+        }
+        pxs_freevar(rt);
+        return cases;
+    }
+
+    // Filled in by `bench.measure()` while the script that defined the functions runs.
+    std::vector<Case> LANG_CASES;
+
+    // `bench.measure()` passes every container through the runtime that calls it.
+    pxs_VarT measure(pxs_VarT args) {
+        auto rt = pxs_listget(args, 0);
+        LANG_CASES.clear();
+        for (auto& size : SIZES) {
+            for (auto& shape : SHAPES) {
+                auto n = size.n;
+                auto count = reps(n);
+                Case c{std::string(shape.name) + "_" + size.name};
+                auto var = build(shape.kind, n);
+
+                c.results.push_back(measure_runs("to_script", count, [&] {
+                    return pxs_call(rt, "take", args_of(pxs_newcopy(var)));
+                }));
+                check(pxs_call(rt, "keep", args_of(pxs_newcopy(var))), "keep");
+                c.results.push_back(measure_runs("to_host", count, [&] { return pxs_call(rt, "give", pxs_newlist()); }));
+                check(pxs_call(rt, "keep", args_of(pxs_newnull())), "keep");
+
+                pxs_freevar(var);
+                pxs_garbagecollect();
+                LANG_CASES.push_back(std::move(c));
+            }
+        }
+        return pxs_newnull();
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        auto scale = std::strtoull(argv[1], nullptr, 10);
+        SCALE = scale > 0 ? static_cast<size_t>(scale) : 1;
+    }
+
+    // Before anything allocates.
+    pxs_setalloc(count_alloc, nullptr);
+    pxs_setfree(count_free);
+    pxs_initialize();
+
+    auto module = pxs_newmod("bench");
+    pxs_addfunc(module, "measure", measure);
+    pxs_addmod(module);
+
+    std::printf("{\n");
+    print_cases("host", bench_host(), false);
+    size_t count = sizeof(LANGS) / sizeof(LANGS[0]);
+    for (size_t i = 0; i < count; i++) {
+        auto& lang = LANGS[i];
+        LANG_CASES.clear();
+        auto code = std::string(lang.functions) + lang.prelude;
+        check(pxs_exec(lang.runtime, code.c_str(), "<bench>"), lang.name);
+        print_cases(lang.name, LANG_CASES, i + 1 == count);
+    }
+    std::printf("}\n");
+
+    pxs_finalize();
+    return 0;
+}
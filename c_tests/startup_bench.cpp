@@ -0,0 +1,112 @@
+// Startup benchmarks, what a page pays before the first script runs. Built natively and for wasm32
+// (`em++ ... -o startup_bench.js`, then `node startup_bench.js`).
+//
+// Measures, in ms:
+//  - `pxs_initialize` and `pxs_finalize`.
+//  - the first `pxs_exec` of a one line script per runtime (its VM is made there) and the next one.
+//  - `pxs_yoyoinit`, only when `yoyo` is passed since it panics without the `yoyo` feature.
+//
+// Every measure is the median of a number of init/finalize rounds (default 20, pass another number to change it).
+// Results are written to stdout as JSON.
+
+#include "pixelscript.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Lang {
+        const char* name;
+        pxs_Runtime runtime;
+        const char* code;
+    };
+
+    const Lang LANGS[] = {
+        {"lua", pxs_Lua, "local x = 1 + 1\n"},
+        {"python", pxs_Python, "x = 1 + 1\n"},
+        {"js", pxs_JavaScript, "let x = 1 + 1;\n"},
+    };
+    constexpr size_t LANG_COUNT = sizeof(LANGS) / sizeof(LANGS[0]);
+
+    double ms_since(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    double median(std::vector<double> values) {
+        if (values.empty()) {
+            return 0.0;
+        }
+        std::sort(values.begin(), values.end());
+        return values[values.size() / 2];
+    }
+
+    // Time `pxs_exec` of `lang` and free the result, printing it to stderr when it is a exception.
+    double exec(const Lang& lang) {
+        auto start = Clock::now();
+        auto res = pxs_exec(lang.runtime, lang.code, "<startup>");
+        auto took = ms_since(start);
+        if (res && pxs_varis(res, pxs_Exception)) {
+            auto msg = pxs_getstring(res);
+            std::fprintf(stderr, "%s failed: %s\n", lang.name, msg ? msg : "unknown error");
+            pxs_freestr(msg);
+        }
+        if (res) {
+            pxs_freevar(res);
+        }
+        return took;
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t rounds = 20;
+    bool yoyo = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "yoyo") == 0) {
+            yoyo = true;
+        } else if (auto n = std::strtoull(argv[i], nullptr, 10); n > 0) {
+            rounds = static_cast<size_t>(n);
+        }
+    }
+
+    std::vector<double> init, finalize, yoyo_init;
+    std::vector<double> first[LANG_COUNT], second[LANG_COUNT];
+    for (size_t round = 0; round < rounds; round++) {
+        auto start = Clock::now();
+        pxs_initialize();
+        init.push_back(ms_since(start));
+
+        if (yoyo) {
+            start = Clock::now();
+            pxs_yoyoinit();
+            yoyo_init.push_back(ms_since(start));
+        }
+
+        for (size_t i = 0; i < LANG_COUNT; i++) {
+            first[i].push_back(exec(LANGS[i]));
+            second[i].push_back(exec(LANGS[i]));
+        }
+
+        start = Clock::now();
+        pxs_finalize();
+        finalize.push_back(ms_since(start));
+    }
+
+    std::printf("{\n");
+    std::printf("  \"rounds\": %zu,\n", rounds);
+    std::printf("  \"initialize\": %.3f,\n", median(init));
+    if (yoyo) {
+        std::printf("  \"yoyo_init\": %.3f,\n", median(yoyo_init));
+    }
+    for (size_t i = 0; i < LANG_COUNT; i++) {
+        std::printf("  \"%s\": {\"first_exec\": %.3f, \"second_exec\": %.3f},\n", LANGS[i].name, median(first[i]), median(second[i]));
+    }
+    std::printf("  \"finalize\": %.3f\n", median(finalize));
+    std::printf("}\n");
+    return 0;
+}
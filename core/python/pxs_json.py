@@ -1,9 +0,0 @@
-import json
-
-
-def encode(object):
-    return json.dumps(object)
-
-
-def decode(string):
-    return json.loads(string)
\ No newline at end of file
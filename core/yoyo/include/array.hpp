@@ -0,0 +1,174 @@
+#pragma once
+#ifdef YOYO_ARRAY
+
+#include <pixelscript.h>
+#include <cstddef>
+#include <cstdint>
+#include <variant>
+#include <vector>
+
+namespace yoyo::array {
+    // Element type of a `Array`.
+    enum class Kind : uint8_t {
+        F32 = 0,
+        F64 = 1,
+        I32 = 2,
+        U8 = 3
+    };
+
+    // A fixed size array of numbers kept on the host. Scripts change it with one call per kernel instead of a
+    // interpreted loop over the elements. Indices are 0 based in every language, negative ones count from the end.
+    //
+    // Integer arrays round and saturate what is written into them (i.e. 300 is stored as 255 in a `U8` array).
+    struct Array {
+        // @private
+        std::variant<std::vector<float>, std::vector<double>, std::vector<int32_t>, std::vector<uint8_t>> data;
+
+        // @private
+        Kind kind() const;
+
+        // @private
+        size_t size() const;
+
+        // @private
+        // CONVERT into a pxs host object.
+        pxs_VarT topxs();
+
+        // @self
+        // returns `int` the number of elements.
+        static pxs_VarT len(pxs_VarT args);
+
+        // @self
+        // returns `Kind` the element type.
+        static pxs_VarT get_kind(pxs_VarT args);
+
+        // @except
+        // @self
+        // Read one element.
+        // args:
+        //  - index: `int` the element.
+        //
+        // returns `int`|`float`
+        static pxs_VarT get(pxs_VarT args);
+
+        // @except
+        // @self
+        // Write one element.
+        // args:
+        //  - index: `int` the element.
+        //  - value: `int`|`float` the new value.
+        //
+        static pxs_VarT set(pxs_VarT args);
+
+        // @except
+        // @self
+        // Set every element.
+        // args:
+        //  - value: `int`|`float` the value.
+        //
+        static pxs_VarT fill(pxs_VarT args);
+
+        // @except
+        // @self
+        // Add to every element in place.
+        // args:
+        //  - other: `int`|`float`|`Array` a number, or a array of the same kind and length added element wise.
+        //
+        static pxs_VarT add(pxs_VarT args);
+
+        // @except
+        // @self
+        // Multiply every element in place.
+        // args:
+        //  - other: `int`|`float`|`Array` a number, or a array of the same kind and length multiplied element wise.
+        //
+        static pxs_VarT mul(pxs_VarT args);
+
+        // @except
+        // @self
+        // `self[i] += a * x[i]`
+        // args:
+        //  - a: `int`|`float` the scale.
+        //  - x: `Array` a array of the same kind and length.
+        //
+        static pxs_VarT axpy(pxs_VarT args);
+
+        // @self
+        // returns `int`|`float`|`null` the smallest element, null when empty.
+        static pxs_VarT min(pxs_VarT args);
+
+        // @self
+        // returns `int`|`float`|`null` the largest element, null when empty.
+        static pxs_VarT max(pxs_VarT args);
+
+        // @self
+        // returns `int`|`float` the sum of the elements. Integer arrays sum exactly into a `int`.
+        static pxs_VarT sum(pxs_VarT args);
+
+        // @except
+        // @self
+        // Clamp every element in place.
+        // args:
+        //  - low: `int`|`float` the smallest value.
+        //  - high: `int`|`float` the largest value.
+        //
+        static pxs_VarT clamp(pxs_VarT args);
+
+        // @except
+        // @self
+        // Move every element towards another array in place, `self[i] += (other[i] - self[i]) * t`.
+        // args:
+        //  - other: `Array` a array of the same kind and length.
+        //  - t: `float` 0 keeps self, 1 copies other.
+        //
+        static pxs_VarT lerp(pxs_VarT args);
+
+        // @except
+        // @self
+        // Read the elements at `indices` into a new array of the same kind.
+        // args:
+        //  - indices: `[]int`|`Array` the elements to read, a integer array works too.
+        //
+        // returns `Array` a array as long as `indices`.
+        static pxs_VarT gather(pxs_VarT args);
+
+        // @except
+        // @self
+        // Write into the elements at `indices`. Nothing is written when a index is out of range.
+        // args:
+        //  - indices: `[]int`|`Array` the elements to write, a integer array works too.
+        //  - values: `int`|`float`|`Array` one value for all, or a array of the same kind as long as `indices`.
+        //
+        static pxs_VarT scatter(pxs_VarT args);
+
+        // @self
+        // returns `[]int`|`[]float` the elements as a script list.
+        static pxs_VarT to_list(pxs_VarT args);
+
+        // @self
+        // returns `[]uint` a copy of the raw element memory (native byte order) as a `pxs_Buffer`.
+        static pxs_VarT to_bytes(pxs_VarT args);
+    };
+
+    // @except
+    // Create a array of zeros.
+    // args:
+    //  - kind: `Kind` the element type.
+    //  - len: `int` the number of elements.
+    //
+    // returns `Array` a new array.
+    pxs_VarT zeros(pxs_VarT args);
+
+    // @except
+    // Create a array from values.
+    // args:
+    //  - kind: `Kind` the element type.
+    //  - values: `[]int`|`[]float`|`[]uint` a list of numbers, or bytes holding the raw elements (native byte order).
+    //
+    // returns `Array` a new array.
+    pxs_VarT of(pxs_VarT args);
+
+    void init(pxs_Module* yoyo);
+};
+
+#endif // YOYO_ARRAY
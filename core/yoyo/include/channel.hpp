@@ -0,0 +1,163 @@
+#pragma once
+
+#ifdef YOYO_CHANNEL
+
+#include <pixelscript.h>
+#include <pixelscript_cpp.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace yoyo::channel {
+    // A message, `pxs_pack` bytes of a value or a byte block from the host.
+    struct Message {
+        std::string bytes;
+        bool packed = false;
+    };
+
+    // A bounded multi producer multi consumer ring buffer. Sending and receiving never lock, every slot has a
+    // sequence number that says whose turn it is, producers and consumers only race on one counter each.
+    class Ring {
+        struct Cell {
+            std::atomic<size_t> seq;
+            Message value;
+        };
+
+        // @private
+        std::unique_ptr<Cell[]> cells;
+        // @private
+        size_t mask;
+        // @private
+        // Next slot to send to. Apart from `tail`, so producers and consumers don't share a cache line.
+        alignas(64) std::atomic<size_t> head{0};
+        // @private
+        // Next slot to receive from.
+        alignas(64) std::atomic<size_t> tail{0};
+
+    public:
+        // `capacity` is rounded up to a power of two.
+        Ring(size_t capacity);
+
+        // Move `message` in. False when full, `message` is then untouched.
+        bool push(Message& message);
+        // Move the oldest message into `out`. False when empty.
+        bool pop(Message& out);
+        // Number of slots.
+        size_t capacity() const;
+        // Number of messages, only a snapshot while others send or receive.
+        size_t size() const;
+    };
+
+    // Returned by `new` and `open`.
+    class Channel {
+        // @private
+        std::shared_ptr<Ring> ring;
+        // @private
+        // Empty if not made with `open`.
+        std::string name;
+
+    public:
+        Channel(std::shared_ptr<Ring> ring, std::string name);
+
+        // @prop(get)
+        // The name given to `open`, empty for `new`.
+        //
+        // args:
+        //  - self: `Channel`
+        //
+        // returns `string`
+        static pxs_VarT get_name(pxs_VarT args);
+
+        // @prop(get)
+        // The max number of messages held.
+        //
+        // args:
+        //  - self: `Channel`
+        //
+        // returns `int`
+        static pxs_VarT get_capacity(pxs_VarT args);
+
+        // @prop(get)
+        // The number of messages held right now.
+        //
+        // args:
+        //  - self: `Channel`
+        //
+        // returns `int`
+        static pxs_VarT get_size(pxs_VarT args);
+
+        // @except
+        // Send a copy of `value` (through `pxs_pack`), only plain data (numbers, strings, bytes, lists, maps) can be sent.
+        // Never blocks.
+        // args:
+        //  - self: `Channel`
+        //  - value: `any` the value.
+        //
+        // returns `bool` false when the channel is full.
+        static pxs_VarT try_send(pxs_VarT args);
+
+        // Receive the oldest message. Never blocks.
+        // args:
+        //  - self: `Channel`
+        //
+        // returns `any`|`null` the value, `[]uint` for byte blocks from the host, `null` when empty.
+        static pxs_VarT try_recv(pxs_VarT args);
+
+        // @except
+        // Send every value of `values` in order, until the channel is full.
+        // args:
+        //  - self: `Channel`
+        //  - values: `[]any` the values.
+        //
+        // returns `int` how many were sent.
+        static pxs_VarT send_many(pxs_VarT args);
+
+        // Receive up to `max` messages at once.
+        // args:
+        //  - self: `Channel`
+        //  - max: @opt `int` the max number of messages. Defaults to everything held.
+        //
+        // returns `[]any` the values, oldest first.
+        static pxs_VarT recv_many(pxs_VarT args);
+    };
+
+    // @private
+    // Get the ring named `name`, made with `capacity` if it does not exist yet. Named rings live as long as the process.
+    std::shared_ptr<Ring> named(const std::string& name, size_t capacity);
+
+    // Create a channel only reachable through the returned object.
+    // args:
+    //  - capacity: @opt `int` max number of messages, rounded up to a power of two. Defaults to 1024.
+    //
+    // returns `Channel`
+    pxs_VarT new_channel(pxs_VarT args);
+
+    // Get the channel named `name`, shared by every thread, runtime and the host (`pxs_yoyochannel`).
+    // args:
+    //  - name: `string` the name.
+    //  - capacity: @opt `int` used when it does not exist yet. Defaults to 1024.
+    //
+    // returns `Channel`
+    pxs_VarT open(pxs_VarT args);
+
+    // @private
+    // Ring of the channel named `name` for the host, see `yoyo_channel_open`.
+    void* host_open(const char* name, uint32_t capacity);
+
+    // @private
+    // See `yoyo_channel_push`.
+    bool host_push(void* ring, const void* data, size_t len, bool packed);
+
+    // @private
+    // See `yoyo_channel_pop`.
+    bool host_pop(void* ring, void (*sink)(void* opaque, const void* data, size_t len, bool packed), void* opaque);
+
+    // @private
+    //
+    // Initialize the `yoyo.channel` module.
+    void init(pxs_Module* yoyo);
+};
+
+#endif // YOYO_CHANNEL
@@ -0,0 +1,167 @@
+#pragma once
+
+#ifdef YOYO_COMPRESS
+
+#include <pixelscript.h>
+#include <pixelscript_cpp.hpp>
+#include <cstdint>
+#include <memory>
+
+namespace yoyo::compress {
+    // Container around the deflate data.
+    enum class Format : uint8_t {
+        // zlib header and adler-32 check, what `deflate` writes.
+        Zlib = 0,
+        // Only the deflate data.
+        Raw = 1,
+        // gzip header and crc-32 check, what `gzip` writes.
+        Gzip = 2
+    };
+
+    // @private
+    // The native streaming encoder of a `Compressor`.
+    class Encoder;
+
+    // @private
+    // The native streaming decoder of a `Decompressor`.
+    class Decoder;
+
+    // Returned by `compressor`. Compresses chunk by chunk, every call returns what is ready so far.
+    class Compressor {
+        // @private
+        std::unique_ptr<Encoder> encoder;
+
+        // @private
+        // Shared by `write`, `flush` and `finish`.
+        static pxs_VarT encode(pxs_VarT args, int flush);
+
+    public:
+        Compressor(std::unique_ptr<Encoder> encoder);
+        ~Compressor();
+
+        // @prop(get)
+        // Has `finish` been called?
+        //
+        // args:
+        //  - self: `Compressor`
+        //
+        // returns `bool`
+        static pxs_VarT get_finished(pxs_VarT args);
+
+        // @except
+        // Compress a chunk.
+        // args:
+        //  - self: `Compressor`
+        //  - data: `[]uint`|`string` the chunk.
+        //
+        // returns `[]uint` compressed bytes ready so far, often empty.
+        static pxs_VarT write(pxs_VarT args);
+
+        // @except
+        // Push out everything written so far, so the other side can decompress it. Costs a few bytes.
+        // args:
+        //  - self: `Compressor`
+        //
+        // returns `[]uint`
+        static pxs_VarT flush(pxs_VarT args);
+
+        // @except
+        // End the stream. Nothing can be written after.
+        // args:
+        //  - self: `Compressor`
+        //
+        // returns `[]uint` the rest of the stream.
+        static pxs_VarT finish(pxs_VarT args);
+    };
+
+    // Returned by `decompressor`. Decompresses chunk by chunk.
+    class Decompressor {
+        // @private
+        std::unique_ptr<Decoder> decoder;
+
+    public:
+        Decompressor(std::unique_ptr<Decoder> decoder);
+        ~Decompressor();
+
+        // @prop(get)
+        // Has the end of the stream (and its check) been read?
+        //
+        // args:
+        //  - self: `Decompressor`
+        //
+        // returns `bool`
+        static pxs_VarT get_done(pxs_VarT args);
+
+        // @except
+        // Decompress a chunk. Bytes after the end of the stream are ignored.
+        // args:
+        //  - self: `Decompressor`
+        //  - data: `[]uint`|`string` the chunk.
+        //
+        // returns `[]uint` the bytes decompressed from it.
+        static pxs_VarT write(pxs_VarT args);
+    };
+
+    // @except
+    // Compress into the zlib format.
+    // args:
+    //  - data: `[]uint`|`string` the data.
+    //  - level: @opt `int` 0 (store) to 9 (smallest). Defaults to 6.
+    //  - parallel: @opt `bool` compress 1MB blocks on the worker pool. Only used for inputs over 2MB, a bit larger
+    //    output as blocks don't share history. Defaults to false.
+    //
+    // returns `[]uint`
+    pxs_VarT deflate(pxs_VarT args);
+
+    // @except
+    // Decompress the zlib format.
+    // args:
+    //  - data: `[]uint`|`string` the data.
+    //  - text: @opt `bool` return a `string`. Defaults to false.
+    //
+    // returns `[]uint`|`string`
+    pxs_VarT inflate(pxs_VarT args);
+
+    // @except
+    // Compress into the gzip format, like `deflate`.
+    // args:
+    //  - data: `[]uint`|`string` the data.
+    //  - level: @opt `int` 0 (store) to 9 (smallest). Defaults to 6.
+    //  - parallel: @opt `bool` see `deflate`. Defaults to false.
+    //
+    // returns `[]uint`
+    pxs_VarT gzip(pxs_VarT args);
+
+    // @except
+    // Decompress the gzip format.
+    // args:
+    //  - data: `[]uint`|`string` the data.
+    //  - text: @opt `bool` return a `string`. Defaults to false.
+    //
+    // returns `[]uint`|`string`
+    pxs_VarT gunzip(pxs_VarT args);
+
+    // @except
+    // Create a `Compressor`.
+    // args:
+    //  - format: @opt `Format` defaults to `Format::Zlib`.
+    //  - level: @opt `int` 0 (store) to 9 (smallest). Defaults to 6.
+    //
+    // returns `Compressor`
+    pxs_VarT compressor(pxs_VarT args);
+
+    // @except
+    // Create a `Decompressor`.
+    // args:
+    //  - format: @opt `Format` defaults to `Format::Zlib`.
+    //
+    // returns `Decompressor`
+    pxs_VarT decompressor(pxs_VarT args);
+
+    // @private
+    //
+    // Initialize the `yoyo.compress` module.
+    void init(pxs_Module* yoyo);
+};
+
+#endif // YOYO_COMPRESS
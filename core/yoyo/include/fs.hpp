@@ -10,13 +10,24 @@
 #include <memory>
 #include <fstream>
 #include <sstream>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <cstdio>
+#include <streambuf>
+#include <map>
+#include <chrono>
 
 namespace yoyo::fs {
     // Pass this as the final argument in `read_file` to return bytes or text.
     // Defaults to Text
+    //
+    // `Mapped` returns a buffer backed by a memory mapping of the file instead of a copy of its bytes.
+    // The file is unmapped once the buffer is no longer used.
     enum class FileReadType : uint8_t {
         Bytes = 0,
-        Text = 1
+        Text = 1,
+        Mapped = 2
     };
 
     // Pass this as the final argument in `open_file` to open as Read, Write, or Append
@@ -38,6 +49,43 @@ namespace yoyo::fs {
         return (static_cast<uint8_t>(l) & static_cast<uint8_t>(r));
     }
 
+    // The `type` of a entry returned by `scan_dir`.
+    enum class EntryType : uint8_t {
+        File = 0,
+        Dir = 1,
+        Symlink = 2,
+        Other = 3
+    };
+
+    // @private
+    // A directory entry as read by `scan_entries`.
+    struct DirEntry {
+        // File name, not the full path.
+        std::string name;
+        // What kind of entry.
+        EntryType type;
+        // Size in bytes. 0 for directories or when metadata was not requested.
+        uint64_t size;
+        // Last modification time in seconds since the unix epoch. -1 when metadata was not requested.
+        int64_t mtime;
+    };
+
+    // @private
+    // Read all entries of `path` natively. Uses `readdir` + `d_type` on POSIX and
+    // `FindFirstFileEx` (basic info, large fetch) on Windows.
+    // When `with_meta` is false, no `stat` calls are made on POSIX.
+    //
+    // returns false and sets `error` if the directory could not be opened.
+    bool scan_entries(const std::string& path, bool with_meta, std::vector<DirEntry>& entries, std::string& error);
+
+    // Pass this as the final argument in `File.seek` to pick where the offset is relative to.
+    // Defaults to Start.
+    enum class SeekFrom : uint8_t {
+        Start = 0,
+        Current = 1,
+        End = 2
+    };
+
     // Pass this as the final argument in `remove_dir` to either remove only empty components or all components.
     // Defaults to Empty.
     enum class DirRemoveType : uint8_t {
@@ -52,6 +100,97 @@ namespace yoyo::fs {
         All = 1
     };
 
+    // @private
+    // A copy on write memory mapping of a file. Uses `mmap` on POSIX and `MapViewOfFile` on Windows.
+    // Writes to the view stay private to the process, the file is never changed.
+    // The mapping is released once this goes out of scope.
+    class MappedFile {
+        // Start of the mapping. `nullptr` for empty files.
+        const char* view = nullptr;
+        // Size of the mapping in bytes.
+        size_t length = 0;
+        // Did the mapping succeed?
+        bool ok = false;
+    #if defined(_WIN32)
+        // File HANDLE
+        void* file_handle = nullptr;
+        // File mapping HANDLE
+        void* map_handle = nullptr;
+    #endif
+
+    public:
+        // `sequential` hints that the mapping is read front to back, otherwise access is random (i.e. archives).
+        MappedFile(const std::string& path, bool sequential = true);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // Was the file mapped?
+        bool is_mapped() const { return ok; }
+        // The mapped contents.
+        const char* data() const { return view; }
+        // The size of the mapped contents.
+        size_t size() const { return length; }
+
+        // @except
+        // Map `path` and return a buffer over the mapping, unmapped by its deleter. A empty buffer for empty files.
+        static pxs_VarT read(const std::string& path);
+    };
+
+    // @private
+    // A `std::streambuf` backed by fixed size blocks. Used by created `File`s so growing the buffer never
+    // reallocates or copies what was already written.
+    // Writes always append. Reads and seeks only move the read position.
+    // Past `spill_threshold` bytes (0 for never) the blocks are moved into a temp file.
+    class BlockBuffer : public std::streambuf {
+        // Size of a single block.
+        size_t block_size;
+        // Spill to disk after this many bytes are in memory. 0 never spills.
+        size_t spill_threshold;
+        // In memory blocks, after the spilled bytes.
+        std::vector<std::unique_ptr<char[]>> blocks;
+        // Bytes used in the last block.
+        size_t tail = 0;
+        // Bytes held in `blocks`.
+        size_t in_memory = 0;
+        // Temp file holding the first `spilled` bytes.
+        std::FILE* spill = nullptr;
+        size_t spilled = 0;
+        // Absolute position of `eback()`.
+        size_t gbase = 0;
+        // Read window for spilled bytes.
+        std::vector<char> window;
+
+        // Current read position.
+        size_t read_pos() const;
+        // Move in memory blocks into the temp file.
+        void spill_blocks();
+
+    protected:
+        int_type overflow(int_type ch) override;
+        std::streamsize xsputn(const char* s, std::streamsize n) override;
+        int_type underflow() override;
+        pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+        pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+
+    public:
+        BlockBuffer(size_t block_size = 64 * 1024, size_t spill_threshold = 0);
+        ~BlockBuffer();
+
+        BlockBuffer(const BlockBuffer&) = delete;
+        BlockBuffer& operator=(const BlockBuffer&) = delete;
+
+        // Change block size and spill threshold. Only valid while empty.
+        void configure(size_t block_size, size_t spill_threshold);
+        // Total bytes written.
+        size_t size() const { return spilled + in_memory; }
+        // Drop everything.
+        void reset();
+        // Write everything into `path`. In memory blocks go out in one vectored write where supported.
+        bool save(const std::string& path);
+    };
+
     // Wraps a `ifstream` or `ofstream` depending on `FileOpenType`.
     // Use this when memory needs to be explicit.
     // `read_file` and `write_file` use `File` internally.
@@ -63,22 +202,38 @@ namespace yoyo::fs {
         // File stream
         std::fstream stream;
         // @private
+        // Blocks backing `buffer`.
+        BlockBuffer blocks;
+        // @private
         // a buffer for writing, when the file is created not opened.
-        std::stringstream buffer;
+        std::iostream buffer;
+        // @private
+        // Buffer handed to `stream` with `pubsetbuf`, so small writes are batched. Empty uses the default.
+        std::vector<char> stream_buffer;
         // @private
         // Open type
         FileOpenType opentype;
+        // @private
+        // Reusable buffer for `read_chunk`. Grows to the largest chunk requested.
+        std::vector<char> chunk;
+        // @private
+        // Reusable buffer for `readline`.
+        std::string line;
 
         // @private
         // Was this file created or opened?
         bool created;
 
         // @private
-        // When opening a file.
-        File(const std::string& fpath, FileOpenType ot);
+        // When opening a file. `buffer_size` of 0 keeps the default stream buffer.
+        File(const std::string& fpath, FileOpenType ot, size_t buffer_size = 0);
         // @private
         // When creating a file.
-        File();
+        File(size_t block_size, size_t spill_threshold);
+
+        // @private
+        // The stream reads/writes go through. `buffer` when created, `stream` when opened.
+        std::iostream& io();
     
     public:
         ~File();
@@ -102,6 +257,10 @@ namespace yoyo::fs {
         static pxs_VarT get_open_type(pxs_VarT args);
 
         // Create a new `File`. It won't write to the system until `save` is called.
+        // Data is kept in fixed size blocks, so it never gets copied while growing.
+        // args:
+        //  - block_size: @opt `int` size of a single block. Defaults to 64KB.
+        //  - spill_threshold: @opt `int` move the data into a temp file once this many bytes are held. Defaults to 0 (never).
         //
         // returns `File` a new instance.
         static pxs_VarT create(pxs_VarT args);
@@ -112,6 +271,7 @@ namespace yoyo::fs {
         // args:
         //  - path: `string` path to the file.
         //  - open_type: @opt `FileOpenType` how to open the file. Defaults to `FileOpenType::Read`.
+        //  - buffer_size: @opt `int` size of the stream buffer, bigger means less flushes for small writes. Defaults to the standard library's.
         //
         // returns `File` a new instance.
         static pxs_VarT open(pxs_VarT args);
@@ -122,21 +282,70 @@ namespace yoyo::fs {
         //  - self: `File`
         //  - read_type: @opt `FileReadType` what to return the file contents as. Defaults to `FileReadType::Text`.
         //
-        // returns `string`|`[]uint` Text or Bytes depending on `read_type`.
+        // returns `string`|`[]uint` Text or Bytes depending on `read_type`. `Mapped` reads from the path on disk.
         static pxs_VarT read(pxs_VarT args);
 
+        // @except
+        // Read at most `size` bytes from the current position of `self`.
+        // Memory used is bound by `size`, not the file size.
+        // args:
+        //  - self: `File`
+        //  - size: `int` max number of bytes to read.
+        //  - read_type: @opt `FileReadType` what to return the chunk as. Defaults to `FileReadType::Text`.
+        //
+        // returns `string`|`[]uint`|`null` the chunk, or `null` once the end of the file is reached.
+        static pxs_VarT read_chunk(pxs_VarT args);
+
+        // @except
+        // Read the next line of `self`. The line break is not included.
+        // args:
+        //  - self: `File`
+        //
+        // returns `string`|`null` the line, or `null` once the end of the file is reached.
+        static pxs_VarT readline(pxs_VarT args);
+
+    #ifdef PXS_JSON
+        // @except
+        // Decode the JSON from the current position of `self` to its end. Read in chunks, the text is never
+        // held whole.
+        // args:
+        //  - self: `File`
+        //  - pointer: @opt `string` JSON pointer (i.e. `/mods/0`) of the only value to build. Defaults to the whole document.
+        //
+        // returns `any` the decoded value.
+        static pxs_VarT read_json(pxs_VarT args);
+    #endif
+
+        // @except
+        // Move the read/write position of `self`.
+        // args:
+        //  - self: `File`
+        //  - offset: `int` offset in bytes.
+        //  - from: @opt `SeekFrom` Defaults to `SeekFrom::Start`.
+        //
+        // returns `int` the new position.
+        static pxs_VarT seek(pxs_VarT args);
+
+        // @except
+        // Get the current read position of `self`.
+        // args:
+        //  - self: `File`
+        //
+        // returns `int`
+        static pxs_VarT tell(pxs_VarT args);
+
         // @except
         // Write into `self`.
         // args:
         //  - self: `File`
-        //  - data: `string`|`[]uint` Data to write.
+        //  - data: `string`|`[]uint`|buffer Data to write.
         static pxs_VarT write(pxs_VarT args);
 
         // @except
         // Append onto `self`.
         // args:
         //  - self: `File`
-        //  - data: `string`|`[]uint` Data to append.
+        //  - data: `string`|`[]uint`|buffer Data to append.
         // 
         // returns `int` the new size of the file.
         static pxs_VarT append(pxs_VarT args);
@@ -161,6 +370,185 @@ namespace yoyo::fs {
         static pxs_VarT save(pxs_VarT args);
     };
 
+    // @private
+    // Shared state of a `read_async` call. Lives until the handle, the worker and (with a callback) the pump are done with it.
+    struct AsyncRead;
+
+    // Returned by `read_async`. Either poll `done`/`result` or pass a callback, which runs inside `yoyo_pump`.
+    class ReadHandle {
+        // @private
+        std::shared_ptr<AsyncRead> state;
+
+    public:
+        ReadHandle(std::shared_ptr<AsyncRead> state);
+
+        // @prop(get)
+        // Has the read finished?
+        //
+        // args:
+        //  - self: `ReadHandle`
+        //
+        // returns `bool`
+        static pxs_VarT get_done(pxs_VarT args);
+
+        // @except
+        // Get the result of the read.
+        // args:
+        //  - self: `ReadHandle`
+        //
+        // returns `string`|`[]uint`|`null` the contents, or `null` if it has not finished yet.
+        static pxs_VarT result(pxs_VarT args);
+
+        // @except
+        // Block until the read finishes.
+        // args:
+        //  - self: `ReadHandle`
+        //
+        // returns `string`|`[]uint` the contents.
+        static pxs_VarT wait(pxs_VarT args);
+    };
+
+    // Read a file on a background thread. Does not block.
+    // args:
+    //  - path: `string` path to the file.
+    //  - read_type: @opt `FileReadType` Defaults to `FileReadType::Text`. `Mapped` is treated as `Bytes`.
+    //  - callback: @opt `function(result)` called from `yoyo_pump` once finished. `result` can be a exception.
+    //
+    // returns `ReadHandle`
+    pxs_VarT read_async(pxs_VarT args);
+
+    // @except
+    // Read many files at once. Reads run in parallel on the worker pool, one call instead of a `read_file` per path.
+    // args:
+    //  - paths: `[]string` paths to the files.
+    //  - read_type: @opt `FileReadType` Defaults to `FileReadType::Text`. `Mapped` is treated as `Bytes`.
+    //
+    // returns `{string: string|[]uint|exception}` path to contents. Failed reads map to a exception instead of throwing.
+    pxs_VarT read_files(pxs_VarT args);
+
+    // @private
+    // Run the callbacks of async reads started on this thread that have finished.
+    //
+    // returns the number of reads handled.
+    int pump();
+
+    // A LRU cache of file contents used by `cached_reader`.
+    // Entries are keyed by path and are only valid while the file's mtime and size don't change.
+    class FileCache {
+        struct Entry {
+            std::string path;
+            std::string contents;
+            int64_t mtime;
+            uint64_t size;
+        };
+
+        // @private
+        // Most recently used first.
+        std::list<Entry> lru;
+        // @private
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+        // @private
+        // Bytes currently held.
+        size_t bytes = 0;
+        // @private
+        // Max bytes to hold.
+        size_t budget = 0;
+        // @private
+        uint64_t hits = 0;
+        // @private
+        uint64_t misses = 0;
+        // @private
+        std::mutex lock;
+
+        // @private
+        // Drop least recently used entries until under budget.
+        void evict();
+        // @private
+        void erase(std::list<Entry>::iterator it);
+
+    public:
+        // Set the byte budget. Evicts if needed.
+        void set_budget(size_t budget);
+        // Read `path` through the cache. Returns false if the file could not be read.
+        bool read(const std::string& path, std::string& out);
+        // Drop a single path.
+        void invalidate(const std::string& path);
+        // Drop everything.
+        void clear();
+        // Get hits, misses, bytes, entries as a `pxs_Map`.
+        pxs_VarT stats();
+    };
+
+    // @private
+    // The process wide `FileCache`.
+    FileCache& file_cache();
+
+    // @private
+    // A `pxs_LoadFileFn` that reads from disk through `file_cache`.
+    pxs_VarT cached_reader(const char* path);
+
+    // @private
+    // Set `cached_reader` as the pixelscript file reader with a byte budget.
+    void use_file_cache(size_t budget);
+
+    // Drop cached file contents used by module loading.
+    // args:
+    //  - path: @opt `string` the path to drop. Drops everything when not passed.
+    pxs_VarT invalidate_cache(pxs_VarT args);
+
+    // Get the stats of the module loading cache.
+    //
+    // returns `{hits: int, misses: int, bytes: int, entries: int}`
+    pxs_VarT cache_stats(pxs_VarT args);
+
+    // A TTL cache of existence checks used by `exists`, `is_dir` and `File`.
+    // Disabled by default (TTL of 0). Yoyo's own writes and removals invalidate the paths they touch.
+    class StatCache {
+        struct Stat {
+            bool exists;
+            bool is_dir;
+            std::chrono::steady_clock::time_point at;
+        };
+
+        // @private
+        // Ordered so everything under a directory can be dropped at once.
+        std::map<std::string, Stat> entries;
+        // @private
+        std::chrono::milliseconds ttl{0};
+        // @private
+        std::mutex lock;
+
+        // @private
+        // Query the filesystem, and cache it when enabled.
+        Stat lookup(const std::string& path);
+
+    public:
+        // Set the TTL. 0 disables and clears the cache.
+        void set_ttl(int64_t ttl_ms);
+        // Does `path` exist?
+        bool exists(const std::string& path);
+        // Is `path` a directory?
+        bool is_dir(const std::string& path);
+        // Drop `path`, everything under it and its parents.
+        void invalidate(const std::string& path);
+        // Drop everything.
+        void clear();
+    };
+
+    // @private
+    // The process wide `StatCache`.
+    StatCache& stat_cache();
+
+    // Cache `exists` and `is_dir` results for some time. Useful when running the same checks every frame.
+    // args:
+    //  - ttl_ms: `int` how long a result is valid in milliseconds. 0 turns the cache off.
+    pxs_VarT cache_stat(pxs_VarT args);
+
+    // Drop cached `exists`/`is_dir` results.
+    // args:
+    //  - path: @opt `string` the path to refresh. Refreshes everything when not passed.
+    pxs_VarT refresh_stat(pxs_VarT args);
+
     // @except
     // Read a file.
     // args:
@@ -169,6 +557,21 @@ namespace yoyo::fs {
     // 
     // returns `string`|`[]uint`
     pxs_VarT read_file(pxs_VarT args);
+
+#ifdef PXS_JSON
+    // @private
+    // Decode the JSON of `in` through a `pxs_json_newstream`, one chunk at a time.
+    pxs_VarT stream_json(std::istream& in, const char* pointer);
+
+    // @except
+    // Decode a JSON file without reading it into a string first. Use it for large files.
+    // args:
+    //  - path: `string` path to the file.
+    //  - pointer: @opt `string` JSON pointer (i.e. `/mods/0`) of the only value to build. Defaults to the whole document.
+    //
+    // returns `any` the decoded value.
+    pxs_VarT read_json(pxs_VarT args);
+#endif
     
     // @except
     // Read the entries of a directory.
@@ -178,11 +581,32 @@ namespace yoyo::fs {
     // returns `[]string` file entries.
     pxs_VarT read_dir(pxs_VarT args);
 
+    // @except
+    // Read the entries of a directory along with their metadata. One call instead of `read_dir` + `is_dir` + ...
+    // args:
+    //  - path: `string` path to the directory.
+    //  - with_meta: @opt `bool` include `size` and `mtime`. Defaults to true.
+    //
+    // returns `[]{name: string, type: EntryType, size: int, mtime: int}`
+    pxs_VarT scan_dir(pxs_VarT args);
+
+    // @except
+    // Recursively walk a directory. Directories are read in parallel on a pool of worker threads
+    // and filtering happens natively, only matching entries become `pxs_Var`s.
+    // args:
+    //  - root: `string` path to the directory.
+    //  - filter: @opt `string`|`[]string` glob(s) matched against file names, i.e. `*.lua`. Directories are only returned when no filter is passed.
+    //  - max_depth: @opt `int` how deep to go. -1 for no limit. Defaults to -1.
+    //  - threads: @opt `int` number of workers. Defaults to the number of hardware threads.
+    //
+    // returns `[]{path: string, name: string, type: EntryType, size: int, mtime: int}` sorted by path. `path` is relative to `root`.
+    pxs_VarT walk(pxs_VarT args);
+
     // @except
     // Write to a file.
     // args:
     //  - path: `string` path to the file.
-    //  - data: `string`|`[]uint` the data to write.
+    //  - data: `string`|`[]uint`|buffer the data to write.
     pxs_VarT write_file(pxs_VarT args);
 
     // Check if a file/dir exists.
@@ -190,7 +614,7 @@ namespace yoyo::fs {
     //  - path: `string` file/dir path.
     //
     // returns: `bool`
-    pxs_VarT exists(pxs_VarT args);
+    bool exists(const std::string& path);
 
     // @except
     // Remove a directory.
@@ -217,10 +641,74 @@ namespace yoyo::fs {
     //  - path: `string` path
     //
     // returns `bool`
-    pxs_VarT is_dir(pxs_VarT args);
+    bool is_dir(const std::string& path);
+
+    // The `kind` of a change reported by `watch`.
+    enum class WatchEvent : uint8_t {
+        Created = 0,
+        Modified = 1,
+        Removed = 2,
+        // The OS dropped changes, `path` (the watched one) has to be rescanned.
+        Overflow = 3
+    };
 
     // @private
-    // 
+    // Shared state of a `watch` call, lives on the thread that called it.
+    struct WatchState;
+
+    // Returned by `watch`. Changes are coalesced per path in a native queue: a file written many times is one
+    // `Modified`, created then removed is nothing. Renames are a `Removed` and a `Created`.
+    class Watcher {
+        // @private
+        std::shared_ptr<WatchState> state;
+
+    public:
+        Watcher(std::shared_ptr<WatchState> state);
+        ~Watcher();
+
+        // @self
+        // @prop(get)
+        // The watched path, as passed to `watch`.
+        //
+        // returns `string`
+        static pxs_VarT get_path(pxs_VarT args);
+
+        // @self
+        // Take the changes so far. Use it instead of a callback.
+        //
+        // returns `[]{path: string, kind: WatchEvent}` in the order the paths first changed.
+        static pxs_VarT poll(pxs_VarT args);
+
+        // @self
+        // Stop watching. Changes not taken yet are dropped.
+        static pxs_VarT close(pxs_VarT args);
+    };
+
+    // @except
+    // Watch a file or directory for changes, with inotify on Linux, FSEvents on macOS and
+    // `ReadDirectoryChangesW` on Windows. Nothing polls the filesystem.
+    // Changed paths are dropped from the module loading cache and the stat cache as they arrive.
+    // args:
+    //  - path: `string` the file or directory.
+    //  - options: @opt `{recursive: bool, latency: int}`. `recursive` watches subdirectories too, defaults to false.
+    //    `latency` is how long in milliseconds changes are held to batch them, defaults to 50.
+    //  - callback: @opt `function(changes)` called from `yoyo_pump` with the batch, see `Watcher.poll`.
+    //
+    // returns `Watcher`
+    pxs_VarT watch(pxs_VarT args);
+
+    // @private
+    // Hand the batched changes of watchers started on this thread to their callbacks.
+    //
+    // returns the number of batches handled.
+    int watch_pump();
+
+    // @private
+    // Register `Watcher` and `watch` on the `fs` module.
+    void init_watch(pxs_Module* fs_mod);
+
+    // @private
+    //
     // Initialize the `yoyo.fs` module.
     void init(pxs_Module* yoyo);
 };
@@ -0,0 +1,146 @@
+#pragma once
+
+#ifdef YOYO_HASH
+
+#include <pixelscript.h>
+#include <pixelscript_cpp.hpp>
+#include <cstdint>
+#include <memory>
+
+namespace yoyo::hash {
+    // Algorithms of `hasher` and `hash_file`.
+    enum class Algorithm : uint8_t {
+        // 64 bit xxHash3, not for security.
+        Xxh3 = 0,
+        // 128 bit xxHash3, not for security.
+        Xxh128 = 1,
+        // The zlib/gzip CRC-32.
+        Crc32 = 2,
+        // CRC-32C (Castagnoli), as used by iSCSI, ext4 and friends.
+        Crc32c = 3,
+        // SHA-256.
+        Sha256 = 4
+    };
+
+    // @private
+    // The native state of a `Hasher`.
+    class Engine;
+
+    // Returned by `hasher`. Hashes chunk by chunk, the result is the same as hashing everything at once.
+    class Hasher {
+        // @private
+        std::unique_ptr<Engine> engine;
+        // @private
+        Algorithm algorithm;
+
+    public:
+        Hasher(std::unique_ptr<Engine> engine, Algorithm algorithm);
+        ~Hasher();
+
+        // @prop(get)
+        // The `Algorithm` of this hasher.
+        //
+        // args:
+        //  - self: `Hasher`
+        //
+        // returns `Algorithm`
+        static pxs_VarT get_algorithm(pxs_VarT args);
+
+        // @except
+        // Hash a chunk.
+        // args:
+        //  - self: `Hasher`
+        //  - data: `[]uint`|`string` the chunk.
+        static pxs_VarT update(pxs_VarT args);
+
+        // The hash of everything so far, big endian. More can be hashed after.
+        // args:
+        //  - self: `Hasher`
+        //
+        // returns `[]uint`
+        static pxs_VarT digest(pxs_VarT args);
+
+        // `digest` as lowercase hex.
+        // args:
+        //  - self: `Hasher`
+        //
+        // returns `string`
+        static pxs_VarT hexdigest(pxs_VarT args);
+
+        // Start over, keeping the algorithm and seed.
+        // args:
+        //  - self: `Hasher`
+        static pxs_VarT reset(pxs_VarT args);
+    };
+
+    // @except
+    // 64 bit xxHash3 of the data.
+    // args:
+    //  - data: `[]uint`|`string` the data.
+    //  - seed: @opt `int` defaults to 0.
+    //
+    // returns `int` the 64 bits, negative from 2^63 in runtimes with signed 64 bit ints. `Hasher.hexdigest` has the
+    // unsigned form.
+    pxs_VarT xxh3(pxs_VarT args);
+
+    // @except
+    // 128 bit xxHash3 of the data.
+    // args:
+    //  - data: `[]uint`|`string` the data.
+    //  - seed: @opt `int` defaults to 0.
+    //
+    // returns `string` 32 hex characters, high half first.
+    pxs_VarT xxh128(pxs_VarT args);
+
+    // @except
+    // CRC-32 of the data, the one of zlib and gzip. Uses carry-less multiply when the CPU has it.
+    // args:
+    //  - data: `[]uint`|`string` the data.
+    //  - crc: @opt `int` the crc of the data before, to continue it. Defaults to 0.
+    //
+    // returns `int`
+    pxs_VarT crc32(pxs_VarT args);
+
+    // @except
+    // CRC-32C of the data. Uses the CRC instructions of SSE4.2 or ARMv8 when the CPU has them.
+    // args:
+    //  - data: `[]uint`|`string` the data.
+    //  - crc: @opt `int` the crc of the data before, to continue it. Defaults to 0.
+    //
+    // returns `int`
+    pxs_VarT crc32c(pxs_VarT args);
+
+    // @except
+    // SHA-256 of the data. Uses the SHA extensions when the CPU has them.
+    // args:
+    //  - data: `[]uint`|`string` the data.
+    //
+    // returns `string` 64 hex characters.
+    pxs_VarT sha256(pxs_VarT args);
+
+    // @except
+    // Create a streaming `Hasher`.
+    // args:
+    //  - algorithm: `Algorithm` the algorithm.
+    //  - seed: @opt `int` seed of `Algorithm::Xxh3` and `Algorithm::Xxh128`. Defaults to 0.
+    //
+    // returns `Hasher`
+    pxs_VarT hasher(pxs_VarT args);
+
+    // @except
+    // Hash a file through a memory mapping, without reading it into a script value. Needs `YOYO_FS`.
+    // args:
+    //  - path: `string` the file.
+    //  - algorithm: @opt `Algorithm` defaults to `Algorithm::Xxh3`.
+    //  - seed: @opt `int` seed of `Algorithm::Xxh3` and `Algorithm::Xxh128`. Defaults to 0.
+    //
+    // returns `string` the hex digest, like `Hasher.hexdigest`.
+    pxs_VarT hash_file(pxs_VarT args);
+
+    // @private
+    //
+    // Initialize the `yoyo.hash` module.
+    void init(pxs_Module* yoyo);
+};
+
+#endif // YOYO_HASH
@@ -6,6 +6,8 @@
 #include <string>
 #include <cstdint>
 #include <vector>
+#include <memory>
+#include <functional>
 
 namespace yoyo::net {
     // 
@@ -24,6 +26,22 @@ namespace yoyo::net {
         HTTP_3
     };
 
+    // @private
+    // How long each phase of a request took, in milliseconds.
+    // Phases that did not happen (i.e. connecting on a reused connection) stay 0.
+    struct Timings {
+        double dns = 0;
+        double connect = 0;
+        double tls = 0;
+        // From sending the request to the status line.
+        double ttfb = 0;
+        // From the status line to the end of the body.
+        double transfer = 0;
+        double total = 0;
+        // Was a keep-alive connection used?
+        bool reused = false;
+    };
+
     // @private
     /// Response data.
     struct ResponseData {
@@ -35,28 +53,56 @@ namespace yoyo::net {
         std::string body;
         // @private
         // The request type (GET,POST,etc)
-        RequestType request_type;
+        RequestType request_type = RequestType::GET;
         // @private
         // The HTTP version to use (if supported.)
-        HttpVersion version;
+        HttpVersion version = HttpVersion::HTTP_1_1;
         // @private
         // Timeout in milliseconds
-        int timeout;
+        int timeout = 30000;
         // @private
         // The user agent. This can only be set once per client.
         std::string user_agent;
         // @private
         // The domain name.
         std::string domain_name;
+        // @private
+        // Filled in on responses.
+        Timings timings;
     };
 
+    // @private
+    // Receives the response body as it arrives, along with the response status.
+    using BodySink = std::function<void(int status, const char* data, size_t len)>;
+
     class ClientResponse {
+        // @private
+        // Converted `text`/`bytes`, made on first access. Owned.
+        pxs_VarT text_cache = nullptr;
+        pxs_VarT bytes_cache = nullptr;
+        // @private
+        // The body once `bytes` moved it out of `data`, owned by the buffer of `bytes_cache`. Lives at least as long
+        // as this response.
+        const std::string* moved_body = nullptr;
+
     public:
+        ClientResponse() = default;
+        // Caches are not shared, the copy converts on its own.
+        ClientResponse(const ClientResponse& other) : data(other.data), status(other.status) {
+            this->data.body = other.body();
+        }
+        ClientResponse& operator=(const ClientResponse&) = delete;
+        ~ClientResponse();
+
+        // @private
+        // The response body, wherever it lives now.
+        const std::string& body() const { return moved_body != nullptr ? *moved_body : data.body; }
+
         // @private
         ResponseData data;
 
         // @private
-        int status;
+        int status = 0;
 
         // @private
         // Convert into its pxs type
@@ -64,7 +110,7 @@ namespace yoyo::net {
 
         // @self
         // @prop(get)
-        // The HTTP version.
+        // The HTTP version that was actually used.
         // 
         // returns `int`
         static pxs_VarT prop_version(pxs_VarT args);
@@ -78,9 +124,9 @@ namespace yoyo::net {
 
         // @self
         // @prop(get)
-        // The response bytes.
+        // The response bytes, a buffer over the body without a copy. Stays valid after the response is gone.
         //
-        // returns `[]uint`
+        // returns `buffer`
         static pxs_VarT prop_bytes(pxs_VarT args);
 
         // @self
@@ -89,25 +135,52 @@ namespace yoyo::net {
         // 
         // returns `string`
         static pxs_VarT prop_text(pxs_VarT args);
+
+        // @self
+        // @prop(get)
+        // How long the request took per phase, in milliseconds.
+        // Keys: `dns`, `connect`, `tls`, `ttfb`, `transfer`, `total` and `reused`.
+        //
+        // returns `map[string]float`
+        static pxs_VarT prop_timings(pxs_VarT args);
     };
 
     // A class that  `ClientResponse`.
     class Client {
         // @private
-        // The internal type/value
-        void* internal;
+        // The internal type/value. Shared so in flight async requests keep the session alive.
+        std::shared_ptr<void> internal;
         
         // @private
         // Use HTTPS. Defaults to true.
         bool use_https = true;
+
+        // @private
+        // Max keep-alive connections per server. 0 closes every connection after its request.
+        size_t max_connections = 6;
+
+        // @private
+        // How long a keep-alive connection can sit idle before it is dropped, in milliseconds.
+        int idle_timeout = 60000;
+
+        // @private
+        // Ask for `gzip`/`deflate` and decode it. Defaults to true.
+        bool decompress = true;
+
+        // @private
+        // Use the process wide session (connections, DNS and TLS session caches). Defaults to true.
+        bool shared_session = true;
         
         // @private
         // Get headers as std::vector<std::string> or parts (key:value).
         std::vector<std::string> get_header_parts();
 
+        // @private
+        // Sets `use_https` from the url scheme.
+        friend pxs_VarT fetch_all(pxs_VarT args);
+
     public:
         Client() {}
-        ~Client();
         // @private
         // The data to create a response with.
         ResponseData data;
@@ -118,7 +191,8 @@ namespace yoyo::net {
         // @private
         // Return a non pxs_native `ClientResponse`.
         // It can be converted to a pxs_native object via `to_pxs`.
-        ClientResponse* create_request(const std::string& path, const RequestType& rt);
+        // With a `sink` the body is streamed into it and the response body stays empty.
+        ClientResponse* create_request(const std::string& path, const RequestType& rt, const BodySink& sink = nullptr);
 
         // @name(Client)
         // Create a new `Client`
@@ -177,6 +251,44 @@ namespace yoyo::net {
         // returns `string`|`null`
         static pxs_VarT prop_domain(pxs_VarT args);
 
+        // @self
+        // @prop(get,set)
+        // Max keep-alive connections per server. 0 disables keep-alive.
+        // args:
+        //  - max: @set `int` the max connections.
+        //
+        // returns `int`|`null`
+        static pxs_VarT prop_max_connections(pxs_VarT args);
+
+        // @self
+        // @prop(get,set)
+        // How long an idle keep-alive connection is kept, in milliseconds.
+        // args:
+        //  - ms: @set `int` the idle timeout.
+        //
+        // returns `int`|`null`
+        static pxs_VarT prop_idle_timeout(pxs_VarT args);
+
+        // @self
+        // @prop(get,set)
+        // Send `Accept-Encoding: gzip, deflate` and decode compressed bodies. Defaults to true.
+        // Setting a `Accept-Encoding` header yourself skips the negotiation, bodies are still decoded.
+        // args:
+        //  - enabled: @set `bool`
+        //
+        // returns `bool`|`null`
+        static pxs_VarT prop_decompress(pxs_VarT args);
+
+        // @self
+        // @prop(get,set)
+        // Share connections and TLS sessions with every other `Client`. Defaults to true.
+        // Turn it off for a private session.
+        // args:
+        //  - shared: @set `bool`
+        //
+        // returns `bool`|`null`
+        static pxs_VarT prop_shared_session(pxs_VarT args);
+
         // @except
         // @self
         // Make a request
@@ -186,8 +298,172 @@ namespace yoyo::net {
         //
         // returns `string`
         static pxs_VarT make_request(pxs_VarT args);
+
+        // @self
+        // Make a request on a background thread. Does not block.
+        // args:
+        //  - url: `string` the url to make the request to.
+        //  - rt: `RequestType` the request type to send.
+        //  - callback: @opt `function(response)` called from `yoyo_pump` once finished. `response` can be a exception.
+        //
+        // returns `PendingResponse`
+        static pxs_VarT request_async(pxs_VarT args);
+
+        // @self
+        // Make many requests to this client's domain at once. They run concurrently on up to `max_connections`
+        // connections, with `HTTP_2`/`HTTP_3` set they are multiplexed over one connection where the platform supports it.
+        // args:
+        //  - requests: `[]string|[][string, RequestType]` paths, optionally with a request type. Defaults to `GET`.
+        //
+        // returns `[]ClientResponse` in the same order. Failed requests are exceptions instead of failing the whole call.
+        static pxs_VarT request_many(pxs_VarT args);
+
+        // @except
+        // @self
+        // Download straight into a file without holding the body in memory.
+        // args:
+        //  - url: `string` the url to download.
+        //  - path: `string` the file to write to.
+        //  - resume: @opt `bool` continue a partial file with a `Range` header. Defaults to false.
+        //
+        // returns `ClientResponse` with an empty body.
+        static pxs_VarT download(pxs_VarT args);
+
+        // @except
+        // @self
+        // Make a request and receive the body in fixed size chunks.
+        // args:
+        //  - url: `string` the url to make the request to.
+        //  - rt: `RequestType` the request type to send.
+        //  - callback: `function(chunk: []uint)` called per chunk. Return `false` to stop.
+        //  - chunk_size: @opt `int` Defaults to 64KB. The last chunk can be smaller.
+        //
+        // returns `ClientResponse` with an empty body.
+        static pxs_VarT stream(pxs_VarT args);
     };
 
+    // @private
+    // Shared state of a `request_async` call.
+    struct PendingState;
+
+    // Returned by `Client.request_async`.
+    class PendingResponse {
+        // @private
+        std::shared_ptr<PendingState> state;
+
+    public:
+        PendingResponse(std::shared_ptr<PendingState> state);
+
+        // @self
+        // Has the request finished?
+        //
+        // returns `bool`
+        static pxs_VarT done(pxs_VarT args);
+
+        // @self
+        // Wait for the request to finish, at most `timeout` milliseconds.
+        // args:
+        //  - timeout: @opt `int` how long to wait. Defaults to 0 (don't wait).
+        //
+        // returns `bool` if it has finished.
+        static pxs_VarT poll(pxs_VarT args);
+
+        // @except
+        // @self
+        // Block until the request finishes.
+        //
+        // returns `ClientResponse`
+        static pxs_VarT result(pxs_VarT args);
+    };
+
+    // @private
+    // Shared state of a `serve` call, lives on the thread that called it.
+    struct ServerState;
+
+    // Returned by `serve`. A HTTP/1.1 server with keep-alive, its sockets run on a I/O thread of its own
+    // (epoll, kqueue or WSAPoll). Published routes are answered there, everything else is handed to the handler
+    // from `yoyo_pump`, so scripts only run on the thread that called `serve`.
+    class Server {
+        // @private
+        std::shared_ptr<ServerState> state;
+
+    public:
+        Server(std::shared_ptr<ServerState> state);
+        ~Server();
+
+        // @self
+        // @prop(get)
+        // The port it listens on, the picked one when `serve` got 0.
+        //
+        // returns `int`
+        static pxs_VarT prop_port(pxs_VarT args);
+
+        // @except
+        // @self
+        // Answer `GET`/`HEAD` requests of `path` with `body` straight from the I/O thread, without calling the
+        // handler. Publish again to update it, i.e. from a timer for metrics.
+        // args:
+        //  - path: `string` the path, without a query.
+        //  - body: `string`|`[]uint`|`null` the body, null stops publishing `path`.
+        //  - content_type: @opt `string` defaults to `text/plain; charset=utf-8`.
+        static pxs_VarT publish(pxs_VarT args);
+
+        // @self
+        // Counters since `serve`.
+        //
+        // returns `{requests: int, published: int, dispatched: int, rejected: int, connections: int, open: int}`.
+        // `rejected` counts requests answered with an error (bad request, too large, too many pending).
+        static pxs_VarT stats(pxs_VarT args);
+
+        // @self
+        // Stop listening and close every connection. Requests still waiting for the pump are dropped.
+        static pxs_VarT close(pxs_VarT args);
+    };
+
+    // @except
+    // Listen for HTTP/1.1 requests.
+    // args:
+    //  - port: `int` the port, 0 picks a free one (see `Server.port`).
+    //  - handler: @opt `function(request)` called from `yoyo_pump` for requests of paths that are not published.
+    //    `request` is `{method: string, path: string, query: string, headers: {string: string}, body: string}`
+    //    with lowercase header names. Return a `string`/`[]uint` body (200), `[status, body, headers]` (headers
+    //    optional, `{string: string}`) or `null` (204). Without a handler those requests get 404.
+    //  - options: @opt `{host: string, max_body: int, idle_timeout: int, max_pending: int}`. `host` defaults to
+    //    `127.0.0.1`, `max_body` to 1MB, `idle_timeout` (ms) to 5000 and `max_pending` (requests waiting for the
+    //    pump before new ones get 503) to 1024.
+    //
+    // returns `Server`
+    pxs_VarT serve(pxs_VarT args);
+
+    // @private
+    // Call the handlers of servers started on this thread for their waiting requests.
+    //
+    // returns the number of requests handled.
+    int serve_pump();
+
+    // @private
+    // Register `Server` and `serve` on the `net` module.
+    void init_server(pxs_Module* net_mod);
+
+    // @private
+    // Run the callbacks of async requests started on this thread that have finished.
+    //
+    // returns the number of requests handled.
+    int pump();
+
+    // @private
+    // Start or stop recording latency histograms per domain. Off by default.
+    void track_stats(bool enabled);
+
+    // @private
+    // Write the recorded stats as JSON into `out`, nul terminated.
+    // `{"domain": {"count": n, "errors": n, "total_ms": f, "buckets": [...]}}`, bucket `i` counts
+    // requests that took at most `2^i` ms, the last one everything slower.
+    // With `reset` the stats are cleared, but only when they fit.
+    //
+    // returns the length needed without the nul.
+    size_t write_stats(char* out, size_t len, bool reset);
+
     // @except
     // Make a HTTP Get request.
     // args:
@@ -209,6 +485,22 @@ namespace yoyo::net {
     // returns `ClientResponse`
     pxs_VarT post(pxs_VarT args);
 
+    // Fetch many urls at once on a native worker pool. Unlike `Client.request_many` they can be on different domains.
+    // Every request goes through the shared session, so requests to the same server reuse its connections.
+    // args:
+    //  - requests: `[]string|[][url, rt, body, headers]` urls, or lists of a url and optionally a `RequestType`,
+    //    a body (`string`|`[]uint`) and headers (`[][]string`).
+    //  - max_concurrency: @opt `int` how many requests run at the same time. Defaults to 6.
+    //  - timeout: @opt `int` timeout per request in milliseconds. Defaults to 30000.
+    //
+    // returns `[]ClientResponse` in the same order. Failed requests are exceptions instead of failing the whole call.
+    pxs_VarT fetch_all(pxs_VarT args);
+
+    // Set how long resolved hosts are cached. Windows uses the WinHTTP cache and ignores it.
+    // args:
+    //  - ttl_ms: `int` cache time in milliseconds. 0 disables the cache. Defaults to 60000.
+    pxs_VarT set_dns_ttl(pxs_VarT args);
+
     void init(pxs_Module* yoyo_mod);
 };
 
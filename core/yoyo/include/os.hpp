@@ -1,9 +1,107 @@
 #pragma once
 #ifdef YOYO_OS
 #include <pixelscript_cpp.hpp>
+#include <string>
+#include <vector>
 
 namespace yoyo::os {
-    void init(pxs_Module* yoyo, pxs_VarT argv);
+    // @private
+    // Use `args` as `argv` instead of asking the OS. Set by the host with `yoyo_os_setargs`.
+    void set_args(std::vector<std::string> args);
+
+    // Get the current working directory.
+    //
+    // returns `string`
+    pxs_VarT get_cwd(pxs_VarT args);
+
+    // @except
+    // Change the current directory.
+    // args:
+    //  - new_path: `string` the new directory.
+    pxs_VarT ch_dir(pxs_VarT args);
+
+    // The number of CPUs this process may run on.
+    // args:
+    //  - physical: @opt `bool` count physical cores instead of logical CPUs (hardware threads). Defaults to false.
+    //
+    // returns `int`
+    pxs_VarT cpu_count(pxs_VarT args);
+
+    // The CPUs this process may run on, grouped by core.
+    //
+    // returns `{logical: int, physical: int, packages: int, cores: [][]int}` with the logical CPU ids of every core.
+    pxs_VarT cpu_topology(pxs_VarT args);
+
+    // @except
+    // Limit the current thread to some logical CPUs.
+    // args:
+    //  - cpus: `[]int` the logical CPU ids.
+    //
+    // returns `bool` false when the OS refused, always on macOS.
+    pxs_VarT set_affinity(pxs_VarT args);
+
+    // The logical CPUs the current thread may run on.
+    //
+    // returns `[]int`
+    pxs_VarT get_affinity(pxs_VarT args);
+
+    // @except
+    // Pin the current thread to one logical CPU.
+    // args:
+    //  - cpu: @opt `int` the logical CPU id. Defaults to the CPU of the next worker, one per physical core.
+    //
+    // returns `bool` false when the OS refused, always on macOS.
+    pxs_VarT pin_current_thread(pxs_VarT args);
+
+    // The resident memory of the process in bytes.
+    //
+    // returns `int`
+    pxs_VarT rss(pxs_VarT args);
+
+    // The highest resident memory of the process so far in bytes.
+    //
+    // returns `int`
+    pxs_VarT peak_rss(pxs_VarT args);
+
+    // CPU time used by the process so far, in seconds.
+    //
+    // returns `{user: float, system: float}`
+    pxs_VarT cpu_time(pxs_VarT args);
+
+    // @except
+    // Get an environment variable.
+    // args:
+    //  - name: `string` the name.
+    //
+    // returns `string`|`null` null when not set.
+    pxs_VarT get_env(pxs_VarT args);
+
+    // @except
+    // Set an environment variable of this process. Not safe while other threads read the environment.
+    // args:
+    //  - name: `string` the name.
+    //  - value: `string` the value.
+    //
+    // returns `bool` false when the OS refused.
+    pxs_VarT set_env(pxs_VarT args);
+
+    // @except
+    // Remove an environment variable of this process. Not safe while other threads read the environment.
+    // args:
+    //  - name: `string` the name.
+    //
+    // returns `bool` false when the OS refused.
+    pxs_VarT unset_env(pxs_VarT args);
+
+    // Every environment variable, `os.environ` in scripts.
+    //
+    // returns `{string: string}`
+    pxs_VarT get_environ(pxs_VarT args);
+
+    // @private
+    //
+    // Initialize the `yoyo.os` module.
+    void init(pxs_Module* yoyo);
 };
 
-#endif // YOYO_OS
\ No newline at end of file
+#endif // YOYO_OS
@@ -8,10 +8,62 @@
 // since pixelscript_cpp already uses `pxs` as a module.
 
 namespace yoyo::ipxs {
+    // Code compiled once with `compile`, ran many times with `run`.
+    class Code {
+    public:
+        // @private
+        // The `pxs_compile` object (runtime, code object, global scope).
+        pxs_VarT object;
+        // @private
+        // Runtime it was compiled for.
+        pxs_Runtime runtime;
+
+        Code(pxs_Runtime runtime, pxs_VarT object);
+        ~Code();
+
+        // @prop(get)
+        // The runtime the code was compiled for.
+        //
+        // args:
+        //  - self: `Code`
+        //
+        // returns `int`
+        static pxs_VarT get_runtime(pxs_VarT args);
+    };
+
     // Execute code
     // Null means it was executed succesfully.
     pxs_VarT exec(pxs_VarT args);
 
+    // @except
+    // Evaluate code and return its result.
+    // args:
+    //  - runtime: `int` the runtime to run it in, i.e. `pxs.LUA`.
+    //  - code: `string` the code.
+    //  - name: @opt `string` name of the code, shown in errors. Defaults to `<eval>`.
+    //
+    // returns `any`
+    pxs_VarT eval(pxs_VarT args);
+
+    // @except
+    // Compile code once, to `run` it many times without parsing it again.
+    // args:
+    //  - runtime: `int` the runtime to compile for, i.e. `pxs.LUA`.
+    //  - code: `string` the code.
+    //  - globals: @opt `{string: any}` the global scope of the code. Copied.
+    //
+    // returns `Code`
+    pxs_VarT compile(pxs_VarT args);
+
+    // @except
+    // Run a `Code`.
+    // args:
+    //  - code: `Code` from `compile`.
+    //  - locals: @opt `{string: any}` the local scope of this run. Copied.
+    //
+    // returns `any` the result of the run.
+    pxs_VarT run(pxs_VarT args);
+
     void init(pxs_Module* yoyo);
 };
 
@@ -4,15 +4,104 @@
 
 #include <pixelscript.h>
 #include <pixelscript_cpp.hpp>
-
-// TODO: implement a better shell.
+#include <cstdint>
+#include <memory>
 
 namespace yoyo::shell {
+    // The output streams of a `Process`.
+    enum class ProcessStream : uint8_t {
+        Stdout = 0,
+        Stderr = 1
+    };
+
+    // @private
+    // The native side of a `Process`, its pipes and what was read from them.
+    struct ProcessHandle;
+
+    // A running (or finished) process started with `spawn`.
+    // Its output is kept in pipes that never block, so a script can read a bit every frame.
+    // While waiting the pipes are drained, a child never gets stuck on a full pipe. Dropping a `Process`
+    // that is still running kills it.
+    class Process {
+        // @private
+        std::unique_ptr<ProcessHandle> handle;
+
+    public:
+        Process(std::unique_ptr<ProcessHandle> handle);
+        ~Process();
+
+        // @prop(get)
+        // The id of the process.
+        //
+        // args:
+        //  - self: `Process`
+        //
+        // returns `int`
+        static pxs_VarT get_pid(pxs_VarT args);
+
+        // @prop(get)
+        // The exit code of the process. Negative when it was ended by a signal.
+        //
+        // args:
+        //  - self: `Process`
+        //
+        // returns `int`|`null` `null` while it is still running.
+        static pxs_VarT get_exit_code(pxs_VarT args);
+
+        // Read what the process has written so far, without blocking.
+        // args:
+        //  - self: `Process`
+        //  - stream: @opt `ProcessStream` defaults to `ProcessStream::Stdout`.
+        //  - size: @opt `int` max number of bytes to read. Defaults to 64KB.
+        //  - bytes: @opt `bool` return `[]uint` instead of a `string`. Defaults to false.
+        //
+        // returns `string`|`[]uint`|`null` the chunk, empty when nothing is available yet or `null` once the stream is closed.
+        static pxs_VarT read(pxs_VarT args);
+
+        // Wait for the process to exit, at most `timeout` milliseconds.
+        // args:
+        //  - self: `Process`
+        //  - timeout: @opt `int` how long to wait. -1 waits forever. Defaults to -1.
+        //
+        // returns `int`|`null` the exit code, or `null` if it is still running.
+        static pxs_VarT wait(pxs_VarT args);
+
+        // Kill the process. Does nothing once it exited.
+        // args:
+        //  - self: `Process`
+        static pxs_VarT kill(pxs_VarT args);
+    };
+
     // Run a shell command via `std::system`
     // Output is sent to terminal directly.
     pxs_VarT system(pxs_VarT args);
 
+    // @except
+    // Start a process without going through a shell. Returns right away.
+    // args:
+    //  - argv: `[]string` the program and its arguments. The program is looked up in `PATH`.
+    //  - opts: @opt `{cwd: string, env: {string: string}, merge_stderr: bool}` the working directory, variables
+    //    added to the current environment and if stderr should go to stdout.
+    //
+    // returns `Process`
+    pxs_VarT spawn(pxs_VarT args);
+
+    // @except
+    // Run many processes at once and collect their output. Processes are waited on by the worker pool,
+    // at most `max_concurrency` of them run at the same time.
+    // args:
+    //  - commands: `[][]string` the argv of every process.
+    //  - opts: @opt the options of `spawn`, plus `max_concurrency: int` (defaults to the number of hardware threads)
+    //    and `timeout: int` in milliseconds per process after which it is killed (defaults to -1, no timeout).
+    //
+    // returns `[]{code: int|null, stdout: string, stderr: string, timed_out: bool}` in the same order. A process that
+    // could not start is an exception instead of failing the whole call.
+    pxs_VarT run_many(pxs_VarT args);
+
+    // @private
+    //
+    // Initialize the `yoyo.shell` module.
     void init(pxs_Module* yoyo);
 }
 
-#endif // YOYO_SHELL
\ No newline at end of file
+#endif // YOYO_SHELL
@@ -0,0 +1,178 @@
+#pragma once
+
+#ifdef YOYO_SHM
+
+#include <pixelscript.h>
+#include <pixelscript_cpp.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace yoyo::shm {
+    // Number types of `Region.get`/`Region.set`, stored in native byte order.
+    enum class ValueType : uint8_t {
+        I8 = 0,
+        U8 = 1,
+        I16 = 2,
+        U16 = 3,
+        I32 = 4,
+        U32 = 5,
+        I64 = 6,
+        U64 = 7,
+        F32 = 8,
+        F64 = 9
+    };
+
+    // @private
+    // A mapped region, unmapped once the last `Region` and view of it are gone.
+    struct Mapping;
+
+    // Returned by `create` and `open`. Every process mapping the same name sees the same bytes, nothing is copied
+    // between them. Offsets are in bytes and must fit in `size`.
+    class Region {
+        // @private
+        std::shared_ptr<Mapping> mapping;
+
+    public:
+        Region(std::shared_ptr<Mapping> mapping);
+
+        // @prop(get)
+        // The name of the region.
+        //
+        // args:
+        //  - self: `Region`
+        //
+        // returns `string`
+        static pxs_VarT get_name(pxs_VarT args);
+
+        // @prop(get)
+        // The size of the region in bytes.
+        //
+        // args:
+        //  - self: `Region`
+        //
+        // returns `int`
+        static pxs_VarT get_size(pxs_VarT args);
+
+        // @except
+        // Read one number.
+        // args:
+        //  - self: `Region`
+        //  - type: `ValueType` the type.
+        //  - offset: `int` where it is.
+        //
+        // returns `int`|`float`
+        static pxs_VarT get(pxs_VarT args);
+
+        // @except
+        // Write one number. Integers wrap like a C cast.
+        // args:
+        //  - self: `Region`
+        //  - type: `ValueType` the type.
+        //  - offset: `int` where it goes.
+        //  - value: `int`|`float` the number.
+        static pxs_VarT set(pxs_VarT args);
+
+        // @except
+        // Copy bytes out of the region.
+        // args:
+        //  - self: `Region`
+        //  - offset: `int` where to start.
+        //  - len: `int` how many bytes.
+        //
+        // returns `[]uint`
+        static pxs_VarT read(pxs_VarT args);
+
+        // @except
+        // Copy bytes into the region.
+        // args:
+        //  - self: `Region`
+        //  - offset: `int` where to start.
+        //  - data: `[]uint`|`string` the bytes.
+        static pxs_VarT write(pxs_VarT args);
+
+        // @except
+        // A `pxs_Buffer` over the region itself, nothing is copied. Other processes can change it while it is read,
+        // use `seq_read` for a consistent copy. Keeps the region mapped while it lives.
+        // args:
+        //  - self: `Region`
+        //  - offset: @opt `int` where to start. Defaults to 0.
+        //  - len: @opt `int` how many bytes. Defaults to the rest of the region.
+        //
+        // returns `[]uint`
+        static pxs_VarT view(pxs_VarT args);
+
+        // @except
+        // Write bytes under the seqlock at `seq_offset`, readers using `seq_read` never see them half written.
+        // Writers wait for each other.
+        // args:
+        //  - self: `Region`
+        //  - seq_offset: `int` the 8 byte aligned sequence counter, shared by every reader and writer of the data.
+        //  - offset: `int` where the data starts.
+        //  - data: `[]uint`|`string` the bytes.
+        static pxs_VarT seq_write(pxs_VarT args);
+
+        // @except
+        // Copy bytes out under the seqlock at `seq_offset`, retrying while a `seq_write` is in progress.
+        // args:
+        //  - self: `Region`
+        //  - seq_offset: `int` the 8 byte aligned sequence counter.
+        //  - offset: `int` where the data starts.
+        //  - len: `int` how many bytes.
+        //
+        // returns `[]uint` a consistent snapshot.
+        static pxs_VarT seq_read(pxs_VarT args);
+
+        // @except
+        // Copy elements out of the region into a new `yoyo.array.Array`, with one copy. Needs `YOYO_ARRAY`.
+        // args:
+        //  - self: `Region`
+        //  - kind: `yoyo.array.Kind` the element type.
+        //  - offset: `int` where the elements start.
+        //  - len: `int` the number of elements.
+        //
+        // returns `Array`
+        static pxs_VarT read_array(pxs_VarT args);
+
+        // @except
+        // Copy the elements of a `yoyo.array.Array` into the region. Needs `YOYO_ARRAY`.
+        // args:
+        //  - self: `Region`
+        //  - offset: `int` where the elements go.
+        //  - array: `Array` the elements.
+        static pxs_VarT write_array(pxs_VarT args);
+    };
+
+    // @except
+    // Create the shared memory region `name`, or open it when it already exists. A new region is zeroed.
+    // args:
+    //  - name: `string` the name, the same in every process.
+    //  - size: `int` the size in bytes.
+    //
+    // returns `Region`
+    pxs_VarT create(pxs_VarT args);
+
+    // @except
+    // Open the existing shared memory region `name`.
+    // args:
+    //  - name: `string` the name.
+    //
+    // returns `Region`
+    pxs_VarT open(pxs_VarT args);
+
+    // Remove the name of a region, mappings stay valid until they are closed. Does nothing on Windows, where a region
+    // goes away with its last mapping.
+    // args:
+    //  - name: `string` the name.
+    //
+    // returns `bool` if it was removed.
+    pxs_VarT unlink(pxs_VarT args);
+
+    // @private
+    //
+    // Initialize the `yoyo.shm` module.
+    void init(pxs_Module* yoyo);
+};
+
+#endif // YOYO_SHM
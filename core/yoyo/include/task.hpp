@@ -0,0 +1,72 @@
+#pragma once
+
+#ifdef YOYO_TASK
+
+#include <pixelscript.h>
+#include <pixelscript_cpp.hpp>
+#include <cstdint>
+#include <memory>
+
+namespace yoyo::task {
+    // @private
+    // Shared state of a `spawn` call.
+    struct TaskState;
+
+    // Returned by `spawn`.
+    class Task {
+        // @private
+        std::shared_ptr<TaskState> state;
+
+    public:
+        Task(std::shared_ptr<TaskState> state);
+
+        // @prop(get)
+        // Has the task finished?
+        //
+        // args:
+        //  - self: `Task`
+        //
+        // returns `bool`
+        static pxs_VarT get_done(pxs_VarT args);
+
+        // Wait for the task to finish, at most `timeout` milliseconds.
+        // args:
+        //  - self: `Task`
+        //  - timeout: @opt `int` how long to wait. -1 waits forever. Defaults to -1.
+        //
+        // returns `bool` if it has finished.
+        static pxs_VarT join(pxs_VarT args);
+
+        // @except
+        // Block until the task finishes.
+        // args:
+        //  - self: `Task`
+        //
+        // returns `any` what the function returned. A copy, the task never shares script objects.
+        static pxs_VarT result(pxs_VarT args);
+    };
+
+    // @except
+    // Call a script function on a worker thread. Every worker has its own runtime state from a `pxs_RuntimePool`,
+    // set up with `yoyo_task_setup` (only `yoyo` by default), so nothing is shared with the caller.
+    // Arguments and the result are copied through `pxs_pack`, only plain data (numbers, strings, bytes, lists, maps) moves.
+    // args:
+    //  - runtime: `int` the runtime to call in, i.e. `pxs.LUA`.
+    //  - module: `string` module of the function (`require`/`import`), JS needs `js_commonjs`. Empty for a global function.
+    //  - fn: `string` the function name.
+    //  - args: @opt `[]any` the arguments.
+    //
+    // returns `Task`
+    pxs_VarT spawn(pxs_VarT args);
+
+    // @private
+    // Set what every worker state is set up with, and how many workers there are. Only used before the first `spawn`.
+    void set_setup(pxs_PoolSetupFn setup, pxs_Opaque opaque, uint32_t workers);
+
+    // @private
+    //
+    // Initialize the `yoyo.task` module.
+    void init(pxs_Module* yoyo);
+};
+
+#endif // YOYO_TASK
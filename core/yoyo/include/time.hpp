@@ -0,0 +1,150 @@
+#pragma once
+
+#ifdef YOYO_TIME
+
+#include <pixelscript.h>
+#include <pixelscript_cpp.hpp>
+#include <cstdint>
+#include <memory>
+
+namespace yoyo::time {
+    // @private
+    // Nanoseconds on the monotonic clock.
+    uint64_t now();
+
+    // Returned by `stopwatch`. Only reads the clock, never allocates while timing.
+    class Stopwatch {
+        // @private
+        // Time of the last `start`.
+        uint64_t started;
+        // @private
+        // Time counted before the last `start`.
+        uint64_t counted = 0;
+        // @private
+        bool running = true;
+
+        // @private
+        uint64_t elapsed() const;
+
+    public:
+        Stopwatch();
+
+        // @prop(get)
+        // Time counted in nanoseconds.
+        //
+        // args:
+        //  - self: `Stopwatch`
+        //
+        // returns `int`
+        static pxs_VarT get_elapsed_ns(pxs_VarT args);
+
+        // @prop(get)
+        // Time counted in seconds.
+        //
+        // args:
+        //  - self: `Stopwatch`
+        //
+        // returns `float`
+        static pxs_VarT get_elapsed(pxs_VarT args);
+
+        // @prop(get)
+        // Is it counting?
+        //
+        // args:
+        //  - self: `Stopwatch`
+        //
+        // returns `bool`
+        static pxs_VarT get_running(pxs_VarT args);
+
+        // Continue counting. Does nothing while running.
+        // args:
+        //  - self: `Stopwatch`
+        static pxs_VarT start(pxs_VarT args);
+
+        // Pause counting. Does nothing while stopped.
+        // args:
+        //  - self: `Stopwatch`
+        static pxs_VarT stop(pxs_VarT args);
+
+        // Start counting again from 0.
+        // args:
+        //  - self: `Stopwatch`
+        //
+        // returns `int` the nanoseconds counted before.
+        static pxs_VarT restart(pxs_VarT args);
+    };
+
+    // @private
+    // A callback waiting in the timer wheel.
+    struct TimerState;
+
+    // Returned by `after` and `every`.
+    class Timer {
+        // @private
+        std::shared_ptr<TimerState> state;
+
+    public:
+        Timer(std::shared_ptr<TimerState> state);
+
+        // @prop(get)
+        // Will it still fire? False once a `after` timer fired or the timer was cancelled.
+        //
+        // args:
+        //  - self: `Timer`
+        //
+        // returns `bool`
+        static pxs_VarT get_active(pxs_VarT args);
+
+        // Stop the timer from firing again.
+        // args:
+        //  - self: `Timer`
+        static pxs_VarT cancel(pxs_VarT args);
+    };
+
+    // Nanoseconds on a monotonic clock, only useful to compare with another call.
+    //
+    // returns `int`
+    pxs_VarT now_ns(pxs_VarT args);
+
+    // Seconds on the highest resolution monotonic clock, only useful to compare with another call.
+    //
+    // returns `float`
+    pxs_VarT perf_counter(pxs_VarT args);
+
+    // Create a running `Stopwatch`.
+    //
+    // returns `Stopwatch`
+    pxs_VarT stopwatch(pxs_VarT args);
+
+    // @except
+    // Call `fn` once, `ms` milliseconds from now. Fired by `yoyo_pump` on this thread, so never earlier but as late
+    // as the next pump.
+    // args:
+    //  - ms: `int` the delay.
+    //  - fn: `function` called without arguments.
+    //
+    // returns `Timer`
+    pxs_VarT after(pxs_VarT args);
+
+    // @except
+    // Call `fn` every `ms` milliseconds until cancelled. Fires at most once per `yoyo_pump`, a late pump does not
+    // catch up with the missed calls.
+    // args:
+    //  - ms: `int` the interval, at least 1.
+    //  - fn: `function` called without arguments.
+    //
+    // returns `Timer`
+    pxs_VarT every(pxs_VarT args);
+
+    // @private
+    // Fire the timers of this thread that are due.
+    // Returns the number of callbacks called.
+    int pump();
+
+    // @private
+    //
+    // Initialize the `yoyo.time` module.
+    void init(pxs_Module* yoyo);
+};
+
+#endif // YOYO_TIME
@@ -36,4 +36,24 @@ namespace yoyo::utils::bytes {
         // }
         return bytes;
     }
-}
\ No newline at end of file
+
+    // View the bytes of a `pxs_String`, `pxs_Buffer` or `pxs_List` of bytes. Strings and buffers are not copied,
+    // lists are copied into `storage`. Returns false when `var` is something else.
+    inline bool view_bytes(pxs_VarT var, const uint8_t*& data, size_t& len, std::vector<uint8_t>& storage) {
+        if (pxs_varis(var, pxs_String) || pxs_varis(var, pxs_Buffer)) {
+            data = reinterpret_cast<const uint8_t*>(pxs_getstrview(var, &len));
+            if (data == nullptr) {
+                len = 0;
+            }
+            return true;
+        }
+        if (pxs_varis(var, pxs_List)) {
+            storage.resize(pxs_varsize(var));
+            pxs_copybytes(var, static_cast<pxs_Opaque>(storage.data()));
+            data = storage.data();
+            len = storage.size();
+            return true;
+        }
+        return false;
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// CPU topology and thread affinity, shared by `yoyo.os` and the worker pools.
+// Only counts the CPUs this process may run on (its affinity mask), not every CPU of the machine.
+namespace yoyo::utils::cpu {
+    // A physical core.
+    struct Core {
+        // The package (socket) it sits in.
+        uint32_t package = 0;
+        // Its logical CPUs (hardware threads), lowest first.
+        std::vector<uint32_t> threads;
+    };
+
+    struct Topology {
+        // Number of logical CPUs.
+        uint32_t logical = 1;
+        // Number of physical cores.
+        uint32_t physical = 1;
+        // Number of packages.
+        uint32_t packages = 1;
+        // Every core, ordered by package then by its first logical CPU.
+        std::vector<Core> cores;
+    };
+
+    // The topology, read once. Falls back to one core per logical CPU when the OS does not say.
+    const Topology& topology();
+
+    // How many workers to run for CPU bound work: a worker per physical core, at most `max` (0 for no limit).
+    uint32_t worker_count(uint32_t max = 0);
+
+    // The logical CPU for worker `index`. The first thread of every core comes first, spread over the packages,
+    // then the sibling threads, so up to `physical` workers never share a core.
+    uint32_t placement(uint32_t index);
+
+    // Limit the calling thread to the logical CPUs `cpus`. Returns false when the OS refuses or does not support it
+    // (macOS).
+    bool set_affinity(const std::vector<uint32_t>& cpus);
+
+    // The logical CPUs the calling thread may run on.
+    std::vector<uint32_t> get_affinity();
+
+    // Pin the calling thread to the CPU of worker `index` (see `placement`).
+    bool pin_worker(uint32_t index);
+};
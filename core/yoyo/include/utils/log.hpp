@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// The buffered sink behind `yoyo.print`, `yoyo.println` and `yoyo.log`.
+// Every thread appends to its own buffer, a background writer drains them all to stdout once a buffer passes
+// the size threshold or the time threshold passed. Output of one thread stays in order, lines of different
+// threads can be reordered within one drain.
+namespace yoyo::utils::log {
+    enum class Level : uint8_t {
+        Debug = 0,
+        Info = 1,
+        Warn = 2,
+        Error = 3,
+        // Drops everything.
+        Off = 4
+    };
+
+    // Set the lowest level written, the buffer size that wakes the writer and how often it drains anyway.
+    // `flush_ms` 0 writes every message right away, without the writer thread.
+    // Defaults to `Level::Info`, 64KB and 50ms.
+    void configure(Level level, size_t flush_bytes, uint32_t flush_ms);
+
+    // Would a message of `level` be written? Check before formatting one.
+    bool enabled(Level level);
+
+    // Queue `text` as is (no newline is added).
+    void write(Level level, std::string_view text);
+
+    // Write everything queued so far, on this thread. Also called at exit.
+    void flush();
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include "utils/cpu.hpp"
+
+// A small worker pool shared by yoyo modules that do background work.
+// Jobs must never touch pixelscript vars, only native data. Results are handed back
+// to the owning thread (i.e. through `yoyo_pump`).
+namespace yoyo::utils::pool {
+    class ThreadPool {
+        std::vector<std::thread> workers;
+        std::deque<std::function<void()>> jobs;
+        std::mutex lock;
+        std::condition_variable cv;
+        bool stopping = false;
+
+        void run() {
+            while (true) {
+                std::function<void()> job;
+                {
+                    std::unique_lock<std::mutex> guard(lock);
+                    cv.wait(guard, [this] { return stopping || !jobs.empty(); });
+                    if (jobs.empty()) {
+                        return;
+                    }
+                    job = std::move(jobs.front());
+                    jobs.pop_front();
+                }
+                job();
+            }
+        }
+
+    public:
+        // `on_start` runs first on every worker with its index, i.e. to pin it with `cpu::pin_worker`.
+        ThreadPool(size_t threads, std::function<void(size_t)> on_start = nullptr) {
+        #ifdef YOYO_NO_THREADS
+            // wasm32 without shared memory, `submit` runs the job right away.
+            (void)threads;
+            (void)on_start;
+            return;
+        #endif
+            threads = std::max<size_t>(1, threads);
+            for (size_t i = 0; i < threads; i++) {
+                workers.emplace_back([this, i, on_start] {
+                    if (on_start) {
+                        on_start(i);
+                    }
+                    run();
+                });
+            }
+        }
+
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                stopping = true;
+            }
+            cv.notify_all();
+            for (auto& w : workers) {
+                w.join();
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // Queue a job.
+        void submit(std::function<void()> job) {
+        #ifdef YOYO_NO_THREADS
+            job();
+            return;
+        #endif
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                jobs.push_back(std::move(job));
+            }
+            cv.notify_one();
+        }
+
+        // Number of worker threads.
+        size_t size() const {
+            return std::max<size_t>(1, workers.size());
+        }
+    };
+
+    // The process wide pool. Created on first use with one worker per logical CPU the process may run on.
+    inline ThreadPool& shared() {
+        static ThreadPool pool(cpu::topology().logical);
+        return pool;
+    }
+};
@@ -32,6 +32,30 @@ namespace yoyo::utils::str {
         return res;
     }
 
+    // Match `text` against a glob `pattern`. Supports `*` and `?`.
+    inline bool glob_match(std::string_view pattern, std::string_view text) {
+        size_t p = 0, t = 0;
+        size_t star = std::string_view::npos, mark = 0;
+        while (t < text.size()) {
+            if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+                p++;
+                t++;
+            } else if (p < pattern.size() && pattern[p] == '*') {
+                star = p++;
+                mark = t;
+            } else if (star != std::string_view::npos) {
+                p = star + 1;
+                t = ++mark;
+            } else {
+                return false;
+            }
+        }
+        while (p < pattern.size() && pattern[p] == '*') {
+            p++;
+        }
+        return p == pattern.size();
+    }
+
     #ifdef _WIN32
     // Convert a std::string into a wide string.
     inline std::wstring to_wstring(std::string_view utf8_str) {
@@ -66,5 +90,43 @@ namespace yoyo::utils::str {
 
         return wide_str;
     }
+
+    // Convert a wide string into a utf8 std::string.
+    inline std::string from_wstring(std::wstring_view wide_str) {
+        if (wide_str.empty()) {
+            return "";
+        }
+
+        int required_bytes = WideCharToMultiByte(
+            CP_UTF8,
+            0,
+            wide_str.data(),
+            static_cast<int>(wide_str.size()),
+            nullptr,
+            0,
+            nullptr,
+            nullptr
+        );
+
+        if (required_bytes <= 0) {
+            return "";
+        }
+
+        std::string utf8_str;
+        utf8_str.resize(required_bytes);
+
+        WideCharToMultiByte(
+            CP_UTF8,
+            0,
+            wide_str.data(),
+            static_cast<int>(wide_str.size()),
+            utf8_str.data(),
+            required_bytes,
+            nullptr,
+            nullptr
+        );
+
+        return utf8_str;
+    }
     #endif // _WIN32
 };
@@ -1,11 +1,28 @@
 #pragma once
 // This is always included.
+#include <pixelscript_cpp.hpp>
 
+// Tags of the yoyo host objects, handed out by the pixelscript type registry so they never collide with the host's.
 namespace yoyo::types {
 // net.hpp
-inline const int NET_HTTP_RESPONSE_TYPE = 0;
-inline const int ZIP_ZIP_FILE_TYPE = 1;
-inline const int FS_FILE_TYPE = 2;
-inline const int NET_ClientResponse = 3;
-inline const int NET_Client = 4;
-};
\ No newline at end of file
+inline const int NET_HTTP_RESPONSE_TYPE = pxs::type::new_type_tag();
+inline const int ZIP_ZIP_FILE_TYPE = pxs::type::new_type_tag();
+inline const int FS_FILE_TYPE = pxs::type::new_type_tag();
+inline const int NET_ClientResponse = pxs::type::new_type_tag();
+inline const int NET_Client = pxs::type::new_type_tag();
+inline const int FS_READ_HANDLE_TYPE = pxs::type::new_type_tag();
+inline const int NET_PendingResponse = pxs::type::new_type_tag();
+inline const int ARRAY_ARRAY_TYPE = pxs::type::new_type_tag();
+inline const int SHELL_PROCESS_TYPE = pxs::type::new_type_tag();
+inline const int PXS_CODE_TYPE = pxs::type::new_type_tag();
+inline const int TASK_TASK_TYPE = pxs::type::new_type_tag();
+inline const int CHANNEL_CHANNEL_TYPE = pxs::type::new_type_tag();
+inline const int TIME_STOPWATCH_TYPE = pxs::type::new_type_tag();
+inline const int TIME_TIMER_TYPE = pxs::type::new_type_tag();
+inline const int SHM_REGION_TYPE = pxs::type::new_type_tag();
+inline const int COMPRESS_COMPRESSOR_TYPE = pxs::type::new_type_tag();
+inline const int COMPRESS_DECOMPRESSOR_TYPE = pxs::type::new_type_tag();
+inline const int HASH_HASHER_TYPE = pxs::type::new_type_tag();
+inline const int NET_SERVER_TYPE = pxs::type::new_type_tag();
+inline const int FS_WATCHER_TYPE = pxs::type::new_type_tag();
+};
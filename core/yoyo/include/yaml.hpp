@@ -0,0 +1,49 @@
+#pragma once
+#ifdef YOYO_YAML
+
+#include <pixelscript.h>
+#include <cstddef>
+
+namespace yoyo::yaml {
+    // @private
+    // Parse every document of `len` bytes of YAML into a `[]any`, building the vars straight from the fkYAML nodes.
+    // Throws a `std::exception` when the YAML is invalid.
+    pxs_VarT load_docs(const char* data, size_t len);
+
+    // @except
+    // Parse YAML into maps, lists and scalars. Only the first document of a multi document stream is returned.
+    // args:
+    //  - text: `string`|`[]uint` the YAML.
+    //
+    // returns `any` the document, `null` when there is none.
+    pxs_VarT load(pxs_VarT args);
+
+    // @except
+    // Parse every document of a YAML stream (separated by `---`).
+    // args:
+    //  - text: `string`|`[]uint` the YAML.
+    //
+    // returns `[]any` the documents.
+    pxs_VarT load_all(pxs_VarT args);
+
+    // @except
+    // Read every document of a YAML file at once. Use `ZipFile.read_yaml` for files in a archive.
+    // args:
+    //  - path: `string` path to the file.
+    //
+    // returns `[]any` the documents.
+    pxs_VarT read_all(pxs_VarT args);
+
+    // @except
+    // Write a value as YAML. Maps and script objects keep the order they iterate in.
+    // Throws on values YAML has no form for, i.e. functions or bytes.
+    // args:
+    //  - value: `any` the value.
+    //
+    // returns `string` the YAML.
+    pxs_VarT dump(pxs_VarT args);
+
+    void init(pxs_Module* yoyo);
+};
+
+#endif // YOYO_YAML
@@ -1,7 +1,70 @@
 #pragma once
 
+#include <cstdint>
+#include <cstddef>
+
 extern "C" {
     // Initialize the yoyo module.
-    // Pass in the argv from the cmdline if avail.
+    // Call `yoyo_os_setargs` first to give `yoyo.os.argv` other args than the ones of the process.
     void yoyo_init();
+
+    // Hand finished background work (i.e. `yoyo.fs.read_async`, `Client.request_async`) back to the scripts and run their callbacks,
+    // and fire the due `yoyo.time` timers.
+    // Call this once per frame from the thread that started the work.
+    // Returns the number of completions handled.
+    int yoyo_pump();
+
+    // Use `yoyo.fs`'s caching disk reader as the pixelscript file reader (`pxs_set_filereader`).
+    // `budget` is the max number of bytes kept in memory. Does nothing without `YOYO_FS`.
+    void yoyo_fs_usecache(uint64_t budget);
+
+    // Start or stop recording per domain latency histograms of `yoyo.net` requests. Off by default.
+    // Does nothing without `YOYO_NET`.
+    void yoyo_net_trackstats(bool enabled);
+
+    // Write the recorded `yoyo.net` stats as nul terminated JSON into `out` (see `yoyo::net::write_stats`).
+    // With `reset` the stats are cleared once they fit into `out`.
+    // Returns the length needed without the nul, 0 without `YOYO_NET`.
+    size_t yoyo_net_stats(char* out, size_t len, bool reset);
+
+    // Open the zip archive at `path` and serve pixelscript imports from it (see `yoyo.zip.mount`).
+    // Returns false when it can not be opened or without `YOYO_ZIP`.
+    bool yoyo_zip_mount(const char* path);
+
+    // Set what the worker states of `yoyo.task` are set up with (`pxs_PoolSetupFn`, add the host modules there) and
+    // how many workers there are, 0 for the default. Null `setup` runs `yoyo_init`. Only used before the first
+    // `yoyo.task.spawn`. Does nothing without `YOYO_TASK`.
+    void yoyo_task_setup(void (*setup)(void*), void* opaque, uint32_t workers);
+
+    // Set up the buffered sink of `yoyo.print`, `yoyo.println` and `yoyo.log`: the lowest level written (0 debug,
+    // 1 info, 2 warn, 3 error, 4 off), the buffer size that wakes the writer thread and how often it drains anyway.
+    // `flush_ms` 0 writes every message right away. Defaults to info, 64KB and 50ms. Does nothing without `YOYO_CORE`.
+    void yoyo_log_setup(int level, size_t flush_bytes, uint32_t flush_ms);
+
+    // Write everything printed so far, i.e. before the host writes to stdout itself.
+    void yoyo_log_flush();
+
+    // Get the `yoyo.channel` named `name`, made with `capacity` (rounded up to a power of two, 0 for the default)
+    // if it does not exist yet. Named channels live as long as the process. Returns null without `YOYO_CHANNEL`.
+    void* yoyo_channel_open(const char* name, uint32_t capacity);
+
+    // Push `len` bytes to `channel` without blocking or locking. With `packed` they are `pxs_pack` output and scripts
+    // receive the value, otherwise scripts get the bytes. Returns false when the channel is full.
+    bool yoyo_channel_push(void* channel, const void* data, size_t len, bool packed);
+
+    // Pop the oldest message of `channel` without blocking or locking, and pass it to `sink` before returning.
+    // `packed` is true for values sent by scripts (`pxs_unpack` them). Returns false when the channel is empty.
+    bool yoyo_channel_pop(void* channel, void (*sink)(void* opaque, const void* data, size_t len, bool packed), void* opaque);
+
+    // Use `argv` as `yoyo.os.argv` instead of the command line of the process. Only seen by later `yoyo_init` calls.
+    // Does nothing without `YOYO_OS`.
+    void yoyo_os_setargs(int argc, const char* const* argv);
+
+    // The logical CPUs, or with `physical` the physical cores, this process may run on.
+    uint32_t yoyo_cpu_count(bool physical);
+
+    // Pin the calling thread to the CPU of worker `index`: one worker per physical core, spread over the packages,
+    // before any shares a core. Lets host worker pools line up with `yoyo.task`. Returns false when the OS refused,
+    // always on macOS.
+    bool yoyo_pin_worker(uint32_t index);
 }
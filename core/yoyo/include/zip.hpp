@@ -7,16 +7,29 @@
 #include <string>
 #include <vector>
 #include <cstdint>
-
-namespace miniz_cpp {
-    class zip_file;
-}
+#include <memory>
 
 namespace yoyo::zip {
+    // Pass this as the final argument in `ZipFile.write` to pick how the entry is compressed.
+    // Defaults to the archive's `compression`, which defaults to Default.
+    //
+    // Everything except `Store` samples the data first and stores it when deflate would barely help
+    // (i.e. PNG, OGG or nested zips).
+    enum class Compression : uint8_t {
+        Store = 0,
+        Fast = 1,
+        Default = 2,
+        Best = 3
+    };
+
+    // @private
+    // The miniz archive plus a path index of its central directory.
+    struct Archive;
+
     struct ZipFile {
         // @private
-        // Internal zip file.
-        miniz_cpp::zip_file* zf;
+        // Internal archive. Shared with `mount`.
+        std::shared_ptr<Archive> archive;
 
         ~ZipFile();
 
@@ -34,35 +47,71 @@ namespace yoyo::zip {
 
         // @except
         // @self
-        // Read a file in the archive.
+        // Read a file in the archive. Text reads of files with nul bytes throw, read them as bytes.
+        // Like `extract`, it throws when the entry does not match its CRC-32.
         // args:
         //  - path: `string` the path to read in the archive.
         //  - rt: @opt `FileReadType` how to read and return the results (default is Text).
         //
-        // returns `string`|`[]uint` either file contents as a string or list of bytes.
+        // returns `string`|`buffer` either file contents as a string or a buffer owning the inflated bytes.
         static pxs_VarT read(pxs_VarT args);
 
+    #ifdef PXS_JSON
+        // @except
+        // @self
+        // Decode a JSON file in the archive, inflated in chunks straight into the decoder. Throws like `read`.
+        // args:
+        //  - path: `string` the path to read in the archive.
+        //  - pointer: @opt `string` JSON pointer (i.e. `/mods/0`) of the only value to build. Defaults to the whole document.
+        //
+        // returns `any` the decoded value.
+        static pxs_VarT read_json(pxs_VarT args);
+    #endif
+
+    #ifdef YOYO_YAML
+        // @except
+        // @self
+        // Parse every document of a YAML file in the archive at once. Throws like `read`.
+        // args:
+        //  - path: `string` the path to read in the archive.
+        //
+        // returns `[]any` the documents.
+        static pxs_VarT read_yaml(pxs_VarT args);
+    #endif
+
         // @except
         // @self
-        // Write into a archive.
+        // Write into a archive. Archives opened from a path get the entry appended in place, the archive
+        // itself is not rewritten.
         // args:
         //  - path: `string` the path to write to.
         //  - data: `string`|`[]uint` the data to write, either a string or bytes.
+        //  - compression: @opt `Compression` how to compress it. Defaults to the archive's `compression`.
         //
         static pxs_VarT write(pxs_VarT args);
 
+        // @self
+        // @prop(get,set)
+        // The default `Compression` of writes.
+        // args:
+        //  - compression: @set `Compression` the new default.
+        //
+        // returns `Compression`|`null`
+        static pxs_VarT prop_compression(pxs_VarT args);
+
         // @except
         // @self
-        // List contents of a directory in the archive.
+        // List contents of a directory in the archive. Directories end with `/`.
         // args:
-        //  - path: `string` the path to the directory.
+        //  - path: `string` the path to the directory. `""` or `"/"` is the root.
+        //  - recursive: @opt `bool` list everything under it instead of the direct children. Defaults to false.
         //
-        // returns `[]string` return a list of items.
+        // returns `[]string` the full archive paths of the items.
         static pxs_VarT listdir(pxs_VarT args);
 
         // @except
         // @self
-        // Remove a directory.
+        // Remove a directory and everything in it.
         // args:
         //  - path: `string` path to directory.
         //
@@ -82,8 +131,33 @@ namespace yoyo::zip {
         // args:
         //  - src_path: `string` path to files. Can be '/'
         //  - dest_path: `string` path to destination.
+        //  - threads: @opt `int` extract a directory on this many worker threads, 0 for one per core. Defaults to 1.
         //
         static pxs_VarT extract(pxs_VarT args);
+
+        // @except
+        // @self
+        // Save the archive. Without a path, an archive opened from a path gets its new central directory,
+        // removed entries keep their data until `compact`.
+        // args:
+        //  - path: @opt `string` write a copy without removed entries here instead.
+        //
+        static pxs_VarT save(pxs_VarT args);
+
+        // @except
+        // @self
+        // Rewrite the archive without the data of removed and replaced entries.
+        //
+        static pxs_VarT compact(pxs_VarT args);
+
+        // @except
+        // @self
+        // Inflate every entry on the worker pool and check it against its CRC-32.
+        // args:
+        //  - threads: @opt `int` number of workers. Defaults to one per core.
+        //
+        // returns `[]string` paths of the corrupt entries, empty when the archive is intact.
+        static pxs_VarT verify(pxs_VarT args);
     };
 
     // Open a new zip file.
@@ -93,6 +167,18 @@ namespace yoyo::zip {
     // returns `ZipFile` a new instance.
     pxs_VarT open(pxs_VarT args);
 
+    // @except
+    // Serve script imports from a archive instead of the disk (`pxs_set_filereader` and `pxs_set_dirreader`).
+    // Sources are inflated once and cached by path until the archive changes. Replaces any mounted archive.
+    // args:
+    //  - zip: `ZipFile` the archive to import from.
+    //
+    pxs_VarT mount(pxs_VarT args);
+
+    // @private
+    // Open the archive at `path` and mount it. Returns false when it can not be opened.
+    bool mount_path(const std::string& path);
+
     void init(pxs_Module* yoyo);
 };
 
@@ -1032,14 +1032,52 @@ mz_ulong mz_adler32(mz_ulong adler, const unsigned char *ptr, size_t buf_len)
   return (s2 << 16) + s1;
 }
 
-// Karl Malbrain's compact CRC-32. See "A compact CCITT crc16 and crc32 C implementation that balances processor cache usage against speed": http://www.geocities.com/malbrain/
+// CRC-32 used to be Karl Malbrain's compact 4 bit table version. Entries are checked against it on every read
+// so it is slice-by-8 now (8 bytes per step, 8KB of tables), or the ARMv8 CRC32 instructions when available.
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+#include <string.h>
+
+struct mz_crc32_tables
+{
+  mz_uint32 t[8][256];
+  mz_crc32_tables()
+  {
+    for (mz_uint32 i = 0; i < 256; i++)
+    {
+      mz_uint32 c = i;
+      for (int k = 0; k < 8; k++) c = (c >> 1) ^ (0xEDB88320U & (0U - (c & 1)));
+      t[0][i] = c;
+    }
+    for (mz_uint32 i = 0; i < 256; i++)
+      for (int s = 1; s < 8; s++) t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xFF];
+  }
+};
+
 mz_ulong mz_crc32(mz_ulong crc, const mz_uint8 *ptr, size_t buf_len)
 {
-  static const mz_uint32 s_crc32[16] = { 0, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
-    0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c };
   mz_uint32 crcu32 = (mz_uint32)crc;
   if (!ptr) return MZ_CRC32_INIT;
-  crcu32 = ~crcu32; while (buf_len--) { mz_uint8 b = *ptr++; crcu32 = (crcu32 >> 4) ^ s_crc32[(crcu32 & 0xF) ^ (b & 0xF)]; crcu32 = (crcu32 >> 4) ^ s_crc32[(crcu32 & 0xF) ^ (b >> 4)]; }
+  crcu32 = ~crcu32;
+#if defined(__ARM_FEATURE_CRC32)
+  while (buf_len >= 8) { mz_uint64 v; memcpy(&v, ptr, 8); crcu32 = __crc32d(crcu32, v); ptr += 8; buf_len -= 8; }
+  while (buf_len--) crcu32 = __crc32b(crcu32, *ptr++);
+#else
+  static const mz_crc32_tables s_tables;
+  const mz_uint32 (*t)[256] = s_tables.t;
+#if MINIZ_LITTLE_ENDIAN
+  while (buf_len >= 8)
+  {
+    mz_uint32 one, two; memcpy(&one, ptr, 4); memcpy(&two, ptr + 4, 4);
+    one ^= crcu32;
+    crcu32 = t[7][one & 0xFF] ^ t[6][(one >> 8) & 0xFF] ^ t[5][(one >> 16) & 0xFF] ^ t[4][one >> 24] ^
+             t[3][two & 0xFF] ^ t[2][(two >> 8) & 0xFF] ^ t[1][(two >> 16) & 0xFF] ^ t[0][two >> 24];
+    ptr += 8; buf_len -= 8;
+  }
+#endif
+  while (buf_len--) crcu32 = (crcu32 >> 8) ^ t[0][(crcu32 ^ *ptr++) & 0xFF];
+#endif
   return ~crcu32;
 }
 
@@ -4940,6 +4978,12 @@ void *mz_zip_extract_archive_file_to_heap(const char *pZip_filename, const char
 
 #endif // MINIZ_HEADER_FILE_ONLY
 
+// yoyo: define MINIZ_NO_CPP_WRAPPER to only get the C API (see core/yoyo/src/utils/miniz.cpp).
+#ifndef MINIZ_NO_CPP_WRAPPER
+
+#include <cassert>
+#include <cstring>
+
 /*
   This is free and unencumbered software released into the public domain.
 
@@ -5707,3 +5751,5 @@ private:
 };
 
 } // namespace miniz_cpp
+
+#endif // MINIZ_NO_CPP_WRAPPER
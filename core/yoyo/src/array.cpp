@@ -0,0 +1,647 @@
+#ifdef YOYO_ARRAY
+
+#include "array.hpp"
+#include <pixelscript.h>
+#include <pixelscript_cpp.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include "utils/exceptions.hpp"
+#include "utils/pxs.hpp"
+#include "utils/types.hpp"
+
+// The kernels are plain loops over `__restrict` pointers, reductions keep independent lanes. That is the form
+// GCC, Clang and MSVC vectorize for every target yoyo builds for, without per platform intrinsics.
+namespace yoyo::array {
+    // Floats compute in their own type, integers in double so nothing overflows before `narrow`.
+    template<typename T>
+    using Wide = std::conditional_t<std::is_floating_point_v<T>, T, double>;
+
+    // Convert into the element type. Integers are rounded and saturated, NaN becomes 0.
+    template<typename T>
+    T narrow(double value) {
+        if constexpr (std::is_floating_point_v<T>) {
+            return static_cast<T>(value);
+        } else {
+            constexpr double low = static_cast<double>(std::numeric_limits<T>::min());
+            constexpr double high = static_cast<double>(std::numeric_limits<T>::max());
+            if (!(value == value)) {
+                return 0;
+            }
+            value = std::round(value);
+            return value <= low ? std::numeric_limits<T>::min()
+                : value >= high ? std::numeric_limits<T>::max()
+                : static_cast<T>(value);
+        }
+    }
+
+    // `out[i] = op(out[i])`
+    template<typename T, typename Op>
+    void map1(T* __restrict out, size_t n, Op op) {
+        for (size_t i = 0; i < n; i++) {
+            out[i] = narrow<T>(op(static_cast<Wide<T>>(out[i])));
+        }
+    }
+
+    // `out[i] = op(out[i], in[i])`, `in` may be `out`.
+    template<typename T, typename Op>
+    void map2(T* out, const T* in, size_t n, Op op) {
+        if (in == out) {
+            map1(out, n, [&](Wide<T> x) { return op(x, x); });
+            return;
+        }
+        T* __restrict dst = out;
+        const T* __restrict src = in;
+        for (size_t i = 0; i < n; i++) {
+            dst[i] = narrow<T>(op(static_cast<Wide<T>>(dst[i]), static_cast<Wide<T>>(src[i])));
+        }
+    }
+
+    // Eight lanes so the loop vectorizes without reordering a single float accumulator.
+    template<typename Acc, typename T, typename Op>
+    Acc reduce(const T* __restrict data, size_t n, Acc init, Op op) {
+        constexpr size_t LANES = 8;
+        Acc lanes[LANES];
+        std::fill(lanes, lanes + LANES, init);
+        size_t i = 0;
+        for (; i + LANES <= n; i += LANES) {
+            for (size_t j = 0; j < LANES; j++) {
+                lanes[j] = op(lanes[j], static_cast<Acc>(data[i + j]));
+            }
+        }
+        for (; i < n; i++) {
+            lanes[0] = op(lanes[0], static_cast<Acc>(data[i]));
+        }
+        Acc result = lanes[0];
+        for (size_t j = 1; j < LANES; j++) {
+            result = op(result, lanes[j]);
+        }
+        return result;
+    }
+
+    template<typename T>
+    pxs_VarT new_number(T value) {
+        if constexpr (std::is_floating_point_v<T>) {
+            return pxs_newfloat(static_cast<double>(value));
+        } else {
+            return pxs_newint(static_cast<int64_t>(value));
+        }
+    }
+
+    const char* kind_name(Kind kind) {
+        switch (kind) {
+            case Kind::F32: return "F32";
+            case Kind::F64: return "F64";
+            case Kind::I32: return "I32";
+            default: return "U8";
+        }
+    }
+
+    Kind Array::kind() const {
+        return static_cast<Kind>(data.index());
+    }
+
+    size_t Array::size() const {
+        return std::visit([](const auto& items) { return items.size(); }, data);
+    }
+
+    void free_array(pxs_Opaque obj) {
+        if (obj) {
+            delete static_cast<Array*>(obj);
+        }
+    }
+
+    // Class of `Array`. Created in `init` since the function lookup is reset with pixelscript.
+    std::optional<pxs::Class<Array>> array_class;
+
+    pxs_VarT Array::topxs() {
+        return array_class->make(this, free_array).raw();
+    }
+
+    // A new array of `len` zeros.
+    Array* make_array(Kind kind, size_t len) {
+        auto array = new Array();
+        switch (kind) {
+            case Kind::F32: array->data.emplace<std::vector<float>>(len); break;
+            case Kind::F64: array->data.emplace<std::vector<double>>(len); break;
+            case Kind::I32: array->data.emplace<std::vector<int32_t>>(len); break;
+            case Kind::U8: array->data.emplace<std::vector<uint8_t>>(len); break;
+        }
+        return array;
+    }
+
+    Array* get_self(pxs_VarT args) {
+        return utils::pxs::get_type<Array>(args, 0, yoyo::types::ARRAY_ARRAY_TYPE);
+    }
+
+    // The `Array` arg at `idx`, null when it is something else.
+    Array* get_array_arg(pxs_VarT args, int idx) {
+        return utils::pxs::get_type<Array>(args, idx, yoyo::types::ARRAY_ARRAY_TYPE);
+    }
+
+    // Get the number arg at `idx`. Returns false when it is not a int or float.
+    bool get_number_arg(pxs_VarT args, int idx, double& out) {
+        auto arg = pxs_arg(args, idx);
+        if (!pxs_varis(arg, pxs_Int64) && !pxs_varis(arg, pxs_UInt64) && !pxs_varis(arg, pxs_Float64)) {
+            return false;
+        }
+        out = pxs_getfloat(arg);
+        return true;
+    }
+
+    pxs_VarT expected_number(pxs_VarT args, int idx) {
+        return utils::exceptions::expected_types(pxs_vartype(pxs_arg(args, idx)), {pxs_Int64, pxs_Float64});
+    }
+
+    // A `Array` arg of the same kind and length as `self`, null when it is not.
+    Array* get_twin_arg(pxs_VarT args, int idx, const Array* self) {
+        auto other = get_array_arg(args, idx);
+        if (!other || other->kind() != self->kind() || other->size() != self->size()) {
+            return nullptr;
+        }
+        return other;
+    }
+
+    pxs_VarT expected_twin(const Array* self) {
+        auto msg = std::string("Expected a ") + kind_name(self->kind()) + " Array of length " + std::to_string(self->size());
+        return pxs_newexception(msg.c_str());
+    }
+
+    // Resolve a (negative) index into `size`. Returns false when it is out of range.
+    bool resolve_index(int64_t index, size_t size, size_t& out) {
+        if (index < 0) {
+            index += static_cast<int64_t>(size);
+        }
+        if (index < 0 || static_cast<uint64_t>(index) >= size) {
+            return false;
+        }
+        out = static_cast<size_t>(index);
+        return true;
+    }
+
+    pxs_VarT out_of_range(int64_t index, size_t size) {
+        auto msg = "Index " + std::to_string(index) + " is out of range for a Array of length " + std::to_string(size);
+        return pxs_newexception(msg.c_str());
+    }
+
+    // Resolve the indices arg at `idx`, a list of ints or a integer `Array`. Returns a exception var on failure.
+    pxs_VarT get_indices_arg(pxs_VarT args, int idx, size_t size, std::vector<size_t>& out) {
+        auto arg = pxs_arg(args, idx);
+        std::vector<int64_t> indices;
+        if (auto array = get_array_arg(args, idx)) {
+            if (array->kind() == Kind::F32 || array->kind() == Kind::F64) {
+                return pxs_newexception("Indices must be a I32 or U8 Array");
+            }
+            std::visit([&](const auto& items) { indices.assign(items.begin(), items.end()); }, array->data);
+        } else if (pxs_varis(arg, pxs_List)) {
+            indices.resize(static_cast<size_t>(pxs_listlen(arg)));
+            if (pxs_list_copy_i64(arg, indices.data(), indices.size()) != static_cast<int32_t>(indices.size())) {
+                return pxs_newexception("Indices must all be ints");
+            }
+        } else {
+            return utils::exceptions::expected_types(pxs_vartype(arg), {pxs_List, pxs_HostObject});
+        }
+
+        out.resize(indices.size());
+        for (size_t i = 0; i < indices.size(); i++) {
+            if (!resolve_index(indices[i], size, out[i])) {
+                return out_of_range(indices[i], size);
+            }
+        }
+        return nullptr;
+    }
+
+    pxs_VarT Array::len(pxs_VarT args) {
+        auto self = get_self(args);
+        if (!self) {
+            return utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        return pxs_newint(static_cast<int64_t>(self->size()));
+    }
+
+    pxs_VarT Array::get_kind(pxs_VarT args) {
+        auto self = get_self(args);
+        if (!self) {
+            return utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        return pxs_newint(static_cast<int>(self->kind()));
+    }
+
+    pxs_VarT Array::get(pxs_VarT args) {
+        auto self = get_self(args);
+        if (!self) {
+            return utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        auto index = pxs_arg(args, 1);
+        if (!pxs_varis(index, pxs_Int64)) {
+            return utils::exceptions::expected_type(pxs_vartype(index), pxs_Int64);
+        }
+        size_t at;
+        if (!resolve_index(pxs_getint(index), self->size(), at)) {
+            return out_of_range(pxs_getint(index), self->size());
+        }
+        return std::visit([&](const auto& items) { return new_number(items[at]); }, self->data);
+    }
+
+    pxs_VarT Array::set(pxs_VarT args) {
+        auto self = get_self(args);
+        if (!self) {
+            return utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        auto index = pxs_arg(args, 1);
+        if (!pxs_varis(index, pxs_Int64)) {
+            return utils::exceptions::expected_type(pxs_vartype(index), pxs_Int64);
+        }
+        double value;
+        if (!get_number_arg(args, 2, value)) {
+            return expected_number(args, 2);
+        }
+        size_t at;
+        if (!resolve_index(pxs_getint(index), self->size(), at)) {
+            return out_of_range(pxs_getint(index), self->size());
+        }
+        std::visit([&](auto& items) {
+            using T = typename std::decay_t<decltype(items)>::value_type;
+            items[at] = narrow<T>(value);
+        }, self->data);
+        return pxs_newnull();
+    }
+
+    pxs_VarT Array::fill(pxs_VarT args) {
+        auto self = get_self(args);
+        if (!self) {
+            return utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        double value;
+        if (!get_number_arg(args, 1, value)) {
+            return expected_number(args, 1);
+        }
+        std::visit([&](auto& items) {
+            using T = typename std::decay_t<decltype(items)>::value_type;
+            std::fill(items.begin(), items.end(), narrow<T>(value));
+        }, self->data);
+        return pxs_newnull();
+    }
+
+    // `self[i] = op(self[i], other)` for a number or a array of the same kind and length at arg 1.
+    template<typename Op>
+    pxs_VarT binary(pxs_VarT args, Op op) {
+        auto self = get_self(args);
+        if (!self) {
+            return utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        double number;
+        if (get_number_arg(args, 1, number)) {
+            std::visit([&](auto& items) {
+                using T = typename std::decay_t<decltype(items)>::value_type;
+                auto value = static_cast<Wide<T>>(number);
+                map1(items.data(), items.size(), [&](Wide<T> x) { return op(x, value); });
+            }, self->data);
+            return pxs_newnull();
+        }
+        auto other = get_twin_arg(args, 1, self);
+        if (!other) {
+            return expected_twin(self);
+        }
+        std::visit([&](auto& items) {
+            using V = std::decay_t<decltype(items)>;
+            map2(items.data(), std::get<V>(other->data).data(), items.size(), op);
+        }, self->data);
+        return pxs_newnull();
+    }
+
+    pxs_VarT Array::add(pxs_VarT args) {
+        return binary(args, [](auto x, auto y) { return x + y; });
+    }
+
+    pxs_VarT Array::mul(pxs_VarT args) {
+        return binary(args, [](auto x, auto y) { return x * y; });
+    }
+
+    pxs_VarT Array::axpy(pxs_VarT args) {
+        auto self = get_self(args);
+        if (!self) {
+            return utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        double a;
+        if (!get_number_arg(args, 1, a)) {
+            return expected_number(args, 1);
+        }
+        auto x = get_twin_arg(args, 2, self);
+        if (!x) {
+            return expected_twin(self);
+        }
+        std::visit([&](auto& items) {
+            using V = std::decay_t<decltype(items)>;
+            using W = Wide<typename V::value_type>;
+            auto scale = static_cast<W>(a);
+            map2(items.data(), std::get<V>(x->data).data(), items.size(), [&](W y, W xi) { return y + scale * xi; });
+        }, self->data);
+        return pxs_newnull();
+    }
+
+    pxs_VarT Array::min(pxs_VarT args) {
+        auto self = get_self(args);
+        if (!self) {
+            return utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        if (self->size() == 0) {
+            return pxs_newnull();
+        }
+        return std::visit([](const auto& items) {
+            using T = typename std::decay_t<decltype(items)>::value_type;
+            return new_number(reduce<T>(items.data(), items.size(), items[0], [](T x, T y) { return y < x ? y : x; }));
+        }, self->data);
+    }
+
+    pxs_VarT Array::max(pxs_VarT args) {
+        auto self = get_self(args);
+        if (!self) {
+            return utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        if (self->size() == 0) {
+            return pxs_newnull();
+        }
+        return std::visit([](const auto& items) {
+            using T = typename std::decay_t<decltype(items)>::value_type;
+            return new_number(reduce<T>(items.data(), items.size(), items[0], [](T x, T y) { return y > x ? y : x; }));
+        }, self->data);
+    }
+
+    pxs_VarT Array::sum(pxs_VarT args) {
+        auto self = get_self(args);
+        if (!self) {
+            return utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        return std::visit([](const auto& items) {
+            using T = typename std::decay_t<decltype(items)>::value_type;
+            // f32 sums in double, integers exactly.
+            using Acc = std::conditional_t<std::is_floating_point_v<T>, double, int64_t>;
+            return new_number(reduce<Acc>(items.data(), items.size(), Acc(0), [](Acc x, Acc y) { return x + y; }));
+        }, self->data);
+    }
+
+    pxs_VarT Array::clamp(pxs_VarT args) {
+        auto self = get_self(args);
+        if (!self) {
+            return utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        double low, high;
+        if (!get_number_arg(args, 1, low)) {
+            return expected_number(args, 1);
+        }
+        if (!get_number_arg(args, 2, high)) {
+            return expected_number(args, 2);
+        }
+        if (low > high) {
+            return pxs_newexception("clamp low is bigger than high");
+        }
+        std::visit([&](auto& items) {
+            using T = typename std::decay_t<decltype(items)>::value_type;
+            // Narrowed first, so the loop compares in the element type.
+            auto lo = narrow<T>(low);
+            auto hi = narrow<T>(high);
+            T* __restrict data = items.data();
+            for (size_t i = 0; i < items.size(); i++) {
+                data[i] = data[i] < lo ? lo : data[i] > hi ? hi : data[i];
+            }
+        }, self->data);
+        return pxs_newnull();
+    }
+
+    pxs_VarT Array::lerp(pxs_VarT args) {
+        auto self = get_self(args);
+        if (!self) {
+            return utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        auto other = get_twin_arg(args, 1, self);
+        if (!other) {
+            return expected_twin(self);
+        }
+        double t;
+        if (!get_number_arg(args, 2, t)) {
+            return expected_number(args, 2);
+        }
+        std::visit([&](auto& items) {
+            using V = std::decay_t<decltype(items)>;
+            using W = Wide<typename V::value_type>;
+            auto amount = static_cast<W>(t);
+            map2(items.data(), std::get<V>(other->data).data(), items.size(), [&](W x, W y) { return x + (y - x) * amount; });
+        }, self->data);
+        return pxs_newnull();
+    }
+
+    pxs_VarT Array::gather(pxs_VarT args) {
+        auto self = get_self(args);
+        if (!self) {
+            return utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        std::vector<size_t> indices;
+        if (auto error = get_indices_arg(args, 1, self->size(), indices)) {
+            return error;
+        }
+        auto result = make_array(self->kind(), indices.size());
+        std::visit([&](const auto& items) {
+            using V = std::decay_t<decltype(items)>;
+            auto out = std::get<V>(result->data).data();
+            for (size_t i = 0; i < indices.size(); i++) {
+                out[i] = items[indices[i]];
+            }
+        }, self->data);
+        return result->topxs();
+    }
+
+    pxs_VarT Array::scatter(pxs_VarT args) {
+        auto self = get_self(args);
+        if (!self) {
+            return utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        std::vector<size_t> indices;
+        if (auto error = get_indices_arg(args, 1, self->size(), indices)) {
+            return error;
+        }
+
+        double number;
+        if (get_number_arg(args, 2, number)) {
+            std::visit([&](auto& items) {
+                using T = typename std::decay_t<decltype(items)>::value_type;
+                auto value = narrow<T>(number);
+                for (auto at : indices) {
+                    items[at] = value;
+                }
+            }, self->data);
+            return pxs_newnull();
+        }
+
+        auto values = get_array_arg(args, 2);
+        if (!values || values->kind() != self->kind() || values->size() != indices.size()) {
+            auto msg = std::string("Expected a number or a ") + kind_name(self->kind()) + " Array of length "
+                + std::to_string(indices.size());
+            return pxs_newexception(msg.c_str());
+        }
+        // A copy when scattering a array into itself, so every value is read before it is written.
+        auto source = values == self ? Array(*values) : Array();
+        const Array& from = values == self ? source : *values;
+        std::visit([&](auto& items) {
+            using V = std::decay_t<decltype(items)>;
+            const auto& in = std::get<V>(from.data);
+            for (size_t i = 0; i < indices.size(); i++) {
+                items[indices[i]] = in[i];
+            }
+        }, self->data);
+        return pxs_newnull();
+    }
+
+    pxs_VarT Array::to_list(pxs_VarT args) {
+        auto self = get_self(args);
+        if (!self) {
+            return utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        return std::visit([](const auto& items) {
+            using T = typename std::decay_t<decltype(items)>::value_type;
+            if constexpr (std::is_floating_point_v<T>) {
+                std::vector<double> values(items.begin(), items.end());
+                return pxs_newlist_f64(values.data(), values.size());
+            } else {
+                std::vector<int64_t> values(items.begin(), items.end());
+                return pxs_newlist_i64(values.data(), values.size());
+            }
+        }, self->data);
+    }
+
+    void free_bytes(void* data) {
+        delete[] static_cast<uint8_t*>(data);
+    }
+
+    pxs_VarT Array::to_bytes(pxs_VarT args) {
+        auto self = get_self(args);
+        if (!self) {
+            return utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        return std::visit([](const auto& items) {
+            using T = typename std::decay_t<decltype(items)>::value_type;
+            auto len = items.size() * sizeof(T);
+            auto bytes = new uint8_t[len];
+            if (len > 0) {
+                std::memcpy(bytes, items.data(), len);
+            }
+            return pxs_newbytes_borrowed(bytes, len, free_bytes);
+        }, self->data);
+    }
+
+    // Get the `Kind` arg at `idx`. Returns false when it is not one.
+    bool get_kind_arg(pxs_VarT args, int idx, Kind& out) {
+        auto arg = pxs_arg(args, idx);
+        if (!pxs_varis(arg, pxs_Int64)) {
+            return false;
+        }
+        auto value = pxs_getint(arg);
+        if (value < static_cast<int>(Kind::F32) || value > static_cast<int>(Kind::U8)) {
+            return false;
+        }
+        out = static_cast<Kind>(value);
+        return true;
+    }
+
+    pxs_VarT zeros(pxs_VarT args) {
+        PXS_ARGC_GT(2); // kind, len
+        Kind kind;
+        if (!get_kind_arg(args, 0, kind)) {
+            return utils::exceptions::invalid_enum();
+        }
+        auto len = pxs_arg(args, 1);
+        if (!pxs_varis(len, pxs_Int64)) {
+            return utils::exceptions::expected_type(pxs_vartype(len), pxs_Int64);
+        }
+        if (pxs_getint(len) < 0) {
+            return pxs_newexception("Array length can not be negative");
+        }
+        return make_array(kind, static_cast<size_t>(pxs_getint(len)))->topxs();
+    }
+
+    pxs_VarT of(pxs_VarT args) {
+        PXS_ARGC_GT(2); // kind, values
+        Kind kind;
+        if (!get_kind_arg(args, 0, kind)) {
+            return utils::exceptions::invalid_enum();
+        }
+        auto values = pxs_arg(args, 1);
+
+        if (pxs_varis(values, pxs_Buffer)) {
+            size_t len = 0;
+            auto data = static_cast<const uint8_t*>(pxs_getbuffer(values, &len));
+            auto array = make_array(kind, 0);
+            auto filled = std::visit([&](auto& items) {
+                using T = typename std::decay_t<decltype(items)>::value_type;
+                if (len % sizeof(T) != 0) {
+                    return false;
+                }
+                items.resize(len / sizeof(T));
+                if (len > 0) {
+                    std::memcpy(items.data(), data, len);
+                }
+                return true;
+            }, array->data);
+            if (!filled) {
+                delete array;
+                auto msg = std::string("Byte length is not a multiple of the ") + kind_name(kind) + " element size";
+                return pxs_newexception(msg.c_str());
+            }
+            return array->topxs();
+        }
+
+        if (!pxs_varis(values, pxs_List)) {
+            return utils::exceptions::expected_types(pxs_vartype(values), {pxs_List, pxs_Buffer});
+        }
+        std::vector<double> numbers(static_cast<size_t>(pxs_listlen(values)));
+        if (pxs_list_copy_f64(values, numbers.data(), numbers.size()) != static_cast<int32_t>(numbers.size())) {
+            return pxs_newexception("Array values must all be numbers");
+        }
+        auto array = make_array(kind, numbers.size());
+        std::visit([&](auto& items) {
+            using T = typename std::decay_t<decltype(items)>::value_type;
+            for (size_t i = 0; i < numbers.size(); i++) {
+                items[i] = narrow<T>(numbers[i]);
+            }
+        }, array->data);
+        return array->topxs();
+    }
+
+    void init(pxs_Module* yoyo) {
+        array_class.emplace("Array", yoyo::types::ARRAY_ARRAY_TYPE);
+        array_class->add_method("len", &Array::len);
+        array_class->add_method("kind", &Array::get_kind);
+        array_class->add_method("get", &Array::get);
+        array_class->add_method("set", &Array::set);
+        array_class->add_method("fill", &Array::fill);
+        array_class->add_method("add", &Array::add);
+        array_class->add_method("mul", &Array::mul);
+        array_class->add_method("axpy", &Array::axpy);
+        array_class->add_method("min", &Array::min);
+        array_class->add_method("max", &Array::max);
+        array_class->add_method("sum", &Array::sum);
+        array_class->add_method("clamp", &Array::clamp);
+        array_class->add_method("lerp", &Array::lerp);
+        array_class->add_method("gather", &Array::gather);
+        array_class->add_method("scatter", &Array::scatter);
+        array_class->add_method("to_list", &Array::to_list);
+        array_class->add_method("to_bytes", &Array::to_bytes);
+
+        auto array_mod = pxs_newmod("array");
+
+        pxs_addfunc(array_mod, "zeros", zeros);
+        pxs_addfunc(array_mod, "of", of);
+        pxs_addvar(array_mod, "F32", pxs_newint(static_cast<int>(Kind::F32)));
+        pxs_addvar(array_mod, "F64", pxs_newint(static_cast<int>(Kind::F64)));
+        pxs_addvar(array_mod, "I32", pxs_newint(static_cast<int>(Kind::I32)));
+        pxs_addvar(array_mod, "U8", pxs_newint(static_cast<int>(Kind::U8)));
+
+        pxs_add_submod(yoyo, array_mod);
+    }
+};
+
+#endif // YOYO_ARRAY
@@ -0,0 +1,306 @@
+#ifdef YOYO_CHANNEL
+
+#include "channel.hpp"
+#include "yoyo.hpp"
+#include <pixelscript_cpp.hpp>
+#include "utils/types.hpp"
+#include "utils/pxs.hpp"
+#include "utils/exceptions.hpp"
+#include <string>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <optional>
+#include <algorithm>
+
+namespace yoyo::channel {
+    // Used when no capacity is passed.
+    constexpr size_t DEFAULT_CAPACITY = 1024;
+
+    Ring::Ring(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        cells = std::make_unique<Cell[]>(size);
+        for (size_t i = 0; i < size; i++) {
+            cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+        mask = size - 1;
+    }
+
+    bool Ring::push(Message& message) {
+        Cell* cell;
+        size_t pos = head.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                // Our turn, claim the slot.
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // The slot still holds a message from the last lap.
+                return false;
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(message);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Ring::pop(Message& out) {
+        Cell* cell;
+        size_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // Nothing sent to the slot yet.
+                return false;
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+        out = std::move(cell->value);
+        // Free for the next lap.
+        cell->seq.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t Ring::capacity() const {
+        return mask + 1;
+    }
+
+    size_t Ring::size() const {
+        auto sent = head.load(std::memory_order_acquire);
+        auto received = tail.load(std::memory_order_acquire);
+        return sent > received ? std::min(sent - received, capacity()) : 0;
+    }
+
+    // Only held by `open`, never by sending or receiving.
+    std::mutex named_lock;
+    std::unordered_map<std::string, std::shared_ptr<Ring>> named_rings;
+
+    std::shared_ptr<Ring> named(const std::string& name, size_t capacity) {
+        std::lock_guard<std::mutex> guard(named_lock);
+        auto& ring = named_rings[name];
+        if (!ring) {
+            ring = std::make_shared<Ring>(capacity);
+        }
+        return ring;
+    }
+
+    // Class of the `Channel` host object. Created in `init` since the function lookup is reset with pixelscript.
+    std::optional<pxs::Class<Channel>> channel_class;
+
+    Channel::Channel(std::shared_ptr<Ring> ring, std::string name) : ring(std::move(ring)), name(std::move(name)) {}
+
+    void free_channel(pxs_Opaque ptr) {
+        if (!ptr) {
+            return;
+        }
+
+        delete static_cast<Channel*>(ptr);
+    }
+
+    // Pack `value` into `out`. Returns the exception on failure.
+    pxs_VarT pack(pxs_VarT rt, pxs_VarT value, Message& out) {
+        auto buffer = pxs_pack(rt, value);
+        if (pxs_varis(buffer, pxs_Exception)) {
+            return buffer;
+        }
+        size_t len = 0;
+        auto data = pxs_getstrview(buffer, &len);
+        out.bytes.assign(data == nullptr ? "" : data, data == nullptr ? 0 : len);
+        out.packed = true;
+        pxs_freevar(buffer);
+        return nullptr;
+    }
+
+    // The script value of `message`.
+    pxs_VarT unpack(Message& message) {
+        auto buffer = pxs_newbytes(static_cast<pxs_Opaque>(message.bytes.data()), sizeof(char), message.bytes.size());
+        if (!message.packed) {
+            return buffer;
+        }
+        auto res = pxs_unpack(buffer);
+        pxs_freevar(buffer);
+        return res;
+    }
+
+    pxs_VarT Channel::get_name(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Channel>(args, 0, yoyo::types::CHANNEL_CHANNEL_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        return pxs_newstring(self->name.c_str());
+    }
+
+    pxs_VarT Channel::get_capacity(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Channel>(args, 0, yoyo::types::CHANNEL_CHANNEL_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        return pxs_newint(static_cast<int64_t>(self->ring->capacity()));
+    }
+
+    pxs_VarT Channel::get_size(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Channel>(args, 0, yoyo::types::CHANNEL_CHANNEL_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        return pxs_newint(static_cast<int64_t>(self->ring->size()));
+    }
+
+    pxs_VarT Channel::try_send(pxs_VarT args) {
+        PXS_ARGC_EQ(2); // self, value
+        auto self = yoyo::utils::pxs::get_type<Channel>(args, 0, yoyo::types::CHANNEL_CHANNEL_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        Message message;
+        auto err = pack(pxs_getrt(args), pxs_arg(args, 1), message);
+        if (err) {
+            return err;
+        }
+        return pxs_newbool(self->ring->push(message));
+    }
+
+    pxs_VarT Channel::try_recv(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Channel>(args, 0, yoyo::types::CHANNEL_CHANNEL_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        Message message;
+        if (!self->ring->pop(message)) {
+            return pxs_newnull();
+        }
+        return unpack(message);
+    }
+
+    pxs_VarT Channel::send_many(pxs_VarT args) {
+        PXS_ARGC_EQ(2); // self, values
+        auto self = yoyo::utils::pxs::get_type<Channel>(args, 0, yoyo::types::CHANNEL_CHANNEL_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        auto values = pxs_arg(args, 1);
+        PXS_ARG_IS_TYPE(values, pxs_List);
+
+        auto rt = pxs_getrt(args);
+        int32_t len = pxs_listlen(values);
+        int64_t sent = 0;
+        for (int32_t i = 0; i < len; i++) {
+            Message message;
+            auto err = pack(rt, pxs_listget(values, i), message);
+            if (err) {
+                return err;
+            }
+            if (!self->ring->push(message)) {
+                break;
+            }
+            sent++;
+        }
+        return pxs_newint(sent);
+    }
+
+    pxs_VarT Channel::recv_many(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Channel>(args, 0, yoyo::types::CHANNEL_CHANNEL_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        size_t max = self->ring->capacity();
+        auto max_arg = pxs::Var::from_args(args, 1);
+        if (max_arg.is(pxs_Int64) || max_arg.is(pxs_UInt64)) {
+            max = static_cast<size_t>(std::max<int64_t>(max_arg.get_int(), 0));
+        }
+
+        auto res = pxs_newlist();
+        Message message;
+        for (size_t i = 0; i < max && self->ring->pop(message); i++) {
+            pxs_listadd(res, unpack(message));
+        }
+        return res;
+    }
+
+    // Capacity from an optional int argument.
+    size_t capacity_arg(pxs_VarT args, int index) {
+        auto capacity = pxs::Var::from_args(args, index);
+        if (capacity.is(pxs_Int64) || capacity.is(pxs_UInt64)) {
+            return static_cast<size_t>(std::clamp<int64_t>(capacity.get_int(), 1, int64_t(1) << 30));
+        }
+        return DEFAULT_CAPACITY;
+    }
+
+    pxs_VarT new_channel(pxs_VarT args) {
+        auto ring = std::make_shared<Ring>(capacity_arg(args, 0));
+        return channel_class->make(new Channel(std::move(ring), ""), free_channel).raw();
+    }
+
+    pxs_VarT open(pxs_VarT args) {
+        PXS_ARGC_GT(1); // name, capacity
+        auto name = pxs::Var::from_args(args, 0);
+        PXS_ARG_IS_TYPE(name.raw(), pxs_String);
+
+        auto str = name.get_string();
+        auto ring = named(str, capacity_arg(args, 1));
+        return channel_class->make(new Channel(std::move(ring), std::move(str)), free_channel).raw();
+    }
+
+    void* host_open(const char* name, uint32_t capacity) {
+        // Named rings are never dropped, so the raw pointer stays valid.
+        return named(name, capacity == 0 ? DEFAULT_CAPACITY : capacity).get();
+    }
+
+    bool host_push(void* ring, const void* data, size_t len, bool packed) {
+        Message message;
+        message.bytes.assign(static_cast<const char*>(data), len);
+        message.packed = packed;
+        return static_cast<Ring*>(ring)->push(message);
+    }
+
+    bool host_pop(void* ring, void (*sink)(void* opaque, const void* data, size_t len, bool packed), void* opaque) {
+        Message message;
+        if (!static_cast<Ring*>(ring)->pop(message)) {
+            return false;
+        }
+        sink(opaque, message.bytes.data(), message.bytes.size(), message.packed);
+        return true;
+    }
+
+    void init(pxs_Module* yoyo) {
+        channel_class.emplace("Channel", yoyo::types::CHANNEL_CHANNEL_TYPE);
+        channel_class->add_property("name", &Channel::get_name);
+        channel_class->add_property("capacity", &Channel::get_capacity);
+        channel_class->add_property("size", &Channel::get_size);
+        channel_class->add_method("try_send", &Channel::try_send);
+        channel_class->add_method("try_recv", &Channel::try_recv);
+        channel_class->add_method("send_many", &Channel::send_many);
+        channel_class->add_method("recv_many", &Channel::recv_many);
+
+        auto channel_mod = pxs_newmod("channel");
+
+        pxs_addfunc(channel_mod, "new", new_channel);
+        pxs_addfunc(channel_mod, "open", open);
+
+        pxs_add_submod(yoyo, channel_mod);
+    }
+};
+
+#endif // YOYO_CHANNEL
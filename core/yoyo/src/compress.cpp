@@ -0,0 +1,645 @@
+#ifdef YOYO_COMPRESS
+
+#include "compress.hpp"
+#include <pixelscript_cpp.hpp>
+#include "utils/types.hpp"
+#include "utils/pxs.hpp"
+#include "utils/pool.hpp"
+#include "utils/bytes.hpp"
+#include "utils/exceptions.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+// Only the C API, the implementation lives in utils/miniz.cpp.
+#define MINIZ_HEADER_FILE_ONLY
+#define MINIZ_NO_CPP_WRAPPER
+#define MINIZ_NO_ZLIB_COMPATIBLE_NAMES
+#include "miniz.hpp"
+
+namespace yoyo::compress {
+    // Input size of one block of `parallel` compression.
+    constexpr size_t BLOCK_SIZE = 1 << 20;
+    constexpr size_t CHUNK_SIZE = 64 * 1024;
+    constexpr int DEFAULT_LEVEL = MZ_DEFAULT_LEVEL;
+
+    // The 10 byte gzip header, no name or time.
+    void gzip_header(int level, std::string& out) {
+        const char header[10] = {
+            '\x1f', '\x8b', 8, 0, 0, 0, 0, 0,
+            static_cast<char>(level >= 9 ? 2 : level <= 1 ? 4 : 0),
+            // Unknown OS.
+            '\xff'
+        };
+        out.append(header, sizeof(header));
+    }
+
+    // Little endian for gzip, big endian for zlib.
+    void append_u32(std::string& out, uint32_t value, bool little) {
+        for (int i = 0; i < 4; i++) {
+            int shift = little ? i * 8 : (3 - i) * 8;
+            out.push_back(static_cast<char>((value >> shift) & 0xff));
+        }
+    }
+
+    // Run `stream` over its input, appending the output to `out`. Returns false on a miniz error.
+    bool run_deflate(mz_stream& stream, int flush, std::string& out) {
+        if (stream.avail_in == 0 && flush == MZ_NO_FLUSH) {
+            return true;
+        }
+        unsigned char buffer[CHUNK_SIZE];
+        while (true) {
+            stream.next_out = buffer;
+            stream.avail_out = sizeof(buffer);
+            int r = mz_deflate(&stream, flush);
+            out.append(reinterpret_cast<const char*>(buffer), sizeof(buffer) - stream.avail_out);
+            if (r == MZ_STREAM_END) {
+                return true;
+            }
+            if (r != MZ_OK && r != MZ_BUF_ERROR) {
+                return false;
+            }
+            // Everything consumed and the output had room, so nothing is held back.
+            if (flush != MZ_FINISH && stream.avail_in == 0 && stream.avail_out != 0) {
+                return true;
+            }
+        }
+    }
+
+    class Encoder {
+        mz_stream stream{};
+        Format format;
+        int level;
+        bool started = false;
+        bool wrote_header = false;
+        mz_ulong crc = MZ_CRC32_INIT;
+        uint32_t size = 0;
+
+    public:
+        bool finished = false;
+
+        Encoder(Format format, int level) : format(format), level(level) {}
+        ~Encoder() {
+            if (this->started) {
+                mz_deflateEnd(&this->stream);
+            }
+        }
+
+        Encoder(const Encoder&) = delete;
+        Encoder& operator=(const Encoder&) = delete;
+
+        bool start() {
+            int window_bits = this->format == Format::Zlib ? MZ_DEFAULT_WINDOW_BITS : -MZ_DEFAULT_WINDOW_BITS;
+            this->started = mz_deflateInit2(&this->stream, this->level, MZ_DEFLATED, window_bits, 9, MZ_DEFAULT_STRATEGY) == MZ_OK;
+            return this->started;
+        }
+
+        // Compress `len` bytes with `flush` (`MZ_NO_FLUSH`, `MZ_SYNC_FLUSH` or `MZ_FINISH`) into `out`.
+        bool write(const uint8_t* data, size_t len, int flush, std::string& out) {
+            if (this->format == Format::Gzip) {
+                if (!this->wrote_header) {
+                    gzip_header(this->level, out);
+                    this->wrote_header = true;
+                }
+                this->crc = mz_crc32(this->crc, data, len);
+                this->size += static_cast<uint32_t>(len);
+            }
+
+            // `avail_in` is 32 bit.
+            do {
+                auto part = std::min<size_t>(len, 1u << 30);
+                this->stream.next_in = data;
+                this->stream.avail_in = static_cast<unsigned int>(part);
+                data += part;
+                len -= part;
+                if (!run_deflate(this->stream, len == 0 ? flush : MZ_NO_FLUSH, out)) {
+                    return false;
+                }
+            } while (len > 0);
+
+            if (flush == MZ_FINISH) {
+                if (this->format == Format::Gzip) {
+                    append_u32(out, static_cast<uint32_t>(this->crc), true);
+                    append_u32(out, this->size, true);
+                }
+                this->finished = true;
+            }
+            return true;
+        }
+    };
+
+    // Size of the gzip header at the start of `header`, 0 when more bytes are needed. Sets `error` when invalid.
+    size_t gzip_header_size(const std::string& header, std::string& error) {
+        auto h = reinterpret_cast<const unsigned char*>(header.data());
+        if (header.size() < 10) {
+            return 0;
+        }
+        if (h[0] != 0x1f || h[1] != 0x8b || h[2] != 8) {
+            error = "Not gzip data";
+            return 0;
+        }
+
+        auto flags = h[3];
+        size_t pos = 10;
+        if (flags & 4) {
+            // FEXTRA
+            if (header.size() < pos + 2) {
+                return 0;
+            }
+            pos += 2 + (h[pos] | (h[pos + 1] << 8));
+        }
+        for (int bit : {8, 16}) {
+            // FNAME, FCOMMENT
+            if (flags & bit) {
+                auto end = header.find('\0', std::min(pos, header.size()));
+                if (end == std::string::npos) {
+                    return 0;
+                }
+                pos = end + 1;
+            }
+        }
+        if (flags & 2) {
+            // FHCRC
+            pos += 2;
+        }
+        return header.size() >= pos ? pos : 0;
+    }
+
+    class Decoder {
+        mz_stream stream{};
+        Format format;
+        bool started = false;
+        bool stream_ended = false;
+        // Bytes held back until the gzip header is complete.
+        std::string header;
+        // The crc-32 and size after gzip data. Starts with the last input bytes inflate took, it reads a few bytes past
+        // the end of the deflate data.
+        std::string trailer;
+        size_t lookback = 0;
+        mz_ulong crc = MZ_CRC32_INIT;
+        uint32_t size = 0;
+
+        bool take_trailer(const uint8_t* data, size_t len, std::string& error) {
+            if (this->format != Format::Gzip) {
+                this->done = true;
+                return true;
+            }
+            auto want = this->lookback + 8 - this->trailer.size();
+            this->trailer.append(reinterpret_cast<const char*>(data), std::min(len, want));
+
+            std::string expected;
+            append_u32(expected, static_cast<uint32_t>(this->crc), true);
+            append_u32(expected, this->size, true);
+            // The trailer starts at most `lookback` bytes before the unused input. Wait while a start still matches.
+            bool possible = false;
+            for (size_t back = 0; back <= this->lookback; back++) {
+                auto start = this->lookback - back;
+                auto have = std::min<size_t>(8, this->trailer.size() - start);
+                if (this->trailer.compare(start, have, expected, 0, have) != 0) {
+                    continue;
+                }
+                if (have == 8) {
+                    this->done = true;
+                    return true;
+                }
+                possible = true;
+            }
+            if (!possible) {
+                error = "gzip check failed";
+                return false;
+            }
+            return true;
+        }
+
+        bool decode(const uint8_t* data, size_t len, std::string& out, std::string& error) {
+            if (this->stream_ended) {
+                return take_trailer(data, len, error);
+            }
+
+            unsigned char buffer[CHUNK_SIZE];
+            this->stream.next_in = data;
+            this->stream.avail_in = static_cast<unsigned int>(len);
+            size_t produced;
+            do {
+                this->stream.next_out = buffer;
+                this->stream.avail_out = sizeof(buffer);
+                auto consumed = this->stream.next_in;
+                int r = mz_inflate(&this->stream, MZ_NO_FLUSH);
+                produced = sizeof(buffer) - this->stream.avail_out;
+                out.append(reinterpret_cast<const char*>(buffer), produced);
+                if (this->format == Format::Gzip) {
+                    this->crc = mz_crc32(this->crc, buffer, produced);
+                    this->size += static_cast<uint32_t>(produced);
+                    // Only the last 8 bytes can be part of the trailer.
+                    this->trailer.append(reinterpret_cast<const char*>(consumed), this->stream.next_in - consumed);
+                    if (this->trailer.size() > 8) {
+                        this->trailer.erase(0, this->trailer.size() - 8);
+                    }
+                }
+                if (r == MZ_STREAM_END) {
+                    this->stream_ended = true;
+                    this->lookback = this->trailer.size();
+                    return take_trailer(this->stream.next_in, this->stream.avail_in, error);
+                }
+                if (r != MZ_OK && r != MZ_BUF_ERROR) {
+                    error = "Invalid compressed data";
+                    return false;
+                }
+            } while (this->stream.avail_in > 0 || produced == sizeof(buffer));
+            return true;
+        }
+
+    public:
+        bool done = false;
+
+        Decoder(Format format) : format(format) {}
+        ~Decoder() {
+            if (this->started) {
+                mz_inflateEnd(&this->stream);
+            }
+        }
+
+        Decoder(const Decoder&) = delete;
+        Decoder& operator=(const Decoder&) = delete;
+
+        // Decompress `len` bytes into `out`. Sets `error` and returns false on invalid data.
+        bool write(const uint8_t* data, size_t len, std::string& out, std::string& error) {
+            if (this->done) {
+                return true;
+            }
+            // `avail_in` is 32 bit.
+            while (len > (1u << 30)) {
+                if (!write(data, 1u << 30, out, error)) {
+                    return false;
+                }
+                data += 1u << 30;
+                len -= 1u << 30;
+            }
+            if (this->started) {
+                return decode(data, len, out, error);
+            }
+
+            size_t skip = 0;
+            if (this->format == Format::Gzip) {
+                this->header.append(reinterpret_cast<const char*>(data), len);
+                skip = gzip_header_size(this->header, error);
+                if (skip == 0) {
+                    return error.empty();
+                }
+            }
+            int window_bits = this->format == Format::Zlib ? MZ_DEFAULT_WINDOW_BITS : -MZ_DEFAULT_WINDOW_BITS;
+            if (mz_inflateInit2(&this->stream, window_bits) != MZ_OK) {
+                error = "Could not start decompressing";
+                return false;
+            }
+            this->started = true;
+
+            if (this->format != Format::Gzip) {
+                return decode(data, len, out, error);
+            }
+            auto rest = this->header.substr(skip);
+            this->header.clear();
+            return decode(reinterpret_cast<const uint8_t*>(rest.data()), rest.size(), out, error);
+        }
+    };
+
+    // Compress 1MB blocks on the worker pool. Every block is its own raw deflate stream ended with a sync flush
+    // (byte aligned and not final) except the last, so they concatenate into one valid stream.
+    bool deflate_parallel(const uint8_t* data, size_t len, Format format, int level, std::string& out) {
+        size_t count = (len + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        std::vector<std::string> parts(count);
+        std::vector<char> ok(count, 0);
+
+        std::mutex lock;
+        std::condition_variable cv;
+        size_t remaining = count;
+        for (size_t i = 0; i < count; i++) {
+            utils::pool::shared().submit([&, i]() {
+                mz_stream stream{};
+                if (mz_deflateInit2(&stream, level, MZ_DEFLATED, -MZ_DEFAULT_WINDOW_BITS, 9, MZ_DEFAULT_STRATEGY) == MZ_OK) {
+                    auto offset = i * BLOCK_SIZE;
+                    stream.next_in = data + offset;
+                    stream.avail_in = static_cast<unsigned int>(std::min(BLOCK_SIZE, len - offset));
+                    ok[i] = run_deflate(stream, i + 1 == count ? MZ_FINISH : MZ_SYNC_FLUSH, parts[i]);
+                    mz_deflateEnd(&stream);
+                }
+                std::lock_guard<std::mutex> guard(lock);
+                if (--remaining == 0) {
+                    cv.notify_one();
+                }
+            });
+        }
+
+        // The check is over the whole input, computed while the blocks compress.
+        uint32_t check;
+        if (format == Format::Gzip) {
+            gzip_header(level, out);
+            check = static_cast<uint32_t>(mz_crc32(MZ_CRC32_INIT, data, len));
+        } else {
+            if (format == Format::Zlib) {
+                unsigned cmf = 0x78;
+                unsigned flevel = level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+                unsigned flg = flevel << 6;
+                flg += 31 - ((cmf << 8) | flg) % 31;
+                out.push_back(static_cast<char>(cmf));
+                out.push_back(static_cast<char>(flg));
+            }
+            check = static_cast<uint32_t>(mz_adler32(MZ_ADLER32_INIT, data, len));
+        }
+
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            cv.wait(guard, [&] { return remaining == 0; });
+        }
+        if (std::find(ok.begin(), ok.end(), 0) != ok.end()) {
+            return false;
+        }
+
+        size_t total = out.size() + 8;
+        for (auto& part : parts) {
+            total += part.size();
+        }
+        out.reserve(total);
+        for (auto& part : parts) {
+            out += part;
+        }
+        if (format == Format::Gzip) {
+            append_u32(out, check, true);
+            append_u32(out, static_cast<uint32_t>(len), true);
+        } else if (format == Format::Zlib) {
+            append_u32(out, check, false);
+        }
+        return true;
+    }
+
+    // Classes of the compress host objects. Created in `init` since the function lookup is reset with pixelscript.
+    std::optional<pxs::Class<Compressor>> compressor_class;
+    std::optional<pxs::Class<Decompressor>> decompressor_class;
+
+    Compressor::Compressor(std::unique_ptr<Encoder> encoder) : encoder(std::move(encoder)) {}
+    Compressor::~Compressor() = default;
+
+    Decompressor::Decompressor(std::unique_ptr<Decoder> decoder) : decoder(std::move(decoder)) {}
+    Decompressor::~Decompressor() = default;
+
+    void free_compressor(pxs_Opaque ptr) {
+        if (!ptr) {
+            return;
+        }
+
+        delete static_cast<Compressor*>(ptr);
+    }
+
+    void free_decompressor(pxs_Opaque ptr) {
+        if (!ptr) {
+            return;
+        }
+
+        delete static_cast<Decompressor*>(ptr);
+    }
+
+    pxs_VarT new_bytes(const std::string& bytes) {
+        return pxs_newbytes(static_cast<pxs_Opaque>(const_cast<char*>(bytes.data())), sizeof(char), bytes.size());
+    }
+
+    pxs_VarT expected_bytes(pxs_VarT arg) {
+        return utils::exceptions::expected_types(pxs_vartype(arg), {pxs_String, pxs_List});
+    }
+
+    // Read the optional level arg at `idx` into `level`. Returns the exception when it is invalid.
+    pxs_VarT level_arg(pxs_VarT args, int idx, int& level) {
+        auto arg = pxs::Var::from_args(args, idx);
+        if (arg.is(pxs_Int64) || arg.is(pxs_UInt64)) {
+            auto value = arg.get_int();
+            if (value < 0 || value > MZ_BEST_COMPRESSION) {
+                return pxs_newexception("Compression level must be 0 to 9");
+            }
+            level = static_cast<int>(value);
+        } else if (!arg.is(pxs_Null)) {
+            return utils::exceptions::expected_types(pxs_vartype(arg.raw()), {pxs_Int64, pxs_Null});
+        }
+        return nullptr;
+    }
+
+    // Read the optional format arg at `idx` into `format`. Returns the exception when it is invalid.
+    pxs_VarT format_arg(pxs_VarT args, int idx, Format& format) {
+        auto arg = pxs::Var::from_args(args, idx);
+        if (arg.is(pxs_Int64) || arg.is(pxs_UInt64)) {
+            auto value = arg.get_int();
+            if (value < 0 || value > static_cast<int64_t>(Format::Gzip)) {
+                return utils::exceptions::invalid_enum();
+            }
+            format = static_cast<Format>(value);
+        } else if (!arg.is(pxs_Null)) {
+            return utils::exceptions::expected_types(pxs_vartype(arg.raw()), {pxs_Int64, pxs_Null});
+        }
+        return nullptr;
+    }
+
+    pxs_VarT Compressor::get_finished(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Compressor>(args, 0, yoyo::types::COMPRESS_COMPRESSOR_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        return pxs_newbool(self->encoder->finished);
+    }
+
+    pxs_VarT Compressor::encode(pxs_VarT args, int flush) {
+        auto self = yoyo::utils::pxs::get_type<Compressor>(args, 0, yoyo::types::COMPRESS_COMPRESSOR_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        if (self->encoder->finished) {
+            return pxs_newexception("Compressor is finished");
+        }
+
+        const uint8_t* data = nullptr;
+        size_t len = 0;
+        std::vector<uint8_t> storage;
+        if (flush == MZ_NO_FLUSH) {
+            PXS_ARGC_EQ(2); // self, data
+            if (!utils::bytes::view_bytes(pxs_arg(args, 1), data, len, storage)) {
+                return expected_bytes(pxs_arg(args, 1));
+            }
+        }
+
+        std::string out;
+        if (!self->encoder->write(data, len, flush, out)) {
+            return pxs_newexception("Could not compress");
+        }
+        return new_bytes(out);
+    }
+
+    pxs_VarT Compressor::write(pxs_VarT args) {
+        return encode(args, MZ_NO_FLUSH);
+    }
+
+    pxs_VarT Compressor::flush(pxs_VarT args) {
+        return encode(args, MZ_SYNC_FLUSH);
+    }
+
+    pxs_VarT Compressor::finish(pxs_VarT args) {
+        return encode(args, MZ_FINISH);
+    }
+
+    pxs_VarT Decompressor::get_done(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Decompressor>(args, 0, yoyo::types::COMPRESS_DECOMPRESSOR_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        return pxs_newbool(self->decoder->done);
+    }
+
+    pxs_VarT Decompressor::write(pxs_VarT args) {
+        PXS_ARGC_EQ(2); // self, data
+        auto self = yoyo::utils::pxs::get_type<Decompressor>(args, 0, yoyo::types::COMPRESS_DECOMPRESSOR_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        const uint8_t* data;
+        size_t len;
+        std::vector<uint8_t> storage;
+        if (!utils::bytes::view_bytes(pxs_arg(args, 1), data, len, storage)) {
+            return expected_bytes(pxs_arg(args, 1));
+        }
+
+        std::string out;
+        std::string error;
+        if (!self->decoder->write(data, len, out, error)) {
+            return pxs_newexception(error.c_str());
+        }
+        return new_bytes(out);
+    }
+
+    // Shared by `deflate` and `gzip`.
+    pxs_VarT compress_all(pxs_VarT args, Format format) {
+        PXS_ARGC_GT(1); // data, level, parallel
+        const uint8_t* data;
+        size_t len;
+        std::vector<uint8_t> storage;
+        if (!utils::bytes::view_bytes(pxs_arg(args, 0), data, len, storage)) {
+            return expected_bytes(pxs_arg(args, 0));
+        }
+        int level = DEFAULT_LEVEL;
+        if (auto err = level_arg(args, 1, level)) {
+            return err;
+        }
+        auto parallel = pxs::Var::from_args(args, 2);
+
+        std::string out;
+        if (parallel.is(pxs_Bool) && parallel.get_bool() && len > 2 * BLOCK_SIZE) {
+            if (!deflate_parallel(data, len, format, level, out)) {
+                return pxs_newexception("Could not compress");
+            }
+            return new_bytes(out);
+        }
+
+        Encoder encoder(format, level);
+        out.reserve(len / 2 + 64);
+        if (!encoder.start() || !encoder.write(data, len, MZ_FINISH, out)) {
+            return pxs_newexception("Could not compress");
+        }
+        return new_bytes(out);
+    }
+
+    // Shared by `inflate` and `gunzip`.
+    pxs_VarT decompress_all(pxs_VarT args, Format format) {
+        PXS_ARGC_GT(1); // data, text
+        const uint8_t* data;
+        size_t len;
+        std::vector<uint8_t> storage;
+        if (!utils::bytes::view_bytes(pxs_arg(args, 0), data, len, storage)) {
+            return expected_bytes(pxs_arg(args, 0));
+        }
+        auto text = pxs::Var::from_args(args, 1);
+
+        Decoder decoder(format);
+        std::string out;
+        std::string error;
+        if (!decoder.write(data, len, out, error)) {
+            return pxs_newexception(error.c_str());
+        }
+        if (!decoder.done) {
+            return pxs_newexception("Compressed data is cut off");
+        }
+        if (text.is(pxs_Bool) && text.get_bool()) {
+            return pxs_newstring(out.c_str());
+        }
+        return new_bytes(out);
+    }
+
+    pxs_VarT deflate(pxs_VarT args) {
+        return compress_all(args, Format::Zlib);
+    }
+
+    pxs_VarT inflate(pxs_VarT args) {
+        return decompress_all(args, Format::Zlib);
+    }
+
+    pxs_VarT gzip(pxs_VarT args) {
+        return compress_all(args, Format::Gzip);
+    }
+
+    pxs_VarT gunzip(pxs_VarT args) {
+        return decompress_all(args, Format::Gzip);
+    }
+
+    pxs_VarT compressor(pxs_VarT args) {
+        auto format = Format::Zlib;
+        if (auto err = format_arg(args, 0, format)) {
+            return err;
+        }
+        int level = DEFAULT_LEVEL;
+        if (auto err = level_arg(args, 1, level)) {
+            return err;
+        }
+
+        auto encoder = std::make_unique<Encoder>(format, level);
+        if (!encoder->start()) {
+            return pxs_newexception("Could not start compressing");
+        }
+        return compressor_class->make(new Compressor(std::move(encoder)), free_compressor).raw();
+    }
+
+    pxs_VarT decompressor(pxs_VarT args) {
+        auto format = Format::Zlib;
+        if (auto err = format_arg(args, 0, format)) {
+            return err;
+        }
+
+        return decompressor_class->make(new Decompressor(std::make_unique<Decoder>(format)), free_decompressor).raw();
+    }
+
+    void init(pxs_Module* yoyo) {
+        compressor_class.emplace("Compressor", yoyo::types::COMPRESS_COMPRESSOR_TYPE);
+        compressor_class->add_property("finished", &Compressor::get_finished);
+        compressor_class->add_method("write", &Compressor::write);
+        compressor_class->add_method("flush", &Compressor::flush);
+        compressor_class->add_method("finish", &Compressor::finish);
+
+        decompressor_class.emplace("Decompressor", yoyo::types::COMPRESS_DECOMPRESSOR_TYPE);
+        decompressor_class->add_property("done", &Decompressor::get_done);
+        decompressor_class->add_method("write", &Decompressor::write);
+
+        auto compress_mod = pxs_newmod("compress");
+
+        pxs_addfunc(compress_mod, "deflate", deflate);
+        pxs_addfunc(compress_mod, "inflate", inflate);
+        pxs_addfunc(compress_mod, "gzip", gzip);
+        pxs_addfunc(compress_mod, "gunzip", gunzip);
+        pxs_addfunc(compress_mod, "compressor", compressor);
+        pxs_addfunc(compress_mod, "decompressor", decompressor);
+
+        pxs_addvar(compress_mod, "FORMAT_ZLIB", pxs_newint(static_cast<int>(Format::Zlib)));
+        pxs_addvar(compress_mod, "FORMAT_RAW", pxs_newint(static_cast<int>(Format::Raw)));
+        pxs_addvar(compress_mod, "FORMAT_GZIP", pxs_newint(static_cast<int>(Format::Gzip)));
+
+        pxs_add_submod(yoyo, compress_mod);
+    }
+};
+
+#endif // YOYO_COMPRESS
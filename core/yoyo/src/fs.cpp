@@ -12,10 +12,154 @@
 #include "utils/debug.hpp"
 #include <system_error>
 #include "utils/types.hpp"
+#include "utils/pxs.hpp"
 #include "utils/exceptions.hpp"
+#include "utils/pool.hpp"
 #include <iterator>
+#include <cstring>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <algorithm>
+#include <optional>
+#include <unordered_map>
+#include <memory>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/uio.h>
+#include <climits>
+#endif
 
 namespace yoyo::fs {
+    MappedFile::MappedFile(const std::string& path, bool sequential) {
+    #if defined(_WIN32)
+        auto wpath = utils::str::to_wstring(path);
+        HANDLE file = CreateFileW(wpath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return;
+        }
+        this->file_handle = file;
+
+        LARGE_INTEGER fsize;
+        if (!GetFileSizeEx(file, &fsize)) {
+            return;
+        }
+        this->length = static_cast<size_t>(fsize.QuadPart);
+        if (this->length == 0) {
+            // Can't map a empty file, but it's still a valid read.
+            this->ok = true;
+            return;
+        }
+
+        // Copy on write, so the view can be handed out as a writable buffer without changing the file.
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        if (mapping == nullptr) {
+            return;
+        }
+        this->map_handle = mapping;
+
+        auto view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+        if (view == nullptr) {
+            return;
+        }
+        this->view = static_cast<const char*>(view);
+        this->ok = true;
+    #else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return;
+        }
+        this->length = static_cast<size_t>(st.st_size);
+        if (this->length == 0) {
+            ::close(fd);
+            this->ok = true;
+            return;
+        }
+
+        // Copy on write, so the view can be handed out as a writable buffer without changing the file.
+        void* view = mmap(nullptr, this->length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        // The mapping keeps its own reference to the file.
+        ::close(fd);
+        if (view == MAP_FAILED) {
+            return;
+        }
+        madvise(view, this->length, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+        this->view = static_cast<const char*>(view);
+        this->ok = true;
+    #endif
+    }
+
+    MappedFile::~MappedFile() {
+    #if defined(_WIN32)
+        if (this->view != nullptr) {
+            UnmapViewOfFile(this->view);
+        }
+        if (this->map_handle != nullptr) {
+            CloseHandle(static_cast<HANDLE>(this->map_handle));
+        }
+        if (this->file_handle != nullptr) {
+            CloseHandle(static_cast<HANDLE>(this->file_handle));
+        }
+    #else
+        if (this->view != nullptr) {
+            munmap(const_cast<char*>(this->view), this->length);
+        }
+    #endif
+    }
+
+    // Mappings handed to scripts by `MappedFile::read`, by the start of their view. Dropped by `free_mapping`.
+    std::mutex mappings_lock;
+    std::unordered_map<const void*, std::unique_ptr<MappedFile>> mappings;
+
+    void free_mapping(void* data) {
+        std::unique_ptr<MappedFile> mapped;
+        {
+            std::lock_guard<std::mutex> guard(mappings_lock);
+            auto it = mappings.find(data);
+            if (it == mappings.end()) {
+                return;
+            }
+            // Unmapped outside the lock.
+            mapped = std::move(it->second);
+            mappings.erase(it);
+        }
+    }
+
+    pxs_VarT MappedFile::read(const std::string& path) {
+        auto mapped = std::make_unique<MappedFile>(path);
+        if (!mapped->is_mapped()) {
+            return pxs_newexception(("Could not map file: " + path).c_str());
+        }
+        if (mapped->size() == 0) {
+            // Nothing is mapped, a empty buffer over a static byte.
+            static char empty = 0;
+            return pxs_newbytes_borrowed(static_cast<pxs_Opaque>(&empty), 0, nullptr);
+        }
+
+        // The buffer is the mapping itself, it is unmapped once the scripts let go of it.
+        auto data = const_cast<char*>(mapped->data());
+        auto len = mapped->size();
+        {
+            std::lock_guard<std::mutex> guard(mappings_lock);
+            mappings.emplace(data, std::move(mapped));
+        }
+        return pxs_newbytes_borrowed(static_cast<pxs_Opaque>(data), len, free_mapping);
+    }
+
     // free a File
     void free_file(pxs_Opaque obj) {
         if (obj == nullptr) {
@@ -26,18 +170,69 @@ namespace yoyo::fs {
         delete val;
     }
 
+    // Write a `pxs_String`, a `pxs_Buffer` or a `pxs_List` of bytes into `out`.
+    //
+    // Strings and buffers are written straight from their own storage. Lists of `pxs_Byte` are streamed through a
+    // small fixed buffer so no copy the size of `data` is ever made. Any other list falls back to `pxs_copybytes`.
+    //
+    // returns `nullptr` on success, otherwise a `pxs_Exception`.
+    pxs_VarT write_var(std::ostream& out, pxs_VarT data) {
+        if (pxs_varis(data, pxs_String)) {
+            const char* str = data->value.string_val;
+            if (str != nullptr) {
+                out.write(str, std::strlen(str));
+            }
+        } else if (pxs_varis(data, pxs_Buffer)) {
+            uintptr_t len = 0;
+            auto bytes = pxs_getbuffer(data, &len);
+            if (bytes != nullptr) {
+                out.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(len));
+            }
+        } else if (pxs_varis(data, pxs_List)) {
+            auto len = pxs_listlen(data);
+            char chunk[4096];
+            size_t used = 0;
+            for (int i = 0; i < len; i++) {
+                auto item = pxs_listget(data, i);
+                if (!pxs_varis(item, pxs_Byte)) {
+                    // Mixed list, let pixelscript figure out the layout.
+                    out.write(chunk, used);
+                    auto rest = pxs_newlist_with_capacity(static_cast<size_t>(len - i));
+                    for (int j = i; j < len; j++) {
+                        pxs_listadd(rest, pxs_new_shallowcopy(pxs_listget(data, j)));
+                    }
+                    std::vector<char> bytes(pxs_varsize(rest));
+                    pxs_copybytes(rest, static_cast<pxs_Opaque>(bytes.data()));
+                    pxs_freevar(rest);
+                    out.write(bytes.data(), bytes.size());
+                    used = 0;
+                    break;
+                }
+
+                chunk[used++] = static_cast<char>(item->value.byte_val);
+                if (used == sizeof(chunk)) {
+                    out.write(chunk, used);
+                    used = 0;
+                }
+            }
+            out.write(chunk, used);
+        } else {
+            return utils::exceptions::expected_types(data->tag, {pxs_String, pxs_Buffer, pxs_List});
+        }
+
+        if (!out) {
+            return pxs_newexception("Could not write to `File`.");
+        }
+        return nullptr;
+    }
+
+    // Classes of the fs host objects. Created in `init` since the function lookup is reset with pixelscript.
+    std::optional<pxs::Class<File>> file_class;
+    std::optional<pxs::Class<ReadHandle>> read_handle_class;
+
     // Create the `File` object with all it's methods.
     pxs_VarT create_file_object(File* file) {
-        auto obj = pxs_newtype(static_cast<pxs_Opaque>(file), free_file, "File", yoyo::types::FS_FILE_TYPE);
-        pxs_object_addfunc(obj, "read", &File::read);
-        pxs_object_addfunc(obj, "write", &File::write);
-        pxs_object_addfunc(obj, "append", &File::append);
-        pxs_object_addfunc(obj, "close", &File::close);
-        pxs_object_addfunc(obj, "remove", &File::remove);
-        pxs_object_addfunc(obj, "save", &File::save);
-        pxs_object_addprop(obj, "path", &File::get_path);
-        pxs_object_addprop(obj, "open_type", &File::get_open_type);
-        return pxs_newhost(obj);
+        return file_class->make(file, free_file).raw();
     }
 
     File::~File() {
@@ -50,7 +245,235 @@ namespace yoyo::fs {
         }
     }
 
-    File::File(const std::string& path, FileOpenType ot) {
+    BlockBuffer::BlockBuffer(size_t block_size, size_t spill_threshold) {
+        configure(block_size, spill_threshold);
+    }
+
+    BlockBuffer::~BlockBuffer() {
+        if (this->spill != nullptr) {
+            std::fclose(this->spill);
+        }
+    }
+
+    void BlockBuffer::configure(size_t block_size, size_t spill_threshold) {
+        this->block_size = block_size == 0 ? 64 * 1024 : block_size;
+        this->spill_threshold = spill_threshold;
+    }
+
+    void BlockBuffer::reset() {
+        this->blocks.clear();
+        this->tail = 0;
+        this->in_memory = 0;
+        if (this->spill != nullptr) {
+            std::fclose(this->spill);
+            this->spill = nullptr;
+        }
+        this->spilled = 0;
+        this->gbase = 0;
+        setg(nullptr, nullptr, nullptr);
+    }
+
+    size_t BlockBuffer::read_pos() const {
+        if (eback() == nullptr) {
+            return this->gbase;
+        }
+        return this->gbase + static_cast<size_t>(gptr() - eback());
+    }
+
+    void BlockBuffer::spill_blocks() {
+        if (this->spill == nullptr) {
+            this->spill = std::tmpfile();
+            if (this->spill == nullptr) {
+                // Keep it in memory then.
+                this->spill_threshold = 0;
+                return;
+            }
+        }
+
+        auto pos = read_pos();
+        std::fseek(this->spill, 0, SEEK_END);
+        for (size_t i = 0; i < this->blocks.size(); i++) {
+            size_t len = i + 1 == this->blocks.size() ? this->tail : this->block_size;
+            std::fwrite(this->blocks[i].get(), 1, len, this->spill);
+        }
+        this->spilled += this->in_memory;
+        this->blocks.clear();
+        this->in_memory = 0;
+        this->tail = 0;
+
+        // The read window may point into a dropped block.
+        this->gbase = pos;
+        setg(nullptr, nullptr, nullptr);
+    }
+
+    std::streamsize BlockBuffer::xsputn(const char* s, std::streamsize n) {
+        std::streamsize written = 0;
+        while (written < n) {
+            if (this->blocks.empty() || this->tail == this->block_size) {
+                this->blocks.emplace_back(new char[this->block_size]);
+                this->tail = 0;
+            }
+            size_t room = this->block_size - this->tail;
+            size_t len = std::min(room, static_cast<size_t>(n - written));
+            std::memcpy(this->blocks.back().get() + this->tail, s + written, len);
+            this->tail += len;
+            this->in_memory += len;
+            written += static_cast<std::streamsize>(len);
+        }
+
+        if (this->spill_threshold > 0 && this->in_memory >= this->spill_threshold) {
+            spill_blocks();
+        }
+        return written;
+    }
+
+    BlockBuffer::int_type BlockBuffer::overflow(int_type ch) {
+        if (traits_type::eq_int_type(ch, traits_type::eof())) {
+            return traits_type::not_eof(ch);
+        }
+        char c = traits_type::to_char_type(ch);
+        xsputn(&c, 1);
+        return ch;
+    }
+
+    BlockBuffer::int_type BlockBuffer::underflow() {
+        auto pos = read_pos();
+        if (pos >= size()) {
+            this->gbase = pos;
+            setg(nullptr, nullptr, nullptr);
+            return traits_type::eof();
+        }
+
+        if (pos < this->spilled) {
+            size_t len = std::min(this->block_size, this->spilled - pos);
+            this->window.resize(len);
+            std::fseek(this->spill, static_cast<long>(pos), SEEK_SET);
+            len = std::fread(this->window.data(), 1, len, this->spill);
+            if (len == 0) {
+                return traits_type::eof();
+            }
+            this->gbase = pos;
+            setg(this->window.data(), this->window.data(), this->window.data() + len);
+        } else {
+            size_t offset = pos - this->spilled;
+            size_t bi = offset / this->block_size;
+            size_t within = offset % this->block_size;
+            size_t len = bi + 1 == this->blocks.size() ? this->tail : this->block_size;
+            char* block = this->blocks[bi].get();
+            this->gbase = pos - within;
+            setg(block, block + within, block + len);
+        }
+
+        return traits_type::to_int_type(*gptr());
+    }
+
+    BlockBuffer::pos_type BlockBuffer::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) {
+        off_type base = 0;
+        if (dir == std::ios::cur) {
+            base = static_cast<off_type>(which & std::ios::in ? read_pos() : size());
+        } else if (dir == std::ios::end) {
+            base = static_cast<off_type>(size());
+        }
+        return seekpos(pos_type(base + off), which);
+    }
+
+    BlockBuffer::pos_type BlockBuffer::seekpos(pos_type pos, std::ios_base::openmode which) {
+        auto p = static_cast<off_type>(pos);
+        if (p < 0 || static_cast<size_t>(p) > size()) {
+            return pos_type(off_type(-1));
+        }
+        if (which & std::ios::in) {
+            this->gbase = static_cast<size_t>(p);
+            setg(nullptr, nullptr, nullptr);
+        }
+        // Writes always append.
+        return pos;
+    }
+
+    bool BlockBuffer::save(const std::string& path) {
+    #if defined(_WIN32)
+        std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        if (this->spill != nullptr) {
+            std::rewind(this->spill);
+            this->window.resize(this->block_size);
+            size_t len;
+            while ((len = std::fread(this->window.data(), 1, this->window.size(), this->spill)) > 0) {
+                out.write(this->window.data(), len);
+            }
+        }
+        for (size_t i = 0; i < this->blocks.size(); i++) {
+            size_t len = i + 1 == this->blocks.size() ? this->tail : this->block_size;
+            out.write(this->blocks[i].get(), len);
+        }
+        return static_cast<bool>(out);
+    #else
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            return false;
+        }
+
+        auto write_all = [fd](const char* data, size_t len) {
+            while (len > 0) {
+                auto n = ::write(fd, data, len);
+                if (n < 0) {
+                    return false;
+                }
+                data += n;
+                len -= static_cast<size_t>(n);
+            }
+            return true;
+        };
+
+        bool ok = true;
+        if (this->spill != nullptr) {
+            std::fflush(this->spill);
+            std::rewind(this->spill);
+            this->window.resize(this->block_size);
+            size_t len;
+            while (ok && (len = std::fread(this->window.data(), 1, this->window.size(), this->spill)) > 0) {
+                ok = write_all(this->window.data(), len);
+            }
+        }
+
+        // Blocks go out with writev, IOV_MAX at a time.
+        std::vector<struct iovec> iov;
+        for (size_t i = 0; ok && i < this->blocks.size(); i++) {
+            size_t len = i + 1 == this->blocks.size() ? this->tail : this->block_size;
+            iov.push_back({this->blocks[i].get(), len});
+
+            if (iov.size() == IOV_MAX || i + 1 == this->blocks.size()) {
+                size_t expected = 0;
+                for (auto& v : iov) {
+                    expected += v.iov_len;
+                }
+                auto n = ::writev(fd, iov.data(), static_cast<int>(iov.size()));
+                if (n < 0) {
+                    ok = false;
+                } else if (static_cast<size_t>(n) < expected) {
+                    // Short write, finish the rest one by one.
+                    size_t done = static_cast<size_t>(n);
+                    for (auto& v : iov) {
+                        if (done >= v.iov_len) {
+                            done -= v.iov_len;
+                            continue;
+                        }
+                        ok = ok && write_all(static_cast<const char*>(v.iov_base) + done, v.iov_len - done);
+                        done = 0;
+                    }
+                }
+                iov.clear();
+            }
+        }
+
+        ::close(fd);
+        return ok;
+    #endif
+    }
+
+    File::File(const std::string& path, FileOpenType ot, size_t buffer_size) : buffer(&blocks) {
         this->path = path;
 
         this->opentype = ot;
@@ -67,19 +490,42 @@ namespace yoyo::fs {
             mode |= std::ios::app;
         }
 
-        this->stream = std::fstream(path, mode);
+        if (buffer_size > 0) {
+            // Must happen before opening.
+            this->stream_buffer.resize(buffer_size);
+            this->stream.rdbuf()->pubsetbuf(this->stream_buffer.data(), static_cast<std::streamsize>(buffer_size));
+        }
+        this->stream.open(path, mode);
         this->created = false;
     }
 
-    File::File() {
+    File::File(size_t block_size, size_t spill_threshold) : blocks(block_size, spill_threshold), buffer(&blocks) {
         this->created = true;
         FileOpenType ot = FileOpenType::Read | FileOpenType::Write | FileOpenType::Append;
         this->opentype = ot;
     }
 
+    std::iostream& File::io() {
+        if (this->created) {
+            return this->buffer;
+        }
+        return this->stream;
+    }
+
     pxs_VarT File::create(pxs_VarT args) {
+        size_t block_size = 64 * 1024;
+        size_t spill_threshold = 0;
+        auto bs_arg = pxs::Var::from_args(args, 0);
+        if ((bs_arg.is(pxs_Int64) || bs_arg.is(pxs_UInt64)) && bs_arg.get_int() > 0) {
+            block_size = static_cast<size_t>(bs_arg.get_int());
+        }
+        auto st_arg = pxs::Var::from_args(args, 1);
+        if ((st_arg.is(pxs_Int64) || st_arg.is(pxs_UInt64)) && st_arg.get_int() > 0) {
+            spill_threshold = static_cast<size_t>(st_arg.get_int());
+        }
+
         // create a file.
-        auto cfile = new File();
+        auto cfile = new File(block_size, spill_threshold);
         // wrap and return it.
         return create_file_object(cfile);
     }
@@ -89,13 +535,14 @@ namespace yoyo::fs {
         auto argc = pxs_argc(args);
         std::string path;
         FileOpenType ot = FileOpenType::Read;
+        size_t buffer_size = 0;
         if (argc >= 1) {
             // Get string path or return exception
             auto path_arg = pxs_arg(args, 0);
             if (path_arg && pxs_varis(path_arg, pxs_String)) {
-                auto path_c = pxs_getstring(path_arg);
-                path = std::string(path_c);
-                pxs_freestr(path_c);
+                size_t path_len = 0;
+                auto path_c = pxs_getstrview(path_arg, &path_len);
+                path = std::string(path_c, path_len);
             } else {
                 return pxs_newexception("Expected path:String");
             }
@@ -103,25 +550,39 @@ namespace yoyo::fs {
             if (argc >= 2) {
                 auto ot_arg = pxs_arg(args, 1);
                 auto ot_int = pxs_getint(ot_arg);
-                if (ot_int > 1) {
-                    return pxs_newexception("Expected valid FileReadType.");
+                auto all = FileOpenType::Read | FileOpenType::Write | FileOpenType::Append;
+                if (ot_int != -1 && (ot_int <= 0 || (ot_int & ~static_cast<int64_t>(all)) != 0)) {
+                    return pxs_newexception("Expected valid FileOpenType.");
                 }
                 if (ot_int != -1) {
                     ot = static_cast<FileOpenType>(ot_int);
                 }
             }
+            if (argc >= 3) {
+                auto bs_arg = pxs::Var::from_args(args, 2);
+                if ((bs_arg.is(pxs_Int64) || bs_arg.is(pxs_UInt64)) && bs_arg.get_int() > 0) {
+                    buffer_size = static_cast<size_t>(bs_arg.get_int());
+                }
+            }
         } else {
             return utils::exceptions::expected_nm(argc, 1);
         }
 
         // If the path does not exist, create it
-        if (!std::filesystem::exists(path)) {
+        if (!stat_cache().exists(path)) {
+            // Make sure the parent directory is there first.
+            std::error_code ec;
+            auto parent_path = std::filesystem::path(path).parent_path();
+            if (!parent_path.empty()) {
+                std::filesystem::create_directories(parent_path, ec);
+            }
             // Create the file
             std::ofstream blank(path);
+            stat_cache().invalidate(path);
         }
 
         // Create file
-        auto cfile = new File(path, ot);
+        auto cfile = new File(path, ot, buffer_size);
         return create_file_object(cfile);
     }
 
@@ -143,9 +604,16 @@ namespace yoyo::fs {
             rt = static_cast<FileReadType>(rt_arg.get_uint());
         }
 
+        if (rt == FileReadType::Mapped) {
+            if (self->created) {
+                return pxs_newexception("`File` was created, there is nothing to map.");
+            }
+            return MappedFile::read(self->path);
+        }
+
         // Get contents as bytes first.
         std::vector<char> contents(
-            (std::istreambuf_iterator<char>(self->stream)),
+            (std::istreambuf_iterator<char>(self->io())),
             std::istreambuf_iterator<char>());
 
         if (rt == FileReadType::Text) {
@@ -157,6 +625,151 @@ namespace yoyo::fs {
         }
     }
 
+    pxs_VarT File::read_chunk(pxs_VarT args) {
+        PXS_ARGC_GT(2); // self, size
+        auto self = static_cast<File*>(pxs_gettype(pxs_getrt(args), pxs_arg(args, 0), yoyo::types::FS_FILE_TYPE));
+        if (!self) {
+            return utils::exceptions::expected_self(PXS_ARG(0));
+        }
+
+        if (!(self->opentype & FileOpenType::Read)) {
+            return pxs_newexception("`File` was not opened with `FileOpenType.Read`.");
+        }
+
+        auto size_arg = pxs::Var::from_args(args, 1);
+        if (!size_arg.is(pxs_Int64) && !size_arg.is(pxs_UInt64)) {
+            return utils::exceptions::expected_types(size_arg.raw()->tag, {pxs_Int64, pxs_UInt64});
+        }
+        auto size = size_arg.get_int();
+        if (size <= 0) {
+            return pxs_newexception("Chunk size must be greater than 0.");
+        }
+
+        FileReadType rt = FileReadType::Text;
+        auto rt_arg = pxs::Var::from_args(args, 2);
+        if (rt_arg.is(pxs_Int64) || rt_arg.is(pxs_UInt64)) {
+            rt = rt_arg.to_enum<FileReadType>();
+        }
+
+        auto& io = self->io();
+        if (self->chunk.size() < static_cast<size_t>(size)) {
+            self->chunk.resize(static_cast<size_t>(size));
+        }
+        io.read(self->chunk.data(), size);
+        auto read = static_cast<size_t>(io.gcount());
+        if (read == 0) {
+            return pxs_newnull();
+        }
+        // A short read sets eof/fail, clear it so `seek` still works.
+        if (!io) {
+            io.clear();
+        }
+
+        if (rt == FileReadType::Text) {
+            return pxs_newstring(std::string(self->chunk.data(), read).c_str());
+        } else {
+            return pxs_newbytes(static_cast<pxs_Opaque>(self->chunk.data()), sizeof(char), read);
+        }
+    }
+
+    pxs_VarT File::readline(pxs_VarT args) {
+        PXS_ARGC_EQ(1); // self
+        auto self = static_cast<File*>(pxs_gettype(pxs_getrt(args), pxs_arg(args, 0), yoyo::types::FS_FILE_TYPE));
+        if (!self) {
+            return utils::exceptions::expected_self(PXS_ARG(0));
+        }
+
+        if (!(self->opentype & FileOpenType::Read)) {
+            return pxs_newexception("`File` was not opened with `FileOpenType.Read`.");
+        }
+
+        auto& io = self->io();
+        if (!std::getline(io, self->line)) {
+            io.clear();
+            return pxs_newnull();
+        }
+
+        // Handle CRLF files.
+        if (!self->line.empty() && self->line.back() == '\r') {
+            self->line.pop_back();
+        }
+
+        return pxs_newstring(self->line.c_str());
+    }
+
+#ifdef PXS_JSON
+    pxs_VarT File::read_json(pxs_VarT args) {
+        PXS_ARGC_GT(0); // self
+        auto self = static_cast<File*>(pxs_gettype(pxs_getrt(args), pxs_arg(args, 0), yoyo::types::FS_FILE_TYPE));
+        if (!self) {
+            return utils::exceptions::expected_self(PXS_ARG(0));
+        }
+
+        if (!(self->opentype & FileOpenType::Read)) {
+            return pxs_newexception("`File` was not opened with `FileOpenType.Read`.");
+        }
+
+        std::string pointer;
+        auto pointer_arg = pxs::Var::from_args(args, 1);
+        if (pointer_arg.is(pxs_String)) {
+            pointer = pointer_arg.get_string();
+        }
+
+        auto& io = self->io();
+        auto result = stream_json(io, pointer.c_str());
+        // Reading to the end sets eof/fail, clear it so `seek` still works.
+        io.clear();
+        return result;
+    }
+#endif
+
+    pxs_VarT File::seek(pxs_VarT args) {
+        PXS_ARGC_GT(2); // self, offset
+        auto self = static_cast<File*>(pxs_gettype(pxs_getrt(args), pxs_arg(args, 0), yoyo::types::FS_FILE_TYPE));
+        if (!self) {
+            return utils::exceptions::expected_self(PXS_ARG(0));
+        }
+
+        auto offset_arg = pxs::Var::from_args(args, 1);
+        if (!offset_arg.is(pxs_Int64) && !offset_arg.is(pxs_UInt64)) {
+            return utils::exceptions::expected_types(offset_arg.raw()->tag, {pxs_Int64, pxs_UInt64});
+        }
+
+        std::ios_base::seekdir dir = std::ios::beg;
+        auto from_arg = pxs::Var::from_args(args, 2);
+        if (from_arg.is(pxs_Int64) || from_arg.is(pxs_UInt64)) {
+            auto from = from_arg.to_enum<SeekFrom>();
+            if (from == SeekFrom::Current) {
+                dir = std::ios::cur;
+            } else if (from == SeekFrom::End) {
+                dir = std::ios::end;
+            } else if (from != SeekFrom::Start) {
+                return utils::exceptions::invalid_enum();
+            }
+        }
+
+        auto& io = self->io();
+        io.clear();
+        io.seekg(offset_arg.get_int(), dir);
+        io.seekp(io.tellg());
+        if (!io) {
+            io.clear();
+            return pxs_newexception("Could not seek `File`.");
+        }
+
+        return pxs_newint(static_cast<int64_t>(io.tellg()));
+    }
+
+    pxs_VarT File::tell(pxs_VarT args) {
+        PXS_ARGC_EQ(1); // self
+        auto self = static_cast<File*>(pxs_gettype(pxs_getrt(args), pxs_arg(args, 0), yoyo::types::FS_FILE_TYPE));
+        if (!self) {
+            return utils::exceptions::expected_self(PXS_ARG(0));
+        }
+
+        return pxs_newint(static_cast<int64_t>(self->io().tellg()));
+    }
+
     pxs_VarT File::write(pxs_VarT args) {
         PXS_ARGC_EQ(2); // self, data
         auto self = static_cast<File*>(pxs_gettype(pxs_getrt(args), pxs_arg(args, 0), yoyo::types::FS_FILE_TYPE));
@@ -168,31 +781,27 @@ namespace yoyo::fs {
             return pxs_newexception("`File` was not opened with `FileOpenType.Write`");
         }
 
-        // CHeck data
         auto data = pxs::Var::from_args(args, 1);
-        std::vector<char> bytes;
-
-        if (data.is(pxs_String)) {
-            auto str = data.get_string();
-            bytes = std::vector<char>(str.begin(), str.end());
-        } else if (data.is(pxs_List)) {
-            bytes.resize(pxs_varsize(data.raw()));
-            pxs_copybytes(data.raw(), static_cast<pxs_Opaque>(bytes.data()));
-        } else {
-            return utils::exceptions::expected_types(data.raw()->tag, {pxs_String, pxs_List});
+        if (!data.is(pxs_String) && !data.is(pxs_Buffer) && !data.is(pxs_List)) {
+            return utils::exceptions::expected_types(data.raw()->tag, {pxs_String, pxs_Buffer, pxs_List});
         }
 
-        // Check if path exists.
-        // If not, create it.
-        std::filesystem::path parent_path = std::filesystem::path(self->path).parent_path();
-        if (!std::filesystem::exists(parent_path)) {
-            auto res = pxs::call(create_dir, {parent_path.string(), static_cast<int>(CreateDirMode::All)});
-            if (pxs_varis(res, pxs_Exception)) {
-                return res;
+        if (!self->created) {
+            // Check if path exists.
+            // If not, create it.
+            std::filesystem::path parent_path = std::filesystem::path(self->path).parent_path();
+            if (!parent_path.empty() && !stat_cache().exists(parent_path.string())) {
+                auto res = pxs::call(create_dir, {parent_path.string(), static_cast<int64_t>(CreateDirMode::All)});
+                if (pxs_varis(res, pxs_Exception)) {
+                    return res;
+                }
             }
         }
 
-        self->stream.write(reinterpret_cast<const char*>(bytes.data(), bytes.size()), bytes.size());
+        auto err = write_var(self->io(), data.raw());
+        if (err != nullptr) {
+            return err;
+        }
 
         return pxs_newnull();
     }
@@ -208,20 +817,17 @@ namespace yoyo::fs {
             return pxs_newexception("`File` was not opened with `FileOpenType.Append`");
         }
 
-        // CHeck data
         auto data = pxs::Var::from_args(args, 1);
-        std::vector<char> bytes;
-
-        if (data.is(pxs_String)) {
-            auto str = data.get_string();
-            bytes = std::vector<char>(str.begin(), str.end());
-        } else if (data.is(pxs_List)) {
-            pxs_copybytes(data.raw(), static_cast<pxs_Opaque>(bytes.data()));
-        } else {
-            return utils::exceptions::expected_types(data.raw()->tag, {pxs_String, pxs_List});
+        if (!data.is(pxs_String) && !data.is(pxs_Buffer) && !data.is(pxs_List)) {
+            return utils::exceptions::expected_types(data.raw()->tag, {pxs_String, pxs_Buffer, pxs_List});
         }
 
-        self->stream.write(reinterpret_cast<const char*>(bytes.data(), bytes.size()), bytes.size());
+        auto& io = self->io();
+        io.seekp(0, std::ios::end);
+        auto err = write_var(io, data.raw());
+        if (err != nullptr) {
+            return err;
+        }
 
         return pxs_newnull();
     }
@@ -252,11 +858,13 @@ namespace yoyo::fs {
 
         if (self->created) {
             // reset buffer
+            self->blocks.reset();
             self->buffer.clear();
         } else {
             // remove file.
             std::error_code ec;
             std::filesystem::remove(self->path, ec);
+            stat_cache().invalidate(self->path);
 
             if (ec) {
                 return pxs_newexception(ec.message().c_str());
@@ -277,9 +885,11 @@ namespace yoyo::fs {
 
         if (self->created) {
             // Creates it automatically yo!
-            std::ofstream w(path_var.get_string(), std::ios::out);
-            w << self->buffer.rdbuf();
-            w.close();
+            auto saved = self->blocks.save(path_var.get_string());
+            stat_cache().invalidate(path_var.get_string());
+            if (!saved) {
+                return pxs_newexception("Could not save `File`.");
+            }
         }
 
         return pxs_newnull();
@@ -305,6 +915,487 @@ namespace yoyo::fs {
         return pxs_newint(static_cast<int>(self->opentype));
     }
 
+    // Read a whole file into `data` without touching any pxs vars. Safe to call from worker threads.
+    static bool read_native(const std::string& path, std::vector<char>& data) {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) {
+            return false;
+        }
+        auto size = static_cast<size_t>(in.tellg());
+        in.seekg(0);
+        data.resize(size);
+        in.read(data.data(), size);
+        data.resize(static_cast<size_t>(in.gcount()));
+        return true;
+    }
+
+    struct AsyncRead {
+        std::string path;
+        FileReadType read_type;
+        // Thread that started the read. Only it may touch the pxs vars below.
+        std::thread::id owner;
+
+        std::mutex lock;
+        std::condition_variable cv;
+        bool done = false;
+        bool ok = false;
+        std::vector<char> data;
+        std::string error;
+
+        // Owned, nullable.
+        pxs_VarT callback = nullptr;
+        // Owned, nullable.
+        pxs_VarT runtime = nullptr;
+
+        ~AsyncRead() {
+            if (callback != nullptr) {
+                pxs_freevar(callback);
+            }
+            if (runtime != nullptr) {
+                pxs_freevar(runtime);
+            }
+        }
+
+        // Convert the finished read into a pxs var.
+        pxs_VarT to_pxs() {
+            if (!ok) {
+                return pxs_newexception(error.c_str());
+            }
+            if (read_type == FileReadType::Text) {
+                return pxs_newstring(std::string(data.begin(), data.end()).c_str());
+            }
+            return pxs_newbytes(static_cast<pxs_Opaque>(data.data()), sizeof(char), data.size());
+        }
+    };
+
+    // Finished reads waiting for `pump`.
+    std::mutex completed_lock;
+    std::vector<std::shared_ptr<AsyncRead>> completed;
+
+    ReadHandle::ReadHandle(std::shared_ptr<AsyncRead> state) : state(std::move(state)) {}
+
+    // free a ReadHandle
+    void free_read_handle(pxs_Opaque obj) {
+        if (obj == nullptr) {
+            return;
+        }
+
+        delete static_cast<ReadHandle*>(obj);
+    }
+
+    pxs_VarT ReadHandle::get_done(pxs_VarT args) {
+        auto self = utils::pxs::get_type<ReadHandle>(args, 0, yoyo::types::FS_READ_HANDLE_TYPE);
+        if (!self) {
+            return utils::exceptions::expected_self(PXS_ARG(0));
+        }
+
+        std::lock_guard<std::mutex> guard(self->state->lock);
+        return pxs_newbool(self->state->done);
+    }
+
+    pxs_VarT ReadHandle::result(pxs_VarT args) {
+        auto self = utils::pxs::get_type<ReadHandle>(args, 0, yoyo::types::FS_READ_HANDLE_TYPE);
+        if (!self) {
+            return utils::exceptions::expected_self(PXS_ARG(0));
+        }
+
+        std::lock_guard<std::mutex> guard(self->state->lock);
+        if (!self->state->done) {
+            return pxs_newnull();
+        }
+        return self->state->to_pxs();
+    }
+
+    pxs_VarT ReadHandle::wait(pxs_VarT args) {
+        auto self = utils::pxs::get_type<ReadHandle>(args, 0, yoyo::types::FS_READ_HANDLE_TYPE);
+        if (!self) {
+            return utils::exceptions::expected_self(PXS_ARG(0));
+        }
+
+        std::unique_lock<std::mutex> guard(self->state->lock);
+        self->state->cv.wait(guard, [&] { return self->state->done; });
+        return self->state->to_pxs();
+    }
+
+    pxs_VarT read_async(pxs_VarT args) {
+        PXS_ARGC_GT(1); // path, read_type, callback
+        PXS_ARG_STRING_VAL(path, 0);
+
+        auto state = std::make_shared<AsyncRead>();
+        state->path = path;
+        state->read_type = FileReadType::Text;
+        state->owner = std::this_thread::get_id();
+
+        auto rt_arg = pxs::Var::from_args(args, 1);
+        if (rt_arg.is(pxs_Int64) || rt_arg.is(pxs_UInt64)) {
+            state->read_type = rt_arg.to_enum<FileReadType>();
+        }
+
+        auto cb_arg = pxs::Var::from_args(args, 2);
+        if (cb_arg.is(pxs_Function)) {
+            // Copying moves the language reference to our copy, keeping it alive.
+            state->callback = pxs_newcopy(cb_arg.raw());
+            state->runtime = pxs_newcopy(pxs_getrt(args));
+        } else if (!cb_arg.is(pxs_Null)) {
+            return utils::exceptions::expected_types(cb_arg.raw()->tag, {pxs_Function, pxs_Null});
+        }
+
+        auto handle = new ReadHandle(state);
+
+        utils::pool::shared().submit([state]() mutable {
+            {
+                std::lock_guard<std::mutex> guard(state->lock);
+                state->ok = read_native(state->path, state->data);
+                if (!state->ok) {
+                    state->error = "Could not open file: " + state->path;
+                }
+                state->done = true;
+            }
+            state->cv.notify_all();
+
+            // Without vars, our reference (and the data with it) can go here.
+            if (state->callback == nullptr && state->runtime == nullptr) {
+                return;
+            }
+            // Hand our reference to the pump so the vars are freed on the owner thread.
+            std::lock_guard<std::mutex> guard(completed_lock);
+            completed.push_back(std::move(state));
+        });
+
+        return read_handle_class->make(handle, free_read_handle).raw();
+    }
+
+    pxs_VarT read_files(pxs_VarT args) {
+        PXS_ARGC_GT(1); // paths, read_type
+        auto paths_arg = pxs::Var::from_args(args, 0);
+        if (!paths_arg.is(pxs_List)) {
+            return utils::exceptions::expected_type(paths_arg.raw()->tag, pxs_List);
+        }
+
+        struct Entry {
+            std::string path;
+            bool ok = false;
+            std::vector<char> data;
+        };
+
+        std::vector<Entry> entries;
+        entries.reserve(paths_arg.list_len());
+        for (int i = 0; i < paths_arg.list_len(); i++) {
+            auto p = paths_arg.list_get(i);
+            if (!p.is(pxs_String)) {
+                return utils::exceptions::expected_type(p.raw()->tag, pxs_String);
+            }
+            entries.push_back({p.get_string(), false, {}});
+        }
+
+        FileReadType read_type = FileReadType::Text;
+        auto rt_arg = pxs::Var::from_args(args, 1);
+        if (rt_arg.is(pxs_Int64) || rt_arg.is(pxs_UInt64)) {
+            read_type = rt_arg.to_enum<FileReadType>();
+        }
+
+        // Fan out on the shared pool and wait for every read.
+        std::mutex lock;
+        std::condition_variable cv;
+        size_t remaining = entries.size();
+        for (auto& entry : entries) {
+            utils::pool::shared().submit([&entry, &lock, &cv, &remaining]() {
+                entry.ok = read_native(entry.path, entry.data);
+                std::lock_guard<std::mutex> guard(lock);
+                if (--remaining == 0) {
+                    cv.notify_one();
+                }
+            });
+        }
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            cv.wait(guard, [&] { return remaining == 0; });
+        }
+
+        // Only now, back on the calling thread, create vars.
+        auto map = pxs_newmap();
+        for (auto& entry : entries) {
+            pxs_VarT value;
+            if (!entry.ok) {
+                value = pxs_newexception(("Could not open file: " + entry.path).c_str());
+            } else if (read_type == FileReadType::Text) {
+                value = pxs_newstring(std::string(entry.data.begin(), entry.data.end()).c_str());
+            } else {
+                value = pxs_newbytes(static_cast<pxs_Opaque>(entry.data.data()), sizeof(char), entry.data.size());
+            }
+            pxs_map_addpair(map, pxs_newstring(entry.path.c_str()), value);
+        }
+        return map;
+    }
+
+    int pump() {
+        int handled = watch_pump();
+        std::vector<std::shared_ptr<AsyncRead>> mine;
+        {
+            std::lock_guard<std::mutex> guard(completed_lock);
+            auto me = std::this_thread::get_id();
+            auto it = std::stable_partition(completed.begin(), completed.end(), [&](const std::shared_ptr<AsyncRead>& s) {
+                return s->owner != me;
+            });
+            std::move(it, completed.end(), std::back_inserter(mine));
+            completed.erase(it, completed.end());
+        }
+
+        for (auto& state : mine) {
+            if (state->callback == nullptr) {
+                continue;
+            }
+
+            auto cb_args = pxs_newlist();
+            pxs_listadd(cb_args, state->to_pxs());
+            auto res = pxs_varcall(state->runtime, state->callback, cb_args);
+            if (res != nullptr) {
+                pxs_freevar(res);
+            }
+        }
+
+        return handled + static_cast<int>(mine.size());
+    }
+
+    void FileCache::erase(std::list<Entry>::iterator it) {
+        this->bytes -= it->contents.size();
+        this->index.erase(it->path);
+        this->lru.erase(it);
+    }
+
+    void FileCache::evict() {
+        while (this->bytes > this->budget && !this->lru.empty()) {
+            erase(std::prev(this->lru.end()));
+        }
+    }
+
+    void FileCache::set_budget(size_t budget) {
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->budget = budget;
+        evict();
+    }
+
+    bool FileCache::read(const std::string& path, std::string& out) {
+        std::error_code ec;
+        auto size = std::filesystem::file_size(path, ec);
+        if (ec) {
+            invalidate(path);
+            return false;
+        }
+        auto mtime = static_cast<int64_t>(std::filesystem::last_write_time(path, ec).time_since_epoch().count());
+        if (ec) {
+            invalidate(path);
+            return false;
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(this->lock);
+            auto found = this->index.find(path);
+            if (found != this->index.end()) {
+                auto it = found->second;
+                if (it->mtime == mtime && it->size == size) {
+                    this->hits++;
+                    // Move to front
+                    this->lru.splice(this->lru.begin(), this->lru, it);
+                    out = it->contents;
+                    return true;
+                }
+                // Stale
+                erase(it);
+            }
+            this->misses++;
+        }
+
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            return false;
+        }
+        std::string contents(size, '\0');
+        in.read(contents.data(), size);
+        contents.resize(static_cast<size_t>(in.gcount()));
+        out = contents;
+
+        std::lock_guard<std::mutex> guard(this->lock);
+        if (contents.size() > this->budget || this->index.count(path) != 0) {
+            // Too big to keep, or someone beat us to it.
+            return true;
+        }
+        this->bytes += contents.size();
+        this->lru.push_front({path, std::move(contents), mtime, size});
+        this->index[path] = this->lru.begin();
+        evict();
+        return true;
+    }
+
+    void FileCache::invalidate(const std::string& path) {
+        std::lock_guard<std::mutex> guard(this->lock);
+        auto found = this->index.find(path);
+        if (found != this->index.end()) {
+            erase(found->second);
+        }
+    }
+
+    void FileCache::clear() {
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->lru.clear();
+        this->index.clear();
+        this->bytes = 0;
+    }
+
+    pxs_VarT FileCache::stats() {
+        std::lock_guard<std::mutex> guard(this->lock);
+        auto map = pxs_newmap();
+        pxs_map_addpair(map, pxs_newstring("hits"), pxs_newuint(this->hits));
+        pxs_map_addpair(map, pxs_newstring("misses"), pxs_newuint(this->misses));
+        pxs_map_addpair(map, pxs_newstring("bytes"), pxs_newuint(this->bytes));
+        pxs_map_addpair(map, pxs_newstring("entries"), pxs_newuint(this->index.size()));
+        return map;
+    }
+
+    FileCache& file_cache() {
+        static FileCache cache;
+        return cache;
+    }
+
+    pxs_VarT cached_reader(const char* path) {
+        if (path == nullptr) {
+            return pxs_newnull();
+        }
+
+        std::string contents;
+        if (!file_cache().read(path, contents)) {
+            return pxs_newnull();
+        }
+        return pxs_newstring(contents.c_str());
+    }
+
+    void use_file_cache(size_t budget) {
+        file_cache().set_budget(budget);
+        pxs_set_filereader(cached_reader);
+    }
+
+    pxs_VarT invalidate_cache(pxs_VarT args) {
+        auto path = pxs::Var::from_args(args, 0);
+        if (path.is(pxs_String)) {
+            file_cache().invalidate(path.get_string());
+        } else {
+            file_cache().clear();
+        }
+        return pxs_newnull();
+    }
+
+    pxs_VarT cache_stats(pxs_VarT /*args*/) {
+        return file_cache().stats();
+    }
+
+    // Normalize so `a/b` and `a/./b/` share an entry.
+    static std::string stat_key(const std::string& path) {
+        auto key = std::filesystem::path(path).lexically_normal().generic_string();
+        while (key.size() > 1 && key.back() == '/') {
+            key.pop_back();
+        }
+        return key;
+    }
+
+    StatCache::Stat StatCache::lookup(const std::string& path) {
+        auto now = std::chrono::steady_clock::now();
+        std::string key;
+        {
+            std::lock_guard<std::mutex> guard(this->lock);
+            if (this->ttl.count() > 0) {
+                key = stat_key(path);
+                auto found = this->entries.find(key);
+                if (found != this->entries.end() && now - found->second.at < this->ttl) {
+                    return found->second;
+                }
+            }
+        }
+
+        std::error_code ec;
+        auto status = std::filesystem::status(path, ec);
+        Stat stat{std::filesystem::exists(status), std::filesystem::is_directory(status), now};
+
+        std::lock_guard<std::mutex> guard(this->lock);
+        if (this->ttl.count() > 0 && !key.empty()) {
+            this->entries[key] = stat;
+        }
+        return stat;
+    }
+
+    void StatCache::set_ttl(int64_t ttl_ms) {
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->ttl = std::chrono::milliseconds(std::max<int64_t>(0, ttl_ms));
+        if (this->ttl.count() == 0) {
+            this->entries.clear();
+        }
+    }
+
+    bool StatCache::exists(const std::string& path) {
+        return lookup(path).exists;
+    }
+
+    bool StatCache::is_dir(const std::string& path) {
+        return lookup(path).is_dir;
+    }
+
+    void StatCache::invalidate(const std::string& path) {
+        std::lock_guard<std::mutex> guard(this->lock);
+        if (this->entries.empty()) {
+            return;
+        }
+
+        auto key = stat_key(path);
+        // The path and everything under it.
+        auto it = this->entries.lower_bound(key);
+        while (it != this->entries.end() && it->first.compare(0, key.size(), key) == 0) {
+            if (it->first.size() == key.size() || it->first[key.size()] == '/') {
+                it = this->entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        // Parents may have been created along the way.
+        auto parent = std::filesystem::path(key).parent_path();
+        while (!parent.empty()) {
+            this->entries.erase(parent.generic_string());
+            if (parent == parent.parent_path()) {
+                break;
+            }
+            parent = parent.parent_path();
+        }
+    }
+
+    void StatCache::clear() {
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->entries.clear();
+    }
+
+    StatCache& stat_cache() {
+        static StatCache cache;
+        return cache;
+    }
+
+    pxs_VarT cache_stat(pxs_VarT args) {
+        PXS_ARGC_EQ(1); // ttl_ms
+        auto ttl = pxs::Var::from_args(args, 0);
+        if (!ttl.is(pxs_Int64) && !ttl.is(pxs_UInt64)) {
+            return utils::exceptions::expected_type(ttl.raw()->tag, pxs_Int64);
+        }
+
+        stat_cache().set_ttl(ttl.get_int());
+        return pxs_newnull();
+    }
+
+    pxs_VarT refresh_stat(pxs_VarT args) {
+        auto path = pxs::Var::from_args(args, 0);
+        if (path.is(pxs_String)) {
+            stat_cache().invalidate(path.get_string());
+        } else {
+            stat_cache().clear();
+        }
+        return pxs_newnull();
+    }
+
     pxs_VarT read_file(pxs_VarT args) {
         PXS_ARGC_GT(0); // at least path.
         auto path = pxs::Var::from_args(args, 0);
@@ -314,6 +1405,11 @@ namespace yoyo::fs {
             return utils::exceptions::expected_types(read_type.raw()->tag, {pxs_Int64, pxs_UInt64});            
         }
 
+        // Mapped reads don't need a stream at all.
+        if (read_type.to_enum<FileReadType>() == FileReadType::Mapped) {
+            return MappedFile::read(path.get_string());
+        }
+
         // open file
         auto file = pxs::Var(pxs::call(&File::open, {path.shallow().raw()}));
         if (!file.is(pxs_HostObject)) {
@@ -322,9 +1418,44 @@ namespace yoyo::fs {
         }
 
         // This will automatically drop file.
-        return pxs::call(&File::read, {file.raw(), path.shallow().raw(), read_type.shallow().raw()});
+        return pxs::call(&File::read, {file.raw(), read_type.shallow().raw()});
     }
 
+#ifdef PXS_JSON
+    pxs_VarT stream_json(std::istream& in, const char* pointer) {
+        auto stream = pxs_json_newstream(pointer);
+        std::vector<char> chunk(64 * 1024);
+        while (in) {
+            in.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+            auto read = static_cast<size_t>(in.gcount());
+            // A failed feed keeps its error for `pxs_json_finish`.
+            if (read == 0 || !pxs_json_feed(stream, chunk.data(), read)) {
+                break;
+            }
+        }
+        return pxs_json_finish(stream);
+    }
+
+    pxs_VarT read_json(pxs_VarT args) {
+        PXS_ARGC_GT(0); // at least path.
+        auto path = pxs::Var::from_args(args, 0);
+        PXS_ARG_IS_TYPE(path.raw(), pxs_String);
+
+        std::string pointer;
+        auto pointer_arg = pxs::Var::from_args(args, 1);
+        if (pointer_arg.is(pxs_String)) {
+            pointer = pointer_arg.get_string();
+        }
+
+        auto path_str = path.get_string();
+        std::ifstream in(path_str, std::ios::binary);
+        if (!in) {
+            return pxs_newexception(("Could not open " + path_str).c_str());
+        }
+        return stream_json(in, pointer.c_str());
+    }
+#endif
+
     pxs_VarT read_dir(pxs_VarT args) {
         auto path = pxs::Var::from_args(args, 0);
         PXS_ARG_IS_TYPE(path.raw(), pxs_String);
@@ -333,7 +1464,7 @@ namespace yoyo::fs {
         if (!std::filesystem::exists(dpath)) {
             return pxs_newexception("Directory does not exist.");
         }
-        if (std::filesystem::is_directory(dpath)) {
+        if (!std::filesystem::is_directory(dpath)) {
             return pxs_newexception("Path is not a directory.");
         }
         auto list = pxs::Var::new_list();
@@ -344,18 +1475,299 @@ namespace yoyo::fs {
         return list.raw();
     }
 
+    bool scan_entries(const std::string& path, bool with_meta, std::vector<DirEntry>& entries, std::string& error) {
+    #if defined(_WIN32)
+        auto pattern = utils::str::to_wstring(path);
+        if (!pattern.empty() && pattern.back() != L'\\' && pattern.back() != L'/') {
+            pattern += L'\\';
+        }
+        pattern += L'*';
+
+        WIN32_FIND_DATAW data;
+        HANDLE find = FindFirstFileExW(pattern.c_str(), FindExInfoBasic, &data, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+        if (find == INVALID_HANDLE_VALUE) {
+            error = "Could not open directory: " + path;
+            return false;
+        }
+
+        do {
+            std::wstring_view wname(data.cFileName);
+            if (wname == L"." || wname == L"..") {
+                continue;
+            }
+
+            DirEntry entry;
+            entry.name = utils::str::from_wstring(wname);
+            if (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) {
+                entry.type = EntryType::Symlink;
+            } else if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+                entry.type = EntryType::Dir;
+            } else {
+                entry.type = EntryType::File;
+            }
+            entry.size = 0;
+            entry.mtime = -1;
+            if (with_meta) {
+                // Find data already carries it, no extra calls needed.
+                if (entry.type != EntryType::Dir) {
+                    entry.size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+                }
+                uint64_t ft = (static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+                // 100ns ticks since 1601 -> seconds since 1970
+                entry.mtime = static_cast<int64_t>((ft - 116444736000000000ULL) / 10000000ULL);
+            }
+            entries.push_back(std::move(entry));
+        } while (FindNextFileW(find, &data));
+
+        FindClose(find);
+        return true;
+    #else
+        DIR* dir = opendir(path.c_str());
+        if (dir == nullptr) {
+            error = "Could not open directory: " + path;
+            return false;
+        }
+        int fd = dirfd(dir);
+
+        while (auto ent = readdir(dir)) {
+            const char* name = ent->d_name;
+            if (std::strcmp(name, ".") == 0 || std::strcmp(name, "..") == 0) {
+                continue;
+            }
+
+            DirEntry entry;
+            entry.name = name;
+            entry.size = 0;
+            entry.mtime = -1;
+
+            bool known_type = true;
+            switch (ent->d_type) {
+                case DT_REG: entry.type = EntryType::File; break;
+                case DT_DIR: entry.type = EntryType::Dir; break;
+                case DT_LNK: entry.type = EntryType::Symlink; break;
+                case DT_UNKNOWN: known_type = false; entry.type = EntryType::Other; break;
+                default: entry.type = EntryType::Other; break;
+            }
+
+            // Only stat when we have to.
+            if (with_meta || !known_type) {
+                struct stat st;
+                if (fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) == 0) {
+                    if (!known_type) {
+                        if (S_ISREG(st.st_mode)) {
+                            entry.type = EntryType::File;
+                        } else if (S_ISDIR(st.st_mode)) {
+                            entry.type = EntryType::Dir;
+                        } else if (S_ISLNK(st.st_mode)) {
+                            entry.type = EntryType::Symlink;
+                        }
+                    }
+                    if (with_meta) {
+                        if (entry.type != EntryType::Dir) {
+                            entry.size = static_cast<uint64_t>(st.st_size);
+                        }
+                        entry.mtime = static_cast<int64_t>(st.st_mtime);
+                    }
+                }
+            }
+            entries.push_back(std::move(entry));
+        }
+
+        closedir(dir);
+        return true;
+    #endif
+    }
+
+    // Convert a `DirEntry` into a `pxs_Map`.
+    pxs_VarT entry_to_map(const DirEntry& entry) {
+        auto map = pxs_newmap();
+        pxs_map_addpair(map, pxs_newstring("name"), pxs_newstring(entry.name.c_str()));
+        pxs_map_addpair(map, pxs_newstring("type"), pxs_newint(static_cast<int>(entry.type)));
+        pxs_map_addpair(map, pxs_newstring("size"), pxs_newuint(entry.size));
+        pxs_map_addpair(map, pxs_newstring("mtime"), pxs_newint(entry.mtime));
+        return map;
+    }
+
+    pxs_VarT scan_dir(pxs_VarT args) {
+        PXS_ARGC_GT(1); // path, with_meta
+        PXS_ARG_STRING_VAL(path, 0);
+        auto with_meta_arg = pxs::Var::from_args(args, 1);
+        bool with_meta = true;
+        if (with_meta_arg.is(pxs_Bool)) {
+            with_meta = with_meta_arg.get_bool();
+        }
+
+        std::vector<DirEntry> entries;
+        std::string error;
+        if (!scan_entries(path, with_meta, entries, error)) {
+            return pxs_newexception(error.c_str());
+        }
+
+        auto list = pxs_newlist_with_capacity(entries.size());
+        for (const auto& entry : entries) {
+            pxs_listadd(list, entry_to_map(entry));
+        }
+        return list;
+    }
+
+    pxs_VarT walk(pxs_VarT args) {
+        PXS_ARGC_GT(1); // root, filter, max_depth, threads
+        PXS_ARG_STRING_VAL(root, 0);
+        if (!std::filesystem::is_directory(root)) {
+            return pxs_newexception("Path is not a directory.");
+        }
+
+        std::vector<std::string> filters;
+        auto filter_arg = pxs::Var::from_args(args, 1);
+        if (filter_arg.is(pxs_String)) {
+            filters.push_back(filter_arg.get_string());
+        } else if (filter_arg.is(pxs_List)) {
+            for (int i = 0; i < filter_arg.list_len(); i++) {
+                auto f = filter_arg.list_get(i);
+                if (!f.is(pxs_String)) {
+                    return utils::exceptions::expected_type(f.raw()->tag, pxs_String);
+                }
+                filters.push_back(f.get_string());
+            }
+        } else if (!filter_arg.is(pxs_Null)) {
+            return utils::exceptions::expected_types(filter_arg.raw()->tag, {pxs_String, pxs_List, pxs_Null});
+        }
+
+        int64_t max_depth = -1;
+        auto depth_arg = pxs::Var::from_args(args, 2);
+        if (depth_arg.is(pxs_Int64) || depth_arg.is(pxs_UInt64)) {
+            max_depth = depth_arg.get_int();
+        }
+
+        size_t threads = std::max(1u, std::thread::hardware_concurrency());
+        auto threads_arg = pxs::Var::from_args(args, 3);
+        if ((threads_arg.is(pxs_Int64) || threads_arg.is(pxs_UInt64)) && threads_arg.get_int() > 0) {
+            threads = static_cast<size_t>(threads_arg.get_int());
+        }
+
+        struct Work {
+            std::string rel;
+            int64_t depth;
+        };
+        struct Found {
+            std::string rel;
+            DirEntry entry;
+        };
+
+        std::mutex lock;
+        std::condition_variable cv;
+        std::deque<Work> queue = {{"", 0}};
+        // Directories queued or being scanned.
+        size_t pending = 1;
+        std::vector<Found> found;
+        std::string first_error;
+
+        auto worker = [&]() {
+            std::vector<DirEntry> entries;
+            std::vector<Found> local;
+            std::string error;
+            while (true) {
+                Work work;
+                {
+                    std::unique_lock<std::mutex> guard(lock);
+                    cv.wait(guard, [&] { return !queue.empty() || pending == 0; });
+                    if (queue.empty()) {
+                        break;
+                    }
+                    work = std::move(queue.front());
+                    queue.pop_front();
+                }
+
+                entries.clear();
+                std::string dir_path = work.rel.empty() ? root : root + "/" + work.rel;
+                bool ok = scan_entries(dir_path, true, entries, error);
+
+                std::vector<Work> subdirs;
+                for (auto& entry : entries) {
+                    std::string rel = work.rel.empty() ? entry.name : work.rel + "/" + entry.name;
+                    if (entry.type == EntryType::Dir) {
+                        if (max_depth < 0 || work.depth < max_depth) {
+                            subdirs.push_back({rel, work.depth + 1});
+                        }
+                        if (filters.empty()) {
+                            local.push_back({rel, std::move(entry)});
+                        }
+                        continue;
+                    }
+
+                    bool matches = filters.empty();
+                    for (const auto& f : filters) {
+                        if (utils::str::glob_match(f, entry.name)) {
+                            matches = true;
+                            break;
+                        }
+                    }
+                    if (matches) {
+                        local.push_back({rel, std::move(entry)});
+                    }
+                }
+
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    if (!ok && first_error.empty()) {
+                        first_error = error;
+                    }
+                    for (auto& sd : subdirs) {
+                        queue.push_back(std::move(sd));
+                    }
+                    pending += subdirs.size();
+                    pending--;
+                }
+                cv.notify_all();
+            }
+
+            std::lock_guard<std::mutex> guard(lock);
+            for (auto& f : local) {
+                found.push_back(std::move(f));
+            }
+        };
+
+    #ifdef YOYO_NO_THREADS
+        worker();
+    #else
+        std::vector<std::thread> pool;
+        pool.reserve(threads);
+        for (size_t i = 0; i < threads; i++) {
+            pool.emplace_back(worker);
+        }
+        for (auto& t : pool) {
+            t.join();
+        }
+    #endif
+
+        if (!first_error.empty()) {
+            return pxs_newexception(first_error.c_str());
+        }
+
+        std::sort(found.begin(), found.end(), [](const Found& a, const Found& b) { return a.rel < b.rel; });
+
+        // pxs vars are only created on the calling thread.
+        auto list = pxs_newlist_with_capacity(found.size());
+        for (const auto& f : found) {
+            auto map = entry_to_map(f.entry);
+            pxs_map_addpair(map, pxs_newstring("path"), pxs_newstring(f.rel.c_str()));
+            pxs_listadd(list, map);
+        }
+        return list;
+    }
+
     pxs_VarT write_file(pxs_VarT args) {
         PXS_ARGC_EQ(2); // path, data
         auto path = pxs::Var::from_args(args, 0);
         PXS_ARG_IS_TYPE(path.raw(), pxs_String);
 
         auto data = pxs::Var::from_args(args, 1);
-        if (!data.is(pxs_String) && !data.is(pxs_List)) {
-            return utils::exceptions::expected_types(data.raw()->tag, {pxs_String, pxs_List});
+        if (!data.is(pxs_String) && !data.is(pxs_Buffer) && !data.is(pxs_List)) {
+            return utils::exceptions::expected_types(data.raw()->tag, {pxs_String, pxs_Buffer, pxs_List});
         }
 
         // Open the file
-        auto file = pxs::Var(pxs::call(&File::open, {path.shallow().raw()}));
+        auto file = pxs::Var(pxs::call(&File::open, {path.shallow().raw(), static_cast<int64_t>(FileOpenType::Write)}));
         if (!file.is(pxs_HostObject)) {
             return file.raw();
         }
@@ -363,11 +1775,8 @@ namespace yoyo::fs {
         return pxs::call(&File::write, {file.raw(), data.shallow().raw()});
     }
 
-    pxs_VarT exists(pxs_VarT args) {
-        PXS_ARGC_EQ(1); // path
-        PXS_ARG_STRING_VAL(path, 0);
-        
-        return pxs_newbool(std::filesystem::exists(path));
+    bool exists(const std::string& path) {
+        return stat_cache().exists(path);
     }
 
     pxs_VarT remove_dir(pxs_VarT args) {
@@ -386,6 +1795,7 @@ namespace yoyo::fs {
         } else {
             return pxs_newexception("Please provide a valid remove type.");
         }
+        stat_cache().invalidate(path);
 
         return pxs_newnull();
     }
@@ -395,6 +1805,7 @@ namespace yoyo::fs {
         PXS_ARG_STRING_VAL(path, 0);
         std::error_code ec;
         std::filesystem::remove(path, ec);
+        stat_cache().invalidate(path);
 
         if (ec) {
             return pxs_newexception(ec.message().c_str());
@@ -416,6 +1827,7 @@ namespace yoyo::fs {
         } else {
             return pxs_newexception("Please provide a valid createmode.");
         }
+        stat_cache().invalidate(path);
 
         if (ec) {
             return pxs_newexception(ec.message().c_str());
@@ -424,28 +1836,60 @@ namespace yoyo::fs {
         return pxs_newnull();
     }
 
-    pxs_VarT is_dir(pxs_VarT args) {
-        PXS_ARGC_EQ(1); // path
-        PXS_ARG_STRING_VAL(path, 0);
-        return pxs_newbool(std::filesystem::is_directory(path));
+    bool is_dir(const std::string& path) {
+        return stat_cache().is_dir(path);
     }
 
     // Initialize the `yoyo.fs` module.
     void init(pxs_Module* yoyo) {
+        file_class.emplace("File", yoyo::types::FS_FILE_TYPE);
+        file_class->add_method("read", &File::read);
+        file_class->add_method("read_chunk", &File::read_chunk);
+        file_class->add_method("readline", &File::readline);
+    #ifdef PXS_JSON
+        file_class->add_method("read_json", &File::read_json);
+    #endif
+        file_class->add_method("seek", &File::seek);
+        file_class->add_method("tell", &File::tell);
+        file_class->add_method("write", &File::write);
+        file_class->add_method("append", &File::append);
+        file_class->add_method("close", &File::close);
+        file_class->add_method("remove", &File::remove);
+        file_class->add_method("save", &File::save);
+        file_class->add_property("path", &File::get_path);
+        file_class->add_property("open_type", &File::get_open_type);
+
+        read_handle_class.emplace("ReadHandle", yoyo::types::FS_READ_HANDLE_TYPE);
+        read_handle_class->add_property("done", &ReadHandle::get_done);
+        read_handle_class->add_method("result", &ReadHandle::result);
+        read_handle_class->add_method("wait", &ReadHandle::wait);
+
         auto _fs = pxs_newmod("fs");
 
         pxs_addfunc(_fs, "read_file", read_file);
+    #ifdef PXS_JSON
+        pxs_addfunc(_fs, "read_json", read_json);
+    #endif
         pxs_addfunc(_fs, "write_file", write_file);
         pxs_addfunc(_fs, "read_dir", read_dir);
-        pxs_addfunc(_fs, "exists", exists);
+        pxs_addfunc(_fs, "scan_dir", scan_dir);
+        pxs_addfunc(_fs, "walk", walk);
+        pxs_addfunc(_fs, "read_async", read_async);
+        pxs_addfunc(_fs, "read_files", read_files);
+        pxs_addfunc(_fs, "invalidate_cache", invalidate_cache);
+        pxs_addfunc(_fs, "cache_stats", cache_stats);
+        pxs_addfunc(_fs, "cache_stat", cache_stat);
+        pxs_addfunc(_fs, "refresh_stat", refresh_stat);
+        pxs_addfunc(_fs, "exists", pxs::bind<&exists>());
         pxs_addfunc(_fs, "remove_dir", remove_dir);
         pxs_addfunc(_fs, "remove_file", remove_file);
         pxs_addfunc(_fs, "create_dir", create_dir);
-        pxs_addfunc(_fs, "is_dir", is_dir);
+        pxs_addfunc(_fs, "is_dir", pxs::bind<&is_dir>());
         pxs_addfunc(_fs, "create", &File::create);
         pxs_addfunc(_fs, "open", &File::open);
         pxs_addvar(_fs, "FILE_READ_TYPE_TEXT", pxs_newint(static_cast<int>(FileReadType::Text)));
         pxs_addvar(_fs, "FILE_READ_TYPE_BYTES", pxs_newint(static_cast<int>(FileReadType::Bytes)));
+        pxs_addvar(_fs, "FILE_READ_TYPE_MAPPED", pxs_newint(static_cast<int>(FileReadType::Mapped)));
         pxs_addvar(_fs, "CREATE_DIR_MODE_ALL", pxs_newint(static_cast<int>(CreateDirMode::All)));
         pxs_addvar(_fs, "CREATE_DIR_MODE_SINGLE", pxs_newint(static_cast<int>(CreateDirMode::Single)));
         pxs_addvar(_fs, "DIR_REMOVE_TYPE_EMPTY", pxs_newint(static_cast<int>(DirRemoveType::Empty)));
@@ -453,6 +1897,14 @@ namespace yoyo::fs {
         pxs_addvar(_fs, "FILE_OPEN_TYPE_READ", pxs_newint(static_cast<int>(FileOpenType::Read)));
         pxs_addvar(_fs, "FILE_OPEN_TYPE_WRITE", pxs_newint(static_cast<int>(FileOpenType::Write)));
         pxs_addvar(_fs, "FILE_OPEN_TYPE_APPEND", pxs_newint(static_cast<int>(FileOpenType::Append)));
+        pxs_addvar(_fs, "ENTRY_TYPE_FILE", pxs_newint(static_cast<int>(EntryType::File)));
+        pxs_addvar(_fs, "ENTRY_TYPE_DIR", pxs_newint(static_cast<int>(EntryType::Dir)));
+        pxs_addvar(_fs, "ENTRY_TYPE_SYMLINK", pxs_newint(static_cast<int>(EntryType::Symlink)));
+        pxs_addvar(_fs, "ENTRY_TYPE_OTHER", pxs_newint(static_cast<int>(EntryType::Other)));
+        pxs_addvar(_fs, "SEEK_FROM_START", pxs_newint(static_cast<int>(SeekFrom::Start)));
+        pxs_addvar(_fs, "SEEK_FROM_CURRENT", pxs_newint(static_cast<int>(SeekFrom::Current)));
+        pxs_addvar(_fs, "SEEK_FROM_END", pxs_newint(static_cast<int>(SeekFrom::End)));
+        init_watch(_fs);
 
         pxs_add_submod(yoyo, _fs);
     }
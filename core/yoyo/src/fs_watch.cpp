@@ -0,0 +1,781 @@
+#ifdef YOYO_FS
+
+#include "fs.hpp"
+#include <pixelscript_cpp.hpp>
+#include "utils/types.hpp"
+#include "utils/pxs.hpp"
+#include "utils/exceptions.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__APPLE__)
+#include <TargetConditionals.h>
+#endif
+
+#if defined(_WIN32)
+#include <windows.h>
+#include "utils/strutils.hpp"
+#elif defined(__APPLE__) && TARGET_OS_OSX
+#include <CoreServices/CoreServices.h>
+#include <dispatch/dispatch.h>
+#elif defined(__linux__)
+#include <sys/inotify.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <climits>
+#endif
+
+namespace yoyo::fs {
+    namespace watching {
+        using Clock = std::chrono::steady_clock;
+
+        struct Change {
+            std::string path;
+            WatchEvent kind;
+            // False once the change cancelled itself out, see `ChangeQueue::push`.
+            bool live = true;
+        };
+
+        // Changes not taken yet, one per path in the order the paths first changed.
+        // Filled by the native thread, emptied by the owner one.
+        class ChangeQueue {
+            std::mutex lock;
+            std::vector<Change> order;
+            std::unordered_map<std::string, size_t> index;
+            size_t live = 0;
+            bool overflowed = false;
+            Clock::time_point first;
+            // A burst (a checkout, `rm -r`) bigger than this is reported as one `Overflow`.
+            static constexpr size_t MAX_CHANGES = 65536;
+
+            void reset() {
+                this->order.clear();
+                this->index.clear();
+                this->live = 0;
+                this->overflowed = false;
+            }
+
+        public:
+            // The watched path, reported on `Overflow`.
+            std::string root;
+
+            void push(const std::string& path, WatchEvent kind) {
+                std::lock_guard<std::mutex> guard(this->lock);
+                if (this->overflowed) {
+                    return;
+                }
+                if (this->live == 0) {
+                    this->first = Clock::now();
+                }
+
+                auto found = this->index.find(path);
+                if (found == this->index.end()) {
+                    if (this->order.size() >= MAX_CHANGES || kind == WatchEvent::Overflow) {
+                        this->reset();
+                        this->overflowed = true;
+                        this->order.push_back({this->root, WatchEvent::Overflow});
+                        this->live = 1;
+                        return;
+                    }
+                    this->index.emplace(path, this->order.size());
+                    this->order.push_back({path, kind});
+                    this->live++;
+                    return;
+                }
+
+                auto& change = this->order[found->second];
+                if (!change.live) {
+                    change.kind = kind;
+                    change.live = true;
+                    this->live++;
+                } else if (change.kind == WatchEvent::Created && kind == WatchEvent::Modified) {
+                    // Still new to whoever takes it.
+                } else if (change.kind == WatchEvent::Created && kind == WatchEvent::Removed) {
+                    change.live = false;
+                    this->live--;
+                } else if (change.kind == WatchEvent::Removed && kind == WatchEvent::Created) {
+                    // Replaced, like an editor saving through a temporary file.
+                    change.kind = WatchEvent::Modified;
+                } else {
+                    change.kind = kind;
+                }
+            }
+
+            void overflow() {
+                this->push(std::string(), WatchEvent::Overflow);
+            }
+
+            // True when there are changes and the oldest is at least `latency` old.
+            bool ready(std::chrono::milliseconds latency) {
+                std::lock_guard<std::mutex> guard(this->lock);
+                return this->live > 0 && Clock::now() - this->first >= latency;
+            }
+
+            std::vector<Change> take() {
+                std::vector<Change> out;
+                std::lock_guard<std::mutex> guard(this->lock);
+                out.reserve(this->live);
+                for (auto& change : this->order) {
+                    if (change.live) {
+                        out.push_back(std::move(change));
+                    }
+                }
+                this->reset();
+                return out;
+            }
+        };
+
+        // Where the native backends report to. Drops the path from the caches before queueing it, so the next
+        // `require` or `exists` sees the change even if the pump has not run yet.
+        struct Sink {
+            // The watched path as given, without trailing separators.
+            std::string root;
+            ChangeQueue queue;
+
+            // `rel` is relative to `root`, empty for `root` itself.
+            void report(const std::string& rel, WatchEvent kind) {
+                auto path = rel.empty() ? this->root : this->root + "/" + rel;
+                file_cache().invalidate(path);
+                stat_cache().invalidate(path);
+                this->queue.push(path, kind);
+            }
+
+            void overflow() {
+                file_cache().clear();
+                stat_cache().invalidate(this->root);
+                this->queue.overflow();
+            }
+        };
+
+        // What is being watched. Files are watched through their directory.
+        struct Target {
+            // Directory given to the OS.
+            std::string dir;
+            // When watching a file, its name in `dir`.
+            std::string file;
+            bool recursive = false;
+        };
+
+        std::string trim_separators(std::string path) {
+            while (path.size() > 1 && (path.back() == '/' || path.back() == '\\')) {
+                path.pop_back();
+            }
+            return path;
+        }
+
+#if defined(__linux__)
+        class Native {
+            Sink& sink;
+            Target target;
+            int fd = -1;
+            int wake[2] = {-1, -1};
+            // Watch descriptor to the directory it watches, relative to `target.dir`.
+            std::unordered_map<int, std::string> dirs;
+            std::thread thread;
+
+            void add(const std::string& rel) {
+                auto path = rel.empty() ? this->target.dir : this->target.dir + "/" + rel;
+                uint32_t mask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO
+                    | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_EXCL_UNLINK;
+                auto wd = inotify_add_watch(this->fd, path.c_str(), mask);
+                if (wd >= 0) {
+                    this->dirs[wd] = rel;
+                }
+            }
+
+            // Watch the directories under `rel`. With `report`, what is already in it is reported as created, since
+            // it could have been filled before the watch was added.
+            void add_tree(const std::string& rel, bool report) {
+                auto base = this->target.dir + "/" + rel;
+                std::error_code ec;
+                auto options = std::filesystem::directory_options::skip_permission_denied;
+                for (std::filesystem::recursive_directory_iterator it(base, options, ec), end; !ec && it != end; it.increment(ec)) {
+                    auto sub = rel + "/" + it->path().lexically_relative(base).generic_string();
+                    if (rel.empty()) {
+                        sub = sub.substr(1);
+                    }
+                    std::error_code type_ec;
+                    if (it->is_directory(type_ec) && !it->is_symlink(type_ec)) {
+                        this->add(sub);
+                    }
+                    if (report) {
+                        this->sink.report(sub, WatchEvent::Created);
+                    }
+                }
+            }
+
+            void handle(const inotify_event* event) {
+                if (event->mask & IN_Q_OVERFLOW) {
+                    this->sink.overflow();
+                    return;
+                }
+                auto found = this->dirs.find(event->wd);
+                if (found == this->dirs.end()) {
+                    return;
+                }
+                if (event->mask & IN_IGNORED) {
+                    this->dirs.erase(found);
+                    return;
+                }
+                auto dir = found->second;
+                if (event->len == 0) {
+                    // The directory itself, subdirectories are reported by their parent.
+                    if (dir.empty() && this->target.file.empty() && (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF))) {
+                        this->sink.report(std::string(), WatchEvent::Removed);
+                    }
+                    return;
+                }
+
+                std::string name(event->name);
+                auto rel = dir.empty() ? name : dir + "/" + name;
+                if (!this->target.file.empty()) {
+                    if (name != this->target.file) {
+                        return;
+                    }
+                    rel.clear();
+                }
+
+                auto kind = WatchEvent::Modified;
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    kind = WatchEvent::Created;
+                } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                    kind = WatchEvent::Removed;
+                }
+                this->sink.report(rel, kind);
+
+                if (this->target.recursive && kind == WatchEvent::Created && (event->mask & IN_ISDIR)) {
+                    this->add(rel);
+                    this->add_tree(rel, true);
+                }
+            }
+
+            void run() {
+                alignas(inotify_event) char buffer[64 * 1024];
+                pollfd fds[2] = {{this->fd, POLLIN, 0}, {this->wake[0], POLLIN, 0}};
+                while (true) {
+                    if (poll(fds, 2, -1) < 0) {
+                        if (errno == EINTR) {
+                            continue;
+                        }
+                        return;
+                    }
+                    if (fds[1].revents != 0) {
+                        return;
+                    }
+                    while (true) {
+                        auto n = read(this->fd, buffer, sizeof(buffer));
+                        if (n <= 0) {
+                            break;
+                        }
+                        for (char* at = buffer; at < buffer + n;) {
+                            auto event = reinterpret_cast<const inotify_event*>(at);
+                            this->handle(event);
+                            at += sizeof(inotify_event) + event->len;
+                        }
+                    }
+                }
+            }
+
+        public:
+            Native(Sink& sink, Target target) : sink(sink), target(std::move(target)) {}
+
+            ~Native() {
+                this->stop();
+                for (int f : {this->fd, this->wake[0], this->wake[1]}) {
+                    if (f >= 0) {
+                        ::close(f);
+                    }
+                }
+            }
+
+            std::string start() {
+                this->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+                if (this->fd < 0 || pipe2(this->wake, O_NONBLOCK | O_CLOEXEC) != 0) {
+                    return std::string("Could not watch: ") + std::strerror(errno);
+                }
+                this->add(std::string());
+                if (this->dirs.empty()) {
+                    return std::string("Could not watch ") + this->target.dir + ": " + std::strerror(errno);
+                }
+                if (this->target.recursive) {
+                    this->add_tree(std::string(), false);
+                }
+                this->thread = std::thread([this]() {
+                    this->run();
+                });
+                return std::string();
+            }
+
+            void stop() {
+                if (this->thread.joinable()) {
+                    char byte = 1;
+                    (void)!write(this->wake[1], &byte, 1);
+                    this->thread.join();
+                }
+            }
+        };
+#elif defined(__APPLE__) && TARGET_OS_OSX
+        class Native {
+            Sink& sink;
+            Target target;
+            // FSEvents reports resolved paths (`/private/var/...`), mapped back onto the path the script gave.
+            std::string real;
+            FSEventStreamRef stream = nullptr;
+            dispatch_queue_t queue = nullptr;
+
+            static void on_events(ConstFSEventStreamRef, void* info, size_t count, void* paths,
+                const FSEventStreamEventFlags flags[], const FSEventStreamEventId[]) {
+                auto self = static_cast<Native*>(info);
+                auto names = static_cast<char**>(paths);
+                for (size_t i = 0; i < count; i++) {
+                    self->handle(names[i], flags[i]);
+                }
+            }
+
+            void handle(const std::string& path, FSEventStreamEventFlags flags) {
+                if (flags & (kFSEventStreamEventFlagMustScanSubDirs | kFSEventStreamEventFlagUserDropped | kFSEventStreamEventFlagKernelDropped)) {
+                    this->sink.overflow();
+                    return;
+                }
+
+                std::error_code ec;
+                bool exists = std::filesystem::exists(std::filesystem::symlink_status(path, ec));
+                if (flags & kFSEventStreamEventFlagRootChanged) {
+                    this->sink.report(std::string(), exists ? WatchEvent::Modified : WatchEvent::Removed);
+                    return;
+                }
+                if (path.size() <= this->real.size() + 1 || path.compare(0, this->real.size(), this->real) != 0
+                    || path[this->real.size()] != '/') {
+                    return;
+                }
+                auto rel = path.substr(this->real.size() + 1);
+                if (!this->target.file.empty()) {
+                    if (rel != this->target.file) {
+                        return;
+                    }
+                    rel.clear();
+                } else if (!this->target.recursive && rel.find('/') != std::string::npos) {
+                    return;
+                }
+
+                // One event can carry created, modified and removed at once, what is on disk now decides.
+                auto kind = WatchEvent::Modified;
+                if (!exists) {
+                    kind = WatchEvent::Removed;
+                } else if (flags & (kFSEventStreamEventFlagItemCreated | kFSEventStreamEventFlagItemRenamed)) {
+                    kind = WatchEvent::Created;
+                }
+                this->sink.report(rel, kind);
+            }
+
+        public:
+            Native(Sink& sink, Target target) : sink(sink), target(std::move(target)) {}
+
+            ~Native() {
+                this->stop();
+            }
+
+            std::string start() {
+                std::error_code ec;
+                this->real = std::filesystem::canonical(this->target.dir, ec).string();
+                if (ec) {
+                    return "Could not watch " + this->target.dir + ": " + ec.message();
+                }
+
+                auto dir = CFStringCreateWithCString(nullptr, this->real.c_str(), kCFStringEncodingUTF8);
+                auto paths = CFArrayCreate(nullptr, reinterpret_cast<const void**>(&dir), 1, &kCFTypeArrayCallBacks);
+                FSEventStreamContext context = {0, this, nullptr, nullptr, nullptr};
+                // Batching is done by the pump, events are wanted as they come.
+                this->stream = FSEventStreamCreate(nullptr, &Native::on_events, &context, paths, kFSEventStreamEventIdSinceNow, 0.0,
+                    kFSEventStreamCreateFlagFileEvents | kFSEventStreamCreateFlagNoDefer | kFSEventStreamCreateFlagWatchRoot);
+                CFRelease(paths);
+                CFRelease(dir);
+                if (this->stream == nullptr) {
+                    return "Could not watch " + this->target.dir;
+                }
+
+                this->queue = dispatch_queue_create("yoyo.fs.watch", DISPATCH_QUEUE_SERIAL);
+                FSEventStreamSetDispatchQueue(this->stream, this->queue);
+                if (!FSEventStreamStart(this->stream)) {
+                    this->stop();
+                    return "Could not watch " + this->target.dir;
+                }
+                return std::string();
+            }
+
+            void stop() {
+                if (this->stream != nullptr) {
+                    FSEventStreamStop(this->stream);
+                    FSEventStreamInvalidate(this->stream);
+                    FSEventStreamRelease(this->stream);
+                    this->stream = nullptr;
+                }
+                if (this->queue != nullptr) {
+                    // Wait for a callback that is still running.
+                    dispatch_sync_f(this->queue, nullptr, [](void*) {});
+                    dispatch_release(this->queue);
+                    this->queue = nullptr;
+                }
+            }
+        };
+#elif defined(_WIN32)
+        class Native {
+            Sink& sink;
+            Target target;
+            HANDLE dir = INVALID_HANDLE_VALUE;
+            HANDLE io_event = nullptr;
+            HANDLE stop_event = nullptr;
+            std::thread thread;
+
+            void handle(const FILE_NOTIFY_INFORMATION* info) {
+                auto rel = yoyo::utils::strutils::from_wstring(
+                    std::wstring_view(info->FileName, info->FileNameLength / sizeof(WCHAR)));
+                std::replace(rel.begin(), rel.end(), '\\', '/');
+                if (!this->target.file.empty()) {
+                    if (rel != this->target.file) {
+                        return;
+                    }
+                    rel.clear();
+                }
+
+                auto kind = WatchEvent::Modified;
+                if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_RENAMED_NEW_NAME) {
+                    kind = WatchEvent::Created;
+                } else if (info->Action == FILE_ACTION_REMOVED || info->Action == FILE_ACTION_RENAMED_OLD_NAME) {
+                    kind = WatchEvent::Removed;
+                }
+                this->sink.report(rel, kind);
+            }
+
+            void run() {
+                alignas(DWORD) char buffer[64 * 1024];
+                DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE
+                    | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_ATTRIBUTES | FILE_NOTIFY_CHANGE_CREATION;
+                HANDLE events[2] = {this->io_event, this->stop_event};
+                while (true) {
+                    OVERLAPPED overlapped = {};
+                    overlapped.hEvent = this->io_event;
+                    if (!ReadDirectoryChangesW(this->dir, buffer, sizeof(buffer), this->target.recursive ? TRUE : FALSE,
+                        filter, nullptr, &overlapped, nullptr)) {
+                        return;
+                    }
+
+                    DWORD read = 0;
+                    if (WaitForMultipleObjects(2, events, FALSE, INFINITE) != WAIT_OBJECT_0) {
+                        CancelIoEx(this->dir, &overlapped);
+                        GetOverlappedResult(this->dir, &overlapped, &read, TRUE);
+                        return;
+                    }
+                    if (!GetOverlappedResult(this->dir, &overlapped, &read, FALSE)) {
+                        return;
+                    }
+                    if (read == 0) {
+                        // The buffer overflowed, Windows dropped the changes.
+                        this->sink.overflow();
+                        continue;
+                    }
+
+                    for (char* at = buffer;;) {
+                        auto info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(at);
+                        this->handle(info);
+                        if (info->NextEntryOffset == 0) {
+                            break;
+                        }
+                        at += info->NextEntryOffset;
+                    }
+                }
+            }
+
+        public:
+            Native(Sink& sink, Target target) : sink(sink), target(std::move(target)) {}
+
+            ~Native() {
+                this->stop();
+                if (this->dir != INVALID_HANDLE_VALUE) {
+                    CloseHandle(this->dir);
+                }
+                for (auto handle : {this->io_event, this->stop_event}) {
+                    if (handle != nullptr) {
+                        CloseHandle(handle);
+                    }
+                }
+            }
+
+            std::string start() {
+                auto wide = yoyo::utils::strutils::to_wstring(this->target.dir);
+                this->dir = CreateFileW(wide.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                    nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+                if (this->dir == INVALID_HANDLE_VALUE) {
+                    return "Could not watch " + this->target.dir;
+                }
+                this->io_event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+                this->stop_event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+                if (this->io_event == nullptr || this->stop_event == nullptr) {
+                    return "Could not watch " + this->target.dir;
+                }
+                this->thread = std::thread([this]() {
+                    this->run();
+                });
+                return std::string();
+            }
+
+            void stop() {
+                if (this->thread.joinable()) {
+                    SetEvent(this->stop_event);
+                    this->thread.join();
+                }
+            }
+        };
+#else
+        class Native {
+        public:
+            Native(Sink&, Target) {}
+
+            std::string start() {
+                return "Watching is not supported on this platform.";
+            }
+
+            void stop() {}
+        };
+#endif
+    };
+
+    struct WatchState {
+        // Thread that called `watch`. Only it may touch the pxs vars below.
+        std::thread::id owner;
+        // Owned, nullable.
+        pxs_VarT callback = nullptr;
+        // Owned, nullable.
+        pxs_VarT runtime = nullptr;
+        std::chrono::milliseconds latency{50};
+        watching::Sink sink;
+        std::unique_ptr<watching::Native> native;
+        bool closed = false;
+
+        void close() {
+            if (!this->closed) {
+                this->closed = true;
+                if (this->native) {
+                    this->native->stop();
+                }
+            }
+        }
+
+        ~WatchState() {
+            close();
+            if (callback != nullptr) {
+                pxs_freevar(callback);
+            }
+            if (runtime != nullptr) {
+                pxs_freevar(runtime);
+            }
+        }
+    };
+
+    namespace {
+        // Watchers with a callback, found by `watch_pump` of their owner thread.
+        struct Registered {
+            std::thread::id owner;
+            std::weak_ptr<WatchState> state;
+        };
+        std::mutex watchers_lock;
+        std::vector<Registered> watchers;
+
+        // Class of the `Watcher` host object. Created in `init_watch` since the function lookup is reset with pixelscript.
+        std::optional<pxs::Class<Watcher>> watcher_class;
+
+        void free_watcher(pxs_Opaque ptr) {
+            if (!ptr) {
+                return;
+            }
+
+            delete static_cast<Watcher*>(ptr);
+        }
+
+        pxs_VarT changes_to_pxs(std::vector<watching::Change> changes) {
+            auto list = pxs_newlist();
+            for (auto& change : changes) {
+                auto map = pxs_newmap();
+                pxs_map_addpair(map, pxs_newstring("path"), pxs_newstring(change.path.c_str()));
+                pxs_map_addpair(map, pxs_newstring("kind"), pxs_newint(static_cast<int>(change.kind)));
+                pxs_listadd(list, map);
+            }
+            return list;
+        }
+
+        void read_watch_options(pxs_VarT opts, watching::Target& target, std::chrono::milliseconds& latency) {
+            if (opts == nullptr || !pxs_varis(opts, pxs_Map)) {
+                return;
+            }
+            pxs_MapIter iter;
+            pxs_VarT key = nullptr;
+            pxs_VarT value = nullptr;
+            pxs_mapiter_begin(opts, &iter);
+            while (pxs_mapiter_next(&iter, &key, &value)) {
+                size_t len = 0;
+                auto str = pxs_getstrview(key, &len);
+                if (str == nullptr) {
+                    continue;
+                }
+                std::string name(str, len);
+                if (name == "recursive" && pxs_varis(value, pxs_Bool)) {
+                    target.recursive = pxs_getbool(value);
+                } else if (name == "latency" && (pxs_varis(value, pxs_Int64) || pxs_varis(value, pxs_UInt64))) {
+                    latency = std::chrono::milliseconds(std::max<int64_t>(0, pxs_getint(value)));
+                }
+            }
+        }
+    };
+
+    Watcher::Watcher(std::shared_ptr<WatchState> state) : state(std::move(state)) {}
+
+    Watcher::~Watcher() {
+        state->close();
+    }
+
+    pxs_VarT Watcher::get_path(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Watcher>(args, 0, yoyo::types::FS_WATCHER_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        return pxs_newstring(self->state->sink.root.c_str());
+    }
+
+    pxs_VarT Watcher::poll(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Watcher>(args, 0, yoyo::types::FS_WATCHER_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        return changes_to_pxs(self->state->sink.queue.take());
+    }
+
+    pxs_VarT Watcher::close(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Watcher>(args, 0, yoyo::types::FS_WATCHER_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        self->state->close();
+        self->state->sink.queue.take();
+        return pxs_newnull();
+    }
+
+    pxs_VarT watch(pxs_VarT args) {
+        PXS_ARGC_GT(1); // path, options, callback
+        PXS_ARG_STRING_VAL(path, 0);
+
+        auto state = std::make_shared<WatchState>();
+        state->owner = std::this_thread::get_id();
+        state->sink.root = watching::trim_separators(path);
+        state->sink.queue.root = state->sink.root;
+
+        watching::Target target;
+        read_watch_options(pxs_arg(args, 1), target, state->latency);
+
+        // A callback can come second when there are no options.
+        auto callback_arg = pxs::Var::from_args(args, 2);
+        if (!callback_arg.is(pxs_Function)) {
+            auto second = pxs::Var::from_args(args, 1);
+            if (second.is(pxs_Function)) {
+                callback_arg = std::move(second);
+            }
+        }
+        if (callback_arg.is(pxs_Function)) {
+            // Copying moves the language reference to our copy, keeping it alive.
+            state->callback = pxs_newcopy(callback_arg.raw());
+            state->runtime = pxs_newcopy(pxs_getrt(args));
+        } else if (!callback_arg.is(pxs_Null)) {
+            return yoyo::utils::exceptions::expected_types(callback_arg.raw()->tag, {pxs_Function, pxs_Null});
+        }
+
+        std::error_code ec;
+        auto status = std::filesystem::status(state->sink.root, ec);
+        if (ec || !std::filesystem::exists(status)) {
+            return pxs_newexception(("Could not watch " + state->sink.root + ": " + (ec ? ec.message() : "No such file or directory")).c_str());
+        }
+        if (std::filesystem::is_directory(status)) {
+            target.dir = state->sink.root;
+        } else {
+            auto file = std::filesystem::path(state->sink.root);
+            target.dir = file.has_parent_path() ? file.parent_path().string() : std::string(".");
+            target.file = file.filename().string();
+            target.recursive = false;
+        }
+
+        state->native = std::make_unique<watching::Native>(state->sink, std::move(target));
+        auto error = state->native->start();
+        if (!error.empty()) {
+            return pxs_newexception(error.c_str());
+        }
+
+        if (state->callback != nullptr) {
+            std::lock_guard<std::mutex> guard(watchers_lock);
+            watchers.push_back({state->owner, state});
+        }
+
+        return watcher_class->make(new Watcher(state), free_watcher).raw();
+    }
+
+    int watch_pump() {
+        std::vector<std::shared_ptr<WatchState>> mine;
+        {
+            std::lock_guard<std::mutex> guard(watchers_lock);
+            auto me = std::this_thread::get_id();
+            // Only watchers of this thread are locked, so their last reference is always dropped here.
+            watchers.erase(std::remove_if(watchers.begin(), watchers.end(), [&](const Registered& r) {
+                if (r.owner != me) {
+                    return false;
+                }
+                auto state = r.state.lock();
+                if (!state) {
+                    return true;
+                }
+                mine.push_back(std::move(state));
+                return false;
+            }), watchers.end());
+        }
+
+        int handled = 0;
+        for (auto& state : mine) {
+            if (state->closed || !state->sink.queue.ready(state->latency)) {
+                continue;
+            }
+            auto cb_args = pxs_newlist();
+            pxs_listadd(cb_args, changes_to_pxs(state->sink.queue.take()));
+            auto res = pxs_varcall(state->runtime, state->callback, cb_args);
+            if (res != nullptr) {
+                pxs_freevar(res);
+            }
+            handled++;
+        }
+        return handled;
+    }
+
+    void init_watch(pxs_Module* fs_mod) {
+        watcher_class.emplace("Watcher", yoyo::types::FS_WATCHER_TYPE);
+        watcher_class->add_property("path", &Watcher::get_path);
+        watcher_class->add_method("poll", &Watcher::poll);
+        watcher_class->add_method("close", &Watcher::close);
+
+        pxs_addfunc(fs_mod, "watch", watch);
+        pxs_addvar(fs_mod, "WATCH_EVENT_CREATED", pxs_newint(static_cast<int>(WatchEvent::Created)));
+        pxs_addvar(fs_mod, "WATCH_EVENT_MODIFIED", pxs_newint(static_cast<int>(WatchEvent::Modified)));
+        pxs_addvar(fs_mod, "WATCH_EVENT_REMOVED", pxs_newint(static_cast<int>(WatchEvent::Removed)));
+        pxs_addvar(fs_mod, "WATCH_EVENT_OVERFLOW", pxs_newint(static_cast<int>(WatchEvent::Overflow)));
+    }
+};
+
+#endif // YOYO_FS
@@ -0,0 +1,1332 @@
+#ifdef YOYO_HASH
+
+#include "hash.hpp"
+#include <pixelscript_cpp.hpp>
+#include "utils/types.hpp"
+#include "utils/pxs.hpp"
+#include "utils/bytes.hpp"
+#include "utils/exceptions.hpp"
+#ifdef YOYO_FS
+#include "fs.hpp"
+#endif
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define YOYO_HASH_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+// MSVC compiles intrinsics for any target.
+#define YOYO_HASH_TARGET(features)
+#else
+#include <cpuid.h>
+#define YOYO_HASH_TARGET(features) __attribute__((target(features)))
+#endif
+#endif
+
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+namespace yoyo::hash {
+    // CPU features, checked once.
+    struct Cpu {
+        bool avx2 = false;
+        bool sse42 = false;
+        bool pclmul = false;
+        bool sha = false;
+    };
+
+    const Cpu& cpu() {
+        static const Cpu features = [] {
+            Cpu c;
+        #if defined(YOYO_HASH_X86)
+        #if defined(_MSC_VER) && !defined(__clang__)
+            int info[4];
+            __cpuid(info, 1);
+            unsigned ecx1 = static_cast<unsigned>(info[2]);
+            __cpuidex(info, 7, 0);
+            unsigned ebx7 = static_cast<unsigned>(info[1]);
+            // AVX state saved by the OS.
+            bool os_avx = (ecx1 & (1u << 27)) && (_xgetbv(0) & 6) == 6;
+        #else
+            unsigned eax, ebx, ecx1 = 0, edx;
+            __get_cpuid(1, &eax, &ebx, &ecx1, &edx);
+            unsigned ebx7 = 0, ecx7;
+            __get_cpuid_count(7, 0, &eax, &ebx7, &ecx7, &edx);
+            bool os_avx = __builtin_cpu_supports("avx");
+        #endif
+            c.pclmul = ecx1 & (1u << 1);
+            // SSSE3 and SSE4.1 come with every CPU that has SHA or SSE4.2.
+            c.sse42 = ecx1 & (1u << 20);
+            c.avx2 = os_avx && (ebx7 & (1u << 5));
+            c.sha = c.sse42 && (ebx7 & (1u << 29));
+        #endif
+            return c;
+        }();
+        return features;
+    }
+
+    inline uint32_t read32(const uint8_t* p) {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+    #if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        v = __builtin_bswap32(v);
+    #endif
+        return v;
+    }
+
+    inline uint64_t read64(const uint8_t* p) {
+        uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+    #if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        v = __builtin_bswap64(v);
+    #endif
+        return v;
+    }
+
+    inline uint32_t swap32(uint32_t x) {
+        return ((x << 24) & 0xff000000u) | ((x << 8) & 0x00ff0000u) | ((x >> 8) & 0x0000ff00u) | ((x >> 24) & 0x000000ffu);
+    }
+
+    inline uint64_t swap64(uint64_t x) {
+        return (static_cast<uint64_t>(swap32(static_cast<uint32_t>(x))) << 32) | swap32(static_cast<uint32_t>(x >> 32));
+    }
+
+    inline uint64_t rotl64(uint64_t x, int r) {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    inline uint32_t rotl32(uint32_t x, int r) {
+        return (x << r) | (x >> (32 - r));
+    }
+
+    // ------------------------------------------------------------------------------------------------------------
+    // xxHash3, following the reference implementation (xxhash.h 0.8).
+
+    struct U128 {
+        uint64_t low;
+        uint64_t high;
+    };
+
+    inline U128 mul128(uint64_t a, uint64_t b) {
+    #if defined(__SIZEOF_INT128__)
+        auto product = static_cast<unsigned __int128>(a) * b;
+        return {static_cast<uint64_t>(product), static_cast<uint64_t>(product >> 64)};
+    #elif defined(_MSC_VER) && defined(_M_X64)
+        uint64_t high;
+        uint64_t low = _umul128(a, b, &high);
+        return {low, high};
+    #else
+        uint64_t lo_lo = (a & 0xffffffff) * (b & 0xffffffff);
+        uint64_t hi_lo = (a >> 32) * (b & 0xffffffff);
+        uint64_t lo_hi = (a & 0xffffffff) * (b >> 32);
+        uint64_t hi_hi = (a >> 32) * (b >> 32);
+        uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+        return {(cross << 32) | (lo_lo & 0xffffffff), (hi_lo >> 32) + (cross >> 32) + hi_hi};
+    #endif
+    }
+
+    inline uint64_t mul128_fold64(uint64_t a, uint64_t b) {
+        auto product = mul128(a, b);
+        return product.low ^ product.high;
+    }
+
+    constexpr uint32_t PRIME32_1 = 0x9E3779B1u;
+    constexpr uint32_t PRIME32_2 = 0x85EBCA77u;
+    constexpr uint32_t PRIME32_3 = 0xC2B2AE3Du;
+    constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87ull;
+    constexpr uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4Full;
+    constexpr uint64_t PRIME64_3 = 0x165667B19E3779F9ull;
+    constexpr uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ull;
+    constexpr uint64_t PRIME64_5 = 0x27D4EB2F165667C5ull;
+    constexpr uint64_t PRIME_MX1 = 0x165667919E3779F9ull;
+    constexpr uint64_t PRIME_MX2 = 0x9FB21C651E98DF25ull;
+
+    constexpr size_t SECRET_SIZE = 192;
+    constexpr size_t SECRET_SIZE_MIN = 136;
+    constexpr size_t STRIPE_LEN = 64;
+    constexpr size_t SECRET_CONSUME_RATE = 8;
+    constexpr size_t STRIPES_PER_BLOCK = (SECRET_SIZE - STRIPE_LEN) / SECRET_CONSUME_RATE;
+    constexpr size_t BLOCK_LEN = STRIPE_LEN * STRIPES_PER_BLOCK;
+    constexpr size_t MIDSIZE_MAX = 240;
+    constexpr size_t MIDSIZE_STARTOFFSET = 3;
+    constexpr size_t MIDSIZE_LASTOFFSET = 17;
+    constexpr size_t SECRET_LASTACC_START = 7;
+    constexpr size_t SECRET_MERGEACCS_START = 11;
+
+    alignas(64) constexpr uint8_t K_SECRET[SECRET_SIZE] = {
+        0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+        0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+        0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+        0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+        0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+        0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+        0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+        0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+        0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+        0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+        0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+        0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+    };
+
+    inline uint64_t xxh64_avalanche(uint64_t h) {
+        h ^= h >> 33;
+        h *= PRIME64_2;
+        h ^= h >> 29;
+        h *= PRIME64_3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    inline uint64_t avalanche(uint64_t h) {
+        h ^= h >> 37;
+        h *= PRIME_MX1;
+        h ^= h >> 32;
+        return h;
+    }
+
+    inline uint64_t rrmxmx(uint64_t h, uint64_t len) {
+        h ^= rotl64(h, 49) ^ rotl64(h, 24);
+        h *= PRIME_MX2;
+        h ^= (h >> 35) + len;
+        h *= PRIME_MX2;
+        return h ^ (h >> 28);
+    }
+
+    inline uint64_t mix16(const uint8_t* input, const uint8_t* secret, uint64_t seed) {
+        return mul128_fold64(read64(input) ^ (read64(secret) + seed), read64(input + 8) ^ (read64(secret + 8) - seed));
+    }
+
+    uint64_t xxh3_short(const uint8_t* input, size_t len, const uint8_t* secret, uint64_t seed) {
+        if (len > 8) {
+            uint64_t bitflip1 = (read64(secret + 24) ^ read64(secret + 32)) + seed;
+            uint64_t bitflip2 = (read64(secret + 40) ^ read64(secret + 48)) - seed;
+            uint64_t lo = read64(input) ^ bitflip1;
+            uint64_t hi = read64(input + len - 8) ^ bitflip2;
+            return avalanche(len + swap64(lo) + hi + mul128_fold64(lo, hi));
+        }
+        if (len >= 4) {
+            seed ^= static_cast<uint64_t>(swap32(static_cast<uint32_t>(seed))) << 32;
+            uint64_t bitflip = (read64(secret + 8) ^ read64(secret + 16)) - seed;
+            uint64_t combined = read32(input + len - 4) + (static_cast<uint64_t>(read32(input)) << 32);
+            return rrmxmx(combined ^ bitflip, len);
+        }
+        if (len > 0) {
+            uint32_t combined = (static_cast<uint32_t>(input[0]) << 16) | (static_cast<uint32_t>(input[len >> 1]) << 24)
+                | input[len - 1] | (static_cast<uint32_t>(len) << 8);
+            uint64_t bitflip = (read32(secret) ^ read32(secret + 4)) + seed;
+            return xxh64_avalanche(combined ^ bitflip);
+        }
+        return xxh64_avalanche(seed ^ read64(secret + 56) ^ read64(secret + 64));
+    }
+
+    uint64_t xxh3_mid(const uint8_t* input, size_t len, const uint8_t* secret, uint64_t seed) {
+        uint64_t acc = len * PRIME64_1;
+        if (len <= 128) {
+            if (len > 32) {
+                if (len > 64) {
+                    if (len > 96) {
+                        acc += mix16(input + 48, secret + 96, seed);
+                        acc += mix16(input + len - 64, secret + 112, seed);
+                    }
+                    acc += mix16(input + 32, secret + 64, seed);
+                    acc += mix16(input + len - 48, secret + 80, seed);
+                }
+                acc += mix16(input + 16, secret + 32, seed);
+                acc += mix16(input + len - 32, secret + 48, seed);
+            }
+            acc += mix16(input, secret, seed);
+            acc += mix16(input + len - 16, secret + 16, seed);
+            return avalanche(acc);
+        }
+
+        size_t rounds = len / 16;
+        for (size_t i = 0; i < 8; i++) {
+            acc += mix16(input + 16 * i, secret + 16 * i, seed);
+        }
+        acc = avalanche(acc);
+        for (size_t i = 8; i < rounds; i++) {
+            acc += mix16(input + 16 * i, secret + 16 * (i - 8) + MIDSIZE_STARTOFFSET, seed);
+        }
+        acc += mix16(input + len - 16, secret + SECRET_SIZE_MIN - MIDSIZE_LASTOFFSET, seed);
+        return avalanche(acc);
+    }
+
+    inline U128 mix32(U128 acc, const uint8_t* a, const uint8_t* b, const uint8_t* secret, uint64_t seed) {
+        acc.low += mix16(a, secret, seed);
+        acc.low ^= read64(b) + read64(b + 8);
+        acc.high += mix16(b, secret + 16, seed);
+        acc.high ^= read64(a) + read64(a + 8);
+        return acc;
+    }
+
+    U128 xxh128_short(const uint8_t* input, size_t len, const uint8_t* secret, uint64_t seed) {
+        if (len > 8) {
+            uint64_t bitflipl = (read64(secret + 32) ^ read64(secret + 40)) - seed;
+            uint64_t bitfliph = (read64(secret + 48) ^ read64(secret + 56)) + seed;
+            uint64_t lo = read64(input);
+            uint64_t hi = read64(input + len - 8);
+            auto m = mul128(lo ^ hi ^ bitflipl, PRIME64_1);
+            m.low += static_cast<uint64_t>(len - 1) << 54;
+            hi ^= bitfliph;
+            m.high += hi + static_cast<uint64_t>(static_cast<uint32_t>(hi)) * (PRIME32_2 - 1);
+            m.low ^= swap64(m.high);
+            auto h = mul128(m.low, PRIME64_2);
+            h.high += m.high * PRIME64_2;
+            return {avalanche(h.low), avalanche(h.high)};
+        }
+        if (len >= 4) {
+            seed ^= static_cast<uint64_t>(swap32(static_cast<uint32_t>(seed))) << 32;
+            uint64_t combined = read32(input) + (static_cast<uint64_t>(read32(input + len - 4)) << 32);
+            uint64_t bitflip = (read64(secret + 16) ^ read64(secret + 24)) + seed;
+            auto m = mul128(combined ^ bitflip, PRIME64_1 + (len << 2));
+            m.high += m.low << 1;
+            m.low ^= m.high >> 3;
+            m.low ^= m.low >> 35;
+            m.low *= PRIME_MX2;
+            m.low ^= m.low >> 28;
+            m.high = avalanche(m.high);
+            return m;
+        }
+        if (len > 0) {
+            uint32_t combinedl = (static_cast<uint32_t>(input[0]) << 16) | (static_cast<uint32_t>(input[len >> 1]) << 24)
+                | input[len - 1] | (static_cast<uint32_t>(len) << 8);
+            uint32_t combinedh = rotl32(swap32(combinedl), 13);
+            uint64_t bitflipl = (read32(secret) ^ read32(secret + 4)) + seed;
+            uint64_t bitfliph = (read32(secret + 8) ^ read32(secret + 12)) - seed;
+            return {xxh64_avalanche(combinedl ^ bitflipl), xxh64_avalanche(combinedh ^ bitfliph)};
+        }
+        return {
+            xxh64_avalanche(seed ^ read64(secret + 64) ^ read64(secret + 72)),
+            xxh64_avalanche(seed ^ read64(secret + 80) ^ read64(secret + 88))
+        };
+    }
+
+    U128 xxh128_mid(const uint8_t* input, size_t len, const uint8_t* secret, uint64_t seed) {
+        U128 acc{len * PRIME64_1, 0};
+        if (len <= 128) {
+            if (len > 32) {
+                if (len > 64) {
+                    if (len > 96) {
+                        acc = mix32(acc, input + 48, input + len - 64, secret + 96, seed);
+                    }
+                    acc = mix32(acc, input + 32, input + len - 48, secret + 64, seed);
+                }
+                acc = mix32(acc, input + 16, input + len - 32, secret + 32, seed);
+            }
+            acc = mix32(acc, input, input + len - 16, secret, seed);
+        } else {
+            size_t rounds = len / 32;
+            for (size_t i = 0; i < 4; i++) {
+                acc = mix32(acc, input + 32 * i, input + 32 * i + 16, secret + 32 * i, seed);
+            }
+            acc.low = avalanche(acc.low);
+            acc.high = avalanche(acc.high);
+            for (size_t i = 4; i < rounds; i++) {
+                acc = mix32(acc, input + 32 * i, input + 32 * i + 16, secret + MIDSIZE_STARTOFFSET + 32 * (i - 4), seed);
+            }
+            acc = mix32(acc, input + len - 16, input + len - 32, secret + SECRET_SIZE_MIN - MIDSIZE_LASTOFFSET - 16, 0 - seed);
+        }
+        uint64_t low = acc.low + acc.high;
+        uint64_t high = acc.low * PRIME64_1 + acc.high * PRIME64_4 + (len - seed) * PRIME64_2;
+        return {avalanche(low), 0 - avalanche(high)};
+    }
+
+    // The 8 lanes of the long input loop.
+    struct alignas(32) Accs {
+        uint64_t lanes[8] = {PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3, PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1};
+    };
+
+    // Accumulate `stripes` stripes of 64 bytes, the secret moving 8 bytes per stripe.
+    using AccumulateFn = void (*)(Accs&, const uint8_t*, const uint8_t*, size_t);
+    // Scramble the lanes after a block.
+    using ScrambleFn = void (*)(Accs&, const uint8_t*);
+
+    void accumulate_scalar(Accs& acc, const uint8_t* input, const uint8_t* secret, size_t stripes) {
+        for (size_t n = 0; n < stripes; n++, input += STRIPE_LEN, secret += SECRET_CONSUME_RATE) {
+            for (size_t i = 0; i < 8; i++) {
+                uint64_t value = read64(input + 8 * i);
+                uint64_t key = value ^ read64(secret + 8 * i);
+                acc.lanes[i ^ 1] += value;
+                acc.lanes[i] += (key & 0xffffffff) * (key >> 32);
+            }
+        }
+    }
+
+    void scramble_scalar(Accs& acc, const uint8_t* secret) {
+        for (size_t i = 0; i < 8; i++) {
+            uint64_t lane = acc.lanes[i];
+            lane ^= lane >> 47;
+            lane ^= read64(secret + 8 * i);
+            lane *= PRIME32_1;
+            acc.lanes[i] = lane;
+        }
+    }
+
+#if defined(YOYO_HASH_X86)
+    // SSE2 is part of x86-64.
+    void accumulate_sse2(Accs& acc, const uint8_t* input, const uint8_t* secret, size_t stripes) {
+        auto lanes = reinterpret_cast<__m128i*>(acc.lanes);
+        __m128i a[4];
+        for (int i = 0; i < 4; i++) {
+            a[i] = _mm_load_si128(lanes + i);
+        }
+        for (size_t n = 0; n < stripes; n++, input += STRIPE_LEN, secret += SECRET_CONSUME_RATE) {
+            for (int i = 0; i < 4; i++) {
+                auto data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input) + i);
+                auto key = _mm_xor_si128(data, _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret) + i));
+                auto product = _mm_mul_epu32(key, _mm_shuffle_epi32(key, _MM_SHUFFLE(0, 3, 0, 1)));
+                auto swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+                a[i] = _mm_add_epi64(product, _mm_add_epi64(a[i], swapped));
+            }
+        }
+        for (int i = 0; i < 4; i++) {
+            _mm_store_si128(lanes + i, a[i]);
+        }
+    }
+
+    void scramble_sse2(Accs& acc, const uint8_t* secret) {
+        auto lanes = reinterpret_cast<__m128i*>(acc.lanes);
+        auto prime = _mm_set1_epi32(static_cast<int>(PRIME32_1));
+        for (int i = 0; i < 4; i++) {
+            auto a = _mm_load_si128(lanes + i);
+            a = _mm_xor_si128(a, _mm_srli_epi64(a, 47));
+            a = _mm_xor_si128(a, _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret) + i));
+            auto high = _mm_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 0, 1));
+            auto product_low = _mm_mul_epu32(a, prime);
+            auto product_high = _mm_mul_epu32(high, prime);
+            _mm_store_si128(lanes + i, _mm_add_epi64(product_low, _mm_slli_epi64(product_high, 32)));
+        }
+    }
+
+    YOYO_HASH_TARGET("avx2")
+    void accumulate_avx2(Accs& acc, const uint8_t* input, const uint8_t* secret, size_t stripes) {
+        auto lanes = reinterpret_cast<__m256i*>(acc.lanes);
+        auto a0 = _mm256_load_si256(lanes);
+        auto a1 = _mm256_load_si256(lanes + 1);
+        for (size_t n = 0; n < stripes; n++, input += STRIPE_LEN, secret += SECRET_CONSUME_RATE) {
+            auto d0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input));
+            auto d1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input) + 1);
+            auto k0 = _mm256_xor_si256(d0, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(secret)));
+            auto k1 = _mm256_xor_si256(d1, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(secret) + 1));
+            auto p0 = _mm256_mul_epu32(k0, _mm256_shuffle_epi32(k0, _MM_SHUFFLE(0, 3, 0, 1)));
+            auto p1 = _mm256_mul_epu32(k1, _mm256_shuffle_epi32(k1, _MM_SHUFFLE(0, 3, 0, 1)));
+            a0 = _mm256_add_epi64(p0, _mm256_add_epi64(a0, _mm256_shuffle_epi32(d0, _MM_SHUFFLE(1, 0, 3, 2))));
+            a1 = _mm256_add_epi64(p1, _mm256_add_epi64(a1, _mm256_shuffle_epi32(d1, _MM_SHUFFLE(1, 0, 3, 2))));
+        }
+        _mm256_store_si256(lanes, a0);
+        _mm256_store_si256(lanes + 1, a1);
+    }
+
+    YOYO_HASH_TARGET("avx2")
+    void scramble_avx2(Accs& acc, const uint8_t* secret) {
+        auto lanes = reinterpret_cast<__m256i*>(acc.lanes);
+        auto prime = _mm256_set1_epi32(static_cast<int>(PRIME32_1));
+        for (int i = 0; i < 2; i++) {
+            auto a = _mm256_load_si256(lanes + i);
+            a = _mm256_xor_si256(a, _mm256_srli_epi64(a, 47));
+            a = _mm256_xor_si256(a, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(secret) + i));
+            auto high = _mm256_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 0, 1));
+            auto product_low = _mm256_mul_epu32(a, prime);
+            auto product_high = _mm256_mul_epu32(high, prime);
+            _mm256_store_si256(lanes + i, _mm256_add_epi64(product_low, _mm256_slli_epi64(product_high, 32)));
+        }
+    }
+#endif
+
+    // The widest loop this CPU runs.
+    struct LongLoop {
+        AccumulateFn accumulate;
+        ScrambleFn scramble;
+    };
+
+    const LongLoop& long_loop() {
+        static const LongLoop loop = [] {
+        #if defined(YOYO_HASH_X86)
+            if (cpu().avx2) {
+                return LongLoop{accumulate_avx2, scramble_avx2};
+            }
+            return LongLoop{accumulate_sse2, scramble_sse2};
+        #else
+            return LongLoop{accumulate_scalar, scramble_scalar};
+        #endif
+        }();
+        return loop;
+    }
+
+    // Every full block but the one holding the last byte, the rest is left for `long_finish`.
+    // Returns the number of bytes consumed.
+    size_t long_blocks(Accs& acc, const uint8_t* input, size_t len, const uint8_t* secret) {
+        auto& loop = long_loop();
+        size_t blocks = (len - 1) / BLOCK_LEN;
+        for (size_t n = 0; n < blocks; n++) {
+            loop.accumulate(acc, input + n * BLOCK_LEN, secret, STRIPES_PER_BLOCK);
+            loop.scramble(acc, secret + SECRET_SIZE - STRIPE_LEN);
+        }
+        return blocks * BLOCK_LEN;
+    }
+
+    // The last 1 to `BLOCK_LEN` bytes, at `tail`. The 64 bytes before `tail + len` must be readable, for
+    // inputs over `MIDSIZE_MAX` they always are.
+    void long_finish(Accs& acc, const uint8_t* tail, size_t len, const uint8_t* secret) {
+        auto& loop = long_loop();
+        loop.accumulate(acc, tail, secret, (len - 1) / STRIPE_LEN);
+        loop.accumulate(acc, tail + len - STRIPE_LEN, secret + SECRET_SIZE - STRIPE_LEN - SECRET_LASTACC_START, 1);
+    }
+
+    uint64_t merge_accs(const Accs& acc, const uint8_t* secret, uint64_t start) {
+        uint64_t result = start;
+        for (size_t i = 0; i < 4; i++) {
+            result += mul128_fold64(acc.lanes[2 * i] ^ read64(secret + 16 * i), acc.lanes[2 * i + 1] ^ read64(secret + 16 * i + 8));
+        }
+        return avalanche(result);
+    }
+
+    uint64_t long_digest64(const Accs& acc, const uint8_t* secret, uint64_t total) {
+        return merge_accs(acc, secret + SECRET_MERGEACCS_START, total * PRIME64_1);
+    }
+
+    U128 long_digest128(const Accs& acc, const uint8_t* secret, uint64_t total) {
+        return {
+            merge_accs(acc, secret + SECRET_MERGEACCS_START, total * PRIME64_1),
+            merge_accs(acc, secret + SECRET_SIZE - STRIPE_LEN - SECRET_MERGEACCS_START, ~(total * PRIME64_2))
+        };
+    }
+
+    // Long inputs use the default secret with the seed mixed in.
+    void seeded_secret(uint64_t seed, uint8_t* out) {
+        for (size_t i = 0; i < SECRET_SIZE / 16; i++) {
+            uint64_t low = read64(K_SECRET + 16 * i) + seed;
+            uint64_t high = read64(K_SECRET + 16 * i + 8) - seed;
+            for (int b = 0; b < 8; b++) {
+                out[16 * i + b] = static_cast<uint8_t>(low >> (8 * b));
+                out[16 * i + 8 + b] = static_cast<uint8_t>(high >> (8 * b));
+            }
+        }
+    }
+
+    uint64_t xxh3_64(const uint8_t* input, size_t len, uint64_t seed) {
+        if (len <= 16) {
+            return xxh3_short(input, len, K_SECRET, seed);
+        }
+        if (len <= MIDSIZE_MAX) {
+            return xxh3_mid(input, len, K_SECRET, seed);
+        }
+        alignas(64) uint8_t secret[SECRET_SIZE];
+        if (seed != 0) {
+            seeded_secret(seed, secret);
+        }
+        auto used = seed != 0 ? secret : K_SECRET;
+        Accs acc;
+        auto done = long_blocks(acc, input, len, used);
+        long_finish(acc, input + done, len - done, used);
+        return long_digest64(acc, used, len);
+    }
+
+    U128 xxh3_128(const uint8_t* input, size_t len, uint64_t seed) {
+        if (len <= 16) {
+            return xxh128_short(input, len, K_SECRET, seed);
+        }
+        if (len <= MIDSIZE_MAX) {
+            return xxh128_mid(input, len, K_SECRET, seed);
+        }
+        alignas(64) uint8_t secret[SECRET_SIZE];
+        if (seed != 0) {
+            seeded_secret(seed, secret);
+        }
+        auto used = seed != 0 ? secret : K_SECRET;
+        Accs acc;
+        auto done = long_blocks(acc, input, len, used);
+        long_finish(acc, input + done, len - done, used);
+        return long_digest128(acc, used, len);
+    }
+
+    // ------------------------------------------------------------------------------------------------------------
+    // CRC-32 and CRC-32C, slicing by 8 with hardware paths.
+
+    struct CrcTables {
+        uint32_t t[8][256];
+    };
+
+    CrcTables make_tables(uint32_t poly) {
+        CrcTables tables;
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = c & 1 ? (c >> 1) ^ poly : c >> 1;
+            }
+            tables.t[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; i++) {
+            for (int s = 1; s < 8; s++) {
+                tables.t[s][i] = (tables.t[s - 1][i] >> 8) ^ tables.t[0][tables.t[s - 1][i] & 0xff];
+            }
+        }
+        return tables;
+    }
+
+    // `crc` is the running (inverted) value.
+    uint32_t crc_slice8(const CrcTables& tables, uint32_t crc, const uint8_t* data, size_t len) {
+        auto& t = tables.t;
+        while (len >= 8) {
+            uint32_t lo = read32(data) ^ crc;
+            uint32_t hi = read32(data + 4);
+            crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24]
+                ^ t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+            data += 8;
+            len -= 8;
+        }
+        while (len-- > 0) {
+            crc = t[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+        }
+        return crc;
+    }
+
+    const CrcTables& crc32_tables() {
+        static const CrcTables tables = make_tables(0xEDB88320u);
+        return tables;
+    }
+
+    const CrcTables& crc32c_tables() {
+        static const CrcTables tables = make_tables(0x82F63B78u);
+        return tables;
+    }
+
+#if defined(YOYO_HASH_X86)
+    YOYO_HASH_TARGET("pclmul")
+    inline __m128i crc_fold(__m128i x, __m128i k, __m128i next) {
+        return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x11), _mm_clmulepi64_si128(x, k, 0x00)), next);
+    }
+
+    // Folds 64 bytes at a time with carry-less multiplies, then a Barrett reduction. `len` must be at least 64 and a
+    // multiple of 16. The constants are the reflected CRC-32 fold keys of Intel's "Fast CRC Computation Using PCLMULQDQ".
+    YOYO_HASH_TARGET("pclmul,sse4.1")
+    uint32_t crc32_pclmul(uint32_t crc, const uint8_t* buf, size_t len) {
+        alignas(16) static const uint64_t k1k2[] = {0x0154442bd4ull, 0x01c6e41596ull};
+        alignas(16) static const uint64_t k3k4[] = {0x01751997d0ull, 0x00ccaa009eull};
+        alignas(16) static const uint64_t k5[] = {0x0163cd6124ull, 0};
+        alignas(16) static const uint64_t poly[] = {0x01db710641ull, 0x01f7011641ull};
+
+        auto load = [](const uint8_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); };
+        auto x1 = _mm_xor_si128(load(buf), _mm_cvtsi32_si128(static_cast<int>(crc)));
+        auto x2 = load(buf + 16);
+        auto x3 = load(buf + 32);
+        auto x4 = load(buf + 48);
+        buf += 64;
+        len -= 64;
+
+        auto k = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+        while (len >= 64) {
+            x1 = crc_fold(x1, k, load(buf));
+            x2 = crc_fold(x2, k, load(buf + 16));
+            x3 = crc_fold(x3, k, load(buf + 32));
+            x4 = crc_fold(x4, k, load(buf + 48));
+            buf += 64;
+            len -= 64;
+        }
+
+        k = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+        x1 = crc_fold(x1, k, x2);
+        x1 = crc_fold(x1, k, x3);
+        x1 = crc_fold(x1, k, x4);
+        while (len >= 16) {
+            x1 = crc_fold(x1, k, load(buf));
+            buf += 16;
+            len -= 16;
+        }
+
+        // 128 to 64 bits.
+        auto mask = _mm_setr_epi32(~0, 0, ~0, 0);
+        x2 = _mm_clmulepi64_si128(x1, k, 0x10);
+        x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+        k = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5));
+        x2 = _mm_srli_si128(x1, 4);
+        x1 = _mm_and_si128(x1, mask);
+        x1 = _mm_xor_si128(_mm_clmulepi64_si128(x1, k, 0x00), x2);
+
+        // Barrett reduction to 32 bits.
+        k = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+        x2 = _mm_and_si128(x1, mask);
+        x2 = _mm_clmulepi64_si128(x2, k, 0x10);
+        x2 = _mm_and_si128(x2, mask);
+        x2 = _mm_clmulepi64_si128(x2, k, 0x00);
+        x1 = _mm_xor_si128(x1, x2);
+        return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+    }
+
+    YOYO_HASH_TARGET("sse4.2")
+    uint32_t crc32c_sse42(uint32_t crc, const uint8_t* data, size_t len) {
+        uint64_t c = crc;
+        while (len >= 8) {
+            uint64_t v;
+            std::memcpy(&v, data, sizeof(v));
+            c = _mm_crc32_u64(c, v);
+            data += 8;
+            len -= 8;
+        }
+        crc = static_cast<uint32_t>(c);
+        while (len-- > 0) {
+            crc = _mm_crc32_u8(crc, *data++);
+        }
+        return crc;
+    }
+#endif
+
+    uint32_t crc32_update(uint32_t crc, const uint8_t* data, size_t len) {
+        uint32_t c = ~crc;
+    #if defined(__ARM_FEATURE_CRC32)
+        while (len >= 8) {
+            uint64_t v;
+            std::memcpy(&v, data, sizeof(v));
+            c = __crc32d(c, v);
+            data += 8;
+            len -= 8;
+        }
+        while (len-- > 0) {
+            c = __crc32b(c, *data++);
+        }
+        return ~c;
+    #else
+    #if defined(YOYO_HASH_X86)
+        if (len >= 64 && cpu().pclmul && cpu().sse42) {
+            size_t chunk = len & ~static_cast<size_t>(15);
+            c = crc32_pclmul(c, data, chunk);
+            data += chunk;
+            len -= chunk;
+        }
+    #endif
+        return ~crc_slice8(crc32_tables(), c, data, len);
+    #endif
+    }
+
+    uint32_t crc32c_update(uint32_t crc, const uint8_t* data, size_t len) {
+        uint32_t c = ~crc;
+    #if defined(__ARM_FEATURE_CRC32)
+        while (len >= 8) {
+            uint64_t v;
+            std::memcpy(&v, data, sizeof(v));
+            c = __crc32cd(c, v);
+            data += 8;
+            len -= 8;
+        }
+        while (len-- > 0) {
+            c = __crc32cb(c, *data++);
+        }
+        return ~c;
+    #else
+    #if defined(YOYO_HASH_X86)
+        if (cpu().sse42) {
+            return ~crc32c_sse42(c, data, len);
+        }
+    #endif
+        return ~crc_slice8(crc32c_tables(), c, data, len);
+    #endif
+    }
+
+    // ------------------------------------------------------------------------------------------------------------
+    // SHA-256 (FIPS 180-4).
+
+    constexpr uint32_t SHA256_K[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+    };
+
+    inline uint32_t rotr32(uint32_t x, int r) {
+        return (x >> r) | (x << (32 - r));
+    }
+
+    inline uint32_t read32_be(const uint8_t* p) {
+        return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16)
+            | (static_cast<uint32_t>(p[2]) << 8) | p[3];
+    }
+
+    void sha256_scalar(uint32_t* state, const uint8_t* data, size_t blocks) {
+        for (; blocks > 0; blocks--, data += 64) {
+            uint32_t w[64];
+            for (int i = 0; i < 16; i++) {
+                w[i] = read32_be(data + 4 * i);
+            }
+            for (int i = 16; i < 64; i++) {
+                uint32_t s0 = rotr32(w[i - 15], 7) ^ rotr32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                uint32_t s1 = rotr32(w[i - 2], 17) ^ rotr32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+
+            uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+            uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+            for (int i = 0; i < 64; i++) {
+                uint32_t t1 = h + (rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25)) + ((e & f) ^ (~e & g)) + SHA256_K[i] + w[i];
+                uint32_t t2 = (rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+                h = g;
+                g = f;
+                f = e;
+                e = d + t1;
+                d = c;
+                c = b;
+                b = a;
+                a = t1 + t2;
+            }
+            state[0] += a;
+            state[1] += b;
+            state[2] += c;
+            state[3] += d;
+            state[4] += e;
+            state[5] += f;
+            state[6] += g;
+            state[7] += h;
+        }
+    }
+
+#if defined(YOYO_HASH_X86)
+    // The SHA-NI rounds, 4 rounds per group with the message schedule kept in `msg`.
+    YOYO_HASH_TARGET("sha,sse4.1,ssse3")
+    void sha256_shani(uint32_t* state, const uint8_t* data, size_t blocks) {
+        const auto mask = _mm_set_epi64x(0x0c0d0e0f08090a0bll, 0x0405060700010203ll);
+        auto tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0xB1);
+        auto state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)), 0x1B);
+        // ABEF and CDGH
+        auto state0 = _mm_alignr_epi8(tmp, state1, 8);
+        state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+        for (; blocks > 0; blocks--, data += 64) {
+            auto abef = state0;
+            auto cdgh = state1;
+            __m128i msg[4];
+            for (int g = 0; g < 16; g++) {
+                if (g < 4) {
+                    msg[g] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data) + g), mask);
+                }
+                auto m = _mm_add_epi32(msg[g % 4], _mm_loadu_si128(reinterpret_cast<const __m128i*>(SHA256_K + 4 * g)));
+                state1 = _mm_sha256rnds2_epu32(state1, state0, m);
+                if (g >= 3 && g <= 14) {
+                    auto& next = msg[(g + 1) % 4];
+                    next = _mm_add_epi32(next, _mm_alignr_epi8(msg[g % 4], msg[(g + 3) % 4], 4));
+                    next = _mm_sha256msg2_epu32(next, msg[g % 4]);
+                }
+                state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(m, 0x0E));
+                if (g >= 1 && g <= 12) {
+                    msg[(g + 3) % 4] = _mm_sha256msg1_epu32(msg[(g + 3) % 4], msg[g % 4]);
+                }
+            }
+            state0 = _mm_add_epi32(state0, abef);
+            state1 = _mm_add_epi32(state1, cdgh);
+        }
+
+        tmp = _mm_shuffle_epi32(state0, 0x1B);
+        state1 = _mm_shuffle_epi32(state1, 0xB1);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_blend_epi16(tmp, state1, 0xF0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), _mm_alignr_epi8(state1, tmp, 8));
+    }
+#endif
+
+    void sha256_blocks(uint32_t* state, const uint8_t* data, size_t blocks) {
+    #if defined(YOYO_HASH_X86)
+        if (cpu().sha) {
+            sha256_shani(state, data, blocks);
+            return;
+        }
+    #endif
+        sha256_scalar(state, data, blocks);
+    }
+
+    struct Sha256 {
+        uint32_t state[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+        uint8_t buffer[64];
+        size_t buffered = 0;
+        uint64_t total = 0;
+
+        void update(const uint8_t* data, size_t len) {
+            this->total += len;
+            if (this->buffered > 0) {
+                auto n = std::min(len, 64 - this->buffered);
+                std::memcpy(this->buffer + this->buffered, data, n);
+                this->buffered += n;
+                data += n;
+                len -= n;
+                if (this->buffered < 64) {
+                    return;
+                }
+                sha256_blocks(this->state, this->buffer, 1);
+                this->buffered = 0;
+            }
+            sha256_blocks(this->state, data, len / 64);
+            data += len / 64 * 64;
+            len %= 64;
+            std::memcpy(this->buffer, data, len);
+            this->buffered = len;
+        }
+
+        // Pads a copy, so more can be hashed after.
+        std::array<uint8_t, 32> digest() const {
+            Sha256 last = *this;
+            uint64_t bits = this->total * 8;
+            uint8_t pad[72] = {0x80};
+            size_t pad_len = (this->buffered < 56 ? 56 : 120) - this->buffered;
+            for (int i = 0; i < 8; i++) {
+                pad[pad_len + i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+            }
+            last.update(pad, pad_len + 8);
+
+            std::array<uint8_t, 32> out;
+            for (int i = 0; i < 8; i++) {
+                for (int b = 0; b < 4; b++) {
+                    out[4 * i + b] = static_cast<uint8_t>(last.state[i] >> (24 - 8 * b));
+                }
+            }
+            return out;
+        }
+    };
+
+    // ------------------------------------------------------------------------------------------------------------
+    // Streaming state of every algorithm.
+
+    void put_be(std::string& out, uint64_t value, int bytes) {
+        for (int i = bytes - 1; i >= 0; i--) {
+            out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+        }
+    }
+
+    class Engine {
+    public:
+        virtual ~Engine() = default;
+        virtual void update(const uint8_t* data, size_t len) = 0;
+        // The big endian digest.
+        virtual std::string digest() const = 0;
+        virtual void reset() = 0;
+    };
+
+    class Xxh3Engine : public Engine {
+        bool wide;
+        uint64_t seed;
+        alignas(64) uint8_t secret[SECRET_SIZE];
+        Accs acc;
+        // The last stripe consumed, then up to a block not consumed yet. A block is only consumed once more input
+        // follows it, the final one is hashed differently.
+        alignas(64) uint8_t buffer[STRIPE_LEN + BLOCK_LEN];
+        size_t buffered = 0;
+        uint64_t total = 0;
+
+        uint8_t* pending() {
+            return this->buffer + STRIPE_LEN;
+        }
+
+        void consume_blocks(const uint8_t* data, size_t blocks) {
+            auto& loop = long_loop();
+            for (size_t n = 0; n < blocks; n++) {
+                loop.accumulate(this->acc, data + n * BLOCK_LEN, this->secret, STRIPES_PER_BLOCK);
+                loop.scramble(this->acc, this->secret + SECRET_SIZE - STRIPE_LEN);
+            }
+        }
+
+    public:
+        Xxh3Engine(bool wide, uint64_t seed) : wide(wide), seed(seed) {
+            seeded_secret(seed, this->secret);
+        }
+
+        void update(const uint8_t* data, size_t len) override {
+            this->total += len;
+            while (len > 0) {
+                if (this->buffered == BLOCK_LEN) {
+                    consume_blocks(this->pending(), 1);
+                    std::memcpy(this->buffer, this->pending() + BLOCK_LEN - STRIPE_LEN, STRIPE_LEN);
+                    this->buffered = 0;
+                }
+                if (this->buffered == 0 && len > BLOCK_LEN) {
+                    // Straight from the input, keeping the last block for later.
+                    size_t blocks = (len - 1) / BLOCK_LEN;
+                    consume_blocks(data, blocks);
+                    data += blocks * BLOCK_LEN;
+                    len -= blocks * BLOCK_LEN;
+                    std::memcpy(this->buffer, data - STRIPE_LEN, STRIPE_LEN);
+                }
+                auto n = std::min(len, BLOCK_LEN - this->buffered);
+                std::memcpy(this->pending() + this->buffered, data, n);
+                this->buffered += n;
+                data += n;
+                len -= n;
+            }
+        }
+
+        std::string digest() const override {
+            std::string out;
+            auto self = const_cast<Xxh3Engine*>(this);
+            if (this->total <= BLOCK_LEN) {
+                // Everything is still buffered.
+                if (this->wide) {
+                    auto h = xxh3_128(self->pending(), this->buffered, this->seed);
+                    put_be(out, h.high, 8);
+                    put_be(out, h.low, 8);
+                } else {
+                    put_be(out, xxh3_64(self->pending(), this->buffered, this->seed), 8);
+                }
+                return out;
+            }
+
+            Accs last = this->acc;
+            long_finish(last, self->pending(), this->buffered, this->secret);
+            if (this->wide) {
+                auto h = long_digest128(last, this->secret, this->total);
+                put_be(out, h.high, 8);
+                put_be(out, h.low, 8);
+            } else {
+                put_be(out, long_digest64(last, this->secret, this->total), 8);
+            }
+            return out;
+        }
+
+        void reset() override {
+            this->acc = Accs();
+            this->buffered = 0;
+            this->total = 0;
+        }
+    };
+
+    class CrcEngine : public Engine {
+        bool castagnoli;
+        uint32_t crc = 0;
+
+    public:
+        CrcEngine(bool castagnoli) : castagnoli(castagnoli) {}
+
+        void update(const uint8_t* data, size_t len) override {
+            this->crc = this->castagnoli ? crc32c_update(this->crc, data, len) : crc32_update(this->crc, data, len);
+        }
+
+        std::string digest() const override {
+            std::string out;
+            put_be(out, this->crc, 4);
+            return out;
+        }
+
+        void reset() override {
+            this->crc = 0;
+        }
+    };
+
+    class Sha256Engine : public Engine {
+        Sha256 sha;
+
+    public:
+        void update(const uint8_t* data, size_t len) override {
+            this->sha.update(data, len);
+        }
+
+        std::string digest() const override {
+            auto bytes = this->sha.digest();
+            return std::string(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        }
+
+        void reset() override {
+            this->sha = Sha256();
+        }
+    };
+
+    std::unique_ptr<Engine> make_engine(Algorithm algorithm, uint64_t seed) {
+        switch (algorithm) {
+            case Algorithm::Xxh3:
+                return std::make_unique<Xxh3Engine>(false, seed);
+            case Algorithm::Xxh128:
+                return std::make_unique<Xxh3Engine>(true, seed);
+            case Algorithm::Crc32:
+                return std::make_unique<CrcEngine>(false);
+            case Algorithm::Crc32c:
+                return std::make_unique<CrcEngine>(true);
+            case Algorithm::Sha256:
+                return std::make_unique<Sha256Engine>();
+        }
+        return nullptr;
+    }
+
+    // The digest of `len` bytes at once, skipping the buffering of the engines.
+    std::string digest_all(Algorithm algorithm, uint64_t seed, const uint8_t* data, size_t len) {
+        std::string out;
+        switch (algorithm) {
+            case Algorithm::Xxh3:
+                put_be(out, xxh3_64(data, len, seed), 8);
+                break;
+            case Algorithm::Xxh128: {
+                auto h = xxh3_128(data, len, seed);
+                put_be(out, h.high, 8);
+                put_be(out, h.low, 8);
+                break;
+            }
+            case Algorithm::Crc32:
+                put_be(out, crc32_update(0, data, len), 4);
+                break;
+            case Algorithm::Crc32c:
+                put_be(out, crc32c_update(0, data, len), 4);
+                break;
+            case Algorithm::Sha256: {
+                Sha256 sha;
+                sha.update(data, len);
+                auto bytes = sha.digest();
+                out.assign(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+                break;
+            }
+        }
+        return out;
+    }
+
+    std::string to_hex(const std::string& bytes) {
+        static const char digits[] = "0123456789abcdef";
+        std::string hex;
+        hex.reserve(bytes.size() * 2);
+        for (unsigned char c : bytes) {
+            hex.push_back(digits[c >> 4]);
+            hex.push_back(digits[c & 0xf]);
+        }
+        return hex;
+    }
+
+    // ------------------------------------------------------------------------------------------------------------
+    // Script bindings.
+
+    // Class of the `Hasher` host object. Created in `init` since the function lookup is reset with pixelscript.
+    std::optional<pxs::Class<Hasher>> hasher_class;
+
+    Hasher::Hasher(std::unique_ptr<Engine> engine, Algorithm algorithm) : engine(std::move(engine)), algorithm(algorithm) {}
+    Hasher::~Hasher() = default;
+
+    void free_hasher(pxs_Opaque ptr) {
+        if (!ptr) {
+            return;
+        }
+
+        delete static_cast<Hasher*>(ptr);
+    }
+
+    pxs_VarT expected_bytes(pxs_VarT arg) {
+        return utils::exceptions::expected_types(pxs_vartype(arg), {pxs_String, pxs_List});
+    }
+
+    // Read the optional int arg at `idx` into `out`. Returns the exception when it is not an int.
+    pxs_VarT uint_arg(pxs_VarT args, int idx, uint64_t& out) {
+        auto arg = pxs::Var::from_args(args, idx);
+        if (arg.is(pxs_Int64) || arg.is(pxs_UInt64)) {
+            out = arg.get_uint();
+        } else if (!arg.is(pxs_Null)) {
+            return utils::exceptions::expected_types(pxs_vartype(arg.raw()), {pxs_Int64, pxs_Null});
+        }
+        return nullptr;
+    }
+
+    // Read the optional algorithm arg at `idx` into `out`. Returns the exception when it is invalid.
+    pxs_VarT algorithm_arg(pxs_VarT args, int idx, Algorithm& out) {
+        auto arg = pxs::Var::from_args(args, idx);
+        if (arg.is(pxs_Int64) || arg.is(pxs_UInt64)) {
+            auto value = arg.get_int();
+            if (value < 0 || value > static_cast<int64_t>(Algorithm::Sha256)) {
+                return utils::exceptions::invalid_enum();
+            }
+            out = static_cast<Algorithm>(value);
+        } else if (!arg.is(pxs_Null)) {
+            return utils::exceptions::expected_types(pxs_vartype(arg.raw()), {pxs_Int64, pxs_Null});
+        }
+        return nullptr;
+    }
+
+    pxs_VarT Hasher::get_algorithm(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Hasher>(args, 0, yoyo::types::HASH_HASHER_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        return pxs_newint(static_cast<int>(self->algorithm));
+    }
+
+    pxs_VarT Hasher::update(pxs_VarT args) {
+        PXS_ARGC_EQ(2); // self, data
+        auto self = yoyo::utils::pxs::get_type<Hasher>(args, 0, yoyo::types::HASH_HASHER_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        const uint8_t* data;
+        size_t len;
+        std::vector<uint8_t> storage;
+        if (!utils::bytes::view_bytes(pxs_arg(args, 1), data, len, storage)) {
+            return expected_bytes(pxs_arg(args, 1));
+        }
+
+        self->engine->update(data, len);
+        return pxs_newnull();
+    }
+
+    pxs_VarT Hasher::digest(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Hasher>(args, 0, yoyo::types::HASH_HASHER_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        auto bytes = self->engine->digest();
+        return pxs_newbytes(static_cast<pxs_Opaque>(bytes.data()), sizeof(char), bytes.size());
+    }
+
+    pxs_VarT Hasher::hexdigest(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Hasher>(args, 0, yoyo::types::HASH_HASHER_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        return pxs_newstring(to_hex(self->engine->digest()).c_str());
+    }
+
+    pxs_VarT Hasher::reset(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Hasher>(args, 0, yoyo::types::HASH_HASHER_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        self->engine->reset();
+        return pxs_newnull();
+    }
+
+    pxs_VarT xxh3(pxs_VarT args) {
+        PXS_ARGC_GT(1); // data, seed
+        const uint8_t* data;
+        size_t len;
+        std::vector<uint8_t> storage;
+        if (!utils::bytes::view_bytes(pxs_arg(args, 0), data, len, storage)) {
+            return expected_bytes(pxs_arg(args, 0));
+        }
+        uint64_t seed = 0;
+        if (auto err = uint_arg(args, 1, seed)) {
+            return err;
+        }
+
+        return pxs_newuint(xxh3_64(data, len, seed));
+    }
+
+    pxs_VarT xxh128(pxs_VarT args) {
+        PXS_ARGC_GT(1); // data, seed
+        const uint8_t* data;
+        size_t len;
+        std::vector<uint8_t> storage;
+        if (!utils::bytes::view_bytes(pxs_arg(args, 0), data, len, storage)) {
+            return expected_bytes(pxs_arg(args, 0));
+        }
+        uint64_t seed = 0;
+        if (auto err = uint_arg(args, 1, seed)) {
+            return err;
+        }
+
+        return pxs_newstring(to_hex(digest_all(Algorithm::Xxh128, seed, data, len)).c_str());
+    }
+
+    // Shared by `crc32` and `crc32c`.
+    pxs_VarT crc_all(pxs_VarT args, bool castagnoli) {
+        PXS_ARGC_GT(1); // data, crc
+        const uint8_t* data;
+        size_t len;
+        std::vector<uint8_t> storage;
+        if (!utils::bytes::view_bytes(pxs_arg(args, 0), data, len, storage)) {
+            return expected_bytes(pxs_arg(args, 0));
+        }
+        uint64_t crc = 0;
+        if (auto err = uint_arg(args, 1, crc)) {
+            return err;
+        }
+
+        auto value = static_cast<uint32_t>(crc);
+        return pxs_newuint(castagnoli ? crc32c_update(value, data, len) : crc32_update(value, data, len));
+    }
+
+    pxs_VarT crc32(pxs_VarT args) {
+        return crc_all(args, false);
+    }
+
+    pxs_VarT crc32c(pxs_VarT args) {
+        return crc_all(args, true);
+    }
+
+    pxs_VarT sha256(pxs_VarT args) {
+        PXS_ARGC_EQ(1); // data
+        const uint8_t* data;
+        size_t len;
+        std::vector<uint8_t> storage;
+        if (!utils::bytes::view_bytes(pxs_arg(args, 0), data, len, storage)) {
+            return expected_bytes(pxs_arg(args, 0));
+        }
+
+        return pxs_newstring(to_hex(digest_all(Algorithm::Sha256, 0, data, len)).c_str());
+    }
+
+    pxs_VarT hasher(pxs_VarT args) {
+        PXS_ARGC_GT(1); // algorithm, seed
+        auto algorithm = Algorithm::Xxh3;
+        if (auto err = algorithm_arg(args, 0, algorithm)) {
+            return err;
+        }
+        uint64_t seed = 0;
+        if (auto err = uint_arg(args, 1, seed)) {
+            return err;
+        }
+
+        return hasher_class->make(new Hasher(make_engine(algorithm, seed), algorithm), free_hasher).raw();
+    }
+
+    pxs_VarT hash_file(pxs_VarT args) {
+#ifdef YOYO_FS
+        PXS_ARGC_GT(1); // path, algorithm, seed
+        PXS_ARG_IS_TYPE(0, pxs_String);
+        auto algorithm = Algorithm::Xxh3;
+        if (auto err = algorithm_arg(args, 1, algorithm)) {
+            return err;
+        }
+        uint64_t seed = 0;
+        if (auto err = uint_arg(args, 2, seed)) {
+            return err;
+        }
+
+        auto path = pxs::Var::from_args(args, 0).get_string();
+        fs::MappedFile mapped(path);
+        if (!mapped.is_mapped()) {
+            return pxs_newexception(("Could not map file: " + path).c_str());
+        }
+        auto data = reinterpret_cast<const uint8_t*>(mapped.data());
+        return pxs_newstring(to_hex(digest_all(algorithm, seed, data, mapped.size())).c_str());
+#else
+        return pxs_newexception("yoyo.fs is not enabled.");
+#endif // YOYO_FS
+    }
+
+    void init(pxs_Module* yoyo) {
+        hasher_class.emplace("Hasher", yoyo::types::HASH_HASHER_TYPE);
+        hasher_class->add_property("algorithm", &Hasher::get_algorithm);
+        hasher_class->add_method("update", &Hasher::update);
+        hasher_class->add_method("digest", &Hasher::digest);
+        hasher_class->add_method("hexdigest", &Hasher::hexdigest);
+        hasher_class->add_method("reset", &Hasher::reset);
+
+        auto hash_mod = pxs_newmod("hash");
+
+        pxs_addfunc(hash_mod, "xxh3", xxh3);
+        pxs_addfunc(hash_mod, "xxh128", xxh128);
+        pxs_addfunc(hash_mod, "crc32", crc32);
+        pxs_addfunc(hash_mod, "crc32c", crc32c);
+        pxs_addfunc(hash_mod, "sha256", sha256);
+        pxs_addfunc(hash_mod, "hasher", hasher);
+        pxs_addfunc(hash_mod, "hash_file", hash_file);
+
+        pxs_addvar(hash_mod, "ALGORITHM_XXH3", pxs_newint(static_cast<int>(Algorithm::Xxh3)));
+        pxs_addvar(hash_mod, "ALGORITHM_XXH128", pxs_newint(static_cast<int>(Algorithm::Xxh128)));
+        pxs_addvar(hash_mod, "ALGORITHM_CRC32", pxs_newint(static_cast<int>(Algorithm::Crc32)));
+        pxs_addvar(hash_mod, "ALGORITHM_CRC32C", pxs_newint(static_cast<int>(Algorithm::Crc32c)));
+        pxs_addvar(hash_mod, "ALGORITHM_SHA256", pxs_newint(static_cast<int>(Algorithm::Sha256)));
+
+        pxs_add_submod(yoyo, hash_mod);
+    }
+};
+
+#endif // YOYO_HASH
@@ -7,6 +7,7 @@
 #include "utils/bytes.hpp"
 #include "utils/strutils.hpp"
 #include "utils/pxs.hpp"
+#include "utils/pool.hpp"
 #include <vector>
 #include <cstdlib>
 #include "utils/exceptions.hpp"
@@ -14,6 +15,24 @@
 #include <array>
 #include <sstream>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <deque>
+#include <chrono>
+#include <thread>
+#include <condition_variable>
+#include <algorithm>
+#include <functional>
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+#include <optional>
+#include <unordered_map>
+// Only the C API, the implementation lives in utils/miniz.cpp.
+#define MINIZ_HEADER_FILE_ONLY
+#define MINIZ_NO_CPP_WRAPPER
+#define MINIZ_NO_ZLIB_COMPATIBLE_NAMES
+#include "miniz.hpp"
 
 #if defined(_WIN32)
 // Windows native IMPL. Uses WinHTTP.
@@ -25,15 +44,282 @@
 #pragma comment(lib, "winhttp.lib")
 #undef DELETE
 
+#else
+// POSIX native IMPL (Linux, Android, Apple). Non blocking sockets driven by `poll`.
+// TLS comes from OpenSSL (`YOYO_NET_OPENSSL`) or SecureTransport on Apple.
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+#if defined(YOYO_NET_OPENSSL)
+#include <openssl/ssl.h>
+#include <openssl/err.h>
 #elif defined(__APPLE__)
-// TODO: APPLE
-#elif defined(__ANDROID__)
-// TODO: ANDROID
-#elif defined(__linux__)
-// TODO LINUX
+#include <Security/Security.h>
+#include <Security/SecureTransport.h>
+#endif
+
 #endif
 
 namespace yoyo::net {
+    // Is `key` (lowercase) in `headers`, ignoring case?
+    bool has_header(const std::map<std::string, std::string>& headers, const std::string& key) {
+        for (const auto& [k, v] : headers) {
+            if (yoyo::utils::str::to_lower(k) == key) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Streaming `gzip`/`deflate` decoder for response bodies.
+    class Inflater {
+        mz_stream stream{};
+        bool gzip;
+        bool started = false;
+        bool finished = false;
+        // Bytes held back until the gzip header (or zlib check) is complete.
+        std::string header;
+        std::unique_ptr<unsigned char[]> out;
+        static constexpr size_t OUT_SIZE = 64 * 1024;
+
+        // Size of the gzip header at the start of `header`, 0 if more bytes are needed.
+        size_t gzip_header_size() const {
+            auto h = reinterpret_cast<const unsigned char*>(header.data());
+            if (header.size() < 10) {
+                return 0;
+            }
+            if (h[0] != 0x1f || h[1] != 0x8b || h[2] != 8) {
+                throw std::runtime_error("Response is not valid gzip.");
+            }
+
+            auto flags = h[3];
+            size_t pos = 10;
+            if (flags & 4) {
+                // FEXTRA
+                if (header.size() < pos + 2) {
+                    return 0;
+                }
+                pos += 2 + (h[pos] | (h[pos + 1] << 8));
+            }
+            for (int bit : {8, 16}) {
+                // FNAME, FCOMMENT
+                if (flags & bit) {
+                    auto end = header.find('\0', pos);
+                    if (end == std::string::npos) {
+                        return 0;
+                    }
+                    pos = end + 1;
+                }
+            }
+            if (flags & 2) {
+                // FHCRC
+                pos += 2;
+            }
+            return header.size() >= pos ? pos : 0;
+        }
+
+        void decode(const unsigned char* data, size_t len, const std::function<void(const char*, size_t)>& emit) {
+            this->stream.next_in = data;
+            this->stream.avail_in = static_cast<unsigned int>(len);
+            size_t produced;
+            do {
+                this->stream.next_out = this->out.get();
+                this->stream.avail_out = OUT_SIZE;
+                int r = mz_inflate(&this->stream, MZ_NO_FLUSH);
+                produced = OUT_SIZE - this->stream.avail_out;
+                if (produced > 0) {
+                    emit(reinterpret_cast<const char*>(this->out.get()), produced);
+                }
+                if (r == MZ_STREAM_END) {
+                    // Anything after (gzip trailer) is ignored.
+                    this->finished = true;
+                    return;
+                }
+                if (r != MZ_OK && r != MZ_BUF_ERROR) {
+                    throw std::runtime_error("Could not decompress the response.");
+                }
+            } while (this->stream.avail_in > 0 || produced == OUT_SIZE);
+        }
+
+    public:
+        Inflater(bool gzip) : gzip(gzip), out(new unsigned char[OUT_SIZE]) {}
+        ~Inflater() {
+            if (this->started) {
+                mz_inflateEnd(&this->stream);
+            }
+        }
+
+        Inflater(const Inflater&) = delete;
+        Inflater& operator=(const Inflater&) = delete;
+
+        // Feed compressed bytes, decoded bytes go to `emit`.
+        void feed(const char* data, size_t len, const std::function<void(const char*, size_t)>& emit) {
+            if (this->finished) {
+                return;
+            }
+            if (this->started) {
+                decode(reinterpret_cast<const unsigned char*>(data), len, emit);
+                return;
+            }
+
+            this->header.append(data, len);
+            size_t skip = 0;
+            int window_bits = -MZ_DEFAULT_WINDOW_BITS;
+            if (this->gzip) {
+                skip = gzip_header_size();
+                if (skip == 0) {
+                    return;
+                }
+            } else {
+                if (this->header.size() < 2) {
+                    return;
+                }
+                // `deflate` should be zlib wrapped, but some servers send it raw.
+                auto h = reinterpret_cast<const unsigned char*>(this->header.data());
+                if ((h[0] & 0x0f) == 8 && ((h[0] << 8) | h[1]) % 31 == 0) {
+                    window_bits = MZ_DEFAULT_WINDOW_BITS;
+                }
+            }
+
+            if (mz_inflateInit2(&this->stream, window_bits) != MZ_OK) {
+                throw std::runtime_error("Could not start decompressing the response.");
+            }
+            this->started = true;
+
+            auto rest = this->header.substr(std::min(skip, this->header.size()));
+            this->header.clear();
+            decode(reinterpret_cast<const unsigned char*>(rest.data()), rest.size(), emit);
+        }
+    };
+
+    // Get a `Inflater` for a `Content-Encoding`, or null when it is not compressed.
+    std::unique_ptr<Inflater> inflater_for(const std::string& encoding) {
+        auto lower = yoyo::utils::str::to_lower(encoding);
+        if (lower.find("gzip") != std::string::npos) {
+            return std::make_unique<Inflater>(true);
+        }
+        if (lower.find("deflate") != std::string::npos) {
+            return std::make_unique<Inflater>(false);
+        }
+        return nullptr;
+    }
+
+    using Clock = std::chrono::steady_clock;
+
+    // Milliseconds between two points.
+    double elapsed_ms(Clock::time_point from, Clock::time_point to) {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    }
+
+    // Process wide latency histograms per domain, see `track_stats`.
+    struct NetStats {
+        // Bucket `i` is `<= 2^i` ms, the last one is everything slower.
+        static constexpr size_t BUCKETS = 17;
+
+        struct Domain {
+            uint64_t count = 0;
+            uint64_t errors = 0;
+            double total_ms = 0;
+            std::array<uint64_t, BUCKETS + 1> buckets{};
+        };
+
+        std::mutex lock;
+        bool enabled = false;
+        std::map<std::string, Domain> domains;
+
+        void record(const std::string& domain, double ms, bool failed) {
+            std::lock_guard<std::mutex> guard(lock);
+            if (!this->enabled) {
+                return;
+            }
+            auto& d = this->domains[domain];
+            d.count++;
+            d.total_ms += ms;
+            if (failed) {
+                d.errors++;
+            }
+            size_t bucket = 0;
+            while (bucket < BUCKETS && ms > static_cast<double>(1ull << bucket)) {
+                bucket++;
+            }
+            d.buckets[bucket]++;
+        }
+
+        // Hold `lock`.
+        std::string to_json() {
+            std::ostringstream out;
+            out << "{";
+            bool first = true;
+            for (const auto& [domain, d] : this->domains) {
+                if (!first) {
+                    out << ",";
+                }
+                first = false;
+                out << "\"";
+                for (char c : domain) {
+                    if (c == '"' || c == '\\') {
+                        out << '\\';
+                    }
+                    out << c;
+                }
+                out << "\":{\"count\":" << d.count << ",\"errors\":" << d.errors << ",\"total_ms\":" << d.total_ms << ",\"buckets\":[";
+                for (size_t i = 0; i < d.buckets.size(); i++) {
+                    out << (i == 0 ? "" : ",") << d.buckets[i];
+                }
+                out << "]}";
+            }
+            out << "}";
+            return out.str();
+        }
+    };
+
+    NetStats& net_stats() {
+        static NetStats stats;
+        return stats;
+    }
+
+    void track_stats(bool enabled) {
+        auto& stats = net_stats();
+        std::lock_guard<std::mutex> guard(stats.lock);
+        stats.enabled = enabled;
+    }
+
+    size_t write_stats(char* out, size_t len, bool reset) {
+        auto& stats = net_stats();
+        std::lock_guard<std::mutex> guard(stats.lock);
+        auto json = stats.to_json();
+        if (out && len > 0) {
+            auto n = std::min(json.size(), len - 1);
+            std::memcpy(out, json.data(), n);
+            out[n] = '\0';
+            if (reset && json.size() < len) {
+                stats.domains.clear();
+            }
+        }
+        return json.size();
+    }
+
+    // Records a request into `net_stats` when it goes out of scope. A exception or a 5xx counts as a error.
+    struct StatsScope {
+        const std::string& domain;
+        Clock::time_point start = Clock::now();
+        int status = 0;
+
+        StatsScope(const std::string& domain) : domain(domain) {}
+        ~StatsScope() {
+            net_stats().record(this->domain, elapsed_ms(this->start, Clock::now()), this->status == 0 || this->status >= 500);
+        }
+    };
+
     // ================================= WINDOWS ================================= 
     #if defined(_WIN32)
     // Get last error for WinHttp
@@ -74,6 +360,41 @@ namespace yoyo::net {
         }
     }
 
+    // When each phase of a request started, filled by `on_status`. The request is synchronous so
+    // WinHTTP calls back on the requesting thread.
+    struct PhaseClock {
+        Clock::time_point resolving{};
+        Clock::time_point resolved{};
+        Clock::time_point connecting{};
+        Clock::time_point connected{};
+        Clock::time_point sending{};
+    };
+
+    void CALLBACK on_status(HINTERNET, DWORD_PTR context, DWORD status, LPVOID, DWORD) {
+        auto phases = reinterpret_cast<PhaseClock*>(context);
+        if (!phases) {
+            return;
+        }
+        auto now = Clock::now();
+        switch (status) {
+            case WINHTTP_CALLBACK_STATUS_RESOLVING_NAME:
+                phases->resolving = now;
+                break;
+            case WINHTTP_CALLBACK_STATUS_NAME_RESOLVED:
+                phases->resolved = now;
+                break;
+            case WINHTTP_CALLBACK_STATUS_CONNECTING_TO_SERVER:
+                phases->connecting = now;
+                break;
+            case WINHTTP_CALLBACK_STATUS_CONNECTED_TO_SERVER:
+                phases->connected = now;
+                break;
+            case WINHTTP_CALLBACK_STATUS_SENDING_REQUEST:
+                phases->sending = now;
+                break;
+        }
+    }
+
     // RAII wrapper for HINTERNET handles.
     struct HInternetWrapper {
         HINTERNET handle;
@@ -86,17 +407,36 @@ namespace yoyo::net {
         }
     };
 
-    void Client::setup() {
-        // Already setup.
-        if (this->internal) {
-            return;
-        }
+    // A `Client` session. Connect handles are kept per scheme, domain and port so WinHTTP can reuse
+    // the keep-alive sockets behind them.
+    struct WinSession {
+        HInternetWrapper session;
+        std::mutex lock;
+        std::map<std::string, std::unique_ptr<HInternetWrapper>> connects;
+
+        WinSession(HINTERNET h) : session(h) {}
+
+        // Get or open the connect handle for a server.
+        HINTERNET connect(const std::string& domain, int port, bool https) {
+            auto key = (https ? "https://" : "http://") + domain + ":" + std::to_string(port);
+            std::lock_guard<std::mutex> guard(lock);
+            auto found = connects.find(key);
+            if (found != connects.end()) {
+                return found->second->handle;
+            }
 
-        auto user_agent = this->data.user_agent;
-        if (user_agent.empty()) {
-            user_agent = "yoyo_rt";
+            auto wdomain_name = yoyo::utils::str::to_wstring(domain);
+            HINTERNET h_connect = WinHttpConnect(session.handle, wdomain_name.c_str(), port, 0);
+            if (!h_connect) {
+                throw std::runtime_error(get_error());
+            }
+            connects[key] = std::make_unique<HInternetWrapper>(h_connect);
+            return h_connect;
         }
+    };
 
+    // Open a new WinHTTP session.
+    std::shared_ptr<void> open_session(const std::string& user_agent) {
         std::wstring wuser_agent = yoyo::utils::str::to_wstring(user_agent);
 
         HINTERNET h_session = WinHttpOpen(
@@ -111,22 +451,49 @@ namespace yoyo::net {
             throw std::runtime_error(get_error());
         }
 
-        // Wrap it and save it.
-        auto wrapper = new HInternetWrapper(h_session);
+        // Wrap it.
+        return std::shared_ptr<void>(new WinSession(h_session), [](void* ptr) {
+            delete static_cast<WinSession*>(ptr);
+        });
+    }
 
-        this->internal = static_cast<void*>(wrapper);
+    void Client::setup() {
+        // Already setup.
+        if (this->internal) {
+            return;
+        }
+
+        auto user_agent = this->data.user_agent;
+        if (user_agent.empty()) {
+            user_agent = "yoyo_rt";
+        }
+
+        if (!this->shared_session) {
+            this->internal = open_session(user_agent);
+            return;
+        }
+
+        // One process wide session per user agent. WinHTTP caches DNS and TLS sessions inside it.
+        static std::mutex sessions_lock;
+        static std::map<std::string, std::shared_ptr<void>> sessions;
+        std::lock_guard<std::mutex> guard(sessions_lock);
+        auto& session = sessions[user_agent];
+        if (!session) {
+            session = open_session(user_agent);
+        }
+        this->internal = session;
     }
-    ClientResponse* Client::create_request(const std::string& path, const RequestType& rt) {
+    ClientResponse* Client::create_request(const std::string& path, const RequestType& rt, const BodySink& sink) {
         // convert back to session
         if (this->internal == nullptr) {
             throw std::runtime_error("Client.win32.internal is null.");
         }
-        auto wrapper = static_cast<HInternetWrapper*>(this->internal);
-        auto wdomain_name = yoyo::utils::str::to_wstring(this->data.domain_name);
+        auto wrapper = static_cast<WinSession*>(this->internal.get());
+        StatsScope stats(this->data.domain_name);
 
         // Set timeouts
         WinHttpSetTimeouts(
-            wrapper->handle,
+            wrapper->session.handle,
             this->data.timeout,
             this->data.timeout,
             this->data.timeout,
@@ -141,32 +508,25 @@ namespace yoyo::net {
             default_port = INTERNET_DEFAULT_HTTP_PORT;
         }
 
-        // Connect to the server yo!
-        HINTERNET h_connect = WinHttpConnect(
-            wrapper->handle,
-            wdomain_name.c_str(),
-            default_port,
-            0
-        );
-
-        if (!h_connect) {
-            // Get error
-            throw std::runtime_error(get_error());
+        // Keep-alive sockets per server.
+        DWORD max_conns = static_cast<DWORD>(this->max_connections);
+        if (max_conns > 0) {
+            WinHttpSetOption(wrapper->session.handle, WINHTTP_OPTION_MAX_CONNS_PER_SERVER, &max_conns, sizeof(max_conns));
         }
 
-        // We are now connected to a server. Lets wrap it
-        auto connect_wrapper = HInternetWrapper(h_connect);
+        // Connect to the server yo! Reuses the handle from the last request to this server.
+        HINTERNET h_connect = wrapper->connect(this->data.domain_name, default_port, this->use_https);
 
         // Get the request type
         // Create the request.
         HINTERNET h_request = WinHttpOpenRequest(
-            connect_wrapper.handle,
+            h_connect,
             get_request_type(rt).c_str(),
             yoyo::utils::str::to_wstring(path).c_str(),
             nullptr,
             WINHTTP_NO_REFERER,
             WINHTTP_DEFAULT_ACCEPT_TYPES,
-            WINHTTP_FLAG_SECURE
+            this->use_https ? WINHTTP_FLAG_SECURE : 0
         );
 
         if (!h_request) {
@@ -174,9 +534,26 @@ namespace yoyo::net {
         }
         auto request_wrapper = HInternetWrapper(h_request);
 
+        // Opt into HTTP/2 (and HTTP/3 where the SDK and OS have it). WinHTTP multiplexes concurrent
+        // requests to the same server over one connection once it is negotiated.
+        #ifdef WINHTTP_OPTION_ENABLE_HTTP_PROTOCOL
+        if (this->data.version != HttpVersion::HTTP_1_1) {
+            DWORD protocols = WINHTTP_PROTOCOL_FLAG_HTTP2;
+            #ifdef WINHTTP_PROTOCOL_FLAG_HTTP3
+            if (this->data.version == HttpVersion::HTTP_3) {
+                protocols |= WINHTTP_PROTOCOL_FLAG_HTTP3;
+            }
+            #endif
+            WinHttpSetOption(request_wrapper.handle, WINHTTP_OPTION_ENABLE_HTTP_PROTOCOL, &protocols, sizeof(protocols));
+        }
+        #endif
+
         // Get headers
         wchar_t* headers_string = NULL;
         auto header_parts = get_header_parts();
+        if (this->decompress && !has_header(this->data.headers, "accept-encoding")) {
+            header_parts.push_back("Accept-Encoding:\tgzip, deflate");
+        }
         if (header_parts.size() > 0) {
             // Do stuff
             std::string total = yoyo::utils::str::join("\r\n", header_parts);
@@ -190,6 +567,10 @@ namespace yoyo::net {
             tha_body = (LPVOID)this->data.body.data();
         }
 
+        // Time the phases.
+        PhaseClock phases;
+        WinHttpSetStatusCallback(request_wrapper.handle, on_status, WINHTTP_CALLBACK_FLAG_ALL_NOTIFICATIONS, 0);
+
         // Send request
         BOOL ok;
         if (rt == RequestType::GET) {
@@ -200,7 +581,7 @@ namespace yoyo::net {
                 WINHTTP_NO_REQUEST_DATA,
                 0,
                 0,
-                0
+                reinterpret_cast<DWORD_PTR>(&phases)
             );
         } else if (rt == RequestType::POST) {
             // Send body
@@ -211,7 +592,7 @@ namespace yoyo::net {
                 tha_body,
                 this->data.body.size(),
                 this->data.body.size(),
-                0
+                reinterpret_cast<DWORD_PTR>(&phases)
             );
         }
         // todo(jc) Add other methods.
@@ -229,8 +610,77 @@ namespace yoyo::net {
         if (!ok) {
             throw std::runtime_error(get_error());
         }
+        auto first_byte = Clock::now();
+        WinHttpSetStatusCallback(request_wrapper.handle, nullptr, WINHTTP_CALLBACK_FLAG_ALL_NOTIFICATIONS, 0);
+
+        // No connect notifications means a keep-alive connection was used.
+        Timings timings;
+        Clock::time_point none{};
+        timings.reused = phases.connected == none;
+        if (phases.resolving != none && phases.resolved != none) {
+            timings.dns = elapsed_ms(phases.resolving, phases.resolved);
+        }
+        if (phases.connecting != none && phases.connected != none) {
+            timings.connect = elapsed_ms(phases.connecting, phases.connected);
+            // The TLS handshake sits between connecting and sending.
+            if (this->use_https && phases.sending != none) {
+                timings.tls = elapsed_ms(phases.connected, phases.sending);
+            }
+        }
+        timings.ttfb = elapsed_ms(phases.sending != none ? phases.sending : stats.start, first_byte);
+
+        // What was actually negotiated.
+        HttpVersion version_used = HttpVersion::HTTP_1_1;
+        #ifdef WINHTTP_OPTION_HTTP_PROTOCOL_USED
+        DWORD protocol_used = 0;
+        DWORD protocol_size = sizeof(protocol_used);
+        if (WinHttpQueryOption(request_wrapper.handle, WINHTTP_OPTION_HTTP_PROTOCOL_USED, &protocol_used, &protocol_size)) {
+            if (protocol_used & WINHTTP_PROTOCOL_FLAG_HTTP2) {
+                version_used = HttpVersion::HTTP_2;
+            }
+            #ifdef WINHTTP_PROTOCOL_FLAG_HTTP3
+            if (protocol_used & WINHTTP_PROTOCOL_FLAG_HTTP3) {
+                version_used = HttpVersion::HTTP_3;
+            }
+            #endif
+        }
+        #endif
+        // Get status code.
+        DWORD status_code = 0;
+        DWORD size = sizeof(status_code);
+
+        WinHttpQueryHeaders(
+            request_wrapper.handle,
+            WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+            WINHTTP_HEADER_NAME_BY_INDEX,
+            &status_code,
+            &size,
+            WINHTTP_NO_HEADER_INDEX
+        );
+
+        // Compressed?
+        std::unique_ptr<Inflater> inflater;
+        if (this->decompress) {
+            DWORD encoding_size = 0;
+            WinHttpQueryHeaders(request_wrapper.handle, WINHTTP_QUERY_CONTENT_ENCODING, WINHTTP_HEADER_NAME_BY_INDEX, WINHTTP_NO_OUTPUT_BUFFER, &encoding_size, WINHTTP_NO_HEADER_INDEX);
+            if (GetLastError() == ERROR_INSUFFICIENT_BUFFER && encoding_size > 0) {
+                std::vector<wchar_t> encoding(encoding_size / sizeof(wchar_t) + 1, L'\0');
+                if (WinHttpQueryHeaders(request_wrapper.handle, WINHTTP_QUERY_CONTENT_ENCODING, WINHTTP_HEADER_NAME_BY_INDEX, encoding.data(), &encoding_size, WINHTTP_NO_HEADER_INDEX)) {
+                    inflater = inflater_for(yoyo::utils::str::from_wstring(encoding.data()));
+                }
+            }
+        }
+
         // Read response
         std::string response;
+        std::vector<char> buffer;
+        std::function<void(const char*, size_t)> emit = [&](const char* data, size_t len) {
+            if (sink) {
+                sink(static_cast<int>(status_code), data, len);
+            } else {
+                response.append(data, len);
+            }
+        };
         DWORD bytes_avail;
         do {
             if (!WinHttpQueryDataAvailable(request_wrapper.handle, &bytes_avail)) {
@@ -241,7 +691,7 @@ namespace yoyo::net {
                 break;
             }
 
-            std::vector<char> buffer(bytes_avail);
+            buffer.resize(bytes_avail);
             DWORD bytes_read = 0;
 
             if (!WinHttpReadData(
@@ -253,36 +703,878 @@ namespace yoyo::net {
                 break;
             }
 
-            response.append(buffer.data(), bytes_read);
+            if (inflater) {
+                inflater->feed(buffer.data(), bytes_read, emit);
+            } else {
+                emit(buffer.data(), bytes_read);
+            }
         } while (bytes_avail > 0);
-
-        // Get status code.
-        DWORD status_code = 0;
-        DWORD size = sizeof(status_code);
-
-        WinHttpQueryHeaders(
-            request_wrapper.handle,
-            WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
-            WINHTTP_HEADER_NAME_BY_INDEX,
-            &status_code,
-            &size,
-            WINHTTP_NO_HEADER_INDEX
-        );
+        auto finished = Clock::now();
+        timings.transfer = elapsed_ms(first_byte, finished);
+        timings.total = elapsed_ms(stats.start, finished);
+        stats.status = static_cast<int>(status_code);
 
         // Now lets return the response yo!
         auto cr = new ClientResponse();
         cr->data.headers = this->data.headers;
-        cr->data.body = response;
+        cr->data.body = std::move(response);
         cr->data.domain_name = this->data.domain_name;
-        cr->data.version = this->data.version;
+        cr->data.version = version_used;
         cr->data.user_agent = this->data.user_agent;
         cr->data.timeout = this->data.timeout;
         cr->data.request_type = rt;
+        cr->data.timings = timings;
         cr->status = status_code;
         
         return cr;
     }
     // ================================= WINDOWS END ================================= 
+    #else
+    // ================================= POSIX ================================= 
+    #if defined(MSG_NOSIGNAL)
+    constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+    #else
+    constexpr int SEND_FLAGS = 0;
+    #endif
+
+    // Get request type for HTTP/1.1
+    std::string get_request_type(RequestType rt) {
+        switch (rt) {
+            case RequestType::GET:
+                return "GET";
+            case RequestType::POST:
+                return "POST";
+            case RequestType::PATCH:
+                return "PATCH";
+            case RequestType::PUT:
+                return "PUT";
+            case RequestType::DELETE:
+                return "DELETE";
+        }
+        return "GET";
+    }
+
+    #if defined(YOYO_NET_OPENSSL)
+    // The process wide TLS context. Peers are verified against the system store.
+    SSL_CTX* tls_context() {
+        static SSL_CTX* ctx = [] {
+            auto ctx = SSL_CTX_new(TLS_client_method());
+            if (ctx) {
+                SSL_CTX_set_default_verify_paths(ctx);
+                SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, nullptr);
+                SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+                SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT);
+            }
+            return ctx;
+        }();
+        return ctx;
+    }
+    #endif
+
+    // Receives body bytes as they are read.
+    using Emit = std::function<void(const char*, size_t)>;
+
+    // A resolved address.
+    struct Address {
+        int family;
+        int socktype;
+        int protocol;
+        sockaddr_storage addr;
+        socklen_t len;
+    };
+
+    // Process wide `getaddrinfo` cache.
+    struct DnsCache {
+        struct Entry {
+            std::vector<Address> addrs;
+            std::chrono::steady_clock::time_point expires;
+        };
+
+        std::mutex lock;
+        std::map<std::string, Entry> entries;
+        std::chrono::milliseconds ttl{60000};
+
+        // Resolve `host`, from the cache when fresh. Throws when it can not be resolved.
+        std::vector<Address> resolve(const std::string& host, int port) {
+            auto key = host + ":" + std::to_string(port);
+            auto now = std::chrono::steady_clock::now();
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                auto found = entries.find(key);
+                if (found != entries.end() && now < found->second.expires) {
+                    return found->second.addrs;
+                }
+            }
+
+            addrinfo hints{};
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+            addrinfo* res = nullptr;
+            int gai = ::getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res);
+            if (gai != 0) {
+                throw std::runtime_error(std::string("Could not resolve host: ") + gai_strerror(gai));
+            }
+
+            std::vector<Address> addrs;
+            for (auto ai = res; ai != nullptr; ai = ai->ai_next) {
+                Address a{ai->ai_family, ai->ai_socktype, ai->ai_protocol, {}, static_cast<socklen_t>(ai->ai_addrlen)};
+                std::memcpy(&a.addr, ai->ai_addr, ai->ai_addrlen);
+                addrs.push_back(a);
+            }
+            ::freeaddrinfo(res);
+
+            std::lock_guard<std::mutex> guard(lock);
+            if (ttl.count() > 0) {
+                entries[key] = {addrs, now + ttl};
+            }
+            return addrs;
+        }
+
+        void set_ttl(int64_t ttl_ms) {
+            std::lock_guard<std::mutex> guard(lock);
+            ttl = std::chrono::milliseconds(std::max<int64_t>(0, ttl_ms));
+            entries.clear();
+        }
+    };
+
+    DnsCache& dns_cache() {
+        static DnsCache cache;
+        return cache;
+    }
+
+    #if defined(YOYO_NET_OPENSSL)
+    // TLS sessions to resume, per host and port.
+    struct TlsSessions {
+        std::mutex lock;
+        std::map<std::string, SSL_SESSION*> sessions;
+
+        ~TlsSessions() {
+            for (auto& [key, session] : sessions) {
+                SSL_SESSION_free(session);
+            }
+        }
+
+        // Returns a new reference, or null.
+        SSL_SESSION* get(const std::string& key) {
+            std::lock_guard<std::mutex> guard(lock);
+            auto found = sessions.find(key);
+            if (found == sessions.end()) {
+                return nullptr;
+            }
+            SSL_SESSION_up_ref(found->second);
+            return found->second;
+        }
+
+        // Takes the reference.
+        void put(const std::string& key, SSL_SESSION* session) {
+            std::lock_guard<std::mutex> guard(lock);
+            auto& slot = sessions[key];
+            if (slot) {
+                SSL_SESSION_free(slot);
+            }
+            slot = session;
+        }
+    };
+
+    TlsSessions& tls_sessions() {
+        static TlsSessions sessions;
+        return sessions;
+    }
+    #endif
+
+    // A TCP connection, TLS when `https`. The socket is non blocking and every wait goes through `poll`
+    // with the `Client` timeout.
+    struct Connection {
+        int fd = -1;
+        std::string host;
+        int port = 0;
+        bool https = false;
+        // Received but not consumed yet.
+        std::string inbox;
+        // What the TLS layer is waiting for.
+        short want = POLLIN;
+        // How long `open` took per phase.
+        double dns_ms = 0;
+        double connect_ms = 0;
+        double tls_ms = 0;
+    #if defined(YOYO_NET_OPENSSL)
+        SSL* ssl = nullptr;
+    #elif defined(__APPLE__)
+        SSLContextRef ssl = nullptr;
+    #endif
+
+        Connection() {}
+        ~Connection() {
+            close();
+        }
+
+        Connection(const Connection&) = delete;
+        Connection& operator=(const Connection&) = delete;
+
+        void close();
+        // Wait for `events` or throw on timeout.
+        void wait(short events, int timeout_ms);
+        void open(const std::string& host, int port, bool https, int timeout_ms);
+        void handshake(int timeout_ms);
+        void send_all(const char* data, size_t len, int timeout_ms);
+        // Returns 0 once the peer closed.
+        size_t recv_some(char* data, size_t len, int timeout_ms);
+        // Read until `\r\n`, returns the line without it.
+        std::string read_line(int timeout_ms);
+        // Read exactly `len` bytes into `emit`.
+        void read_exact(size_t len, const Emit& emit, int timeout_ms);
+        // Read everything until the peer closes into `emit`.
+        void read_to_end(const Emit& emit, int timeout_ms);
+        // Is an idle connection still usable? Idle connections should have nothing to read.
+        bool alive();
+    };
+
+    // Idle keep-alive connections of a `Client`, keyed by scheme, host and port.
+    struct ConnectionPool {
+        struct Idle {
+            std::unique_ptr<Connection> conn;
+            std::chrono::steady_clock::time_point since;
+        };
+
+        std::mutex lock;
+        std::map<std::string, std::deque<Idle>> idle;
+
+        static std::string key(const std::string& host, int port, bool https) {
+            return (https ? "https://" : "http://") + host + ":" + std::to_string(port);
+        }
+
+        // Take an idle connection, or null if there is none that is fresh enough.
+        std::unique_ptr<Connection> acquire(const std::string& host, int port, bool https, int idle_timeout_ms) {
+            std::lock_guard<std::mutex> guard(lock);
+            auto found = idle.find(key(host, port, https));
+            if (found == idle.end()) {
+                return nullptr;
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            auto& queue = found->second;
+            while (!queue.empty()) {
+                auto item = std::move(queue.back());
+                queue.pop_back();
+                if (now - item.since < std::chrono::milliseconds(idle_timeout_ms) && item.conn->alive()) {
+                    return std::move(item.conn);
+                }
+            }
+            return nullptr;
+        }
+
+        // Give a connection back. The oldest one is closed past `max_idle`.
+        void release(std::unique_ptr<Connection> conn, size_t max_idle) {
+            std::lock_guard<std::mutex> guard(lock);
+            auto& queue = idle[key(conn->host, conn->port, conn->https)];
+            while (!queue.empty() && queue.size() >= max_idle) {
+                queue.pop_front();
+            }
+            queue.push_back({std::move(conn), std::chrono::steady_clock::now()});
+        }
+    };
+
+    #if defined(__APPLE__) && !defined(YOYO_NET_OPENSSL)
+    // SecureTransport IO callbacks.
+    OSStatus st_read(SSLConnectionRef ref, void* data, size_t* len) {
+        auto conn = const_cast<Connection*>(static_cast<const Connection*>(ref));
+        size_t want = *len;
+        size_t got = 0;
+        while (got < want) {
+            auto n = ::recv(conn->fd, static_cast<char*>(data) + got, want - got, 0);
+            if (n > 0) {
+                got += static_cast<size_t>(n);
+                continue;
+            }
+            *len = got;
+            if (n == 0) {
+                return errSSLClosedGraceful;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                conn->want = POLLIN;
+                return errSSLWouldBlock;
+            }
+            return errSSLClosedAbort;
+        }
+        *len = got;
+        return noErr;
+    }
+
+    OSStatus st_write(SSLConnectionRef ref, const void* data, size_t* len) {
+        auto conn = const_cast<Connection*>(static_cast<const Connection*>(ref));
+        size_t want = *len;
+        size_t sent = 0;
+        while (sent < want) {
+            auto n = ::send(conn->fd, static_cast<const char*>(data) + sent, want - sent, SEND_FLAGS);
+            if (n > 0) {
+                sent += static_cast<size_t>(n);
+                continue;
+            }
+            *len = sent;
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                conn->want = POLLOUT;
+                return errSSLWouldBlock;
+            }
+            return errSSLClosedAbort;
+        }
+        *len = sent;
+        return noErr;
+    }
+    #endif
+
+    void Connection::close() {
+    #if defined(YOYO_NET_OPENSSL)
+        if (this->ssl) {
+            // Keep the session around for the next connection to this server.
+            auto session = SSL_get1_session(this->ssl);
+            if (session && SSL_SESSION_is_resumable(session)) {
+                tls_sessions().put(this->host + ":" + std::to_string(this->port), session);
+            } else if (session) {
+                SSL_SESSION_free(session);
+            }
+            SSL_shutdown(this->ssl);
+            SSL_free(this->ssl);
+            this->ssl = nullptr;
+        }
+    #elif defined(__APPLE__)
+        if (this->ssl) {
+            SSLClose(this->ssl);
+            CFRelease(this->ssl);
+            this->ssl = nullptr;
+        }
+    #endif
+        if (this->fd != -1) {
+            ::close(this->fd);
+            this->fd = -1;
+        }
+        this->inbox.clear();
+    }
+
+    void Connection::wait(short events, int timeout_ms) {
+        pollfd p{this->fd, events, 0};
+        int r;
+        do {
+            r = ::poll(&p, 1, timeout_ms);
+        } while (r < 0 && errno == EINTR);
+
+        if (r == 0) {
+            throw std::runtime_error("The request timed out.");
+        }
+        if (r < 0) {
+            throw std::runtime_error(std::strerror(errno));
+        }
+    }
+
+    void Connection::open(const std::string& host, int port, bool https, int timeout_ms) {
+        this->host = host;
+        this->port = port;
+        this->https = https;
+
+        auto started = Clock::now();
+        auto addrs = dns_cache().resolve(host, port);
+        auto resolved = Clock::now();
+        this->dns_ms = elapsed_ms(started, resolved);
+
+        std::string error = "Could not connect to " + host;
+        for (const auto& ai : addrs) {
+            int fd = ::socket(ai.family, ai.socktype, ai.protocol);
+            if (fd < 0) {
+                continue;
+            }
+            ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+            int one = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        #if defined(SO_NOSIGPIPE)
+            ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+        #endif
+
+            int r = ::connect(fd, reinterpret_cast<const sockaddr*>(&ai.addr), ai.len);
+            if (r < 0 && errno == EINPROGRESS) {
+                pollfd p{fd, POLLOUT, 0};
+                do {
+                    r = ::poll(&p, 1, timeout_ms);
+                } while (r < 0 && errno == EINTR);
+
+                if (r == 1) {
+                    int err = 0;
+                    socklen_t len = sizeof(err);
+                    ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+                    r = err == 0 ? 0 : -1;
+                    if (err != 0) {
+                        error = std::strerror(err);
+                    }
+                } else {
+                    error = r == 0 ? "The request timed out." : std::strerror(errno);
+                    r = -1;
+                }
+            } else if (r < 0) {
+                error = std::strerror(errno);
+            }
+
+            if (r == 0) {
+                this->fd = fd;
+                break;
+            }
+            ::close(fd);
+        }
+
+        if (this->fd == -1) {
+            throw std::runtime_error(error);
+        }
+        auto connected = Clock::now();
+        this->connect_ms = elapsed_ms(resolved, connected);
+
+        if (https) {
+            handshake(timeout_ms);
+            this->tls_ms = elapsed_ms(connected, Clock::now());
+        }
+    }
+
+    void Connection::handshake(int timeout_ms) {
+    #if defined(YOYO_NET_OPENSSL)
+        auto ctx = tls_context();
+        if (!ctx) {
+            throw std::runtime_error("Could not create a TLS context.");
+        }
+        this->ssl = SSL_new(ctx);
+        if (!this->ssl) {
+            throw std::runtime_error("Could not create a TLS session.");
+        }
+        SSL_set_fd(this->ssl, this->fd);
+        SSL_set_tlsext_host_name(this->ssl, this->host.c_str());
+        SSL_set1_host(this->ssl, this->host.c_str());
+
+        // Resume the last session with this server if there is one.
+        auto session = tls_sessions().get(this->host + ":" + std::to_string(this->port));
+        if (session) {
+            SSL_set_session(this->ssl, session);
+            SSL_SESSION_free(session);
+        }
+
+        while (true) {
+            int r = SSL_connect(this->ssl);
+            if (r == 1) {
+                break;
+            }
+            int err = SSL_get_error(this->ssl, r);
+            if (err == SSL_ERROR_WANT_READ) {
+                wait(POLLIN, timeout_ms);
+            } else if (err == SSL_ERROR_WANT_WRITE) {
+                wait(POLLOUT, timeout_ms);
+            } else {
+                throw std::runtime_error(std::string("TLS handshake failed: ") + ERR_error_string(ERR_get_error(), nullptr));
+            }
+        }
+    #elif defined(__APPLE__)
+        this->ssl = SSLCreateContext(kCFAllocatorDefault, kSSLClientSide, kSSLStreamType);
+        if (!this->ssl) {
+            throw std::runtime_error("Could not create a TLS session.");
+        }
+        SSLSetIOFuncs(this->ssl, st_read, st_write);
+        SSLSetConnection(this->ssl, this);
+        SSLSetPeerDomainName(this->ssl, this->host.c_str(), this->host.size());
+        // Lets SecureTransport resume the session on the next connection to this server.
+        auto peer_id = this->host + ":" + std::to_string(this->port);
+        SSLSetPeerID(this->ssl, peer_id.data(), peer_id.size());
+
+        OSStatus status;
+        while ((status = SSLHandshake(this->ssl)) == errSSLWouldBlock) {
+            wait(this->want, timeout_ms);
+        }
+        if (status != noErr) {
+            throw std::runtime_error("TLS handshake failed: " + std::to_string(status));
+        }
+    #else
+        (void)timeout_ms;
+        throw std::runtime_error("HTTPS is not supported in this build. Enable `yoyo_net_tls`.");
+    #endif
+    }
+
+    void Connection::send_all(const char* data, size_t len, int timeout_ms) {
+        size_t sent = 0;
+        while (sent < len) {
+        #if defined(YOYO_NET_OPENSSL)
+            if (this->ssl) {
+                int r = SSL_write(this->ssl, data + sent, static_cast<int>(len - sent));
+                if (r > 0) {
+                    sent += static_cast<size_t>(r);
+                    continue;
+                }
+                int err = SSL_get_error(this->ssl, r);
+                if (err == SSL_ERROR_WANT_READ) {
+                    wait(POLLIN, timeout_ms);
+                } else if (err == SSL_ERROR_WANT_WRITE) {
+                    wait(POLLOUT, timeout_ms);
+                } else {
+                    throw std::runtime_error("TLS write failed.");
+                }
+                continue;
+            }
+        #elif defined(__APPLE__)
+            if (this->ssl) {
+                size_t processed = 0;
+                auto status = SSLWrite(this->ssl, data + sent, len - sent, &processed);
+                sent += processed;
+                if (status == errSSLWouldBlock) {
+                    wait(this->want, timeout_ms);
+                } else if (status != noErr) {
+                    throw std::runtime_error("TLS write failed: " + std::to_string(status));
+                }
+                continue;
+            }
+        #endif
+            auto n = ::send(this->fd, data + sent, len - sent, SEND_FLAGS);
+            if (n >= 0) {
+                sent += static_cast<size_t>(n);
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                wait(POLLOUT, timeout_ms);
+            } else if (errno != EINTR) {
+                throw std::runtime_error(std::strerror(errno));
+            }
+        }
+    }
+
+    size_t Connection::recv_some(char* data, size_t len, int timeout_ms) {
+        while (true) {
+        #if defined(YOYO_NET_OPENSSL)
+            if (this->ssl) {
+                int r = SSL_read(this->ssl, data, static_cast<int>(len));
+                if (r > 0) {
+                    return static_cast<size_t>(r);
+                }
+                int err = SSL_get_error(this->ssl, r);
+                if (err == SSL_ERROR_WANT_READ) {
+                    wait(POLLIN, timeout_ms);
+                } else if (err == SSL_ERROR_WANT_WRITE) {
+                    wait(POLLOUT, timeout_ms);
+                } else if (err == SSL_ERROR_ZERO_RETURN || (err == SSL_ERROR_SYSCALL && r == 0)) {
+                    return 0;
+                } else {
+                    throw std::runtime_error("TLS read failed.");
+                }
+                continue;
+            }
+        #elif defined(__APPLE__)
+            if (this->ssl) {
+                size_t processed = 0;
+                auto status = SSLRead(this->ssl, data, len, &processed);
+                if (processed > 0) {
+                    return processed;
+                }
+                if (status == errSSLWouldBlock) {
+                    wait(this->want, timeout_ms);
+                } else if (status == errSSLClosedGraceful || status == errSSLClosedNoNotify) {
+                    return 0;
+                } else {
+                    throw std::runtime_error("TLS read failed: " + std::to_string(status));
+                }
+                continue;
+            }
+        #endif
+            auto n = ::recv(this->fd, data, len, 0);
+            if (n >= 0) {
+                return static_cast<size_t>(n);
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                wait(POLLIN, timeout_ms);
+            } else if (errno != EINTR) {
+                throw std::runtime_error(std::strerror(errno));
+            }
+        }
+    }
+
+    std::string Connection::read_line(int timeout_ms) {
+        char buffer[16 * 1024];
+        while (true) {
+            auto end = this->inbox.find("\r\n");
+            if (end != std::string::npos) {
+                auto line = this->inbox.substr(0, end);
+                this->inbox.erase(0, end + 2);
+                return line;
+            }
+
+            auto n = recv_some(buffer, sizeof(buffer), timeout_ms);
+            if (n == 0) {
+                throw std::runtime_error("Connection closed before the response finished.");
+            }
+            this->inbox.append(buffer, n);
+        }
+    }
+
+    void Connection::read_exact(size_t len, const Emit& emit, int timeout_ms) {
+        auto take = std::min(len, this->inbox.size());
+        if (take > 0) {
+            emit(this->inbox.data(), take);
+            this->inbox.erase(0, take);
+        }
+        len -= take;
+
+        char buffer[16 * 1024];
+        while (len > 0) {
+            auto n = recv_some(buffer, std::min(len, sizeof(buffer)), timeout_ms);
+            if (n == 0) {
+                throw std::runtime_error("Connection closed before the response finished.");
+            }
+            emit(buffer, n);
+            len -= n;
+        }
+    }
+
+    void Connection::read_to_end(const Emit& emit, int timeout_ms) {
+        if (!this->inbox.empty()) {
+            emit(this->inbox.data(), this->inbox.size());
+            this->inbox.clear();
+        }
+
+        char buffer[16 * 1024];
+        size_t n;
+        while ((n = recv_some(buffer, sizeof(buffer), timeout_ms)) > 0) {
+            emit(buffer, n);
+        }
+    }
+
+    bool Connection::alive() {
+        if (this->fd == -1 || !this->inbox.empty()) {
+            return false;
+        }
+        // Readable while idle means the peer closed (or sent garbage).
+        pollfd p{this->fd, POLLIN, 0};
+        return ::poll(&p, 1, 0) == 0;
+    }
+
+    // A parsed HTTP/1.1 response.
+    struct HttpResponse {
+        int status = 0;
+        // Lowercase keys.
+        std::map<std::string, std::string> headers;
+        std::string body;
+        // Can the connection be used again?
+        bool keep_alive = false;
+        double ttfb_ms = 0;
+        double transfer_ms = 0;
+    };
+
+    // Send `request` on `conn` and read the response. The body goes to `sink` when set.
+    HttpResponse send_http(Connection& conn, const std::string& request, int timeout_ms, const BodySink& sink, bool decompress) {
+        auto sent = Clock::now();
+        conn.send_all(request.data(), request.size(), timeout_ms);
+
+        HttpResponse res;
+        std::string status_line;
+        // Skip informational responses (100 Continue).
+        do {
+            status_line = conn.read_line(timeout_ms);
+            auto space = status_line.find(' ');
+            if (status_line.compare(0, 5, "HTTP/") != 0 || space == std::string::npos) {
+                throw std::runtime_error("Malformed HTTP response.");
+            }
+            res.status = std::atoi(status_line.c_str() + space + 1);
+            res.headers.clear();
+
+            std::string line;
+            while (!(line = conn.read_line(timeout_ms)).empty()) {
+                auto colon = line.find(':');
+                if (colon == std::string::npos) {
+                    continue;
+                }
+                auto value_start = line.find_first_not_of(" \t", colon + 1);
+                auto value = value_start == std::string::npos ? "" : line.substr(value_start);
+                while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) {
+                    value.pop_back();
+                }
+                res.headers[yoyo::utils::str::to_lower(line.substr(0, colon))] = value;
+            }
+        } while (res.status / 100 == 1);
+        auto first_byte = Clock::now();
+        res.ttfb_ms = elapsed_ms(sent, first_byte);
+
+        auto connection = res.headers.find("connection");
+        auto conn_value = connection == res.headers.end() ? "" : yoyo::utils::str::to_lower(connection->second);
+        if (status_line.compare(0, 8, "HTTP/1.0") == 0) {
+            res.keep_alive = conn_value == "keep-alive";
+        } else {
+            res.keep_alive = conn_value != "close";
+        }
+
+        Emit deliver = [&](const char* data, size_t len) {
+            if (sink) {
+                sink(res.status, data, len);
+            } else {
+                res.body.append(data, len);
+            }
+        };
+
+        // Inflate on the fly when compressed.
+        std::unique_ptr<Inflater> inflater;
+        auto content_encoding = res.headers.find("content-encoding");
+        if (decompress && content_encoding != res.headers.end()) {
+            inflater = inflater_for(content_encoding->second);
+        }
+        Emit emit = deliver;
+        if (inflater) {
+            emit = [&](const char* data, size_t len) {
+                inflater->feed(data, len, deliver);
+            };
+        }
+
+        auto encoding = res.headers.find("transfer-encoding");
+        auto length = res.headers.find("content-length");
+        if (res.status == 204 || res.status == 304) {
+            // No body.
+        } else if (encoding != res.headers.end() && yoyo::utils::str::to_lower(encoding->second).find("chunked") != std::string::npos) {
+            while (true) {
+                auto size_line = conn.read_line(timeout_ms);
+                auto size = std::strtoull(size_line.c_str(), nullptr, 16);
+                if (size == 0) {
+                    // Trailers
+                    while (!conn.read_line(timeout_ms).empty()) {}
+                    break;
+                }
+                conn.read_exact(static_cast<size_t>(size), emit, timeout_ms);
+                conn.read_line(timeout_ms);
+            }
+        } else if (length != res.headers.end()) {
+            auto size = std::strtoull(length->second.c_str(), nullptr, 10);
+            if (!sink && !inflater) {
+                res.body.reserve(static_cast<size_t>(size));
+            }
+            conn.read_exact(static_cast<size_t>(size), emit, timeout_ms);
+        } else {
+            conn.read_to_end(emit, timeout_ms);
+            res.keep_alive = false;
+        }
+        res.transfer_ms = elapsed_ms(first_byte, Clock::now());
+
+        return res;
+    }
+
+    void Client::setup() {
+        // Already setup.
+        if (this->internal) {
+            return;
+        }
+
+        if (!this->shared_session) {
+            this->internal = std::shared_ptr<void>(new ConnectionPool(), [](void* ptr) {
+                delete static_cast<ConnectionPool*>(ptr);
+            });
+            return;
+        }
+
+        // Process wide, connections are keyed by server anyway.
+        static std::shared_ptr<void> shared(new ConnectionPool(), [](void* ptr) {
+            delete static_cast<ConnectionPool*>(ptr);
+        });
+        this->internal = shared;
+    }
+
+    ClientResponse* Client::create_request(const std::string& path, const RequestType& rt, const BodySink& sink) {
+        auto host = this->data.domain_name;
+        int port = this->use_https ? 443 : 80;
+        auto colon = host.rfind(':');
+        if (colon != std::string::npos && host.find(':') == colon) {
+            port = std::atoi(host.c_str() + colon + 1);
+            host = host.substr(0, colon);
+        }
+
+        auto user_agent = this->data.user_agent;
+        if (user_agent.empty()) {
+            user_agent = "yoyo_rt";
+        }
+
+        std::string request = get_request_type(rt) + " " + (path.empty() || path[0] != '/' ? "/" + path : path) + " HTTP/1.1\r\n";
+        request += "Host: " + this->data.domain_name + "\r\n";
+        request += "User-Agent: " + user_agent + "\r\n";
+        if (this->max_connections == 0) {
+            request += "Connection: close\r\n";
+        }
+        for (const auto& [key, value] : this->data.headers) {
+            request += key + ": " + value + "\r\n";
+        }
+        if (this->decompress && !has_header(this->data.headers, "accept-encoding")) {
+            request += "Accept-Encoding: gzip, deflate\r\n";
+        }
+        if (rt != RequestType::GET || !this->data.body.empty()) {
+            request += "Content-Length: " + std::to_string(this->data.body.size()) + "\r\n";
+        }
+        request += "\r\n";
+        request += this->data.body;
+
+        // Never retry once part of the body was handed out.
+        bool emitted = false;
+        BodySink tracked;
+        if (sink) {
+            tracked = [&](int status, const char* data, size_t len) {
+                emitted = true;
+                sink(status, data, len);
+            };
+        }
+
+        StatsScope stats(this->data.domain_name);
+        auto pool = static_cast<ConnectionPool*>(this->internal.get());
+        HttpResponse response;
+        Timings timings;
+        for (int attempt = 0; attempt < 2; attempt++) {
+            std::unique_ptr<Connection> conn;
+            if (pool && attempt == 0) {
+                conn = pool->acquire(host, port, this->use_https, this->idle_timeout);
+            }
+            bool reused = conn != nullptr;
+            if (!conn) {
+                conn = std::make_unique<Connection>();
+                conn->open(host, port, this->use_https, this->data.timeout);
+            }
+            timings = Timings{};
+            timings.reused = reused;
+            if (!reused) {
+                timings.dns = conn->dns_ms;
+                timings.connect = conn->connect_ms;
+                timings.tls = conn->tls_ms;
+            }
+
+            try {
+                response = send_http(*conn, request, this->data.timeout, tracked, this->decompress);
+            } catch (const std::runtime_error&) {
+                // The server may have dropped an idle connection, try once on a fresh one.
+                if (reused && !emitted) {
+                    continue;
+                }
+                throw;
+            }
+
+            timings.ttfb = response.ttfb_ms;
+            timings.transfer = response.transfer_ms;
+
+            if (pool && response.keep_alive && this->max_connections > 0) {
+                pool->release(std::move(conn), this->max_connections);
+            }
+            break;
+        }
+        timings.total = elapsed_ms(stats.start, Clock::now());
+        stats.status = response.status;
+
+        // Now lets return the response yo!
+        auto cr = new ClientResponse();
+        cr->data.headers = this->data.headers;
+        cr->data.body = std::move(response.body);
+        cr->data.domain_name = this->data.domain_name;
+        // Only HTTP/1.1 is spoken here.
+        cr->data.version = HttpVersion::HTTP_1_1;
+        cr->data.user_agent = this->data.user_agent;
+        cr->data.timeout = this->data.timeout;
+        cr->data.request_type = rt;
+        cr->data.timings = timings;
+        cr->status = response.status;
+
+        return cr;
+    }
+    // ================================= POSIX END ================================= 
     #endif 
 
     void free_client(pxs_Opaque ptr) {
@@ -301,16 +1593,6 @@ namespace yoyo::net {
         delete static_cast<ClientResponse*>(ptr);
     }
 
-    Client::~Client() {
-        if (!this->internal) {
-            return;
-        }
-
-        #if defined(_WIN32)
-            delete static_cast<HInternetWrapper*>(this->internal);
-        #endif
-    }
-
     std::vector<std::string> Client::get_header_parts() {
         std::vector<std::string> res;
         for (const auto& [key, value] : this->data.headers) {
@@ -320,13 +1602,40 @@ namespace yoyo::net {
         return res;
     }
 
+    // Bodies handed to scripts by `ClientResponse::prop_bytes`, by their data. Dropped by `free_body`.
+    std::mutex bodies_lock;
+    std::unordered_map<const void*, std::unique_ptr<std::string>> bodies;
+
+    void free_body(void* data) {
+        std::unique_ptr<std::string> body;
+        {
+            std::lock_guard<std::mutex> guard(bodies_lock);
+            auto it = bodies.find(data);
+            if (it == bodies.end()) {
+                return;
+            }
+            // Freed outside the lock.
+            body = std::move(it->second);
+            bodies.erase(it);
+        }
+    }
+
+    ClientResponse::~ClientResponse() {
+        if (this->text_cache != nullptr) {
+            pxs_freevar(this->text_cache);
+        }
+        if (this->bytes_cache != nullptr) {
+            pxs_freevar(this->bytes_cache);
+        }
+    }
+
+    // Classes of the net host objects. Created in `init` since the function lookup is reset with pixelscript.
+    std::optional<pxs::Class<ClientResponse>> client_response_class;
+    std::optional<pxs::Class<Client>> client_class;
+    std::optional<pxs::Class<PendingResponse>> pending_response_class;
+
     pxs_VarT ClientResponse::into_pxs() {
-        auto obj = pxs_newtype(static_cast<pxs_Opaque>(this), free_client_response, "ClientResponse", yoyo::types::NET_ClientResponse);
-        pxs_object_addprop(obj, "version", ClientResponse::prop_version);
-        pxs_object_addprop(obj, "status", ClientResponse::prop_status);
-        pxs_object_addprop(obj, "bytes", ClientResponse::prop_bytes);
-        pxs_object_addprop(obj, "text", ClientResponse::prop_text);
-        return pxs_newhost(obj);
+        return client_response_class->make(this, free_client_response).raw();
     }
 
     pxs_VarT ClientResponse::prop_version(pxs_VarT args) {
@@ -338,47 +1647,70 @@ namespace yoyo::net {
         return pxs_newint(static_cast<int>(self->data.version));
     }
 
-    pxs_VarT ClientResponse::prop_status(pxs_VarT args) {
+    pxs_VarT ClientResponse::prop_status(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<ClientResponse>(args, 0, yoyo::types::NET_ClientResponse);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        return pxs_newint(self->status);
+    }
+
+    pxs_VarT ClientResponse::prop_bytes(pxs_VarT args) {
         auto self = yoyo::utils::pxs::get_type<ClientResponse>(args, 0, yoyo::types::NET_ClientResponse);
         if (!self) {
             return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
         }
 
-        return pxs_newint(self->status);
+        // One buffer over the body, copies of it share the memory.
+        if (self->bytes_cache == nullptr) {
+            auto body = std::make_unique<std::string>(std::move(self->data.body));
+            auto data = body->data();
+            auto len = body->size();
+            self->moved_body = body.get();
+            {
+                std::lock_guard<std::mutex> guard(bodies_lock);
+                bodies.emplace(data, std::move(body));
+            }
+            self->bytes_cache = pxs_newbytes_borrowed(static_cast<pxs_Opaque>(data), len, free_body);
+        }
+        return pxs_newcopy(self->bytes_cache);
     }
 
-    pxs_VarT ClientResponse::prop_bytes(pxs_VarT args) {
+    pxs_VarT ClientResponse::prop_text(pxs_VarT args) {
         auto self = yoyo::utils::pxs::get_type<ClientResponse>(args, 0, yoyo::types::NET_ClientResponse);
         if (!self) {
             return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
         }
 
-        // Convert response into bytes
-        auto response = self->data.body;
-        return pxs_newbytes(static_cast<pxs_Opaque>(response.data()), sizeof(char), response.size());
+        if (self->text_cache == nullptr) {
+            self->text_cache = pxs_newstring(self->body().c_str());
+        }
+        return pxs_newcopy(self->text_cache);
     }
 
-    pxs_VarT ClientResponse::prop_text(pxs_VarT args) {
+    pxs_VarT ClientResponse::prop_timings(pxs_VarT args) {
         auto self = yoyo::utils::pxs::get_type<ClientResponse>(args, 0, yoyo::types::NET_ClientResponse);
         if (!self) {
             return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
         }
 
-        return pxs_newstring(self->data.body.c_str());
+        const auto& t = self->data.timings;
+        auto map = pxs_newmap();
+        pxs_map_addpair(map, pxs_newstring("dns"), pxs_newfloat(t.dns));
+        pxs_map_addpair(map, pxs_newstring("connect"), pxs_newfloat(t.connect));
+        pxs_map_addpair(map, pxs_newstring("tls"), pxs_newfloat(t.tls));
+        pxs_map_addpair(map, pxs_newstring("ttfb"), pxs_newfloat(t.ttfb));
+        pxs_map_addpair(map, pxs_newstring("transfer"), pxs_newfloat(t.transfer));
+        pxs_map_addpair(map, pxs_newstring("total"), pxs_newfloat(t.total));
+        pxs_map_addpair(map, pxs_newstring("reused"), pxs_newbool(t.reused));
+        return map;
     }
 
-    pxs_VarT Client::new_client(pxs_VarT args) {
+    pxs_VarT Client::new_client(pxs_VarT /*args*/) {
         // Create a new client
         auto client = new Client();
-        auto object = pxs_newtype(static_cast<pxs_Opaque>(client), free_client, "Client", yoyo::types::NET_Client);
-        pxs_object_addprop(object, "headers", &Client::prop_headers);
-        pxs_object_addfunc(object, "get_header", &Client::get_header);
-        pxs_object_addfunc(object, "set_header", &Client::set_header);
-        pxs_object_addprop(object, "body", &Client::prop_body);
-        pxs_object_addprop(object, "version", &Client::prop_version);
-        pxs_object_addprop(object, "domain", &Client::prop_domain);
-        pxs_object_addfunc(object, "make_request", &Client::make_request);
-        return pxs_newhost(object);
+        return client_class->make(client, free_client).raw();
     }
 
     // Get the headers from a pxs_VarT
@@ -422,7 +1754,7 @@ namespace yoyo::net {
         if (argc == 1) {
             // Return headers
             auto headers = self->data.headers;
-            auto result = pxs_newlist();
+            auto result = pxs_newlist_with_capacity(headers.size());
 
             for (const auto& [key, value] : headers) {
                 auto it = pxs_newlist();
@@ -545,6 +1877,89 @@ namespace yoyo::net {
         return pxs_newnull();
     }
 
+    pxs_VarT Client::prop_max_connections(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Client>(args, 0, yoyo::types::NET_Client);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        auto argc = pxs_argc(args);
+        if (argc == 1) {
+            return pxs_newint(static_cast<int64_t>(self->max_connections));
+        }
+
+        if (argc == 2) {
+            auto v = pxs_getint(pxs_arg(args, 1));
+            if (v > -1) {
+                self->max_connections = static_cast<size_t>(v);
+            }
+        }
+
+        return pxs_newnull();
+    }
+
+    pxs_VarT Client::prop_idle_timeout(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Client>(args, 0, yoyo::types::NET_Client);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        auto argc = pxs_argc(args);
+        if (argc == 1) {
+            return pxs_newint(self->idle_timeout);
+        }
+
+        if (argc == 2) {
+            auto v = pxs_getint(pxs_arg(args, 1));
+            if (v > -1) {
+                self->idle_timeout = static_cast<int>(v);
+            }
+        }
+
+        return pxs_newnull();
+    }
+
+    pxs_VarT Client::prop_decompress(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Client>(args, 0, yoyo::types::NET_Client);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        auto argc = pxs_argc(args);
+        if (argc == 1) {
+            return pxs_newbool(self->decompress);
+        }
+
+        if (argc == 2) {
+            self->decompress = pxs_getbool(pxs_arg(args, 1));
+        }
+
+        return pxs_newnull();
+    }
+
+    pxs_VarT Client::prop_shared_session(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Client>(args, 0, yoyo::types::NET_Client);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        auto argc = pxs_argc(args);
+        if (argc == 1) {
+            return pxs_newbool(self->shared_session);
+        }
+
+        if (argc == 2) {
+            auto shared = pxs_getbool(pxs_arg(args, 1));
+            if (shared != self->shared_session) {
+                self->shared_session = shared;
+                // Picked up by the next request.
+                self->internal.reset();
+            }
+        }
+
+        return pxs_newnull();
+    }
+
     pxs_VarT Client::make_request(pxs_VarT args) {
         auto self = yoyo::utils::pxs::get_type<Client>(args, 0, yoyo::types::NET_Client);
         if (!self) {
@@ -564,7 +1979,12 @@ namespace yoyo::net {
         // Get the request type
         auto request_t = static_cast<RequestType>(pxs_getint(pxs_arg(args, 2)));
 
-        auto client_response = self->create_request(url, request_t);
+        ClientResponse* client_response = nullptr;
+        try {
+            client_response = self->create_request(url, request_t);
+        } catch (const std::exception& e) {
+            return pxs_newexception(e.what());
+        }
         if (!client_response) {
             return pxs_newnull();
         }
@@ -572,19 +1992,430 @@ namespace yoyo::net {
         return client_response->into_pxs();
     }
 
+    struct PendingState {
+        // Thread that started the request. Only it may touch the pxs vars below.
+        std::thread::id owner;
+
+        std::mutex lock;
+        std::condition_variable cv;
+        bool done = false;
+        std::unique_ptr<ClientResponse> response;
+        std::string error;
+
+        // Owned, nullable.
+        pxs_VarT callback = nullptr;
+        // Owned, nullable.
+        pxs_VarT runtime = nullptr;
+
+        ~PendingState() {
+            if (callback != nullptr) {
+                pxs_freevar(callback);
+            }
+            if (runtime != nullptr) {
+                pxs_freevar(runtime);
+            }
+        }
+
+        // Convert the finished request into a pxs var. The first call hands out the response, later ones a copy.
+        pxs_VarT to_pxs() {
+            if (!response) {
+                if (error.empty()) {
+                    return pxs_newexception("Response was already consumed.");
+                }
+                return pxs_newexception(error.c_str());
+            }
+            if (taken) {
+                return (new ClientResponse(*response))->into_pxs();
+            }
+            taken = true;
+            return response.release()->into_pxs();
+        }
+
+    private:
+        bool taken = false;
+    };
+
+    // Finished requests waiting for `pump`.
+    std::mutex completed_lock;
+    std::vector<std::shared_ptr<PendingState>> completed;
+
+    PendingResponse::PendingResponse(std::shared_ptr<PendingState> state) : state(std::move(state)) {}
+
+    void free_pending_response(pxs_Opaque ptr) {
+        if (!ptr) {
+            return;
+        }
+
+        delete static_cast<PendingResponse*>(ptr);
+    }
+
+    pxs_VarT PendingResponse::done(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<PendingResponse>(args, 0, yoyo::types::NET_PendingResponse);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        std::lock_guard<std::mutex> guard(self->state->lock);
+        return pxs_newbool(self->state->done);
+    }
+
+    pxs_VarT PendingResponse::poll(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<PendingResponse>(args, 0, yoyo::types::NET_PendingResponse);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        int64_t timeout = 0;
+        auto timeout_arg = pxs::Var::from_args(args, 1);
+        if (timeout_arg.is(pxs_Int64) || timeout_arg.is(pxs_UInt64)) {
+            timeout = std::max<int64_t>(0, timeout_arg.get_int());
+        }
+
+        std::unique_lock<std::mutex> guard(self->state->lock);
+        auto done = self->state->cv.wait_for(guard, std::chrono::milliseconds(timeout), [&] { return self->state->done; });
+        return pxs_newbool(done);
+    }
+
+    pxs_VarT PendingResponse::result(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<PendingResponse>(args, 0, yoyo::types::NET_PendingResponse);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        std::unique_lock<std::mutex> guard(self->state->lock);
+        self->state->cv.wait(guard, [&] { return self->state->done; });
+        return self->state->to_pxs();
+    }
+
+    pxs_VarT Client::request_async(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Client>(args, 0, yoyo::types::NET_Client);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        auto url_arg = pxs::Var::from_args(args, 1);
+        if (!url_arg.is(pxs_String)) {
+            return pxs_newexception("Expected URL to be string.");
+        }
+        auto url = url_arg.get_string();
+        auto request_t = static_cast<RequestType>(pxs_getint(pxs_arg(args, 2)));
+
+        auto state = std::make_shared<PendingState>();
+        state->owner = std::this_thread::get_id();
+
+        auto cb_arg = pxs::Var::from_args(args, 3);
+        if (cb_arg.is(pxs_Function)) {
+            // Copying moves the language reference to our copy, keeping it alive.
+            state->callback = pxs_newcopy(cb_arg.raw());
+            state->runtime = pxs_newcopy(pxs_getrt(args));
+        } else if (!cb_arg.is(pxs_Null)) {
+            return yoyo::utils::exceptions::expected_types(cb_arg.raw()->tag, {pxs_Function, pxs_Null});
+        }
+
+        try {
+            self->setup();
+        } catch (const std::exception& e) {
+            return pxs_newexception(e.what());
+        }
+
+        // A snapshot of the settings, sharing the session/connections.
+        auto snapshot = std::make_shared<Client>(*self);
+
+        utils::pool::shared().submit([state, snapshot, url, request_t]() mutable {
+            std::unique_ptr<ClientResponse> response;
+            std::string error;
+            try {
+                response.reset(snapshot->create_request(url, request_t));
+            } catch (const std::exception& e) {
+                error = e.what();
+            }
+
+            {
+                std::lock_guard<std::mutex> guard(state->lock);
+                state->response = std::move(response);
+                state->error = error.empty() && !state->response ? "Request failed." : error;
+                state->done = true;
+            }
+            state->cv.notify_all();
+
+            // Hand our reference to the pump so the vars are freed on the owner thread.
+            std::lock_guard<std::mutex> guard(completed_lock);
+            completed.push_back(std::move(state));
+        });
+
+        return pending_response_class->make(new PendingResponse(state), free_pending_response).raw();
+    }
+
+    pxs_VarT Client::request_many(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Client>(args, 0, yoyo::types::NET_Client);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        auto list = pxs::Var::from_args(args, 1);
+        if (!list.is(pxs_List)) {
+            return yoyo::utils::exceptions::expected_type(list.raw()->tag, pxs_List);
+        }
+
+        struct Item {
+            std::string path;
+            RequestType rt = RequestType::GET;
+            std::unique_ptr<ClientResponse> response;
+            std::string error;
+        };
+
+        std::vector<Item> items(list.list_len());
+        for (size_t i = 0; i < items.size(); i++) {
+            auto entry = list.list_get(static_cast<int>(i));
+            if (entry.is(pxs_String)) {
+                items[i].path = entry.get_string();
+            } else if (entry.is(pxs_List) && entry.list_len() >= 1 && entry.list_get(0).is(pxs_String)) {
+                items[i].path = entry.list_get(0).get_string();
+                if (entry.list_len() >= 2) {
+                    items[i].rt = entry.list_get(1).to_enum<RequestType>();
+                }
+            } else {
+                return yoyo::utils::exceptions::expected_types(entry.raw()->tag, {pxs_String, pxs_List});
+            }
+        }
+
+        try {
+            self->setup();
+        } catch (const std::exception& e) {
+            return pxs_newexception(e.what());
+        }
+
+        // One worker per allowed connection, each pulling the next request.
+        size_t workers = std::min(items.size(), std::max<size_t>(1, self->max_connections));
+        std::mutex lock;
+        std::condition_variable cv;
+        size_t next = 0;
+        size_t running = workers;
+        for (size_t w = 0; w < workers; w++) {
+            utils::pool::shared().submit([&]() {
+                while (true) {
+                    size_t i;
+                    {
+                        std::lock_guard<std::mutex> guard(lock);
+                        if (next >= items.size()) {
+                            break;
+                        }
+                        i = next++;
+                    }
+
+                    try {
+                        items[i].response.reset(self->create_request(items[i].path, items[i].rt));
+                    } catch (const std::exception& e) {
+                        items[i].error = e.what();
+                    }
+                }
+
+                std::lock_guard<std::mutex> guard(lock);
+                if (--running == 0) {
+                    cv.notify_one();
+                }
+            });
+        }
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            cv.wait(guard, [&] { return running == 0; });
+        }
+
+        auto result = pxs_newlist_with_capacity(items.size());
+        for (auto& item : items) {
+            if (item.response) {
+                pxs_listadd(result, item.response.release()->into_pxs());
+            } else {
+                pxs_listadd(result, pxs_newexception(item.error.empty() ? "Request failed." : item.error.c_str()));
+            }
+        }
+        return result;
+    }
+
+    pxs_VarT Client::download(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Client>(args, 0, yoyo::types::NET_Client);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        auto url_arg = pxs::Var::from_args(args, 1);
+        if (!url_arg.is(pxs_String)) {
+            return pxs_newexception("Expected URL to be string.");
+        }
+        auto path_arg = pxs::Var::from_args(args, 2);
+        if (!path_arg.is(pxs_String)) {
+            return yoyo::utils::exceptions::expected_type(path_arg.raw()->tag, pxs_String);
+        }
+        auto url = url_arg.get_string();
+        auto path = path_arg.get_string();
+        auto resume_arg = pxs::Var::from_args(args, 3);
+        bool resume = resume_arg.is(pxs_Bool) && resume_arg.get_bool();
+
+        // Copy so the Range header does not stick to the client.
+        Client client(*self);
+        uintmax_t offset = 0;
+        std::error_code ec;
+        if (resume && std::filesystem::exists(path, ec)) {
+            offset = std::filesystem::file_size(path, ec);
+            if (ec) {
+                offset = 0;
+            }
+        }
+        if (offset > 0) {
+            client.data.headers["Range"] = "bytes=" + std::to_string(offset) + "-";
+        }
+
+        std::ofstream out;
+        bool failed = false;
+        BodySink sink = [&](int status, const char* data, size_t len) {
+            // Don't write error pages into the file.
+            if (status >= 400 || failed) {
+                return;
+            }
+            if (!out.is_open()) {
+                // 206 means the server honored the Range header.
+                auto mode = std::ios::binary | (status == 206 ? std::ios::app : std::ios::trunc);
+                out.open(path, mode);
+                if (!out) {
+                    failed = true;
+                    return;
+                }
+            }
+            out.write(data, static_cast<std::streamsize>(len));
+        };
+
+        ClientResponse* response = nullptr;
+        try {
+            client.setup();
+            response = client.create_request(url, RequestType::GET, sink);
+        } catch (const std::exception& e) {
+            return pxs_newexception(e.what());
+        }
+        if (failed) {
+            delete response;
+            return pxs_newexception(("Could not write to: " + path).c_str());
+        }
+        return response->into_pxs();
+    }
+
+    pxs_VarT Client::stream(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Client>(args, 0, yoyo::types::NET_Client);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        auto url_arg = pxs::Var::from_args(args, 1);
+        if (!url_arg.is(pxs_String)) {
+            return pxs_newexception("Expected URL to be string.");
+        }
+        auto url = url_arg.get_string();
+        auto request_t = static_cast<RequestType>(pxs_getint(pxs_arg(args, 2)));
+        auto callback = pxs_arg(args, 3);
+        if (!pxs_varis(callback, pxs_Function)) {
+            return yoyo::utils::exceptions::expected_type(callback->tag, pxs_Function);
+        }
+        size_t chunk_size = 64 * 1024;
+        auto chunk_arg = pxs::Var::from_args(args, 4);
+        if ((chunk_arg.is(pxs_Int64) || chunk_arg.is(pxs_UInt64)) && chunk_arg.get_int() > 0) {
+            chunk_size = static_cast<size_t>(chunk_arg.get_int());
+        }
+        auto rt = pxs_getrt(args);
+
+        std::string pending;
+        pending.reserve(chunk_size);
+        auto flush = [&](const char* data, size_t len) {
+            auto cb_args = pxs_newlist();
+            pxs_listadd(cb_args, pxs_newbytes(static_cast<pxs_Opaque>(const_cast<char*>(data)), sizeof(char), len));
+            auto res = pxs_varcall(rt, callback, cb_args);
+            bool stop = res != nullptr && pxs_varis(res, pxs_Bool) && !pxs_getbool(res);
+            if (res != nullptr) {
+                pxs_freevar(res);
+            }
+            if (stop) {
+                throw std::runtime_error("Stream stopped by callback.");
+            }
+        };
+        BodySink sink = [&](int /*status*/, const char* data, size_t len) {
+            // Fixed size chunks, straight from the read buffer when possible.
+            while (len > 0) {
+                if (pending.empty() && len >= chunk_size) {
+                    flush(data, chunk_size);
+                    data += chunk_size;
+                    len -= chunk_size;
+                    continue;
+                }
+                auto take = std::min(len, chunk_size - pending.size());
+                pending.append(data, take);
+                data += take;
+                len -= take;
+                if (pending.size() == chunk_size) {
+                    flush(pending.data(), pending.size());
+                    pending.clear();
+                }
+            }
+        };
+
+        ClientResponse* response = nullptr;
+        try {
+            self->setup();
+            response = self->create_request(url, request_t, sink);
+            if (!pending.empty()) {
+                flush(pending.data(), pending.size());
+            }
+        } catch (const std::exception& e) {
+            delete response;
+            return pxs_newexception(e.what());
+        }
+        return response->into_pxs();
+    }
+
+    int pump() {
+        int handled = serve_pump();
+        std::vector<std::shared_ptr<PendingState>> mine;
+        {
+            std::lock_guard<std::mutex> guard(completed_lock);
+            auto me = std::this_thread::get_id();
+            auto it = std::stable_partition(completed.begin(), completed.end(), [&](const std::shared_ptr<PendingState>& s) {
+                return s->owner != me;
+            });
+            std::move(it, completed.end(), std::back_inserter(mine));
+            completed.erase(it, completed.end());
+        }
+
+        for (auto& state : mine) {
+            if (state->callback == nullptr) {
+                continue;
+            }
+
+            pxs_VarT response;
+            {
+                std::lock_guard<std::mutex> guard(state->lock);
+                response = state->to_pxs();
+            }
+            auto cb_args = pxs_newlist();
+            pxs_listadd(cb_args, response);
+            auto res = pxs_varcall(state->runtime, state->callback, cb_args);
+            if (res != nullptr) {
+                pxs_freevar(res);
+            }
+        }
+
+        return handled + static_cast<int>(mine.size());
+    }
+
     // Get domain name and path from a pxs_VarT url
     std::array<std::string, 2> get_domain_and_path(pxs_VarT url) {
         std::array<std::string, 2> result({"", ""});
 
-        auto cstr = pxs_getstring(url);
+        size_t len = 0;
+        auto cstr = pxs_getstrview(url, &len);
         if (!cstr) {
             return result;
         }
 
-        std::stringstream Url(cstr);
+        std::stringstream Url(std::string(cstr, len));
         std::vector<std::string> paths;
         std::string token;
-        pxs_freestr(cstr);
 
         while (std::getline(Url, token, '/')) {
             paths.push_back(token);
@@ -649,7 +2480,166 @@ namespace yoyo::net {
         return result;
     }
 
+    pxs_VarT fetch_all(pxs_VarT args) {
+        auto list = pxs::Var::from_args(args, 0);
+        if (!list.is(pxs_List)) {
+            return yoyo::utils::exceptions::expected_type(list.raw()->tag, pxs_List);
+        }
+        auto concurrency_arg = pxs::Var::from_args(args, 1);
+        size_t max_concurrency = 6;
+        if (concurrency_arg.is(pxs_Int64) || concurrency_arg.is(pxs_UInt64)) {
+            max_concurrency = static_cast<size_t>(std::max<int64_t>(1, concurrency_arg.get_int()));
+        }
+        auto timeout_arg = pxs::Var::from_args(args, 2);
+        int timeout = 30000;
+        if (timeout_arg.is(pxs_Int64) || timeout_arg.is(pxs_UInt64)) {
+            timeout = static_cast<int>(timeout_arg.get_int());
+        }
+        auto rt = pxs_getrt(args);
+
+        struct Item {
+            Client client;
+            std::string path;
+            RequestType rt = RequestType::GET;
+            std::unique_ptr<ClientResponse> response;
+            std::string error;
+        };
+
+        // Everything pixelscript is read here, the workers only see native data.
+        std::vector<Item> items(list.list_len());
+        for (size_t i = 0; i < items.size(); i++) {
+            auto entry = list.list_get(static_cast<int>(i));
+            bool is_descriptor = entry.is(pxs_List) && entry.list_len() >= 1 && entry.list_get(0).is(pxs_String);
+            if (!entry.is(pxs_String) && !is_descriptor) {
+                return yoyo::utils::exceptions::expected_types(entry.raw()->tag, {pxs_String, pxs_List});
+            }
+            auto url = is_descriptor ? entry.list_get(0) : entry.copy_owned();
+
+            auto& item = items[i];
+            auto url_str = url.get_string();
+            auto paths = get_domain_and_path(url.raw());
+            item.client.use_https = url_str.compare(0, 7, "http://") != 0;
+            item.client.data.domain_name = paths[0];
+            item.client.data.timeout = timeout;
+            // Keep enough idle connections around for the batch.
+            item.client.max_connections = std::max(item.client.max_connections, max_concurrency);
+            item.path = paths[1];
+
+            if (is_descriptor) {
+                if (entry.list_len() >= 2) {
+                    item.rt = entry.list_get(1).to_enum<RequestType>();
+                }
+                if (entry.list_len() >= 3 && !entry.list_get(2).is(pxs_Null)) {
+                    auto body = entry.list_get(2);
+                    std::string value(pxs_varsize(body.raw()) / sizeof(char), '\0');
+                    pxs_smart_copystring(rt, body.raw(), value.data());
+                    item.client.data.body = value;
+                }
+                if (entry.list_len() >= 4 && entry.list_get(3).is(pxs_List)) {
+                    item.client.data.headers = get_headers(rt, entry.list_get(3).raw());
+                }
+            }
+
+            if (item.client.data.domain_name.empty()) {
+                item.error = "Expected URL with a domain, found " + url_str;
+            }
+        }
+
+        // `max_concurrency` workers, each pulling the next request.
+        size_t workers = std::min(items.size(), max_concurrency);
+        std::mutex lock;
+        std::condition_variable cv;
+        size_t next = 0;
+        size_t running = workers;
+        for (size_t w = 0; w < workers; w++) {
+            utils::pool::shared().submit([&]() {
+                while (true) {
+                    size_t i;
+                    {
+                        std::lock_guard<std::mutex> guard(lock);
+                        if (next >= items.size()) {
+                            break;
+                        }
+                        i = next++;
+                    }
+
+                    auto& item = items[i];
+                    if (!item.error.empty()) {
+                        continue;
+                    }
+                    try {
+                        item.client.setup();
+                        item.response.reset(item.client.create_request(item.path, item.rt));
+                    } catch (const std::exception& e) {
+                        item.error = e.what();
+                    }
+                }
+
+                std::lock_guard<std::mutex> guard(lock);
+                if (--running == 0) {
+                    cv.notify_one();
+                }
+            });
+        }
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            cv.wait(guard, [&] { return running == 0; });
+        }
+
+        auto result = pxs_newlist_with_capacity(items.size());
+        for (auto& item : items) {
+            if (item.response) {
+                pxs_listadd(result, item.response.release()->into_pxs());
+            } else {
+                pxs_listadd(result, pxs_newexception(item.error.empty() ? "Request failed." : item.error.c_str()));
+            }
+        }
+        return result;
+    }
+
+    pxs_VarT set_dns_ttl(pxs_VarT args) {
+        PXS_ARGC_EQ(1); // ttl_ms
+        auto ttl = pxs::Var::from_args(args, 0);
+        if (!ttl.is(pxs_Int64) && !ttl.is(pxs_UInt64)) {
+            return yoyo::utils::exceptions::expected_type(ttl.raw()->tag, pxs_Int64);
+        }
+
+        #if !defined(_WIN32)
+        dns_cache().set_ttl(ttl.get_int());
+        #endif
+        return pxs_newnull();
+    }
+
     void init(pxs_Module* yoyo_mod) {
+        client_response_class.emplace("ClientResponse", yoyo::types::NET_ClientResponse);
+        client_response_class->add_property("version", ClientResponse::prop_version);
+        client_response_class->add_property("status", ClientResponse::prop_status);
+        client_response_class->add_property("bytes", ClientResponse::prop_bytes);
+        client_response_class->add_property("text", ClientResponse::prop_text);
+        client_response_class->add_property("timings", ClientResponse::prop_timings);
+
+        client_class.emplace("Client", yoyo::types::NET_Client);
+        client_class->add_property("headers", &Client::prop_headers);
+        client_class->add_method("get_header", &Client::get_header);
+        client_class->add_method("set_header", &Client::set_header);
+        client_class->add_property("body", &Client::prop_body);
+        client_class->add_property("version", &Client::prop_version);
+        client_class->add_property("domain", &Client::prop_domain);
+        client_class->add_property("max_connections", &Client::prop_max_connections);
+        client_class->add_property("idle_timeout", &Client::prop_idle_timeout);
+        client_class->add_property("decompress", &Client::prop_decompress);
+        client_class->add_property("shared_session", &Client::prop_shared_session);
+        client_class->add_method("make_request", &Client::make_request);
+        client_class->add_method("request_async", &Client::request_async);
+        client_class->add_method("request_many", &Client::request_many);
+        client_class->add_method("download", &Client::download);
+        client_class->add_method("stream", &Client::stream);
+
+        pending_response_class.emplace("PendingResponse", yoyo::types::NET_PendingResponse);
+        pending_response_class->add_method("done", &PendingResponse::done);
+        pending_response_class->add_method("poll", &PendingResponse::poll);
+        pending_response_class->add_method("result", &PendingResponse::result);
+
         auto net_mod = pxs_newmod("net");
 
         pxs_addvar(net_mod, "HTTP_VERSION_1_1", pxs_newint(static_cast<int>(HttpVersion::HTTP_1_1)));
@@ -661,6 +2651,10 @@ namespace yoyo::net {
         pxs_addobject(client_mod, "Client", Client::new_client);
         pxs_addfunc(client_mod, "get", get);
         pxs_addfunc(client_mod, "post", post);
+        pxs_addfunc(client_mod, "fetch_all", fetch_all);
+        pxs_addfunc(client_mod, "set_dns_ttl", set_dns_ttl);
+
+        init_server(net_mod);
 
         pxs_add_submod(net_mod, client_mod);
         pxs_add_submod(yoyo_mod, net_mod);
@@ -0,0 +1,1290 @@
+#ifdef YOYO_NET
+
+#include "net.hpp"
+#include <pixelscript_cpp.hpp>
+#include "utils/types.hpp"
+#include "utils/bytes.hpp"
+#include "utils/pxs.hpp"
+#include "utils/exceptions.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+// Winsock has to come before windows.h, which is why the server is not in net.cpp.
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#elif defined(__APPLE__) || defined(__FreeBSD__)
+#include <sys/event.h>
+#define YOYO_SERVE_KQUEUE
+#endif
+#endif
+
+namespace yoyo::net {
+    // The I/O side, named so it does not clash with the client types of net.cpp.
+    namespace serving {
+        using Clock = std::chrono::steady_clock;
+        using Headers = std::vector<std::pair<std::string, std::string>>;
+
+        // Largest request line plus headers.
+        constexpr size_t MAX_HEAD = 16 * 1024;
+        // Bytes read per `recv`.
+        constexpr size_t READ_CHUNK = 16 * 1024;
+        // Poller keys of the listening socket and the waker, connections count up from `FIRST_CONNECTION`.
+        constexpr uint64_t KEY_LISTEN = 0;
+        constexpr uint64_t KEY_WAKE = 1;
+        constexpr uint64_t FIRST_CONNECTION = 2;
+
+    #if defined(_WIN32)
+        using socket_t = SOCKET;
+        const socket_t NO_SOCKET = INVALID_SOCKET;
+
+        void close_socket(socket_t s) {
+            closesocket(s);
+        }
+
+        bool would_block() {
+            return WSAGetLastError() == WSAEWOULDBLOCK;
+        }
+
+        bool set_nonblocking(socket_t s) {
+            u_long on = 1;
+            return ioctlsocket(s, FIONBIO, &on) == 0;
+        }
+
+        bool start_sockets() {
+            static const bool started = [] {
+                WSADATA data;
+                return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+            }();
+            return started;
+        }
+    #else
+        using socket_t = int;
+        const socket_t NO_SOCKET = -1;
+
+        void close_socket(socket_t s) {
+            ::close(s);
+        }
+
+        bool would_block() {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+
+        bool set_nonblocking(socket_t s) {
+            int flags = fcntl(s, F_GETFL, 0);
+            return flags >= 0 && fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0 && fcntl(s, F_SETFD, FD_CLOEXEC) == 0;
+        }
+
+        bool start_sockets() {
+            return true;
+        }
+    #endif
+
+        // Send without raising SIGPIPE on a closed peer.
+        int send_some(socket_t s, const char* data, size_t len) {
+        #if defined(_WIN32)
+            return ::send(s, data, static_cast<int>(std::min<size_t>(len, INT32_MAX)), 0);
+        #elif defined(MSG_NOSIGNAL)
+            return static_cast<int>(::send(s, data, len, MSG_NOSIGNAL));
+        #else
+            // SO_NOSIGPIPE is set on the socket.
+            return static_cast<int>(::send(s, data, len, 0));
+        #endif
+        }
+
+        struct PollEvent {
+            uint64_t key;
+            bool readable;
+            bool writable;
+            // Error or hang up, the socket is done.
+            bool closed;
+        };
+
+    #if defined(__linux__)
+        // epoll, level triggered.
+        class Poller {
+            int fd = -1;
+            std::vector<epoll_event> buffer = std::vector<epoll_event>(256);
+
+        public:
+            ~Poller() {
+                if (fd >= 0) {
+                    ::close(fd);
+                }
+            }
+
+            bool open() {
+                fd = epoll_create1(EPOLL_CLOEXEC);
+                return fd >= 0;
+            }
+
+            void watch(socket_t s, uint64_t key, bool read, bool write, bool added) {
+                epoll_event ev{};
+                ev.events = (read ? EPOLLIN : 0u) | (write ? EPOLLOUT : 0u);
+                ev.data.u64 = key;
+                epoll_ctl(fd, added ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, s, &ev);
+            }
+
+            void forget(socket_t s) {
+                epoll_ctl(fd, EPOLL_CTL_DEL, s, nullptr);
+            }
+
+            void wait(std::vector<PollEvent>& out, int timeout_ms) {
+                out.clear();
+                int n = epoll_wait(fd, buffer.data(), static_cast<int>(buffer.size()), timeout_ms);
+                for (int i = 0; i < n; i++) {
+                    auto& ev = buffer[i];
+                    out.push_back({ev.data.u64, (ev.events & EPOLLIN) != 0, (ev.events & EPOLLOUT) != 0,
+                        (ev.events & (EPOLLERR | EPOLLHUP)) != 0});
+                }
+            }
+        };
+    #elif defined(YOYO_SERVE_KQUEUE)
+        // kqueue, a read and a write filter per socket.
+        class Poller {
+            int fd = -1;
+            std::vector<struct kevent> buffer = std::vector<struct kevent>(256);
+
+        public:
+            ~Poller() {
+                if (fd >= 0) {
+                    ::close(fd);
+                }
+            }
+
+            bool open() {
+                fd = kqueue();
+                return fd >= 0;
+            }
+
+            void watch(socket_t s, uint64_t key, bool read, bool write, bool) {
+                struct kevent changes[2];
+                auto udata = reinterpret_cast<void*>(static_cast<uintptr_t>(key));
+                EV_SET(&changes[0], s, EVFILT_READ, EV_ADD | (read ? EV_ENABLE : EV_DISABLE), 0, 0, udata);
+                EV_SET(&changes[1], s, EVFILT_WRITE, EV_ADD | (write ? EV_ENABLE : EV_DISABLE), 0, 0, udata);
+                kevent(fd, changes, 2, nullptr, 0, nullptr);
+            }
+
+            // Closing the socket drops its filters.
+            void forget(socket_t) {}
+
+            void wait(std::vector<PollEvent>& out, int timeout_ms) {
+                out.clear();
+                timespec timeout{timeout_ms / 1000, (timeout_ms % 1000) * 1000000L};
+                int n = kevent(fd, nullptr, 0, buffer.data(), static_cast<int>(buffer.size()), &timeout);
+                for (int i = 0; i < n; i++) {
+                    auto& ev = buffer[i];
+                    auto key = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(ev.udata));
+                    out.push_back({key, ev.filter == EVFILT_READ, ev.filter == EVFILT_WRITE, (ev.flags & EV_ERROR) != 0});
+                }
+            }
+        };
+    #else
+        // `poll` (`WSAPoll` on Windows), the set is rebuilt per wait.
+        class Poller {
+            struct Watched {
+                socket_t socket;
+                uint64_t key;
+                short events;
+            };
+            std::vector<Watched> watched;
+        #if defined(_WIN32)
+            std::vector<WSAPOLLFD> fds;
+        #else
+            std::vector<pollfd> fds;
+        #endif
+
+        public:
+            bool open() {
+                return true;
+            }
+
+            void watch(socket_t s, uint64_t key, bool read, bool write, bool) {
+                short events = static_cast<short>((read ? POLLIN : 0) | (write ? POLLOUT : 0));
+                for (auto& w : watched) {
+                    if (w.socket == s) {
+                        w.key = key;
+                        w.events = events;
+                        return;
+                    }
+                }
+                watched.push_back({s, key, events});
+            }
+
+            void forget(socket_t s) {
+                watched.erase(std::remove_if(watched.begin(), watched.end(), [&](const Watched& w) {
+                    return w.socket == s;
+                }), watched.end());
+            }
+
+            void wait(std::vector<PollEvent>& out, int timeout_ms) {
+                out.clear();
+                fds.resize(watched.size());
+                for (size_t i = 0; i < watched.size(); i++) {
+                    fds[i].fd = watched[i].socket;
+                    fds[i].events = watched[i].events;
+                    fds[i].revents = 0;
+                }
+            #if defined(_WIN32)
+                int n = WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), timeout_ms);
+            #else
+                int n = ::poll(fds.data(), static_cast<nfds_t>(fds.size()), timeout_ms);
+            #endif
+                for (size_t i = 0; i < fds.size() && n > 0; i++) {
+                    auto revents = fds[i].revents;
+                    if (revents == 0) {
+                        continue;
+                    }
+                    n--;
+                    out.push_back({watched[i].key, (revents & POLLIN) != 0, (revents & POLLOUT) != 0,
+                        (revents & (POLLERR | POLLHUP | POLLNVAL)) != 0});
+                }
+            }
+        };
+    #endif
+
+        // Wakes the I/O thread out of its wait. A pipe, or on Windows a UDP socket sending to itself.
+        class Waker {
+        #if defined(_WIN32)
+            socket_t sock = NO_SOCKET;
+        #else
+            int fds[2] = {-1, -1};
+        #endif
+
+        public:
+            ~Waker() {
+            #if defined(_WIN32)
+                if (sock != NO_SOCKET) {
+                    close_socket(sock);
+                }
+            #else
+                for (auto fd : fds) {
+                    if (fd >= 0) {
+                        ::close(fd);
+                    }
+                }
+            #endif
+            }
+
+            bool open() {
+            #if defined(_WIN32)
+                sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+                if (sock == NO_SOCKET) {
+                    return false;
+                }
+                sockaddr_in addr{};
+                addr.sin_family = AF_INET;
+                addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                int len = sizeof(addr);
+                return bind(sock, reinterpret_cast<sockaddr*>(&addr), len) == 0
+                    && getsockname(sock, reinterpret_cast<sockaddr*>(&addr), &len) == 0
+                    && connect(sock, reinterpret_cast<sockaddr*>(&addr), len) == 0
+                    && set_nonblocking(sock);
+            #else
+                return pipe(fds) == 0 && set_nonblocking(fds[0]) && set_nonblocking(fds[1]);
+            #endif
+            }
+
+            socket_t handle() const {
+            #if defined(_WIN32)
+                return sock;
+            #else
+                return fds[0];
+            #endif
+            }
+
+            void wake() {
+                char byte = 1;
+            #if defined(_WIN32)
+                ::send(sock, &byte, 1, 0);
+            #else
+                // A full pipe is already awake.
+                [[maybe_unused]] auto n = ::write(fds[1], &byte, 1);
+            #endif
+            }
+
+            void drain() {
+                char buffer[64];
+            #if defined(_WIN32)
+                while (recv(sock, buffer, sizeof(buffer), 0) > 0) {}
+            #else
+                while (::read(fds[0], buffer, sizeof(buffer)) > 0) {}
+            #endif
+            }
+        };
+
+        // A request waiting for the handler.
+        struct PendingRequest {
+            uint64_t connection;
+            std::string method;
+            std::string path;
+            std::string query;
+            Headers headers;
+            std::string body;
+        };
+
+        // The answer of the handler, on its way back to the I/O thread.
+        struct Reply {
+            uint64_t connection;
+            int status;
+            Headers headers;
+            std::string body;
+        };
+
+        // A `Server.publish` response.
+        struct Published {
+            std::string content_type;
+            std::string body;
+        };
+
+        struct Connection {
+            socket_t socket = NO_SOCKET;
+            std::string in;
+            std::string out;
+            // How much of `out` was sent.
+            size_t sent = 0;
+            // Waiting for the handler, nothing more is parsed until it answers.
+            bool busy = false;
+            // The request waiting for the handler was a `HEAD`.
+            bool head_only = false;
+            bool keep_alive = true;
+            // Close once `out` is sent.
+            bool closing = false;
+            // The peer will not send more.
+            bool peer_closed = false;
+            // What the poller watches, `watched` once it was added.
+            bool watched = false;
+            bool want_read = false;
+            bool want_write = false;
+            Clock::time_point last_active = Clock::now();
+        };
+
+        std::string_view reason(int status) {
+            switch (status) {
+                case 200: return "OK";
+                case 201: return "Created";
+                case 202: return "Accepted";
+                case 204: return "No Content";
+                case 301: return "Moved Permanently";
+                case 302: return "Found";
+                case 304: return "Not Modified";
+                case 400: return "Bad Request";
+                case 401: return "Unauthorized";
+                case 403: return "Forbidden";
+                case 404: return "Not Found";
+                case 405: return "Method Not Allowed";
+                case 413: return "Content Too Large";
+                case 431: return "Request Header Fields Too Large";
+                case 500: return "Internal Server Error";
+                case 501: return "Not Implemented";
+                case 503: return "Service Unavailable";
+                default: return "Unknown";
+            }
+        }
+
+        bool iequals(std::string_view a, std::string_view b) {
+            return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+                return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+            });
+        }
+
+        std::string_view trim(std::string_view s) {
+            while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+                s.remove_prefix(1);
+            }
+            while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+                s.remove_suffix(1);
+            }
+            return s;
+        }
+
+        // The request line and headers of a request.
+        struct Head {
+            std::string method;
+            std::string target;
+            Headers headers;
+            size_t content_length = 0;
+            bool chunked = false;
+            bool keep_alive = true;
+        };
+
+        // Parse `text`, the head without its blank line. False when it is not HTTP/1.x.
+        bool parse_head(std::string_view text, Head& head) {
+            auto line_end = text.find("\r\n");
+            auto line = text.substr(0, line_end);
+            auto sp1 = line.find(' ');
+            auto sp2 = sp1 == std::string_view::npos ? sp1 : line.find(' ', sp1 + 1);
+            if (sp2 == std::string_view::npos || sp1 == 0 || sp2 == sp1 + 1) {
+                return false;
+            }
+            auto version = line.substr(sp2 + 1);
+            if (version != "HTTP/1.1" && version != "HTTP/1.0") {
+                return false;
+            }
+            head.method = std::string(line.substr(0, sp1));
+            head.target = std::string(line.substr(sp1 + 1, sp2 - sp1 - 1));
+            bool http10 = version == "HTTP/1.0";
+            head.keep_alive = !http10;
+
+            bool has_length = false;
+            size_t pos = line_end == std::string_view::npos ? text.size() : line_end + 2;
+            while (pos < text.size()) {
+                auto end = text.find("\r\n", pos);
+                if (end == std::string_view::npos) {
+                    end = text.size();
+                }
+                auto header = text.substr(pos, end - pos);
+                pos = end + 2;
+                auto colon = header.find(':');
+                if (colon == std::string_view::npos || colon == 0) {
+                    return false;
+                }
+                std::string name(header.substr(0, colon));
+                std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) {
+                    return static_cast<char>(std::tolower(c));
+                });
+                auto value = trim(header.substr(colon + 1));
+
+                if (name == "content-length") {
+                    size_t length = 0;
+                    if (value.empty() || value.size() > 15) {
+                        return false;
+                    }
+                    for (char c : value) {
+                        if (c < '0' || c > '9') {
+                            return false;
+                        }
+                        length = length * 10 + static_cast<size_t>(c - '0');
+                    }
+                    // Two different lengths smuggle a request.
+                    if (has_length && length != head.content_length) {
+                        return false;
+                    }
+                    has_length = true;
+                    head.content_length = length;
+                } else if (name == "transfer-encoding") {
+                    head.chunked = !iequals(value, "identity");
+                } else if (name == "connection") {
+                    if (iequals(value, "close")) {
+                        head.keep_alive = false;
+                    } else if (iequals(value, "keep-alive")) {
+                        head.keep_alive = true;
+                    }
+                }
+                head.headers.emplace_back(std::move(name), std::string(value));
+            }
+            return true;
+        }
+
+        // Write a response into `conn.out`. Content-Length and Connection are ours, the handler can not set them.
+        void write_response(Connection& conn, int status, const Headers& headers, std::string_view body, bool head_only) {
+            auto& out = conn.out;
+            out.reserve(out.size() + 128 + body.size());
+            out += "HTTP/1.1 ";
+            out += std::to_string(status);
+            out += ' ';
+            out += reason(status);
+            out += "\r\n";
+            bool has_type = false;
+            for (auto& [name, value] : headers) {
+                if (iequals(name, "content-length") || iequals(name, "connection") || iequals(name, "transfer-encoding")) {
+                    continue;
+                }
+                has_type = has_type || iequals(name, "content-type");
+                out += name;
+                out += ": ";
+                out += value;
+                out += "\r\n";
+            }
+            if (!has_type && status != 204 && status != 304) {
+                out += "Content-Type: text/plain; charset=utf-8\r\n";
+            }
+            if (status != 204 && status != 304) {
+                out += "Content-Length: ";
+                out += std::to_string(body.size());
+                out += "\r\n";
+            }
+            out += conn.keep_alive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+            if (!head_only && status != 204 && status != 304) {
+                out += body;
+            }
+            if (!conn.keep_alive) {
+                conn.closing = true;
+            }
+        }
+
+        struct ServeOptions {
+            std::string host = "127.0.0.1";
+            int port = 0;
+            size_t max_body = 1024 * 1024;
+            int idle_timeout = 5000;
+            size_t max_pending = 1024;
+        };
+
+        // The sockets of a server, run by its I/O thread. The owning thread only touches the locked queues.
+        class Reactor {
+        public:
+            explicit Reactor(ServeOptions options, bool has_handler) : options(std::move(options)), has_handler(has_handler) {}
+
+            ~Reactor() {
+                for (auto& [id, conn] : connections) {
+                    close_socket(conn.socket);
+                }
+                if (listener != NO_SOCKET) {
+                    close_socket(listener);
+                }
+            }
+
+            std::atomic<bool> stopping{false};
+            std::atomic<uint64_t> requests{0};
+            std::atomic<uint64_t> published_hits{0};
+            std::atomic<uint64_t> dispatched{0};
+            std::atomic<uint64_t> rejected{0};
+            std::atomic<uint64_t> accepted{0};
+            std::atomic<int64_t> open{0};
+
+            // Bind and listen.
+            //
+            // returns the error, empty when listening.
+            std::string listen() {
+                if (!start_sockets()) {
+                    return "Could not start sockets.";
+                }
+                if (!poller.open() || !waker.open()) {
+                    return "Could not create the event loop.";
+                }
+
+                addrinfo hints{};
+                hints.ai_family = AF_UNSPEC;
+                hints.ai_socktype = SOCK_STREAM;
+                hints.ai_flags = AI_PASSIVE;
+                addrinfo* found = nullptr;
+                auto port = std::to_string(options.port);
+                if (getaddrinfo(options.host.empty() ? nullptr : options.host.c_str(), port.c_str(), &hints, &found) != 0 || found == nullptr) {
+                    return "Could not resolve " + options.host + ".";
+                }
+
+                std::string error = "Could not listen on " + options.host + ":" + port + ".";
+                for (auto addr = found; addr != nullptr; addr = addr->ai_next) {
+                    auto s = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+                    if (s == NO_SOCKET) {
+                        continue;
+                    }
+                #if !defined(_WIN32)
+                    int on = 1;
+                    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+                #endif
+                    if (bind(s, addr->ai_addr, static_cast<int>(addr->ai_addrlen)) != 0 || ::listen(s, SOMAXCONN) != 0 || !set_nonblocking(s)) {
+                        close_socket(s);
+                        continue;
+                    }
+                    listener = s;
+                    break;
+                }
+                freeaddrinfo(found);
+                if (listener == NO_SOCKET) {
+                    return error;
+                }
+
+                sockaddr_storage bound{};
+                socklen_t len = sizeof(bound);
+                if (getsockname(listener, reinterpret_cast<sockaddr*>(&bound), &len) == 0) {
+                    if (bound.ss_family == AF_INET) {
+                        bound_port = ntohs(reinterpret_cast<sockaddr_in*>(&bound)->sin_port);
+                    } else if (bound.ss_family == AF_INET6) {
+                        bound_port = ntohs(reinterpret_cast<sockaddr_in6*>(&bound)->sin6_port);
+                    }
+                }
+
+                poller.watch(listener, KEY_LISTEN, true, false, false);
+                poller.watch(waker.handle(), KEY_WAKE, true, false, false);
+                return "";
+            }
+
+            int port() const {
+                return bound_port;
+            }
+
+            // The I/O loop, until `stop`.
+            void run() {
+                std::vector<PollEvent> events;
+                auto last_sweep = Clock::now();
+                while (!stopping.load(std::memory_order_acquire)) {
+                    poller.wait(events, 250);
+                    for (auto& ev : events) {
+                        if (ev.key == KEY_LISTEN) {
+                            accept_all();
+                        } else if (ev.key == KEY_WAKE) {
+                            waker.drain();
+                        } else {
+                            on_event(ev);
+                        }
+                    }
+                    deliver_replies();
+
+                    auto now = Clock::now();
+                    if (now - last_sweep >= std::chrono::milliseconds(500)) {
+                        last_sweep = now;
+                        sweep(now);
+                    }
+                }
+            }
+
+            void stop() {
+                stopping.store(true, std::memory_order_release);
+                waker.wake();
+            }
+
+            // Take the requests waiting for the handler.
+            std::deque<PendingRequest> take_pending() {
+                std::lock_guard<std::mutex> guard(pending_lock);
+                return std::exchange(pending, {});
+            }
+
+            // Hand the answer of the handler back.
+            void reply(Reply reply) {
+                {
+                    std::lock_guard<std::mutex> guard(replies_lock);
+                    replies.push_back(std::move(reply));
+                }
+                waker.wake();
+            }
+
+            // Set or, with no body, remove a published path.
+            void publish(const std::string& path, std::optional<Published> response) {
+                std::lock_guard<std::mutex> guard(published_lock);
+                if (response) {
+                    published[path] = std::make_shared<const Published>(std::move(*response));
+                } else {
+                    published.erase(path);
+                }
+            }
+
+        private:
+            ServeOptions options;
+            bool has_handler;
+            socket_t listener = NO_SOCKET;
+            int bound_port = 0;
+            Poller poller;
+            Waker waker;
+            std::unordered_map<uint64_t, Connection> connections;
+            uint64_t next_id = FIRST_CONNECTION;
+
+            std::mutex pending_lock;
+            std::deque<PendingRequest> pending;
+
+            std::mutex replies_lock;
+            std::vector<Reply> replies;
+
+            std::mutex published_lock;
+            std::unordered_map<std::string, std::shared_ptr<const Published>> published;
+
+            void accept_all() {
+                while (true) {
+                    auto s = accept(listener, nullptr, nullptr);
+                    if (s == NO_SOCKET) {
+                        return;
+                    }
+                    if (!set_nonblocking(s)) {
+                        close_socket(s);
+                        continue;
+                    }
+                    int on = 1;
+                    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&on), sizeof(on));
+                #if defined(SO_NOSIGPIPE)
+                    setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+                #endif
+                    auto id = next_id++;
+                    auto& conn = connections[id];
+                    conn.socket = s;
+                    accepted.fetch_add(1, std::memory_order_relaxed);
+                    open.fetch_add(1, std::memory_order_relaxed);
+                    settle(id, conn);
+                }
+            }
+
+            void close_connection(uint64_t id) {
+                auto it = connections.find(id);
+                if (it == connections.end()) {
+                    return;
+                }
+                poller.forget(it->second.socket);
+                close_socket(it->second.socket);
+                connections.erase(it);
+                open.fetch_sub(1, std::memory_order_relaxed);
+            }
+
+            void on_event(const PollEvent& ev) {
+                auto it = connections.find(ev.key);
+                if (it == connections.end()) {
+                    return;
+                }
+                auto& conn = it->second;
+                if (ev.readable && !read_some(conn)) {
+                    close_connection(ev.key);
+                    return;
+                }
+                if (ev.closed) {
+                    close_connection(ev.key);
+                    return;
+                }
+                if (ev.readable) {
+                    process(ev.key, conn);
+                } else if (ev.writable) {
+                    settle(ev.key, conn);
+                }
+            }
+
+            // Read what is there. False on a error.
+            bool read_some(Connection& conn) {
+                char buffer[READ_CHUNK];
+                // Nothing past the largest request is read, it would only be refused.
+                auto limit = MAX_HEAD + options.max_body + READ_CHUNK;
+                while (conn.in.size() < limit) {
+                    auto n = recv(conn.socket, buffer, static_cast<int>(sizeof(buffer)), 0);
+                    if (n > 0) {
+                        conn.in.append(buffer, static_cast<size_t>(n));
+                        conn.last_active = Clock::now();
+                        continue;
+                    }
+                    if (n == 0) {
+                        conn.peer_closed = true;
+                        return true;
+                    }
+                    return would_block();
+                }
+                return true;
+            }
+
+            // Refuse the request and close after the answer, the rest of the stream can not be trusted.
+            void refuse(Connection& conn, int status) {
+                rejected.fetch_add(1, std::memory_order_relaxed);
+                conn.keep_alive = false;
+                conn.in.clear();
+                write_response(conn, status, {}, reason(status), false);
+            }
+
+            // Answer or dispatch the complete requests in `conn.in`, then send.
+            void process(uint64_t id, Connection& conn) {
+                while (!conn.busy && !conn.closing) {
+                    auto end = conn.in.find("\r\n\r\n");
+                    if (end == std::string::npos) {
+                        if (conn.in.size() > MAX_HEAD) {
+                            refuse(conn, 431);
+                        }
+                        break;
+                    }
+                    if (end > MAX_HEAD) {
+                        refuse(conn, 431);
+                        break;
+                    }
+
+                    Head head;
+                    if (!parse_head(std::string_view(conn.in).substr(0, end), head)) {
+                        refuse(conn, 400);
+                        break;
+                    }
+                    if (head.chunked) {
+                        refuse(conn, 501);
+                        break;
+                    }
+                    if (head.content_length > options.max_body) {
+                        refuse(conn, 413);
+                        break;
+                    }
+                    auto total = end + 4 + head.content_length;
+                    if (conn.in.size() < total) {
+                        break;
+                    }
+
+                    std::string body = conn.in.substr(end + 4, head.content_length);
+                    conn.in.erase(0, total);
+                    conn.keep_alive = head.keep_alive;
+                    requests.fetch_add(1, std::memory_order_relaxed);
+
+                    std::string path = head.target;
+                    std::string query;
+                    auto q = path.find('?');
+                    if (q != std::string::npos) {
+                        query = path.substr(q + 1);
+                        path.resize(q);
+                    }
+
+                    bool head_only = head.method == "HEAD";
+                    if (head_only || head.method == "GET") {
+                        std::shared_ptr<const Published> response;
+                        {
+                            std::lock_guard<std::mutex> guard(published_lock);
+                            auto found = published.find(path);
+                            if (found != published.end()) {
+                                response = found->second;
+                            }
+                        }
+                        if (response) {
+                            published_hits.fetch_add(1, std::memory_order_relaxed);
+                            write_response(conn, 200, {{"Content-Type", response->content_type}}, response->body, head_only);
+                            continue;
+                        }
+                    }
+
+                    if (!has_handler) {
+                        write_response(conn, 404, {}, reason(404), head_only);
+                        continue;
+                    }
+
+                    {
+                        std::lock_guard<std::mutex> guard(pending_lock);
+                        if (pending.size() >= options.max_pending) {
+                            rejected.fetch_add(1, std::memory_order_relaxed);
+                            write_response(conn, 503, {}, reason(503), head_only);
+                            continue;
+                        }
+                        pending.push_back({id, std::move(head.method), std::move(path), std::move(query), std::move(head.headers), std::move(body)});
+                    }
+                    dispatched.fetch_add(1, std::memory_order_relaxed);
+                    conn.busy = true;
+                    conn.head_only = head_only;
+                }
+                settle(id, conn);
+            }
+
+            // Send what is queued, close when done with the connection, and watch what is left to do.
+            void settle(uint64_t id, Connection& conn) {
+                while (conn.sent < conn.out.size()) {
+                    auto n = send_some(conn.socket, conn.out.data() + conn.sent, conn.out.size() - conn.sent);
+                    if (n > 0) {
+                        conn.sent += static_cast<size_t>(n);
+                        conn.last_active = Clock::now();
+                    } else if (n < 0 && would_block()) {
+                        break;
+                    } else {
+                        close_connection(id);
+                        return;
+                    }
+                }
+                bool flushed = conn.sent == conn.out.size();
+                if (flushed) {
+                    conn.out.clear();
+                    conn.sent = 0;
+                    if (conn.closing || (conn.peer_closed && !conn.busy)) {
+                        close_connection(id);
+                        return;
+                    }
+                }
+
+                bool read = !conn.busy && !conn.closing && !conn.peer_closed;
+                bool write = !flushed;
+                if (!conn.watched || read != conn.want_read || write != conn.want_write) {
+                    poller.watch(conn.socket, id, read, write, conn.watched);
+                    conn.watched = true;
+                    conn.want_read = read;
+                    conn.want_write = write;
+                }
+            }
+
+            void deliver_replies() {
+                std::vector<Reply> ready;
+                {
+                    std::lock_guard<std::mutex> guard(replies_lock);
+                    ready.swap(replies);
+                }
+                for (auto& reply : ready) {
+                    auto it = connections.find(reply.connection);
+                    if (it == connections.end() || !it->second.busy) {
+                        continue;
+                    }
+                    auto& conn = it->second;
+                    conn.busy = false;
+                    write_response(conn, reply.status, reply.headers, reply.body, conn.head_only);
+                    // Pipelined requests behind it.
+                    process(reply.connection, conn);
+                }
+            }
+
+            // Drop connections idle for longer than `idle_timeout`.
+            void sweep(Clock::time_point now) {
+                auto timeout = std::chrono::milliseconds(options.idle_timeout);
+                std::vector<uint64_t> idle;
+                for (auto& [id, conn] : connections) {
+                    if (!conn.busy && conn.out.empty() && now - conn.last_active > timeout) {
+                        idle.push_back(id);
+                    }
+                }
+                for (auto id : idle) {
+                    close_connection(id);
+                }
+            }
+        };
+    };
+
+    struct ServerState {
+        // Thread that called `serve`. Only it may touch the pxs vars below.
+        std::thread::id owner;
+        // Owned, nullable.
+        pxs_VarT handler = nullptr;
+        // Owned, nullable.
+        pxs_VarT runtime = nullptr;
+        std::unique_ptr<serving::Reactor> reactor;
+        std::thread thread;
+
+        void close() {
+            if (thread.joinable()) {
+                reactor->stop();
+                thread.join();
+            }
+        }
+
+        ~ServerState() {
+            close();
+            if (handler != nullptr) {
+                pxs_freevar(handler);
+            }
+            if (runtime != nullptr) {
+                pxs_freevar(runtime);
+            }
+        }
+    };
+
+    namespace {
+        using namespace serving;
+
+        // Servers with a handler, found by `serve_pump` of their owner thread.
+        struct Registered {
+            std::thread::id owner;
+            std::weak_ptr<ServerState> state;
+        };
+        std::mutex servers_lock;
+        std::vector<Registered> servers;
+
+        // Class of the `Server` host object. Created in `init_server` since the function lookup is reset with pixelscript.
+        std::optional<pxs::Class<Server>> server_class;
+
+        void free_server(pxs_Opaque ptr) {
+            if (!ptr) {
+                return;
+            }
+
+            delete static_cast<Server*>(ptr);
+        }
+
+        std::string string_of(pxs_VarT var) {
+            size_t len = 0;
+            auto str = pxs_getstrview(var, &len);
+            return str == nullptr ? std::string() : std::string(str, len);
+        }
+
+        // Read a `{string: string}` map into `out`. Other pairs are skipped.
+        void read_headers(pxs_VarT map, Headers& out) {
+            if (!pxs_varis(map, pxs_Map)) {
+                return;
+            }
+            pxs_MapIter iter;
+            pxs_VarT key = nullptr;
+            pxs_VarT value = nullptr;
+            pxs_mapiter_begin(map, &iter);
+            while (pxs_mapiter_next(&iter, &key, &value)) {
+                if (!pxs_varis(key, pxs_String) || !pxs_varis(value, pxs_String)) {
+                    continue;
+                }
+                auto name = string_of(key);
+                auto text = string_of(value);
+                // No header splitting.
+                if (name.find_first_of("\r\n:") != std::string::npos || text.find_first_of("\r\n") != std::string::npos) {
+                    continue;
+                }
+                out.emplace_back(std::move(name), std::move(text));
+            }
+        }
+
+        // Read a body (`string`, `[]uint` or buffer). False when it is something else.
+        bool read_body(pxs_VarT var, std::string& out) {
+            const uint8_t* data = nullptr;
+            size_t len = 0;
+            std::vector<uint8_t> storage;
+            if (!utils::bytes::view_bytes(var, data, len, storage)) {
+                return false;
+            }
+            out.assign(reinterpret_cast<const char*>(data), len);
+            return true;
+        }
+
+        // Turn what the handler returned into a reply.
+        void read_reply(pxs_VarT res, Reply& reply) {
+            reply.status = 200;
+            if (res == nullptr || pxs_varis(res, pxs_Null)) {
+                reply.status = 204;
+                return;
+            }
+            if (pxs_varis(res, pxs_Exception)) {
+                reply.status = 500;
+                reply.body = string_of(res);
+                return;
+            }
+            if (pxs_varis(res, pxs_List) && pxs_listlen(res) >= 1 && pxs_listlen(res) <= 3
+                && (pxs_varis(pxs_listget(res, 0), pxs_Int64) || pxs_varis(pxs_listget(res, 0), pxs_UInt64))) {
+                auto status = pxs_getint(pxs_listget(res, 0));
+                reply.status = status >= 100 && status <= 599 ? static_cast<int>(status) : 500;
+                if (pxs_listlen(res) >= 2) {
+                    auto body = pxs_listget(res, 1);
+                    if (!pxs_varis(body, pxs_Null) && !read_body(body, reply.body)) {
+                        reply.status = 500;
+                        reply.body = "Expected the body to be string or bytes.";
+                        return;
+                    }
+                }
+                if (pxs_listlen(res) == 3) {
+                    read_headers(pxs_listget(res, 2), reply.headers);
+                }
+                return;
+            }
+            if (!read_body(res, reply.body)) {
+                reply.status = 500;
+                reply.body = "Expected the handler to return string, bytes, [status, body, headers] or null.";
+            } else if (!pxs_varis(res, pxs_String)) {
+                reply.headers.emplace_back("Content-Type", "application/octet-stream");
+            }
+        }
+
+        pxs_VarT request_to_pxs(const PendingRequest& request) {
+            auto headers = pxs_newmap();
+            for (auto& [name, value] : request.headers) {
+                pxs_map_addpair(headers, pxs_newstring(name.c_str()), pxs_newstring(value.c_str()));
+            }
+            auto map = pxs_newmap();
+            pxs_map_addpair(map, pxs_newstring("method"), pxs_newstring(request.method.c_str()));
+            pxs_map_addpair(map, pxs_newstring("path"), pxs_newstring(request.path.c_str()));
+            pxs_map_addpair(map, pxs_newstring("query"), pxs_newstring(request.query.c_str()));
+            pxs_map_addpair(map, pxs_newstring("headers"), headers);
+            pxs_map_addpair(map, pxs_newstring("body"), pxs_newstring(request.body.c_str()));
+            return map;
+        }
+
+        ServeOptions read_serve_options(pxs_VarT opts, ServeOptions out) {
+            if (opts == nullptr || !pxs_varis(opts, pxs_Map)) {
+                return out;
+            }
+            pxs_MapIter iter;
+            pxs_VarT key = nullptr;
+            pxs_VarT value = nullptr;
+            pxs_mapiter_begin(opts, &iter);
+            while (pxs_mapiter_next(&iter, &key, &value)) {
+                auto name = string_of(key);
+                bool number = pxs_varis(value, pxs_Int64) || pxs_varis(value, pxs_UInt64);
+                if (name == "host" && pxs_varis(value, pxs_String)) {
+                    out.host = string_of(value);
+                } else if (name == "max_body" && number) {
+                    out.max_body = static_cast<size_t>(std::max<int64_t>(0, pxs_getint(value)));
+                } else if (name == "idle_timeout" && number) {
+                    out.idle_timeout = static_cast<int>(std::clamp<int64_t>(pxs_getint(value), 1, INT32_MAX));
+                } else if (name == "max_pending" && number) {
+                    out.max_pending = static_cast<size_t>(std::max<int64_t>(1, pxs_getint(value)));
+                }
+            }
+            return out;
+        }
+    };
+
+    Server::Server(std::shared_ptr<ServerState> state) : state(std::move(state)) {}
+
+    Server::~Server() {
+        state->close();
+    }
+
+    pxs_VarT Server::prop_port(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Server>(args, 0, yoyo::types::NET_SERVER_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        return pxs_newint(self->state->reactor->port());
+    }
+
+    pxs_VarT Server::publish(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Server>(args, 0, yoyo::types::NET_SERVER_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        PXS_ARG_STRING_VAL(path, 1);
+        auto body_arg = pxs::Var::from_args(args, 2);
+        if (body_arg.is(pxs_Null)) {
+            self->state->reactor->publish(path, std::nullopt);
+            return pxs_newnull();
+        }
+
+        Published response;
+        response.content_type = "text/plain; charset=utf-8";
+        if (!read_body(body_arg.raw(), response.body)) {
+            return yoyo::utils::exceptions::expected_types(body_arg.raw()->tag, {pxs_String, pxs_List, pxs_Null});
+        }
+        auto type_arg = pxs::Var::from_args(args, 3);
+        if (type_arg.is(pxs_String)) {
+            response.content_type = type_arg.get_string();
+            if (response.content_type.find_first_of("\r\n") != std::string::npos) {
+                return pxs_newexception("Expected content_type to be a single line.");
+            }
+        } else if (!body_arg.is(pxs_String)) {
+            response.content_type = "application/octet-stream";
+        }
+        self->state->reactor->publish(path, std::move(response));
+        return pxs_newnull();
+    }
+
+    pxs_VarT Server::stats(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Server>(args, 0, yoyo::types::NET_SERVER_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        auto& reactor = *self->state->reactor;
+        auto count = [](const std::atomic<uint64_t>& n) {
+            return pxs_newint(static_cast<int64_t>(n.load(std::memory_order_relaxed)));
+        };
+        auto map = pxs_newmap();
+        pxs_map_addpair(map, pxs_newstring("requests"), count(reactor.requests));
+        pxs_map_addpair(map, pxs_newstring("published"), count(reactor.published_hits));
+        pxs_map_addpair(map, pxs_newstring("dispatched"), count(reactor.dispatched));
+        pxs_map_addpair(map, pxs_newstring("rejected"), count(reactor.rejected));
+        pxs_map_addpair(map, pxs_newstring("connections"), count(reactor.accepted));
+        pxs_map_addpair(map, pxs_newstring("open"), pxs_newint(reactor.open.load(std::memory_order_relaxed)));
+        return map;
+    }
+
+    pxs_VarT Server::close(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Server>(args, 0, yoyo::types::NET_SERVER_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        self->state->close();
+        return pxs_newnull();
+    }
+
+    pxs_VarT serve(pxs_VarT args) {
+        PXS_ARGC_GT(1); // port, handler, options
+        auto port_arg = pxs::Var::from_args(args, 0);
+        if (!port_arg.is(pxs_Int64) && !port_arg.is(pxs_UInt64)) {
+            return yoyo::utils::exceptions::expected_types(port_arg.raw()->tag, {pxs_Int64, pxs_UInt64});
+        }
+        auto port = port_arg.get_int();
+        if (port < 0 || port > 65535) {
+            return pxs_newexception("Expected port to be between 0 and 65535.");
+        }
+
+        auto state = std::make_shared<ServerState>();
+        state->owner = std::this_thread::get_id();
+
+        auto handler_arg = pxs::Var::from_args(args, 1);
+        if (handler_arg.is(pxs_Function)) {
+            // Copying moves the language reference to our copy, keeping it alive.
+            state->handler = pxs_newcopy(handler_arg.raw());
+            state->runtime = pxs_newcopy(pxs_getrt(args));
+        } else if (!handler_arg.is(pxs_Null)) {
+            return yoyo::utils::exceptions::expected_types(handler_arg.raw()->tag, {pxs_Function, pxs_Null});
+        }
+
+        ServeOptions defaults;
+        defaults.port = static_cast<int>(port);
+        auto options = read_serve_options(pxs_arg(args, 2), defaults);
+
+        state->reactor = std::make_unique<serving::Reactor>(options, state->handler != nullptr);
+        auto error = state->reactor->listen();
+        if (!error.empty()) {
+            return pxs_newexception(error.c_str());
+        }
+        auto reactor = state->reactor.get();
+        state->thread = std::thread([reactor]() {
+            reactor->run();
+        });
+
+        if (state->handler != nullptr) {
+            std::lock_guard<std::mutex> guard(servers_lock);
+            servers.push_back({state->owner, state});
+        }
+
+        return server_class->make(new Server(state), free_server).raw();
+    }
+
+    int serve_pump() {
+        std::vector<std::shared_ptr<ServerState>> mine;
+        {
+            std::lock_guard<std::mutex> guard(servers_lock);
+            auto me = std::this_thread::get_id();
+            // Only servers of this thread are locked, so their last reference is always dropped here.
+            servers.erase(std::remove_if(servers.begin(), servers.end(), [&](const Registered& r) {
+                if (r.owner != me) {
+                    return false;
+                }
+                auto state = r.state.lock();
+                if (!state) {
+                    return true;
+                }
+                mine.push_back(std::move(state));
+                return false;
+            }), servers.end());
+        }
+
+        int handled = 0;
+        for (auto& state : mine) {
+            if (state->reactor->stopping.load(std::memory_order_acquire)) {
+                continue;
+            }
+            for (auto& request : state->reactor->take_pending()) {
+                auto cb_args = pxs_newlist();
+                pxs_listadd(cb_args, request_to_pxs(request));
+                auto res = pxs_varcall(state->runtime, state->handler, cb_args);
+
+                Reply reply;
+                reply.connection = request.connection;
+                read_reply(res, reply);
+                if (res != nullptr) {
+                    pxs_freevar(res);
+                }
+                state->reactor->reply(std::move(reply));
+                handled++;
+            }
+        }
+        return handled;
+    }
+
+    void init_server(pxs_Module* net_mod) {
+        server_class.emplace("Server", yoyo::types::NET_SERVER_TYPE);
+        server_class->add_property("port", &Server::prop_port);
+        server_class->add_method("publish", &Server::publish);
+        server_class->add_method("stats", &Server::stats);
+        server_class->add_method("close", &Server::close);
+
+        pxs_addfunc(net_mod, "serve", serve);
+    }
+};
+
+#endif // YOYO_NET
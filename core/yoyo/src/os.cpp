@@ -1,40 +1,375 @@
 #ifdef YOYO_OS
 #include <pixelscript_cpp.hpp>
 #include <filesystem>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <vector>
 #include "os.hpp"
+#include "utils/cpu.hpp"
+#include "utils/strutils.hpp"
+#include "utils/exceptions.hpp"
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+#if defined(__APPLE__)
+#include <crt_externs.h>
+#include <mach/mach.h>
+#endif
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+extern char** environ;
+#endif
 
 namespace yoyo::os {
-    // Get the current working directory.
+    std::mutex args_lock;
+    std::optional<std::vector<std::string>> host_args;
+
+    // Worker slot of the next `pin_current_thread` without a cpu.
+    std::atomic<uint32_t> next_pin{0};
+
+    void set_args(std::vector<std::string> args) {
+        std::lock_guard<std::mutex> guard(args_lock);
+        host_args = std::move(args);
+    }
+
+    // The args the host set, otherwise the ones of the process.
+    std::vector<std::string> process_args() {
+        {
+            std::lock_guard<std::mutex> guard(args_lock);
+            if (host_args) {
+                return *host_args;
+            }
+        }
+
+        std::vector<std::string> args;
+    #if defined(_WIN32)
+        if (__wargv != nullptr) {
+            for (int i = 0; i < __argc; i++) {
+                args.push_back(utils::str::from_wstring(__wargv[i]));
+            }
+        } else if (__argv != nullptr) {
+            for (int i = 0; i < __argc; i++) {
+                args.emplace_back(__argv[i]);
+            }
+        }
+    #elif defined(__APPLE__)
+        auto argc = *_NSGetArgc();
+        auto argv = *_NSGetArgv();
+        for (int i = 0; i < argc; i++) {
+            args.emplace_back(argv[i]);
+        }
+    #else
+        // Nul separated.
+        std::ifstream cmdline("/proc/self/cmdline", std::ios::binary);
+        std::string arg;
+        while (std::getline(cmdline, arg, '\0')) {
+            args.push_back(arg);
+        }
+    #endif
+        return args;
+    }
+
+    pxs_VarT cpu_list(const std::vector<uint32_t>& cpus) {
+        std::vector<int64_t> ids(cpus.begin(), cpus.end());
+        return pxs_newlist_i64(ids.data(), ids.size());
+    }
+
+    // Read a list of cpu ids. Returns false when it is not a list of ints.
+    bool read_cpus(pxs_VarT list, std::vector<uint32_t>& out) {
+        if (!pxs_varis(list, pxs_List)) {
+            return false;
+        }
+        std::vector<int64_t> ids(pxs_listlen(list));
+        if (pxs_list_copy_i64(list, ids.data(), ids.size()) != static_cast<int32_t>(ids.size())) {
+            return false;
+        }
+        for (auto id : ids) {
+            if (id < 0) {
+                return false;
+            }
+            out.push_back(static_cast<uint32_t>(id));
+        }
+        return true;
+    }
+
     pxs_VarT get_cwd(pxs_VarT args) {
-        auto res = std::filesystem::current_path();
+        std::error_code ec;
+        auto res = std::filesystem::current_path(ec);
+        if (ec) {
+            return pxs_newexception(ec.message().c_str());
+        }
         return pxs_newstring(res.string().c_str());
     }
 
-    // Change the current directory
     pxs_VarT ch_dir(pxs_VarT args) {
         PXS_ARGC_EQ(1); // new_path
         auto new_path = pxs::Var::from_args(args, 0);
         PXS_ARG_IS_TYPE(new_path.raw(), pxs_String);
 
-        // TODO: Exception catching.
-        // auto new_path_str = new_path.get_string();
-        // if (new_path_str)
-
-        std::filesystem::current_path(new_path.get_string());
+        std::error_code ec;
+        std::filesystem::current_path(new_path.get_string(), ec);
+        if (ec) {
+            return pxs_newexception(("Could not change directory: " + ec.message()).c_str());
+        }
         return pxs_newnull();
     }
 
-    void init(pxs_Module* yoyo, pxs_VarT argv) {
+    pxs_VarT cpu_count(pxs_VarT args) {
+        auto physical = pxs::Var::from_args(args, 0);
+        auto& topo = utils::cpu::topology();
+        if (physical.is(pxs_Bool) && physical.get_bool()) {
+            return pxs_newint(topo.physical);
+        }
+        return pxs_newint(topo.logical);
+    }
+
+    pxs_VarT cpu_topology(pxs_VarT /*args*/) {
+        auto& topo = utils::cpu::topology();
+        auto cores = pxs_newlist();
+        for (auto& core : topo.cores) {
+            pxs_listadd(cores, cpu_list(core.threads));
+        }
+
+        auto map = pxs_newmap();
+        pxs_map_addpair(map, pxs_newstring("logical"), pxs_newint(topo.logical));
+        pxs_map_addpair(map, pxs_newstring("physical"), pxs_newint(topo.physical));
+        pxs_map_addpair(map, pxs_newstring("packages"), pxs_newint(topo.packages));
+        pxs_map_addpair(map, pxs_newstring("cores"), cores);
+        return map;
+    }
+
+    pxs_VarT set_affinity(pxs_VarT args) {
+        PXS_ARGC_EQ(1); // cpus
+        std::vector<uint32_t> cpus;
+        if (!read_cpus(pxs_arg(args, 0), cpus)) {
+            return pxs_newexception("Expected a list of cpu ids");
+        }
+
+        return pxs_newbool(utils::cpu::set_affinity(cpus));
+    }
+
+    pxs_VarT get_affinity(pxs_VarT /*args*/) {
+        return cpu_list(utils::cpu::get_affinity());
+    }
+
+    pxs_VarT pin_current_thread(pxs_VarT args) {
+        auto cpu = pxs::Var::from_args(args, 0);
+        if (cpu.is(pxs_Null)) {
+            return pxs_newbool(utils::cpu::pin_worker(next_pin.fetch_add(1, std::memory_order_relaxed)));
+        }
+        if (!cpu.is(pxs_Int64) && !cpu.is(pxs_UInt64)) {
+            return utils::exceptions::expected_types(pxs_vartype(cpu.raw()), {pxs_Int64, pxs_Null});
+        }
+        auto id = cpu.get_int();
+        if (id < 0) {
+            return pxs_newexception("Expected a cpu id");
+        }
+
+        return pxs_newbool(utils::cpu::set_affinity({static_cast<uint32_t>(id)}));
+    }
+
+    pxs_VarT rss(pxs_VarT /*args*/) {
+        uint64_t bytes = 0;
+    #if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            bytes = counters.WorkingSetSize;
+        }
+    #elif defined(__APPLE__)
+        mach_task_basic_info_data_t info;
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+        if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS) {
+            bytes = info.resident_size;
+        }
+    #else
+        // Pages: total, resident, ...
+        std::ifstream statm("/proc/self/statm");
+        uint64_t total = 0, resident = 0;
+        if (statm >> total >> resident) {
+            bytes = resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+        }
+    #endif
+        return pxs_newint(static_cast<int64_t>(bytes));
+    }
+
+    pxs_VarT peak_rss(pxs_VarT /*args*/) {
+        uint64_t bytes = 0;
+    #if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            bytes = counters.PeakWorkingSetSize;
+        }
+    #else
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        #if defined(__APPLE__)
+            bytes = static_cast<uint64_t>(usage.ru_maxrss);
+        #else
+            // In kilobytes.
+            bytes = static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+        #endif
+        }
+    #endif
+        return pxs_newint(static_cast<int64_t>(bytes));
+    }
+
+    pxs_VarT cpu_time(pxs_VarT /*args*/) {
+        double user = 0, system = 0;
+    #if defined(_WIN32)
+        FILETIME created, exited, kernel, user_time;
+        if (GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user_time)) {
+            // 100ns ticks.
+            auto seconds = [](const FILETIME& t) {
+                return ((static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime) / 1e7;
+            };
+            user = seconds(user_time);
+            system = seconds(kernel);
+        }
+    #else
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) == 0) {
+            user = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6;
+            system = usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+        }
+    #endif
+        auto map = pxs_newmap();
+        pxs_map_addpair(map, pxs_newstring("user"), pxs_newfloat(user));
+        pxs_map_addpair(map, pxs_newstring("system"), pxs_newfloat(system));
+        return map;
+    }
+
+    pxs_VarT get_env(pxs_VarT args) {
+        PXS_ARGC_EQ(1); // name
+        PXS_ARG_STRING(name_arg, 0);
+        auto name = name_arg.get_string();
+
+    #if defined(_WIN32)
+        auto wide_name = utils::str::to_wstring(name);
+        auto len = GetEnvironmentVariableW(wide_name.c_str(), nullptr, 0);
+        if (len == 0) {
+            return pxs_newnull();
+        }
+        std::wstring value(len, L'\0');
+        len = GetEnvironmentVariableW(wide_name.c_str(), value.data(), len);
+        value.resize(len);
+        return pxs_newstring(utils::str::from_wstring(value).c_str());
+    #else
+        auto value = std::getenv(name.c_str());
+        if (value == nullptr) {
+            return pxs_newnull();
+        }
+        return pxs_newstring(value);
+    #endif
+    }
+
+    pxs_VarT set_env(pxs_VarT args) {
+        PXS_ARGC_EQ(2); // name, value
+        PXS_ARG_STRING(name_arg, 0);
+        PXS_ARG_STRING(value_arg, 1);
+        auto name = name_arg.get_string();
+        auto value = value_arg.get_string();
+        if (name.empty() || name.find('=') != std::string::npos) {
+            return pxs_newbool(false);
+        }
+
+    #if defined(_WIN32)
+        // Both the process block and the CRT copy `getenv` reads.
+        bool ok = SetEnvironmentVariableW(utils::str::to_wstring(name).c_str(), utils::str::to_wstring(value).c_str());
+        return pxs_newbool(ok && _putenv_s(name.c_str(), value.c_str()) == 0);
+    #else
+        return pxs_newbool(setenv(name.c_str(), value.c_str(), 1) == 0);
+    #endif
+    }
+
+    pxs_VarT unset_env(pxs_VarT args) {
+        PXS_ARGC_EQ(1); // name
+        PXS_ARG_STRING(name_arg, 0);
+        auto name = name_arg.get_string();
+        if (name.empty() || name.find('=') != std::string::npos) {
+            return pxs_newbool(false);
+        }
+
+    #if defined(_WIN32)
+        bool ok = SetEnvironmentVariableW(utils::str::to_wstring(name).c_str(), nullptr);
+        return pxs_newbool(ok && _putenv_s(name.c_str(), "") == 0);
+    #else
+        return pxs_newbool(unsetenv(name.c_str()) == 0);
+    #endif
+    }
+
+    pxs_VarT get_environ(pxs_VarT /*args*/) {
+        auto map = pxs_newmap();
+        auto add = [&](std::string_view entry) {
+            // Windows has entries like `=C:` for the drive directories, skip the leading `=`.
+            auto eq = entry.find('=', 1);
+            if (eq == std::string_view::npos) {
+                return;
+            }
+            pxs_map_addpair(map,
+                pxs_newstring(std::string(entry.substr(0, eq)).c_str()),
+                pxs_newstring(std::string(entry.substr(eq + 1)).c_str()));
+        };
+
+    #if defined(_WIN32)
+        auto block = GetEnvironmentStringsW();
+        if (block != nullptr) {
+            for (auto entry = block; *entry != L'\0'; entry += wcslen(entry) + 1) {
+                if (*entry != L'=') {
+                    add(utils::str::from_wstring(entry));
+                }
+            }
+            FreeEnvironmentStringsW(block);
+        }
+    #else
+    #if defined(__APPLE__)
+        auto env = *_NSGetEnviron();
+    #else
+        auto env = ::environ;
+    #endif
+        for (; env != nullptr && *env != nullptr; env++) {
+            add(*env);
+        }
+    #endif
+        return map;
+    }
+
+    void init(pxs_Module* yoyo) {
         auto yoyo_os = pxs_newmod("os");
 
-        // Add argv
+        std::vector<std::string> args = process_args();
+        auto argv = pxs_newlist();
+        for (auto& arg : args) {
+            pxs_listadd(argv, pxs_newstring(arg.c_str()));
+        }
         pxs_addvar(yoyo_os, "argv", argv);
 
         pxs_addfunc(yoyo_os, "get_cwd", get_cwd);
         pxs_addfunc(yoyo_os, "ch_dir", ch_dir);
+        pxs_addfunc(yoyo_os, "cpu_count", cpu_count);
+        pxs_addfunc(yoyo_os, "cpu_topology", cpu_topology);
+        pxs_addfunc(yoyo_os, "set_affinity", set_affinity);
+        pxs_addfunc(yoyo_os, "get_affinity", get_affinity);
+        pxs_addfunc(yoyo_os, "pin_current_thread", pin_current_thread);
+        pxs_addfunc(yoyo_os, "rss", rss);
+        pxs_addfunc(yoyo_os, "peak_rss", peak_rss);
+        pxs_addfunc(yoyo_os, "cpu_time", cpu_time);
+        pxs_addfunc(yoyo_os, "get_env", get_env);
+        pxs_addfunc(yoyo_os, "set_env", set_env);
+        pxs_addfunc(yoyo_os, "unset_env", unset_env);
+        pxs_addfunc(yoyo_os, "environ", get_environ);
 
         pxs_add_submod(yoyo, yoyo_os);
     }
 };
 
-#endif // YOYO_OS
\ No newline at end of file
+#endif // YOYO_OS
@@ -4,11 +4,55 @@
 #include "utils/debug.hpp"
 #include "pxs.hpp"
 #include <string>
+#include <optional>
 #include "utils/strutils.hpp"
+#include "utils/types.hpp"
+#include "utils/pxs.hpp"
+#include "utils/exceptions.hpp"
 // ipxs = internal pxs module.
 // since pixelscript_cpp already uses `pxs` as a module.
 
 namespace yoyo::ipxs {
+    // Class of the `Code` host object. Created in `init` since the function lookup is reset with pixelscript.
+    std::optional<pxs::Class<Code>> code_class;
+
+    Code::Code(pxs_Runtime runtime, pxs_VarT object) : object(object), runtime(runtime) {}
+
+    Code::~Code() {
+        pxs_freevar(object);
+    }
+
+    void free_code(pxs_Opaque ptr) {
+        if (!ptr) {
+            return;
+        }
+
+        delete static_cast<Code*>(ptr);
+    }
+
+    pxs_VarT Code::get_runtime(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Code>(args, 0, yoyo::types::PXS_CODE_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        return pxs_newint(static_cast<int>(self->runtime));
+    }
+
+    // Copy of the scope at `idx` of `args`, or a null when it was not passed.
+    //
+    // returns a exception when it is not a map.
+    pxs_VarT scope_arg(pxs_VarT args, int idx) {
+        auto scope = pxs::Var::from_args(args, idx);
+        if (scope.is(pxs_Null)) {
+            return pxs_newnull();
+        }
+        if (!scope.is(pxs_Map)) {
+            return yoyo::utils::exceptions::expected_types(scope.raw()->tag, {pxs_Map, pxs_Null});
+        }
+        return pxs_newcopy(scope.raw());
+    }
+
     // Execute code
     // Null means it was executed succesfully.
     pxs_VarT exec(pxs_VarT args) {
@@ -33,6 +77,53 @@ namespace yoyo::ipxs {
         return pxs_newnull();
     }
 
+    pxs_VarT eval(pxs_VarT args) {
+        PXS_ARGC_GT(2); // runtime option, code, code name
+        auto runtime = pxs::Var::from_args(args, 0);
+        PXS_ARG_IS_TYPE(runtime.raw(), pxs_Int64);
+        auto code = pxs::Var::from_args(args, 1);
+        PXS_ARG_IS_TYPE(code.raw(), pxs_String);
+        auto name = pxs::Var::from_args(args, 2);
+        std::string code_name = name.is(pxs_String) ? name.get_string() : "<eval>";
+
+        return pxs_evalnamed(code.get_string().c_str(), code_name.c_str(), static_cast<pxs_Runtime>(runtime.get_int()));
+    }
+
+    pxs_VarT compile(pxs_VarT args) {
+        PXS_ARGC_GT(2); // runtime option, code, globals
+        auto runtime = pxs::Var::from_args(args, 0);
+        PXS_ARG_IS_TYPE(runtime.raw(), pxs_Int64);
+        pxs_Runtime rt = static_cast<pxs_Runtime>(runtime.get_int());
+        auto code = pxs::Var::from_args(args, 1);
+        PXS_ARG_IS_TYPE(code.raw(), pxs_String);
+        auto globals = scope_arg(args, 2);
+        if (pxs_varis(globals, pxs_Exception)) {
+            return globals;
+        }
+
+        auto object = pxs_compile(rt, code.get_string().c_str(), globals);
+        if (!pxs_varis(object, pxs_List)) {
+            // The compile error.
+            return object;
+        }
+        return code_class->make(new Code(rt, object), free_code).raw();
+    }
+
+    pxs_VarT run(pxs_VarT args) {
+        PXS_ARGC_GT(1); // code, locals
+        auto self = yoyo::utils::pxs::get_type<Code>(args, 0, yoyo::types::PXS_CODE_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_type(pxs_arg(args, 0)->tag, pxs_HostObject);
+        }
+        auto locals = scope_arg(args, 1);
+        if (pxs_varis(locals, pxs_Exception)) {
+            return locals;
+        }
+
+        // `pxs_execobject` takes the object, the handle keeps its own.
+        return pxs_execobject(pxs_new_shallowcopy(self->object), locals);
+    }
+
     // Get a Runtime type based on a name
     // works for `py`, `python`, `lua`, `js`, `javascript`.
     pxs_VarT runtime_from_name(pxs_VarT args) {
@@ -62,8 +153,13 @@ namespace yoyo::ipxs {
         pxs_addvar(pxs, "LUA", pxs_newint(pxs_Runtime::pxs_Lua));
         pxs_addvar(pxs, "JS", pxs_newint(pxs_Runtime::pxs_JavaScript));
 
-        // Define exec and TODO: eval
+        code_class.emplace("Code", yoyo::types::PXS_CODE_TYPE);
+        code_class->add_property("runtime", &Code::get_runtime);
+
         pxs_addfunc(pxs, "exec", exec);
+        pxs_addfunc(pxs, "eval", eval);
+        pxs_addfunc(pxs, "compile", compile);
+        pxs_addfunc(pxs, "run", run);
         pxs_addfunc(pxs, "runtime_from_name", runtime_from_name);
 
         pxs_add_submod(yoyo, pxs);
@@ -3,13 +3,647 @@
 #include <pixelscript.h>
 #include <pixelscript_cpp.hpp>
 #include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <utility>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
 #include "shell.hpp"
+#include "utils/types.hpp"
+#include "utils/pxs.hpp"
+#include "utils/pool.hpp"
+#include "utils/exceptions.hpp"
 
-// TODO: implement a better shell.
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <spawn.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <cerrno>
+
+extern char** environ;
+
+// `posix_spawn_file_actions_addchdir_np` is glibc 2.29+ and macOS.
+#if defined(__APPLE__) || (defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29)))
+#define YOYO_SPAWN_CHDIR
+#endif
+#endif
 
 namespace yoyo::shell {
-    // Run a shell command via `std::system`
-    // Output is sent to terminal directly.
+    // Size of a single pipe read, and the default chunk of `Process.read`.
+    constexpr size_t READ_SIZE = 64 * 1024;
+    // Longest a wait sleeps before checking the process again.
+    constexpr int64_t WAIT_SLICE_MS = 50;
+
+    using Clock = std::chrono::steady_clock;
+
+    // What to start. Read from the pixelscript args up front, so workers only see native data.
+    struct SpawnOptions {
+        std::vector<std::string> argv;
+        std::string cwd;
+        std::vector<std::pair<std::string, std::string>> env;
+        bool merge_stderr = false;
+    };
+
+    // Pipes are inheritable for a moment while spawning, two spawns at once could leak them into each other.
+    std::mutex spawn_lock;
+
+    struct ProcessHandle {
+    #if defined(_WIN32)
+        HANDLE process = nullptr;
+        DWORD pid = 0;
+        HANDLE pipes[2] = {nullptr, nullptr};
+    #else
+        pid_t pid = -1;
+        int pipes[2] = {-1, -1};
+    #endif
+        // Read from the pipes, not handed out yet from `taken` on.
+        std::string pending[2];
+        size_t taken[2] = {0, 0};
+        bool exited = false;
+        int exit_code = 0;
+
+        ProcessHandle() = default;
+        ProcessHandle(const ProcessHandle&) = delete;
+        ProcessHandle& operator=(const ProcessHandle&) = delete;
+
+        ~ProcessHandle() {
+            if (!check_exit()) {
+                kill();
+                wait(-1);
+            }
+            close_pipe(0);
+            close_pipe(1);
+        #if defined(_WIN32)
+            if (process) {
+                CloseHandle(process);
+            }
+        #endif
+        }
+
+        bool is_open(int stream) const {
+        #if defined(_WIN32)
+            return pipes[stream] != nullptr;
+        #else
+            return pipes[stream] != -1;
+        #endif
+        }
+
+        void close_pipe(int stream) {
+            if (!is_open(stream)) {
+                return;
+            }
+        #if defined(_WIN32)
+            CloseHandle(pipes[stream]);
+            pipes[stream] = nullptr;
+        #else
+            ::close(pipes[stream]);
+            pipes[stream] = -1;
+        #endif
+        }
+
+        // Move what is available in pipe `stream` into `pending`, without blocking. Closes it at the end.
+        void fill(int stream) {
+            auto& out = pending[stream];
+            while (is_open(stream)) {
+                auto at = out.size();
+            #if defined(_WIN32)
+                DWORD avail = 0;
+                // Fails once the write end is closed.
+                if (!PeekNamedPipe(pipes[stream], nullptr, 0, nullptr, &avail, nullptr)) {
+                    close_pipe(stream);
+                    return;
+                }
+                if (avail == 0) {
+                    return;
+                }
+                DWORD n = 0;
+                out.resize(at + std::min<size_t>(avail, READ_SIZE));
+                bool ok = ReadFile(pipes[stream], out.data() + at, static_cast<DWORD>(out.size() - at), &n, nullptr);
+                out.resize(at + n);
+                if (!ok) {
+                    close_pipe(stream);
+                    return;
+                }
+            #else
+                out.resize(at + READ_SIZE);
+                auto n = ::read(pipes[stream], out.data() + at, READ_SIZE);
+                out.resize(at + std::max<ssize_t>(n, 0));
+                if (n > 0 || (n < 0 && errno == EINTR)) {
+                    continue;
+                }
+                if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                    close_pipe(stream);
+                }
+                return;
+            #endif
+            }
+        }
+
+        // Bytes of `stream` not handed out yet.
+        size_t available(int stream) const {
+            return pending[stream].size() - taken[stream];
+        }
+
+        // Hand out at most `size` bytes of `stream`.
+        std::string take(int stream, size_t size) {
+            auto& buf = pending[stream];
+            auto& at = taken[stream];
+            auto chunk = buf.substr(at, std::min(size, buf.size() - at));
+            at += chunk.size();
+            if (at == buf.size()) {
+                buf.clear();
+                at = 0;
+            } else if (at > READ_SIZE && at * 2 > buf.size()) {
+                // Don't move the rest on every small read.
+                buf.erase(0, at);
+                at = 0;
+            }
+            return chunk;
+        }
+
+        // Did the process exit? Does not block.
+        bool check_exit() {
+            if (exited) {
+                return true;
+            }
+        #if defined(_WIN32)
+            if (WaitForSingleObject(process, 0) != WAIT_OBJECT_0) {
+                return false;
+            }
+            DWORD code = 0;
+            GetExitCodeProcess(process, &code);
+            exit_code = static_cast<int>(code);
+        #else
+            int status = 0;
+            pid_t res;
+            do {
+                res = waitpid(pid, &status, WNOHANG);
+            } while (res < 0 && errno == EINTR);
+            if (res == 0) {
+                return false;
+            }
+            if (res < 0) {
+                // Reaped by someone else.
+                exit_code = -1;
+            } else if (WIFEXITED(status)) {
+                exit_code = WEXITSTATUS(status);
+            } else if (WIFSIGNALED(status)) {
+                exit_code = -WTERMSIG(status);
+            }
+        #endif
+            exited = true;
+            return true;
+        }
+
+        // Block for at most `ms` or until there is output, moving it into `pending`.
+        void park(int64_t ms) {
+        #if defined(_WIN32)
+            // Anonymous pipes can't be waited on, check them often while they are open.
+            if (is_open(0) || is_open(1)) {
+                ms = std::min<int64_t>(ms, 5);
+            }
+            WaitForSingleObject(process, static_cast<DWORD>(ms));
+        #else
+            pollfd fds[2];
+            nfds_t count = 0;
+            for (int stream = 0; stream < 2; stream++) {
+                if (is_open(stream)) {
+                    fds[count++] = {pipes[stream], POLLIN, 0};
+                }
+            }
+            if (count == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+                return;
+            }
+            ::poll(fds, count, static_cast<int>(ms));
+        #endif
+            fill(0);
+            fill(1);
+        }
+
+        // Wait at most `timeout` ms (-1 forever) for the process to exit, draining the pipes meanwhile.
+        bool wait(int64_t timeout) {
+            auto deadline = Clock::now() + std::chrono::milliseconds(std::max<int64_t>(timeout, 0));
+            // Without pipes to wake us the exit is polled, starting fast.
+            int64_t backoff = 1;
+            while (!check_exit()) {
+                int64_t slice = (is_open(0) || is_open(1)) ? WAIT_SLICE_MS : backoff;
+                backoff = std::min(backoff * 2, WAIT_SLICE_MS);
+                if (timeout >= 0) {
+                    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+                    if (left <= 0) {
+                        return false;
+                    }
+                    slice = std::min<int64_t>(slice, left);
+                }
+                park(slice);
+            }
+            fill(0);
+            fill(1);
+            return true;
+        }
+
+        void kill() {
+            if (check_exit()) {
+                return;
+            }
+        #if defined(_WIN32)
+            TerminateProcess(process, 1);
+        #else
+            ::kill(pid, SIGKILL);
+        #endif
+        }
+    };
+
+#if defined(_WIN32)
+    // Quote `arg` the way `CommandLineToArgvW` splits it.
+    std::string quote_arg(const std::string& arg) {
+        if (!arg.empty() && arg.find_first_of(" \t\n\v\"") == std::string::npos) {
+            return arg;
+        }
+        std::string out = "\"";
+        for (auto it = arg.begin();; ++it) {
+            size_t backslashes = 0;
+            while (it != arg.end() && *it == '\\') {
+                ++it;
+                ++backslashes;
+            }
+            if (it == arg.end()) {
+                out.append(backslashes * 2, '\\');
+                break;
+            }
+            if (*it == '"') {
+                out.append(backslashes * 2 + 1, '\\');
+            } else {
+                out.append(backslashes, '\\');
+            }
+            out.push_back(*it);
+        }
+        out.push_back('"');
+        return out;
+    }
+#endif
+
+    // Does the `KEY=value` `entry` set one of the keys of `env`?
+    bool overridden(std::string_view entry, const std::vector<std::pair<std::string, std::string>>& env) {
+        for (const auto& [key, value] : env) {
+            if (entry.size() > key.size() && entry[key.size()] == '=') {
+            #if defined(_WIN32)
+                if (_strnicmp(entry.data(), key.c_str(), key.size()) == 0) {
+                    return true;
+                }
+            #else
+                if (entry.compare(0, key.size(), key) == 0) {
+                    return true;
+                }
+            #endif
+            }
+        }
+        return false;
+    }
+
+    // Start a process. Only native data, safe on any thread.
+    //
+    // returns the handle, or nullptr with `error` set.
+    std::unique_ptr<ProcessHandle> start(const SpawnOptions& opts, std::string& error) {
+        auto handle = std::make_unique<ProcessHandle>();
+        // Nothing to wait for until it started.
+        handle->exited = true;
+        std::lock_guard<std::mutex> guard(spawn_lock);
+    #if defined(_WIN32)
+        SECURITY_ATTRIBUTES sa{sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE};
+        HANDLE writers[2] = {nullptr, nullptr};
+        for (int stream = 0; stream < (opts.merge_stderr ? 1 : 2); stream++) {
+            if (!CreatePipe(&handle->pipes[stream], &writers[stream], &sa, 0)) {
+                error = "Could not create the pipes of " + opts.argv[0];
+                for (auto w : writers) {
+                    if (w) {
+                        CloseHandle(w);
+                    }
+                }
+                return nullptr;
+            }
+            SetHandleInformation(handle->pipes[stream], HANDLE_FLAG_INHERIT, 0);
+        }
+        HANDLE null_in = CreateFileA("NUL", GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, &sa, OPEN_EXISTING, 0, nullptr);
+
+        STARTUPINFOA si{};
+        si.cb = sizeof(si);
+        si.dwFlags = STARTF_USESTDHANDLES;
+        si.hStdInput = null_in;
+        si.hStdOutput = writers[0];
+        si.hStdError = opts.merge_stderr ? writers[0] : writers[1];
+
+        std::string command;
+        for (const auto& arg : opts.argv) {
+            if (!command.empty()) {
+                command.push_back(' ');
+            }
+            command += quote_arg(arg);
+        }
+
+        // `KEY=value\0...\0\0`
+        std::string env_block;
+        if (!opts.env.empty()) {
+            auto current = GetEnvironmentStringsA();
+            for (auto entry = current; entry && *entry; entry += std::strlen(entry) + 1) {
+                if (!overridden(entry, opts.env)) {
+                    env_block.append(entry).push_back('\0');
+                }
+            }
+            FreeEnvironmentStringsA(current);
+            for (const auto& [key, value] : opts.env) {
+                env_block.append(key).append("=").append(value).push_back('\0');
+            }
+            env_block.push_back('\0');
+        }
+
+        PROCESS_INFORMATION pi{};
+        bool ok = CreateProcessA(
+            nullptr, command.data(), nullptr, nullptr, TRUE, CREATE_NO_WINDOW,
+            env_block.empty() ? nullptr : env_block.data(),
+            opts.cwd.empty() ? nullptr : opts.cwd.c_str(),
+            &si, &pi
+        );
+        for (auto w : writers) {
+            if (w) {
+                CloseHandle(w);
+            }
+        }
+        if (null_in != INVALID_HANDLE_VALUE) {
+            CloseHandle(null_in);
+        }
+        if (!ok) {
+            error = "Could not spawn " + opts.argv[0] + ", error " + std::to_string(GetLastError());
+            return nullptr;
+        }
+        CloseHandle(pi.hThread);
+        handle->process = pi.hProcess;
+        handle->pid = pi.dwProcessId;
+    #else
+        int writers[2] = {-1, -1};
+        auto close_writers = [&] {
+            for (auto w : writers) {
+                if (w != -1) {
+                    ::close(w);
+                }
+            }
+        };
+        for (int stream = 0; stream < (opts.merge_stderr ? 1 : 2); stream++) {
+            int fds[2];
+            if (::pipe(fds) != 0) {
+                error = "Could not create the pipes of " + opts.argv[0] + ": " + std::strerror(errno);
+                close_writers();
+                return nullptr;
+            }
+            // The child gets them through `dup2`, which clears CLOEXEC on the copy.
+            fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+            fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+            fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+            handle->pipes[stream] = fds[0];
+            writers[stream] = fds[1];
+        }
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_addopen(&actions, 0, "/dev/null", O_RDONLY, 0);
+        posix_spawn_file_actions_adddup2(&actions, writers[0], 1);
+        posix_spawn_file_actions_adddup2(&actions, opts.merge_stderr ? writers[0] : writers[1], 2);
+        if (!opts.cwd.empty()) {
+        #ifdef YOYO_SPAWN_CHDIR
+            posix_spawn_file_actions_addchdir_np(&actions, opts.cwd.c_str());
+        #else
+            posix_spawn_file_actions_destroy(&actions);
+            close_writers();
+            error = "cwd is not supported on this platform.";
+            return nullptr;
+        #endif
+        }
+
+        std::vector<char*> argv;
+        for (const auto& arg : opts.argv) {
+            argv.push_back(const_cast<char*>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+
+        std::vector<std::string> env_strings;
+        std::vector<char*> envp;
+        if (!opts.env.empty()) {
+            for (auto entry = environ; entry && *entry; entry++) {
+                if (!overridden(*entry, opts.env)) {
+                    envp.push_back(*entry);
+                }
+            }
+            for (const auto& [key, value] : opts.env) {
+                env_strings.push_back(key + "=" + value);
+            }
+            for (auto& entry : env_strings) {
+                envp.push_back(entry.data());
+            }
+            envp.push_back(nullptr);
+        }
+
+        int res = posix_spawnp(&handle->pid, argv[0], &actions, nullptr, argv.data(), envp.empty() ? environ : envp.data());
+        posix_spawn_file_actions_destroy(&actions);
+        close_writers();
+        if (res != 0) {
+            error = "Could not spawn " + opts.argv[0] + ": " + std::strerror(res);
+            return nullptr;
+        }
+    #endif
+        handle->exited = false;
+        return handle;
+    }
+
+    // Call `f(key, value)` for every pair of the `opts` map. `key` is only valid during the call.
+    template<typename F>
+    void each_option(pxs_VarT opts, F&& f) {
+        pxs_MapIter iter;
+        pxs_VarT key = nullptr;
+        pxs_VarT value = nullptr;
+        pxs_mapiter_begin(opts, &iter);
+        while (pxs_mapiter_next(&iter, &key, &value)) {
+            size_t len = 0;
+            auto str = pxs_getstrview(key, &len);
+            if (str != nullptr) {
+                f(std::string_view(str, len), value);
+            }
+        }
+    }
+
+    std::string string_of(pxs_VarT var) {
+        size_t len = 0;
+        auto str = pxs_getstrview(var, &len);
+        return str == nullptr ? std::string() : std::string(str, len);
+    }
+
+    // Read `argv` into `out`.
+    //
+    // returns a exception, or nullptr.
+    pxs_VarT read_argv(const pxs::Var& argv, SpawnOptions& out) {
+        if (!argv.is(pxs_List)) {
+            return yoyo::utils::exceptions::expected_type(argv.raw()->tag, pxs_List);
+        }
+        for (int i = 0; i < argv.list_len(); i++) {
+            auto arg = argv.list_get(i);
+            if (!arg.is(pxs_String)) {
+                return yoyo::utils::exceptions::expected_type(arg.raw()->tag, pxs_String);
+            }
+            out.argv.push_back(arg.get_string());
+        }
+        if (out.argv.empty()) {
+            return pxs_newexception("Expected argv to hold at least the program.");
+        }
+        return nullptr;
+    }
+
+    // Read the `spawn` options into `out`. Other keys are left to the caller.
+    //
+    // returns a exception, or nullptr.
+    pxs_VarT read_options(const pxs::Var& opts, SpawnOptions& out) {
+        if (opts.is(pxs_Null)) {
+            return nullptr;
+        }
+        if (!opts.is(pxs_Map)) {
+            return yoyo::utils::exceptions::expected_type(opts.raw()->tag, pxs_Map);
+        }
+        pxs_VarT error = nullptr;
+        each_option(opts.raw(), [&](std::string_view key, pxs_VarT value) {
+            if (error) {
+                return;
+            }
+            if (key == "cwd") {
+                if (!pxs_varis(value, pxs_String)) {
+                    error = yoyo::utils::exceptions::expected_type(value->tag, pxs_String);
+                    return;
+                }
+                out.cwd = string_of(value);
+            } else if (key == "env") {
+                if (!pxs_varis(value, pxs_Map)) {
+                    error = yoyo::utils::exceptions::expected_type(value->tag, pxs_Map);
+                    return;
+                }
+                each_option(value, [&](std::string_view name, pxs_VarT env_value) {
+                    if (!error && !pxs_varis(env_value, pxs_String)) {
+                        error = yoyo::utils::exceptions::expected_type(env_value->tag, pxs_String);
+                    }
+                    out.env.emplace_back(std::string(name), string_of(env_value));
+                });
+            } else if (key == "merge_stderr") {
+                out.merge_stderr = pxs_varis(value, pxs_Bool) && pxs_getbool(value);
+            }
+        });
+        return error;
+    }
+
+    // Class of the `Process` host object. Created in `init` since the function lookup is reset with pixelscript.
+    std::optional<pxs::Class<Process>> process_class;
+
+    Process::Process(std::unique_ptr<ProcessHandle> handle) : handle(std::move(handle)) {}
+
+    Process::~Process() = default;
+
+    void free_process(pxs_Opaque ptr) {
+        if (!ptr) {
+            return;
+        }
+
+        delete static_cast<Process*>(ptr);
+    }
+
+    pxs_VarT Process::get_pid(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Process>(args, 0, yoyo::types::SHELL_PROCESS_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        return pxs_newint(static_cast<int64_t>(self->handle->pid));
+    }
+
+    pxs_VarT Process::get_exit_code(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Process>(args, 0, yoyo::types::SHELL_PROCESS_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        if (!self->handle->check_exit()) {
+            return pxs_newnull();
+        }
+        return pxs_newint(self->handle->exit_code);
+    }
+
+    pxs_VarT Process::read(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Process>(args, 0, yoyo::types::SHELL_PROCESS_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        int stream = static_cast<int>(ProcessStream::Stdout);
+        auto stream_arg = pxs::Var::from_args(args, 1);
+        if (stream_arg.is(pxs_Int64) || stream_arg.is(pxs_UInt64)) {
+            stream = static_cast<int>(stream_arg.get_int());
+        }
+        if (stream != static_cast<int>(ProcessStream::Stdout) && stream != static_cast<int>(ProcessStream::Stderr)) {
+            return yoyo::utils::exceptions::invalid_enum();
+        }
+        size_t size = READ_SIZE;
+        auto size_arg = pxs::Var::from_args(args, 2);
+        if (size_arg.is(pxs_Int64) || size_arg.is(pxs_UInt64)) {
+            size = static_cast<size_t>(std::max<int64_t>(1, size_arg.get_int()));
+        }
+        bool as_bytes = pxs::Var::from_args(args, 3).get_bool();
+
+        auto& handle = *self->handle;
+        handle.fill(stream);
+        if (handle.available(stream) == 0) {
+            return handle.is_open(stream) ? pxs_newstring("") : pxs_newnull();
+        }
+        auto chunk = handle.take(stream, size);
+        if (as_bytes) {
+            return pxs_newbytes(static_cast<pxs_Opaque>(chunk.data()), sizeof(char), chunk.size());
+        }
+        return pxs_newstring(chunk.c_str());
+    }
+
+    pxs_VarT Process::wait(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Process>(args, 0, yoyo::types::SHELL_PROCESS_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        int64_t timeout = -1;
+        auto timeout_arg = pxs::Var::from_args(args, 1);
+        if (timeout_arg.is(pxs_Int64) || timeout_arg.is(pxs_UInt64)) {
+            timeout = timeout_arg.get_int();
+        }
+
+        if (!self->handle->wait(timeout)) {
+            return pxs_newnull();
+        }
+        return pxs_newint(self->handle->exit_code);
+    }
+
+    pxs_VarT Process::kill(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Process>(args, 0, yoyo::types::SHELL_PROCESS_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        self->handle->kill();
+        return pxs_newnull();
+    }
+
     pxs_VarT system(pxs_VarT args) {
         PXS_ARGC_EQ(1); // command
         auto command = pxs::Var::from_args(args, 0);
@@ -19,13 +653,145 @@ namespace yoyo::shell {
         return pxs_newint(res);
     }
 
+    pxs_VarT spawn(pxs_VarT args) {
+        SpawnOptions opts;
+        if (auto error = read_argv(pxs::Var::from_args(args, 0), opts)) {
+            return error;
+        }
+        if (auto error = read_options(pxs::Var::from_args(args, 1), opts)) {
+            return error;
+        }
+
+        std::string error;
+        auto handle = start(opts, error);
+        if (!handle) {
+            return pxs_newexception(error.c_str());
+        }
+        return process_class->make(new Process(std::move(handle)), free_process).raw();
+    }
+
+    pxs_VarT run_many(pxs_VarT args) {
+        auto list = pxs::Var::from_args(args, 0);
+        if (!list.is(pxs_List)) {
+            return yoyo::utils::exceptions::expected_type(list.raw()->tag, pxs_List);
+        }
+        auto opts_arg = pxs::Var::from_args(args, 1);
+        SpawnOptions shared;
+        if (auto error = read_options(opts_arg, shared)) {
+            return error;
+        }
+        size_t max_concurrency = std::max<size_t>(1, std::thread::hardware_concurrency());
+        int64_t timeout = -1;
+        if (opts_arg.is(pxs_Map)) {
+            each_option(opts_arg.raw(), [&](std::string_view key, pxs_VarT value) {
+                if (!pxs_varis(value, pxs_Int64) && !pxs_varis(value, pxs_UInt64)) {
+                    return;
+                }
+                if (key == "max_concurrency") {
+                    max_concurrency = static_cast<size_t>(std::max<int64_t>(1, pxs_getint(value)));
+                } else if (key == "timeout") {
+                    timeout = pxs_getint(value);
+                }
+            });
+        }
+
+        struct Item {
+            SpawnOptions opts;
+            std::string out;
+            std::string err;
+            std::string error;
+            int code = 0;
+            bool timed_out = false;
+        };
+
+        // Everything pixelscript is read here, the workers only see native data.
+        std::vector<Item> items(list.list_len());
+        for (size_t i = 0; i < items.size(); i++) {
+            items[i].opts = shared;
+            if (auto error = read_argv(list.list_get(static_cast<int>(i)), items[i].opts)) {
+                return error;
+            }
+        }
+
+        // `max_concurrency` workers, each starting the next process and waiting on it.
+        size_t workers = std::min(items.size(), max_concurrency);
+        std::mutex lock;
+        std::condition_variable cv;
+        size_t next = 0;
+        size_t running = workers;
+        for (size_t w = 0; w < workers; w++) {
+            utils::pool::shared().submit([&]() {
+                while (true) {
+                    size_t i;
+                    {
+                        std::lock_guard<std::mutex> guard(lock);
+                        if (next >= items.size()) {
+                            break;
+                        }
+                        i = next++;
+                    }
+
+                    auto& item = items[i];
+                    auto handle = start(item.opts, item.error);
+                    if (!handle) {
+                        continue;
+                    }
+                    if (!handle->wait(timeout)) {
+                        item.timed_out = true;
+                        handle->kill();
+                        handle->wait(-1);
+                    }
+                    item.code = handle->exit_code;
+                    item.out = handle->take(0, handle->available(0));
+                    item.err = handle->take(1, handle->available(1));
+                }
+
+                std::lock_guard<std::mutex> guard(lock);
+                if (--running == 0) {
+                    cv.notify_one();
+                }
+            });
+        }
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            cv.wait(guard, [&] { return running == 0; });
+        }
+
+        auto result = pxs_newlist_with_capacity(items.size());
+        for (auto& item : items) {
+            if (!item.error.empty()) {
+                pxs_listadd(result, pxs_newexception(item.error.c_str()));
+                continue;
+            }
+            auto map = pxs_newmap();
+            pxs_map_addpair(map, pxs_newstring("code"), item.timed_out ? pxs_newnull() : pxs_newint(item.code));
+            pxs_map_addpair(map, pxs_newstring("stdout"), pxs_newstring(item.out.c_str()));
+            pxs_map_addpair(map, pxs_newstring("stderr"), pxs_newstring(item.err.c_str()));
+            pxs_map_addpair(map, pxs_newstring("timed_out"), pxs_newbool(item.timed_out));
+            pxs_listadd(result, map);
+        }
+        return result;
+    }
+
     void init(pxs_Module* yoyo) {
+        process_class.emplace("Process", yoyo::types::SHELL_PROCESS_TYPE);
+        process_class->add_property("pid", &Process::get_pid);
+        process_class->add_property("exit_code", &Process::get_exit_code);
+        process_class->add_method("read", &Process::read);
+        process_class->add_method("wait", &Process::wait);
+        process_class->add_method("kill", &Process::kill);
+
         auto shell_mod = pxs_newmod("shell");
 
+        pxs_addvar(shell_mod, "PROCESS_STREAM_STDOUT", pxs_newint(static_cast<int>(ProcessStream::Stdout)));
+        pxs_addvar(shell_mod, "PROCESS_STREAM_STDERR", pxs_newint(static_cast<int>(ProcessStream::Stderr)));
+
         pxs_addfunc(shell_mod, "system", system);
+        pxs_addfunc(shell_mod, "spawn", spawn);
+        pxs_addfunc(shell_mod, "run_many", run_many);
 
         pxs_add_submod(yoyo, shell_mod);
     }
 }
 
-#endif // YOYO_SHELL
\ No newline at end of file
+#endif // YOYO_SHELL
@@ -0,0 +1,641 @@
+#ifdef YOYO_SHM
+
+#include "shm.hpp"
+#include <pixelscript_cpp.hpp>
+#include "utils/types.hpp"
+#include "utils/pxs.hpp"
+#include "utils/exceptions.hpp"
+#include "utils/bytes.hpp"
+#ifdef YOYO_ARRAY
+#include "array.hpp"
+#endif
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace yoyo::shm {
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "seqlocks in shared memory need lock free 64 bit atomics");
+
+    struct Mapping {
+        std::string name;
+        uint8_t* data = nullptr;
+        size_t size = 0;
+#if defined(_WIN32)
+        HANDLE handle = nullptr;
+#endif
+
+        ~Mapping() {
+#if defined(_WIN32)
+            if (data != nullptr) {
+                UnmapViewOfFile(data);
+            }
+            if (handle != nullptr) {
+                CloseHandle(handle);
+            }
+#else
+            if (data != nullptr) {
+                munmap(data, size);
+            }
+#endif
+        }
+    };
+
+    // POSIX names are a single path component starting with `/`.
+    std::string os_name(const std::string& name) {
+#if defined(_WIN32)
+        return "Local\\yoyo_" + name;
+#else
+        return name.size() > 0 && name[0] == '/' ? name : "/" + name;
+#endif
+    }
+
+    // Map `name`, creating it with `size` bytes when `create` is set. Sets `error` on failure.
+    std::shared_ptr<Mapping> map_region(const std::string& name, size_t size, bool create, std::string& error) {
+        auto mapping = std::make_shared<Mapping>();
+        mapping->name = name;
+        auto path = os_name(name);
+#if defined(_WIN32)
+        if (create) {
+            auto size64 = static_cast<uint64_t>(size);
+            mapping->handle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64 & 0xFFFFFFFF), path.c_str());
+        } else {
+            mapping->handle = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, path.c_str());
+        }
+        if (mapping->handle == nullptr) {
+            error = "Could not open shared memory: " + name;
+            return nullptr;
+        }
+        bool existed = !create || GetLastError() == ERROR_ALREADY_EXISTS;
+        mapping->data = static_cast<uint8_t*>(MapViewOfFile(mapping->handle, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+        if (mapping->data == nullptr) {
+            error = "Could not map shared memory: " + name;
+            return nullptr;
+        }
+        // An existing section keeps its size, only known rounded up to pages.
+        MEMORY_BASIC_INFORMATION info;
+        if (VirtualQuery(mapping->data, &info, sizeof(info)) == 0) {
+            error = "Could not map shared memory: " + name;
+            return nullptr;
+        }
+        mapping->size = existed ? static_cast<size_t>(info.RegionSize) : size;
+#else
+        int fd = shm_open(path.c_str(), create ? (O_RDWR | O_CREAT) : O_RDWR, 0600);
+        if (fd < 0) {
+            error = "Could not open shared memory: " + name + " (" + std::strerror(errno) + ")";
+            return nullptr;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            error = "Could not open shared memory: " + name;
+            return nullptr;
+        }
+        // A region only grows, so processes with a mapping never lose pages under them.
+        if (create && static_cast<size_t>(st.st_size) < size) {
+            if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+                close(fd);
+                error = "Could not size shared memory: " + name + " (" + std::strerror(errno) + ")";
+                return nullptr;
+            }
+            st.st_size = static_cast<off_t>(size);
+        }
+        mapping->size = static_cast<size_t>(st.st_size);
+        if (mapping->size == 0) {
+            close(fd);
+            error = "Shared memory is empty: " + name;
+            return nullptr;
+        }
+        void* data = mmap(nullptr, mapping->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            error = "Could not map shared memory: " + name + " (" + std::strerror(errno) + ")";
+            return nullptr;
+        }
+        mapping->data = static_cast<uint8_t*>(data);
+#endif
+        return mapping;
+    }
+
+    // Mappings kept alive by the views handed to scripts, keyed by the view's data pointer.
+    std::mutex views_lock;
+    std::unordered_multimap<const void*, std::shared_ptr<Mapping>> views;
+
+    void free_view(void* data) {
+        std::shared_ptr<Mapping> mapping;
+        {
+            std::lock_guard<std::mutex> guard(views_lock);
+            auto it = views.find(data);
+            if (it == views.end()) {
+                return;
+            }
+            // Unmapped outside the lock.
+            mapping = std::move(it->second);
+            views.erase(it);
+        }
+    }
+
+    // Class of the `Region` host object. Created in `init` since the function lookup is reset with pixelscript.
+    std::optional<pxs::Class<Region>> region_class;
+
+    Region::Region(std::shared_ptr<Mapping> mapping) : mapping(std::move(mapping)) {}
+
+    void free_region(pxs_Opaque ptr) {
+        if (!ptr) {
+            return;
+        }
+
+        delete static_cast<Region*>(ptr);
+    }
+
+    // Get the int arg at `idx`. Returns false when it is not a int.
+    bool get_int_arg(pxs_VarT args, int idx, int64_t& out) {
+        auto arg = pxs_arg(args, idx);
+        if (!pxs_varis(arg, pxs_Int64) && !pxs_varis(arg, pxs_UInt64)) {
+            return false;
+        }
+        out = pxs_getint(arg);
+        return true;
+    }
+
+    pxs_VarT expected_int(pxs_VarT args, int idx) {
+        return utils::exceptions::expected_type(pxs_vartype(pxs_arg(args, idx)), pxs_Int64);
+    }
+
+    // Does `[offset, offset + len)` fit in `size`?
+    bool in_range(int64_t offset, uint64_t len, size_t size) {
+        return offset >= 0 && static_cast<uint64_t>(offset) <= size && len <= size - static_cast<uint64_t>(offset);
+    }
+
+    pxs_VarT out_of_range(int64_t offset, uint64_t len, size_t size) {
+        auto msg = "Range " + std::to_string(offset) + "+" + std::to_string(len) + " is out of a region of " + std::to_string(size) + " bytes";
+        return pxs_newexception(msg.c_str());
+    }
+
+    pxs_VarT expected_bytes(pxs_VarT args, int idx) {
+        return utils::exceptions::expected_types(pxs_vartype(pxs_arg(args, idx)), {pxs_String, pxs_List});
+    }
+
+    size_t value_size(ValueType type) {
+        switch (type) {
+            case ValueType::I8: case ValueType::U8: return 1;
+            case ValueType::I16: case ValueType::U16: return 2;
+            case ValueType::I32: case ValueType::U32: case ValueType::F32: return 4;
+            default: return 8;
+        }
+    }
+
+    // Unaligned, so any offset works.
+    template<typename T>
+    T load(const uint8_t* at) {
+        T value;
+        std::memcpy(&value, at, sizeof(T));
+        return value;
+    }
+
+    template<typename T>
+    void store(uint8_t* at, T value) {
+        std::memcpy(at, &value, sizeof(T));
+    }
+
+    // The seqlock counter at `offset`. Processes share it through the mapping, so it has to be lock free.
+    std::atomic<uint64_t>* seq_at(uint8_t* data, int64_t offset) {
+        return reinterpret_cast<std::atomic<uint64_t>*>(data + offset);
+    }
+
+    pxs_VarT Region::get_name(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Region>(args, 0, yoyo::types::SHM_REGION_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        return pxs_newstring(self->mapping->name.c_str());
+    }
+
+    pxs_VarT Region::get_size(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Region>(args, 0, yoyo::types::SHM_REGION_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        return pxs_newint(static_cast<int64_t>(self->mapping->size));
+    }
+
+    pxs_VarT Region::get(pxs_VarT args) {
+        PXS_ARGC_EQ(3); // self, type, offset
+        auto self = yoyo::utils::pxs::get_type<Region>(args, 0, yoyo::types::SHM_REGION_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        int64_t type_int, offset;
+        if (!get_int_arg(args, 1, type_int)) {
+            return expected_int(args, 1);
+        }
+        if (type_int < 0 || type_int > static_cast<int64_t>(ValueType::F64)) {
+            return utils::exceptions::invalid_enum();
+        }
+        if (!get_int_arg(args, 2, offset)) {
+            return expected_int(args, 2);
+        }
+        auto type = static_cast<ValueType>(type_int);
+        auto& mapping = *self->mapping;
+        if (!in_range(offset, value_size(type), mapping.size)) {
+            return out_of_range(offset, value_size(type), mapping.size);
+        }
+
+        auto at = mapping.data + offset;
+        switch (type) {
+            case ValueType::I8: return pxs_newint(load<int8_t>(at));
+            case ValueType::U8: return pxs_newint(load<uint8_t>(at));
+            case ValueType::I16: return pxs_newint(load<int16_t>(at));
+            case ValueType::U16: return pxs_newint(load<uint16_t>(at));
+            case ValueType::I32: return pxs_newint(load<int32_t>(at));
+            case ValueType::U32: return pxs_newint(load<uint32_t>(at));
+            case ValueType::I64: return pxs_newint(load<int64_t>(at));
+            case ValueType::U64: return pxs_newuint(load<uint64_t>(at));
+            case ValueType::F32: return pxs_newfloat(load<float>(at));
+            case ValueType::F64: return pxs_newfloat(load<double>(at));
+        }
+        return pxs_newnull();
+    }
+
+    pxs_VarT Region::set(pxs_VarT args) {
+        PXS_ARGC_EQ(4); // self, type, offset, value
+        auto self = yoyo::utils::pxs::get_type<Region>(args, 0, yoyo::types::SHM_REGION_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        int64_t type_int, offset;
+        if (!get_int_arg(args, 1, type_int)) {
+            return expected_int(args, 1);
+        }
+        if (type_int < 0 || type_int > static_cast<int64_t>(ValueType::F64)) {
+            return utils::exceptions::invalid_enum();
+        }
+        if (!get_int_arg(args, 2, offset)) {
+            return expected_int(args, 2);
+        }
+        auto value = pxs_arg(args, 3);
+        bool is_float = pxs_varis(value, pxs_Float64);
+        if (!is_float && !pxs_varis(value, pxs_Int64) && !pxs_varis(value, pxs_UInt64)) {
+            return utils::exceptions::expected_types(pxs_vartype(value), {pxs_Int64, pxs_Float64});
+        }
+        auto type = static_cast<ValueType>(type_int);
+        auto& mapping = *self->mapping;
+        if (!in_range(offset, value_size(type), mapping.size)) {
+            return out_of_range(offset, value_size(type), mapping.size);
+        }
+
+        auto at = mapping.data + offset;
+        // Integers go through int64 so they wrap like a C cast, floats truncate.
+        auto as_int = is_float ? static_cast<int64_t>(pxs_getfloat(value)) : pxs_getint(value);
+        auto as_float = pxs_getfloat(value);
+        switch (type) {
+            case ValueType::I8: store(at, static_cast<int8_t>(as_int)); break;
+            case ValueType::U8: store(at, static_cast<uint8_t>(as_int)); break;
+            case ValueType::I16: store(at, static_cast<int16_t>(as_int)); break;
+            case ValueType::U16: store(at, static_cast<uint16_t>(as_int)); break;
+            case ValueType::I32: store(at, static_cast<int32_t>(as_int)); break;
+            case ValueType::U32: store(at, static_cast<uint32_t>(as_int)); break;
+            case ValueType::I64: store(at, as_int); break;
+            case ValueType::U64: store(at, pxs_varis(value, pxs_UInt64) ? pxs_getuint(value) : static_cast<uint64_t>(as_int)); break;
+            case ValueType::F32: store(at, static_cast<float>(as_float)); break;
+            case ValueType::F64: store(at, as_float); break;
+        }
+        return pxs_newnull();
+    }
+
+    pxs_VarT Region::read(pxs_VarT args) {
+        PXS_ARGC_EQ(3); // self, offset, len
+        auto self = yoyo::utils::pxs::get_type<Region>(args, 0, yoyo::types::SHM_REGION_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        int64_t offset, len;
+        if (!get_int_arg(args, 1, offset)) {
+            return expected_int(args, 1);
+        }
+        if (!get_int_arg(args, 2, len) || len < 0) {
+            return expected_int(args, 2);
+        }
+        auto& mapping = *self->mapping;
+        if (!in_range(offset, static_cast<uint64_t>(len), mapping.size)) {
+            return out_of_range(offset, static_cast<uint64_t>(len), mapping.size);
+        }
+
+        return pxs_newbytes(static_cast<pxs_Opaque>(mapping.data + offset), sizeof(uint8_t), static_cast<size_t>(len));
+    }
+
+    pxs_VarT Region::write(pxs_VarT args) {
+        PXS_ARGC_EQ(3); // self, offset, data
+        auto self = yoyo::utils::pxs::get_type<Region>(args, 0, yoyo::types::SHM_REGION_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        int64_t offset;
+        if (!get_int_arg(args, 1, offset)) {
+            return expected_int(args, 1);
+        }
+        const uint8_t* data;
+        size_t len;
+        std::vector<uint8_t> storage;
+        if (!utils::bytes::view_bytes(pxs_arg(args, 2), data, len, storage)) {
+            return expected_bytes(args, 2);
+        }
+        auto& mapping = *self->mapping;
+        if (!in_range(offset, len, mapping.size)) {
+            return out_of_range(offset, len, mapping.size);
+        }
+
+        if (len > 0) {
+            std::memcpy(mapping.data + offset, data, len);
+        }
+        return pxs_newnull();
+    }
+
+    pxs_VarT Region::view(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Region>(args, 0, yoyo::types::SHM_REGION_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        auto& mapping = *self->mapping;
+        int64_t offset = 0;
+        if (PXS_ARGC() > 1 && !pxs_varis(pxs_arg(args, 1), pxs_Null) && !get_int_arg(args, 1, offset)) {
+            return expected_int(args, 1);
+        }
+        int64_t len = offset >= 0 && static_cast<uint64_t>(offset) <= mapping.size ? static_cast<int64_t>(mapping.size) - offset : 0;
+        if (PXS_ARGC() > 2 && !pxs_varis(pxs_arg(args, 2), pxs_Null) && (!get_int_arg(args, 2, len) || len < 0)) {
+            return expected_int(args, 2);
+        }
+        if (!in_range(offset, static_cast<uint64_t>(len), mapping.size)) {
+            return out_of_range(offset, static_cast<uint64_t>(len), mapping.size);
+        }
+
+        auto data = mapping.data + offset;
+        {
+            std::lock_guard<std::mutex> guard(views_lock);
+            views.emplace(data, self->mapping);
+        }
+        return pxs_newbytes_borrowed(static_cast<pxs_Opaque>(data), static_cast<size_t>(len), free_view);
+    }
+
+    pxs_VarT Region::seq_write(pxs_VarT args) {
+        PXS_ARGC_EQ(4); // self, seq_offset, offset, data
+        auto self = yoyo::utils::pxs::get_type<Region>(args, 0, yoyo::types::SHM_REGION_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        int64_t seq_offset, offset;
+        if (!get_int_arg(args, 1, seq_offset)) {
+            return expected_int(args, 1);
+        }
+        if (!get_int_arg(args, 2, offset)) {
+            return expected_int(args, 2);
+        }
+        const uint8_t* data;
+        size_t len;
+        std::vector<uint8_t> storage;
+        if (!utils::bytes::view_bytes(pxs_arg(args, 3), data, len, storage)) {
+            return expected_bytes(args, 3);
+        }
+        auto& mapping = *self->mapping;
+        if (!in_range(seq_offset, sizeof(uint64_t), mapping.size) || seq_offset % 8 != 0) {
+            return pxs_newexception(("Invalid seqlock offset " + std::to_string(seq_offset)).c_str());
+        }
+        if (!in_range(offset, len, mapping.size)) {
+            return out_of_range(offset, len, mapping.size);
+        }
+
+        auto seq = seq_at(mapping.data, seq_offset);
+        // An odd counter is a write in progress, taking it from even to odd also locks out other writers.
+        auto current = seq->load(std::memory_order_relaxed);
+        while (true) {
+            if (current % 2 == 0 && seq->compare_exchange_weak(current, current + 1, std::memory_order_acquire)) {
+                break;
+            }
+            if (current % 2 != 0) {
+                std::this_thread::yield();
+                current = seq->load(std::memory_order_relaxed);
+            }
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        if (len > 0) {
+            std::memcpy(mapping.data + offset, data, len);
+        }
+        seq->store(current + 2, std::memory_order_release);
+        return pxs_newnull();
+    }
+
+    pxs_VarT Region::seq_read(pxs_VarT args) {
+        PXS_ARGC_EQ(4); // self, seq_offset, offset, len
+        auto self = yoyo::utils::pxs::get_type<Region>(args, 0, yoyo::types::SHM_REGION_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        int64_t seq_offset, offset, len;
+        if (!get_int_arg(args, 1, seq_offset)) {
+            return expected_int(args, 1);
+        }
+        if (!get_int_arg(args, 2, offset)) {
+            return expected_int(args, 2);
+        }
+        if (!get_int_arg(args, 3, len) || len < 0) {
+            return expected_int(args, 3);
+        }
+        auto& mapping = *self->mapping;
+        if (!in_range(seq_offset, sizeof(uint64_t), mapping.size) || seq_offset % 8 != 0) {
+            return pxs_newexception(("Invalid seqlock offset " + std::to_string(seq_offset)).c_str());
+        }
+        if (!in_range(offset, static_cast<uint64_t>(len), mapping.size)) {
+            return out_of_range(offset, static_cast<uint64_t>(len), mapping.size);
+        }
+
+        auto seq = seq_at(mapping.data, seq_offset);
+        std::vector<uint8_t> copy(static_cast<size_t>(len));
+        while (true) {
+            auto before = seq->load(std::memory_order_acquire);
+            if (before % 2 != 0) {
+                std::this_thread::yield();
+                continue;
+            }
+            if (!copy.empty()) {
+                std::memcpy(copy.data(), mapping.data + offset, copy.size());
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq->load(std::memory_order_relaxed) == before) {
+                break;
+            }
+        }
+        return pxs_newbytes(static_cast<pxs_Opaque>(copy.data()), sizeof(uint8_t), copy.size());
+    }
+
+    pxs_VarT Region::read_array(pxs_VarT args) {
+#ifdef YOYO_ARRAY
+        PXS_ARGC_EQ(4); // self, kind, offset, len
+        auto self = yoyo::utils::pxs::get_type<Region>(args, 0, yoyo::types::SHM_REGION_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        int64_t kind, offset, len;
+        if (!get_int_arg(args, 1, kind)) {
+            return expected_int(args, 1);
+        }
+        if (kind < 0 || kind > static_cast<int64_t>(array::Kind::U8)) {
+            return utils::exceptions::invalid_enum();
+        }
+        if (!get_int_arg(args, 2, offset)) {
+            return expected_int(args, 2);
+        }
+        if (!get_int_arg(args, 3, len) || len < 0) {
+            return expected_int(args, 3);
+        }
+
+        auto array = new array::Array();
+        switch (static_cast<array::Kind>(kind)) {
+            case array::Kind::F32: array->data.emplace<std::vector<float>>(static_cast<size_t>(len)); break;
+            case array::Kind::F64: array->data.emplace<std::vector<double>>(static_cast<size_t>(len)); break;
+            case array::Kind::I32: array->data.emplace<std::vector<int32_t>>(static_cast<size_t>(len)); break;
+            case array::Kind::U8: array->data.emplace<std::vector<uint8_t>>(static_cast<size_t>(len)); break;
+        }
+        auto& mapping = *self->mapping;
+        auto bytes = std::visit([](auto& v) { return v.size() * sizeof(v[0]); }, array->data);
+        if (!in_range(offset, bytes, mapping.size)) {
+            delete array;
+            return out_of_range(offset, bytes, mapping.size);
+        }
+        std::visit([&](auto& v) {
+            if (!v.empty()) {
+                std::memcpy(v.data(), mapping.data + offset, bytes);
+            }
+        }, array->data);
+        return array->topxs();
+#else
+        return pxs_newexception("yoyo.array is not enabled.");
+#endif // YOYO_ARRAY
+    }
+
+    pxs_VarT Region::write_array(pxs_VarT args) {
+#ifdef YOYO_ARRAY
+        PXS_ARGC_EQ(3); // self, offset, array
+        auto self = yoyo::utils::pxs::get_type<Region>(args, 0, yoyo::types::SHM_REGION_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+        int64_t offset;
+        if (!get_int_arg(args, 1, offset)) {
+            return expected_int(args, 1);
+        }
+        auto array = yoyo::utils::pxs::get_type<array::Array>(args, 2, yoyo::types::ARRAY_ARRAY_TYPE);
+        if (!array) {
+            return pxs_newexception("Expected a `Array`");
+        }
+
+        auto& mapping = *self->mapping;
+        auto bytes = std::visit([](auto& v) { return v.size() * sizeof(v[0]); }, array->data);
+        if (!in_range(offset, bytes, mapping.size)) {
+            return out_of_range(offset, bytes, mapping.size);
+        }
+        std::visit([&](auto& v) {
+            if (!v.empty()) {
+                std::memcpy(mapping.data + offset, v.data(), bytes);
+            }
+        }, array->data);
+        return pxs_newnull();
+#else
+        return pxs_newexception("yoyo.array is not enabled.");
+#endif // YOYO_ARRAY
+    }
+
+    // Shared by `create` and `open`.
+    pxs_VarT make_region(pxs_VarT args, bool create) {
+        auto name = pxs::Var::from_args(args, 0);
+        PXS_ARG_IS_TYPE(name.raw(), pxs_String);
+        int64_t size = 0;
+        if (create) {
+            if (!get_int_arg(args, 1, size)) {
+                return expected_int(args, 1);
+            }
+            if (size <= 0) {
+                return pxs_newexception("Shared memory size must be positive");
+            }
+        }
+
+        std::string error;
+        auto mapping = map_region(name.get_string(), static_cast<size_t>(size), create, error);
+        if (!mapping) {
+            return pxs_newexception(error.c_str());
+        }
+        return region_class->make(new Region(std::move(mapping)), free_region).raw();
+    }
+
+    pxs_VarT create(pxs_VarT args) {
+        PXS_ARGC_EQ(2); // name, size
+        return make_region(args, true);
+    }
+
+    pxs_VarT open(pxs_VarT args) {
+        PXS_ARGC_EQ(1); // name
+        return make_region(args, false);
+    }
+
+    pxs_VarT unlink(pxs_VarT args) {
+        PXS_ARGC_EQ(1); // name
+        PXS_ARG_STRING_VAL(name, 0);
+#if defined(_WIN32)
+        return pxs_newbool(false);
+#else
+        return pxs_newbool(shm_unlink(os_name(name).c_str()) == 0);
+#endif
+    }
+
+    void init(pxs_Module* yoyo) {
+        region_class.emplace("Region", yoyo::types::SHM_REGION_TYPE);
+        region_class->add_property("name", &Region::get_name);
+        region_class->add_property("size", &Region::get_size);
+        region_class->add_method("get", &Region::get);
+        region_class->add_method("set", &Region::set);
+        region_class->add_method("read", &Region::read);
+        region_class->add_method("write", &Region::write);
+        region_class->add_method("view", &Region::view);
+        region_class->add_method("seq_write", &Region::seq_write);
+        region_class->add_method("seq_read", &Region::seq_read);
+        region_class->add_method("read_array", &Region::read_array);
+        region_class->add_method("write_array", &Region::write_array);
+
+        auto shm_mod = pxs_newmod("shm");
+
+        pxs_addfunc(shm_mod, "create", create);
+        pxs_addfunc(shm_mod, "open", open);
+        pxs_addfunc(shm_mod, "unlink", unlink);
+
+        pxs_addvar(shm_mod, "VALUE_TYPE_I8", pxs_newint(static_cast<int>(ValueType::I8)));
+        pxs_addvar(shm_mod, "VALUE_TYPE_U8", pxs_newint(static_cast<int>(ValueType::U8)));
+        pxs_addvar(shm_mod, "VALUE_TYPE_I16", pxs_newint(static_cast<int>(ValueType::I16)));
+        pxs_addvar(shm_mod, "VALUE_TYPE_U16", pxs_newint(static_cast<int>(ValueType::U16)));
+        pxs_addvar(shm_mod, "VALUE_TYPE_I32", pxs_newint(static_cast<int>(ValueType::I32)));
+        pxs_addvar(shm_mod, "VALUE_TYPE_U32", pxs_newint(static_cast<int>(ValueType::U32)));
+        pxs_addvar(shm_mod, "VALUE_TYPE_I64", pxs_newint(static_cast<int>(ValueType::I64)));
+        pxs_addvar(shm_mod, "VALUE_TYPE_U64", pxs_newint(static_cast<int>(ValueType::U64)));
+        pxs_addvar(shm_mod, "VALUE_TYPE_F32", pxs_newint(static_cast<int>(ValueType::F32)));
+        pxs_addvar(shm_mod, "VALUE_TYPE_F64", pxs_newint(static_cast<int>(ValueType::F64)));
+
+        pxs_add_submod(yoyo, shm_mod);
+    }
+};
+
+#endif // YOYO_SHM
@@ -0,0 +1,292 @@
+#ifdef YOYO_TASK
+
+#include "task.hpp"
+#include "yoyo.hpp"
+#include <pixelscript_cpp.hpp>
+#include "utils/types.hpp"
+#include "utils/pxs.hpp"
+#include "utils/pool.hpp"
+#include "utils/cpu.hpp"
+#include "utils/exceptions.hpp"
+#include <string>
+#include <string_view>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <thread>
+#include <optional>
+#include <algorithm>
+#include <cctype>
+
+namespace yoyo::task {
+    struct TaskState {
+        std::mutex lock;
+        std::condition_variable cv;
+        bool done = false;
+        // `pxs_pack` of the result.
+        std::string packed;
+        std::string error;
+
+        void finish(std::string packed_result, std::string error_msg) {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                packed = std::move(packed_result);
+                error = std::move(error_msg);
+                done = true;
+            }
+            cv.notify_all();
+        }
+    };
+
+    // What a worker runs. Only native data.
+    struct Job {
+        pxs_Runtime runtime;
+        std::string module;
+        std::string func;
+        // `pxs_pack` of the args list.
+        std::string args;
+    };
+
+    // Set with `set_setup` before the first `spawn`.
+    pxs_PoolSetupFn worker_setup = nullptr;
+    pxs_Opaque worker_opaque = nullptr;
+    uint32_t worker_count = 0;
+
+    // The runtime sets of the workers and the threads using them, one set per thread so acquiring never fails.
+    // Made by the first `spawn`, kept for the life of the process.
+    std::once_flag workers_once;
+    pxs_RuntimePool* runtime_pool = nullptr;
+    utils::pool::ThreadPool* workers = nullptr;
+
+    void default_setup(pxs_Opaque) {
+        yoyo_init();
+    }
+
+    void start_workers() {
+        std::call_once(workers_once, [] {
+            uint32_t count = worker_count;
+            if (count == 0) {
+                // A worker per physical core, sibling threads only slow script VMs down.
+                // Python has 15 VMs for other threads.
+                count = utils::cpu::worker_count(8);
+            }
+            runtime_pool = pxs_pool_create(count, worker_setup ? worker_setup : default_setup, worker_opaque);
+
+            // Pinned only when every worker gets a core of its own.
+            std::function<void(size_t)> on_start;
+            if (count <= utils::cpu::topology().physical) {
+                on_start = [](size_t i) { utils::cpu::pin_worker(static_cast<uint32_t>(i)); };
+            }
+            workers = new utils::pool::ThreadPool(count, on_start);
+        });
+    }
+
+    // Copy the bytes of a `pxs_pack` result.
+    std::string bytes_of(pxs_VarT buffer) {
+        size_t len = 0;
+        auto data = pxs_getstrview(buffer, &len);
+        return data == nullptr ? std::string() : std::string(data, len);
+    }
+
+    // Only what can be a module path or name goes into the lookup code.
+    bool valid_name(std::string_view name, bool path) {
+        if (name.empty()) {
+            return !path;
+        }
+        return std::all_of(name.begin(), name.end(), [&](char c) {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || (path && (c == '.' || c == '/' || c == '-'));
+        });
+    }
+
+    // Code that evaluates to the function of `job`.
+    std::string lookup_code(const Job& job) {
+        switch (job.runtime) {
+            case pxs_Runtime::pxs_Lua:
+                return "return require('" + job.module + "')." + job.func;
+            case pxs_Runtime::pxs_Python:
+                return "__import__('" + job.module + "')." + job.func;
+            case pxs_Runtime::pxs_JavaScript:
+                return "require('" + job.module + "')." + job.func;
+            default:
+                return "";
+        }
+    }
+
+    // Run `job` in this workers runtime set.
+    void run(const Job& job, TaskState& state) {
+        pxs_pool_acquire(runtime_pool);
+        auto rt = pxs_newint(static_cast<int>(job.runtime));
+        auto packed_args = pxs_newbytes(static_cast<pxs_Opaque>(const_cast<char*>(job.args.data())), sizeof(char), job.args.size());
+        auto call_args = pxs_unpack(packed_args);
+        pxs_freevar(packed_args);
+        if (pxs_varis(call_args, pxs_Exception)) {
+            auto error = bytes_of(call_args);
+            pxs_freevar(call_args);
+            pxs_freevar(rt);
+            pxs_pool_release(runtime_pool);
+            state.finish("", std::move(error));
+            return;
+        }
+
+        pxs_VarT res;
+        if (job.module.empty()) {
+            res = pxs_call(rt, job.func.c_str(), call_args);
+        } else {
+            auto func = pxs_evalnamed(lookup_code(job).c_str(), "<task>", job.runtime);
+            if (pxs_varis(func, pxs_Exception)) {
+                res = func;
+                pxs_freevar(call_args);
+            } else {
+                res = pxs_varcall(rt, func, call_args);
+                pxs_freevar(func);
+            }
+        }
+
+        if (res == nullptr) {
+            res = pxs_newnull();
+        }
+
+        std::string packed;
+        std::string error;
+        if (pxs_varis(res, pxs_Exception)) {
+            error = bytes_of(res);
+        } else {
+            auto buffer = pxs_pack(rt, res);
+            if (pxs_varis(buffer, pxs_Exception)) {
+                error = bytes_of(buffer);
+            } else {
+                packed = bytes_of(buffer);
+            }
+            pxs_freevar(buffer);
+        }
+        pxs_freevar(res);
+        pxs_freevar(rt);
+        pxs_pool_release(runtime_pool);
+
+        state.finish(std::move(packed), std::move(error));
+    }
+
+    // Class of the `Task` host object. Created in `init` since the function lookup is reset with pixelscript.
+    std::optional<pxs::Class<Task>> task_class;
+
+    Task::Task(std::shared_ptr<TaskState> state) : state(std::move(state)) {}
+
+    void free_task(pxs_Opaque ptr) {
+        if (!ptr) {
+            return;
+        }
+
+        delete static_cast<Task*>(ptr);
+    }
+
+    pxs_VarT Task::get_done(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Task>(args, 0, yoyo::types::TASK_TASK_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        std::lock_guard<std::mutex> guard(self->state->lock);
+        return pxs_newbool(self->state->done);
+    }
+
+    pxs_VarT Task::join(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Task>(args, 0, yoyo::types::TASK_TASK_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        int64_t timeout = -1;
+        auto timeout_arg = pxs::Var::from_args(args, 1);
+        if (timeout_arg.is(pxs_Int64) || timeout_arg.is(pxs_UInt64)) {
+            timeout = timeout_arg.get_int();
+        }
+
+        std::unique_lock<std::mutex> guard(self->state->lock);
+        auto finished = [&] { return self->state->done; };
+        if (timeout < 0) {
+            self->state->cv.wait(guard, finished);
+            return pxs_newbool(true);
+        }
+        return pxs_newbool(self->state->cv.wait_for(guard, std::chrono::milliseconds(timeout), finished));
+    }
+
+    pxs_VarT Task::result(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Task>(args, 0, yoyo::types::TASK_TASK_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        std::unique_lock<std::mutex> guard(self->state->lock);
+        self->state->cv.wait(guard, [&] { return self->state->done; });
+        if (!self->state->error.empty()) {
+            return pxs_newexception(self->state->error.c_str());
+        }
+        auto& packed = self->state->packed;
+        auto buffer = pxs_newbytes(static_cast<pxs_Opaque>(packed.data()), sizeof(char), packed.size());
+        auto res = pxs_unpack(buffer);
+        pxs_freevar(buffer);
+        return res;
+    }
+
+    pxs_VarT spawn(pxs_VarT args) {
+        PXS_ARGC_GT(3); // runtime, module, fn, args
+        auto runtime = pxs::Var::from_args(args, 0);
+        PXS_ARG_IS_TYPE(runtime.raw(), pxs_Int64);
+        auto module = pxs::Var::from_args(args, 1);
+        PXS_ARG_IS_TYPE(module.raw(), pxs_String);
+        auto func = pxs::Var::from_args(args, 2);
+        PXS_ARG_IS_TYPE(func.raw(), pxs_String);
+
+        Job job{static_cast<pxs_Runtime>(runtime.get_int()), module.get_string(), func.get_string(), ""};
+        if (!valid_name(job.module, true) || !valid_name(job.func, false)) {
+            return pxs_newexception(("Invalid task function " + job.module + "." + job.func).c_str());
+        }
+
+        auto call_args = pxs::Var::from_args(args, 3);
+        if (!call_args.is(pxs_List) && !call_args.is(pxs_Null)) {
+            return yoyo::utils::exceptions::expected_types(call_args.raw()->tag, {pxs_List, pxs_Null});
+        }
+        pxs_VarT buffer;
+        if (call_args.is(pxs_List)) {
+            buffer = pxs_pack(pxs_getrt(args), call_args.raw());
+        } else {
+            auto empty = pxs_newlist();
+            buffer = pxs_pack(nullptr, empty);
+            pxs_freevar(empty);
+        }
+        if (pxs_varis(buffer, pxs_Exception)) {
+            return buffer;
+        }
+        job.args = bytes_of(buffer);
+        pxs_freevar(buffer);
+
+        start_workers();
+        auto state = std::make_shared<TaskState>();
+        workers->submit([job = std::move(job), state]() {
+            run(job, *state);
+        });
+        return task_class->make(new Task(state), free_task).raw();
+    }
+
+    void set_setup(pxs_PoolSetupFn setup, pxs_Opaque opaque, uint32_t count) {
+        worker_setup = setup;
+        worker_opaque = opaque;
+        worker_count = count;
+    }
+
+    void init(pxs_Module* yoyo) {
+        task_class.emplace("Task", yoyo::types::TASK_TASK_TYPE);
+        task_class->add_property("done", &Task::get_done);
+        task_class->add_method("join", &Task::join);
+        task_class->add_method("result", &Task::result);
+
+        auto task_mod = pxs_newmod("task");
+
+        pxs_addfunc(task_mod, "spawn", spawn);
+
+        pxs_add_submod(yoyo, task_mod);
+    }
+};
+
+#endif // YOYO_TASK
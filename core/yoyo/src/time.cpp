@@ -0,0 +1,321 @@
+#ifdef YOYO_TIME
+
+#include "time.hpp"
+#include "yoyo.hpp"
+#include <pixelscript_cpp.hpp>
+#include "utils/types.hpp"
+#include "utils/pxs.hpp"
+#include "utils/exceptions.hpp"
+#include <array>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <optional>
+#include <algorithm>
+
+namespace yoyo::time {
+    uint64_t now() {
+        using namespace std::chrono;
+        return static_cast<uint64_t>(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+    }
+
+    // Class of the `Stopwatch` host object. Created in `init` since the function lookup is reset with pixelscript.
+    std::optional<pxs::Class<Stopwatch>> stopwatch_class;
+    // Class of the `Timer` host object.
+    std::optional<pxs::Class<Timer>> timer_class;
+
+    Stopwatch::Stopwatch() : started(now()) {}
+
+    uint64_t Stopwatch::elapsed() const {
+        return running ? counted + (now() - started) : counted;
+    }
+
+    void free_stopwatch(pxs_Opaque ptr) {
+        if (!ptr) {
+            return;
+        }
+
+        delete static_cast<Stopwatch*>(ptr);
+    }
+
+    pxs_VarT Stopwatch::get_elapsed_ns(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Stopwatch>(args, 0, yoyo::types::TIME_STOPWATCH_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        return pxs_newint(static_cast<int64_t>(self->elapsed()));
+    }
+
+    pxs_VarT Stopwatch::get_elapsed(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Stopwatch>(args, 0, yoyo::types::TIME_STOPWATCH_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        return pxs_newfloat(static_cast<double>(self->elapsed()) / 1e9);
+    }
+
+    pxs_VarT Stopwatch::get_running(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Stopwatch>(args, 0, yoyo::types::TIME_STOPWATCH_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        return pxs_newbool(self->running);
+    }
+
+    pxs_VarT Stopwatch::start(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Stopwatch>(args, 0, yoyo::types::TIME_STOPWATCH_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        if (!self->running) {
+            self->started = now();
+            self->running = true;
+        }
+        return pxs_newnull();
+    }
+
+    pxs_VarT Stopwatch::stop(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Stopwatch>(args, 0, yoyo::types::TIME_STOPWATCH_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        if (self->running) {
+            self->counted = self->elapsed();
+            self->running = false;
+        }
+        return pxs_newnull();
+    }
+
+    pxs_VarT Stopwatch::restart(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Stopwatch>(args, 0, yoyo::types::TIME_STOPWATCH_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        auto at = now();
+        auto before = self->running ? self->counted + (at - self->started) : self->counted;
+        self->started = at;
+        self->counted = 0;
+        self->running = true;
+        return pxs_newint(static_cast<int64_t>(before));
+    }
+
+    struct TimerState {
+        // Tick (millisecond) it fires at.
+        uint64_t deadline = 0;
+        // 0 for `after`.
+        uint64_t interval = 0;
+        bool active = true;
+
+        // Owned.
+        pxs_VarT callback = nullptr;
+        // Owned.
+        pxs_VarT runtime = nullptr;
+
+        ~TimerState() {
+            if (callback != nullptr) {
+                pxs_freevar(callback);
+            }
+            if (runtime != nullptr) {
+                pxs_freevar(runtime);
+            }
+        }
+    };
+
+    // A hashed timer wheel of one millisecond ticks. A timer goes into the slot of its deadline, a pump only looks at
+    // the slots of the ticks that passed, so waiting timers cost nothing. Timers further out than one lap stay in
+    // their slot until the lap of their deadline.
+    class TimerWheel {
+        static constexpr size_t SLOTS = 256;
+
+        std::array<std::vector<std::shared_ptr<TimerState>>, SLOTS> slots;
+        // Last tick handled.
+        uint64_t current;
+
+    public:
+        TimerWheel() : current(now() / 1000000) {}
+
+        void add(std::shared_ptr<TimerState> timer) {
+            // Due ticks that were already handled go into the next one.
+            timer->deadline = std::max(timer->deadline, current + 1);
+            slots[timer->deadline & (SLOTS - 1)].push_back(std::move(timer));
+        }
+
+        // Take the timers due at `tick`, in deadline order. Drops cancelled ones.
+        std::vector<std::shared_ptr<TimerState>> advance(uint64_t tick) {
+            std::vector<std::shared_ptr<TimerState>> due;
+            if (tick <= current) {
+                return due;
+            }
+            // One lap visits every slot.
+            auto ticks = std::min<uint64_t>(tick - current, SLOTS);
+            for (uint64_t t = current + 1; t <= current + ticks; t++) {
+                auto& slot = slots[t & (SLOTS - 1)];
+                auto keep = std::partition(slot.begin(), slot.end(), [&](const std::shared_ptr<TimerState>& timer) {
+                    return timer->active && timer->deadline > tick;
+                });
+                for (auto it = keep; it != slot.end(); it++) {
+                    if ((*it)->active) {
+                        due.push_back(std::move(*it));
+                    }
+                }
+                slot.erase(keep, slot.end());
+            }
+            current = tick;
+            std::stable_sort(due.begin(), due.end(), [](const std::shared_ptr<TimerState>& a, const std::shared_ptr<TimerState>& b) {
+                return a->deadline < b->deadline;
+            });
+            return due;
+        }
+    };
+
+    // Every thread fires its own timers, their vars belong to it. Never destroyed, the timers die with the runtimes.
+    thread_local TimerWheel* wheel = nullptr;
+
+    TimerWheel& this_wheel() {
+        if (wheel == nullptr) {
+            wheel = new TimerWheel();
+        }
+        return *wheel;
+    }
+
+    Timer::Timer(std::shared_ptr<TimerState> state) : state(std::move(state)) {}
+
+    void free_timer(pxs_Opaque ptr) {
+        if (!ptr) {
+            return;
+        }
+
+        delete static_cast<Timer*>(ptr);
+    }
+
+    pxs_VarT Timer::get_active(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Timer>(args, 0, yoyo::types::TIME_TIMER_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        return pxs_newbool(self->state->active);
+    }
+
+    pxs_VarT Timer::cancel(pxs_VarT args) {
+        auto self = yoyo::utils::pxs::get_type<Timer>(args, 0, yoyo::types::TIME_TIMER_TYPE);
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        // The wheel drops it when passing its slot.
+        self->state->active = false;
+        return pxs_newnull();
+    }
+
+    pxs_VarT now_ns(pxs_VarT /*args*/) {
+        return pxs_newint(static_cast<int64_t>(now()));
+    }
+
+    pxs_VarT perf_counter(pxs_VarT /*args*/) {
+        using namespace std::chrono;
+        auto ns = duration_cast<nanoseconds>(high_resolution_clock::now().time_since_epoch()).count();
+        return pxs_newfloat(static_cast<double>(ns) / 1e9);
+    }
+
+    pxs_VarT stopwatch(pxs_VarT /*args*/) {
+        return stopwatch_class->make(new Stopwatch(), free_stopwatch).raw();
+    }
+
+    // Shared by `after` and `every`.
+    pxs_VarT add_timer(pxs_VarT args, bool repeat) {
+        PXS_ARGC_EQ(2); // ms, fn
+        auto ms_arg = pxs::Var::from_args(args, 0);
+        int64_t ms;
+        if (ms_arg.is(pxs_Int64) || ms_arg.is(pxs_UInt64)) {
+            ms = ms_arg.get_int();
+        } else if (ms_arg.is(pxs_Float64)) {
+            ms = static_cast<int64_t>(ms_arg.get_float());
+        } else {
+            return yoyo::utils::exceptions::expected_types(ms_arg.raw()->tag, {pxs_Int64, pxs_Float64});
+        }
+        auto fn = pxs::Var::from_args(args, 1);
+        PXS_ARG_IS_TYPE(fn.raw(), pxs_Function);
+
+        auto state = std::make_shared<TimerState>();
+        auto delay = static_cast<uint64_t>(std::max<int64_t>(ms, repeat ? 1 : 0));
+        state->deadline = now() / 1000000 + delay;
+        state->interval = repeat ? delay : 0;
+        // Copying moves the language reference to our copy, keeping it alive.
+        state->callback = pxs_newcopy(fn.raw());
+        state->runtime = pxs_newcopy(pxs_getrt(args));
+        this_wheel().add(state);
+
+        return timer_class->make(new Timer(std::move(state)), free_timer).raw();
+    }
+
+    pxs_VarT after(pxs_VarT args) {
+        return add_timer(args, false);
+    }
+
+    pxs_VarT every(pxs_VarT args) {
+        return add_timer(args, true);
+    }
+
+    int pump() {
+        if (wheel == nullptr) {
+            return 0;
+        }
+
+        auto tick = now() / 1000000;
+        auto due = wheel->advance(tick);
+        int fired = 0;
+        for (auto& timer : due) {
+            // An earlier callback may have cancelled it.
+            if (!timer->active) {
+                continue;
+            }
+            if (timer->interval == 0) {
+                timer->active = false;
+            } else {
+                // Skip the calls a late pump missed.
+                timer->deadline = std::max(timer->deadline + timer->interval, tick + 1);
+                wheel->add(timer);
+            }
+
+            auto res = pxs_varcall(timer->runtime, timer->callback, pxs_newlist());
+            if (res != nullptr) {
+                pxs_freevar(res);
+            }
+            fired++;
+        }
+        return fired;
+    }
+
+    void init(pxs_Module* yoyo) {
+        stopwatch_class.emplace("Stopwatch", yoyo::types::TIME_STOPWATCH_TYPE);
+        stopwatch_class->add_property("elapsed_ns", &Stopwatch::get_elapsed_ns);
+        stopwatch_class->add_property("elapsed", &Stopwatch::get_elapsed);
+        stopwatch_class->add_property("running", &Stopwatch::get_running);
+        stopwatch_class->add_method("start", &Stopwatch::start);
+        stopwatch_class->add_method("stop", &Stopwatch::stop);
+        stopwatch_class->add_method("restart", &Stopwatch::restart);
+
+        timer_class.emplace("Timer", yoyo::types::TIME_TIMER_TYPE);
+        timer_class->add_property("active", &Timer::get_active);
+        timer_class->add_method("cancel", &Timer::cancel);
+
+        auto time_mod = pxs_newmod("time");
+
+        pxs_addfunc(time_mod, "now_ns", now_ns);
+        pxs_addfunc(time_mod, "perf_counter", perf_counter);
+        pxs_addfunc(time_mod, "stopwatch", stopwatch);
+        pxs_addfunc(time_mod, "after", after);
+        pxs_addfunc(time_mod, "every", every);
+
+        pxs_add_submod(yoyo, time_mod);
+    }
+};
+
+#endif // YOYO_TIME
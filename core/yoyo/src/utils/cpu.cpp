@@ -0,0 +1,294 @@
+#include "utils/cpu.hpp"
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <utility>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <sys/sysctl.h>
+#elif defined(__linux__)
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+namespace yoyo::utils::cpu {
+    // One core per logical CPU, when nothing better is known.
+    void flat(Topology& topo, const std::vector<uint32_t>& cpus) {
+        for (auto id : cpus) {
+            Core core;
+            core.threads.push_back(id);
+            topo.cores.push_back(std::move(core));
+        }
+    }
+
+    std::vector<uint32_t> default_cpus() {
+        std::vector<uint32_t> cpus(std::max(1u, std::thread::hardware_concurrency()));
+        for (uint32_t i = 0; i < cpus.size(); i++) {
+            cpus[i] = i;
+        }
+        return cpus;
+    }
+
+#if defined(__linux__)
+    // A number out of sysfs, -1 if missing.
+    long read_sysfs(uint32_t cpu, const char* name) {
+        std::ifstream file("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/" + name);
+        long value = -1;
+        if (!(file >> value)) {
+            return -1;
+        }
+        return value;
+    }
+#endif
+
+    Topology read_topology() {
+        Topology topo;
+    #if defined(__linux__)
+        // The mask of the main thread, the one the process started with.
+        std::vector<uint32_t> cpus;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(getpid(), sizeof(set), &set) == 0) {
+            for (uint32_t i = 0; i < CPU_SETSIZE; i++) {
+                if (CPU_ISSET(i, &set)) {
+                    cpus.push_back(i);
+                }
+            }
+        }
+        if (cpus.empty()) {
+            cpus = default_cpus();
+        }
+
+        // (package, core id) -> core
+        std::map<std::pair<long, long>, Core> grouped;
+        bool known = true;
+        for (auto id : cpus) {
+            long package = read_sysfs(id, "physical_package_id");
+            long core_id = read_sysfs(id, "core_id");
+            if (core_id < 0) {
+                known = false;
+                break;
+            }
+            auto& core = grouped[{std::max(0L, package), core_id}];
+            core.package = static_cast<uint32_t>(std::max(0L, package));
+            core.threads.push_back(id);
+        }
+        if (known) {
+            for (auto& [key, core] : grouped) {
+                topo.cores.push_back(std::move(core));
+            }
+        } else {
+            flat(topo, cpus);
+        }
+    #elif defined(_WIN32)
+        DWORD_PTR process_mask = 0, system_mask = 0;
+        GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask);
+
+        DWORD len = 0;
+        GetLogicalProcessorInformationEx(RelationAll, nullptr, &len);
+        std::vector<char> buffer(len);
+        auto info = reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data());
+        if (len > 0 && GetLogicalProcessorInformationEx(RelationAll, info, &len)) {
+            // Packages first, to number the cores by them.
+            std::vector<KAFFINITY> packages;
+            for (DWORD offset = 0; offset < len;) {
+                auto entry = reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data() + offset);
+                if (entry->Relationship == RelationProcessorPackage) {
+                    packages.push_back(entry->Processor.GroupMask[0].Mask);
+                }
+                offset += entry->Size;
+            }
+            for (DWORD offset = 0; offset < len;) {
+                auto entry = reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data() + offset);
+                offset += entry->Size;
+                // Only the first processor group, the one threads start in.
+                if (entry->Relationship != RelationProcessorCore || entry->Processor.GroupMask[0].Group != 0) {
+                    continue;
+                }
+                auto mask = entry->Processor.GroupMask[0].Mask & process_mask;
+                Core core;
+                for (uint32_t bit = 0; bit < sizeof(KAFFINITY) * 8; bit++) {
+                    if (mask & (static_cast<KAFFINITY>(1) << bit)) {
+                        core.threads.push_back(bit);
+                    }
+                }
+                if (core.threads.empty()) {
+                    continue;
+                }
+                for (size_t p = 0; p < packages.size(); p++) {
+                    if (packages[p] & mask) {
+                        core.package = static_cast<uint32_t>(p);
+                    }
+                }
+                topo.cores.push_back(std::move(core));
+            }
+        }
+        if (topo.cores.empty()) {
+            flat(topo, default_cpus());
+        }
+    #elif defined(__APPLE__)
+        int logical = 0, physical = 0, packages = 0;
+        size_t size = sizeof(int);
+        sysctlbyname("hw.logicalcpu", &logical, &size, nullptr, 0);
+        size = sizeof(int);
+        sysctlbyname("hw.physicalcpu", &physical, &size, nullptr, 0);
+        size = sizeof(int);
+        sysctlbyname("hw.packages", &packages, &size, nullptr, 0);
+        if (logical <= 0 || physical <= 0 || logical % physical != 0) {
+            flat(topo, default_cpus());
+        } else {
+            // Siblings are numbered next to each other.
+            int per_core = logical / physical;
+            int per_package = physical / std::max(1, packages);
+            for (int c = 0; c < physical; c++) {
+                Core core;
+                core.package = static_cast<uint32_t>(c / std::max(1, per_package));
+                for (int t = 0; t < per_core; t++) {
+                    core.threads.push_back(static_cast<uint32_t>(c * per_core + t));
+                }
+                topo.cores.push_back(std::move(core));
+            }
+        }
+    #else
+        flat(topo, default_cpus());
+    #endif
+
+        std::stable_sort(topo.cores.begin(), topo.cores.end(), [](const Core& a, const Core& b) {
+            return a.package != b.package ? a.package < b.package : a.threads.front() < b.threads.front();
+        });
+        topo.physical = static_cast<uint32_t>(topo.cores.size());
+        topo.logical = 0;
+        uint32_t last_package = 0;
+        topo.packages = 0;
+        for (auto& core : topo.cores) {
+            std::sort(core.threads.begin(), core.threads.end());
+            topo.logical += static_cast<uint32_t>(core.threads.size());
+            if (topo.packages == 0 || core.package != last_package) {
+                topo.packages++;
+                last_package = core.package;
+            }
+        }
+        return topo;
+    }
+
+    const Topology& topology() {
+        static const Topology topo = read_topology();
+        return topo;
+    }
+
+    uint32_t worker_count(uint32_t max) {
+        auto count = std::max(1u, topology().physical);
+        return max == 0 ? count : std::min(count, max);
+    }
+
+    // Logical CPUs in the order workers get them.
+    const std::vector<uint32_t>& worker_order() {
+        static const std::vector<uint32_t> order = [] {
+            auto& topo = topology();
+            // Cores of each package, to take them in turn.
+            std::map<uint32_t, std::vector<const Core*>> by_package;
+            size_t widest = 0;
+            for (auto& core : topo.cores) {
+                by_package[core.package].push_back(&core);
+                widest = std::max(widest, core.threads.size());
+            }
+
+            std::vector<uint32_t> order;
+            for (size_t thread = 0; thread < widest; thread++) {
+                for (size_t rank = 0; ; rank++) {
+                    bool any = false;
+                    for (auto& [package, cores] : by_package) {
+                        if (rank < cores.size()) {
+                            any = true;
+                            if (thread < cores[rank]->threads.size()) {
+                                order.push_back(cores[rank]->threads[thread]);
+                            }
+                        }
+                    }
+                    if (!any) {
+                        break;
+                    }
+                }
+            }
+            if (order.empty()) {
+                order.push_back(0);
+            }
+            return order;
+        }();
+        return order;
+    }
+
+    uint32_t placement(uint32_t index) {
+        auto& order = worker_order();
+        return order[index % order.size()];
+    }
+
+    bool set_affinity(const std::vector<uint32_t>& cpus) {
+        if (cpus.empty()) {
+            return false;
+        }
+    #if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (auto id : cpus) {
+            if (id >= CPU_SETSIZE) {
+                return false;
+            }
+            CPU_SET(id, &set);
+        }
+        // 0 is the calling thread.
+        return sched_setaffinity(0, sizeof(set), &set) == 0;
+    #elif defined(_WIN32)
+        DWORD_PTR mask = 0;
+        for (auto id : cpus) {
+            if (id >= sizeof(DWORD_PTR) * 8) {
+                return false;
+            }
+            mask |= static_cast<DWORD_PTR>(1) << id;
+        }
+        return SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+    #else
+        // macOS only takes affinity hints, and not on Apple silicon.
+        return false;
+    #endif
+    }
+
+    std::vector<uint32_t> get_affinity() {
+        std::vector<uint32_t> cpus;
+    #if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (uint32_t i = 0; i < CPU_SETSIZE; i++) {
+                if (CPU_ISSET(i, &set)) {
+                    cpus.push_back(i);
+                }
+            }
+        }
+    #elif defined(_WIN32)
+        GROUP_AFFINITY affinity;
+        if (GetThreadGroupAffinity(GetCurrentThread(), &affinity) && affinity.Group == 0) {
+            for (uint32_t bit = 0; bit < sizeof(KAFFINITY) * 8; bit++) {
+                if (affinity.Mask & (static_cast<KAFFINITY>(1) << bit)) {
+                    cpus.push_back(bit);
+                }
+            }
+        }
+    #endif
+        if (cpus.empty()) {
+            for (auto& core : topology().cores) {
+                cpus.insert(cpus.end(), core.threads.begin(), core.threads.end());
+            }
+            std::sort(cpus.begin(), cpus.end());
+        }
+        return cpus;
+    }
+
+    bool pin_worker(uint32_t index) {
+        return set_affinity({placement(index)});
+    }
+};
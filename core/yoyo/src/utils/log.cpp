@@ -0,0 +1,167 @@
+#include "utils/log.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace yoyo::utils::log {
+    std::atomic<uint8_t> min_level{static_cast<uint8_t>(Level::Info)};
+    std::atomic<size_t> flush_size{64 * 1024};
+    std::atomic<uint32_t> flush_interval{50};
+
+    // Only its thread appends, the writer swaps the data out.
+    struct ThreadBuffer {
+        std::mutex lock;
+        std::string data;
+    };
+
+    // Shared by the writer and every thread. Never destroyed, threads may log while statics are torn down.
+    struct Sink {
+        std::mutex buffers_lock;
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+
+        // Held while writing, so drains never interleave.
+        std::mutex write_lock;
+
+        std::mutex wake_lock;
+        std::condition_variable wake;
+        bool woken = false;
+    };
+
+    Sink* sink = new Sink();
+    std::once_flag writer_once;
+    thread_local std::shared_ptr<ThreadBuffer> own_buffer;
+
+    void drain() {
+        std::lock_guard<std::mutex> write_guard(sink->write_lock);
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        {
+            std::lock_guard<std::mutex> guard(sink->buffers_lock);
+            // Buffers of threads that are gone are dropped once empty.
+            auto& all = sink->buffers;
+            for (size_t i = 0; i < all.size();) {
+                if (all[i].use_count() == 1 && all[i]->data.empty()) {
+                    all[i] = std::move(all.back());
+                    all.pop_back();
+                } else {
+                    i++;
+                }
+            }
+            buffers = all;
+        }
+
+        bool wrote = false;
+        std::string chunk;
+        for (auto& buffer : buffers) {
+            {
+                std::lock_guard<std::mutex> guard(buffer->lock);
+                chunk.swap(buffer->data);
+            }
+            if (!chunk.empty()) {
+                std::fwrite(chunk.data(), 1, chunk.size(), stdout);
+                chunk.clear();
+                wrote = true;
+            }
+        }
+        if (wrote) {
+            std::fflush(stdout);
+        }
+    }
+
+    void start_writer() {
+        std::call_once(writer_once, [] {
+            std::atexit(flush);
+            std::thread([] {
+                while (true) {
+                    {
+                        std::unique_lock<std::mutex> guard(sink->wake_lock);
+                        auto woken = [] { return sink->woken; };
+                        auto interval = flush_interval.load(std::memory_order_relaxed);
+                        if (interval == 0) {
+                            // Writing right away, nothing to drain until configured again.
+                            sink->wake.wait(guard, woken);
+                        } else {
+                            sink->wake.wait_for(guard, std::chrono::milliseconds(interval), woken);
+                        }
+                        sink->woken = false;
+                    }
+                    drain();
+                }
+            }).detach();
+        });
+    }
+
+    void configure(Level level, size_t flush_bytes, uint32_t flush_ms) {
+        min_level.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+        flush_size.store(flush_bytes == 0 ? 1 : flush_bytes, std::memory_order_relaxed);
+        flush_interval.store(flush_ms, std::memory_order_relaxed);
+        if (flush_ms == 0) {
+            drain();
+        }
+        // Picks up the new interval.
+        {
+            std::lock_guard<std::mutex> guard(sink->wake_lock);
+            sink->woken = true;
+        }
+        sink->wake.notify_one();
+    }
+
+    bool enabled(Level level) {
+        return level != Level::Off && static_cast<uint8_t>(level) >= min_level.load(std::memory_order_relaxed);
+    }
+
+    void write(Level level, std::string_view text) {
+        if (!enabled(level) || text.empty()) {
+            return;
+        }
+
+    #ifdef YOYO_NO_THREADS
+        // No writer thread on wasm32 without shared memory.
+        bool direct = true;
+    #else
+        bool direct = flush_interval.load(std::memory_order_relaxed) == 0;
+    #endif
+        if (direct) {
+            std::lock_guard<std::mutex> guard(sink->write_lock);
+            std::fwrite(text.data(), 1, text.size(), stdout);
+            std::fflush(stdout);
+            return;
+        }
+
+        if (!own_buffer) {
+            own_buffer = std::make_shared<ThreadBuffer>();
+            std::lock_guard<std::mutex> guard(sink->buffers_lock);
+            sink->buffers.push_back(own_buffer);
+        }
+        start_writer();
+
+        size_t size;
+        {
+            std::lock_guard<std::mutex> guard(own_buffer->lock);
+            own_buffer->data.append(text);
+            size = own_buffer->data.size();
+        }
+
+        auto limit = flush_size.load(std::memory_order_relaxed);
+        if (size >= limit * 4) {
+            // The writer is behind, write it ourselves instead of growing without bound.
+            drain();
+        } else if (size >= limit) {
+            {
+                std::lock_guard<std::mutex> guard(sink->wake_lock);
+                sink->woken = true;
+            }
+            sink->wake.notify_one();
+        }
+    }
+
+    void flush() {
+        drain();
+    }
+}
@@ -0,0 +1,4 @@
+// The miniz C implementation, shared by `yoyo.zip`, `yoyo.net` and `yoyo.compress`.
+// Everything else includes `miniz.hpp` with `MINIZ_HEADER_FILE_ONLY`.
+#define MINIZ_NO_CPP_WRAPPER
+#include "miniz.hpp"
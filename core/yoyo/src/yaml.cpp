@@ -0,0 +1,389 @@
+#ifdef YOYO_YAML
+
+#include "yaml.hpp"
+#include "fkyaml.hpp"
+#include <pixelscript.h>
+#include <pixelscript_cpp.hpp>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "utils/exceptions.hpp"
+
+namespace yoyo::yaml {
+    // Frees a var that is still being built when a throw leaves the tree halfway.
+    using OwnedVar = std::unique_ptr<pxs_Var, decltype(&pxs_freevar)>;
+
+    OwnedVar owned(pxs_VarT var) {
+        return OwnedVar(var, &pxs_freevar);
+    }
+
+    // Deeper trees throw instead of running out of stack.
+    constexpr int MAX_DEPTH = 512;
+
+    pxs_VarT to_pxs(const fkyaml::node& node, int depth);
+
+    // `pxs_Map` keys can only be scalars.
+    pxs_VarT key_to_pxs(const fkyaml::node& key) {
+        switch (key.get_type()) {
+            case fkyaml::node_type::SEQUENCE:
+            case fkyaml::node_type::MAPPING:
+            case fkyaml::node_type::NULL_OBJECT:
+                throw std::runtime_error("YAML map keys must be strings, numbers or bools.");
+            default:
+                return to_pxs(key, 0);
+        }
+    }
+
+    // Aliases resolve to the anchored node, so they are built as copies.
+    pxs_VarT to_pxs(const fkyaml::node& node, int depth) {
+        if (depth > MAX_DEPTH) {
+            throw std::runtime_error("YAML is nested too deep.");
+        }
+
+        switch (node.get_type()) {
+            case fkyaml::node_type::SEQUENCE: {
+                const auto& seq = node.as_seq();
+                auto list = owned(pxs_newlist_with_capacity(seq.size()));
+                for (const auto& item : seq) {
+                    pxs_listadd(list.get(), to_pxs(item, depth + 1));
+                }
+                return list.release();
+            }
+            case fkyaml::node_type::MAPPING: {
+                auto map = owned(pxs_newmap());
+                for (const auto& pair : node.as_map()) {
+                    auto key = owned(key_to_pxs(pair.first));
+                    auto value = to_pxs(pair.second, depth + 1);
+                    pxs_map_addpair(map.get(), key.release(), value);
+                }
+                return map.release();
+            }
+            case fkyaml::node_type::BOOLEAN:
+                return pxs_newbool(node.as_bool());
+            case fkyaml::node_type::INTEGER:
+                return pxs_newint(node.as_int());
+            case fkyaml::node_type::FLOAT:
+                return pxs_newfloat(node.as_float());
+            case fkyaml::node_type::STRING:
+                return pxs_newstring(node.as_str().c_str());
+            case fkyaml::node_type::NULL_OBJECT:
+            default:
+                return pxs_newnull();
+        }
+    }
+
+    // Parse the nodes of every document.
+    std::vector<fkyaml::node> parse(const char* data, size_t len) {
+        const char* begin = data;
+        const char* end = data + len;
+        return fkyaml::node::deserialize_docs(begin, end);
+    }
+
+    pxs_VarT load_docs(const char* data, size_t len) {
+        auto docs = parse(data, len);
+        auto list = owned(pxs_newlist_with_capacity(docs.size()));
+        for (const auto& doc : docs) {
+            pxs_listadd(list.get(), to_pxs(doc, 0));
+        }
+        return list.release();
+    }
+
+    // Can `str` be written without quotes and still read back as the same string?
+    bool is_plain(const std::string& str) {
+        if (str.empty() || str.front() == ' ' || str.back() == ' ') {
+            return false;
+        }
+        char first = str.front();
+        if (!std::isalpha(static_cast<unsigned char>(first)) && first != '_' && first != '/' && first != '.') {
+            return false;
+        }
+        for (size_t i = 0; i < str.size(); i++) {
+            auto c = static_cast<unsigned char>(str[i]);
+            // UTF-8 is fine, anything YAML gives a meaning to is not.
+            if (c < 0x80 && !std::isalnum(c) && std::strchr(" _-./()", c) == nullptr) {
+                return false;
+            }
+        }
+        // i.e. `true`, `null` or `.inf`.
+        return fkyaml::detail::scalar_scanner::scan(str.data(), str.data() + str.size()) == fkyaml::node_type::STRING;
+    }
+
+    void write_string(const std::string& str, std::string& out) {
+        if (is_plain(str)) {
+            out += str;
+            return;
+        }
+        out += '"';
+        for (char ch : str) {
+            auto c = static_cast<unsigned char>(ch);
+            switch (ch) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (c < 0x20 || c == 0x7f) {
+                        char hex[5];
+                        std::snprintf(hex, sizeof(hex), "\\x%02x", c);
+                        out += hex;
+                    } else {
+                        out += ch;
+                    }
+            }
+        }
+        out += '"';
+    }
+
+    void write_float(double value, std::string& out) {
+        if (std::isnan(value)) {
+            out += ".nan";
+        } else if (std::isinf(value)) {
+            out += value < 0 ? "-.inf" : ".inf";
+        } else {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.17g", value);
+            // Shortest form that reads back the same.
+            for (int precision = 1; precision < 17; precision++) {
+                char shorter[32];
+                std::snprintf(shorter, sizeof(shorter), "%.*g", precision, value);
+                if (std::strtod(shorter, nullptr) == value) {
+                    std::memcpy(buf, shorter, sizeof(buf));
+                    break;
+                }
+            }
+            out += buf;
+            // Keep it a float.
+            if (std::strpbrk(buf, ".en") == nullptr) {
+                out += ".0";
+            }
+        }
+    }
+
+    // Write a scalar. Returns false when `var` is not one.
+    bool write_scalar(pxs_VarT var, std::string& out) {
+        switch (pxs_vartype(var)) {
+            case pxs_Null:
+                out += "null";
+                return true;
+            case pxs_Bool:
+                out += pxs_getbool(var) ? "true" : "false";
+                return true;
+            case pxs_Int64:
+                out += std::to_string(pxs_getint(var));
+                return true;
+            case pxs_UInt64:
+                out += std::to_string(pxs_getuint(var));
+                return true;
+            case pxs_Float64:
+                write_float(pxs_getfloat(var), out);
+                return true;
+            case pxs_String: {
+                size_t len = 0;
+                auto str = pxs_getstrview(var, &len);
+                write_string(std::string(str ? str : "", len), out);
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+
+    // A value to dump, without its proxy and with the `[key, value]` pairs of maps and script objects.
+    struct Dumped {
+        pxs_VarT var;
+        OwnedVar entries;
+    };
+
+    Dumped resolve(pxs_VarT rt, pxs_VarT var) {
+        if (pxs_varis(var, pxs_Proxy)) {
+            var = pxs_getproxy(var);
+        }
+        if (pxs_varis(var, pxs_Map)) {
+            auto entries = owned(pxs_newlist());
+            pxs_MapIter iter;
+            pxs_VarT key = nullptr;
+            pxs_VarT value = nullptr;
+            pxs_mapiter_begin(var, &iter);
+            while (pxs_mapiter_next(&iter, &key, &value)) {
+                auto entry = pxs_newlist();
+                pxs_listadd(entry, pxs_newcopy(key));
+                pxs_listadd(entry, pxs_newcopy(value));
+                pxs_listadd(entries.get(), entry);
+            }
+            return {var, std::move(entries)};
+        }
+        if (pxs_varis(var, pxs_Object)) {
+            auto entries = owned(pxs_objectentries(rt, var));
+            if (pxs_varis(entries.get(), pxs_Exception)) {
+                throw std::runtime_error(pxs::Var(entries.get()).get_string());
+            }
+            return {var, std::move(entries)};
+        }
+        return {var, owned(nullptr)};
+    }
+
+    // Number of list items or map pairs, -1 for scalars.
+    int block_len(const Dumped& value) {
+        if (value.entries) {
+            return pxs_listlen(value.entries.get());
+        }
+        if (pxs_varis(value.var, pxs_List)) {
+            return pxs_listlen(value.var);
+        }
+        return -1;
+    }
+
+    // Write a scalar or empty container on the current line.
+    void write_flow(const Dumped& value, std::string& out) {
+        if (value.entries) {
+            out += "{}";
+        } else if (pxs_varis(value.var, pxs_List)) {
+            out += "[]";
+        } else if (!write_scalar(value.var, out)) {
+            throw std::runtime_error("Can not dump a " + pxs::string_type(pxs_vartype(value.var)) + " as YAML.");
+        }
+    }
+
+    void write_block(pxs_VarT rt, const Dumped& value, int indent, bool inline_first, std::string& out, int depth);
+
+    // Write `var` after the `key:` or `-` already in `out`. Scalars and empty containers stay on that line,
+    // the rest becomes a block indented by `indent` (starting on the line of a `-`).
+    void write_value(pxs_VarT rt, pxs_VarT var, int indent, bool after_dash, std::string& out, int depth) {
+        auto value = resolve(rt, var);
+        if (block_len(value) > 0) {
+            out += after_dash ? ' ' : '\n';
+            write_block(rt, value, indent, after_dash, out, depth + 1);
+            return;
+        }
+        out += ' ';
+        write_flow(value, out);
+        out += '\n';
+    }
+
+    // Write the items of a non empty list or map, each line indented by `indent`. With `inline_first` the
+    // first item continues the current line.
+    void write_block(pxs_VarT rt, const Dumped& value, int indent, bool inline_first, std::string& out, int depth) {
+        if (depth > MAX_DEPTH) {
+            throw std::runtime_error("Value is nested too deep to be YAML.");
+        }
+
+        int len = block_len(value);
+        for (int i = 0; i < len; i++) {
+            if (i > 0 || !inline_first) {
+                out.append(indent, ' ');
+            }
+            if (!value.entries) {
+                out += '-';
+                write_value(rt, pxs_listget(value.var, i), indent + 2, true, out, depth);
+                continue;
+            }
+            auto entry = pxs_listget(value.entries.get(), i);
+            if (!write_scalar(pxs_listget(entry, 0), out)) {
+                throw std::runtime_error("YAML map keys must be strings, numbers or bools.");
+            }
+            out += ':';
+            write_value(rt, pxs_listget(entry, 1), indent + 2, false, out, depth);
+        }
+    }
+
+    // Get the text of a `string` or `[]uint` arg. Returns false when it is neither.
+    bool get_text_arg(pxs_VarT args, int idx, const char*& data, size_t& len) {
+        len = 0;
+        data = pxs_getstrview(pxs_arg(args, idx), &len);
+        return data != nullptr;
+    }
+
+    pxs_VarT load(pxs_VarT args) {
+        PXS_ARGC_GT(1); // text
+        const char* data;
+        size_t len;
+        if (!get_text_arg(args, 0, data, len)) {
+            return utils::exceptions::expected_types(pxs_vartype(pxs_arg(args, 0)), {pxs_String, pxs_Buffer});
+        }
+
+        try {
+            auto docs = parse(data, len);
+            if (docs.empty()) {
+                return pxs_newnull();
+            }
+            return to_pxs(docs.front(), 0);
+        } catch (const std::exception& e) {
+            return pxs_newexception(e.what());
+        }
+    }
+
+    pxs_VarT load_all(pxs_VarT args) {
+        PXS_ARGC_GT(1); // text
+        const char* data;
+        size_t len;
+        if (!get_text_arg(args, 0, data, len)) {
+            return utils::exceptions::expected_types(pxs_vartype(pxs_arg(args, 0)), {pxs_String, pxs_Buffer});
+        }
+
+        try {
+            return load_docs(data, len);
+        } catch (const std::exception& e) {
+            return pxs_newexception(e.what());
+        }
+    }
+
+    pxs_VarT read_all(pxs_VarT args) {
+        PXS_ARGC_GT(1); // path
+        auto path = pxs::Var::from_args(args, 0);
+        PXS_ARG_IS_TYPE(path.raw(), pxs_String);
+
+        auto path_str = path.get_string();
+        std::ifstream in(path_str, std::ios::binary);
+        if (!in) {
+            return pxs_newexception(("Could not open " + path_str).c_str());
+        }
+        std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        try {
+            return load_docs(text.data(), text.size());
+        } catch (const std::exception& e) {
+            return pxs_newexception((path_str + ": " + e.what()).c_str());
+        }
+    }
+
+    pxs_VarT dump(pxs_VarT args) {
+        PXS_ARGC_GT(1); // value
+        try {
+            auto rt = pxs_getrt(args);
+            auto value = resolve(rt, pxs_arg(args, 0));
+            std::string text;
+            if (block_len(value) > 0) {
+                write_block(rt, value, 0, false, text, 0);
+            } else {
+                write_flow(value, text);
+                text += '\n';
+            }
+            return pxs_newstring(text.c_str());
+        } catch (const std::exception& e) {
+            return pxs_newexception(e.what());
+        }
+    }
+
+    void init(pxs_Module* yoyo) {
+        auto yaml_mod = pxs_newmod("yaml");
+
+        pxs_addfunc(yaml_mod, "load", load);
+        pxs_addfunc(yaml_mod, "load_all", load_all);
+        pxs_addfunc(yaml_mod, "read_all", read_all);
+        pxs_addfunc(yaml_mod, "dump", dump);
+
+        pxs_add_submod(yoyo, yaml_mod);
+    }
+};
+
+#endif // YOYO_YAML
@@ -18,40 +18,121 @@
 #ifdef YOYO_ZIP
 #include "zip.hpp"
 #endif
+#ifdef YOYO_YAML
+#include "yaml.hpp"
+#endif
+#ifdef YOYO_ARRAY
+#include "array.hpp"
+#endif
+#ifdef YOYO_TASK
+#include "task.hpp"
+#endif
+#ifdef YOYO_CHANNEL
+#include "channel.hpp"
+#endif
+#ifdef YOYO_TIME
+#include "time.hpp"
+#endif
+#ifdef YOYO_SHM
+#include "shm.hpp"
+#endif
+#ifdef YOYO_COMPRESS
+#include "compress.hpp"
+#endif
+#ifdef YOYO_HASH
+#include "hash.hpp"
+#endif
 
 #include <pixelscript.h>
+#include <pixelscript_cpp.hpp>
+#include "utils/log.hpp"
+#include "utils/exceptions.hpp"
+#include "utils/cpu.hpp"
 
 #include <string>
+#include <vector>
 #include <iostream>
 
 #ifdef YOYO_CORE
 namespace yoyo {
-    /// `yoyo.print`
-    pxs_VarT print(pxs_VarT args) {
-        std::string msg;
+    // Join the args from `first` on with spaces. Strings and ints are read directly, the rest goes through the
+    // language's own `to_string`.
+    void join_args(pxs_VarT args, int first, std::string& msg) {
         pxs::Var arg_wrapper = pxs::Var(pxs_listget(args, 0), args);
         int argc = arg_wrapper.list_len();
-        for (int i = 1; i < argc; i++) {
-            auto var = arg_wrapper.list_get(i).to_string();
-            msg += var;
+        for (int i = first; i < argc; i++) {
+            auto var = arg_wrapper.list_get(i);
+            if (var.is(pxs_String)) {
+                msg += var.get_string_view();
+            } else if (var.is(pxs_Int64)) {
+                msg += std::to_string(var.get_int());
+            } else {
+                msg += var.to_string();
+            }
             if (i < argc - 1) {
                 msg += " ";
             }
         }
+    }
 
-        std::cout << msg;
+    /// `yoyo.print`
+    pxs_VarT print(pxs_VarT args) {
+        if (!utils::log::enabled(utils::log::Level::Info)) {
+            return pxs_newnull();
+        }
+
+        std::string msg;
+        join_args(args, 1, msg);
+        utils::log::write(utils::log::Level::Info, msg);
         return pxs_newnull();
     }
 
     /// `yoyo.println`
     pxs_VarT println(pxs_VarT args) {
-        pxs_freevar(print(args));
-        std::cout << std::endl;
+        if (!utils::log::enabled(utils::log::Level::Info)) {
+            return pxs_newnull();
+        }
+
+        std::string msg;
+        join_args(args, 1, msg);
+        msg += '\n';
+        utils::log::write(utils::log::Level::Info, msg);
+        return pxs_newnull();
+    }
+
+    /// `yoyo.log(level, ...)`, a line at `level` (`LOG_WARN`, ...).
+    pxs_VarT log(pxs_VarT args) {
+        PXS_ARGC_GT(1); // level, ...
+        auto level_arg = pxs::Var::from_args(args, 0);
+        if (!level_arg.is(pxs_Int64) && !level_arg.is(pxs_UInt64)) {
+            return utils::exceptions::expected_type(level_arg.raw()->tag, pxs_Int64);
+        }
+        auto level_int = level_arg.get_int();
+        if (level_int < 0 || level_int > static_cast<int64_t>(utils::log::Level::Error)) {
+            return utils::exceptions::invalid_enum();
+        }
+        auto level = static_cast<utils::log::Level>(level_int);
+        if (!utils::log::enabled(level)) {
+            return pxs_newnull();
+        }
+
+        std::string msg;
+        join_args(args, 2, msg);
+        msg += '\n';
+        utils::log::write(level, msg);
+        return pxs_newnull();
+    }
+
+    /// `yoyo.flush`, write out everything printed so far.
+    pxs_VarT flush(pxs_VarT /*args*/) {
+        utils::log::flush();
         return pxs_newnull();
     }
 
     /// `yoyo.readln`
     pxs_VarT readln(pxs_VarT args) {
+        // Show a prompt printed before.
+        utils::log::flush();
         std::string line;
         std::getline(std::cin, line);
 
@@ -61,37 +142,226 @@ namespace yoyo {
 #endif // YOYO_CORE
 
 void yoyo_init() {
+    // Shows up in `pxs_startupstats`, with a phase per library.
+    pxs_startupbegin("yoyo_init");
     auto yoyo = pxs_newmod("yoyo");
 
     #ifdef YOYO_CORE
     pxs_addfunc(yoyo, "print", yoyo::print);
     pxs_addfunc(yoyo, "println", yoyo::println);
     pxs_addfunc(yoyo, "readln", yoyo::readln);
+    pxs_addfunc(yoyo, "log", yoyo::log);
+    pxs_addfunc(yoyo, "flush", yoyo::flush);
+    pxs_addvar(yoyo, "LOG_DEBUG", pxs_newint(static_cast<int>(yoyo::utils::log::Level::Debug)));
+    pxs_addvar(yoyo, "LOG_INFO", pxs_newint(static_cast<int>(yoyo::utils::log::Level::Info)));
+    pxs_addvar(yoyo, "LOG_WARN", pxs_newint(static_cast<int>(yoyo::utils::log::Level::Warn)));
+    pxs_addvar(yoyo, "LOG_ERROR", pxs_newint(static_cast<int>(yoyo::utils::log::Level::Error)));
     #endif // YOYO_CORE
 
     #ifdef YOYO_OS
-    // yoyo::os::init(yoyo, argv);
+    pxs_startupbegin("yoyo.os");
+    yoyo::os::init(yoyo);
+    pxs_startupend();
     #endif // YOYO_OS
 
     #ifdef YOYO_PXS
+    pxs_startupbegin("yoyo.pxs");
     yoyo::ipxs::init(yoyo);
+    pxs_startupend();
     #endif // YOYO_PXS
 
     #ifdef YOYO_FS
+    pxs_startupbegin("yoyo.fs");
     yoyo::fs::init(yoyo);
+    pxs_startupend();
     #endif // YOYO_FS
 
     #ifdef YOYO_SHELL
+    pxs_startupbegin("yoyo.shell");
     yoyo::shell::init(yoyo);
+    pxs_startupend();
     #endif // YOYO_SHELL
 
     #ifdef YOYO_NET
+    pxs_startupbegin("yoyo.net");
     yoyo::net::init(yoyo);
+    pxs_startupend();
     #endif // YOYO_NET
 
     #ifdef YOYO_ZIP
+    pxs_startupbegin("yoyo.zip");
     yoyo::zip::init(yoyo);
+    pxs_startupend();
     #endif // YOYO_ZIP
-    
+
+    #ifdef YOYO_YAML
+    pxs_startupbegin("yoyo.yaml");
+    yoyo::yaml::init(yoyo);
+    pxs_startupend();
+    #endif // YOYO_YAML
+
+    #ifdef YOYO_ARRAY
+    pxs_startupbegin("yoyo.array");
+    yoyo::array::init(yoyo);
+    pxs_startupend();
+    #endif // YOYO_ARRAY
+
+    #ifdef YOYO_TASK
+    pxs_startupbegin("yoyo.task");
+    yoyo::task::init(yoyo);
+    pxs_startupend();
+    #endif // YOYO_TASK
+
+    #ifdef YOYO_CHANNEL
+    pxs_startupbegin("yoyo.channel");
+    yoyo::channel::init(yoyo);
+    pxs_startupend();
+    #endif // YOYO_CHANNEL
+
+    #ifdef YOYO_TIME
+    pxs_startupbegin("yoyo.time");
+    yoyo::time::init(yoyo);
+    pxs_startupend();
+    #endif // YOYO_TIME
+
+    #ifdef YOYO_SHM
+    pxs_startupbegin("yoyo.shm");
+    yoyo::shm::init(yoyo);
+    pxs_startupend();
+    #endif // YOYO_SHM
+
+    #ifdef YOYO_COMPRESS
+    pxs_startupbegin("yoyo.compress");
+    yoyo::compress::init(yoyo);
+    pxs_startupend();
+    #endif // YOYO_COMPRESS
+
+    #ifdef YOYO_HASH
+    pxs_startupbegin("yoyo.hash");
+    yoyo::hash::init(yoyo);
+    pxs_startupend();
+    #endif // YOYO_HASH
+
     pxs_addmod(yoyo);
+    pxs_startupend();
+}
+
+int yoyo_pump() {
+    int handled = 0;
+
+    #ifdef YOYO_FS
+    handled += yoyo::fs::pump();
+    #endif // YOYO_FS
+
+    #ifdef YOYO_NET
+    handled += yoyo::net::pump();
+    #endif // YOYO_NET
+
+    #ifdef YOYO_TIME
+    handled += yoyo::time::pump();
+    #endif // YOYO_TIME
+
+    return handled;
+}
+
+
+void yoyo_fs_usecache(uint64_t budget) {
+    #ifdef YOYO_FS
+    yoyo::fs::use_file_cache(static_cast<size_t>(budget));
+    #endif // YOYO_FS
+}
+
+void yoyo_net_trackstats(bool enabled) {
+    #ifdef YOYO_NET
+    yoyo::net::track_stats(enabled);
+    #endif // YOYO_NET
+}
+
+size_t yoyo_net_stats(char* out, size_t len, bool reset) {
+    #ifdef YOYO_NET
+    return yoyo::net::write_stats(out, len, reset);
+    #else
+    if (out && len > 0) {
+        out[0] = '\0';
+    }
+    return 0;
+    #endif // YOYO_NET
+}
+
+bool yoyo_zip_mount(const char* path) {
+    #ifdef YOYO_ZIP
+    return path != nullptr && yoyo::zip::mount_path(path);
+    #else
+    return false;
+    #endif // YOYO_ZIP
+}
+
+void yoyo_task_setup(void (*setup)(void*), void* opaque, uint32_t workers) {
+    #ifdef YOYO_TASK
+    yoyo::task::set_setup(setup, opaque, workers);
+    #endif // YOYO_TASK
+}
+
+void* yoyo_channel_open(const char* name, uint32_t capacity) {
+    #ifdef YOYO_CHANNEL
+    return name == nullptr ? nullptr : yoyo::channel::host_open(name, capacity);
+    #else
+    return nullptr;
+    #endif // YOYO_CHANNEL
+}
+
+bool yoyo_channel_push(void* channel, const void* data, size_t len, bool packed) {
+    #ifdef YOYO_CHANNEL
+    if (channel == nullptr || (data == nullptr && len != 0)) {
+        return false;
+    }
+    return yoyo::channel::host_push(channel, data, len, packed);
+    #else
+    return false;
+    #endif // YOYO_CHANNEL
+}
+
+bool yoyo_channel_pop(void* channel, void (*sink)(void* opaque, const void* data, size_t len, bool packed), void* opaque) {
+    #ifdef YOYO_CHANNEL
+    if (channel == nullptr || sink == nullptr) {
+        return false;
+    }
+    return yoyo::channel::host_pop(channel, sink, opaque);
+    #else
+    return false;
+    #endif // YOYO_CHANNEL
+}
+
+void yoyo_log_setup(int level, size_t flush_bytes, uint32_t flush_ms) {
+    #ifdef YOYO_CORE
+    if (level < 0 || level > static_cast<int>(yoyo::utils::log::Level::Off)) {
+        level = static_cast<int>(yoyo::utils::log::Level::Off);
+    }
+    yoyo::utils::log::configure(static_cast<yoyo::utils::log::Level>(level), flush_bytes, flush_ms);
+    #endif // YOYO_CORE
+}
+
+void yoyo_log_flush() {
+    #ifdef YOYO_CORE
+    yoyo::utils::log::flush();
+    #endif // YOYO_CORE
+}
+
+void yoyo_os_setargs(int argc, const char* const* argv) {
+    #ifdef YOYO_OS
+    std::vector<std::string> args;
+    for (int i = 0; i < argc && argv != nullptr; i++) {
+        args.emplace_back(argv[i] == nullptr ? "" : argv[i]);
+    }
+    yoyo::os::set_args(std::move(args));
+    #endif // YOYO_OS
+}
+
+uint32_t yoyo_cpu_count(bool physical) {
+    auto& topo = yoyo::utils::cpu::topology();
+    return physical ? topo.physical : topo.logical;
+}
+
+bool yoyo_pin_worker(uint32_t index) {
+    return yoyo::utils::cpu::pin_worker(index);
 }
@@ -4,8 +4,17 @@
 #include <cstdint>
 #include <string>
 #include <vector>
+// Only the C API, the implementation lives in utils/miniz.cpp.
+#define MINIZ_HEADER_FILE_ONLY
+#define MINIZ_NO_CPP_WRAPPER
 #include "miniz.hpp"
 #include <utility>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
 #include "utils/types.hpp"
 #include <sstream>
 #include "utils/bytes.hpp"
@@ -14,60 +23,993 @@
 #include <pixelscript.h>
 #include <pixelscript_cpp.hpp>
 #include "utils/exceptions.hpp"
+#include "utils/pool.hpp"
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <optional>
 
 #ifndef YOYO_FS
 #error "YOYO_FS is required to use YOYO_ZIP."
 #endif
 
 #include "fs.hpp"
+#ifdef YOYO_YAML
+#include "yaml.hpp"
+#endif
 
 namespace yoyo::zip {
+    // Archive path of `path`: no leading `/` or `./`.
+    std::string entry_path(const std::string& path) {
+        size_t start = 0;
+        while (start < path.size()) {
+            if (path[start] == '/') {
+                start++;
+            } else if (path.compare(start, 2, "./") == 0) {
+                start += 2;
+            } else {
+                break;
+            }
+        }
+        return path.substr(start);
+    }
+
+    // Archive path of the directory `path`: `""` for the root, otherwise ending in `/`.
+    std::string dir_path(const std::string& path) {
+        auto dir = entry_path(path);
+        if (!dir.empty() && dir.back() != '/') {
+            dir += '/';
+        }
+        return dir;
+    }
+
+    // The directory holding `path`, `""` for the root.
+    std::string parent_of(const std::string& path) {
+        auto end = path.size();
+        if (end > 0 && path[end - 1] == '/') {
+            end--;
+        }
+        auto slash = path.rfind('/', end == 0 ? 0 : end - 1);
+        if (slash == std::string::npos || end == 0) {
+            return "";
+        }
+        return path.substr(0, slash + 1);
+    }
+
+    // Little endian helpers for zip records.
+    void put16(std::string& out, uint32_t value) {
+        out += static_cast<char>(value & 0xFF);
+        out += static_cast<char>((value >> 8) & 0xFF);
+    }
+
+    void put32(std::string& out, uint32_t value) {
+        put16(out, value & 0xFFFF);
+        put16(out, value >> 16);
+    }
+
+    uint32_t read16(const char* data) {
+        auto p = reinterpret_cast<const unsigned char*>(data);
+        return p[0] | (p[1] << 8);
+    }
+
+    // The current local time as MS-DOS time and date.
+    void dos_now(uint16_t& time, uint16_t& date) {
+        auto now = std::time(nullptr);
+        std::tm tm{};
+    #if defined(_WIN32)
+        localtime_s(&tm, &now);
+    #else
+        localtime_r(&now, &tm);
+    #endif
+        time = static_cast<uint16_t>((tm.tm_hour << 11) | (tm.tm_min << 5) | (tm.tm_sec >> 1));
+        date = static_cast<uint16_t>(((std::max(tm.tm_year + 1900, 1980) - 1980) << 9) | ((tm.tm_mon + 1) << 5) | tm.tm_mday);
+    }
+
+    // Reading mode serves lookups from `entries` and `children`, built once per central directory.
+    //
+    // Writes append in place: the first one after reading keeps the central directory records of the live
+    // entries and starts writing new entries where the old central directory began. The next read (or `flush`)
+    // writes the new central directory after them and rebuilds the index. Removed and replaced entries
+    // only leave the central directory, their data stays until `compact`.
+    struct Archive {
+        std::unique_ptr<mz_zip_archive> zip = std::make_unique<mz_zip_archive>();
+        // Keeps the bytes `zip` reads from alive.
+        std::shared_ptr<const void> storage;
+        const void* data = nullptr;
+        size_t size = 0;
+        // The archive on disk, empty for archives in memory.
+        std::string path;
+        // The bytes of an archive in memory.
+        std::shared_ptr<std::vector<char>> owned;
+
+        // Path to central directory index. Later duplicates win.
+        std::unordered_map<std::string, mz_uint> entries;
+        // Directory (`""` or ending in `/`) to its direct children. Directories also exist implicitly through their files.
+        std::unordered_map<std::string, std::vector<std::string>> children{{"", {}}};
+
+        // An append in progress.
+        struct Appending {
+            std::FILE* file = nullptr;
+            std::shared_ptr<std::vector<char>> buffer;
+            // Where the next local header goes.
+            uint64_t end = 0;
+            // Central directory records of the live entries.
+            std::vector<std::string> records;
+            std::unordered_map<std::string, size_t> slots;
+        };
+        std::unique_ptr<Appending> appending;
+        // Bumped by every write and removal.
+        uint64_t version = 0;
+        // Reused by text reads of `ZipFile.read` and by `read_yaml`, entries are inflated here before they become pxs vars.
+        std::vector<char> scratch;
+        // Used by writes that don't pick one.
+        Compression compression = Compression::Default;
+
+        Archive() {}
+        ~Archive() {
+            try {
+                // Archives on disk keep every change.
+                if (!this->path.empty() && !writing() && has_dead_entries()) {
+                    start_write();
+                }
+                finish_append(false);
+            } catch (...) {}
+            close();
+        }
+
+        Archive(const Archive&) = delete;
+        Archive& operator=(const Archive&) = delete;
+
+        bool reading() const {
+            return this->zip->m_zip_mode == MZ_ZIP_MODE_READING;
+        }
+
+        bool writing() const {
+            return this->appending != nullptr;
+        }
+
+        // Stop reading and let go of the bytes.
+        void close() {
+            if (reading()) {
+                mz_zip_reader_end(this->zip.get());
+            }
+            this->storage.reset();
+            this->owned.reset();
+            this->data = nullptr;
+            this->size = 0;
+        }
+
+        // Read the archive in `data`. `storage` keeps it alive.
+        void load(std::shared_ptr<const void> storage, const void* data, size_t size) {
+            close();
+            this->storage = std::move(storage);
+            this->data = data;
+            this->size = size;
+            std::memset(this->zip.get(), 0, sizeof(mz_zip_archive));
+            if (!mz_zip_reader_init_mem(this->zip.get(), this->data, this->size, 0)) {
+                close();
+                throw std::runtime_error("Not a valid zip archive.");
+            }
+            index();
+        }
+
+        void load(std::shared_ptr<std::vector<char>> bytes) {
+            auto data = static_cast<const void*>(bytes->data());
+            auto size = bytes->size();
+            load(bytes, data, size);
+            this->owned = std::move(bytes);
+        }
+
+        void load(std::vector<char> bytes) {
+            load(std::make_shared<std::vector<char>>(std::move(bytes)));
+        }
+
+        // Map the archive at `path`. Writes go back into it.
+        void load_file(const std::string& path) {
+            auto mapped = std::make_shared<fs::MappedFile>(path, false);
+            if (!mapped->is_mapped()) {
+                throw std::runtime_error("Could not open archive: " + path);
+            }
+            auto data = static_cast<const void*>(mapped->data());
+            auto size = mapped->size();
+            load(std::move(mapped), data, size);
+            this->path = path;
+        }
+
+        void add_child(const std::string& path) {
+            if (path.back() == '/') {
+                if (this->children.count(path)) {
+                    return;
+                }
+                this->children[path];
+            }
+            auto parent = parent_of(path);
+            if (!this->children.count(parent)) {
+                add_child(parent);
+            }
+            this->children[parent].push_back(path);
+        }
+
+        void index() {
+            this->entries.clear();
+            this->children.clear();
+            this->children[""];
+
+            auto count = mz_zip_reader_get_num_files(this->zip.get());
+            this->entries.reserve(count);
+            std::string name;
+            for (mz_uint i = 0; i < count; i++) {
+                auto len = mz_zip_reader_get_filename(this->zip.get(), i, nullptr, 0);
+                if (len <= 1) {
+                    continue;
+                }
+                name.resize(len);
+                mz_zip_reader_get_filename(this->zip.get(), i, name.data(), len);
+                name.resize(len - 1);
+
+                auto path = entry_path(name);
+                if (path.empty()) {
+                    continue;
+                }
+                auto found = this->entries.find(path);
+                if (found != this->entries.end()) {
+                    found->second = i;
+                    continue;
+                }
+                this->entries.emplace(path, i);
+                add_child(path);
+            }
+        }
+
+        // Are there entries in the central directory that are not live anymore?
+        bool has_dead_entries() const {
+            return reading() && this->entries.size() != mz_zip_reader_get_num_files(this->zip.get());
+        }
+
+        // Live entries in archive order.
+        std::vector<std::pair<mz_uint, const std::string*>> live_entries() const {
+            std::vector<std::pair<mz_uint, const std::string*>> live;
+            live.reserve(this->entries.size());
+            for (const auto& [path, i] : this->entries) {
+                live.emplace_back(i, &path);
+            }
+            std::sort(live.begin(), live.end());
+            return live;
+        }
+
+        // Finish pending writes and be ready to read.
+        void start_read() {
+            finish_append(true);
+        }
+
+        // Be ready to append entries.
+        void start_write() {
+            if (writing()) {
+                return;
+            }
+            auto state = std::make_unique<Appending>();
+
+            if (reading()) {
+                // Keep the central directory records of the live entries as they are.
+                auto cdir = static_cast<const char*>(this->data) + this->zip->m_central_directory_file_ofs;
+                for (const auto& [i, path] : live_entries()) {
+                    mz_zip_archive_file_stat stat;
+                    if (!mz_zip_reader_file_stat(this->zip.get(), i, &stat)) {
+                        throw std::runtime_error("Could not read the central directory.");
+                    }
+                    auto record = cdir + stat.m_central_dir_ofs;
+                    auto len = 46 + read16(record + 28) + read16(record + 30) + read16(record + 32);
+                    state->slots[*path] = state->records.size();
+                    state->records.emplace_back(record, len);
+                }
+                // New entries overwrite the old central directory.
+                state->end = this->zip->m_central_directory_file_ofs;
+            }
+
+            if (!this->path.empty()) {
+                close();
+                state->file = std::fopen(this->path.c_str(), "r+b");
+                if (!state->file || !seek(state->file, state->end)) {
+                    if (state->file) {
+                        std::fclose(state->file);
+                    }
+                    load_file(this->path);
+                    throw std::runtime_error("Could not open " + this->path + " for writing.");
+                }
+            } else {
+                // Keep growing our own bytes, copy them once when they are someone else's.
+                auto buffer = this->owned;
+                if (!buffer) {
+                    auto bytes = static_cast<const char*>(this->data);
+                    buffer = std::make_shared<std::vector<char>>(bytes, bytes + this->size);
+                }
+                close();
+                buffer->resize(state->end);
+                state->buffer = std::move(buffer);
+            }
+            this->appending = std::move(state);
+        }
+
+        static bool seek(std::FILE* file, uint64_t offset) {
+        #if defined(_WIN32)
+            return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+        #else
+            return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+        #endif
+        }
+
+        // Append `len` bytes at the end of the pending data.
+        void put(const void* data, size_t len) {
+            auto& state = *this->appending;
+            if (state.file) {
+                if (std::fwrite(data, 1, len, state.file) != len) {
+                    throw std::runtime_error("Could not write to " + this->path);
+                }
+            } else {
+                auto& buffer = *state.buffer;
+                buffer.resize(static_cast<size_t>(state.end) + len);
+                std::memcpy(buffer.data() + state.end, data, len);
+            }
+            state.end += len;
+        }
+
+        // Write the central directory and stop appending. Reads again with `reload`.
+        void finish_append(bool reload) {
+            if (!writing()) {
+                return;
+            }
+            auto& state = *this->appending;
+
+            std::string cdir;
+            size_t count = 0;
+            for (const auto& record : state.records) {
+                if (!record.empty()) {
+                    cdir += record;
+                    count++;
+                }
+            }
+            if (count > 0xFFFF || state.end > 0xFFFFFFFF || cdir.size() > 0xFFFFFFFF) {
+                throw std::runtime_error("The archive is too large, ZIP64 is not supported.");
+            }
+            std::string eocd;
+            put32(eocd, 0x06054b50);
+            put16(eocd, 0);
+            put16(eocd, 0);
+            put16(eocd, static_cast<uint32_t>(count));
+            put16(eocd, static_cast<uint32_t>(count));
+            put32(eocd, static_cast<uint32_t>(cdir.size()));
+            put32(eocd, static_cast<uint32_t>(state.end));
+            put16(eocd, 0);
+            put(cdir.data(), cdir.size());
+            put(eocd.data(), eocd.size());
+
+            auto total = state.end;
+            auto file = state.file;
+            auto buffer = std::move(state.buffer);
+            this->appending.reset();
+
+            if (file) {
+                bool ok = std::fflush(file) == 0;
+                std::fclose(file);
+                // Removed entries can make it shorter than before.
+                std::error_code ec;
+                std::filesystem::resize_file(this->path, total, ec);
+                fs::stat_cache().invalidate(this->path);
+                if (!ok || ec) {
+                    throw std::runtime_error("Could not write to " + this->path);
+                }
+                if (reload) {
+                    load_file(this->path);
+                }
+            } else {
+                buffer->resize(static_cast<size_t>(total));
+                if (reload) {
+                    load(std::move(buffer));
+                } else {
+                    this->owned = std::move(buffer);
+                }
+            }
+        }
+
+        // Persist pending writes and removals. Only the central directory is rewritten for removals.
+        void flush() {
+            if (!writing() && has_dead_entries()) {
+                start_write();
+            }
+            start_read();
+        }
+
+        // Rewrite the archive without the data of removed and replaced entries.
+        void compact() {
+            start_read();
+            if (!reading()) {
+                return;
+            }
+
+            mz_zip_archive out;
+            std::memset(&out, 0, sizeof(out));
+            std::string tmp = this->path.empty() ? "" : this->path + ".yoyo_tmp";
+            bool ok = tmp.empty()
+                ? mz_zip_writer_init_heap(&out, 0, this->size)
+                : mz_zip_writer_init_file(&out, tmp.c_str(), 0);
+            if (!ok) {
+                throw std::runtime_error("Could not start compacting the archive.");
+            }
+            for (const auto& [i, path] : live_entries()) {
+                ok = ok && mz_zip_writer_add_from_zip_reader(&out, this->zip.get(), i);
+            }
+
+            void* heap = nullptr;
+            size_t heap_size = 0;
+            if (ok) {
+                ok = tmp.empty()
+                    ? mz_zip_writer_finalize_heap_archive(&out, &heap, &heap_size)
+                    : mz_zip_writer_finalize_archive(&out);
+            }
+            mz_zip_writer_end(&out);
+            if (!ok) {
+                if (heap) {
+                    mz_free(heap);
+                }
+                std::error_code ec;
+                if (!tmp.empty()) {
+                    std::filesystem::remove(tmp, ec);
+                }
+                throw std::runtime_error("Could not compact the archive.");
+            }
+
+            if (tmp.empty()) {
+                auto bytes = static_cast<const char*>(heap);
+                auto buffer = std::make_shared<std::vector<char>>(bytes, bytes + heap_size);
+                mz_free(heap);
+                load(std::move(buffer));
+                return;
+            }
+            // Let go of the mapping before replacing the file.
+            close();
+            std::error_code ec;
+            std::filesystem::rename(tmp, this->path, ec);
+            fs::stat_cache().invalidate(this->path);
+            load_file(this->path);
+            if (ec) {
+                throw std::runtime_error("Could not replace " + this->path + ": " + ec.message());
+            }
+        }
+
+        // Write a copy of the archive, without removed entries, to `dest`.
+        void save_as(const std::string& dest) {
+            start_read();
+            mz_zip_archive out;
+            std::memset(&out, 0, sizeof(out));
+            if (!mz_zip_writer_init_file(&out, dest.c_str(), 0)) {
+                throw std::runtime_error("Could not write " + dest);
+            }
+            bool ok = true;
+            if (reading()) {
+                for (const auto& [i, path] : live_entries()) {
+                    ok = ok && mz_zip_writer_add_from_zip_reader(&out, this->zip.get(), i);
+                }
+            }
+            ok = ok && mz_zip_writer_finalize_archive(&out);
+            mz_zip_writer_end(&out);
+            fs::stat_cache().invalidate(dest);
+            if (!ok) {
+                throw std::runtime_error("Could not write " + dest);
+            }
+        }
+
+        // Index of `path`, -1 if it is not in the archive.
+        int find(const std::string& path) {
+            start_read();
+            auto found = this->entries.find(entry_path(path));
+            return found == this->entries.end() ? -1 : static_cast<int>(found->second);
+        }
+
+        // Inflate `path` into `out`, sized to the entry. Reusing `out` saves the allocation.
+        template<typename Buffer>
+        void read_into(const std::string& path, Buffer& out) {
+            auto i = find(path);
+            if (i < 0) {
+                throw std::runtime_error("Could not find " + path + " in the archive.");
+            }
+            mz_zip_archive_file_stat stat;
+            if (!mz_zip_reader_file_stat(this->zip.get(), static_cast<mz_uint>(i), &stat) || stat.m_uncomp_size > SIZE_MAX) {
+                throw std::runtime_error("Could not read " + path + " from the archive.");
+            }
+            out.resize(static_cast<size_t>(stat.m_uncomp_size));
+            if (out.size() > 0 && !mz_zip_reader_extract_to_mem(this->zip.get(), static_cast<mz_uint>(i), out.data(), out.size(), 0)) {
+                throw std::runtime_error("Could not read " + path + " from the archive.");
+            }
+        }
+
+        std::string read(const std::string& path) {
+            std::string result;
+            read_into(path, result);
+            return result;
+        }
+
+    #ifdef PXS_JSON
+        // Inflate `path` into a `pxs_json_newstream` one buffer at a time, the entry is never held whole.
+        pxs_VarT read_json(const std::string& path, const char* pointer) {
+            auto i = find(path);
+            if (i < 0) {
+                throw std::runtime_error("Could not find " + path + " in the archive.");
+            }
+            auto stream = pxs_json_newstream(pointer);
+            auto feed = [](void* opaque, mz_uint64, const void* data, size_t len) -> size_t {
+                // Returning short stops miniz, the error stays in the stream.
+                return pxs_json_feed(static_cast<pxs_JsonStream*>(opaque), static_cast<const char*>(data), len) ? len : 0;
+            };
+            bool ok = mz_zip_reader_extract_to_callback(this->zip.get(), static_cast<mz_uint>(i), feed, stream, 0);
+            auto result = pxs_json_finish(stream);
+            // i.e. a CRC-32 mismatch after valid JSON.
+            if (!ok && !pxs_varis(result, pxs_Exception)) {
+                pxs_freevar(result);
+                throw std::runtime_error("Could not read " + path + " from the archive.");
+            }
+            return result;
+        }
+    #endif
+
+        // Inflate entry `i` of `zip` straight into the file `dest`, one buffer at a time. Its directory has to exist.
+        static void inflate_to_file(mz_zip_archive* zip, mz_uint i, const std::string& name, const std::filesystem::path& dest) {
+            std::ofstream out(dest, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                throw std::runtime_error("Could not write " + dest.string());
+            }
+            auto write_chunk = [](void* opaque, mz_uint64, const void* data, size_t len) -> size_t {
+                auto stream = static_cast<std::ofstream*>(opaque);
+                stream->write(static_cast<const char*>(data), static_cast<std::streamsize>(len));
+                return *stream ? len : 0;
+            };
+            bool ok = mz_zip_reader_extract_to_callback(zip, i, write_chunk, &out, 0);
+            out.close();
+            fs::stat_cache().invalidate(dest.string());
+            if (!ok || !out) {
+                throw std::runtime_error("Could not extract " + name + " to " + dest.string());
+            }
+        }
+
+        void extract_to(const std::string& path, const std::filesystem::path& dest) {
+            auto i = find(path);
+            if (i < 0) {
+                throw std::runtime_error("Could not find " + path + " in the archive.");
+            }
+            std::error_code ec;
+            if (dest.has_parent_path()) {
+                std::filesystem::create_directories(dest.parent_path(), ec);
+            }
+            inflate_to_file(this->zip.get(), static_cast<mz_uint>(i), path, dest);
+        }
+
+        // Run `job(reader, i)` for every i below `count` on `threads` pool workers. Every worker reads through
+        // its own reader over the same bytes. The first job to throw stops the rest and its error is rethrown.
+        void run_parallel(size_t count, size_t threads, const std::function<void(mz_zip_archive*, size_t)>& job) {
+            start_read();
+            size_t workers = std::min(count, std::max<size_t>(1, threads));
+            std::mutex lock;
+            std::condition_variable cv;
+            size_t next = 0;
+            size_t running = workers;
+            std::string error;
+            for (size_t w = 0; w < workers; w++) {
+                utils::pool::shared().submit([&]() {
+                    mz_zip_archive reader;
+                    std::memset(&reader, 0, sizeof(reader));
+                    bool ready = mz_zip_reader_init_mem(&reader, this->data, this->size, 0);
+                    while (ready) {
+                        size_t i;
+                        {
+                            std::lock_guard<std::mutex> guard(lock);
+                            if (next >= count || !error.empty()) {
+                                break;
+                            }
+                            i = next++;
+                        }
+
+                        try {
+                            job(&reader, i);
+                        } catch (const std::exception& e) {
+                            std::lock_guard<std::mutex> guard(lock);
+                            error = e.what();
+                        }
+                    }
+                    if (ready) {
+                        mz_zip_reader_end(&reader);
+                    }
+
+                    std::lock_guard<std::mutex> guard(lock);
+                    if (!ready && error.empty()) {
+                        error = "Could not read the archive.";
+                    }
+                    if (--running == 0) {
+                        cv.notify_one();
+                    }
+                });
+            }
+            std::unique_lock<std::mutex> guard(lock);
+            cv.wait(guard, [&] { return running == 0; });
+            if (!error.empty()) {
+                throw std::runtime_error(error);
+            }
+        }
+
+        // Extract `files` (archive path, destination) on `threads` pool workers. The destination directories have to exist.
+        void extract_parallel(const std::vector<std::pair<std::string, std::filesystem::path>>& files, size_t threads) {
+            start_read();
+            std::vector<mz_uint> indices;
+            indices.reserve(files.size());
+            for (const auto& [name, dest] : files) {
+                auto found = this->entries.find(name);
+                if (found == this->entries.end()) {
+                    throw std::runtime_error("Could not find " + name + " in the archive.");
+                }
+                indices.push_back(found->second);
+            }
+            run_parallel(files.size(), threads, [&](mz_zip_archive* reader, size_t i) {
+                inflate_to_file(reader, indices[i], files[i].first, files[i].second);
+            });
+        }
+
+        // Inflate every live entry and check it against its CRC-32 without keeping the data.
+        // Returns the paths that failed, in archive order.
+        std::vector<std::string> verify(size_t threads) {
+            auto live = live_entries();
+            std::vector<char> failed(live.size(), 0);
+            auto discard = [](void*, mz_uint64, const void*, size_t len) -> size_t {
+                return len;
+            };
+            run_parallel(live.size(), threads, [&](mz_zip_archive* reader, size_t i) {
+                // miniz checks the CRC once the entry is inflated.
+                failed[i] = !mz_zip_reader_extract_to_callback(reader, live[i].first, discard, nullptr, 0);
+            });
+
+            std::vector<std::string> result;
+            for (size_t i = 0; i < live.size(); i++) {
+                if (failed[i]) {
+                    result.push_back(*live[i].second);
+                }
+            }
+            return result;
+        }
+
+        // miniz level of `compression`.
+        static int deflate_level(Compression compression) {
+            switch (compression) {
+                case Compression::Store:
+                    return MZ_NO_COMPRESSION;
+                case Compression::Fast:
+                    return MZ_BEST_SPEED;
+                case Compression::Best:
+                    return MZ_BEST_COMPRESSION;
+                default:
+                    return MZ_DEFAULT_LEVEL;
+            }
+        }
+
+        // Would deflate barely help `data`? Compresses a few spread out slices at the fastest level
+        // instead of all of it.
+        static bool poorly_compressible(const unsigned char* data, size_t len) {
+            constexpr size_t slice = 4096;
+            constexpr size_t slices = 4;
+            if (len < slice * 2) {
+                // Small enough to just try.
+                return false;
+            }
+
+            std::vector<unsigned char> out(slice + slice / 8 + 64);
+            auto flags = tdefl_create_comp_flags_from_zip_params(MZ_BEST_SPEED, -MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY);
+            size_t in_total = 0;
+            size_t out_total = 0;
+            for (size_t i = 0; i < slices; i++) {
+                auto at = (len - slice) / (slices - 1) * i;
+                auto packed = tdefl_compress_mem_to_mem(out.data(), out.size(), data + at, slice, static_cast<int>(flags));
+                // 0 means it did not even fit.
+                out_total += packed == 0 ? slice : packed;
+                in_total += slice;
+            }
+            // Saving less than 1/32 is not worth inflating for.
+            return out_total > in_total - in_total / 32;
+        }
+
+        // Add `path`, replacing an entry with the same path.
+        void write(const std::string& path, const void* data, size_t len) {
+            write(path, data, len, this->compression);
+        }
+
+        void write(const std::string& path, const void* data, size_t len, Compression compression) {
+            auto name = entry_path(path);
+            if (name.empty()) {
+                throw std::runtime_error("Expected a path to write to.");
+            }
+            start_write();
+            this->version++;
+
+            bool dir = name.back() == '/';
+            auto crc = static_cast<uint32_t>(mz_crc32(MZ_CRC32_INIT, static_cast<const unsigned char*>(data), len));
+            uint16_t method = 0;
+            const void* payload = data;
+            size_t payload_len = len;
+            void* deflated = nullptr;
+            auto bytes = static_cast<const unsigned char*>(data);
+            if (!dir && len > 0 && compression != Compression::Store && !poorly_compressible(bytes, len)) {
+                size_t deflated_len = 0;
+                auto flags = tdefl_create_comp_flags_from_zip_params(deflate_level(compression), -MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY);
+                deflated = tdefl_compress_mem_to_heap(data, len, &deflated_len, static_cast<int>(flags));
+                // Stored when deflate does not help.
+                if (deflated && deflated_len < len) {
+                    method = MZ_DEFLATED;
+                    payload = deflated;
+                    payload_len = deflated_len;
+                }
+            }
+
+            auto& state = *this->appending;
+            auto offset = state.end;
+            if (len > 0xFFFFFFFF || offset > 0xFFFFFFFF || name.size() > 0xFFFF) {
+                mz_free(deflated);
+                throw std::runtime_error("The archive is too large, ZIP64 is not supported.");
+            }
+            uint16_t time, date;
+            dos_now(time, date);
+
+            std::string header;
+            put32(header, 0x04034b50);
+            put16(header, 20);
+            put16(header, 0);
+            put16(header, method);
+            put16(header, time);
+            put16(header, date);
+            put32(header, crc);
+            put32(header, static_cast<uint32_t>(payload_len));
+            put32(header, static_cast<uint32_t>(len));
+            put16(header, static_cast<uint32_t>(name.size()));
+            put16(header, 0);
+            header += name;
+            try {
+                put(header.data(), header.size());
+                put(payload, payload_len);
+            } catch (...) {
+                mz_free(deflated);
+                throw;
+            }
+            mz_free(deflated);
+
+            std::string record;
+            put32(record, 0x02014b50);
+            put16(record, 20);
+            put16(record, 20);
+            put16(record, 0);
+            put16(record, method);
+            put16(record, time);
+            put16(record, date);
+            put32(record, crc);
+            put32(record, static_cast<uint32_t>(payload_len));
+            put32(record, static_cast<uint32_t>(len));
+            put16(record, static_cast<uint32_t>(name.size()));
+            put16(record, 0);
+            put16(record, 0);
+            put16(record, 0);
+            put16(record, 0);
+            // MS-DOS directory attribute.
+            put32(record, dir ? 0x10 : 0);
+            put32(record, static_cast<uint32_t>(offset));
+            record += name;
+
+            auto slot = state.slots.find(name);
+            if (slot != state.slots.end()) {
+                state.records[slot->second] = std::move(record);
+            } else {
+                state.slots[name] = state.records.size();
+                state.records.push_back(std::move(record));
+            }
+        }
+
+        // Is `path` a directory? The root always is.
+        bool is_dir(const std::string& path) {
+            start_read();
+            return this->children.count(dir_path(path)) > 0;
+        }
+
+        // Paths under the directory `dir`.
+        std::vector<std::string> list(const std::string& dir, bool recursive) {
+            start_read();
+            auto found = this->children.find(dir_path(dir));
+            if (found == this->children.end()) {
+                throw std::runtime_error("Could not find the directory " + dir + " in the archive.");
+            }
+            if (!recursive) {
+                return found->second;
+            }
+
+            std::vector<std::string> result;
+            collect(found->second, result);
+            return result;
+        }
+
+        // Depth first, a directory comes right before its contents.
+        void collect(const std::vector<std::string>& items, std::vector<std::string>& result) {
+            for (const auto& item : items) {
+                result.push_back(item);
+                if (item.back() == '/') {
+                    collect(this->children[item], result);
+                }
+            }
+        }
+
+        // Drop `path` from its parent's children.
+        void unlink(const std::string& path) {
+            auto parent = this->children.find(parent_of(path));
+            if (parent == this->children.end()) {
+                return;
+            }
+            auto& items = parent->second;
+            items.erase(std::remove(items.begin(), items.end(), path), items.end());
+        }
+
+        // Remove a file. Its data is dropped with the next rewrite.
+        void remove_file(const std::string& path) {
+            start_read();
+            auto name = entry_path(path);
+            if (name.empty() || name.back() == '/' || this->entries.erase(name) == 0) {
+                throw std::runtime_error("Could not find the file " + path + " in the archive.");
+            }
+            this->version++;
+            unlink(name);
+        }
+
+        // Remove a directory and everything in it. Returns the number of entries removed.
+        size_t remove_dir(const std::string& path) {
+            auto dir = dir_path(path);
+            auto items = list(dir, true);
+            this->version++;
+            for (const auto& item : items) {
+                this->entries.erase(item);
+                if (item.back() == '/') {
+                    this->children.erase(item);
+                }
+            }
+            if (dir.empty()) {
+                this->children[""].clear();
+            } else {
+                this->entries.erase(dir);
+                this->children.erase(dir);
+                unlink(dir);
+            }
+            return items.size();
+        }
+    };
+
     void free_zip_file(pxs_Opaque obj) {
         if (obj) {
             delete static_cast<ZipFile*>(obj);
         }
     }
 
-    ZipFile::~ZipFile() {
-        if (zf) {
-            delete zf;
+    ZipFile::~ZipFile() {}
+
+    // The archive serving script imports.
+    struct Mount {
+        std::mutex lock;
+        std::shared_ptr<Archive> archive;
+        // Decompressed sources by archive path, valid for `version`.
+        std::unordered_map<std::string, std::string> sources;
+        uint64_t version = 0;
+    };
+
+    Mount& mount_state() {
+        static Mount mount;
+        return mount;
+    }
+
+    pxs_VarT mounted_reader(const char* path) {
+        if (path == nullptr) {
+            return pxs_newnull();
+        }
+        auto& mount = mount_state();
+        std::lock_guard<std::mutex> guard(mount.lock);
+        if (!mount.archive) {
+            return pxs_newnull();
+        }
+        if (mount.version != mount.archive->version) {
+            mount.sources.clear();
+            mount.version = mount.archive->version;
         }
+
+        auto name = entry_path(path);
+        auto found = mount.sources.find(name);
+        if (found == mount.sources.end()) {
+            try {
+                found = mount.sources.emplace(name, mount.archive->read(name)).first;
+            } catch (const std::exception&) {
+                return pxs_newnull();
+            }
+        }
+        return pxs_newstring(found->second.c_str());
+    }
+
+    pxs_VarT mounted_dir_reader(const char* path) {
+        if (path == nullptr) {
+            return pxs_newnull();
+        }
+        auto& mount = mount_state();
+        std::lock_guard<std::mutex> guard(mount.lock);
+        if (!mount.archive || !mount.archive->is_dir(path)) {
+            return pxs_newnull();
+        }
+
+        // Names like a disk reader would give, without the directory and trailing `/`.
+        auto dir = dir_path(path);
+        auto items = mount.archive->list(dir, false);
+        auto list = pxs_newlist_with_capacity(items.size());
+        for (const auto& item : items) {
+            auto name = item.substr(dir.size());
+            if (name.back() == '/') {
+                name.pop_back();
+            }
+            pxs_listadd(list, pxs_newstring(name.c_str()));
+        }
+        return list;
     }
 
+    void mount_archive(std::shared_ptr<Archive> archive) {
+        auto& state = mount_state();
+        {
+            std::lock_guard<std::mutex> guard(state.lock);
+            state.archive = std::move(archive);
+            state.sources.clear();
+            state.version = state.archive->version;
+        }
+        pxs_set_filereader(mounted_reader);
+        pxs_set_dirreader(mounted_dir_reader);
+    }
+
+    bool mount_path(const std::string& path) {
+        auto archive = std::make_shared<Archive>();
+        try {
+            archive->load_file(path);
+        } catch (const std::exception&) {
+            return false;
+        }
+        mount_archive(std::move(archive));
+        return true;
+    }
+
+    // Class of `ZipFile`. Created in `init` since the function lookup is reset with pixelscript.
+    std::optional<pxs::Class<ZipFile>> zip_file_class;
+
     pxs_VarT ZipFile::topxs() {
-        auto obj = pxs_newtype(static_cast<pxs_Opaque>(this), free_zip_file, "ZipFile", yoyo::types::ZIP_ZIP_FILE_TYPE);
-        pxs_object_addfunc(obj, "read", &ZipFile::read);
-        pxs_object_addfunc(obj, "write", &ZipFile::write);
-        pxs_object_addfunc(obj, "listdir", &ZipFile::listdir);
-        pxs_object_addfunc(obj, "rmdir", &ZipFile::rmdir);
-        pxs_object_addfunc(obj, "rmfile", &ZipFile::rmfile);
-        pxs_object_addfunc(obj, "extract", &ZipFile::extract);
-        return pxs_newhost(obj);
+        return zip_file_class->make(this, free_zip_file).raw();
     }
 
-    // pxs_VarT ZipFile::open(const std::string& path) {
-    //     // Open a new zip file using fs.hpp
-    //     auto contents = pxs::call(fs::read_file, {path, static_cast<int>(fs::FileReadType::Bytes)});
-    //     if (pxs_varis(contents, pxs_Exception)) {
-    //         return contents; // propogate.
-    //     }
-    //     // Extarct contents
-    //     std::vector<uint8_t> bytes;
-    //     bytes.resize(pxs_varsize(contents));
-    //     pxs_copybytes(contents, static_cast<pxs_Opaque>(bytes.data()));
-    //     pxs_freevar(contents);
-
-    //     // Create zip file
-    //     auto zip = new ZipFile{miniz_cpp::zip_file(bytes)};
-        
-    //     return zip->topxs();
-    // }
+    // Get the `string` arg at `idx`. Returns false when it is not a string.
+    bool get_string_arg(pxs_VarT args, int idx, std::string& out) {
+        auto arg = pxs_arg(args, idx);
+        if (!pxs_varis(arg, pxs_String)) {
+            return false;
+        }
+        size_t len = 0;
+        auto str = pxs_getstrview(arg, &len);
+        out.assign(str ? str : "", len);
+        return true;
+    }
+
+    // A `read_into` target handed over to a `pxs_Buffer`, so bytes reads inflate straight into the returned var.
+    struct EntryBytes {
+        std::unique_ptr<char[]> bytes;
+        size_t len = 0;
 
-    // pxs_VarT ZipFile::open(const std::vector<uint8_t> archive_bytes) {
-    //     // Just create the zip
-    //     auto zip = new ZipFile{miniz_cpp::zip_file(archive_bytes)};
-    //     return zip->topxs();
-    // }
+        void resize(size_t size) {
+            bytes.reset(new char[size]);
+            len = size;
+        }
+        char* data() { return bytes.get(); }
+        size_t size() const { return len; }
+    };
+
+    void free_entry(void* data) {
+        delete[] static_cast<char*>(data);
+    }
 
     pxs_VarT ZipFile::read(pxs_VarT args) {
         auto self = static_cast<ZipFile*>(pxs_gettype(pxs_getrt(args), pxs_arg(args, 0), yoyo::types::ZIP_ZIP_FILE_TYPE));
@@ -76,15 +1018,10 @@ namespace yoyo::zip {
         }
 
         // Get path
-        auto path_arg = pxs_arg(args, 1);
-        auto path_c = pxs_getstring(path_arg);
-        if (!path_c) {
-            return yoyo::utils::exceptions::expected_type(pxs_vartype(path_arg), pxs_String);
-        }
-        // copy it over. (No allocations needed...) pretty neat I know.
         std::string path;
-        path.resize(pxs_varsize(path_arg) / sizeof(char));
-        pxs_copystring(path_arg, path.data());
+        if (!get_string_arg(args, 1, path)) {
+            return yoyo::utils::exceptions::expected_type(pxs_vartype(pxs_arg(args, 1)), pxs_String);
+        }
 
         // Get rt
         auto rt_int = pxs_getint(pxs_arg(args, 2));
@@ -96,20 +1033,88 @@ namespace yoyo::zip {
             read_type = static_cast<fs::FileReadType>(rt_int);
         }
 
-        // Lets go!
-        auto res = self->zf->read(path);
-
-        // If read_type is bytes we gotta convert it
-        pxs_VarT result;
+        // Bytes are inflated into memory the buffer takes over, one allocation and no copy.
         if (read_type == fs::FileReadType::Bytes) {
-            result = pxs_newbytes(static_cast<pxs_Opaque>(res.data()), sizeof(char), res.size());
-        } else {
-            result = pxs_newstring(res.c_str());
+            EntryBytes entry;
+            try {
+                self->archive->read_into(path, entry);
+            } catch (const std::exception& e) {
+                return pxs_newexception(e.what());
+            }
+            auto len = entry.size();
+            return pxs_newbytes_borrowed(static_cast<pxs_Opaque>(entry.bytes.release()), len, free_entry);
+        }
+
+        auto& res = self->archive->scratch;
+        try {
+            self->archive->read_into(path, res);
+        } catch (const std::exception& e) {
+            return pxs_newexception(e.what());
+        }
+
+        // Strings end at the first nul, don't hand out part of the file.
+        if (!res.empty() && std::memchr(res.data(), '\0', res.size())) {
+            return pxs_newexception((path + " contains nul bytes, read it as FILE_READ_TYPE_BYTES.").c_str());
+        }
+        res.push_back('\0');
+        auto result = pxs_newstring(res.data());
+        // Big entries should not stay around.
+        if (res.capacity() > (1 << 20)) {
+            std::vector<char>().swap(res);
         }
 
         return result;
     }
 
+#ifdef PXS_JSON
+    pxs_VarT ZipFile::read_json(pxs_VarT args) {
+        auto self = static_cast<ZipFile*>(pxs_gettype(pxs_getrt(args), pxs_arg(args, 0), yoyo::types::ZIP_ZIP_FILE_TYPE));
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        std::string path;
+        if (!get_string_arg(args, 1, path)) {
+            return yoyo::utils::exceptions::expected_type(pxs_vartype(pxs_arg(args, 1)), pxs_String);
+        }
+        // Optional, the whole document without it.
+        std::string pointer;
+        get_string_arg(args, 2, pointer);
+
+        try {
+            return self->archive->read_json(path, pointer.c_str());
+        } catch (const std::exception& e) {
+            return pxs_newexception(e.what());
+        }
+    }
+#endif
+
+#ifdef YOYO_YAML
+    pxs_VarT ZipFile::read_yaml(pxs_VarT args) {
+        auto self = static_cast<ZipFile*>(pxs_gettype(pxs_getrt(args), pxs_arg(args, 0), yoyo::types::ZIP_ZIP_FILE_TYPE));
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        std::string path;
+        if (!get_string_arg(args, 1, path)) {
+            return yoyo::utils::exceptions::expected_type(pxs_vartype(pxs_arg(args, 1)), pxs_String);
+        }
+
+        auto& res = self->archive->scratch;
+        try {
+            self->archive->read_into(path, res);
+            auto docs = yoyo::yaml::load_docs(res.data(), res.size());
+            if (res.capacity() > (1 << 20)) {
+                std::vector<char>().swap(res);
+            }
+            return docs;
+        } catch (const std::exception& e) {
+            return pxs_newexception((path + ": " + e.what()).c_str());
+        }
+    }
+#endif
+
     pxs_VarT ZipFile::write(pxs_VarT args) {
         auto self = static_cast<ZipFile*>(pxs_gettype(pxs_getrt(args), pxs_arg(args, 0), yoyo::types::ZIP_ZIP_FILE_TYPE));
         if (!self) {
@@ -117,24 +1122,59 @@ namespace yoyo::zip {
         }
 
         // Get path
-        auto path_arg = pxs_arg(args, 1);
-        if (!pxs_varis(path_arg, pxs_String)) {
-            return yoyo::utils::exceptions::expected_type(pxs_vartype(path_arg), pxs_String);
-        }
         std::string path;
-        path.resize(pxs_varsize(path_arg) / sizeof(char));
-        pxs_copystring(path_arg, path.data());
+        if (!get_string_arg(args, 1, path)) {
+            return yoyo::utils::exceptions::expected_type(pxs_vartype(pxs_arg(args, 1)), pxs_String);
+        }
 
         // Get data
         auto data_arg = pxs_arg(args, 2);
-        std::string data;
         if (!pxs_varis(data_arg, pxs_String) && !pxs_varis(data_arg, pxs_List)) {
             return yoyo::utils::exceptions::expected_types(pxs_vartype(data_arg), {pxs_String, pxs_List});
         }
+        std::string data;
+        data.resize(pxs_varsize(data_arg));
         pxs_copybytes(data_arg, static_cast<pxs_Opaque>(data.data()));
+
+        // Get compression
+        auto compression = self->archive->compression;
+        auto compression_arg = pxs_arg(args, 3);
+        if (pxs_varis(compression_arg, pxs_Int64) || pxs_varis(compression_arg, pxs_UInt64)) {
+            auto level = pxs_getint(compression_arg);
+            if (level < 0 || level > static_cast<int64_t>(Compression::Best)) {
+                return yoyo::utils::exceptions::invalid_enum();
+            }
+            compression = static_cast<Compression>(level);
+        }
         
         // Write it yo!
-        self->zf->writestr(path, data);
+        try {
+            self->archive->write(path, data.data(), data.size(), compression);
+        } catch (const std::exception& e) {
+            return pxs_newexception(e.what());
+        }
+        return pxs_newnull();
+    }
+
+    pxs_VarT ZipFile::prop_compression(pxs_VarT args) {
+        auto self = static_cast<ZipFile*>(pxs_gettype(pxs_getrt(args), pxs_arg(args, 0), yoyo::types::ZIP_ZIP_FILE_TYPE));
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        auto argc = pxs_argc(args);
+        if (argc == 1) {
+            return pxs_newint(static_cast<int64_t>(self->archive->compression));
+        }
+
+        if (argc == 2) {
+            auto level = pxs_getint(pxs_arg(args, 1));
+            if (level < 0 || level > static_cast<int64_t>(Compression::Best)) {
+                return yoyo::utils::exceptions::invalid_enum();
+            }
+            self->archive->compression = static_cast<Compression>(level);
+        }
+
         return pxs_newnull();
     }
 
@@ -145,48 +1185,61 @@ namespace yoyo::zip {
         }
         
         // Get path
-        auto path_arg = pxs_arg(args, 1);
-        if (!pxs_varis(path_arg, pxs_String)) {
-            return utils::exceptions::expected_type(pxs_vartype(path_arg), pxs_String);
-        }
         std::string path;
-        path.resize(pxs_varsize(path_arg) / sizeof(char));
-        pxs_copystring(path_arg, path.data());
+        if (!get_string_arg(args, 1, path)) {
+            return utils::exceptions::expected_type(pxs_vartype(pxs_arg(args, 1)), pxs_String);
+        }
+        auto recursive_arg = pxs_arg(args, 2);
+        bool recursive = pxs_varis(recursive_arg, pxs_Bool) && pxs_getbool(recursive_arg);
 
         // Grab and pass the contents.
-        auto full_contents = self->zf->infolist();
-        pxs_VarT list = pxs_newlist();
-        for (const auto& item : full_contents) {
-            if (path.empty()) {
-                pxs_listadd(list, pxs_newstring(item.filename.c_str()));
-                continue;
-            }
-            // Check starts with.
-            if (item.filename.rfind(path, 0) == 0) {
-                pxs_listadd(list, pxs_newstring(item.filename.c_str()));
-            }
+        std::vector<std::string> items;
+        try {
+            items = self->archive->list(path, recursive);
+        } catch (const std::exception& e) {
+            return pxs_newexception(e.what());
+        }
+        pxs_VarT list = pxs_newlist_with_capacity(items.size());
+        for (const auto& item : items) {
+            pxs_listadd(list, pxs_newstring(item.c_str()));
         }
 
         return list;
     }
 
-    // todo(jordanmc)
     pxs_VarT ZipFile::rmdir(pxs_VarT args) {
         auto self = static_cast<ZipFile*>(pxs_gettype(pxs_getrt(args), pxs_arg(args, 0), yoyo::types::ZIP_ZIP_FILE_TYPE));
         if (!self) {
             return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
         }
-        
+        std::string path;
+        if (!get_string_arg(args, 1, path)) {
+            return utils::exceptions::expected_type(pxs_vartype(pxs_arg(args, 1)), pxs_String);
+        }
+
+        try {
+            self->archive->remove_dir(path);
+        } catch (const std::exception& e) {
+            return pxs_newexception(e.what());
+        }
         return pxs_newnull();
     }
     
-    // todo(jordanmc)
     pxs_VarT ZipFile::rmfile(pxs_VarT args) {
         auto self = static_cast<ZipFile*>(pxs_gettype(pxs_getrt(args), pxs_arg(args, 0), yoyo::types::ZIP_ZIP_FILE_TYPE));
         if (!self) {
             return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
         }
-        
+        std::string path;
+        if (!get_string_arg(args, 1, path)) {
+            return utils::exceptions::expected_type(pxs_vartype(pxs_arg(args, 1)), pxs_String);
+        }
+
+        try {
+            self->archive->remove_file(path);
+        } catch (const std::exception& e) {
+            return pxs_newexception(e.what());
+        }
         return pxs_newnull();
     }
 
@@ -197,106 +1250,206 @@ namespace yoyo::zip {
         }
         
         // Get src_path
-        auto src_path_arg = pxs_arg(args, 1);
-        if (!pxs_varis(src_path_arg, pxs_String)) {
-            return utils::exceptions::expected_type(pxs_vartype(src_path_arg), pxs_String);
-        }
         std::string src_path;
-        src_path.resize(pxs_varsize(src_path_arg) / sizeof(char));
-        pxs_copystring(src_path_arg, src_path.data());
+        if (!get_string_arg(args, 1, src_path)) {
+            return utils::exceptions::expected_type(pxs_vartype(pxs_arg(args, 1)), pxs_String);
+        }
 
         // Get dst_path
-        auto dst_path_arg = pxs_arg(args, 2);
-        if (!pxs_varis(dst_path_arg, pxs_String)) {
-            return utils::exceptions::expected_type(pxs_vartype(dst_path_arg), pxs_String);
-        }
         std::string dst_path;
-        dst_path.resize(pxs_varsize(dst_path_arg) / sizeof(char));
-        pxs_copystring(dst_path_arg, dst_path.data());
-
-        bool is_dir = src_path.back() == '/';
-
-        if (is_dir) {
-            // A full dir
-            auto contents = pxs::call(ZipFile::listdir, {pxs_new_shallowcopy(pxs_arg(args, 0)), src_path});
-            if (!pxs_varis(contents, pxs_List)) {
-                return pxs_newexception("Could not get contents of directory in archive.");
-            }
-            
-            // Loop through and write them
-            for (int i = 0; i < pxs_listlen(contents); i++) {
-                auto item = pxs_listget(contents, i);
-                if (pxs_varis(item, pxs_String)) {
-                    std::string str;
-                    str.resize(pxs_varsize(item) / sizeof(char));
-                    pxs_copystring(item, str.data());
-                    // Get file contents and save them at this (dst + item) path
-                    auto file_contents = self->zf->read(str);
-                    auto path = dst_path + "/" + str;
-                    auto res = pxs::call(fs::write_file, {dst_path, file_contents});
-                    if (pxs_varis(res, pxs_Exception)) {
-                        pxs_freevar(contents);
-                        return res;
-                    }
-                    // free res
-                    pxs_freevar(res);
+        if (!get_string_arg(args, 2, dst_path)) {
+            return utils::exceptions::expected_type(pxs_vartype(pxs_arg(args, 2)), pxs_String);
+        }
+
+        // Get threads
+        size_t threads = 1;
+        auto threads_arg = pxs_arg(args, 3);
+        if (pxs_varis(threads_arg, pxs_Int64) || pxs_varis(threads_arg, pxs_UInt64)) {
+            threads = static_cast<size_t>(std::max<int64_t>(0, pxs_getint(threads_arg)));
+        }
+
+        try {
+            auto archive = self->archive;
+            if (!archive->is_dir(src_path)) {
+                // just a file
+                archive->extract_to(src_path, dst_path);
+                return pxs_newnull();
+            }
+
+            // A full dir, paths are kept relative to it.
+            auto dir = dir_path(src_path);
+            std::filesystem::path dst(dst_path);
+            std::error_code ec;
+            std::filesystem::create_directories(dst, ec);
+            std::vector<std::pair<std::string, std::filesystem::path>> files;
+            for (auto& item : archive->list(dir, true)) {
+                auto target = dst / item.substr(dir.size());
+                if (item.back() == '/') {
+                    std::filesystem::create_directories(target, ec);
+                    continue;
+                }
+                // Implicit directories only show up through their files.
+                if (target.has_parent_path()) {
+                    std::filesystem::create_directories(target.parent_path(), ec);
                 }
+                files.emplace_back(std::move(item), std::move(target));
             }
 
-            pxs_freevar(contents);
-            return pxs_newnull();
-        } else {
-            // just a file
-            auto contents = self->zf->read(src_path);
-            return pxs::call(fs::write_file, {dst_path, contents});
+            if (threads == 1) {
+                for (const auto& [item, target] : files) {
+                    archive->extract_to(item, target);
+                }
+            } else {
+                archive->extract_parallel(files, threads == 0 ? utils::pool::shared().size() : threads);
+            }
+            fs::stat_cache().invalidate(dst_path);
+        } catch (const std::exception& e) {
+            return pxs_newexception(e.what());
         }
+        return pxs_newnull();
+    }
+
+    pxs_VarT ZipFile::save(pxs_VarT args) {
+        auto self = static_cast<ZipFile*>(pxs_gettype(pxs_getrt(args), pxs_arg(args, 0), yoyo::types::ZIP_ZIP_FILE_TYPE));
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        // Get path
+        std::string path;
+        auto path_arg = pxs_arg(args, 1);
+        if (path_arg && !pxs_varis(path_arg, pxs_Null) && !get_string_arg(args, 1, path)) {
+            return utils::exceptions::expected_type(pxs_vartype(path_arg), pxs_String);
+        }
+
+        try {
+            if (!path.empty()) {
+                self->archive->save_as(path);
+            } else if (self->archive->path.empty()) {
+                return pxs_newexception("Expected a path to save an archive in memory to.");
+            } else {
+                self->archive->flush();
+            }
+        } catch (const std::exception& e) {
+            return pxs_newexception(e.what());
+        }
+        return pxs_newnull();
+    }
+
+    pxs_VarT ZipFile::verify(pxs_VarT args) {
+        auto self = static_cast<ZipFile*>(pxs_gettype(pxs_getrt(args), pxs_arg(args, 0), yoyo::types::ZIP_ZIP_FILE_TYPE));
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        // Get threads
+        size_t threads = utils::pool::shared().size();
+        auto threads_arg = pxs_arg(args, 1);
+        if (pxs_varis(threads_arg, pxs_Int64) || pxs_varis(threads_arg, pxs_UInt64)) {
+            auto n = pxs_getint(threads_arg);
+            if (n > 0) {
+                threads = static_cast<size_t>(n);
+            }
+        }
+
+        std::vector<std::string> failed;
+        try {
+            failed = self->archive->verify(threads);
+        } catch (const std::exception& e) {
+            return pxs_newexception(e.what());
+        }
+        pxs_VarT list = pxs_newlist();
+        for (const auto& item : failed) {
+            pxs_listadd(list, pxs_newstring(item.c_str()));
+        }
+        return list;
+    }
+
+    pxs_VarT ZipFile::compact(pxs_VarT args) {
+        auto self = static_cast<ZipFile*>(pxs_gettype(pxs_getrt(args), pxs_arg(args, 0), yoyo::types::ZIP_ZIP_FILE_TYPE));
+        if (!self) {
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
+        }
+
+        try {
+            self->archive->compact();
+        } catch (const std::exception& e) {
+            return pxs_newexception(e.what());
+        }
+        return pxs_newnull();
     }
 
     pxs_VarT open(pxs_VarT args) {
         // Get PD
         auto pd_arg = pxs_arg(args, 0);
-        ZipFile* zf = nullptr;
-        if (pxs_varis(pd_arg, pxs_String)) {
-            // This is a string argument.
-            auto str_c = pxs_getstring(pd_arg);
-            if (!str_c) {
-                return pxs_newexception("pd:string argument is null.");
-            }
-            // Read file bytes.
-            auto contents = pxs::call(fs::read_file, {std::string(str_c), static_cast<int>(fs::FileReadType::Bytes)});
-            pxs_freestr(str_c);
-            // Bubble up.
-            if (pxs_varis(contents, pxs_Exception)) {
-                return contents;
-            } else {
-                // Copy bytes. 
-                std::vector<uint8_t> bytes;
-                pxs_copybytes(contents, static_cast<pxs_Opaque>(bytes.data()));
-                pxs_freevar(contents);
-                zf = new ZipFile{new miniz_cpp::zip_file(bytes)};
-            }
-        } else if (pxs_varis(pd_arg, pxs_List)) {
-            // Its already bytes
-            // Lets read them y listo!
-            std::vector<uint8_t> bytes;
-            pxs_copybytes(pd_arg, static_cast<pxs_Opaque>(bytes.data()));
-            zf = new ZipFile{new miniz_cpp::zip_file(bytes)};
-        } else if (!pd_arg) {
-            // Empty dog.
-            zf = new ZipFile{new miniz_cpp::zip_file()};
+        auto zf = new ZipFile{std::make_shared<Archive>()};
+        try {
+            if (pxs_varis(pd_arg, pxs_String)) {
+                // This is a string argument.
+                size_t str_len = 0;
+                auto str_c = pxs_getstrview(pd_arg, &str_len);
+                if (!str_c) {
+                    delete zf;
+                    return pxs_newexception("pd:string argument is null.");
+                }
+                std::string path(str_c, str_len);
+                // Map it, entries are only inflated when they are read.
+                zf->archive->load_file(path);
+            } else if (pxs_varis(pd_arg, pxs_List)) {
+                // Its already bytes
+                // Lets read them y listo!
+                std::vector<char> bytes(pxs_varsize(pd_arg));
+                pxs_copybytes(pd_arg, static_cast<pxs_Opaque>(bytes.data()));
+                zf->archive->load(std::move(bytes));
+            } else if (pd_arg && !pxs_varis(pd_arg, pxs_Null)) {
+                delete zf;
+                return yoyo::utils::exceptions::expected_types(pxs_vartype(pd_arg), {pxs_String, pxs_List});
+            }
+            // Otherwise empty dog.
+        } catch (const std::exception& e) {
+            delete zf;
+            return pxs_newexception(e.what());
         }
 
+        return zf->topxs();
+    }
+
+    pxs_VarT mount(pxs_VarT args) {
+        auto zf = static_cast<ZipFile*>(pxs_gettype(pxs_getrt(args), pxs_arg(args, 0), yoyo::types::ZIP_ZIP_FILE_TYPE));
         if (!zf) {
-            return pxs_newexception("Could not create ZipFile.");
+            return yoyo::utils::exceptions::expected_self(pxs_arg(args, 0));
         }
-
-        return zf->topxs();
+        mount_archive(zf->archive);
+        return pxs_newnull();
     }
 
     void init(pxs_Module* yoyo) {
+        zip_file_class.emplace("ZipFile", yoyo::types::ZIP_ZIP_FILE_TYPE);
+        zip_file_class->add_method("read", &ZipFile::read);
+    #ifdef PXS_JSON
+        zip_file_class->add_method("read_json", &ZipFile::read_json);
+    #endif
+    #ifdef YOYO_YAML
+        zip_file_class->add_method("read_yaml", &ZipFile::read_yaml);
+    #endif
+        zip_file_class->add_method("write", &ZipFile::write);
+        zip_file_class->add_method("listdir", &ZipFile::listdir);
+        zip_file_class->add_method("rmdir", &ZipFile::rmdir);
+        zip_file_class->add_method("rmfile", &ZipFile::rmfile);
+        zip_file_class->add_method("extract", &ZipFile::extract);
+        zip_file_class->add_method("save", &ZipFile::save);
+        zip_file_class->add_method("compact", &ZipFile::compact);
+        zip_file_class->add_method("verify", &ZipFile::verify);
+        zip_file_class->add_property("compression", &ZipFile::prop_compression);
+
         auto zip_mod = pxs_newmod("zip");
 
         pxs_addfunc(zip_mod, "open", open);
+        pxs_addfunc(zip_mod, "mount", mount);
+        pxs_addvar(zip_mod, "COMPRESSION_STORE", pxs_newint(static_cast<int>(Compression::Store)));
+        pxs_addvar(zip_mod, "COMPRESSION_FAST", pxs_newint(static_cast<int>(Compression::Fast)));
+        pxs_addvar(zip_mod, "COMPRESSION_DEFAULT", pxs_newint(static_cast<int>(Compression::Default)));
+        pxs_addvar(zip_mod, "COMPRESSION_BEST", pxs_newint(static_cast<int>(Compression::Best)));
 
         pxs_add_submod(yoyo, zip_mod);
     }
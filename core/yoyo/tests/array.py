@@ -0,0 +1,50 @@
+from yoyo import array
+
+
+a = array.of(array.F32, [1, 2, 3, 4])
+assert a.len() == 4 and a.kind() == array.F32
+assert a.get(0) == 1.0 and a.get(-1) == 4.0
+
+# Kernels work in place.
+a.add(1)
+assert a.to_list() == [2.0, 3.0, 4.0, 5.0], a.to_list()
+a.mul(array.of(array.F32, [1, 0, 1, 0]))
+assert a.to_list() == [2.0, 0.0, 4.0, 0.0], a.to_list()
+a.axpy(2, array.of(array.F32, [1, 1, 1, 1]))
+assert a.sum() == 10.0 and a.min() == 2.0 and a.max() == 6.0
+a.clamp(2.5, 5)
+assert a.to_list() == [4.0, 2.5, 5.0, 2.5], a.to_list()
+a.lerp(array.zeros(array.F32, 4), 0.5)
+assert a.to_list() == [2.0, 1.25, 2.5, 1.25], a.to_list()
+
+# Gather and scatter take a list or a integer array.
+b = array.of(array.F64, [10, 20, 30, 40, 50])
+assert b.gather([4, 0, -1]).to_list() == [50.0, 10.0, 50.0]
+b.scatter(array.of(array.I32, [0, 2]), 0)
+assert b.to_list() == [0.0, 20.0, 0.0, 40.0, 50.0], b.to_list()
+b.scatter([1, 3], array.of(array.F64, [1, 2]))
+assert b.to_list() == [0.0, 1.0, 0.0, 2.0, 50.0], b.to_list()
+
+try:
+    b.scatter([0, 5], 1)
+    assert False, "scatter out of range should raise"
+except Exception:
+    pass
+assert b.get(0) == 0.0
+
+# Integer arrays round and saturate.
+c = array.of(array.U8, [250, 10])
+c.add(10)
+assert c.to_list() == [255, 20], c.to_list()
+c.mul(-1)
+assert c.to_list() == [0, 0], c.to_list()
+i = array.zeros(array.I32, 3)
+i.fill(2.5)
+assert i.sum() == 9, i.sum()
+
+# Raw bytes round trip.
+raw = array.of(array.I32, [1, -2, 3]).to_bytes()
+assert len(raw) == 12
+assert array.of(array.I32, raw).to_list() == [1, -2, 3]
+
+assert array.zeros(array.F32, 0).min() is None
@@ -0,0 +1,22 @@
+from yoyo import channel
+
+
+ch = channel.new(3)
+assert ch.capacity == 4 and ch.size == 0 and ch.name == ""
+assert ch.try_recv() is None
+
+assert ch.try_send({"a": [1, 2.5, "x"]})
+assert ch.try_recv() == {"a": [1, 2.5, "x"]}
+
+# Stops once full.
+assert ch.send_many(list(range(10))) == 4
+assert not ch.try_send(10)
+assert ch.size == 4
+assert ch.recv_many(3) == [0, 1, 2]
+assert ch.recv_many() == [3]
+
+# Same channel as the host and other runtimes.
+shared = channel.open("_yoyo_test")
+assert shared.name == "_yoyo_test"
+assert shared.try_recv() == 42
+assert shared.try_send(7)
@@ -0,0 +1,46 @@
+from yoyo import compress
+
+
+text = "hello yoyo " * 200
+packed = compress.deflate(text)
+assert len(packed) < len(text)
+assert compress.inflate(packed, True) == text
+assert list(compress.inflate(packed)) == list(text.encode())
+assert compress.gunzip(compress.gzip(text, 9), True) == text
+assert list(compress.inflate(compress.deflate([1, 2, 3], 0))) == [1, 2, 3]
+
+# Streaming, chunk by chunk.
+c = compress.compressor(compress.FORMAT_GZIP, 1)
+out = list(c.write(text[:1000])) + list(c.flush()) + list(c.write(text[1000:])) + list(c.finish())
+assert c.finished
+d = compress.decompressor(compress.FORMAT_GZIP)
+back = []
+for i in range(0, len(out), 100):
+    back += list(d.write(out[i:i + 100]))
+assert d.done
+assert back == list(text.encode())
+
+raw = compress.compressor(compress.FORMAT_RAW)
+data = list(raw.write(text)) + list(raw.finish())
+assert list(compress.decompressor(compress.FORMAT_RAW).write(data)) == list(text.encode())
+
+# Large inputs split into blocks on the worker pool.
+big = "pixelscript " * 400000
+assert compress.inflate(compress.deflate(big, 6, True), True) == big
+assert compress.gunzip(compress.gzip(big, 6, True), True) == big
+
+try:
+    compress.inflate(packed[:10])
+    assert False
+except Exception:
+    pass
+try:
+    compress.deflate(text, 10)
+    assert False
+except Exception:
+    pass
+try:
+    c.write("more")
+    assert False
+except Exception:
+    pass
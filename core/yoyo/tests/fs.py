@@ -0,0 +1,103 @@
+from yoyo import println
+from yoyo import fs
+
+
+path = "_yoyo_fs_test/data.txt"
+
+# Strings and byte lists are written in place.
+fs.write_file(path, "line 1\nline 2\n")
+f = fs.open(path, fs.FILE_OPEN_TYPE_APPEND)
+f.append([108, 105, 110, 101, 32, 51, 10])
+f.close()
+
+text = fs.read_file(path, fs.FILE_READ_TYPE_TEXT)
+assert text == "line 1\nline 2\nline 3\n", text
+
+mapped = fs.read_file(path, fs.FILE_READ_TYPE_MAPPED)
+assert len(mapped) == len(text), mapped
+# A mapped read is a buffer over the mapping and can be written back as is.
+fs.write_file("_yoyo_fs_test/mapped.txt", mapped)
+assert fs.read_file("_yoyo_fs_test/mapped.txt", fs.FILE_READ_TYPE_TEXT) == text
+fs.remove_file("_yoyo_fs_test/mapped.txt")
+# Empty files are mapped to a empty buffer, not another type.
+fs.write_file("_yoyo_fs_test/empty.txt", "")
+empty = fs.read_file("_yoyo_fs_test/empty.txt", fs.FILE_READ_TYPE_MAPPED)
+assert len(empty) == 0 and type(empty) == type(mapped), empty
+fs.remove_file("_yoyo_fs_test/empty.txt")
+
+# Async reads
+handle = fs.read_async(path)
+assert handle.wait() == text
+assert handle.done
+
+# Chunked reads
+f = fs.open(path)
+assert f.readline() == "line 1"
+assert f.tell() == 7
+assert f.read_chunk(4) == "line"
+f.seek(0)
+chunks = []
+chunk = f.read_chunk(5)
+while chunk is not None:
+    chunks.append(chunk)
+    chunk = f.read_chunk(5)
+assert "".join(chunks) == text, chunks
+f.close()
+
+# Directory listing
+entries = fs.scan_dir("_yoyo_fs_test")
+assert len(entries) == 1, entries
+assert entries[0]["name"] == "data.txt", entries
+assert entries[0]["type"] == fs.ENTRY_TYPE_FILE, entries
+assert entries[0]["size"] == len(text), entries
+assert fs.read_dir("_yoyo_fs_test") == ["data.txt"]
+
+# Recursive walk
+fs.write_file("_yoyo_fs_test/sub/a.lua", "return 1")
+walked = fs.walk("_yoyo_fs_test", "*.lua")
+assert [e["path"] for e in walked] == ["sub/a.lua"], walked
+assert len(fs.walk("_yoyo_fs_test")) == 3
+
+# Batch reads
+files = fs.read_files([path, "_yoyo_fs_test/sub/a.lua"])
+assert files[path] == text, files
+assert files["_yoyo_fs_test/sub/a.lua"] == "return 1", files
+
+# Stat cache stays consistent with our own writes.
+fs.cache_stat(60000)
+assert not fs.exists("_yoyo_fs_test/new.txt")
+fs.write_file("_yoyo_fs_test/new.txt", "new")
+assert fs.exists("_yoyo_fs_test/new.txt")
+fs.remove_file("_yoyo_fs_test/new.txt")
+assert not fs.exists("_yoyo_fs_test/new.txt")
+fs.cache_stat(0)
+
+# Streaming JSON, only with pxs_json.
+if hasattr(fs, "read_json"):
+    fs.write_file("_yoyo_fs_test/data.json", '{"mods": [{"name": "a"}, {"name": "b", "tags": ["x"]}], "big": "' + "y" * 200000 + '"}')
+    doc = fs.read_json("_yoyo_fs_test/data.json")
+    assert doc["mods"][1]["name"] == "b"
+    assert len(doc["big"]) == 200000
+    assert fs.read_json("_yoyo_fs_test/data.json", "/mods/1/tags") == ["x"]
+    f = fs.open("_yoyo_fs_test/data.json")
+    assert f.read_json("/mods/0/name") == "a"
+    f.close()
+
+# Watching, changes are coalesced per path.
+watcher = fs.watch("_yoyo_fs_test", {"recursive": True})
+assert watcher.path == "_yoyo_fs_test"
+for i in range(50):
+    fs.write_file("_yoyo_fs_test/watched.txt", str(i))
+fs.write_file("_yoyo_fs_test/gone.txt", "x")
+fs.remove_file("_yoyo_fs_test/gone.txt")
+changes = []
+for _ in range(100000):
+    changes += watcher.poll()
+    if any(c["path"] == "_yoyo_fs_test/watched.txt" for c in changes):
+        break
+watched = [c for c in changes if c["path"] == "_yoyo_fs_test/watched.txt"]
+assert len(watched) == 1 and watched[0]["kind"] == fs.WATCH_EVENT_CREATED, changes
+watcher.close()
+
+fs.remove_dir("_yoyo_fs_test", fs.DIR_REMOVE_TYPE_ALL)
+println("fs ok")
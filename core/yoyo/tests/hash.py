@@ -0,0 +1,46 @@
+from yoyo import hash, fs
+
+
+assert hash.xxh3("") == 0x2D06800538D394C2
+assert hash.xxh3("abc") == 0x78AF5F94892F3950
+assert hash.xxh3("pixelscript", 1) == 0x77C97871C360CB48
+assert hash.xxh128("hello") == "b5e9c1ad071b3e7fc779cfaa5e523818"
+assert hash.crc32("123456789") == 0xCBF43926
+assert hash.crc32("6789", hash.crc32("12345")) == 0xCBF43926
+assert hash.crc32c("123456789") == 0xE3069283
+assert hash.sha256("abc") == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"
+# Byte lists hash like the string.
+assert hash.xxh3([104, 101, 108, 108, 111]) == hash.xxh3("hello")
+
+# Streaming gives the same result as hashing at once.
+data = "pixelscript" * 1000
+for algorithm in [hash.ALGORITHM_XXH3, hash.ALGORITHM_XXH128, hash.ALGORITHM_CRC32, hash.ALGORITHM_CRC32C, hash.ALGORITHM_SHA256]:
+    h = hash.hasher(algorithm)
+    assert h.algorithm == algorithm
+    for i in range(0, len(data), 777):
+        h.update(data[i:i + 777])
+    once = hash.hasher(algorithm)
+    once.update(data)
+    assert h.hexdigest() == once.hexdigest()
+    assert len(h.digest()) * 2 == len(h.hexdigest())
+    h.reset()
+    h.update(data)
+    assert h.hexdigest() == once.hexdigest()
+
+h = hash.hasher(hash.ALGORITHM_XXH3)
+h.update("hello")
+assert h.hexdigest() == "9555e8555c62dcfd"
+h.reset()
+h.update(data)
+
+path = "_yoyo_hash_test.txt"
+fs.write_file(path, data)
+assert hash.hash_file(path) == h.hexdigest()
+assert hash.hash_file(path, hash.ALGORITHM_SHA256) == hash.sha256(data)
+fs.remove_file(path)
+
+try:
+    hash.hasher(99)
+    assert False
+except Exception:
+    pass
@@ -3,4 +3,14 @@ from yoyo import net
 
 
 response = net.client.get("https://jsonplaceholder.typicode.com/todos/1")
-print(response)
\ No newline at end of file
+print(response)
+
+# A server on a free port, the handler runs from `yoyo_pump`.
+def handle(request):
+    return [200, request["method"] + " " + request["path"], {"X-Yoyo": "1"}]
+
+server = net.serve(0, handle)
+server.publish("/metrics", "requests 0\n")
+print(server.port)
+print(server.stats())
+server.close()
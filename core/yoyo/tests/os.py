@@ -0,0 +1,45 @@
+from yoyo import os
+
+
+assert len(os.argv) > 0
+
+cwd = os.get_cwd()
+os.ch_dir("..")
+assert os.get_cwd() != cwd
+os.ch_dir(cwd)
+assert os.get_cwd() == cwd
+
+# Topology, only the CPUs the process may run on.
+logical = os.cpu_count()
+physical = os.cpu_count(True)
+assert logical >= physical >= 1
+topo = os.cpu_topology()
+assert topo["logical"] == logical
+assert topo["physical"] == physical
+assert topo["packages"] >= 1
+assert len(topo["cores"]) == physical
+assert sum(len(core) for core in topo["cores"]) == logical
+
+# Affinity of this thread, macOS refuses.
+allowed = os.get_affinity()
+assert len(allowed) >= 1
+first = topo["cores"][0][0]
+if os.pin_current_thread(first):
+    assert os.get_affinity() == [first]
+    assert os.set_affinity(allowed)
+    assert os.get_affinity() == allowed
+
+# Process stats.
+assert os.rss() > 0
+assert os.peak_rss() >= os.rss()
+times = os.cpu_time()
+assert times["user"] >= 0 and times["system"] >= 0
+
+# Environment.
+assert os.get_env("YOYO_OS_TEST") is None
+assert os.set_env("YOYO_OS_TEST", "pixel")
+assert os.get_env("YOYO_OS_TEST") == "pixel"
+assert os.environ()["YOYO_OS_TEST"] == "pixel"
+assert os.unset_env("YOYO_OS_TEST")
+assert os.get_env("YOYO_OS_TEST") is None
+assert not os.set_env("A=B", "c")
@@ -0,0 +1,12 @@
+from yoyo import net, channel
+
+
+# The host connects to the port over loopback and drives the handler with `yoyo_pump`.
+def handle(request):
+    text = request["method"] + " " + request["path"] + " " + request["query"] + " " + request["body"]
+    return [201, text, {"X-Yoyo": request["headers"].get("x-test", "none"), "Content-Type": "text/x-yoyo"}]
+
+server = net.serve(0, handle)
+assert server.port > 0
+server.publish("/metrics", "requests 0\n")
+assert channel.open("_yoyo_serve").try_send(server.port)
@@ -0,0 +1,39 @@
+from yoyo import shell
+
+
+# Output is captured, stderr apart.
+p = shell.spawn(["sh", "-c", "echo out; echo err >&2; exit 3"])
+assert p.wait() == 3
+assert p.exit_code == 3
+assert p.read() == "out\n"
+assert p.read(shell.PROCESS_STREAM_STDERR) == "err\n"
+assert p.read() is None
+
+# Options
+p = shell.spawn(["sh", "-c", "echo $YOYO_SHELL_TEST; echo oops >&2"], {"env": {"YOYO_SHELL_TEST": "set"}, "merge_stderr": True})
+p.wait()
+assert p.read() == "set\noops\n"
+
+# Chunked reads
+p = shell.spawn(["sh", "-c", "printf abcdef"])
+p.wait()
+assert p.read(shell.PROCESS_STREAM_STDOUT, 4) == "abcd"
+assert list(p.read(shell.PROCESS_STREAM_STDOUT, 4, True)) == [101, 102]
+
+# Timeouts and kill
+p = shell.spawn(["sleep", "5"])
+assert p.wait(10) is None
+assert p.exit_code is None
+p.kill()
+assert p.wait() != 0
+
+try:
+    shell.spawn(["yoyo_not_a_program"])
+    assert False
+except Exception:
+    pass
+
+results = shell.run_many([["sh", "-c", "echo " + str(i)] for i in range(4)] + [["sleep", "5"]], {"timeout": 200})
+assert [r["stdout"] for r in results[:4]] == ["0\n", "1\n", "2\n", "3\n"], results
+assert results[0]["code"] == 0 and not results[0]["timed_out"]
+assert results[4]["timed_out"] and results[4]["code"] is None
@@ -0,0 +1,35 @@
+from yoyo import shm, array
+
+
+a = shm.create("_yoyo_shm_test", 4096)
+assert a.size >= 4096 and a.name == "_yoyo_shm_test"
+# Another mapping of the same region, like a second process would have.
+b = shm.open("_yoyo_shm_test")
+
+a.set(shm.VALUE_TYPE_I32, 8, -5)
+assert b.get(shm.VALUE_TYPE_I32, 8) == -5
+a.set(shm.VALUE_TYPE_U8, 16, 300)
+assert b.get(shm.VALUE_TYPE_U8, 16) == 44
+a.set(shm.VALUE_TYPE_F64, 17, 1.5)
+assert b.get(shm.VALUE_TYPE_F64, 17) == 1.5
+
+a.write(100, "hello")
+assert list(b.read(100, 5)) == list(b"hello")
+view = b.view(100, 5)
+assert len(view) == 5 and view[0] == ord("h")
+
+a.seq_write(0, 200, [1, 2, 3])
+assert list(b.seq_read(0, 200, 3)) == [1, 2, 3]
+assert b.get(shm.VALUE_TYPE_U64, 0) == 2
+
+arr = array.of(array.F32, [1.0, 2.0, 3.0])
+a.write_array(512, arr)
+assert b.read_array(array.F32, 512, 3).to_list() == [1.0, 2.0, 3.0]
+
+try:
+    a.read(4090, 100)
+    assert False
+except Exception:
+    pass
+
+shm.unlink("_yoyo_shm_test")
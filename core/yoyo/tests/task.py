@@ -0,0 +1,19 @@
+from yoyo import fs, pxs, task
+
+
+fs.write_file("_yoyo_task_mod", "return { add = function(a, b) return a + b end, boom = function() error('boom') end }")
+
+# Each runs in a worker's own Lua state.
+tasks = [task.spawn(pxs.LUA, "_yoyo_task_mod", "add", [i, 10]) for i in range(8)]
+assert [t.result() for t in tasks] == list(range(10, 18))
+assert tasks[0].done and tasks[0].join(0)
+
+t = task.spawn(pxs.LUA, "_yoyo_task_mod", "boom")
+assert t.join()
+try:
+    t.result()
+    assert False
+except Exception:
+    pass
+
+fs.remove_file("_yoyo_task_mod")
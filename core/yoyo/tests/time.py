@@ -0,0 +1,25 @@
+from yoyo import time, channel
+
+
+a = time.now_ns()
+b = time.now_ns()
+assert b >= a
+assert time.perf_counter() > 0
+
+sw = time.stopwatch()
+assert sw.running
+sw.stop()
+stopped = sw.elapsed_ns
+assert not sw.running and sw.elapsed_ns == stopped
+sw.start()
+assert sw.restart() >= stopped
+assert sw.elapsed < 1.0
+
+# Fired by the host's pump, which reads them from the channel.
+fired = channel.open("_yoyo_time")
+once = time.after(0, lambda: fired.try_send(1))
+assert once.active
+repeat = time.every(1, lambda: fired.try_send(2))
+cancelled = time.after(0, lambda: fired.try_send(3))
+cancelled.cancel()
+assert not cancelled.active
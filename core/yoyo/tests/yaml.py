@@ -0,0 +1,49 @@
+from yoyo import println
+from yoyo import fs
+from yoyo import yaml
+
+manifest = yaml.load("""
+name: My Mod
+version: 1.2
+id: 3
+enabled: true
+icon: ~
+deps:
+  - core
+  - {id: ui, min: 2}
+base: &base {x: 1}
+copy: *base
+""")
+assert manifest["name"] == "My Mod"
+assert manifest["version"] == 1.2
+assert manifest["id"] == 3
+assert manifest["enabled"] == True
+assert manifest["icon"] is None
+assert manifest["deps"][0] == "core"
+assert manifest["deps"][1]["min"] == 2
+assert manifest["copy"]["x"] == 1
+
+# Only the first document, `load_all` for every one.
+assert yaml.load("a: 1\n---\nb: 2\n") == {"a": 1}
+docs = yaml.load_all("a: 1\n---\nb: 2\n---\n- x\n")
+assert len(docs) == 3, docs
+assert docs[2] == ["x"]
+assert yaml.load("") is None
+
+# Dumps read back the same, strings that look like other things are quoted.
+value = {"text": "a: b # c", "flag": "true", "num": "1.5", "list": [1, 2.5, None, [], {}], "nested": {"k": [{"a": 1}]}}
+text = yaml.dump(value)
+assert yaml.load(text) == value, text
+
+try:
+    yaml.load("a: [1}")
+    assert False, "bad YAML loaded"
+except Exception:
+    pass
+
+fs.write_file("_yoyo_yaml_test/mods.yaml", "name: a\n---\nname: b\n")
+mods = yaml.read_all("_yoyo_yaml_test/mods.yaml")
+assert [mod["name"] for mod in mods] == ["a", "b"], mods
+fs.remove_dir("_yoyo_yaml_test", fs.DIR_REMOVE_TYPE_ALL)
+
+println("yaml ok")
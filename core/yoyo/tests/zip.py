@@ -0,0 +1,84 @@
+from yoyo import println
+from yoyo import fs
+from yoyo import zip as yzip
+
+
+archive = yzip.open()
+archive.write("mods/a/init.lua", "return 'a'")
+archive.write("mods/a/data.txt", "data")
+archive.write("mods/b.lua", "return 'b'")
+archive.write("readme.txt", "hi")
+
+# Lookups go through the index.
+assert archive.read("mods/a/init.lua") == "return 'a'"
+assert archive.read("/readme.txt") == "hi"
+assert archive.listdir("") == ["mods/", "readme.txt"], archive.listdir("")
+assert archive.listdir("mods") == ["mods/a/", "mods/b.lua"], archive.listdir("mods")
+assert len(archive.listdir("/", True)) == 6, archive.listdir("/", True)
+
+# Bytes reads are a buffer over the inflated entry.
+data = archive.read("mods/a/data.txt", fs.FILE_READ_TYPE_BYTES)
+assert len(data) == 4 and data[0] == 100 and data[-1] == 97, data
+
+# Writing a path again replaces it.
+archive.write("readme.txt", "hello")
+assert archive.read("readme.txt") == "hello"
+
+# Compression per write and per archive.
+archive.write("stored.txt", "stored", yzip.COMPRESSION_STORE)
+assert archive.read("stored.txt") == "stored"
+archive.compression = yzip.COMPRESSION_FAST
+assert archive.compression == yzip.COMPRESSION_FAST
+archive.write("fast.txt", "fast " * 100)
+assert archive.read("fast.txt") == "fast " * 100
+archive.rmfile("stored.txt")
+archive.rmfile("fast.txt")
+
+# Every entry matches its CRC.
+assert archive.verify() == []
+
+# Removals
+archive.rmfile("mods/b.lua")
+assert archive.listdir("mods") == ["mods/a/"]
+archive.write("mods/c.lua", "return 'c'")
+assert archive.listdir("mods") == ["mods/a/", "mods/c.lua"]
+
+# Extract keeps paths relative to the directory.
+archive.extract("mods/", "_yoyo_zip_test")
+assert fs.read_file("_yoyo_zip_test/a/init.lua") == "return 'a'"
+assert fs.read_file("_yoyo_zip_test/c.lua") == "return 'c'"
+archive.extract("mods/", "_yoyo_zip_test/par", 0)
+assert fs.read_file("_yoyo_zip_test/par/a/data.txt") == "data"
+archive.extract("readme.txt", "_yoyo_zip_test/readme.txt")
+assert fs.read_file("_yoyo_zip_test/readme.txt") == "hello"
+
+# Streaming JSON, only with pxs_json.
+if hasattr(archive, "read_json"):
+    archive.write("mods/manifest.json", '{"name": "mod", "deps": ["core"]}')
+    assert archive.read_json("mods/manifest.json")["name"] == "mod"
+    assert archive.read_json("mods/manifest.json", "/deps/0") == "core"
+    archive.rmfile("mods/manifest.json")
+
+if hasattr(archive, "read_yaml"):
+    archive.write("mods/manifest.yaml", "name: mod\ndeps: [core]\n---\nname: other\n")
+    docs = archive.read_yaml("mods/manifest.yaml")
+    assert len(docs) == 2, docs
+    assert docs[0]["deps"] == ["core"]
+    assert docs[1]["name"] == "other"
+    archive.rmfile("mods/manifest.yaml")
+
+archive.rmdir("mods")
+assert archive.listdir("") == ["readme.txt"]
+
+# Saving and appending in place.
+archive.save("_yoyo_zip_test/save.zip")
+saved = yzip.open("_yoyo_zip_test/save.zip")
+assert saved.listdir("") == ["readme.txt"]
+saved.write("slot1.txt", "level 1")
+saved.save()
+saved.write("slot1.txt", "level 2")
+saved.compact()
+assert yzip.open("_yoyo_zip_test/save.zip").read("slot1.txt") == "level 2"
+
+fs.remove_dir("_yoyo_zip_test", fs.DIR_REMOVE_TYPE_ALL)
+println("zip ok")
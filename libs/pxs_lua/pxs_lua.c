@@ -1,30 +1,170 @@
 #include "lua.h"
 #include "lauxlib.h"
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
 #include "pxs_lua.h"
 #include "pxs_utils.h"
 
-// C Callback.
-// Push this to lua stack instead of unsafe rust code.
-// This will call the rust code via the bridge uptop.
-// It's up to the bridge to know what function to call. Use upvalues for that.
-int pxslua_callback(lua_State* L) {
-    char* err_buf = NULL;
-    // char* buffer[256] = {0};
-    // char* buffer = (char*)malloc(strlen())
-    // Call the bridge
-    int result = pxslua_rustbridge(L, &err_buf);
-
-    if (result < 0) {
-        if (err_buf == NULL) {
-            lua_pushstring(L, "Unknown error.");
-        } else {
-            lua_pushstring(L, err_buf);
-            pxsutils_freestring(err_buf);
-        }
-        return lua_error(L);
-    }
-
-    // Num returned (1)
-    return result;
-}
\ No newline at end of file
+// A C closure per bridge, no dispatch on a function type. The error message is already a Lua string on the stack.
+#define PXSLUA_CLOSURE(name, bridge)      \
+    int name(lua_State* L) {              \
+        int result = bridge(L);           \
+        if (result < 0) {                 \
+            return lua_error(L);          \
+        }                                 \
+        return result;                    \
+    }
+
+PXSLUA_CLOSURE(pxslua_objectcall, pxslua_objectbridge)
+PXSLUA_CLOSURE(pxslua_modulecall, pxslua_modulebridge)
+PXSLUA_CLOSURE(pxslua_index, pxslua_indexbridge)
+PXSLUA_CLOSURE(pxslua_newindex, pxslua_newindexbridge)
+PXSLUA_CLOSURE(pxslua_moduleloader, pxslua_loaderbridge)
+PXSLUA_CLOSURE(pxslua_hostmodule, pxslua_hostmodulebridge)
+
+// Count hook for execution budgets, raises a error once the budget is spent.
+// Raised here so the longjmp never crosses Rust frames.
+void pxslua_budgethook(lua_State* L, lua_Debug* ar) {
+    (void)ar;
+    if (pxslua_budgetcheck(L)) {
+        luaL_error(L, "Execution budget exceeded");
+    }
+}
+
+// Same as the lauxlib panic, which is static.
+static int pxslua_panic(lua_State* L) {
+    const char* msg = (lua_type(L, -1) == LUA_TSTRING) ? lua_tostring(L, -1) : "error object is not a string";
+    fprintf(stderr, "PANIC: unprotected error in call to Lua API (%s)\n", msg);
+    fflush(stderr);
+    return 0;
+}
+
+// `luaL_newstate` with the allocator `f`, for `pxs_setalloc`.
+lua_State* pxslua_newstate(lua_Alloc f, void* ud) {
+    lua_State* L = lua_newstate(f, ud, luaL_makeseed(NULL));
+    if (L != NULL) {
+        lua_atpanic(L, &pxslua_panic);
+    }
+    return L;
+}
+
+// Metatable name of `pxs_Buffer` userdata.
+#define PXSLUA_BUFFER "pxs_buffer"
+
+// A `pxs_Buffer` in Lua. Points at the host memory, `handle` keeps it alive.
+typedef struct pxslua_Buffer {
+    const unsigned char* data;
+    size_t len;
+    void* handle;
+} pxslua_Buffer;
+
+static int pxslua_buffergc(lua_State* L) {
+    pxslua_Buffer* buffer = (pxslua_Buffer*)luaL_checkudata(L, 1, PXSLUA_BUFFER);
+    if (buffer->handle != NULL) {
+        pxslua_releasebuffer(buffer->handle);
+        buffer->handle = NULL;
+    }
+    return 0;
+}
+
+static int pxslua_bufferlen(lua_State* L) {
+    pxslua_Buffer* buffer = (pxslua_Buffer*)luaL_checkudata(L, 1, PXSLUA_BUFFER);
+    lua_pushinteger(L, (lua_Integer)buffer->len);
+    return 1;
+}
+
+// buffer[i] is the byte at `i` (1 based), nil when out of range.
+static int pxslua_bufferindex(lua_State* L) {
+    pxslua_Buffer* buffer = (pxslua_Buffer*)luaL_checkudata(L, 1, PXSLUA_BUFFER);
+    lua_Integer idx = luaL_checkinteger(L, 2);
+    if (idx < 1 || (size_t)idx > buffer->len) {
+        lua_pushnil(L);
+    } else {
+        lua_pushinteger(L, buffer->data[idx - 1]);
+    }
+    return 1;
+}
+
+// tostring(buffer) copies the bytes into a Lua string, only when asked for.
+static int pxslua_buffertostring(lua_State* L) {
+    pxslua_Buffer* buffer = (pxslua_Buffer*)luaL_checkudata(L, 1, PXSLUA_BUFFER);
+    lua_pushlstring(L, (const char*)buffer->data, buffer->len);
+    return 1;
+}
+
+void pxslua_pushbuffer(lua_State* L, const unsigned char* data, size_t len, void* handle) {
+    pxslua_Buffer* buffer = (pxslua_Buffer*)lua_newuserdatauv(L, sizeof(pxslua_Buffer), 0);
+    buffer->data = data;
+    buffer->len = len;
+    buffer->handle = handle;
+
+    if (luaL_newmetatable(L, PXSLUA_BUFFER)) {
+        lua_pushcfunction(L, &pxslua_buffergc);
+        lua_setfield(L, -2, "__gc");
+        lua_pushcfunction(L, &pxslua_bufferlen);
+        lua_setfield(L, -2, "__len");
+        lua_pushcfunction(L, &pxslua_bufferindex);
+        lua_setfield(L, -2, "__index");
+        lua_pushcfunction(L, &pxslua_buffertostring);
+        lua_setfield(L, -2, "__tostring");
+    }
+    lua_setmetatable(L, -2);
+}
+
+void* pxslua_tobuffer(lua_State* L, int idx) {
+    pxslua_Buffer* buffer = (pxslua_Buffer*)luaL_testudata(L, idx, PXSLUA_BUFFER);
+    return buffer == NULL ? NULL : buffer->handle;
+}
+
+// Metatable name of `pxs_Proxy` userdata.
+#define PXSLUA_PROXY "pxs_proxy"
+
+// A `pxs_Proxy` in Lua, `handle` keeps the host container alive.
+typedef struct pxslua_Proxy {
+    void* handle;
+} pxslua_Proxy;
+
+static int pxslua_proxygc(lua_State* L) {
+    pxslua_Proxy* proxy = (pxslua_Proxy*)luaL_checkudata(L, 1, PXSLUA_PROXY);
+    if (proxy->handle != NULL) {
+        pxslua_releaseproxy(proxy->handle);
+        proxy->handle = NULL;
+    }
+    return 0;
+}
+
+static int pxslua_proxylenmeta(lua_State* L) {
+    pxslua_Proxy* proxy = (pxslua_Proxy*)luaL_checkudata(L, 1, PXSLUA_PROXY);
+    lua_pushinteger(L, (lua_Integer)pxslua_proxylen(proxy->handle));
+    return 1;
+}
+
+// proxy[k] converts only that item, nil when missing. Lists are 1 based.
+static int pxslua_proxyindexmeta(lua_State* L) {
+    pxslua_Proxy* proxy = (pxslua_Proxy*)luaL_checkudata(L, 1, PXSLUA_PROXY);
+    if (!pxslua_proxyindex(L, proxy->handle)) {
+        return luaL_error(L, "Could not convert proxy item");
+    }
+    return 1;
+}
+
+void pxslua_pushproxy(lua_State* L, void* handle) {
+    pxslua_Proxy* proxy = (pxslua_Proxy*)lua_newuserdatauv(L, sizeof(pxslua_Proxy), 0);
+    proxy->handle = handle;
+
+    if (luaL_newmetatable(L, PXSLUA_PROXY)) {
+        lua_pushcfunction(L, &pxslua_proxygc);
+        lua_setfield(L, -2, "__gc");
+        lua_pushcfunction(L, &pxslua_proxylenmeta);
+        lua_setfield(L, -2, "__len");
+        lua_pushcfunction(L, &pxslua_proxyindexmeta);
+        lua_setfield(L, -2, "__index");
+    }
+    lua_setmetatable(L, -2);
+}
+
+void* pxslua_toproxy(lua_State* L, int idx) {
+    pxslua_Proxy* proxy = (pxslua_Proxy*)luaL_testudata(L, idx, PXSLUA_PROXY);
+    return proxy == NULL ? NULL : proxy->handle;
+}
@@ -3,14 +3,66 @@
 
 #include "lua.h"
 
+// Function signatures in Rust, one bridge per kind of host function.
+// Each returns the number of results, or -1 with the error message pushed on the stack.
+int pxslua_objectbridge(lua_State* L);
+int pxslua_modulebridge(lua_State* L);
+int pxslua_indexbridge(lua_State* L);
+int pxslua_newindexbridge(lua_State* L);
+int pxslua_loaderbridge(lua_State* L);
+int pxslua_hostmodulebridge(lua_State* L);
+
+// C closures of the bridges above. Push these to the lua stack instead of unsafe rust code.
+// They raise the pushed error with `lua_error`, so the longjmp never crosses Rust frames.
+// Method of a host object. Upvalue 1: `fn_idx << 8 | flags`.
+int pxslua_objectcall(lua_State* L);
+// Function of a host module. Upvalue 1: `fn_idx`.
+int pxslua_modulecall(lua_State* L);
+// `__index` and `__newindex` of host objects. Upvalues 1-3: the slot tables of the type.
+int pxslua_index(lua_State* L);
+int pxslua_newindex(lua_State* L);
+// Searcher of script modules.
+int pxslua_moduleloader(lua_State* L);
+// `package.preload` stub of a host module. Upvalue 1: the module index.
+int pxslua_hostmodule(lua_State* L);
+
+// Function signature in Rust.
+// Returns non zero once the running call is over its budget.
+int pxslua_budgetcheck(lua_State* L);
+
+// Count hook for execution budgets, raises a error once the budget is spent.
+// Set with `lua_sethook(L, pxslua_budgethook, LUA_MASKCOUNT, step)`.
+void pxslua_budgethook(lua_State* L, lua_Debug* ar);
+
+// `luaL_newstate` with the allocator `f`, for `pxs_setalloc`. No warning function is set.
+lua_State* pxslua_newstate(lua_Alloc f, void* ud);
+
+// Function signature in Rust.
+// Gives back the `handle` of a collected buffer.
+void pxslua_releasebuffer(void* handle);
+
+// Push a `pxs_Buffer` as a userdata reading `data` in place. `handle` is released when Lua collects it.
+void pxslua_pushbuffer(lua_State* L, const unsigned char* data, size_t len, void* handle);
+
+// The handle of the buffer at `idx`, NULL if it is not a buffer.
+void* pxslua_tobuffer(lua_State* L, int idx);
+
+// Function signature in Rust.
+// Gives back the `handle` of a collected proxy.
+void pxslua_releaseproxy(void* handle);
+
 // Function signature in Rust.
-// The state, the string ptr.
-int pxslua_rustbridge(lua_State* L, char** err_buf);
-
-// C Callback.
-// Push this to lua stack instead of unsafe rust code.
-// This will call the rust code via the bridge uptop.
-// It's up to the bridge to know what function to call. Use upvalues for that.
-int pxslua_callback(lua_State* L);
+// Push the item of the proxy `handle` at the key on index 2. Returns 0 when the item could not be converted.
+int pxslua_proxyindex(lua_State* L, void* handle);
+
+// Function signature in Rust.
+// Number of items behind the proxy `handle`.
+size_t pxslua_proxylen(void* handle);
+
+// Push a `pxs_Proxy` as a userdata, items are converted when indexed. `handle` is released when Lua collects it.
+void pxslua_pushproxy(lua_State* L, void* handle);
+
+// The handle of the proxy at `idx`, NULL if it is not a proxy.
+void* pxslua_toproxy(lua_State* L, int idx);
 
 #endif
\ No newline at end of file
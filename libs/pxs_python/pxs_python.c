@@ -42,3 +42,153 @@ char* pxspython_import(const char* file_path, int* data_size) {
     // Now it can be freed via `free`.
     return result;
 }
+
+// A `pxs_Buffer` in pocketpy. Points at the host memory, `handle` keeps it alive.
+typedef struct pxspython_Buffer {
+    unsigned char* data;
+    int len;
+    void* handle;
+} pxspython_Buffer;
+
+static void pxspython_bufferdtor(void* ud) {
+    pxspython_Buffer* buffer = (pxspython_Buffer*)ud;
+    if (buffer->handle != NULL) {
+        pxspython_releasebuffer(buffer->handle);
+        buffer->handle = NULL;
+    }
+}
+
+static bool pxspython_bufferlen(int argc, py_StackRef argv) {
+    PY_CHECK_ARGC(1);
+    pxspython_Buffer* buffer = (pxspython_Buffer*)py_touserdata(py_arg(0));
+    py_newint(py_retval(), buffer->len);
+    return true;
+}
+
+// buffer[i] is the byte at `i`, negative from the end like bytes.
+static bool pxspython_buffergetitem(int argc, py_StackRef argv) {
+    PY_CHECK_ARGC(2);
+    PY_CHECK_ARG_TYPE(1, tp_int);
+    pxspython_Buffer* buffer = (pxspython_Buffer*)py_touserdata(py_arg(0));
+    py_i64 idx = py_toint(py_arg(1));
+    if (idx < 0) {
+        idx += buffer->len;
+    }
+    if (idx < 0 || idx >= buffer->len) {
+        return IndexError("buffer index out of range");
+    }
+    py_newint(py_retval(), buffer->data[idx]);
+    return true;
+}
+
+// Copy the bytes into a `bytes`, only when asked for.
+static bool pxspython_buffertobytes(int argc, py_StackRef argv) {
+    PY_CHECK_ARGC(1);
+    pxspython_Buffer* buffer = (pxspython_Buffer*)py_touserdata(py_arg(0));
+    unsigned char* bytes = py_newbytes(py_retval(), buffer->len);
+    memcpy(bytes, buffer->data, buffer->len);
+    return true;
+}
+
+py_Type pxspython_newbuffertype(void) {
+    py_Type type = py_newtype("pxs_buffer", tp_object, NULL, &pxspython_bufferdtor);
+    py_bindmagic(type, py_name("__len__"), &pxspython_bufferlen);
+    py_bindmagic(type, py_name("__getitem__"), &pxspython_buffergetitem);
+    py_bindmethod(type, "tobytes", &pxspython_buffertobytes);
+    return type;
+}
+
+void pxspython_newbuffer(py_OutRef out, py_Type type, unsigned char* data, int len, void* handle) {
+    pxspython_Buffer* buffer = (pxspython_Buffer*)py_newobject(out, type, 0, sizeof(pxspython_Buffer));
+    buffer->data = data;
+    buffer->len = len;
+    buffer->handle = handle;
+}
+
+void* pxspython_tobuffer(py_Ref ref, py_Type type) {
+    if (!py_istype(ref, type)) {
+        return NULL;
+    }
+    return ((pxspython_Buffer*)py_touserdata(ref))->handle;
+}
+
+// A `pxs_Proxy` in pocketpy, `handle` keeps the host container alive.
+typedef struct pxspython_Proxy {
+    void* handle;
+} pxspython_Proxy;
+
+static void pxspython_proxydtor(void* ud) {
+    pxspython_Proxy* proxy = (pxspython_Proxy*)ud;
+    if (proxy->handle != NULL) {
+        pxspython_releaseproxy(proxy->handle);
+        proxy->handle = NULL;
+    }
+}
+
+static bool pxspython_proxylenmagic(int argc, py_StackRef argv) {
+    PY_CHECK_ARGC(1);
+    pxspython_Proxy* proxy = (pxspython_Proxy*)py_touserdata(py_arg(0));
+    py_newint(py_retval(), pxspython_proxylen(proxy->handle));
+    return true;
+}
+
+// proxy[k] converts only that item. Lists take negative indexes like list.
+static bool pxspython_proxygetitem(int argc, py_StackRef argv) {
+    PY_CHECK_ARGC(2);
+    pxspython_Proxy* proxy = (pxspython_Proxy*)py_touserdata(py_arg(0));
+    // Converting the item can use the stack and `py_retval`.
+    py_Ref item = py_pushtmp();
+    int res = pxspython_proxyget(proxy->handle, py_arg(1), item);
+    if (res == 1) {
+        py_assign(py_retval(), item);
+    }
+    py_pop();
+    if (res == 0) {
+        return KeyError(py_arg(1));
+    }
+    if (res < 0) {
+        return IndexError("proxy index out of range");
+    }
+    return true;
+}
+
+py_Type pxspython_newproxytype(void) {
+    py_Type type = py_newtype("pxs_proxy", tp_object, NULL, &pxspython_proxydtor);
+    py_bindmagic(type, py_name("__len__"), &pxspython_proxylenmagic);
+    py_bindmagic(type, py_name("__getitem__"), &pxspython_proxygetitem);
+    return type;
+}
+
+void pxspython_newproxy(py_OutRef out, py_Type type, void* handle) {
+    pxspython_Proxy* proxy = (pxspython_Proxy*)py_newobject(out, type, 0, sizeof(pxspython_Proxy));
+    proxy->handle = handle;
+}
+
+void* pxspython_toproxy(py_Ref ref, py_Type type) {
+    if (!py_istype(ref, type)) {
+        return NULL;
+    }
+    return ((pxspython_Proxy*)py_touserdata(ref))->handle;
+}
+
+// A host function in pocketpy, only its id. Cheaper than a `function` per callback.
+typedef struct pxspython_HostFunc {
+    int idx;
+} pxspython_HostFunc;
+
+// [self, args...]
+static bool pxspython_hostfunccall(int argc, py_StackRef argv) {
+    pxspython_HostFunc* func = (pxspython_HostFunc*)py_touserdata(py_arg(0));
+    return pxspython_callhost(func->idx, argc - 1, argv + 1);
+}
+
+py_Type pxspython_newhostfunctype(void) {
+    py_Type type = py_newtype("pxs_hostfunc", tp_object, NULL, NULL);
+    py_bindmagic(type, py_name("__call__"), &pxspython_hostfunccall);
+    return type;
+}
+
+void pxspython_newhostfunc(py_OutRef out, py_Type type, int idx) {
+    pxspython_HostFunc* func = (pxspython_HostFunc*)py_newobject(out, type, 0, sizeof(pxspython_HostFunc));
+    func->idx = idx;
+}
@@ -1,6 +1,8 @@
 #ifndef PXS_PYTHON_H
 #define PXS_PYTHON_H
 
+#include "pocketpy.h"
+
 const int PXSPYTHON_IS_DIR = -2;
 const int PXSPYTHON_NOT_FOUND = -1;
 
@@ -9,4 +11,36 @@ int pxspython_importfile(char** buffer, const char* file_path);
 // Override for the pocketpy.callbacks.import function.
 char* pxspython_import(const char* path, int* size);
 
+// Defined in pixelscript:rust code
+// Gives back the `handle` of a collected buffer.
+void pxspython_releasebuffer(void* handle);
+// Make the `pxs_buffer` type in the current VM.
+py_Type pxspython_newbuffertype(void);
+// A `pxs_buffer` reading `data` in place. `handle` is released when the object is collected.
+void pxspython_newbuffer(py_OutRef out, py_Type type, unsigned char* data, int len, void* handle);
+// The handle of a `pxs_buffer`, NULL if `ref` is not one.
+void* pxspython_tobuffer(py_Ref ref, py_Type type);
+
+// Defined in pixelscript:rust code
+// Gives back the `handle` of a collected proxy.
+void pxspython_releaseproxy(void* handle);
+// Number of items behind the proxy `handle`.
+int pxspython_proxylen(void* handle);
+// Set `out` to the item of the proxy `handle` at `key`. 1 when found, 0 for a missing key, -1 for a index out of range.
+int pxspython_proxyget(void* handle, py_Ref key, py_OutRef out);
+// Make the `pxs_proxy` type in the current VM.
+py_Type pxspython_newproxytype(void);
+// A `pxs_proxy` over the host container of `handle`, released when the object is collected.
+void pxspython_newproxy(py_OutRef out, py_Type type, void* handle);
+// The handle of a `pxs_proxy`, NULL if `ref` is not one.
+void* pxspython_toproxy(py_Ref ref, py_Type type);
+
+// Defined in pixelscript:rust code
+// Call host function `idx` with the `argc` args at `argv`, the result goes in `py_retval`.
+bool pxspython_callhost(int idx, int argc, py_StackRef argv);
+// Make the `pxs_hostfunc` type in the current VM.
+py_Type pxspython_newhostfunctype(void);
+// A `pxs_hostfunc` calling host function `idx`. Every one shares the same native `__call__`.
+void pxspython_newhostfunc(py_OutRef out, py_Type type, int idx);
+
 #endif // PXS_PYTHON_H
\ No newline at end of file
@@ -0,0 +1,16 @@
+#ifndef PXS_PYTHON_ALLOC_H
+#define PXS_PYTHON_ALLOC_H
+
+// Included before pocketpy.c so its allocations go through `pxs_setalloc`.
+#include <stdlib.h>
+
+// Defined in pixelscript:rust code
+void* pxspython_malloc(size_t size);
+void* pxspython_realloc(void* ptr, size_t size);
+void pxspython_free(void* ptr);
+
+#define PK_MALLOC(size)             pxspython_malloc(size)
+#define PK_REALLOC(ptr, size)       pxspython_realloc(ptr, size)
+#define PK_FREE(ptr)                pxspython_free(ptr)
+
+#endif // PXS_PYTHON_ALLOC_H
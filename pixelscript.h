@@ -55,6 +55,16 @@ typedef enum pxs_VarType {
    * Holds 1 byte of memory (u8).
    */
   pxs_Byte,
+  /**
+   * Host memory shared with scripts without copying it.
+   * Lua (userdata), Python (pxs_buffer), JS/easyjs (ArrayBuffer)
+   */
+  pxs_Buffer,
+  /**
+   * A List or Map that stays on the host, scripts read its items on demand.
+   * Lua (userdata), Python (pxs_proxy), JS/easyjs (object)
+   */
+  pxs_Proxy,
 } pxs_VarType;
 
 /**
@@ -76,6 +86,56 @@ typedef enum pxs_Runtime {
   pxs_Wren = 3,
 } pxs_Runtime;
 
+/**
+ * The element type of a `pxs_Column`.
+ */
+typedef enum pxs_ColumnType {
+  pxs_ColF32,
+  pxs_ColF64,
+  pxs_ColI32,
+  pxs_ColU32,
+  pxs_ColI64,
+  pxs_ColU8,
+} pxs_ColumnType;
+
+/**
+ * What a trace event is about.
+ */
+typedef enum pxs_TraceKind {
+  /**
+   * `pxs_exec` and `pxs_execobject`, named by the file name (`<object>` for a compiled object).
+   */
+  pxs_TraceExec,
+  /**
+   * `pxs_call` and `pxs_callv`, named by the method.
+   */
+  pxs_TraceCall,
+  /**
+   * A script importing a module file, named by its path. Finding and reading it, Lua and JS compile it here too.
+   */
+  pxs_TraceImport,
+  /**
+   * A garbage collection (`pxs_garbagecollect`, `pxs_gcstep`), named `collect` or `step`. `auto` for one the
+   * runtime ran on its own, see `pxs_gcstats_enable`.
+   */
+  pxs_TraceGC,
+  /**
+   * A script calling a host function, named as in the lookup (`_{module}{name}`).
+   */
+  pxs_TraceHost,
+  /**
+   * A host span from `pxs_tracebegin`/`pxs_traceend`, i.e. a engine frame marker.
+   */
+  pxs_TraceMark,
+} pxs_TraceKind;
+
+/**
+ * An independent set of runtime states (one per language, plus host functions and objects).
+ *
+ * A thread can hold many contexts and switch between them with `pxs_setcontext`.
+ */
+typedef struct pxs_Context pxs_Context;
+
 /**
  * A Factory variable data holder.
  *
@@ -84,6 +144,17 @@ typedef enum pxs_Runtime {
  */
 typedef struct pxs_FactoryHolder pxs_FactoryHolder;
 
+/**
+ * The result of a `pxs_submit` job, set once by the worker that ran it.
+ */
+typedef struct pxs_Future pxs_Future;
+
+/**
+ * A streaming JSON decoder. Text is fed in chunks (`feed`) and the `pxs_Var` tree is built as it goes, so the text
+ * is never held whole. With a JSON pointer only that value is built.
+ */
+typedef struct pxs_JsonStream pxs_JsonStream;
+
 /**
  * A Module is a C representation of data that needs to be (imported,required, etc)
  *
@@ -117,6 +188,24 @@ typedef struct pxs_Module pxs_Module;
  */
 typedef struct pxs_PixelArena pxs_PixelArena;
 
+/**
+ * A PixelScript Class.
+ *
+ * Holds the callbacks of a host type so they are registered once and shared by every instance
+ * created with `pxs_newinstance`, rather than added to each `pxs_PixelObject`.
+ */
+typedef struct pxs_PixelClass pxs_PixelClass;
+
+/**
+ * Runtime sets made ahead of time so threads can skip `pxs_startthread`.
+ */
+typedef struct pxs_RuntimePool pxs_RuntimePool;
+
+/**
+ * Worker threads, each with its own runtime states, running `pxs_submit` jobs.
+ */
+typedef struct pxs_Scheduler pxs_Scheduler;
+
 /**
  * A PixelScript Object.
  *
@@ -184,6 +273,13 @@ typedef struct pxs_PixelArena pxs_PixelArena;
  */
 typedef struct pxs_PixelObject pxs_PixelObject;
 
+/**
+ * A `Buffer` in pixelscript is host memory that vars and script values share. Clones never copy the memory.
+ *
+ * Scripts keep it alive through a handle (`into_handle`), released by the runtime when its value is collected.
+ */
+typedef struct pxs_VarBuffer pxs_VarBuffer;
+
 /**
  * Holds data for a pxs_Var of list.
  *
@@ -230,6 +326,14 @@ typedef struct pxs_VarMap pxs_VarMap;
  */
 typedef struct pxs_VarObject pxs_VarObject;
 
+/**
+ * A `Proxy` in pixelscript is a List or Map kept on the host. Scripts get a view that converts only the items
+ * they read, instead of the whole container when it is passed.
+ *
+ * Like buffers, script values keep the container alive through a handle (`into_handle`). The container is read only.
+ */
+typedef struct pxs_VarProxy pxs_VarProxy;
+
 /**
  * The Variables actual value union.
  */
@@ -247,6 +351,8 @@ typedef union pxs_VarValue {
   struct pxs_FactoryHolder *factory_val;
   struct pxs_VarMap *map_val;
   uint8_t byte_val;
+  struct pxs_VarBuffer *buffer_val;
+  struct pxs_VarProxy *proxy_val;
 } pxs_VarValue;
 
 /**
@@ -307,6 +413,25 @@ typedef struct pxs_Var {
  */
 typedef struct pxs_Var *pxs_VarT;
 
+/**
+ * A host iteration over the pairs of a `pxs_Map` (`pxs_mapiter_begin`/`pxs_mapiter_next`). It lives wherever the
+ * caller puts it (i.e. the stack), so iterating allocates nothing.
+ */
+typedef struct pxs_MapIter {
+  /**
+   * The map being iterated (BORROW).
+   */
+  pxs_VarT map;
+  /**
+   * Position of the next pair.
+   */
+  uintptr_t index;
+  /**
+   * String keys are not stored as `pxs_Var`s, `next` points this at the key text instead. It never owns it.
+   */
+  struct pxs_Var key;
+} pxs_MapIter;
+
 /**
  * Function reference used in C.
  *
@@ -319,8 +444,108 @@ typedef struct pxs_Var *pxs_VarT;
  */
 typedef struct pxs_Var *(*pxs_Func)(struct pxs_Var *args);
 
+/**
+ * Function reference used in C, taking its args as a frame instead of a list.
+ *
+ * rt: *mut pxs_Var, the runtime.
+ * argc: i32, number of args. Not including the runtime.
+ * argv: *mut *mut pxs_Var, the args. Owned by the caller and only valid during the call.
+ *
+ * Same memory rules as `pxs_Func`, do not free `rt` or the `argv` items.
+ */
+typedef struct pxs_Var *(*pxs_FuncV)(struct pxs_Var *rt, int32_t argc, struct pxs_Var **argv);
+
+/**
+ * One function of a `pxs_addfunctable` table.
+ *
+ * name: static storage, kept without a copy.
+ */
+typedef struct pxs_FuncEntry {
+  const char *name;
+  pxs_Func func;
+} pxs_FuncEntry;
+
 typedef void *pxs_Opaque;
 
+/**
+ * One named field of `pxs_newcolumns`. Row `i` is at `data + i * stride`, a `stride` of 0 means packed (a plain
+ * array). Use the struct size as the stride for a field of a array of structs.
+ */
+typedef struct pxs_Column {
+  const char *name;
+  pxs_ColumnType kind;
+  pxs_Opaque data;
+  uintptr_t stride;
+} pxs_Column;
+
+/**
+ * Gets a trace event. `runtime` is a `pxs_Runtime`, -1 for `pxs_TraceMark`. `name` is only valid during the call.
+ * Called on the thread doing the work, which can be any thread.
+ */
+typedef void (*pxs_TraceFn)(pxs_Opaque opaque, pxs_TraceKind kind, int32_t runtime, const char *name);
+
+/**
+ * Callbacks of `pxs_settracer`. A NULL callback is skipped.
+ */
+typedef struct pxs_Tracer {
+  pxs_TraceFn begin;
+  pxs_TraceFn end;
+  pxs_Opaque opaque;
+} pxs_Tracer;
+
+/**
+ * A call or frame that ran too long. The strings are only valid during the callback.
+ */
+typedef struct pxs_SlowCall {
+  /**
+   * A `pxs_Runtime`.
+   */
+  int32_t runtime;
+  /**
+   * As given to `pxs_exec`/`pxs_evalnamed`, `<eval>` for `pxs_eval` and `<object>` for `pxs_execobject`. Empty for
+   * `pxs_call`/`pxs_callv`.
+   */
+  const char *file;
+  /**
+   * The method of `pxs_call`/`pxs_callv`, empty for the others.
+   */
+  const char *function;
+  /**
+   * How long it ran. For a frame all of its calls together.
+   */
+  uint64_t ns;
+  /**
+   * 0 for a call. For a frame the number of calls in it, `runtime`, `file`, `function` and `call_ns` are then its
+   * slowest call.
+   */
+  uint32_t frame_calls;
+  /**
+   * How long the slowest call of a frame ran, the same as `ns` for a call.
+   */
+  uint64_t call_ns;
+} pxs_SlowCall;
+
+/**
+ * Gets a call or frame that ran too long. Called on the thread that made the call, which can be any thread.
+ */
+typedef void (*pxs_SlowFn)(pxs_Opaque opaque, const pxs_SlowCall *call);
+
+/**
+ * Thresholds and callback of `pxs_setwatchdog`. A threshold of 0 is not watched.
+ */
+typedef struct pxs_Watchdog {
+  /**
+   * Report a call that ran this long or longer, in microseconds.
+   */
+  uint64_t call_us;
+  /**
+   * Report a frame whose calls ran this long or longer together, in microseconds.
+   */
+  uint64_t frame_us;
+  pxs_SlowFn slow;
+  pxs_Opaque opaque;
+} pxs_Watchdog;
+
 /**
  * Function Type for Loading a file.
  */
@@ -331,6 +556,45 @@ typedef pxs_VarT (*pxs_LoadFileFn)(const char *file_path);
  */
 typedef pxs_VarT (*pxs_ReadDirFn)(const char *dir_path);
 
+/**
+ * Called once per runtime set in `pxs_pool_create`, while that set is the current threads state.
+ * Add modules here (`pxs_addmod`) like you would after `pxs_startthread`.
+ */
+typedef void (*pxs_PoolSetupFn)(pxs_Opaque opaque);
+
+/**
+ * Allocate `size` bytes (`ptr` is NULL) or resize `ptr` to `size` bytes, like `realloc`.
+ *
+ * Must return memory aligned like `malloc` does (16 bytes on 64 bit), or NULL when out of memory.
+ * `tag` is the one given for the runtime that allocates, see `pxs_setalloctag`.
+ */
+typedef void *(*pxs_AllocFn)(pxs_Opaque tag, void *ptr, uintptr_t size);
+
+/**
+ * Free memory from `pxs_AllocFn`. `ptr` is never NULL.
+ */
+typedef void (*pxs_FreeFn)(pxs_Opaque tag, void *ptr);
+
+/**
+ * How `pxs_initialize_with` brings the runtimes up.
+ */
+typedef struct pxs_InitOptions {
+  /**
+   * Start Lua and JS on threads of their own while Python starts on the calling thread, then move their states to
+   * the calling thread. Startup then takes about as long as the slowest runtime instead of all of them.
+   */
+  bool parallel;
+  /**
+   * Runtimes (bits of `1 << pxs_Runtime`) not started up front, each thread starts them on their first use.
+   */
+  uint32_t deferred;
+} pxs_InitOptions;
+
+/**
+ * A interned name from `pxs_intern`. 0 is never a atom.
+ */
+typedef uint32_t pxs_Atom;
+
 #ifdef __cplusplus
 extern "C" {
 #endif // __cplusplus
@@ -340,11 +604,50 @@ extern "C" {
  */
 uint32_t pxs_version(void);
 
+/**
+ * Allocate through `alloc` instead of the C allocator: Lua, pocketpy and QuickJS, and with the `host_alloc`
+ * feature every Rust side allocation (pxs_Var, strings, ...).
+ *
+ * Only used once `pxs_setfree` is set too. Set both before `pxs_initialize` (before any other call with
+ * `host_alloc`) and never change them, memory must always go back to the allocator it came from.
+ *
+ * `tag` is passed for memory of runtimes without their own tag, and for the Rust side.
+ *
+ * tag:BORROW
+ */
+void pxs_setalloc(pxs_AllocFn alloc, pxs_Opaque tag);
+
+/**
+ * Free through `free`, the pair of `pxs_setalloc`.
+ */
+void pxs_setfree(pxs_FreeFn free);
+
+/**
+ * Give the memory of `runtime` its own tag, i.e. to keep each VM in its own arena.
+ *
+ * Lua and JS states take the tag when they are made (`pxs_initialize`, `pxs_startthread`, ...), Python on every allocation,
+ * so set it before `pxs_initialize`.
+ *
+ * tag:BORROW
+ */
+void pxs_setalloctag(enum pxs_Runtime runtime, pxs_Opaque tag);
+
 /**
  * Initialize the PixelScript runtime.
  */
 void pxs_initialize(void);
 
+/**
+ * Initialize the PixelScript runtime like `pxs_initialize`, with `options` (NULL for the defaults).
+ *
+ * With `parallel` Lua and JS start on threads of their own, so they must not need the calling thread (i.e. no
+ * `pxs_setalloc` hooks bound to it). A `deferred` runtime is only started, per thread, by the first call that goes
+ * to it (`pxs_exec`, `pxs_call`, ...), `pxs_addmod` keeps the modules for it until then.
+ *
+ * options: BORROW, NULLABLE.
+ */
+void pxs_initialize_with(const struct pxs_InitOptions *options);
+
 /**
  * Finalize the PixelScript runtime.
  */
@@ -357,6 +660,21 @@ void pxs_finalize(void);
  */
 pxs_VarT pxs_exec(enum pxs_Runtime runtime, const char *code, const char *file_name);
 
+/**
+ * Reload the script module `name` of `runtime` in the current threads state: its file is read and run again and
+ * `package.loaded` (Lua), `sys.modules` (Python) or what `require` returns (JS) get the new module. Host modules,
+ * functions, objects and every other module are kept. A module not imported yet is loaded.
+ *
+ * Lua copies the new table into the old one and Python runs the new code in the same module object, so scripts
+ * holding the module see the change. ES `import`s in JS stay bound to the first module of a name, only `require`
+ * sees a reload. The file is read from the host even when cached (`pxs_filecache_enable`).
+ *
+ * Null means no error, otherwise error. A failed reload leaves the old module in place (Lua and JS).
+ *
+ * return:OWNED
+ */
+pxs_VarT pxs_reload_module(enum pxs_Runtime runtime, const char *name);
+
 /**
  * Free the string created by the pixelscript library
  *
@@ -380,6 +698,13 @@ struct pxs_Module *pxs_newmod(const char *name);
  */
 void pxs_addfunc(struct pxs_Module *module_ptr, const char *name, pxs_Func func);
 
+/**
+ * Add a callback taking its args as a frame (`rt, argc, argv`) to a module. No args list is created per call.
+ *
+ * module_ptr:BORROW
+ */
+void pxs_addfuncv(struct pxs_Module *module_ptr, const char *name, pxs_FuncV func);
+
 /**
  * Add the same function under different names.
  *
@@ -388,6 +713,15 @@ void pxs_addfunc(struct pxs_Module *module_ptr, const char *name, pxs_Func func)
  */
 void pxs_addfuncs(struct pxs_Module *module_ptr, pxs_VarT func_list, pxs_Func func);
 
+/**
+ * Add `n` functions from a table of `{name, func}` entries, i.e. the static table of a bindings generator. Room is
+ * made once for all of them and the names are kept without a copy.
+ *
+ * module_ptr:BORROW
+ * entries:BORROW, each `name` must be static storage (valid until `pxs_finalize`).
+ */
+void pxs_addfunctable(struct pxs_Module *module_ptr, const struct pxs_FuncEntry *entries, uintptr_t n);
+
 /**
  * Add a Varible to a module.
  *
@@ -415,6 +749,9 @@ void pxs_add_submod(struct pxs_Module *parent_ptr, struct pxs_Module *child_ptr)
  *
  * After this you can forget about the ptr since PM handles it.
  *
+ * Each runtime only keeps a loader stub per module, its functions, variables and submodules are made on the first
+ * `require`/`import` of it.
+ *
  * module_ptr:TRANSFER
  */
 void pxs_addmod(struct pxs_Module *module_ptr);
@@ -483,6 +820,93 @@ void pxs_object_addprop(struct pxs_PixelObject *ptr,
                         const char *name,
                         pxs_Func callback);
 
+/**
+ * Add a plain data property to a object. Scripts read `value` (and with `writable` assign it) on the object without
+ * calling into the host, read it back with `pxs_objectget`. Only scalars: ints, floats, bools, strings and null.
+ *
+ * ptr:BORROW
+ * value:TRANSFER
+ */
+void pxs_object_addfield(struct pxs_PixelObject *ptr, const char *name, pxs_VarT value, bool writable);
+
+/**
+ * Create a new class.
+ *
+ * A class holds the methods and properties of a host type. They are registered once on the class and shared by
+ * every instance created with `pxs_newinstance`. Instead of calling `pxs_object_addfunc` on each object.
+ *
+ * Add all callbacks before creating the first instance. A `type_id` < 0 means no type.
+ *
+ * Free with `pxs_freeclass`. Instances keep the class alive.
+ *
+ * return:OWNED
+ */
+struct pxs_PixelClass *pxs_newclass(const char *type_name, int32_t type_id);
+
+/**
+ * Add a callback to a class.
+ *
+ * class_ptr:BORROW
+ */
+void pxs_class_addfunc(struct pxs_PixelClass *class_ptr, const char *name, pxs_Func callback);
+
+/**
+ * Add a callback taking its args as a frame (`rt, argc, argv`) to a class. `argv[0]` is the object.
+ *
+ * class_ptr:BORROW
+ */
+void pxs_class_addfuncv(struct pxs_PixelClass *class_ptr, const char *name, pxs_FuncV callback);
+
+/**
+ * Add a callback to a class and make it use the language pointer rather than _pxs_ptr idx.
+ *
+ * class_ptr:BORROW
+ */
+void pxs_class_add_reffunc(struct pxs_PixelClass *class_ptr,
+                           const char *name,
+                           pxs_Func callback);
+
+/**
+ * Add a property to a class. The same as `pxs_object_addprop` but for every instance of the class.
+ *
+ * class_ptr:BORROW
+ */
+void pxs_class_addprop(struct pxs_PixelClass *class_ptr, const char *name, pxs_Func callback);
+
+/**
+ * Add a plain data property to a class. The same as `pxs_object_addfield` but every instance starts with its own
+ * copy of `value`.
+ *
+ * class_ptr:BORROW
+ * value:TRANSFER
+ */
+void pxs_class_addfield(struct pxs_PixelClass *class_ptr, const char *name, pxs_VarT value, bool writable);
+
+/**
+ * Create a new instance of a class.
+ *
+ * The same as `pxs_newtype` but the methods and properties come from the class. Do not add callbacks to the
+ * returned object.
+ *
+ * This must be wrapped in a `pxs_newhost` before use within a callback.
+ *
+ * Can return nullptr.
+ *
+ * class_ptr:BORROW
+ * ptr:OWNED
+ * return:OWNED
+ */
+struct pxs_PixelObject *pxs_newinstance(struct pxs_PixelClass *class_ptr,
+                                        pxs_Opaque ptr,
+                                        pxs_DeleterFn free_method);
+
+/**
+ * Free a class. Instances that are still alive keep using it.
+ *
+ * class_ptr:TRANSFER
+ */
+void pxs_freeclass(struct pxs_PixelClass *class_ptr);
+
 /**
  * Add a object constructor to a module. This is the same as calling `pxs_addfunc`. Only named differently to distinguish
  * when a function should be treated as a Object or a Function in your code.
@@ -519,6 +943,25 @@ pxs_VarT pxs_newnull(void);
  */
 pxs_VarT pxs_newhost(struct pxs_PixelObject *pixel_object);
 
+/**
+ * Make a column view: one HostObject giving scripts `count` rows of the named fields in `columns`, read and written
+ * in place. Scripts call `len()`, `fields()`, `get(field, i)`, `set(field, i, value)`, `read(field, start?, count?)`,
+ * `read_bytes(field, start?, count?)`, `write(field, start, values)` and `fill(field, value, start?, count?)`. A field
+ * is a name or a index into `columns`, rows start at 0 in every language.
+ *
+ * The view does not copy the memory. Keep it alive (and in place) until `free(owner)` is called when the view is
+ * collected, make a new view when it moves. On errors `free(owner)` is called right away.
+ *
+ * columns:BORROW
+ * owner:TRANSFER
+ * return:OWNED
+ */
+pxs_VarT pxs_newcolumns(uintptr_t count,
+                        const struct pxs_Column *columns,
+                        uintptr_t ncolumns,
+                        pxs_Opaque owner,
+                        pxs_DeleterFn free);
+
 /**
  * Create a new variable int. (i64)
  *
@@ -626,6 +1069,29 @@ bool pxs_getbool(struct pxs_Var *var);
  */
 char *pxs_getstring(struct pxs_Var *var);
 
+/**
+ * Borrow the string of a `pxs_String` or `pxs_Exception` without copying it.
+ *
+ * The result stays valid as long as `var` is alive and unchanged. Do not free it.
+ *
+ * var:BORROW
+ * len: set to the length in bytes without the nul. Can be null.
+ * return:BORROW&NULLABLE
+ */
+const char *pxs_borrowstring(pxs_VarT var, uintptr_t *len);
+
+/**
+ * View the text of a var without copying it: a `pxs_String` or `pxs_Exception`, or the bytes of a `pxs_Buffer`.
+ *
+ * The result points into the vars own storage and stays valid as long as `var` is alive and unchanged. Do not
+ * free it. Always use `len`, a `pxs_Buffer` is not nul terminated and can hold nul bytes.
+ *
+ * var:BORROW
+ * len: set to the length in bytes, 0 when NULL is returned. Required.
+ * return:BORROW&NULLABLE
+ */
+const char *pxs_getstrview(pxs_VarT var, uintptr_t *len);
+
 /**
  * Check if a variable is of a type.
  *
@@ -647,6 +1113,29 @@ void pxs_set_filereader(pxs_LoadFileFn func);
  */
 void pxs_set_dirreader(pxs_ReadDirFn func);
 
+/**
+ * Cache what the file and dir readers return (or stop). Each path an import tries is then only read once, from any
+ * runtime or thread, found or not, until `pxs_filecache_invalidate`. Setting a reader empties it.
+ * Off by default, when off a read costs one extra flag check.
+ */
+void pxs_filecache_enable(bool enabled);
+
+/**
+ * Mark a file or dir as changed, so the next import reads it again. With a NULL path every cached path is stale,
+ * i.e. call it when mods are reloaded. Returns the cache version, which a NULL path bumps.
+ *
+ * path: BORROW, NULLABLE.
+ */
+uint64_t pxs_filecache_invalidate(const char *path);
+
+/**
+ * Stats of the file cache, as a map with `version`, `files` and `dirs` (paths cached), and `hits`/`misses` (reads
+ * served from it or by the reader).
+ *
+ * return:OWNED
+ */
+pxs_VarT pxs_filecache_stats(void);
+
 /**
  * Free a PixelScript var.
  *
@@ -662,34 +1151,241 @@ void pxs_freevar(struct pxs_Var *var);
 void pxs_startthread(void);
 
 /**
- * Tells PixelScript that we just stopped the most recent thread.
+ * Tells PixelScript that we are in a new thread, like `pxs_startthread`, starting only the runtimes in `mask` (bits
+ * of `1 << pxs_Runtime`) now. The others start on this thread with the first call that goes to them, modules added
+ * for them are kept until then. A worker that only runs Lua passes `1 << pxs_Lua` and never makes the other VMs.
  */
-void pxs_stopthread(void);
+void pxs_startthread_with(uint32_t mask);
 
 /**
- * Clear the current threads state for all languages.
- *
- * Optionally, if you want to run the garbage collector.
+ * Tells PixelScript that we just stopped the most recent thread.
  */
-void pxs_clear(void);
+void pxs_stopthread(void);
 
 /**
- * Call a method within a specifed runtime.
+ * Create a pool of `count` runtime sets, each what `pxs_startthread` would build for a new thread.
  *
- * Runtime is a `pxs_Var`.
+ * `setup` is called once per set while it is the current threads state, add modules there with `pxs_addmod`.
+ * Globals that exist after `setup` are kept, `pxs_pool_release` removes the rest.
  *
- * Transfers ownership of args.
+ * Python has 16 VMs in total (one is the main thread), so at most 15 sets get a Python VM.
  *
- * runtime:BORROW
- * args:TRANSFER
+ * setup:BORROW
+ * opaque:BORROW
  * return:OWNED
  */
-struct pxs_Var *pxs_call(struct pxs_Var *runtime, const char *method, struct pxs_Var *args);
+struct pxs_RuntimePool *pxs_pool_create(uint32_t count, pxs_PoolSetupFn setup, pxs_Opaque opaque);
 
 /**
- * Call a ToString method on this Var. If already a string, it won't call it.
+ * Use a set from `pool` as this threads runtime state, instead of `pxs_startthread`.
  *
- * Host must free this memory with `pxs_free_var`
+ * Returns false when every set is in use or this thread already has one.
+ *
+ * pool:BORROW
+ */
+bool pxs_pool_acquire(struct pxs_RuntimePool *pool);
+
+/**
+ * Give this threads set back to `pool` and restore the state the thread had before `pxs_pool_acquire`.
+ *
+ * Script globals defined since the pool was made are removed, the runtimes themselves are kept.
+ * Free every var that came from this set before releasing it.
+ *
+ * Returns false if this thread does not have a set.
+ *
+ * pool:BORROW
+ */
+bool pxs_pool_release(struct pxs_RuntimePool *pool);
+
+/**
+ * Free a pool and every set in it. Every set must be released first, sets still in use are not freed.
+ *
+ * pool:TRANSFER
+ */
+void pxs_pool_free(struct pxs_RuntimePool *pool);
+
+/**
+ * Create a context: its own runtime state for every language, plus its own host functions and objects.
+ *
+ * `setup` is called once while the new context is the current threads state, add modules there with `pxs_addmod`.
+ * Like a new thread, each context with Python takes one of the 16 Python VMs.
+ *
+ * setup:BORROW
+ * opaque:BORROW
+ * return:OWNED
+ */
+struct pxs_Context *pxs_newcontext(pxs_PoolSetupFn setup, pxs_Opaque opaque);
+
+/**
+ * Make `context` the current threads state, NULL to go back to the threads own state.
+ *
+ * Switching only swaps pointers, nothing is created or cleared. Vars of one context must not be used in another.
+ *
+ * Returns false if `context` is current on another thread, or this thread uses a set from `pxs_pool_acquire`.
+ *
+ * context:BORROW
+ */
+bool pxs_setcontext(struct pxs_Context *context);
+
+/**
+ * Free a context and its runtime states. If it is current on this thread, the thread goes back to its own state first.
+ *
+ * A context that is current on another thread is not freed.
+ *
+ * context:TRANSFER
+ */
+void pxs_freecontext(struct pxs_Context *context);
+
+/**
+ * Create a scheduler with `workers` threads, each with its own runtime states, for `pxs_submit`.
+ *
+ * `setup` is called on every worker thread after `pxs_startthread`, add modules there with `pxs_addmod`.
+ * It runs on several threads at once.
+ *
+ * Python has 16 VMs in total (one is the main thread), so at most 15 workers get a Python VM.
+ *
+ * setup:BORROW
+ * opaque:BORROW
+ * return:OWNED
+ */
+struct pxs_Scheduler *pxs_newscheduler(uint32_t workers, pxs_PoolSetupFn setup, pxs_Opaque opaque);
+
+/**
+ * Run `code` on one of the scheduler's workers. Returns right away with a future for the result.
+ *
+ * The code is compiled once per worker and run like `pxs_execobject`, `args` is its local scope.
+ * `args` must be a `pxs_Map` or null holding only plain data (numbers, strings, bools, lists and maps of those),
+ * and so must the result. Anything else is bound to the thread that made it.
+ *
+ * A exception is reported through the future.
+ *
+ * scheduler:BORROW
+ * args:TRANSFER
+ * return:OWNED
+ */
+struct pxs_Future *pxs_submit(struct pxs_Scheduler *scheduler,
+                              enum pxs_Runtime runtime,
+                              const char *code,
+                              pxs_VarT args);
+
+/**
+ * Has the job of `future` finished?
+ *
+ * future:BORROW
+ */
+bool pxs_future_ready(struct pxs_Future *future);
+
+/**
+ * Block until the job of `future` finished and return its result. The result can only be taken once.
+ *
+ * future:BORROW
+ * return:OWNED
+ */
+pxs_VarT pxs_future_wait(struct pxs_Future *future);
+
+/**
+ * Free a future. The job still runs if it has not yet.
+ *
+ * future:TRANSFER
+ */
+void pxs_freefuture(struct pxs_Future *future);
+
+/**
+ * Free a scheduler. Blocks until the queued jobs ran and the workers stopped.
+ *
+ * scheduler:TRANSFER
+ */
+void pxs_freescheduler(struct pxs_Scheduler *scheduler);
+
+/**
+ * Save the precompiled chunks `runtime` has compiled so far (the core libs, module files and scripts) as a snapshot.
+ *
+ * Call this once initialization and mod bootstrap are done, it also stops recording new chunks. The core
+ * libs and imported modules (`require`, `import`) are still kept in memory, later threads and contexts load them.
+ * Lua chunks are `lua_dump` bytecode, JS modules are `JS_WriteObject` bytecode and Python scripts are serialized code objects.
+ *
+ * Free the result with `pxs_freesnapshot`.
+ *
+ * len:BORROW, set to the size in bytes.
+ * return:OWNED
+ */
+uint8_t *pxs_snapshot_save(enum pxs_Runtime runtime, uintptr_t *len);
+
+/**
+ * Load a snapshot from `pxs_snapshot_save`. Chunks whose source did not change are loaded from bytecode instead of compiled.
+ *
+ * Can be called before `pxs_initialize`, so the core libs come from the snapshot too.
+ * Returns false if the snapshot is not for this runtime or pixelscript version.
+ *
+ * data:BORROW
+ */
+bool pxs_snapshot_load(enum pxs_Runtime runtime, const uint8_t *data, uintptr_t len);
+
+/**
+ * Persist compiled chunks in `dir` so later runs skip compiling sources that did not change. NULL to stop persisting.
+ *
+ * Chunk files are keyed by a hash of the chunk name and source, and files of another pixelscript version are ignored.
+ * Covers `pxs_exec`, `pxs_compile` and module files of Lua and JS, and `pxs_exec` of Python.
+ * The directory must exist, failing to write a chunk file only means it gets compiled again.
+ *
+ * dir:BORROW
+ */
+void pxs_set_cachedir(const char *dir);
+
+/**
+ * Free a snapshot from `pxs_snapshot_save`.
+ *
+ * data:TRANSFER
+ */
+void pxs_freesnapshot(uint8_t *data, uintptr_t len);
+
+/**
+ * Limit every call into `runtime` made on the current thread. 0 means no limit, both 0 removes the budget.
+ *
+ * A call that runs over (pxs_exec, pxs_call, pxs_objectcall, pxs_eval, ...) is stopped and returns an exception.
+ * Calls made from inside a budgeted call (i.e. a host callback calling back into the script) share its budget.
+ *
+ * `instructions` is counted in steps of the VM (1000 in Lua, about 10000 in JS) and is not supported in Python.
+ * `millis` is wall time in Lua and JS, and CPU time in Python.
+ */
+void pxs_setbudget(enum pxs_Runtime runtime, uint64_t instructions, uint64_t millis);
+
+/**
+ * Clear the current threads state for all languages.
+ *
+ * Optionally, if you want to run the garbage collector.
+ */
+void pxs_clear(void);
+
+/**
+ * Call a method within a specifed runtime.
+ *
+ * Runtime is a `pxs_Var`.
+ *
+ * Transfers ownership of args.
+ *
+ * runtime:BORROW
+ * args:TRANSFER
+ * return:OWNED
+ */
+struct pxs_Var *pxs_call(struct pxs_Var *runtime, const char *method, struct pxs_Var *args);
+
+/**
+ * Call a method within a specifed runtime with `argc` args from `argv`. The same as `pxs_call` without building a
+ * list first.
+ *
+ * Transfers ownership of the items in `argv`, the array itself stays with the caller (i.e. on the stack).
+ *
+ * runtime:BORROW
+ * argv:TRANSFER
+ * return:OWNED
+ */
+struct pxs_Var *pxs_callv(struct pxs_Var *runtime, const char *method, int32_t argc, pxs_VarT *argv);
+
+/**
+ * Call a ToString method on this Var. If already a string, it won't call it.
+ *
+ * Host must free this memory with `pxs_free_var`
  *
  * runtime_var:BORROW
  * var:BORROW
@@ -706,6 +1402,13 @@ struct pxs_Var *pxs_tostring(struct pxs_Var *runtime_var, struct pxs_Var *var);
  */
 struct pxs_Var *pxs_newlist(void);
 
+/**
+ * Create a new empty pxs_VarList with room for `capacity` items, so adding them does not reallocate.
+ *
+ * return:OWNED
+ */
+pxs_VarT pxs_newlist_with_capacity(uintptr_t capacity);
+
 /**
  * Add a item to a pxs_VarList.
  *
@@ -759,6 +1462,53 @@ bool pxs_listset(struct pxs_Var *list,
  */
 int32_t pxs_listlen(struct pxs_Var *list);
 
+/**
+ * The items of a `pxs_List` as one contiguous array, without a call per item: `span[i]` is item `i` and `&span[i]`
+ * its `pxs_VarT`. `len` is set to the number of items.
+ *
+ * The span is valid until the list changes. NULL (and a `len` of 0) for a empty list or a var that is not a list.
+ *
+ * list:BORROW
+ * return:BORROW
+ */
+pxs_VarT pxs_listspan(pxs_VarT list, uintptr_t *len);
+
+/**
+ * Create a new pxs_VarList of `len` ints in one call.
+ *
+ * values:BORROW
+ * return:OWNED
+ */
+pxs_VarT pxs_newlist_i64(const int64_t *values, uintptr_t len);
+
+/**
+ * Create a new pxs_VarList of `len` floats in one call.
+ *
+ * values:BORROW
+ * return:OWNED
+ */
+pxs_VarT pxs_newlist_f64(const double *values, uintptr_t len);
+
+/**
+ * Copy up to `len` items of a pxs_VarList into `out` as ints. Converts like `pxs_getint`.
+ *
+ * Stops at the first item that is not a number. Returns the number of items copied, -1 if `list` is not a list.
+ *
+ * list:BORROW
+ * out:BORROW
+ */
+int32_t pxs_list_copy_i64(pxs_VarT list, int64_t *out, uintptr_t len);
+
+/**
+ * Copy up to `len` items of a pxs_VarList into `out` as floats. Converts like `pxs_getfloat`.
+ *
+ * Stops at the first item that is not a number. Returns the number of items copied, -1 if `list` is not a list.
+ *
+ * list:BORROW
+ * out:BORROW
+ */
+int32_t pxs_list_copy_f64(pxs_VarT list, double *out, uintptr_t len);
+
 /**
  * Call a `pxs_Var`s function.
  *
@@ -775,9 +1525,57 @@ struct pxs_Var *pxs_varcall(struct pxs_Var *runtime,
                             struct pxs_Var *var_func,
                             struct pxs_Var *args);
 
+/**
+ * Call a `pxs_Var`s function with `argc` args from `argv`. The same as `pxs_varcall` without building a list first.
+ *
+ * Transfers ownership of the items in `argv`, the array itself stays with the caller (i.e. on the stack).
+ *
+ * runtime:BORROW
+ * var_func:BORROW
+ * argv:TRANSFER
+ * return:OWNED
+ */
+struct pxs_Var *pxs_varcallv(struct pxs_Var *runtime,
+                             struct pxs_Var *var_func,
+                             int32_t argc,
+                             pxs_VarT *argv);
+
+/**
+ * Call `var_func` with every args list in `batches` (a List of Lists), i.e. `score(entity)` over many entities.
+ *
+ * The function is converted and the runtime entered once, and conversion scratch is reused between calls.
+ * Returns a List with one result per args list, a failed call (or a args item that is not a List) is a exception in its slot.
+ *
+ * runtime:BORROW
+ * var_func:BORROW
+ * batches:TRANSFER
+ * return:OWNED
+ */
+pxs_VarT pxs_callbatch(pxs_VarT runtime, pxs_VarT var_func, pxs_VarT batches);
+
+/**
+ * Column oriented `pxs_callbatch`. Row `i` calls `var_func(columns[0][i], columns[1][i], ...)` and writes the result to `out[i]`.
+ *
+ * `columns` holds `ncolumns` arrays of `rows` floats each. Results that are not numbers are written as NaN.
+ * Returns how many rows produced a number, or -1 when a param is null.
+ *
+ * runtime:BORROW
+ * var_func:BORROW
+ * columns:BORROW
+ * out:BORROW
+ */
+int32_t pxs_callbatch_f64(pxs_VarT runtime,
+                          pxs_VarT var_func,
+                          const double *const *columns,
+                          uintptr_t ncolumns,
+                          uintptr_t rows,
+                          double *out);
+
 /**
  * Copy the pxs_Var.
  *
+ * Lists and Maps are copy on write: the copy shares the items until either side changes, so copying is O(1).
+ *
  * Memory is handled by caller
  *
  * item:BORROW
@@ -805,6 +1603,51 @@ pxs_VarT pxs_objectget(pxs_VarT runtime, pxs_VarT obj, const char *key);
  */
 bool pxs_objectset(pxs_VarT runtime, pxs_VarT obj, const char *key, pxs_VarT value);
 
+/**
+ * Intern `name`, returns a atom that stands for it in `pxs_objectget_atom` and `pxs_objectset_atom`.
+ *
+ * The same name always gives the same atom, on every thread and for every runtime. Atoms are never freed, so intern
+ * property names once (i.e. at startup) and keep the atom instead of passing the name on every access.
+ * Returns 0 when `name` is NULL.
+ */
+pxs_Atom pxs_intern(const char *name);
+
+/**
+ * The name of a atom from `pxs_intern`. NULL for unknown atoms.
+ *
+ * return:BORROW
+ */
+const char *pxs_atomname(pxs_Atom atom);
+
+/**
+ * `pxs_objectget` with a atom from `pxs_intern`. JS looks the property up by its own cached atom.
+ *
+ * runtime:BORROW
+ * obj:BORROW
+ * return:OWNED
+ */
+pxs_VarT pxs_objectget_atom(pxs_VarT runtime, pxs_VarT obj, pxs_Atom key);
+
+/**
+ * `pxs_objectset` with a atom from `pxs_intern`.
+ *
+ * runtime:BORROW
+ * obj:BORROW
+ * value:TRANSFER
+ */
+bool pxs_objectset_atom(pxs_VarT runtime, pxs_VarT obj, pxs_Atom key, pxs_VarT value);
+
+/**
+ * The key value pairs of a script object (`pxs_Object`, i.e. a Lua table, Python dict or JS object) as a
+ * `pxs_List` of `[key, value]` lists, in the order the runtime iterates them.
+ * Returns a exception when `obj` is not a object of `runtime`.
+ *
+ * runtime:BORROW
+ * obj:BORROW
+ * return:OWNED
+ */
+pxs_VarT pxs_objectentries(pxs_VarT runtime, pxs_VarT obj);
+
 /**
  * Evaluate code. This will return a `pxs_VarT`.
  *
@@ -885,6 +1728,20 @@ pxs_VarT pxs_newexception(const char *msg);
  */
 pxs_VarT pxs_var_fromname(pxs_VarT rt, const char *name);
 
+/**
+ * Resolve a function by name once, for calling it many times with `pxs_varcall`/`pxs_varcallv`.
+ *
+ * The handle keeps a reference to the function inside the runtime (registry ref in Lua, a ref in Python and JS)
+ * so calls skip the name lookup. The handle stays valid until it is freed with `pxs_freevar`,
+ * which must happen before `pxs_finalize`.
+ *
+ * Returns a exception if `name` does not exist or is not a function.
+ *
+ * rt:BORROW
+ * return:OWNED
+ */
+pxs_VarT pxs_getfunc(pxs_VarT rt, const char *name);
+
 /**
  * Remove a item from a list at a specific index.
  *
@@ -944,6 +1801,16 @@ pxs_VarT pxs_execobject(pxs_VarT object, pxs_VarT local);
  */
 pxs_VarT pxs_newmap(void);
 
+/**
+ * Create a new `pxs_Map` that keeps the insertion order of its keys when one is removed.
+ *
+ * Every map iterates in insertion order until a key is removed, a plain map then moves its last pair into the gap.
+ * Removing from this one shifts the pairs after it instead, which is O(n).
+ *
+ * return:OWNED
+ */
+pxs_VarT pxs_newmap_ordered(void);
+
 /**
  * Add a new key (`pxs_Var`) value (`pxs_Var`) pair in a map.
  *
@@ -989,6 +1856,32 @@ int32_t pxs_maplen(pxs_VarT map);
  */
 pxs_VarT pxs_mapkeys(pxs_VarT map);
 
+/**
+ * Start iterating the pairs of a `pxs_Map` in order, without copying the keys like `pxs_mapkeys` does. `iter` is
+ * filled in by this call, it can live on the stack:
+ * ```c
+ * pxs_MapIter iter;
+ * pxs_VarT key, value;
+ * pxs_mapiter_begin(map, &iter);
+ * while (pxs_mapiter_next(&iter, &key, &value)) { ... }
+ * ```
+ * Do not change the map while iterating. Returns false (and `next` yields nothing) if `map` is not a `pxs_Map`.
+ *
+ * map:BORROW
+ */
+bool pxs_mapiter_begin(pxs_VarT map, struct pxs_MapIter *iter);
+
+/**
+ * The next pair of a `pxs_mapiter_begin` iteration. False when there are no more.
+ *
+ * `key` and `value` are borrowed from the map. A string key is valid until the next call, copy it
+ * (`pxs_getstring`/`pxs_newcopy`) to keep it.
+ *
+ * key:BORROW
+ * value:BORROW
+ */
+bool pxs_mapiter_next(struct pxs_MapIter *iter, pxs_VarT *key, pxs_VarT *value);
+
 /**
  * Get a value in a map from a key.
  *
@@ -1001,42 +1894,131 @@ pxs_VarT pxs_mapkeys(pxs_VarT map);
 pxs_VarT pxs_mapget(pxs_VarT map, pxs_VarT key);
 
 /**
- * Insert a item into a list at a certain index, shifting all other items to the right.
- *
- * Item ownership is transferred.
+ * Create a new `pxs_Map` from `len` string keys and ints in one call. Null keys are skipped.
  *
- * list:BORROW
- * item:TRANSFER
+ * keys:BORROW
+ * values:BORROW
+ * return:OWNED
  */
-void pxs_listinsert(pxs_VarT list, uintptr_t index, pxs_VarT item);
+pxs_VarT pxs_newmap_i64(const char *const *keys, const int64_t *values, uintptr_t len);
 
 /**
- * Create a new arena in memory.
- * This does not return anything, it simply creates a scope that will allocate pxs_Var memory.
- * when finished call, `pxs_freearena`
+ * Create a new `pxs_Map` from `len` string keys and floats in one call. Null keys are skipped.
  *
- * result:OWNED
+ * keys:BORROW
+ * values:BORROW
+ * return:OWNED
  */
-struct pxs_PixelArena *pxs_newarena(void);
+pxs_VarT pxs_newmap_f64(const char *const *keys, const double *values, uintptr_t len);
 
 /**
- * Free arena. Upon freeing all variables allocated since `pxs_newarena` will be freed.
+ * Copy up to `len` pairs of a `pxs_Map` with string keys and number values into `keys` and `values` as ints.
+ * Other pairs are skipped. Use `pxs_maplen` to size the buffers.
  *
- * arena:TRANSFER
+ * The keys are borrowed from the map and valid until it changes. Returns the number of pairs copied, -1 if `map` is
+ * not a map.
+ *
+ * map:BORROW
+ * keys:BORROW
+ * values:BORROW
  */
-void pxs_freearena(struct pxs_PixelArena *arena);
+int32_t pxs_map_copy_i64(pxs_VarT map, const char **keys, int64_t *values, uintptr_t len);
 
 /**
- * Add a `pxs_VarT` to a `pxs_PixelArena`. Upon freeing the Arena, the variable is freed aswell.
+ * Copy up to `len` pairs of a `pxs_Map` with string keys and number values into `keys` and `values` as floats.
+ * Other pairs are skipped. Use `pxs_maplen` to size the buffers.
  *
- * A variable must only be added once.
+ * The keys are borrowed from the map and valid until it changes. Returns the number of pairs copied, -1 if `map` is
+ * not a map.
  *
- * arena:BORROW
- * var:TRANSFER
+ * map:BORROW
+ * keys:BORROW
+ * values:BORROW
+ */
+int32_t pxs_map_copy_f64(pxs_VarT map, const char **keys, double *values, uintptr_t len);
+
+/**
+ * Insert a item into a list at a certain index, shifting all other items to the right.
+ *
+ * Item ownership is transferred.
+ *
+ * list:BORROW
+ * item:TRANSFER
+ */
+void pxs_listinsert(pxs_VarT list, uintptr_t index, pxs_VarT item);
+
+/**
+ * Move all items of `other` to the end of `list` in one call. `other` is freed, and can be `list` itself
+ * (the items are then copied). False if either is not a list.
+ *
+ * list:BORROW
+ * other:TRANSFER
+ */
+bool pxs_listextend(pxs_VarT list, pxs_VarT other);
+
+/**
+ * Remove `count` items at `start` and insert the items of `items` in their place, shifting the rest once.
+ * `items` can be NULL to only remove, and is freed. `count` stops at the end of the list.
+ *
+ * False if `start` is past the end, or `list`/`items` is not a list.
+ *
+ * list:BORROW
+ * items:TRANSFER
+ */
+bool pxs_listsplice(pxs_VarT list, uintptr_t start, uintptr_t count, pxs_VarT items);
+
+/**
+ * Remove every item of a list. Its memory is kept for new items.
+ *
+ * list:BORROW
+ */
+void pxs_listclear(pxs_VarT list);
+
+/**
+ * Make room in a list for `additional` more items, so adding them does not reallocate.
+ *
+ * list:BORROW
+ */
+void pxs_listreserve(pxs_VarT list, uintptr_t additional);
+
+/**
+ * Create a new arena in memory.
+ * This does not return anything, it simply creates a scope that will allocate pxs_Var memory.
+ * when finished call, `pxs_freearena`
+ *
+ * result:OWNED
+ */
+struct pxs_PixelArena *pxs_newarena(void);
+
+/**
+ * Free arena. Upon freeing all variables allocated since `pxs_newarena` will be freed.
+ *
+ * arena:TRANSFER
+ */
+void pxs_freearena(struct pxs_PixelArena *arena);
+
+/**
+ * Add a `pxs_VarT` to a `pxs_PixelArena`. Upon freeing the Arena, the variable is freed aswell.
+ *
+ * A variable must only be added once.
+ *
+ * arena:BORROW
+ * var:TRANSFER
  * result:BORROW
  */
 pxs_VarT pxs_arenaput(struct pxs_PixelArena *arena, pxs_VarT var);
 
+/**
+ * Take a `pxs_VarT` back out of a `pxs_PixelArena`. It is no longer freed with the arena.
+ *
+ * Returns NULL if `var` is not in the arena.
+ *
+ * arena:BORROW
+ * var:BORROW
+ * result:OWNED
+ */
+pxs_VarT pxs_arenatake(struct pxs_PixelArena *arena, pxs_VarT var);
+
 /**
  * Add a `char*` to a `pxs_PixelArena`. Upon freeing the Arena, the string is freed aswell.
  *
@@ -1053,6 +2035,27 @@ pxs_VarT pxs_arenaput(struct pxs_PixelArena *arena, pxs_VarT var);
  */
 char *pxs_arena_putstr(struct pxs_PixelArena *arena, char *str);
 
+/**
+ * Copy `str` into a `pxs_PixelArena`. The copy is carved from the arenas own memory and is freed with it.
+ *
+ * Do not free the result, it lives until `pxs_arenareset` or `pxs_freearena`.
+ *
+ * arena:BORROW
+ * str:BORROW
+ * result:BORROW
+ */
+char *pxs_arena_newstr(struct pxs_PixelArena *arena, const char *str);
+
+/**
+ * Free everything in a `pxs_PixelArena` but keep the arena for reuse.
+ *
+ * Strings from `pxs_arena_newstr` reuse the same memory afterwards, and freed vars are kept for the next `pxs_new*` calls
+ * of this thread instead of going back to the allocator. Cheaper than a `pxs_freearena` + `pxs_newarena` per frame.
+ *
+ * arena:BORROW
+ */
+void pxs_arenareset(struct pxs_PixelArena *arena);
+
 /**
  * Debug state info.
  *
@@ -1060,11 +2063,294 @@ char *pxs_arena_putstr(struct pxs_PixelArena *arena, char *str);
  */
 char *pxs_debugstate(enum pxs_Runtime runtime);
 
+/**
+ * Numbers of the current threads `runtime` state, as a flat map of ints for dashboards (`pxs_debugstate` is for
+ * people). Every runtime has:
+ * - `bytes`, `peak`, `limit`, `gc_cycles`: as in `pxs_memstats`
+ * - `vars`: pxs_Vars alive on this thread (all runtimes)
+ * - `host_objects`: host objects in this threads lookup (all runtimes)
+ * - `functions`: host functions in this threads lookup (all runtimes)
+ * - `gc_full`, `gc_steps`, `gc_auto`, `gc_pause_ns`, `gc_max_pause_ns`, `gc_reclaimed`: collections on this thread,
+ *   as in `pxs_gcstats` (`gc_auto` only counts while `pxs_gcstats_enable` is on)
+ *
+ * Lua adds `stack_depth` (Lua calls running), `stack_top`, `registry_size` and `globals`. JS adds
+ * `defined_objects`, `modules` (imported host modules), `lazy_modules` (not imported yet) and every
+ * `JS_ComputeMemoryUsage` field (i.e. `obj_count`, `malloc_size`). Python adds `vm`, `vms_active`,
+ * `defined_objects` and `objects_collected` (pocketpy keeps its heap counts private).
+ *
+ * Counting Lua tables walks them, cheap for a scrape every few seconds but not for every frame.
+ *
+ * return:OWNED
+ */
+pxs_VarT pxs_runtimestats(pxs_Runtime runtime);
+
+/**
+ * What changed between two stats maps (i.e. two `pxs_runtimestats`, `pxs_memstats` or `pxs_funcstats`): every
+ * number in `after` minus the same key in `before` (0 when missing there), nested maps diffed the same way. Other
+ * values are left out.
+ *
+ * before: BORROW
+ * after: BORROW
+ * return:OWNED
+ */
+pxs_VarT pxs_statsdiff(pxs_VarT before, pxs_VarT after);
+
+/**
+ * Memory of the current threads `runtime` state, as a map with:
+ * - `bytes`: allocated right now
+ * - `peak`: most bytes at once
+ * - `limit`: from `pxs_setmemlimit`, 0 for none
+ * - `gc_cycles`: full collections run through `pxs_garbagecollect` or finished by `pxs_gcstep`
+ * - `vars`: pxs_Vars alive on this thread (all runtimes)
+ * - `objects`: host objects in this threads lookup (all runtimes)
+ *
+ * Python memory is counted per VM, and includes what pocketpy keeps in its own pools.
+ *
+ * return:OWNED
+ */
+pxs_VarT pxs_memstats(enum pxs_Runtime runtime);
+
+/**
+ * Limit the memory of the current threads `runtime` state to `bytes`, 0 for no limit.
+ *
+ * An allocation over the limit fails in the script that made it (a Lua memory error, a JS out of memory error),
+ * the state stays usable. Lower than what the state holds only stops it from growing.
+ *
+ * Returns false for Python, pocketpy can not survive a failed allocation.
+ */
+bool pxs_setmemlimit(enum pxs_Runtime runtime, uintptr_t bytes);
+
 /**
  * Call GC for all backends.
  */
 void pxs_garbagecollect(void);
 
+/**
+ * Do about `budget_us` microseconds of collection work in the current threads `runtime` state, at least one step.
+ *
+ * Returns true when a full cycle finished. Lua steps its incremental collector until the budget is spent.
+ * QuickJS frees most memory by reference count and its cycle collector is not incremental, so a step only collects
+ * once memory grew enough that QuickJS would have. pocketpy only has a full collection, which every step runs.
+ */
+bool pxs_gcstep(enum pxs_Runtime runtime, uint64_t budget_us);
+
+/**
+ * Let the current threads `runtime` state collect garbage on its own (the default), or only through
+ * `pxs_gcstep` and `pxs_garbagecollect` so the host decides when it pays for it.
+ */
+void pxs_setautogc(enum pxs_Runtime runtime, bool enabled);
+
+/**
+ * Log every garbage collection from now on (or stop logging), and watch the ones runtimes run on their own in the
+ * states of this thread and the ones made later. Off by default. Logged collections are kept when turned off, until
+ * `pxs_gcstats_reset`.
+ *
+ * Automatic collections show up in `pxs_settracer` as `pxs_TraceGC` events named `auto`. pocketpy reports both
+ * ends of a collection so they are timed. Lua (collecting in steps inside allocations) and QuickJS (collecting inside
+ * a allocation) are only seen once they are over: a begin and end right after each other, and `ns` of -1 in the
+ * log. QuickJS ones are looked for after every `pxs_exec`/`pxs_call`. Turn automatic collection off
+ * (`pxs_setautogc`) and use `pxs_gcstep` to have every pause timed.
+ */
+void pxs_gcstats_enable(bool enabled);
+
+/**
+ * The collections logged while `pxs_gcstats_enable` was on, from every thread, as a map with:
+ * - `runtimes`: by runtime (`lua`, `python`, `js`), `full` (`pxs_garbagecollect`), `steps` (`pxs_gcstep`) and
+ *   `auto` counts, `pause_ns` and `max_pause_ns` of the timed ones, and `reclaimed` bytes
+ * - `events`: the last 1024, oldest first, each with `runtime`, `kind` (`full`, `step` or `auto`), `start_us` (on the
+ *   clock of `pxs_tracewriter_stop`), `ns` (-1 when not timed), `reclaimed` and `bytes` left in use
+ * - `dropped`: events that did not fit
+ *
+ * `pxs_runtimestats` has the same totals for the state of the current thread, always counted.
+ *
+ * return:OWNED
+ */
+pxs_VarT pxs_gcstats(void);
+
+/**
+ * Forget the log of `pxs_gcstats`.
+ */
+void pxs_gcstats_reset(void);
+
+/**
+ * Tag the pxs_Vars this thread hands out from now on in `pxs_leakreport`, i.e. with the request or system
+ * making them. NULL clears the tag. Does nothing without the `pxs_trace` feature.
+ *
+ * tag: BORROW
+ */
+void pxs_settracetag(const char *tag);
+
+/**
+ * The pxs_Vars handed to the host and not freed yet, grouped by where they were made: count, type, the C API call
+ * that returned them, the runtime being called at the time and the `pxs_settracetag` tag. Most first.
+ *
+ * Needs the `pxs_trace` feature, without it the report says so.
+ *
+ * result: OWNED
+ */
+char *pxs_leakreport(void);
+
+/**
+ * Start sampling the scripts of every thread `hz` times a second (at most 10000). Calls into a runtime that start
+ * after this are sampled: the Lua, JS and Python stack (and the host functions they call, as `[host]` frames) is
+ * recorded when the runtime next checks in, about every 1000 Lua instructions, QuickJS interrupt or Python line.
+ *
+ * False if it is already running or `hz` is 0.
+ */
+bool pxs_profiler_start(uint32_t hz);
+
+/**
+ * Stop the profiler and get its samples as collapsed stacks, one `frame;frame;frame count` line per stack with the
+ * most sampled first. Ready for flamegraph tools (i.e. `flamegraph.pl`, speedscope). Empty if it was not running.
+ *
+ * Free with `pxs_freestr`.
+ *
+ * result: OWNED
+ */
+char *pxs_profiler_stop(void);
+
+/**
+ * Record the calls scripts make to host functions from now on (or stop recording). Off by default, when off a call
+ * costs one extra flag check. Recorded stats are kept when turned off, until `pxs_funcstats_reset`.
+ */
+void pxs_funcstats_enable(bool enabled);
+
+/**
+ * Stats of the host functions called while `pxs_funcstats_enable` was on, from every thread. A map by the function
+ * name as it is in the lookup (`_{module}{name}`, `_{type}{method}`), then by runtime (`lua`, `python`, `js`, `wren`),
+ * each with:
+ * - `calls`: times called
+ * - `total_ns`, `max_ns`, `mean_ns`: time in the function, from its args as pxs_Vars to its result
+ * - `p50_ns`, `p90_ns`, `p99_ns`, `p999_ns`: percentiles, within 12.5%
+ * - `histogram`: list of `[upper_ns, count]` for every bucket with calls, 8 buckets per power of two
+ *
+ * return:OWNED
+ */
+pxs_VarT pxs_funcstats(void);
+
+/**
+ * Forget the stats of `pxs_funcstats`.
+ */
+void pxs_funcstats_reset(void);
+
+/**
+ * Follow the host objects added from now on (or stop following new ones): how many of each type are created,
+ * destroyed and alive, and how often their reference counts change, i.e. to find the scripts that churn host objects.
+ * Off by default, when off adding a object costs one extra flag check. Kept when turned off, until
+ * `pxs_objstats_reset`.
+ */
+void pxs_objstats_enable(bool enabled);
+
+/**
+ * Stats of the host objects added while `pxs_objstats_enable` was on, from every thread. A map by type name (the
+ * `type_name` of `pxs_newobject`/`pxs_newtype`, the class type name for `pxs_newinstance`), each with:
+ * - `created`, `destroyed`: objects added to and freed from the object lookup
+ * - `live`: still alive, `peak`: most alive at once (per thread, added up)
+ * - `ref_ops`: reference count changes, i.e. every var made or freed holding one, creating and destroying included
+ * - `ref_ops_per_sec`: `ref_ops` over the time since recording was turned on or reset
+ *
+ * return:OWNED
+ */
+pxs_VarT pxs_objstats(void);
+
+/**
+ * Forget the stats of `pxs_objstats`. Objects alive stay counted as `live`.
+ */
+void pxs_objstats_reset(void);
+
+/**
+ * Where startup went, as a map with:
+ * - `initialize`: all of `pxs_initialize`
+ * - `phases`: list in start order, each with `name`, `runtime` (empty for host phases), `depth` (phases inside
+ *   phases), i.e. each runtimes `start` with its `vm`, `stdlib`, `core_modules` and `globals`, and the ones of
+ *   `pxs_startupbegin`
+ * - `modules`: list of every `pxs_addmod`, each with `name`, `functions` (submodules included) and `runtimes`,
+ *   the cost of adding it to each runtime
+ * - `modules_total`: all of `modules`
+ *
+ * Every cost is a map of `ns`, `allocs` (new blocks of the language states) and `bytes` (allocated by them).
+ *
+ * return:OWNED
+ */
+pxs_VarT pxs_startupstats(void);
+
+/**
+ * Begin a host startup phase named `name` in `pxs_startupstats`, i.e. around loading assets or `yoyo_init`. Phases
+ * begun while one is open are inside it. End it with `pxs_startupend`.
+ *
+ * name: BORROW
+ */
+void pxs_startupbegin(const char *name);
+
+/**
+ * End the last phase `pxs_startupbegin` began on this thread. False if none is open.
+ */
+bool pxs_startupend(void);
+
+/**
+ * Send begin/end events of `pxs_exec`/`pxs_execobject`, `pxs_call`/`pxs_callv`, module imports, garbage collection
+ * and host function calls (see `pxs_TraceKind`) to `tracer` from now on, i.e. to put them on the timeline of a engine
+ * profiler. NULL removes the tracer. Events come from every thread, on the thread doing the work.
+ *
+ * tracer: BORROW, NULLABLE. Copied.
+ */
+void pxs_settracer(const pxs_Tracer *tracer);
+
+/**
+ * Start the built in trace writer: keep the next `capacity` events of every thread (the ones after are counted as
+ * dropped) for `pxs_tracewriter_stop`. Works next to a `pxs_settracer` tracer.
+ *
+ * False if it is already running or `capacity` is 0.
+ */
+bool pxs_tracewriter_start(uintptr_t capacity);
+
+/**
+ * Stop the trace writer and get its events as Chrome trace JSON, for `chrome://tracing` or Perfetto. Timestamps are
+ * microseconds since the first `pxs_tracewriter_start`. Empty if it was not running.
+ *
+ * Free with `pxs_freestr`.
+ *
+ * result: OWNED
+ */
+char *pxs_tracewriter_stop(void);
+
+/**
+ * Begin a host span named `name` (a `pxs_TraceMark` event), i.e. a engine frame, so it lines up with pixelscript
+ * events in the trace writer. End it with `pxs_traceend` and the same name. Nothing happens while nothing traces.
+ *
+ * name: BORROW
+ */
+void pxs_tracebegin(const char *name);
+
+/**
+ * End the host span of `pxs_tracebegin`.
+ *
+ * name: BORROW
+ */
+void pxs_traceend(const char *name);
+
+/**
+ * Report every `pxs_exec`, `pxs_eval`/`pxs_evalnamed`, `pxs_execobject` and `pxs_call`/`pxs_callv` that ran past
+ * `watchdog.call_us` to `watchdog.slow`, with its runtime, file name, function and time (see `pxs_SlowCall`), i.e.
+ * to find the mods that make frames slow in a released game. Nothing is stopped, for that see `pxs_setbudget`. With
+ * `watchdog.frame_us` the host also calls `pxs_watchdog_frame` once per frame, a frame whose calls ran past it
+ * together is reported with its slowest call.
+ *
+ * Only the outermost call of a thread is watched. NULL, a NULL callback or both thresholds 0 turn the watchdog off,
+ * it then costs one relaxed load per call.
+ *
+ * watchdog: BORROW, NULLABLE. Copied.
+ */
+void pxs_setwatchdog(const pxs_Watchdog *watchdog);
+
+/**
+ * End the frame of the current thread for `pxs_setwatchdog` and start the next one. Reports the frame when its calls
+ * ran past `frame_us`.
+ *
+ * Returns how long the calls of the frame ran, in nanoseconds. 0 while `frame_us` is 0.
+ */
+uint64_t pxs_watchdog_frame(void);
+
 /**
  * Get the host IDX from a `pxs_HostObject`.
  *
@@ -1109,6 +2395,74 @@ uintptr_t pxs_argc(pxs_VarT args);
  */
 pxs_VarT pxs_newbytes(pxs_Opaque data, uintptr_t el_size, uintptr_t size);
 
+/**
+ * Create a `pxs_Buffer` over host memory. Nothing is copied, not here and not when it is passed to a script:
+ * Lua gets a userdata (`#buf`, `buf[i]`, `tostring(buf)`), Python a `pxs_buffer` (`len`, `buf[i]`, `buf.tobytes()`)
+ * and JS a `ArrayBuffer`.
+ *
+ * `data` must stay valid and unchanged in size until `deleter` is called. That happens once, when this var, its
+ * clones and every script value using it are gone. Pass NULL for memory the host frees itself after the runtimes stop.
+ *
+ * data: BORROW
+ * result: OWNED
+ */
+pxs_VarT pxs_newbytes_borrowed(pxs_Opaque data, uintptr_t len, pxs_DeleterFn deleter);
+
+/**
+ * Get the memory of a `pxs_Buffer` and its size in `len`. NULL if `var` is not a buffer.
+ *
+ * var: BORROW
+ * result: BORROW
+ */
+pxs_Opaque pxs_getbuffer(pxs_VarT var, uintptr_t *len);
+
+/**
+ * Wrap a `pxs_List` or `pxs_Map` in a `pxs_Proxy`. Scripts get a view instead of a converted copy, only the items
+ * they read are converted (nested Lists/Maps fully, when read):
+ * Lua gets a userdata (`#p`, `p[i]` 1 based, `p.key`), Python a `pxs_proxy` (`len(p)`, `p[i]`, `p[key]`)
+ * and JS a object (`p.length`, `p[i]`, `p.key`).
+ *
+ * Use it for large containers that scripts only look into. The view is read only, and can not be iterated
+ * with `pairs`/`for in`/`Object.keys`.
+ *
+ * var: TRANSFER
+ * result: OWNED
+ */
+pxs_VarT pxs_newproxy(pxs_VarT var);
+
+/**
+ * Get the `pxs_List` or `pxs_Map` behind a `pxs_Proxy`. NULL if `var` is not a proxy. Do not change it.
+ *
+ * var: BORROW
+ * result: BORROW
+ */
+pxs_VarT pxs_getproxy(pxs_VarT var);
+
+/**
+ * Publish a `pxs_List` or `pxs_Map` of plain data (no objects or functions) as `name`, for every runtime and thread.
+ * It is kept once on the host and frozen: scripts read it through `pxs_Proxy` views (`pxs_data.get(name)`), nested
+ * Lists/Maps are views too, so nothing is converted until a value is read. Publishing `name` again replaces it, views
+ * of the old data keep it alive.
+ *
+ * Use it for data every runtime reads (item tables, localization) instead of converting it into each one.
+ * Returns false when `var` can not be published.
+ *
+ * var: TRANSFER
+ */
+bool pxs_publish(const char *name, pxs_VarT var);
+
+/**
+ * Remove the data published as `name`. Views scripts still hold keep working. False if nothing was published as `name`.
+ */
+bool pxs_unpublish(const char *name);
+
+/**
+ * A `pxs_Proxy` of the data published as `name`, `pxs_Null` if there is none. It can be passed into any runtime.
+ *
+ * return: OWNED
+ */
+pxs_VarT pxs_published(const char *name);
+
 /**
  * Get the memory size (in bytes) of a `pxs_VarT`
  *
@@ -1124,6 +2478,7 @@ uintptr_t pxs_varsize(pxs_VarT var);
  *   - `pxs_Bool`
  *   - `pxs_String`
  *   - `pxs_List`
+ *   - `pxs_Buffer`
  *
  * var: BORROW
  * data_ptr: BORROW
@@ -1172,8 +2527,8 @@ enum pxs_VarType pxs_vartype(pxs_VarT var);
 
 /**
  * Encode a `pxs_Var` into a JSON string. Will return a `pxs_Var` of type string.
- * Transfers ownership of args.
- * Basically calls the runtime.pxs_json.encode() function.
+ * `args` is a list holding the value. Transfers ownership of args.
+ * Uses the native encoder of `pxs_json`, `rt` is only needed to look into script objects (`pxs_Object`).
  *
  * Note: This function is already enabled in each scripting language. This is a host language wrapper for calling it easily.
  *
@@ -1185,9 +2540,9 @@ pxs_VarT pxs_json_encode(pxs_VarT rt,
                          pxs_VarT args);
 
 /**
- * Decode a `pxs_String` into a `pxs_Var`.
- * Make sure runtime is the first argument in args.
- * Transfers ownership of args.
+ * Decode a `pxs_String` (or a `pxs_Buffer` of JSON text) into a `pxs_Var`. Objects become `pxs_Map`s and arrays
+ * `pxs_List`s.
+ * `args` is a list holding the string. Transfers ownership of args.
  *
  * Note: This function is already enabled in each scripting language. This is a host language wrapper for calling it easily.
  *
@@ -1198,6 +2553,56 @@ pxs_VarT pxs_json_encode(pxs_VarT rt,
 pxs_VarT pxs_json_decode(pxs_VarT rt,
                          pxs_VarT args);
 
+/**
+ * Start a streaming JSON decode. Feed the text in chunks with `pxs_json_feed` and get the value with
+ * `pxs_json_finish`, the text is never held whole. `yoyo.fs` and `yoyo.zip` use it for `read_json`.
+ *
+ * `pointer` is a JSON pointer (RFC 6901, i.e. `/mods/0/name`) to only build that value, the rest is checked and
+ * dropped. NULL or `""` builds the whole document.
+ *
+ * pointer:BORROW
+ * return:OWNED
+ */
+struct pxs_JsonStream *pxs_json_newstream(const char *pointer);
+
+/**
+ * Decode the next `len` bytes of the text. Chunks can end anywhere. False once the text is invalid, the error is
+ * returned by `pxs_json_finish`.
+ *
+ * stream:BORROW
+ * data:BORROW
+ */
+bool pxs_json_feed(struct pxs_JsonStream *stream, const char *data, uintptr_t len);
+
+/**
+ * End a streaming decode and free `stream`. Returns the decoded (or pointed to) value, or a exception.
+ *
+ * stream:TRANSFER
+ * return:OWNED
+ */
+pxs_VarT pxs_json_finish(struct pxs_JsonStream *stream);
+/**
+ * Pack a `pxs_Var` tree into a `pxs_Buffer` of MessagePack. Smaller and faster than JSON, and keeps the types:
+ * `pxs_Int64`/`pxs_UInt64`/`pxs_Byte`/`pxs_Float64` stay apart, `pxs_Buffer`s stay bytes and `pxs_Map` keys do not
+ * have to be strings. The buffer can be written to disk or unpacked in another runtime.
+ *
+ * `rt` is only needed to look into script objects (`pxs_Object`), it can be NULL otherwise.
+ *
+ * rt:BORROW
+ * var:BORROW
+ * return:OWNED
+ */
+pxs_VarT pxs_pack(pxs_VarT rt, pxs_VarT var);
+
+/**
+ * Unpack the bytes of `pxs_pack` into a new `pxs_Var` tree. `bytes` is a `pxs_Buffer` (i.e. `pxs_newbytes_borrowed`
+ * over a file read by the host), a `pxs_String` or a `pxs_List` of bytes.
+ *
+ * bytes:BORROW
+ * return:OWNED
+ */
+pxs_VarT pxs_unpack(pxs_VarT bytes);
+
 /**
  * Initialize the `pxs_mem` module.
  *
@@ -1212,6 +2617,134 @@ void pxs_meminit(void);
  */
 void pxs_yoyoinit(void);
 
+/**
+ * Run the callbacks of finished `yoyo` background work (i.e. `yoyo.fs.read_async`) and the due `yoyo.time` timers.
+ *
+ * Call this once per frame from the thread that started the work. Returns the number of completions handled.
+ */
+int32_t pxs_yoyopump(void);
+
+/**
+ * Use the `yoyo.fs` caching disk reader as the file reader (see `pxs_set_filereader`).
+ *
+ * Sources are kept in a LRU keyed by path and revalidated against the file's mtime and size,
+ * so importing the same file from multiple runtimes or after `pxs_clear` only reads it once.
+ *
+ * budget: max number of bytes to keep cached.
+ */
+void pxs_yoyofilecache(uint64_t budget);
+
+/**
+ * Start or stop recording per domain latency histograms of `yoyo.net` requests. Off by default.
+ *
+ * enabled: record or not.
+ */
+void pxs_yoyonettrack(bool enabled);
+
+/**
+ * Write the recorded `yoyo.net` stats as nul terminated JSON into `out`.
+ *
+ * `{"domain": {"count": n, "errors": n, "total_ms": f, "buckets": [...]}}`. Bucket `i` counts requests
+ * that took at most `2^i` ms, the last one everything slower. A exception or a 5xx is a error.
+ *
+ * out: buffer to write into, can be null to get the length.
+ * len: size of `out`.
+ * reset: clear the stats, only done when they fit into `out`.
+ *
+ * Returns the length needed without the nul.
+ */
+uintptr_t pxs_yoyonetstats(char *out, uintptr_t len, bool reset);
+
+/**
+ * Open the zip archive at `path` and serve script imports from it instead of the disk.
+ *
+ * Replaces the file and dir readers (see `pxs_set_filereader` and `pxs_set_dirreader`). Sources are
+ * inflated once and cached by path.
+ *
+ * path: BORROW path to the archive.
+ *
+ * Returns false when the archive can not be opened.
+ */
+bool pxs_yoyozipmount(const char *path);
+
+/**
+ * Set up the worker states of `yoyo.task`. Each worker has its own runtime set (see `pxs_pool_create`), `setup` is
+ * called once per set, add the modules tasks need there. Null `setup` only adds `yoyo`.
+ *
+ * workers: number of worker threads, 0 for the default (physical cores, at most 8).
+ *
+ * Only used before the first `yoyo.task.spawn`.
+ *
+ * setup:BORROW
+ * opaque:BORROW
+ */
+void pxs_yoyotasksetup(pxs_PoolSetupFn setup, pxs_Opaque opaque, uint32_t workers);
+
+/**
+ * Set up the buffered sink behind `yoyo.print`, `yoyo.println` and `yoyo.log`. Every thread appends to its own
+ * buffer and a writer thread drains them to stdout.
+ *
+ * level: lowest level written, 0 debug, 1 info, 2 warn, 3 error, 4 off.
+ * flush_bytes: buffer size that wakes the writer.
+ * flush_ms: how often the writer drains anyway, 0 writes every message right away.
+ *
+ * Defaults to info, 64KB and 50ms.
+ */
+void pxs_yoyologsetup(int32_t level, uintptr_t flush_bytes, uint32_t flush_ms);
+
+/**
+ * Write everything `yoyo` printed so far, i.e. before the host writes to stdout itself.
+ */
+void pxs_yoyologflush(void);
+
+/**
+ * Get the `yoyo.channel` named `name`, made with `capacity` (rounded up to a power of two, 0 for 1024) if it does
+ * not exist yet. Scripts get the same channel with `yoyo.channel.open(name)`. Lives as long as the process.
+ *
+ * name:BORROW
+ */
+pxs_Opaque pxs_yoyochannel(const char *name, uint32_t capacity);
+
+/**
+ * Send a copy of `var` (through `pxs_pack`) to `channel` from `pxs_yoyochannel`. Never blocks or locks.
+ *
+ * Returns false when the channel is full or `var` can not be packed.
+ *
+ * channel:BORROW
+ * var:BORROW
+ */
+bool pxs_yoyochannelsend(pxs_Opaque channel, pxs_VarT var);
+
+/**
+ * Receive the oldest message of `channel` from `pxs_yoyochannel`. Never blocks or locks.
+ *
+ * Values come back unpacked, byte blocks pushed with `yoyo_channel_push` as a `pxs_Buffer`.
+ *
+ * channel:BORROW
+ * return:OWNED null when the channel is empty.
+ */
+pxs_VarT pxs_yoyochannelrecv(pxs_Opaque channel);
+
+/**
+ * Use `argv` as `yoyo.os.argv` instead of the command line of the process. Call before `pxs_yoyoinit`.
+ *
+ * argv:BORROW `argc` strings, copied.
+ */
+void pxs_yoyosetargs(int32_t argc, const char *const *argv);
+
+/**
+ * The number of logical CPUs this process may run on, or with `physical` the number of physical cores.
+ */
+uint32_t pxs_yoyocpucount(bool physical);
+
+/**
+ * Pin the calling thread to the CPU `yoyo` gives worker `index`: a physical core each, spread over the packages,
+ * before any two share a core. Lets host worker pools line up with `yoyo.task`.
+ *
+ * Returns false when the OS refused, always on macOS.
+ */
+bool pxs_yoyopinworker(uint32_t index);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -7,13 +7,70 @@
 
 #include <string>
 #include <vector>
+#include <map>
 #include <cstring>
 #include <cstdlib>
 #include <optional>
 #include <variant>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <exception>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <new>
 
 // The pixel script namespace
 namespace pxs {
+    class Var;
+
+    // Makes every owned `Var` created on this thread while it is alive owned by a `pxs_PixelArena` instead, and
+    // frees them all at once when the scope ends. Scopes nest, the innermost one adopts.
+    // Vars must not outlive their scope unless they are promoted.
+    // This should not be copied.
+    // This should not be moved.
+    class ArenaScope {
+        pxs_PixelArena* arena;
+        ArenaScope* parent;
+
+        static ArenaScope*& current() {
+            static thread_local ArenaScope* scope = nullptr;
+            return scope;
+        }
+    public:
+        ArenaScope() : arena(pxs_newarena()), parent(current()) {
+            current() = this;
+        }
+
+        ~ArenaScope() {
+            current() = parent;
+            pxs_freearena(arena);
+        }
+
+        ArenaScope(const ArenaScope&) = delete;
+        ArenaScope& operator=(const ArenaScope&) = delete;
+
+        // Put `var` in the innermost scope. False when there is no scope.
+        static bool adopt(pxs_Var* var) {
+            auto scope = current();
+            if (scope == nullptr || var == nullptr) {
+                return false;
+            }
+            pxs_arenaput(scope->arena, var);
+            return true;
+        }
+
+        // Raw ptr
+        pxs_PixelArena* raw() const {
+            return arena;
+        }
+
+        // Move `var` out of this scope. Into the enclosing scope, or owned by `var` if this is the outermost one.
+        void promote(Var& var) const;
+    };
+
     // A Var
     class Var {
         // Runtime this Var belongs to
@@ -25,13 +82,13 @@ namespace pxs {
 
     public:
         // Null variable. Owned
-        Var() : rt(nullptr), ptr(pxs_newnull()), owned(true) {}
+        Var() : rt(nullptr), ptr(pxs_newnull()), owned(!ArenaScope::adopt(ptr)) {}
         // Null runtime, set pointer, not owned.
         Var(pxs_Var* ptr) : rt(nullptr), ptr(ptr), owned(false) {}
-        // Ptr and owned option.
-        Var(pxs_Var* ptr, bool owned) : rt(nullptr), ptr(ptr), owned(owned) {}
+        // Ptr and owned option. Owned vars go to the current `ArenaScope` if there is one.
+        Var(pxs_Var* ptr, bool owned) : rt(nullptr), ptr(ptr), owned(owned && !ArenaScope::adopt(ptr)) {}
         // Runtime, pointer, owned = false.
-        Var(pxs_Var* rt, pxs_Var* ptr, bool owned=false) : rt(rt), ptr(ptr), owned(owned) {}
+        Var(pxs_Var* rt, pxs_Var* ptr, bool owned=false) : rt(rt), ptr(ptr), owned(owned && !ArenaScope::adopt(ptr)) {}
         ~Var() {
             if (owned && ptr != nullptr) {
                 pxs_freevar(ptr);
@@ -96,6 +153,11 @@ namespace pxs {
             return Var(nullptr, pxs_newlist());
         }
 
+        // Create a new list with room for `capacity` items.
+        [[nodiscard]] static Var new_list(size_t capacity) {
+            return Var(nullptr, pxs_newlist_with_capacity(capacity));
+        }
+
         // Create a Var with the same rt
         [[nodiscard]] Var with_rt(pxs_Var* val, bool owned=false) const {
             return Var(rt, val, owned);
@@ -137,21 +199,19 @@ namespace pxs {
         }
 
         // Get string val. Will return "" if not a valid string.
-        // Will also free the memoery automatically
         [[nodiscard]] std::string get_string() const {
-            if (!is(pxs_String) && !is(pxs_Exception)) {
-                return std::string("");
-            }
+            return std::string(get_string_view());
+        }
 
-            // Ok lets do it!
-            char* val = pxs_getstring(ptr);
+        // Borrow the string val (or the bytes of a buffer) without copying it. Will return "" if not a valid string.
+        // Only valid while this var is alive and unchanged.
+        [[nodiscard]] std::string_view get_string_view() const {
+            size_t len = 0;
+            auto val = pxs_getstrview(ptr, &len);
             if (val == nullptr) {
-                return std::string("");
+                return std::string_view();
             }
-
-            std::string res = std::string(val);
-            pxs_freestr(val);
-            return res;
+            return std::string_view(val, len);
         }
 
         // Get float val. Will return -1.0f if not a int or float
@@ -195,6 +255,21 @@ namespace pxs {
             pxs_listadd(ptr, pxs_newcopy(arg.raw()));
         }
 
+        // Make room in this list for `additional` more items.
+        void reserve(size_t additional) const {
+            pxs_listreserve(ptr, additional);
+        }
+
+        // Move the items of another list to the end of this one.
+        void extend(Var&& other) const {
+            pxs_listextend(ptr, other.release());
+        }
+
+        // Add copies of the items of another list to the end of this one.
+        void extend(const Var& other) const {
+            pxs_listextend(ptr, pxs_newcopy(other.raw()));
+        }
+
         // Get this var as a C++ object. HostObject
         template<typename T>
         T* get_object() const {
@@ -303,6 +378,28 @@ namespace pxs {
             return pxs_listlen(raw());
         }
 
+        // Call `f(item)` for every item of a list, borrowed. Nothing is copied.
+        template<typename F>
+        void list_each(F&& f) const {
+            size_t len = 0;
+            auto span = pxs_listspan(raw(), &len);
+            for (size_t i = 0; i < len; i++) {
+                f(&span[i]);
+            }
+        }
+
+        // Call `f(key, value)` for every pair of a map in order, both borrowed. Nothing is copied.
+        template<typename F>
+        void map_each(F&& f) const {
+            pxs_MapIter iter;
+            pxs_VarT key = nullptr;
+            pxs_VarT value = nullptr;
+            pxs_mapiter_begin(raw(), &iter);
+            while (pxs_mapiter_next(&iter, &key, &value)) {
+                f(key, value);
+            }
+        }
+
         // Debug a `pxs_Var`
         std::string debug() const {
             // Get string
@@ -321,6 +418,106 @@ namespace pxs {
             owned = val;
         }
 
+        // Is this a owned ptr
+        bool is_owned() const {
+            return owned;
+        }
+
+        // Give up the ptr, i.e. to pass it to a `TRANSFER` argument. A Var that is not owned gives a copy.
+        [[nodiscard]] pxs_Var* release() {
+            auto res = owned ? ptr : pxs_newcopy(ptr);
+            ptr = nullptr;
+            owned = false;
+            return res;
+        }
+
+        // Create a owned list from numbers in one call. Integers are stored as ints, floats as floats.
+        template<typename T>
+        [[nodiscard]] static Var from_vector(const std::vector<T>& values) {
+            static_assert(std::is_arithmetic_v<T>, "from_vector expects numbers.");
+            if constexpr (std::is_same_v<T, int64_t>) {
+                return Var(pxs_newlist_i64(values.data(), values.size()), true);
+            } else if constexpr (std::is_same_v<T, double>) {
+                return Var(pxs_newlist_f64(values.data(), values.size()), true);
+            } else {
+                using U = std::conditional_t<std::is_floating_point_v<T>, double, int64_t>;
+                return from_vector(std::vector<U>(values.begin(), values.end()));
+            }
+        }
+
+        // Get the items of a list as numbers in one call. Stops at the first item that is not a number.
+        template<typename T>
+        std::vector<T> to_vector() const {
+            static_assert(std::is_arithmetic_v<T>, "to_vector expects numbers.");
+            using U = std::conditional_t<std::is_floating_point_v<T>, double, int64_t>;
+            std::vector<U> res;
+            auto len = list_len();
+            if (len <= 0) {
+                return {};
+            }
+
+            res.resize(static_cast<size_t>(len));
+            int32_t copied = 0;
+            if constexpr (std::is_same_v<U, double>) {
+                copied = pxs_list_copy_f64(ptr, res.data(), res.size());
+            } else {
+                copied = pxs_list_copy_i64(ptr, res.data(), res.size());
+            }
+            res.resize(copied > 0 ? static_cast<size_t>(copied) : 0);
+
+            if constexpr (std::is_same_v<T, U>) {
+                return res;
+            } else {
+                return std::vector<T>(res.begin(), res.end());
+            }
+        }
+
+        // Create a owned map from string keyed numbers in one call.
+        template<typename T>
+        [[nodiscard]] static Var from_map(const std::map<std::string, T>& values) {
+            static_assert(std::is_arithmetic_v<T>, "from_map expects numbers.");
+            using U = std::conditional_t<std::is_floating_point_v<T>, double, int64_t>;
+            std::vector<const char*> keys;
+            std::vector<U> nums;
+            keys.reserve(values.size());
+            nums.reserve(values.size());
+            for (const auto& [key, value] : values) {
+                keys.push_back(key.c_str());
+                nums.push_back(static_cast<U>(value));
+            }
+
+            if constexpr (std::is_same_v<U, double>) {
+                return Var(pxs_newmap_f64(keys.data(), nums.data(), keys.size()), true);
+            } else {
+                return Var(pxs_newmap_i64(keys.data(), nums.data(), keys.size()), true);
+            }
+        }
+
+        // Get the string keyed numbers of a map in one call. Other pairs are skipped.
+        template<typename T>
+        std::map<std::string, T> to_map() const {
+            static_assert(std::is_arithmetic_v<T>, "to_map expects numbers.");
+            using U = std::conditional_t<std::is_floating_point_v<T>, double, int64_t>;
+            std::map<std::string, T> res;
+            auto len = pxs_maplen(ptr);
+            if (len <= 0) {
+                return res;
+            }
+
+            std::vector<const char*> keys(static_cast<size_t>(len));
+            std::vector<U> nums(static_cast<size_t>(len));
+            int32_t copied = 0;
+            if constexpr (std::is_same_v<U, double>) {
+                copied = pxs_map_copy_f64(ptr, keys.data(), nums.data(), keys.size());
+            } else {
+                copied = pxs_map_copy_i64(ptr, keys.data(), nums.data(), keys.size());
+            }
+            for (int32_t i = 0; i < copied; i++) {
+                res.emplace(keys[i], static_cast<T>(nums[i]));
+            }
+            return res;
+        }
+
         // Get all the items of a list as objects.
         template<typename T>
         std::vector<T> list_get_objects() const {
@@ -366,6 +563,19 @@ namespace pxs {
         }
     };
 
+    inline void ArenaScope::promote(Var& var) const {
+        auto taken = pxs_arenatake(arena, var.raw());
+        if (taken == nullptr) {
+            // Not in this scope
+            return;
+        }
+        if (parent != nullptr) {
+            pxs_arenaput(parent->arena, taken);
+        } else {
+            var.set_owned(true);
+        }
+    }
+
     // Call a function using pxs_call
     // Result is owned.
     [[nodiscard]] inline Var call(pxs_Runtime runtime, const std::string& name, const pxs::Var& args) {
@@ -445,28 +655,327 @@ namespace pxs {
         return fun(list.raw());
     }
 
+    inline std::string string_type(pxs_VarType var_type);
+
+    namespace detail {
+        template<typename T>
+        struct is_optional : std::false_type {};
+        template<typename T>
+        struct is_optional<std::optional<T>> : std::true_type {};
+
+        // How a argument of type `T` is read out of a var. `holder` is what keeps the value alive until the call.
+        template<typename T, typename = void>
+        struct ArgConv;
+
+        template<>
+        struct ArgConv<bool> {
+            using holder = bool;
+            static constexpr const char* expected = "Bool";
+            static bool read(pxs_VarT /*rt*/, pxs_VarT var, holder& out) {
+                if (!pxs_varis(var, pxs_Bool)) {
+                    return false;
+                }
+                out = pxs_getbool(var);
+                return true;
+            }
+        };
+
+        template<typename T>
+        struct ArgConv<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>> {
+            using holder = T;
+            static constexpr const char* expected = "Int";
+            static bool read(pxs_VarT /*rt*/, pxs_VarT var, holder& out) {
+                if (pxs_varis(var, pxs_Int64)) {
+                    out = static_cast<T>(pxs_getint(var));
+                } else if (pxs_varis(var, pxs_UInt64)) {
+                    out = static_cast<T>(pxs_getuint(var));
+                } else {
+                    return false;
+                }
+                return true;
+            }
+        };
+
+        template<typename T>
+        struct ArgConv<T, std::enable_if_t<std::is_floating_point_v<T>>> {
+            using holder = T;
+            static constexpr const char* expected = "Float";
+            static bool read(pxs_VarT /*rt*/, pxs_VarT var, holder& out) {
+                if (pxs_varis(var, pxs_Float64)) {
+                    out = static_cast<T>(pxs_getfloat(var));
+                } else if (pxs_varis(var, pxs_Int64)) {
+                    out = static_cast<T>(pxs_getint(var));
+                } else if (pxs_varis(var, pxs_UInt64)) {
+                    out = static_cast<T>(pxs_getuint(var));
+                } else {
+                    return false;
+                }
+                return true;
+            }
+        };
+
+        template<>
+        struct ArgConv<std::string> {
+            using holder = std::string;
+            static constexpr const char* expected = "String";
+            static bool read(pxs_VarT /*rt*/, pxs_VarT var, holder& out) {
+                if (!pxs_varis(var, pxs_String)) {
+                    return false;
+                }
+                out = Var(var).get_string();
+                return true;
+            }
+        };
+
+        // Borrowed from the var, only valid for the call.
+        template<>
+        struct ArgConv<std::string_view> {
+            using holder = std::string_view;
+            static constexpr const char* expected = "String";
+            static bool read(pxs_VarT /*rt*/, pxs_VarT var, holder& out) {
+                if (!pxs_varis(var, pxs_String)) {
+                    return false;
+                }
+                out = Var(var).get_string_view();
+                return true;
+            }
+        };
+
+        // Anything, borrowed.
+        template<>
+        struct ArgConv<pxs_VarT> {
+            using holder = pxs_VarT;
+            static constexpr const char* expected = "Any";
+            static bool read(pxs_VarT /*rt*/, pxs_VarT var, holder& out) {
+                out = var;
+                return true;
+            }
+        };
+
+        // Anything, borrowed, with the runtime set.
+        template<>
+        struct ArgConv<Var> {
+            using holder = Var;
+            static constexpr const char* expected = "Any";
+            static bool read(pxs_VarT rt, pxs_VarT var, holder& out) {
+                out = Var(rt, var, false);
+                return true;
+            }
+        };
+
+        // Missing or null is `std::nullopt`.
+        template<typename T>
+        struct ArgConv<std::optional<T>> {
+            using holder = std::optional<typename ArgConv<T>::holder>;
+            static constexpr const char* expected = ArgConv<T>::expected;
+            static bool read(pxs_VarT rt, pxs_VarT var, holder& out) {
+                if (var == nullptr || pxs_varis(var, pxs_Null)) {
+                    out.reset();
+                    return true;
+                }
+                out.emplace();
+                return ArgConv<T>::read(rt, var, *out);
+            }
+        };
+
+        template<typename T>
+        using arg_t = std::remove_cv_t<std::remove_reference_t<T>>;
+
+        // Convert a value into a owned var.
+        template<typename R>
+        pxs_VarT into_var(R&& value) {
+            using T = std::decay_t<R>;
+            if constexpr (std::is_same_v<T, bool>) {
+                return pxs_newbool(value);
+            } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+                return pxs_newint(static_cast<int64_t>(value));
+            } else if constexpr (std::is_integral_v<T>) {
+                return pxs_newuint(static_cast<uint64_t>(value));
+            } else if constexpr (std::is_floating_point_v<T>) {
+                return pxs_newfloat(static_cast<double>(value));
+            } else if constexpr (std::is_same_v<T, std::string>) {
+                return pxs_newstring(value.c_str());
+            } else if constexpr (std::is_same_v<T, std::string_view>) {
+                return pxs_newstring(std::string(value).c_str());
+            } else if constexpr (std::is_same_v<T, const char*> || std::is_same_v<T, char*>) {
+                return pxs_newstring(value);
+            } else if constexpr (std::is_same_v<T, pxs_VarT>) {
+                return value ? value : pxs_newnull();
+            } else if constexpr (std::is_same_v<T, Var>) {
+                // Hand over the ownership, a borrowed var is copied.
+                pxs_VarT res = nullptr;
+                if constexpr (!std::is_lvalue_reference_v<R> && !std::is_const_v<std::remove_reference_t<R>>) {
+                    res = value.raw() ? value.release() : nullptr;
+                } else {
+                    res = pxs_newcopy(value.raw());
+                }
+                return res ? res : pxs_newnull();
+            } else if constexpr (is_optional<T>::value) {
+                return value ? into_var(*value) : pxs_newnull();
+            } else {
+                static_assert(sizeof(T) == 0, "pxs can not convert this type into a var.");
+            }
+        }
+
+        // Number of args that have to be passed, trailing `std::optional`s can be left out.
+        template<typename... Args>
+        constexpr size_t required_args() {
+            constexpr bool optional[] = {is_optional<arg_t<Args>>::value..., false};
+            size_t required = 0;
+            for (size_t i = 0; i < sizeof...(Args); i++) {
+                if (!optional[i]) {
+                    required = i + 1;
+                }
+            }
+            return required;
+        }
+
+        template<auto Fn, typename R, typename... Args, size_t... I>
+        pxs_VarT invoke(pxs_VarT args, std::index_sequence<I...>) {
+            constexpr size_t required = required_args<Args...>();
+            constexpr size_t total = sizeof...(Args);
+            int len = pxs_listlen(args);
+            size_t argc = len > 0 ? static_cast<size_t>(len - 1) : 0;
+            if (argc < required || argc > total) {
+                auto count = required == total ? std::to_string(total) : std::to_string(required) + " to " + std::to_string(total);
+                return pxs_newexception(("Expected " + count + " args. Found " + std::to_string(argc)).c_str());
+            }
+
+            // One pass over the args, stopping at the first bad one.
+            pxs_VarT rt = pxs_listget(args, 0);
+            std::tuple<typename ArgConv<arg_t<Args>>::holder...> values;
+            int bad = -1;
+            ((bad < 0 && !ArgConv<arg_t<Args>>::read(rt, I < argc ? pxs_listget(args, static_cast<int>(I) + 1) : nullptr, std::get<I>(values))
+                ? (bad = static_cast<int>(I), false) : true), ...);
+            if (bad >= 0) {
+                static constexpr const char* expected[] = {ArgConv<arg_t<Args>>::expected..., ""};
+                auto found = pxs_listget(args, bad + 1);
+                return pxs_newexception(("Expected " + std::string(expected[bad]) + " for arg " + std::to_string(bad) + " but found " + string_type(pxs_vartype(found))).c_str());
+            }
+
+            try {
+                if constexpr (std::is_void_v<R>) {
+                    Fn(std::move(std::get<I>(values))...);
+                    return pxs_newnull();
+                } else {
+                    return into_var(Fn(std::move(std::get<I>(values))...));
+                }
+            } catch (const std::exception& e) {
+                return pxs_newexception(e.what());
+            }
+        }
+
+        template<auto Fn, typename Sig>
+        struct Binder;
+
+        template<auto Fn, typename R, typename... Args>
+        struct Binder<Fn, R(*)(Args...)> {
+            static pxs_VarT call(pxs_VarT args) {
+                return invoke<Fn, R, Args...>(args, std::index_sequence_for<Args...>{});
+            }
+        };
+
+        template<auto Fn, typename R, typename... Args>
+        struct Binder<Fn, R(*)(Args...) noexcept> : Binder<Fn, R(*)(Args...)> {};
+    }
+
+    // A `pxs_Func` calling the plain C++ function `Fn`, i.e. `pxs_addfunc(mod, "add", pxs::bind<&add>())`.
+    //
+    // The arity and argument types are checked once in one pass over the args. Supported arguments are
+    // `bool`, integers, floats, `std::string`, `std::string_view` (only valid during the call), `pxs_VarT`
+    // and `pxs::Var` (borrowed), and `std::optional` of those for trailing args that can be left out or null.
+    // Returns are converted the same way, `void` is null. A thrown `std::exception` becomes a exception.
+    template<auto Fn>
+    constexpr pxs_Func bind() {
+        return &detail::Binder<Fn, decltype(Fn)>::call;
+    }
+
+    // Call a function using pxs_call, moving in the `args` list instead of copying it.
+    // Result is owned.
+    [[nodiscard]] inline Var call(pxs_Runtime runtime, const std::string& name, pxs::Var&& args) {
+        if (!args.is(pxs_List)) {
+            return Var::new_exception(std::string("`args` in call is not list but is, ") + args.debug());
+        }
+        auto rt = pxs_newint(runtime);
+        auto res = pxs_call(rt, name.c_str(), args.release());
+        return pxs::Var(rt, res, true);
+    }
+
+    // Call a function using pxs_callv with the args built straight from `args`, i.e. `pxs::call(pxs_Lua, "update", 1, 2.0, "x")`.
+    // Args convert like `pxs::bind` returns. A `pxs::Var` is copied unless it is moved in.
+    // Result is owned.
+    template<typename... Args, typename = std::enable_if_t<!(sizeof...(Args) == 1 && (std::is_same_v<std::decay_t<Args>, Var> && ...))>>
+    [[nodiscard]] Var call(pxs_Runtime runtime, const char* name, Args&&... args) {
+        // A frame on the stack, one extra slot so it is never empty.
+        pxs_VarT argv[sizeof...(Args) + 1] = {detail::into_var(std::forward<Args>(args))..., nullptr};
+
+        auto rt = pxs_newint(runtime);
+        auto res = pxs_callv(rt, name, static_cast<int32_t>(sizeof...(Args)), argv);
+        return pxs::Var(rt, res, true);
+    }
+
+    // A function resolved once with `pxs_getfunc`, for calling it every frame without the name lookup.
+    // i.e. `pxs::FunctionRef update(pxs_Lua, "update"); update(dt);`
+    //
+    // The handle is not put in a `ArenaScope`, it lives until this is destroyed. Destroy it before `pxs_finalize`.
+    // This should not be copied.
+    class FunctionRef {
+        pxs_VarT rt = nullptr;
+        pxs_VarT func = nullptr;
+    public:
+        FunctionRef(pxs_Runtime runtime, const std::string& name) : rt(pxs_newint(runtime)) {
+            func = pxs_getfunc(rt, name.c_str());
+        }
+        ~FunctionRef() {
+            if (func) {
+                pxs_freevar(func);
+            }
+            if (rt) {
+                pxs_freevar(rt);
+            }
+        }
+
+        FunctionRef(FunctionRef&& other) noexcept : rt(other.rt), func(other.func) {
+            other.rt = nullptr;
+            other.func = nullptr;
+        }
+
+        FunctionRef(const FunctionRef& other) = delete;
+        FunctionRef& operator=(const FunctionRef& other) = delete;
+        FunctionRef& operator=(FunctionRef&& other) = delete;
+
+        // Did the name resolve to a function?
+        bool valid() const {
+            return func && pxs_varis(func, pxs_Function);
+        }
+
+        // The exception from resolving, or the function. Borrowed.
+        [[nodiscard]] Var raw() const {
+            return Var(rt, func);
+        }
+
+        // Call the function with the args built straight from `args`. Args convert like `pxs::call`.
+        // Result is owned.
+        template<typename... Args>
+        [[nodiscard]] Var operator()(Args&&... args) const {
+            pxs_VarT argv[sizeof...(Args) + 1] = {detail::into_var(std::forward<Args>(args))..., nullptr};
+
+            auto res = pxs_varcallv(rt, func, static_cast<int32_t>(sizeof...(Args)), argv);
+            return pxs::Var(rt, res, true);
+        }
+    };
+
     // Wrapper for creating `pxs_PixelObject`.
     // This should not be copied.
     // This should not be moved.
+    //
+    // Callbacks are added to this object only. When a type has many instances use `pxs::Class`.
     class Object {
         pxs_PixelObject* obj;
-        char* type;
-        std::vector<char*> method_names;
     public:
         Object(void* ptr, pxs_DeleterFn deleter, const std::string& type) {
-            this->type = strdup(type.c_str());
-            this->obj = pxs_newobject(ptr, deleter, this->type);
-            this->method_names = {};
-        }
-
-        ~Object() {
-            if (this->type != nullptr) {
-                free(this->type);
-            }
-
-            for (auto ptr : this->method_names) {
-                free(ptr);
-            }
+            // Names are copied by pixelscript.
+            this->obj = pxs_newobject(ptr, deleter, type.c_str());
         }
 
         // Turn this into a HostObject variable
@@ -479,13 +988,10 @@ namespace pxs {
 
         // Add a method to the object
         void add_method(const std::string& method_name, pxs_Func func, bool use_id=true) {
-            char* name = strdup(method_name.c_str());
-            method_names.push_back(name);
-
             if (use_id) {
-                pxs_object_addfunc(obj, name, func);
+                pxs_object_addfunc(obj, method_name.c_str(), func);
             } else {
-                pxs_object_add_reffunc(obj, name, func);
+                pxs_object_add_reffunc(obj, method_name.c_str(), func);
             }
         }
 
@@ -514,6 +1020,79 @@ namespace pxs {
         void add_property(const std::string& name, pxs_Func func) {
             pxs_object_addprop(obj, name.c_str(), func);    
         }
+
+        // Add a plain data property starting as `value` (ownership is taken). Scripts use it without calling the host.
+        void add_field(const std::string& name, pxs_VarT value, bool writable = true) {
+            pxs_object_addfield(obj, name.c_str(), value, writable);
+        }
+    };
+
+    // Wrapper for a `pxs_PixelClass`. Methods and properties are registered once and shared by every instance of `T`.
+    // Add all of them before the first `make`.
+    // This should not be copied.
+    template<typename T>
+    class Class {
+        pxs_PixelClass* cls;
+    public:
+        Class(const std::string& type, int type_id = -1) {
+            this->cls = pxs_newclass(type.c_str(), type_id);
+        }
+
+        ~Class() {
+            if (cls != nullptr) {
+                pxs_freeclass(cls);
+            }
+        }
+
+        Class(const Class&) = delete;
+        Class& operator=(const Class&) = delete;
+
+        // Raw ptr
+        pxs_PixelClass* raw() const {
+            return cls;
+        }
+
+        // Add a method to the class
+        void add_method(const std::string& method_name, pxs_Func func, bool use_id=true) {
+            if (use_id) {
+                pxs_class_addfunc(cls, method_name.c_str(), func);
+            } else {
+                pxs_class_add_reffunc(cls, method_name.c_str(), func);
+            }
+        }
+
+        // Add a str method to the class. Will add for all runtimes supporting.
+        void add_str_method(pxs_Runtime runtime, pxs_Func func) {
+            if (runtime == pxs_Runtime::pxs_Python) {
+                add_method("__str__", func);
+            } else if (runtime == pxs_Runtime::pxs_Lua) {
+                add_method("__tostring", func);
+            } else if (runtime == pxs_Runtime::pxs_JavaScript) {
+                add_method("toString", func);
+            }
+        }
+
+        // Add a str method to the class. Will add for all runtimes.
+        void add_str_method(pxs_Func func) {
+            add_str_method(pxs_Python, func);
+            add_str_method(pxs_Lua, func);
+            add_str_method(pxs_JavaScript, func);
+        }
+
+        // Add a property
+        void add_property(const std::string& name, pxs_Func func) {
+            pxs_class_addprop(cls, name.c_str(), func);
+        }
+
+        // Add a plain data property every instance starts with as `value` (ownership is taken).
+        void add_field(const std::string& name, pxs_VarT value, bool writable = true) {
+            pxs_class_addfield(cls, name.c_str(), value, writable);
+        }
+
+        // Make a HostObject variable owning `ptr`. Freed with `deleter`, `delete` by default.
+        [[nodiscard]] Var make(T* ptr, pxs_DeleterFn deleter = [](void* p) { delete static_cast<T*>(p); }) const {
+            return Var(pxs_newnull(), pxs_newhost(pxs_newinstance(cls, ptr, deleter)));
+        }
     };
 
     // Get runtime from int
@@ -584,6 +1163,16 @@ namespace pxs {
 };
 
 namespace pxs::type {
+    // Hand out a new process wide type tag. Starts at `1 << 16` so hand numbered tags do not collide.
+    inline int32_t new_type_tag() {
+        static std::atomic<int32_t> next{1 << 16};
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // The type tag of `T`, assigned once at static init.
+    template<typename T>
+    inline const int32_t type_tag = new_type_tag();
+
     // pixelscript does not know what a HostObject type is. It is just a void* passed around the host to the caller.
     // So to enforce that what we are receiving is correct. We need to attach a "TYPE" to it. Without the type, UB is possible.
     class Wrapper {
@@ -616,6 +1205,15 @@ namespace pxs::type {
 
                 return static_cast<T*>(wrapper->data);
             }
+
+            // The data as `T` if this wrapper has `expected_type`. Checked against the inline tag only.
+            template<typename T>
+            T* as(int32_t expected_type) const {
+                if (type_tag != expected_type) {
+                    return nullptr;
+                }
+                return static_cast<T*>(data);
+            }
     };
 
     // A `Wrapper` free method
@@ -628,15 +1226,105 @@ namespace pxs::type {
         delete val;
     }
 
+    // A per type pool of `Wrapper`s with their `T` in the same slot. Slots are recycled instead of freed.
+    template<typename T>
+    class Pool {
+        struct Slot {
+            alignas(Wrapper) unsigned char header[sizeof(Wrapper)];
+            alignas(T) unsigned char value[sizeof(T)];
+        };
+        static constexpr size_t SLAB_SLOTS = 64;
+
+        std::mutex lock;
+        std::vector<std::unique_ptr<Slot[]>> slabs;
+        std::vector<Slot*> free_slots;
+
+        Slot* take() {
+            std::lock_guard<std::mutex> guard(lock);
+            if (free_slots.empty()) {
+                slabs.emplace_back(new Slot[SLAB_SLOTS]);
+                for (size_t i = SLAB_SLOTS; i > 0; i--) {
+                    free_slots.push_back(&slabs.back()[i - 1]);
+                }
+            }
+            auto slot = free_slots.back();
+            free_slots.pop_back();
+            return slot;
+        }
+
+        void give(Slot* slot) {
+            std::lock_guard<std::mutex> guard(lock);
+            free_slots.push_back(slot);
+        }
+
+        static void destroy(pxs_Opaque value) {
+            static_cast<T*>(value)->~T();
+        }
+    public:
+        // The pool of `T`.
+        static Pool& shared() {
+            static Pool pool;
+            return pool;
+        }
+
+        // Construct a `T` in a slot and its `Wrapper` with `tag` in front of it.
+        template<typename... Args>
+        Wrapper* make(int32_t tag, Args&&... args) {
+            auto slot = take();
+            T* value = nullptr;
+            try {
+                value = new (slot->value) T(std::forward<Args>(args)...);
+            } catch (...) {
+                give(slot);
+                throw;
+            }
+            return new (slot->header) Wrapper(value, destroy, tag);
+        }
+
+        // A `pxs_DeleterFn` for wrappers from `make`. Destroys the `T` and recycles the slot.
+        static void free(pxs_Opaque wrapper) {
+            if (wrapper == nullptr) {
+                return;
+            }
+
+            auto header = static_cast<Wrapper*>(wrapper);
+            header->~Wrapper();
+            // The header is the first member of its slot.
+            shared().give(reinterpret_cast<Slot*>(header));
+        }
+    };
+
     // A PXS extension class for `pxs_HostObject`.
     template<typename T>
     class Extension {
     public:
-        inline static int32_t ext_type = -1;
+        // Unique per `T` unless assigned by hand.
+        inline static int32_t ext_type = type_tag<T>;
         static T* self(pxs_VarT arg) {
             auto var = pxs::Var(arg);
             return pxs::type::Wrapper::get<T>(var, ext_type);
         }
+
+        // Construct a pooled `T` next to its `Wrapper`. Hand it to pixelscript with `free_pooled` as the deleter, i.e.
+        // `pxs_newinstance(cls, Extension<T>::make(args...), Extension<T>::free_pooled)`.
+        template<typename... Args>
+        static Wrapper* make(Args&&... args) {
+            return Pool<T>::shared().make(ext_type, std::forward<Args>(args)...);
+        }
+
+        // Free a `Wrapper` from `make`.
+        static void free_pooled(pxs_Opaque wrapper) {
+            Pool<T>::free(wrapper);
+        }
+
+        // `T` of arg `idx` in a callback's `args`. One host lookup, then the tag in the `Wrapper` is compared.
+        static T* self(pxs_VarT args, int idx) {
+            auto wrapper = static_cast<Wrapper*>(pxs_gethost(pxs_getrt(args), pxs_arg(args, idx)));
+            if (!wrapper) {
+                return nullptr;
+            }
+            return wrapper->as<T>(ext_type);
+        }
     };
 };
 
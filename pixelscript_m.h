@@ -1,6 +1,32 @@
 #ifndef PIXEL_SCRIPT_M_H
 #define PIXEL_SCRIPT_M_H
 
+// Define `PXS_FRAME_ABI` before including to write handlers for `pxs_addfuncv` (`rt, argc, argv`) instead of a args list.
+#ifdef PXS_FRAME_ABI
+
+// Helpful to not have to write out the method everytime.
+#define PXS_HANDLER(name) pxs_Var* name(pxs_VarT rt, int32_t argc, pxs_VarT* argv)
+
+// Get a arg, NULL when out of range.
+#define PXS_ARG(index) ((index) < argc ? argv[index] : NULL)
+
+// Number of args. Does not include Runtime.
+#define PXS_ARGC() argc
+
+// Get the current runtime via macro
+#define PXS_RT() rt
+
+// Helpful to not have to write out pxs_getint(rt).
+#define PXS_GET_RT() pxs_getint(rt)
+
+// Helpful to not have to write out pxs_newint(runtime).
+#define PXS_NEW_RT(runtime) pxs_newint(runtime)
+
+// Get self
+#define PXS_SELF() PXS_ARG(0)
+
+#else
+
 // Helpful to not have to write out the method everytime.
 #define PXS_HANDLER(name) pxs_Var* name(pxs_VarT args)
 
@@ -22,4 +48,6 @@
 // Get self
 #define PXS_SELF() pxs_listget(args, 1)
 
+#endif // PXS_FRAME_ABI
+
 #endif // PIXEL_SCRIPT_M_H
\ No newline at end of file
@@ -12,9 +12,12 @@ import sys
 CRATE_NAME = "pixelscript"
 LIB_CRATES = ["mlua", CRATE_NAME]
 SOURCE = "pxsb"
-# TODO: Figure out how WASM will work since it needs to use other libs for it to work, gotta have to link something.
 VALID_EXTENSIONS = ["lib", "a", "so", "dylib"]
 full_lib_size = 0
+# Size of every collected lib, printed at the end.
+lib_sizes = {}
+# wasm32 builds go through emscripten, it brings the libc the vendored C needs.
+WASM_TARGET = "wasm32-unknown-emscripten"
 
 
 def convert_path(path:str) -> str:
@@ -32,6 +35,7 @@ def move(old):
     old = convert_path(old)
     ext = get_ext(old)
     file_name = old.split('.')[0].split('/')[-1]
+    lib_sizes[f"{file_name}.{ext}"] = os.path.getsize(old)
     shutil.copy(old, f"{SOURCE}/{file_name}.{ext}")
 
 
@@ -54,6 +58,8 @@ defaults = True
 debug = False
 run_clear = False
 yoyo = False
+wasm = False
+wasm_threads = False
 
 for arg in argv:
     if "target" in arg:
@@ -72,6 +78,11 @@ for arg in argv:
         run_clear = True
     elif arg == "yoyo":
         yoyo = True
+    elif arg == "wasm":
+        wasm = True
+    elif arg == "wasm_threads":
+        wasm = True
+        wasm_threads = True
     elif arg == "help":
         print("""PixelScript script/build.py usage
 Arguments:
@@ -82,13 +93,27 @@ Arguments:
 - clear; clear the cache
 - help; print this message
 - yoyo; include the yoyo_full
+- wasm; build for wasm32 (emscripten) with SIMD128
+- wasm_threads; wasm with shared memory and pthreads, for yoyo.task. Needs a nightly toolchain
 """)
         exit(0)
 
+if wasm:
+    rtarget = WASM_TARGET
+    target = "--target=" + rtarget
+    # The C/C++ of the vendored runtimes follow these, see `build_wasm` in build.rs.
+    rustflags = ["-C target-feature=+simd128"]
+    if wasm_threads:
+        rustflags = ["-C target-feature=+simd128,+atomics,+bulk-memory"]
+    os.environ["RUSTFLAGS"] = (os.environ.get("RUSTFLAGS", "") + " " + " ".join(rustflags)).strip()
+
 build_mode = "release" if not debug else "debug"
 build_flag = "--release" if not debug else ""
 # Build in release mode
 cmd = ["cargo", "build", build_flag]
+if wasm_threads:
+    # std has to be rebuilt with atomics for shared memory.
+    cmd = ["cargo", "+nightly", "build", build_flag, "-Z", "build-std=std,panic_abort"]
 # Grab target and features if passed
 if target:
     cmd += [target]
@@ -138,4 +163,6 @@ for path in os.listdir(build_dir):
             # Search through contents
             collect_libs(full_path)
 
+for name, size in sorted(lib_sizes.items(), key=lambda item: -item[1]):
+    print(f"  {name}: {size / 1000:.1f}kb")
 print(f"Full size of pixelscript: {full_lib_size // 1000000}mb")
@@ -1,6 +1,6 @@
 use crate::{
     js::{
-        SmartJSValue, quickjs,
+        SmartJSValue, object::host_idx, quickjs,
         var::{js_into_pxs, pxs_into_js},
     }, pxs_debug, shared::{PXS_PTR_NAME, func::call_function, object::ObjectFlags, pxs_Runtime, var::pxs_Var}
 };
@@ -11,7 +11,7 @@ unsafe extern "C" fn object_trampoline(
     this_val: quickjs::JSValue,
     argc: i32,
     argv: *mut quickjs::JSValue,
-    _magic: i32,
+    magic: i32,
     func_data: *mut quickjs::JSValue,
 ) -> quickjs::JSValue {
     // Convert JSValue -> vec![pxs_Var]
@@ -27,9 +27,11 @@ unsafe extern "C" fn object_trampoline(
     unsafe {
         let flags = SmartJSValue::new_borrow(*func_data.offset(1), ctx).as_i32().unwrap() as u8;
         if flags & (ObjectFlags::UsesId as u8) != 0 {
-            // Pass pxs_ptr 
-            let pxs_ptr = smart_this.get_prop(PXS_PTR_NAME).as_i32().unwrap();
-            // let pxs_ptr = SmartJSValue::new_borrow(*func_data.offset(1), ctx).as_i32().unwrap();
+            // Pass pxs_ptr, out of the opaque of `this`. The magic is its class.
+            let Some(pxs_ptr) = host_idx(this_val, magic as quickjs::JSClassID) else {
+                let message = format!("{PXS_PTR_NAME} not found, `this` is not a host object.");
+                return SmartJSValue::new_exception(ctx, message, "CallbackRefError".to_string()).dupped_value();
+            };
             pxs_args.push(pxs_Var::new_i64(pxs_ptr as i64));
         } else {
             // Reference
@@ -133,8 +135,8 @@ pub(super) fn create_callback(ctx: *mut quickjs::JSContext, fn_idx: i32) -> Smar
     SmartJSValue::new_owned(function, ctx)
 }
 
-/// Create a JS callback that gets attached to a object.
-pub(super) fn create_object_callback(ctx: *mut quickjs::JSContext, fn_idx: i32, flags: u8) -> SmartJSValue {
+/// Create a JS callback that gets attached to the prototype of host class `class_id`.
+pub(super) fn create_object_callback(ctx: *mut quickjs::JSContext, fn_idx: i32, flags: u8, class_id: quickjs::JSClassID) -> SmartJSValue {
     let idx_wrapper = SmartJSValue::new_i32(ctx, fn_idx);
     let flags_wrapper = SmartJSValue::new_i32(ctx, flags as i32);
     let mut func_data = vec![
@@ -143,7 +145,7 @@ pub(super) fn create_object_callback(ctx: *mut quickjs::JSContext, fn_idx: i32,
     ];
     let func_data_ptr = func_data.as_mut_ptr();
     let function = unsafe {
-        quickjs::JS_NewCFunctionData(ctx, Some(object_trampoline), 0, 0, 2, func_data_ptr)
+        quickjs::JS_NewCFunctionData(ctx, Some(object_trampoline), 0, class_id as i32, 2, func_data_ptr)
     };
     SmartJSValue::new_owned(function, ctx)
 }
\ No newline at end of file
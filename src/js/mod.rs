@@ -1,4 +1,7 @@
-use std::collections::HashMap;
+use std::{
+    collections::{HashMap, HashSet},
+    sync::Arc,
+};
 
 use etffi::{
     borrow_string, create_raw_string,
@@ -10,12 +13,12 @@ use etffi::{
 use crate::{
     js::{
         func::create_callback,
-        module::add_local_module,
+        module::compile_module,
         utils::SmartJSValue,
-        var::{js_into_pxs, pxs_into_js},
+        var::{js_into_pxs, pxs_into_js, register_proxy_class},
     }, pxs_debug, pxs_error, shared::{
-        PXS_METHOD_NAME, PixelScript, PxsRes, PxsResult, pxs_Opaque, read_file,
-        var::{ObjectMethods, pxs_Var},
+        PXS_METHOD_NAME, PixelScript, PxsRes, PxsResult, alloc::{self, MemAccount, MemStats}, budget, gcstats, intern::{self, pxs_Atom}, module::pxs_Module, profiler, pxs_Opaque, pxs_Runtime, read_file, snapshot, startup,
+        tracer::{self, pxs_TraceKind}, var::{ObjectMethods, pxs_Var, pxs_VarMap},
     }, with_feature,
 };
 
@@ -46,12 +49,29 @@ struct State {
     rt: *mut quickjs::JSRuntime,
     /// The `__main__` context. Each thread gets it's own context.
     context: *mut quickjs::JSContext,
-    /// Keep a list of defined PixelObject as class
-    defined_objects: HashMap<String, SmartJSValue>,
+    /// Keep a list of defined PixelObject as class, type name => QuickJS class (only valid in `rt`).
+    /// The prototype of each is owned by `context`, see `object::create_object`.
+    defined_objects: HashMap<String, quickjs::JSClassID>,
     /// Module defined functions or variables takes a map[module_name] => map[int] => export
     module_exports: HashMap<String, Vec<JSModuleMethod>>,
     /// JSModules
     modules: HashMap<String, *mut quickjs::JSModuleDef>,
+    /// Host modules not imported yet, defined by `js_module_loader`. See `module::add_module`.
+    lazy_modules: HashMap<String, Arc<pxs_Module>>,
+    /// Script modules of `reload_module`, found by `js_module_loader` before the file.
+    reloaded: HashMap<String, *mut quickjs::JSModuleDef>,
+    /// Globals kept by `reset_globals`.
+    marked_globals: HashSet<String>,
+    /// Memory of `rt`, its allocator points here so it is boxed.
+    account: Box<MemAccount>,
+    /// False when the host runs the collector (`pxs_setautogc`).
+    auto_gc: bool,
+    /// Bytes at which `pxs_gcstep` collects, while `auto_gc` is off.
+    gc_due: usize,
+    /// `JS_GetGCThreshold` at the last look while `gcstats` watches, 0 when it does not. See `poll_gc`.
+    gc_threshold: usize,
+    /// `JSAtom`s of pixelscript atoms, made on first use. Atom `n` is at `n - 1`, 0 when not made yet.
+    atoms: Vec<quickjs::JSAtom>,
 }
 
 /// Creates a raw pointer with empty values
@@ -62,27 +82,194 @@ fn new_state() -> *mut State {
         defined_objects: HashMap::new(),
         module_exports: HashMap::new(),
         modules: HashMap::new(),
+        lazy_modules: HashMap::new(),
+        reloaded: HashMap::new(),
+        marked_globals: HashSet::new(),
+        account: Box::new(MemAccount::new(alloc::tag(Some(&pxs_Runtime::pxs_JavaScript)))),
+        auto_gc: true,
+        gc_due: JS_GC_THRESHOLD,
+        gc_threshold: 0,
+        atoms: Vec::new(),
     }
     .into_raw()
 }
 
+/// QuickJS' first GC threshold.
+const JS_GC_THRESHOLD: usize = 256 * 1024;
+
+/// Where QuickJS puts the threshold after a collection that left `bytes`.
+fn next_gc_due(bytes: usize) -> usize {
+    (bytes + (bytes >> 1)).max(JS_GC_THRESHOLD)
+}
+
+/// Turn QuickJS' own collections off or back on, per `auto_gc`.
+unsafe fn apply_gc_mode(state: *mut State) {
+    unsafe {
+        if (*state).auto_gc {
+            quickjs::JS_SetGCThreshold((*state).rt, next_gc_due((*state).account.stats().bytes));
+        } else {
+            (*state).gc_due = next_gc_due((*state).account.stats().bytes);
+            quickjs::JS_SetGCThreshold((*state).rt, usize::MAX);
+        }
+        // Moved here, not by a collection.
+        if (*state).gc_threshold != 0 {
+            (*state).gc_threshold = quickjs::JS_GetGCThreshold((*state).rt);
+        }
+    }
+}
+
+/// Start or stop watching the collections QuickJS runs on its own.
+unsafe fn watch_gc(state: *mut State, enabled: bool) {
+    unsafe {
+        (*state).gc_threshold = if enabled && !(*state).rt.is_null() {
+            quickjs::JS_GetGCThreshold((*state).rt).max(1)
+        } else {
+            0
+        };
+    }
+}
+
+/// Look for a collection QuickJS ran on its own since the last look. One moves the threshold to 1.5 times the bytes
+/// left, so runs close together are seen as one. Called after every call into JS.
+fn poll_gc(state: *mut State) {
+    unsafe {
+        if (*state).gc_threshold == 0 || (*state).rt.is_null() {
+            return;
+        }
+        let threshold = quickjs::JS_GetGCThreshold((*state).rt);
+        if threshold != (*state).gc_threshold {
+            (*state).gc_threshold = threshold;
+            gcstats::auto_seen(&pxs_Runtime::pxs_JavaScript, (*state).account.stats().bytes);
+        }
+    }
+}
+
+/// Bytes before every JS allocation, holding its size for `js_malloc_usable_size`.
+/// 16 keeps the memory after it aligned like `malloc`.
+const JS_ALLOC_HEADER: usize = 16;
+
+/// The opaque of every JS allocator function is the `MemAccount` of the state.
+unsafe fn js_account<'a>(opaque: *mut std::ffi::c_void) -> &'a MemAccount {
+    unsafe { &*(opaque as *const MemAccount) }
+}
+
+unsafe extern "C" fn js_host_malloc(opaque: *mut std::ffi::c_void, size: usize) -> *mut std::ffi::c_void {
+    unsafe {
+        let account = js_account(opaque);
+        if !account.resize(0, size) {
+            return std::ptr::null_mut();
+        }
+        let base = alloc::raw_realloc(account.tag(), std::ptr::null_mut(), size + JS_ALLOC_HEADER) as *mut usize;
+        if base.is_null() {
+            account.resize(size, 0);
+            return std::ptr::null_mut();
+        }
+        base.write(size);
+        (base as *mut u8).add(JS_ALLOC_HEADER) as *mut std::ffi::c_void
+    }
+}
+
+unsafe extern "C" fn js_host_calloc(opaque: *mut std::ffi::c_void, count: usize, size: usize) -> *mut std::ffi::c_void {
+    let Some(total) = count.checked_mul(size) else {
+        return std::ptr::null_mut();
+    };
+    unsafe {
+        let ptr = js_host_malloc(opaque, total);
+        if !ptr.is_null() {
+            std::ptr::write_bytes(ptr as *mut u8, 0, total);
+        }
+        ptr
+    }
+}
+
+unsafe extern "C" fn js_host_free(opaque: *mut std::ffi::c_void, ptr: *mut std::ffi::c_void) {
+    if ptr.is_null() {
+        return;
+    }
+    unsafe {
+        let account = js_account(opaque);
+        account.resize(js_host_usable_size(ptr), 0);
+        alloc::raw_free(account.tag(), (ptr as *mut u8).sub(JS_ALLOC_HEADER) as *mut std::ffi::c_void);
+    }
+}
+
+unsafe extern "C" fn js_host_realloc(opaque: *mut std::ffi::c_void, ptr: *mut std::ffi::c_void, size: usize) -> *mut std::ffi::c_void {
+    unsafe {
+        if ptr.is_null() {
+            return js_host_malloc(opaque, size);
+        }
+        if size == 0 {
+            js_host_free(opaque, ptr);
+            return std::ptr::null_mut();
+        }
+        let account = js_account(opaque);
+        let old = js_host_usable_size(ptr);
+        if !account.resize(old, size) {
+            return std::ptr::null_mut();
+        }
+        let base = (ptr as *mut u8).sub(JS_ALLOC_HEADER) as *mut std::ffi::c_void;
+        let base = alloc::raw_realloc(account.tag(), base, size + JS_ALLOC_HEADER) as *mut usize;
+        if base.is_null() {
+            account.resize(size, old);
+            return std::ptr::null_mut();
+        }
+        base.write(size);
+        (base as *mut u8).add(JS_ALLOC_HEADER) as *mut std::ffi::c_void
+    }
+}
+
+unsafe extern "C" fn js_host_usable_size(ptr: *const std::ffi::c_void) -> usize {
+    if ptr.is_null() {
+        return 0;
+    }
+    unsafe { ((ptr as *const u8).sub(JS_ALLOC_HEADER) as *const usize).read() }
+}
+
+/// QuickJS allocator, counting in the states `MemAccount` and going through `pxs_setalloc` when it is set.
+static HOST_MALLOC_FUNCTIONS: quickjs::JSMallocFunctions = quickjs::JSMallocFunctions {
+    js_calloc: Some(js_host_calloc),
+    js_malloc: Some(js_host_malloc),
+    js_free: Some(js_host_free),
+    js_realloc: Some(js_host_realloc),
+    js_malloc_usable_size: Some(js_host_usable_size),
+};
+
 /// Initialize the state.
 fn init(ptr: *mut State) {
     unsafe {
-        let rt = quickjs::JS_NewRuntime();
-        let ctx = quickjs::JS_NewContext(rt);
+        let ctx = startup::step(&pxs_Runtime::pxs_JavaScript, "vm", || {
+            let account = &*(*ptr).account as *const MemAccount as *mut std::ffi::c_void;
+            let rt = quickjs::JS_NewRuntime2(&HOST_MALLOC_FUNCTIONS, account);
+            let limit = (*ptr).account.stats().limit;
+            if limit > 0 {
+                quickjs::JS_SetMemoryLimit(rt, limit);
+            }
+            (*ptr).rt = rt;
+            register_proxy_class(rt);
+            if !(*ptr).auto_gc {
+                apply_gc_mode(ptr);
+            }
+            if gcstats::enabled() {
+                watch_gc(ptr, true);
+            }
+            quickjs::JS_NewContext(rt)
+        });
 
-        (*ptr).rt = rt;
         (*ptr).context = ctx;
 
         // Setup module loader!
         quickjs::JS_SetModuleLoaderFunc(rt, None, Some(js_module_loader), std::ptr::null_mut());
 
-        with_feature!("pxs_json", {
-            // Add pxs_json.js
-            let pxs_json = add_local_module(ctx, include_str!("../../core/js/pxs_json.js"), "pxs_json");
-
-            (*ptr).modules.insert("pxs_json".to_string(), pxs_json);
+        startup::step(&pxs_Runtime::pxs_JavaScript, "core_modules", || {
+            with_feature!("pxs_json", {
+                module::add_module(&crate::pxs_core::pxs_json::module());
+            });
+            with_feature!("pxs_pack", {
+                module::add_module(&crate::pxs_core::pxs_pack::module());
+            });
+            with_feature!("pxs_data", {
+                module::add_module(&crate::pxs_core::pxs_data::module());
+            });
         });
 
         with_feature!("js_commonjs", {
@@ -101,17 +288,47 @@ fn init(ptr: *mut State) {
             globals.set_prop("require", &mut require_func);
         });
 
-        add_main_js();
+        startup::step(&pxs_Runtime::pxs_JavaScript, "globals", add_main_js);
+    }
+}
+
+/// The `JSAtom` of a pixelscript atom in the current threads context.
+fn js_atom(state: *mut State, atom: pxs_Atom) -> PxsRes<quickjs::JSAtom> {
+    let Some(name) = intern::name(atom) else {
+        return pxs_error!("Unknown atom: {atom}");
+    };
+    unsafe {
+        let atoms = &mut (*state).atoms;
+        let idx = atom as usize - 1;
+        if atoms.len() <= idx {
+            atoms.resize(idx + 1, 0);
+        }
+        if atoms[idx] == 0 {
+            atoms[idx] = quickjs::JS_NewAtomLen(get_context(state), name.as_ptr() as *const std::ffi::c_char, name.len());
+        }
+        Ok(atoms[idx])
     }
 }
 
 /// Clear the State
 fn clear(ptr: *mut State) {
     import_all_modules();
+    free_state(ptr);
+}
+
+/// Free the runtime and context of a state, leaving it empty.
+fn free_state(ptr: *mut State) {
     unsafe {
         (*ptr).defined_objects.clear();
         (*ptr).module_exports.clear();
         (*ptr).modules.clear();
+        (*ptr).lazy_modules.clear();
+        (*ptr).reloaded.clear();
+        for atom in (*ptr).atoms.drain(..) {
+            if atom != 0 && !(*ptr).context.is_null() {
+                quickjs::JS_FreeAtom((*ptr).context, atom);
+            }
+        }
         if !(*ptr).context.is_null() {
             quickjs::JS_FreeContext((*ptr).context);
         }
@@ -120,6 +337,7 @@ fn clear(ptr: *mut State) {
         }
         (*ptr).context = std::ptr::null_mut();
         (*ptr).rt = std::ptr::null_mut();
+        (*ptr).gc_threshold = 0;
     }
 }
 
@@ -150,34 +368,35 @@ unsafe extern "C" fn js_module_loader(
         if let Some(module) = (*state).modules.get(name) {
             return *module;
         }
+        if let Some(module) = (*state).reloaded.get(name) {
+            return *module;
+        }
+        if let Some(module) = module::materialize_module(context, name) {
+            return module;
+        }
 
         // Otherwise try to read the file...
-        let contents = read_file(name);
-        if contents.len() == 0 {
-            return std::ptr::null_mut();
-        }
+        tracer::span(pxs_TraceKind::pxs_TraceImport, &pxs_Runtime::pxs_JavaScript, name, || {
+            let contents = read_file(name);
+            if contents.len() == 0 {
+                return std::ptr::null_mut();
+            }
 
-        let mut cstrsafe = CStringSafe::new();
-        // We need to evalute a module
-        let res = quickjs::JS_Eval(
-            context,
-            cstrsafe.new_string(&contents),
-            contents.len(),
-            module_name,
-            (quickjs::JS_EVAL_TYPE_MODULE | quickjs::JS_EVAL_FLAG_COMPILE_ONLY) as i32,
-        );
-        let smart_res = SmartJSValue::new_borrow(res, context);
+            // We need to evalute a module, kept compiled for every later context.
+            let res = snapshot::import(|| compile_module(context, &contents, name));
+            let smart_res = SmartJSValue::new_borrow(res, context);
 
-        // Check exception
-        if smart_res.is_exception() || smart_res.is_error() {
-            pxs_debug!("Error compiling module");
-            return std::ptr::null_mut();
-        }
+            // Check exception
+            if smart_res.is_exception() || smart_res.is_error() {
+                pxs_debug!("Error compiling module");
+                return std::ptr::null_mut();
+            }
 
-        let val_int = smart_res.value.u.ptr as isize;
-        let m = ((val_int & !15) as *mut std::ffi::c_void).cast::<quickjs::JSModuleDef>();
+            let val_int = smart_res.value.u.ptr as isize;
+            let m = ((val_int & !15) as *mut std::ffi::c_void).cast::<quickjs::JSModuleDef>();
 
-        m
+            m
+        })
     }
 }
 
@@ -185,6 +404,27 @@ fn get_js_state() -> *mut State {
     JSTATE.with(|mutex| mutex.get_ptr())
 }
 
+/// Call `f` with each own string property of `globalThis` and its name.
+fn for_each_global(context: *mut quickjs::JSContext, mut f: impl FnMut(quickjs::JSAtom, String)) {
+    let globals = SmartJSValue::globalThis(context);
+    unsafe {
+        let mut tab: *mut quickjs::JSPropertyEnum = std::ptr::null_mut();
+        let mut len: u32 = 0;
+        if quickjs::JS_GetOwnPropertyNames(context, &mut tab, &mut len, globals.value, quickjs::JS_GPN_STRING_MASK as i32) != 0 {
+            return;
+        }
+        for i in 0..len as usize {
+            let atom = (*tab.add(i)).atom;
+            let name = quickjs::JS_AtomToCStringLen(context, std::ptr::null_mut(), atom);
+            if !name.is_null() {
+                f(atom, borrow_string!(name).to_string());
+                quickjs::JS_FreeCString(context, name);
+            }
+        }
+        quickjs::JS_FreePropertyEnum(context, tab, len);
+    }
+}
+
 #[cfg(feature = "js_commonjs")]
 /// Add commonJS `require`
 unsafe extern "C" fn commonjs_require(
@@ -274,6 +514,74 @@ fn run_js(code: &str, file_name: &str, eval_type: i32) -> SmartJSValue {
     }
 }
 
+/// Run JS code as a module, compiled through `compile_module` so it can come from the code cache.
+fn run_js_module(code: &str, file_name: &str) -> SmartJSValue {
+    let context = get_context(get_js_state());
+    unsafe {
+        let module = compile_module(context, code, file_name);
+        if SmartJSValue::new_borrow(module, context).is_exception() {
+            return SmartJSValue::current_exception(context);
+        }
+        let val = quickjs::JS_EvalFunction(context, module);
+
+        let exception = SmartJSValue::current_exception(context);
+        if exception.is_undefined() {
+            let smart = SmartJSValue::new_owned(val, context);
+            if smart.is_promise() {
+                smart.await_value()
+            } else {
+                smart
+            }
+        } else {
+            exception
+        }
+    }
+}
+
+/// QuickJS checks for interrupts about every this many ticks (`JS_INTERRUPT_COUNTER_INIT`), counted as instructions.
+const JS_BUDGET_STEP: u64 = 10000;
+
+/// Interrupt handler while a budget is armed, non zero interrupts the running code.
+unsafe extern "C" fn budget_interrupt(_rt: *mut quickjs::JSRuntime, _opaque: *mut std::ffi::c_void) -> std::ffi::c_int {
+    if profiler::running() {
+        profiler::poll(None);
+    }
+    budget::charge(&pxs_Runtime::pxs_JavaScript, JS_BUDGET_STEP) as std::ffi::c_int
+}
+
+/// Push the frames of the running JS code for a profiler sample, outermost first. Read from the backtrace of a new
+/// `Error` (`    at name (file:line:col)` lines), so only the innermost `Error.stackTraceLimit` frames are there.
+fn profile_frames(frames: &mut Vec<String>) {
+    let context = get_context(get_js_state());
+    if context.is_null() {
+        return;
+    }
+    let error = SmartJSValue::new_owned(unsafe { quickjs::JS_NewError(context) }, context);
+    let Ok(stack) = error.get_prop("stack").as_string() else {
+        return;
+    };
+    let start = frames.len();
+    for line in stack.lines() {
+        let Some(frame) = line.trim().strip_prefix("at ") else {
+            continue;
+        };
+        // Drop the line and column so samples of a function add up.
+        let frame = match (frame.rfind(" ("), frame.ends_with(')')) {
+            (Some(open), true) => {
+                let (name, place) = frame.split_at(open);
+                let place = &place[2..place.len() - 1];
+                match place {
+                    "native" => format!("[host] {name}"),
+                    _ => format!("{name} ({})", place.rsplitn(3, ':').last().unwrap_or(place)),
+                }
+            }
+            _ => frame.to_string(),
+        };
+        frames.push(frame);
+    }
+    frames[start..].reverse();
+}
+
 /// Get JS Name (runs code without global this)
 fn get_js_name(name: &str) -> SmartJSValue {
     run_js(name, "<get_js_name>", quickjs::JS_EVAL_TYPE_GLOBAL as i32)
@@ -281,11 +589,18 @@ fn get_js_name(name: &str) -> SmartJSValue {
 
 /// Add main.js
 fn add_main_js() {
-    run_js(
-        include_str!("../../core/js/main.js"),
-        "main.js",
-        quickjs::JS_EVAL_TYPE_MODULE as i32,
-    );
+    let context = get_context(get_js_state());
+    unsafe {
+        // Compiled apart from running so a snapshot can skip the parse.
+        let module = snapshot::core(|| compile_module(context, include_str!("../../core/js/main.js"), "main.js"));
+        if SmartJSValue::new_borrow(module, context).is_exception() {
+            return;
+        }
+        let res = SmartJSValue::new_owned(quickjs::JS_EvalFunction(context, module), context);
+        if res.is_promise() {
+            let _ = res.await_value();
+        }
+    }
 }
 
 /// Import all modules to initialize the app
@@ -320,17 +635,18 @@ impl PixelScript for JSScripting {
         let state = get_js_state();
         unsafe {
             // let modules = state.modules.borrow();
-            if (*state).modules.contains_key(&source.name) {
+            if (*state).modules.contains_key(&source.name) || (*state).lazy_modules.contains_key(&source.name) {
                 // Don't add it
                 pxs_debug!("JSModule {} already exists.", &source.name);
                 return;
             }
         }
-        module::add_module(get_context(state), &source);
+        module::add_module(&source);
     }
 
     fn execute(code: &str, file_name: &str) -> PxsResult {
-        let res = run_js(code, file_name, quickjs::JS_EVAL_TYPE_MODULE as i32);
+        let res = run_js_module(code, file_name);
+        poll_gc(get_js_state());
         let pxs_res = js_into_pxs(&res);
         if let Err(err) = pxs_res {
             Ok(pxs_Var::new_exception(err.to_string()))
@@ -344,6 +660,40 @@ impl PixelScript for JSScripting {
         }
     }
 
+    fn reload_module(name: &str) -> PxsResult {
+        let state = get_js_state();
+        let context = get_context(state);
+        let contents = read_file(name);
+        if contents.is_empty() {
+            return pxs_error!("{name} was not found.");
+        }
+        unsafe {
+            let module = snapshot::import(|| compile_module(context, &contents, name));
+            if SmartJSValue::new_borrow(module, context).is_exception() {
+                let exception = SmartJSValue::current_exception(context);
+                return pxs_error!("{}", exception.get_error_exception().unwrap_or_default());
+            }
+            let val_int = module.u.ptr as isize;
+            let def = ((val_int & !15) as *mut std::ffi::c_void).cast::<quickjs::JSModuleDef>();
+
+            // ES imports are bound when linked, later `import`s keep finding the first module of this name. `require`
+            // goes through `js_module_loader`, which now returns this one.
+            let val = quickjs::JS_EvalFunction(context, module);
+            let exception = SmartJSValue::current_exception(context);
+            if !exception.is_undefined() {
+                return pxs_error!("{}", exception.get_error_exception().unwrap_or_default());
+            }
+            let res = SmartJSValue::new_owned(val, context);
+            let res = if res.is_promise() { res.await_value() } else { res };
+            if res.is_exception() || res.is_error() {
+                return pxs_error!("{}", res.get_error_exception().unwrap_or_default());
+            }
+            (*state).reloaded.insert(name.to_string(), def);
+        }
+        poll_gc(state);
+        Ok(pxs_Var::new_null())
+    }
+
     fn eval(code: &str, name: &str) -> PxsResult {
         let res = run_js(code, name, quickjs::JS_EVAL_TYPE_GLOBAL as i32);
         js_into_pxs(&res)
@@ -361,6 +711,76 @@ impl PixelScript for JSScripting {
         Self::stop();
     }
 
+    fn detach_thread() -> pxs_Opaque {
+        let state = new_state();
+        unsafe {
+            std::ptr::swap(state, get_js_state());
+        }
+        state as pxs_Opaque
+    }
+
+    fn attach_thread(state: pxs_Opaque) {
+        let state = state as *mut State;
+        unsafe {
+            std::ptr::swap(state, get_js_state());
+            // The runtime was made on another thread, its stack limit is measured from there.
+            let current = get_js_state();
+            if !(*current).rt.is_null() {
+                quickjs::JS_UpdateStackTop((*current).rt);
+            }
+        }
+        free_state(state);
+        let _ = State::from_raw(state);
+    }
+
+    fn arm_budget(_budget: &crate::shared::budget::Budget) {
+        unsafe {
+            quickjs::JS_SetInterruptHandler((*get_js_state()).rt, Some(budget_interrupt), std::ptr::null_mut());
+        }
+    }
+
+    fn disarm_budget() {
+        unsafe {
+            quickjs::JS_SetInterruptHandler((*get_js_state()).rt, None, std::ptr::null_mut());
+        }
+    }
+
+    fn profile_stack(frames: &mut Vec<String>) {
+        profile_frames(frames);
+    }
+
+    fn mark_globals() {
+        let state = get_js_state();
+        unsafe {
+            if (*state).context.is_null() {
+                return;
+            }
+            let mut names = HashSet::new();
+            for_each_global((*state).context, |_, name| {
+                names.insert(name);
+            });
+            (*state).marked_globals = names;
+        }
+    }
+
+    fn reset_globals() {
+        let state = get_js_state();
+        unsafe {
+            let context = (*state).context;
+            if context.is_null() {
+                return;
+            }
+            // `let` and `const` at the top of a global script do not live on `globalThis` and stay.
+            let globals = SmartJSValue::globalThis(context);
+            for_each_global(context, |atom, name| {
+                if !(*state).marked_globals.contains(&name) {
+                    quickjs::JS_DeleteProperty(context, globals.value, atom, 0);
+                }
+            });
+            quickjs::JS_RunGC((*state).rt);
+        }
+    }
+
     fn clear() {
         let state = get_js_state();
         clear(state);
@@ -369,11 +789,11 @@ impl PixelScript for JSScripting {
 
     fn compile(code: &str, global_scope: crate::shared::var::pxs_Var) -> PxsResult {
         // Compile object
-        let mod_obj = run_js(
-            code,
-            "<code_object>",
-            (quickjs::JS_EVAL_FLAG_COMPILE_ONLY | quickjs::JS_EVAL_TYPE_MODULE) as i32,
-        );
+        let context = get_context(get_js_state());
+        let mut mod_obj = SmartJSValue::new_owned(compile_module(context, code, "<code_object>"), context);
+        if mod_obj.is_exception() {
+            mod_obj = SmartJSValue::current_exception(context);
+        }
         if mod_obj.is_exception() || mod_obj.is_error() {
             return pxs_error!("{}", mod_obj.get_error_exception().unwrap());
         }
@@ -442,6 +862,7 @@ impl PixelScript for JSScripting {
 
         // Call method
         let res = pxs_method.call_as_source(&args);
+        poll_gc(state);
 
         if res.is_exception() {
             Ok(pxs_Var::new_exception(res.get_error_exception().unwrap()))
@@ -467,13 +888,106 @@ impl PixelScript for JSScripting {
         }
     }
 
+    fn runtime_stats(stats: &mut pxs_VarMap) {
+        let state = get_js_state();
+        poll_gc(state);
+        unsafe {
+            stats.add_str("defined_objects", pxs_Var::new_i64((*state).defined_objects.len() as i64));
+            stats.add_str("modules", pxs_Var::new_i64((*state).modules.len() as i64));
+            stats.add_str("lazy_modules", pxs_Var::new_i64((*state).lazy_modules.len() as i64));
+            if (*state).rt.is_null() {
+                return;
+            }
+            let mut usage: quickjs::JSMemoryUsage = std::mem::zeroed();
+            quickjs::JS_ComputeMemoryUsage((*state).rt, &mut usage);
+            let fields = [
+                ("malloc_size", usage.malloc_size),
+                ("malloc_limit", usage.malloc_limit),
+                ("malloc_count", usage.malloc_count),
+                ("memory_used_size", usage.memory_used_size),
+                ("memory_used_count", usage.memory_used_count),
+                ("atom_count", usage.atom_count),
+                ("atom_size", usage.atom_size),
+                ("str_count", usage.str_count),
+                ("str_size", usage.str_size),
+                ("obj_count", usage.obj_count),
+                ("obj_size", usage.obj_size),
+                ("prop_count", usage.prop_count),
+                ("prop_size", usage.prop_size),
+                ("shape_count", usage.shape_count),
+                ("shape_size", usage.shape_size),
+                ("js_func_count", usage.js_func_count),
+                ("js_func_size", usage.js_func_size),
+                ("js_func_code_size", usage.js_func_code_size),
+                ("js_func_pc2line_count", usage.js_func_pc2line_count),
+                ("js_func_pc2line_size", usage.js_func_pc2line_size),
+                ("c_func_count", usage.c_func_count),
+                ("array_count", usage.array_count),
+                ("fast_array_count", usage.fast_array_count),
+                ("fast_array_elements", usage.fast_array_elements),
+                ("binary_object_count", usage.binary_object_count),
+                ("binary_object_size", usage.binary_object_size),
+            ];
+            for (key, value) in fields {
+                stats.add_str(key, pxs_Var::new_i64(value));
+            }
+        }
+    }
+
     fn garbage_collect() {
         let state = get_js_state();
         unsafe {
             if !(*state).rt.is_null() {
                 quickjs::JS_RunGC((*state).rt);
+                (*state).account.collected();
+            }
+        }
+    }
+
+    fn gc_step(_budget: std::time::Duration) -> bool {
+        // QuickJS frees by reference count, its collector is only for cycles and not incremental.
+        // So a step collects when QuickJS would have (memory grew by half since the last one), and is free otherwise.
+        let state = get_js_state();
+        unsafe {
+            if (*state).rt.is_null() || (*state).account.stats().bytes < (*state).gc_due {
+                return false;
+            }
+            Self::garbage_collect();
+            (*state).gc_due = next_gc_due((*state).account.stats().bytes);
+        }
+        true
+    }
+
+    fn set_auto_gc(enabled: bool) {
+        let state = get_js_state();
+        unsafe {
+            (*state).auto_gc = enabled;
+            if !(*state).rt.is_null() {
+                apply_gc_mode(state);
+            }
+        }
+    }
+
+    fn mem_stats() -> MemStats {
+        unsafe { (*get_js_state()).account.stats() }
+    }
+
+    fn watch_gc(enabled: bool) {
+        unsafe {
+            watch_gc(get_js_state(), enabled);
+        }
+    }
+
+    fn set_mem_limit(bytes: usize) -> bool {
+        let state = get_js_state();
+        unsafe {
+            (*state).account.set_limit(bytes);
+            // QuickJS also checks it, and throws its out of memory error before asking for the memory.
+            if !(*state).rt.is_null() {
+                quickjs::JS_SetMemoryLimit((*state).rt, bytes);
             }
         }
+        true
     }
 }
 
@@ -514,6 +1028,7 @@ impl ObjectMethods for JSScripting {
             )))
         } else {
             let res = cbk.call_as_source(&argv);
+            poll_gc(state);
             js_into_pxs(&res)
         }
     }
@@ -533,6 +1048,34 @@ impl ObjectMethods for JSScripting {
         js_into_pxs(&res)
     }
 
+    fn var_call_batch(
+        method: &crate::shared::var::pxs_Var,
+        batches: &mut [crate::shared::var::pxs_VarList],
+    ) -> Vec<pxs_Var> {
+        let context = get_context(get_js_state());
+        let smart_val = match pxs_into_js(context, method) {
+            Ok(val) => val,
+            Err(e) => return batches.iter().map(|_| pxs_Var::new_exception(e.to_string())).collect(),
+        };
+
+        // Reused between calls.
+        let mut argv = vec![];
+        batches
+            .iter()
+            .map(|args| {
+                argv.clear();
+                for arg in args.vars.iter() {
+                    match pxs_into_js(context, arg) {
+                        Ok(val) => argv.push(val),
+                        Err(e) => return pxs_Var::new_exception(e.to_string()),
+                    }
+                }
+                js_into_pxs(&smart_val.call_as_source(&argv))
+                    .unwrap_or_else(|e| pxs_Var::new_exception(e.to_string()))
+            })
+            .collect()
+    }
+
     fn get(var: &crate::shared::var::pxs_Var, key: &str) -> PxsResult {
         let state = get_js_state();
         let this = pxs_into_js(get_context(state), var)?;
@@ -555,7 +1098,68 @@ impl ObjectMethods for JSScripting {
         Ok(())
     }
 
+    fn get_atom(var: &crate::shared::var::pxs_Var, key: pxs_Atom) -> PxsResult {
+        let state = get_js_state();
+        let atom = js_atom(state, key)?;
+        let this = pxs_into_js(get_context(state), var)?;
+        let res = this.get_prop_atom(atom);
+
+        js_into_pxs(&res)
+    }
+
+    fn set_atom(
+        var: &crate::shared::var::pxs_Var,
+        key: pxs_Atom,
+        value: &crate::shared::var::pxs_Var,
+    ) -> PxsRes<()> {
+        let state = get_js_state();
+        let atom = js_atom(state, key)?;
+        let this = pxs_into_js(get_context(state), var)?;
+        let mut value = pxs_into_js(get_context(state), value)?;
+
+        this.set_prop_atom(atom, &mut value);
+
+        Ok(())
+    }
+
     fn get_from_name(name: &str) -> PxsResult {
         js_into_pxs(&get_js_name(name))
     }
+
+    fn entries(var: &pxs_Var) -> PxsRes<Vec<(pxs_Var, pxs_Var)>> {
+        let context = get_context(get_js_state());
+        let this = pxs_into_js(context, var)?;
+        if !this.is_object() {
+            return pxs_error!("Var is not a JS object");
+        }
+
+        let mut entries = vec![];
+        unsafe {
+            let mut tab: *mut quickjs::JSPropertyEnum = std::ptr::null_mut();
+            let mut len: u32 = 0;
+            let flags = quickjs::JS_GPN_STRING_MASK | quickjs::JS_GPN_ENUM_ONLY;
+            if quickjs::JS_GetOwnPropertyNames(context, &mut tab, &mut len, this.value, flags as i32) != 0 {
+                let err = SmartJSValue::current_exception(context).get_error_exception().unwrap_or_default();
+                return pxs_error!("{err}");
+            }
+            for i in 0..len as usize {
+                let atom = (*tab.add(i)).atom;
+                let name = quickjs::JS_AtomToCStringLen(context, std::ptr::null_mut(), atom);
+                if name.is_null() {
+                    continue;
+                }
+                let key = pxs_Var::new_string(borrow_string!(name).to_string());
+                quickjs::JS_FreeCString(context, name);
+                match js_into_pxs(&this.get_prop_atom(atom)) {
+                    Ok(value) => entries.push((key, value)),
+                    Err(err) => {
+                        quickjs::JS_FreePropertyEnum(context, tab, len);
+                        return Err(err);
+                    }
+                }
+            }
+            quickjs::JS_FreePropertyEnum(context, tab, len);
+        }
+        Ok(entries)
+    }
 }
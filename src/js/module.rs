@@ -2,7 +2,7 @@ use std::sync::Arc;
 
 use etffi::{borrow_string, cstring::CStringSafe};
 
-use crate::{js::{JSModuleMethod, SmartJSValue, create_callback, get_js_state, pxs_into_js, quickjs}, pxs_debug, shared::module::pxs_Module};
+use crate::{js::{JSModuleMethod, SmartJSValue, create_callback, get_js_state, pxs_into_js, quickjs}, pxs_debug, shared::{module::pxs_Module, pxs_Runtime, snapshot, tracer::{self, pxs_TraceKind}}};
 
 /// Module definition function
 unsafe extern "C" fn init_module_function(ctx: *mut quickjs::JSContext, m: *mut quickjs::JSModuleDef) -> i32 {
@@ -33,14 +33,37 @@ unsafe extern "C" fn init_module_function(ctx: *mut quickjs::JSContext, m: *mut
     0
 }
 
-/// Add a module to JS!
-pub(super) fn add_module(context: *mut quickjs::JSContext, module: &Arc<pxs_Module>) {
+/// Add `module` and its submodules to JS. They are only defined (`define_module`) when the module loader is first
+/// asked for them, most scripts import a few modules of a large API.
+pub(super) fn add_module(module: &Arc<pxs_Module>) {
+    let state = get_js_state();
+    unsafe {
+        (*state).lazy_modules.insert(module.name.clone(), Arc::clone(module));
+    }
+
+    for child in module.modules.iter() {
+        add_module(child);
+    }
+}
+
+/// Define a module of `add_module` if it was not imported yet. None when there is no such module waiting.
+pub(super) fn materialize_module(context: *mut quickjs::JSContext, name: &str) -> Option<*mut quickjs::JSModuleDef> {
+    let state = get_js_state();
+    let module = unsafe { (*state).lazy_modules.remove(name) }?;
+    tracer::span(pxs_TraceKind::pxs_TraceImport, &pxs_Runtime::pxs_JavaScript, name, || define_module(context, &module))
+}
+
+/// Make the C module of `module`, without its submodules.
+fn define_module(context: *mut quickjs::JSContext, module: &Arc<pxs_Module>) -> Option<*mut quickjs::JSModuleDef> {
     let mut cstrsafe = CStringSafe::new();
 
     // Set it up my man
     let js_mod = unsafe {
         quickjs::JS_NewCModule(context, cstrsafe.new_string(&module.name), Some(init_module_function))
     };
+    if js_mod.is_null() {
+        return None;
+    }
 
     let mut exports = vec![];
     // Create trampolines
@@ -49,7 +72,7 @@ pub(super) fn add_module(context: *mut quickjs::JSContext, module: &Arc<pxs_Modu
         let mut cbk = create_callback(context, method.idx);
         cbk.owned = false;
         exports.push(JSModuleMethod{
-            name: method.name.clone(),
+            name: method.name.to_string(),
             value: cbk
         });
         // Add export
@@ -94,26 +117,40 @@ pub(super) fn add_module(context: *mut quickjs::JSContext, module: &Arc<pxs_Modu
         (*state).modules.insert(module.name.clone(), js_mod);
     }
 
-    // Add child modules
-    for child in module.modules.iter() {
-        add_module(context, child);
-    }
+    Some(js_mod)
 }
 
-/// Add a local module to JS engine.
-pub(super) fn add_local_module(context: *mut quickjs::JSContext, code: &str, name: &str) -> *mut quickjs::JSModuleDef {
+/// Compile a module without evaluating it. Same as `JS_Eval` with `JS_EVAL_FLAG_COMPILE_ONLY`.
+///
+/// Uses the bytecode from a loaded snapshot when the source matches, and records the bytecode while recording.
+pub(super) fn compile_module(context: *mut quickjs::JSContext, code: &str, name: &str) -> quickjs::JSValue {
     let mut cstrsafe = CStringSafe::new();
+    unsafe {
+        if let Some(bytecode) = snapshot::cached_chunk(pxs_Runtime::pxs_JavaScript, name, code) {
+            let module = SmartJSValue::new_borrow(
+                quickjs::JS_ReadObject(context, bytecode.as_ptr(), bytecode.len(), quickjs::JS_READ_OBJ_BYTECODE as i32),
+                context,
+            );
+            // Read modules are not resolved yet, compiled ones are resolved by `JS_Eval`.
+            if module.is_module() && quickjs::JS_ResolveModule(context, module.value) == 0 {
+                return module.value;
+            }
+            // A bad chunk, compile the source instead.
+            let _ = SmartJSValue::current_exception(context);
+            quickjs::JS_FreeValue(context, module.value);
+        }
 
-    // Compile module
-    let smart_module = SmartJSValue::new_owned(unsafe {
-        quickjs::JS_Eval(context, cstrsafe.new_string(code), code.len(), cstrsafe.new_string(name), (quickjs::JS_EVAL_TYPE_MODULE | quickjs::JS_EVAL_FLAG_COMPILE_ONLY) as i32)
-    }, context);
+        let module = quickjs::JS_Eval(context, cstrsafe.new_string(code), code.len(), cstrsafe.new_string(name), (quickjs::JS_EVAL_TYPE_MODULE | quickjs::JS_EVAL_FLAG_COMPILE_ONLY) as i32);
 
-    // Check exception
-    if smart_module.is_exception() || smart_module.is_error() {
-        pxs_debug!("Error compiling module");
-        return std::ptr::null_mut();
-    }
+        if snapshot::is_recording(pxs_Runtime::pxs_JavaScript) && SmartJSValue::new_borrow(module, context).is_module() {
+            let mut size: usize = 0;
+            let bytes = quickjs::JS_WriteObject(context, &mut size, module, quickjs::JS_WRITE_OBJ_BYTECODE as i32);
+            if !bytes.is_null() {
+                snapshot::record_chunk(pxs_Runtime::pxs_JavaScript, name, code, std::slice::from_raw_parts(bytes, size).to_vec());
+                quickjs::js_free(context, bytes as *mut std::ffi::c_void);
+            }
+        }
 
-    smart_module.get_module_ptr()
-}
\ No newline at end of file
+        module
+    }
+}
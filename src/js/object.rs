@@ -1,43 +1,118 @@
-use std::sync::Arc;
+use std::{ffi::{CString, c_void}, sync::Arc};
 
-use crate::{js::{SmartJSValue, func::create_object_callback, get_js_state, quickjs}, shared::{PXS_PTR_NAME, object::{ObjectFlags, pxs_PixelObject}}};
+use crate::{js::{SmartJSValue, func::create_object_callback, get_js_state, js_atom, quickjs, var::pxs_into_js}, shared::{PXS_PTR_NAME, intern, object::{ObjectFlags, pxs_PixelObject}}};
 
-pub(super) fn create_object(ctx: *mut quickjs::JSContext, idx: i32, source: Arc<pxs_PixelObject>) -> SmartJSValue {
-    let state = get_js_state();
-    let type_name = &source.type_name;
+/// The object idx kept in the opaque of a host class instance, `None` when `this_val` is not one of `class_id`.
+///
+/// Stored as `idx + 1` so idx 0 is not a null opaque.
+pub(super) fn host_idx(this_val: quickjs::JSValue, class_id: quickjs::JSClassID) -> Option<i32> {
+    let opaque = unsafe { quickjs::JS_GetOpaque(this_val, class_id) };
+    if opaque.is_null() {
+        None
+    } else {
+        Some(opaque as usize as i32 - 1)
+    }
+}
 
-    let object = SmartJSValue::new_object(ctx);
+/// `_pxs_ptr` of host class instances, read out of the opaque. The class id is the magic.
+unsafe extern "C" fn ptr_getter(
+    ctx: *mut quickjs::JSContext,
+    this_val: quickjs::JSValue,
+    _argc: i32,
+    _argv: *mut quickjs::JSValue,
+    magic: i32,
+    _func_data: *mut quickjs::JSValue,
+) -> quickjs::JSValue {
+    match host_idx(this_val, magic as quickjs::JSClassID) {
+        Some(idx) => SmartJSValue::new_i32(ctx, idx).dupped_value(),
+        None => SmartJSValue::new_undefined(ctx).value,
+    }
+}
 
-    // Check if already exist
-    // let mut defined_objects = state.defined_objects.borrow_mut();
-    unsafe { 
-        if let Some(dobj) = (*state).defined_objects.get(type_name) {
-            object.set_prop(PXS_PTR_NAME, &mut SmartJSValue::new_i32(ctx, idx));
-            // Set proto
-            object.set_proto(dobj);
-            return object;
-        }
+/// Register the type of `source` as a QuickJS class with a shared prototype.
+fn define_class(ctx: *mut quickjs::JSContext, source: &pxs_PixelObject) -> quickjs::JSClassID {
+    let state = get_js_state();
+    let mut class_id: quickjs::JSClassID = 0;
+    unsafe {
+        let rt = quickjs::JS_GetRuntime(ctx);
+        quickjs::JS_NewClassID(rt, &mut class_id);
+        // QuickJS copies the name into an atom.
+        let class_name = CString::new(source.type_name.replace('\0', "")).unwrap();
+        let def = quickjs::JSClassDef {
+            class_name: class_name.as_ptr(),
+            // The object is dropped through its `lang_ptr`, not by the instance.
+            finalizer: None,
+            gc_mark: None,
+            call: None,
+            exotic: std::ptr::null_mut(),
+        };
+        quickjs::JS_NewClass(rt, class_id, &def);
     }
 
-    // Create new object
-    for object_cbk in source.callbacks.iter() {
+    let proto = SmartJSValue::new_object(ctx);
+
+    // Methods and properties, keyed by atoms that live as long as the context.
+    for object_cbk in source.callbacks().iter() {
         let module_cbk = &object_cbk.cbk;
         let flags = object_cbk.flags;
+        let Ok(atom) = js_atom(state, intern::intern(&module_cbk.name)) else {
+            continue;
+        };
 
-        let mut func = create_object_callback(ctx, module_cbk.idx, flags);
+        let mut func = create_object_callback(ctx, module_cbk.idx, flags, class_id);
         if flags & (ObjectFlags::IsProp as u8) != 0 {
-            object.add_getter_setter(&module_cbk.name, &func);
+            proto.add_getter_setter_atom(atom, &func, Some(&func));
         } else {
             // Set
-            object.set_prop(&module_cbk.name, &mut func);
+            proto.set_prop_atom(atom, &mut func);
         }
     }
 
-    // Define obj
+    // Fields are data properties of the prototype, assigning a writable one gives the instance its own.
+    for field in source.fields().iter() {
+        let Ok(mut value) = pxs_into_js(ctx, &field.var) else {
+            continue;
+        };
+        if field.writable {
+            proto.set_prop(&field.name, &mut value);
+        } else {
+            proto.set_readonly_prop(&field.name, &mut value);
+        }
+    }
+
+    // `pxs_objectget(_pxs_ptr)` still finds the idx.
+    if let Ok(atom) = js_atom(state, intern::intern(PXS_PTR_NAME)) {
+        let getter = SmartJSValue::new_owned(unsafe {
+            quickjs::JS_NewCFunctionData(ctx, Some(ptr_getter), 0, class_id as i32, 0, std::ptr::null_mut())
+        }, ctx);
+        proto.add_getter_setter_atom(atom, &getter, None);
+    }
+
+    // The context owns the prototype from here.
     unsafe {
-        (*state).defined_objects.insert(type_name.clone(), object);
+        quickjs::JS_SetClassProto(ctx, class_id, proto.dupped_value());
     }
 
-    // Recursion!
-    create_object(ctx, idx, source)
+    class_id
+}
+
+/// Create the JS instance of host object `idx`. Instances are of the QuickJS class of their type, they have no own
+/// properties so they all share one shape, and keep `idx` in their opaque.
+pub(super) fn create_object(ctx: *mut quickjs::JSContext, idx: i32, source: Arc<pxs_PixelObject>) -> SmartJSValue {
+    let state = get_js_state();
+    let type_name = &source.type_name;
+
+    unsafe {
+        let class_id = match (*state).defined_objects.get(type_name) {
+            Some(class_id) => *class_id,
+            None => {
+                let class_id = define_class(ctx, &source);
+                (*state).defined_objects.insert(type_name.clone(), class_id);
+                class_id
+            }
+        };
+        let object = SmartJSValue::new_owned(quickjs::JS_NewObjectClass(ctx, class_id), ctx);
+        quickjs::JS_SetOpaque(object.value, (idx as usize + 1) as *mut c_void);
+        object
+    }
 }
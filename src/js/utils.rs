@@ -372,6 +372,14 @@ impl SmartJSValue {
         }
     }
 
+    /// Get a property off a Value by atom.
+    pub fn get_prop_atom(&self, key: quickjs::JSAtom) -> Self {
+        unsafe {
+            let prop = quickjs::JS_GetProperty(self.context, self.value, key);
+            Self::new_owned(prop, self.context)
+        }
+    }
+
     /// Get a property off a Value.
     pub fn get_prop_pos(&self, key: u32) -> Self {
         unsafe {
@@ -425,6 +433,33 @@ impl SmartJSValue {
         }
     }
 
+    /// Define a property scripts can not assign.
+    ///
+    /// Un owns value
+    pub fn set_readonly_prop(&self, key: &str, value: &mut SmartJSValue) {
+        value.owned = false;
+        unsafe {
+            let mut cstrgen = CStringSafe::new();
+            quickjs::JS_DefinePropertyValueStr(
+                self.context,
+                self.value,
+                cstrgen.new_string(key),
+                value.value,
+                (quickjs::JS_PROP_CONFIGURABLE | quickjs::JS_PROP_ENUMERABLE) as i32,
+            );
+        }
+    }
+
+    /// Set a property by atom
+    /// 
+    /// Un owns property
+    pub fn set_prop_atom(&self, key: quickjs::JSAtom, value: &mut SmartJSValue) {
+        value.owned = false;
+        unsafe {
+            quickjs::JS_SetProperty(self.context, self.value, key, value.value);
+        }
+    }
+
     /// Set a property
     /// 
     /// Un owns property
@@ -479,6 +514,17 @@ impl SmartJSValue {
         }
     }
 
+    /// Add a Getter & Setter by atom. Without `setter` the property can only be read.
+    pub fn add_getter_setter_atom(&self, atom: quickjs::JSAtom, getter: &SmartJSValue, setter: Option<&SmartJSValue>) {
+        unsafe {
+            let setter = match setter {
+                Some(setter) => setter.dupped_value(),
+                None => Self::new_undefined(self.context).value,
+            };
+            quickjs::JS_DefinePropertyGetSet(self.context, self.value, atom, getter.dupped_value(), setter, (quickjs::JS_PROP_CONFIGURABLE | quickjs::JS_PROP_ENUMERABLE) as i32);
+        }
+    }
+
     /// Get a Error/Exception
     pub fn get_error_exception(&self) -> Option<String> {
         if !self.is_error() && !self.is_exception() {
@@ -1,12 +1,12 @@
 // Convert PXS vars to JS vars.
 // Convert JS vars to PXS vars.
 
-use std::{ffi::c_void, sync::Arc};
+use std::{ffi::{c_int, c_void}, sync::{Arc, atomic::{AtomicU32, Ordering}}};
 
 use etffi::ptr_magic::PtrMagic;
 
 use crate::{js::{SmartJSValue, object::create_object, quickjs}, pxs_error, shared::{
-    PxsRes, PxsResult, object::get_object, pxs_Runtime, var::{pxs_Var, pxs_VarObject}
+    PxsRes, PxsResult, map::MapKey, object::get_object, pxs_Runtime, var::{pxs_Var, pxs_VarBuffer, pxs_VarObject, pxs_VarProxy}
 }};
 
 /// JS PXS Container.
@@ -24,6 +24,105 @@ impl JSPXSContainer {
 
 impl PtrMagic for JSPXSContainer {}
 
+/// Class of proxy objects, the same id in every runtime.
+static PROXY_CLASS_ID: AtomicU32 = AtomicU32::new(0);
+
+/// Reads of a proxy object go to its host container.
+static PROXY_EXOTIC: quickjs::JSClassExoticMethods = quickjs::JSClassExoticMethods {
+    get_own_property: Some(proxy_get_own_property),
+    get_own_property_names: None,
+    delete_property: None,
+    define_own_property: None,
+    has_property: None,
+    get_property: None,
+    set_property: None,
+};
+
+/// Releases the proxy handle of a collected proxy object.
+unsafe extern "C" fn proxy_finalizer(_rt: *mut quickjs::JSRuntime, val: quickjs::JSValue) {
+    unsafe {
+        let handle = quickjs::JS_GetOpaque(val, PROXY_CLASS_ID.load(Ordering::Relaxed));
+        if !handle.is_null() {
+            pxs_VarProxy::release_handle(handle);
+        }
+    }
+}
+
+/// `proxy[key]` converts only that item. Lists take indexes and have `length`, maps take their keys.
+unsafe extern "C" fn proxy_get_own_property(
+    ctx: *mut quickjs::JSContext,
+    desc: *mut quickjs::JSPropertyDescriptor,
+    obj: quickjs::JSValue,
+    prop: quickjs::JSAtom,
+) -> c_int {
+    unsafe {
+        let handle = quickjs::JS_GetOpaque(obj, PROXY_CLASS_ID.load(Ordering::Relaxed));
+        if handle.is_null() {
+            return 0;
+        }
+        let proxy = pxs_VarProxy::from_handle(handle);
+
+        let mut len = 0;
+        let name = quickjs::JS_AtomToCStringLen(ctx, &mut len, prop);
+        if name.is_null() {
+            return -1;
+        }
+        let key = String::from_utf8_lossy(std::slice::from_raw_parts(name as *const u8, len)).to_string();
+        quickjs::JS_FreeCString(ctx, name);
+
+        let value = if proxy.target().is_list() && key == "length" {
+            Ok(SmartJSValue::new_i32(ctx, proxy.len() as i32))
+        } else {
+            let item = if proxy.target().is_list() {
+                key.parse::<u32>().ok().and_then(|idx| proxy.get(&pxs_Var::new_i64(idx as i64)))
+            } else {
+                // Property keys are strings, maps can also have int keys.
+                proxy.get(&pxs_Var::new_string(key.clone()))
+                    .or_else(|| key.parse::<i64>().ok().and_then(|k| proxy.get(&pxs_Var::new_i64(k))))
+            };
+            let Some(item) = item else {
+                return 0;
+            };
+            pxs_into_js(ctx, item)
+        };
+
+        match value {
+            Ok(value) => {
+                if !desc.is_null() {
+                    (*desc).flags = quickjs::JS_PROP_ENUMERABLE as i32;
+                    (*desc).value = value.dupped_value();
+                    (*desc).getter = SmartJSValue::new_undefined(ctx).value;
+                    (*desc).setter = SmartJSValue::new_undefined(ctx).value;
+                }
+                1
+            }
+            Err(err) => {
+                let error = SmartJSValue::new_exception(ctx, err.to_string(), "Exception".to_string());
+                quickjs::JS_Throw(ctx, error.dupped_value());
+                -1
+            }
+        }
+    }
+}
+
+/// Add the proxy class to a new runtime.
+pub(super) fn register_proxy_class(rt: *mut quickjs::JSRuntime) {
+    unsafe {
+        let mut id = PROXY_CLASS_ID.load(Ordering::Relaxed);
+        quickjs::JS_NewClassID(rt, &mut id);
+        PROXY_CLASS_ID.store(id, Ordering::Relaxed);
+
+        let def = quickjs::JSClassDef {
+            class_name: c"pxs_proxy".as_ptr(),
+            finalizer: Some(proxy_finalizer),
+            gc_mark: None,
+            call: None,
+            exotic: &PROXY_EXOTIC as *const quickjs::JSClassExoticMethods as *mut quickjs::JSClassExoticMethods,
+        };
+        quickjs::JS_NewClass(rt, id, &def);
+    }
+}
+
 /// JS Object deleters
 unsafe extern "C" fn js_deleter(ptr: *mut c_void) {
     if ptr.is_null() {
@@ -70,6 +169,16 @@ pub(super) fn js_into_pxs(value: &SmartJSValue) -> PxsResult {
         Ok(pxs_Var::new_exception(value.get_error_exception().unwrap()))
     } else if value.is_undefined() || value.is_null() {
         Ok(pxs_Var::new_null())
+    } else if value.is_object() && unsafe { quickjs::JS_GetClassID(value.value) } == PROXY_CLASS_ID.load(Ordering::Relaxed) {
+        // Back to the same container.
+        let handle = unsafe { quickjs::JS_GetOpaque(value.value, PROXY_CLASS_ID.load(Ordering::Relaxed)) };
+        Ok(pxs_Var::new_proxy(unsafe { pxs_VarProxy::from_handle(handle) }))
+    } else if value.is_object() && unsafe { quickjs::JS_IsArrayBuffer(value.value) } {
+        // Copied, the memory belongs to the JS value (even for ArrayBuffers over a `pxs_Buffer`).
+        let mut len = 0;
+        let data = unsafe { quickjs::JS_GetArrayBuffer(value.context, &mut len, value.value) };
+        let bytes = if data.is_null() { vec![] } else { unsafe { std::slice::from_raw_parts(data, len) }.to_vec() };
+        Ok(pxs_Var::new_buffer(pxs_VarBuffer::from_vec(bytes)))
     } else {
         // As object.
         Ok(pxs_Var::new_object(pxs_VarObject::new_lang_only(JSPXSContainer::from_value(value.clone()).into_void()), Some(js_deleter)))
@@ -154,16 +263,16 @@ pub(super) fn pxs_into_js(context: *mut quickjs::JSContext, var: &pxs_Var) -> Px
             let object = SmartJSValue::new_object(context);
             
             let map = var.get_map().unwrap();
-            let keys = map.keys();
-
-            for k in keys {
-                let item = map.get_item(k);
-                if let Some(item) = item {
-                    let js_key = pxs_into_js(context, k)?;
-                    let mut js_val = pxs_into_js(context, item)?;
+            for (k, item) in map.iter() {
+                let js_key = match k {
+                    MapKey::Str(k) => unsafe {
+                        SmartJSValue::new_owned(quickjs::JS_NewStringLen(context, k.as_ptr(), k.as_str().len()), context)
+                    },
+                    MapKey::Var(k) => pxs_into_js(context, k)?,
+                };
+                let mut js_val = pxs_into_js(context, item)?;
 
-                    object.set_prop_value(&js_key, &mut js_val);
-                }
+                object.set_prop_value(&js_key, &mut js_val);
             }
             
             Ok(object)
@@ -171,5 +280,19 @@ pub(super) fn pxs_into_js(context: *mut quickjs::JSContext, var: &pxs_Var) -> Px
         crate::shared::var::pxs_VarType::pxs_Byte => {
             Ok(SmartJSValue::new_i32(context, var.get_byte()? as i32))
         },
+        crate::shared::var::pxs_VarType::pxs_Buffer => {
+            // A copy: scripts can write any ArrayBuffer (`reverse`, `Atomics` even ignore the immutable flag), and host
+            // memory may be read only (i.e. a mapped file) or shared with other threads.
+            let buffer = var.get_buffer().unwrap();
+            let value = unsafe { quickjs::JS_NewArrayBufferCopy(context, buffer.data(), buffer.len()) };
+            Ok(SmartJSValue::new_owned(value, context))
+        },
+        crate::shared::var::pxs_VarType::pxs_Proxy => {
+            let object = SmartJSValue::new_owned(unsafe {
+                quickjs::JS_NewObjectClass(context, PROXY_CLASS_ID.load(Ordering::Relaxed))
+            }, context);
+            unsafe { quickjs::JS_SetOpaque(object.value, var.get_proxy().unwrap().into_handle()) };
+            Ok(object)
+        },
     }
 }
@@ -13,10 +13,11 @@
 // BORROW: the value is borrowed by the library.
 // NULLABLE: means the value can be NULL.
 
-use etffi::{borrow_string, create_raw_string, cstring::CStringSafe, free_raw_string, ptr_magic::PtrMagic};
+use etffi::{borrow_string, create_raw_string, cstring::CStringSafe, ptr_magic::PtrMagic};
 use shared::{func::pxs_Func, var::pxs_Var};
 use std::{
-    ffi::{CString, c_char, c_void},
+    collections::HashSet,
+    ffi::{CStr, CString, c_char, c_void},
     ptr,
     sync::Arc,
 };
@@ -29,18 +30,31 @@ use crate::lua::LuaScripting;
 use crate::python::PythonScripting;
 
 use crate::shared::{
-    PXS_PTR_NAME, PixelScript,
+    PXS_PTR_NAME_C, PixelScript,
+    alloc::{self, pxs_AllocFn, pxs_FreeFn},
     arena::pxs_PixelArena,
-    func::{clear_function_lookup, lookup_add_function},
+    budget::{self, Budget},
+    columns::{self, pxs_Column},
+    context::{current_context, pxs_Context, swap_context, take_home_set},
+    intern::{self, pxs_Atom},
+    map::pxs_MapIter,
+    deferred, filecache, funcstats, gcstats, objstats,
+    func::{FunctionCall, attach_function_lookup, clear_function_lookup, detach_function_lookup, lookup_add_call, lookup_add_function, lookup_len, lookup_reserve, pxs_FuncEntry, pxs_FuncV},
     module::pxs_Module,
-    object::{ObjectFlags, clear_object_lookup, lookup_add_object, pxs_PixelObject},
+    object::{ObjectField, ObjectFlags, attach_object_lookup, clear_object_lookup, detach_object_lookup, live_objects, lookup_add_object, pxs_PixelClass, pxs_PixelObject},
+    profiler,
+    pool::{RuntimeSet, has_own_set, pxs_PoolSetupFn, pxs_RuntimePool, save_own_set, take_own_set},
+    scheduler::{JobCache, WorkerHooks, pxs_Future, pxs_Scheduler},
+    snapshot, startup::{self, pxs_InitOptions}, store,
+    tracer::{self, pxs_TraceKind, pxs_Tracer},
+    watchdog::{self, pxs_Watchdog},
     pxs_LoadFileFn, pxs_Opaque, pxs_ReadDirFn, pxs_Runtime, set_read_dir, set_read_file,
-    var::{ObjectMethods, pxs_DeleterFn, pxs_VarList, pxs_VarT, pxs_VarType},
+    var::{ObjectMethods, live_vars, pxs_DeleterFn, pxs_VarBuffer, pxs_VarList, pxs_VarMap, pxs_VarProxy, pxs_VarT, pxs_VarType},
 };
 
 pub mod shared;
 
-#[cfg(feature = "include-core")]
+#[cfg(any(feature = "include-core", feature = "pxs_json", feature = "pxs_mem", feature = "pxs_pack"))]
 pub mod pxs_core;
 #[cfg(feature = "yoyo")]
 pub mod yoyo;
@@ -67,16 +81,19 @@ macro_rules! with_backend {
             #[cfg(feature = "python")]
             pxs_Runtime::pxs_Python => {
                 type $backend_alias = PythonScripting;
+                deferred::ensure::<PythonScripting>(&pxs_Runtime::pxs_Python);
                 $body
             }
             #[cfg(feature = "lua")]
             pxs_Runtime::pxs_Lua => {
                 type $backend_alias = LuaScripting;
+                deferred::ensure::<LuaScripting>(&pxs_Runtime::pxs_Lua);
                 $body
             }
             #[cfg(feature = "js")]
             pxs_Runtime::pxs_JavaScript => {
                 type $backend_alias = JSScripting;
+                deferred::ensure::<JSScripting>(&pxs_Runtime::pxs_JavaScript);
                 $body
             }
             _ => panic!("Runtime not enabled"),
@@ -99,31 +116,134 @@ pub extern "C" fn pxs_version() -> u32 {
     (major << 16) | (minor << 8) | patch
 }
 
+/// Allocate through `alloc` instead of the C allocator: Lua, pocketpy and QuickJS, and with the `host_alloc`
+/// feature every Rust side allocation (pxs_Var, strings, ...).
+///
+/// Only used once `pxs_setfree` is set too. Set both before `pxs_initialize` (before any other call with
+/// `host_alloc`) and never change them, memory must always go back to the allocator it came from.
+///
+/// `tag` is passed for memory of runtimes without their own tag, and for the Rust side.
+///
+/// tag:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_setalloc(alloc: Option<pxs_AllocFn>, tag: pxs_Opaque) {
+    // No pxs_debug! in these, nothing may allocate before the hooks are set.
+    alloc::set_alloc(alloc, tag);
+}
+
+/// Free through `free`, the pair of `pxs_setalloc`.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_setfree(free: Option<pxs_FreeFn>) {
+    alloc::set_free(free);
+}
+
+/// Give the memory of `runtime` its own tag, i.e. to keep each VM in its own arena.
+///
+/// Lua and JS states take the tag when they are made (`pxs_initialize`, `pxs_startthread`, ...), Python on every allocation,
+/// so set it before `pxs_initialize`.
+///
+/// tag:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_setalloctag(runtime: pxs_Runtime, tag: pxs_Opaque) {
+    alloc::set_tag(&runtime, tag);
+}
+
 /// Initialize the PixelScript runtime.
 #[unsafe(no_mangle)]
 pub extern "C" fn pxs_initialize() {
-    pxs_debug!("pxs_initialize");
+    pxs_initialize_with(ptr::null());
+}
+
+/// Initialize the PixelScript runtime like `pxs_initialize`, with `options` (NULL for the defaults).
+///
+/// With `parallel` Lua and JS start on threads of their own, so they must not need the calling thread (i.e. no
+/// `pxs_setalloc` hooks bound to it). A `deferred` runtime is only started, per thread, by the first call that goes
+/// to it (`pxs_exec`, `pxs_call`, ...), `pxs_addmod` keeps the modules for it until then.
+///
+/// options: BORROW, NULLABLE.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_initialize_with(options: *const pxs_InitOptions) {
+    pxs_debug!("pxs_initialize_with");
+    let options = if options.is_null() { pxs_InitOptions::default() } else { unsafe { *options } };
     unsafe {
         if IS_KILLED {
             panic!("Once finalized, PixelScript can not be initalized again.");
         }
         if !IS_INIT {
-            with_feature!("lua", {
-                LuaScripting::start();
-            });
+            deferred::set_deferred(options.deferred);
+            startup::initialize(|| {
+                if options.parallel {
+                    start_parallel();
+                    return;
+                }
+                with_feature!("lua", {
+                    if !deferred::is_deferred(&pxs_Runtime::pxs_Lua) {
+                        startup::phase(Some(&pxs_Runtime::pxs_Lua), "start", LuaScripting::start);
+                    }
+                });
 
-            with_feature!("python", {
-                PythonScripting::start();
-            });
+                with_feature!("python", {
+                    if !deferred::is_deferred(&pxs_Runtime::pxs_Python) {
+                        startup::phase(Some(&pxs_Runtime::pxs_Python), "start", PythonScripting::start);
+                    }
+                });
 
-            with_feature!("js", {
-                JSScripting::start();
+                with_feature!("js", {
+                    if !deferred::is_deferred(&pxs_Runtime::pxs_JavaScript) {
+                        startup::phase(Some(&pxs_Runtime::pxs_JavaScript), "start", JSScripting::start);
+                    }
+                });
             });
         }
             IS_INIT = true;
     }
 }
 
+/// Start Lua and JS on threads of their own and Python on this one, then move the Lua and JS states here.
+fn start_parallel() {
+    // The states are moved here with this threads function lookup, the core modules must be made in it.
+    #[cfg(any(feature = "include-core", feature = "pxs_json", feature = "pxs_mem", feature = "pxs_pack"))]
+    pxs_core::share_modules(true);
+
+    std::thread::scope(|scope| {
+        // States go between threads as addresses.
+        #[allow(unused_mut)]
+        let mut started: Vec<(pxs_Runtime, std::thread::ScopedJoinHandle<'_, usize>)> = vec![];
+        with_feature!("lua", {
+            if !deferred::is_deferred(&pxs_Runtime::pxs_Lua) {
+                started.push((pxs_Runtime::pxs_Lua, scope.spawn(|| {
+                    startup::phase(Some(&pxs_Runtime::pxs_Lua), "start", LuaScripting::start);
+                    LuaScripting::detach_thread() as usize
+                })));
+            }
+        });
+        with_feature!("js", {
+            if !deferred::is_deferred(&pxs_Runtime::pxs_JavaScript) {
+                started.push((pxs_Runtime::pxs_JavaScript, scope.spawn(|| {
+                    startup::phase(Some(&pxs_Runtime::pxs_JavaScript), "start", JSScripting::start);
+                    JSScripting::detach_thread() as usize
+                })));
+            }
+        });
+
+        with_feature!("python", {
+            if !deferred::is_deferred(&pxs_Runtime::pxs_Python) {
+                startup::phase(Some(&pxs_Runtime::pxs_Python), "start", PythonScripting::start);
+            }
+        });
+
+        for (runtime, handle) in started {
+            let state = handle.join().unwrap_or_else(|panic| std::panic::resume_unwind(panic)) as pxs_Opaque;
+            with_backend!(runtime, Backend => {
+                Backend::attach_thread(state);
+            });
+        }
+    });
+
+    #[cfg(any(feature = "include-core", feature = "pxs_json", feature = "pxs_mem", feature = "pxs_pack"))]
+    pxs_core::share_modules(false);
+}
+
 /// Finalize the PixelScript runtime.
 #[unsafe(no_mangle)]
 pub extern "C" fn pxs_finalize() {
@@ -141,17 +261,38 @@ pub extern "C" fn pxs_finalize() {
     clear_function_lookup();
     // Drop object lookup
     clear_object_lookup();
+    // Drop published data
+    store::clear();
+    // Stop the sampler thread
+    let _ = profiler::stop();
+    funcstats::set_enabled(false);
+    funcstats::reset();
+    objstats::set_enabled(false);
+    objstats::reset();
+    filecache::set_enabled(false);
+    filecache::reset_stats();
+    gcstats::set_enabled(false);
+    gcstats::reset();
+    tracer::set_tracer(None);
+    let _ = tracer::writer_stop();
+    watchdog::set_watchdog(None);
 
     with_feature!("lua", {
-        LuaScripting::stop();
+        if deferred::started_once(&pxs_Runtime::pxs_Lua) {
+            LuaScripting::stop();
+        }
     });
 
     with_feature!("python", {
-        PythonScripting::stop();
+        if deferred::started_once(&pxs_Runtime::pxs_Python) {
+            PythonScripting::stop();
+        }
     });
 
     with_feature!("js", {
-        JSScripting::stop();
+        if deferred::started_once(&pxs_Runtime::pxs_JavaScript) {
+            JSScripting::stop();
+        }
     });
 }
 
@@ -179,7 +320,11 @@ pub extern "C" fn pxs_exec(
     }
 
     with_backend!(runtime, Backend => {
-        let res = Backend::execute(rcode, rfile_name);
+        let res = watchdog::watch(&runtime, rfile_name, "", || {
+            tracer::span(pxs_TraceKind::pxs_TraceExec, &runtime, rfile_name, || {
+                budget::scoped::<Backend, _>(&runtime, || Backend::execute(rcode, rfile_name))
+            })
+        });
         if res.is_err() {
             pxs_Var::new_exception(res.unwrap_err().to_string()).into_raw()
         } else {
@@ -188,6 +333,41 @@ pub extern "C" fn pxs_exec(
     })
 }
 
+#[unsafe(no_mangle)]
+/// Reload the script module `name` of `runtime` in the current threads state: its file is read and run again and
+/// `package.loaded` (Lua), `sys.modules` (Python) or what `require` returns (JS) get the new module. Host modules,
+/// functions, objects and every other module are kept. A module not imported yet is loaded.
+///
+/// Lua copies the new table into the old one and Python runs the new code in the same module object, so scripts
+/// holding the module see the change. ES `import`s in JS stay bound to the first module of a name, only `require`
+/// sees a reload. The file is read from the host even when cached (`pxs_filecache_enable`).
+///
+/// Null means no error, otherwise error. A failed reload leaves the old module in place (Lua and JS).
+///
+/// return:OWNED
+pub extern "C" fn pxs_reload_module(runtime: pxs_Runtime, name: *const c_char) -> pxs_VarT {
+    pxs_debug!("pxs_reload_module");
+    assert_initiated!();
+
+    if name.is_null() {
+        return pxs_Var::new_exception("name is null").into_raw();
+    }
+    let rname = borrow_string!(name);
+    if rname.is_empty() {
+        return pxs_Var::new_exception("name is an empty string").into_raw();
+    }
+
+    with_backend!(runtime, Backend => {
+        let res = tracer::span(pxs_TraceKind::pxs_TraceImport, &runtime, rname, || {
+            filecache::refresh(|| Backend::reload_module(rname))
+        });
+        match res {
+            Ok(var) => var.into_raw(),
+            Err(err) => pxs_Var::new_exception(err.to_string()).into_raw(),
+        }
+    })
+}
+
 /// Free the string created by the pixelscript library
 ///
 /// string:TRANSFER
@@ -227,6 +407,21 @@ pub extern "C" fn pxs_newmod(name: *const c_char) -> *mut pxs_Module {
 pub extern "C" fn pxs_addfunc(module_ptr: *mut pxs_Module, name: *const c_char, func: pxs_Func) {
     pxs_debug!("pxs_addfunc");
     assert_initiated!();
+    add_function_to_module(module_ptr, name, FunctionCall::List(func));
+}
+
+/// Add a callback taking its args as a frame (`rt, argc, argv`) to a module. No args list is created per call.
+///
+/// module_ptr:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_addfuncv(module_ptr: *mut pxs_Module, name: *const c_char, func: pxs_FuncV) {
+    pxs_debug!("pxs_addfuncv");
+    assert_initiated!();
+    add_function_to_module(module_ptr, name, FunctionCall::Frame(func));
+}
+
+/// Add a function to a module
+fn add_function_to_module(module_ptr: *mut pxs_Module, name: *const c_char, func: FunctionCall) {
     if module_ptr.is_null() {
         return;
     }
@@ -255,7 +450,7 @@ pub extern "C" fn pxs_addfunc(module_ptr: *mut pxs_Module, name: *const c_char,
     }
 
     // Save the callback
-    let idx = lookup_add_function(&full_name, func);
+    let idx = lookup_add_call(&full_name, func);
 
     // Now add callback
     module.add_callback(name_str, &full_name, idx);
@@ -290,6 +485,51 @@ pub extern "C" fn pxs_addfuncs(module_ptr: *mut pxs_Module, func_list: pxs_VarT,
     }
 }
 
+/// Add `n` functions from a table of `{name, func}` entries, i.e. the static table of a bindings generator. Room is
+/// made once for all of them and the names are kept without a copy.
+///
+/// module_ptr:BORROW
+/// entries:BORROW, each `name` must be static storage (valid until `pxs_finalize`).
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_addfunctable(module_ptr: *mut pxs_Module, entries: *const pxs_FuncEntry, n: usize) {
+    pxs_debug!("pxs_addfunctable");
+    assert_initiated!();
+
+    if module_ptr.is_null() || entries.is_null() || n == 0 {
+        return;
+    }
+
+    let module = unsafe { pxs_Module::from_borrow(module_ptr) };
+    let entries = unsafe { std::slice::from_raw_parts(entries, n) };
+    module.callbacks.reserve(n);
+    lookup_reserve(n);
+
+    let mut names: HashSet<&str> = module.callbacks.iter().map(|cbk| &*cbk.name).collect();
+    let mut added = Vec::with_capacity(n);
+    for entry in entries.iter() {
+        if entry.name.is_null() {
+            continue;
+        }
+        // The host keeps the name for as long as pixelscript runs.
+        let name: &'static CStr = unsafe { CStr::from_ptr(entry.name) };
+        let Ok(name) = name.to_str() else {
+            pxs_debug!("pxs_addfunctable: name is not utf-8");
+            continue;
+        };
+        if !names.insert(name) {
+            panic!("Function with name: _{}{name} is already defined.", module.name);
+        }
+        added.push((name, entry.func));
+    }
+    drop(names);
+
+    for (name, func) in added {
+        let full_name = format!("_{}{}", module.name, name);
+        let idx = lookup_add_call(&full_name, FunctionCall::List(func));
+        module.add_static_callback(name, full_name, idx);
+    }
+}
+
 /// Add a Varible to a module.
 ///
 /// Pass in the module pointer and variable params.
@@ -353,6 +593,9 @@ pub extern "C" fn pxs_add_submod(parent_ptr: *mut pxs_Module, child_ptr: *mut px
 ///
 /// After this you can forget about the ptr since PM handles it.
 ///
+/// Each runtime only keeps a loader stub per module, its functions, variables and submodules are made on the first
+/// `require`/`import` of it.
+///
 /// module_ptr:TRANSFER
 #[unsafe(no_mangle)]
 pub extern "C" fn pxs_addmod(module_ptr: *mut pxs_Module) {
@@ -364,16 +607,35 @@ pub extern "C" fn pxs_addmod(module_ptr: *mut pxs_Module) {
     }
 
     let module = Arc::new(pxs_Module::from_raw(module_ptr));
+    let functions = module.function_count();
 
     // LUA
     with_feature!("lua", {
-        LuaScripting::add_module(Arc::clone(&module));
+        if !deferred::started(&pxs_Runtime::pxs_Lua) {
+            deferred::defer_module(&pxs_Runtime::pxs_Lua, &module);
+        } else {
+            startup::module(&module.name, functions, &pxs_Runtime::pxs_Lua, || {
+                LuaScripting::add_module(Arc::clone(&module));
+            });
+        }
     });
     with_feature!("python", {
-        PythonScripting::add_module(Arc::clone(&module));
+        if !deferred::started(&pxs_Runtime::pxs_Python) {
+            deferred::defer_module(&pxs_Runtime::pxs_Python, &module);
+        } else {
+            startup::module(&module.name, functions, &pxs_Runtime::pxs_Python, || {
+                PythonScripting::add_module(Arc::clone(&module));
+            });
+        }
     });
     with_feature!("js", {
-        JSScripting::add_module(Arc::clone(&module));
+        if !deferred::started(&pxs_Runtime::pxs_JavaScript) {
+            deferred::defer_module(&pxs_Runtime::pxs_JavaScript, &module);
+        } else {
+            startup::module(&module.name, functions, &pxs_Runtime::pxs_JavaScript, || {
+                JSScripting::add_module(Arc::clone(&module));
+            });
+        }
     });
 
     // Module gets dropped here, and that is good!
@@ -529,6 +791,221 @@ pub extern "C" fn pxs_object_addprop(
     add_callback_to_object(object_borrow, name_borrow, callback, flags);
 }
 
+/// Add a plain data property to a object. Scripts read `value` (and with `writable` assign it) on the object without
+/// calling into the host, read it back with `pxs_objectget`. Only scalars: ints, floats, bools, strings and null.
+///
+/// ptr:BORROW
+/// value:TRANSFER
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_object_addfield(
+    ptr: *mut pxs_PixelObject,
+    name: *const c_char,
+    value: pxs_VarT,
+    writable: bool,
+) {
+    pxs_debug!("pxs_object_addfield");
+    assert_initiated!();
+
+    if ptr.is_null() || name.is_null() || value.is_null() {
+        return;
+    }
+
+    let object_borrow = unsafe { pxs_PixelObject::from_borrow(ptr) };
+    let name_borrow = borrow_string!(name);
+    let value = own_var!(value);
+    if !ObjectField::is_plain(&value) {
+        eprintln!("Field {name_borrow} of {} must be a scalar.", object_borrow.type_name);
+        return;
+    }
+
+    object_borrow.add_field(name_borrow, value, writable);
+}
+
+/// Create a new class.
+///
+/// A class holds the methods and properties of a host type. They are registered once on the class and shared by
+/// every instance created with `pxs_newinstance`. Instead of calling `pxs_object_addfunc` on each object.
+///
+/// Add all callbacks before creating the first instance. A `type_id` < 0 means no type.
+///
+/// Free with `pxs_freeclass`. Instances keep the class alive.
+///
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_newclass(type_name: *const c_char, type_id: i32) -> *mut pxs_PixelClass {
+    pxs_debug!("pxs_newclass");
+    assert_initiated!();
+    if type_name.is_null() {
+        return ptr::null_mut();
+    }
+
+    let type_name = borrow_string!(type_name);
+    Arc::into_raw(Arc::new(pxs_PixelClass::new(type_name, type_id))) as *mut pxs_PixelClass
+}
+
+/// Add a callback to a class
+fn add_callback_to_class(class_ptr: *mut pxs_PixelClass, name: *const c_char, callback: FunctionCall, flags: u8) {
+    if class_ptr.is_null() || name.is_null() {
+        return;
+    }
+
+    // Borrow the handle's Arc without releasing it.
+    let mut class = std::mem::ManuallyDrop::new(unsafe { Arc::from_raw(class_ptr as *const pxs_PixelClass) });
+    let name = borrow_string!(name);
+    if Arc::get_mut(&mut class).is_none() {
+        eprintln!("Can not add {name} to class {} after creating instances.", class.type_name);
+        return;
+    }
+    let class = Arc::get_mut(&mut class).unwrap();
+
+    // Add to function lookup
+    let full_name = format!("_{}{}", class.type_name, name);
+    let idx = lookup_add_call(full_name.as_str(), callback);
+
+    class.add_callback(name, full_name.as_str(), idx, flags);
+}
+
+/// Add a callback to a class.
+///
+/// class_ptr:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_class_addfunc(
+    class_ptr: *mut pxs_PixelClass,
+    name: *const c_char,
+    callback: pxs_Func,
+) {
+    pxs_debug!("pxs_class_addfunc");
+    assert_initiated!();
+
+    add_callback_to_class(class_ptr, name, FunctionCall::List(callback), ObjectFlags::UsesId as u8);
+}
+
+/// Add a callback taking its args as a frame (`rt, argc, argv`) to a class. `argv[0]` is the object.
+///
+/// class_ptr:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_class_addfuncv(
+    class_ptr: *mut pxs_PixelClass,
+    name: *const c_char,
+    callback: pxs_FuncV,
+) {
+    pxs_debug!("pxs_class_addfuncv");
+    assert_initiated!();
+
+    add_callback_to_class(class_ptr, name, FunctionCall::Frame(callback), ObjectFlags::UsesId as u8);
+}
+
+/// Add a callback to a class and make it use the language pointer rather than _pxs_ptr idx.
+///
+/// class_ptr:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_class_add_reffunc(
+    class_ptr: *mut pxs_PixelClass,
+    name: *const c_char,
+    callback: pxs_Func,
+) {
+    pxs_debug!("pxs_class_add_reffunc");
+    assert_initiated!();
+
+    add_callback_to_class(class_ptr, name, FunctionCall::List(callback), ObjectFlags::UsesRef as u8);
+}
+
+/// Add a property to a class. The same as `pxs_object_addprop` but for every instance of the class.
+///
+/// class_ptr:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_class_addprop(
+    class_ptr: *mut pxs_PixelClass,
+    name: *const c_char,
+    callback: pxs_Func,
+) {
+    pxs_debug!("pxs_class_addprop");
+    assert_initiated!();
+
+    let flags = ObjectFlags::UsesId as u8 | ObjectFlags::IsProp as u8;
+    add_callback_to_class(class_ptr, name, FunctionCall::List(callback), flags);
+}
+
+/// Add a plain data property to a class. The same as `pxs_object_addfield` but every instance starts with its own
+/// copy of `value`.
+///
+/// class_ptr:BORROW
+/// value:TRANSFER
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_class_addfield(
+    class_ptr: *mut pxs_PixelClass,
+    name: *const c_char,
+    value: pxs_VarT,
+    writable: bool,
+) {
+    pxs_debug!("pxs_class_addfield");
+    assert_initiated!();
+
+    if class_ptr.is_null() || name.is_null() || value.is_null() {
+        return;
+    }
+
+    let value = own_var!(value);
+    let mut class = std::mem::ManuallyDrop::new(unsafe { Arc::from_raw(class_ptr as *const pxs_PixelClass) });
+    let name = borrow_string!(name);
+    if !ObjectField::is_plain(&value) {
+        eprintln!("Field {name} of {} must be a scalar.", class.type_name);
+        return;
+    }
+    if Arc::get_mut(&mut class).is_none() {
+        eprintln!("Can not add {name} to class {} after creating instances.", class.type_name);
+        return;
+    }
+    let class = Arc::get_mut(&mut class).unwrap();
+
+    class.add_field(name, value, writable);
+}
+
+/// Create a new instance of a class.
+///
+/// The same as `pxs_newtype` but the methods and properties come from the class. Do not add callbacks to the
+/// returned object.
+///
+/// This must be wrapped in a `pxs_newhost` before use within a callback.
+///
+/// Can return nullptr.
+///
+/// class_ptr:BORROW
+/// ptr:OWNED
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_newinstance(
+    class_ptr: *mut pxs_PixelClass,
+    ptr: pxs_Opaque,
+    free_method: pxs_DeleterFn,
+) -> *mut pxs_PixelObject {
+    pxs_debug!("pxs_newinstance");
+    assert_initiated!();
+    if class_ptr.is_null() || ptr.is_null() {
+        return ptr::null_mut();
+    }
+
+    let class = unsafe {
+        Arc::increment_strong_count(class_ptr as *const pxs_PixelClass);
+        Arc::from_raw(class_ptr as *const pxs_PixelClass)
+    };
+    pxs_PixelObject::new_instance(ptr, free_method, class).into_raw()
+}
+
+/// Free a class. Instances that are still alive keep using it.
+///
+/// class_ptr:TRANSFER
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_freeclass(class_ptr: *mut pxs_PixelClass) {
+    pxs_debug!("pxs_freeclass");
+
+    if class_ptr.is_null() {
+        return;
+    }
+
+    let _ = unsafe { Arc::from_raw(class_ptr as *const pxs_PixelClass) };
+}
+
 /// Add a object constructor to a module. This is the same as calling `pxs_addfunc`. Only named differently to distinguish
 /// when a function should be treated as a Object or a Function in your code.
 /// It is not required to call this function in order to expose a `pxs_HostObject` to a module. Any functoin that returns a `pxs_HostObject`
@@ -563,7 +1040,7 @@ pub extern "C" fn pxs_newstring(str: *const c_char) -> pxs_VarT {
 #[unsafe(no_mangle)]
 pub extern "C" fn pxs_newnull() -> pxs_VarT {
     pxs_debug!("pxs_newnull");
-    pxs_Var::new_null().into_raw()
+    pxs_Var::new_null().into_pooled_raw()
 }
 
 /// Make a new HostObject var.
@@ -588,17 +1065,56 @@ pub extern "C" fn pxs_newhost(pixel_object: *mut pxs_PixelObject) -> pxs_VarT {
 
     // Create it in the system
     let idx = lookup_add_object(Arc::clone(&pixel_arc));
+    if idx < 0 {
+        return pxs_Var::new_exception("Too many host objects on this thread").into_raw();
+    }
 
     pxs_Var::new_host_object(idx).into_raw()
 }
 
+/// Make a column view: one HostObject giving scripts `count` rows of the named fields in `columns`, read and written
+/// in place. Scripts call `len()`, `fields()`, `get(field, i)`, `set(field, i, value)`, `read(field, start?, count?)`,
+/// `read_bytes(field, start?, count?)`, `write(field, start, values)` and `fill(field, value, start?, count?)`. A field
+/// is a name or a index into `columns`, rows start at 0 in every language.
+///
+/// The view does not copy the memory. Keep it alive (and in place) until `free(owner)` is called when the view is
+/// collected, make a new view when it moves. On errors `free(owner)` is called right away.
+///
+/// columns:BORROW
+/// owner:TRANSFER
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_newcolumns(
+    count: usize,
+    columns: *const pxs_Column,
+    ncolumns: usize,
+    owner: pxs_Opaque,
+    free: Option<pxs_DeleterFn>,
+) -> pxs_VarT {
+    pxs_debug!("pxs_newcolumns");
+    assert_initiated!();
+
+    let columns = if ncolumns == 0 {
+        &[]
+    } else if columns.is_null() {
+        if let Some(free) = free {
+            unsafe { free(owner) };
+        }
+        return pxs_Var::null_param_ep("columns").into_raw();
+    } else {
+        unsafe { std::slice::from_raw_parts(columns, ncolumns) }
+    };
+
+    columns::new_columns(count, columns, owner, free)
+}
+
 /// Create a new variable int. (i64)
 ///
 /// return:OWNED
 #[unsafe(no_mangle)]
 pub extern "C" fn pxs_newint(val: i64) -> pxs_VarT {
     pxs_debug!("pxs_newint");
-    pxs_Var::new_i64(val).into_raw()
+    pxs_Var::new_i64(val).into_pooled_raw()
 }
 /// Create a new variable uint. (u64)
 ///
@@ -606,7 +1122,7 @@ pub extern "C" fn pxs_newint(val: i64) -> pxs_VarT {
 #[unsafe(no_mangle)]
 pub extern "C" fn pxs_newuint(val: u64) -> pxs_VarT {
     pxs_debug!("pxs_newuint");
-    pxs_Var::new_u64(val).into_raw()
+    pxs_Var::new_u64(val).into_pooled_raw()
 }
 /// Create a new variable bool.
 ///
@@ -614,7 +1130,7 @@ pub extern "C" fn pxs_newuint(val: u64) -> pxs_VarT {
 #[unsafe(no_mangle)]
 pub extern "C" fn pxs_newbool(val: bool) -> pxs_VarT {
     pxs_debug!("pxs_newbool");
-    pxs_Var::new_bool(val).into_raw()
+    pxs_Var::new_bool(val).into_pooled_raw()
 }
 
 /// Create a new variable float. (f64)
@@ -623,7 +1139,7 @@ pub extern "C" fn pxs_newbool(val: bool) -> pxs_VarT {
 #[unsafe(no_mangle)]
 pub extern "C" fn pxs_newfloat(val: f64) -> pxs_VarT {
     pxs_debug!("pxs_newfloat");
-    pxs_Var::new_f64(val).into_raw()
+    pxs_Var::new_f64(val).into_pooled_raw()
 }
 
 /// Call a function on a object, and use a Enum for runtime rather than a var.
@@ -713,7 +1229,7 @@ pub extern "C" fn pxs_objectcall(
     }
 
     with_backend!(runtime, Backend => {
-        let res = Backend::object_call(var_borrow, method_borrow, list);
+        let res = budget::scoped::<Backend, _>(&runtime, || Backend::object_call(var_borrow, method_borrow, list));
         if res.is_err() {
             pxs_Var::new_exception(res.unwrap_err().to_string())
         } else {
@@ -830,41 +1346,138 @@ pub extern "C" fn pxs_getstring(var: *mut pxs_Var) -> *mut c_char {
     create_raw_string!(string.clone())
 }
 
-/// Check if a variable is of a type.
+/// Borrow the string of a `pxs_String` or `pxs_Exception` without copying it.
+///
+/// The result stays valid as long as `var` is alive and unchanged. Do not free it.
 ///
 /// var:BORROW
+/// len: set to the length in bytes without the nul. Can be null.
+/// return:BORROW&NULLABLE
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_varis(var: *mut pxs_Var, var_type: pxs_VarType) -> bool {
-    pxs_debug!("pxs_varis");
+pub extern "C" fn pxs_borrowstring(var: pxs_VarT, len: *mut usize) -> *const c_char {
+    pxs_debug!("pxs_borrowstring");
+    if !len.is_null() {
+        unsafe { *len = 0 };
+    }
     if var.is_null() {
-        return false;
+        return ptr::null();
     }
 
-    let var_borrow = unsafe { pxs_Var::from_borrow(var) };
+    let bv = borrow_var!(var);
+    if !bv.is_string() && !bv.is_exception() {
+        return ptr::null();
+    }
 
-    var_borrow.tag == var_type
+    let raw = unsafe { bv.value.string_val };
+    if raw.is_null() {
+        return ptr::null();
+    }
+    if !len.is_null() {
+        unsafe { *len = CStr::from_ptr(raw).to_bytes().len() };
+    }
+    raw
 }
 
-/// Set a function for reading a file.
+/// View the text of a var without copying it: a `pxs_String` or `pxs_Exception`, or the bytes of a `pxs_Buffer`.
 ///
-/// This is used to load files via import, require, etc
-#[unsafe(no_mangle)]
-pub extern "C" fn pxs_set_filereader(func: pxs_LoadFileFn) {
-    pxs_debug!("pxs_set_filereader");
-    assert_initiated!();
-    set_read_file(func);
-}
-
-/// Set a function for reading a directory.
+/// The result points into the vars own storage and stays valid as long as `var` is alive and unchanged. Do not
+/// free it. Always use `len`, a `pxs_Buffer` is not nul terminated and can hold nul bytes.
 ///
-/// This is used to read a dir.
-#[unsafe(no_mangle)]
+/// var:BORROW
+/// len: set to the length in bytes, 0 when NULL is returned. Required.
+/// return:BORROW&NULLABLE
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_getstrview(var: pxs_VarT, len: *mut usize) -> *const c_char {
+    pxs_debug!("pxs_getstrview");
+    if len.is_null() {
+        return ptr::null();
+    }
+    unsafe { *len = 0 };
+    if var.is_null() {
+        return ptr::null();
+    }
+
+    let bv = borrow_var!(var);
+    if let Some(buffer) = bv.get_buffer() {
+        unsafe { *len = buffer.len() };
+        return buffer.data() as *const c_char;
+    }
+    pxs_borrowstring(var, len)
+}
+
+/// Check if a variable is of a type.
+///
+/// var:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_varis(var: *mut pxs_Var, var_type: pxs_VarType) -> bool {
+    pxs_debug!("pxs_varis");
+    if var.is_null() {
+        return false;
+    }
+
+    let var_borrow = unsafe { pxs_Var::from_borrow(var) };
+
+    var_borrow.tag == var_type
+}
+
+/// Set a function for reading a file.
+///
+/// This is used to load files via import, require, etc
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_set_filereader(func: pxs_LoadFileFn) {
+    pxs_debug!("pxs_set_filereader");
+    assert_initiated!();
+    set_read_file(func);
+}
+
+/// Set a function for reading a directory.
+///
+/// This is used to read a dir.
+#[unsafe(no_mangle)]
 pub extern "C" fn pxs_set_dirreader(func: pxs_ReadDirFn) {
     pxs_debug!("pxs_set_dirreader");
     assert_initiated!();
     set_read_dir(func);
 }
 
+/// Cache what the file and dir readers return (or stop). Each path an import tries is then only read once, from any
+/// runtime or thread, found or not, until `pxs_filecache_invalidate`. Setting a reader empties it.
+/// Off by default, when off a read costs one extra flag check.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_filecache_enable(enabled: bool) {
+    pxs_debug!("pxs_filecache_enable");
+    assert_initiated!();
+
+    filecache::set_enabled(enabled);
+}
+
+/// Mark a file or dir as changed, so the next import reads it again. With a NULL path every cached path is stale,
+/// i.e. call it when mods are reloaded. Returns the cache version, which a NULL path bumps.
+///
+/// path: BORROW, NULLABLE.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_filecache_invalidate(path: *const c_char) -> u64 {
+    pxs_debug!("pxs_filecache_invalidate");
+    assert_initiated!();
+
+    if path.is_null() {
+        return filecache::invalidate(None);
+    }
+    filecache::invalidate(Some(borrow_string!(path)))
+}
+
+/// Stats of the file cache, as a map with `version`, `files` and `dirs` (paths cached), and `hits`/`misses` (reads
+/// served from it or by the reader).
+///
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_filecache_stats() -> pxs_VarT {
+    pxs_debug!("pxs_filecache_stats");
+    assert_initiated!();
+
+    filecache::stats().into_raw()
+}
+
 /// Free a PixelScript var.
 ///
 /// You should only free results from `pxs_object_call`
@@ -879,22 +1492,38 @@ pub extern "C" fn pxs_freevar(var: *mut pxs_Var) {
         return;
     }
 
-    let _ = pxs_Var::from_raw(var);
+    // The node is kept for the next small var.
+    let _ = pxs_Var::from_pooled_raw(var);
 }
 
 /// Tells PixelScript that we are in a new thread.
 #[unsafe(no_mangle)]
 pub extern "C" fn pxs_startthread() {
-    pxs_debug!("pxs_startthread");
+    pxs_startthread_with(u32::MAX);
+}
+
+/// Tells PixelScript that we are in a new thread, like `pxs_startthread`, starting only the runtimes in `mask` (bits
+/// of `1 << pxs_Runtime`) now. The others start on this thread with the first call that goes to them, modules added
+/// for them are kept until then. A worker that only runs Lua passes `1 << pxs_Lua` and never makes the other VMs.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_startthread_with(mask: u32) {
+    pxs_debug!("pxs_startthread_with");
     assert_initiated!();
+    deferred::set_lazy(!mask);
     with_feature!("lua", {
-        LuaScripting::start_thread();
+        if !deferred::is_deferred(&pxs_Runtime::pxs_Lua) {
+            startup::phase(Some(&pxs_Runtime::pxs_Lua), "start_thread", LuaScripting::start_thread);
+        }
     });
     with_feature!("python", {
-        PythonScripting::start_thread();
+        if !deferred::is_deferred(&pxs_Runtime::pxs_Python) {
+            startup::phase(Some(&pxs_Runtime::pxs_Python), "start_thread", PythonScripting::start_thread);
+        }
     });
     with_feature!("js", {
-        JSScripting::start_thread();
+        if !deferred::is_deferred(&pxs_Runtime::pxs_JavaScript) {
+            startup::phase(Some(&pxs_Runtime::pxs_JavaScript), "start_thread", JSScripting::start_thread);
+        }
     });
 }
 
@@ -904,369 +1533,606 @@ pub extern "C" fn pxs_stopthread() {
     pxs_debug!("pxs_stopthread");
     assert_initiated!();
     with_feature!("lua", {
-        LuaScripting::stop_thread();
+        if deferred::started(&pxs_Runtime::pxs_Lua) {
+            LuaScripting::stop_thread();
+        }
     });
     with_feature!("python", {
-        PythonScripting::stop_thread();
+        if deferred::started(&pxs_Runtime::pxs_Python) {
+            PythonScripting::stop_thread();
+        }
     });
     with_feature!("js", {
-        JSScripting::stop_thread();
+        if deferred::started(&pxs_Runtime::pxs_JavaScript) {
+            JSScripting::stop_thread();
+        }
     });
+    deferred::stopped();
 }
 
-/// Clear the current threads state for all languages.
-///
-/// Optionally, if you want to run the garbage collector.
-#[unsafe(no_mangle)]
-pub extern "C" fn pxs_clear() {
-    pxs_debug!("pxs_clear");
-    assert_initiated!();
-    // Drop function lookup
-    clear_function_lookup();
-    // Drop object lookup
-    clear_object_lookup();
+/// Take the current threads state for every language out, leaving it empty.
+fn detach_runtime_set() -> RuntimeSet {
+    let mut set = RuntimeSet::empty();
+    with_feature!("lua", {
+        set.lua = LuaScripting::detach_thread();
+    });
+    with_feature!("python", {
+        set.python = PythonScripting::detach_thread();
+    });
+    with_feature!("js", {
+        set.js = JSScripting::detach_thread();
+    });
+    set.functions = detach_function_lookup();
+    set.objects = detach_object_lookup();
+    set.starts = deferred::detach();
+    set
+}
 
+/// Make `set` the current threads state for every language. The thread must be empty, i.e. just detached.
+fn attach_runtime_set(set: RuntimeSet) {
     with_feature!("lua", {
-        LuaScripting::clear();
+        LuaScripting::attach_thread(set.lua);
     });
     with_feature!("python", {
-        PythonScripting::clear();
+        PythonScripting::attach_thread(set.python);
     });
     with_feature!("js", {
-        JSScripting::clear();
-    })
+        JSScripting::attach_thread(set.js);
+    });
+    attach_function_lookup(set.functions);
+    attach_object_lookup(set.objects);
+    deferred::attach(set.starts);
 }
 
-/// Call a method within a specifed runtime.
+/// Create a pool of `count` runtime sets, each what `pxs_startthread` would build for a new thread.
 ///
-/// Runtime is a `pxs_Var`.
+/// `setup` is called once per set while it is the current threads state, add modules there with `pxs_addmod`.
+/// Globals that exist after `setup` are kept, `pxs_pool_release` removes the rest.
 ///
-/// Transfers ownership of args.
+/// Python has 16 VMs in total (one is the main thread), so at most 15 sets get a Python VM.
 ///
-/// runtime:BORROW
-/// args:TRANSFER
+/// setup:BORROW
+/// opaque:BORROW
 /// return:OWNED
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_call(
-    runtime: *mut pxs_Var,
-    method: *const c_char,
-    args: *mut pxs_Var,
-) -> *mut pxs_Var {
-    pxs_debug!("pxs_call");
+pub extern "C" fn pxs_pool_create(count: u32, setup: Option<pxs_PoolSetupFn>, opaque: pxs_Opaque) -> *mut pxs_RuntimePool {
+    pxs_debug!("pxs_pool_create");
     assert_initiated!();
 
-    if runtime.is_null() || method.is_null() || args.is_null() {
-        return pxs_Var::null_params_ep().into_raw();
+    let own = detach_runtime_set();
+    let mut sets = Vec::with_capacity(count as usize);
+    for _ in 0..count {
+        pxs_startthread();
+        if let Some(setup) = setup {
+            unsafe {
+                setup(opaque);
+            }
+        }
+        with_feature!("lua", {
+            if deferred::started(&pxs_Runtime::pxs_Lua) {
+                LuaScripting::mark_globals();
+            }
+        });
+        with_feature!("python", {
+            if deferred::started(&pxs_Runtime::pxs_Python) {
+                PythonScripting::mark_globals();
+            }
+        });
+        with_feature!("js", {
+            if deferred::started(&pxs_Runtime::pxs_JavaScript) {
+                JSScripting::mark_globals();
+            }
+        });
+        sets.push(detach_runtime_set());
     }
+    attach_runtime_set(own);
 
-    let runtime_var = unsafe { pxs_Var::from_borrow(runtime) };
-    let runtime_id = pxs_getint(runtime_var);
+    pxs_RuntimePool::new(sets).into_raw()
+}
 
-    // Borrow runtime, var, and method, and argv
-    let runtime_borrow = pxs_Runtime::from_i64(runtime_id);
-    let method_borrow = borrow_string!(method);
-    // Own args
-    let args = own_var!(args);
-    if !args.is_list() {
-        return pxs_Var::incorrect_type_ep(pxs_VarType::pxs_List, args.tag).into_raw();
+/// Use a set from `pool` as this threads runtime state, instead of `pxs_startthread`.
+///
+/// Returns false when every set is in use or this thread already has one.
+///
+/// pool:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_pool_acquire(pool: *mut pxs_RuntimePool) -> bool {
+    pxs_debug!("pxs_pool_acquire");
+    assert_initiated!();
+    if pool.is_null() || has_own_set() {
+        return false;
     }
-    let list = args.get_list().unwrap();
 
-    // Get runtime
-    if let Some(rt) = runtime_borrow {
-        with_backend!(rt, Backend => {
-            let res = Backend::call_method(method_borrow, list);
-            if res.is_err() {
-                pxs_Var::new_exception(res.unwrap_err().to_string())
-            } else {
-                res.unwrap()
-            }
-        })
-        .into_raw()
-    } else {
-        pxs_Var::unkown_runtime_ep(runtime_id).into_raw()
-    }
+    let Some(set) = (unsafe { (*pool).take() }) else {
+        return false;
+    };
+    save_own_set(detach_runtime_set());
+    attach_runtime_set(set);
+    true
 }
 
-/// Call a ToString method on this Var. If already a string, it won't call it.
+/// Give this threads set back to `pool` and restore the state the thread had before `pxs_pool_acquire`.
 ///
-/// Host must free this memory with `pxs_free_var`
+/// Script globals defined since the pool was made are removed, the runtimes themselves are kept.
+/// Free every var that came from this set before releasing it.
 ///
-/// runtime_var:BORROW
-/// var:BORROW
-/// return:OWNED
+/// Returns false if this thread does not have a set.
+///
+/// pool:BORROW
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_tostring(runtime_var: *mut pxs_Var, var: *mut pxs_Var) -> *mut pxs_Var {
-    pxs_debug!("pxs_tostring");
+pub extern "C" fn pxs_pool_release(pool: *mut pxs_RuntimePool) -> bool {
+    pxs_debug!("pxs_pool_release");
     assert_initiated!();
-
-    if var.is_null() || runtime_var.is_null() {
-        return pxs_Var::null_params_ep().into_raw();
+    if pool.is_null() {
+        return false;
     }
 
-    // Borrow
-    let b_var = unsafe { pxs_Var::from_borrow(var) };
-
-    // If string or primative, no object calling needed
-    match b_var.tag {
-        pxs_VarType::pxs_Int64 => {
-            let val = b_var.get_i64().unwrap();
-            return pxs_Var::new_string(val.to_string()).into_raw();
-        }
-        pxs_VarType::pxs_UInt64 => {
-            let val = b_var.get_u64().unwrap();
-            return pxs_Var::new_string(val.to_string()).into_raw();
-        }
-        pxs_VarType::pxs_String | pxs_VarType::pxs_Exception => {
-            return pxs_Var::new_string(b_var.get_string().unwrap().clone()).into_raw();
-        }
-        pxs_VarType::pxs_Bool => {
-            return pxs_Var::new_string(b_var.get_bool().unwrap().to_string()).into_raw();
-        }
-        pxs_VarType::pxs_Float64 => {
-            return pxs_Var::new_string(b_var.get_f64().unwrap().to_string()).into_raw();
+    let Some(own) = take_own_set() else {
+        return false;
+    };
+    with_feature!("lua", {
+        if deferred::started(&pxs_Runtime::pxs_Lua) {
+            LuaScripting::reset_globals();
         }
-        pxs_VarType::pxs_Null => {
-            return pxs_Var::new_string("null".to_string()).into_raw();
+    });
+    with_feature!("python", {
+        if deferred::started(&pxs_Runtime::pxs_Python) {
+            PythonScripting::reset_globals();
         }
-        _ => {
-            // Do nothing
+    });
+    with_feature!("js", {
+        if deferred::started(&pxs_Runtime::pxs_JavaScript) {
+            JSScripting::reset_globals();
         }
+    });
+    let set = detach_runtime_set();
+    attach_runtime_set(own);
+    unsafe {
+        (*pool).put(set);
     }
+    true
+}
 
-    // Not a string, so let's convert
-    let runtime = unsafe { pxs_Runtime::from_var_ptr(runtime_var) };
-    if let Some(runtime) = runtime {
-        let args = pxs_Var::new_list();
-        let list = args.get_list().unwrap();
-        list.add_item(b_var.shallow_copy());
-        let res = match runtime {
-            pxs_Runtime::pxs_Lua => {
-                with_feature!("lua", { LuaScripting::call_method("tostring", list) }, {
-                    return pxs_Var::feature_not_enabled_ep("lua").into_raw();
-                })
-            }
-            pxs_Runtime::pxs_Python => {
-                with_feature!("python", { PythonScripting::call_method("str", list) }, {
-                    return pxs_Var::feature_not_enabled_ep("python").into_raw();
-                })
-            }
-            pxs_Runtime::pxs_JavaScript => {
-                with_feature!(
-                    "js",
-                    {
-                        // Check variable is null.
-                        if pxs_varis(var, pxs_VarType::pxs_Null) {
-                            return pxs_Var::new_string("null".to_owned()).into_raw();
-                        }
-
-                        let mut empty_list = pxs_VarList::new();
-                        JSScripting::object_call(b_var, "toString", &mut empty_list)
-                    },
-                    {
-                        return pxs_Var::feature_not_enabled_ep("js").into_raw();
-                    }
-                )
-            }
-            pxs_Runtime::pxs_Wren => {
-                todo!()
-            }
-        };
+/// Free a pool and every set in it. Every set must be released first, sets still in use are not freed.
+///
+/// pool:TRANSFER
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_pool_free(pool: *mut pxs_RuntimePool) {
+    pxs_debug!("pxs_pool_free");
+    assert_initiated!();
+    if pool.is_null() {
+        return;
+    }
 
-        if let Ok(res) = res {
-            res.into_raw()
-        } else {
-            pxs_Var::new_exception(res.unwrap_err().to_string()).into_raw()
-        }
-    } else {
-        pxs_Var::unkown_runtime_var_ep(runtime_var).into_raw()
+    let pool = pxs_RuntimePool::from_raw(pool);
+    let own = detach_runtime_set();
+    for set in pool.drain() {
+        attach_runtime_set(set);
+        // Same order as `pxs_finalize`, objects hold language memory.
+        clear_function_lookup();
+        clear_object_lookup();
+        // Leaves the thread empty again for the next set.
+        pxs_stopthread();
     }
+    attach_runtime_set(own);
 }
 
-/// Create a new pxs_VarList.
+/// Create a context: its own runtime state for every language, plus its own host functions and objects.
 ///
-/// This does not take any arguments. To add to a list, you must call `pxs_var_list_add(ptr, item)`
+/// `setup` is called once while the new context is the current threads state, add modules there with `pxs_addmod`.
+/// Like a new thread, each context with Python takes one of the 16 Python VMs.
 ///
+/// setup:BORROW
+/// opaque:BORROW
 /// return:OWNED
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_newlist() -> *mut pxs_Var {
-    pxs_debug!("pxs_newlist");
+pub extern "C" fn pxs_newcontext(setup: Option<pxs_PoolSetupFn>, opaque: pxs_Opaque) -> *mut pxs_Context {
+    pxs_debug!("pxs_newcontext");
     assert_initiated!();
 
-    pxs_Var::new_list().into_raw()
+    let own = detach_runtime_set();
+    pxs_startthread();
+    if let Some(setup) = setup {
+        unsafe {
+            setup(opaque);
+        }
+    }
+    let set = detach_runtime_set();
+    attach_runtime_set(own);
+
+    pxs_Context::new(set).into_raw()
 }
 
-/// Add a item to a pxs_VarList.
-///
-/// Expects a pointer to pxs_VarList. And a pointer for the item to add (pxs_Var*)
+/// Make `context` the current threads state, NULL to go back to the threads own state.
 ///
-/// This will take ownership of the added item. If you want to copy it instead first create a new `pxs_Var` with `pxs_var_newcopy(item)`
+/// Switching only swaps pointers, nothing is created or cleared. Vars of one context must not be used in another.
 ///
-/// Will return the index added at.
+/// Returns false if `context` is current on another thread, or this thread uses a set from `pxs_pool_acquire`.
 ///
-/// list:BORROW
-/// item:TRANSFER
+/// context:BORROW
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_listadd(list: *mut pxs_Var, item: *mut pxs_Var) -> i32 {
-    pxs_debug!("pxs_listadd");
+pub extern "C" fn pxs_setcontext(context: *mut pxs_Context) -> bool {
+    pxs_debug!("pxs_setcontext");
     assert_initiated!();
-
-    // Check null
-    if list.is_null() || item.is_null() {
-        return -1;
+    if has_own_set() {
+        return false;
+    }
+    if context == current_context() {
+        return true;
     }
 
-    // Borrow list
-    let borrow_list = unsafe { pxs_Var::from_borrow(list) };
-    // Check that this is actually a list
-    if !borrow_list.is_list() {
-        return -1;
+    let set = if context.is_null() {
+        take_home_set()
+    } else {
+        unsafe { (*context).take() }
+    };
+    let Some(set) = set else {
+        return false;
+    };
+    let previous = detach_runtime_set();
+    attach_runtime_set(set);
+    swap_context(context, previous);
+    true
+}
+
+/// Free a context and its runtime states. If it is current on this thread, the thread goes back to its own state first.
+///
+/// A context that is current on another thread is not freed.
+///
+/// context:TRANSFER
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_freecontext(context: *mut pxs_Context) {
+    pxs_debug!("pxs_freecontext");
+    assert_initiated!();
+    if context.is_null() {
+        return;
+    }
+    if context == current_context() {
+        pxs_setcontext(std::ptr::null_mut());
     }
 
-    // and own item
-    let owned_item = pxs_Var::from_raw(item);
+    let context = pxs_Context::from_raw(context);
+    let Some(set) = context.take() else {
+        return;
+    };
+    let own = detach_runtime_set();
+    attach_runtime_set(set);
+    // Same order as `pxs_finalize`, objects hold language memory.
+    clear_function_lookup();
+    clear_object_lookup();
+    pxs_stopthread();
+    attach_runtime_set(own);
+}
 
-    // Get varlist and add item
-    let varlist = borrow_list.get_list().unwrap();
-    varlist.add_item(owned_item);
+/// Run a `pxs_submit` job on a worker, compiling `code` once per worker.
+fn run_job(cache: &mut JobCache, runtime: pxs_Runtime, code: &str, args: pxs_Var) -> pxs_Var {
+    let key = (runtime.into_i64(), code.to_string());
+    if !cache.contains_key(&key) {
+        let compiled = with_backend!(runtime.clone(), Backend => {
+            Backend::compile(code, pxs_Var::new_null())
+        });
+        match compiled {
+            Ok(compiled) if compiled.is_list() => {
+                // Same layout as `pxs_compile`.
+                compiled.get_list().unwrap().insert_item(0, runtime.into_var());
+                cache.insert(key.clone(), compiled);
+            }
+            Ok(other) => return other,
+            Err(e) => return pxs_Var::new_exception(e),
+        }
+    }
 
-    // Return index
-    (varlist.vars.len() - 1) as i32
+    // The cache keeps the code object, the copy does not free it.
+    let object = cache.get(&key).unwrap().shallow_copy();
+    let res = with_backend!(runtime, Backend => {
+        match budget::scoped::<Backend, _>(&runtime, || Backend::exec_object(object, args)) {
+            Ok(res) => res,
+            Err(e) => pxs_Var::new_exception(e),
+        }
+    });
+
+    if res.is_portable() {
+        res
+    } else {
+        pxs_Var::new_exception(format!("Job result of type {:#?} can not leave the worker thread", res.tag))
+    }
 }
 
-/// Get a item from a pxs_VarList.
+/// Create a scheduler with `workers` threads, each with its own runtime states, for `pxs_submit`.
 ///
-/// Expcts a pointer to pxs_VarList. And a index of i32. Supports negative indexes just like in Python.
+/// `setup` is called on every worker thread after `pxs_startthread`, add modules there with `pxs_addmod`.
+/// It runs on several threads at once.
 ///
-/// This will NOT return a cloned variable, you must NOT free it.
+/// Python has 16 VMs in total (one is the main thread), so at most 15 workers get a Python VM.
 ///
-/// list:BORROW
-/// return:BORROW&NULLABLE
+/// setup:BORROW
+/// opaque:BORROW
+/// return:OWNED
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_listget(list: *mut pxs_Var, index: i32) -> *mut pxs_Var {
-    pxs_debug!("pxs_listget");
+pub extern "C" fn pxs_newscheduler(workers: u32, setup: Option<pxs_PoolSetupFn>, opaque: pxs_Opaque) -> *mut pxs_Scheduler {
+    pxs_debug!("pxs_newscheduler");
     assert_initiated!();
 
-    if list.is_null() {
-        return ptr::null_mut();
+    // Raw pointers are not `Send`, the host promises `opaque` can be shared.
+    let opaque = opaque as usize;
+    let hooks = WorkerHooks {
+        start: Box::new(move || {
+            pxs_startthread();
+            if let Some(setup) = setup {
+                unsafe {
+                    setup(opaque as pxs_Opaque);
+                }
+            }
+        }),
+        run: run_job,
+        stop: || {
+            clear_function_lookup();
+            clear_object_lookup();
+            pxs_stopthread();
+        },
+    };
+
+    pxs_Scheduler::new(workers as usize, hooks).into_raw()
+}
+
+/// Run `code` on one of the scheduler's workers. Returns right away with a future for the result.
+///
+/// The code is compiled once per worker and run like `pxs_execobject`, `args` is its local scope.
+/// `args` must be a `pxs_Map` or null holding only plain data (numbers, strings, bools, lists and maps of those),
+/// and so must the result. Anything else is bound to the thread that made it.
+///
+/// A exception is reported through the future.
+///
+/// scheduler:BORROW
+/// args:TRANSFER
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_submit(
+    scheduler: *mut pxs_Scheduler,
+    runtime: pxs_Runtime,
+    code: *const c_char,
+    args: pxs_VarT,
+) -> *mut pxs_Future {
+    pxs_debug!("pxs_submit");
+    assert_initiated!();
+
+    let args = if args.is_null() { pxs_Var::new_null() } else { pxs_Var::from_raw(args) };
+    if scheduler.is_null() || code.is_null() {
+        let future = pxs_Future::new();
+        future.set(pxs_Var::null_params_ep());
+        return Arc::into_raw(Arc::new(future)) as *mut pxs_Future;
+    }
+    if (!args.is_map() && !args.is_null()) || !args.is_portable() {
+        let future = pxs_Future::new();
+        future.set(pxs_Var::new_exception("`args` must be a Map or Null of plain data".to_string()));
+        return Arc::into_raw(Arc::new(future)) as *mut pxs_Future;
     }
 
-    // Get list
-    let borrow_list = unsafe { pxs_Var::from_borrow(list) };
-    if !borrow_list.is_list() {
-        return pxs_Var::incorrect_type_ep(pxs_VarType::pxs_List, borrow_list.tag).into_raw();
+    let code = borrow_string!(code).to_string();
+    let future = unsafe { (*scheduler).submit(runtime, code, args) };
+    Arc::into_raw(future) as *mut pxs_Future
+}
+
+/// Has the job of `future` finished?
+///
+/// future:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_future_ready(future: *mut pxs_Future) -> bool {
+    pxs_debug!("pxs_future_ready");
+    if future.is_null() {
+        return false;
     }
+    unsafe { (*future).is_ready() }
+}
 
-    // Derefernce list and get the item.
-    let varlist = borrow_list.get_list().unwrap();
-    if let Some(res) = varlist.get_item(index) {
-        res as *const pxs_Var as *mut pxs_Var
-    } else {
-        return ptr::null_mut();
+/// Block until the job of `future` finished and return its result. The result can only be taken once.
+///
+/// future:BORROW
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_future_wait(future: *mut pxs_Future) -> pxs_VarT {
+    pxs_debug!("pxs_future_wait");
+    if future.is_null() {
+        return pxs_Var::null_param_ep("future").into_raw();
+    }
+    match unsafe { (*future).wait() } {
+        Some(res) => res.into_raw(),
+        None => pxs_Var::new_exception("Future result was already taken".to_string()).into_raw(),
     }
 }
 
-/// Set a item at a specific index in a pxs_VarList.
+/// Free a future. The job still runs if it has not yet.
 ///
-/// Expects a pointer to pxs_VarList, a index of i32, and a pxs_Var. Supports negative indexes jsut like in Python.
+/// future:TRANSFER
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_freefuture(future: *mut pxs_Future) {
+    pxs_debug!("pxs_freefuture");
+    if future.is_null() {
+        return;
+    }
+    unsafe {
+        let _ = Arc::from_raw(future as *const pxs_Future);
+    }
+}
+
+/// Free a scheduler. Blocks until the queued jobs ran and the workers stopped.
 ///
-/// Will take ownership of the pxs_Var.
+/// scheduler:TRANSFER
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_freescheduler(scheduler: *mut pxs_Scheduler) {
+    pxs_debug!("pxs_freescheduler");
+    assert_initiated!();
+    if scheduler.is_null() {
+        return;
+    }
+
+    let _ = pxs_Scheduler::from_raw(scheduler);
+}
+
+/// Save the precompiled chunks `runtime` has compiled so far (the core libs, module files and scripts) as a snapshot.
 ///
-/// This will return a boolean for success = true, or failure = false.
+/// Call this once initialization and mod bootstrap are done, it also stops recording new chunks. The core
+/// libs and imported modules (`require`, `import`) are still kept in memory, later threads and contexts load them.
+/// Lua chunks are `lua_dump` bytecode, JS modules are `JS_WriteObject` bytecode and Python scripts are serialized code objects.
 ///
-/// list:BORROW
-/// item:TRANSFER
+/// Free the result with `pxs_freesnapshot`.
+///
+/// len:BORROW, set to the size in bytes.
+/// return:OWNED
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_listset(list: *mut pxs_Var, index: i32, item: *mut pxs_Var) -> bool {
-    pxs_debug!("pxs_listset");
+pub extern "C" fn pxs_snapshot_save(runtime: pxs_Runtime, len: *mut usize) -> *mut u8 {
+    pxs_debug!("pxs_snapshot_save");
     assert_initiated!();
 
-    if list.is_null() || item.is_null() {
-        return false;
+    let data = snapshot::save(runtime, pxs_version()).into_boxed_slice();
+    if !len.is_null() {
+        unsafe {
+            *len = data.len();
+        }
     }
+    Box::into_raw(data) as *mut u8
+}
 
-    // Borrow list
-    let borrow_list = unsafe { pxs_Var::from_borrow(list) };
-    // Check if actually list
-    if !borrow_list.is_list() {
+/// Load a snapshot from `pxs_snapshot_save`. Chunks whose source did not change are loaded from bytecode instead of compiled.
+///
+/// Can be called before `pxs_initialize`, so the core libs come from the snapshot too.
+/// Returns false if the snapshot is not for this runtime or pixelscript version.
+///
+/// data:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_snapshot_load(runtime: pxs_Runtime, data: *const u8, len: usize) -> bool {
+    pxs_debug!("pxs_snapshot_load");
+    if data.is_null() {
         return false;
     }
 
-    // Get list
-    let list = borrow_list.get_list().unwrap();
-    // Own item
-    let owned_item = pxs_Var::from_raw(item);
-    // Set in list
-    list.set_item(owned_item, index)
+    let bytes = unsafe { std::slice::from_raw_parts(data, len) };
+    match snapshot::load(runtime, pxs_version(), bytes) {
+        Ok(()) => true,
+        Err(_e) => {
+            pxs_debug!("Could not load snapshot: {_e}");
+            false
+        }
+    }
 }
 
-/// Get length of a pxs_VarList.
+/// Persist compiled chunks in `dir` so later runs skip compiling sources that did not change. NULL to stop persisting.
 ///
-/// Expects a pointer to a pxs_VarList
+/// Chunk files are keyed by a hash of the chunk name and source, and files of another pixelscript version are ignored.
+/// Covers `pxs_exec`, `pxs_compile` and module files of Lua and JS, and `pxs_exec` of Python.
+/// The directory must exist, failing to write a chunk file only means it gets compiled again.
 ///
-/// list:BORROW
+/// dir:BORROW
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_listlen(list: *mut pxs_Var) -> i32 {
-    pxs_debug!("pxs_listlen");
-    assert_initiated!();
-
-    if list.is_null() {
-        return -1;
+pub extern "C" fn pxs_set_cachedir(dir: *const c_char) {
+    pxs_debug!("pxs_set_cachedir");
+    if dir.is_null() {
+        snapshot::set_cache_dir(None, pxs_version());
+        return;
     }
+    let dir = borrow_string!(dir);
+    snapshot::set_cache_dir(Some(std::path::PathBuf::from(dir)), pxs_version());
+}
 
-    let borrow_list = unsafe { pxs_Var::from_borrow(list) };
-    if !borrow_list.is_list() {
-        return -1;
+/// Free a snapshot from `pxs_snapshot_save`.
+///
+/// data:TRANSFER
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_freesnapshot(data: *mut u8, len: usize) {
+    pxs_debug!("pxs_freesnapshot");
+    if data.is_null() {
+        return;
+    }
+    unsafe {
+        let _ = Box::from_raw(std::ptr::slice_from_raw_parts_mut(data, len));
     }
+}
 
-    let list = borrow_list.get_list().unwrap();
+/// Limit every call into `runtime` made on the current thread. 0 means no limit, both 0 removes the budget.
+///
+/// A call that runs over (pxs_exec, pxs_call, pxs_objectcall, pxs_eval, ...) is stopped and returns an exception.
+/// Calls made from inside a budgeted call (i.e. a host callback calling back into the script) share its budget.
+///
+/// `instructions` is counted in steps of the VM (1000 in Lua, about 10000 in JS) and is not supported in Python.
+/// `millis` is wall time in Lua and JS, and CPU time in Python.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_setbudget(runtime: pxs_Runtime, instructions: u64, millis: u64) {
+    pxs_debug!("pxs_setbudget");
+    budget::set_budget(&runtime, Budget { instructions, millis });
+}
 
-    list.vars.len() as i32
+/// Clear the current threads state for all languages.
+///
+/// Optionally, if you want to run the garbage collector.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_clear() {
+    pxs_debug!("pxs_clear");
+    assert_initiated!();
+    // Drop function lookup
+    clear_function_lookup();
+    // Drop object lookup
+    clear_object_lookup();
+
+    with_feature!("lua", {
+        if deferred::started(&pxs_Runtime::pxs_Lua) {
+            LuaScripting::clear();
+        }
+    });
+    with_feature!("python", {
+        if deferred::started(&pxs_Runtime::pxs_Python) {
+            PythonScripting::clear();
+        }
+    });
+    with_feature!("js", {
+        if deferred::started(&pxs_Runtime::pxs_JavaScript) {
+            JSScripting::clear();
+        }
+    })
 }
 
-/// Call a `pxs_Var`s function.
+/// Call a method within a specifed runtime.
 ///
-/// Expects runtime var, var function, and args that is a List.
+/// Runtime is a `pxs_Var`.
 ///
 /// Transfers ownership of args.
 ///
 /// runtime:BORROW
-/// var_func:BORROW
 /// args:TRANSFER
 /// return:OWNED
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_varcall(
+pub extern "C" fn pxs_call(
     runtime: *mut pxs_Var,
-    var_func: *mut pxs_Var,
+    method: *const c_char,
     args: *mut pxs_Var,
 ) -> *mut pxs_Var {
-    pxs_debug!("pxs_varcall");
+    pxs_debug!("pxs_call");
     assert_initiated!();
 
-    if runtime.is_null() || var_func.is_null() || args.is_null() {
+    if runtime.is_null() || method.is_null() || args.is_null() {
         return pxs_Var::null_params_ep().into_raw();
     }
 
-    // Get the function pointer
-    let borrow_func = borrow_var!(var_func);
-    // Check if function
-    if !borrow_func.is_function() {
-        return pxs_Var::incorrect_type_ep(pxs_VarType::pxs_Function, borrow_func.tag).into_raw();
-    }
+    let runtime_var = unsafe { pxs_Var::from_borrow(runtime) };
+    let runtime_id = pxs_getint(runtime_var);
 
-    // own args
+    // Borrow runtime, var, and method, and argv
+    let runtime_borrow = pxs_Runtime::from_i64(runtime_id);
+    let method_borrow = borrow_string!(method);
+    // Own args
     let args = own_var!(args);
-    // Check it's a list
     if !args.is_list() {
-        return ptr::null_mut();
+        return pxs_Var::incorrect_type_ep(pxs_VarType::pxs_List, args.tag).into_raw();
     }
     let list = args.get_list().unwrap();
 
-    // Match the runtime
-    let rt = unsafe { pxs_Runtime::from_var_ptr(runtime) };
-    if let Some(runtime) = rt {
-        with_backend!(runtime, Backend => {
-            let res = Backend::var_call(borrow_func, list);
+    // Get runtime
+    if let Some(rt) = runtime_borrow {
+        with_backend!(rt, Backend => {
+            let res = watchdog::watch(&rt, "", method_borrow, || {
+                tracer::span(pxs_TraceKind::pxs_TraceCall, &rt, method_borrow, || {
+                    budget::scoped::<Backend, _>(&rt, || Backend::call_method(method_borrow, list))
+                })
+            });
             if res.is_err() {
                 pxs_Var::new_exception(res.unwrap_err().to_string())
             } else {
@@ -1275,765 +2141,2414 @@ pub extern "C" fn pxs_varcall(
         })
         .into_raw()
     } else {
-        pxs_Var::unkown_runtime_var_ep(runtime).into_raw()
+        pxs_Var::unkown_runtime_ep(runtime_id).into_raw()
     }
 }
 
-/// Copy the pxs_Var.
+/// Call a method within a specifed runtime with `argc` args from `argv`. The same as `pxs_call` without building a
+/// list first.
 ///
-/// Memory is handled by caller
+/// Transfers ownership of the items in `argv`, the array itself stays with the caller (i.e. on the stack).
 ///
-/// item:BORROW
+/// runtime:BORROW
+/// argv:TRANSFER
 /// return:OWNED
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_newcopy(item: *mut pxs_Var) -> *mut pxs_Var {
-    pxs_debug!("pxs_newcopy");
+pub extern "C" fn pxs_callv(
+    runtime: *mut pxs_Var,
+    method: *const c_char,
+    argc: i32,
+    argv: *mut pxs_VarT,
+) -> *mut pxs_Var {
+    pxs_debug!("pxs_callv");
     assert_initiated!();
 
-    if item.is_null() {
-        return pxs_Var::null_param_ep("item").into_raw();
+    let mut list = frame_to_list(argc, argv);
+    if runtime.is_null() || method.is_null() {
+        return pxs_Var::null_params_ep().into_raw();
     }
 
-    // Borrow var
-    let borrow_item = borrow_var!(item);
+    let runtime_var = unsafe { pxs_Var::from_borrow(runtime) };
+    let runtime_id = pxs_getint(runtime_var);
+    let method_borrow = borrow_string!(method);
 
-    // Clone the var
-    let cloned_var = borrow_item.clone();
-    cloned_var.into_raw()
+    if let Some(rt) = pxs_Runtime::from_i64(runtime_id) {
+        with_backend!(rt, Backend => {
+            let res = watchdog::watch(&rt, "", method_borrow, || {
+                tracer::span(pxs_TraceKind::pxs_TraceCall, &rt, method_borrow, || {
+                    budget::scoped::<Backend, _>(&rt, || Backend::call_method(method_borrow, &mut list))
+                })
+            });
+            if res.is_err() {
+                pxs_Var::new_exception(res.unwrap_err().to_string())
+            } else {
+                res.unwrap()
+            }
+        })
+        .into_raw()
+    } else {
+        pxs_Var::unkown_runtime_ep(runtime_id).into_raw()
+    }
 }
 
-/// Call a objects getter.
+/// Call a ToString method on this Var. If already a string, it won't call it.
 ///
-/// runtime:BORROW
-/// obj:BORROW
+/// Host must free this memory with `pxs_free_var`
+///
+/// runtime_var:BORROW
+/// var:BORROW
 /// return:OWNED
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_objectget(runtime: pxs_VarT, obj: pxs_VarT, key: *const c_char) -> pxs_VarT {
-    pxs_debug!("pxs_objectget");
+pub extern "C" fn pxs_tostring(runtime_var: *mut pxs_Var, var: *mut pxs_Var) -> *mut pxs_Var {
+    pxs_debug!("pxs_tostring");
     assert_initiated!();
-    if runtime.is_null() || obj.is_null() || key.is_null() {
+
+    if var.is_null() || runtime_var.is_null() {
         return pxs_Var::null_params_ep().into_raw();
     }
 
-    // Borrow var
-    let borrow_obj = borrow_var!(obj);
-    let borrow_rt = unsafe { pxs_Runtime::from_var_ptr(runtime).unwrap() };
-    let borrow_key = borrow_string!(key);
+    // Borrow
+    let b_var = unsafe { pxs_Var::from_borrow(var) };
 
-    with_backend!(borrow_rt, Backend => {
-        let res = Backend::get(borrow_obj, borrow_key);
-        if res.is_err() {
-            pxs_Var::new_exception(res.unwrap_err().to_string())
+    // If string or primative, no object calling needed
+    match b_var.tag {
+        pxs_VarType::pxs_Int64 => {
+            let val = b_var.get_i64().unwrap();
+            return pxs_Var::new_string(val.to_string()).into_raw();
+        }
+        pxs_VarType::pxs_UInt64 => {
+            let val = b_var.get_u64().unwrap();
+            return pxs_Var::new_string(val.to_string()).into_raw();
+        }
+        pxs_VarType::pxs_String | pxs_VarType::pxs_Exception => {
+            return pxs_Var::new_string(b_var.get_string().unwrap().clone()).into_raw();
+        }
+        pxs_VarType::pxs_Bool => {
+            return pxs_Var::new_string(b_var.get_bool().unwrap().to_string()).into_raw();
+        }
+        pxs_VarType::pxs_Float64 => {
+            return pxs_Var::new_string(b_var.get_f64().unwrap().to_string()).into_raw();
+        }
+        pxs_VarType::pxs_Null => {
+            return pxs_Var::new_string("null".to_string()).into_raw();
+        }
+        _ => {
+            // Do nothing
+        }
+    }
+
+    // Not a string, so let's convert
+    let runtime = unsafe { pxs_Runtime::from_var_ptr(runtime_var) };
+    if let Some(runtime) = runtime {
+        let args = pxs_Var::new_list();
+        let list = args.get_list().unwrap();
+        list.add_item(b_var.shallow_copy());
+        let res = match runtime {
+            pxs_Runtime::pxs_Lua => {
+                with_feature!("lua", {
+                    deferred::ensure::<LuaScripting>(&pxs_Runtime::pxs_Lua);
+                    LuaScripting::call_method("tostring", list)
+                }, {
+                    return pxs_Var::feature_not_enabled_ep("lua").into_raw();
+                })
+            }
+            pxs_Runtime::pxs_Python => {
+                with_feature!("python", {
+                    deferred::ensure::<PythonScripting>(&pxs_Runtime::pxs_Python);
+                    PythonScripting::call_method("str", list)
+                }, {
+                    return pxs_Var::feature_not_enabled_ep("python").into_raw();
+                })
+            }
+            pxs_Runtime::pxs_JavaScript => {
+                with_feature!(
+                    "js",
+                    {
+                        // Check variable is null.
+                        if pxs_varis(var, pxs_VarType::pxs_Null) {
+                            return pxs_Var::new_string("null".to_owned()).into_raw();
+                        }
+
+                        let mut empty_list = pxs_VarList::new();
+                        JSScripting::object_call(b_var, "toString", &mut empty_list)
+                    },
+                    {
+                        return pxs_Var::feature_not_enabled_ep("js").into_raw();
+                    }
+                )
+            }
+            pxs_Runtime::pxs_Wren => {
+                // No Wren backend yet, see todo.md.
+                return pxs_Var::feature_not_enabled_ep("wren").into_raw();
+            }
+        };
+
+        if let Ok(res) = res {
+            res.into_raw()
         } else {
-            res.unwrap()
+            pxs_Var::new_exception(res.unwrap_err().to_string()).into_raw()
         }
-    })
-    .into_raw()
+    } else {
+        pxs_Var::unkown_runtime_var_ep(runtime_var).into_raw()
+    }
 }
 
-/// Call a objects setter.
+/// Create a new pxs_VarList.
 ///
-/// value ownership is transfered.
+/// This does not take any arguments. To add to a list, you must call `pxs_var_list_add(ptr, item)`
 ///
-/// runtime:BORROW
-/// obj:BORROW
-/// value:TRANSFER
+/// return:OWNED
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_objectset(
-    runtime: pxs_VarT,
-    obj: pxs_VarT,
-    key: *const c_char,
-    value: pxs_VarT,
-) -> bool {
-    pxs_debug!("pxs_objectset");
+pub extern "C" fn pxs_newlist() -> *mut pxs_Var {
+    pxs_debug!("pxs_newlist");
     assert_initiated!();
 
-    if runtime.is_null() || obj.is_null() || key.is_null() || value.is_null() {
-        return false;
+    pxs_Var::new_list().into_raw()
+}
+
+/// Create a new empty pxs_VarList with room for `capacity` items, so adding them does not reallocate.
+///
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_newlist_with_capacity(capacity: usize) -> pxs_VarT {
+    pxs_debug!("pxs_newlist_with_capacity");
+    assert_initiated!();
+
+    pxs_Var::new_list_with_capacity(capacity).into_raw()
+}
+
+/// Add a item to a pxs_VarList.
+///
+/// Expects a pointer to pxs_VarList. And a pointer for the item to add (pxs_Var*)
+///
+/// This will take ownership of the added item. If you want to copy it instead first create a new `pxs_Var` with `pxs_var_newcopy(item)`
+///
+/// Will return the index added at.
+///
+/// list:BORROW
+/// item:TRANSFER
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_listadd(list: *mut pxs_Var, item: *mut pxs_Var) -> i32 {
+    pxs_debug!("pxs_listadd");
+    assert_initiated!();
+
+    // Check null
+    if list.is_null() || item.is_null() {
+        return -1;
     }
 
-    // Borrow
-    let rt = unsafe { pxs_Runtime::from_var_ptr(runtime).unwrap() };
-    let borrow_obj = borrow_var!(obj);
-    let borrow_key = borrow_string!(key);
-    // own
-    let owned_value = own_var!(value);
+    // Borrow list
+    let borrow_list = unsafe { pxs_Var::from_borrow(list) };
+    // Check that this is actually a list
+    if !borrow_list.is_list() {
+        return -1;
+    }
 
-    with_backend!(rt, Backend => {
-        let res = Backend::set(borrow_obj, borrow_key, &owned_value);
-        if res.is_err() {
-            false
-            // pxs_Var::new_exception(res.unwrap_err().to_string())
-        } else {
-            true
-            // res.unwrap()
-        }
-    })
+    // and own item
+    let owned_item = pxs_Var::from_raw(item);
+
+    // Get varlist and add item
+    let varlist = borrow_list.get_list().unwrap();
+    varlist.add_item(owned_item);
+
+    // Return index
+    (varlist.vars.len() - 1) as i32
 }
 
-/// Evaluate code. This will return a `pxs_VarT`.
+/// Get a item from a pxs_VarList.
 ///
-/// return:OWNED
+/// Expcts a pointer to pxs_VarList. And a index of i32. Supports negative indexes just like in Python.
+///
+/// This will NOT return a cloned variable, you must NOT free it.
+///
+/// list:BORROW
+/// return:BORROW&NULLABLE
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_eval(script: *const c_char, rt: pxs_Runtime) -> pxs_VarT {
-    pxs_debug!("pxs_eval");
-    if script.is_null() {
-        return pxs_Var::null_param_ep("script").into_raw();
+pub extern "C" fn pxs_listget(list: *mut pxs_Var, index: i32) -> *mut pxs_Var {
+    pxs_debug!("pxs_listget");
+    assert_initiated!();
+
+    if list.is_null() {
+        return ptr::null_mut();
     }
 
-    let script = borrow_string!(script);
+    // Get list
+    let borrow_list = unsafe { pxs_Var::from_borrow(list) };
+    if !borrow_list.is_list() {
+        return pxs_Var::incorrect_type_ep(pxs_VarType::pxs_List, borrow_list.tag).into_raw();
+    }
 
-    with_backend!(rt, Backend => {
-        let res = Backend::eval(script, "<eval>");
-        if res.is_err() {
-            pxs_Var::new_exception(res.unwrap_err().to_string())
-        } else {
-            res.unwrap()
-        }
-    })
-    .into_raw()
+    // Derefernce list and get the item. The caller may change it, so it can not be shared with a copy.
+    let varlist = borrow_list.get_list().unwrap();
+    varlist.unshare();
+    if let Some(res) = varlist.get_item(index) {
+        res as *const pxs_Var as *mut pxs_Var
+    } else {
+        return ptr::null_mut();
+    }
 }
 
-/// Evaluate named code. This will return a `pxs_VarT`.
-/// 
-/// return:OWNED
+/// Set a item at a specific index in a pxs_VarList.
+///
+/// Expects a pointer to pxs_VarList, a index of i32, and a pxs_Var. Supports negative indexes jsut like in Python.
+///
+/// Will take ownership of the pxs_Var.
+///
+/// This will return a boolean for success = true, or failure = false.
+///
+/// list:BORROW
+/// item:TRANSFER
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_evalnamed(script: *const c_char, name: *const c_char, rt: pxs_Runtime) -> pxs_VarT {
-    pxs_debug!("pxs_evalnamed");
-    if script.is_null() || name.is_null() {
-        return pxs_Var::null_params_ep().into_raw();
+pub extern "C" fn pxs_listset(list: *mut pxs_Var, index: i32, item: *mut pxs_Var) -> bool {
+    pxs_debug!("pxs_listset");
+    assert_initiated!();
+
+    if list.is_null() || item.is_null() {
+        return false;
     }
 
-    let script = borrow_string!(script);
-    let name = borrow_string!(name);
+    // Borrow list
+    let borrow_list = unsafe { pxs_Var::from_borrow(list) };
+    // Check if actually list
+    if !borrow_list.is_list() {
+        return false;
+    }
 
-    with_backend!(rt, Backend => {
-        let res = Backend::eval(script, name);
-        if res.is_err() {
-            pxs_Var::new_exception(res.unwrap_err())
-        } else {
-            res.unwrap()
+    // Get list
+    let list = borrow_list.get_list().unwrap();
+    // Own item
+    let owned_item = pxs_Var::from_raw(item);
+    // Set in list
+    list.set_item(owned_item, index)
+}
+
+/// Get length of a pxs_VarList.
+///
+/// Expects a pointer to a pxs_VarList
+///
+/// list:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_listlen(list: *mut pxs_Var) -> i32 {
+    pxs_debug!("pxs_listlen");
+    assert_initiated!();
+
+    if list.is_null() {
+        return -1;
+    }
+
+    let borrow_list = unsafe { pxs_Var::from_borrow(list) };
+    if !borrow_list.is_list() {
+        return -1;
+    }
+
+    let list = borrow_list.get_list().unwrap();
+
+    list.vars.len() as i32
+}
+
+/// The items of a `pxs_List` as one contiguous array, without a call per item: `span[i]` is item `i` and `&span[i]`
+/// its `pxs_VarT`. `len` is set to the number of items.
+///
+/// The span is valid until the list changes. NULL (and a `len` of 0) for a empty list or a var that is not a list.
+///
+/// list:BORROW
+/// return:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_listspan(list: pxs_VarT, len: *mut usize) -> pxs_VarT {
+    pxs_debug!("pxs_listspan");
+    assert_initiated!();
+
+    if !len.is_null() {
+        unsafe { *len = 0 };
+    }
+    if list.is_null() {
+        return ptr::null_mut();
+    }
+    let Some(list) = borrow_var!(list).get_list() else {
+        return ptr::null_mut();
+    };
+    if list.vars.is_empty() {
+        return ptr::null_mut();
+    }
+
+    // Items may be changed through the span.
+    let vars = list.vars_mut();
+    if !len.is_null() {
+        unsafe { *len = vars.len() };
+    }
+    vars.as_mut_ptr()
+}
+
+/// Create a new pxs_VarList of `len` ints in one call.
+///
+/// values:BORROW
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_newlist_i64(values: *const i64, len: usize) -> pxs_VarT {
+    pxs_debug!("pxs_newlist_i64");
+    assert_initiated!();
+
+    if values.is_null() || len == 0 {
+        return pxs_Var::new_list().into_raw();
+    }
+
+    let values = unsafe { std::slice::from_raw_parts(values, len) };
+    pxs_Var::new_list_with(values.iter().map(|v| pxs_Var::new_i64(*v)).collect()).into_raw()
+}
+
+/// Create a new pxs_VarList of `len` floats in one call.
+///
+/// values:BORROW
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_newlist_f64(values: *const f64, len: usize) -> pxs_VarT {
+    pxs_debug!("pxs_newlist_f64");
+    assert_initiated!();
+
+    if values.is_null() || len == 0 {
+        return pxs_Var::new_list().into_raw();
+    }
+
+    let values = unsafe { std::slice::from_raw_parts(values, len) };
+    pxs_Var::new_list_with(values.iter().map(|v| pxs_Var::new_f64(*v)).collect()).into_raw()
+}
+
+/// Copy up to `len` items of a pxs_VarList into `out` as ints. Converts like `pxs_getint`.
+///
+/// Stops at the first item that is not a number. Returns the number of items copied, -1 if `list` is not a list.
+///
+/// list:BORROW
+/// out:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_list_copy_i64(list: pxs_VarT, out: *mut i64, len: usize) -> i32 {
+    pxs_debug!("pxs_list_copy_i64");
+    assert_initiated!();
+
+    if list.is_null() {
+        return -1;
+    }
+    let list = borrow_var!(list);
+    let Some(list) = list.get_list() else {
+        return -1;
+    };
+    if out.is_null() {
+        return 0;
+    }
+
+    let out = unsafe { std::slice::from_raw_parts_mut(out, len.min(list.vars.len())) };
+    for (i, item) in list.vars.iter().take(out.len()).enumerate() {
+        match item.as_i64() {
+            Some(v) => out[i] = v,
+            None => return i as i32,
+        }
+    }
+    out.len() as i32
+}
+
+/// Copy up to `len` items of a pxs_VarList into `out` as floats. Converts like `pxs_getfloat`.
+///
+/// Stops at the first item that is not a number. Returns the number of items copied, -1 if `list` is not a list.
+///
+/// list:BORROW
+/// out:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_list_copy_f64(list: pxs_VarT, out: *mut f64, len: usize) -> i32 {
+    pxs_debug!("pxs_list_copy_f64");
+    assert_initiated!();
+
+    if list.is_null() {
+        return -1;
+    }
+    let list = borrow_var!(list);
+    let Some(list) = list.get_list() else {
+        return -1;
+    };
+    if out.is_null() {
+        return 0;
+    }
+
+    let out = unsafe { std::slice::from_raw_parts_mut(out, len.min(list.vars.len())) };
+    for (i, item) in list.vars.iter().take(out.len()).enumerate() {
+        match item.as_f64() {
+            Some(v) => out[i] = v,
+            None => return i as i32,
+        }
+    }
+    out.len() as i32
+}
+
+/// Call a `pxs_Var`s function.
+///
+/// Expects runtime var, var function, and args that is a List.
+///
+/// Transfers ownership of args.
+///
+/// runtime:BORROW
+/// var_func:BORROW
+/// args:TRANSFER
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_varcall(
+    runtime: *mut pxs_Var,
+    var_func: *mut pxs_Var,
+    args: *mut pxs_Var,
+) -> *mut pxs_Var {
+    pxs_debug!("pxs_varcall");
+    assert_initiated!();
+
+    if runtime.is_null() || var_func.is_null() || args.is_null() {
+        return pxs_Var::null_params_ep().into_raw();
+    }
+
+    // Get the function pointer
+    let borrow_func = borrow_var!(var_func);
+    // Check if function
+    if !borrow_func.is_function() {
+        return pxs_Var::incorrect_type_ep(pxs_VarType::pxs_Function, borrow_func.tag).into_raw();
+    }
+
+    // own args
+    let args = own_var!(args);
+    // Check it's a list
+    if !args.is_list() {
+        return ptr::null_mut();
+    }
+    let list = args.get_list().unwrap();
+
+    // Match the runtime
+    let rt = unsafe { pxs_Runtime::from_var_ptr(runtime) };
+    if let Some(runtime) = rt {
+        with_backend!(runtime, Backend => {
+            let res = budget::scoped::<Backend, _>(&runtime, || Backend::var_call(borrow_func, list));
+            if res.is_err() {
+                pxs_Var::new_exception(res.unwrap_err().to_string())
+            } else {
+                res.unwrap()
+            }
+        })
+        .into_raw()
+    } else {
+        pxs_Var::unkown_runtime_var_ep(runtime).into_raw()
+    }
+}
+
+/// Own the `argc` vars of `argv` as a list.
+fn frame_to_list(argc: i32, argv: *mut pxs_VarT) -> pxs_VarList {
+    let mut list = pxs_VarList::new();
+    if argc <= 0 || argv.is_null() {
+        return list;
+    }
+
+    let argv = unsafe { std::slice::from_raw_parts(argv, argc as usize) };
+    list.vars_mut().reserve(argv.len());
+    for arg in argv {
+        if arg.is_null() {
+            list.add_item(pxs_Var::new_null());
+        } else {
+            list.add_item(own_var!(*arg));
+        }
+    }
+    list
+}
+
+/// Call a `pxs_Var`s function with `argc` args from `argv`. The same as `pxs_varcall` without building a list first.
+///
+/// Transfers ownership of the items in `argv`, the array itself stays with the caller (i.e. on the stack).
+///
+/// runtime:BORROW
+/// var_func:BORROW
+/// argv:TRANSFER
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_varcallv(
+    runtime: *mut pxs_Var,
+    var_func: *mut pxs_Var,
+    argc: i32,
+    argv: *mut pxs_VarT,
+) -> *mut pxs_Var {
+    pxs_debug!("pxs_varcallv");
+    assert_initiated!();
+
+    let mut list = frame_to_list(argc, argv);
+    if runtime.is_null() || var_func.is_null() {
+        return pxs_Var::null_params_ep().into_raw();
+    }
+
+    let borrow_func = borrow_var!(var_func);
+    if !borrow_func.is_function() {
+        return pxs_Var::incorrect_type_ep(pxs_VarType::pxs_Function, borrow_func.tag).into_raw();
+    }
+
+    let rt = unsafe { pxs_Runtime::from_var_ptr(runtime) };
+    if let Some(runtime) = rt {
+        with_backend!(runtime, Backend => {
+            let res = budget::scoped::<Backend, _>(&runtime, || Backend::var_call(borrow_func, &mut list));
+            if res.is_err() {
+                pxs_Var::new_exception(res.unwrap_err().to_string())
+            } else {
+                res.unwrap()
+            }
+        })
+        .into_raw()
+    } else {
+        pxs_Var::unkown_runtime_var_ep(runtime).into_raw()
+    }
+}
+
+/// Call `var_func` with every args list in `batches` (a List of Lists), i.e. `score(entity)` over many entities.
+///
+/// The function is converted and the runtime entered once, and conversion scratch is reused between calls.
+/// Returns a List with one result per args list, a failed call (or a args item that is not a List) is a exception in its slot.
+///
+/// runtime:BORROW
+/// var_func:BORROW
+/// batches:TRANSFER
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_callbatch(runtime: pxs_VarT, var_func: pxs_VarT, batches: pxs_VarT) -> pxs_VarT {
+    pxs_debug!("pxs_callbatch");
+    assert_initiated!();
+
+    if runtime.is_null() || var_func.is_null() || batches.is_null() {
+        return pxs_Var::null_params_ep().into_raw();
+    }
+    let borrow_func = borrow_var!(var_func);
+    if !borrow_func.is_function() {
+        return pxs_Var::incorrect_type_ep(pxs_VarType::pxs_Function, borrow_func.tag).into_raw();
+    }
+    let batches = own_var!(batches);
+    let Some(list) = batches.get_list() else {
+        return pxs_Var::incorrect_type_ep(pxs_VarType::pxs_List, batches.tag).into_raw();
+    };
+
+    // Args lists are moved out, `None` marks the items that are not lists.
+    let mut arg_lists = Vec::with_capacity(list.len());
+    let mut slots = Vec::with_capacity(list.len());
+    for item in list.vars_mut().iter_mut() {
+        match item.get_list() {
+            Some(args) => {
+                slots.push(Some(arg_lists.len()));
+                arg_lists.push(pxs_VarList { vars: std::mem::take(&mut args.vars) });
+            }
+            None => slots.push(None),
+        }
+    }
+
+    let rt = unsafe { pxs_Runtime::from_var_ptr(runtime) };
+    let Some(rt) = rt else {
+        return pxs_Var::unkown_runtime_var_ep(runtime).into_raw();
+    };
+    let mut results = with_backend!(rt, Backend => {
+        budget::scoped::<Backend, _>(&rt, || Backend::var_call_batch(borrow_func, &mut arg_lists))
+    })
+    .into_iter();
+
+    let out = slots
+        .into_iter()
+        .map(|slot| match slot {
+            Some(_) => results.next().unwrap_or_else(pxs_Var::new_null),
+            None => pxs_Var::new_exception("Batch item is not a List"),
+        })
+        .collect();
+    pxs_Var::new_list_with(out).into_raw()
+}
+
+/// Column oriented `pxs_callbatch`. Row `i` calls `var_func(columns[0][i], columns[1][i], ...)` and writes the result to `out[i]`.
+///
+/// `columns` holds `ncolumns` arrays of `rows` floats each. Results that are not numbers are written as NaN.
+/// Returns how many rows produced a number, or -1 when a param is null.
+///
+/// runtime:BORROW
+/// var_func:BORROW
+/// columns:BORROW
+/// out:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_callbatch_f64(
+    runtime: pxs_VarT,
+    var_func: pxs_VarT,
+    columns: *const *const f64,
+    ncolumns: usize,
+    rows: usize,
+    out: *mut f64,
+) -> i32 {
+    pxs_debug!("pxs_callbatch_f64");
+    assert_initiated!();
+
+    if runtime.is_null() || var_func.is_null() || out.is_null() || (columns.is_null() && ncolumns > 0) {
+        return -1;
+    }
+    let borrow_func = borrow_var!(var_func);
+    if !borrow_func.is_function() {
+        return -1;
+    }
+    let Some(rt) = (unsafe { pxs_Runtime::from_var_ptr(runtime) }) else {
+        return -1;
+    };
+
+    let columns = if ncolumns == 0 { &[][..] } else { unsafe { std::slice::from_raw_parts(columns, ncolumns) } };
+    if columns.iter().any(|column| column.is_null()) {
+        return -1;
+    }
+    let mut arg_lists: Vec<pxs_VarList> = (0..rows)
+        .map(|row| pxs_VarList::with_vars(columns.iter().map(|column| pxs_Var::new_f64(unsafe { *column.add(row) })).collect()))
+        .collect();
+
+    let results = with_backend!(rt, Backend => {
+        budget::scoped::<Backend, _>(&rt, || Backend::var_call_batch(borrow_func, &mut arg_lists))
+    });
+
+    let out = unsafe { std::slice::from_raw_parts_mut(out, rows) };
+    let mut numbers = 0;
+    for (slot, res) in out.iter_mut().zip(results.iter()) {
+        *slot = match res.as_f64() {
+            Some(val) => {
+                numbers += 1;
+                val
+            }
+            None => f64::NAN,
+        };
+    }
+    numbers
+}
+
+/// Copy the pxs_Var.
+///
+/// Lists and Maps are copy on write: the copy shares the items until either side changes, so copying is O(1).
+/// Borrowing a item (`pxs_listget`, `pxs_listspan`, `pxs_mapget`, `pxs_mapiter_begin`) counts as a change, since the
+/// item can be changed through the pointer.
+///
+/// Memory is handled by caller
+///
+/// item:BORROW
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_newcopy(item: *mut pxs_Var) -> *mut pxs_Var {
+    pxs_debug!("pxs_newcopy");
+    assert_initiated!();
+
+    if item.is_null() {
+        return pxs_Var::null_param_ep("item").into_raw();
+    }
+
+    // Borrow var
+    let borrow_item = borrow_var!(item);
+
+    // Clone the var
+    let cloned_var = borrow_item.clone();
+    cloned_var.into_raw()
+}
+
+/// Call a objects getter.
+///
+/// runtime:BORROW
+/// obj:BORROW
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_objectget(runtime: pxs_VarT, obj: pxs_VarT, key: *const c_char) -> pxs_VarT {
+    pxs_debug!("pxs_objectget");
+    assert_initiated!();
+    if runtime.is_null() || obj.is_null() || key.is_null() {
+        return pxs_Var::null_params_ep().into_raw();
+    }
+
+    // Borrow var
+    let borrow_obj = borrow_var!(obj);
+    let borrow_rt = unsafe { pxs_Runtime::from_var_ptr(runtime).unwrap() };
+    let borrow_key = borrow_string!(key);
+
+    with_backend!(borrow_rt, Backend => {
+        let res = Backend::get(borrow_obj, borrow_key);
+        if res.is_err() {
+            pxs_Var::new_exception(res.unwrap_err().to_string())
+        } else {
+            res.unwrap()
+        }
+    })
+    .into_raw()
+}
+
+/// Call a objects setter.
+///
+/// value ownership is transfered.
+///
+/// runtime:BORROW
+/// obj:BORROW
+/// value:TRANSFER
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_objectset(
+    runtime: pxs_VarT,
+    obj: pxs_VarT,
+    key: *const c_char,
+    value: pxs_VarT,
+) -> bool {
+    pxs_debug!("pxs_objectset");
+    assert_initiated!();
+
+    if runtime.is_null() || obj.is_null() || key.is_null() || value.is_null() {
+        return false;
+    }
+
+    // Borrow
+    let rt = unsafe { pxs_Runtime::from_var_ptr(runtime).unwrap() };
+    let borrow_obj = borrow_var!(obj);
+    let borrow_key = borrow_string!(key);
+    // own
+    let owned_value = own_var!(value);
+
+    with_backend!(rt, Backend => {
+        let res = Backend::set(borrow_obj, borrow_key, &owned_value);
+        if res.is_err() {
+            false
+            // pxs_Var::new_exception(res.unwrap_err().to_string())
+        } else {
+            true
+            // res.unwrap()
+        }
+    })
+}
+
+/// Intern `name`, returns a atom that stands for it in `pxs_objectget_atom` and `pxs_objectset_atom`.
+///
+/// The same name always gives the same atom, on every thread and for every runtime. Atoms are never freed, so intern
+/// property names once (i.e. at startup) and keep the atom instead of passing the name on every access.
+/// Returns 0 when `name` is NULL.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_intern(name: *const c_char) -> pxs_Atom {
+    pxs_debug!("pxs_intern");
+    assert_initiated!();
+
+    if name.is_null() {
+        return 0;
+    }
+
+    intern::intern(borrow_string!(name))
+}
+
+/// The name of a atom from `pxs_intern`. NULL for unknown atoms.
+///
+/// return:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_atomname(atom: pxs_Atom) -> *const c_char {
+    pxs_debug!("pxs_atomname");
+    assert_initiated!();
+
+    match intern::c_name(atom) {
+        Some(name) => name.as_ptr(),
+        None => ptr::null(),
+    }
+}
+
+/// `pxs_objectget` with a atom from `pxs_intern`. JS looks the property up by its own cached atom.
+///
+/// runtime:BORROW
+/// obj:BORROW
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_objectget_atom(runtime: pxs_VarT, obj: pxs_VarT, key: pxs_Atom) -> pxs_VarT {
+    pxs_debug!("pxs_objectget_atom");
+    assert_initiated!();
+    if runtime.is_null() || obj.is_null() {
+        return pxs_Var::null_params_ep().into_raw();
+    }
+
+    let borrow_obj = borrow_var!(obj);
+    let borrow_rt = unsafe { pxs_Runtime::from_var_ptr(runtime).unwrap() };
+
+    with_backend!(borrow_rt, Backend => {
+        match Backend::get_atom(borrow_obj, key) {
+            Ok(res) => res,
+            Err(e) => pxs_Var::new_exception(e.to_string()),
+        }
+    })
+    .into_raw()
+}
+
+/// `pxs_objectset` with a atom from `pxs_intern`.
+///
+/// runtime:BORROW
+/// obj:BORROW
+/// value:TRANSFER
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_objectset_atom(runtime: pxs_VarT, obj: pxs_VarT, key: pxs_Atom, value: pxs_VarT) -> bool {
+    pxs_debug!("pxs_objectset_atom");
+    assert_initiated!();
+
+    if runtime.is_null() || obj.is_null() || value.is_null() {
+        return false;
+    }
+
+    let rt = unsafe { pxs_Runtime::from_var_ptr(runtime).unwrap() };
+    let borrow_obj = borrow_var!(obj);
+    let owned_value = own_var!(value);
+
+    with_backend!(rt, Backend => {
+        Backend::set_atom(borrow_obj, key, &owned_value).is_ok()
+    })
+}
+
+/// The key value pairs of a script object (`pxs_Object`, i.e. a Lua table, Python dict or JS object) as a
+/// `pxs_List` of `[key, value]` lists, in the order the runtime iterates them.
+/// Returns a exception when `obj` is not a object of `runtime`.
+///
+/// runtime:BORROW
+/// obj:BORROW
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_objectentries(runtime: pxs_VarT, obj: pxs_VarT) -> pxs_VarT {
+    pxs_debug!("pxs_objectentries");
+    assert_initiated!();
+    if runtime.is_null() || obj.is_null() {
+        return pxs_Var::null_params_ep().into_raw();
+    }
+
+    let Some(rt) = (unsafe { pxs_Runtime::from_var_ptr(runtime) }) else {
+        return pxs_Var::new_exception("Expected a runtime").into_raw();
+    };
+    match object_entries(rt, borrow_var!(obj)) {
+        Ok(entries) => pxs_Var::new_list_with(
+            entries
+                .into_iter()
+                .map(|(key, value)| pxs_Var::new_list_with(vec![key, value]))
+                .collect(),
+        ),
+        Err(e) => pxs_Var::new_exception(e.to_string()),
+    }
+    .into_raw()
+}
+
+/// Evaluate code. This will return a `pxs_VarT`.
+///
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_eval(script: *const c_char, rt: pxs_Runtime) -> pxs_VarT {
+    pxs_debug!("pxs_eval");
+    if script.is_null() {
+        return pxs_Var::null_param_ep("script").into_raw();
+    }
+
+    let script = borrow_string!(script);
+
+    with_backend!(rt, Backend => {
+        let res = watchdog::watch(&rt, "<eval>", "", || {
+            budget::scoped::<Backend, _>(&rt, || Backend::eval(script, "<eval>"))
+        });
+        if res.is_err() {
+            pxs_Var::new_exception(res.unwrap_err().to_string())
+        } else {
+            res.unwrap()
+        }
+    })
+    .into_raw()
+}
+
+/// Evaluate named code. This will return a `pxs_VarT`.
+/// 
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_evalnamed(script: *const c_char, name: *const c_char, rt: pxs_Runtime) -> pxs_VarT {
+    pxs_debug!("pxs_evalnamed");
+    if script.is_null() || name.is_null() {
+        return pxs_Var::null_params_ep().into_raw();
+    }
+
+    let script = borrow_string!(script);
+    let name = borrow_string!(name);
+
+    with_backend!(rt, Backend => {
+        let res = watchdog::watch(&rt, name, "", || budget::scoped::<Backend, _>(&rt, || Backend::eval(script, name)));
+        if res.is_err() {
+            pxs_Var::new_exception(res.unwrap_err())
+        } else {
+            res.unwrap()
+        }
+    }).into_raw()
+}
+
+/// Add a factory variable. This variable will be instantiated once at module startup.
+///
+/// Args should not contain runtime. It gets added automatically.
+///
+/// Basically does:
+/// ```python
+/// var_name = callback(args)
+/// ```
+///
+/// args:TRANSFER
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_newfactory(func: pxs_Func, args: *mut pxs_Var) -> pxs_VarT {
+    pxs_debug!("pxs_newfactory");
+    assert_initiated!();
+
+    if args.is_null() {
+        return pxs_Var::null_param_ep("args").into_raw();
+    }
+    // Check args is list
+    let var = pxs_Var::from_raw(args);
+    if !var.is_list() {
+        return ptr::null_mut();
+    }
+
+    pxs_Var::new_factory(func, var).into_raw()
+}
+
+/// Get the `_pxs_ptr` of a `pxs_HostObject`. And type check it against `type_id`.
+/// 
+/// if `type_id` < 0, no type checking is done.
+/// 
+/// runtime: BORROW
+/// var: BORROW
+/// return: BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_gettype(runtime: pxs_VarT, var: pxs_VarT, type_id: i32) -> *mut c_void {
+    pxs_debug!("pxs_gettype");
+    assert_initiated!();
+    if runtime.is_null() || var.is_null() {
+        return ptr::null_mut();
+    }
+
+    let borrow_var = unsafe { pxs_Var::from_borrow(var) };
+
+    if borrow_var.is_object() {
+        // Check for ptr
+        let idx_var = pxs_objectget(runtime, var, PXS_PTR_NAME_C.as_ptr());
+        if idx_var.is_null() {
+            return ptr::null_mut();
+        }
+
+        let idx_own = pxs_Var::from_raw(idx_var);
+        let host_ptr = idx_own.get_host_ptr_of_type(type_id);
+
+        if host_ptr.is_null() {
+            pxs_debug!("Host pointer is null. The variable is: {:#?}", idx_own);
+        }
+
+        host_ptr
+    } else if borrow_var.is_i64() || borrow_var.is_u64() || borrow_var.is_host_object() {
+        borrow_var.get_host_ptr_of_type(type_id)
+    } else if borrow_var.is_factory() {
+        // Get the factory
+        let factory = borrow_var.get_factory().unwrap();
+        // Call the function
+        let res = factory.call(unsafe { pxs_Runtime::from_var_ptr(runtime) }.unwrap());
+        // Now we should have our object, so just call pxs_gettype on it again
+        let res_raw = res.into_raw();
+        let host = pxs_gettype(runtime, res_raw, type_id);
+        // Free res_raw
+        let _ = pxs_Var::from_raw(res_raw);
+        // return host
+        host
+    } else {
+        ptr::null_mut()
+    }
+}
+
+/// Get the HostPointer universally supported for:
+/// - Objects that have `_pxs_ptr` assigned.
+/// - Integers (signed and unsigned)
+/// - HostObjects
+/// - Factories (this will call it on the fly.)
+///
+/// All other types will return NULL.
+///
+/// runtime:BORROW
+/// var:BORROW
+/// return:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_gethost(runtime: pxs_VarT, var: pxs_VarT) -> *mut c_void {
+    pxs_debug!("pxs_gethost");
+    pxs_gettype(runtime, var, -1)
+}
+
+/// Return a string rep of the `pxs_Var`.
+///
+/// String must be freed via `pxs_freestr`.
+///
+/// var:BORROW
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_debugvar(var: pxs_VarT) -> *mut c_char {
+    pxs_debug!("pxs_debugvar");
+    if var.is_null() {
+        create_raw_string!("NULL")
+    } else {
+        let borrow_var = unsafe { pxs_Var::from_borrow(var) };
+        let str = format!("{:#?}", borrow_var);
+        create_raw_string!(str)
+    }
+}
+
+/// Create a `pxs_Exception`.
+///
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_newexception(msg: *const c_char) -> pxs_VarT {
+    pxs_debug!("pxs_newexception");
+    if msg.is_null() {
+        return pxs_Var::null_param_ep("msg").into_raw();
+    }
+
+    // Borrow msg
+    let bmsg = borrow_string!(msg);
+    pxs_Var::new_exception(bmsg.to_string().clone()).into_raw()
+}
+
+/// Get a variable reference from its name
+///
+/// rt:BORROW
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_var_fromname(rt: pxs_VarT, name: *const c_char) -> pxs_VarT {
+    pxs_debug!("pxs_var_fromname");
+    assert_initiated!();
+    if name.is_null() {
+        return pxs_Var::null_param_ep("name").into_raw();
+    }
+
+    let bname = borrow_string!(name);
+    let runtime = unsafe { pxs_Runtime::from_var_ptr(rt) };
+    if let Some(runtime) = runtime {
+        with_backend!(runtime, Backend => {
+            let res = Backend::get_from_name(bname);
+            if res.is_err() {
+                pxs_Var::new_exception(res.unwrap_err().to_string())
+            } else {
+                res.unwrap()
+            }
+        })
+        .into_raw()
+    } else {
+        pxs_Var::unkown_runtime_var_ep(rt).into_raw()
+    }
+}
+
+/// Resolve a function by name once, for calling it many times with `pxs_varcall`/`pxs_varcallv`.
+///
+/// The handle keeps a reference to the function inside the runtime (registry ref in Lua, a ref in Python and JS)
+/// so calls skip the name lookup. The handle stays valid until it is freed with `pxs_freevar`,
+/// which must happen before `pxs_finalize`.
+///
+/// Returns a exception if `name` does not exist or is not a function.
+///
+/// rt:BORROW
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_getfunc(rt: pxs_VarT, name: *const c_char) -> pxs_VarT {
+    pxs_debug!("pxs_getfunc");
+    assert_initiated!();
+    if name.is_null() {
+        return pxs_Var::null_param_ep("name").into_raw();
+    }
+
+    let bname = borrow_string!(name);
+    let runtime = unsafe { pxs_Runtime::from_var_ptr(rt) };
+    if let Some(runtime) = runtime {
+        with_backend!(runtime, Backend => {
+            match Backend::get_from_name(bname) {
+                Ok(var) if var.is_function() => var,
+                Ok(var) => pxs_Var::new_exception(format!("`{bname}` is not a function but is, {:#?}", var.tag)),
+                Err(e) => pxs_Var::new_exception(e.to_string()),
+            }
+        })
+        .into_raw()
+    } else {
+        pxs_Var::unkown_runtime_var_ep(rt).into_raw()
+    }
+}
+
+/// Remove a item from a list at a specific index.
+///
+/// Returns true for success, false for failed.
+/// 
+/// This will automatically call `pxs_freevar` on the found item.
+///
+/// list:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_listdel(list: pxs_VarT, index: i32) -> bool {
+    pxs_debug!("pxs_listdel");
+    if list.is_null() {
+        return false;
+    }
+
+    let var = borrow_var!(list);
+    if !var.is_list() {
+        return false;
+    }
+
+    // Ok so it's a List and it's not null! Lets delete the item
+    let var_list = var.get_list().unwrap();
+    var_list.del_item(index)
+}
+
+/// Do a Shallow Copy. Which means it gets the same data without get the deleter for (pxs_Object or pxs_Function).
+///
+/// Memory is owned by caller.
+///
+/// var:BORROW
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_new_shallowcopy(var: pxs_VarT) -> pxs_VarT {
+    pxs_debug!("pxs_new_shallowcopy");
+    if var.is_null() {
+        return pxs_Var::null_param_ep("var").into_raw();
+    }
+
+    // Apply a shallow copy.
+    let bvar = borrow_var!(var);
+    bvar.shallow_copy().into_raw()
+}
+
+/// Compile a code string into a code object for later execution.
+///
+/// Pass in a optional gloabl scope (or null for default). Scope ownership is transferred.
+/// Returns a `pxs_Var` whichs memory is handled by the caller.
+///
+/// Resulting `pxs_Var` will contain (Associated Runtime, Code Object, Scope|default).
+///
+/// global_scope:TRANSFER
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_compile(
+    runtime: pxs_Runtime,
+    code: *const c_char,
+    global_scope: pxs_VarT,
+) -> pxs_VarT {
+    pxs_debug!("pxs_compile");
+    assert_initiated!();
+
+    if code.is_null() || global_scope.is_null() {
+        return pxs_Var::null_params_ep().into_raw();
+    }
+
+    let rcode = borrow_string!(code);
+    let scope = own_var!(global_scope);
+
+    // Make sure scope is map or is null.
+    if !scope.is_map() && !scope.is_null() {
+        return pxs_Var::new_exception("Global scope must be a Map or Null".to_string()).into_raw();
+    }
+
+    let res = with_backend!(runtime, Backend => {
+        let res = Backend::compile(rcode, scope);
+        if res.is_err() {
+            pxs_Var::new_exception(res.unwrap_err().to_string())
+        } else {
+            res.unwrap()
+        }
+    });
+
+    if !res.is_list() {
+        return res.into_raw();
+    }
+
+    // Add the runtime to the object.
+    let list = res.get_list().unwrap();
+    list.insert_item(0, runtime.into_var());
+
+    res.into_raw()
+}
+
+/// Execute a compiled code object.
+///
+/// Variable ownership is transfered. If this is not desired behavior, pass in a shallow copy.
+/// Returned variable must be freed by caller.
+///
+/// Runtime is not required because the object is embedded with it in pxs_compile.
+/// Pass in a optional local scope that gets passed along with the global scope.
+/// Note: Do not use the same scope as in `pxs_compile`.
+///
+/// Scope ownership is transferred.
+///
+/// object : TRANSFER
+/// local  : TRANSFER
+/// return : OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_execobject(object: pxs_VarT, local: pxs_VarT) -> pxs_VarT {
+    pxs_debug!("pxs_execobject");
+    assert_initiated!();
+
+    if object.is_null() || local.is_null() {
+        return pxs_Var::null_params_ep().into_raw();
+    }
+
+    let var = own_var!(object);
+
+    if !var.is_list() {
+        return pxs_Var::incorrect_type_ep(pxs_VarType::pxs_List, var.tag).into_raw();
+    }
+
+    // Get scope
+    let scope = own_var!(local);
+    // Check if scope is a map
+    if !scope.is_map() && !scope.is_null() {
+        return pxs_Var::incorrect_types_ep(
+            vec![pxs_VarType::pxs_Map, pxs_VarType::pxs_Null],
+            scope.tag,
+        )
+        .into_raw();
+    }
+
+    let list = var.get_list().unwrap();
+    let rt = list.get_item(0);
+    if let Some(rt) = rt {
+        let runtime = pxs_Runtime::from_var(rt);
+        if let Some(runtime) = runtime {
+            // Now we can do stuff
+            with_backend!(runtime, Backend => {
+                let res = watchdog::watch(&runtime, "<object>", "", || {
+                    tracer::span(pxs_TraceKind::pxs_TraceExec, &runtime, "<object>", || {
+                        budget::scoped::<Backend, _>(&runtime, || Backend::exec_object(var, scope))
+                    })
+                });
+                if res.is_err() {
+                    pxs_Var::new_exception(res.unwrap_err().to_string())
+                } else {
+                    res.unwrap()
+                }
+            })
+            .into_raw()
+        } else {
+            pxs_Var::new_exception(format!("Unkown runtime: {:#?}", rt)).into_raw()
+        }
+    } else {
+        pxs_Var::new_exception("Code Object list is empty").into_raw()
+    }
+}
+
+/// Create a new `pxs_Map`
+///
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_newmap() -> pxs_VarT {
+    pxs_debug!("pxs_newmap");
+    pxs_Var::new_map().into_raw()
+}
+
+/// Create a new `pxs_Map` that keeps the insertion order of its keys when one is removed.
+///
+/// Every map iterates in insertion order until a key is removed, a plain map then moves its last pair into the gap.
+/// Removing from this one shifts the pairs after it instead, which is O(n).
+///
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_newmap_ordered() -> pxs_VarT {
+    pxs_debug!("pxs_newmap_ordered");
+    pxs_Var::new_map_with(pxs_VarMap::new_ordered()).into_raw()
+}
+
+/// Add a new key (`pxs_Var`) value (`pxs_Var`) pair in a map.
+///
+/// Keys can only be:
+/// - `pxs_String`
+/// - `pxs_Int64`
+/// - `pxs_UInt64`
+/// - `pxs_Float64`
+/// - `pxs_Bool`
+///
+/// Key and value ownership are transfered.
+///
+/// map:BORROW
+/// key:TRANSFER
+/// value:TRANSFER
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_map_addpair(map: pxs_VarT, key: pxs_VarT, value: pxs_VarT) {
+    pxs_debug!("pxs_map_addpair");
+    if map.is_null() || key.is_null() || value.is_null() {
+        // TODO: error
+        return;
+    }
+
+    // Check map is actually a map
+    let map = borrow_var!(map);
+    if !map.is_map() {
+        // TODO: error
+        return;
+    }
+
+    // Check key is valid pair
+    let key = own_var!(key);
+    if key.is_string() || key.is_i64() || key.is_bool() || key.is_u64() || key.is_f64() {
+        let internal = map.get_map().unwrap();
+        internal.add_item(key, own_var!(value));
+    } else {
+        // TODO: error
+        return;
+    }
+}
+
+/// Remove a value (`pxs_Var`) from a map based on it's key (`pxs_Var`).
+///
+/// map:BORROW
+/// key:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_map_delitem(map: pxs_VarT, key: pxs_VarT) {
+    pxs_debug!("pxs_map_delitem");
+    if map.is_null() || key.is_null() {
+        // TODO: error
+        return;
+    }
+
+    let map = borrow_var!(map);
+    if !map.is_map() {
+        // TODO: error
+        return;
+    }
+
+    let key = borrow_var!(key);
+    let internal = map.get_map().unwrap();
+    internal.del_item(key);
+}
+
+/// Get length of a `pxs_Map`.
+///
+/// -1 is invalid length.
+///
+/// map:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_maplen(map: pxs_VarT) -> i32 {
+    pxs_debug!("pxs_maplen");
+    if map.is_null() {
+        return -1;
+    }
+
+    let bvar = borrow_var!(map);
+    if bvar.is_map() {
+        bvar.get_map().unwrap().len() as i32
+    } else {
+        -1
+    }
+}
+
+/// Get the keys of a `pxs_Map`.
+///
+/// Returns a `pxs_List` or `pxs_Null` Which is owned by caller.
+///
+/// map:BORROW
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_mapkeys(map: pxs_VarT) -> pxs_VarT {
+    pxs_debug!("pxs_mapkeys");
+    if map.is_null() {
+        return pxs_Var::null_param_ep("map").into_raw();
+    }
+
+    // Check is map
+    let map = borrow_var!(map);
+    if !map.is_map() {
+        return pxs_Var::incorrect_type_ep(pxs_VarType::pxs_Map, map.tag).into_raw();
+    }
+    let internals = map.get_map().unwrap();
+
+    let result = pxs_Var::new_list();
+    let list = result.get_list().unwrap();
+
+    // Get keys..
+    for (k, _) in internals.iter() {
+        // Deep copy the key over.
+        list.add_item(k.to_var());
+    }
+
+    result.into_raw()
+}
+
+/// Start iterating the pairs of a `pxs_Map` in order, without copying the keys like `pxs_mapkeys` does. `iter` is
+/// filled in by this call, it can live on the stack:
+/// ```c
+/// pxs_MapIter iter;
+/// pxs_VarT key, value;
+/// pxs_mapiter_begin(map, &iter);
+/// while (pxs_mapiter_next(&iter, &key, &value)) { ... }
+/// ```
+/// Do not change the map while iterating. Returns false (and `next` yields nothing) if `map` is not a `pxs_Map`.
+///
+/// map:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_mapiter_begin(map: pxs_VarT, iter: *mut pxs_MapIter) -> bool {
+    pxs_debug!("pxs_mapiter_begin");
+    assert_initiated!();
+
+    if iter.is_null() {
+        return false;
+    }
+    let is_map = !map.is_null() && borrow_var!(map).is_map();
+    if is_map {
+        // Values may be changed through the pointers handed out by `next`.
+        borrow_var!(map).get_map().unwrap().unshare();
+    }
+    // `iter` is not initialized memory, so it is not dropped.
+    unsafe { iter.write(pxs_MapIter::new(if is_map { map } else { ptr::null_mut() })) };
+    is_map
+}
+
+/// The next pair of a `pxs_mapiter_begin` iteration. False when there are no more.
+///
+/// `key` and `value` are borrowed from the map. A string key is valid until the next call, copy it
+/// (`pxs_getstring`/`pxs_newcopy`) to keep it.
+///
+/// key:BORROW
+/// value:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_mapiter_next(iter: *mut pxs_MapIter, key: *mut pxs_VarT, value: *mut pxs_VarT) -> bool {
+    pxs_debug!("pxs_mapiter_next");
+
+    if iter.is_null() {
+        return false;
+    }
+    let Some((next_key, next_value)) = (unsafe { (*iter).next() }) else {
+        return false;
+    };
+    unsafe {
+        if !key.is_null() {
+            *key = next_key;
+        }
+        if !value.is_null() {
+            *value = next_value;
+        }
+    }
+    true
+}
+
+/// Get a value in a map from a key.
+///
+/// Result is not owned by caller. Use `pxs_newcopy` to transfer ownership.
+///
+/// map:BORROW
+/// key:BORROW
+/// return:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_mapget(map: pxs_VarT, key: pxs_VarT) -> pxs_VarT {
+    pxs_debug!("pxs_mapget");
+
+    if map.is_null() || key.is_null() {
+        return pxs_Var::null_params_ep().into_raw();
+    }
+
+    // check map
+    let map = borrow_var!(map);
+    if !map.is_map() {
+        return pxs_Var::incorrect_type_ep(pxs_VarType::pxs_Map, map.tag).into_raw();
+    }
+    let internal = map.get_map().unwrap();
+    // The caller may change the value, so it can not be shared with a copy.
+    internal.unshare();
+    let res = internal.get_item(borrow_var!(key));
+
+    // Return a borrowed pxs_Var.
+    if let Some(res) = res {
+        res as *const pxs_Var as *mut pxs_Var
+    } else {
+        pxs_Var::item_not_found_ep().into_raw()
+    }
+}
+
+/// Build a `pxs_Map` from `len` string keys and values.
+fn new_map_from<T: Copy>(keys: *const *const c_char, values: *const T, len: usize, new_value: fn(T) -> pxs_Var) -> pxs_VarT {
+    if keys.is_null() || values.is_null() || len == 0 {
+        return pxs_Var::new_map().into_raw();
+    }
+
+    let keys = unsafe { std::slice::from_raw_parts(keys, len) };
+    let values = unsafe { std::slice::from_raw_parts(values, len) };
+    let mut map = pxs_VarMap::with_capacity(len);
+    for (key, value) in keys.iter().zip(values) {
+        if key.is_null() {
+            continue;
+        }
+        map.add_str(borrow_string!(*key), new_value(*value));
+    }
+    pxs_Var::new_map_with(map).into_raw()
+}
+
+/// Copy the string keyed number pairs of a `pxs_Map` into `keys` and `values`, up to `len` of them.
+fn map_copy_into<T>(map: pxs_VarT, keys: *mut *const c_char, values: *mut T, len: usize, get_value: fn(&pxs_Var) -> Option<T>) -> i32 {
+    if map.is_null() {
+        return -1;
+    }
+    let map = borrow_var!(map);
+    let Some(map) = map.get_map() else {
+        return -1;
+    };
+    if keys.is_null() || values.is_null() {
+        return 0;
+    }
+
+    let keys = unsafe { std::slice::from_raw_parts_mut(keys, len) };
+    let values = unsafe { std::slice::from_raw_parts_mut(values, len) };
+    let mut copied = 0;
+    for (key, value) in map.iter() {
+        if copied == len {
+            break;
+        }
+        if !key.is_string() {
+            continue;
+        }
+        let Some(value) = get_value(value) else {
+            continue;
+        };
+        keys[copied] = key.as_ptr();
+        values[copied] = value;
+        copied += 1;
+    }
+    copied as i32
+}
+
+/// Create a new `pxs_Map` from `len` string keys and ints in one call. Null keys are skipped.
+///
+/// keys:BORROW
+/// values:BORROW
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_newmap_i64(keys: *const *const c_char, values: *const i64, len: usize) -> pxs_VarT {
+    pxs_debug!("pxs_newmap_i64");
+    new_map_from(keys, values, len, pxs_Var::new_i64)
+}
+
+/// Create a new `pxs_Map` from `len` string keys and floats in one call. Null keys are skipped.
+///
+/// keys:BORROW
+/// values:BORROW
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_newmap_f64(keys: *const *const c_char, values: *const f64, len: usize) -> pxs_VarT {
+    pxs_debug!("pxs_newmap_f64");
+    new_map_from(keys, values, len, pxs_Var::new_f64)
+}
+
+/// Copy up to `len` pairs of a `pxs_Map` with string keys and number values into `keys` and `values` as ints.
+/// Other pairs are skipped. Use `pxs_maplen` to size the buffers.
+///
+/// The keys are borrowed from the map and valid until it changes. Returns the number of pairs copied, -1 if `map` is
+/// not a map.
+///
+/// map:BORROW
+/// keys:BORROW
+/// values:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_map_copy_i64(map: pxs_VarT, keys: *mut *const c_char, values: *mut i64, len: usize) -> i32 {
+    pxs_debug!("pxs_map_copy_i64");
+    map_copy_into(map, keys, values, len, pxs_Var::as_i64)
+}
+
+/// Copy up to `len` pairs of a `pxs_Map` with string keys and number values into `keys` and `values` as floats.
+/// Other pairs are skipped. Use `pxs_maplen` to size the buffers.
+///
+/// The keys are borrowed from the map and valid until it changes. Returns the number of pairs copied, -1 if `map` is
+/// not a map.
+///
+/// map:BORROW
+/// keys:BORROW
+/// values:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_map_copy_f64(map: pxs_VarT, keys: *mut *const c_char, values: *mut f64, len: usize) -> i32 {
+    pxs_debug!("pxs_map_copy_f64");
+    map_copy_into(map, keys, values, len, pxs_Var::as_f64)
+}
+
+/// Insert a item into a list at a certain index, shifting all other items to the right.
+///
+/// Item ownership is transferred.
+///
+/// list:BORROW
+/// item:TRANSFER
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_listinsert(list: pxs_VarT, index: usize, item: pxs_VarT) {
+    pxs_debug!("pxs_listinsert");
+
+    if list.is_null() || item.is_null() {
+        // TODO: log something?
+        return;
+    }
+
+    // Check is list
+    let list = borrow_var!(list);
+    if !list.is_list() {
+        // TODO: log something?
+        return;
+    }
+
+    let item = own_var!(item);
+    let internal = list.get_list().unwrap();
+    internal.insert_item(index, item);
+}
+
+/// Move all items of `other` to the end of `list` in one call. `other` is freed, and can be `list` itself
+/// (the items are then copied). False if either is not a list.
+///
+/// list:BORROW
+/// other:TRANSFER
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_listextend(list: pxs_VarT, other: pxs_VarT) -> bool {
+    pxs_debug!("pxs_listextend");
+    assert_initiated!();
+
+    if list.is_null() || other.is_null() {
+        return false;
+    }
+    let Some(internal) = borrow_var!(list).get_list() else {
+        if list != other {
+            let _ = own_var!(other);
         }
-    }).into_raw()
+        return false;
+    };
+
+    if list == other {
+        let mut copy = internal.clone();
+        internal.extend(&mut copy);
+        return true;
+    }
+    let other = own_var!(other);
+    let Some(other_list) = other.get_list() else {
+        return false;
+    };
+    internal.extend(other_list);
+    true
 }
 
-/// Add a factory variable. This variable will be instantiated once at module startup.
-///
-/// Args should not contain runtime. It gets added automatically.
+/// Remove `count` items at `start` and insert the items of `items` in their place, shifting the rest once.
+/// `items` can be NULL to only remove, and is freed. `count` stops at the end of the list.
 ///
-/// Basically does:
-/// ```python
-/// var_name = callback(args)
-/// ```
+/// False if `start` is past the end, or `list`/`items` is not a list.
 ///
-/// args:TRANSFER
-/// return:OWNED
+/// list:BORROW
+/// items:TRANSFER
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_newfactory(func: pxs_Func, args: *mut pxs_Var) -> pxs_VarT {
-    pxs_debug!("pxs_newfactory");
+pub extern "C" fn pxs_listsplice(list: pxs_VarT, start: usize, count: usize, items: pxs_VarT) -> bool {
+    pxs_debug!("pxs_listsplice");
     assert_initiated!();
 
-    if args.is_null() {
-        return pxs_Var::null_param_ep("args").into_raw();
-    }
-    // Check args is list
-    let var = pxs_Var::from_raw(args);
-    if !var.is_list() {
-        return ptr::null_mut();
+    let owned_items = if items.is_null() || items == list { None } else { Some(own_var!(items)) };
+    if list.is_null() {
+        return false;
     }
+    let Some(internal) = borrow_var!(list).get_list() else {
+        return false;
+    };
 
-    pxs_Var::new_factory(func, var).into_raw()
+    let new_items = match &owned_items {
+        Some(owned_items) => match owned_items.get_list() {
+            Some(owned_list) => owned_list.take_vars(),
+            None => return false,
+        },
+        None if items == list => internal.clone().take_vars(),
+        None => vec![],
+    };
+    internal.splice(start, count, new_items)
 }
 
-/// Get the `_pxs_ptr` of a `pxs_HostObject`. And type check it against `type_id`.
-/// 
-/// if `type_id` < 0, no type checking is done.
-/// 
-/// runtime: BORROW
-/// var: BORROW
-/// return: BORROW
+/// Remove every item of a list. Its memory is kept for new items.
+///
+/// list:BORROW
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_gettype(runtime: pxs_VarT, var: pxs_VarT, type_id: i32) -> *mut c_void {
-    pxs_debug!("pxs_gettype");
+pub extern "C" fn pxs_listclear(list: pxs_VarT) {
+    pxs_debug!("pxs_listclear");
     assert_initiated!();
-    if runtime.is_null() || var.is_null() {
-        return ptr::null_mut();
+
+    if list.is_null() {
+        return;
     }
+    if let Some(internal) = borrow_var!(list).get_list() {
+        internal.clear();
+    }
+}
 
-    let borrow_var = unsafe { pxs_Var::from_borrow(var) };
+/// Make room in a list for `additional` more items, so adding them does not reallocate.
+///
+/// list:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_listreserve(list: pxs_VarT, additional: usize) {
+    pxs_debug!("pxs_listreserve");
+    assert_initiated!();
 
-    if borrow_var.is_object() {
-        // Check for ptr
-        let key = create_raw_string!(PXS_PTR_NAME);
-        let idx_var = pxs_objectget(runtime, var, key);
-        unsafe {
-            free_raw_string!(key);
-        }
-        if idx_var.is_null() {
-            return ptr::null_mut();
-        }
+    if list.is_null() {
+        return;
+    }
+    if let Some(internal) = borrow_var!(list).get_list() {
+        internal.reserve(additional);
+    }
+}
 
-        let idx_own = pxs_Var::from_raw(idx_var);
-        if type_id >= 0 {
-            let t = idx_own.get_pxs_type();
-            if t != type_id {
-                return ptr::null_mut();
-            }
-        }
-        let host_ptr = idx_own.get_host_ptr();
+/// Create a new arena in memory.
+/// This does not return anything, it simply creates a scope that will allocate pxs_Var memory.
+/// when finished call, `pxs_freearena`
+///
+/// result:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_newarena() -> *mut pxs_PixelArena {
+    pxs_debug!("pxs_newarena");
+    assert_initiated!();
 
-        if host_ptr.is_null() {
-            pxs_debug!("Host pointer is null. The variable is: {:#?}", idx_own);
-        }
+    let arena = pxs_PixelArena::new();
+    arena.into_raw()
+}
 
-        host_ptr
-    } else if borrow_var.is_i64() || borrow_var.is_u64() || borrow_var.is_host_object() {
-        if type_id >= 0 {
-            let t = borrow_var.get_pxs_type();
-            if t != type_id {
-                return ptr::null_mut();
-            }
-        }
-        borrow_var.get_host_ptr()
-    } else if borrow_var.is_factory() {
-        // Get the factory
-        let factory = borrow_var.get_factory().unwrap();
-        // Call the function
-        let res = factory.call(unsafe { pxs_Runtime::from_var_ptr(runtime) }.unwrap());
-        // Now we should have our object, so just call pxs_gettype on it again
-        let res_raw = res.into_raw();
-        let host = pxs_gettype(runtime, res_raw, type_id);
-        // Free res_raw
-        let _ = pxs_Var::from_raw(res_raw);
-        // return host
-        host
-    } else {
-        ptr::null_mut()
+/// Free arena. Upon freeing all variables allocated since `pxs_newarena` will be freed.
+///
+/// arena:TRANSFER
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_freearena(arena: *mut pxs_PixelArena) {
+    pxs_debug!("pxs_freearena");
+    assert_initiated!();
+
+    if arena.is_null() {
+        return;
     }
+
+    let _ = pxs_PixelArena::from_raw(arena);
 }
 
-/// Get the HostPointer universally supported for:
-/// - Objects that have `_pxs_ptr` assigned.
-/// - Integers (signed and unsigned)
-/// - HostObjects
-/// - Factories (this will call it on the fly.)
-///
-/// All other types will return NULL.
+/// Add a `pxs_VarT` to a `pxs_PixelArena`. Upon freeing the Arena, the variable is freed aswell.
 ///
-/// runtime:BORROW
-/// var:BORROW
-/// return:BORROW
+/// A variable must only be added once.
+/// 
+/// arena:BORROW
+/// var:TRANSFER
+/// result:BORROW
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_gethost(runtime: pxs_VarT, var: pxs_VarT) -> *mut c_void {
-    pxs_debug!("pxs_gethost");
-    pxs_gettype(runtime, var, -1)
+pub extern "C" fn pxs_arenaput(arena: *mut pxs_PixelArena, var: pxs_VarT) -> pxs_VarT {
+    pxs_debug!("pxs_arenaput");
+    assert_initiated!();
+
+    if arena.is_null() || var.is_null() {
+        return std::ptr::null_mut();
+    }
+
+    let barena = unsafe { pxs_PixelArena::from_borrow(arena) };
+    barena.alloc(var);
+
+    var
 }
 
-/// Return a string rep of the `pxs_Var`.
+/// Take a `pxs_VarT` back out of a `pxs_PixelArena`. It is no longer freed with the arena.
 ///
-/// String must be freed via `pxs_freestr`.
+/// Returns NULL if `var` is not in the arena.
 ///
+/// arena:BORROW
 /// var:BORROW
-/// return:OWNED
+/// result:OWNED
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_debugvar(var: pxs_VarT) -> *mut c_char {
-    pxs_debug!("pxs_debugvar");
-    if var.is_null() {
-        create_raw_string!("NULL")
+pub extern "C" fn pxs_arenatake(arena: *mut pxs_PixelArena, var: pxs_VarT) -> pxs_VarT {
+    pxs_debug!("pxs_arenatake");
+    assert_initiated!();
+
+    if arena.is_null() || var.is_null() {
+        return std::ptr::null_mut();
+    }
+
+    let barena = unsafe { pxs_PixelArena::from_borrow(arena) };
+    if barena.take(var) {
+        var
     } else {
-        let borrow_var = unsafe { pxs_Var::from_borrow(var) };
-        let str = format!("{:#?}", borrow_var);
-        create_raw_string!(str)
+        std::ptr::null_mut()
     }
 }
 
-/// Create a `pxs_Exception`.
-///
-/// return:OWNED
+/// Add a `char*` to a `pxs_PixelArena`. Upon freeing the Arena, the string is freed aswell.
+/// 
+/// This must be a string allocated by pixelscript. Either in:
+/// - `pxs_getstring`
+/// - `pxs_smart_getstring`
+/// - `pxs_debugstate`
+/// 
+/// A string must only be added once.
+/// 
+/// arena:BORROW
+/// str:TRANSFER
+/// result:BORROW
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_newexception(msg: *const c_char) -> pxs_VarT {
-    pxs_debug!("pxs_newexception");
-    if msg.is_null() {
-        return pxs_Var::null_param_ep("msg").into_raw();
+pub extern "C" fn pxs_arena_putstr(arena: *mut pxs_PixelArena, str: *mut c_char) -> *mut c_char {
+    pxs_debug!("pxs_arena_putstr");
+    assert_initiated!();
+
+    if arena.is_null() || str.is_null() {
+        return core::ptr::null_mut();
     }
 
-    // Borrow msg
-    let bmsg = borrow_string!(msg);
-    pxs_Var::new_exception(bmsg.to_string().clone()).into_raw()
+    let barena = unsafe { pxs_PixelArena::from_borrow(arena) };
+    barena.alloc_str(str); 
+
+    str
 }
 
-/// Get a variable reference from its name
+/// Copy `str` into a `pxs_PixelArena`. The copy is carved from the arenas own memory and is freed with it.
 ///
-/// rt:BORROW
-/// return:OWNED
+/// Do not free the result, it lives until `pxs_arenareset` or `pxs_freearena`.
+///
+/// arena:BORROW
+/// str:BORROW
+/// result:BORROW
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_var_fromname(rt: pxs_VarT, name: *const c_char) -> pxs_VarT {
-    pxs_debug!("pxs_var_fromname");
+pub extern "C" fn pxs_arena_newstr(arena: *mut pxs_PixelArena, str: *const c_char) -> *mut c_char {
+    pxs_debug!("pxs_arena_newstr");
     assert_initiated!();
-    if name.is_null() {
-        return pxs_Var::null_param_ep("name").into_raw();
-    }
 
-    let bname = borrow_string!(name);
-    let runtime = unsafe { pxs_Runtime::from_var_ptr(rt) };
-    if let Some(runtime) = runtime {
-        with_backend!(runtime, Backend => {
-            let res = Backend::get_from_name(bname);
-            if res.is_err() {
-                pxs_Var::new_exception(res.unwrap_err().to_string())
-            } else {
-                res.unwrap()
-            }
-        })
-        .into_raw()
-    } else {
-        pxs_Var::unkown_runtime_var_ep(rt).into_raw()
+    if arena.is_null() || str.is_null() {
+        return core::ptr::null_mut();
     }
+
+    let barena = unsafe { pxs_PixelArena::from_borrow(arena) };
+    barena.new_str(unsafe { CStr::from_ptr(str) })
 }
 
-/// Remove a item from a list at a specific index.
+/// Free everything in a `pxs_PixelArena` but keep the arena for reuse.
 ///
-/// Returns true for success, false for failed.
-/// 
-/// This will automatically call `pxs_freevar` on the found item.
+/// Strings from `pxs_arena_newstr` reuse the same memory afterwards, and freed vars are kept for the next `pxs_new*` calls
+/// of this thread instead of going back to the allocator. Cheaper than a `pxs_freearena` + `pxs_newarena` per frame.
 ///
-/// list:BORROW
+/// arena:BORROW
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_listdel(list: pxs_VarT, index: i32) -> bool {
-    pxs_debug!("pxs_listdel");
-    if list.is_null() {
-        return false;
-    }
+pub extern "C" fn pxs_arenareset(arena: *mut pxs_PixelArena) {
+    pxs_debug!("pxs_arenareset");
+    assert_initiated!();
 
-    let var = borrow_var!(list);
-    if !var.is_list() {
-        return false;
+    if arena.is_null() {
+        return;
     }
 
-    // Ok so it's a List and it's not null! Lets delete the item
-    let var_list = var.get_list().unwrap();
-    var_list.del_item(index)
+    let barena = unsafe { pxs_PixelArena::from_borrow(arena) };
+    barena.reset();
+}
+
+/// Debug state info.
+///
+/// result:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_debugstate(runtime: pxs_Runtime) -> *mut c_char {
+    pxs_debug!("pxs_debugstate");
+    assert_initiated!();
+    with_backend!(runtime, Backend => {
+        create_raw_string!(Backend::debug())
+    })
 }
 
-/// Do a Shallow Copy. Which means it gets the same data without get the deleter for (pxs_Object or pxs_Function).
+/// Numbers of the current threads `runtime` state, as a flat map of ints for dashboards (`pxs_debugstate` is for
+/// people). Every runtime has:
+/// - `bytes`, `peak`, `limit`, `gc_cycles`: as in `pxs_memstats`
+/// - `vars`: pxs_Vars alive on this thread (all runtimes)
+/// - `host_objects`: host objects in this threads lookup (all runtimes)
+/// - `functions`: host functions in this threads lookup (all runtimes)
+/// - `gc_full`, `gc_steps`, `gc_auto`, `gc_pause_ns`, `gc_max_pause_ns`, `gc_reclaimed`: collections on this thread,
+///   as in `pxs_gcstats` (`gc_auto` only counts while `pxs_gcstats_enable` is on)
 ///
-/// Memory is owned by caller.
+/// Lua adds `stack_depth` (Lua calls running), `stack_top`, `registry_size` and `globals`. JS adds
+/// `defined_objects`, `modules` (imported host modules), `lazy_modules` (not imported yet) and every
+/// `JS_ComputeMemoryUsage` field (i.e. `obj_count`, `malloc_size`). Python adds `vm`, `vms_active`,
+/// `defined_objects` and `objects_collected` (pocketpy keeps its heap counts private).
+///
+/// Counting Lua tables walks them, cheap for a scrape every few seconds but not for every frame.
 ///
-/// var:BORROW
 /// return:OWNED
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_new_shallowcopy(var: pxs_VarT) -> pxs_VarT {
-    pxs_debug!("pxs_new_shallowcopy");
-    if var.is_null() {
-        return pxs_Var::null_param_ep("var").into_raw();
-    }
+pub extern "C" fn pxs_runtimestats(runtime: pxs_Runtime) -> pxs_VarT {
+    pxs_debug!("pxs_runtimestats");
+    assert_initiated!();
 
-    // Apply a shallow copy.
-    let bvar = borrow_var!(var);
-    bvar.shallow_copy().into_raw()
+    let mut map = pxs_VarMap::new_ordered();
+    let mem = with_backend!(runtime, Backend => {
+        Backend::mem_stats()
+    });
+    let entries = [
+        ("bytes", mem.bytes as i64),
+        ("peak", mem.peak as i64),
+        ("limit", mem.limit as i64),
+        ("gc_cycles", mem.gc_cycles as i64),
+        ("vars", live_vars() as i64),
+        ("host_objects", live_objects() as i64),
+        ("functions", lookup_len() as i64),
+    ];
+    for (key, value) in entries {
+        map.add_str(key, pxs_Var::new_i64(value));
+    }
+    gcstats::add_totals(&runtime, &mut map);
+    with_backend!(runtime, Backend => {
+        Backend::runtime_stats(&mut map);
+    });
+    pxs_Var::new_map_with(map).into_raw()
 }
 
-/// Compile a code string into a code object for later execution.
-///
-/// Pass in a optional gloabl scope (or null for default). Scope ownership is transferred.
-/// Returns a `pxs_Var` whichs memory is handled by the caller.
-///
-/// Resulting `pxs_Var` will contain (Associated Runtime, Code Object, Scope|default).
+/// What changed between two stats maps (i.e. two `pxs_runtimestats`, `pxs_memstats` or `pxs_funcstats`): every
+/// number in `after` minus the same key in `before` (0 when missing there), nested maps diffed the same way. Other
+/// values are left out.
 ///
-/// global_scope:TRANSFER
+/// before: BORROW
+/// after: BORROW
 /// return:OWNED
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_compile(
-    runtime: pxs_Runtime,
-    code: *const c_char,
-    global_scope: pxs_VarT,
-) -> pxs_VarT {
-    pxs_debug!("pxs_compile");
+pub extern "C" fn pxs_statsdiff(before: pxs_VarT, after: pxs_VarT) -> pxs_VarT {
+    pxs_debug!("pxs_statsdiff");
     assert_initiated!();
 
-    if code.is_null() || global_scope.is_null() {
+    if before.is_null() || after.is_null() {
         return pxs_Var::null_params_ep().into_raw();
     }
+    let before = unsafe { pxs_Var::from_borrow(before) };
+    let after = unsafe { pxs_Var::from_borrow(after) };
+    if !after.is_map() {
+        return pxs_Var::incorrect_type_ep(pxs_VarType::pxs_Map, after.tag).into_raw();
+    }
+    stats_diff(Some(&*before), after).into_raw()
+}
 
-    let rcode = borrow_string!(code);
-    let scope = own_var!(global_scope);
-
-    // Make sure scope is map or is null.
-    if !scope.is_map() && !scope.is_null() {
-        return pxs_Var::new_exception("Global scope must be a Map or Null".to_string()).into_raw();
+/// `after - before` of the numbers of the map `after`.
+fn stats_diff(before: Option<&pxs_Var>, after: &pxs_Var) -> pxs_Var {
+    let before = before.and_then(|before| before.get_map());
+    let after = after.get_map().unwrap();
+    let mut diff = pxs_VarMap::new_ordered();
+    for (key, value) in after.iter() {
+        let key = key.as_var();
+        let old = before.as_ref().and_then(|before| before.get_item(&key));
+        let changed = match value.tag {
+            pxs_VarType::pxs_Map => stats_diff(old, value),
+            pxs_VarType::pxs_Int64 | pxs_VarType::pxs_UInt64 => {
+                let old = old.and_then(|old| old.as_i64()).unwrap_or(0);
+                pxs_Var::new_i64(value.as_i64().unwrap().wrapping_sub(old))
+            }
+            pxs_VarType::pxs_Float64 => {
+                let old = old.and_then(|old| old.as_f64()).unwrap_or(0.0);
+                pxs_Var::new_f64(value.as_f64().unwrap() - old)
+            }
+            _ => continue,
+        };
+        diff.add_item(key.into_owned(), changed);
     }
+    pxs_Var::new_map_with(diff)
+}
 
-    let res = with_backend!(runtime, Backend => {
-        let res = Backend::compile(rcode, scope);
-        if res.is_err() {
-            pxs_Var::new_exception(res.unwrap_err().to_string())
-        } else {
-            res.unwrap()
-        }
+/// Memory of the current threads `runtime` state, as a map with:
+/// - `bytes`: allocated right now
+/// - `peak`: most bytes at once
+/// - `limit`: from `pxs_setmemlimit`, 0 for none
+/// - `gc_cycles`: full collections run through `pxs_garbagecollect` or finished by `pxs_gcstep`
+/// - `vars`: pxs_Vars alive on this thread (all runtimes)
+/// - `objects`: host objects in this threads lookup (all runtimes)
+///
+/// Python memory is counted per VM, and includes what pocketpy keeps in its own pools.
+///
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_memstats(runtime: pxs_Runtime) -> pxs_VarT {
+    pxs_debug!("pxs_memstats");
+    assert_initiated!();
+    let stats = with_backend!(runtime, Backend => {
+        Backend::mem_stats()
     });
 
-    if !res.is_list() {
-        return res.into_raw();
+    let mut map = pxs_VarMap::new();
+    let entries = [
+        ("bytes", stats.bytes as i64),
+        ("peak", stats.peak as i64),
+        ("limit", stats.limit as i64),
+        ("gc_cycles", stats.gc_cycles as i64),
+        ("vars", live_vars() as i64),
+        ("objects", live_objects() as i64),
+    ];
+    for (key, value) in entries {
+        map.add_str(key, pxs_Var::new_i64(value));
     }
-
-    // Add the runtime to the object.
-    let list = res.get_list().unwrap();
-    list.insert_item(0, runtime.into_var());
-
-    res.into_raw()
+    pxs_Var::new_map_with(map).into_raw()
 }
 
-/// Execute a compiled code object.
-///
-/// Variable ownership is transfered. If this is not desired behavior, pass in a shallow copy.
-/// Returned variable must be freed by caller.
+/// Limit the memory of the current threads `runtime` state to `bytes`, 0 for no limit.
 ///
-/// Runtime is not required because the object is embedded with it in pxs_compile.
-/// Pass in a optional local scope that gets passed along with the global scope.
-/// Note: Do not use the same scope as in `pxs_compile`.
-///
-/// Scope ownership is transferred.
+/// An allocation over the limit fails in the script that made it (a Lua memory error, a JS out of memory error),
+/// the state stays usable. Lower than what the state holds only stops it from growing. Lua checks it only while its
+/// code runs: what host callbacks and the host push into Lua is counted but never refused, the script fails on its
+/// next allocation instead.
 ///
-/// object : TRANSFER
-/// local  : TRANSFER
-/// return : OWNED
+/// Returns false for Python, pocketpy can not survive a failed allocation.
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_execobject(object: pxs_VarT, local: pxs_VarT) -> pxs_VarT {
-    pxs_debug!("pxs_execobject");
+pub extern "C" fn pxs_setmemlimit(runtime: pxs_Runtime, bytes: usize) -> bool {
+    pxs_debug!("pxs_setmemlimit");
     assert_initiated!();
+    with_backend!(runtime, Backend => {
+        Backend::set_mem_limit(bytes)
+    })
+}
 
-    if object.is_null() || local.is_null() {
-        return pxs_Var::null_params_ep().into_raw();
-    }
+/// Call GC for all backends.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_garbagecollect() {
+    pxs_debug!("pxs_gc");
+    assert_initiated!();
 
-    let var = own_var!(object);
+    with_feature!("lua", {
+        if deferred::started(&pxs_Runtime::pxs_Lua) {
+            gcstats::collect::<LuaScripting, _>(&pxs_Runtime::pxs_Lua, gcstats::Kind::Full, LuaScripting::garbage_collect);
+        }
+    });
+    with_feature!("python", {
+        if deferred::started(&pxs_Runtime::pxs_Python) {
+            gcstats::collect::<PythonScripting, _>(&pxs_Runtime::pxs_Python, gcstats::Kind::Full, PythonScripting::garbage_collect);
+        }
+    });
+    with_feature!("js", {
+        if deferred::started(&pxs_Runtime::pxs_JavaScript) {
+            gcstats::collect::<JSScripting, _>(&pxs_Runtime::pxs_JavaScript, gcstats::Kind::Full, JSScripting::garbage_collect);
+        }
+    });
+}
 
-    if !var.is_list() {
-        return pxs_Var::incorrect_type_ep(pxs_VarType::pxs_List, var.tag).into_raw();
-    }
+/// Do about `budget_us` microseconds of collection work in the current threads `runtime` state, at least one step.
+///
+/// Returns true when a full cycle finished. Lua steps its incremental collector until the budget is spent.
+/// QuickJS frees most memory by reference count and its cycle collector is not incremental, so a step only collects
+/// once memory grew enough that QuickJS would have. pocketpy only has a full collection, which every step runs.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_gcstep(runtime: pxs_Runtime, budget_us: u64) -> bool {
+    pxs_debug!("pxs_gcstep");
+    assert_initiated!();
+    with_backend!(runtime, Backend => {
+        gcstats::collect::<Backend, _>(&runtime, gcstats::Kind::Step, || {
+            Backend::gc_step(std::time::Duration::from_micros(budget_us))
+        })
+    })
+}
 
-    // Get scope
-    let scope = own_var!(local);
-    // Check if scope is a map
-    if !scope.is_map() && !scope.is_null() {
-        return pxs_Var::incorrect_types_ep(
-            vec![pxs_VarType::pxs_Map, pxs_VarType::pxs_Null],
-            scope.tag,
-        )
-        .into_raw();
-    }
+/// Let the current threads `runtime` state collect garbage on its own (the default), or only through
+/// `pxs_gcstep` and `pxs_garbagecollect` so the host decides when it pays for it.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_setautogc(runtime: pxs_Runtime, enabled: bool) {
+    pxs_debug!("pxs_setautogc");
+    assert_initiated!();
+    with_backend!(runtime, Backend => {
+        Backend::set_auto_gc(enabled);
+    })
+}
 
-    let list = var.get_list().unwrap();
-    let rt = list.get_item(0);
-    if let Some(rt) = rt {
-        let runtime = pxs_Runtime::from_var(rt);
-        if let Some(runtime) = runtime {
-            // Now we can do stuff
-            with_backend!(runtime, Backend => {
-                let res = Backend::exec_object(var, scope);
-                if res.is_err() {
-                    pxs_Var::new_exception(res.unwrap_err().to_string())
-                } else {
-                    res.unwrap()
-                }
-            })
-            .into_raw()
-        } else {
-            pxs_Var::new_exception(format!("Unkown runtime: {:#?}", rt)).into_raw()
+/// Log every garbage collection from now on (or stop logging), and watch the ones runtimes run on their own in the
+/// states of this thread and the ones made later. Off by default. Logged collections are kept when turned off, until
+/// `pxs_gcstats_reset`.
+///
+/// Automatic collections show up in `pxs_settracer` as `pxs_TraceGC` events named `auto`. pocketpy reports both
+/// ends of a collection so they are timed. Lua (collecting in steps inside allocations) and QuickJS (collecting inside
+/// a allocation) are only seen once they are over: a begin and end right after each other, and `ns` of -1 in the
+/// log. QuickJS ones are looked for after every `pxs_exec`/`pxs_call`. Turn automatic collection off
+/// (`pxs_setautogc`) and use `pxs_gcstep` to have every pause timed.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_gcstats_enable(enabled: bool) {
+    pxs_debug!("pxs_gcstats_enable");
+    assert_initiated!();
+
+    gcstats::set_enabled(enabled);
+    with_feature!("lua", {
+        if deferred::started(&pxs_Runtime::pxs_Lua) {
+            LuaScripting::watch_gc(enabled);
         }
-    } else {
-        pxs_Var::new_exception("Code Object list is empty").into_raw()
-    }
+    });
+    with_feature!("python", {
+        if deferred::started(&pxs_Runtime::pxs_Python) {
+            PythonScripting::watch_gc(enabled);
+        }
+    });
+    with_feature!("js", {
+        if deferred::started(&pxs_Runtime::pxs_JavaScript) {
+            JSScripting::watch_gc(enabled);
+        }
+    });
 }
 
-/// Create a new `pxs_Map`
+/// The collections logged while `pxs_gcstats_enable` was on, from every thread, as a map with:
+/// - `runtimes`: by runtime (`lua`, `python`, `js`), `full` (`pxs_garbagecollect`), `steps` (`pxs_gcstep`) and
+///   `auto` counts, `pause_ns` and `max_pause_ns` of the timed ones, and `reclaimed` bytes
+/// - `events`: the last 1024, oldest first, each with `runtime`, `kind` (`full`, `step` or `auto`), `start_us` (on the
+///   clock of `pxs_tracewriter_stop`), `ns` (-1 when not timed), `reclaimed` and `bytes` left in use
+/// - `dropped`: events that did not fit
+///
+/// `pxs_runtimestats` has the same totals for the state of the current thread, always counted.
 ///
 /// return:OWNED
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_newmap() -> pxs_VarT {
-    pxs_debug!("pxs_newmap");
-    pxs_Var::new_map().into_raw()
+pub extern "C" fn pxs_gcstats() -> pxs_VarT {
+    pxs_debug!("pxs_gcstats");
+    assert_initiated!();
+
+    gcstats::snapshot().into_raw()
 }
 
-/// Add a new key (`pxs_Var`) value (`pxs_Var`) pair in a map.
-///
-/// Keys can only be:
-/// - `pxs_String`
-/// - `pxs_Int64`
-/// - `pxs_UInt64`
-/// - `pxs_Float64`
-/// - `pxs_Bool`
-///
-/// Key and value ownership are transfered.
-///
-/// map:BORROW
-/// key:TRANSFER
-/// value:TRANSFER
+/// Forget the log of `pxs_gcstats`.
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_map_addpair(map: pxs_VarT, key: pxs_VarT, value: pxs_VarT) {
-    pxs_debug!("pxs_map_addpair");
-    if map.is_null() || key.is_null() || value.is_null() {
-        // TODO: error
-        return;
-    }
+pub extern "C" fn pxs_gcstats_reset() {
+    pxs_debug!("pxs_gcstats_reset");
+    assert_initiated!();
 
-    // Check map is actually a map
-    let map = borrow_var!(map);
-    if !map.is_map() {
-        // TODO: error
-        return;
-    }
+    gcstats::reset();
+}
 
-    // Check key is valid pair
-    let key = own_var!(key);
-    if key.is_string() || key.is_i64() || key.is_bool() || key.is_u64() || key.is_f64() {
-        let internal = map.get_map().unwrap();
-        internal.add_item(key, own_var!(value));
-    } else {
-        // TODO: error
-        return;
+/// Tag the pxs_Vars this thread hands out from now on in `pxs_leakreport`, i.e. with the request or system
+/// making them. NULL clears the tag. Does nothing without the `pxs_trace` feature.
+///
+/// tag: BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_settracetag(tag: *const c_char) {
+    pxs_debug!("pxs_settracetag");
+    assert_initiated!();
+
+    #[cfg(feature = "pxs_trace")]
+    {
+        let tag = if tag.is_null() { None } else { Some(borrow_string!(tag)) };
+        shared::trace::set_tag(tag);
     }
+    #[cfg(not(feature = "pxs_trace"))]
+    let _ = tag;
 }
 
-/// Remove a value (`pxs_Var`) from a map based on it's key (`pxs_Var`).
+/// The pxs_Vars handed to the host and not freed yet, grouped by where they were made: count, type, the C API call
+/// that returned them, the runtime being called at the time and the `pxs_settracetag` tag. Most first.
 ///
-/// map:BORROW
-/// key:BORROW
+/// Needs the `pxs_trace` feature, without it the report says so.
+///
+/// result: OWNED
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_map_delitem(map: pxs_VarT, key: pxs_VarT) {
-    pxs_debug!("pxs_map_delitem");
-    if map.is_null() || key.is_null() {
-        // TODO: error
-        return;
-    }
+pub extern "C" fn pxs_leakreport() -> *mut c_char {
+    pxs_debug!("pxs_leakreport");
+    assert_initiated!();
 
-    let map = borrow_var!(map);
-    if !map.is_map() {
-        // TODO: error
-        return;
-    }
+    #[cfg(feature = "pxs_trace")]
+    let report = shared::trace::report();
+    #[cfg(not(feature = "pxs_trace"))]
+    let report = String::from("pxs_leakreport needs the pxs_trace feature\n");
+    create_raw_string!(report)
+}
 
-    let key = borrow_var!(key);
-    let internal = map.get_map().unwrap();
-    internal.del_item(key);
+/// Start sampling the scripts of every thread `hz` times a second (at most 10000). Calls into a runtime that start
+/// after this are sampled: the Lua, JS and Python stack (and the host functions they call, as `[host]` frames) is
+/// recorded when the runtime next checks in, about every 1000 Lua instructions, QuickJS interrupt or Python line.
+///
+/// False if it is already running or `hz` is 0.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_profiler_start(hz: u32) -> bool {
+    pxs_debug!("pxs_profiler_start");
+    assert_initiated!();
+
+    profiler::start(hz)
 }
 
-/// Get length of a `pxs_Map`.
+/// Stop the profiler and get its samples as collapsed stacks, one `frame;frame;frame count` line per stack with the
+/// most sampled first. Ready for flamegraph tools (i.e. `flamegraph.pl`, speedscope). Empty if it was not running.
 ///
-/// -1 is invalid length.
+/// Free with `pxs_freestr`.
 ///
-/// map:BORROW
+/// result: OWNED
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_maplen(map: pxs_VarT) -> i32 {
-    pxs_debug!("pxs_maplen");
-    if map.is_null() {
-        return -1;
-    }
+pub extern "C" fn pxs_profiler_stop() -> *mut c_char {
+    pxs_debug!("pxs_profiler_stop");
+    assert_initiated!();
 
-    let bvar = borrow_var!(map);
-    if bvar.is_map() {
-        bvar.get_map().unwrap().len() as i32
-    } else {
-        -1
-    }
+    create_raw_string!(profiler::stop())
 }
 
-/// Get the keys of a `pxs_Map`.
-///
-/// Returns a `pxs_List` or `pxs_Null` Which is owned by caller.
+/// Record the calls scripts make to host functions from now on (or stop recording). Off by default, when off a call
+/// costs one extra flag check. Recorded stats are kept when turned off, until `pxs_funcstats_reset`.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_funcstats_enable(enabled: bool) {
+    pxs_debug!("pxs_funcstats_enable");
+    assert_initiated!();
+
+    funcstats::set_enabled(enabled);
+}
+
+/// Stats of the host functions called while `pxs_funcstats_enable` was on, from every thread. A map by the function
+/// name as it is in the lookup (`_{module}{name}`, `_{type}{method}`), then by runtime (`lua`, `python`, `js`, `wren`),
+/// each with:
+/// - `calls`: times called
+/// - `total_ns`, `max_ns`, `mean_ns`: time in the function, from its args as pxs_Vars to its result
+/// - `p50_ns`, `p90_ns`, `p99_ns`, `p999_ns`: percentiles, within 12.5%
+/// - `histogram`: list of `[upper_ns, count]` for every bucket with calls, 8 buckets per power of two
 ///
-/// map:BORROW
 /// return:OWNED
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_mapkeys(map: pxs_VarT) -> pxs_VarT {
-    pxs_debug!("pxs_mapkeys");
-    if map.is_null() {
-        return pxs_Var::null_param_ep("map").into_raw();
-    }
+pub extern "C" fn pxs_funcstats() -> pxs_VarT {
+    pxs_debug!("pxs_funcstats");
+    assert_initiated!();
 
-    // Check is map
-    let map = borrow_var!(map);
-    if !map.is_map() {
-        return pxs_Var::incorrect_type_ep(pxs_VarType::pxs_Map, map.tag).into_raw();
-    }
-    let internals = map.get_map().unwrap();
+    funcstats::snapshot().into_raw()
+}
 
-    let result = pxs_Var::new_list();
-    let list = result.get_list().unwrap();
+/// Forget the stats of `pxs_funcstats`.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_funcstats_reset() {
+    pxs_debug!("pxs_funcstats_reset");
+    assert_initiated!();
 
-    // Get keys..
-    let keys = internals.keys();
-    for k in keys {
-        // Deep copy the key over.
-        list.add_item(k.clone());
-    }
+    funcstats::reset();
+}
 
-    result.into_raw()
+/// Follow the host objects added from now on (or stop following new ones): how many of each type are created,
+/// destroyed and alive, and how often their reference counts change, i.e. to find the scripts that churn host objects.
+/// Off by default, when off adding a object costs one extra flag check. Kept when turned off, until
+/// `pxs_objstats_reset`.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_objstats_enable(enabled: bool) {
+    pxs_debug!("pxs_objstats_enable");
+    assert_initiated!();
+
+    objstats::set_enabled(enabled);
 }
 
-/// Get a value in a map from a key.
+/// Stats of the host objects added while `pxs_objstats_enable` was on, from every thread. A map by type name (the
+/// `type_name` of `pxs_newobject`/`pxs_newtype`, the class type name for `pxs_newinstance`), each with:
+/// - `created`, `destroyed`: objects added to and freed from the object lookup
+/// - `live`: still alive, `peak`: most alive at once (per thread, added up)
+/// - `ref_ops`: reference count changes, i.e. every var made or freed holding one, creating and destroying included
+/// - `ref_ops_per_sec`: `ref_ops` over the time since recording was turned on or reset
 ///
-/// Result is not owned by caller. Use `pxs_newcopy` to transfer ownership.
-///
-/// map:BORROW
-/// key:BORROW
-/// return:BORROW
+/// return:OWNED
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_mapget(map: pxs_VarT, key: pxs_VarT) -> pxs_VarT {
-    pxs_debug!("pxs_mapget");
+pub extern "C" fn pxs_objstats() -> pxs_VarT {
+    pxs_debug!("pxs_objstats");
+    assert_initiated!();
 
-    if map.is_null() || key.is_null() {
-        return pxs_Var::null_params_ep().into_raw();
-    }
+    objstats::snapshot().into_raw()
+}
 
-    // check map
-    let map = borrow_var!(map);
-    if !map.is_map() {
-        return pxs_Var::incorrect_type_ep(pxs_VarType::pxs_Map, map.tag).into_raw();
-    }
-    let internal = map.get_map().unwrap();
-    let res = internal.get_item(borrow_var!(key));
+/// Forget the stats of `pxs_objstats`. Objects alive stay counted as `live`.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_objstats_reset() {
+    pxs_debug!("pxs_objstats_reset");
+    assert_initiated!();
 
-    // Return a const pxs_Var.
-    if let Some(res) = res {
-        res as *const pxs_Var as *mut pxs_Var
-    } else {
-        pxs_Var::item_not_found_ep().into_raw()
-    }
+    objstats::reset();
 }
 
-/// Insert a item into a list at a certain index, shifting all other items to the right.
+/// Where startup went, as a map with:
+/// - `initialize`: all of `pxs_initialize`
+/// - `phases`: list in start order, each with `name`, `runtime` (empty for host phases), `depth` (phases inside
+///   phases), i.e. each runtimes `start` with its `vm`, `stdlib`, `core_modules` and `globals`, and the ones of
+///   `pxs_startupbegin`
+/// - `modules`: list of every `pxs_addmod`, each with `name`, `functions` (submodules included) and `runtimes`,
+///   the cost of adding it to each runtime
+/// - `modules_total`: all of `modules`
 ///
-/// Item ownership is transferred.
+/// Every cost is a map of `ns`, `allocs` (new blocks of the language states) and `bytes` (allocated by them).
 ///
-/// list:BORROW
-/// item:TRANSFER
+/// return:OWNED
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_listinsert(list: pxs_VarT, index: usize, item: pxs_VarT) {
-    pxs_debug!("pxs_listinsert");
+pub extern "C" fn pxs_startupstats() -> pxs_VarT {
+    pxs_debug!("pxs_startupstats");
+    assert_initiated!();
 
-    if list.is_null() || item.is_null() {
-        // TODO: log something?
-        return;
-    }
+    startup::snapshot().into_raw()
+}
 
-    // Check is list
-    let list = borrow_var!(list);
-    if !list.is_list() {
-        // TODO: log something?
+/// Begin a host startup phase named `name` in `pxs_startupstats`, i.e. around loading assets or `yoyo_init`. Phases
+/// begun while one is open are inside it. End it with `pxs_startupend`.
+///
+/// name: BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_startupbegin(name: *const c_char) {
+    pxs_debug!("pxs_startupbegin");
+    assert_initiated!();
+
+    if name.is_null() {
         return;
     }
-
-    let item = own_var!(item);
-    let internal = list.get_list().unwrap();
-    internal.insert_item(index, item);
+    startup::begin(None, borrow_string!(name));
 }
 
-/// Create a new arena in memory.
-/// This does not return anything, it simply creates a scope that will allocate pxs_Var memory.
-/// when finished call, `pxs_freearena`
-///
-/// result:OWNED
+/// End the last phase `pxs_startupbegin` began on this thread. False if none is open.
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_newarena() -> *mut pxs_PixelArena {
-    pxs_debug!("pxs_newarena");
+pub extern "C" fn pxs_startupend() -> bool {
+    pxs_debug!("pxs_startupend");
     assert_initiated!();
 
-    let arena = pxs_PixelArena::new();
-    arena.into_raw()
+    startup::end()
 }
 
-/// Free arena. Upon freeing all variables allocated since `pxs_newarena` will be freed.
+/// Send begin/end events of `pxs_exec`/`pxs_execobject`, `pxs_call`/`pxs_callv`, module imports, garbage collection
+/// and host function calls (see `pxs_TraceKind`) to `tracer` from now on, i.e. to put them on the timeline of a engine
+/// profiler. NULL removes the tracer. Events come from every thread, on the thread doing the work.
 ///
-/// arena:TRANSFER
+/// tracer: BORROW, NULLABLE. Copied.
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_freearena(arena: *mut pxs_PixelArena) {
-    pxs_debug!("pxs_freearena");
+pub extern "C" fn pxs_settracer(tracer: *const pxs_Tracer) {
+    pxs_debug!("pxs_settracer");
     assert_initiated!();
 
-    if arena.is_null() {
-        return;
-    }
-
-    let _ = pxs_PixelArena::from_raw(arena);
+    let tracer = if tracer.is_null() { None } else { Some(unsafe { *tracer }) };
+    tracer::set_tracer(tracer);
 }
 
-/// Add a `pxs_VarT` to a `pxs_PixelArena`. Upon freeing the Arena, the variable is freed aswell.
+/// Start the built in trace writer: keep the next `capacity` events of every thread (the ones after are counted as
+/// dropped) for `pxs_tracewriter_stop`. Works next to a `pxs_settracer` tracer.
 ///
-/// A variable must only be added once.
-/// 
-/// arena:BORROW
-/// var:TRANSFER
-/// result:BORROW
+/// False if it is already running or `capacity` is 0.
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_arenaput(arena: *mut pxs_PixelArena, var: pxs_VarT) -> pxs_VarT {
-    pxs_debug!("pxs_arenaput");
+pub extern "C" fn pxs_tracewriter_start(capacity: usize) -> bool {
+    pxs_debug!("pxs_tracewriter_start");
     assert_initiated!();
 
-    if arena.is_null() || var.is_null() {
-        return std::ptr::null_mut();
-    }
+    tracer::writer_start(capacity)
+}
 
-    let barena = unsafe { pxs_PixelArena::from_borrow(arena) };
-    barena.alloc(var);
+/// Stop the trace writer and get its events as Chrome trace JSON, for `chrome://tracing` or Perfetto. Timestamps are
+/// microseconds since the first `pxs_tracewriter_start`. Empty if it was not running.
+///
+/// Free with `pxs_freestr`.
+///
+/// result: OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_tracewriter_stop() -> *mut c_char {
+    pxs_debug!("pxs_tracewriter_stop");
+    assert_initiated!();
 
-    var
+    create_raw_string!(tracer::writer_stop())
 }
 
-/// Add a `char*` to a `pxs_PixelArena`. Upon freeing the Arena, the string is freed aswell.
-/// 
-/// This must be a string allocated by pixelscript. Either in:
-/// - `pxs_getstring`
-/// - `pxs_smart_getstring`
-/// - `pxs_debugstate`
-/// 
-/// A string must only be added once.
-/// 
-/// arena:BORROW
-/// str:TRANSFER
-/// result:BORROW
+/// Begin a host span named `name` (a `pxs_TraceMark` event), i.e. a engine frame, so it lines up with pixelscript
+/// events in the trace writer. End it with `pxs_traceend` and the same name. Nothing happens while nothing traces.
+///
+/// name: BORROW
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_arena_putstr(arena: *mut pxs_PixelArena, str: *mut c_char) -> *mut c_char {
-    pxs_debug!("pxs_arena_putstr");
+pub extern "C" fn pxs_tracebegin(name: *const c_char) {
+    pxs_debug!("pxs_tracebegin");
     assert_initiated!();
 
-    if arena.is_null() || str.is_null() {
-        return core::ptr::null_mut();
+    if !name.is_null() && tracer::active() {
+        tracer::emit(true, pxs_TraceKind::pxs_TraceMark, None, borrow_string!(name));
     }
+}
 
-    let barena = unsafe { pxs_PixelArena::from_borrow(arena) };
-    barena.alloc_str(str); 
+/// End the host span of `pxs_tracebegin`.
+///
+/// name: BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_traceend(name: *const c_char) {
+    pxs_debug!("pxs_traceend");
+    assert_initiated!();
 
-    str
+    if !name.is_null() && tracer::active() {
+        tracer::emit(false, pxs_TraceKind::pxs_TraceMark, None, borrow_string!(name));
+    }
 }
 
-/// Debug state info.
+/// Report every `pxs_exec`, `pxs_eval`/`pxs_evalnamed`, `pxs_execobject` and `pxs_call`/`pxs_callv` that ran past
+/// `watchdog.call_us` to `watchdog.slow`, with its runtime, file name, function and time (see `pxs_SlowCall`), i.e.
+/// to find the mods that make frames slow in a released game. Nothing is stopped, for that see `pxs_setbudget`. With
+/// `watchdog.frame_us` the host also calls `pxs_watchdog_frame` once per frame, a frame whose calls ran past it
+/// together is reported with its slowest call.
 ///
-/// result:OWNED
+/// Only the outermost call of a thread is watched. NULL, a NULL callback or both thresholds 0 turn the watchdog off,
+/// it then costs one relaxed load per call.
+///
+/// watchdog: BORROW, NULLABLE. Copied.
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_debugstate(runtime: pxs_Runtime) -> *mut c_char {
-    pxs_debug!("pxs_debugstate");
+pub extern "C" fn pxs_setwatchdog(watchdog: *const pxs_Watchdog) {
+    pxs_debug!("pxs_setwatchdog");
     assert_initiated!();
-    with_backend!(runtime, Backend => {
-        create_raw_string!(Backend::debug())
-    })
+
+    let watchdog = if watchdog.is_null() { None } else { Some(unsafe { *watchdog }) };
+    watchdog::set_watchdog(watchdog);
 }
 
-/// Call GC for all backends.
+/// End the frame of the current thread for `pxs_setwatchdog` and start the next one. Reports the frame when its calls
+/// ran past `frame_us`.
+///
+/// Returns how long the calls of the frame ran, in nanoseconds. 0 while `frame_us` is 0.
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_garbagecollect() {
-    pxs_debug!("pxs_gc");
+pub extern "C" fn pxs_watchdog_frame() -> u64 {
+    pxs_debug!("pxs_watchdog_frame");
     assert_initiated!();
 
-    with_feature!("lua", {
-        LuaScripting::garbage_collect();
-    });
-    with_feature!("python", {
-        PythonScripting::garbage_collect();
-    });
-    with_feature!("js", {
-        JSScripting::garbage_collect();
-    });
+    watchdog::end_frame()
 }
 
 /// Get the host IDX from a `pxs_HostObject`.
@@ -2071,57 +4586,205 @@ pub extern "C" fn pxs_arg(args: pxs_VarT, idx: i32) -> pxs_VarT {
     pxs_listget(args, idx + 1)
 }
 
-/// Get the `pxs_VarT` runtime from args.
-/// 
-/// Does `pxs_listget(args, 0)`
-/// 
-/// args: BORROW
-/// result: BORROW&NULLABLE
+/// Get the `pxs_VarT` runtime from args.
+/// 
+/// Does `pxs_listget(args, 0)`
+/// 
+/// args: BORROW
+/// result: BORROW&NULLABLE
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_getrt(args: pxs_VarT) -> pxs_VarT {
+    pxs_debug!("pxs_getrt");
+    assert_initiated!();
+    pxs_listget(args, 0)
+}
+
+/// Get the length of args without the runtime.
+/// 
+/// args: BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_argc(args: pxs_VarT) -> usize {
+    pxs_debug!("pxs_argc");
+    assert_initiated!();
+    let len = pxs_listlen(args);
+    if len <= 0 {
+        return 0;
+    } else {
+        return (len - 1) as usize;
+    }
+}
+
+/// Create a `pxs_List` of u8. i.e. bytes.
+/// 
+/// data: BORROW
+/// result: OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_newbytes(data: pxs_Opaque, el_size: usize, size: usize) -> pxs_VarT {
+    pxs_debug!("pxs_newbytes");
+    assert_initiated!();
+
+    if data.is_null() {
+        return pxs_newlist();
+    }
+
+    let ptr = data as *mut u8;
+    let total_bytes = el_size * size;
+    let raw_bytes: &mut [u8] = unsafe { core::slice::from_raw_parts_mut(ptr, total_bytes) };
+
+    let mut list = Vec::with_capacity(total_bytes);
+    for i in raw_bytes {
+        list.push(pxs_Var::new_byte(i.clone()));
+    }
+
+    pxs_Var::new_list_with(list).into_raw()
+}
+
+/// Create a `pxs_Buffer` over host memory. Nothing is copied, not here and not when it is passed to Lua or Python:
+/// Lua gets a userdata (`#buf`, `buf[i]`, `tostring(buf)`) and Python a `pxs_buffer` (`len`, `buf[i]`,
+/// `buf.tobytes()`), both read only. JS gets a `ArrayBuffer` copy, since scripts can always write those.
+///
+/// `data` must stay valid and unchanged in size until `deleter` is called. That happens once, when this var, its
+/// clones and every script value using it are gone. Pass NULL for memory the host frees itself after the runtimes stop.
+///
+/// data: BORROW
+/// result: OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_newbytes_borrowed(data: pxs_Opaque, len: usize, deleter: Option<pxs_DeleterFn>) -> pxs_VarT {
+    pxs_debug!("pxs_newbytes_borrowed");
+    assert_initiated!();
+
+    if data.is_null() {
+        return pxs_Var::null_param_ep("data").into_raw();
+    }
+
+    pxs_Var::new_buffer(pxs_VarBuffer::new(data as *mut u8, len, deleter)).into_raw()
+}
+
+/// Get the memory of a `pxs_Buffer` and its size in `len`. NULL if `var` is not a buffer.
+///
+/// var: BORROW
+/// result: BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_getbuffer(var: pxs_VarT, len: *mut usize) -> pxs_Opaque {
+    pxs_debug!("pxs_getbuffer");
+    assert_initiated!();
+
+    if var.is_null() {
+        return ptr::null_mut();
+    }
+
+    let bvar = borrow_var!(var);
+    let Some(buffer) = bvar.get_buffer() else {
+        return ptr::null_mut();
+    };
+    if !len.is_null() {
+        unsafe { *len = buffer.len() };
+    }
+    buffer.data() as pxs_Opaque
+}
+
+/// Wrap a `pxs_List` or `pxs_Map` in a `pxs_Proxy`. Scripts get a view instead of a converted copy, only the items
+/// they read are converted (nested Lists/Maps fully, when read):
+/// Lua gets a userdata (`#p`, `p[i]` 1 based, `p.key`), Python a `pxs_proxy` (`len(p)`, `p[i]`, `p[key]`)
+/// and JS a object (`p.length`, `p[i]`, `p.key`).
+///
+/// Use it for large containers that scripts only look into. The view is read only, and can not be iterated
+/// with `pairs`/`for in`/`Object.keys`.
+///
+/// var: TRANSFER
+/// result: OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_newproxy(var: pxs_VarT) -> pxs_VarT {
+    pxs_debug!("pxs_newproxy");
+    assert_initiated!();
+
+    if var.is_null() {
+        return pxs_Var::null_param_ep("var").into_raw();
+    }
+
+    let owned = pxs_Var::from_raw(var);
+    if !owned.is_list() && !owned.is_map() {
+        return pxs_Var::incorrect_types_ep(vec![pxs_VarType::pxs_List, pxs_VarType::pxs_Map], owned.tag).into_raw();
+    }
+
+    pxs_Var::new_proxy(pxs_VarProxy::new(owned)).into_raw()
+}
+
+/// Get the `pxs_List` or `pxs_Map` behind a `pxs_Proxy`. NULL if `var` is not a proxy. Do not change it.
+///
+/// var: BORROW
+/// result: BORROW
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_getrt(args: pxs_VarT) -> pxs_VarT {
-    pxs_debug!("pxs_getrt");
+pub extern "C" fn pxs_getproxy(var: pxs_VarT) -> pxs_VarT {
+    pxs_debug!("pxs_getproxy");
     assert_initiated!();
-    pxs_listget(args, 0)
+
+    if var.is_null() {
+        return ptr::null_mut();
+    }
+
+    let bvar = borrow_var!(var);
+    let Some(proxy) = bvar.get_proxy() else {
+        return ptr::null_mut();
+    };
+    proxy.target() as *const pxs_Var as pxs_VarT
 }
 
-/// Get the length of args without the runtime.
-/// 
-/// args: BORROW
+/// Publish a `pxs_List` or `pxs_Map` of plain data (no objects or functions) as `name`, for every runtime and thread.
+/// It is kept once on the host and frozen: scripts read it through `pxs_Proxy` views (`pxs_data.get(name)`), nested
+/// Lists/Maps are views too, so nothing is converted until a value is read. Publishing `name` again replaces it, views
+/// of the old data keep it alive.
+///
+/// Use it for data every runtime reads (item tables, localization) instead of converting it into each one.
+/// Returns false when `var` can not be published.
+///
+/// var: TRANSFER
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_argc(args: pxs_VarT) -> usize {
-    pxs_debug!("pxs_argc");
+pub extern "C" fn pxs_publish(name: *const c_char, var: pxs_VarT) -> bool {
+    pxs_debug!("pxs_publish");
     assert_initiated!();
-    let len = pxs_listlen(args);
-    if len <= 0 {
-        return 0;
-    } else {
-        return (len - 1) as usize;
+
+    if var.is_null() {
+        return false;
+    }
+    let owned = pxs_Var::from_raw(var);
+    if name.is_null() {
+        return false;
     }
+
+    store::publish(borrow_string!(name), &owned).is_ok()
 }
 
-/// Create a `pxs_List` of u8. i.e. bytes.
-/// 
-/// data: BORROW
-/// result: OWNED
+/// Remove the data published as `name`. Views scripts still hold keep working. False if nothing was published as `name`.
 #[unsafe(no_mangle)]
-pub extern "C" fn pxs_newbytes(data: pxs_Opaque, el_size: usize, size: usize) -> pxs_VarT {
-    pxs_debug!("pxs_newbytes");
+pub extern "C" fn pxs_unpublish(name: *const c_char) -> bool {
+    pxs_debug!("pxs_unpublish");
     assert_initiated!();
 
-    if data.is_null() {
-        return pxs_newlist();
+    if name.is_null() {
+        return false;
     }
 
-    let ptr = data as *mut u8;
-    let total_bytes = el_size * size;
-    let raw_bytes: &mut [u8] = unsafe { core::slice::from_raw_parts_mut(ptr, total_bytes) };
+    store::unpublish(borrow_string!(name))
+}
 
-    let mut list = vec![];
-    for i in raw_bytes {
-        list.push(pxs_Var::new_byte(i.clone()));
+/// A `pxs_Proxy` of the data published as `name`, `pxs_Null` if there is none. It can be passed into any runtime.
+///
+/// return: OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_published(name: *const c_char) -> pxs_VarT {
+    pxs_debug!("pxs_published");
+    assert_initiated!();
+
+    if name.is_null() {
+        return pxs_Var::null_param_ep("name").into_raw();
     }
 
-    pxs_Var::new_list_with(list).into_raw()
+    match store::get(borrow_string!(name)) {
+        Some(proxy) => pxs_Var::new_proxy(proxy),
+        None => pxs_Var::new_null(),
+    }
+    .into_raw()
 }
 
 /// Get the memory size (in bytes) of a `pxs_VarT`
@@ -2147,6 +4810,7 @@ pub extern "C" fn pxs_varsize(var: pxs_VarT) -> usize {
 ///   - `pxs_Bool`
 ///   - `pxs_String`
 ///   - `pxs_List`
+///   - `pxs_Buffer`
 /// 
 /// var: BORROW
 /// data_ptr: BORROW
@@ -2263,9 +4927,14 @@ pub extern "C" fn pxs_vartype(var: pxs_VarT) -> pxs_VarType {
 
 // ====================================== Core functions Start =======================================
 
+/// The key value pairs of a script object (`pxs_Object`) of `runtime`, see `ObjectMethods::entries`.
+pub(crate) fn object_entries(runtime: pxs_Runtime, var: &pxs_Var) -> shared::PxsRes<Vec<(pxs_Var, pxs_Var)>> {
+    with_backend!(runtime, Backend => { Backend::entries(var) })
+}
+
 /// Encode a `pxs_Var` into a JSON string. Will return a `pxs_Var` of type string.
-/// Transfers ownership of args.
-/// Basically calls the runtime.pxs_json.encode() function.
+/// `args` is a list holding the value. Transfers ownership of args.
+/// Uses the native encoder of `pxs_json`, `rt` is only needed to look into script objects (`pxs_Object`).
 ///
 /// Note: This function is already enabled in each scripting language. This is a host language wrapper for calling it easily.
 ///
@@ -2284,15 +4953,17 @@ pub extern "C" fn pxs_json_encode(rt: pxs_VarT, args: pxs_VarT) -> pxs_VarT {
                     return pxs_Var::new_exception("Not a valid core call").into_raw();
                 }
             }
-            pxs_core::pxs_json::encode(rt, args)
+            let res = pxs_core::pxs_json::encode(rt, pxs_listget(args, 0));
+            pxs_freevar(args);
+            res
         },
         { pxs_Var::feature_not_enabled_ep("pxs_json").into_raw() }
     )
 }
 
-/// Decode a `pxs_String` into a `pxs_Var`.
-/// Make sure runtime is the first argument in args.
-/// Transfers ownership of args.
+/// Decode a `pxs_String` (or a `pxs_Buffer` of JSON text) into a `pxs_Var`. Objects become `pxs_Map`s and arrays
+/// `pxs_List`s.
+/// `args` is a list holding the string. Transfers ownership of args.
 ///
 /// Note: This function is already enabled in each scripting language. This is a host language wrapper for calling it easily.
 ///
@@ -2311,12 +4982,106 @@ pub extern "C" fn pxs_json_decode(rt: pxs_VarT, args: pxs_VarT) -> pxs_VarT {
                     return pxs_Var::new_exception("Not a valid core call").into_raw();
                 }
             }
-            pxs_core::pxs_json::decode(rt, args)
+            let res = pxs_core::pxs_json::decode(pxs_listget(args, 0));
+            pxs_freevar(args);
+            res
         },
         { pxs_Var::feature_not_enabled_ep("pxs_json").into_raw() }
     )
 }
 
+/// Start a streaming JSON decode. Feed the text in chunks with `pxs_json_feed` and get the value with
+/// `pxs_json_finish`, the text is never held whole. `yoyo.fs` and `yoyo.zip` use it for `read_json`.
+///
+/// `pointer` is a JSON pointer (RFC 6901, i.e. `/mods/0/name`) to only build that value, the rest is checked and
+/// dropped. NULL or `""` builds the whole document.
+///
+/// pointer:BORROW
+/// return:OWNED
+#[cfg(feature = "pxs_json")]
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_json_newstream(pointer: *const c_char) -> *mut pxs_core::pxs_json::pxs_JsonStream {
+    pxs_debug!("pxs_json_newstream");
+    assert_initiated!();
+
+    let pointer = if pointer.is_null() { "" } else { borrow_string!(pointer) };
+    pxs_core::pxs_json::pxs_JsonStream::new(pointer).into_raw()
+}
+
+/// Decode the next `len` bytes of the text. Chunks can end anywhere. False once the text is invalid, the error is
+/// returned by `pxs_json_finish`.
+///
+/// stream:BORROW
+/// data:BORROW
+#[cfg(feature = "pxs_json")]
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_json_feed(stream: *mut pxs_core::pxs_json::pxs_JsonStream, data: *const c_char, len: usize) -> bool {
+    pxs_debug!("pxs_json_feed");
+    assert_initiated!();
+
+    if stream.is_null() || (data.is_null() && len > 0) {
+        return false;
+    }
+    let data = if len == 0 { &[][..] } else { unsafe { std::slice::from_raw_parts(data as *const u8, len) } };
+    unsafe { (*stream).feed(data).is_ok() }
+}
+
+/// End a streaming decode and free `stream`. Returns the decoded (or pointed to) value, or a exception.
+///
+/// stream:TRANSFER
+/// return:OWNED
+#[cfg(feature = "pxs_json")]
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_json_finish(stream: *mut pxs_core::pxs_json::pxs_JsonStream) -> pxs_VarT {
+    pxs_debug!("pxs_json_finish");
+    assert_initiated!();
+
+    if stream.is_null() {
+        return pxs_Var::null_param_ep("stream").into_raw();
+    }
+    match pxs_core::pxs_json::pxs_JsonStream::from_raw(stream).finish() {
+        Ok(value) => value,
+        Err(err) => pxs_Var::new_exception(err),
+    }
+    .into_raw()
+}
+
+/// Pack a `pxs_Var` tree into a `pxs_Buffer` of MessagePack. Smaller and faster than JSON, and keeps the types:
+/// `pxs_Int64`/`pxs_UInt64`/`pxs_Byte`/`pxs_Float64` stay apart, `pxs_Buffer`s stay bytes and `pxs_Map` keys do not
+/// have to be strings. The buffer can be written to disk or unpacked in another runtime.
+///
+/// `rt` is only needed to look into script objects (`pxs_Object`), it can be NULL otherwise.
+///
+/// rt:BORROW
+/// var:BORROW
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_pack(rt: pxs_VarT, var: pxs_VarT) -> pxs_VarT {
+    pxs_debug!("pxs_pack");
+    assert_initiated!();
+    with_feature!(
+        "pxs_pack",
+        { pxs_core::pxs_pack::pack(rt, var) },
+        { pxs_Var::feature_not_enabled_ep("pxs_pack").into_raw() }
+    )
+}
+
+/// Unpack the bytes of `pxs_pack` into a new `pxs_Var` tree. `bytes` is a `pxs_Buffer` (i.e. `pxs_newbytes_borrowed`
+/// over a file read by the host), a `pxs_String` or a `pxs_List` of bytes.
+///
+/// bytes:BORROW
+/// return:OWNED
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_unpack(bytes: pxs_VarT) -> pxs_VarT {
+    pxs_debug!("pxs_unpack");
+    assert_initiated!();
+    with_feature!(
+        "pxs_pack",
+        { pxs_core::pxs_pack::unpack(bytes) },
+        { pxs_Var::feature_not_enabled_ep("pxs_pack").into_raw() }
+    )
+}
+
 /// Initialize the `pxs_mem` module.
 /// 
 /// This needs to be called in each new thread too. Should only be called once per thread.
@@ -2347,4 +5112,282 @@ pub extern "C" fn pxs_yoyoinit() {
     });
 }
 
+/// Run the callbacks of finished `yoyo` background work (i.e. `yoyo.fs.read_async`) and the due `yoyo.time` timers.
+///
+/// Call this once per frame from the thread that started the work. Returns the number of completions handled.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_yoyopump() -> i32 {
+    pxs_debug!("pxs_yoyopump");
+    assert_initiated!();
+
+    with_feature!("yoyo", {
+        unsafe { yoyo::yoyo::yoyo_pump() }
+    }, {
+        0
+    })
+}
+
+/// Use the `yoyo.fs` caching disk reader as the file reader (see `pxs_set_filereader`).
+///
+/// Sources are kept in a LRU keyed by path and revalidated against the file's mtime and size,
+/// so importing the same file from multiple runtimes or after `pxs_clear` only reads it once.
+///
+/// budget: max number of bytes to keep cached.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_yoyofilecache(budget: u64) {
+    pxs_debug!("pxs_yoyofilecache");
+    assert_initiated!();
+
+    with_feature!("yoyo_fs", {
+        unsafe { yoyo::yoyo::yoyo_fs_usecache(budget) };
+    }, {
+        panic!("yoyo_fs is not enabled.");
+    });
+}
+
+/// Start or stop recording per domain latency histograms of `yoyo.net` requests. Off by default.
+///
+/// enabled: record or not.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_yoyonettrack(enabled: bool) {
+    pxs_debug!("pxs_yoyonettrack");
+    assert_initiated!();
+
+    with_feature!("yoyo_net", {
+        unsafe { yoyo::yoyo::yoyo_net_trackstats(enabled) };
+    }, {
+        panic!("yoyo_net is not enabled.");
+    });
+}
+
+/// Write the recorded `yoyo.net` stats as nul terminated JSON into `out`.
+///
+/// `{"domain": {"count": n, "errors": n, "total_ms": f, "buckets": [...]}}`. Bucket `i` counts requests
+/// that took at most `2^i` ms, the last one everything slower. A exception or a 5xx is a error.
+///
+/// out: buffer to write into, can be null to get the length.
+/// len: size of `out`.
+/// reset: clear the stats, only done when they fit into `out`.
+///
+/// Returns the length needed without the nul.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_yoyonetstats(out: *mut c_char, len: usize, reset: bool) -> usize {
+    pxs_debug!("pxs_yoyonetstats");
+    assert_initiated!();
+
+    with_feature!("yoyo_net", {
+        unsafe { yoyo::yoyo::yoyo_net_stats(out, len, reset) }
+    }, {
+        0
+    })
+}
+
+/// Open the zip archive at `path` and serve script imports from it instead of the disk.
+///
+/// Replaces the file and dir readers (see `pxs_set_filereader` and `pxs_set_dirreader`). Sources are
+/// inflated once and cached by path.
+///
+/// path: BORROW path to the archive.
+///
+/// Returns false when the archive can not be opened.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_yoyozipmount(path: *const c_char) -> bool {
+    pxs_debug!("pxs_yoyozipmount");
+    assert_initiated!();
+
+    if path.is_null() {
+        return false;
+    }
+
+    with_feature!("yoyo_zip", {
+        unsafe { yoyo::yoyo::yoyo_zip_mount(path) }
+    }, {
+        panic!("yoyo_zip is not enabled.");
+    })
+}
+
+/// Set up the worker states of `yoyo.task`. Each worker has its own runtime set (see `pxs_pool_create`), `setup` is
+/// called once per set, add the modules tasks need there. Null `setup` only adds `yoyo`.
+///
+/// workers: number of worker threads, 0 for the default (physical cores, at most 8).
+///
+/// Only used before the first `yoyo.task.spawn`.
+///
+/// setup:BORROW
+/// opaque:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_yoyotasksetup(setup: Option<pxs_PoolSetupFn>, opaque: pxs_Opaque, workers: u32) {
+    pxs_debug!("pxs_yoyotasksetup");
+    assert_initiated!();
+
+    with_feature!("yoyo_task", {
+        unsafe { yoyo::yoyo::yoyo_task_setup(setup, opaque, workers) };
+    }, {
+        panic!("yoyo_task is not enabled.");
+    });
+}
+
+/// Set up the buffered sink behind `yoyo.print`, `yoyo.println` and `yoyo.log`. Every thread appends to its own
+/// buffer and a writer thread drains them to stdout.
+///
+/// level: lowest level written, 0 debug, 1 info, 2 warn, 3 error, 4 off.
+/// flush_bytes: buffer size that wakes the writer.
+/// flush_ms: how often the writer drains anyway, 0 writes every message right away.
+///
+/// Defaults to info, 64KB and 50ms.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_yoyologsetup(level: i32, flush_bytes: usize, flush_ms: u32) {
+    pxs_debug!("pxs_yoyologsetup");
+    assert_initiated!();
+
+    with_feature!("yoyo_core", {
+        unsafe { yoyo::yoyo::yoyo_log_setup(level, flush_bytes, flush_ms) };
+    }, {
+        panic!("yoyo_core is not enabled.");
+    });
+}
+
+/// Write everything `yoyo` printed so far, i.e. before the host writes to stdout itself.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_yoyologflush() {
+    pxs_debug!("pxs_yoyologflush");
+    assert_initiated!();
+
+    with_feature!("yoyo_core", {
+        unsafe { yoyo::yoyo::yoyo_log_flush() };
+    }, {
+        panic!("yoyo_core is not enabled.");
+    });
+}
+
+/// Get the `yoyo.channel` named `name`, made with `capacity` (rounded up to a power of two, 0 for 1024) if it does
+/// not exist yet. Scripts get the same channel with `yoyo.channel.open(name)`. Lives as long as the process.
+///
+/// name:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_yoyochannel(name: *const c_char, capacity: u32) -> pxs_Opaque {
+    pxs_debug!("pxs_yoyochannel");
+    assert_initiated!();
+
+    if name.is_null() {
+        return ptr::null_mut();
+    }
+
+    with_feature!("yoyo_channel", {
+        unsafe { yoyo::yoyo::yoyo_channel_open(name, capacity) }
+    }, {
+        panic!("yoyo_channel is not enabled.");
+    })
+}
+
+/// Send a copy of `var` (through `pxs_pack`) to `channel` from `pxs_yoyochannel`. Never blocks or locks.
+///
+/// Returns false when the channel is full or `var` can not be packed.
+///
+/// channel:BORROW
+/// var:BORROW
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_yoyochannelsend(channel: pxs_Opaque, var: pxs_VarT) -> bool {
+    pxs_debug!("pxs_yoyochannelsend");
+    assert_initiated!();
+
+    if channel.is_null() || var.is_null() {
+        return false;
+    }
+
+    with_feature!("yoyo_channel", {
+        let packed = pxs_pack(ptr::null_mut(), var);
+        if pxs_varis(packed, pxs_VarType::pxs_Exception) {
+            pxs_freevar(packed);
+            return false;
+        }
+        let mut len = 0usize;
+        let data = pxs_getstrview(packed, &mut len);
+        let sent = unsafe { yoyo::yoyo::yoyo_channel_push(channel, data as *const c_void, len, true) };
+        pxs_freevar(packed);
+        sent
+    }, {
+        panic!("yoyo_channel is not enabled.");
+    })
+}
+
+/// Receive the oldest message of `channel` from `pxs_yoyochannel`. Never blocks or locks.
+///
+/// Values come back unpacked, byte blocks pushed with `yoyo_channel_push` as a `pxs_Buffer`.
+///
+/// channel:BORROW
+/// return:OWNED null when the channel is empty.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_yoyochannelrecv(channel: pxs_Opaque) -> pxs_VarT {
+    pxs_debug!("pxs_yoyochannelrecv");
+    assert_initiated!();
+
+    if channel.is_null() {
+        return ptr::null_mut();
+    }
+
+    with_feature!("yoyo_channel", {
+        unsafe extern "C" fn sink(opaque: *mut c_void, data: *const c_void, len: usize, packed: bool) {
+            let out = unsafe { &mut *(opaque as *mut pxs_VarT) };
+            let bytes = pxs_newbytes(data as pxs_Opaque, 1, len);
+            if packed {
+                *out = pxs_unpack(bytes);
+                pxs_freevar(bytes);
+            } else {
+                *out = bytes;
+            }
+        }
+
+        let mut out: pxs_VarT = ptr::null_mut();
+        unsafe { yoyo::yoyo::yoyo_channel_pop(channel, Some(sink), &mut out as *mut pxs_VarT as *mut c_void) };
+        out
+    }, {
+        panic!("yoyo_channel is not enabled.");
+    })
+}
+
+/// Use `argv` as `yoyo.os.argv` instead of the command line of the process. Call before `pxs_yoyoinit`.
+///
+/// argv:BORROW `argc` strings, copied.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_yoyosetargs(argc: i32, argv: *const *const c_char) {
+    pxs_debug!("pxs_yoyosetargs");
+    assert_initiated!();
+
+    with_feature!("yoyo_os", {
+        unsafe { yoyo::yoyo::yoyo_os_setargs(argc, argv) };
+    }, {
+        panic!("yoyo_os is not enabled.");
+    });
+}
+
+/// The number of logical CPUs this process may run on, or with `physical` the number of physical cores.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_yoyocpucount(physical: bool) -> u32 {
+    pxs_debug!("pxs_yoyocpucount");
+    assert_initiated!();
+
+    with_feature!("yoyo", {
+        unsafe { yoyo::yoyo::yoyo_cpu_count(physical) }
+    }, {
+        panic!("yoyo is not enabled.");
+    })
+}
+
+/// Pin the calling thread to the CPU `yoyo` gives worker `index`: a physical core each, spread over the packages,
+/// before any two share a core. Lets host worker pools line up with `yoyo.task`.
+///
+/// Returns false when the OS refused, always on macOS.
+#[unsafe(no_mangle)]
+pub extern "C" fn pxs_yoyopinworker(index: u32) -> bool {
+    pxs_debug!("pxs_yoyopinworker");
+    assert_initiated!();
+
+    with_feature!("yoyo", {
+        unsafe { yoyo::yoyo::yoyo_pin_worker(index) }
+    }, {
+        panic!("yoyo is not enabled.");
+    })
+}
+
 // ====================================== Core functions End =========================================
\ No newline at end of file
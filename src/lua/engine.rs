@@ -152,6 +152,14 @@ impl Engine {
         self.increase(1);
     }
 
+    /// Push a 64 bit integer
+    pub fn push_i64(&mut self, i: i64) {
+        unsafe {
+            lua::lua_pushinteger(self.L, i);
+        }
+        self.increase(1);
+    }
+
     /// Push boolean
     pub fn push_boolean(&mut self, b: bool) {
         unsafe {
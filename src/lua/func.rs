@@ -9,68 +9,144 @@
 // use mlua::{Integer, IntoLua, Lua, MultiValue, Value::Nil, Variadic};
 
 use crate::{
-    create_raw_string, free_raw_string,
     lua::{
-        engine::Engine, from_lua, lua, lua_pop, lua_upvalueindex, module_loader_func, object::{lua_index, lua_newindex}, var::push_lua_stack
+        from_lua, lua, lua_pop, lua_upvalueindex, outside_limit, module::load_module, module_loader_func, object::{lua_index, lua_newindex}, var::push_lua_stack
     },
     pxs_error,
     shared::{
-        PXS_PTR_NAME, PxsRes, func::call_function, object::ObjectFlags, pxs_Runtime,
+        PXS_PTR_NAME_C, PxsRes, PxsResult, budget, func::call_function, object::ObjectFlags, profiler, pxs_Runtime,
+        var::pxs_Var,
     },
 };
 
-pub(super) const LUA_OBJECT_BRIDGE_FUNCTION: i32 = 0;
-pub(super) const LUA_MODULE_BRIDGE_FUNCTION: i32 = 1;
-pub(super) const LUA_INDEX_BRIDGE_FUNCTION: i32 = 2;
-pub(super) const LUA_NEWINDEX_BRIDGE_FUNCTION: i32 = 3;
-pub(super) const LUA_MODULE_LOADER_BRIDGE_FUNCTION: i32 = 4;
+/// Instructions between budget checks.
+pub(super) const LUA_BUDGET_STEP: i32 = 1000;
 
 /// cbindgen:ignore
 /// This is defined in libs/pxs_lua.h
-/// The idea is that we let C handle the lua_errors
+/// Called every `LUA_BUDGET_STEP` instructions while a budget is armed, C raises the error.
 #[unsafe(no_mangle)]
-unsafe extern "C" fn pxslua_rustbridge(
-    L: *mut lua::lua_State,
-    err_buff: *mut *mut core::ffi::c_char,
-) -> core::ffi::c_int {
-    let engine = Engine::without_alloc(L);
-    // Get the function type up value
-    let function_type = engine.get_upvalue(1);
-
-    let res = if function_type == LUA_OBJECT_BRIDGE_FUNCTION {
-        lua_object_bridge(L)
-    } else if function_type == LUA_MODULE_BRIDGE_FUNCTION {
-        lua_bridge(L)
-    } else if function_type == LUA_INDEX_BRIDGE_FUNCTION {
-        lua_index(L)
-    } else if function_type == LUA_NEWINDEX_BRIDGE_FUNCTION {
-        lua_newindex(L)
-    } else if function_type == LUA_MODULE_LOADER_BRIDGE_FUNCTION {
-        module_loader_func(L)
-    } else {
-        Ok(0)
-    };
-
-    match res {
+unsafe extern "C" fn pxslua_budgetcheck(L: *mut lua::lua_State) -> core::ffi::c_int {
+    if profiler::running() {
+        profiler::poll(Some(&|frames: &mut Vec<String>| profile_frames(L, frames)));
+    }
+    budget::charge(&pxs_Runtime::pxs_Lua, LUA_BUDGET_STEP as u64) as core::ffi::c_int
+}
+
+/// Push the frames of `L` for a profiler sample, outermost first. C functions are the host bridge.
+pub(super) fn profile_frames(L: *mut lua::lua_State, frames: &mut Vec<String>) {
+    let start = frames.len();
+    let mut level = 0;
+    unsafe {
+        let mut ar: lua::lua_Debug = std::mem::zeroed();
+        while lua::lua_getstack(L, level, &mut ar) != 0 {
+            level += 1;
+            if lua::lua_getinfo(L, c"Sn".as_ptr(), &mut ar) == 0 {
+                continue;
+            }
+            let name = if ar.name.is_null() { "?".into() } else { std::ffi::CStr::from_ptr(ar.name).to_string_lossy() };
+            let what = std::ffi::CStr::from_ptr(ar.what).to_bytes();
+            let src = std::ffi::CStr::from_ptr(ar.short_src.as_ptr()).to_string_lossy();
+            frames.push(match what {
+                b"C" => format!("[host] {name}"),
+                b"main" => format!("<main> ({src})"),
+                _ => format!("{name} ({src}:{})", ar.linedefined),
+            });
+        }
+    }
+    frames[start..].reverse();
+}
+
+/// Pack a callback index and its `ObjectFlags` into the one upvalue of a `pxslua_objectcall`.
+pub(super) fn pack_callback(fn_idx: i32, flags: u8) -> i64 {
+    ((fn_idx as i64) << 8) | flags as i64
+}
+
+/// The callback index and flags of `pack_callback`.
+pub(super) fn unpack_callback(packed: i64) -> (i32, u8) {
+    ((packed >> 8) as i32, (packed & 0xff) as u8)
+}
+
+/// Run a bridge and hand its result to C. A error message is pushed as is for C to raise, `lua_error` must not unwind
+/// Rust frames. For the same reason the memory limit is not checked in it (`outside_limit`).
+fn bridge_result(L: *mut lua::lua_State, bridge: impl FnOnce(*mut lua::lua_State) -> PxsRes<i32>) -> core::ffi::c_int {
+    match outside_limit(|| bridge(L)) {
         Ok(num) => num,
         Err(err) => {
-            let raw_string = create_raw_string!(err);
             unsafe {
-                *err_buff = raw_string;
+                lua::lua_pushlstring(L, err.as_ptr() as *const core::ffi::c_char, err.len());
             }
             -1
         }
     }
 }
 
+/// cbindgen:ignore
+/// This is defined in libs/pxs_lua.h
+#[unsafe(no_mangle)]
+unsafe extern "C" fn pxslua_objectbridge(L: *mut lua::lua_State) -> core::ffi::c_int {
+    bridge_result(L, lua_object_bridge)
+}
+
+/// cbindgen:ignore
+/// This is defined in libs/pxs_lua.h
+#[unsafe(no_mangle)]
+unsafe extern "C" fn pxslua_modulebridge(L: *mut lua::lua_State) -> core::ffi::c_int {
+    bridge_result(L, lua_bridge)
+}
+
+/// cbindgen:ignore
+/// This is defined in libs/pxs_lua.h
+#[unsafe(no_mangle)]
+unsafe extern "C" fn pxslua_indexbridge(L: *mut lua::lua_State) -> core::ffi::c_int {
+    bridge_result(L, lua_index)
+}
+
+/// cbindgen:ignore
+/// This is defined in libs/pxs_lua.h
+#[unsafe(no_mangle)]
+unsafe extern "C" fn pxslua_newindexbridge(L: *mut lua::lua_State) -> core::ffi::c_int {
+    bridge_result(L, lua_newindex)
+}
+
+/// cbindgen:ignore
+/// This is defined in libs/pxs_lua.h
+#[unsafe(no_mangle)]
+unsafe extern "C" fn pxslua_loaderbridge(L: *mut lua::lua_State) -> core::ffi::c_int {
+    bridge_result(L, module_loader_func)
+}
+
+/// cbindgen:ignore
+/// This is defined in libs/pxs_lua.h
+#[unsafe(no_mangle)]
+unsafe extern "C" fn pxslua_hostmodulebridge(L: *mut lua::lua_State) -> core::ffi::c_int {
+    bridge_result(L, load_module)
+}
+
+/// Convert the value at `idx`. `from_lua` references tables and functions from the top, so it gets a copy there.
+pub(super) fn arg_from_lua(L: *mut lua::lua_State, idx: i32) -> PxsResult {
+    unsafe {
+        lua::lua_pushvalue(L, idx);
+    }
+    let var = from_lua(-1);
+    lua_pop(L, 1);
+    var
+}
+
+/// Convert the args from `first` on into `argv`.
+fn push_args(L: *mut lua::lua_State, argv: &mut Vec<pxs_Var>, first: i32, argc: i32) -> PxsRes<()> {
+    for i in first..=argc {
+        argv.push(arg_from_lua(L, i)?);
+    }
+    Ok(())
+}
+
 fn lua_object_bridge(L: *mut lua::lua_State) -> PxsRes<i32> {
     unsafe {
         let argc = lua::lua_gettop(L);
         let obj = 1; // object is always first (IF actually passed.)
 
-        // Get fn idx
-        let fn_idx = lua::lua_tointegerx(L, lua_upvalueindex(2), core::ptr::null_mut());
-        let flags = lua::lua_tointegerx(L, lua_upvalueindex(3), core::ptr::null_mut());
+        let (fn_idx, flags) = unpack_callback(lua::lua_tointegerx(L, lua_upvalueindex(1), core::ptr::null_mut()));
 
         // Check that obj is a table
         if lua::lua_type(L, obj) != lua::LUA_TTABLE as i32 {
@@ -78,42 +154,26 @@ fn lua_object_bridge(L: *mut lua::lua_State) -> PxsRes<i32> {
         }
 
         // Let's setup our callback
-        let mut argv = vec![pxs_Runtime::pxs_Lua.into_var()];
+        let mut argv = Vec::with_capacity(argc as usize + 1);
+        argv.push(pxs_Runtime::pxs_Lua.into_var());
 
         // Check flags
-        if flags as u8 & (ObjectFlags::UsesId as u8) != 0 {
+        if flags & (ObjectFlags::UsesId as u8) != 0 {
             // Get _pxs_ptr
-            let ptr_string = create_raw_string!(PXS_PTR_NAME);
-            lua::lua_pushstring(L, ptr_string);
-            free_raw_string!(ptr_string);
+            lua::lua_pushstring(L, PXS_PTR_NAME_C.as_ptr());
             lua::lua_rawget(L, obj);
-            argv.push(from_lua(-1)?);
-            // pop
+            let id = from_lua(-1);
             lua_pop(L, 1);
+            argv.push(id?);
         } else {
-            lua::lua_pushvalue(L, 1);
-            argv.push(from_lua(1).unwrap());
-            // Pop pushed
-            lua_pop(L, 1);
+            argv.push(arg_from_lua(L, obj)?);
         }
 
-        for i in 2..=argc {
-            lua::lua_pushvalue(L, i);
-            let var = from_lua(i);
-            lua_pop(L, 1);
-            if let Ok(var) = var {
-                argv.push(var);
-            } else {
-                return pxs_error!("{}", var.unwrap_err().to_string());
-            }
-        }
+        push_args(L, &mut argv, 2, argc)?;
 
         // Call the fuction
-        let res = call_function(fn_idx as i32, argv);
-        let success: Result<i32, String> = push_lua_stack(&res);
-        if success.is_err() {
-            return pxs_error!("{}", success.unwrap_err().to_string());
-        }
+        let res = call_function(fn_idx, argv);
+        push_lua_stack(&res)?;
 
         // Always return 1 dog
         Ok(1)
@@ -126,30 +186,16 @@ fn lua_bridge(L: *mut lua::lua_State) -> PxsRes<i32> {
         let argc = lua::lua_gettop(L);
 
         // Get fn idx
-        let fn_idx = lua::lua_tointegerx(L, lua_upvalueindex(2), std::ptr::null_mut());
+        let fn_idx = lua::lua_tointegerx(L, lua_upvalueindex(1), std::ptr::null_mut());
 
-        // Now we have fn idx, lets set up our callback
-        let mut argv = vec![pxs_Runtime::pxs_Lua.into_var()];
-
-        // Num of args (skip first)
-        for i in 1..=argc {
-            lua::lua_pushvalue(L, i);
-            let var = from_lua(-1);
-            lua_pop(L, 1);
-            if let Ok(var) = var {
-                argv.push(var);
-            } else {
-                return pxs_error!("{}", var.unwrap_err().to_string());
-            }
-        }
+        // Now we have fn idx, lets set up our callback. Sized once, this is the frame `pxs_FuncV`s borrow.
+        let mut argv = Vec::with_capacity(argc as usize + 1);
+        argv.push(pxs_Runtime::pxs_Lua.into_var());
+        push_args(L, &mut argv, 1, argc)?;
 
         // Call callback
         let res = call_function(fn_idx as i32, argv);
-
-        let success: Result<i32, String> = push_lua_stack(&res);
-        if success.is_err() {
-            return pxs_error!("{}", success.unwrap_err().to_string());
-        }
+        push_lua_stack(&res)?;
 
         // Always return 1 as number of args returned.
         Ok(1)
@@ -16,9 +16,9 @@ pub mod var;
 
 use etffi::cstring::CStringSafe;
 use etffi::ptr_magic::{PtrMagic, ThreadSafePointer};
+use std::{collections::HashSet, sync::Arc};
 
-use crate::lua::func::LUA_MODULE_LOADER_BRIDGE_FUNCTION;
-use crate::lua::module::preload_lua_module;
+use crate::lua::func::LUA_BUDGET_STEP;
 use crate::{
     borrow_string,
     lua::{
@@ -28,8 +28,9 @@ use crate::{
     },
     pxs_error,
     shared::{
-        PixelScript, PxsRes, PxsResult,
-        read_file,
+        PixelScript, PxsRes, PxsResult, alloc::{self, MemAccount, MemStats}, gcstats, module::pxs_Module, pxs_Opaque,
+        pxs_Runtime, read_file, snapshot, startup,
+        tracer::{self, pxs_TraceKind},
         var::{ObjectMethods, pxs_Var, pxs_VarMap},
     },
     with_feature,
@@ -51,6 +52,16 @@ thread_local! {
 struct State {
     /// The lua engine.
     engine: *mut lua::lua_State,
+    /// Memory of `engine`, its allocator points here so it is boxed.
+    account: Box<MemAccount>,
+    /// Globals kept by `reset_globals`.
+    marked_globals: HashSet<String>,
+    /// `gc_sentinel` leaves a new sentinel behind, see `watch_gc`.
+    gc_watch: bool,
+    /// A sentinel is waiting for its cycle.
+    gc_sentinel: bool,
+    /// Host modules behind the loader stubs in `package.preload`, by the index in their upvalue. See `module::add_module`.
+    modules: Vec<Arc<pxs_Module>>,
 }
 
 impl PtrMagic for State {}
@@ -67,7 +78,7 @@ const LUA_TNUMBER: i32 = 3;
 const LUA_TSTRING: i32 = 4;
 const LUA_TTABLE: i32 = 5;
 const LUA_TFUNCTION: i32 = 6;
-// const LUA_TUSERDATA: i32 = 7;
+const LUA_TUSERDATA: i32 = 7;
 // const LUA_TTHREAD: i32 = 8;
 
 /// Helper for safely referencing Lua table/functions.
@@ -165,55 +176,199 @@ pub(self) fn lua_get_error(L: *mut lua::lua_State) -> String {
     }
 }
 
-fn new_state() -> *mut State {
+/// Lua allocator, `ud` is the `MemAccount` of the state. Goes through `pxs_setalloc` when it is set.
+unsafe extern "C" fn lua_alloc(
+    ud: *mut std::ffi::c_void,
+    ptr: *mut std::ffi::c_void,
+    osize: usize,
+    nsize: usize,
+) -> *mut std::ffi::c_void {
     unsafe {
-        State {
-            engine: lua::luaL_newstate(),
+        let account = &*(ud as *const MemAccount);
+        // Without a block, `osize` is the type of the new object.
+        let old = if ptr.is_null() { 0 } else { osize };
+        if nsize == 0 {
+            alloc::raw_free(account.tag(), ptr);
+            account.resize(old, 0);
+            return std::ptr::null_mut();
+        }
+        // NULL makes Lua raise a memory error, in the script that asked for it. Only checked while Lua code runs
+        // (`lua_call`), the error must not unwind host code (`outside_limit`).
+        if !account.resize(old, nsize) {
+            return std::ptr::null_mut();
         }
-        .into_raw()
+        let new = alloc::raw_realloc(account.tag(), ptr, nsize);
+        if new.is_null() {
+            account.resize(nsize, old);
+        }
+        new
     }
 }
 
+/// Run host code called by Lua with the memory limit unchecked. A memory error raised in it would `longjmp` over its
+/// Rust frames, what it allocates is counted against the next allocation of the script.
+pub(self) fn outside_limit<T>(f: impl FnOnce() -> T) -> T {
+    let account = unsafe { &(*get_lua_state()).account };
+    let checked = account.set_checked(false);
+    let res = f();
+    account.set_checked(checked);
+    res
+}
+
+/// A new lua state counting its memory in `account`.
+fn new_engine(account: &MemAccount) -> *mut lua::lua_State {
+    unsafe { lua::pxslua_newstate(Some(lua_alloc), account as *const MemAccount as *mut std::ffi::c_void) }
+}
+
+fn new_state() -> *mut State {
+    let account = Box::new(MemAccount::new(alloc::tag(Some(&pxs_Runtime::pxs_Lua))));
+    // The host pushes values outside of `lua_pcall`, where a memory error would abort the process.
+    account.set_checked(false);
+    State {
+        engine: new_engine(&account),
+        account,
+        marked_globals: HashSet::new(),
+        gc_watch: false,
+        gc_sentinel: false,
+        modules: vec![],
+    }
+    .into_raw()
+}
+
 fn init(ptr: *mut State) {
     unsafe {
         let all_libs = !0;
         let safe_libs = all_libs & !(lua::LUA_IOLIBK | lua::LUA_OSLIBK | lua::LUA_DBLIBK);
-        lua::luaL_openselectedlibs((*ptr).engine, safe_libs as i32, 0);
+        startup::step(&pxs_Runtime::pxs_Lua, "stdlib", || {
+            lua::luaL_openselectedlibs((*ptr).engine, safe_libs as i32, 0);
+        });
 
         let mut lua_globals = String::new();
         lua_globals.push_str(include_str!("../../core/lua/main.lua"));
 
-        with_feature!("pxs_json", {
-            // Load dkjson module
-            let _ = preload_lua_module(
-                (*ptr).engine,
-                include_str!("../../libs/dkjson.lua"),
-                "__dkjson__",
-            );
-            // Load in the pxs_json module
-            let _ = preload_lua_module(
-                (*ptr).engine,
-                include_str!("../../core/lua/pxs_json.lua"),
-                "pxs_json",
-            );
-            // Import it globally
-            lua_globals.push_str("\npxs_json = require('pxs_json')\n");
+        startup::step(&pxs_Runtime::pxs_Lua, "core_modules", || {
+            with_feature!("pxs_json", {
+                let _ = module::add_module(ptr, crate::pxs_core::pxs_json::module());
+                // Import it globally
+                lua_globals.push_str("\npxs_json = require('pxs_json')\n");
+            });
+            with_feature!("pxs_pack", {
+                let _ = module::add_module(ptr, crate::pxs_core::pxs_pack::module());
+                lua_globals.push_str("\npxs_pack = require('pxs_pack')\n");
+            });
+            with_feature!("pxs_data", {
+                let _ = module::add_module(ptr, crate::pxs_core::pxs_data::module());
+                lua_globals.push_str("\npxs_data = require('pxs_data')\n");
+            });
+        });
+        startup::step(&pxs_Runtime::pxs_Lua, "globals", || {
+            let _ = snapshot::core(|| execute(ptr, &lua_globals, "<lua_globals>"));
         });
-        let _ = execute(ptr, &lua_globals, "<lua_globals>");
 
         setup_module_loader((*ptr).engine);
+
+        if gcstats::enabled() {
+            watch_gc(ptr, true);
+        }
     }
 }
 
 fn clear(ptr: *mut State) {
     unsafe {
         let L = (*ptr).engine;
+        // Closing runs every finalizer, the sentinel too.
+        (*ptr).gc_watch = false;
         lua::lua_close(L);
+        (*ptr).gc_sentinel = false;
+        (*ptr).modules.clear();
 
-        (*ptr).engine = lua::luaL_newstate();
+        (*ptr).engine = new_engine(&(*ptr).account);
     }
 }
 
+/// Finalizer of the sentinel `watch_gc` leaves for the collector: it runs at the end of the cycle that collected the
+/// sentinel, and leaves the next one.
+unsafe extern "C" fn gc_sentinel(L: *mut lua::lua_State) -> std::ffi::c_int {
+    outside_limit(|| unsafe { sentinel_collected(L) })
+}
+
+/// `gc_sentinel` with the limit unchecked, it leaves a new sentinel.
+unsafe fn sentinel_collected(L: *mut lua::lua_State) -> std::ffi::c_int {
+    let state = get_lua_state();
+    unsafe {
+        // `L` is the thread that ran the collection, maybe a coroutine. A state of a other thread (being closed
+        // after `attach_thread`) is not watched.
+        lua::lua_rawgeti(L, LUA_REGISTRYINDEX, lua::LUA_RIDX_MAINTHREAD as i64);
+        let main = lua::lua_tothread(L, -1);
+        lua_pop(L, 1);
+        if main != (*state).engine {
+            return 0;
+        }
+        (*state).gc_sentinel = false;
+        if (*state).gc_watch {
+            gcstats::auto_seen(&pxs_Runtime::pxs_Lua, (*state).account.stats().bytes);
+            leave_gc_sentinel(state, L);
+        }
+    }
+    0
+}
+
+/// Leave a empty table finalized by `gc_sentinel` to the collector, made on the thread `L` of the state.
+unsafe fn leave_gc_sentinel(ptr: *mut State, L: *mut lua::lua_State) {
+    unsafe {
+        lua::lua_createtable(L, 0, 0);
+        lua::lua_createtable(L, 0, 1);
+        lua::lua_pushcclosure(L, Some(gc_sentinel), 0);
+        lua::lua_setfield(L, -2, c"__gc".as_ptr());
+        lua::lua_setmetatable(L, -2);
+        lua_pop(L, 1);
+        (*ptr).gc_sentinel = true;
+    }
+}
+
+/// Watch the automatic cycles of the state with a sentinel table that only the collector holds.
+fn watch_gc(ptr: *mut State, enabled: bool) {
+    unsafe {
+        (*ptr).gc_watch = enabled;
+        // One from before may still be waiting for its cycle.
+        if enabled && !(*ptr).gc_sentinel {
+            leave_gc_sentinel(ptr, (*ptr).engine);
+        }
+    }
+}
+
+/// Entries of the table on top of the stack, which is popped.
+fn table_size(L: *mut lua::lua_State) -> usize {
+    let mut size = 0;
+    unsafe {
+        lua::lua_pushnil(L);
+        while lua::lua_next(L, -2) != 0 {
+            size += 1;
+            lua_pop(L, 1);
+        }
+    }
+    lua_pop(L, 1);
+    size
+}
+
+/// Names of the string keys in the globals table.
+fn global_names(L: *mut lua::lua_State) -> HashSet<String> {
+    let mut names = HashSet::new();
+    unsafe {
+        lua_push_globals(L);
+        lua::lua_pushnil(L);
+        while lua::lua_next(L, -2) != 0 {
+            // Only strings, `lua_tolstring` would convert a number key in place and break `lua_next`.
+            if lua::lua_type(L, -2) == LUA_TSTRING {
+                names.insert(borrow_string!(lua::lua_tolstring(L, -2, core::ptr::null_mut())).to_string());
+            }
+            lua_pop(L, 1);
+        }
+        lua_pop(L, 1);
+    }
+    names
+}
+
 /// Get the state of LUA.
 fn get_lua_state() -> *mut State {
     LUASTATE.with(|mutex| mutex.get_ptr())
@@ -228,8 +383,12 @@ fn get_lua_engine() -> Engine {
 /// Will add result to stack if not error. If error, its popped from stack.
 pub(self) fn lua_call(L: *mut lua::lua_State, args: i32, results: i32) -> PxsRes<()> {
     unsafe {
+        // The limit is checked while the call runs, a memory error is caught here.
+        let account = &(*get_lua_state()).account;
+        let checked = account.set_checked(true);
         // 1
         let code = lua::lua_pcallk(L, args, results, 0, 0, None); // results
+        account.set_checked(checked);
         if code != LUA_OK {
             let lua_error = lua_get_error(L);
             return pxs_error!("{lua_error}");
@@ -271,16 +430,18 @@ pub(self) fn module_loader_func(L: *mut lua::lua_State) -> PxsRes<i32> {
     let mut engine = Engine::without_alloc(L);
     let path = engine.to_string(path_idx);
 
-    let contents = read_file(&path);
-    if contents.is_empty() {
-        return pxs_error!("{path} was not found.");
-    }
+    tracer::span(pxs_TraceKind::pxs_TraceImport, &pxs_Runtime::pxs_Lua, &path, || {
+        let contents = read_file(&path);
+        if contents.is_empty() {
+            return pxs_error!("{path} was not found.");
+        }
 
-    // Compile chunk
-    let _ = engine.compile_chunk(&contents, &path)?;
+        // Compile chunk, kept compiled for every later state.
+        let _ = snapshot::import(|| engine.compile_chunk(&contents, &path))?;
 
-    // Donezo!
-    Ok(1)
+        // Donezo!
+        Ok(1)
+    })
 }
 
 /// Custom moduile loader function
@@ -295,10 +456,8 @@ fn setup_module_loader(L: *mut lua::lua_State) {
     engine.raw_get(package_idx);
     let s_idx = engine.get_top();
 
-    // Pass Function type
-    engine.push_integer(LUA_MODULE_LOADER_BRIDGE_FUNCTION);
     // Push module loader
-    engine.push_function(lua::pxslua_callback, 1);
+    engine.push_function(lua::pxslua_moduleloader, 0);
     // Add to table (redefine path searcher)
     engine.set_index(s_idx, 2 as i32);
 
@@ -311,14 +470,35 @@ fn setup_module_loader(L: *mut lua::lua_State) {
     engine.set_index(s_idx, 4);
 }
 
+/// Called with a module name by `reload_module`. Scripts holding the old table see the new contents, a failed reload
+/// leaves the old module in place.
+const LUA_RELOAD: &str = r#"
+local name = ...
+local loaded = package.loaded
+local old = loaded[name]
+loaded[name] = nil
+local ok, new = pcall(require, name)
+if not ok then
+    loaded[name] = old
+    error(new, 0)
+end
+if type(old) == "table" and type(new) == "table" and old ~= new then
+    for k in pairs(old) do
+        old[k] = nil
+    end
+    for k, v in pairs(new) do
+        old[k] = v
+    end
+    loaded[name] = old
+end
+"#;
+
 /// Add variables to a Table from a Map
 fn add_variables_to_table(state: *mut State, table: i32, map: &pxs_VarMap) -> PxsRes<()> {
-    let keys = map.keys();
     let mut engine = Engine::from_state(state);
-    for k in keys {
+    for (k, value) in map.iter() {
         // Push key to lua
-        engine.push_pxs(k)?;
-        let value = map.get_item(k).unwrap();
+        engine.push_pxs(&k.as_var())?;
         engine.push_pxs(value)?;
         engine.set_table(table);
     }
@@ -328,11 +508,10 @@ fn add_variables_to_table(state: *mut State, table: i32, map: &pxs_VarMap) -> Px
 
 /// Remove variables from a Table.
 fn remove_variables_from_table(state: *mut State, table: i32, map: &pxs_VarMap) -> PxsRes<()> {
-    let keys = map.keys();
     let mut engine = Engine::from_state(state);
-    for k in keys {
+    for (k, _) in map.iter() {
         // Convert to lua
-        engine.push_pxs(k)?;
+        engine.push_pxs(&k.as_var())?;
         engine.push_nil();
         engine.set_table(table);
     }
@@ -363,7 +542,8 @@ impl PixelScript for LuaScripting {
 
     fn start() {
         // Initalize the state
-        init(get_lua_state());
+        let state = startup::step(&pxs_Runtime::pxs_Lua, "vm", get_lua_state);
+        init(state);
     }
 
     fn stop() {
@@ -378,12 +558,83 @@ impl PixelScript for LuaScripting {
         Self::stop();
     }
 
+    fn detach_thread() -> pxs_Opaque {
+        let state = new_state();
+        unsafe {
+            std::ptr::swap(state, get_lua_state());
+        }
+        state as pxs_Opaque
+    }
+
+    fn attach_thread(state: pxs_Opaque) {
+        let state = state as *mut State;
+        unsafe {
+            std::ptr::swap(state, get_lua_state());
+            lua::lua_close((*state).engine);
+        }
+        let _ = State::from_raw(state);
+    }
+
+    fn arm_budget(_budget: &crate::shared::budget::Budget) {
+        unsafe {
+            lua::lua_sethook(
+                (*get_lua_state()).engine,
+                Some(lua::pxslua_budgethook),
+                lua::LUA_MASKCOUNT as i32,
+                LUA_BUDGET_STEP,
+            );
+        }
+    }
+
+    fn disarm_budget() {
+        unsafe {
+            lua::lua_sethook((*get_lua_state()).engine, None, 0, 0);
+        }
+    }
+
+    fn profile_stack(frames: &mut Vec<String>) {
+        func::profile_frames(unsafe { (*get_lua_state()).engine }, frames);
+    }
+
+    fn mark_globals() {
+        let state = get_lua_state();
+        unsafe {
+            (*state).marked_globals = global_names((*state).engine);
+        }
+    }
+
+    fn reset_globals() {
+        let state = get_lua_state();
+        unsafe {
+            let L = (*state).engine;
+            lua::lua_settop(L, 0);
+            lua_push_globals(L);
+            for name in global_names(L) {
+                if !(*state).marked_globals.contains(&name) {
+                    push_string(L, &name);
+                    lua::lua_pushnil(L);
+                    lua::lua_rawset(L, -3);
+                }
+            }
+            lua_pop(L, 1);
+            lua::lua_gc(L, lua::LUA_GCCOLLECT as i32);
+        }
+    }
+
     fn clear() {
         let state = get_lua_state();
         clear(state);
         init(state);
     }
 
+    fn reload_module(name: &str) -> PxsResult {
+        let mut engine = get_lua_engine();
+        engine.compile_chunk(LUA_RELOAD, "<lua_reload>")?;
+        engine.push_string(name);
+        engine.call(1, 0)?;
+        Ok(pxs_Var::new_null())
+    }
+
     fn eval(code: &str, name: &str) -> PxsResult {
         let state = get_lua_state();
         let mut engine = Engine::from_state(state);
@@ -477,12 +728,71 @@ impl PixelScript for LuaScripting {
         // format!("{{tables: {:#?}}}", tables)
     }
 
+    fn runtime_stats(stats: &mut pxs_VarMap) {
+        unsafe {
+            let L = (*get_lua_state()).engine;
+            let mut depth = 0;
+            let mut ar: lua::lua_Debug = std::mem::zeroed();
+            while lua::lua_getstack(L, depth, &mut ar) != 0 {
+                depth += 1;
+            }
+            stats.add_str("stack_depth", pxs_Var::new_i64(depth as i64));
+            stats.add_str("stack_top", pxs_Var::new_i64(lua::lua_gettop(L) as i64));
+
+            lua::lua_pushvalue(L, LUA_REGISTRYINDEX);
+            stats.add_str("registry_size", pxs_Var::new_i64(table_size(L) as i64));
+            lua_push_globals(L);
+            stats.add_str("globals", pxs_Var::new_i64(table_size(L) as i64));
+        }
+    }
+
     fn garbage_collect() {
         let state = get_lua_state();
         unsafe {
             lua::lua_gc((*state).engine, lua::LUA_GCCOLLECT as i32);
+            (*state).account.collected();
+        }
+    }
+
+    fn gc_step(budget: std::time::Duration) -> bool {
+        let state = get_lua_state();
+        let start = std::time::Instant::now();
+        unsafe {
+            loop {
+                // 0 is one basic step, 1 is returned at the end of a cycle.
+                if lua::lua_gc((*state).engine, lua::LUA_GCSTEP as i32, 0usize) == 1 {
+                    (*state).account.collected();
+                    return true;
+                }
+                if start.elapsed() >= budget {
+                    return false;
+                }
+            }
+        }
+    }
+
+    fn set_auto_gc(enabled: bool) {
+        let state = get_lua_state();
+        let what = if enabled { lua::LUA_GCRESTART } else { lua::LUA_GCSTOP };
+        unsafe {
+            lua::lua_gc((*state).engine, what as i32);
         }
     }
+
+    fn mem_stats() -> MemStats {
+        unsafe { (*get_lua_state()).account.stats() }
+    }
+
+    fn set_mem_limit(bytes: usize) -> bool {
+        unsafe {
+            (*get_lua_state()).account.set_limit(bytes);
+        }
+        true
+    }
+
+    fn watch_gc(enabled: bool) {
+        watch_gc(get_lua_state(), enabled);
+    }
 }
 
 /// Push args to lua stack.
@@ -527,6 +837,37 @@ impl ObjectMethods for LuaScripting {
         engine.get_top_pxs()
     }
 
+    fn var_call_batch(
+        method: &crate::shared::var::pxs_Var,
+        batches: &mut [crate::shared::var::pxs_VarList],
+    ) -> Vec<pxs_Var> {
+        let L = unsafe { (*get_lua_state()).engine };
+        // The stack is reset by hand, a failed call leaves it uneven for allocation tracking.
+        let mut engine = Engine::without_alloc(L);
+        let base = unsafe { lua::lua_gettop(L) };
+        if let Err(e) = engine.push_pxs(method) {
+            return batches.iter().map(|_| pxs_Var::new_exception(e.to_string())).collect();
+        }
+        let func = base + 1;
+
+        let mut results = Vec::with_capacity(batches.len());
+        for args in batches.iter() {
+            engine.push_value(func);
+            let res = args_to_lua(&mut engine, &args.vars)
+                .and_then(|_| lua_call(L, args.len() as i32, 1))
+                .and_then(|_| engine.from_lua(-1));
+            unsafe {
+                lua::lua_settop(L, func);
+            }
+            results.push(res.unwrap_or_else(|e| pxs_Var::new_exception(e.to_string())));
+        }
+
+        unsafe {
+            lua::lua_settop(L, base);
+        }
+        results
+    }
+
     fn get(var: &pxs_Var, key: &str) -> PxsResult {
         let mut engine = get_lua_engine();
         engine.push_pxs(var)?;
@@ -559,4 +900,35 @@ impl ObjectMethods for LuaScripting {
         // result
         engine.from_lua(-1)
     }
+
+    fn entries(var: &pxs_Var) -> PxsRes<Vec<(pxs_Var, pxs_Var)>> {
+        let mut engine = get_lua_engine();
+        let table = engine.push_pxs(var)?;
+        let L = unsafe { (*get_lua_state()).engine };
+        if unsafe { lua::lua_type(L, table) } != LUA_TTABLE {
+            return pxs_error!("Var is not a Lua table");
+        }
+
+        let mut entries = vec![];
+        unsafe {
+            lua::lua_pushnil(L);
+            while lua::lua_next(L, table) != 0 {
+                // `from_lua` refs tables from the top, so the key is copied up first.
+                lua::lua_pushvalue(L, -2);
+                let key = from_lua(-1);
+                lua_pop(L, 1);
+                let value = from_lua(-1);
+                lua_pop(L, 1);
+                match (key, value) {
+                    (Ok(key), Ok(value)) => entries.push((key, value)),
+                    (Err(err), _) | (_, Err(err)) => {
+                        // The key `lua_next` would have taken.
+                        lua_pop(L, 1);
+                        return Err(err);
+                    }
+                }
+            }
+        }
+        Ok(entries)
+    }
 }
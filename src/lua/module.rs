@@ -6,30 +6,58 @@
 //
 // Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
 //
-use std::sync::Arc;
+use std::{
+    ffi::{c_char, c_void},
+    sync::Arc,
+};
 
 use etffi::cstring::CStringSafe;
 
 use crate::{
     lua::{
-        State, engine::Engine, func::LUA_MODULE_BRIDGE_FUNCTION, lua, lua_get_error, lua_upvalueindex, LUA_OK
+        State, engine::Engine, get_lua_state, lua,
+        lua_get_error, lua_upvalueindex, LUA_OK
     },
     pxs_error,
-    shared::{PxsRes, module::pxs_Module},
+    shared::{
+        PxsRes, module::pxs_Module, pxs_Runtime, snapshot,
+        tracer::{self, pxs_TraceKind},
+    },
 };
 
-/// Load function
-unsafe extern "C" fn module_loader(L: *mut lua::lua_State) -> core::ffi::c_int {
-    unsafe {
-        lua::lua_pushvalue(L, lua_upvalueindex(1));
-        1
+/// Collect `lua_dump` output.
+unsafe extern "C" fn dump_writer(_L: *mut lua::lua_State, p: *const c_void, sz: usize, ud: *mut c_void) -> i32 {
+    // Called with a null `p` to end the dump.
+    if !p.is_null() && sz > 0 {
+        unsafe {
+            let out = &mut *(ud as *mut Vec<u8>);
+            out.extend_from_slice(std::slice::from_raw_parts(p as *const u8, sz));
+        }
     }
+    0
 }
 
 /// Compile a Lua chunk of code
+///
+/// Uses the bytecode from a loaded snapshot when the source matches, and records the bytecode while recording.
 pub(super) fn compile_chunk(L: *mut lua::lua_State, code: &str, name: &str) -> PxsRes<i32> {
     let mut cstring = CStringSafe::new();
     unsafe {
+        if let Some(bytecode) = snapshot::cached_chunk(pxs_Runtime::pxs_Lua, name, code) {
+            let res = lua::luaL_loadbufferx(
+                L,
+                bytecode.as_ptr() as *const c_char,
+                bytecode.len(),
+                cstring.new_string(name),
+                cstring.new_string("b"),
+            );
+            if res == LUA_OK {
+                return Ok(lua::lua_gettop(L));
+            }
+            // A bad chunk, compile the source instead.
+            let _ = lua_get_error(L);
+        }
+
         let res = lua::luaL_loadbufferx(
             L,
             cstring.new_string(code),
@@ -42,53 +70,89 @@ pub(super) fn compile_chunk(L: *mut lua::lua_State, code: &str, name: &str) -> P
             return pxs_error!("{lua_error}");
         }
 
+        if snapshot::is_recording(pxs_Runtime::pxs_Lua) {
+            let mut bytecode: Vec<u8> = Vec::new();
+            // Keep debug info so errors still have line numbers.
+            if lua::lua_dump(L, Some(dump_writer), &mut bytecode as *mut Vec<u8> as *mut c_void, 0) == 0 {
+                snapshot::record_chunk(pxs_Runtime::pxs_Lua, name, code, bytecode);
+            }
+        }
+
         Ok(lua::lua_gettop(L))
     }
 }
 
-/// Preload a lua source code as a module.
-pub(super) fn preload_lua_module(L: *mut lua::lua_State, code: &str, name: &str) -> PxsRes<()> {
-    let mut engine = Engine::new(L);
-    // Get package
-    engine.get_global("package");
-    engine.get_field(-1, "preload");
-    let preload_idx = engine.get_top();
-
-    // Compile code
-    engine.compile_chunk(code, name)?;
-    // run it
-    engine.call(0, 1)?;
-
-    // Pass result ito upvalue
-    engine.push_function(module_loader, 1);
-    engine.set_field(preload_idx, name);
-
-    Ok(())
-}
-
-pub(super) fn add_module(state: *mut State, module: Arc<pxs_Module>) -> PxsRes<()> {
-    let mut engine = Engine::from_state(state);
-
-    // Create module table
-    let table = engine.create_table(0, (module.variables.len() +module.callbacks.len()) as i32);
+/// Push the table of `module` on the stack of the state engine: its variables and callbacks, not its submodules.
+fn push_module_table(state: *mut State, module: &pxs_Module) -> PxsRes<()> {
+    let L = unsafe { (*state).engine };
+    let top = unsafe { lua::lua_gettop(L) };
+    // The table stays on the stack for the caller.
+    let mut engine = Engine::without_alloc(L);
+    let table = engine.create_table(0, (module.variables.len() + module.callbacks.len()) as i32);
 
     // Add variables
     for var in module.variables.iter() {
         engine.push_string(&var.name);
-        engine.push_pxs(&var.var)?;
+        if let Err(err) = engine.push_pxs(&var.var) {
+            unsafe { lua::lua_settop(L, top) };
+            return Err(err);
+        }
         engine.raw_set(table);
     }
 
     // Add callbacks
     for cbk in module.callbacks.iter() {
         engine.push_string(&cbk.name);
-        engine.push_integer(LUA_MODULE_BRIDGE_FUNCTION);
         engine.push_integer(cbk.idx); // add idx to upvalue.
-        engine.push_function(lua::pxslua_callback, 2);
+        engine.push_function(lua::pxslua_modulecall, 1);
         engine.raw_set(table);
     }
 
-    // Setup loader
+    Ok(())
+}
+
+/// Loader stub of a host module in `package.preload`. Builds the module table on the first `require`, after that
+/// `require` finds it in `package.loaded`.
+pub(super) fn load_module(L: *mut lua::lua_State) -> PxsRes<i32> {
+    let state = get_lua_state();
+    let idx = unsafe { lua::lua_tointegerx(L, lua_upvalueindex(1), core::ptr::null_mut()) } as usize;
+    let Some(module) = (unsafe { (*state).modules.get(idx).cloned() }) else {
+        return pxs_error!("Module {idx} is not added.");
+    };
+
+    tracer::span(pxs_TraceKind::pxs_TraceImport, &pxs_Runtime::pxs_Lua, &module.name, || {
+        push_module_table(state, &module)?;
+        unsafe {
+            // Required from a coroutine.
+            let main = (*state).engine;
+            if main != L {
+                lua::lua_xmove(main, L, 1);
+            }
+        }
+        Ok(1)
+    })
+}
+
+/// Add a loader stub for `module` and each of its submodules to the `package.preload` table at `preload_idx`.
+fn add_loader(state: *mut State, engine: &mut Engine, preload_idx: i32, module: &Arc<pxs_Module>) {
+    let idx = unsafe {
+        (*state).modules.push(Arc::clone(module));
+        (*state).modules.len() - 1
+    };
+    engine.push_string(&module.name);
+    engine.push_integer(idx as i32);
+    engine.push_function(lua::pxslua_hostmodule, 1);
+    engine.raw_set(preload_idx);
+
+    for child in module.modules.iter() {
+        add_loader(state, engine, preload_idx, child);
+    }
+}
+
+/// Add `module` to `package.preload`. Only a loader stub is made per module, its functions and variables are made on
+/// the first `require` (most scripts touch a few modules of a large API).
+pub(super) fn add_module(state: *mut State, module: Arc<pxs_Module>) -> PxsRes<()> {
+    let mut engine = Engine::from_state(state);
 
     // Get preload
     engine.get_global("package");
@@ -96,19 +160,10 @@ pub(super) fn add_module(state: *mut State, module: Arc<pxs_Module>) -> PxsRes<(
     engine.raw_get(-2);
     let preload_idx = engine.get_top();
 
-    // Now we actually have the preload module
-    // module stuff
-    engine.push_string(&module.name);
-    engine.push_value(table); // add table to upvalues
-    engine.push_function(module_loader, 1);
-    engine.raw_set(preload_idx);
+    add_loader(state, &mut engine, preload_idx, &module);
 
     // Drop the engine to clean stack.
     drop(engine);
 
-    for child in module.modules.iter() {
-        add_module(state, Arc::clone(&child))?;
-    }
-
     Ok(())
 }
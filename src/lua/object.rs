@@ -10,78 +10,89 @@ use std::sync::Arc;
 
 use crate::{
     borrow_string, lua::{
-        State, engine::Engine, func::{LUA_INDEX_BRIDGE_FUNCTION, LUA_NEWINDEX_BRIDGE_FUNCTION, LUA_OBJECT_BRIDGE_FUNCTION}, lua
+        State, engine::Engine, from_lua, func::{arg_from_lua, pack_callback, unpack_callback}, lua, lua_pop, lua_upvalueindex, var::push_lua_stack
     }, pxs_error, shared::{
-        PXS_PTR_NAME, PxsRes, object::{ObjectFlags, pxs_PixelObject}, utils::create_private_name
+        PXS_PTR_NAME, PXS_PTR_NAME_C, PxsRes, func::call_function, object::{ObjectFlags, pxs_PixelObject}, pxs_Runtime
     }
 };
 
-/// __index
-pub(super) fn lua_index(L: *mut lua::lua_State) -> PxsRes<i32> {
-    let table = 1;
-    let key = 2;
-
-    let function_name = unsafe {
-        borrow_string!(lua::lua_tolstring(L, key, core::ptr::null_mut())).to_string()
-    };
-    // Possible private name.
-    let private_name = create_private_name(&function_name);
-
-    let mut engine = Engine::without_alloc(L);
-
-    // Check on regular table first. (_pxs_ptr) or user assigned values.
-    engine.push_value(key);
-    engine.raw_get(table);
-    
-    if engine.get_type(-1) != lua::LUA_TNIL as i32 {
-        // We got something, return it.
-        return Ok(1);
-    } 
-    // Pop nil from the stack
-    engine.pop(1);
-
-    // Get the meta table because that is what has the values
-    engine.get_meta(table); // 1 (3)
-    let mt = engine.get_top();
+// Upvalues of `__index` and `__newindex`, the slot tables of the type. Built with its metatable so a access is a few
+// `rawget`s and never builds a name.
+/// Methods, the metatable itself.
+const SLOT_METHODS: i32 = 1;
+/// Property name -> `pack_callback(fn_idx, flags)`.
+const SLOT_PROPS: i32 = 2;
+/// Read only field name -> value.
+const SLOT_FIELDS: i32 = 3;
+
+/// Call the getter of the property `slot` of the object at `table`, or the setter with the value at `value`.
+fn call_property(L: *mut lua::lua_State, table: i32, slot: i64, value: Option<i32>) -> PxsRes<i32> {
+    let (fn_idx, flags) = unpack_callback(slot);
+
+    let mut argv = Vec::with_capacity(3);
+    argv.push(pxs_Runtime::pxs_Lua.into_var());
+    if flags & ObjectFlags::UsesId as u8 != 0 {
+        unsafe {
+            lua::lua_pushstring(L, PXS_PTR_NAME_C.as_ptr());
+            lua::lua_rawget(L, table);
+        }
+        let id = from_lua(-1);
+        lua_pop(L, 1);
+        argv.push(id?);
+    } else {
+        argv.push(arg_from_lua(L, table)?);
+    }
+    if let Some(value) = value {
+        argv.push(arg_from_lua(L, value)?);
+    }
 
-    // Check for non private name first
-    engine.push_string(&function_name); // 2 (4)
-    engine.raw_get(mt); // 2 (4)
+    let res = call_function(fn_idx, argv);
+    push_lua_stack(&res)?;
+    Ok(1)
+}
 
-    if engine.get_type(engine.get_top()) != lua::LUA_TNIL as i32 {
-        // We have our result!
-        engine.remove(3); // remove MT
-        return Ok(1);
+/// The property slot of the key at `key`, None when it is not a property.
+fn find_prop(L: *mut lua::lua_State, key: i32) -> Option<i64> {
+    unsafe {
+        lua::lua_pushvalue(L, key);
+        lua::lua_rawget(L, lua_upvalueindex(SLOT_PROPS));
+        let slot = if lua::lua_isinteger(L, -1) != 0 {
+            Some(lua::lua_tointegerx(L, -1, core::ptr::null_mut()))
+        } else {
+            None
+        };
+        lua_pop(L, 1);
+        slot
     }
+}
 
-    // We may have a property
-    engine.pop(1); // 1 (3) Now only MT is on top.
-
-    // Check private name
-    engine.push_string(&private_name); // 2 (4)
-    engine.raw_get(mt); // 2 (4)
+/// __index
+///
+/// Only called for keys the table does not have: `_pxs_ptr`, writable fields and values set by scripts are found
+/// by Lua before this.
+pub(super) fn lua_index(L: *mut lua::lua_State) -> PxsRes<i32> {
+    let table = 1;
+    let key = 2;
 
-    if engine.get_type(engine.get_top()) != lua::LUA_TFUNCTION as i32 {
-        // Who knows what this is, just return it
-        engine.remove(3); // remove MT
-        return Ok(1);
+    unsafe {
+        // Methods and read only fields are returned as they are.
+        for slots in [SLOT_METHODS, SLOT_FIELDS] {
+            lua::lua_pushvalue(L, key);
+            if lua::lua_rawget(L, lua_upvalueindex(slots)) != lua::LUA_TNIL as i32 {
+                return Ok(1);
+            }
+            lua_pop(L, 1);
+        }
     }
 
-    // We have our function on top!
-    // Lets push the table
-    engine.push_value(table); // 3 (5)
-    let res = engine.call(1, 1); // if successfull 3 (5)
-    if res.is_err() {
-        engine.pop(1); // MT 
-        return pxs_error!("{}", res.unwrap_err().to_string());
+    // A property asks the host.
+    match find_prop(L, key) {
+        Some(slot) => call_property(L, table, slot, None),
+        None => {
+            unsafe { lua::lua_pushnil(L) };
+            Ok(1)
+        }
     }
-
-    // We got a value!
-    // Just need to return it
-    // I need to remove MT only
-    engine.remove(3);
-    // Done
-    Ok(1)
 }
 
 /// __newindex
@@ -90,37 +101,28 @@ pub(super) fn lua_newindex(L: *mut lua::lua_State) -> PxsRes<i32> {
     let key = 2;
     let value = 3;
 
-    let mut engine = Engine::new(L);
-
-    // Property 
-    let property_name = engine.to_string(key);
-    let private_name = create_private_name(&property_name);
-
-    // Get MT
-    engine.get_meta(table);
-    let mt = engine.get_top();
+    if let Some(slot) = find_prop(L, key) {
+        // The setter result is only checked for a exception.
+        call_property(L, table, slot, Some(value))?;
+        return Ok(0);
+    }
 
-    // Check if MT has private name
-    engine.push_string(&private_name);
-    engine.raw_get(mt);
+    unsafe {
+        lua::lua_pushvalue(L, key);
+        let read_only = lua::lua_rawget(L, lua_upvalueindex(SLOT_FIELDS)) != lua::LUA_TNIL as i32;
+        lua_pop(L, 1);
+        if read_only {
+            // Field names are strings.
+            let name = borrow_string!(lua::lua_tolstring(L, key, core::ptr::null_mut()));
+            return pxs_error!("{name} is read only.");
+        }
 
-    if engine.get_type(engine.get_top()) != lua::LUA_TFUNCTION as i32 {
         // Set it like you would normally
-        engine.push_value(key);
-        engine.push_value(value);
-        engine.raw_set(table);
-    } else {
-        // This is a function!
-        // Push table, value
-        engine.push_value(table);
-        engine.push_value(value);
-        let res = engine.call(2, 1); // this should always be nil
-        if res.is_err() {
-            return pxs_error!("{}", res.unwrap_err().to_string());
-        }
+        lua::lua_pushvalue(L, key);
+        lua::lua_pushvalue(L, value);
+        lua::lua_rawset(L, table);
     }
 
-    drop(engine);
     Ok(0)
 }
 
@@ -132,10 +134,11 @@ pub(super) fn create_object(
 ) {
     let mut engine = Engine::from_state(state);
 
-    let callback_count = source.callbacks.len();
+    let callback_count = source.callbacks().len();
+    let writable_count = source.fields().iter().filter(|field| field.writable).count();
     // Create the table off the `engine` tracked stack.
     unsafe {
-        lua::lua_createtable((*state).engine, 0, callback_count as i32);
+        lua::lua_createtable((*state).engine, 0, (1 + writable_count) as i32);
     }
     let table = engine.get_top();
 
@@ -144,47 +147,66 @@ pub(super) fn create_object(
     engine.push_integer(idx);
     engine.raw_set(table);
 
+    // Writable fields live in the table, Lua reads and writes them without the bridge.
+    for field in source.fields().iter().filter(|field| field.writable) {
+        engine.push_string(&field.name);
+        if engine.push_pxs(&field.var).is_err() {
+            engine.pop(1);
+            continue;
+        }
+        engine.raw_set(table);
+    }
+
     // Create a new meta table
     let created = engine.new_meta(&source.type_name);
-    if created == 0 {
-        // Alaready exists
+    let mt = engine.get_top();
+    if created == 0 && source.is_instance() {
+        // Class instances share the metatable of the first one, which already has every callback.
         engine.set_meta(table);
+        return;
     }
 
-    // Create a new meta table.
-    let mt = engine.get_top();
+    let prop_count = source.callbacks().iter().filter(|method| method.flags & ObjectFlags::IsProp as u8 != 0).count();
+    let props = engine.create_table(0, prop_count as i32);
+    let fields = engine.create_table(0, (source.fields().len() - writable_count) as i32);
 
     // Add callbacks
-    for method in source.callbacks.iter() {
-        // The method name changes if a prop _pxs{name}_.
-        let method_name = if method.flags & ObjectFlags::IsProp as u8 != 0 {
-            create_private_name(&method.cbk.name)
-        } else {
-            method.cbk.name.clone()
-        };
+    for method in source.callbacks().iter() {
+        if method.flags & ObjectFlags::IsProp as u8 != 0 {
+            engine.push_string(&method.cbk.name);
+            engine.push_i64(pack_callback(method.cbk.idx, method.flags));
+            engine.raw_set(props);
+            continue;
+        }
 
-        // Setup the function up values
-        engine.push_integer(LUA_OBJECT_BRIDGE_FUNCTION);
-        engine.push_integer(method.cbk.idx);
-        engine.push_integer(method.flags as i32);
-        engine.push_function(lua::pxslua_callback, 3);
-        // engine.push_function(lua_object_bridge, 2);
+        // Index and flags in one upvalue.
+        engine.push_i64(pack_callback(method.cbk.idx, method.flags));
+        engine.push_function(lua::pxslua_objectcall, 1);
 
         // Add to metatable
-        engine.set_field(mt, &method_name);
+        engine.set_field(mt, &method.cbk.name);
+    }
+
+    for field in source.fields().iter().filter(|field| !field.writable) {
+        engine.push_string(&field.name);
+        if engine.push_pxs(&field.var).is_err() {
+            engine.pop(1);
+            continue;
+        }
+        engine.raw_set(fields);
     }
 
-    // Bind __index
-    engine.push_string("__index");
-    engine.push_integer(LUA_INDEX_BRIDGE_FUNCTION);
-    engine.push_function(lua::pxslua_callback, 1);
-    engine.raw_set(mt);
-
-    // Bind __newindex
-    engine.push_string("__newindex");
-    engine.push_integer(LUA_NEWINDEX_BRIDGE_FUNCTION);
-    engine.push_function(lua::pxslua_callback, 1);
-    engine.raw_set(mt);
+    // Bind __index and __newindex with the slot tables.
+    let metamethods: [(&str, unsafe extern "C" fn(*mut lua::lua_State) -> core::ffi::c_int); 2] =
+        [("__index", lua::pxslua_index), ("__newindex", lua::pxslua_newindex)];
+    for (name, func) in metamethods {
+        engine.push_string(name);
+        engine.push_value(mt);
+        engine.push_value(props);
+        engine.push_value(fields);
+        engine.push_function(func, 3);
+        engine.raw_set(mt);
+    }
 
     // Just put it on the top
     engine.push_value(mt);
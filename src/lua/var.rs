@@ -13,12 +13,67 @@ use etffi::{borrow_string, cstring::CStringSafe};
 
 // Pure Rust goes here
 use crate::{
-    lua::{LUA_TBOOLEAN, LUA_TFUNCTION, LUA_TNONE, LUA_TNUMBER, LUA_TSTRING, LUA_TTABLE, LuaReference, get_lua_state, lua::{self, lua_createtable, lua_geti, lua_gettop, lua_rawseti, lua_settable}, lua_pop, object::create_object}, pxs_error, shared::{
-        PxsRes, PxsResult, object::get_object, pxs_Opaque, pxs_Runtime, var::{pxs_Var, pxs_VarObject, pxs_VarType}
+    lua::{LUA_TBOOLEAN, LUA_TFUNCTION, LUA_TNONE, LUA_TNUMBER, LUA_TSTRING, LUA_TTABLE, LUA_TUSERDATA, LuaReference, get_lua_state, outside_limit, lua::{self, lua_createtable, lua_geti, lua_gettop, lua_rawseti, lua_settable}, lua_pop, object::create_object}, pxs_error, shared::{
+        PxsRes, PxsResult, map::MapKey, object::get_object, pxs_Opaque, pxs_Runtime, var::{pxs_Var, pxs_VarBuffer, pxs_VarObject, pxs_VarProxy, pxs_VarType}
     }
 };
 use etffi::ptr_magic::PtrMagic;
 
+/// cbindgen:ignore
+/// This is defined in libs/pxs_lua.h
+/// Called by the `__gc` of a buffer userdata.
+#[unsafe(no_mangle)]
+unsafe extern "C" fn pxslua_releasebuffer(handle: pxs_Opaque) {
+    unsafe { pxs_VarBuffer::release_handle(handle) };
+}
+
+/// cbindgen:ignore
+/// This is defined in libs/pxs_lua.h
+/// Called by the `__gc` of a proxy userdata.
+#[unsafe(no_mangle)]
+unsafe extern "C" fn pxslua_releaseproxy(handle: pxs_Opaque) {
+    unsafe { pxs_VarProxy::release_handle(handle) };
+}
+
+/// cbindgen:ignore
+/// This is defined in libs/pxs_lua.h
+#[unsafe(no_mangle)]
+unsafe extern "C" fn pxslua_proxylen(handle: pxs_Opaque) -> usize {
+    unsafe { pxs_VarProxy::from_handle(handle) }.len()
+}
+
+/// cbindgen:ignore
+/// This is defined in libs/pxs_lua.h
+/// `__index` of a proxy userdata, converts only the item asked for.
+#[unsafe(no_mangle)]
+unsafe extern "C" fn pxslua_proxyindex(_L: *mut lua::lua_State, handle: pxs_Opaque) -> core::ffi::c_int {
+    outside_limit(|| proxy_index(handle))
+}
+
+/// `pxslua_proxyindex` with the memory limit unchecked.
+fn proxy_index(handle: pxs_Opaque) -> core::ffi::c_int {
+    let proxy = unsafe { pxs_VarProxy::from_handle(handle) };
+    let Ok(mut key) = from_lua(2) else {
+        return 0;
+    };
+    if proxy.target().is_list() {
+        // Lua lists start at 1.
+        key = match key.as_i64() {
+            Some(idx) if idx >= 1 => pxs_Var::new_i64(idx - 1),
+            _ => pxs_Var::new_null(),
+        };
+    }
+
+    let res = match proxy.get(&key) {
+        Some(item) => push_lua_stack(item),
+        None => {
+            unsafe { lua::lua_pushnil((*get_lua_state()).engine) };
+            Ok(0)
+        }
+    };
+    res.is_ok() as core::ffi::c_int
+}
+
 /// Free lua memory
 unsafe extern "C" fn free_lua_mem(ptr: pxs_Opaque) {
     let _ = LuaReference::from_raw(ptr as *mut LuaReference);
@@ -81,6 +136,12 @@ pub(super) fn from_lua(idx: i32) -> PxsResult {
                 // Convert into list
                 Ok(pxs_Var::new_list_with(values))
             }
+        } else if lua_type == LUA_TUSERDATA && !lua::pxslua_tobuffer(L, idx).is_null() {
+            // Back to the same memory.
+            Ok(pxs_Var::new_buffer(pxs_VarBuffer::from_handle(lua::pxslua_tobuffer(L, idx))))
+        } else if lua_type == LUA_TUSERDATA && !lua::pxslua_toproxy(L, idx).is_null() {
+            // Back to the same container.
+            Ok(pxs_Var::new_proxy(pxs_VarProxy::from_handle(lua::pxslua_toproxy(L, idx))))
         } else if lua_type == LUA_TNONE {
             pxs_error!("Reference does not exist.")
         } else {
@@ -173,18 +234,28 @@ pub(super) fn push_lua_stack(var: &pxs_Var) -> PxsRes<i32> {
             },
             pxs_VarType::pxs_Map => {
                 let map = var.get_map().unwrap();
-                let keys = map.keys();
-                lua_createtable(L, 0, keys.len() as i32);
+                lua_createtable(L, 0, map.len() as i32);
                 let table = lua_gettop(L);
-                for k in keys {
-                    push_lua_stack(k)?;
-                    push_lua_stack(map.get_item(k).unwrap())?;
+                for (k, value) in map.iter() {
+                    match k {
+                        // Already nul terminated.
+                        MapKey::Str(k) => lua::lua_pushstring(L, k.as_ptr()),
+                        MapKey::Var(k) => push_lua_stack(k)?,
+                    }
+                    push_lua_stack(value)?;
                     lua_settable(L, table);
                 }
             },
             pxs_VarType::pxs_Byte => {
                 lua::lua_pushinteger(L, var.get_byte()? as i64);
             }
+            pxs_VarType::pxs_Buffer => {
+                let buffer = var.get_buffer().unwrap();
+                lua::pxslua_pushbuffer(L, buffer.data(), buffer.len(), buffer.into_handle());
+            }
+            pxs_VarType::pxs_Proxy => {
+                lua::pxslua_pushproxy(L, var.get_proxy().unwrap().into_handle());
+            }
         }
 
         Ok(lua_gettop(L))
@@ -1,4 +1,6 @@
-use crate::{pxs_varis, shared::var::{pxs_VarT, pxs_VarType}};
+use std::sync::{Arc, Mutex, atomic::{AtomicBool, Ordering}};
+
+use crate::{pxs_varis, shared::{module::pxs_Module, var::{pxs_VarT, pxs_VarType}}, with_feature};
 
 // Copyright 2026 Jordan Castro <jordan@grupojvm.com>
 //
@@ -13,6 +15,44 @@ use crate::{pxs_varis, shared::var::{pxs_VarT, pxs_VarType}};
 pub mod pxs_json;
 #[cfg(feature="pxs_mem")]
 pub mod pxs_mem;
+#[cfg(feature="pxs_pack")]
+pub mod pxs_pack;
+#[cfg(feature="pxs_data")]
+pub mod pxs_data;
+
+/// Core modules made by the thread of a parallel `pxs_initialize`, for the runtimes it starts on other threads. Their
+/// function ids are in its lookup, the one the started states are moved to.
+static SHARED: Mutex<Vec<Arc<pxs_Module>>> = Mutex::new(vec![]);
+static SHARING: AtomicBool = AtomicBool::new(false);
+
+/// Core module `name`, the shared one while sharing.
+fn shared_module(name: &str, build: fn() -> Arc<pxs_Module>) -> Arc<pxs_Module> {
+    if SHARING.load(Ordering::Relaxed) {
+        if let Some(module) = SHARED.lock().unwrap().iter().find(|module| module.name == name) {
+            return Arc::clone(module);
+        }
+    }
+    build()
+}
+
+/// Make the core modules once on this thread and share them with the runtimes starting on others, or stop sharing.
+pub(crate) fn share_modules(share: bool) {
+    SHARING.store(false, Ordering::Relaxed);
+    let mut modules: Vec<Arc<pxs_Module>> = vec![];
+    if share {
+        with_feature!("pxs_json", {
+            modules.push(pxs_json::module());
+        });
+        with_feature!("pxs_pack", {
+            modules.push(pxs_pack::module());
+        });
+        with_feature!("pxs_data", {
+            modules.push(pxs_data::module());
+        });
+    }
+    *SHARED.lock().unwrap() = modules;
+    SHARING.store(share, Ordering::Relaxed);
+}
 
 /// This will check if the arguments are valid to be passed into a pxs_Func.
 /// This is only used in core functions exposed to lib.
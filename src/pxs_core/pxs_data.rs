@@ -0,0 +1,73 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+//! The `pxs_data` module, scripts reading what the host published with `pxs_publish`.
+use std::sync::Arc;
+
+use crate::{
+    borrow_var, pxs_listget,
+    shared::{
+        func::lookup_add_function,
+        module::pxs_Module,
+        store,
+        var::{pxs_Var, pxs_VarT, pxs_VarType},
+    },
+};
+use etffi::ptr_magic::PtrMagic;
+
+/// `pxs_data.get(name)` a view of the data published as `name`, null if there is none.
+extern "C" fn script_get(args: pxs_VarT) -> pxs_VarT {
+    let name = pxs_listget(args, 1);
+    if name.is_null() {
+        return pxs_Var::null_param_ep("name").into_raw();
+    }
+    let name = match borrow_var!(name).get_string() {
+        Ok(name) => name,
+        Err(err) => return pxs_Var::new_exception(err).into_raw(),
+    };
+
+    match store::get(&name) {
+        Some(proxy) => pxs_Var::new_proxy(proxy),
+        None => pxs_Var::new_null(),
+    }
+    .into_raw()
+}
+
+/// `pxs_data.names()` every published name.
+extern "C" fn script_names(_args: pxs_VarT) -> pxs_VarT {
+    let names = store::names().into_iter().map(pxs_Var::new_string).collect();
+    pxs_Var::new_list_with(names).into_raw()
+}
+
+/// `pxs_data.keys(view)` the keys of a Map view in order, since views can not be iterated.
+extern "C" fn script_keys(args: pxs_VarT) -> pxs_VarT {
+    let view = pxs_listget(args, 1);
+    if view.is_null() {
+        return pxs_Var::null_param_ep("view").into_raw();
+    }
+    let view = borrow_var!(view);
+    let Some(map) = view.get_proxy().and_then(|proxy| proxy.target().get_map()) else {
+        return pxs_Var::incorrect_types_ep(vec![pxs_VarType::pxs_Proxy], view.tag).into_raw();
+    };
+
+    let keys = map.iter().map(|(key, _)| key.to_var()).collect();
+    pxs_Var::new_list_with(keys).into_raw()
+}
+
+/// The `pxs_data` module, added to every state by the runtimes.
+pub(crate) fn module() -> Arc<pxs_Module> {
+    super::shared_module("pxs_data", build)
+}
+
+fn build() -> Arc<pxs_Module> {
+    let mut module = pxs_Module::new("pxs_data".to_string());
+    module.add_callback("get", "_pxs_dataget", lookup_add_function("_pxs_dataget", script_get));
+    module.add_callback("names", "_pxs_datanames", lookup_add_function("_pxs_datanames", script_names));
+    module.add_callback("keys", "_pxs_datakeys", lookup_add_function("_pxs_datakeys", script_keys));
+    Arc::new(module)
+}
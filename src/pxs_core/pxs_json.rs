@@ -1,50 +1,981 @@
-use crate::{create_raw_string, free_raw_string, pxs_freevar, pxs_objectget, pxs_var_fromname, pxs_varcall, shared::var::pxs_VarT};
-
-/// Encode a `pxs_Object` into JSON.
-pub extern "C" fn encode(rt: pxs_VarT, args: pxs_VarT) -> pxs_VarT {
-    // Get json module
-    let cname = create_raw_string!("pxs_json");
-    let json = pxs_var_fromname(rt, cname);
-    unsafe{
-        free_raw_string!(cname);
-    }
-
-    let cmethod = create_raw_string!("encode");
-    // Lets get the encode method as a var!
-    let encode_method = pxs_objectget(rt, json, cmethod);
-    // Now let's call it
-    let res = pxs_varcall(rt, encode_method, args);
-    unsafe{
-        free_raw_string!(cmethod);
-    }
-    // Free json
-    pxs_freevar(json);
-    // Free decode method
-    pxs_freevar(encode_method);
-
-    res
-} 
-
-/// Decode a JSON string into a `pxs_Object`
-pub extern "C" fn decode(rt: pxs_VarT, args: pxs_VarT) -> pxs_VarT {
-    let cname = create_raw_string!("pxs_json");
-    let json = pxs_var_fromname(rt, cname);
-    unsafe{
-        free_raw_string!(cname);
-    }
-
-    let cmethod = create_raw_string!("decode");
-    // Lets get the decode method as a var!
-    let decode_method = pxs_objectget(rt, json, cmethod);
-    // Now let's call it
-    let res = pxs_varcall(rt, decode_method, args);
-    unsafe {
-        free_raw_string!(cmethod);
-    }
-
-    // Free json
-    pxs_freevar(json);
-    // Free decode_method
-    pxs_freevar(decode_method);
-    res
-}
\ No newline at end of file
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+//! Native JSON for `pxs_json`, working on `pxs_Var` trees so every runtime behaves the same.
+//!
+//! Decoding is done in two stages like simdjson: `scan` finds every token of the input 64 bytes at a time, then
+//! `Parser` builds the tree from that index without looking at whitespace or string contents again.
+use std::{ffi::CStr, fmt::Write, sync::Arc};
+
+use crate::{
+    borrow_var, object_entries, pxs_error, pxs_getstrview, pxs_listget,
+    shared::{
+        PxsRes, PxsResult,
+        func::lookup_add_function,
+        map::MapKey,
+        module::pxs_Module,
+        pxs_Runtime,
+        var::{pxs_Var, pxs_VarMap, pxs_VarT, pxs_VarType},
+    },
+};
+use etffi::ptr_magic::PtrMagic;
+
+/// Deeper than this is a error, so cyclic script data can not overflow the stack.
+const MAX_DEPTH: usize = 1024;
+
+/// Byte classes of one 64 byte block, bit `i` is byte `i`.
+#[derive(Default)]
+struct Masks {
+    quote: u64,
+    backslash: u64,
+    /// `{ } [ ] : ,`
+    op: u64,
+    /// Space, tab, `\n` and `\r`.
+    space: u64,
+}
+
+#[cfg(target_arch = "x86_64")]
+fn classify(block: &[u8; 64]) -> Masks {
+    use std::arch::x86_64::*;
+
+    // SSE2 is part of x86_64, 16 bytes per compare.
+    #[inline(always)]
+    fn eq(chunk: __m128i, c: u8) -> u64 {
+        unsafe { _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(c as i8))) as u16 as u64 }
+    }
+
+    let mut masks = Masks::default();
+    for i in 0..4 {
+        let chunk = unsafe { _mm_loadu_si128(block.as_ptr().add(i * 16) as *const __m128i) };
+        let shift = i * 16;
+        masks.quote |= eq(chunk, b'"') << shift;
+        masks.backslash |= eq(chunk, b'\\') << shift;
+        masks.op |= (eq(chunk, b'{') | eq(chunk, b'}') | eq(chunk, b'[') | eq(chunk, b']') | eq(chunk, b':')
+            | eq(chunk, b','))
+            << shift;
+        masks.space |= (eq(chunk, b' ') | eq(chunk, b'\t') | eq(chunk, b'\n') | eq(chunk, b'\r')) << shift;
+    }
+    masks
+}
+
+#[cfg(not(target_arch = "x86_64"))]
+fn classify(block: &[u8; 64]) -> Masks {
+    let mut masks = Masks::default();
+    for (i, b) in block.iter().enumerate() {
+        let bit = 1u64 << i;
+        match b {
+            b'"' => masks.quote |= bit,
+            b'\\' => masks.backslash |= bit,
+            b'{' | b'}' | b'[' | b']' | b':' | b',' => masks.op |= bit,
+            b' ' | b'\t' | b'\n' | b'\r' => masks.space |= bit,
+            _ => {}
+        }
+    }
+    masks
+}
+
+/// Bytes escaped by a backslash. `carry` is set when the last byte of the block escapes the next blocks first.
+///
+/// Walks the backslashes one by one, they are rare in real JSON.
+fn escaped(backslash: u64, carry: &mut bool) -> u64 {
+    let mut backslash = backslash;
+    let mut escaped = 0;
+    if *carry {
+        // A escaped backslash does not escape.
+        escaped = 1;
+        backslash &= !1;
+    }
+    *carry = false;
+    while backslash != 0 {
+        let i = backslash.trailing_zeros();
+        if i == 63 {
+            *carry = true;
+            break;
+        }
+        let next = 1u64 << (i + 1);
+        escaped |= next;
+        backslash &= !(next | (1u64 << i));
+    }
+    escaped
+}
+
+/// Bit `i` is the xor of bits `0..=i`, i.e. set from a opening quote up to (not including) the closing one.
+fn prefix_xor(mut bits: u64) -> u64 {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    bits
+}
+
+/// Stage 1: the position of every token. That is structural characters, opening quotes and the first byte of
+/// numbers/`true`/`false`/`null`, all outside of strings.
+fn scan(input: &[u8]) -> PxsRes<Vec<u32>> {
+    if input.len() > u32::MAX as usize {
+        return pxs_error!("JSON is too large");
+    }
+
+    let mut index = Vec::with_capacity(input.len() / 8 + 1);
+    let mut escape_carry = false;
+    // All ones while inside a string.
+    let mut in_string_carry = 0u64;
+    let mut scalar_carry = 0u64;
+    let mut padded = [b' '; 64];
+
+    for (n, chunk) in input.chunks(64).enumerate() {
+        let masks = match <&[u8; 64]>::try_from(chunk) {
+            Ok(block) => classify(block),
+            Err(_) => {
+                padded[..chunk.len()].copy_from_slice(chunk);
+                classify(&padded)
+            }
+        };
+
+        let quotes = masks.quote & !escaped(masks.backslash, &mut escape_carry);
+        let in_string = prefix_xor(quotes) ^ in_string_carry;
+        in_string_carry = ((in_string as i64) >> 63) as u64;
+
+        let scalar = !(masks.op | masks.space | quotes | in_string);
+        let scalar_starts = scalar & !((scalar << 1) | scalar_carry);
+        scalar_carry = scalar >> 63;
+
+        let mut tokens = (masks.op & !in_string) | (quotes & in_string) | scalar_starts;
+        let base = (n * 64) as u32;
+        while tokens != 0 {
+            index.push(base + tokens.trailing_zeros());
+            tokens &= tokens - 1;
+        }
+    }
+
+    if in_string_carry != 0 {
+        return pxs_error!("Unterminated string in JSON");
+    }
+    Ok(index)
+}
+
+fn is_delimiter(b: u8) -> bool {
+    matches!(b, b' ' | b'\t' | b'\n' | b'\r' | b'{' | b'}' | b'[' | b']' | b':' | b',' | b'"')
+}
+
+/// A JSON number, as a `pxs_Int64` when it has no fraction or exponent and fits (`pxs_UInt64` above `i64::MAX`),
+/// else a `pxs_Float64`. None if it is not valid JSON.
+fn number(text: &[u8]) -> Option<pxs_Var> {
+    let digits = |i: &mut usize| {
+        let start = *i;
+        while *i < text.len() && text[*i].is_ascii_digit() {
+            *i += 1;
+        }
+        *i - start
+    };
+
+    let mut i = 0;
+    if text.first() == Some(&b'-') {
+        i += 1;
+    }
+    let int_start = i;
+    let int_len = digits(&mut i);
+    if int_len == 0 || (int_len > 1 && text[int_start] == b'0') {
+        return None;
+    }
+    let mut is_float = false;
+    if text.get(i) == Some(&b'.') {
+        i += 1;
+        if digits(&mut i) == 0 {
+            return None;
+        }
+        is_float = true;
+    }
+    if matches!(text.get(i), Some(b'e' | b'E')) {
+        i += 1;
+        if matches!(text.get(i), Some(b'+' | b'-')) {
+            i += 1;
+        }
+        if digits(&mut i) == 0 {
+            return None;
+        }
+        is_float = true;
+    }
+    if i != text.len() {
+        return None;
+    }
+
+    // Only ASCII got this far.
+    let text = std::str::from_utf8(text).ok()?;
+    if !is_float {
+        if let Ok(int) = text.parse::<i64>() {
+            return Some(pxs_Var::new_i64(int));
+        }
+        if let Ok(uint) = text.parse::<u64>() {
+            return Some(pxs_Var::new_u64(uint));
+        }
+    }
+    text.parse::<f64>().ok().map(pxs_Var::new_f64)
+}
+
+/// Stage 2: builds the tree from the token index of `scan`.
+struct Parser<'a> {
+    text: &'a str,
+    index: Vec<u32>,
+    next: usize,
+}
+
+impl<'a> Parser<'a> {
+    fn byte(&self, at: usize) -> u8 {
+        self.text.as_bytes()[at]
+    }
+
+    fn peek(&self) -> Option<u8> {
+        self.index.get(self.next).map(|at| self.byte(*at as usize))
+    }
+
+    /// Position of the next token.
+    fn take(&mut self) -> PxsRes<usize> {
+        let Some(at) = self.index.get(self.next) else {
+            return pxs_error!("Unexpected end of JSON");
+        };
+        self.next += 1;
+        Ok(*at as usize)
+    }
+
+    fn unexpected<T>(&self, at: usize) -> PxsRes<T> {
+        pxs_error!("Unexpected '{}' in JSON at {at}", self.byte(at).escape_ascii())
+    }
+
+    fn expect(&mut self, c: u8) -> PxsRes<()> {
+        let at = self.take()?;
+        if self.byte(at) != c {
+            return self.unexpected(at);
+        }
+        Ok(())
+    }
+
+    fn value(&mut self, depth: usize) -> PxsResult {
+        if depth > MAX_DEPTH {
+            return pxs_error!("JSON is nested too deep");
+        }
+        let at = self.take()?;
+        match self.byte(at) {
+            b'{' => self.object(depth),
+            b'[' => self.array(depth),
+            b'"' => Ok(pxs_Var::new_string(self.string(at)?)),
+            _ => self.atom(at),
+        }
+    }
+
+    fn object(&mut self, depth: usize) -> PxsResult {
+        // Keeps the document order, also when a script removes keys.
+        let mut map = pxs_VarMap::new_ordered();
+        if self.peek() == Some(b'}') {
+            self.next += 1;
+            return Ok(pxs_Var::new_map_with(map));
+        }
+        loop {
+            let at = self.take()?;
+            if self.byte(at) != b'"' {
+                return self.unexpected(at);
+            }
+            let key = self.string(at)?;
+            self.expect(b':')?;
+            let value = self.value(depth + 1)?;
+            map.add_str(&key, value);
+
+            let at = self.take()?;
+            match self.byte(at) {
+                b',' => continue,
+                b'}' => return Ok(pxs_Var::new_map_with(map)),
+                _ => return self.unexpected(at),
+            }
+        }
+    }
+
+    fn array(&mut self, depth: usize) -> PxsResult {
+        let mut values = vec![];
+        if self.peek() == Some(b']') {
+            self.next += 1;
+            return Ok(pxs_Var::new_list_with(values));
+        }
+        loop {
+            values.push(self.value(depth + 1)?);
+
+            let at = self.take()?;
+            match self.byte(at) {
+                b',' => continue,
+                b']' => return Ok(pxs_Var::new_list_with(values)),
+                _ => return self.unexpected(at),
+            }
+        }
+    }
+
+    fn string(&self, at: usize) -> PxsRes<String> {
+        string_at(self.text, at)
+    }
+
+    /// A number, `true`, `false` or `null` at `at`.
+    fn atom(&self, at: usize) -> PxsResult {
+        let bytes = self.text.as_bytes();
+        let mut end = at;
+        while end < bytes.len() && !is_delimiter(bytes[end]) {
+            end += 1;
+        }
+        scalar(&bytes[at..end], at)
+    }
+}
+
+/// `true`, `false`, `null` or a number, `at` is only for the error.
+fn scalar(text: &[u8], at: usize) -> PxsResult {
+    match text {
+        b"true" => Ok(pxs_Var::new_bool(true)),
+        b"false" => Ok(pxs_Var::new_bool(false)),
+        b"null" => Ok(pxs_Var::new_null()),
+        text => match number(text) {
+            Some(var) => Ok(var),
+            None => pxs_error!("Invalid JSON value '{}' at {at}", text.escape_ascii()),
+        },
+    }
+}
+
+/// 4 hex digits of a `\u` escape at `at`.
+fn hex4(text: &str, at: usize) -> PxsRes<u32> {
+    let Some(hex) = text.get(at..at + 4) else {
+        return pxs_error!("Invalid \\u escape in JSON at {at}");
+    };
+    match u32::from_str_radix(hex, 16) {
+        Ok(code) if hex.bytes().all(|b| b.is_ascii_hexdigit()) => Ok(code),
+        _ => pxs_error!("Invalid \\u escape in JSON at {at}"),
+    }
+}
+
+/// The string starting at the quote at `at` of `text`.
+fn string_at(text: &str, at: usize) -> PxsRes<String> {
+    let bytes = text.as_bytes();
+    let special = |b: u8| b == b'"' || b == b'\\' || b < 0x20;
+
+    let start = at + 1;
+    let mut i = start;
+    while i < bytes.len() && !special(bytes[i]) {
+        i += 1;
+    }
+    // No escapes, the usual case.
+    if bytes.get(i) == Some(&b'"') {
+        return Ok(text[start..i].to_string());
+    }
+
+    let mut out = String::with_capacity(i - start + 16);
+    out.push_str(&text[start..i]);
+    loop {
+        let run = i;
+        while i < bytes.len() && !special(bytes[i]) {
+            i += 1;
+        }
+        // Runs end on ASCII, so these are char boundaries.
+        out.push_str(&text[run..i]);
+
+        match bytes.get(i) {
+            None => return pxs_error!("Unterminated string in JSON"),
+            Some(b'"') => return Ok(out),
+            Some(b'\\') => {
+                let Some(escape) = bytes.get(i + 1) else {
+                    return pxs_error!("Unterminated string in JSON");
+                };
+                i += 2;
+                match escape {
+                    b'"' => out.push('"'),
+                    b'\\' => out.push('\\'),
+                    b'/' => out.push('/'),
+                    b'b' => out.push('\u{8}'),
+                    b'f' => out.push('\u{c}'),
+                    b'n' => out.push('\n'),
+                    b'r' => out.push('\r'),
+                    b't' => out.push('\t'),
+                    b'u' => {
+                        let code = hex4(text, i)?;
+                        i += 4;
+                        let mut ch = char::from_u32(code);
+                        // A surrogate pair, a lone surrogate has no UTF-8 form.
+                        if (0xD800..0xDC00).contains(&code) && bytes.get(i..i + 2) == Some(b"\\u") {
+                            let low = hex4(text, i + 2)?;
+                            if (0xDC00..0xE000).contains(&low) {
+                                ch = char::from_u32(0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00));
+                                i += 6;
+                            }
+                        }
+                        out.push(ch.unwrap_or(char::REPLACEMENT_CHARACTER));
+                    }
+                    _ => return pxs_error!("Invalid escape in JSON at {}", i - 2),
+                }
+            }
+            Some(_) => return pxs_error!("Control character in JSON string at {i}"),
+        }
+    }
+}
+
+/// Decode JSON text. Objects become `pxs_Map`s with string keys and arrays `pxs_List`s.
+pub fn decode_str(text: &str) -> PxsResult {
+    let index = scan(text.as_bytes())?;
+    let mut parser = Parser { text, index, next: 0 };
+    let value = parser.value(0)?;
+    if let Some(at) = parser.index.get(parser.next) {
+        return pxs_error!("Unexpected data after JSON value at {at}");
+    }
+    Ok(value)
+}
+
+/// What a streamed value is to the pointer of a `pxs_JsonStream`.
+#[derive(Clone, Copy, PartialEq)]
+enum Mode {
+    /// Outside of the pointer, only checked.
+    Skip,
+    /// On the way to the pointer, keys are read but nothing is built.
+    Path,
+    /// The pointed to value or inside of it.
+    Build,
+}
+
+/// A open object or array of a `pxs_JsonStream`.
+struct Frame {
+    mode: Mode,
+    is_array: bool,
+    items: Vec<pxs_Var>,
+    map: pxs_VarMap,
+    /// Key of the value being read, objects only.
+    key: Option<String>,
+    /// Index of the value being read, arrays only.
+    index: usize,
+}
+
+/// What comes next in a `pxs_JsonStream`.
+#[derive(Clone, Copy, PartialEq)]
+enum Expect {
+    Value,
+    /// A value or `]`.
+    FirstValue,
+    Key,
+    /// A key or `}`.
+    FirstKey,
+    Colon,
+    /// `,` or the closing bracket.
+    Next,
+    /// Only whitespace.
+    Done,
+}
+
+/// A token split over chunks.
+#[derive(Clone, Copy, PartialEq)]
+enum Token {
+    None,
+    /// `keep` when its text is needed (built, or a key on the pointer path).
+    Str { key: bool, escape: bool, keep: bool },
+    /// A number, `true`, `false` or `null`.
+    Atom,
+}
+
+/// Longer atoms are a error, so garbage can not grow the token buffer.
+const MAX_ATOM: usize = 4096;
+
+#[allow(non_camel_case_types)]
+/// A streaming JSON decoder. Text is fed in chunks (`feed`) and the `pxs_Var` tree is built as it goes, so the text
+/// is never held whole. With a JSON pointer only that value is built.
+pub struct pxs_JsonStream {
+    pointer: String,
+    tokens: Vec<String>,
+    stack: Vec<Frame>,
+    expect: Expect,
+    token: Token,
+    /// Bytes of the current string (with its quotes) or atom.
+    buf: Vec<u8>,
+    result: Option<pxs_Var>,
+    /// The first error, every feed after it fails too.
+    error: Option<String>,
+    /// Bytes fed before the current chunk, for errors.
+    offset: usize,
+}
+
+impl PtrMagic for pxs_JsonStream {}
+
+/// The reference tokens of a JSON pointer (RFC 6901), `""` is the whole document.
+fn pointer_tokens(pointer: &str) -> PxsRes<Vec<String>> {
+    if pointer.is_empty() {
+        return Ok(vec![]);
+    }
+    let Some(rest) = pointer.strip_prefix('/') else {
+        return pxs_error!("JSON pointer '{pointer}' does not start with '/'");
+    };
+    Ok(rest.split('/').map(|token| token.replace("~1", "/").replace("~0", "~")).collect())
+}
+
+/// Does the pointer token name array index `index`? Leading zeros do not.
+fn is_index(token: &str, index: usize) -> bool {
+    token.parse::<usize>() == Ok(index) && (token == "0" || !token.starts_with('0'))
+}
+
+impl pxs_JsonStream {
+    /// A decoder building the value at `pointer`, `""` for the whole document.
+    pub fn new(pointer: &str) -> Self {
+        let (tokens, error) = match pointer_tokens(pointer) {
+            Ok(tokens) => (tokens, None),
+            Err(err) => (vec![], Some(err)),
+        };
+        pxs_JsonStream {
+            pointer: pointer.to_string(),
+            tokens,
+            stack: vec![],
+            expect: Expect::Value,
+            token: Token::None,
+            buf: vec![],
+            result: None,
+            error,
+            offset: 0,
+        }
+    }
+
+    /// Mode of the value starting now.
+    fn child_mode(&self) -> Mode {
+        let Some(top) = self.stack.last() else {
+            return if self.tokens.is_empty() { Mode::Build } else { Mode::Path };
+        };
+        if top.mode != Mode::Path {
+            return top.mode;
+        }
+        // Path frames are the first ones, one per matched token.
+        let depth = self.stack.len() - 1;
+        let token = &self.tokens[depth];
+        let matches = if top.is_array { is_index(token, top.index) } else { top.key.as_deref() == Some(token.as_str()) };
+        if !matches {
+            Mode::Skip
+        } else if depth + 1 == self.tokens.len() {
+            Mode::Build
+        } else {
+            Mode::Path
+        }
+    }
+
+    /// A value of `mode` is done, `value` is None when it was not built.
+    fn complete(&mut self, mode: Mode, value: Option<pxs_Var>) {
+        let Some(top) = self.stack.last_mut() else {
+            if mode == Mode::Build {
+                self.result = value;
+            }
+            self.expect = Expect::Done;
+            return;
+        };
+        if top.mode == Mode::Build {
+            if let Some(value) = value {
+                if top.is_array {
+                    top.items.push(value);
+                } else {
+                    top.map.add_str(&top.key.take().unwrap_or_default(), value);
+                }
+            }
+        } else if mode == Mode::Build {
+            // The pointed to value, later duplicates of its key win like in `decode_str`.
+            self.result = value;
+        }
+        top.key = None;
+        top.index += top.is_array as usize;
+        self.expect = Expect::Next;
+    }
+
+    fn open(&mut self, is_array: bool) -> PxsRes<()> {
+        if self.stack.len() >= MAX_DEPTH {
+            return pxs_error!("JSON is nested too deep");
+        }
+        let mode = self.child_mode();
+        self.stack.push(Frame {
+            mode,
+            is_array,
+            items: vec![],
+            map: pxs_VarMap::new_ordered(),
+            key: None,
+            index: 0,
+        });
+        self.expect = if is_array { Expect::FirstValue } else { Expect::FirstKey };
+        Ok(())
+    }
+
+    fn close(&mut self) {
+        let frame = self.stack.pop().unwrap();
+        let value = (frame.mode == Mode::Build).then(|| {
+            if frame.is_array {
+                pxs_Var::new_list_with(frame.items)
+            } else {
+                pxs_Var::new_map_with(frame.map)
+            }
+        });
+        self.complete(frame.mode, value);
+    }
+
+    fn start_string(&mut self, key: bool) {
+        let keep = if key { self.stack.last().unwrap().mode != Mode::Skip } else { self.child_mode() == Mode::Build };
+        self.buf.clear();
+        if keep {
+            self.buf.push(b'"');
+        }
+        self.token = Token::Str { key, escape: false, keep };
+    }
+
+    /// The kept string, its escapes decoded.
+    fn take_string(&mut self) -> PxsRes<String> {
+        let Ok(text) = std::str::from_utf8(&self.buf) else {
+            return pxs_error!("JSON is not UTF-8");
+        };
+        string_at(text, 0)
+    }
+
+    fn end_string(&mut self, key: bool, keep: bool) -> PxsRes<()> {
+        if key {
+            if keep {
+                let key = self.take_string()?;
+                self.stack.last_mut().unwrap().key = Some(key);
+            }
+            self.expect = Expect::Colon;
+            return Ok(());
+        }
+        let value = if keep { Some(pxs_Var::new_string(self.take_string()?)) } else { None };
+        let mode = self.child_mode();
+        self.complete(mode, value);
+        Ok(())
+    }
+
+    fn end_atom(&mut self, at: usize) -> PxsRes<()> {
+        self.token = Token::None;
+        let mode = self.child_mode();
+        // Checked even when skipped.
+        let value = scalar(&self.buf, at)?;
+        self.complete(mode, (mode == Mode::Build).then_some(value));
+        Ok(())
+    }
+
+    fn unexpected<T>(b: u8, at: usize) -> PxsRes<T> {
+        pxs_error!("Unexpected '{}' in JSON at {at}", b.escape_ascii())
+    }
+
+    /// A byte outside of strings and atoms, at `at` of the whole text.
+    fn structural(&mut self, b: u8, at: usize) -> PxsRes<()> {
+        match self.expect {
+            Expect::Value | Expect::FirstValue => match b {
+                b'{' => self.open(false)?,
+                b'[' => self.open(true)?,
+                b']' if self.expect == Expect::FirstValue => self.close(),
+                b'"' => self.start_string(false),
+                b'}' | b']' | b':' | b',' => return Self::unexpected(b, at),
+                _ => {
+                    self.buf.clear();
+                    self.buf.push(b);
+                    self.token = Token::Atom;
+                }
+            },
+            Expect::Key | Expect::FirstKey => match b {
+                b'"' => self.start_string(true),
+                b'}' if self.expect == Expect::FirstKey => self.close(),
+                _ => return Self::unexpected(b, at),
+            },
+            Expect::Colon if b == b':' => self.expect = Expect::Value,
+            Expect::Next => match (b, self.stack.last().unwrap().is_array) {
+                (b',', true) => self.expect = Expect::Value,
+                (b',', false) => self.expect = Expect::Key,
+                (b']', true) | (b'}', false) => self.close(),
+                _ => return Self::unexpected(b, at),
+            },
+            Expect::Colon => return Self::unexpected(b, at),
+            Expect::Done => return pxs_error!("Unexpected data after JSON value at {at}"),
+        }
+        Ok(())
+    }
+
+    fn feed_chunk(&mut self, data: &[u8]) -> PxsRes<()> {
+        let mut i = 0;
+        while i < data.len() {
+            match self.token {
+                Token::Str { key, escape, keep } => {
+                    if escape {
+                        if keep {
+                            self.buf.push(data[i]);
+                        }
+                        self.token = Token::Str { key, escape: false, keep };
+                        i += 1;
+                        continue;
+                    }
+                    // Everything up to the next quote, backslash or control character at once.
+                    let run = data[i..]
+                        .iter()
+                        .position(|b| *b == b'"' || *b == b'\\' || *b < 0x20)
+                        .unwrap_or(data.len() - i);
+                    if keep {
+                        self.buf.extend_from_slice(&data[i..i + run]);
+                    }
+                    i += run;
+                    let Some(&b) = data.get(i) else {
+                        break;
+                    };
+                    if keep {
+                        self.buf.push(b);
+                    }
+                    i += 1;
+                    match b {
+                        b'\\' => self.token = Token::Str { key, escape: true, keep },
+                        b'"' => {
+                            self.token = Token::None;
+                            self.end_string(key, keep)?;
+                        }
+                        _ => return pxs_error!("Control character in JSON string at {}", self.offset + i - 1),
+                    }
+                    continue;
+                }
+                Token::Atom => {
+                    if !is_delimiter(data[i]) {
+                        if self.buf.len() >= MAX_ATOM {
+                            return pxs_error!("Invalid JSON value at {}", self.offset + i);
+                        }
+                        self.buf.push(data[i]);
+                        i += 1;
+                        continue;
+                    }
+                    self.end_atom(self.offset + i)?;
+                }
+                Token::None => {}
+            }
+
+            let b = data[i];
+            i += 1;
+            if !matches!(b, b' ' | b'\t' | b'\n' | b'\r') {
+                self.structural(b, self.offset + i - 1)?;
+            }
+        }
+        self.offset += data.len();
+        Ok(())
+    }
+
+    /// Decode the next chunk of text. Chunks can end anywhere, even inside of a UTF-8 character.
+    pub fn feed(&mut self, data: &[u8]) -> PxsRes<()> {
+        if let Some(err) = &self.error {
+            return Err(err.clone());
+        }
+        let res = self.feed_chunk(data);
+        if let Err(err) = &res {
+            self.error = Some(err.clone());
+        }
+        res
+    }
+
+    /// The end of the text, returns the decoded (or pointed to) value.
+    pub fn finish(mut self) -> PxsResult {
+        if let Some(err) = self.error.take() {
+            return Err(err);
+        }
+        if self.token == Token::Atom {
+            self.end_atom(self.offset)?;
+        }
+        if self.expect != Expect::Done {
+            return pxs_error!("Unexpected end of JSON");
+        }
+        match self.result.take() {
+            Some(value) => Ok(value),
+            None => pxs_error!("JSON pointer '{}' not found", self.pointer),
+        }
+    }
+}
+
+/// Writes JSON, looking into `pxs_Object`s through the runtime they came from.
+struct Encoder {
+    runtime: Option<pxs_Runtime>,
+    out: String,
+}
+
+impl Encoder {
+    fn string(&mut self, text: &str) {
+        self.out.push('"');
+        let bytes = text.as_bytes();
+        let mut run = 0;
+        for (i, b) in bytes.iter().enumerate() {
+            let escape = match b {
+                b'"' => "\\\"",
+                b'\\' => "\\\\",
+                b'\n' => "\\n",
+                b'\r' => "\\r",
+                b'\t' => "\\t",
+                0..0x20 => "",
+                _ => continue,
+            };
+            self.out.push_str(&text[run..i]);
+            if escape.is_empty() {
+                let _ = write!(self.out, "\\u{:04x}", b);
+            } else {
+                self.out.push_str(escape);
+            }
+            run = i + 1;
+        }
+        self.out.push_str(&text[run..]);
+        self.out.push('"');
+    }
+
+    /// A object key. JSON only has string keys, so numbers and bools are written as text.
+    fn key(&mut self, key: MapKey) -> PxsRes<()> {
+        let key = match key {
+            MapKey::Str(key) => {
+                self.string(key.as_str());
+                return Ok(());
+            }
+            MapKey::Var(key) => key,
+        };
+        match key.tag {
+            pxs_VarType::pxs_String => self.string(&key.get_string()?),
+            pxs_VarType::pxs_Int64 | pxs_VarType::pxs_UInt64 | pxs_VarType::pxs_Float64 | pxs_VarType::pxs_Bool
+            | pxs_VarType::pxs_Byte => {
+                self.out.push('"');
+                self.value(key, 0)?;
+                self.out.push('"');
+            }
+            _ => return pxs_error!("Can not encode a {:#?} as a JSON key", key.tag),
+        }
+        Ok(())
+    }
+
+    fn pairs<'v>(&mut self, pairs: impl Iterator<Item = (MapKey<'v>, &'v pxs_Var)>, depth: usize) -> PxsRes<()> {
+        self.out.push('{');
+        for (i, (key, value)) in pairs.enumerate() {
+            if i > 0 {
+                self.out.push(',');
+            }
+            self.key(key)?;
+            self.out.push(':');
+            self.value(value, depth + 1)?;
+        }
+        self.out.push('}');
+        Ok(())
+    }
+
+    fn value(&mut self, var: &pxs_Var, depth: usize) -> PxsRes<()> {
+        if depth > MAX_DEPTH {
+            return pxs_error!("Value is nested too deep to encode as JSON, is it cyclic?");
+        }
+        match var.tag {
+            pxs_VarType::pxs_Int64 => {
+                let _ = write!(self.out, "{}", var.get_i64()?);
+            }
+            pxs_VarType::pxs_UInt64 => {
+                let _ = write!(self.out, "{}", var.get_u64()?);
+            }
+            pxs_VarType::pxs_Byte => {
+                let _ = write!(self.out, "{}", var.get_byte()?);
+            }
+            pxs_VarType::pxs_Float64 => {
+                let float = var.get_f64()?;
+                // Same as `JSON.stringify`.
+                if float.is_finite() {
+                    let _ = write!(self.out, "{float:?}");
+                } else {
+                    self.out.push_str("null");
+                }
+            }
+            pxs_VarType::pxs_Bool => self.out.push_str(if var.get_bool()? { "true" } else { "false" }),
+            pxs_VarType::pxs_Null => self.out.push_str("null"),
+            pxs_VarType::pxs_String => {
+                let text = unsafe { CStr::from_ptr(var.value.string_val) };
+                match text.to_str() {
+                    Ok(text) => self.string(text),
+                    Err(_) => return pxs_error!("String is not UTF-8"),
+                }
+            }
+            pxs_VarType::pxs_List => {
+                self.out.push('[');
+                for (i, item) in var.get_list().unwrap().vars.iter().enumerate() {
+                    if i > 0 {
+                        self.out.push(',');
+                    }
+                    self.value(item, depth + 1)?;
+                }
+                self.out.push(']');
+            }
+            pxs_VarType::pxs_Map => self.pairs(var.get_map().unwrap().iter(), depth)?,
+            pxs_VarType::pxs_Buffer => {
+                let buffer = var.get_buffer().unwrap();
+                let bytes = unsafe { std::slice::from_raw_parts(buffer.data(), buffer.len()) };
+                self.out.push('[');
+                for (i, b) in bytes.iter().enumerate() {
+                    if i > 0 {
+                        self.out.push(',');
+                    }
+                    let _ = write!(self.out, "{b}");
+                }
+                self.out.push(']');
+            }
+            pxs_VarType::pxs_Proxy => self.value(var.get_proxy().unwrap().target(), depth)?,
+            pxs_VarType::pxs_Object => {
+                let Some(runtime) = self.runtime.clone() else {
+                    return pxs_error!("Encoding a pxs_Object as JSON needs its runtime");
+                };
+                let entries = object_entries(runtime, var)?;
+                self.pairs(entries.iter().map(|(key, value)| (MapKey::Var(key), value)), depth)?;
+            }
+            _ => return pxs_error!("Can not encode a {:#?} as JSON", var.tag),
+        }
+        Ok(())
+    }
+}
+
+/// Encode a `pxs_Var` tree as JSON. `runtime` is used to look into `pxs_Object`s (tables, dicts, JS objects).
+pub fn encode_var(runtime: Option<pxs_Runtime>, var: &pxs_Var) -> PxsRes<String> {
+    let mut encoder = Encoder { runtime, out: String::new() };
+    encoder.value(var, 0)?;
+    Ok(encoder.out)
+}
+
+/// Encode `value` (BORROW) into a JSON `pxs_String`.
+pub(crate) fn encode(rt: pxs_VarT, value: pxs_VarT) -> pxs_VarT {
+    if value.is_null() {
+        return pxs_Var::null_param_ep("value").into_raw();
+    }
+    let runtime = unsafe { pxs_Runtime::from_var_ptr(rt) };
+    match encode_var(runtime, borrow_var!(value)) {
+        Ok(text) => pxs_Var::new_string(text),
+        Err(err) => pxs_Var::new_exception(err),
+    }
+    .into_raw()
+}
+
+/// Decode a JSON `pxs_String` (or `pxs_Buffer` of JSON text), `value` is BORROW.
+pub(crate) fn decode(value: pxs_VarT) -> pxs_VarT {
+    let mut len = 0;
+    let view = pxs_getstrview(value, &mut len);
+    if view.is_null() {
+        return pxs_Var::new_exception("Expected a JSON string").into_raw();
+    }
+    let bytes = unsafe { std::slice::from_raw_parts(view as *const u8, len) };
+    let Ok(text) = std::str::from_utf8(bytes) else {
+        return pxs_Var::new_exception("JSON is not UTF-8").into_raw();
+    };
+    match decode_str(text) {
+        Ok(var) => var,
+        Err(err) => pxs_Var::new_exception(err),
+    }
+    .into_raw()
+}
+
+/// `pxs_json.encode(value)`
+extern "C" fn script_encode(args: pxs_VarT) -> pxs_VarT {
+    encode(pxs_listget(args, 0), pxs_listget(args, 1))
+}
+
+/// `pxs_json.decode(string)`
+extern "C" fn script_decode(args: pxs_VarT) -> pxs_VarT {
+    decode(pxs_listget(args, 1))
+}
+
+/// The `pxs_json` module, added to every state by the runtimes.
+pub(crate) fn module() -> Arc<pxs_Module> {
+    super::shared_module("pxs_json", build)
+}
+
+fn build() -> Arc<pxs_Module> {
+    let mut module = pxs_Module::new("pxs_json".to_string());
+    module.add_callback("encode", "_pxs_jsonencode", lookup_add_function("_pxs_jsonencode", script_encode));
+    module.add_callback("decode", "_pxs_jsondecode", lookup_add_function("_pxs_jsondecode", script_decode));
+    Arc::new(module)
+}
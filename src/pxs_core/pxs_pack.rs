@@ -0,0 +1,411 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+//! Binary `pxs_Var` trees for `pxs_pack`, in MessagePack so other tools can read them.
+//!
+//! Types survive the round trip: `pxs_Int64` uses the signed int formats, `pxs_UInt64` the unsigned ones,
+//! `pxs_Buffer` is `bin` and map keys can be any valid key type. pxs types MessagePack has no format for are
+//! ext types:
+//! - `1` a `pxs_Byte` (fixext 1).
+//! - `2` a `pxs_List` of only `pxs_Byte`s (i.e. `pxs_newbytes`), one byte per item.
+use std::sync::Arc;
+
+use crate::{
+    borrow_var, object_entries, pxs_error, pxs_listget,
+    shared::{
+        PxsRes, PxsResult,
+        func::lookup_add_function,
+        map::MapKey,
+        module::pxs_Module,
+        pxs_Runtime,
+        var::{pxs_Var, pxs_VarBuffer, pxs_VarMap, pxs_VarT, pxs_VarType},
+    },
+};
+use etffi::ptr_magic::PtrMagic;
+
+/// Deeper than this is a error, so cyclic script data can not overflow the stack.
+const MAX_DEPTH: usize = 1024;
+
+const EXT_BYTE: u8 = 1;
+const EXT_BYTES: u8 = 2;
+
+/// Writes MessagePack, looking into `pxs_Object`s through the runtime they came from.
+struct Packer {
+    runtime: Option<pxs_Runtime>,
+    out: Vec<u8>,
+}
+
+impl Packer {
+    /// A marker byte followed by a big endian length, using the smallest of the 8/16/32 bit forms. `fix` is the
+    /// fix form (marker | len) and its limit, if the type has one.
+    fn header(&mut self, len: usize, fix: Option<(u8, usize)>, markers: [u8; 3]) -> PxsRes<()> {
+        match (len, fix) {
+            (len, Some((marker, limit))) if len < limit => self.out.push(marker | len as u8),
+            (0..=0xff, _) if markers[0] != 0 => self.out.extend_from_slice(&[markers[0], len as u8]),
+            (0..=0xffff, _) => {
+                self.out.push(markers[1]);
+                self.out.extend_from_slice(&(len as u16).to_be_bytes());
+            }
+            (0..=0xffff_ffff, _) => {
+                self.out.push(markers[2]);
+                self.out.extend_from_slice(&(len as u32).to_be_bytes());
+            }
+            _ => return pxs_error!("Value is too large to pack ({len} items)"),
+        }
+        Ok(())
+    }
+
+    fn int(&mut self, val: i64) {
+        match val {
+            -32..=127 => self.out.push(val as u8),
+            -128..=127 => self.out.extend_from_slice(&[0xd0, val as u8]),
+            -32768..=32767 => {
+                self.out.push(0xd1);
+                self.out.extend_from_slice(&(val as i16).to_be_bytes());
+            }
+            -2147483648..=2147483647 => {
+                self.out.push(0xd2);
+                self.out.extend_from_slice(&(val as i32).to_be_bytes());
+            }
+            _ => {
+                self.out.push(0xd3);
+                self.out.extend_from_slice(&val.to_be_bytes());
+            }
+        }
+    }
+
+    fn uint(&mut self, val: u64) {
+        match val {
+            0..=0xff => self.out.extend_from_slice(&[0xcc, val as u8]),
+            0..=0xffff => {
+                self.out.push(0xcd);
+                self.out.extend_from_slice(&(val as u16).to_be_bytes());
+            }
+            0..=0xffff_ffff => {
+                self.out.push(0xce);
+                self.out.extend_from_slice(&(val as u32).to_be_bytes());
+            }
+            _ => {
+                self.out.push(0xcf);
+                self.out.extend_from_slice(&val.to_be_bytes());
+            }
+        }
+    }
+
+    fn float(&mut self, val: f64) {
+        // float 32 when nothing is lost, it still unpacks as a `pxs_Float64`.
+        if (val as f32) as f64 == val {
+            self.out.push(0xca);
+            self.out.extend_from_slice(&(val as f32).to_be_bytes());
+        } else {
+            self.out.push(0xcb);
+            self.out.extend_from_slice(&val.to_be_bytes());
+        }
+    }
+
+    fn bytes(&mut self, bytes: &[u8]) -> PxsRes<()> {
+        self.header(bytes.len(), None, [0xc4, 0xc5, 0xc6])?;
+        self.out.extend_from_slice(bytes);
+        Ok(())
+    }
+
+    fn str(&mut self, text: &str) -> PxsRes<()> {
+        self.header(text.len(), Some((0xa0, 32)), [0xd9, 0xda, 0xdb])?;
+        self.out.extend_from_slice(text.as_bytes());
+        Ok(())
+    }
+
+    fn pairs<'v>(&mut self, len: usize, pairs: impl Iterator<Item = (MapKey<'v>, &'v pxs_Var)>, depth: usize) -> PxsRes<()> {
+        self.header(len, Some((0x80, 16)), [0, 0xde, 0xdf])?;
+        for (key, value) in pairs {
+            match key {
+                MapKey::Str(key) => self.str(key.as_str())?,
+                MapKey::Var(key) if is_key(key) => self.value(key, depth + 1)?,
+                MapKey::Var(key) => return pxs_error!("Can not pack a map key of type {:#?}", key.tag),
+            }
+            self.value(value, depth + 1)?;
+        }
+        Ok(())
+    }
+
+    fn value(&mut self, var: &pxs_Var, depth: usize) -> PxsRes<()> {
+        if depth > MAX_DEPTH {
+            return pxs_error!("Value is nested too deep to pack, is it cyclic?");
+        }
+        match var.tag {
+            pxs_VarType::pxs_Null => self.out.push(0xc0),
+            pxs_VarType::pxs_Bool => self.out.push(if var.get_bool()? { 0xc3 } else { 0xc2 }),
+            pxs_VarType::pxs_Int64 => self.int(var.get_i64()?),
+            pxs_VarType::pxs_UInt64 => self.uint(var.get_u64()?),
+            pxs_VarType::pxs_Float64 => self.float(var.get_f64()?),
+            pxs_VarType::pxs_Byte => self.out.extend_from_slice(&[0xd4, EXT_BYTE, var.get_byte()?]),
+            pxs_VarType::pxs_String => self.str(&var.get_string()?)?,
+            pxs_VarType::pxs_Buffer => self.bytes(var.get_buffer().unwrap().as_slice())?,
+            pxs_VarType::pxs_List => {
+                let items = &var.get_list().unwrap().vars;
+                if !items.is_empty() && items.iter().all(|item| item.is_byte()) {
+                    self.header(items.len(), None, [0xc7, 0xc8, 0xc9])?;
+                    self.out.push(EXT_BYTES);
+                    for item in items.iter() {
+                        self.out.push(item.get_byte()?);
+                    }
+                    return Ok(());
+                }
+                self.header(items.len(), Some((0x90, 16)), [0, 0xdc, 0xdd])?;
+                for item in items.iter() {
+                    self.value(item, depth + 1)?;
+                }
+            }
+            pxs_VarType::pxs_Map => {
+                let map = var.get_map().unwrap();
+                self.pairs(map.len(), map.iter(), depth)?;
+            }
+            pxs_VarType::pxs_Proxy => self.value(var.get_proxy().unwrap().target(), depth)?,
+            pxs_VarType::pxs_Object => {
+                let Some(runtime) = self.runtime.clone() else {
+                    return pxs_error!("Packing a pxs_Object needs its runtime");
+                };
+                let entries = object_entries(runtime, var)?;
+                self.pairs(entries.len(), entries.iter().map(|(key, value)| (MapKey::Var(key), value)), depth)?;
+            }
+            _ => return pxs_error!("Can not pack a {:#?}", var.tag),
+        }
+        Ok(())
+    }
+}
+
+/// Types `pxs_VarMap` can hash.
+fn is_key(var: &pxs_Var) -> bool {
+    matches!(
+        var.tag,
+        pxs_VarType::pxs_Int64
+            | pxs_VarType::pxs_UInt64
+            | pxs_VarType::pxs_Float64
+            | pxs_VarType::pxs_Bool
+            | pxs_VarType::pxs_String
+            | pxs_VarType::pxs_Byte
+    )
+}
+
+/// Reads MessagePack front to back.
+struct Unpacker<'a> {
+    data: &'a [u8],
+    at: usize,
+}
+
+impl<'a> Unpacker<'a> {
+    fn take(&mut self, len: usize) -> PxsRes<&'a [u8]> {
+        if self.data.len() - self.at < len {
+            return pxs_error!("Packed data is truncated");
+        }
+        let bytes = &self.data[self.at..self.at + len];
+        self.at += len;
+        Ok(bytes)
+    }
+
+    fn u8(&mut self) -> PxsRes<u8> {
+        Ok(self.take(1)?[0])
+    }
+
+    fn be<const N: usize>(&mut self) -> PxsRes<[u8; N]> {
+        Ok(self.take(N)?.try_into().unwrap())
+    }
+
+    /// A 8/16/32 bit length, `size` bytes.
+    fn len(&mut self, size: usize) -> PxsRes<usize> {
+        Ok(match size {
+            1 => self.u8()? as usize,
+            2 => u16::from_be_bytes(self.be()?) as usize,
+            _ => u32::from_be_bytes(self.be()?) as usize,
+        })
+    }
+
+    fn string(&mut self, len: usize) -> PxsResult {
+        match std::str::from_utf8(self.take(len)?) {
+            Ok(text) => Ok(pxs_Var::new_string(text.to_string())),
+            Err(_) => pxs_error!("Packed string is not UTF-8"),
+        }
+    }
+
+    fn array(&mut self, len: usize, depth: usize) -> PxsResult {
+        // Every item is at least one byte, so a bad length can not make a huge allocation.
+        if len > self.data.len() - self.at {
+            return pxs_error!("Packed data is truncated");
+        }
+        let mut items = Vec::with_capacity(len);
+        for _ in 0..len {
+            items.push(self.value(depth + 1)?);
+        }
+        Ok(pxs_Var::new_list_with(items))
+    }
+
+    fn map(&mut self, len: usize, depth: usize) -> PxsResult {
+        if len > (self.data.len() - self.at) / 2 {
+            return pxs_error!("Packed data is truncated");
+        }
+        let mut map = pxs_VarMap::with_capacity(len);
+        for _ in 0..len {
+            let key = self.value(depth + 1)?;
+            if !is_key(&key) {
+                return pxs_error!("Packed map key of type {:#?} is not a valid key", key.tag);
+            }
+            let value = self.value(depth + 1)?;
+            map.add_item(key, value);
+        }
+        Ok(pxs_Var::new_map_with(map))
+    }
+
+    fn ext(&mut self, len: usize) -> PxsResult {
+        let kind = self.u8()?;
+        let data = self.take(len)?;
+        match (kind, len) {
+            (EXT_BYTE, 1) => Ok(pxs_Var::new_byte(data[0])),
+            (EXT_BYTES, _) => Ok(pxs_Var::new_list_with(data.iter().map(|b| pxs_Var::new_byte(*b)).collect())),
+            _ => pxs_error!("Unknown packed ext type {kind}"),
+        }
+    }
+
+    fn value(&mut self, depth: usize) -> PxsResult {
+        if depth > MAX_DEPTH {
+            return pxs_error!("Packed data is nested too deep");
+        }
+        let marker = self.u8()?;
+        match marker {
+            0x00..=0x7f => Ok(pxs_Var::new_i64(marker as i64)),
+            0x80..=0x8f => self.map((marker & 0x0f) as usize, depth),
+            0x90..=0x9f => self.array((marker & 0x0f) as usize, depth),
+            0xa0..=0xbf => self.string((marker & 0x1f) as usize),
+            0xc0 => Ok(pxs_Var::new_null()),
+            0xc2 => Ok(pxs_Var::new_bool(false)),
+            0xc3 => Ok(pxs_Var::new_bool(true)),
+            0xc4..=0xc6 => {
+                let len = self.len(1 << (marker - 0xc4))?;
+                Ok(pxs_Var::new_buffer(pxs_VarBuffer::from_vec(self.take(len)?.to_vec())))
+            }
+            0xc7..=0xc9 => {
+                let len = self.len(1 << (marker - 0xc7))?;
+                self.ext(len)
+            }
+            0xca => Ok(pxs_Var::new_f64(f32::from_be_bytes(self.be()?) as f64)),
+            0xcb => Ok(pxs_Var::new_f64(f64::from_be_bytes(self.be()?))),
+            0xcc => Ok(pxs_Var::new_u64(self.u8()? as u64)),
+            0xcd => Ok(pxs_Var::new_u64(u16::from_be_bytes(self.be()?) as u64)),
+            0xce => Ok(pxs_Var::new_u64(u32::from_be_bytes(self.be()?) as u64)),
+            0xcf => Ok(pxs_Var::new_u64(u64::from_be_bytes(self.be()?))),
+            0xd0 => Ok(pxs_Var::new_i64(self.u8()? as i8 as i64)),
+            0xd1 => Ok(pxs_Var::new_i64(i16::from_be_bytes(self.be()?) as i64)),
+            0xd2 => Ok(pxs_Var::new_i64(i32::from_be_bytes(self.be()?) as i64)),
+            0xd3 => Ok(pxs_Var::new_i64(i64::from_be_bytes(self.be()?))),
+            0xd4..=0xd8 => self.ext(1 << (marker - 0xd4)),
+            0xd9..=0xdb => {
+                let len = self.len(1 << (marker - 0xd9))?;
+                self.string(len)
+            }
+            0xdc | 0xdd => {
+                let len = self.len(2 << (marker - 0xdc))?;
+                self.array(len, depth)
+            }
+            0xde | 0xdf => {
+                let len = self.len(2 << (marker - 0xde))?;
+                self.map(len, depth)
+            }
+            0xe0..=0xff => Ok(pxs_Var::new_i64(marker as i8 as i64)),
+            _ => pxs_error!("Invalid packed marker 0x{marker:02x}"),
+        }
+    }
+}
+
+/// Pack a `pxs_Var` tree. `runtime` is used to look into `pxs_Object`s (tables, dicts, JS objects).
+pub fn pack_var(runtime: Option<pxs_Runtime>, var: &pxs_Var) -> PxsRes<Vec<u8>> {
+    let mut packer = Packer { runtime, out: Vec::new() };
+    packer.value(var, 0)?;
+    Ok(packer.out)
+}
+
+/// Unpack a tree made by `pack_var` (or any MessagePack without other ext types).
+pub fn unpack_bytes(data: &[u8]) -> PxsResult {
+    let mut unpacker = Unpacker { data, at: 0 };
+    let value = unpacker.value(0)?;
+    if unpacker.at != data.len() {
+        return pxs_error!("Unexpected data after packed value at {}", unpacker.at);
+    }
+    Ok(value)
+}
+
+/// Pack `value` (BORROW) into a `pxs_Buffer`.
+pub(crate) fn pack(rt: pxs_VarT, value: pxs_VarT) -> pxs_VarT {
+    if value.is_null() {
+        return pxs_Var::null_param_ep("value").into_raw();
+    }
+    let runtime = unsafe { pxs_Runtime::from_var_ptr(rt) };
+    match pack_var(runtime, borrow_var!(value)) {
+        Ok(bytes) => pxs_Var::new_buffer(pxs_VarBuffer::from_vec(bytes)),
+        Err(err) => pxs_Var::new_exception(err),
+    }
+    .into_raw()
+}
+
+/// Unpack a `pxs_Buffer`, a `pxs_String` or a `pxs_List` of bytes. `value` is BORROW.
+pub(crate) fn unpack(value: pxs_VarT) -> pxs_VarT {
+    if value.is_null() {
+        return pxs_Var::null_param_ep("value").into_raw();
+    }
+    let var = borrow_var!(value);
+    let res = match var.tag {
+        pxs_VarType::pxs_Buffer => unpack_bytes(var.get_buffer().unwrap().as_slice()),
+        pxs_VarType::pxs_String => match var.get_string() {
+            Ok(text) => unpack_bytes(text.as_bytes()),
+            Err(err) => Err(err),
+        },
+        pxs_VarType::pxs_List => {
+            let bytes: Option<Vec<u8>> = var
+                .get_list()
+                .unwrap()
+                .vars
+                .iter()
+                .map(|item| match item.tag {
+                    pxs_VarType::pxs_Byte => item.get_byte().ok(),
+                    pxs_VarType::pxs_Int64 => item.get_i64().ok().and_then(|b| u8::try_from(b).ok()),
+                    _ => None,
+                })
+                .collect();
+            match bytes {
+                Some(bytes) => unpack_bytes(&bytes),
+                None => pxs_error!("Can only unpack a pxs_List of bytes"),
+            }
+        }
+        _ => pxs_error!("Can not unpack a {:#?}", var.tag),
+    };
+    match res {
+        Ok(var) => var,
+        Err(err) => pxs_Var::new_exception(err),
+    }
+    .into_raw()
+}
+
+/// `pxs_pack.pack(value)`
+extern "C" fn script_pack(args: pxs_VarT) -> pxs_VarT {
+    pack(pxs_listget(args, 0), pxs_listget(args, 1))
+}
+
+/// `pxs_pack.unpack(bytes)`
+extern "C" fn script_unpack(args: pxs_VarT) -> pxs_VarT {
+    unpack(pxs_listget(args, 1))
+}
+
+/// The `pxs_pack` module, added to every state by the runtimes.
+pub(crate) fn module() -> Arc<pxs_Module> {
+    super::shared_module("pxs_pack", build)
+}
+
+fn build() -> Arc<pxs_Module> {
+    let mut module = pxs_Module::new("pxs_pack".to_string());
+    module.add_callback("pack", "_pxs_packpack", lookup_add_function("_pxs_packpack", script_pack));
+    module.add_callback("unpack", "_pxs_packunpack", lookup_add_function("_pxs_packunpack", script_unpack));
+    Arc::new(module)
+}
@@ -126,14 +126,27 @@ pub(super) unsafe extern "C" fn pocketpy_bridge(argc: i32, argv: pocketpy::py_St
         }
     }
 
+    unsafe { call_host(fn_idx, argc - 1, py_get_arg(argv, 1)) }
+}
+
+#[unsafe(no_mangle)]
+/// cbindgen:ignore
+/// This is defined in libs/pxs_python.h
+/// Called by a `pxs_hostfunc`, `argv` are the script args.
+unsafe extern "C" fn pxspython_callhost(idx: i32, argc: i32, argv: pocketpy::py_StackRef) -> bool {
+    unsafe { call_host(idx as i64, argc, argv) }
+}
+
+/// Call host function `fn_idx` with the `argc` args at `argv`, its result goes in `py_retval`.
+unsafe fn call_host(fn_idx: i64, argc: i32, argv: pocketpy::py_StackRef) -> bool {
     // Convert argv into Vec<Var>
-    let mut vars: Vec<pxs_Var> = vec![];
+    let mut vars: Vec<pxs_Var> = Vec::with_capacity(argc as usize + 1);
 
     // Add the runtime
     vars.push(pxs_Var::new_i64(pxs_Runtime::pxs_Python as i64));
 
     // Convert py_Ref into pxs_Var.
-    for i in 1..argc {
+    for i in 0..argc {
         let arg_ref = unsafe { py_get_arg(argv, i as usize) };
         vars.push(pocketpyref_to_var(arg_ref));
     }
@@ -7,18 +7,18 @@
 // Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
 //
 use std::{
-    cell::Cell, collections::{HashMap, HashSet}, sync::LazyLock
+    cell::{Cell, RefCell}, collections::{HashMap, HashSet}, ffi::c_void, sync::{Arc, LazyLock}
 };
 
 use etffi::{borrow_string, create_raw_string, cstring::CStringSafe, free_raw_string, ptr_magic::{PtrMagic, ThreadSafePointer}};
 
 use crate::{
     pxs_debug, pxs_error, python::{
-        func::{get_builtin, pocketpy_bridge, py_assign},
-        module::create_module,
+        func::{get_builtin, pocketpy_bridge, py_assign, py_get_arg},
+        module::{create_module, materialize_module},
         var::{PythonPointer, pocketpyref_to_var, var_to_pocketpyref},
     }, shared::{
-        PixelScript, PxsRes, PxsResult, pxs_Opaque, read_file, read_file_dir, var::{ObjectMethods, pxs_Var, pxs_VarList}
+        PixelScript, PxsRes, PxsResult, alloc::{self, MemAccount, MemStats}, gcstats, intern::{self, pxs_Atom}, module::pxs_Module, profiler, pxs_Opaque, pxs_Runtime, read_file, read_file_dir, snapshot, startup, tracer::{self, pxs_TraceKind}, var::{ObjectMethods, pxs_Var, pxs_VarList, pxs_VarMap}
     }, with_feature
 };
 
@@ -64,6 +64,59 @@ static PYSTATE: LazyLock<ThreadSafePointer<State>> = LazyLock::new(setup_python_
 thread_local! {
     /// Current thread idx
     static THREAD_IDX: Cell<Option<u8>> = Cell::new(None);
+    /// The main thread uses VM 0 without a `THREAD_IDX`, this is true while that VM is detached.
+    static MAIN_DETACHED: Cell<bool> = Cell::new(false);
+    /// Frames of the running code while a call is profiled, pocketpy does not expose `f_back`.
+    static PROFILE_FRAMES: RefCell<Vec<*mut pocketpy::py_Frame>> = const { RefCell::new(vec![]) };
+    /// Objects freed by `garbage_collect` and `gc_step` on this thread, pocketpy keeps its heap counts private.
+    static PY_COLLECTED: Cell<u64> = const { Cell::new(0) };
+}
+
+/// Trace function of profiled calls. Keeps `PROFILE_FRAMES` and takes samples on line events.
+unsafe extern "C" fn profile_trace(frame: *mut pocketpy::py_Frame, event: pocketpy::py_TraceEvent) {
+    PROFILE_FRAMES.with_borrow_mut(|frames| {
+        // Generators leave without a pop event, everything above the frame of a event is gone.
+        let found = frames.iter().rposition(|other| *other == frame);
+        match event {
+            pocketpy::py_TraceEvent::TRACE_EVENT_POP => frames.truncate(found.unwrap_or(frames.len())),
+            _ => match found {
+                Some(idx) => frames.truncate(idx + 1),
+                None => frames.push(frame),
+            },
+        }
+    });
+    if matches!(event, pocketpy::py_TraceEvent::TRACE_EVENT_LINE) {
+        profiler::poll(None);
+    }
+}
+
+/// Push the frames of the running Python code for a profiler sample, outermost first.
+fn profile_frames(out: &mut Vec<String>) {
+    let frames = PROFILE_FRAMES.with_borrow(|frames| frames.clone());
+    let mut cstr_safe = CStringSafe::new();
+    for frame in frames {
+        unsafe {
+            let mut line = 0;
+            let file = pocketpy::py_Frame_sourceloc(frame, &mut line);
+            let file = if file.is_null() { "?".into() } else { std::ffi::CStr::from_ptr(file).to_string_lossy() };
+            let function = pocketpy::py_Frame_function(frame);
+            let mut name = String::from("<module>");
+            if !function.is_null() && pocketpy::py_istype(function, pocketpy::py_PredefinedType::tp_function as pocketpy::py_Type) {
+                // `py_getattr` writes the return register, the running code may be using it.
+                let saved = *pocketpy::py_retval();
+                if pocketpy::py_getattr(function, pocketpy::py_name(cstr_safe.new_string("__name__"))) {
+                    let value = pocketpy::py_tostr(pocketpy::py_retval());
+                    if !value.is_null() {
+                        name = std::ffi::CStr::from_ptr(value).to_string_lossy().into_owned();
+                    }
+                } else {
+                    pocketpy::py_clearexc(std::ptr::null_mut());
+                }
+                *pocketpy::py_retval() = saved;
+            }
+            out.push(format!("{name} ({file})"));
+        }
+    }
 }
 
 /// _pxs_call
@@ -76,7 +129,17 @@ struct State {
     /// Keep a list of defined PixelObject as class
     defined_objects: HashMap<i32, HashSet<String>>,
     /// Thread pool 0-15
-    thread_pool: Vec<ThreadStatus>
+    thread_pool: Vec<ThreadStatus>,
+    /// `__main__` names kept by `reset_globals`, one per VM. Never resized so threads only touch their own.
+    marked_globals: Vec<HashSet<String>>,
+    /// The `pxs_buffer` type of each VM, made in `python_setup`.
+    buffer_types: Vec<pocketpy::py_Type>,
+    /// The `pxs_proxy` type of each VM, made in `python_setup`.
+    proxy_types: Vec<pocketpy::py_Type>,
+    /// The `pxs_hostfunc` type of each VM, made in `python_setup`.
+    hostfunc_types: Vec<pocketpy::py_Type>,
+    /// Host modules of each VM not imported yet, made by `pxspython_lazyimport`. See `module::add_module`.
+    lazy_modules: Vec<HashMap<String, Arc<pxs_Module>>>,
 }
 
 impl State {
@@ -92,7 +155,12 @@ impl State {
 fn new_state() -> *mut State {
     State {
         defined_objects: HashMap::new(),
-        thread_pool: setup_python_thread_pool()
+        thread_pool: setup_python_thread_pool(),
+        marked_globals: (0..16).map(|_| HashSet::new()).collect(),
+        buffer_types: vec![0; 16],
+        proxy_types: vec![0; 16],
+        hostfunc_types: vec![0; 16],
+        lazy_modules: (0..16).map(|_| HashMap::new()).collect(),
     }.into_raw()
 }
 
@@ -108,6 +176,7 @@ fn clear(ptr: *mut State) {
         if let Some(v) = (*ptr).defined_objects.get_mut(&idx) {
             v.clear();
         }
+        (*ptr).lazy_modules[idx as usize].clear();
     }
 }
 
@@ -130,6 +199,46 @@ pub(self) fn exec_py(code: &str, name: &str, module: &str) -> String {
     )
 }
 
+unsafe extern "C" {
+    /// Serialize a code object. Not in pocketpy.h but public in pocketpy.c, it is what `py_compilefile` uses.
+    fn CodeObject__dumps(co: *const c_void, size: *mut i32) -> *mut c_void;
+}
+
+/// Bytecode of `code` compiled in exec mode, from the code cache or compiled and recorded.
+///
+/// None when nothing wants the bytecode or it does not compile (`py_exec` raises the error then).
+fn exec_bytecode(code: &str, name: &str) -> Option<Arc<[u8]>> {
+    if let Some(bytecode) = snapshot::cached_chunk(pxs_Runtime::pxs_Python, name, code) {
+        return Some(bytecode);
+    }
+    if !snapshot::is_recording(pxs_Runtime::pxs_Python) {
+        return None;
+    }
+
+    let c_code = create_raw_string!(code);
+    let c_name = create_raw_string!(name);
+    unsafe {
+        let ok = pocketpy::py_compile(c_code, c_name, pocketpy::py_CompileMode::EXEC_MODE, false);
+        free_raw_string!(c_code);
+        free_raw_string!(c_name);
+        if !ok {
+            pocketpy::py_clearexc(std::ptr::null_mut());
+            return None;
+        }
+
+        let mut size: i32 = 0;
+        let data = CodeObject__dumps(pocketpy::py_touserdata(pocketpy::py_retval()), &mut size);
+        if data.is_null() {
+            return None;
+        }
+        let bytecode: Arc<[u8]> = std::slice::from_raw_parts(data as *const u8, size as usize).into();
+        pocketpy::py_free(data);
+
+        snapshot::record_chunk(pxs_Runtime::pxs_Python, name, code, Arc::clone(&bytecode));
+        Some(bytecode)
+    }
+}
+
 /// Run python code as eval or exec on a optinal module.
 /// If no module is chosen, it defaults to __main__ via pocketpy internals.
 fn run_py(
@@ -138,19 +247,26 @@ fn run_py(
     comp_mode: pocketpy::py_CompileMode,
     module: Option<&str>,
 ) -> String {
+    // Only exec mode code objects can be run from bytecode (`py_execo`).
+    let bytecode = if matches!(comp_mode, pocketpy::py_CompileMode::EXEC_MODE) {
+        exec_bytecode(code, name)
+    } else {
+        None
+    };
     let c_code = create_raw_string!(code);
     let c_name = create_raw_string!(name);
     unsafe {
-        let res = {
-            if let Some(module_name) = module {
-                let c_module = create_raw_string!(module_name);
-                let pymod = pocketpy::py_getmodule(c_module);
-                free_raw_string!(c_module);
-
-                pocketpy::py_exec(c_code, c_name, comp_mode, pymod)
-            } else {
-                pocketpy::py_exec(c_code, c_name, comp_mode, std::ptr::null_mut())
-            }
+        let pymod = if let Some(module_name) = module {
+            let c_module = create_raw_string!(module_name);
+            let pymod = pocketpy::py_getmodule(c_module);
+            free_raw_string!(c_module);
+            pymod
+        } else {
+            std::ptr::null_mut()
+        };
+        let res = match bytecode {
+            Some(bytecode) => pocketpy::py_execo(bytecode.as_ptr() as *const c_void, bytecode.len() as i32, c_name, pymod),
+            None => pocketpy::py_exec(c_code, c_name, comp_mode, pymod),
         };
         free_raw_string!(c_code);
         free_raw_string!(c_name);
@@ -194,31 +310,56 @@ pub(self) fn exec_main_py(code: &str, name: &str) -> String {
     run_py(code, name, pocketpy::py_CompileMode::EXEC_MODE, None)
 }
 
-/// Create a new module and load it with code.
-unsafe fn new_module(code: &str, name: &str) {
-    let cname = create_raw_string!(name);
-    let module = unsafe { pocketpy::py_getmodule(cname) };
-    if !module.is_null() {
-        pxs_debug!("PYTHON module: {name} already exists.");
-        return;
-    }
+/// Get the state of Pocketpy.
+pub(self) fn get_py_state() -> *mut State {
+    PYSTATE.get_ptr()
+}
+
+/// The `pxs_buffer` type of the current VM.
+pub(self) fn buffer_type() -> pocketpy::py_Type {
+    unsafe { (*get_py_state()).buffer_types[get_thread_idx() as usize] }
+}
+
+/// The `pxs_proxy` type of the current VM.
+pub(self) fn proxy_type() -> pocketpy::py_Type {
+    unsafe { (*get_py_state()).proxy_types[get_thread_idx() as usize] }
+}
 
-    let _ = unsafe { pocketpy::py_newmodule(cname) };
+/// The `pxs_hostfunc` type of the current VM.
+pub(self) fn hostfunc_type() -> pocketpy::py_Type {
+    unsafe { (*get_py_state()).hostfunc_types[get_thread_idx() as usize] }
+}
 
-    // Exec the code
-    let err = exec_py(code, format!("<{}>", name).as_str(), name);
-    if !err.is_empty() {
-        panic!("Setting new module error: {err}");
+/// The VM this thread uses, None when it has none.
+fn current_vm() -> Option<usize> {
+    match THREAD_IDX.get() {
+        Some(idx) => Some(idx as usize),
+        // The main thread uses VM 0 without a `THREAD_IDX`.
+        None if !MAIN_DETACHED.get() && get_thread_idx() == 0 => Some(0),
+        None => None,
     }
+}
 
+/// Collect a name from `py_applydict`.
+unsafe extern "C" fn collect_name(name: pocketpy::py_Name, _val: pocketpy::py_Ref, ctx: *mut std::ffi::c_void) -> bool {
     unsafe {
-        free_raw_string!(cname);
+        let names = &mut *(ctx as *mut Vec<String>);
+        names.push(borrow_string!(pocketpy::py_name2str(name)).to_string());
     }
+    true
 }
 
-/// Get the state of Pocketpy.
-pub(self) fn get_py_state() -> *mut State {
-    PYSTATE.get_ptr()
+/// Names defined in `__main__`.
+fn main_names() -> Vec<String> {
+    let mut names = Vec::new();
+    let mut cstr_safe = CStringSafe::new();
+    unsafe {
+        let main = pocketpy::py_getmodule(cstr_safe.new_string(PYTHON_MAIN_MODULE));
+        if !main.is_null() {
+            pocketpy::py_applydict(main, Some(collect_name), &mut names as *mut Vec<String> as *mut std::ffi::c_void);
+        }
+    }
+    names
 }
 
 /// Add a new defined object
@@ -249,6 +390,78 @@ pub(self) fn is_object_defined(name: &str) -> bool {
     }
 }
 
+/// Memory by pocketpy VM, the last one for memory from before any VM.
+static PY_ACCOUNTS: [MemAccount; 17] = [const { MemAccount::new(std::ptr::null_mut()) }; 17];
+
+/// Bytes before every pocketpy allocation: its size and the VM it is counted in. `PK_FREE` has no size.
+const PY_ALLOC_HEADER: usize = 16;
+
+/// The account of the current VM.
+fn current_account() -> usize {
+    let vm = unsafe { pocketpy::py_currentvm() };
+    if vm < 0 { 16 } else { vm as usize }
+}
+
+/// Write the header at `base` and return the memory after it.
+unsafe fn py_alloc_done(base: *mut usize, size: usize, vm: usize) -> *mut core::ffi::c_void {
+    unsafe {
+        base.write(size);
+        base.add(1).write(vm);
+        (base as *mut u8).add(PY_ALLOC_HEADER) as *mut core::ffi::c_void
+    }
+}
+
+#[unsafe(no_mangle)]
+/// cbindgen:ignore
+/// This is defined in libs/pxs_python/pxs_python_alloc.h, pocketpy's `PK_MALLOC`.
+/// pocketpy has no allocator state, so the tag is looked up on every call.
+unsafe extern "C" fn pxspython_malloc(size: usize) -> *mut core::ffi::c_void {
+    let vm = current_account();
+    PY_ACCOUNTS[vm].resize(0, size);
+    unsafe {
+        let base = alloc::raw_realloc(alloc::tag(Some(&pxs_Runtime::pxs_Python)), std::ptr::null_mut(), size + PY_ALLOC_HEADER);
+        if base.is_null() {
+            PY_ACCOUNTS[vm].resize(size, 0);
+            return std::ptr::null_mut();
+        }
+        py_alloc_done(base as *mut usize, size, vm)
+    }
+}
+
+#[unsafe(no_mangle)]
+/// cbindgen:ignore
+/// pocketpy's `PK_REALLOC`.
+unsafe extern "C" fn pxspython_realloc(ptr: *mut core::ffi::c_void, size: usize) -> *mut core::ffi::c_void {
+    if ptr.is_null() {
+        return unsafe { pxspython_malloc(size) };
+    }
+    unsafe {
+        let base = (ptr as *mut u8).sub(PY_ALLOC_HEADER) as *mut usize;
+        let (old, vm) = (base.read(), base.add(1).read());
+        PY_ACCOUNTS[vm].resize(old, size);
+        let base = alloc::raw_realloc(alloc::tag(Some(&pxs_Runtime::pxs_Python)), base as *mut core::ffi::c_void, size + PY_ALLOC_HEADER);
+        if base.is_null() {
+            PY_ACCOUNTS[vm].resize(size, old);
+            return std::ptr::null_mut();
+        }
+        py_alloc_done(base as *mut usize, size, vm)
+    }
+}
+
+#[unsafe(no_mangle)]
+/// cbindgen:ignore
+/// pocketpy's `PK_FREE`.
+unsafe extern "C" fn pxspython_free(ptr: *mut core::ffi::c_void) {
+    if ptr.is_null() {
+        return;
+    }
+    unsafe {
+        let base = (ptr as *mut u8).sub(PY_ALLOC_HEADER) as *mut usize;
+        PY_ACCOUNTS[base.add(1).read()].resize(base.read(), 0);
+        alloc::raw_free(alloc::tag(Some(&pxs_Runtime::pxs_Python)), base as *mut core::ffi::c_void)
+    }
+}
+
 #[unsafe(no_mangle)]
 /// cbindgen:ignore
 /// This is the import overrider
@@ -262,35 +475,47 @@ unsafe extern "C" fn pxspython_importfile(
 
     // Borrow file_path
     let b = borrow_string!(file_path);
-    // Remove .py and check if this is a directory
-    let file_path = {
-        let pos_dir = &b[0..b.len() - 3];
-        let files = read_file_dir(pos_dir);
-
-        if files.contains(&"__import__.py".to_string()) {
-            // Ok just use that then
-            format!("{pos_dir}__import__.py")
-        } else {
-            // No __import__.py so let's see first if there is any .py so we can return a pseudo type
-            for _ in files.iter() {
-                return pocketpy::PXSPYTHON_IS_DIR; // -2 is a specific thingy to return a empty string in C.
+    tracer::span(pxs_TraceKind::pxs_TraceImport, &pxs_Runtime::pxs_Python, b, || {
+        // Remove .py and check if this is a directory
+        let file_path = {
+            let pos_dir = &b[0..b.len() - 3];
+            let files = read_file_dir(pos_dir);
+
+            if files.contains(&"__import__.py".to_string()) {
+                // Ok just use that then
+                format!("{pos_dir}__import__.py")
+            } else {
+                // No __import__.py so let's see first if there is any .py so we can return a pseudo type
+                for _ in files.iter() {
+                    return pocketpy::PXSPYTHON_IS_DIR; // -2 is a specific thingy to return a empty string in C.
+                }
+                b.to_string()
             }
-            b.to_string()
+        };
+
+        let contents = read_file(&file_path);
+        let size = contents.len() as core::ffi::c_int;
+        if size == 0 {
+            return pocketpy::PXSPYTHON_NOT_FOUND;
         }
-    };
+        let raw_contents = create_raw_string!(contents);
 
-    let contents = read_file(&file_path);
-    let size = contents.len() as core::ffi::c_int;
-    if size == 0 {
-        return pocketpy::PXSPYTHON_NOT_FOUND;
-    }
-    let raw_contents = create_raw_string!(contents);
+        unsafe {
+            *buffer = raw_contents;
+        }
 
-    unsafe {
-        *buffer = raw_contents;
-    }
+        size + 1
+    })
+}
 
-    size + 1
+#[unsafe(no_mangle)]
+/// cbindgen:ignore
+/// pocketpy's `lazyimport`, called on imports of modules that do not exist yet. Makes a host module on its first import.
+unsafe extern "C" fn pxspython_lazyimport(path: *const core::ffi::c_char) -> pocketpy::py_GlobalRef {
+    if path.is_null() || !materialize_module(borrow_string!(path)) {
+        return std::ptr::null_mut();
+    }
+    unsafe { pocketpy::py_getmodule(path) }
 }
 
 /// Keep a reference to a python object/function.
@@ -381,6 +606,51 @@ pub(self) fn python_pxs_remove_ref(idx: i32) {
     }
 }
 
+/// `gc.setup_debug_callback` of watched VMs. pocketpy calls it with `"start"` before a collection and `"stop"` (and a
+/// report) after it.
+unsafe extern "C" fn gc_callback(argc: i32, argv: pocketpy::py_StackRef) -> bool {
+    unsafe {
+        if argc >= 1 {
+            let what = borrow_string!(pocketpy::py_tostr(py_get_arg(argv, 0)));
+            let bytes = PY_ACCOUNTS[current_account()].stats().bytes;
+            if what == "start" {
+                gcstats::auto_begin(&pxs_Runtime::pxs_Python, bytes);
+            } else {
+                gcstats::auto_end(&pxs_Runtime::pxs_Python, bytes);
+            }
+        }
+        pocketpy::py_newnone(pocketpy::py_retval());
+    }
+    true
+}
+
+/// Set the `gc.setup_debug_callback` of the current VM to `gc_callback`, or back to None.
+fn watch_vm_gc(enabled: bool) {
+    unsafe {
+        let mut cstr_safe = CStringSafe::new();
+        let gc = pocketpy::py_getmodule(cstr_safe.new_string("gc"));
+        if gc.is_null() {
+            return;
+        }
+        let setup = pocketpy::py_getdict(gc, pocketpy::py_name(cstr_safe.new_string("setup_debug_callback")));
+        if setup.is_null() {
+            return;
+        }
+        let arg = pocketpy::py_pushtmp();
+        if enabled {
+            pocketpy::py_newnativefunc(arg, Some(gc_callback));
+        } else {
+            pocketpy::py_newnone(arg);
+        }
+        if !pocketpy::py_call(setup, 1, arg) {
+            #[allow(unused)]
+            let err = consume_error();
+            pxs_debug!("Err: {err}");
+        }
+        pocketpy::py_pop();
+    }
+}
+
 /// Do some python setup. This needs to be called for every thread too
 unsafe fn python_setup() {
     unsafe {
@@ -392,6 +662,12 @@ unsafe fn python_setup() {
         // Setup module loader.
         let callbacks = pocketpy::py_callbacks();
         (*callbacks).importfile = Some(pocketpy::pxspython_import);
+        (*callbacks).lazyimport = Some(pxspython_lazyimport);
+
+        // Types are per VM and gone after a reset.
+        (*get_py_state()).buffer_types[get_thread_idx() as usize] = pocketpy::pxspython_newbuffertype();
+        (*get_py_state()).proxy_types[get_thread_idx() as usize] = pocketpy::pxspython_newproxytype();
+        (*get_py_state()).hostfunc_types[get_thread_idx() as usize] = pocketpy::pxspython_newhostfunctype();
     }
 
     // Setup some python code
@@ -399,30 +675,46 @@ unsafe fn python_setup() {
     let mut python_code = String::new();
     python_code.push_str(include_str!("../../core/python/main.py"));
 
-    with_feature!("pxs_json", {
-        // Create module
-        unsafe {
-            new_module(include_str!("../../core/python/pxs_json.py"), "pxs_json");
-        }
-        // Import into main
-        python_code.push_str("\nimport pxs_json\n");
+    startup::step(&pxs_Runtime::pxs_Python, "core_modules", || {
+        with_feature!("pxs_json", {
+            // Create module
+            create_module(&crate::pxs_core::pxs_json::module());
+            // Import into main
+            python_code.push_str("\nimport pxs_json\n");
+        });
+        with_feature!("pxs_pack", {
+            create_module(&crate::pxs_core::pxs_pack::module());
+            python_code.push_str("\nimport pxs_pack\n");
+        });
+        with_feature!("pxs_data", {
+            create_module(&crate::pxs_core::pxs_data::module());
+            python_code.push_str("\nimport pxs_data\n");
+        });
     });
 
-    let res = exec_main_py(&python_code, "<python_setup>");
+    let res = startup::step(&pxs_Runtime::pxs_Python, "globals", || {
+        snapshot::core(|| exec_main_py(&python_code, "<python_setup>"))
+    });
     if !res.is_empty() {
         panic!("Python setup error: {res}");
     }
+
+    if gcstats::enabled() {
+        watch_vm_gc(true);
+    }
 }
 
 pub struct PythonScripting;
 
 impl PixelScript for PythonScripting {
     fn start() {
-        let _ = get_py_state();
-        // py initialize here
-        unsafe {
-            pocketpy::py_initialize();
-        }
+        startup::step(&pxs_Runtime::pxs_Python, "vm", || {
+            let _ = get_py_state();
+            // py initialize here
+            unsafe {
+                pocketpy::py_initialize();
+            }
+        });
         // Set the main thread to 0
         THREAD_IDX.set(Some(0));
         init();
@@ -437,7 +729,7 @@ impl PixelScript for PythonScripting {
     }
 
     fn add_module(source: std::sync::Arc<crate::shared::module::pxs_Module>) {
-        create_module(&source);
+        module::add_module(source);
     }
 
     fn execute(code: &str, file_name: &str) -> PxsResult {
@@ -490,6 +782,92 @@ impl PixelScript for PythonScripting {
         }
     }
 
+    fn detach_thread() -> pxs_Opaque {
+        // The VM index plus one, null when this thread has no VM.
+        let idx = current_vm().map_or(0, |idx| idx + 1);
+        if idx == 1 {
+            MAIN_DETACHED.set(true);
+        }
+        THREAD_IDX.set(None);
+        idx as pxs_Opaque
+    }
+
+    fn attach_thread(state: pxs_Opaque) {
+        let idx = state as usize;
+        if idx == 0 {
+            THREAD_IDX.set(None);
+            return;
+        }
+        let idx = idx - 1;
+        unsafe {
+            pocketpy::py_switchvm(idx as i32);
+        }
+        if idx == 0 {
+            MAIN_DETACHED.set(false);
+            THREAD_IDX.set(None);
+        } else {
+            THREAD_IDX.set(Some(idx as u8));
+        }
+    }
+
+    fn arm_budget(budget: &crate::shared::budget::Budget) {
+        // pocketpy has no instruction hook, only its watchdog (CPU time).
+        if budget.millis > 0 {
+            unsafe {
+                pocketpy::py_watchdog_begin(budget.millis as i64);
+            }
+        }
+        // Samples come from the trace function instead.
+        if crate::shared::budget::is_profiled(&pxs_Runtime::pxs_Python) {
+            PROFILE_FRAMES.with_borrow_mut(|frames| frames.clear());
+            unsafe {
+                pocketpy::py_sys_settrace(Some(profile_trace), true);
+            }
+        }
+    }
+
+    fn disarm_budget() {
+        unsafe {
+            pocketpy::py_watchdog_end();
+            if crate::shared::budget::is_profiled(&pxs_Runtime::pxs_Python) {
+                pocketpy::py_sys_settrace(None, true);
+                PROFILE_FRAMES.with_borrow_mut(|frames| frames.clear());
+            }
+        }
+    }
+
+    fn profile_stack(frames: &mut Vec<String>) {
+        profile_frames(frames);
+    }
+
+    fn mark_globals() {
+        let Some(idx) = current_vm() else {
+            return;
+        };
+        let state = get_py_state();
+        unsafe {
+            (*state).marked_globals[idx] = main_names().into_iter().collect();
+        }
+    }
+
+    fn reset_globals() {
+        let Some(idx) = current_vm() else {
+            return;
+        };
+        let state = get_py_state();
+        let mut cstr_safe = CStringSafe::new();
+        unsafe {
+            let marked = &(*state).marked_globals[idx];
+            let main = pocketpy::py_getmodule(cstr_safe.new_string(PYTHON_MAIN_MODULE));
+            for name in main_names() {
+                if !marked.contains(&name) {
+                    pocketpy::py_deldict(main, pocketpy::py_name(cstr_safe.new_string(&name)));
+                }
+            }
+            pocketpy::py_gc_collect();
+        }
+    }
+
     fn clear() {
         let state = get_py_state();
         clear(state);
@@ -499,6 +877,27 @@ impl PixelScript for PythonScripting {
         init();
     }
 
+    fn reload_module(name: &str) -> PxsResult {
+        let mut cstr_safe = CStringSafe::new();
+        unsafe {
+            let c_name = cstr_safe.new_string(name);
+            let module = pocketpy::py_getmodule(c_name);
+            // Runs the new code in the same module object (RELOAD_MODE), so `sys.modules` and importers keep it.
+            let ok = if module.is_null() {
+                match pocketpy::py_import(c_name) {
+                    0 => return pxs_error!("{name} was not found."),
+                    res => res == 1,
+                }
+            } else {
+                pocketpy::py_importlib_reload(module)
+            };
+            if !ok {
+                return pxs_error!("{}", consume_error());
+            }
+        }
+        Ok(pxs_Var::new_null())
+    }
+
     fn eval(code: &str, name: &str) -> PxsResult {
         let res = eval_main_py(code, name);
         if res.is_empty() {
@@ -638,10 +1037,50 @@ impl PixelScript for PythonScripting {
         }
     }
 
+    fn runtime_stats(stats: &mut pxs_VarMap) {
+        let state = get_py_state();
+        let vm = get_thread_idx();
+        unsafe {
+            let defined = (*state).defined_objects.get(&vm).map_or(0, |objects| objects.len());
+            let active = (0..(*state).thread_pool.len())
+                .filter(|i| (*state).get_thread_status(*i) == ThreadStatus::Occupied)
+                .count();
+            stats.add_str("vm", pxs_Var::new_i64(vm as i64));
+            stats.add_str("vms_active", pxs_Var::new_i64(active as i64));
+            stats.add_str("defined_objects", pxs_Var::new_i64(defined as i64));
+        }
+        stats.add_str("objects_collected", pxs_Var::new_i64(PY_COLLECTED.get() as i64));
+    }
+
     fn garbage_collect() {
         unsafe {
-            pocketpy::py_gc_collect();
+            PY_COLLECTED.set(PY_COLLECTED.get() + pocketpy::py_gc_collect().max(0) as u64);
         }
+        PY_ACCOUNTS[current_account()].collected();
+    }
+
+    fn gc_step(_budget: std::time::Duration) -> bool {
+        // pocketpy only has a full mark and sweep.
+        Self::garbage_collect();
+        true
+    }
+
+    fn set_auto_gc(enabled: bool) {
+        let code = if enabled { "__import__('gc').enable()" } else { "__import__('gc').disable()" };
+        let _ = run_py(code, "<pxs_gc>", pocketpy::py_CompileMode::EVAL_MODE, None);
+    }
+
+    fn mem_stats() -> MemStats {
+        PY_ACCOUNTS[current_account()].stats()
+    }
+
+    fn set_mem_limit(_bytes: usize) -> bool {
+        // pocketpy does not check for NULL from `PK_MALLOC`, failing it would crash the process.
+        false
+    }
+
+    fn watch_gc(enabled: bool) {
+        watch_vm_gc(enabled);
     }
 }
 
@@ -654,6 +1093,49 @@ fn add_args(args: &Vec<pxs_Var>) {
     }
 }
 
+/// `getattr` on a Python object var.
+fn get_attr(var: &pxs_Var, py_key: pocketpy::py_Name) -> PxsResult {
+    unsafe {
+        if var.value.object_val.is_null() {
+            return pxs_error!("var.value.object_val is Null");
+        }
+        // Deref
+        let python_pointer = PythonPointer::from_borrow_void(var.get_object_ptr());
+        let object = python_pointer.get_ptr();
+        let res = pocketpy::py_getattr(object, py_key);
+
+        if !res {
+            return Ok(pxs_Var::new_exception(consume_error()));
+        }
+
+        let py_res = pocketpy::py_retval();
+        // Get value
+        Ok(pocketpyref_to_var(py_res))
+    }
+}
+
+/// `setattr` on a Python object var.
+fn set_attr(var: &pxs_Var, py_key: pocketpy::py_Name, value: &pxs_Var) -> PxsRes<()> {
+    unsafe {
+        if var.value.object_val.is_null() {
+            return pxs_error!("var.value.object_val is Null");
+        }
+
+        // Deref
+        let object = PythonPointer::from_borrow_void(var.get_object_ptr()).get_ptr();
+        // Set
+        let tmp = pocketpy::py_pushtmp();
+        var_to_pocketpyref(tmp, value, None);
+        let res = pocketpy::py_setattr(object, py_key, tmp);
+
+        if !res {
+            return pxs_error!("{}", consume_error());
+        }
+
+        Ok(())
+    }
+}
+
 impl ObjectMethods for PythonScripting {
     fn object_call(
         var: &crate::shared::var::pxs_Var,
@@ -793,51 +1275,32 @@ impl ObjectMethods for PythonScripting {
     }
 
     fn get(var: &pxs_Var, key: &str) -> PxsResult {
-        unsafe {
-            if var.value.object_val.is_null() {
-                return pxs_error!("var.value.object_val is Null");
-            }
-            // Deref
-            let python_pointer = PythonPointer::from_borrow_void(var.get_object_ptr());
-            let object = python_pointer.get_ptr();
-            let raw_key = create_raw_string!(key);
-            let py_key = pocketpy::py_name(raw_key);
-            free_raw_string!(raw_key);
-            let res = pocketpy::py_getattr(object, py_key);
-
-            if !res {
-                return Ok(pxs_Var::new_exception(consume_error()));
-            }
-
-            let py_res = pocketpy::py_retval();
-            // Get value
-            Ok(pocketpyref_to_var(py_res))
-        }
+        let raw_key = create_raw_string!(key);
+        let py_key = unsafe { pocketpy::py_name(raw_key) };
+        unsafe { free_raw_string!(raw_key) };
+        get_attr(var, py_key)
     }
 
     fn set(var: &pxs_Var, key: &str, value: &pxs_Var) -> PxsRes<()> {
-        unsafe {
-            if var.value.object_val.is_null() {
-                return pxs_error!("var.value.object_val is Null");
-            }
-
-            // Deref
-            let object = PythonPointer::from_borrow_void(var.get_object_ptr()).get_ptr();
-            // Key
-            let raw_key = create_raw_string!(key);
-            let py_key = pocketpy::py_name(raw_key);
-            free_raw_string!(raw_key);
-            // Set
-            let tmp = pocketpy::py_pushtmp();
-            var_to_pocketpyref(tmp, value, None);
-            let res = pocketpy::py_setattr(object, py_key, tmp);
+        let raw_key = create_raw_string!(key);
+        let py_key = unsafe { pocketpy::py_name(raw_key) };
+        unsafe { free_raw_string!(raw_key) };
+        set_attr(var, py_key, value)
+    }
 
-            if !res {
-                return pxs_error!("{}", consume_error());
-            }
+    fn get_atom(var: &pxs_Var, key: pxs_Atom) -> PxsResult {
+        // Interned names are already C strings, no copy.
+        let Some(name) = intern::c_name(key) else {
+            return pxs_error!("Unknown atom: {key}");
+        };
+        get_attr(var, unsafe { pocketpy::py_name(name.as_ptr()) })
+    }
 
-            Ok(())
-        }
+    fn set_atom(var: &pxs_Var, key: pxs_Atom, value: &pxs_Var) -> PxsRes<()> {
+        let Some(name) = intern::c_name(key) else {
+            return pxs_error!("Unknown atom: {key}");
+        };
+        set_attr(var, unsafe { pocketpy::py_name(name.as_ptr()) }, value)
     }
 
     fn get_from_name(name: &str) -> PxsResult {
@@ -875,4 +1338,34 @@ impl ObjectMethods for PythonScripting {
             Ok(pocketpyref_to_var(py_ref))
         }
     }
+
+    fn entries(var: &pxs_Var) -> PxsRes<Vec<(pxs_Var, pxs_Var)>> {
+        unsafe {
+            if !var.is_object() || var.value.object_val.is_null() {
+                return pxs_error!("Var is not a Python object");
+            }
+            let object = PythonPointer::from_borrow_void(var.get_object_ptr()).get_ptr();
+            if object.is_null() || pocketpy::py_typeof(object) as i32 != pocketpy::py_PredefinedType::tp_dict as i32 {
+                return pxs_error!("Only a Python dict has entries");
+            }
+            // Converting values registers them, which overwrites `py_retval`.
+            let dict = pocketpy::py_pushtmp();
+            py_assign(dict, object);
+
+            let mut entries: Vec<(pxs_Var, pxs_Var)> = Vec::with_capacity(pocketpy::py_dict_len(dict) as usize);
+            let ok = pocketpy::py_dict_apply(dict, Some(collect_entry), &mut entries as *mut Vec<(pxs_Var, pxs_Var)> as *mut c_void);
+            pocketpy::py_pop();
+            if !ok {
+                return pxs_error!("{}", consume_error());
+            }
+            Ok(entries)
+        }
+    }
+}
+
+/// `py_dict_apply` callback of `PythonScripting::entries`.
+unsafe extern "C" fn collect_entry(key: pocketpy::py_Ref, val: pocketpy::py_Ref, ctx: *mut c_void) -> bool {
+    let entries = unsafe { &mut *(ctx as *mut Vec<(pxs_Var, pxs_Var)>) };
+    entries.push((pocketpyref_to_var(key), pocketpyref_to_var(val)));
+    true
 }
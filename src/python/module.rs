@@ -10,10 +10,41 @@ use etffi::cstring::CStringSafe;
 //
 use crate::{
     python::{
-        PXS_CALL_METHOD, exec_py, pocketpy, pocketpy_bridge, var_to_pocketpyref
+        PXS_CALL_METHOD, get_py_state, get_thread_idx, hostfunc_type, pocketpy, pocketpy_bridge, var_to_pocketpyref
+    },
+    shared::{
+        module::pxs_Module,
+        pxs_Runtime,
+        tracer::{self, pxs_TraceKind},
     },
-    shared::module::pxs_Module,
 };
+use std::sync::Arc;
+
+/// Add `module` to the current VM. It is made on its first import (`pxspython_lazyimport`), with its submodules.
+///
+/// A module that already exists (a host object made it, or it was added before) is added to right away, imports
+/// find it without asking.
+pub(super) fn add_module(module: Arc<pxs_Module>) {
+    let mut cstr_safe = CStringSafe::new();
+    let exists = unsafe { !pocketpy::py_getmodule(cstr_safe.new_string(&module.name)).is_null() };
+    if exists {
+        create_module(&module);
+        return;
+    }
+    unsafe {
+        (*get_py_state()).lazy_modules[get_thread_idx() as usize].insert(module.name.clone(), module);
+    }
+}
+
+/// Make the module `name` of `add_module` if it was not imported yet. False when there is no such module waiting.
+pub(super) fn materialize_module(name: &str) -> bool {
+    let module = unsafe { (*get_py_state()).lazy_modules[get_thread_idx() as usize].remove(name) };
+    let Some(module) = module else {
+        return false;
+    };
+    tracer::span(pxs_TraceKind::pxs_TraceImport, &pxs_Runtime::pxs_Python, name, || create_module(&module));
+    true
+}
 
 pub(super) fn create_module(module: &pxs_Module) {
     // Get module name
@@ -51,34 +82,21 @@ pub(super) fn create_module(module: &pxs_Module) {
         }
     }
 
-    // Bind a single function for the module
-    let module_function_name = PXS_CALL_METHOD;
-
+    // Bind a single function for the module, the methods of its objects call it.
     unsafe {
-        pocketpy::py_bindfunc(pymodule, cstr_safe.new_string(module_function_name), Some(pocketpy_bridge));
+        pocketpy::py_bindfunc(pymodule, cstr_safe.new_string(PXS_CALL_METHOD), Some(pocketpy_bridge));
     }
 
-    let mut methods = String::new();
-
-    // Add callbacks to module... This also needs to go through the pybridge
+    // One `pxs_hostfunc` per callback, all called through the same native `__call__`. No Python code is made.
     for method in module.callbacks.iter() {
-        let bridge_code = format!(
-            r#"
-def {}(*args):
-    return {module_function_name}({}, *args)
-"#,
-            method.name, method.idx
-        );
-        methods.push_str(&bridge_code);
+        unsafe {
+            let tmp = pocketpy::py_pushtmp();
+            pocketpy::pxspython_newhostfunc(tmp, hostfunc_type(), method.idx);
+            pocketpy::py_setattr(pymodule, pocketpy::py_name(cstr_safe.new_string(&method.name)), tmp);
+            pocketpy::py_pop();
+        }
     }
 
-    // Run bridge_code in current module
-    exec_py(
-        &methods,
-        format!("<{}>", module_name).as_str(),
-        &module_name,
-    );
-
     // Do the same for internal modules
     for im in module.modules.iter() {
         create_module(im);
@@ -12,8 +12,9 @@ use etffi::cstring::CStringSafe;
 
 use crate::{
     pxs_debug, python::{
-        PXS_CALL_METHOD, add_new_defined_object, eval_py, exec_py, func::get_from_obj, is_object_defined, pocketpy, pocketpy_bridge
-    }, shared::{object::{ObjectFlags, pxs_PixelObject}}
+        PXS_CALL_METHOD, add_new_defined_object, eval_py, exec_py, func::get_from_obj, is_object_defined,
+        module::materialize_module, pocketpy, pocketpy_bridge, var::var_to_pocketpyref
+    }, shared::{object::{ObjectFlags, pxs_PixelObject}, utils::create_private_name}
 };
 
 /// Create a object type in the Python Runtime.
@@ -28,7 +29,8 @@ pub(super) fn create_object(idx: i32, source: Arc<pxs_PixelObject>, module_name:
     unsafe {
         let c_module_name = cstr_safe.new_string(&rmodule_name.clone());
         let pymodule = pocketpy::py_getmodule(c_module_name);
-        if pymodule.is_null() {
+        // A host module not imported yet is made whole, a import would not make it after this.
+        if pymodule.is_null() && !materialize_module(&rmodule_name) {
             pocketpy::py_newmodule(c_module_name);
         }
     }
@@ -60,7 +62,7 @@ pub(super) fn create_object(idx: i32, source: Arc<pxs_PixelObject>, module_name:
     // Object does not exist
     // First register callbacks
     let mut methods_str = String::new();
-    for method in source.callbacks.iter() {
+    for method in source.callbacks().iter() {
         // Check input type
         let input = if method.flags & ObjectFlags::UsesId as u8 != 0 {
             "._pxs_ptr"
@@ -89,6 +91,18 @@ pub(super) fn create_object(idx: i32, source: Arc<pxs_PixelObject>, module_name:
         }
     }
 
+    // Read only fields are properties without a setter, over a class attribute set below.
+    for field in source.fields().iter().filter(|field| !field.writable) {
+        methods_str.push_str(&format!(
+            r#"
+    @property
+    def {}(self):
+        return self.{}
+"#,
+            field.name, create_private_name(&field.name)
+        ));
+    }
+
     let object_string = format!(
         r#"
 # Bridge for pocketpy
@@ -114,6 +128,21 @@ class _{}:
         return;
     }
 
+    // Fields are class attributes, assigning a writable one gives the instance its own.
+    unsafe {
+        let pymodule = pocketpy::py_getmodule(cstr_safe.new_string(&rmodule_name));
+        let class = pocketpy::py_getdict(pymodule, pocketpy::py_name(cstr_safe.new_string(&format!("_{object_name}"))));
+        if !class.is_null() {
+            for field in source.fields().iter() {
+                let name = if field.writable { field.name.clone() } else { create_private_name(&field.name) };
+                let tmp = pocketpy::py_pushtmp();
+                var_to_pocketpyref(tmp, &field.var, Some(&rmodule_name));
+                pocketpy::py_setdict(class, pocketpy::py_name(cstr_safe.new_string(&name)), tmp);
+                pocketpy::py_pop();
+            }
+        }
+    }
+
     // add it
     add_new_defined_object(&object_name);
 
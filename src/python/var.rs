@@ -15,12 +15,52 @@ use etffi::{borrow_string, create_raw_string, free_raw_string, ptr_magic::PtrMag
 
 use crate::{
     pxs_debug, python::{
-        consume_error, func::{get_string_from_obj, py_assign}, object::create_object, pocketpy::{self}, python_pxs_get_register, python_pxs_new_register, python_pxs_remove_ref
+        buffer_type, consume_error, func::{get_string_from_obj, py_assign}, hostfunc_type, object::create_object, pocketpy::{self}, proxy_type, python_pxs_get_register, python_pxs_new_register, python_pxs_remove_ref
     }, shared::{
-        object::get_object, pxs_Runtime, var::{pxs_Var, pxs_VarObject, pxs_VarType}
+        map::MapKey, object::get_object, pxs_Opaque, pxs_Runtime, var::{pxs_Var, pxs_VarBuffer, pxs_VarObject, pxs_VarProxy, pxs_VarType}
     }
 };
 
+#[unsafe(no_mangle)]
+/// cbindgen:ignore
+/// This is defined in libs/pxs_python.h
+/// Called when a `pxs_buffer` is collected.
+unsafe extern "C" fn pxspython_releasebuffer(handle: pxs_Opaque) {
+    unsafe { pxs_VarBuffer::release_handle(handle) };
+}
+
+#[unsafe(no_mangle)]
+/// cbindgen:ignore
+/// This is defined in libs/pxs_python.h
+/// Called when a `pxs_proxy` is collected.
+unsafe extern "C" fn pxspython_releaseproxy(handle: pxs_Opaque) {
+    unsafe { pxs_VarProxy::release_handle(handle) };
+}
+
+#[unsafe(no_mangle)]
+/// cbindgen:ignore
+/// This is defined in libs/pxs_python.h
+unsafe extern "C" fn pxspython_proxylen(handle: pxs_Opaque) -> i32 {
+    unsafe { pxs_VarProxy::from_handle(handle) }.len() as i32
+}
+
+#[unsafe(no_mangle)]
+/// cbindgen:ignore
+/// This is defined in libs/pxs_python.h
+/// `__getitem__` of a `pxs_proxy`, converts only the item asked for.
+unsafe extern "C" fn pxspython_proxyget(handle: pxs_Opaque, key: pocketpy::py_Ref, out: pocketpy::py_Ref) -> i32 {
+    let proxy = unsafe { pxs_VarProxy::from_handle(handle) };
+    let key = pocketpyref_to_var(key);
+    match proxy.get(&key) {
+        Some(item) => {
+            var_to_pocketpyref(out, item, None);
+            1
+        }
+        None if proxy.target().is_list() => -1,
+        None => 0,
+    }
+}
+
 /// Wrap a pointer with a Box!
 /// 
 /// This makes it possible to keep references to fun
@@ -141,11 +181,23 @@ pub(super) fn pocketpyref_to_var(pref: pocketpy::py_Ref) -> pxs_Var {
         unsafe{ pocketpy::py_pop(); }
         
         pxs_Var::new_list_with(vars)
-    } else if tp == pocketpy::py_PredefinedType::tp_function as i32 {
+    } else if tp == pocketpy::py_PredefinedType::tp_function as i32 || tp == hostfunc_type() as i32 {
         pxs_Var::new_function(unsafe { make_python_pointer(pref).into_raw() as *mut c_void }, Some(free_py_mem))
     } else if tp == pocketpy::py_PredefinedType::tp_Exception as i32 {
         let msg = consume_error();
         pxs_Var::new_exception(msg)
+    } else if tp == pocketpy::py_PredefinedType::tp_bytes as i32 {
+        // Copied, `bytes` are owned by pocketpy.
+        let mut size = 0;
+        let data = unsafe { pocketpy::py_tobytes(pref, &mut size) };
+        let bytes = if data.is_null() { vec![] } else { unsafe { std::slice::from_raw_parts(data, size as usize) }.to_vec() };
+        pxs_Var::new_buffer(pxs_VarBuffer::from_vec(bytes))
+    } else if tp == buffer_type() as i32 {
+        // Back to the same memory.
+        unsafe { pxs_Var::new_buffer(pxs_VarBuffer::from_handle(pocketpy::pxspython_tobuffer(pref, buffer_type()))) }
+    } else if tp == proxy_type() as i32 {
+        // Back to the same container.
+        unsafe { pxs_Var::new_proxy(pxs_VarProxy::from_handle(pocketpy::pxspython_toproxy(pref, proxy_type()))) }
     } 
     else {
         unsafe {
@@ -287,27 +339,27 @@ pub(super) fn var_to_pocketpyref(out: pocketpy::py_Ref, var: &pxs_Var, module_na
                 // New dict
                 pocketpy::py_newdict(out);
                 let map = var.get_map().unwrap();
-                let keys = map.keys();
-                for k in keys {
-                    let item = map.get_item(k);
-                    if let Some(item) = item {
-                        // Ok we can add this jaunt now
-                        let py_key = pocketpy::py_pushtmp();
-                        var_to_pocketpyref(py_key, k, module_name);
-                        let py_value = pocketpy::py_pushtmp();
-                        var_to_pocketpyref(py_value, item, module_name);
-
-                        let ok = pocketpy::py_dict_setitem(out, py_key, py_value);
-                        if !ok {
-                            #[allow(unused)]
-                            let err = consume_error();
-                            pxs_debug!("Map to Python error: {err}");
-                        }
+                for (k, item) in map.iter() {
+                    // Ok we can add this jaunt now
+                    let py_key = pocketpy::py_pushtmp();
+                    match k {
+                        // Already nul terminated.
+                        MapKey::Str(k) => pocketpy::py_newstr(py_key, k.as_ptr()),
+                        MapKey::Var(k) => var_to_pocketpyref(py_key, k, module_name),
+                    }
+                    let py_value = pocketpy::py_pushtmp();
+                    var_to_pocketpyref(py_value, item, module_name);
 
-                        // Pop stack (2)
-                        pocketpy::py_pop();
-                        pocketpy::py_pop();
+                    let ok = pocketpy::py_dict_setitem(out, py_key, py_value);
+                    if !ok {
+                        #[allow(unused)]
+                        let err = consume_error();
+                        pxs_debug!("Map to Python error: {err}");
                     }
+
+                    // Pop stack (2)
+                    pocketpy::py_pop();
+                    pocketpy::py_pop();
                 }
 
                 // All good dayo!
@@ -315,6 +367,13 @@ pub(super) fn var_to_pocketpyref(out: pocketpy::py_Ref, var: &pxs_Var, module_na
             pxs_VarType::pxs_Byte => {
                 pocketpy::py_newint(out, var.get_byte().unwrap() as i64);
             }
+            pxs_VarType::pxs_Buffer => {
+                let buffer = var.get_buffer().unwrap();
+                pocketpy::pxspython_newbuffer(out, buffer_type(), buffer.data(), buffer.len() as i32, buffer.into_handle());
+            }
+            pxs_VarType::pxs_Proxy => {
+                pocketpy::pxspython_newproxy(out, proxy_type(), var.get_proxy().unwrap().into_handle());
+            }
         }
     }
 }
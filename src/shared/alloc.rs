@@ -0,0 +1,254 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+use std::{
+    cell::Cell,
+    ffi::c_void,
+    sync::atomic::{AtomicBool, AtomicPtr, AtomicU64, AtomicUsize, Ordering},
+};
+
+use crate::shared::{pxs_Opaque, pxs_Runtime};
+
+#[allow(non_camel_case_types)]
+/// Allocate `size` bytes (`ptr` is NULL) or resize `ptr` to `size` bytes, like `realloc`.
+///
+/// Must return memory aligned like `malloc` does (16 bytes on 64 bit), or NULL when out of memory.
+/// `tag` is the one given for the runtime that allocates, see `pxs_setalloctag`.
+pub type pxs_AllocFn = unsafe extern "C" fn(tag: pxs_Opaque, ptr: *mut c_void, size: usize) -> *mut c_void;
+
+#[allow(non_camel_case_types)]
+/// Free memory from `pxs_AllocFn`. `ptr` is never NULL.
+pub type pxs_FreeFn = unsafe extern "C" fn(tag: pxs_Opaque, ptr: *mut c_void);
+
+unsafe extern "C" {
+    fn realloc(ptr: *mut c_void, size: usize) -> *mut c_void;
+    fn free(ptr: *mut c_void);
+}
+
+/// Set by `pxs_setalloc` and `pxs_setfree`, null for the C allocator.
+static ALLOC: AtomicPtr<c_void> = AtomicPtr::new(std::ptr::null_mut());
+static FREE: AtomicPtr<c_void> = AtomicPtr::new(std::ptr::null_mut());
+/// The tag of memory that no runtime owns (pxs_Var nodes, ...).
+static DEFAULT_TAG: AtomicPtr<c_void> = AtomicPtr::new(std::ptr::null_mut());
+/// By runtime, null to use `DEFAULT_TAG`.
+static TAGS: [AtomicPtr<c_void>; 4] = [const { AtomicPtr::new(std::ptr::null_mut()) }; 4];
+
+pub(crate) fn set_alloc(alloc: Option<pxs_AllocFn>, tag: pxs_Opaque) {
+    ALLOC.store(alloc.map_or(std::ptr::null_mut(), |f| f as *mut c_void), Ordering::Release);
+    DEFAULT_TAG.store(tag, Ordering::Release);
+}
+
+pub(crate) fn set_free(free: Option<pxs_FreeFn>) {
+    FREE.store(free.map_or(std::ptr::null_mut(), |f| f as *mut c_void), Ordering::Release);
+}
+
+pub(crate) fn set_tag(runtime: &pxs_Runtime, tag: pxs_Opaque) {
+    TAGS[runtime.into_i64() as usize].store(tag, Ordering::Release);
+}
+
+/// Are both hooks set? Backends only route to the host when they are.
+pub(crate) fn has_hooks() -> bool {
+    !ALLOC.load(Ordering::Acquire).is_null() && !FREE.load(Ordering::Acquire).is_null()
+}
+
+/// The tag for memory of `runtime`, or the default one. Backends take it once when making their state.
+pub(crate) fn tag(runtime: Option<&pxs_Runtime>) -> pxs_Opaque {
+    let tag = runtime.map_or(std::ptr::null_mut(), |rt| TAGS[rt.into_i64() as usize].load(Ordering::Acquire));
+    if tag.is_null() { DEFAULT_TAG.load(Ordering::Acquire) } else { tag }
+}
+
+/// `realloc` through the host allocator, or the C one without both hooks.
+pub(crate) unsafe fn raw_realloc(tag: pxs_Opaque, ptr: *mut c_void, size: usize) -> *mut c_void {
+    unsafe {
+        if !has_hooks() {
+            return realloc(ptr, size);
+        }
+        std::mem::transmute::<*mut c_void, pxs_AllocFn>(ALLOC.load(Ordering::Acquire))(tag, ptr, size)
+    }
+}
+
+/// `free` through the host allocator, or the C one without both hooks.
+pub(crate) unsafe fn raw_free(tag: pxs_Opaque, ptr: *mut c_void) {
+    if ptr.is_null() {
+        return;
+    }
+    unsafe {
+        if !has_hooks() {
+            return free(ptr);
+        }
+        std::mem::transmute::<*mut c_void, pxs_FreeFn>(FREE.load(Ordering::Acquire))(tag, ptr)
+    }
+}
+
+/// What `pxs_memstats` reports of one language state.
+pub struct MemStats {
+    /// Bytes the state has allocated right now.
+    pub bytes: usize,
+    /// Most bytes it ever had at once.
+    pub peak: usize,
+    /// The limit from `pxs_setmemlimit`, 0 for none.
+    pub limit: usize,
+    /// Full collections run through `pxs_garbagecollect` or finished by `pxs_gcstep`.
+    pub gc_cycles: u64,
+}
+
+thread_local! {
+    /// New blocks and bytes grown by every language state on this thread, see `thread_allocs`.
+    static THREAD_ALLOCS: Cell<(u64, u64)> = const { Cell::new((0, 0)) };
+}
+
+/// New blocks allocated and bytes grown, by all language states of this thread so far. Only goes up, take the
+/// difference around what is measured.
+pub(crate) fn thread_allocs() -> (u64, u64) {
+    THREAD_ALLOCS.get()
+}
+
+/// Memory of one language state, counted by its allocator.
+pub(crate) struct MemAccount {
+    /// The allocator tag the state was made with.
+    tag: AtomicPtr<c_void>,
+    bytes: AtomicUsize,
+    peak: AtomicUsize,
+    limit: AtomicUsize,
+    /// Is `limit` checked right now? See `set_checked`.
+    checked: AtomicBool,
+    gc_cycles: AtomicU64,
+}
+
+impl MemAccount {
+    pub const fn new(tag: pxs_Opaque) -> MemAccount {
+        MemAccount {
+            tag: AtomicPtr::new(tag),
+            bytes: AtomicUsize::new(0),
+            peak: AtomicUsize::new(0),
+            limit: AtomicUsize::new(0),
+            checked: AtomicBool::new(true),
+            gc_cycles: AtomicU64::new(0),
+        }
+    }
+
+    pub fn tag(&self) -> pxs_Opaque {
+        self.tag.load(Ordering::Relaxed)
+    }
+
+    /// Count an allocation going from `old` to `new` bytes. False, and nothing counted, if it would go over the limit.
+    ///
+    /// Only one thread allocates for a state at a time, so plain loads and stores are enough.
+    pub fn resize(&self, old: usize, new: usize) -> bool {
+        let bytes = self.bytes.load(Ordering::Relaxed);
+        let bytes = if new > old {
+            let bytes = bytes + (new - old);
+            let limit = self.limit.load(Ordering::Relaxed);
+            if limit > 0 && bytes > limit && self.checked.load(Ordering::Relaxed) {
+                return false;
+            }
+            if bytes > self.peak.load(Ordering::Relaxed) {
+                self.peak.store(bytes, Ordering::Relaxed);
+            }
+            let (blocks, grown) = THREAD_ALLOCS.get();
+            THREAD_ALLOCS.set((blocks + (old == 0) as u64, grown + (new - old) as u64));
+            bytes
+        } else {
+            bytes.saturating_sub(old - new)
+        };
+        self.bytes.store(bytes, Ordering::Relaxed);
+        true
+    }
+
+    /// 0 for no limit.
+    pub fn set_limit(&self, limit: usize) {
+        self.limit.store(limit, Ordering::Relaxed);
+    }
+
+    /// Check the limit in `resize` or not, returning the old setting. Allocations that are not checked are still
+    /// counted, the next checked one fails while the state is over the limit.
+    pub fn set_checked(&self, checked: bool) -> bool {
+        self.checked.swap(checked, Ordering::Relaxed)
+    }
+
+    /// A full collection ran.
+    pub fn collected(&self) {
+        self.gc_cycles.fetch_add(1, Ordering::Relaxed);
+    }
+
+    pub fn stats(&self) -> MemStats {
+        MemStats {
+            bytes: self.bytes.load(Ordering::Relaxed),
+            peak: self.peak.load(Ordering::Relaxed),
+            limit: self.limit.load(Ordering::Relaxed),
+            gc_cycles: self.gc_cycles.load(Ordering::Relaxed),
+        }
+    }
+}
+
+/// Alignment the host allocator guarantees, larger ones are aligned by hand.
+#[cfg(feature = "host_alloc")]
+const HOST_ALIGN: usize = 16;
+
+/// The Rust allocator (pxs_Var, lookups, strings, ...) with the `host_alloc` feature.
+///
+/// Memory from before the hooks were set would go to the wrong free, so they must be set before any other pxs_ call.
+#[cfg(feature = "host_alloc")]
+struct HostAlloc;
+
+#[cfg(feature = "host_alloc")]
+use std::alloc::GlobalAlloc;
+
+#[cfg(feature = "host_alloc")]
+unsafe impl GlobalAlloc for HostAlloc {
+    unsafe fn alloc(&self, layout: std::alloc::Layout) -> *mut u8 {
+        unsafe {
+            if !has_hooks() {
+                return std::alloc::System.alloc(layout);
+            }
+            if layout.align() <= HOST_ALIGN {
+                return raw_realloc(tag(None), std::ptr::null_mut(), layout.size()) as *mut u8;
+            }
+            // Room to align and to keep the real pointer right before the aligned one.
+            let base = raw_realloc(tag(None), std::ptr::null_mut(), layout.size() + layout.align()) as *mut u8;
+            if base.is_null() {
+                return base;
+            }
+            let aligned = base.add(layout.align() - (base as usize % layout.align()));
+            (aligned as *mut *mut u8).sub(1).write(base);
+            aligned
+        }
+    }
+
+    unsafe fn dealloc(&self, ptr: *mut u8, layout: std::alloc::Layout) {
+        unsafe {
+            if !has_hooks() {
+                return std::alloc::System.dealloc(ptr, layout);
+            }
+            let base = if layout.align() <= HOST_ALIGN { ptr } else { (ptr as *mut *mut u8).sub(1).read() };
+            raw_free(tag(None), base as *mut c_void);
+        }
+    }
+
+    unsafe fn realloc(&self, ptr: *mut u8, layout: std::alloc::Layout, new_size: usize) -> *mut u8 {
+        unsafe {
+            if !has_hooks() {
+                return std::alloc::System.realloc(ptr, layout, new_size);
+            }
+            if layout.align() <= HOST_ALIGN {
+                return raw_realloc(tag(None), ptr as *mut c_void, new_size) as *mut u8;
+            }
+            let new_layout = std::alloc::Layout::from_size_align_unchecked(new_size, layout.align());
+            let new = self.alloc(new_layout);
+            if !new.is_null() {
+                std::ptr::copy_nonoverlapping(ptr, new, layout.size().min(new_size));
+                self.dealloc(ptr, layout);
+            }
+            new
+        }
+    }
+}
+
+#[cfg(feature = "host_alloc")]
+#[global_allocator]
+static GLOBAL: HostAlloc = HostAlloc;
@@ -2,16 +2,26 @@ use etffi::{free_raw_string, ptr_magic::PtrMagic};
 
 use crate::{shared::{var::{pxs_Var, pxs_VarT}}};
 
+/// Bytes in one string chunk of an arena. Longer strings get a chunk of their own.
+const ARENA_CHUNK: usize = 4096;
+
 #[allow(non_camel_case_types)]
 /// A memory arena for `pxs_Var`s.
+///
+/// Strings made with `pxs_arena_newstr` are carved from chunks the arena keeps until it is freed,
+/// `pxs_arenareset` only rewinds them.
 pub struct pxs_PixelArena {
     vars: Vec<pxs_VarT>,
-    strings: Vec<*mut core::ffi::c_char>
+    strings: Vec<*mut core::ffi::c_char>,
+    chunks: Vec<Box<[u8]>>,
+    /// The chunk being carved and how much of it is used.
+    chunk: usize,
+    offset: usize,
 }
 
 impl pxs_PixelArena {
     pub fn new() -> pxs_PixelArena {
-        pxs_PixelArena { vars: Vec::new(), strings: Vec::new() }
+        pxs_PixelArena { vars: Vec::new(), strings: Vec::new(), chunks: Vec::new(), chunk: 0, offset: 0 }
     }
 
     /// Add a new `pxs_Var` for arena tracking
@@ -24,7 +34,18 @@ impl pxs_PixelArena {
         if idx >= self.vars.len() as u32 {
             return;
         }
-        self.vars.remove(idx as usize);
+        self.vars.swap_remove(idx as usize);
+    }
+
+    /// Stop tracking `var`, the caller owns it again. Returns false when it is not in the arena.
+    pub fn take(&mut self, var: pxs_VarT) -> bool {
+        // Recent vars are the ones usually taken back.
+        if let Some(idx) = self.vars.iter().rposition(|v| *v == var) {
+            self.vars.swap_remove(idx);
+            true
+        } else {
+            false
+        }
     }
 
     /// Get number of items currently in PixelArena
@@ -36,24 +57,57 @@ impl pxs_PixelArena {
     pub fn alloc_str(&mut self, string: *mut core::ffi::c_char) {
         self.strings.push(string);
     }
-}
 
-impl PtrMagic for pxs_PixelArena {}
+    /// `len` bytes from the chunks, adding a chunk when the rest are full.
+    fn carve(&mut self, len: usize) -> *mut u8 {
+        while self.chunk < self.chunks.len() {
+            if self.chunks[self.chunk].len() - self.offset >= len {
+                let ptr = unsafe { self.chunks[self.chunk].as_mut_ptr().add(self.offset) };
+                self.offset += len;
+                return ptr;
+            }
+            self.chunk += 1;
+            self.offset = 0;
+        }
+        self.chunks.push(vec![0u8; len.max(ARENA_CHUNK)].into_boxed_slice());
+        self.chunk = self.chunks.len() - 1;
+        self.offset = len;
+        self.chunks[self.chunk].as_mut_ptr()
+    }
 
-impl Drop for pxs_PixelArena {
-    fn drop(&mut self) {
+    /// Copy `string` into the arena.
+    pub fn new_str(&mut self, string: &core::ffi::CStr) -> *mut core::ffi::c_char {
+        let bytes = string.to_bytes_with_nul();
+        let ptr = self.carve(bytes.len());
+        unsafe { std::ptr::copy_nonoverlapping(bytes.as_ptr(), ptr, bytes.len()) };
+        ptr as *mut core::ffi::c_char
+    }
+
+    /// Free everything in the arena but keep its memory for the next vars and strings.
+    ///
+    /// Var nodes go back to this threads pool, so the `pxs_new*` calls that follow reuse them.
+    pub fn reset(&mut self) {
         #[cfg(feature = "pxs-debug")] {
             let count = self.vars.len();
             crate::pxs_debug!("Dropping {count} number of vars");
         }
-        for v in self.vars.drain(0..self.vars.len()) {
-            let _ = pxs_Var::from_raw(v);
+        for v in self.vars.drain(..) {
+            let _ = pxs_Var::from_pooled_raw(v);
         }
-        self.vars.clear();
 
-        for s in self.strings.drain(0..self.strings.len()) {
+        for s in self.strings.drain(..) {
             unsafe { free_raw_string!(s) };
         }
-        self.strings.clear();
+
+        self.chunk = 0;
+        self.offset = 0;
+    }
+}
+
+impl PtrMagic for pxs_PixelArena {}
+
+impl Drop for pxs_PixelArena {
+    fn drop(&mut self) {
+        self.reset();
     }
 }
@@ -0,0 +1,107 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+use std::{
+    cell::Cell,
+    time::{Duration, Instant},
+};
+
+use crate::shared::{PixelScript, profiler, pxs_Runtime};
+
+/// Message of the exception a call gets when it runs out of budget.
+pub const BUDGET_EXCEEDED: &str = "Execution budget exceeded";
+
+/// Limits of one top level call into a runtime, set by `pxs_setbudget`. 0 means no limit.
+#[derive(Clone, Copy, Default)]
+pub struct Budget {
+    /// VM instructions. Checked in steps, so a call can run over by up to one step.
+    pub instructions: u64,
+    /// Milliseconds since the call started.
+    pub millis: u64,
+}
+
+impl Budget {
+    pub fn is_unlimited(&self) -> bool {
+        self.instructions == 0 && self.millis == 0
+    }
+}
+
+/// A budgeted (or profiled) call that is running.
+#[derive(Clone, Copy)]
+struct Scope {
+    budget: Budget,
+    start: Instant,
+    used: u64,
+    profiled: bool,
+}
+
+thread_local! {
+    /// By runtime.
+    static BUDGETS: Cell<[Budget; 4]> = Cell::new([Budget::default(); 4]);
+    /// By runtime, the outermost budgeted call on this thread. Calls nested in it share its budget.
+    static SCOPES: Cell<[Option<Scope>; 4]> = Cell::new([None; 4]);
+}
+
+/// Set the budget of `runtime` on this thread.
+pub(crate) fn set_budget(runtime: &pxs_Runtime, budget: Budget) {
+    let mut budgets = BUDGETS.get();
+    budgets[runtime.into_i64() as usize] = budget;
+    BUDGETS.set(budgets);
+}
+
+/// Run `f`, a call into backend `B`, under the budget of `runtime`.
+///
+/// The budget hooks also take the samples of `profiler`, so a call is armed when the profiler runs too.
+pub(crate) fn scoped<B: PixelScript, R>(runtime: &pxs_Runtime, f: impl FnOnce() -> R) -> R {
+    #[cfg(feature = "pxs_trace")]
+    let _trace = super::trace::enter(runtime);
+    let idx = runtime.into_i64() as usize;
+    let budget = BUDGETS.get()[idx];
+    let profiled = profiler::running();
+    if (budget.is_unlimited() && !profiled) || SCOPES.get()[idx].is_some() {
+        return f();
+    }
+
+    set_scope(idx, Some(Scope { budget, start: Instant::now(), used: 0, profiled }));
+    if profiled {
+        profiler::enter(runtime.clone(), B::profile_stack);
+    }
+    B::arm_budget(&budget);
+    let res = f();
+    B::disarm_budget();
+    if profiled {
+        profiler::exit();
+    }
+    set_scope(idx, None);
+    res
+}
+
+/// Is the running call of `runtime` profiled?
+pub(crate) fn is_profiled(runtime: &pxs_Runtime) -> bool {
+    SCOPES.get()[runtime.into_i64() as usize].is_some_and(|scope| scope.profiled)
+}
+
+fn set_scope(idx: usize, scope: Option<Scope>) {
+    let mut scopes = SCOPES.get();
+    scopes[idx] = scope;
+    SCOPES.set(scopes);
+}
+
+/// Count `instructions` against the running call of `runtime`. True once it is over budget.
+pub(crate) fn charge(runtime: &pxs_Runtime, instructions: u64) -> bool {
+    let idx = runtime.into_i64() as usize;
+    let mut scopes = SCOPES.get();
+    let Some(scope) = scopes[idx].as_mut() else {
+        return false;
+    };
+    scope.used += instructions;
+    let over = (scope.budget.instructions > 0 && scope.used > scope.budget.instructions)
+        || (scope.budget.millis > 0 && scope.start.elapsed() > Duration::from_millis(scope.budget.millis));
+    SCOPES.set(scopes);
+    over
+}
@@ -0,0 +1,451 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+//! Column views (`pxs_newcolumns`): named typed fields over host memory, one host object for all rows.
+//!
+//! Scripts read and write a field of one row (`get`/`set`) or a range of rows in one call (`read`/`write`/`fill`),
+//! instead of a host object with property callbacks per entity.
+use std::{
+    cell::RefCell,
+    ffi::{CStr, c_char, c_void},
+    sync::Arc,
+};
+
+use crate::{
+    pxs_error, pxs_gettype, pxs_newhost,
+    shared::{
+        PxsRes, PxsResult, pxs_Opaque,
+        func::{FunctionCall, lookup_add_call, lookup_is, pxs_FuncV},
+        object::{ObjectFlags, pxs_PixelClass, pxs_PixelObject},
+        var::{pxs_DeleterFn, pxs_Var, pxs_VarBuffer, pxs_VarT, pxs_VarType},
+    },
+};
+use etffi::ptr_magic::PtrMagic;
+
+/// Type tag of column views. Below the tags `pxs::type::new_type_tag` hands out.
+const COLUMNS_TYPE: i32 = (1 << 16) - 1;
+
+const TYPE_NAME: &str = "pxs_Columns";
+
+#[repr(C)]
+#[derive(Debug, Clone, Copy, PartialEq)]
+#[allow(non_camel_case_types)]
+/// The element type of a `pxs_Column`.
+pub enum pxs_ColumnType {
+    pxs_ColF32,
+    pxs_ColF64,
+    pxs_ColI32,
+    pxs_ColU32,
+    pxs_ColI64,
+    pxs_ColU8,
+}
+
+impl pxs_ColumnType {
+    /// Size of one element in bytes.
+    pub fn size(self) -> usize {
+        match self {
+            Self::pxs_ColF32 | Self::pxs_ColI32 | Self::pxs_ColU32 => 4,
+            Self::pxs_ColF64 | Self::pxs_ColI64 => 8,
+            Self::pxs_ColU8 => 1,
+        }
+    }
+}
+
+#[repr(C)]
+#[allow(non_camel_case_types)]
+/// One named field of `pxs_newcolumns`. Row `i` is at `data + i * stride`, a `stride` of 0 means packed (a plain
+/// array). Use the struct size as the stride for a field of a array of structs.
+pub struct pxs_Column {
+    pub name: *const c_char,
+    pub kind: pxs_ColumnType,
+    pub data: pxs_Opaque,
+    pub stride: usize,
+}
+
+struct Column {
+    name: String,
+    kind: pxs_ColumnType,
+    data: *mut u8,
+    stride: usize,
+}
+
+/// A number from a script, before it is stored as the column type.
+#[derive(Clone, Copy)]
+enum Num {
+    Int(i64),
+    Float(f64),
+}
+
+impl Num {
+    fn from_var(var: &pxs_Var) -> Option<Self> {
+        match var.tag {
+            pxs_VarType::pxs_Int64 | pxs_VarType::pxs_Bool => var.as_i64().map(Self::Int),
+            pxs_VarType::pxs_Byte => var.get_byte().ok().map(|val| Self::Int(val as i64)),
+            pxs_VarType::pxs_UInt64 => var.get_u64().ok().map(|val| Self::Int(i64::try_from(val).unwrap_or(i64::MAX))),
+            pxs_VarType::pxs_Float64 => var.get_f64().ok().map(Self::Float),
+            _ => None,
+        }
+    }
+}
+
+/// Integers saturate, floats are rounded first (`as` saturates and makes NaN 0).
+macro_rules! store_int {
+    ($num:expr, $t:ty) => {
+        match $num {
+            Num::Int(val) => val.clamp(<$t>::MIN as i64, <$t>::MAX as i64) as $t,
+            Num::Float(val) => val.round() as $t,
+        }
+    };
+}
+
+macro_rules! store_float {
+    ($num:expr, $t:ty) => {
+        match $num {
+            Num::Int(val) => val as $t,
+            Num::Float(val) => val as $t,
+        }
+    };
+}
+
+impl Column {
+    fn at(&self, row: usize) -> *mut u8 {
+        unsafe { self.data.add(row * self.stride) }
+    }
+
+    /// The value of `row`, which must be in range.
+    fn get(&self, row: usize) -> pxs_Var {
+        let ptr = self.at(row);
+        unsafe {
+            match self.kind {
+                pxs_ColumnType::pxs_ColF32 => pxs_Var::new_f64((ptr as *const f32).read_unaligned() as f64),
+                pxs_ColumnType::pxs_ColF64 => pxs_Var::new_f64((ptr as *const f64).read_unaligned()),
+                pxs_ColumnType::pxs_ColI32 => pxs_Var::new_i64((ptr as *const i32).read_unaligned() as i64),
+                pxs_ColumnType::pxs_ColU32 => pxs_Var::new_i64((ptr as *const u32).read_unaligned() as i64),
+                pxs_ColumnType::pxs_ColI64 => pxs_Var::new_i64((ptr as *const i64).read_unaligned()),
+                pxs_ColumnType::pxs_ColU8 => pxs_Var::new_i64(*ptr as i64),
+            }
+        }
+    }
+
+    /// Store `num` at `row`, which must be in range.
+    fn set(&self, row: usize, num: Num) {
+        let ptr = self.at(row);
+        unsafe {
+            match self.kind {
+                pxs_ColumnType::pxs_ColF32 => (ptr as *mut f32).write_unaligned(store_float!(num, f32)),
+                pxs_ColumnType::pxs_ColF64 => (ptr as *mut f64).write_unaligned(store_float!(num, f64)),
+                pxs_ColumnType::pxs_ColI32 => (ptr as *mut i32).write_unaligned(store_int!(num, i32)),
+                pxs_ColumnType::pxs_ColU32 => (ptr as *mut u32).write_unaligned(store_int!(num, u32)),
+                pxs_ColumnType::pxs_ColI64 => (ptr as *mut i64).write_unaligned(store_int!(num, i64)),
+                pxs_ColumnType::pxs_ColU8 => *ptr = store_int!(num, u8),
+            }
+        }
+    }
+
+    /// Copy `rows` into `out`, packed.
+    fn copy_out(&self, start: usize, rows: usize, out: &mut Vec<u8>) {
+        let size = self.kind.size();
+        if self.stride == size {
+            out.extend_from_slice(unsafe { std::slice::from_raw_parts(self.at(start), rows * size) });
+            return;
+        }
+        for row in start..start + rows {
+            out.extend_from_slice(unsafe { std::slice::from_raw_parts(self.at(row), size) });
+        }
+    }
+
+    /// Copy packed `bytes` into the rows from `start`.
+    fn copy_in(&self, start: usize, bytes: &[u8]) {
+        let size = self.kind.size();
+        if self.stride == size {
+            unsafe { std::ptr::copy(bytes.as_ptr(), self.at(start), bytes.len()) };
+            return;
+        }
+        for (i, value) in bytes.chunks_exact(size).enumerate() {
+            unsafe { std::ptr::copy_nonoverlapping(value.as_ptr(), self.at(start + i), size) };
+        }
+    }
+}
+
+/// What a column view holds. `owner` is given to `free` when the view is collected.
+struct Columns {
+    count: usize,
+    columns: Vec<Column>,
+    owner: pxs_Opaque,
+    free: Option<pxs_DeleterFn>,
+}
+
+impl PtrMagic for Columns {}
+
+impl Drop for Columns {
+    fn drop(&mut self) {
+        if let Some(free) = self.free {
+            unsafe { free(self.owner) };
+        }
+    }
+}
+
+impl Columns {
+    /// The column of a name or index arg.
+    fn column(&self, arg: Option<&pxs_Var>) -> PxsRes<&Column> {
+        let Some(arg) = arg else {
+            return pxs_error!("Expected a field name or index");
+        };
+        if arg.is_string() {
+            let name = arg.get_string()?;
+            return match self.columns.iter().find(|column| column.name == name) {
+                Some(column) => Ok(column),
+                None => pxs_error!("No field named {name}"),
+            };
+        }
+        match arg.as_i64().and_then(|idx| usize::try_from(idx).ok()).and_then(|idx| self.columns.get(idx)) {
+            Some(column) => Ok(column),
+            None => pxs_error!("Expected a field name or index"),
+        }
+    }
+
+    /// A row arg, negative ones count from the end.
+    fn row(&self, arg: Option<&pxs_Var>) -> PxsRes<usize> {
+        let Some(index) = arg.and_then(|arg| arg.as_i64()) else {
+            return pxs_error!("Expected a row index");
+        };
+        let row = if index < 0 { index + self.count as i64 } else { index };
+        if row < 0 || row >= self.count as i64 {
+            return pxs_error!("Row {index} is out of range for {} rows", self.count);
+        }
+        Ok(row as usize)
+    }
+
+    /// The optional `start` and `count` args, `count` stops at the end.
+    fn range(&self, start: Option<&pxs_Var>, count: Option<&pxs_Var>) -> PxsRes<(usize, usize)> {
+        let start = match start.filter(|arg| !arg.is_null()) {
+            Some(arg) => match arg.as_i64() {
+                Some(start) if start >= 0 && start as usize <= self.count => start as usize,
+                _ => return pxs_error!("Start is out of range for {} rows", self.count),
+            },
+            None => 0,
+        };
+        let rest = self.count - start;
+        let count = match count.filter(|arg| !arg.is_null()) {
+            Some(arg) => match arg.as_i64() {
+                Some(count) if count >= 0 => (count as usize).min(rest),
+                _ => return pxs_error!("Count can not be negative"),
+            },
+            None => rest,
+        };
+        Ok((start, count))
+    }
+}
+
+/// The view and its args from a method call, `argv[0]` is the view.
+fn this<'a>(rt: pxs_VarT, argc: i32, argv: *mut pxs_VarT) -> PxsRes<(&'a Columns, Vec<&'a pxs_Var>)> {
+    if argc < 1 || argv.is_null() {
+        return pxs_error!("Expected a column view");
+    }
+    let argv = unsafe { std::slice::from_raw_parts(argv, argc as usize) };
+    let columns = pxs_gettype(rt, argv[0], COLUMNS_TYPE) as *mut Columns;
+    if columns.is_null() {
+        return pxs_error!("Expected a column view");
+    }
+    let args = argv[1..].iter().map(|arg| unsafe { &**arg }).collect();
+    Ok((unsafe { &*columns }, args))
+}
+
+/// Run a method, errors become exceptions.
+fn method(rt: pxs_VarT, argc: i32, argv: *mut pxs_VarT, body: impl FnOnce(&Columns, &[&pxs_Var]) -> PxsResult) -> pxs_VarT {
+    match this(rt, argc, argv).and_then(|(columns, args)| body(columns, &args)) {
+        Ok(var) => var,
+        Err(err) => pxs_Var::new_exception(err),
+    }
+    .into_raw()
+}
+
+/// `view.len()` the number of rows.
+extern "C" fn columns_len(rt: pxs_VarT, argc: i32, argv: *mut pxs_VarT) -> pxs_VarT {
+    method(rt, argc, argv, |columns, _| Ok(pxs_Var::new_i64(columns.count as i64)))
+}
+
+/// `view.fields()` the field names in order.
+extern "C" fn columns_fields(rt: pxs_VarT, argc: i32, argv: *mut pxs_VarT) -> pxs_VarT {
+    method(rt, argc, argv, |columns, _| {
+        let names = columns.columns.iter().map(|column| pxs_Var::new_string(column.name.clone())).collect();
+        Ok(pxs_Var::new_list_with(names))
+    })
+}
+
+/// `view.get(field, row)`
+extern "C" fn columns_get(rt: pxs_VarT, argc: i32, argv: *mut pxs_VarT) -> pxs_VarT {
+    method(rt, argc, argv, |columns, args| {
+        let column = columns.column(args.first().copied())?;
+        let row = columns.row(args.get(1).copied())?;
+        Ok(column.get(row))
+    })
+}
+
+/// `view.set(field, row, value)`
+extern "C" fn columns_set(rt: pxs_VarT, argc: i32, argv: *mut pxs_VarT) -> pxs_VarT {
+    method(rt, argc, argv, |columns, args| {
+        let column = columns.column(args.first().copied())?;
+        let row = columns.row(args.get(1).copied())?;
+        let Some(num) = args.get(2).and_then(|arg| Num::from_var(arg)) else {
+            return pxs_error!("Expected a number");
+        };
+        column.set(row, num);
+        Ok(pxs_Var::new_null())
+    })
+}
+
+/// `view.read(field, start?, count?)` a list of the values.
+extern "C" fn columns_read(rt: pxs_VarT, argc: i32, argv: *mut pxs_VarT) -> pxs_VarT {
+    method(rt, argc, argv, |columns, args| {
+        let column = columns.column(args.first().copied())?;
+        let (start, count) = columns.range(args.get(1).copied(), args.get(2).copied())?;
+        let values = (start..start + count).map(|row| column.get(row)).collect();
+        Ok(pxs_Var::new_list_with(values))
+    })
+}
+
+/// `view.read_bytes(field, start?, count?)` the packed values as a buffer.
+extern "C" fn columns_read_bytes(rt: pxs_VarT, argc: i32, argv: *mut pxs_VarT) -> pxs_VarT {
+    method(rt, argc, argv, |columns, args| {
+        let column = columns.column(args.first().copied())?;
+        let (start, count) = columns.range(args.get(1).copied(), args.get(2).copied())?;
+        let mut bytes = Vec::with_capacity(count * column.kind.size());
+        column.copy_out(start, count, &mut bytes);
+        Ok(pxs_Var::new_buffer(pxs_VarBuffer::from_vec(bytes)))
+    })
+}
+
+/// `view.write(field, start, values)` a list of numbers, or a buffer of packed values.
+extern "C" fn columns_write(rt: pxs_VarT, argc: i32, argv: *mut pxs_VarT) -> pxs_VarT {
+    method(rt, argc, argv, |columns, args| {
+        let column = columns.column(args.first().copied())?;
+        let (start, rest) = columns.range(args.get(1).copied(), None)?;
+        let Some(values) = args.get(2) else {
+            return pxs_error!("Expected a list or buffer of values");
+        };
+
+        if let Some(buffer) = values.get_buffer() {
+            let bytes = buffer.as_slice();
+            let size = column.kind.size();
+            if bytes.len() % size != 0 || bytes.len() / size > rest {
+                return pxs_error!("Buffer of {} bytes does not fit {rest} rows of {size} bytes", bytes.len());
+            }
+            column.copy_in(start, bytes);
+            return Ok(pxs_Var::new_null());
+        }
+
+        let Some(list) = values.get_list() else {
+            return pxs_error!("Expected a list or buffer of values");
+        };
+        if list.len() > rest {
+            return pxs_error!("{} values do not fit {rest} rows", list.len());
+        }
+        // Check every value before writing any.
+        let nums: Option<Vec<Num>> = list.vars.iter().map(Num::from_var).collect();
+        let Some(nums) = nums else {
+            return pxs_error!("Values must all be numbers");
+        };
+        for (i, num) in nums.into_iter().enumerate() {
+            column.set(start + i, num);
+        }
+        Ok(pxs_Var::new_null())
+    })
+}
+
+/// `view.fill(field, value, start?, count?)`
+extern "C" fn columns_fill(rt: pxs_VarT, argc: i32, argv: *mut pxs_VarT) -> pxs_VarT {
+    method(rt, argc, argv, |columns, args| {
+        let column = columns.column(args.first().copied())?;
+        let Some(num) = args.get(1).and_then(|arg| Num::from_var(arg)) else {
+            return pxs_error!("Expected a number");
+        };
+        let (start, count) = columns.range(args.get(2).copied(), args.get(3).copied())?;
+        for row in start..start + count {
+            column.set(row, num);
+        }
+        Ok(pxs_Var::new_null())
+    })
+}
+
+const METHODS: [(&str, pxs_FuncV); 8] = [
+    ("len", columns_len),
+    ("fields", columns_fields),
+    ("get", columns_get),
+    ("set", columns_set),
+    ("read", columns_read),
+    ("read_bytes", columns_read_bytes),
+    ("write", columns_write),
+    ("fill", columns_fill),
+];
+
+thread_local! {
+    /// The class of column views and the id of its first method, for the current function lookup.
+    static CLASS: RefCell<Option<(i32, Arc<pxs_PixelClass>)>> = const { RefCell::new(None) };
+}
+
+/// The class of column views. Made again when the function lookup changed (`pxs_clear`, another context).
+fn class() -> Arc<pxs_PixelClass> {
+    let first_name = format!("_{TYPE_NAME}{}", METHODS[0].0);
+    CLASS.with(|cached| {
+        let mut cached = cached.borrow_mut();
+        if let Some((first, class)) = cached.as_ref() {
+            if lookup_is(*first, &first_name) {
+                return Arc::clone(class);
+            }
+        }
+
+        let mut class = pxs_PixelClass::new(TYPE_NAME, COLUMNS_TYPE);
+        let mut first = -1;
+        for (name, callback) in METHODS {
+            let full_name = format!("_{TYPE_NAME}{name}");
+            let idx = lookup_add_call(&full_name, FunctionCall::Frame(callback));
+            if first < 0 {
+                first = idx;
+            }
+            class.add_callback(name, &full_name, idx, ObjectFlags::UsesId as u8);
+        }
+        let class = Arc::new(class);
+        *cached = Some((first, Arc::clone(&class)));
+        class
+    })
+}
+
+unsafe extern "C" fn free_columns(ptr: *mut c_void) {
+    let _ = Columns::from_raw(ptr as *mut Columns);
+}
+
+/// A view of `count` rows of `columns`. `free(owner)` is called when it is collected, or right away on errors.
+pub fn new_columns(count: usize, columns: &[pxs_Column], owner: pxs_Opaque, free: Option<pxs_DeleterFn>) -> pxs_VarT {
+    // Owns `owner` from here on.
+    let mut view = Columns { count, columns: Vec::with_capacity(columns.len()), owner, free };
+    for column in columns {
+        if column.name.is_null() {
+            return pxs_Var::null_param_ep("column name").into_raw();
+        }
+        let name = match unsafe { CStr::from_ptr(column.name) }.to_str() {
+            Ok(name) => name.to_string(),
+            Err(err) => return pxs_Var::new_exception(err).into_raw(),
+        };
+        let size = column.kind.size();
+        let stride = if column.stride == 0 { size } else { column.stride };
+        if stride < size {
+            return pxs_Var::new_exception(format!("Stride of {name} is smaller than its type")).into_raw();
+        }
+        if column.data.is_null() && count > 0 {
+            return pxs_Var::null_param_ep(format!("{name} data")).into_raw();
+        }
+        if view.columns.iter().any(|other| other.name == name) {
+            return pxs_Var::new_exception(format!("Field {name} is there twice")).into_raw();
+        }
+        view.columns.push(Column { name, kind: column.kind, data: column.data as *mut u8, stride });
+    }
+
+    let object = pxs_PixelObject::new_instance(view.into_void(), free_columns, class());
+    pxs_newhost(object.into_raw())
+}
@@ -0,0 +1,69 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+use std::{cell::{Cell, RefCell}, sync::Mutex};
+
+use etffi::ptr_magic::PtrMagic;
+
+use crate::shared::pool::RuntimeSet;
+
+#[allow(non_camel_case_types)]
+/// An independent set of runtime states (one per language, plus host functions and objects).
+///
+/// A thread can hold many contexts and switch between them with `pxs_setcontext`.
+pub struct pxs_Context {
+    /// None while the context is current on some thread.
+    set: Mutex<Option<RuntimeSet>>,
+}
+
+impl pxs_Context {
+    pub(crate) fn new(set: RuntimeSet) -> pxs_Context {
+        pxs_Context { set: Mutex::new(Some(set)) }
+    }
+
+    /// Take the set to make it current, None if it is current somewhere already.
+    pub(crate) fn take(&self) -> Option<RuntimeSet> {
+        self.set.lock().unwrap().take()
+    }
+
+    /// Put the set back once it is no longer current.
+    pub(crate) fn put(&self, set: RuntimeSet) {
+        *self.set.lock().unwrap() = Some(set);
+    }
+}
+
+impl PtrMagic for pxs_Context {}
+
+thread_local! {
+    /// The context that is current on this thread, null for the threads own state.
+    static CURRENT: Cell<*mut pxs_Context> = Cell::new(std::ptr::null_mut());
+    /// The threads own state while a context is current.
+    static HOME_SET: RefCell<Option<RuntimeSet>> = RefCell::new(None);
+}
+
+/// The context that is current on this thread, null for the threads own state.
+pub(crate) fn current_context() -> *mut pxs_Context {
+    CURRENT.get()
+}
+
+/// Make `context` current and keep `previous` (the detached current state) where it belongs.
+pub(crate) fn swap_context(context: *mut pxs_Context, previous: RuntimeSet) {
+    let current = CURRENT.replace(context);
+    if current.is_null() {
+        HOME_SET.set(Some(previous));
+    } else {
+        unsafe {
+            (*current).put(previous);
+        }
+    }
+}
+
+/// Take the threads own state back, if a context is current.
+pub(crate) fn take_home_set() -> Option<RuntimeSet> {
+    HOME_SET.take()
+}
@@ -0,0 +1,148 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+//! Runtimes started on first use (`pxs_InitOptions::deferred`, `pxs_startthread_with`).
+//!
+//! A deferred runtime is not started by `pxs_initialize` or `pxs_startthread`, each thread starts its state the first
+//! time a call goes to it (`pxs_exec`, `pxs_call`, ...). Modules added before that are kept and added once it
+//! starts. `pxs_startthread_with` defers runtimes for one thread only. What a thread started moves with its state
+//! (`RuntimeSet`).
+//!
+//! Nothing is deferred by default, every check is then two relaxed loads.
+use std::{
+    cell::{Cell, RefCell},
+    sync::{
+        Arc,
+        atomic::{AtomicBool, AtomicU8, Ordering},
+    },
+};
+
+use crate::shared::{PixelScript, module::pxs_Module, pxs_Runtime, startup};
+
+/// Deferred runtimes, by bit.
+static DEFERRED: AtomicU8 = AtomicU8::new(0);
+/// Deferred runtimes whose `start` ran, on any thread. Other threads then use `start_thread`.
+static STARTED_ONCE: AtomicU8 = AtomicU8::new(0);
+/// Did a thread defer runtimes of its own (`Starts::lazy`)?
+static ANY_LAZY: AtomicBool = AtomicBool::new(false);
+
+/// What deferred runtimes of one state started, and the modules waiting for the others.
+#[derive(Default)]
+pub(crate) struct Starts {
+    started: u8,
+    /// Deferred for this state only, by `pxs_startthread_with`.
+    lazy: u8,
+    /// Module and the runtimes (by bit) still waiting for it.
+    pending: Vec<(u8, Arc<pxs_Module>)>,
+}
+
+thread_local! {
+    static STARTS: RefCell<Starts> = RefCell::new(Starts::default());
+    /// Starting a runtime right now, modules it adds go in directly.
+    static STARTING: Cell<u8> = const { Cell::new(0) };
+}
+
+fn bit(runtime: &pxs_Runtime) -> u8 {
+    1 << runtime.into_i64()
+}
+
+/// Defer the runtimes in `mask` (bits of `1 << pxs_Runtime`). Set once, by `pxs_initialize`.
+pub(crate) fn set_deferred(mask: u32) {
+    DEFERRED.store((mask & 0xF) as u8, Ordering::Relaxed);
+}
+
+/// Is `runtime` deferred for every thread?
+fn deferred_everywhere(runtime: &pxs_Runtime) -> bool {
+    DEFERRED.load(Ordering::Relaxed) & bit(runtime) != 0
+}
+
+/// Is `runtime` deferred for the current thread?
+pub(crate) fn is_deferred(runtime: &pxs_Runtime) -> bool {
+    deferred_everywhere(runtime)
+        || ANY_LAZY.load(Ordering::Relaxed) && STARTS.with_borrow(|starts| starts.lazy & bit(runtime) != 0)
+}
+
+/// Defer the runtimes in `mask` for the current threads state only, the others are not deferred by it.
+pub(crate) fn set_lazy(mask: u32) {
+    let lazy = (mask & 0xF) as u8;
+    if lazy != 0 {
+        ANY_LAZY.store(true, Ordering::Relaxed);
+    }
+    STARTS.with_borrow_mut(|starts| starts.lazy = lazy);
+}
+
+/// Is `runtime` running in the current threads state?
+pub(crate) fn started(runtime: &pxs_Runtime) -> bool {
+    if !is_deferred(runtime) {
+        return true;
+    }
+    let bit = bit(runtime);
+    STARTING.get() & bit != 0 || STARTS.with_borrow(|starts| starts.started & bit != 0)
+}
+
+/// Did `runtime` start on any thread? (`stop` is only called for those)
+pub(crate) fn started_once(runtime: &pxs_Runtime) -> bool {
+    !deferred_everywhere(runtime) || STARTED_ONCE.load(Ordering::Relaxed) & bit(runtime) != 0
+}
+
+/// Start `runtime` in the current threads state if it is deferred and not started yet.
+pub(crate) fn ensure<B: PixelScript>(runtime: &pxs_Runtime) {
+    if started(runtime) {
+        return;
+    }
+    let bit = bit(runtime);
+    STARTING.set(STARTING.get() | bit);
+    // Not deferred everywhere, `pxs_initialize` ran `start`.
+    if deferred_everywhere(runtime) && STARTED_ONCE.fetch_or(bit, Ordering::Relaxed) & bit == 0 {
+        startup::phase(Some(runtime), "start", B::start);
+    } else {
+        startup::phase(Some(runtime), "start_thread", B::start_thread);
+    }
+
+    let pending = STARTS.with_borrow_mut(|starts| {
+        starts.started |= bit;
+        let mut pending = vec![];
+        for (waiting, module) in starts.pending.iter_mut() {
+            if *waiting & bit != 0 {
+                *waiting &= !bit;
+                pending.push(Arc::clone(module));
+            }
+        }
+        starts.pending.retain(|(waiting, _)| *waiting != 0);
+        pending
+    });
+    for module in pending {
+        startup::module(&module.name, module.function_count(), runtime, || B::add_module(module));
+    }
+    STARTING.set(STARTING.get() & !bit);
+}
+
+/// Keep `module` for `runtime` until it starts in the current threads state.
+pub(crate) fn defer_module(runtime: &pxs_Runtime, module: &Arc<pxs_Module>) {
+    let bit = bit(runtime);
+    STARTS.with_borrow_mut(|starts| match starts.pending.last_mut() {
+        // The runtimes of one `pxs_addmod` come one after the other.
+        Some((waiting, last)) if Arc::ptr_eq(last, module) => *waiting |= bit,
+        _ => starts.pending.push((bit, Arc::clone(module))),
+    });
+}
+
+/// The current thread stopped its state.
+pub(crate) fn stopped() {
+    STARTS.with_borrow_mut(|starts| *starts = Starts::default());
+}
+
+/// Take what the current threads state started out with it, see `RuntimeSet`.
+pub(crate) fn detach() -> Starts {
+    STARTS.with_borrow_mut(std::mem::take)
+}
+
+/// Make `starts` the current threads again.
+pub(crate) fn attach(starts: Starts) {
+    STARTS.set(starts);
+}
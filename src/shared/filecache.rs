@@ -0,0 +1,143 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+//! Cache of what the file and dir readers returned (`pxs_filecache_enable`).
+//!
+//! Every import of every runtime on every thread asks the host readers for each path it tries, found or not. With the
+//! cache on, a path is only asked once: its contents (or that it is missing) are shared by all threads until the host
+//! bumps the version (`pxs_filecache_invalidate`), a path read under an older version is read again. Compiled code
+//! does not need its own entry, the code cache already keys bytecode by file name and source hash.
+//!
+//! Off by default, a read then costs one relaxed load.
+use std::{
+    cell::Cell,
+    collections::HashMap,
+    sync::{
+        LazyLock, RwLock,
+        atomic::{AtomicBool, AtomicU64, Ordering},
+    },
+};
+
+use crate::shared::var::{pxs_Var, pxs_VarMap};
+
+static ENABLED: AtomicBool = AtomicBool::new(false);
+/// Bumped by the host, entries of an older version are stale.
+static VERSION: AtomicU64 = AtomicU64::new(0);
+static HITS: AtomicU64 = AtomicU64::new(0);
+static MISSES: AtomicU64 = AtomicU64::new(0);
+
+/// Path => (version, what the reader returned). Empty for a missing file or dir.
+struct Cache {
+    files: HashMap<String, (u64, String)>,
+    dirs: HashMap<String, (u64, Vec<String>)>,
+}
+
+static CACHE: LazyLock<RwLock<Cache>> =
+    LazyLock::new(|| RwLock::new(Cache { files: HashMap::new(), dirs: HashMap::new() }));
+
+thread_local! {
+    /// Reading through `refresh`, cached entries are read again.
+    static REFRESH: Cell<bool> = const { Cell::new(false) };
+}
+
+/// Is the cache on? One relaxed load, checked before anything else.
+pub(crate) fn enabled() -> bool {
+    ENABLED.load(Ordering::Relaxed)
+}
+
+/// Turn the cache on or off. Turning it off forgets every entry.
+pub fn set_enabled(enabled: bool) {
+    ENABLED.store(enabled, Ordering::Relaxed);
+    if !enabled {
+        clear();
+    }
+}
+
+/// Forget every entry, for a new reader.
+pub(crate) fn clear() {
+    let mut cache = CACHE.write().unwrap();
+    cache.files.clear();
+    cache.dirs.clear();
+}
+
+/// Mark `path` as changed, None for every path. Returns the new version.
+pub fn invalidate(path: Option<&str>) -> u64 {
+    match path {
+        Some(path) => {
+            let mut cache = CACHE.write().unwrap();
+            cache.files.remove(path);
+            cache.dirs.remove(path);
+            VERSION.load(Ordering::Relaxed)
+        }
+        // Entries are dropped lazily, when read again.
+        None => VERSION.fetch_add(1, Ordering::Relaxed) + 1,
+    }
+}
+
+/// Run `f` reading every path from the host again, the entries it reads are replaced. For `pxs_reload_module`.
+pub(crate) fn refresh<R>(f: impl FnOnce() -> R) -> R {
+    let was = REFRESH.replace(true);
+    let res = f();
+    REFRESH.set(was);
+    res
+}
+
+/// Get `path` from `map` or from `read`, and keep it.
+fn get_or_read<T: Clone>(
+    map: fn(&Cache) -> &HashMap<String, (u64, T)>,
+    map_mut: fn(&mut Cache) -> &mut HashMap<String, (u64, T)>,
+    path: &str,
+    read: impl FnOnce() -> T,
+) -> T {
+    let version = VERSION.load(Ordering::Relaxed);
+    if !REFRESH.get() {
+        if let Some((at, value)) = map(&CACHE.read().unwrap()).get(path) {
+            if *at == version {
+                HITS.fetch_add(1, Ordering::Relaxed);
+                return value.clone();
+            }
+        }
+    }
+
+    // Read without the lock, the reader may import too.
+    MISSES.fetch_add(1, Ordering::Relaxed);
+    let value = read();
+    map_mut(&mut CACHE.write().unwrap()).insert(path.to_string(), (version, value.clone()));
+    value
+}
+
+/// Contents of file `path`, read by `read` when not cached.
+pub(crate) fn file(path: &str, read: impl FnOnce() -> String) -> String {
+    get_or_read(|cache| &cache.files, |cache| &mut cache.files, path, read)
+}
+
+/// Entries of dir `path`, read by `read` when not cached.
+pub(crate) fn dir(path: &str, read: impl FnOnce() -> Vec<String>) -> Vec<String> {
+    get_or_read(|cache| &cache.dirs, |cache| &mut cache.dirs, path, read)
+}
+
+/// `{version, files, dirs, hits, misses}`.
+pub fn stats() -> pxs_Var {
+    let (files, dirs) = {
+        let cache = CACHE.read().unwrap();
+        (cache.files.len(), cache.dirs.len())
+    };
+    let mut map = pxs_VarMap::new_ordered();
+    map.add_str("version", pxs_Var::new_i64(VERSION.load(Ordering::Relaxed) as i64));
+    map.add_str("files", pxs_Var::new_i64(files as i64));
+    map.add_str("dirs", pxs_Var::new_i64(dirs as i64));
+    map.add_str("hits", pxs_Var::new_i64(HITS.load(Ordering::Relaxed) as i64));
+    map.add_str("misses", pxs_Var::new_i64(MISSES.load(Ordering::Relaxed) as i64));
+    pxs_Var::new_map_with(map)
+}
+
+/// Zero the hit and miss counts.
+pub(crate) fn reset_stats() {
+    HITS.store(0, Ordering::Relaxed);
+    MISSES.store(0, Ordering::Relaxed);
+}
@@ -8,9 +8,13 @@ use etffi::ptr_magic::{PtrMagic, ThreadSafePointer};
 //
 // Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
 //
-use super::var::pxs_Var;
-use std::collections::HashMap
-;
+use std::{ffi::c_char, time::Instant};
+
+use super::{
+    funcstats, profiler, pxs_Runtime,
+    tracer::{self, pxs_TraceKind},
+    var::pxs_Var,
+};
 
 /// Function reference used in C.
 ///
@@ -23,40 +27,63 @@ use std::collections::HashMap
 #[allow(non_camel_case_types)]
 pub type pxs_Func = unsafe extern "C" fn(args: *mut pxs_Var) -> *mut pxs_Var;
 
-/// Basic rust structure to track Funcs and opaques together.
-pub struct Function {
-    pub name: String,
+/// Function reference used in C, taking its args as a frame instead of a list.
+///
+/// rt: *mut pxs_Var, the runtime.
+/// argc: i32, number of args. Not including the runtime.
+/// argv: *mut *mut pxs_Var, the args. Owned by the caller and only valid during the call.
+///
+/// Same memory rules as `pxs_Func`, do not free `rt` or the `argv` items.
+#[allow(non_camel_case_types)]
+pub type pxs_FuncV = unsafe extern "C" fn(rt: *mut pxs_Var, argc: i32, argv: *mut *mut pxs_Var) -> *mut pxs_Var;
+
+/// One function of a `pxs_addfunctable` table.
+///
+/// name: static storage, kept without a copy.
+#[repr(C)]
+#[allow(non_camel_case_types)]
+pub struct pxs_FuncEntry {
+    pub name: *const c_char,
     pub func: pxs_Func,
 }
 
-unsafe impl Send for Function {}
-unsafe impl Sync for Function {}
+/// How a `Function` takes its args.
+#[derive(Clone, Copy)]
+pub enum FunctionCall {
+    /// A `pxs_List` of the runtime and args.
+    List(pxs_Func),
+    /// A frame of args.
+    Frame(pxs_FuncV),
+}
 
 /// Lookup state structure
 pub struct FunctionLookup {
-    /// Function hash shared between all runtimes.
+    /// Functions by id, the id is the index. Shared between all runtimes.
     ///
-    /// Negative numbers are valid here.
-    pub function_hash: HashMap<i32, Function>,
+    /// Append only, so ids stay valid until the lookup is cleared.
+    pub functions: Vec<FunctionCall>,
+    /// Names by id. Only used for debugging, calls never touch it.
+    pub names: Vec<String>,
 }
 
 impl PtrMagic for FunctionLookup {}
 
 impl FunctionLookup {
-    pub fn get_function(&self, idx: i32) -> Option<&Function> {
-        self.function_hash.get(&idx)
+    pub fn get_function(&self, idx: i32) -> Option<FunctionCall> {
+        // Negative ids wrap around to out of bounds.
+        self.functions.get(idx as usize).copied()
     }
-    pub fn add_function(&mut self, name: &str, func: pxs_Func) -> i32 {
-        // TODO: Allow for negative idxs.
-        self.function_hash.insert(
-            self.function_hash.len() as i32,
-            Function {
-                name: name.to_string(),
-                func,
-            },
-        );
-
-        return (self.function_hash.len() - 1) as i32;
+
+    /// Name of function `idx`.
+    pub fn get_name(&self, idx: i32) -> Option<&str> {
+        self.names.get(idx as usize).map(|name| name.as_str())
+    }
+
+    pub fn add_function(&mut self, name: &str, func: FunctionCall) -> i32 {
+        self.functions.push(func);
+        self.names.push(name.to_string());
+
+        (self.functions.len() - 1) as i32
     }
 }
 
@@ -67,7 +94,8 @@ thread_local! {
 /// Create a new function lookup.
 fn new_function_lookup() -> *mut FunctionLookup {
     FunctionLookup {
-        function_hash: HashMap::new(),
+        functions: vec![],
+        names: vec![],
     }.into_raw()
 }
 
@@ -80,16 +108,62 @@ fn get_function_lookup() -> *mut FunctionLookup {
 
 /// Add a function to the lookup
 pub fn lookup_add_function(name: &str, func: pxs_Func) -> i32 {
+    lookup_add_call(name, FunctionCall::List(func))
+}
+
+/// Add a function of either calling convention to the lookup
+pub fn lookup_add_call(name: &str, func: FunctionCall) -> i32 {
     let lookup = get_function_lookup();
     unsafe {
         (*lookup).add_function(name, func)
     }
 }
 
-/// Clear function lookup hash
+/// Make room for `additional` more functions in the current threads lookup.
+pub fn lookup_reserve(additional: usize) {
+    let lookup = get_function_lookup();
+    unsafe {
+        (*lookup).functions.reserve(additional);
+        (*lookup).names.reserve(additional);
+    }
+}
+
+/// Functions in the current threads lookup.
+pub fn lookup_len() -> usize {
+    unsafe { (*get_function_lookup()).functions.len() }
+}
+
+/// Is function `idx` the one added as `name`? Lets code that caches ids notice the lookup was cleared or swapped.
+pub fn lookup_is(idx: i32, name: &str) -> bool {
+    let lookup = get_function_lookup();
+    unsafe {
+        (*lookup).get_name(idx) == Some(name)
+    }
+}
+
+/// Take the current threads function lookup out, leaving a empty one. Used by `pxs_RuntimePool`.
+pub(crate) fn detach_function_lookup() -> *mut FunctionLookup {
+    let lookup = new_function_lookup();
+    unsafe {
+        std::ptr::swap(lookup, get_function_lookup());
+    }
+    lookup
+}
+
+/// Make a lookup from `detach_function_lookup` the current threads lookup. The replaced one is freed.
+pub(crate) fn attach_function_lookup(lookup: *mut FunctionLookup) {
+    unsafe {
+        std::ptr::swap(lookup, get_function_lookup());
+    }
+    let _ = FunctionLookup::from_raw(lookup);
+}
+
+/// Clear function lookup
 pub fn clear_function_lookup() {
     unsafe {
-        (*get_function_lookup()).function_hash.clear();
+        let lookup = get_function_lookup();
+        (*lookup).functions.clear();
+        (*lookup).names.clear();
     }
 }
 
@@ -97,34 +171,92 @@ pub fn clear_function_lookup() {
 ///
 /// This should only be used within languages and never from a end user.
 pub unsafe fn call_function(fn_idx: i32, args: Vec<pxs_Var>) -> pxs_Var {
-    let func = {
-        let fl = get_function_lookup();
-        let function = unsafe { (*fl).get_function(fn_idx) };
-        if function.is_none() {
-            return pxs_Var::new_null();
+    let func = match unsafe { (*get_function_lookup()).get_function(fn_idx) } {
+        Some(func) => func,
+        None => return pxs_Var::new_null(),
+    };
+
+    let stats = funcstats::enabled();
+    let traced = tracer::active();
+    if !stats && !traced && !profiler::running() {
+        return unsafe { call_lookup_function(func, args) };
+    }
+
+    let runtime = args.first().and_then(pxs_Runtime::from_var);
+    let name = if traced || profiler::running() {
+        unsafe { (*get_function_lookup()).get_name(fn_idx) }.unwrap_or("?").to_string()
+    } else {
+        String::new()
+    };
+    if traced {
+        tracer::emit(true, pxs_TraceKind::pxs_TraceHost, runtime.as_ref(), &name);
+    }
+    let start = Instant::now();
+    let res = if profiler::running() {
+        profiler::host_call(&name, || unsafe { call_lookup_function(func, args) })
+    } else {
+        unsafe { call_lookup_function(func, args) }
+    };
+    if traced {
+        tracer::emit(false, pxs_TraceKind::pxs_TraceHost, runtime.as_ref(), &name);
+    }
+    if let (true, Some(runtime)) = (stats, runtime) {
+        let elapsed = start.elapsed();
+        // Looked up after the call, the lookup may have grown during it.
+        if let Some(name) = unsafe { (*get_function_lookup()).get_name(fn_idx) } {
+            funcstats::record(name, &runtime, elapsed);
         }
+    }
+    res
+}
 
-        let function = function.unwrap();
+unsafe fn call_lookup_function(func: FunctionCall, args: Vec<pxs_Var>) -> pxs_Var {
+    let res = match func {
+        FunctionCall::List(func) => {
+            // Convert the pxs_Var vector into a list.
+            // Do this because I don't want to mess with the older code.
+            let args = pxs_Var::new_list_with(args);
+            let args_ptr = args.into_pooled_raw();
 
-        function.func
+            unsafe {
+                let res = func(args_ptr);
+                // Free args
+                let _ = pxs_Var::from_pooled_raw(args_ptr);
+                res
+            }
+        }
+        FunctionCall::Frame(func) => unsafe { call_frame(func, args) },
     };
 
-    // Convert the pxs_Var vector into a list.
-    // Do this because I don't want to mess with the older code.
-    let args = pxs_Var::new_list_with(args);
-    let args_ptr = args.into_raw();
+    if res.is_null() {
+        pxs_Var::new_null()
+    } else {
+        // Usually a `pxs_new*` node, back into the pool for the next call.
+        pxs_Var::from_pooled_raw(res)
+    }
+}
 
-    unsafe {
-        let res = func(args_ptr);
-        // Free args
-        let _ = pxs_Var::from_raw(args_ptr);
+/// Args that fit in a frame on the stack. More spill to the heap.
+const FRAME_ARGS: usize = 16;
 
-        let result = if res.is_null() {
-            pxs_Var::new_null()
-        } else {
-            pxs_Var::from_raw(res)
-        };
+/// Call a `pxs_FuncV` with `args`, the runtime first. The frame borrows `args` for the call.
+unsafe fn call_frame(func: pxs_FuncV, mut args: Vec<pxs_Var>) -> *mut pxs_Var {
+    let (rt, rest) = match args.split_first_mut() {
+        Some((rt, rest)) => (rt as *mut pxs_Var, rest),
+        None => (std::ptr::null_mut(), Default::default()),
+    };
 
-        result
-    }
+    let mut frame = [std::ptr::null_mut::<pxs_Var>(); FRAME_ARGS];
+    let mut spill: Vec<*mut pxs_Var> = vec![];
+    let argv = if rest.len() <= FRAME_ARGS {
+        for (slot, var) in frame.iter_mut().zip(rest.iter_mut()) {
+            *slot = var;
+        }
+        frame.as_mut_ptr()
+    } else {
+        spill.extend(rest.iter_mut().map(|v| v as *mut pxs_Var));
+        spill.as_mut_ptr()
+    };
+
+    unsafe { func(rt, rest.len() as i32, argv) }
 }
@@ -0,0 +1,209 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+//! Call counts and latency of host functions (`pxs_funcstats`).
+//!
+//! Off by default, `call_function` only checks one relaxed bool. When on each thread records into its own table
+//! (a lock nobody else takes outside of `pxs_funcstats`), so scripts on many threads do not fight over a counter.
+//! Latencies go in a log linear histogram: 8 buckets per power of two, within 12.5% of the real value.
+use std::{
+    cell::OnceCell,
+    collections::HashMap,
+    sync::{
+        Arc, Mutex,
+        atomic::{AtomicBool, Ordering},
+    },
+    time::Duration,
+};
+
+use crate::shared::{
+    pxs_Runtime,
+    var::{pxs_Var, pxs_VarMap},
+};
+
+/// Buckets per power of two.
+const SUB_BUCKETS: u64 = 8;
+/// Buckets to hold any u64 of nanoseconds.
+const BUCKETS: usize = 62 * SUB_BUCKETS as usize;
+/// Runtimes, indexed by `pxs_Runtime::into_i64`.
+const RUNTIMES: [pxs_Runtime; 4] =
+    [pxs_Runtime::pxs_Lua, pxs_Runtime::pxs_Python, pxs_Runtime::pxs_JavaScript, pxs_Runtime::pxs_Wren];
+/// Percentiles in every entry.
+const PERCENTILES: [(&str, f64); 4] = [("p50_ns", 0.5), ("p90_ns", 0.9), ("p99_ns", 0.99), ("p999_ns", 0.999)];
+
+static ENABLED: AtomicBool = AtomicBool::new(false);
+
+/// Calls of one function from one runtime.
+#[derive(Clone)]
+struct Stats {
+    calls: u64,
+    total_ns: u64,
+    max_ns: u64,
+    buckets: Vec<u64>,
+}
+
+impl Stats {
+    fn new() -> Self {
+        Self { calls: 0, total_ns: 0, max_ns: 0, buckets: vec![0; BUCKETS] }
+    }
+
+    fn record(&mut self, ns: u64) {
+        self.calls += 1;
+        self.total_ns = self.total_ns.saturating_add(ns);
+        self.max_ns = self.max_ns.max(ns);
+        self.buckets[bucket(ns)] += 1;
+    }
+
+    fn merge(&mut self, other: &Stats) {
+        self.calls += other.calls;
+        self.total_ns = self.total_ns.saturating_add(other.total_ns);
+        self.max_ns = self.max_ns.max(other.max_ns);
+        for (mine, theirs) in self.buckets.iter_mut().zip(&other.buckets) {
+            *mine += theirs;
+        }
+    }
+
+    /// Upper bound of the bucket holding the `p` percentile, no more than the max.
+    fn percentile(&self, p: f64) -> u64 {
+        let target = ((self.calls as f64 * p).ceil() as u64).max(1);
+        let mut seen = 0;
+        for (i, count) in self.buckets.iter().enumerate() {
+            seen += count;
+            if seen >= target {
+                return bucket_high(i).min(self.max_ns);
+            }
+        }
+        self.max_ns
+    }
+
+    fn into_var(&self) -> pxs_Var {
+        let mut map = pxs_VarMap::new_ordered();
+        map.add_str("calls", pxs_Var::new_i64(self.calls as i64));
+        map.add_str("total_ns", pxs_Var::new_i64(self.total_ns as i64));
+        map.add_str("max_ns", pxs_Var::new_i64(self.max_ns as i64));
+        map.add_str("mean_ns", pxs_Var::new_i64((self.total_ns / self.calls.max(1)) as i64));
+        for (key, p) in PERCENTILES {
+            map.add_str(key, pxs_Var::new_i64(self.percentile(p) as i64));
+        }
+        let histogram = self
+            .buckets
+            .iter()
+            .enumerate()
+            .filter(|(_, count)| **count > 0)
+            .map(|(i, count)| {
+                pxs_Var::new_list_with(vec![
+                    pxs_Var::new_i64(bucket_high(i) as i64),
+                    pxs_Var::new_i64(*count as i64),
+                ])
+            })
+            .collect();
+        map.add_str("histogram", pxs_Var::new_list_with(histogram));
+        pxs_Var::new_map_with(map)
+    }
+}
+
+/// Bucket of `ns`. Under 8 it is exact, then 8 buckets for every power of two.
+fn bucket(ns: u64) -> usize {
+    if ns < SUB_BUCKETS {
+        return ns as usize;
+    }
+    let exp = 63 - ns.leading_zeros() as u64;
+    let sub = (ns >> (exp - 3)) & (SUB_BUCKETS - 1);
+    ((exp - 2) * SUB_BUCKETS + sub) as usize
+}
+
+/// Highest value in bucket `i`.
+fn bucket_high(i: usize) -> u64 {
+    let i = i as u64;
+    if i < SUB_BUCKETS {
+        return i;
+    }
+    let exp = i / SUB_BUCKETS + 2;
+    let sub = i % SUB_BUCKETS;
+    let high = (((SUB_BUCKETS + sub + 1) as u128) << (exp - 3)) - 1;
+    high.min(u64::MAX as u128) as u64
+}
+
+/// Stats of one thread, by function name then runtime.
+type Table = HashMap<String, [Option<Stats>; RUNTIMES.len()]>;
+
+/// Table of every thread that recorded something. Kept after the thread ends, until `reset`.
+static TABLES: Mutex<Vec<Arc<Mutex<Table>>>> = Mutex::new(vec![]);
+
+thread_local! {
+    static TABLE: OnceCell<Arc<Mutex<Table>>> = const { OnceCell::new() };
+}
+
+/// Is recording on? One relaxed load, checked before anything else.
+pub(crate) fn enabled() -> bool {
+    ENABLED.load(Ordering::Relaxed)
+}
+
+/// Turn recording on or off. What was recorded stays until `reset`.
+pub fn set_enabled(enabled: bool) {
+    ENABLED.store(enabled, Ordering::Relaxed);
+}
+
+/// Record a call of `name` from `runtime` that took `elapsed`.
+pub(crate) fn record(name: &str, runtime: &pxs_Runtime, elapsed: Duration) {
+    let ns = u64::try_from(elapsed.as_nanos()).unwrap_or(u64::MAX);
+    TABLE.with(|table| {
+        let table = table.get_or_init(|| {
+            let table = Arc::new(Mutex::new(Table::new()));
+            TABLES.lock().unwrap().push(Arc::clone(&table));
+            table
+        });
+        let mut table = table.lock().unwrap();
+        // Only the first call of a function allocates its name.
+        if !table.contains_key(name) {
+            table.insert(name.to_string(), Default::default());
+        }
+        let runtimes = table.get_mut(name).unwrap();
+        runtimes[runtime.into_i64() as usize].get_or_insert_with(Stats::new).record(ns);
+    });
+}
+
+/// Stats of every thread merged, as `{name: {runtime: {calls, total_ns, max_ns, mean_ns, p50_ns, p90_ns, p99_ns,
+/// p999_ns, histogram}}}`.
+pub fn snapshot() -> pxs_Var {
+    let mut merged: Table = Table::new();
+    for table in TABLES.lock().unwrap().iter() {
+        for (name, runtimes) in table.lock().unwrap().iter() {
+            let into = merged.entry(name.clone()).or_default();
+            for (into, stats) in into.iter_mut().zip(runtimes) {
+                if let Some(stats) = stats {
+                    into.get_or_insert_with(Stats::new).merge(stats);
+                }
+            }
+        }
+    }
+
+    let mut names: Vec<_> = merged.into_iter().collect();
+    names.sort_by(|a, b| a.0.cmp(&b.0));
+    let mut map = pxs_VarMap::new_ordered();
+    for (name, runtimes) in names {
+        let mut by_runtime = pxs_VarMap::new_ordered();
+        for (runtime, stats) in RUNTIMES.iter().zip(&runtimes) {
+            if let Some(stats) = stats {
+                by_runtime.add_str(runtime.name(), stats.into_var());
+            }
+        }
+        map.add_str(&name, pxs_Var::new_map_with(by_runtime));
+    }
+    pxs_Var::new_map_with(map)
+}
+
+/// Forget everything recorded, and the tables of threads that ended.
+pub fn reset() {
+    let mut tables = TABLES.lock().unwrap();
+    tables.retain(|table| Arc::strong_count(table) > 1);
+    for table in tables.iter() {
+        table.lock().unwrap().clear();
+    }
+}
+
@@ -0,0 +1,274 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+//! Garbage collections of every runtime (`pxs_gcstats`).
+//!
+//! `pxs_garbagecollect` and `pxs_gcstep` are always timed, into per thread totals that `pxs_runtimestats` reports.
+//! While `pxs_gcstats_enable` is on every collection also goes in a log of the recent ones, and the collections a
+//! runtime runs on its own are watched where they can be seen:
+//! - pocketpy calls `gc.setup_debug_callback` at both ends of a collection, so they are timed.
+//! - Lua collects in small steps inside allocations. A finalizer sees the end of every cycle, it has no duration.
+//! - QuickJS collects inside an allocation, which moves its threshold (`JS_GetGCThreshold`). The threshold is looked
+//!   at after every call into it, so the collection has no duration and ones close together are seen as one.
+//!
+//! For every Lua and JS pause to be timed turn automatic collection off (`pxs_setautogc`) and step it with
+//! `pxs_gcstep` where the frame has time.
+use std::{
+    cell::{Cell, RefCell},
+    collections::VecDeque,
+    sync::{
+        Mutex,
+        atomic::{AtomicBool, Ordering},
+    },
+    time::Instant,
+};
+
+use crate::shared::{
+    PixelScript, pxs_Runtime,
+    tracer::{self, pxs_TraceKind},
+    var::{pxs_Var, pxs_VarMap},
+};
+
+/// Collections kept in the log, the oldest go first.
+const MAX_EVENTS: usize = 1024;
+/// Runtimes, indexed by `pxs_Runtime::into_i64`.
+const RUNTIMES: [pxs_Runtime; 4] =
+    [pxs_Runtime::pxs_Lua, pxs_Runtime::pxs_Python, pxs_Runtime::pxs_JavaScript, pxs_Runtime::pxs_Wren];
+
+static ENABLED: AtomicBool = AtomicBool::new(false);
+
+/// What started a collection.
+#[derive(Clone, Copy, PartialEq, Eq)]
+pub(crate) enum Kind {
+    /// `pxs_garbagecollect`.
+    Full,
+    /// `pxs_gcstep`.
+    Step,
+    /// The runtime, on its own.
+    Auto,
+}
+
+impl Kind {
+    fn name(&self) -> &'static str {
+        match self {
+            Kind::Full => "full",
+            Kind::Step => "step",
+            Kind::Auto => "auto",
+        }
+    }
+}
+
+/// Collections of one runtime.
+#[derive(Clone, Copy)]
+struct Totals {
+    full: u64,
+    steps: u64,
+    auto: u64,
+    /// Of the timed ones.
+    pause_ns: u64,
+    max_pause_ns: u64,
+    reclaimed: u64,
+}
+
+impl Totals {
+    const ZERO: Totals = Totals { full: 0, steps: 0, auto: 0, pause_ns: 0, max_pause_ns: 0, reclaimed: 0 };
+
+    fn add(&mut self, kind: Kind, ns: Option<u64>, reclaimed: u64) {
+        match kind {
+            Kind::Full => self.full += 1,
+            Kind::Step => self.steps += 1,
+            Kind::Auto => self.auto += 1,
+        }
+        if let Some(ns) = ns {
+            self.pause_ns = self.pause_ns.saturating_add(ns);
+            self.max_pause_ns = self.max_pause_ns.max(ns);
+        }
+        self.reclaimed += reclaimed;
+    }
+
+    fn is_empty(&self) -> bool {
+        self.full + self.steps + self.auto == 0
+    }
+
+    /// Add the totals to `map`, every key starting with `prefix`.
+    fn add_to(&self, map: &mut pxs_VarMap, prefix: &str) {
+        let entries = [
+            ("full", self.full),
+            ("steps", self.steps),
+            ("auto", self.auto),
+            ("pause_ns", self.pause_ns),
+            ("max_pause_ns", self.max_pause_ns),
+            ("reclaimed", self.reclaimed),
+        ];
+        for (key, value) in entries {
+            map.add_str(&format!("{prefix}{key}"), pxs_Var::new_i64(value as i64));
+        }
+    }
+}
+
+struct Event {
+    runtime: pxs_Runtime,
+    kind: Kind,
+    /// On the clock of the Chrome trace writer.
+    start_us: f64,
+    /// None when the runtime did not say when it started.
+    ns: Option<u64>,
+    reclaimed: u64,
+    /// In use after it.
+    bytes: u64,
+}
+
+struct Log {
+    totals: [Totals; 4],
+    events: VecDeque<Event>,
+    dropped: u64,
+}
+
+static LOG: Mutex<Log> = Mutex::new(Log { totals: [Totals::ZERO; 4], events: VecDeque::new(), dropped: 0 });
+
+thread_local! {
+    /// Every collection of the states of this thread, by runtime.
+    static TOTALS: RefCell<[Totals; 4]> = const { RefCell::new([Totals::ZERO; 4]) };
+    /// In `collect`. What the runtime reports on its own meanwhile is that collection.
+    static EXPLICIT: Cell<bool> = const { Cell::new(false) };
+    /// Start and bytes in use of the automatic collection running on this thread.
+    static AUTO_START: Cell<Option<(Instant, usize)>> = const { Cell::new(None) };
+}
+
+/// Is the log on? One relaxed load, checked before anything else.
+pub(crate) fn enabled() -> bool {
+    ENABLED.load(Ordering::Relaxed)
+}
+
+/// Turn the log on or off. What was logged stays until `reset`.
+pub fn set_enabled(enabled: bool) {
+    ENABLED.store(enabled, Ordering::Relaxed);
+}
+
+fn record(runtime: &pxs_Runtime, kind: Kind, start: Instant, ns: Option<u64>, before: usize, after: usize) {
+    let reclaimed = before.saturating_sub(after) as u64;
+    let idx = runtime.into_i64() as usize;
+    TOTALS.with_borrow_mut(|totals| totals[idx].add(kind, ns, reclaimed));
+    if !enabled() {
+        return;
+    }
+    let mut log = LOG.lock().unwrap();
+    log.totals[idx].add(kind, ns, reclaimed);
+    if log.events.len() >= MAX_EVENTS {
+        log.events.pop_front();
+        log.dropped += 1;
+    }
+    log.events.push_back(Event {
+        runtime: runtime.clone(),
+        kind,
+        start_us: tracer::epoch_us(start),
+        ns,
+        reclaimed,
+        bytes: after as u64,
+    });
+}
+
+/// Run `f`, a collection of the current threads `B` state the host asked for.
+pub(crate) fn collect<B: PixelScript, R>(runtime: &pxs_Runtime, kind: Kind, f: impl FnOnce() -> R) -> R {
+    let name = if kind == Kind::Step { "step" } else { "collect" };
+    tracer::span(pxs_TraceKind::pxs_TraceGC, runtime, name, || {
+        let before = B::mem_stats().bytes;
+        let outer = EXPLICIT.replace(true);
+        let start = Instant::now();
+        let res = f();
+        let ns = u64::try_from(start.elapsed().as_nanos()).unwrap_or(u64::MAX);
+        EXPLICIT.set(outer);
+        record(runtime, kind, start, Some(ns), before, B::mem_stats().bytes);
+        res
+    })
+}
+
+/// `runtime` starts a collection on its own, with `bytes` in use.
+pub(crate) fn auto_begin(runtime: &pxs_Runtime, bytes: usize) {
+    if EXPLICIT.get() {
+        return;
+    }
+    if tracer::active() {
+        tracer::emit(true, pxs_TraceKind::pxs_TraceGC, Some(runtime), "auto");
+    }
+    AUTO_START.set(Some((Instant::now(), bytes)));
+}
+
+/// The collection from `auto_begin` is over, `bytes` are left in use.
+pub(crate) fn auto_end(runtime: &pxs_Runtime, bytes: usize) {
+    let Some((start, before)) = AUTO_START.take() else {
+        return;
+    };
+    let ns = u64::try_from(start.elapsed().as_nanos()).unwrap_or(u64::MAX);
+    if tracer::active() {
+        tracer::emit(false, pxs_TraceKind::pxs_TraceGC, Some(runtime), "auto");
+    }
+    record(runtime, Kind::Auto, start, Some(ns), before, bytes);
+}
+
+/// `runtime` finished a collection on its own some time before now, `bytes` are in use. In the trace it is a begin
+/// and end right after each other.
+pub(crate) fn auto_seen(runtime: &pxs_Runtime, bytes: usize) {
+    if EXPLICIT.get() {
+        return;
+    }
+    if tracer::active() {
+        tracer::emit(true, pxs_TraceKind::pxs_TraceGC, Some(runtime), "auto");
+        tracer::emit(false, pxs_TraceKind::pxs_TraceGC, Some(runtime), "auto");
+    }
+    record(runtime, Kind::Auto, Instant::now(), None, bytes, bytes);
+}
+
+/// Add the totals of the current threads `runtime` state to `stats` (`pxs_runtimestats`), as `gc_` keys.
+pub(crate) fn add_totals(runtime: &pxs_Runtime, stats: &mut pxs_VarMap) {
+    let totals = TOTALS.with_borrow(|totals| totals[runtime.into_i64() as usize]);
+    totals.add_to(stats, "gc_");
+}
+
+/// The log as `{runtimes: {runtime: {full, steps, auto, pause_ns, max_pause_ns, reclaimed}}, events: [{runtime,
+/// kind, start_us, ns, reclaimed, bytes}], dropped}`.
+pub fn snapshot() -> pxs_Var {
+    let log = LOG.lock().unwrap();
+    let mut map = pxs_VarMap::new_ordered();
+
+    let mut runtimes = pxs_VarMap::new_ordered();
+    for (runtime, totals) in RUNTIMES.iter().zip(&log.totals) {
+        if !totals.is_empty() {
+            let mut entry = pxs_VarMap::new_ordered();
+            totals.add_to(&mut entry, "");
+            runtimes.add_str(runtime.name(), pxs_Var::new_map_with(entry));
+        }
+    }
+    map.add_str("runtimes", pxs_Var::new_map_with(runtimes));
+
+    let events = log
+        .events
+        .iter()
+        .map(|event| {
+            let mut entry = pxs_VarMap::new_ordered();
+            entry.add_str("runtime", pxs_Var::new_string(event.runtime.name().to_string()));
+            entry.add_str("kind", pxs_Var::new_string(event.kind.name().to_string()));
+            entry.add_str("start_us", pxs_Var::new_f64(event.start_us));
+            entry.add_str("ns", pxs_Var::new_i64(event.ns.map_or(-1, |ns| ns as i64)));
+            entry.add_str("reclaimed", pxs_Var::new_i64(event.reclaimed as i64));
+            entry.add_str("bytes", pxs_Var::new_i64(event.bytes as i64));
+            pxs_Var::new_map_with(entry)
+        })
+        .collect();
+    map.add_str("events", pxs_Var::new_list_with(events));
+    map.add_str("dropped", pxs_Var::new_i64(log.dropped as i64));
+    pxs_Var::new_map_with(map)
+}
+
+/// Forget the log. The per thread totals stay, they belong to the states.
+pub fn reset() {
+    let mut log = LOG.lock().unwrap();
+    log.totals = [Totals::ZERO; 4];
+    log.events.clear();
+    log.dropped = 0;
+}
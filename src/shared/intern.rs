@@ -0,0 +1,66 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+use std::{
+    collections::HashMap,
+    ffi::{CStr, CString},
+    sync::{LazyLock, RwLock},
+};
+
+#[allow(non_camel_case_types)]
+/// A interned name from `pxs_intern`. 0 is never a atom.
+pub type pxs_Atom = u32;
+
+/// Names by atom and atoms by name. Names are never freed so they can be borrowed for the whole process.
+struct Interner {
+    atoms: HashMap<&'static str, pxs_Atom>,
+    /// Atom `n` is at `n - 1`.
+    names: Vec<&'static CStr>,
+}
+
+static INTERNER: LazyLock<RwLock<Interner>> = LazyLock::new(|| {
+    RwLock::new(Interner {
+        atoms: HashMap::new(),
+        names: Vec::new(),
+    })
+});
+
+/// The atom of `name`, the same one every time and on every thread. 0 if `name` has a nul byte.
+pub fn intern(name: &str) -> pxs_Atom {
+    if let Some(atom) = INTERNER.read().unwrap().atoms.get(name) {
+        return *atom;
+    }
+
+    let Ok(cname) = CString::new(name) else {
+        return 0;
+    };
+    let mut interner = INTERNER.write().unwrap();
+    // Another thread could have added it between the locks.
+    if let Some(atom) = interner.atoms.get(name) {
+        return *atom;
+    }
+    let cname: &'static CStr = Box::leak(cname.into_boxed_c_str());
+    interner.names.push(cname);
+    let atom = interner.names.len() as pxs_Atom;
+    interner.atoms.insert(cname.to_str().unwrap(), atom);
+    atom
+}
+
+/// The name of `atom` as a C string.
+pub fn c_name(atom: pxs_Atom) -> Option<&'static CStr> {
+    if atom == 0 {
+        return None;
+    }
+    INTERNER.read().unwrap().names.get(atom as usize - 1).copied()
+}
+
+/// The name of `atom`.
+pub fn name(atom: pxs_Atom) -> Option<&'static str> {
+    // Names are made from a &str, so always utf8.
+    c_name(atom).map(|name| name.to_str().unwrap())
+}
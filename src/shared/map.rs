@@ -0,0 +1,547 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+use std::{
+    borrow::Cow, cell::Cell, ffi::{CStr, c_char}, fmt, mem::ManuallyDrop,
+};
+
+use crate::shared::var::{default_deleter, pxs_Var, pxs_VarT, pxs_VarType, pxs_VarValue};
+
+/// String keys up to this many bytes are stored inline.
+const INLINE_LEN: usize = 29;
+
+/// Tables up to this many pairs are scanned, bigger ones get a index.
+const SCAN_LEN: usize = 8;
+
+/// A string key of a `pxs_VarMap`. Short keys are stored inline, every key ends in a nul so C can borrow it.
+#[derive(Clone)]
+pub enum KeyStr {
+    Inline { len: u8, bytes: [u8; INLINE_LEN + 1] },
+    /// The bytes followed by the nul.
+    Heap(Box<[u8]>),
+}
+
+impl KeyStr {
+    /// `key` may not hold a nul.
+    pub fn new(key: &str) -> Self {
+        debug_assert!(!key.as_bytes().contains(&0), "Map key holds a nul");
+        if key.len() <= INLINE_LEN {
+            let mut bytes = [0; INLINE_LEN + 1];
+            bytes[..key.len()].copy_from_slice(key.as_bytes());
+            Self::Inline { len: key.len() as u8, bytes }
+        } else {
+            let mut bytes = Vec::with_capacity(key.len() + 1);
+            bytes.extend_from_slice(key.as_bytes());
+            bytes.push(0);
+            Self::Heap(bytes.into_boxed_slice())
+        }
+    }
+
+    pub fn as_str(&self) -> &str {
+        let bytes = match self {
+            Self::Inline { len, bytes } => &bytes[..*len as usize],
+            Self::Heap(bytes) => &bytes[..bytes.len() - 1],
+        };
+        // Only made from a &str.
+        unsafe { std::str::from_utf8_unchecked(bytes) }
+    }
+
+    /// Nul terminated, valid until the map changes.
+    pub fn as_ptr(&self) -> *const c_char {
+        match self {
+            Self::Inline { bytes, .. } => bytes.as_ptr() as *const c_char,
+            Self::Heap(bytes) => bytes.as_ptr() as *const c_char,
+        }
+    }
+}
+
+/// A key while iterating a `pxs_VarMap`.
+#[derive(Clone, Copy)]
+pub enum MapKey<'a> {
+    Str(&'a KeyStr),
+    Var(&'a pxs_Var),
+}
+
+impl<'a> MapKey<'a> {
+    /// The key as a var, string keys are copied into a `pxs_String`.
+    pub fn as_var(&self) -> Cow<'a, pxs_Var> {
+        match self {
+            Self::Str(key) => Cow::Owned(pxs_Var::new_string(key.as_str().to_string())),
+            Self::Var(key) => Cow::Borrowed(key),
+        }
+    }
+
+    /// A owned copy of the key.
+    pub fn to_var(&self) -> pxs_Var {
+        self.as_var().into_owned()
+    }
+
+    /// The text of a UTF-8 string key.
+    pub fn as_str(&self) -> Option<&'a str> {
+        match self {
+            Self::Str(key) => Some(key.as_str()),
+            Self::Var(key) => key_str(key),
+        }
+    }
+
+    /// The nul terminated text of a string key, null for other keys.
+    pub fn as_ptr(&self) -> *const c_char {
+        match self {
+            Self::Str(key) => key.as_ptr(),
+            Self::Var(key) if key.is_string() => unsafe { key.value.string_val },
+            Self::Var(_) => std::ptr::null(),
+        }
+    }
+
+    pub fn is_string(&self) -> bool {
+        match self {
+            Self::Str(_) => true,
+            Self::Var(key) => key.is_string(),
+        }
+    }
+
+    pub fn tag(&self) -> pxs_VarType {
+        match self {
+            Self::Str(_) => pxs_VarType::pxs_String,
+            Self::Var(key) => key.tag,
+        }
+    }
+
+    pub fn is_portable(&self) -> bool {
+        match self {
+            Self::Str(_) => true,
+            Self::Var(key) => key.is_portable(),
+        }
+    }
+}
+
+impl fmt::Debug for MapKey<'_> {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        match self {
+            Self::Str(key) => fmt::Debug::fmt(key.as_str(), f),
+            Self::Var(key) => fmt::Debug::fmt(key, f),
+        }
+    }
+}
+
+/// Multiply and rotate per 8 bytes (like FxHash). Much cheaper than SipHash for the short keys maps hold.
+fn mix(hash: u64, word: u64) -> u64 {
+    (hash.rotate_left(5) ^ word).wrapping_mul(0x517c_c1b7_2722_0a95)
+}
+
+/// Spread the high bits into the low ones, the index only looks at those.
+fn finish(hash: u64) -> u64 {
+    let hash = (hash ^ (hash >> 33)).wrapping_mul(0xff51_afd7_ed55_8ccd);
+    hash ^ (hash >> 33)
+}
+
+fn hash_bytes(bytes: &[u8]) -> u64 {
+    let mut hash = bytes.len() as u64;
+    let mut words = bytes.chunks_exact(8);
+    for word in &mut words {
+        hash = mix(hash, u64::from_le_bytes(word.try_into().unwrap()));
+    }
+    let rest = words.remainder();
+    if !rest.is_empty() {
+        let mut word = [0; 8];
+        word[..rest.len()].copy_from_slice(rest);
+        hash = mix(hash, u64::from_le_bytes(word));
+    }
+    finish(hash)
+}
+
+/// Bytes of a `pxs_String`, without the nul.
+fn string_bytes(var: &pxs_Var) -> &[u8] {
+    unsafe {
+        if var.value.string_val.is_null() {
+            &[]
+        } else {
+            CStr::from_ptr(var.value.string_val).to_bytes()
+        }
+    }
+}
+
+/// The text of a UTF-8 `pxs_String`.
+fn key_str(var: &pxs_Var) -> Option<&str> {
+    if var.is_string() {
+        std::str::from_utf8(string_bytes(var)).ok()
+    } else {
+        None
+    }
+}
+
+/// A string hashes the same as a `KeyStr` or a `pxs_String`.
+fn hash_var(key: &pxs_Var) -> u64 {
+    unsafe {
+        let (kind, bits) = match key.tag {
+            pxs_VarType::pxs_String => return hash_bytes(string_bytes(key)),
+            pxs_VarType::pxs_Int64 => (1, key.value.i64_val as u64),
+            pxs_VarType::pxs_UInt64 => (2, key.value.u64_val),
+            pxs_VarType::pxs_Bool => (3, key.value.bool_val as u64),
+            // -0.0 == 0.0
+            pxs_VarType::pxs_Float64 => (4, if key.value.f64_val == 0.0 { 0 } else { key.value.f64_val.to_bits() }),
+            pxs_VarType::pxs_Byte => (5, key.value.byte_val as u64),
+            _ => panic!("Can not Hash none basic pxs_VarType"),
+        };
+        finish(mix(kind, bits))
+    }
+}
+
+/// Same as `pxs_Var::eq` for the types that hash, without copying strings.
+fn same_key(a: &pxs_Var, b: &pxs_Var) -> bool {
+    a.tag == b.tag && if a.is_string() { string_bytes(a) == string_bytes(b) } else { a == b }
+}
+
+#[derive(Clone)]
+pub struct Entry<K> {
+    hash: u64,
+    key: K,
+    value: pxs_Var,
+}
+
+/// Pairs kept in one dense array in insertion order, found through a open addressing index of their positions.
+#[derive(Clone)]
+pub struct Table<K> {
+    entries: Vec<Entry<K>>,
+    /// Position + 1 of a entry, 0 is a empty slot. Linear probing, the length is a power of 2.
+    /// Empty while the table is small enough to scan.
+    slots: Vec<u32>,
+}
+
+impl<K> Table<K> {
+    fn with_capacity(capacity: usize) -> Self {
+        let mut table = Self {
+            entries: Vec::with_capacity(capacity),
+            slots: vec![],
+        };
+        if capacity > SCAN_LEN {
+            table.reindex(capacity);
+        }
+        table
+    }
+
+    fn find(&self, hash: u64, is_key: impl Fn(&K) -> bool) -> Option<usize> {
+        if self.slots.is_empty() {
+            return self.entries.iter().position(|entry| entry.hash == hash && is_key(&entry.key));
+        }
+        let mask = self.slots.len() - 1;
+        let mut i = hash as usize & mask;
+        loop {
+            let slot = self.slots[i] as usize;
+            if slot == 0 {
+                return None;
+            }
+            let entry = &self.entries[slot - 1];
+            if entry.hash == hash && is_key(&entry.key) {
+                return Some(slot - 1);
+            }
+            i = (i + 1) & mask;
+        }
+    }
+
+    /// Insert or replace, the old value is dropped.
+    fn insert(&mut self, hash: u64, is_key: impl Fn(&K) -> bool, new_key: impl FnOnce() -> K, value: pxs_Var) {
+        match self.find(hash, is_key) {
+            Some(i) => self.entries[i].value = value,
+            None => self.push(hash, new_key(), value),
+        }
+    }
+
+    /// Add a key that is not in the table yet.
+    fn push(&mut self, hash: u64, key: K, value: pxs_Var) {
+        self.entries.push(Entry { hash, key, value });
+        let len = self.entries.len();
+        if self.slots.is_empty() {
+            if len > SCAN_LEN {
+                self.reindex(len);
+            }
+        } else if len * 4 > self.slots.len() * 3 {
+            // Stay under 3/4 full.
+            self.reindex(len);
+        } else {
+            place(&mut self.slots, hash, len as u32);
+        }
+    }
+
+    /// Rebuild the index with room for `len` entries.
+    fn reindex(&mut self, len: usize) {
+        self.slots = vec![0; (len * 2).next_power_of_two().max(SCAN_LEN * 4)];
+        for (i, entry) in self.entries.iter().enumerate() {
+            place(&mut self.slots, entry.hash, i as u32 + 1);
+        }
+    }
+
+    /// The slot holding entry `i`.
+    fn slot_of(&self, i: usize) -> usize {
+        let mask = self.slots.len() - 1;
+        let mut slot = self.entries[i].hash as usize & mask;
+        while self.slots[slot] as usize != i + 1 {
+            slot = (slot + 1) & mask;
+        }
+        slot
+    }
+
+    /// Remove entry `i`. `ordered` keeps the order of the others, otherwise the last entry takes its place.
+    fn remove(&mut self, i: usize, ordered: bool) -> pxs_Var {
+        if self.slots.is_empty() {
+            let entry = if ordered { self.entries.remove(i) } else { self.entries.swap_remove(i) };
+            return entry.value;
+        }
+
+        // Shift the following entries of the probe back into the hole, so lookups need no tombstones.
+        let mask = self.slots.len() - 1;
+        let mut hole = self.slot_of(i);
+        let mut slot = (hole + 1) & mask;
+        while self.slots[slot] != 0 {
+            let home = self.entries[self.slots[slot] as usize - 1].hash as usize & mask;
+            if slot.wrapping_sub(home) & mask >= slot.wrapping_sub(hole) & mask {
+                self.slots[hole] = self.slots[slot];
+                hole = slot;
+            }
+            slot = (slot + 1) & mask;
+        }
+        self.slots[hole] = 0;
+
+        if ordered {
+            for slot in self.slots.iter_mut() {
+                if *slot as usize > i + 1 {
+                    *slot -= 1;
+                }
+            }
+            self.entries.remove(i).value
+        } else {
+            let last = self.entries.len() - 1;
+            if i != last {
+                let slot = self.slot_of(last);
+                self.slots[slot] = i as u32 + 1;
+            }
+            self.entries.swap_remove(i).value
+        }
+    }
+}
+
+fn place(slots: &mut [u32], hash: u64, position: u32) {
+    let mask = slots.len() - 1;
+    let mut i = hash as usize & mask;
+    while slots[i] != 0 {
+        i = (i + 1) & mask;
+    }
+    slots[i] = position;
+}
+
+/// The pairs of a `pxs_VarMap`. Maps start out string keyed, the first other key moves every key into a `pxs_Var`.
+#[derive(Clone)]
+pub enum Pairs {
+    Strings(Table<KeyStr>),
+    Vars(Table<pxs_Var>),
+}
+
+impl Pairs {
+    pub fn with_capacity(capacity: usize) -> Self {
+        Self::Strings(Table::with_capacity(capacity))
+    }
+
+    pub fn len(&self) -> usize {
+        match self {
+            Self::Strings(table) => table.entries.len(),
+            Self::Vars(table) => table.entries.len(),
+        }
+    }
+
+    pub fn get(&self, key: &pxs_Var) -> Option<&pxs_Var> {
+        match self {
+            // A string map only holds UTF-8 strings.
+            Self::Strings(_) => self.get_str(key_str(key)?),
+            Self::Vars(table) => {
+                if !is_key(key) {
+                    return None;
+                }
+                let i = table.find(hash_var(key), |k| same_key(k, key))?;
+                Some(&table.entries[i].value)
+            }
+        }
+    }
+
+    pub fn get_str(&self, key: &str) -> Option<&pxs_Var> {
+        let hash = hash_bytes(key.as_bytes());
+        match self {
+            Self::Strings(table) => {
+                let i = table.find(hash, |k| k.as_str() == key)?;
+                Some(&table.entries[i].value)
+            }
+            Self::Vars(table) => {
+                let i = table.find(hash, |k| k.is_string() && string_bytes(k) == key.as_bytes())?;
+                Some(&table.entries[i].value)
+            }
+        }
+    }
+
+    /// Panics on keys that do not hash, like `HashMap` did.
+    pub fn insert(&mut self, key: pxs_Var, value: pxs_Var) {
+        if let Self::Strings(_) = self {
+            if let Some(text) = key_str(&key) {
+                return self.insert_str(text, value);
+            }
+            self.to_vars();
+        }
+        let Self::Vars(table) = self else { unreachable!() };
+        let hash = hash_var(&key);
+        match table.find(hash, |k| same_key(k, &key)) {
+            Some(i) => table.entries[i].value = value,
+            None => table.push(hash, key, value),
+        }
+    }
+
+    pub fn insert_str(&mut self, key: &str, value: pxs_Var) {
+        let hash = hash_bytes(key.as_bytes());
+        match self {
+            Self::Strings(table) => table.insert(hash, |k| k.as_str() == key, || KeyStr::new(key), value),
+            Self::Vars(table) => table.insert(
+                hash,
+                |k| k.is_string() && string_bytes(k) == key.as_bytes(),
+                || pxs_Var::new_string(key.to_string()),
+                value,
+            ),
+        }
+    }
+
+    pub fn remove(&mut self, key: &pxs_Var, ordered: bool) -> Option<pxs_Var> {
+        match self {
+            Self::Strings(table) => {
+                let key = key_str(key)?;
+                let i = table.find(hash_bytes(key.as_bytes()), |k| k.as_str() == key)?;
+                Some(table.remove(i, ordered))
+            }
+            Self::Vars(table) => {
+                if !is_key(key) {
+                    return None;
+                }
+                let i = table.find(hash_var(key), |k| same_key(k, key))?;
+                Some(table.remove(i, ordered))
+            }
+        }
+    }
+
+    pub fn iter(&self) -> Iter<'_> {
+        match self {
+            Self::Strings(table) => Iter::Strings(table.entries.iter()),
+            Self::Vars(table) => Iter::Vars(table.entries.iter()),
+        }
+    }
+
+    /// The pair at `index` in `iter` order.
+    pub fn pair_at(&self, index: usize) -> Option<(MapKey<'_>, &pxs_Var)> {
+        match self {
+            Self::Strings(table) => table.entries.get(index).map(|entry| (MapKey::Str(&entry.key), &entry.value)),
+            Self::Vars(table) => table.entries.get(index).map(|entry| (MapKey::Var(&entry.key), &entry.value)),
+        }
+    }
+
+    /// Positions and hashes stay the same, so the index is kept.
+    fn to_vars(&mut self) {
+        let Self::Strings(table) = self else {
+            return;
+        };
+        let entries = std::mem::take(&mut table.entries)
+            .into_iter()
+            .map(|entry| Entry {
+                hash: entry.hash,
+                key: pxs_Var::new_string(entry.key.as_str().to_string()),
+                value: entry.value,
+            })
+            .collect();
+        let slots = std::mem::take(&mut table.slots);
+        *self = Self::Vars(Table { entries, slots });
+    }
+}
+
+/// Types `hash_var` takes.
+fn is_key(var: &pxs_Var) -> bool {
+    matches!(
+        var.tag,
+        pxs_VarType::pxs_Int64
+            | pxs_VarType::pxs_UInt64
+            | pxs_VarType::pxs_Float64
+            | pxs_VarType::pxs_Bool
+            | pxs_VarType::pxs_String
+            | pxs_VarType::pxs_Byte
+    )
+}
+
+/// The pairs of a `pxs_VarMap` in order.
+pub enum Iter<'a> {
+    Strings(std::slice::Iter<'a, Entry<KeyStr>>),
+    Vars(std::slice::Iter<'a, Entry<pxs_Var>>),
+}
+
+impl<'a> Iterator for Iter<'a> {
+    type Item = (MapKey<'a>, &'a pxs_Var);
+
+    fn next(&mut self) -> Option<Self::Item> {
+        match self {
+            Self::Strings(entries) => entries.next().map(|entry| (MapKey::Str(&entry.key), &entry.value)),
+            Self::Vars(entries) => entries.next().map(|entry| (MapKey::Var(&entry.key), &entry.value)),
+        }
+    }
+
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        match self {
+            Self::Strings(entries) => entries.size_hint(),
+            Self::Vars(entries) => entries.size_hint(),
+        }
+    }
+}
+
+impl ExactSizeIterator for Iter<'_> {}
+
+/// A host iteration over the pairs of a `pxs_Map` (`pxs_mapiter_begin`/`pxs_mapiter_next`). It lives wherever the
+/// caller puts it (i.e. the stack), so iterating allocates nothing.
+#[repr(C)]
+#[allow(non_camel_case_types)]
+pub struct pxs_MapIter {
+    /// The map being iterated (BORROW).
+    pub map: pxs_VarT,
+    /// Position of the next pair.
+    pub index: usize,
+    /// String keys are not stored as `pxs_Var`s, `next` points this at the key text instead. It never owns it.
+    pub key: ManuallyDrop<pxs_Var>,
+}
+
+impl pxs_MapIter {
+    pub fn new(map: pxs_VarT) -> Self {
+        Self {
+            map,
+            index: 0,
+            // Not made with `pxs_Var::new`, it is not a live var and is never dropped.
+            key: ManuallyDrop::new(pxs_Var {
+                tag: pxs_VarType::pxs_String,
+                value: pxs_VarValue { string_val: std::ptr::null_mut() },
+                deleter: Cell::new(default_deleter),
+            }),
+        }
+    }
+
+    /// The next key and value, borrowed from the map.
+    pub fn next(&mut self) -> Option<(pxs_VarT, pxs_VarT)> {
+        if self.map.is_null() {
+            return None;
+        }
+        let map = unsafe { (*self.map).get_map() }?;
+        let (key, value) = map.pair_at(self.index)?;
+        self.index += 1;
+
+        let key = match key {
+            MapKey::Str(key) => {
+                self.key.value.string_val = key.as_ptr() as *mut c_char;
+                &mut *self.key as *mut pxs_Var
+            }
+            MapKey::Var(key) => key as *const pxs_Var as pxs_VarT,
+        };
+        Some((key, value as *const pxs_Var as pxs_VarT))
+    }
+}
@@ -13,7 +13,7 @@ use std::{
 use etffi::{ptr_magic::{PtrMagic, ThreadSafePointer}, cstring::CStringSafe};
 
 use crate::{
-    own_var, shared::{var::{pxs_Var, pxs_VarT}}
+    own_var, shared::{var::{pxs_Var, pxs_VarMap, pxs_VarT}}
 };
 
 /// Helper methods/macros for using PixelScript
@@ -27,7 +27,48 @@ pub mod object;
 pub mod utils;
 /// The internal PixelScript Var logic.
 pub mod var;
+/// Storage of `pxs_VarMap`.
+pub mod map;
 pub mod arena;
+/// Host allocator hooks.
+pub mod alloc;
+/// Time and instruction limits of script calls.
+pub mod budget;
+/// Independent runtime sets a thread switches between.
+pub mod context;
+/// Pre-warmed runtime sets for threads.
+pub mod pool;
+/// Worker threads running script jobs.
+pub mod scheduler;
+/// Precompiled chunks saved between launches.
+pub mod snapshot;
+/// Interned names shared by every runtime.
+pub mod intern;
+/// Read only data shared by every runtime (`pxs_publish`).
+pub mod store;
+/// Column views over host memory (`pxs_newcolumns`).
+pub mod columns;
+/// Sampling profiler of script calls (`pxs_profiler_start`).
+pub mod profiler;
+/// Call counts and latency of host functions (`pxs_funcstats`).
+pub mod funcstats;
+/// Lifetimes and reference counts of host objects by type (`pxs_objstats`).
+pub mod objstats;
+/// Cache of what the file and dir readers returned (`pxs_filecache_enable`).
+pub mod filecache;
+/// Runtimes started on first use (`pxs_InitOptions`).
+pub mod deferred;
+/// Begin/end trace events and the Chrome trace writer (`pxs_settracer`).
+pub mod tracer;
+/// Costs of startup phases and module registration (`pxs_startupstats`).
+pub mod startup;
+/// Garbage collection pauses of every runtime (`pxs_gcstats`).
+pub mod gcstats;
+/// Soft watchdog reporting slow script calls (`pxs_setwatchdog`).
+pub mod watchdog;
+/// Records of live pxs_Var allocations for `pxs_leakreport`.
+#[cfg(feature = "pxs_trace")]
+pub mod trace;
 
 /// cbindgen:ignore
 /// This is a internal function used in `pxs_utils.h` to allow bridge code to work with rust strings.
@@ -91,6 +132,7 @@ pub(crate) fn set_read_file(func: pxs_LoadFileFn) {
     unsafe { 
         (*PIXEL_STATE.get_ptr()).load_file = Some(func);
     }
+    filecache::clear();
 }
 
 /// Set `read_dir` function in PixelState global
@@ -98,11 +140,19 @@ pub(crate) fn set_read_dir(func: pxs_ReadDirFn) {
     unsafe {
         (*PIXEL_STATE.get_ptr()).read_dir = Some(func);
     }
+    filecache::clear();
 }
 
 /// Read a file using pxs api.
 /// This must be set by host language.
 pub fn read_file(file_path: &str) -> String {
+    if filecache::enabled() {
+        return filecache::file(file_path, || host_read_file(file_path));
+    }
+    host_read_file(file_path)
+}
+
+fn host_read_file(file_path: &str) -> String {
     // Get callback
     let cbk = unsafe { (*PIXEL_STATE.get_ptr()).load_file };
     if cbk.is_none() {
@@ -127,6 +177,13 @@ pub fn read_file(file_path: &str) -> String {
 /// Read a Directory using pxs api.
 /// This must be set by host language.
 pub fn read_file_dir(dir_path: &str) -> Vec<String> {
+    if filecache::enabled() {
+        return filecache::dir(dir_path, || host_read_dir(dir_path));
+    }
+    host_read_dir(dir_path)
+}
+
+fn host_read_dir(dir_path: &str) -> Vec<String> {
     let cbk = unsafe { (*PIXEL_STATE.get_ptr()).read_dir };
     if cbk.is_none() {
         return vec![];
@@ -186,9 +243,35 @@ pub trait PixelScript {
     /// For most languages this is NOT needed.
     fn stop_thread();
 
+    /// Take the current threads state out so it can be kept in a `pxs_RuntimePool`.
+    /// The thread is left with a empty state until `attach_thread` or `start_thread`.
+    fn detach_thread() -> pxs_Opaque;
+
+    /// Make a state from `detach_thread` the current threads state. The empty state it replaces is freed.
+    fn attach_thread(state: pxs_Opaque);
+
+    /// Remember the script globals that exist right now. `reset_globals` keeps only these.
+    fn mark_globals();
+
+    /// Remove the script globals defined since `mark_globals`. Much cheaper than `clear`.
+    fn reset_globals();
+
+    /// Start enforcing `budget` on the current threads state, a budgeted call is starting.
+    fn arm_budget(budget: &budget::Budget);
+
+    /// Stop enforcing the budget from `arm_budget`.
+    fn disarm_budget();
+
+    /// Push the frames of the script code running on this thread, outermost first. For `profiler` samples.
+    fn profile_stack(frames: &mut Vec<String>);
+
     /// Clear the current threads state.
     fn clear();
 
+    /// Compile and run the script module `name` again and rebind it where imports find it, the rest of the state is
+    /// kept. Also loads it when it was not imported yet.
+    fn reload_module(name: &str) -> PxsResult;
+
     /// Compile and save for future use.
     /// Pass in a optional global scope, if null, defaults to empty Map.
     /// Result will be a list with: [Runtime, Compiled Object, ...]
@@ -202,8 +285,26 @@ pub trait PixelScript {
     /// For debugging purposes. Return a string which explains the current state.
     fn debug() -> String;
 
+    /// Add the numbers of the current threads state only this runtime has to `stats` (`pxs_runtimestats`).
+    fn runtime_stats(stats: &mut pxs_VarMap);
+
     /// Call the garbage collector. Will also free internal types.
     fn garbage_collect();
+
+    /// Do incremental collection work for about `budget`, at least one step. True when a cycle finished.
+    fn gc_step(budget: std::time::Duration) -> bool;
+
+    /// Let the runtime collect on its own, or only when asked (`garbage_collect`, `gc_step`).
+    fn set_auto_gc(enabled: bool);
+
+    /// Memory of the current threads state.
+    fn mem_stats() -> alloc::MemStats;
+
+    /// Limit the memory of the current threads state, 0 for none. False if the runtime can not enforce one.
+    fn set_mem_limit(bytes: usize) -> bool;
+
+    /// Start or stop watching the collections the current threads state runs on its own, for `gcstats`.
+    fn watch_gc(enabled: bool);
 }
 
 /// Public enum for supported runtimes.
@@ -264,6 +365,16 @@ impl pxs_Runtime {
         }
     }
 
+    /// Short lowercase name, i.e. `lua`.
+    pub fn name(&self) -> &'static str {
+        match self {
+            pxs_Runtime::pxs_Lua => "lua",
+            pxs_Runtime::pxs_Python => "python",
+            pxs_Runtime::pxs_JavaScript => "js",
+            pxs_Runtime::pxs_Wren => "wren",
+        }
+    }
+
     /// Turns current runtime into a `pxs_Int64`
     pub fn into_var(&self) -> pxs_Var {
         let idx = self.into_i64();
@@ -274,5 +385,8 @@ impl pxs_Runtime {
 /// PXS PTR name string
 pub const PXS_PTR_NAME: &str = "_pxs_ptr";
 
+/// PXS PTR name as a C string, for looking it up without allocating.
+pub const PXS_PTR_NAME_C: &std::ffi::CStr = c"_pxs_ptr";
+
 /// PXS __pxs__ internal method
 pub const PXS_METHOD_NAME: &str = "__pxs__";
\ No newline at end of file
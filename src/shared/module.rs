@@ -7,7 +7,7 @@
 // Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
 //
 use crate::shared::{PtrMagic, var::pxs_Var};
-use std::sync::Arc;
+use std::{borrow::Cow, sync::Arc};
 
 /// A Module is a C representation of data that needs to be (imported,required, etc)
 ///
@@ -49,7 +49,8 @@ pub struct pxs_Module {
 /// Wraps a idx with a name.
 #[derive(Clone)]
 pub struct ModuleCallback {
-    pub name: String,
+    /// Borrowed for the static names of `pxs_addfunctable`.
+    pub name: Cow<'static, str>,
     pub full_name: String,
     pub idx: i32,
 }
@@ -81,15 +82,25 @@ impl pxs_Module {
         }
     }
 
+    /// Callbacks of this module and all its submodules.
+    pub fn function_count(&self) -> usize {
+        self.callbacks.len() + self.modules.iter().map(|module| module.function_count()).sum::<usize>()
+    }
+
     /// Add a callback to current module.
     pub fn add_callback(&mut self, name: &str, full_name: &str, idx: i32) {
         self.callbacks.push(ModuleCallback {
-            name: name.to_string(),
+            name: Cow::Owned(name.to_string()),
             full_name: full_name.to_string(),
             idx,
         });
     }
 
+    /// Add a callback whose name lives for as long as the program, without copying it.
+    pub fn add_static_callback(&mut self, name: &'static str, full_name: String, idx: i32) {
+        self.callbacks.push(ModuleCallback { name: Cow::Borrowed(name), full_name, idx });
+    }
+
     /// Add a variable to current module.
     pub fn add_variable(&mut self, name: &str, var: pxs_Var) {
         self.variables.push(ModuleVariable {
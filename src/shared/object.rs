@@ -7,12 +7,12 @@
 // Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
 //
 use std::{
-    collections::HashMap, ops::{BitAnd, BitOr}, os::raw::c_void, ptr, sync::{Arc, Mutex}
+    ops::{BitAnd, BitOr}, os::raw::c_void, ptr, sync::{Arc, Mutex}
 };
 
 use etffi::ptr_magic::ThreadSafePointer;
 
-use crate::{shared::{PtrMagic, module::ModuleCallback, var::{default_deleter, pxs_DeleterFn}}};
+use crate::{shared::{PtrMagic, module::ModuleCallback, objstats, var::{default_deleter, pxs_DeleterFn, pxs_Var, pxs_VarType}}};
 
 /// Flags for `ObjectCallback`.
 /// 
@@ -57,6 +57,69 @@ pub struct ObjectCallback {
     pub flags: u8
 }
 
+/// A plain data property. Every instance starts with `var` and scripts read it without calling the host.
+///
+/// When `writable` is false, assigning it is a error.
+pub struct ObjectField {
+    pub name: String,
+    /// Only scalars (`pxs_Int64`, `pxs_UInt64`, `pxs_Float64`, `pxs_Bool`, `pxs_String`, `pxs_Null`).
+    pub var: pxs_Var,
+    pub writable: bool
+}
+
+impl ObjectField {
+    /// Can `var` be a field. Scalars only, so instances never share a mutable default.
+    pub fn is_plain(var: &pxs_Var) -> bool {
+        matches!(var.tag,
+            pxs_VarType::pxs_Int64 | pxs_VarType::pxs_UInt64 | pxs_VarType::pxs_Float64 |
+            pxs_VarType::pxs_Bool | pxs_VarType::pxs_String | pxs_VarType::pxs_Null)
+    }
+}
+
+/// A PixelScript Class.
+///
+/// Holds the callbacks of a host type so they are registered once and shared by every instance
+/// created with `pxs_newinstance`, rather than added to each `pxs_PixelObject`.
+#[allow(non_camel_case_types)]
+pub struct pxs_PixelClass {
+    /// Type name (this is a hash)
+    pub type_name: String,
+    /// Optional type. < 0 == None.
+    pub t: i32,
+    /// Callbacks shared by all instances.
+    pub callbacks: Vec<ObjectCallback>,
+    /// Data properties shared by all instances.
+    pub fields: Vec<ObjectField>
+}
+
+impl pxs_PixelClass {
+    pub fn new(type_name: &str, t: i32) -> Self {
+        Self {
+            type_name: type_name.to_string(),
+            t,
+            callbacks: vec![],
+            fields: vec![]
+        }
+    }
+
+    pub fn add_field(&mut self, name: &str, var: pxs_Var, writable: bool) {
+        self.fields.push(ObjectField { name: name.to_string(), var, writable });
+    }
+
+    pub fn add_callback(&mut self, name: &str, full_name: &str, idx: i32, flags: u8) {
+        self.callbacks.push(
+            ObjectCallback {
+                cbk: ModuleCallback {
+            name: name.to_string().into(),
+            full_name: full_name.to_string(),
+            idx,
+        }, flags});
+    }
+}
+
+unsafe impl Send for pxs_PixelClass {}
+unsafe impl Sync for pxs_PixelClass {}
+
 /// A PixelScript Object.
 ///
 /// The way this works is via the host, a Pseudo type can be created. So when the scripting
@@ -138,10 +201,13 @@ pub struct pxs_PixelObject {
     ///
     /// The first Var will always be the ptr.
     pub callbacks: Vec<ObjectCallback>,
+    /// Data properties, see `ObjectField`.
+    pub fields: Vec<ObjectField>,
+    /// The class this object is an instance of. When set its callbacks and fields are used instead.
+    pub class: Option<Arc<pxs_PixelClass>>,
     // PixelObject does not hold variables. They are all getters/
+    // References are counted by the `ObjectLookup` slot holding it.
 
-    /// Refernce Counting. This is internal reference counting PXS side.
-    pub ref_count: Mutex<u16>,
     /// Optional type. < 0 == None.
     pub t: i32
 }
@@ -152,11 +218,11 @@ impl pxs_PixelObject {
             ptr,
             free_method,
             callbacks: vec![],
+            fields: vec![],
+            class: None,
             lang_ptr: Mutex::new(ptr::null_mut()),
             type_name: type_name.to_string(),
             pxs_free_method: Mutex::new(default_deleter),
-            // TODO: Do I need to set this to 0?
-            ref_count: Mutex::new(1),
             t: -1
         }
     }
@@ -166,25 +232,56 @@ impl pxs_PixelObject {
             ptr,
             free_method,
             callbacks: vec![],
+            fields: vec![],
+            class: None,
             lang_ptr: Mutex::new(ptr::null_mut()),
             type_name: type_name.to_string(),
             pxs_free_method: Mutex::new(default_deleter),
-            // TODO: Do I need to set this to 0?
-            ref_count: Mutex::new(1),
             t
         }
     }
 
+    pub fn new_instance(ptr: *mut c_void, free_method: pxs_DeleterFn, class: Arc<pxs_PixelClass>) -> Self {
+        let mut object = Self::new_type(ptr, free_method, &class.type_name, class.t);
+        object.class = Some(class);
+        object
+    }
+
     pub fn add_callback(&mut self, name: &str, full_name: &str, idx: i32, flags: u8) {
         self.callbacks.push(
             ObjectCallback {
                 cbk: ModuleCallback {
-            name: name.to_string(),
+            name: name.to_string().into(),
             full_name: full_name.to_string(),
             idx,
         }, flags});
     }
 
+    /// The callbacks of this object. The class ones if it has a class.
+    pub fn callbacks(&self) -> &[ObjectCallback] {
+        match &self.class {
+            Some(class) => &class.callbacks,
+            None => &self.callbacks
+        }
+    }
+
+    pub fn add_field(&mut self, name: &str, var: pxs_Var, writable: bool) {
+        self.fields.push(ObjectField { name: name.to_string(), var, writable });
+    }
+
+    /// The data properties of this object. The class ones if it has a class.
+    pub fn fields(&self) -> &[ObjectField] {
+        match &self.class {
+            Some(class) => &class.fields,
+            None => &self.fields
+        }
+    }
+
+    /// Is this object an instance of a `pxs_PixelClass`.
+    pub fn is_instance(&self) -> bool {
+        self.class.is_some()
+    }
+
     pub fn update_lang_ptr(&self, n_ptr: *mut c_void) {
         let mut guard = self.lang_ptr.lock().unwrap();
 
@@ -202,26 +299,6 @@ impl pxs_PixelObject {
 
         *guard = free_method;
     }
-
-    /// Add to reference counting
-    pub fn add_reference(&self) {
-        let mut guard = self.ref_count.lock().unwrap();
-        *guard += 1;
-    }
-
-    /// Remove from reference counting
-    pub fn sub_reference(&self) -> u16 {
-        let mut guard = self.ref_count.lock().unwrap();
-        *guard -= 1;
-
-        *guard
-    }
-
-    /// Check current ref count
-    pub fn current_ref_count(&self) -> u16 {
-        let guard = self.ref_count.lock().unwrap();
-        return *guard;
-    }
 }
 
 impl PtrMagic for pxs_PixelObject {}
@@ -247,16 +324,127 @@ impl Drop for pxs_PixelObject {
     }
 }
 
+/// Bits of an object id that are its slot index, the bits above are the slot generation.
+const INDEX_BITS: u32 = 22;
+const INDEX_MASK: u32 = (1 << INDEX_BITS) - 1;
+/// Generations wrap before an id could turn negative (-1 means no object).
+const GENERATION_MASK: u32 = (1 << (31 - INDEX_BITS)) - 1;
+/// `ObjectSlot::stats` of a object `objstats` does not follow.
+const NO_STATS: u32 = u32::MAX;
+
+/// A slot of the `ObjectLookup` slab.
+struct ObjectSlot {
+    /// Bumped every time the slot is freed, so ids of the old object no longer match.
+    generation: u32,
+    object: Option<Arc<pxs_PixelObject>>,
+    /// References held by vars. Not atomic, the lookup never leaves its thread.
+    refs: u32,
+    /// Index of the object type in `ObjectLookup::stats`, or `NO_STATS`.
+    stats: u32,
+}
+
 /// Lookup state structure
+///
+/// A generational slab. Ids are the slot index plus its generation, so a lookup is a bounds check and a
+/// generation compare, and a stale id finds nothing instead of a recycled slot.
 pub struct ObjectLookup {
-    /// Object hash shared between all runtimes.
-    pub object_hash: HashMap<i32, Arc<pxs_PixelObject>>,
-    /// next idx avail
-    pub next_idx: i32
+    slots: Vec<ObjectSlot>,
+    /// Freed slots, reused before the slab grows.
+    free: Vec<u32>,
+    /// Object stats of this lookup, made when the first object is added while `objstats` records.
+    stats: Option<Arc<Mutex<objstats::Table>>>,
 }
 
 impl PtrMagic for ObjectLookup {}
 
+impl ObjectLookup {
+    fn slot(&self, id: i32) -> Option<&ObjectSlot> {
+        if id < 0 {
+            return None;
+        }
+        let slot = self.slots.get((id as u32 & INDEX_MASK) as usize)?;
+        if slot.object.is_some() && slot.generation == (id as u32) >> INDEX_BITS {
+            Some(slot)
+        } else {
+            None
+        }
+    }
+
+    fn slot_mut(&mut self, id: i32) -> Option<&mut ObjectSlot> {
+        if id < 0 {
+            return None;
+        }
+        let slot = self.slots.get_mut((id as u32 & INDEX_MASK) as usize)?;
+        if slot.object.is_some() && slot.generation == (id as u32) >> INDEX_BITS {
+            Some(slot)
+        } else {
+            None
+        }
+    }
+
+    /// Add a object with one reference. -1 when the slab is full.
+    fn insert(&mut self, object: Arc<pxs_PixelObject>) -> i32 {
+        let index = match self.free.pop() {
+            Some(index) => index,
+            None => {
+                if self.slots.len() > INDEX_MASK as usize {
+                    return -1;
+                }
+                self.slots.push(ObjectSlot {
+                    generation: 0,
+                    object: None,
+                    refs: 0,
+                    stats: NO_STATS,
+                });
+                (self.slots.len() - 1) as u32
+            }
+        };
+        let stats = if objstats::enabled() {
+            let table = self.stats.get_or_insert_with(objstats::new_table);
+            table.lock().unwrap().created(&object.type_name)
+        } else {
+            NO_STATS
+        };
+        let slot = &mut self.slots[index as usize];
+        slot.object = Some(object);
+        slot.refs = 1;
+        slot.stats = stats;
+        ((slot.generation << INDEX_BITS) | index) as i32
+    }
+
+    /// Free the slot of `id` and return its object, to be dropped by the caller once the lookup is no longer borrowed.
+    fn remove(&mut self, id: i32) -> Option<Arc<pxs_PixelObject>> {
+        let slot = self.slot_mut(id)?;
+        let object = slot.object.take();
+        slot.refs = 0;
+        slot.stats = NO_STATS;
+        slot.generation = (slot.generation + 1) & GENERATION_MASK;
+        self.free.push(id as u32 & INDEX_MASK);
+        object
+    }
+
+    /// Record a reference count change of a object with `stats`, its last one when `destroyed`.
+    fn count_ref(&self, stats: u32, destroyed: bool) {
+        if stats == NO_STATS {
+            return;
+        }
+        if let Some(table) = &self.stats {
+            let mut table = table.lock().unwrap();
+            if destroyed { table.destroyed(stats) } else { table.ref_op(stats) }
+        }
+    }
+
+    fn clear(&mut self) -> Vec<ObjectSlot> {
+        for slot in &self.slots {
+            if slot.object.is_some() {
+                self.count_ref(slot.stats, true);
+            }
+        }
+        self.free.clear();
+        std::mem::take(&mut self.slots)
+    }
+}
+
 thread_local! {
     /// The object lookup!
     static OBJECT_LOOKUP: ThreadSafePointer<ObjectLookup> = ThreadSafePointer::new_owned(new_object_lookup());
@@ -264,8 +452,9 @@ thread_local! {
 
 fn new_object_lookup() -> *mut ObjectLookup {
     ObjectLookup {
-        object_hash: HashMap::new(),
-        next_idx: 0,
+        slots: vec![],
+        free: vec![],
+        stats: None,
     }.into_raw()
 }
 
@@ -279,12 +468,19 @@ fn get_object_lookup() -> *mut ObjectLookup {
 /// Apply reference counting to object in lookup.
 pub(crate) fn apply_ref_count_delete(idx: i32) {
     let lookup = get_object_lookup();
-    if let Some(object) = unsafe { (*lookup).object_hash.get(&idx) } {
-        // Check # of references
-        if object.sub_reference() == 0 {
-            unsafe{(*lookup).object_hash.remove(&idx)};
+    let removed = unsafe {
+        match (*lookup).slot_mut(idx) {
+            Some(slot) => {
+                slot.refs -= 1;
+                let (refs, stats) = (slot.refs, slot.stats);
+                (*lookup).count_ref(stats, refs == 0);
+                if refs == 0 { (*lookup).remove(idx) } else { None }
+            }
+            None => None,
         }
-    }
+    };
+    // Dropped here, freeing the object can drop vars which come back into the lookup.
+    drop(removed);
 }
 
 /// Apply reference counting to a object in lookup.
@@ -292,38 +488,62 @@ pub(crate) fn apply_ref_count_delete(idx: i32) {
 pub(crate) fn apply_ref_count_alloc(idx: i32) {
     let lookup = get_object_lookup();
     // Check for object.
-    if let Some(object) = unsafe {(*lookup).object_hash.get(&idx)} {
-        object.add_reference();
+    if let Some(slot) = unsafe { (*lookup).slot_mut(idx) } {
+        slot.refs += 1;
+        let stats = slot.stats;
+        unsafe { (*lookup).count_ref(stats, false) };
     }
 }
 
-pub(crate) fn clear_object_lookup() {
-    let lookup = get_object_lookup();
+/// Take the current threads object lookup out, leaving a empty one. Used by `pxs_RuntimePool`.
+pub(crate) fn detach_object_lookup() -> *mut ObjectLookup {
+    let lookup = new_object_lookup();
+    unsafe {
+        std::ptr::swap(lookup, get_object_lookup());
+    }
+    lookup
+}
+
+/// Make a lookup from `detach_object_lookup` the current threads lookup. The replaced one is freed.
+pub(crate) fn attach_object_lookup(lookup: *mut ObjectLookup) {
     unsafe {
-        (*lookup).object_hash.clear();
-        (*lookup).next_idx = 0;
+        std::ptr::swap(lookup, get_object_lookup());
     }
+    let _ = ObjectLookup::from_raw(lookup);
+}
+
+pub(crate) fn clear_object_lookup() {
+    let lookup = get_object_lookup();
+    let slots = unsafe { (*lookup).clear() };
+    drop(slots);
+}
+
+/// Objects in the current threads lookup, for every runtime.
+pub(crate) fn live_objects() -> usize {
+    let lookup = get_object_lookup();
+    unsafe { (*lookup).slots.len() - (*lookup).free.len() }
 }
 
 // add_object(Arc::clone(&pixel_arc))
+/// Add a object to the lookup, returns its id or -1 when there are too many objects.
 pub(crate) fn lookup_add_object(pixel_obj: Arc<pxs_PixelObject>) -> i32 {
     let lookup = get_object_lookup();
 
-    unsafe {
-        let idx = (*lookup).next_idx;
-        (*lookup).object_hash.insert(idx, Arc::clone(&pixel_obj));
-        (*lookup).next_idx += 1;
-        idx
-    }
+    unsafe { (*lookup).insert(pixel_obj) }
 }
 
 /// Get a PixelObject Arc
 pub(crate) fn get_object(idx: i32) -> Option<Arc<pxs_PixelObject>> {
     let lookup = get_object_lookup();
 
-    if let Some(res) = unsafe { (*lookup).object_hash.get(&idx) } {
-        Some(res.to_owned())
-    } else {
-        None
-    }
-}
\ No newline at end of file
+    unsafe { (*lookup).slot(idx) }.and_then(|slot| slot.object.clone())
+}
+
+/// Call `f` with a borrowed PixelObject, without cloning its Arc.
+pub(crate) fn with_object<R>(idx: i32, f: impl FnOnce(&pxs_PixelObject) -> R) -> Option<R> {
+    let lookup = get_object_lookup();
+
+    unsafe { (*lookup).slot(idx) }
+        .and_then(|slot| slot.object.as_deref())
+        .map(f)
+}
@@ -0,0 +1,154 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+//! Lifetimes and reference counting of host objects by type name (`pxs_objstats`).
+//!
+//! Off by default, the object lookup then only checks one relaxed bool when it adds an object. Every lookup records
+//! into its own table (it moves with the lookup between threads), its slots keep the index of their type in it so a
+//! reference count change is an index and an add. Objects added while off are not followed.
+use std::{
+    collections::HashMap,
+    sync::{
+        Arc, Mutex,
+        atomic::{AtomicBool, Ordering},
+    },
+    time::Instant,
+};
+
+use crate::shared::var::{pxs_Var, pxs_VarMap};
+
+static ENABLED: AtomicBool = AtomicBool::new(false);
+
+/// Objects of one type in one lookup.
+#[derive(Clone, Copy, Default)]
+pub(crate) struct TypeStats {
+    created: u64,
+    destroyed: u64,
+    /// Not `created - destroyed`, it survives `reset`.
+    live: u64,
+    peak: u64,
+    /// Reference count changes, creating and destroying included.
+    ref_ops: u64,
+}
+
+impl TypeStats {
+    fn merge(&mut self, other: &TypeStats) {
+        self.created += other.created;
+        self.destroyed += other.destroyed;
+        self.live += other.live;
+        self.peak += other.peak;
+        self.ref_ops += other.ref_ops;
+    }
+}
+
+/// Stats of one lookup, by type.
+#[derive(Default)]
+pub(crate) struct Table {
+    names: HashMap<String, u32>,
+    types: Vec<(String, TypeStats)>,
+}
+
+impl Table {
+    /// An object of `type_name` was added, returns the index its slot keeps.
+    pub(crate) fn created(&mut self, type_name: &str) -> u32 {
+        let idx = match self.names.get(type_name) {
+            Some(idx) => *idx,
+            None => {
+                self.types.push((type_name.to_string(), TypeStats::default()));
+                let idx = (self.types.len() - 1) as u32;
+                self.names.insert(type_name.to_string(), idx);
+                idx
+            }
+        };
+        let stats = &mut self.types[idx as usize].1;
+        stats.created += 1;
+        stats.live += 1;
+        stats.peak = stats.peak.max(stats.live);
+        stats.ref_ops += 1;
+        idx
+    }
+
+    pub(crate) fn ref_op(&mut self, idx: u32) {
+        if let Some((_, stats)) = self.types.get_mut(idx as usize) {
+            stats.ref_ops += 1;
+        }
+    }
+
+    pub(crate) fn destroyed(&mut self, idx: u32) {
+        if let Some((_, stats)) = self.types.get_mut(idx as usize) {
+            stats.destroyed += 1;
+            stats.live = stats.live.saturating_sub(1);
+            stats.ref_ops += 1;
+        }
+    }
+}
+
+/// Table of every lookup that recorded something. Kept after the lookup is freed, until `reset`.
+static TABLES: Mutex<Vec<Arc<Mutex<Table>>>> = Mutex::new(vec![]);
+/// Start of the `ref_ops_per_sec` window, set by turning recording on and by `reset`.
+static SINCE: Mutex<Option<Instant>> = Mutex::new(None);
+
+/// Is recording on? One relaxed load, checked before anything else.
+pub(crate) fn enabled() -> bool {
+    ENABLED.load(Ordering::Relaxed)
+}
+
+/// Turn recording on or off. What was recorded stays until `reset`.
+pub fn set_enabled(enabled: bool) {
+    if enabled {
+        SINCE.lock().unwrap().get_or_insert_with(Instant::now);
+    }
+    ENABLED.store(enabled, Ordering::Relaxed);
+}
+
+/// A new table for a lookup.
+pub(crate) fn new_table() -> Arc<Mutex<Table>> {
+    let table = Arc::new(Mutex::new(Table::default()));
+    TABLES.lock().unwrap().push(Arc::clone(&table));
+    table
+}
+
+/// Stats of every lookup merged, as `{type: {created, destroyed, live, peak, ref_ops, ref_ops_per_sec}}`.
+pub fn snapshot() -> pxs_Var {
+    let secs = SINCE.lock().unwrap().map_or(0.0, |since| since.elapsed().as_secs_f64());
+    let mut merged: HashMap<String, TypeStats> = HashMap::new();
+    for table in TABLES.lock().unwrap().iter() {
+        for (name, stats) in table.lock().unwrap().types.iter() {
+            merged.entry(name.clone()).or_default().merge(stats);
+        }
+    }
+
+    let mut types: Vec<_> = merged.into_iter().collect();
+    types.sort_by(|a, b| a.0.cmp(&b.0));
+    let mut map = pxs_VarMap::new_ordered();
+    for (name, stats) in types {
+        let mut entry = pxs_VarMap::new_ordered();
+        entry.add_str("created", pxs_Var::new_i64(stats.created as i64));
+        entry.add_str("destroyed", pxs_Var::new_i64(stats.destroyed as i64));
+        entry.add_str("live", pxs_Var::new_i64(stats.live as i64));
+        entry.add_str("peak", pxs_Var::new_i64(stats.peak as i64));
+        entry.add_str("ref_ops", pxs_Var::new_i64(stats.ref_ops as i64));
+        let per_sec = if secs > 0.0 { stats.ref_ops as f64 / secs } else { 0.0 };
+        entry.add_str("ref_ops_per_sec", pxs_Var::new_f64(per_sec));
+        map.add_str(&name, pxs_Var::new_map_with(entry));
+    }
+    pxs_Var::new_map_with(map)
+}
+
+/// Forget what was recorded and the tables of freed lookups. Live objects stay counted, peaks start from them.
+pub fn reset() {
+    let mut tables = TABLES.lock().unwrap();
+    tables.retain(|table| Arc::strong_count(table) > 1);
+    for table in tables.iter() {
+        for (_, stats) in table.lock().unwrap().types.iter_mut() {
+            *stats = TypeStats { live: stats.live, peak: stats.live, ..TypeStats::default() };
+        }
+    }
+    let mut since = SINCE.lock().unwrap();
+    *since = if enabled() { Some(Instant::now()) } else { None };
+}
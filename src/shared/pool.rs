@@ -0,0 +1,100 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+use std::{cell::RefCell, sync::Mutex};
+
+use etffi::ptr_magic::PtrMagic;
+
+use crate::shared::{deferred::Starts, func::FunctionLookup, object::ObjectLookup, pxs_Opaque};
+
+#[allow(non_camel_case_types)]
+/// Called once per runtime set in `pxs_pool_create`, while that set is the current threads state.
+/// Add modules here (`pxs_addmod`) like you would after `pxs_startthread`.
+pub type pxs_PoolSetupFn = unsafe extern "C" fn(opaque: pxs_Opaque);
+
+/// One threads worth of runtime state, taken out of the thread that made it.
+pub(crate) struct RuntimeSet {
+    pub lua: pxs_Opaque,
+    pub python: pxs_Opaque,
+    pub js: pxs_Opaque,
+    pub functions: *mut FunctionLookup,
+    pub objects: *mut ObjectLookup,
+    /// Deferred runtimes it started.
+    pub starts: Starts,
+}
+
+// A set is only ever used by the one thread that has it checked out.
+unsafe impl Send for RuntimeSet {}
+
+impl RuntimeSet {
+    pub fn empty() -> Self {
+        RuntimeSet {
+            lua: std::ptr::null_mut(),
+            python: std::ptr::null_mut(),
+            js: std::ptr::null_mut(),
+            functions: std::ptr::null_mut(),
+            objects: std::ptr::null_mut(),
+            starts: Starts::default(),
+        }
+    }
+}
+
+#[allow(non_camel_case_types)]
+/// Runtime sets made ahead of time so threads can skip `pxs_startthread`.
+pub struct pxs_RuntimePool {
+    sets: Mutex<Vec<RuntimeSet>>,
+}
+
+impl pxs_RuntimePool {
+    pub(crate) fn new(sets: Vec<RuntimeSet>) -> pxs_RuntimePool {
+        pxs_RuntimePool { sets: Mutex::new(sets) }
+    }
+
+    /// Check out a set, None when all of them are in use.
+    pub(crate) fn take(&self) -> Option<RuntimeSet> {
+        self.sets.lock().unwrap().pop()
+    }
+
+    /// Check a set back in.
+    pub(crate) fn put(&self, set: RuntimeSet) {
+        self.sets.lock().unwrap().push(set);
+    }
+
+    /// Take every set that is checked in.
+    pub(crate) fn drain(&self) -> Vec<RuntimeSet> {
+        std::mem::take(&mut *self.sets.lock().unwrap())
+    }
+}
+
+impl PtrMagic for pxs_RuntimePool {}
+
+thread_local! {
+    /// The state this thread had before `pxs_pool_acquire`, put back by `pxs_pool_release`.
+    static OWN_SET: RefCell<Option<RuntimeSet>> = RefCell::new(None);
+}
+
+/// Save this threads own set while a pooled one is in use. False if one is already saved.
+pub(crate) fn save_own_set(set: RuntimeSet) -> bool {
+    OWN_SET.with_borrow_mut(|own| {
+        if own.is_some() {
+            return false;
+        }
+        *own = Some(set);
+        true
+    })
+}
+
+/// Take back this threads own set.
+pub(crate) fn take_own_set() -> Option<RuntimeSet> {
+    OWN_SET.with_borrow_mut(|own| own.take())
+}
+
+/// Is this thread using a pooled set?
+pub(crate) fn has_own_set() -> bool {
+    OWN_SET.with_borrow(|own| own.is_some())
+}
@@ -0,0 +1,185 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+//! Sampling profiler of script calls (`pxs_profiler_start`).
+//!
+//! A sampler thread only bumps `TICK` at the asked rate. Runtimes check it from the hook they already have for
+//! budgets (the Lua count hook, the QuickJS interrupt handler, the pocketpy trace function) and when it moved take
+//! the stack of the thread, weighted by the ticks since the last sample. Time spent in host functions called by a
+//! script is counted when they return, under a `[host]` frame.
+use std::{
+    cell::{Cell, RefCell},
+    collections::HashMap,
+    sync::{
+        Arc, LazyLock, Mutex,
+        atomic::{AtomicBool, AtomicU64, Ordering},
+    },
+    thread::JoinHandle,
+    time::Duration,
+};
+
+use crate::shared::pxs_Runtime;
+
+/// Takes the frames of a runtime on this thread, outermost first.
+pub(crate) type StackFn = fn(&mut Vec<String>);
+
+/// Highest sample rate of `pxs_profiler_start`.
+pub const MAX_HZ: u32 = 10_000;
+
+static RUNNING: AtomicBool = AtomicBool::new(false);
+static TICK: AtomicU64 = AtomicU64::new(0);
+static SAMPLER: Mutex<Option<(Arc<AtomicBool>, JoinHandle<()>)>> = Mutex::new(None);
+/// Samples by collapsed stack.
+static STACKS: LazyLock<Mutex<HashMap<String, u64>>> = LazyLock::new(|| Mutex::new(HashMap::new()));
+
+/// What the thread is running, outermost first.
+enum Layer {
+    Script(pxs_Runtime, StackFn),
+    Host(String),
+}
+
+thread_local! {
+    static LAYERS: RefCell<Vec<Layer>> = const { RefCell::new(vec![]) };
+    /// `TICK` at the last sample of this thread.
+    static LAST_TICK: Cell<u64> = const { Cell::new(0) };
+}
+
+/// Is the profiler on? One relaxed load, checked before anything else.
+pub(crate) fn running() -> bool {
+    RUNNING.load(Ordering::Relaxed)
+}
+
+/// Start sampling `hz` times a second. False if it is already running or `hz` is 0.
+pub fn start(hz: u32) -> bool {
+    let mut sampler = SAMPLER.lock().unwrap();
+    if hz == 0 || sampler.is_some() {
+        return false;
+    }
+    let period = Duration::from_secs_f64(1.0 / hz.min(MAX_HZ) as f64);
+    let stop = Arc::new(AtomicBool::new(false));
+    let thread_stop = Arc::clone(&stop);
+    let handle = std::thread::spawn(move || {
+        while !thread_stop.load(Ordering::Relaxed) {
+            std::thread::sleep(period);
+            TICK.fetch_add(1, Ordering::Relaxed);
+        }
+    });
+    *sampler = Some((stop, handle));
+    RUNNING.store(true, Ordering::Relaxed);
+    true
+}
+
+/// Stop sampling and take the samples as collapsed stacks (`frame;frame;frame count` lines, most first), the input
+/// of flamegraph tools. Empty when it was not running.
+pub fn stop() -> String {
+    let sampler = SAMPLER.lock().unwrap().take();
+    let Some((stop, handle)) = sampler else {
+        return String::new();
+    };
+    RUNNING.store(false, Ordering::Relaxed);
+    stop.store(true, Ordering::Relaxed);
+    let _ = handle.join();
+
+    let stacks = std::mem::take(&mut *STACKS.lock().unwrap());
+    let mut stacks: Vec<(String, u64)> = stacks.into_iter().collect();
+    stacks.sort_by(|a, b| b.1.cmp(&a.1).then_with(|| a.0.cmp(&b.0)));
+    let mut out = String::new();
+    for (stack, count) in stacks {
+        out.push_str(&stack);
+        out.push(' ');
+        out.push_str(&count.to_string());
+        out.push('\n');
+    }
+    out
+}
+
+/// A top level call into `runtime` is starting while the profiler runs. Samples before it are not this thread's.
+pub(crate) fn enter(runtime: pxs_Runtime, stack: StackFn) {
+    LAYERS.with_borrow_mut(|layers| {
+        if layers.is_empty() {
+            LAST_TICK.set(TICK.load(Ordering::Relaxed));
+        }
+        layers.push(Layer::Script(runtime, stack));
+    });
+}
+
+/// The call from `enter` is over.
+pub(crate) fn exit() {
+    LAYERS.with_borrow_mut(|layers| {
+        layers.pop();
+    });
+}
+
+/// Frame names end up in `;` separated lines.
+fn clean(frame: &str) -> String {
+    frame.replace([';', '\n', '\r'], " ")
+}
+
+/// Take a sample when a tick passed since the last one. Called by the runtime hooks, `innermost` takes the frames
+/// of the running runtime (i.e. of the coroutine the hook is in) instead of its `StackFn`.
+pub(crate) fn poll(innermost: Option<&dyn Fn(&mut Vec<String>)>) {
+    let tick = TICK.load(Ordering::Relaxed);
+    let last = LAST_TICK.get();
+    if tick == last || !running() {
+        return;
+    }
+    LAST_TICK.set(tick);
+    sample(tick - last, innermost, None);
+}
+
+fn sample(weight: u64, innermost: Option<&dyn Fn(&mut Vec<String>)>, leaf: Option<&str>) {
+    let stack = LAYERS.with_borrow(|layers| {
+        let mut frames = vec![];
+        let mut scratch = vec![];
+        for (i, layer) in layers.iter().enumerate() {
+            match layer {
+                Layer::Script(runtime, stack) => {
+                    frames.push(format!("[{}]", runtime.name()));
+                    scratch.clear();
+                    match innermost {
+                        Some(innermost) if i + 1 == layers.len() => innermost(&mut scratch),
+                        _ => stack(&mut scratch),
+                    }
+                    frames.extend(scratch.iter().map(|frame| clean(frame)));
+                }
+                Layer::Host(name) => frames.push(format!("[host] {}", clean(name))),
+            }
+        }
+        if let Some(leaf) = leaf {
+            frames.push(format!("[host] {}", clean(leaf)));
+        }
+        frames.join(";")
+    });
+    if stack.is_empty() {
+        return;
+    }
+    *STACKS.lock().unwrap().entry(stack).or_insert(0) += weight;
+}
+
+/// Run the host function `name`, called by a script. Ticks that pass while it runs are counted to it.
+pub(crate) fn host_call<R>(name: &str, f: impl FnOnce() -> R) -> R {
+    // A call that started before the profiler.
+    if LAYERS.with_borrow(|layers| layers.is_empty()) {
+        return f();
+    }
+    // What ran before the call is the script's.
+    poll(None);
+    LAYERS.with_borrow_mut(|layers| layers.push(Layer::Host(name.to_string())));
+    let res = f();
+    LAYERS.with_borrow_mut(|layers| {
+        layers.pop();
+    });
+
+    let tick = TICK.load(Ordering::Relaxed);
+    let last = LAST_TICK.get();
+    if tick != last && running() {
+        LAST_TICK.set(tick);
+        sample(tick - last, None, Some(name));
+    }
+    res
+}
@@ -0,0 +1,192 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+use std::{
+    collections::{HashMap, VecDeque},
+    sync::{
+        Arc, Condvar, Mutex,
+        atomic::{AtomicBool, AtomicUsize, Ordering},
+    },
+    thread::JoinHandle,
+};
+
+use etffi::ptr_magic::PtrMagic;
+
+use crate::shared::{pxs_Runtime, var::pxs_Var};
+
+/// Compiled code objects of one worker, by (runtime, code).
+pub(crate) type JobCache = HashMap<(i64, String), pxs_Var>;
+
+/// What a worker thread does, given by `pxs_newscheduler`.
+pub(crate) struct WorkerHooks {
+    /// Called first on every worker thread, i.e. `pxs_startthread` and adding modules.
+    pub start: Box<dyn Fn() + Send + Sync>,
+    /// Run a job. The result must be portable (see `pxs_Var::is_portable`).
+    pub run: fn(&mut JobCache, pxs_Runtime, &str, pxs_Var) -> pxs_Var,
+    /// Called last on every worker thread, after its `JobCache` is dropped.
+    pub stop: fn(),
+}
+
+#[allow(non_camel_case_types)]
+/// The result of a `pxs_submit` job, set once by the worker that ran it.
+pub struct pxs_Future {
+    result: Mutex<Option<pxs_Var>>,
+    ready: Condvar,
+    taken: AtomicBool,
+}
+
+impl pxs_Future {
+    pub fn new() -> pxs_Future {
+        pxs_Future {
+            result: Mutex::new(None),
+            ready: Condvar::new(),
+            taken: AtomicBool::new(false),
+        }
+    }
+
+    /// Complete the future.
+    pub fn set(&self, var: pxs_Var) {
+        *self.result.lock().unwrap() = Some(var);
+        self.ready.notify_all();
+    }
+
+    /// Has the job finished?
+    pub fn is_ready(&self) -> bool {
+        self.taken.load(Ordering::Acquire) || self.result.lock().unwrap().is_some()
+    }
+
+    /// Block until the job finished and take its result. None if it was already taken.
+    pub fn wait(&self) -> Option<pxs_Var> {
+        if self.taken.load(Ordering::Acquire) {
+            return None;
+        }
+        let mut result = self.result.lock().unwrap();
+        while result.is_none() {
+            result = self.ready.wait(result).unwrap();
+        }
+        self.taken.store(true, Ordering::Release);
+        result.take()
+    }
+}
+
+/// A queued `pxs_submit`.
+struct Job {
+    runtime: pxs_Runtime,
+    code: String,
+    args: pxs_Var,
+    future: Arc<pxs_Future>,
+}
+
+/// State shared by the scheduler and its workers.
+struct Shared {
+    /// One deque per worker. The owner pops from the back, thieves take from the front.
+    deques: Vec<Mutex<VecDeque<Job>>>,
+    /// Jobs queued and not yet picked up, workers sleep on `wake` while this is 0.
+    pending: Mutex<usize>,
+    wake: Condvar,
+    stopping: AtomicBool,
+    /// Round robin for `submit`.
+    next: AtomicUsize,
+}
+
+impl Shared {
+    /// A job for worker `idx`, its own first and then stolen from the others.
+    fn find_job(&self, idx: usize) -> Option<Job> {
+        let count = self.deques.len();
+        let job = self.deques[idx].lock().unwrap().pop_back().or_else(|| {
+            (1..count).find_map(|i| self.deques[(idx + i) % count].lock().unwrap().pop_front())
+        });
+        if job.is_some() {
+            *self.pending.lock().unwrap() -= 1;
+        }
+        job
+    }
+
+    fn worker(&self, idx: usize, hooks: &WorkerHooks) {
+        (hooks.start)();
+        let mut cache = JobCache::new();
+        loop {
+            if let Some(job) = self.find_job(idx) {
+                let res = (hooks.run)(&mut cache, job.runtime, &job.code, job.args);
+                job.future.set(res);
+                continue;
+            }
+
+            let mut pending = self.pending.lock().unwrap();
+            while *pending == 0 && !self.stopping.load(Ordering::Acquire) {
+                pending = self.wake.wait(pending).unwrap();
+            }
+            // Queued jobs still run when stopping.
+            if *pending == 0 {
+                break;
+            }
+        }
+        drop(cache);
+        (hooks.stop)();
+    }
+}
+
+#[allow(non_camel_case_types)]
+/// Worker threads, each with its own runtime states, running `pxs_submit` jobs.
+pub struct pxs_Scheduler {
+    shared: Arc<Shared>,
+    workers: Vec<JoinHandle<()>>,
+}
+
+impl pxs_Scheduler {
+    pub(crate) fn new(count: usize, hooks: WorkerHooks) -> pxs_Scheduler {
+        let count = count.max(1);
+        let shared = Arc::new(Shared {
+            deques: (0..count).map(|_| Mutex::new(VecDeque::new())).collect(),
+            pending: Mutex::new(0),
+            wake: Condvar::new(),
+            stopping: AtomicBool::new(false),
+            next: AtomicUsize::new(0),
+        });
+        let hooks = Arc::new(hooks);
+        let workers = (0..count)
+            .map(|idx| {
+                let shared = Arc::clone(&shared);
+                let hooks = Arc::clone(&hooks);
+                std::thread::spawn(move || shared.worker(idx, &hooks))
+            })
+            .collect();
+
+        pxs_Scheduler { shared, workers }
+    }
+
+    /// Queue a job, returns its future.
+    pub(crate) fn submit(&self, runtime: pxs_Runtime, code: String, args: pxs_Var) -> Arc<pxs_Future> {
+        let future = Arc::new(pxs_Future::new());
+        let idx = self.shared.next.fetch_add(1, Ordering::Relaxed) % self.shared.deques.len();
+        self.shared.deques[idx].lock().unwrap().push_back(Job {
+            runtime,
+            code,
+            args,
+            future: Arc::clone(&future),
+        });
+        *self.shared.pending.lock().unwrap() += 1;
+        self.shared.wake.notify_one();
+        future
+    }
+}
+
+impl PtrMagic for pxs_Scheduler {}
+
+impl Drop for pxs_Scheduler {
+    fn drop(&mut self) {
+        {
+            let _pending = self.shared.pending.lock().unwrap();
+            self.shared.stopping.store(true, Ordering::Release);
+        }
+        self.shared.wake.notify_all();
+        for worker in self.workers.drain(..) {
+            let _ = worker.join();
+        }
+    }
+}
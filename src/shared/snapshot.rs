@@ -0,0 +1,277 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+use std::{
+    cell::Cell,
+    collections::HashMap,
+    path::PathBuf,
+    sync::{
+        Arc, LazyLock, Mutex,
+        atomic::{AtomicUsize, Ordering},
+    },
+};
+
+use crate::{
+    pxs_error,
+    shared::{PxsRes, pxs_Runtime},
+};
+
+/// First bytes of a snapshot.
+const SNAPSHOT_MAGIC: &[u8; 4] = b"PXSS";
+/// First bytes of a chunk file in the cache dir.
+const CHUNK_MAGIC: &[u8; 4] = b"PXSC";
+
+/// Precompiled chunks of one runtime, by chunk name.
+///
+/// Chunks compiled while recording are kept, `pxs_snapshot_save` writes them and stops recording. The core libs and
+/// imported modules are kept either way (`core`, `import`).
+/// A cached chunk is only used when the source it was compiled from is the same (by hash).
+struct CodeCache {
+    /// name => (source hash, bytecode). Shared so a hit does not copy the bytecode under the lock.
+    chunks: HashMap<String, (u64, Arc<[u8]>)>,
+    recording: bool,
+}
+
+/// One cache per runtime, shared by all threads so new thread states hit it too.
+static CODE_CACHES: LazyLock<Mutex<Vec<CodeCache>>> = LazyLock::new(|| {
+    Mutex::new(
+        (0..4)
+            .map(|_| CodeCache {
+                chunks: HashMap::new(),
+                recording: true,
+            })
+            .collect(),
+    )
+});
+
+/// Where chunks are persisted between runs, set by `pxs_set_cachedir`.
+///
+/// With the pixelscript version, chunk files of another version are never used.
+static CACHE_DIR: Mutex<Option<(PathBuf, u32)>> = Mutex::new(None);
+
+thread_local! {
+    /// Compiling the core libs or a imported module, see `core` and `import`.
+    static KEEP: Cell<bool> = const { Cell::new(false) };
+}
+
+/// Makes temporary chunk file names unique within the process.
+static TMP_COUNTER: AtomicUsize = AtomicUsize::new(0);
+
+/// FNV-1a, stable between builds unlike `DefaultHasher`.
+fn fnv1a(hash: u64, bytes: &[u8]) -> u64 {
+    bytes
+        .iter()
+        .fold(hash, |hash, b| (hash ^ *b as u64).wrapping_mul(0x100000001b3))
+}
+
+/// Hash of a chunks source.
+pub(crate) fn source_hash(code: &str) -> u64 {
+    fnv1a(0xcbf29ce484222325, code.as_bytes())
+}
+
+/// File in the cache dir for chunk `name` compiled from `code`.
+///
+/// The name is part of the key because the bytecode keeps it for error messages.
+fn chunk_path(dir: &PathBuf, runtime: &pxs_Runtime, name: &str, hash: u64) -> PathBuf {
+    let key = fnv1a(hash, name.as_bytes());
+    dir.join(format!("{}-{key:016x}.pxc", runtime.into_i64()))
+}
+
+/// Persist chunks in `dir`, None to only cache in memory.
+pub(crate) fn set_cache_dir(dir: Option<PathBuf>, version: u32) {
+    *CACHE_DIR.lock().unwrap() = dir.map(|dir| (dir, version));
+}
+
+/// Read a chunk file, None if missing or stale.
+///
+/// Layout: magic, version, source hash, bytecode.
+fn read_chunk_file(runtime: &pxs_Runtime, name: &str, hash: u64) -> Option<Vec<u8>> {
+    let (path, version) = {
+        let dir = CACHE_DIR.lock().unwrap();
+        let (dir, version) = dir.as_ref()?;
+        (chunk_path(dir, runtime, name, hash), *version)
+    };
+    let data = std::fs::read(path).ok()?;
+    let mut reader = Reader { data: &data };
+    if reader.take(4).ok()? != CHUNK_MAGIC
+        || reader.u32().ok()? != version
+        || reader.u64().ok()? != hash
+    {
+        return None;
+    }
+    Some(reader.data.to_vec())
+}
+
+/// Write a chunk file, if a cache dir is set. Failing to write only costs the next run a compile.
+fn write_chunk_file(runtime: &pxs_Runtime, name: &str, hash: u64, bytecode: &[u8]) {
+    let (path, version) = {
+        let dir = CACHE_DIR.lock().unwrap();
+        let Some((dir, version)) = dir.as_ref() else {
+            return;
+        };
+        (chunk_path(dir, runtime, name, hash), *version)
+    };
+    let mut out = Vec::with_capacity(bytecode.len() + 16);
+    out.extend_from_slice(CHUNK_MAGIC);
+    push_u32(&mut out, version);
+    out.extend_from_slice(&hash.to_le_bytes());
+    out.extend_from_slice(bytecode);
+
+    // Written aside and renamed so other threads and processes never read half a file.
+    let tmp = path.with_extension(format!(
+        "{}-{}.tmp",
+        std::process::id(),
+        TMP_COUNTER.fetch_add(1, Ordering::Relaxed)
+    ));
+    if std::fs::write(&tmp, &out).is_err() || std::fs::rename(&tmp, &path).is_err() {
+        let _ = std::fs::remove_file(&tmp);
+    }
+}
+
+/// Bytecode for chunk `name` compiled from `code`, if cached in memory or in the cache dir.
+pub(crate) fn cached_chunk(runtime: pxs_Runtime, name: &str, code: &str) -> Option<Arc<[u8]>> {
+    let hash = source_hash(code);
+    {
+        let caches = CODE_CACHES.lock().unwrap();
+        let cache = &caches[runtime.into_i64() as usize];
+        if let Some((cached, bytecode)) = cache.chunks.get(name) {
+            if *cached == hash {
+                return Some(Arc::clone(bytecode));
+            }
+        }
+    }
+
+    let bytecode: Arc<[u8]> = read_chunk_file(&runtime, name, hash)?.into();
+    let mut caches = CODE_CACHES.lock().unwrap();
+    let cache = &mut caches[runtime.into_i64() as usize];
+    if cache.recording || KEEP.get() {
+        cache.chunks.insert(name.to_string(), (hash, Arc::clone(&bytecode)));
+    }
+    Some(bytecode)
+}
+
+/// Run `f` keeping the chunks it compiles in memory, recording or not.
+fn keep<R>(f: impl FnOnce() -> R) -> R {
+    let outer = KEEP.replace(true);
+    let res = f();
+    KEEP.set(outer);
+    res
+}
+
+/// Run `f`, the core libs of a new VM. Chunks it compiles are always kept in memory, recording or not, so only the
+/// first VM of the process compiles them and every later `pxs_initialize` and `pxs_startthread` loads the bytecode.
+pub(crate) fn core<R>(f: impl FnOnce() -> R) -> R {
+    keep(f)
+}
+
+/// Run `f`, compiling a module for an import (`require`, `import`). Like `core`, its chunk is kept in memory so other
+/// threads, contexts and states after `pxs_clear` load the bytecode instead of parsing the file again. A changed
+/// file has another source hash and is compiled again.
+pub(crate) fn import<R>(f: impl FnOnce() -> R) -> R {
+    keep(f)
+}
+
+/// Does `runtime` want the bytecode of chunks it compiles? (Recording a snapshot, a cache dir set or the core libs)
+pub(crate) fn is_recording(runtime: pxs_Runtime) -> bool {
+    KEEP.get()
+        || CODE_CACHES.lock().unwrap()[runtime.into_i64() as usize].recording
+        || CACHE_DIR.lock().unwrap().is_some()
+}
+
+/// Keep the bytecode of chunk `name` compiled from `code`.
+pub(crate) fn record_chunk(runtime: pxs_Runtime, name: &str, code: &str, bytecode: impl Into<Arc<[u8]>>) {
+    let hash = source_hash(code);
+    let bytecode = bytecode.into();
+    write_chunk_file(&runtime, name, hash, &bytecode);
+
+    let mut caches = CODE_CACHES.lock().unwrap();
+    let cache = &mut caches[runtime.into_i64() as usize];
+    if cache.recording || KEEP.get() {
+        cache.chunks.insert(name.to_string(), (hash, bytecode));
+    }
+}
+
+fn push_u32(out: &mut Vec<u8>, val: u32) {
+    out.extend_from_slice(&val.to_le_bytes());
+}
+
+/// Write the chunks of `runtime` and stop recording.
+///
+/// Layout: magic, version, runtime, count, then per chunk: name len, name, source hash, bytecode len, bytecode.
+pub(crate) fn save(runtime: pxs_Runtime, version: u32) -> Vec<u8> {
+    let mut caches = CODE_CACHES.lock().unwrap();
+    let cache = &mut caches[runtime.into_i64() as usize];
+    cache.recording = false;
+
+    let mut out = Vec::new();
+    out.extend_from_slice(SNAPSHOT_MAGIC);
+    push_u32(&mut out, version);
+    push_u32(&mut out, runtime.into_i64() as u32);
+    push_u32(&mut out, cache.chunks.len() as u32);
+    for (name, (hash, bytecode)) in cache.chunks.iter() {
+        push_u32(&mut out, name.len() as u32);
+        out.extend_from_slice(name.as_bytes());
+        out.extend_from_slice(&hash.to_le_bytes());
+        push_u32(&mut out, bytecode.len() as u32);
+        out.extend_from_slice(bytecode);
+    }
+    out
+}
+
+/// Reads a snapshot, front to back.
+struct Reader<'a> {
+    data: &'a [u8],
+}
+
+impl<'a> Reader<'a> {
+    fn take(&mut self, len: usize) -> PxsRes<&'a [u8]> {
+        if self.data.len() < len {
+            return pxs_error!("Snapshot is truncated");
+        }
+        let (head, rest) = self.data.split_at(len);
+        self.data = rest;
+        Ok(head)
+    }
+
+    fn u32(&mut self) -> PxsRes<u32> {
+        Ok(u32::from_le_bytes(self.take(4)?.try_into().unwrap()))
+    }
+
+    fn u64(&mut self) -> PxsRes<u64> {
+        Ok(u64::from_le_bytes(self.take(8)?.try_into().unwrap()))
+    }
+}
+
+/// Load the chunks of a snapshot made by `save` into the cache of `runtime`.
+pub(crate) fn load(runtime: pxs_Runtime, version: u32, data: &[u8]) -> PxsRes<()> {
+    let mut reader = Reader { data };
+    if reader.take(4)? != SNAPSHOT_MAGIC {
+        return pxs_error!("Not a pixelscript snapshot");
+    }
+    // Bytecode formats change between engine versions.
+    if reader.u32()? != version {
+        return pxs_error!("Snapshot was made by another pixelscript version");
+    }
+    if reader.u32()? != runtime.into_i64() as u32 {
+        return pxs_error!("Snapshot was made for another runtime");
+    }
+
+    let count = reader.u32()?;
+    let mut chunks = HashMap::with_capacity(count as usize);
+    for _ in 0..count {
+        let len = reader.u32()? as usize;
+        let name = String::from_utf8_lossy(reader.take(len)?).to_string();
+        let hash = reader.u64()?;
+        let len = reader.u32()? as usize;
+        chunks.insert(name, (hash, reader.take(len)?.into()));
+    }
+
+    let mut caches = CODE_CACHES.lock().unwrap();
+    caches[runtime.into_i64() as usize].chunks.extend(chunks);
+    Ok(())
+}
@@ -0,0 +1,236 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+//! Where startup time goes (`pxs_startupstats`): the phases of `pxs_initialize` per runtime, host phases from
+//! `pxs_startupbegin` (i.e. `yoyo_init`) and every `pxs_addmod` per runtime.
+//!
+//! Always on, startup runs a handful of phases. Allocations are the new blocks and bytes of the language states
+//! (`alloc::thread_allocs`), Rust side allocations are not counted.
+use std::{cell::RefCell, sync::Mutex, time::Instant};
+
+use crate::shared::{
+    alloc, pxs_Runtime,
+    var::{pxs_Var, pxs_VarMap},
+};
+
+/// How `pxs_initialize_with` brings the runtimes up.
+#[repr(C)]
+#[allow(non_camel_case_types)]
+#[derive(Clone, Copy, Default)]
+pub struct pxs_InitOptions {
+    /// Start Lua and JS on threads of their own while Python starts on the calling thread, then move their states to
+    /// the calling thread. Startup then takes about as long as the slowest runtime instead of all of them.
+    pub parallel: bool,
+    /// Runtimes (bits of `1 << pxs_Runtime`) not started up front, each thread starts them on their first use.
+    pub deferred: u32,
+}
+
+/// Most `pxs_addmod` calls kept, for hosts that add modules all the time.
+const MAX_MODULES: usize = 1024;
+/// Most phases kept.
+const MAX_PHASES: usize = 1024;
+
+/// Time and allocations of something measured.
+#[derive(Clone, Copy, Default)]
+struct Cost {
+    ns: u64,
+    allocs: u64,
+    bytes: u64,
+}
+
+impl Cost {
+    fn add(&mut self, other: &Cost) {
+        self.ns += other.ns;
+        self.allocs += other.allocs;
+        self.bytes += other.bytes;
+    }
+
+    fn add_to(&self, map: &mut pxs_VarMap) {
+        map.add_str("ns", pxs_Var::new_i64(self.ns as i64));
+        map.add_str("allocs", pxs_Var::new_i64(self.allocs as i64));
+        map.add_str("bytes", pxs_Var::new_i64(self.bytes as i64));
+    }
+}
+
+/// Start of a measure.
+struct Mark {
+    start: Instant,
+    allocs: (u64, u64),
+}
+
+impl Mark {
+    fn now() -> Self {
+        Mark { start: Instant::now(), allocs: alloc::thread_allocs() }
+    }
+
+    fn cost(&self) -> Cost {
+        let (allocs, bytes) = alloc::thread_allocs();
+        Cost {
+            ns: u64::try_from(self.start.elapsed().as_nanos()).unwrap_or(u64::MAX),
+            allocs: allocs - self.allocs.0,
+            bytes: bytes - self.allocs.1,
+        }
+    }
+}
+
+struct Phase {
+    name: String,
+    runtime: Option<pxs_Runtime>,
+    /// Phases inside phases, 0 at the top.
+    depth: u32,
+    cost: Cost,
+}
+
+struct Module {
+    name: String,
+    functions: usize,
+    /// By `pxs_Runtime::into_i64`.
+    runtimes: [Option<Cost>; 4],
+}
+
+struct Startup {
+    initialize: Option<Cost>,
+    phases: Vec<Phase>,
+    modules: Vec<Module>,
+}
+
+static STARTUP: Mutex<Startup> = Mutex::new(Startup { initialize: None, phases: vec![], modules: vec![] });
+
+thread_local! {
+    /// Open phases of this thread, by their index in `phases` (None when it did not fit).
+    static OPEN: RefCell<Vec<(Option<usize>, Mark)>> = const { RefCell::new(vec![]) };
+}
+
+/// Open a phase named `name`, inside the open one of this thread.
+pub(crate) fn begin(runtime: Option<&pxs_Runtime>, name: &str) {
+    let depth = OPEN.with_borrow(|open| open.len()) as u32;
+    let idx = {
+        let mut startup = STARTUP.lock().unwrap();
+        if startup.phases.len() < MAX_PHASES {
+            startup.phases.push(Phase { name: name.to_string(), runtime: runtime.cloned(), depth, cost: Cost::default() });
+            Some(startup.phases.len() - 1)
+        } else {
+            None
+        }
+    };
+    OPEN.with_borrow_mut(|open| open.push((idx, Mark::now())));
+}
+
+/// Close the phase `begin` opened last on this thread. False when none is open.
+pub(crate) fn end() -> bool {
+    let Some((idx, mark)) = OPEN.with_borrow_mut(|open| open.pop()) else {
+        return false;
+    };
+    let cost = mark.cost();
+    if let Some(idx) = idx {
+        STARTUP.lock().unwrap().phases[idx].cost = cost;
+    }
+    true
+}
+
+/// Run `f` as a phase.
+pub(crate) fn phase<R>(runtime: Option<&pxs_Runtime>, name: &str, f: impl FnOnce() -> R) -> R {
+    begin(runtime, name);
+    let res = f();
+    end();
+    res
+}
+
+/// Run `f` as a phase inside the open one, i.e. a step of a runtime start. Outside of one (a state reset later on)
+/// nothing is recorded.
+pub(crate) fn step<R>(runtime: &pxs_Runtime, name: &str, f: impl FnOnce() -> R) -> R {
+    if OPEN.with_borrow(|open| open.is_empty()) {
+        return f();
+    }
+    phase(Some(runtime), name, f)
+}
+
+/// Run `f`, all of `pxs_initialize`.
+pub(crate) fn initialize<R>(f: impl FnOnce() -> R) -> R {
+    let mark = Mark::now();
+    let res = f();
+    STARTUP.lock().unwrap().initialize = Some(mark.cost());
+    res
+}
+
+/// Run `f`, adding the module `name` (with `functions` functions in all) to `runtime`.
+pub(crate) fn module<R>(name: &str, functions: usize, runtime: &pxs_Runtime, f: impl FnOnce() -> R) -> R {
+    let mark = Mark::now();
+    let res = f();
+    let cost = mark.cost();
+
+    let mut startup = STARTUP.lock().unwrap();
+    let idx = runtime.into_i64() as usize;
+    // The runtimes of one `pxs_addmod` come one after the other.
+    let same = startup.modules.last().is_some_and(|last| last.name == name && last.runtimes[idx].is_none());
+    if same {
+        startup.modules.last_mut().unwrap().runtimes[idx] = Some(cost);
+    } else if startup.modules.len() < MAX_MODULES {
+        let mut runtimes = [None; 4];
+        runtimes[idx] = Some(cost);
+        startup.modules.push(Module { name: name.to_string(), functions, runtimes });
+    }
+    res
+}
+
+/// The stats as a map, see `pxs_startupstats`.
+pub fn snapshot() -> pxs_Var {
+    let startup = STARTUP.lock().unwrap();
+    let runtimes = [pxs_Runtime::pxs_Lua, pxs_Runtime::pxs_Python, pxs_Runtime::pxs_JavaScript, pxs_Runtime::pxs_Wren];
+
+    let mut map = pxs_VarMap::new_ordered();
+    let mut initialize = pxs_VarMap::new_ordered();
+    startup.initialize.unwrap_or_default().add_to(&mut initialize);
+    map.add_str("initialize", pxs_Var::new_map_with(initialize));
+
+    let phases = startup
+        .phases
+        .iter()
+        .map(|phase| {
+            let mut entry = pxs_VarMap::new_ordered();
+            entry.add_str("name", pxs_Var::new_string(phase.name.clone()));
+            let runtime = phase.runtime.as_ref().map_or("", |runtime| runtime.name());
+            entry.add_str("runtime", pxs_Var::new_string(runtime.to_string()));
+            entry.add_str("depth", pxs_Var::new_i64(phase.depth as i64));
+            phase.cost.add_to(&mut entry);
+            pxs_Var::new_map_with(entry)
+        })
+        .collect();
+    map.add_str("phases", pxs_Var::new_list_with(phases));
+
+    let mut total = Cost::default();
+    let modules = startup
+        .modules
+        .iter()
+        .map(|module| {
+            let mut entry = pxs_VarMap::new_ordered();
+            entry.add_str("name", pxs_Var::new_string(module.name.clone()));
+            entry.add_str("functions", pxs_Var::new_i64(module.functions as i64));
+            let mut sum = Cost::default();
+            let mut by_runtime = pxs_VarMap::new_ordered();
+            for (runtime, cost) in runtimes.iter().zip(&module.runtimes) {
+                if let Some(cost) = cost {
+                    sum.add(cost);
+                    let mut cost_map = pxs_VarMap::new_ordered();
+                    cost.add_to(&mut cost_map);
+                    by_runtime.add_str(runtime.name(), pxs_Var::new_map_with(cost_map));
+                }
+            }
+            total.add(&sum);
+            sum.add_to(&mut entry);
+            entry.add_str("runtimes", pxs_Var::new_map_with(by_runtime));
+            pxs_Var::new_map_with(entry)
+        })
+        .collect();
+    map.add_str("modules", pxs_Var::new_list_with(modules));
+
+    let mut modules_total = pxs_VarMap::new_ordered();
+    total.add_to(&mut modules_total);
+    map.add_str("modules_total", pxs_Var::new_map_with(modules_total));
+    pxs_Var::new_map_with(map)
+}
@@ -0,0 +1,89 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+//! Data published by the host with `pxs_publish`, read by every runtime through `pxs_Proxy` views.
+//!
+//! A published tree is frozen once: every List and Map in it becomes a proxy, so reading a nested container in a
+//! script gives another view instead of converting it. All runtimes (and threads) read the same native copy.
+use std::{
+    collections::HashMap,
+    sync::{LazyLock, RwLock},
+};
+
+use crate::{
+    pxs_error,
+    shared::{
+        PxsRes,
+        map::MapKey,
+        var::{pxs_Var, pxs_VarMap, pxs_VarProxy, pxs_VarType},
+    },
+};
+
+/// Published views by name.
+static STORE: LazyLock<RwLock<HashMap<String, pxs_VarProxy>>> = LazyLock::new(|| RwLock::new(HashMap::new()));
+
+/// A copy of `var` where every List and Map is a proxy. Proxies are unwrapped and frozen too.
+fn freeze(var: &pxs_Var) -> pxs_Var {
+    match var.tag {
+        pxs_VarType::pxs_List => {
+            let items = var.get_list().unwrap().vars.iter().map(freeze).collect();
+            pxs_Var::new_proxy(pxs_VarProxy::new(pxs_Var::new_list_with(items)))
+        }
+        pxs_VarType::pxs_Map => {
+            let old = var.get_map().unwrap();
+            let mut map = pxs_VarMap::with_capacity(old.len());
+            for (key, value) in old.iter() {
+                match key {
+                    MapKey::Str(key) => map.add_str(key.as_str(), freeze(value)),
+                    MapKey::Var(key) => map.add_item(key.clone(), freeze(value)),
+                }
+            }
+            pxs_Var::new_proxy(pxs_VarProxy::new(pxs_Var::new_map_with(map)))
+        }
+        pxs_VarType::pxs_Proxy => freeze(var.get_proxy().unwrap().target()),
+        _ => var.clone(),
+    }
+}
+
+/// Publish `var` (a List or Map of plain data) as `name`, replacing what was published before. Views of the old data
+/// stay valid until they are collected.
+pub fn publish(name: &str, var: &pxs_Var) -> PxsRes<()> {
+    if !var.is_list() && !var.is_map() && !var.is_proxy() {
+        return pxs_error!("Can only publish a pxs_List or pxs_Map, not a {:#?}", var.tag);
+    }
+    if !var.is_portable() {
+        return pxs_error!("Published data can only hold plain values (no objects or functions)");
+    }
+
+    let frozen = freeze(var);
+    let proxy = frozen.get_proxy().unwrap().clone();
+    STORE.write().unwrap().insert(name.to_string(), proxy);
+    Ok(())
+}
+
+/// Remove `name`. False if nothing was published as `name`.
+pub fn unpublish(name: &str) -> bool {
+    STORE.write().unwrap().remove(name).is_some()
+}
+
+/// A view of the data published as `name`.
+pub fn get(name: &str) -> Option<pxs_VarProxy> {
+    STORE.read().unwrap().get(name).cloned()
+}
+
+/// Names of everything published, sorted.
+pub fn names() -> Vec<String> {
+    let mut names: Vec<String> = STORE.read().unwrap().keys().cloned().collect();
+    names.sort();
+    names
+}
+
+/// Drop everything published. Called by `pxs_finalize`.
+pub fn clear() {
+    STORE.write().unwrap().clear();
+}
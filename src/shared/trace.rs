@@ -0,0 +1,112 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+use std::{
+    cell::Cell,
+    collections::HashMap,
+    panic::Location,
+    sync::{LazyLock, Mutex},
+};
+
+use crate::shared::{intern::{self, pxs_Atom}, pxs_Runtime, var::pxs_VarType};
+
+/// Where a traced `pxs_Var` node was made.
+#[derive(Clone, Copy, PartialEq, Eq, Hash)]
+struct Site {
+    /// The `into_raw` that made the node, i.e. which C API function returned it.
+    location: &'static Location<'static>,
+    /// `pxs_settracetag` of the thread at the time, 0 for none.
+    tag: pxs_Atom,
+    /// The runtime being called on the thread at the time, -1 for none.
+    runtime: i64,
+    var_type: pxs_VarType,
+}
+
+/// Nodes are freed on other threads than they are made on, so records are global. Sharded by address to keep
+/// threads from waiting on each other.
+const SHARDS: usize = 16;
+
+static RECORDS: LazyLock<Vec<Mutex<HashMap<usize, Site>>>> =
+    LazyLock::new(|| (0..SHARDS).map(|_| Mutex::new(HashMap::new())).collect());
+
+thread_local! {
+    static TAG: Cell<pxs_Atom> = const { Cell::new(0) };
+    static RUNTIME: Cell<i64> = const { Cell::new(-1) };
+}
+
+fn shard(node: usize) -> &'static Mutex<HashMap<usize, Site>> {
+    // Nodes are at least 8 byte aligned.
+    &RECORDS[(node >> 4) % SHARDS]
+}
+
+/// Record a node handed out by `into_raw`.
+pub(crate) fn track(node: *const std::ffi::c_void, var_type: pxs_VarType, location: &'static Location<'static>) {
+    let site = Site {
+        location,
+        tag: TAG.try_with(|tag| tag.get()).unwrap_or(0),
+        runtime: RUNTIME.try_with(|rt| rt.get()).unwrap_or(-1),
+        var_type,
+    };
+    shard(node as usize).lock().unwrap().insert(node as usize, site);
+}
+
+/// Forget a node taken back by `from_raw`.
+pub(crate) fn untrack(node: *const std::ffi::c_void) {
+    shard(node as usize).lock().unwrap().remove(&(node as usize));
+}
+
+/// Tag the nodes this thread makes from now on, `None` to stop.
+pub(crate) fn set_tag(tag: Option<&str>) {
+    TAG.set(tag.map(intern::intern).unwrap_or(0));
+}
+
+/// Puts the runtime of the thread back when dropped.
+pub(crate) struct RuntimeGuard(i64);
+
+impl Drop for RuntimeGuard {
+    fn drop(&mut self) {
+        let _ = RUNTIME.try_with(|rt| rt.set(self.0));
+    }
+}
+
+/// Mark the nodes made until the guard drops as made by `runtime`.
+pub(crate) fn enter(runtime: &pxs_Runtime) -> RuntimeGuard {
+    RuntimeGuard(RUNTIME.replace(runtime.into_i64()))
+}
+
+/// Live nodes grouped by site, most first.
+pub(crate) fn report() -> String {
+    let mut sites: HashMap<Site, usize> = HashMap::new();
+    for shard in RECORDS.iter() {
+        for site in shard.lock().unwrap().values() {
+            *sites.entry(*site).or_insert(0) += 1;
+        }
+    }
+    let mut sites: Vec<(Site, usize)> = sites.into_iter().collect();
+    sites.sort_by(|a, b| b.1.cmp(&a.1));
+
+    let total: usize = sites.iter().map(|(_, count)| count).sum();
+    let mut out = format!("{total} live pxs_Vars at {} sites\n", sites.len());
+    for (site, count) in sites {
+        let runtime = match pxs_Runtime::from_i64(site.runtime) {
+            Some(pxs_Runtime::pxs_Lua) => "lua",
+            Some(pxs_Runtime::pxs_Python) => "python",
+            Some(pxs_Runtime::pxs_JavaScript) => "js",
+            Some(pxs_Runtime::pxs_Wren) => "wren",
+            None => "host",
+        };
+        out.push_str(&format!(
+            "{count:>8}  {:?}  {}:{}  {runtime}  {}\n",
+            site.var_type,
+            site.location.file(),
+            site.location.line(),
+            intern::name(site.tag).unwrap_or("-"),
+        ));
+    }
+    out
+}
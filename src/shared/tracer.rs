@@ -0,0 +1,244 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+//! Begin/end events of what pixelscript does (`pxs_settracer`), and a buffered Chrome trace writer of them
+//! (`pxs_tracewriter_start`).
+//!
+//! Both sinks are off by default, a traced spot then costs one relaxed load.
+use std::{
+    cell::Cell,
+    ffi::{CString, c_char},
+    fmt::Write,
+    sync::{
+        LazyLock, Mutex, RwLock,
+        atomic::{AtomicBool, AtomicU32, Ordering},
+    },
+    time::Instant,
+};
+
+use crate::shared::{pxs_Opaque, pxs_Runtime};
+
+/// What a trace event is about.
+#[repr(C)]
+#[allow(non_camel_case_types)]
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum pxs_TraceKind {
+    /// `pxs_exec` and `pxs_execobject`, named by the file name (`<object>` for a compiled object).
+    pxs_TraceExec,
+    /// `pxs_call` and `pxs_callv`, named by the method.
+    pxs_TraceCall,
+    /// A script importing a module file, named by its path. Finding and reading it, Lua and JS compile it here too.
+    pxs_TraceImport,
+    /// A garbage collection (`pxs_garbagecollect`, `pxs_gcstep`), named `collect` or `step`. `auto` for one the
+    /// runtime ran on its own, see `pxs_gcstats_enable`.
+    pxs_TraceGC,
+    /// A script calling a host function, named as in the lookup (`_{module}{name}`).
+    pxs_TraceHost,
+    /// A host span from `pxs_tracebegin`/`pxs_traceend`, i.e. a engine frame marker.
+    pxs_TraceMark,
+}
+
+impl pxs_TraceKind {
+    /// Category in the Chrome trace.
+    fn name(&self) -> &'static str {
+        match self {
+            pxs_TraceKind::pxs_TraceExec => "exec",
+            pxs_TraceKind::pxs_TraceCall => "call",
+            pxs_TraceKind::pxs_TraceImport => "import",
+            pxs_TraceKind::pxs_TraceGC => "gc",
+            pxs_TraceKind::pxs_TraceHost => "host",
+            pxs_TraceKind::pxs_TraceMark => "mark",
+        }
+    }
+}
+
+#[allow(non_camel_case_types)]
+/// Gets a trace event. `runtime` is a `pxs_Runtime`, -1 for `pxs_TraceMark`. `name` is only valid during the call.
+/// Called on the thread doing the work, which can be any thread.
+pub type pxs_TraceFn = unsafe extern "C" fn(opaque: pxs_Opaque, kind: pxs_TraceKind, runtime: i32, name: *const c_char);
+
+/// Callbacks of `pxs_settracer`. A NULL callback is skipped.
+#[repr(C)]
+#[allow(non_camel_case_types)]
+#[derive(Clone, Copy)]
+pub struct pxs_Tracer {
+    pub begin: Option<pxs_TraceFn>,
+    pub end: Option<pxs_TraceFn>,
+    pub opaque: pxs_Opaque,
+}
+
+// The host says its callbacks can be called from any thread.
+unsafe impl Send for pxs_Tracer {}
+unsafe impl Sync for pxs_Tracer {}
+
+/// Any sink on? Both below are only looked at when it is.
+static ACTIVE: AtomicBool = AtomicBool::new(false);
+static TRACER: RwLock<Option<pxs_Tracer>> = RwLock::new(None);
+static WRITER: Mutex<Option<Writer>> = Mutex::new(None);
+/// Time 0 of the Chrome trace.
+static EPOCH: LazyLock<Instant> = LazyLock::new(Instant::now);
+static NEXT_TID: AtomicU32 = AtomicU32::new(1);
+
+thread_local! {
+    /// Small id of this thread in the Chrome trace.
+    static TID: Cell<u32> = const { Cell::new(0) };
+}
+
+/// Events kept by the Chrome trace writer.
+struct Writer {
+    events: Vec<Event>,
+    capacity: usize,
+    dropped: u64,
+}
+
+struct Event {
+    begin: bool,
+    kind: pxs_TraceKind,
+    runtime: Option<pxs_Runtime>,
+    name: String,
+    ts_us: f64,
+    tid: u32,
+}
+
+fn update_active() {
+    let active = TRACER.read().unwrap().is_some() || WRITER.lock().unwrap().is_some();
+    ACTIVE.store(active, Ordering::Relaxed);
+}
+
+/// Is any sink on? One relaxed load, checked before anything else.
+pub(crate) fn active() -> bool {
+    ACTIVE.load(Ordering::Relaxed)
+}
+
+/// Send events to `tracer` from now on, None to stop.
+pub fn set_tracer(tracer: Option<pxs_Tracer>) {
+    *TRACER.write().unwrap() = tracer;
+    update_active();
+}
+
+/// Start buffering events for `writer_stop`, at most `capacity` of them (later ones are counted as dropped).
+/// False if it is already running or `capacity` is 0.
+pub fn writer_start(capacity: usize) -> bool {
+    {
+        let mut writer = WRITER.lock().unwrap();
+        if capacity == 0 || writer.is_some() {
+            return false;
+        }
+        LazyLock::force(&EPOCH);
+        *writer = Some(Writer { events: Vec::with_capacity(capacity.min(1 << 16)), capacity, dropped: 0 });
+    }
+    update_active();
+    true
+}
+
+/// Stop the writer and take its events as Chrome trace JSON (`chrome://tracing`, Perfetto). Empty when it was not
+/// running.
+pub fn writer_stop() -> String {
+    let writer = WRITER.lock().unwrap().take();
+    update_active();
+    let Some(writer) = writer else {
+        return String::new();
+    };
+
+    let mut out = String::from("{\"traceEvents\":[");
+    for (i, event) in writer.events.iter().enumerate() {
+        if i > 0 {
+            out.push(',');
+        }
+        let _ = write!(
+            out,
+            "{{\"name\":{},\"cat\":\"{}\",\"ph\":\"{}\",\"ts\":{:.3},\"pid\":1,\"tid\":{}",
+            json_string(&event.name),
+            event.kind.name(),
+            if event.begin { "B" } else { "E" },
+            event.ts_us,
+            event.tid
+        );
+        if let Some(runtime) = &event.runtime {
+            let _ = write!(out, ",\"args\":{{\"runtime\":\"{}\"}}", runtime.name());
+        }
+        out.push('}');
+    }
+    let _ = write!(out, "],\"displayTimeUnit\":\"ms\",\"otherData\":{{\"dropped\":{}}}}}", writer.dropped);
+    out
+}
+
+fn json_string(s: &str) -> String {
+    let mut out = String::with_capacity(s.len() + 2);
+    out.push('"');
+    for c in s.chars() {
+        match c {
+            '"' => out.push_str("\\\""),
+            '\\' => out.push_str("\\\\"),
+            c if (c as u32) < 0x20 => {
+                let _ = write!(out, "\\u{:04x}", c as u32);
+            }
+            c => out.push(c),
+        }
+    }
+    out.push('"');
+    out
+}
+
+fn thread_id() -> u32 {
+    let tid = TID.get();
+    if tid != 0 {
+        return tid;
+    }
+    let tid = NEXT_TID.fetch_add(1, Ordering::Relaxed);
+    TID.set(tid);
+    tid
+}
+
+/// `at` on the clock of the Chrome trace, in microseconds.
+pub(crate) fn epoch_us(at: Instant) -> f64 {
+    at.saturating_duration_since(*EPOCH).as_nanos() as f64 / 1000.0
+}
+
+/// Send one event to the sinks that are on.
+pub(crate) fn emit(begin: bool, kind: pxs_TraceKind, runtime: Option<&pxs_Runtime>, name: &str) {
+    // Copied out, the callback may set another tracer.
+    let tracer = *TRACER.read().unwrap();
+    if let Some(tracer) = tracer {
+        let callback = if begin { tracer.begin } else { tracer.end };
+        if let Some(callback) = callback {
+            let cname = CString::new(name.replace('\0', "")).unwrap_or_default();
+            let runtime = runtime.map_or(-1, |runtime| runtime.into_i64() as i32);
+            unsafe {
+                callback(tracer.opaque, kind, runtime, cname.as_ptr());
+            }
+        }
+    }
+
+    let mut writer = WRITER.lock().unwrap();
+    if let Some(writer) = writer.as_mut() {
+        if writer.events.len() >= writer.capacity {
+            writer.dropped += 1;
+            return;
+        }
+        writer.events.push(Event {
+            begin,
+            kind,
+            runtime: runtime.cloned(),
+            name: name.to_string(),
+            ts_us: EPOCH.elapsed().as_nanos() as f64 / 1000.0,
+            tid: thread_id(),
+        });
+    }
+}
+
+/// Run `f` between a begin and end event, when a sink is on.
+pub(crate) fn span<R>(kind: pxs_TraceKind, runtime: &pxs_Runtime, name: &str, f: impl FnOnce() -> R) -> R {
+    if !active() {
+        return f();
+    }
+    emit(true, kind, Some(runtime), name);
+    let res = f();
+    emit(false, kind, Some(runtime), name);
+    res
+}
@@ -7,13 +7,16 @@
 // Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
 //
 use std::{
-    cell::Cell, collections::HashMap, ffi::{CStr, CString, c_char, c_void}, hash::Hash, ptr,
+    cell::Cell, ffi::{CStr, CString, c_char, c_void}, hash::Hash, ptr, sync::Arc,
 };
 
 use etffi::{create_raw_string, borrow_string, ptr_magic::PtrMagic};
 
+#[cfg(feature = "pxs_trace")]
+use crate::shared::trace;
+
 use crate::{
-    pxs_error, shared::{PxsError, PxsRes, PxsResult, func::pxs_Func, object::{apply_ref_count_alloc, apply_ref_count_delete, get_object}, pxs_Runtime}
+    pxs_error, shared::{PxsError, PxsRes, PxsResult, func::pxs_Func, intern::{self, pxs_Atom}, map::{Iter, MapKey, Pairs}, object::{apply_ref_count_alloc, apply_ref_count_delete, get_object, with_object}, pxs_Runtime}
 };
 
 /// Macro for writing out the Var:: get methods.
@@ -62,7 +65,7 @@ macro_rules! write_is_methods {
 
 /// This represents the variable type that is being read or created.
 #[repr(C)]
-#[derive(Debug, PartialEq, Clone, Copy)]
+#[derive(Debug, PartialEq, Eq, Hash, Clone, Copy)]
 #[allow(non_camel_case_types)]
 pub enum pxs_VarType {
     pxs_Int64,
@@ -90,6 +93,12 @@ pub enum pxs_VarType {
     pxs_Map,
     /// Holds 1 byte of memory (u8).
     pxs_Byte,
+    /// Host memory shared with scripts without copying it.
+    /// Lua (userdata), Python (pxs_buffer), JS/easyjs (ArrayBuffer)
+    pxs_Buffer,
+    /// A List or Map that stays on the host, scripts read its items on demand.
+    /// Lua (userdata), Python (pxs_proxy), JS/easyjs (object)
+    pxs_Proxy,
 }
 
 /// A `Object` in pixelscript is wrapped with a potential host_ptr. This allows for non language specific ref counting.
@@ -155,10 +164,14 @@ impl Drop for pxs_VarObject {
 /// A `Map` in pixelscript is very simply a Key (pxs_Var) to Value (pxs_Var) pair.
 /// 
 /// In Python it's a dictionary, in Lua it's a table, and in JS it's a object.
+///
+/// Pairs iterate in the order they were added. String keys are stored without a `pxs_Var` until some other key is added.
 #[allow(non_camel_case_types)]
 pub struct pxs_VarMap {
-    /// Key of pxs_Var => value of pxs_Var.
-    map: HashMap<pxs_Var, pxs_Var>,
+    /// Key of pxs_Var => value of pxs_Var. Shared by copies until one of them changes (see `pxs_VarList::vars`).
+    map: Arc<Pairs>,
+    /// Removing a item keeps the order of the others, instead of moving the last pair in its place.
+    ordered: bool,
 }
 
 impl PtrMagic for pxs_VarMap {}
@@ -166,8 +179,22 @@ impl PtrMagic for pxs_VarMap {}
 impl pxs_VarMap {
     /// A new map
     pub fn new() -> Self {
+        Self::with_capacity(0)
+    }
+
+    /// A new map with room for `capacity` items.
+    pub fn with_capacity(capacity: usize) -> Self {
+        Self {
+            map: Arc::new(Pairs::with_capacity(capacity)),
+            ordered: false,
+        }
+    }
+
+    /// A new map that keeps insertion order when items are removed. Removing is O(n).
+    pub fn new_ordered() -> Self {
         Self {
-            map: HashMap::new(),
+            map: Arc::new(Pairs::with_capacity(0)),
+            ordered: true,
         }
     }
 
@@ -175,15 +202,22 @@ impl pxs_VarMap {
     ///
     /// Old value (if any) gets dropped.
     pub fn add_item(&mut self, key: pxs_Var, value: pxs_Var) {
-        // Drop old value.
-        let _ = self.map.insert(key, value);
+        Arc::make_mut(&mut self.map).insert(key, value);
+    }
+
+    /// Add a new item with a string key, without making a `pxs_Var` for it. `key` may not hold a nul.
+    ///
+    /// Old value (if any) gets dropped.
+    pub fn add_str(&mut self, key: &str, value: pxs_Var) {
+        Arc::make_mut(&mut self.map).insert_str(key, value);
     }
 
     /// Remove a item by key.
     /// 
     /// Old value gets dropped.
     pub fn del_item(&mut self, key: &pxs_Var) {
-        let _ = self.map.remove(key);
+        let ordered = self.ordered;
+        let _ = Arc::make_mut(&mut self.map).remove(key, ordered);
     }
 
     /// Current length of map
@@ -196,9 +230,44 @@ impl pxs_VarMap {
         self.map.get(key)
     }
 
-    /// Get keys
-    pub fn keys(&self) -> Vec<&pxs_Var> {
-        self.map.keys().collect()
+    /// Get value from a string key.
+    pub fn get_str(&self, key: &str) -> Option<&pxs_Var> {
+        self.map.get_str(key)
+    }
+
+    /// Iterate over the key value pairs.
+    pub fn iter(&self) -> Iter<'_> {
+        self.map.iter()
+    }
+
+    /// The pair at `index` in `iter` order.
+    pub fn pair_at(&self, index: usize) -> Option<(MapKey<'_>, &pxs_Var)> {
+        self.map.pair_at(index)
+    }
+
+    /// Does removing keep the order?
+    pub fn is_ordered(&self) -> bool {
+        self.ordered
+    }
+
+    /// Is the map shared with a copy?
+    pub fn is_shared(&self) -> bool {
+        Arc::strong_count(&self.map) > 1
+    }
+
+    /// Copy the pairs if they are shared, so a value can be changed in place (`pxs_mapget`).
+    pub fn unshare(&mut self) {
+        let _ = Arc::make_mut(&mut self.map);
+    }
+}
+
+impl Clone for pxs_VarMap {
+    /// Shares the pairs, they are copied on the first change.
+    fn clone(&self) -> Self {
+        Self {
+            map: Arc::clone(&self.map),
+            ordered: self.ordered,
+        }
     }
 }
 
@@ -236,7 +305,7 @@ impl pxs_FactoryHolder {
         assert!(args_clone.is_list(), "Factory args must be a list");
         // Get list and add runtime
         let args_list = args_clone.get_list().unwrap();
-        args_list.vars.insert(0, pxs_Var::new_i64(rt.into_i64()));
+        args_list.insert_item(0, pxs_Var::new_i64(rt.into_i64()));
 
         args_clone
     }
@@ -293,13 +362,40 @@ impl PtrMagic for pxs_FactoryHolder {}
 /// ```
 #[allow(non_camel_case_types)]
 pub struct pxs_VarList {
-    pub vars: Vec<pxs_Var>,
+    /// The items, shared by copies of the list (`pxs_newcopy`) until one of them changes. Change them through
+    /// `vars_mut`, which copies them first when they are shared.
+    pub vars: Arc<Vec<pxs_Var>>,
 }
 
 impl pxs_VarList {
     /// Create a new VarList
     pub fn new() -> Self {
-        pxs_VarList { vars: vec![] }
+        pxs_VarList { vars: Arc::new(vec![]) }
+    }
+
+    /// A VarList owning `vars`.
+    pub fn with_vars(vars: Vec<pxs_Var>) -> Self {
+        pxs_VarList { vars: Arc::new(vars) }
+    }
+
+    /// A empty VarList with room for `capacity` items.
+    pub fn with_capacity(capacity: usize) -> Self {
+        pxs_VarList { vars: Arc::new(Vec::with_capacity(capacity)) }
+    }
+
+    /// The items to change, copied first if another list shares them.
+    pub fn vars_mut(&mut self) -> &mut Vec<pxs_Var> {
+        Arc::make_mut(&mut self.vars)
+    }
+
+    /// Are the items shared with a copy?
+    pub fn is_shared(&self) -> bool {
+        Arc::strong_count(&self.vars) > 1
+    }
+
+    /// Copy the items if they are shared, so one can be changed in place (`pxs_listget`, `pxs_listspan`).
+    pub fn unshare(&mut self) {
+        let _ = self.vars_mut();
     }
 
     fn get_rindex(&self, index: i32) -> i32 {
@@ -312,7 +408,7 @@ impl pxs_VarList {
 
     /// Add a Var to the list. List will take ownership.
     pub fn add_item(&mut self, item: pxs_Var) {
-        self.vars.push(item);
+        self.vars_mut().push(item);
     }
 
     /// Get a Var from the list. Supports negative based indexes.
@@ -341,7 +437,7 @@ impl pxs_VarList {
         if self.vars.len() < r_index as usize {
             false
         } else {
-            self.vars[r_index as usize] = item;
+            self.vars_mut()[r_index as usize] = item;
             true
         }
     }
@@ -357,7 +453,7 @@ impl pxs_VarList {
         if self.vars.len() < r_index as usize {
             false
         } else {
-            self.vars.remove(index as usize);
+            self.vars_mut().remove(index as usize);
             true
         }
     }
@@ -369,12 +465,242 @@ impl pxs_VarList {
 
     /// Insert a item moving all the rest to the right.
     pub fn insert_item(&mut self, index: usize, item: pxs_Var) {
-        self.vars.insert(index, item);
+        self.vars_mut().insert(index, item);
+    }
+
+    /// Make room for `additional` more items.
+    pub fn reserve(&mut self, additional: usize) {
+        self.vars_mut().reserve(additional);
+    }
+
+    /// Take the items, leaving the list empty. They are copied if a copy shares them.
+    pub fn take_vars(&mut self) -> Vec<pxs_Var> {
+        Arc::try_unwrap(std::mem::take(&mut self.vars)).unwrap_or_else(|shared| (*shared).clone())
+    }
+
+    /// Move the items of `other` to the end, leaving it empty.
+    pub fn extend(&mut self, other: &mut pxs_VarList) {
+        let items = other.take_vars();
+        if self.vars.is_empty() && !self.is_shared() && self.vars.capacity() < items.len() {
+            // Take the whole vec instead of copying into a smaller one.
+            self.vars = Arc::new(items);
+            return;
+        }
+        self.vars_mut().extend(items);
+    }
+
+    /// Remove `count` items at `start` and put `items` in their place, in one shift of the rest. False when
+    /// `start` is past the end. `count` stops at the end.
+    pub fn splice(&mut self, start: usize, count: usize, items: Vec<pxs_Var>) -> bool {
+        let len = self.vars.len();
+        if start > len {
+            return false;
+        }
+        let end = start + count.min(len - start);
+        self.vars_mut().splice(start..end, items);
+        true
+    }
+
+    /// Remove every item. The memory is kept unless a copy shares the items.
+    pub fn clear(&mut self) {
+        if self.is_shared() {
+            self.vars = Arc::new(vec![]);
+        } else {
+            self.vars_mut().clear();
+        }
     }
 }
 
 impl PtrMagic for pxs_VarList {}
 
+impl Clone for pxs_VarList {
+    /// Shares the items, they are copied on the first change.
+    fn clone(&self) -> Self {
+        Self {
+            vars: Arc::clone(&self.vars),
+        }
+    }
+}
+
+/// The memory behind a `pxs_Buffer`, given back to the host once nothing uses it.
+struct BufferData {
+    data: *mut u8,
+    len: usize,
+    deleter: Option<pxs_DeleterFn>,
+    /// The memory is a boxed slice made by pixelscript (`from_vec`), not host memory.
+    owned: bool,
+}
+
+impl Drop for BufferData {
+    fn drop(&mut self) {
+        if self.owned {
+            unsafe { drop(Box::from_raw(std::ptr::slice_from_raw_parts_mut(self.data, self.len))) };
+        } else if let Some(deleter) = self.deleter {
+            unsafe { deleter(self.data as *mut c_void) };
+        }
+    }
+}
+
+/// A `Buffer` in pixelscript is host memory that vars and script values share. Clones never copy the memory.
+///
+/// Scripts keep it alive through a handle (`into_handle`), released by the runtime when its value is collected.
+#[allow(non_camel_case_types)]
+pub struct pxs_VarBuffer {
+    data: Arc<BufferData>,
+}
+
+impl PtrMagic for pxs_VarBuffer {}
+
+// The host owns the memory, and it is only read through pixelscript: Lua and Python views are read only and JS gets
+// a copy.
+unsafe impl Send for BufferData {}
+unsafe impl Sync for BufferData {}
+
+impl pxs_VarBuffer {
+    pub fn new(data: *mut u8, len: usize, deleter: Option<pxs_DeleterFn>) -> Self {
+        Self {
+            data: Arc::new(BufferData { data, len, deleter, owned: false }),
+        }
+    }
+
+    /// A buffer owning `bytes`, for memory pixelscript makes itself (i.e. `pxs_pack`).
+    pub fn from_vec(bytes: Vec<u8>) -> Self {
+        let len = bytes.len();
+        let data = Box::into_raw(bytes.into_boxed_slice()) as *mut u8;
+        Self {
+            data: Arc::new(BufferData { data, len, deleter: None, owned: true }),
+        }
+    }
+
+    /// Start of the memory.
+    pub fn data(&self) -> *mut u8 {
+        self.data.data
+    }
+
+    /// Size of the memory in bytes.
+    pub fn len(&self) -> usize {
+        self.data.len
+    }
+
+    /// The memory as a slice.
+    pub fn as_slice(&self) -> &[u8] {
+        if self.data.data.is_null() {
+            return &[];
+        }
+        unsafe { core::slice::from_raw_parts(self.data.data, self.data.len) }
+    }
+
+    /// A handle keeping the memory alive for a script value. Give it back with `release_handle`.
+    pub fn into_handle(&self) -> *mut c_void {
+        Arc::into_raw(Arc::clone(&self.data)) as *mut c_void
+    }
+
+    /// A buffer sharing the memory of `handle`, which stays valid.
+    pub unsafe fn from_handle(handle: *mut c_void) -> Self {
+        let data = handle as *const BufferData;
+        unsafe {
+            Arc::increment_strong_count(data);
+            Self { data: Arc::from_raw(data) }
+        }
+    }
+
+    /// Release a handle from `into_handle`.
+    pub unsafe fn release_handle(handle: *mut c_void) {
+        unsafe { drop(Arc::from_raw(handle as *const BufferData)) };
+    }
+}
+
+impl Clone for pxs_VarBuffer {
+    fn clone(&self) -> Self {
+        Self {
+            data: Arc::clone(&self.data),
+        }
+    }
+}
+
+/// A `Proxy` in pixelscript is a List or Map kept on the host. Scripts get a view that converts only the items
+/// they read, instead of the whole container when it is passed.
+///
+/// Like buffers, script values keep the container alive through a handle (`into_handle`). The container is read only.
+#[allow(non_camel_case_types)]
+pub struct pxs_VarProxy {
+    target: Arc<pxs_Var>,
+}
+
+impl PtrMagic for pxs_VarProxy {}
+
+impl pxs_VarProxy {
+    pub fn new(target: pxs_Var) -> Self {
+        Self {
+            target: Arc::new(target),
+        }
+    }
+
+    /// The List or Map behind the view.
+    pub fn target(&self) -> &pxs_Var {
+        &self.target
+    }
+
+    /// Number of items.
+    pub fn len(&self) -> usize {
+        if let Some(list) = self.target.get_list() {
+            list.len()
+        } else if let Some(map) = self.target.get_map() {
+            map.len()
+        } else {
+            0
+        }
+    }
+
+    /// The item at `key`. A index for lists (0 based, negative from the end), a key for maps.
+    pub fn get(&self, key: &pxs_Var) -> Option<&pxs_Var> {
+        if let Some(list) = self.target.get_list() {
+            let index = i32::try_from(key.as_i64()?).ok()?;
+            list.get_item(index)
+        } else if let Some(map) = self.target.get_map() {
+            // Only basic types hash.
+            match key.tag {
+                pxs_VarType::pxs_Int64
+                | pxs_VarType::pxs_UInt64
+                | pxs_VarType::pxs_String
+                | pxs_VarType::pxs_Bool
+                | pxs_VarType::pxs_Float64
+                | pxs_VarType::pxs_Byte => map.get_item(key),
+                _ => None,
+            }
+        } else {
+            None
+        }
+    }
+
+    /// A handle keeping the container alive for a script value. Give it back with `release_handle`.
+    pub fn into_handle(&self) -> *mut c_void {
+        Arc::into_raw(Arc::clone(&self.target)) as *mut c_void
+    }
+
+    /// A proxy of the container of `handle`, which stays valid.
+    pub unsafe fn from_handle(handle: *mut c_void) -> Self {
+        let target = handle as *const pxs_Var;
+        unsafe {
+            Arc::increment_strong_count(target);
+            Self { target: Arc::from_raw(target) }
+        }
+    }
+
+    /// Release a handle from `into_handle`.
+    pub unsafe fn release_handle(handle: *mut c_void) {
+        unsafe { drop(Arc::from_raw(handle as *const pxs_Var)) };
+    }
+}
+
+impl Clone for pxs_VarProxy {
+    fn clone(&self) -> Self {
+        Self {
+            target: Arc::clone(&self.target),
+        }
+    }
+}
+
 /// The Variables actual value union.
 #[repr(C)]
 #[allow(non_camel_case_types)]
@@ -391,7 +717,9 @@ pub union pxs_VarValue {
     pub function_val: *mut c_void,
     pub factory_val: *mut pxs_FactoryHolder,
     pub map_val: *mut pxs_VarMap,
-    pub byte_val: u8
+    pub byte_val: u8,
+    pub buffer_val: *mut pxs_VarBuffer,
+    pub proxy_val: *mut pxs_VarProxy
 }
 
 #[allow(non_camel_case_types)]
@@ -449,6 +777,7 @@ pub struct pxs_Var {
 // Rust specific functions
 impl pxs_Var {
     pub fn new(tag: pxs_VarType, value: pxs_VarValue, deleter: pxs_DeleterFn) -> Self {
+        count_var(1);
         Self {
             tag,
             value,
@@ -459,22 +788,21 @@ impl pxs_Var {
     /// Get the `t` from a `pxs_PixelObject`.
     /// This will return -1 for anything that does not have a `pxs_PixelObject` assigned.
     pub fn get_pxs_type(&self) -> i32 {
-        let object = get_object(self.get_host_idx());
-        if let Some(obj) = object {
-            obj.t
-        } else {
-            -1
-        }
+        with_object(self.get_host_idx(), |obj| obj.t).unwrap_or(-1)
+    }
+
+    /// Get the direct host pointer if the `pxs_PixelObject` has type `t`, OR null. `t` < 0 skips the check.
+    ///
+    /// One object lookup, instead of `get_pxs_type` and `get_host_ptr`.
+    pub fn get_host_ptr_of_type(&self, t: i32) -> *mut c_void {
+        with_object(self.get_host_idx(), |obj| {
+            if t < 0 || obj.t == t { obj.ptr } else { std::ptr::null_mut() }
+        }).unwrap_or(std::ptr::null_mut())
     }
 
     /// Get the direct host pointer. (Not the idx) OR null if not found!
     pub fn get_host_ptr(&self) -> *mut c_void {
-        let object = get_object(self.get_host_idx());
-        if let Some(obj) = object {
-            obj.ptr
-        } else {
-            std::ptr::null_mut()
-        }
+        with_object(self.get_host_idx(), |obj| obj.ptr).unwrap_or(std::ptr::null_mut())
     }
 
     /// Get A owned Rust string from the Var.
@@ -540,9 +868,12 @@ impl pxs_Var {
 
     /// Create a new pxs_VarList var with values.
     pub fn new_list_with(vars: Vec<pxs_Var>) -> Self {
-        let mut list = pxs_VarList::new();
-        list.vars = vars;
-        Self::new(pxs_VarType::pxs_List, pxs_VarValue{list_val: list.into_raw()}, default_deleter)
+        Self::new(pxs_VarType::pxs_List, pxs_VarValue{list_val: pxs_VarList::with_vars(vars).into_raw()}, default_deleter)
+    }
+
+    /// Create a new empty pxs_VarList var with room for `capacity` items.
+    pub fn new_list_with_capacity(capacity: usize) -> Self {
+        Self::new(pxs_VarType::pxs_List, pxs_VarValue{list_val: pxs_VarList::with_capacity(capacity).into_raw()}, default_deleter)
     }
 
     /// Create a new Function var.
@@ -573,6 +904,65 @@ impl pxs_Var {
         Self::new(pxs_VarType::pxs_Map, pxs_VarValue{map_val: pxs_VarMap::new().into_raw()}, default_deleter)
     }
 
+    /// Create a new Map var with values.
+    pub fn new_map_with(map: pxs_VarMap) -> Self {
+        Self::new(pxs_VarType::pxs_Map, pxs_VarValue{map_val: map.into_raw()}, default_deleter)
+    }
+
+    /// Create a new Buffer var.
+    pub fn new_buffer(buffer: pxs_VarBuffer) -> Self {
+        Self::new(pxs_VarType::pxs_Buffer, pxs_VarValue{buffer_val: buffer.into_raw()}, default_deleter)
+    }
+
+    /// Get the pxs_VarBuffer as a &pxs_VarBuffer
+    pub fn get_buffer(&self) -> Option<&pxs_VarBuffer> {
+        if !self.is_buffer() {
+            None
+        } else {
+            unsafe { Some(pxs_VarBuffer::from_borrow(self.value.buffer_val)) }
+        }
+    }
+
+    /// Create a new Proxy var.
+    pub fn new_proxy(proxy: pxs_VarProxy) -> Self {
+        Self::new(pxs_VarType::pxs_Proxy, pxs_VarValue{proxy_val: proxy.into_raw()}, default_deleter)
+    }
+
+    /// Get the pxs_VarProxy as a &pxs_VarProxy
+    pub fn get_proxy(&self) -> Option<&pxs_VarProxy> {
+        if !self.is_proxy() {
+            None
+        } else {
+            unsafe { Some(pxs_VarProxy::from_borrow(self.value.proxy_val)) }
+        }
+    }
+
+    /// The value of a `pxs_Int64`, `pxs_UInt64`, `pxs_Float64` or `pxs_Bool` as a i64. Same conversion as `pxs_getint`.
+    pub fn as_i64(&self) -> Option<i64> {
+        unsafe {
+            match self.tag {
+                pxs_VarType::pxs_Int64 => Some(self.value.i64_val),
+                pxs_VarType::pxs_UInt64 => Some(self.value.u64_val as i64),
+                pxs_VarType::pxs_Bool => Some(self.value.bool_val.into()),
+                pxs_VarType::pxs_Float64 => Some(self.value.f64_val as i64),
+                _ => None,
+            }
+        }
+    }
+
+    /// The value of a `pxs_Int64`, `pxs_UInt64`, `pxs_Float64` or `pxs_Bool` as a f64. Same conversion as `pxs_getfloat`.
+    pub fn as_f64(&self) -> Option<f64> {
+        unsafe {
+            match self.tag {
+                pxs_VarType::pxs_Int64 => Some(self.value.i64_val as f64),
+                pxs_VarType::pxs_UInt64 => Some(self.value.u64_val as f64),
+                pxs_VarType::pxs_Bool => Some(self.value.bool_val.into()),
+                pxs_VarType::pxs_Float64 => Some(self.value.f64_val),
+                _ => None,
+            }
+        }
+    }
+
     /// Get the IDX of the object if Host, i64, u64
     pub fn get_host_idx(&self) -> i32 {
         match self.tag {
@@ -653,17 +1043,17 @@ impl pxs_Var {
                 pxs_VarType::pxs_Exception => borrow_string!(self.value.string_val).to_string(),
                 pxs_VarType::pxs_Map => {
                     let map = self.get_map().unwrap();
-                    let keys = map.keys();
                     let mut res = String::from("{");
-                    for k in keys {
-                        let value = map.get_item(k);
+                    for (k, value) in map.iter() {
                         res.push_str(format!("{:#?}: {:#?},\n", k, value).as_str());
                     }
                     res.push_str("}");
 
                     res
                 },
-                pxs_VarType::pxs_Byte => self.value.byte_val.to_string()
+                pxs_VarType::pxs_Byte => self.value.byte_val.to_string(),
+                pxs_VarType::pxs_Buffer => format!("Buffer({})", self.get_buffer().unwrap().len()),
+                pxs_VarType::pxs_Proxy => format!("Proxy({})", self.get_proxy().unwrap().target().dbg())
             };
 
             details
@@ -707,7 +1097,30 @@ impl pxs_Var {
         is_factory, pxs_VarType::pxs_Factory;
         is_exception, pxs_VarType::pxs_Exception;
         is_map, pxs_VarType::pxs_Map;
-        is_byte, pxs_VarType::pxs_Byte
+        is_byte, pxs_VarType::pxs_Byte;
+        is_buffer, pxs_VarType::pxs_Buffer;
+        is_proxy, pxs_VarType::pxs_Proxy
+    }
+
+    /// Is this plain data that no runtime or host object owns? i.e. it can be moved to another thread.
+    ///
+    /// Int/Uint/Float/String/Bool/Null/Exception/Byte/Buffer, and List/Maps/Proxies holding only those.
+    pub fn is_portable(&self) -> bool {
+        match self.tag {
+            pxs_VarType::pxs_Byte
+            | pxs_VarType::pxs_Buffer
+            | pxs_VarType::pxs_Int64
+            | pxs_VarType::pxs_UInt64
+            | pxs_VarType::pxs_String
+            | pxs_VarType::pxs_Bool
+            | pxs_VarType::pxs_Float64
+            | pxs_VarType::pxs_Null
+            | pxs_VarType::pxs_Exception => true,
+            pxs_VarType::pxs_List => self.get_list().unwrap().vars.iter().all(|v| v.is_portable()),
+            pxs_VarType::pxs_Map => self.get_map().unwrap().iter().all(|(k, v)| k.is_portable() && v.is_portable()),
+            pxs_VarType::pxs_Proxy => self.get_proxy().unwrap().target().is_portable(),
+            _ => false,
+        }
     }
 
     /// Do a shallow copy on this variable.
@@ -766,24 +1179,25 @@ impl pxs_Var {
                     Self::new(pxs_VarType::pxs_Factory, pxs_VarValue{factory_val: f.into_raw()}, default_deleter)
                 },
                 pxs_VarType::pxs_Map => {
-                    // Our new map
-                    let mut map = pxs_VarMap::new();
                     // OG map yo!
                     let og_map = self.get_map().unwrap();
-                    // Get them keys dog
-                    let keys = og_map.keys();
-                    for k in keys {
-                        let v = og_map.get_item(k);
-                        if let Some(v) = v {
-                            //  shallow copy
-                            map.add_item(k.shallow_copy(), v.shallow_copy());
+                    // Our new map
+                    let mut map = pxs_VarMap::with_capacity(og_map.len());
+                    map.ordered = og_map.ordered;
+                    for (k, v) in og_map.iter() {
+                        //  shallow copy
+                        match k {
+                            MapKey::Str(k) => map.add_str(k.as_str(), v.shallow_copy()),
+                            MapKey::Var(k) => map.add_item(k.shallow_copy(), v.shallow_copy()),
                         }
                     }
 
                     // Follows a similar structure to pxs_List shallow copy
                     Self::new(pxs_VarType::pxs_Map, pxs_VarValue{map_val: map.into_raw()}, default_deleter)
                 },
-                pxs_VarType::pxs_Byte => self.clone()
+                pxs_VarType::pxs_Byte => self.clone(),
+                pxs_VarType::pxs_Buffer => self.clone(),
+                pxs_VarType::pxs_Proxy => self.clone()
             }
         }
     }
@@ -816,6 +1230,7 @@ impl pxs_Var {
                 size
             },
             pxs_VarType::pxs_Byte => 1,
+            pxs_VarType::pxs_Buffer => self.get_buffer().unwrap().len(),
             _ => 0
         }
     }
@@ -864,6 +1279,9 @@ impl pxs_Var {
                     let val = self.get_byte().unwrap().to_ne_bytes();
                     core::ptr::copy_nonoverlapping(val.as_ptr(), ptr, size);
                 }
+                pxs_VarType::pxs_Buffer => {
+                    core::ptr::copy_nonoverlapping(self.get_buffer().unwrap().data(), ptr, size);
+                }
                 _ => {
                     return 0;
                 }
@@ -878,6 +1296,7 @@ unsafe impl Sync for pxs_Var {}
 
 impl Drop for pxs_Var {
     fn drop(&mut self) {
+        count_var(-1);
         if self.tag == pxs_VarType::pxs_String || self.tag == pxs_VarType::pxs_Exception {
             unsafe {
                 // Free the mem
@@ -919,12 +1338,111 @@ impl Drop for pxs_Var {
             let _ = unsafe {
                 pxs_VarMap::from_raw(self.value.map_val)
             };
+        } else if self.tag == pxs_VarType::pxs_Buffer {
+            let _ = unsafe {
+                pxs_VarBuffer::from_raw(self.value.buffer_val)
+            };
+        } else if self.tag == pxs_VarType::pxs_Proxy {
+            let _ = unsafe {
+                pxs_VarProxy::from_raw(self.value.proxy_val)
+            };
         }
     }
 }
 
 impl PtrMagic for pxs_Var {}
 
+/// Most freed `pxs_Var` nodes a thread keeps for reuse.
+thread_local! {
+    /// Vars made minus vars dropped on this thread, for `pxs_memstats`.
+    static LIVE_VARS: Cell<isize> = const { Cell::new(0) };
+}
+
+fn count_var(delta: isize) {
+    // Vars can be dropped while the thread exits.
+    let _ = LIVE_VARS.try_with(|live| live.set(live.get() + delta));
+}
+
+/// Vars made minus vars dropped on this thread. Vars moved between threads (i.e. job results) count where they are made and dropped.
+pub(crate) fn live_vars() -> isize {
+    LIVE_VARS.get()
+}
+
+const VAR_POOL_SIZE: usize = 256;
+
+/// Freed `pxs_Var` allocations of a thread, deallocated when the thread exits.
+///
+/// Nodes are plain `Box` allocations, so a pooled var freed through `from_raw` is still fine.
+struct VarPool(Vec<*mut pxs_Var>);
+
+impl Drop for VarPool {
+    fn drop(&mut self) {
+        for node in self.0.drain(..) {
+            unsafe { std::alloc::dealloc(node as *mut u8, std::alloc::Layout::new::<pxs_Var>()) };
+        }
+    }
+}
+
+thread_local! {
+    static VAR_POOL: std::cell::RefCell<VarPool> = std::cell::RefCell::new(VarPool(Vec::with_capacity(VAR_POOL_SIZE)));
+}
+
+impl pxs_Var {
+    /// `PtrMagic::into_raw`, recorded for `pxs_leakreport` with the `pxs_trace` feature.
+    #[cfg_attr(feature = "pxs_trace", track_caller)]
+    pub fn into_raw(self) -> *mut pxs_Var {
+        #[cfg(feature = "pxs_trace")]
+        let (var_type, location) = (self.tag, std::panic::Location::caller());
+        let node = <pxs_Var as PtrMagic>::into_raw(self);
+        #[cfg(feature = "pxs_trace")]
+        trace::track(node as *const c_void, var_type, location);
+        node
+    }
+
+    /// `PtrMagic::from_raw`, the counterpart of `into_raw`.
+    pub fn from_raw(node: *mut pxs_Var) -> pxs_Var {
+        #[cfg(feature = "pxs_trace")]
+        trace::untrack(node as *const c_void);
+        <pxs_Var as PtrMagic>::from_raw(node)
+    }
+
+    /// `into_raw`, reusing a node freed by `from_pooled_raw` when this thread has one.
+    #[cfg_attr(feature = "pxs_trace", track_caller)]
+    pub fn into_pooled_raw(self) -> *mut pxs_Var {
+        match VAR_POOL.try_with(|pool| pool.borrow_mut().0.pop()).ok().flatten() {
+            Some(node) => {
+                #[cfg(feature = "pxs_trace")]
+                trace::track(node as *const c_void, self.tag, std::panic::Location::caller());
+                unsafe { ptr::write(node, self) };
+                node
+            }
+            None => self.into_raw(),
+        }
+    }
+
+    /// `from_raw`, keeping the node for `into_pooled_raw` instead of freeing it.
+    pub fn from_pooled_raw(node: *mut pxs_Var) -> pxs_Var {
+        #[cfg(feature = "pxs_trace")]
+        trace::untrack(node as *const c_void);
+        let var = unsafe { ptr::read(node) };
+        let kept = VAR_POOL
+            .try_with(|pool| {
+                let mut pool = pool.borrow_mut();
+                if pool.0.len() < VAR_POOL_SIZE {
+                    pool.0.push(node);
+                    true
+                } else {
+                    false
+                }
+            })
+            .unwrap_or(false);
+        if !kept {
+            unsafe { std::alloc::dealloc(node as *mut u8, std::alloc::Layout::new::<pxs_Var>()) };
+        }
+        var
+    }
+}
+
 impl Clone for pxs_Var {
     fn clone(&self) -> Self {
         unsafe {
@@ -953,16 +1471,8 @@ impl Clone for pxs_Var {
                 }
                 pxs_VarType::pxs_HostObject => pxs_Var::new_host_object(self.value.host_object_val),
                 pxs_VarType::pxs_List => {
-                    let mut list = pxs_VarList::new();
-                    // let mut list = pxs_Var::new_list();
-                    let og_list_val = pxs_VarList::from_borrow(self.value.list_val);
-
-                    // Add items of current list. i.e. transfer ownership...
-                    for item in og_list_val.vars.iter() {
-                        // Clone into new list
-                        list.add_item(item.clone());
-                    }
-
+                    // Copy on write, items are cloned once either list changes.
+                    let list = pxs_VarList::from_borrow(self.value.list_val).clone();
                     Self::new(pxs_VarType::pxs_List, pxs_VarValue{ list_val: list.into_raw()}, default_deleter)
                 }
                 pxs_VarType::pxs_Function => {
@@ -997,25 +1507,19 @@ impl Clone for pxs_Var {
                     Self::new(pxs_VarType::pxs_Exception, pxs_VarValue{string_val: new_string}, default_deleter)
                 }
                 pxs_VarType::pxs_Map => {
-                    // Our new map
-                    let mut map = pxs_VarMap::new();
-                    // OG map yo!
-                    let og_map = self.get_map().unwrap();
-                    // Get them keys dog
-                    let keys = og_map.keys();
-                    for k in keys {
-                        let v = og_map.get_item(k);
-                        if let Some(v) = v {
-                            map.add_item(k.clone(), v.clone());
-                        }
-                    }
-
-                    // Follows a similar structure to pxs_List cloning
+                    // Copy on write, like pxs_List.
+                    let map = self.get_map().unwrap().clone();
                     Self::new(pxs_VarType::pxs_Map, pxs_VarValue{map_val: map.into_raw()}, default_deleter)
                 }
                 pxs_VarType::pxs_Byte => {
                     pxs_Var::new_byte(self.value.byte_val)
                 }
+                pxs_VarType::pxs_Buffer => {
+                    pxs_Var::new_buffer(self.get_buffer().unwrap().clone())
+                }
+                pxs_VarType::pxs_Proxy => {
+                    pxs_Var::new_proxy(self.get_proxy().unwrap().clone())
+                }
             }
         }
     }
@@ -1071,6 +1575,16 @@ impl PartialEq for pxs_Var {
                 (pxs_VarType::pxs_Byte, _) => {
                     false
                 }
+                (pxs_VarType::pxs_Buffer, pxs_VarType::pxs_Buffer) => {
+                    // Same memory.
+                    self.get_buffer().unwrap().data() == other.get_buffer().unwrap().data()
+                }
+                (pxs_VarType::pxs_Buffer, _) => false,
+                (pxs_VarType::pxs_Proxy, pxs_VarType::pxs_Proxy) => {
+                    // Same container.
+                    std::ptr::eq(self.get_proxy().unwrap().target(), other.get_proxy().unwrap().target())
+                }
+                (pxs_VarType::pxs_Proxy, _) => false
             }
         }
     }
@@ -1153,14 +1667,49 @@ pub trait ObjectMethods {
     /// Call a pxs_Var function.
     fn var_call(method: &pxs_Var, args: &mut pxs_VarList) -> PxsResult;
 
+    /// Call a pxs_Var function once per args list. A failed call is a exception in its slot.
+    ///
+    /// Backends override this to convert the function and enter the runtime only once.
+    fn var_call_batch(method: &pxs_Var, batches: &mut [pxs_VarList]) -> Vec<pxs_Var> {
+        batches
+            .iter_mut()
+            .map(|args| match Self::var_call(method, args) {
+                Ok(res) => res,
+                Err(e) => pxs_Var::new_exception(e.to_string()),
+            })
+            .collect()
+    }
+
     /// Getter
     fn get(var: &pxs_Var, key: &str) -> PxsResult;
 
     /// Setter
     fn set(var: &pxs_Var, key: &str, value: &pxs_Var) -> PxsRes<()>;
 
+    /// Getter by a interned name. Backends with their own atoms override this to skip hashing `key` per call.
+    fn get_atom(var: &pxs_Var, key: pxs_Atom) -> PxsResult {
+        match intern::name(key) {
+            Some(name) => Self::get(var, name),
+            None => pxs_error!("Unknown atom: {key}"),
+        }
+    }
+
+    /// Setter by a interned name.
+    fn set_atom(var: &pxs_Var, key: pxs_Atom, value: &pxs_Var) -> PxsRes<()> {
+        match intern::name(key) {
+            Some(name) => Self::set(var, name, value),
+            None => pxs_error!("Unknown atom: {key}"),
+        }
+    }
+
     /// Get a object/function based off their name
     fn get_from_name(name: &str) -> PxsResult;
+
+    /// The key value pairs of a object, i.e. a Lua table, Python dict or JS object. Used to walk script data
+    /// (`pxs_json.encode`) without calling into script code per key.
+    fn entries(var: &pxs_Var) -> PxsRes<Vec<(pxs_Var, pxs_Var)>> {
+        pxs_error!("Can not list the entries of a {:#?}", var.tag)
+    }
 }
 
 /// Type Helper for a pxs_Var
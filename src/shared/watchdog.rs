@@ -0,0 +1,187 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+//! Soft watchdog of script calls (`pxs_setwatchdog`).
+//!
+//! Unlike a budget nothing is stopped: a `pxs_exec`, `pxs_eval`, `pxs_execobject` or `pxs_call` that ran past the
+//! threshold is reported to the host after it returns, and so is a frame (`pxs_watchdog_frame`) whose calls ran past
+//! the frame threshold together. Only the outermost call of a thread is watched, the ones inside it are part of it.
+//!
+//! Off by default, a watched spot then costs one relaxed load.
+use std::{
+    cell::{Cell, RefCell},
+    ffi::{CString, c_char},
+    sync::{
+        RwLock,
+        atomic::{AtomicBool, Ordering},
+    },
+    time::Instant,
+};
+
+use crate::shared::{pxs_Opaque, pxs_Runtime};
+
+/// A call or frame that ran too long. The strings are only valid during the callback.
+#[repr(C)]
+#[allow(non_camel_case_types)]
+pub struct pxs_SlowCall {
+    /// A `pxs_Runtime`.
+    pub runtime: i32,
+    /// As given to `pxs_exec`/`pxs_evalnamed`, `<eval>` for `pxs_eval` and `<object>` for `pxs_execobject`. Empty for
+    /// `pxs_call`/`pxs_callv`.
+    pub file: *const c_char,
+    /// The method of `pxs_call`/`pxs_callv`, empty for the others.
+    pub function: *const c_char,
+    /// How long it ran. For a frame all of its calls together.
+    pub ns: u64,
+    /// 0 for a call. For a frame the number of calls in it, `runtime`, `file`, `function` and `call_ns` are then its
+    /// slowest call.
+    pub frame_calls: u32,
+    /// How long the slowest call of a frame ran, the same as `ns` for a call.
+    pub call_ns: u64,
+}
+
+#[allow(non_camel_case_types)]
+/// Gets a call or frame that ran too long. Called on the thread that made the call, which can be any thread.
+pub type pxs_SlowFn = unsafe extern "C" fn(opaque: pxs_Opaque, call: *const pxs_SlowCall);
+
+/// Thresholds and callback of `pxs_setwatchdog`. A threshold of 0 is not watched.
+#[repr(C)]
+#[allow(non_camel_case_types)]
+#[derive(Clone, Copy)]
+pub struct pxs_Watchdog {
+    /// Report a call that ran this long or longer, in microseconds.
+    pub call_us: u64,
+    /// Report a frame whose calls ran this long or longer together, in microseconds.
+    pub frame_us: u64,
+    pub slow: Option<pxs_SlowFn>,
+    pub opaque: pxs_Opaque,
+}
+
+// The host says its callback can be called from any thread.
+unsafe impl Send for pxs_Watchdog {}
+unsafe impl Sync for pxs_Watchdog {}
+
+static ACTIVE: AtomicBool = AtomicBool::new(false);
+static WATCHDOG: RwLock<Option<pxs_Watchdog>> = RwLock::new(None);
+
+/// Calls of the frame running on a thread.
+struct Frame {
+    ns: u64,
+    calls: u32,
+    /// The slowest call. The strings keep their buffers between frames.
+    runtime: i32,
+    file: String,
+    function: String,
+    call_ns: u64,
+}
+
+thread_local! {
+    /// In a watched call.
+    static WATCHING: Cell<bool> = const { Cell::new(false) };
+    static FRAME: RefCell<Frame> = const {
+        RefCell::new(Frame { ns: 0, calls: 0, runtime: -1, file: String::new(), function: String::new(), call_ns: 0 })
+    };
+}
+
+/// Is the watchdog on? One relaxed load, checked before anything else.
+pub(crate) fn active() -> bool {
+    ACTIVE.load(Ordering::Relaxed)
+}
+
+/// Watch calls with `watchdog` from now on, None to stop.
+pub fn set_watchdog(watchdog: Option<pxs_Watchdog>) {
+    let watchdog = watchdog.filter(|watchdog| watchdog.slow.is_some() && (watchdog.call_us > 0 || watchdog.frame_us > 0));
+    ACTIVE.store(watchdog.is_some(), Ordering::Relaxed);
+    *WATCHDOG.write().unwrap() = watchdog;
+}
+
+fn report(watchdog: &pxs_Watchdog, runtime: i32, file: &str, function: &str, ns: u64, frame_calls: u32, call_ns: u64) {
+    let Some(slow) = watchdog.slow else {
+        return;
+    };
+    let cfile = CString::new(file.replace('\0', "")).unwrap_or_default();
+    let cfunction = CString::new(function.replace('\0', "")).unwrap_or_default();
+    let call = pxs_SlowCall { runtime, file: cfile.as_ptr(), function: cfunction.as_ptr(), ns, frame_calls, call_ns };
+    unsafe {
+        slow(watchdog.opaque, &call);
+    }
+}
+
+/// Run `f`, a call into `runtime` from `file` or of `function`, under the watchdog.
+pub(crate) fn watch<R>(runtime: &pxs_Runtime, file: &str, function: &str, f: impl FnOnce() -> R) -> R {
+    if !active() || WATCHING.get() {
+        return f();
+    }
+    WATCHING.set(true);
+    let start = Instant::now();
+    let res = f();
+    let ns = u64::try_from(start.elapsed().as_nanos()).unwrap_or(u64::MAX);
+    WATCHING.set(false);
+
+    // Copied out, the callback may set another watchdog.
+    let Some(watchdog) = *WATCHDOG.read().unwrap() else {
+        return res;
+    };
+    let runtime = runtime.into_i64() as i32;
+    if watchdog.frame_us > 0 {
+        FRAME.with_borrow_mut(|frame| {
+            frame.ns = frame.ns.saturating_add(ns);
+            frame.calls += 1;
+            if frame.calls == 1 || ns > frame.call_ns {
+                frame.runtime = runtime;
+                frame.file.clear();
+                frame.file.push_str(file);
+                frame.function.clear();
+                frame.function.push_str(function);
+                frame.call_ns = ns;
+            }
+        });
+    }
+    if watchdog.call_us > 0 && ns >= watchdog.call_us.saturating_mul(1000) {
+        report(&watchdog, runtime, file, function, ns, 0, ns);
+    }
+    res
+}
+
+/// End the frame of this thread and start the next one. Reports it when its calls ran past the frame threshold.
+/// Returns how long they ran, in nanoseconds.
+pub(crate) fn end_frame() -> u64 {
+    let watchdog = *WATCHDOG.read().unwrap();
+    // Taken out, the callback may make calls into this frame.
+    let frame = FRAME.with_borrow_mut(|frame| {
+        let ended = Frame {
+            ns: frame.ns,
+            calls: frame.calls,
+            runtime: frame.runtime,
+            file: std::mem::take(&mut frame.file),
+            function: std::mem::take(&mut frame.function),
+            call_ns: frame.call_ns,
+        };
+        frame.ns = 0;
+        frame.calls = 0;
+        frame.call_ns = 0;
+        ended
+    });
+    let ns = frame.ns;
+    if let Some(watchdog) = watchdog {
+        if watchdog.frame_us > 0 && frame.calls > 0 && ns >= watchdog.frame_us.saturating_mul(1000) {
+            report(&watchdog, frame.runtime, &frame.file, &frame.function, frame.ns, frame.calls, frame.call_ns);
+        }
+    }
+    // Give the buffers back, unless the callback made calls that took them.
+    let Frame { mut file, mut function, .. } = frame;
+    FRAME.with_borrow_mut(|into| {
+        if into.calls == 0 {
+            file.clear();
+            function.clear();
+            into.file = file;
+            into.function = function;
+        }
+    });
+    ns
+}
@@ -0,0 +1,79 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_alloc --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use std::{
+        ffi::c_void,
+        sync::atomic::{AtomicUsize, Ordering},
+    };
+
+    use pixelscript::{
+        pxs_finalize, pxs_initialize, pxs_setalloc, pxs_setalloctag, pxs_setfree,
+        shared::{pxs_Opaque, pxs_Runtime, utils},
+    };
+
+    unsafe extern "C" {
+        fn realloc(ptr: *mut c_void, size: usize) -> *mut c_void;
+        fn free(ptr: *mut c_void);
+    }
+
+    /// Live allocations by tag: default, Lua, Python, JS.
+    static LIVE: [AtomicUsize; 4] = [const { AtomicUsize::new(0) }; 4];
+    /// Allocations ever made by tag.
+    static TOTAL: [AtomicUsize; 4] = [const { AtomicUsize::new(0) }; 4];
+
+    fn tag_of(idx: usize) -> pxs_Opaque {
+        &LIVE[idx] as *const AtomicUsize as pxs_Opaque
+    }
+
+    fn idx_of(tag: pxs_Opaque) -> usize {
+        (0..4).find(|i| tag_of(*i) == tag).expect("Unknown tag")
+    }
+
+    unsafe extern "C" fn test_alloc(tag: pxs_Opaque, ptr: *mut c_void, size: usize) -> *mut c_void {
+        let idx = idx_of(tag);
+        if ptr.is_null() {
+            LIVE[idx].fetch_add(1, Ordering::Relaxed);
+            TOTAL[idx].fetch_add(1, Ordering::Relaxed);
+        }
+        unsafe { realloc(ptr, size) }
+    }
+
+    unsafe extern "C" fn test_free(tag: pxs_Opaque, ptr: *mut c_void) {
+        LIVE[idx_of(tag)].fetch_sub(1, Ordering::Relaxed);
+        unsafe { free(ptr) }
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_setalloc(Some(test_alloc), tag_of(0));
+        pxs_setfree(Some(test_free));
+        pxs_setalloctag(pxs_Runtime::pxs_Lua, tag_of(1));
+        pxs_setalloctag(pxs_Runtime::pxs_Python, tag_of(2));
+        pxs_setalloctag(pxs_Runtime::pxs_JavaScript, tag_of(3));
+
+        pxs_initialize();
+        utils::setup_pxs();
+
+        assert!(utils::execute_code("local t = {}\nfor i = 1, 100 do t[i] = tostring(i) end", "<alloc>", pxs_Runtime::pxs_Lua).is_null());
+        assert!(utils::execute_code("t = [str(i) for i in range(100)]", "<alloc>", pxs_Runtime::pxs_Python).is_null());
+        assert!(utils::execute_code("let t = []; for (let i = 0; i < 100; i++) { t.push(String(i)); }", "<alloc>", pxs_Runtime::pxs_JavaScript).is_null());
+
+        // Every VM went to its own arena.
+        for idx in 1..4 {
+            assert!(TOTAL[idx].load(Ordering::Relaxed) > 0, "Runtime {} did not use its tag", idx - 1);
+        }
+
+        pxs_finalize();
+    }
+}
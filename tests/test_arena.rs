@@ -13,7 +13,7 @@
 mod tests {
     use pixelscript::{
         pxs_addfunc, pxs_addmod, pxs_addvar,
-        pxs_arenaput, pxs_clear, pxs_finalize, pxs_freearena, pxs_freevar, pxs_gethost, pxs_getint,
+        pxs_arena_newstr, pxs_arenaput, pxs_arenareset, pxs_clear, pxs_finalize, pxs_freearena, pxs_freevar, pxs_gethost, pxs_getint,
         pxs_getstring, pxs_initialize, pxs_listadd, pxs_listget, pxs_map_addpair, pxs_newarena,
         pxs_newbool, pxs_newfactory, pxs_newhost, pxs_newint, pxs_newlist, pxs_newmap, pxs_newmod,
         pxs_newnull, pxs_newobject, pxs_newstring,
@@ -115,6 +115,28 @@ mod tests {
         pxs_newbool(true)
     }
 
+    fn test_reset() {
+        let arena = pxs_newarena();
+        let mut cstrgen = CStringSafe::new();
+
+        let first = pxs_arena_newstr(arena, cstrgen.new_string("first"));
+        let long = "x".repeat(10000);
+        let big = pxs_arena_newstr(arena, cstrgen.new_string(&long));
+        pxs_arenaput(arena, pxs_newint(1));
+        assert_eq!(borrow_string!(first), "first");
+        assert_eq!(borrow_string!(big), long);
+
+        // Same memory after a reset.
+        pxs_arenareset(arena);
+        let again = pxs_arena_newstr(arena, cstrgen.new_string("again"));
+        assert_eq!(again, first);
+        assert_eq!(borrow_string!(again), "again");
+
+        let var = pxs_arenaput(arena, pxs_newint(2));
+        assert_eq!(pxs_getint(var), 2);
+        pxs_freearena(arena);
+    }
+
     fn print_helper(lang: &str) {
         println!("====================== {lang} ===================");
     }
@@ -173,6 +195,8 @@ alloc(20);
         test_lua();
         print_helper("JS");
         test_js();
+        print_helper("RESET");
+        test_reset();
 
         pxs_clear();
         pxs_finalize();
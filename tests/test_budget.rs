@@ -0,0 +1,46 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_budget --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use pixelscript::{
+        pxs_finalize, pxs_initialize, pxs_setbudget,
+        shared::{pxs_Runtime, utils},
+    };
+
+    fn test_runtime(runtime: pxs_Runtime, instructions: u64, millis: u64, forever: &str, short: &str) {
+        pxs_setbudget(runtime.clone(), instructions, millis);
+
+        let res = utils::execute_code(forever, "<budget>", runtime.clone());
+        assert!(res.is_exception(), "Endless script was not stopped: {:#?}", res);
+
+        // The budget is per call, the next one starts fresh.
+        let res = utils::execute_code(short, "<budget>", runtime.clone());
+        assert!(res.is_null(), "Error is not null: {:#?}", res);
+
+        pxs_setbudget(runtime, 0, 0);
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        test_runtime(pxs_Runtime::pxs_Lua, 100_000, 0, "while true do end", "local x = 1 + 1");
+        test_runtime(pxs_Runtime::pxs_Lua, 0, 50, "while true do end", "local x = 1 + 1");
+        test_runtime(pxs_Runtime::pxs_JavaScript, 100_000, 0, "while (true) {}", "let x = 1 + 1;");
+        test_runtime(pxs_Runtime::pxs_JavaScript, 0, 50, "while (true) {}", "let x = 1 + 1;");
+        test_runtime(pxs_Runtime::pxs_Python, 0, 50, "while True:\n    pass", "x = 1 + 1");
+
+        pxs_finalize();
+    }
+}
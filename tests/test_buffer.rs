@@ -0,0 +1,98 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_buffer --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use std::sync::atomic::{AtomicUsize, Ordering};
+
+    use etffi::cstring::CStringSafe;
+    use pixelscript::{
+        pxs_addfunc, pxs_addmod, pxs_copybytes, pxs_finalize, pxs_freevar, pxs_getbuffer, pxs_getstrview, pxs_initialize,
+        pxs_listget, pxs_newbool, pxs_newbytes_borrowed, pxs_newmod, pxs_newstring, pxs_varsize,
+        shared::{pxs_Opaque, pxs_Runtime, utils, var::pxs_VarT},
+    };
+
+    static DATA: [u8; 4] = [1, 2, 3, 4];
+    static DELETED: AtomicUsize = AtomicUsize::new(0);
+
+    unsafe extern "C" fn delete_data(ptr: pxs_Opaque) {
+        assert_eq!(ptr as *const u8, DATA.as_ptr());
+        DELETED.fetch_add(1, Ordering::Relaxed);
+    }
+
+    fn new_buffer() -> pxs_VarT {
+        pxs_newbytes_borrowed(DATA.as_ptr() as pxs_Opaque, DATA.len(), Some(delete_data))
+    }
+
+    extern "C" fn buf(_args: pxs_VarT) -> pxs_VarT {
+        new_buffer()
+    }
+
+    /// Did the buffer come back as the same memory?
+    extern "C" fn same(args: pxs_VarT) -> pxs_VarT {
+        let mut len = 0;
+        let ptr = pxs_getbuffer(pxs_listget(args, 1), &mut len);
+        pxs_newbool(ptr as *const u8 == DATA.as_ptr() && len == DATA.len())
+    }
+
+    fn test_runtime(runtime: pxs_Runtime, code: &str) {
+        let res = utils::execute_code(code, "<buffer>", runtime);
+        assert!(res.is_null(), "Error is not null: {:#?}", res);
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        // Host side, no copy.
+        let host = new_buffer();
+        let mut len = 0;
+        assert_eq!(pxs_getbuffer(host, &mut len) as *const u8, DATA.as_ptr());
+        assert_eq!(len, 4);
+        assert_eq!(pxs_varsize(host), 4);
+        let mut copy = [0u8; 4];
+        pxs_copybytes(host, copy.as_mut_ptr() as pxs_Opaque);
+        assert_eq!(copy, DATA);
+        let mut view_len = 0;
+        assert_eq!(pxs_getstrview(host, &mut view_len) as *const u8, DATA.as_ptr());
+        assert_eq!(view_len, 4);
+        pxs_freevar(host);
+        assert_eq!(DELETED.load(Ordering::Relaxed), 1);
+
+        let mut cstrgen = CStringSafe::new();
+        let string = pxs_newstring(cstrgen.new_string("path/to"));
+        let view = pxs_getstrview(string, &mut view_len);
+        assert_eq!(unsafe { std::slice::from_raw_parts(view as *const u8, view_len) }, b"path/to");
+        pxs_freevar(string);
+        let test_mod = pxs_newmod(cstrgen.new_string("test"));
+        pxs_addfunc(test_mod, cstrgen.new_string("buf"), buf);
+        pxs_addfunc(test_mod, cstrgen.new_string("same"), same);
+        pxs_addmod(test_mod);
+
+        test_runtime(
+            pxs_Runtime::pxs_Lua,
+            "local t = require('test')\nlocal b = t.buf()\nassert(#b == 4 and b[1] == 1 and b[4] == 4 and b[5] == nil)\nassert(tostring(b) == '\\1\\2\\3\\4')\nassert(t.same(b))",
+        );
+        test_runtime(
+            pxs_Runtime::pxs_Python,
+            "from test import buf, same\nb = buf()\nassert len(b) == 4 and b[0] == 1 and b[-1] == 4\nassert len(b.tobytes()) == 4\nassert same(b)",
+        );
+        test_runtime(
+            pxs_Runtime::pxs_JavaScript,
+            "import {buf} from 'test';\nconst b = new Uint8Array(buf());\nif (b.length !== 4 || b[0] !== 1 || b[3] !== 4) { throw new Error('bad buffer'); }\n// A copy, DATA is read only memory.\nb[0] = 9;\nb.reverse();\nif (new Uint8Array(buf())[0] !== 1) { throw new Error('wrote host memory'); }",
+        );
+        assert_eq!(DATA, [1, 2, 3, 4]);
+
+        pxs_finalize();
+    }
+}
@@ -0,0 +1,87 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_callbatch --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use pixelscript::{
+        own_var, pxs_callbatch, pxs_callbatch_f64, pxs_finalize, pxs_freevar, pxs_getfunc,
+        pxs_initialize, pxs_listadd, pxs_newint, pxs_newlist, pxs_newstring,
+        shared::{pxs_Runtime, utils},
+    };
+    use etffi::cstring::CStringSafe;
+
+    const ROWS: usize = 100;
+
+    fn test_runtime(runtime: pxs_Runtime, script: &str) {
+        let res = utils::execute_code(script, "<callbatch>", runtime.clone());
+        assert!(res.is_null(), "Error is not null: {:#?}", res);
+
+        let mut cstrgen = CStringSafe::new();
+        let rt = pxs_newint(runtime.into_i64());
+        let func = pxs_getfunc(rt, cstrgen.new_string("score"));
+
+        // score(i, 1) per row, and one item that is not a list.
+        let batches = pxs_newlist();
+        for i in 0..ROWS {
+            let args = pxs_newlist();
+            pxs_listadd(args, pxs_newint(i as i64));
+            pxs_listadd(args, pxs_newint(1));
+            pxs_listadd(batches, args);
+        }
+        pxs_listadd(batches, pxs_newstring(cstrgen.new_string("not args")));
+
+        let results = own_var!(pxs_callbatch(rt, func, batches));
+        let list = results.get_list().expect("Expected a list of results");
+        assert_eq!(list.len(), ROWS + 1);
+        for i in 0..ROWS {
+            assert_eq!(list.get_item(i as i32).unwrap().as_i64(), Some(i as i64 * 2 + 1));
+        }
+        assert!(list.get_item(ROWS as i32).unwrap().is_exception());
+
+        // Columns
+        let xs: Vec<f64> = (0..ROWS).map(|i| i as f64).collect();
+        let ys = vec![0.5; ROWS];
+        let columns = [xs.as_ptr(), ys.as_ptr()];
+        let mut out = vec![0.0; ROWS];
+        let numbers = pxs_callbatch_f64(rt, func, columns.as_ptr(), columns.len(), ROWS, out.as_mut_ptr());
+        assert_eq!(numbers, ROWS as i32);
+        for i in 0..ROWS {
+            assert_eq!(out[i], i as f64 * 2.0 + 0.5);
+        }
+
+        pxs_freevar(func);
+        pxs_freevar(rt);
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        test_runtime(pxs_Runtime::pxs_Lua, r#"
+function score(x, y)
+    return x * 2 + y
+end
+"#);
+        test_runtime(pxs_Runtime::pxs_Python, r#"
+def score(x, y):
+    return x * 2 + y
+"#);
+        test_runtime(pxs_Runtime::pxs_JavaScript, r#"
+globalThis.score = function(x, y) {
+    return x * 2 + y;
+};
+"#);
+
+        pxs_finalize();
+    }
+}
@@ -0,0 +1,86 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_codecache --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use std::ffi::CString;
+
+    use pixelscript::{
+        pxs_finalize, pxs_initialize, pxs_set_cachedir,
+        shared::{pxs_Runtime, utils},
+    };
+
+    const LUA: &str = r#"
+local pxs = require('pxs')
+pxs.print('Cached Lua ' .. tostring(pxs.num))
+"#;
+
+    const PYTHON: &str = r#"
+import pxs
+pxs.print('Cached Python ' + str(pxs.num))
+"#;
+
+    const JS: &str = r#"
+import * as pxs from 'pxs';
+pxs.print('Cached JS ' + pxs.num);
+"#;
+
+    fn run_all() {
+        for (code, runtime) in [
+            (LUA, pxs_Runtime::pxs_Lua),
+            (PYTHON, pxs_Runtime::pxs_Python),
+            (JS, pxs_Runtime::pxs_JavaScript),
+        ] {
+            let res = utils::execute_code(code, "<codecache>", runtime);
+            assert!(res.is_null(), "Error is not null: {:#?}", res);
+        }
+    }
+
+    fn chunk_files(dir: &std::path::Path) -> Vec<std::path::PathBuf> {
+        std::fs::read_dir(dir)
+            .unwrap()
+            .map(|e| e.unwrap().path())
+            .filter(|p| p.extension().is_some_and(|e| e == "pxc"))
+            .collect()
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        let dir = std::env::temp_dir().join(format!("pxs_codecache_{}", std::process::id()));
+        let _ = std::fs::remove_dir_all(&dir);
+        std::fs::create_dir_all(&dir).unwrap();
+        let c_dir = CString::new(dir.to_string_lossy().as_bytes()).unwrap();
+
+        // Set before initializing so the core libs are persisted too.
+        pxs_set_cachedir(c_dir.as_ptr());
+        pxs_initialize();
+        utils::setup_pxs();
+
+        run_all();
+        let files = chunk_files(&dir);
+        assert!(files.len() >= 3, "Expected chunk files, got {:#?}", files);
+
+        // Same sources, now from the chunk files.
+        run_all();
+        assert_eq!(chunk_files(&dir).len(), files.len());
+
+        // A broken chunk file is compiled again instead.
+        for file in &files {
+            std::fs::write(file, b"PXSC").unwrap();
+        }
+        run_all();
+
+        pxs_set_cachedir(std::ptr::null());
+        pxs_finalize();
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+}
@@ -0,0 +1,158 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_columns --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use std::sync::atomic::{AtomicUsize, Ordering};
+
+    use pixelscript::{
+        pxs_addfunc, pxs_addmod, pxs_finalize, pxs_freevar, pxs_initialize, pxs_newcolumns, pxs_newmod, pxs_varis,
+        shared::{
+            columns::{pxs_Column, pxs_ColumnType},
+            pxs_Opaque, pxs_Runtime, utils,
+            var::{pxs_VarT, pxs_VarType},
+        },
+    };
+
+    #[repr(C)]
+    #[derive(Clone, Copy)]
+    struct Item {
+        weight: f64,
+        count: u8,
+    }
+
+    /// Host memory of 4 entities, as plain arrays plus a array of structs.
+    struct World {
+        xs: Vec<f32>,
+        ys: Vec<f32>,
+        hp: Vec<i32>,
+        items: Vec<Item>,
+    }
+
+    static mut WORLD: *mut World = std::ptr::null_mut();
+    static FREES: AtomicUsize = AtomicUsize::new(0);
+
+    unsafe extern "C" fn count_free(_owner: pxs_Opaque) {
+        FREES.fetch_add(1, Ordering::SeqCst);
+    }
+
+    fn world() -> &'static mut World {
+        unsafe { &mut *WORLD }
+    }
+
+    fn columns(world: &mut World) -> Vec<pxs_Column> {
+        let stride = std::mem::size_of::<Item>();
+        vec![
+            pxs_Column { name: c"x".as_ptr(), kind: pxs_ColumnType::pxs_ColF32, data: world.xs.as_mut_ptr() as pxs_Opaque, stride: 0 },
+            pxs_Column { name: c"y".as_ptr(), kind: pxs_ColumnType::pxs_ColF32, data: world.ys.as_mut_ptr() as pxs_Opaque, stride: 0 },
+            pxs_Column { name: c"hp".as_ptr(), kind: pxs_ColumnType::pxs_ColI32, data: world.hp.as_mut_ptr() as pxs_Opaque, stride: 0 },
+            pxs_Column {
+                name: c"weight".as_ptr(),
+                kind: pxs_ColumnType::pxs_ColF64,
+                data: &mut world.items[0].weight as *mut f64 as pxs_Opaque,
+                stride,
+            },
+            pxs_Column {
+                name: c"count".as_ptr(),
+                kind: pxs_ColumnType::pxs_ColU8,
+                data: &mut world.items[0].count as *mut u8 as pxs_Opaque,
+                stride,
+            },
+        ]
+    }
+
+    /// `world.view()` a column view of the world.
+    extern "C" fn view(_args: pxs_VarT) -> pxs_VarT {
+        let world = world();
+        let columns = columns(world);
+        pxs_newcolumns(world.xs.len(), columns.as_ptr(), columns.len(), std::ptr::null_mut(), Some(count_free))
+    }
+
+    fn test_runtime(runtime: pxs_Runtime, code: &str) {
+        let res = utils::execute_code(code, "<columns>", runtime);
+        assert!(res.is_null(), "Error is not null: {:#?}", res);
+    }
+
+    fn test_errors() {
+        let world = world();
+        let mut columns = columns(world);
+        columns[1].name = c"x".as_ptr();
+        let frees = FREES.load(Ordering::SeqCst);
+        let res = pxs_newcolumns(4, columns.as_ptr(), columns.len(), std::ptr::null_mut(), Some(count_free));
+        assert!(pxs_varis(res, pxs_VarType::pxs_Exception));
+        assert_eq!(FREES.load(Ordering::SeqCst), frees + 1, "owner is freed on errors");
+        pxs_freevar(res);
+
+        columns[1].name = c"y".as_ptr();
+        columns[3].stride = 4;
+        let res = pxs_newcolumns(4, columns.as_ptr(), columns.len(), std::ptr::null_mut(), None);
+        assert!(pxs_varis(res, pxs_VarType::pxs_Exception));
+        pxs_freevar(res);
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        let item = Item { weight: 0.5, count: 1 };
+        unsafe {
+            WORLD = Box::into_raw(Box::new(World {
+                xs: vec![0.0, 1.0, 2.0, 3.0],
+                ys: vec![0.0; 4],
+                hp: vec![100; 4],
+                items: vec![item; 4],
+            }));
+        }
+
+        let module = pxs_newmod(c"world".as_ptr());
+        pxs_addfunc(module, c"view".as_ptr(), view);
+        pxs_addmod(module);
+
+        test_errors();
+
+        test_runtime(
+            pxs_Runtime::pxs_Lua,
+            "local world = require('world')\nlocal v = world.view()\nassert(v:len() == 4 and v:fields()[3] == 'hp')\nassert(v:get('x', 3) == 3 and v:get(0, -1) == 3)\nv:set('hp', 0, 250.6)\nv:write('y', 1, {5, 6, 7})\nassert(not pcall(function() v:get('x', 4) end))\nassert(not pcall(function() v:write('y', 2, {1, 2, 3}) end))",
+        );
+        {
+            let world = world();
+            assert_eq!(world.hp[0], 251);
+            assert_eq!(world.ys, vec![0.0, 5.0, 6.0, 7.0]);
+        }
+
+        test_runtime(
+            pxs_Runtime::pxs_Python,
+            "from world import view\nv = view()\nxs = v.read('x')\nassert xs == [0.0, 1.0, 2.0, 3.0]\nv.write('x', 0, [x * 2 for x in xs])\nassert v.read('y', 2) == [6.0, 7.0]\nv.fill('count', 300)\nv.set('weight', 2, 4.25)\nassert v.read('weight', 1, 2) == [0.5, 4.25]\nassert len(v.read_bytes('hp')) == 16",
+        );
+        {
+            let world = world();
+            assert_eq!(world.xs, vec![0.0, 2.0, 4.0, 6.0]);
+            assert!(world.items.iter().all(|item| item.count == 255));
+            assert_eq!(world.items[2].weight, 4.25);
+        }
+
+        test_runtime(
+            pxs_Runtime::pxs_JavaScript,
+            "import { view } from 'world';\nlet v = view();\nv.write('hp', 1, v.read_bytes('hp', 0, 3));\nv.fill('hp', -5, 3);\nlet threw = false;\ntry { v.set('missing', 0, 1); } catch (e) { threw = true; }\nif (!threw) { throw 'missing field did not throw'; }",
+        );
+        {
+            let world = world();
+            assert_eq!(world.hp, vec![251, 251, 100, -5]);
+        }
+
+        pxs_finalize();
+        unsafe {
+            let _ = Box::from_raw(WORLD);
+        }
+    }
+}
@@ -0,0 +1,71 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_context --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use pixelscript::{
+        pxs_finalize, pxs_freecontext, pxs_initialize, pxs_newcontext, pxs_setcontext,
+        shared::{pxs_Opaque, pxs_Runtime, utils},
+    };
+
+    unsafe extern "C" fn setup(_opaque: pxs_Opaque) {
+        utils::setup_pxs();
+    }
+
+    fn run(script: &str, runtime: pxs_Runtime) -> bool {
+        utils::execute_code(script, "<test>", runtime).is_null()
+    }
+
+    /// Define `owner` in every language, checking the last definition was this contexts own.
+    fn test_owner(owner: i32, first: bool) {
+        let lua = if first { "assert(owner == nil)".to_string() } else { format!("assert(owner == {owner})") };
+        let python = if first { "assert 'owner' not in globals()".to_string() } else { format!("assert owner == {owner}") };
+        let js = if first {
+            "if (globalThis.owner !== undefined) { throw new Error('shared'); }".to_string()
+        } else {
+            format!("if (globalThis.owner !== {owner}) {{ throw new Error('shared'); }}")
+        };
+
+        assert!(run(&format!("{lua}\nlocal pxs = require('pxs')\nowner = {owner}"), pxs_Runtime::pxs_Lua));
+        assert!(run(&format!("{python}\nfrom pxs import *\nowner = {owner}"), pxs_Runtime::pxs_Python));
+        assert!(run(&format!("{js}\nglobalThis.owner = {owner};"), pxs_Runtime::pxs_JavaScript));
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        let contexts: Vec<_> = (0..2).map(|_| pxs_newcontext(Some(setup), std::ptr::null_mut())).collect();
+
+        test_owner(-1, true);
+        for (i, context) in contexts.iter().enumerate() {
+            assert!(pxs_setcontext(*context));
+            test_owner(i as i32, true);
+        }
+        // Switching back finds each context as it was left.
+        for (i, context) in contexts.iter().enumerate() {
+            assert!(pxs_setcontext(*context));
+            test_owner(i as i32, false);
+        }
+        assert!(pxs_setcontext(std::ptr::null_mut()));
+        test_owner(-1, false);
+
+        // Current on this thread, so it goes back to the own state first.
+        assert!(pxs_setcontext(contexts[0]));
+        pxs_freecontext(contexts[0]);
+        test_owner(-1, false);
+        pxs_freecontext(contexts[1]);
+
+        pxs_finalize();
+    }
+}
@@ -128,13 +128,13 @@ pxs_mem.memdel(p)
 import {print, encode, decode} from 'core';
 import { memdel, mem_delall } from 'pxs_mem';
 import { Per } from 'pxs';
-// import * as pxs_json from 'pxs_json';
+import * as pxs_json from 'pxs_json';
 let obj = {one: 1, two: 2};
-// let encoded = pxs_json.encode(obj);
-// print(`encoded: ${encoded}`);
-// let decoded = pxs_json.decode(encoded);
-// print(decoded.one);
-// print(decoded.two);
+let encoded = pxs_json.encode(obj);
+print(`encoded: ${encoded}`);
+let decoded = pxs_json.decode(encoded);
+print(decoded.one);
+print(decoded.two);
 
 let encoded2 = encode(obj);
 let decoded2 = decode(encoded2);
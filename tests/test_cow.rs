@@ -0,0 +1,114 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_cow --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use etffi::cstring::CStringSafe;
+    use pixelscript::{
+        pxs_finalize, pxs_freevar, pxs_getint, pxs_initialize, pxs_listadd, pxs_listget, pxs_listlen, pxs_listset,
+        pxs_map_addpair, pxs_mapget, pxs_maplen, pxs_newcopy, pxs_newint, pxs_newlist, pxs_newmap, pxs_newstring,
+        shared::utils,
+    };
+
+    #[test]
+    fn test_list() {
+        pxs_initialize();
+        utils::setup_pxs();
+
+        let inner = pxs_newlist();
+        pxs_listadd(inner, pxs_newint(1));
+        let list = pxs_newlist();
+        pxs_listadd(list, pxs_newint(0));
+        pxs_listadd(list, inner);
+
+        // Borrowing a item unshares, it can be changed through the pointer.
+        let copy = pxs_newcopy(list);
+        assert_ne!(pxs_listget(list, 1), pxs_listget(copy, 1));
+
+        pxs_listadd(copy, pxs_newint(2));
+        assert_eq!(pxs_listlen(list), 2);
+        assert_eq!(pxs_listlen(copy), 3);
+        assert_ne!(pxs_listget(list, 1), pxs_listget(copy, 1));
+
+        // Nested lists are copied on their own change.
+        pxs_listset(pxs_listget(copy, 1), 0, pxs_newint(5));
+        assert_eq!(pxs_getint(pxs_listget(pxs_listget(list, 1), 0)), 1);
+        assert_eq!(pxs_getint(pxs_listget(pxs_listget(copy, 1), 0)), 5);
+
+        pxs_freevar(list);
+        assert_eq!(pxs_listlen(copy), 3);
+        pxs_freevar(copy);
+
+        pxs_finalize();
+    }
+
+    #[test]
+    fn test_map() {
+        pxs_initialize();
+        utils::setup_pxs();
+
+        let mut cstrgen = CStringSafe::new();
+        let map = pxs_newmap();
+        pxs_map_addpair(map, pxs_newstring(cstrgen.new_string("a")), pxs_newint(1));
+
+        let copy = pxs_newcopy(map);
+        let key = pxs_newstring(cstrgen.new_string("a"));
+        assert_ne!(pxs_mapget(map, key), pxs_mapget(copy, key));
+
+        pxs_map_addpair(copy, pxs_newstring(cstrgen.new_string("b")), pxs_newint(2));
+        assert_eq!(pxs_maplen(map), 1);
+        assert_eq!(pxs_maplen(copy), 2);
+
+        pxs_freevar(key);
+        pxs_freevar(map);
+        pxs_freevar(copy);
+
+        pxs_finalize();
+    }
+
+    #[test]
+    fn test_nested_only() {
+        pxs_initialize();
+        utils::setup_pxs();
+
+        let inner = pxs_newlist();
+        pxs_listadd(inner, pxs_newint(1));
+        let list = pxs_newlist();
+        pxs_listadd(list, pxs_newint(0));
+        pxs_listadd(list, inner);
+
+        // Only the nested list of the copy changes, the top level is never written to.
+        let copy = pxs_newcopy(list);
+        pxs_listset(pxs_listget(copy, 1), 0, pxs_newint(5));
+        assert_eq!(pxs_getint(pxs_listget(pxs_listget(list, 1), 0)), 1);
+        assert_eq!(pxs_getint(pxs_listget(pxs_listget(copy, 1), 0)), 5);
+
+        let mut cstrgen = CStringSafe::new();
+        let map = pxs_newmap();
+        let nested = pxs_newlist();
+        pxs_listadd(nested, pxs_newint(1));
+        pxs_map_addpair(map, pxs_newstring(cstrgen.new_string("a")), nested);
+
+        let map_copy = pxs_newcopy(map);
+        let key = pxs_newstring(cstrgen.new_string("a"));
+        pxs_listset(pxs_mapget(map_copy, key), 0, pxs_newint(5));
+        assert_eq!(pxs_getint(pxs_listget(pxs_mapget(map, key), 0)), 1);
+        assert_eq!(pxs_getint(pxs_listget(pxs_mapget(map_copy, key), 0)), 5);
+
+        pxs_freevar(key);
+        pxs_freevar(map);
+        pxs_freevar(map_copy);
+        pxs_freevar(list);
+        pxs_freevar(copy);
+
+        pxs_finalize();
+    }
+}
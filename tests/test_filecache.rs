@@ -0,0 +1,93 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_filecache --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use std::{
+        ffi::{CStr, c_char},
+        sync::atomic::{AtomicUsize, Ordering},
+    };
+
+    use pixelscript::{
+        pxs_filecache_enable, pxs_filecache_invalidate, pxs_filecache_stats, pxs_finalize, pxs_freevar, pxs_initialize,
+        pxs_newnull, pxs_newstring, pxs_set_filereader,
+        shared::{pxs_Runtime, utils, var::pxs_VarT},
+    };
+
+    /// Calls of the reader.
+    static READS: AtomicUsize = AtomicUsize::new(0);
+
+    unsafe extern "C" fn file_loader(file_path: *const c_char) -> pxs_VarT {
+        READS.fetch_add(1, Ordering::Relaxed);
+        let file_path = unsafe { CStr::from_ptr(file_path) }.to_str().unwrap();
+        if file_path == "cached" {
+            pxs_newstring(c"return { n = 1 }".as_ptr())
+        } else {
+            pxs_newnull()
+        }
+    }
+
+    fn require(name: &str) {
+        let code = format!("package.loaded['{name}'] = nil\npcall(require, '{name}')");
+        let res = utils::execute_code(&code, "<filecache>", pxs_Runtime::pxs_Lua);
+        assert!(res.is_null(), "Error is not null: {:#?}", res);
+    }
+
+    fn int(stats: pxs_VarT, key: &str) -> i64 {
+        unsafe { &*stats }.get_map().unwrap().get_str(key).expect(key).get_i64().unwrap()
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+        pxs_set_filereader(file_loader);
+
+        // Off, every require reads.
+        require("cached");
+        require("cached");
+        assert_eq!(READS.swap(0, Ordering::Relaxed), 2);
+
+        // Found or not, a path is read once.
+        pxs_filecache_enable(true);
+        for _ in 0..3 {
+            require("cached");
+            require("missing");
+        }
+        assert_eq!(READS.swap(0, Ordering::Relaxed), 2);
+        let stats = pxs_filecache_stats();
+        assert_eq!((int(stats, "files"), int(stats, "hits"), int(stats, "misses")), (2, 4, 2));
+        pxs_freevar(stats);
+
+        // One path changed.
+        assert_eq!(pxs_filecache_invalidate(c"cached".as_ptr()), 0);
+        require("cached");
+        require("missing");
+        assert_eq!(READS.swap(0, Ordering::Relaxed), 1);
+
+        // Everything changed.
+        assert_eq!(pxs_filecache_invalidate(std::ptr::null()), 1);
+        require("cached");
+        require("missing");
+        require("cached");
+        assert_eq!(READS.swap(0, Ordering::Relaxed), 2);
+
+        pxs_filecache_enable(false);
+        let stats = pxs_filecache_stats();
+        assert_eq!((int(stats, "version"), int(stats, "files")), (1, 0));
+        pxs_freevar(stats);
+        require("cached");
+        assert_eq!(READS.swap(0, Ordering::Relaxed), 1);
+
+        pxs_finalize();
+    }
+}
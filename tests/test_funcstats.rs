@@ -0,0 +1,96 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_funcstats --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use pixelscript::{
+        pxs_addfunc, pxs_addmod, pxs_finalize, pxs_freevar, pxs_funcstats, pxs_funcstats_enable, pxs_funcstats_reset,
+        pxs_initialize, pxs_maplen, pxs_newmod, pxs_newnull,
+        shared::{pxs_Runtime, utils, var::{pxs_Var, pxs_VarT}},
+    };
+
+    /// `test.tick()` a cheap host function.
+    extern "C" fn tick(_args: pxs_VarT) -> pxs_VarT {
+        pxs_newnull()
+    }
+
+    /// `test.nap()` a slow one.
+    extern "C" fn nap(_args: pxs_VarT) -> pxs_VarT {
+        std::thread::sleep(std::time::Duration::from_millis(2));
+        pxs_newnull()
+    }
+
+    fn test_runtime(runtime: pxs_Runtime, code: &str) {
+        let res = utils::execute_code(code, "<funcstats>", runtime);
+        assert!(res.is_null(), "Error is not null: {:#?}", res);
+    }
+
+    fn int(stats: &pxs_Var, key: &str) -> i64 {
+        stats.get_map().unwrap().get_str(key).unwrap().get_i64().unwrap()
+    }
+
+    /// Stats of `name` called from `runtime`.
+    fn entry<'a>(stats: &'a pxs_Var, name: &str, runtime: &str) -> &'a pxs_Var {
+        let by_runtime = stats.get_map().unwrap().get_str(name).expect(name);
+        by_runtime.get_map().unwrap().get_str(runtime).expect(runtime)
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        let module = pxs_newmod(c"test".as_ptr());
+        pxs_addfunc(module, c"tick".as_ptr(), tick);
+        pxs_addfunc(module, c"nap".as_ptr(), nap);
+        pxs_addmod(module);
+
+        // Off by default.
+        test_runtime(pxs_Runtime::pxs_Lua, "local t = require('test')\nt.tick()");
+        let stats = pxs_funcstats();
+        assert_eq!(pxs_maplen(stats), 0);
+        pxs_freevar(stats);
+
+        pxs_funcstats_enable(true);
+        test_runtime(pxs_Runtime::pxs_Lua, "local t = require('test')\nfor i = 1, 100 do t.tick() end\nt.nap()");
+        test_runtime(pxs_Runtime::pxs_Python, "import test\nfor i in range(50):\n    test.tick()");
+        test_runtime(pxs_Runtime::pxs_JavaScript, "import * as t from 'test';\nfor (let i = 0; i < 25; i++) { t.tick(); }\nt.nap();");
+        pxs_funcstats_enable(false);
+        test_runtime(pxs_Runtime::pxs_Lua, "local t = require('test')\nt.tick()");
+
+        let stats = pxs_funcstats();
+        let stats_ref = unsafe { &*stats };
+        assert_eq!(int(entry(stats_ref, "_testtick", "lua"), "calls"), 100);
+        assert_eq!(int(entry(stats_ref, "_testtick", "python"), "calls"), 50);
+        assert_eq!(int(entry(stats_ref, "_testtick", "js"), "calls"), 25);
+
+        let nap = entry(stats_ref, "_testnap", "js");
+        assert_eq!(int(nap, "calls"), 1);
+        assert!(int(nap, "max_ns") >= 2_000_000);
+        assert!(int(nap, "p50_ns") <= int(nap, "max_ns"));
+        assert!(int(nap, "p50_ns") >= 2_000_000 * 7 / 8);
+
+        let tick = entry(stats_ref, "_testtick", "lua");
+        assert!(int(tick, "p50_ns") <= int(tick, "p99_ns"));
+        let histogram = tick.get_map().unwrap().get_str("histogram").unwrap().get_list().unwrap();
+        let counted: i64 = histogram.vars.iter().map(|bucket| bucket.get_list().unwrap().vars[1].get_i64().unwrap()).sum();
+        assert_eq!(counted, 100);
+        pxs_freevar(stats);
+
+        pxs_funcstats_reset();
+        let stats = pxs_funcstats();
+        assert_eq!(pxs_maplen(stats), 0);
+        pxs_freevar(stats);
+
+        pxs_finalize();
+    }
+}
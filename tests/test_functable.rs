@@ -0,0 +1,66 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_functable --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use pixelscript::{
+        pxs_addfunc, pxs_addfunctable, pxs_addmod, pxs_finalize, pxs_initialize, pxs_newint, pxs_newmod,
+        shared::{func::pxs_FuncEntry, pxs_Runtime, utils, var::pxs_VarT},
+    };
+
+    extern "C" fn one(_args: pxs_VarT) -> pxs_VarT {
+        pxs_newint(1)
+    }
+
+    extern "C" fn two(_args: pxs_VarT) -> pxs_VarT {
+        pxs_newint(2)
+    }
+
+    extern "C" fn three(_args: pxs_VarT) -> pxs_VarT {
+        pxs_newint(3)
+    }
+
+    fn test_runtime(runtime: pxs_Runtime, code: &str) {
+        let res = utils::execute_code(code, "<functable>", runtime);
+        assert!(res.is_null(), "Error is not null: {:#?}", res);
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        let module = pxs_newmod(c"gen".as_ptr());
+        pxs_addfunc(module, c"one".as_ptr(), one);
+        let table = [
+            pxs_FuncEntry { name: c"two".as_ptr(), func: two },
+            // Skipped.
+            pxs_FuncEntry { name: std::ptr::null(), func: two },
+            pxs_FuncEntry { name: c"three".as_ptr(), func: three },
+        ];
+        pxs_addfunctable(module, table.as_ptr(), table.len());
+        pxs_addfunctable(module, table.as_ptr(), 0);
+        pxs_addmod(module);
+
+        test_runtime(
+            pxs_Runtime::pxs_Lua,
+            "local gen = require('gen')\nassert(gen.one() + gen.two() + gen.three() == 6)",
+        );
+        test_runtime(pxs_Runtime::pxs_Python, "import gen\nassert gen.one() + gen.two() + gen.three() == 6");
+        test_runtime(
+            pxs_Runtime::pxs_JavaScript,
+            "import { one, two, three } from 'gen';\nif (one() + two() + three() !== 6) throw new Error('gen');",
+        );
+
+        pxs_finalize();
+    }
+}
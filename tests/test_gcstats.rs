@@ -0,0 +1,99 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_gcstats --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use pixelscript::{
+        pxs_finalize, pxs_freevar, pxs_garbagecollect, pxs_gcstats, pxs_gcstats_enable, pxs_gcstats_reset, pxs_gcstep,
+        pxs_initialize, pxs_runtimestats,
+        shared::{pxs_Runtime, utils, var::pxs_Var},
+    };
+
+    fn int(stats: &pxs_Var, key: &str) -> i64 {
+        stats.get_map().unwrap().get_str(key).expect(key).get_i64().unwrap()
+    }
+
+    fn test_runtime(runtime: pxs_Runtime, code: &str) {
+        let res = utils::execute_code(code, "<gcstats>", runtime);
+        assert!(res.is_null(), "Error is not null: {:#?}", res);
+    }
+
+    /// Make garbage until the runtime collected on its own.
+    fn churn() {
+        test_runtime(pxs_Runtime::pxs_Lua, "for i = 1, 200000 do local t = { i, { i } } end");
+        test_runtime(pxs_Runtime::pxs_Python, "for i in range(100000):\n    t = [i, [i]]");
+        test_runtime(
+            pxs_Runtime::pxs_JavaScript,
+            "for (let i = 0; i < 100000; i++) { let a = {}; let b = { a }; a.b = b; }",
+        );
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        // Host collections are always counted per thread.
+        let before = pxs_runtimestats(pxs_Runtime::pxs_Lua);
+        pxs_garbagecollect();
+        pxs_gcstep(pxs_Runtime::pxs_Lua, 100);
+        let after = pxs_runtimestats(pxs_Runtime::pxs_Lua);
+        assert_eq!(int(unsafe { &*after }, "gc_full"), int(unsafe { &*before }, "gc_full") + 1);
+        assert_eq!(int(unsafe { &*after }, "gc_steps"), int(unsafe { &*before }, "gc_steps") + 1);
+        assert!(int(unsafe { &*after }, "gc_pause_ns") > int(unsafe { &*before }, "gc_pause_ns"));
+        pxs_freevar(before);
+        pxs_freevar(after);
+
+        // Nothing logged while off.
+        let stats = pxs_gcstats();
+        assert!(unsafe { &*stats }.get_map().unwrap().get_str("events").unwrap().get_list().unwrap().len() == 0);
+        pxs_freevar(stats);
+
+        pxs_gcstats_enable(true);
+        churn();
+        pxs_garbagecollect();
+        pxs_gcstats_enable(false);
+
+        let stats = pxs_gcstats();
+        let stats_ref = unsafe { &*stats };
+        println!("{:#?}", stats_ref);
+        let map = stats_ref.get_map().unwrap();
+        let runtimes = map.get_str("runtimes").unwrap();
+        for name in ["lua", "python", "js"] {
+            let runtime = runtimes.get_map().unwrap().get_str(name).expect(name);
+            assert_eq!(int(runtime, "full"), 1, "{name}");
+            assert!(int(runtime, "auto") > 0, "{name}");
+        }
+        // pocketpy ones are timed, the others are not.
+        let events = map.get_str("events").unwrap().get_list().unwrap();
+        let timed = |runtime: &str, kind: &str| {
+            events.vars.iter().filter(|event| {
+                let event = event.get_map().unwrap();
+                event.get_str("runtime").unwrap().get_string().unwrap() == runtime
+                    && event.get_str("kind").unwrap().get_string().unwrap() == kind
+                    && event.get_str("ns").unwrap().get_i64().unwrap() >= 0
+            }).count()
+        };
+        assert!(timed("python", "auto") > 0);
+        assert_eq!(timed("lua", "auto"), 0);
+        assert_eq!(timed("lua", "full"), 1);
+        assert_eq!(int(stats_ref, "dropped"), 0);
+        pxs_freevar(stats);
+
+        pxs_gcstats_reset();
+        let stats = pxs_gcstats();
+        assert!(unsafe { &*stats }.get_map().unwrap().get_str("events").unwrap().get_list().unwrap().len() == 0);
+        pxs_freevar(stats);
+
+        pxs_finalize();
+    }
+}
@@ -0,0 +1,59 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_gcstep --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use pixelscript::{
+        own_var, pxs_finalize, pxs_gcstep, pxs_initialize, pxs_memstats, pxs_setautogc,
+        shared::{pxs_Runtime, utils, var::pxs_Var},
+    };
+
+    fn bytes(runtime: pxs_Runtime) -> i64 {
+        let stats = own_var!(pxs_memstats(runtime));
+        let map = stats.get_map().expect("Expected a map");
+        map.get_item(&pxs_Var::new_string("bytes".to_string())).and_then(|v| v.as_i64()).unwrap()
+    }
+
+    fn test_runtime(runtime: pxs_Runtime, garbage: &str) {
+        pxs_setautogc(runtime.clone(), false);
+
+        let res = utils::execute_code(garbage, "<gcstep>", runtime.clone());
+        assert!(res.is_null(), "Error is not null: {:#?}", res);
+        let before = bytes(runtime.clone());
+
+        // Small steps until a cycle finished.
+        let mut finished = false;
+        for _ in 0..100000 {
+            if pxs_gcstep(runtime.clone(), 100) {
+                finished = true;
+                break;
+            }
+        }
+        assert!(finished, "No cycle finished");
+        assert!(bytes(runtime.clone()) < before, "Nothing was collected");
+
+        pxs_setautogc(runtime, true);
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        test_runtime(pxs_Runtime::pxs_Lua, "for i = 1, 100000 do local t = { i, tostring(i) } end");
+        // Cycles, which only the collector frees in QuickJS.
+        test_runtime(pxs_Runtime::pxs_JavaScript, "for (let i = 0; i < 100000; i++) { let a = {}; let b = { a }; a.b = b; }");
+        test_runtime(pxs_Runtime::pxs_Python, "for i in range(100000):\n    t = [i, str(i)]");
+
+        pxs_finalize();
+    }
+}
@@ -0,0 +1,76 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_importcache --no-default-features --features "lua,python,js,js_commonjs,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use std::ffi::{CStr, c_char};
+
+    use pixelscript::{
+        pxs_finalize, pxs_freesnapshot, pxs_initialize, pxs_newnull, pxs_newstring, pxs_set_filereader,
+        pxs_snapshot_save, pxs_startthread, pxs_stopthread,
+        shared::{pxs_Runtime, utils, var::pxs_VarT},
+    };
+
+    unsafe extern "C" fn file_loader(file_path: *const c_char) -> pxs_VarT {
+        match unsafe { CStr::from_ptr(file_path) }.to_str().unwrap() {
+            "depjs" => pxs_newstring(c"export const n = 1;".as_ptr()),
+            "deplua" => pxs_newstring(c"return { n = 1 }".as_ptr()),
+            _ => pxs_newnull(),
+        }
+    }
+
+    fn test_runtime(runtime: pxs_Runtime, code: &str) {
+        let res = utils::execute_code(code, "<importcache>", runtime);
+        assert!(res.is_null(), "Error is not null: {:#?}", res);
+    }
+
+    /// Does the snapshot of `runtime` have a chunk named `name`?
+    fn has_chunk(runtime: pxs_Runtime, name: &str) -> bool {
+        let mut len = 0;
+        let data = pxs_snapshot_save(runtime, &mut len);
+        let found = unsafe { std::slice::from_raw_parts(data, len) }
+            .windows(name.len())
+            .any(|window| window == name.as_bytes());
+        pxs_freesnapshot(data, len);
+        found
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+        pxs_set_filereader(file_loader);
+
+        // Stop recording, only the core libs and imports are kept from here on.
+        assert!(!has_chunk(pxs_Runtime::pxs_JavaScript, "depjs"));
+        assert!(!has_chunk(pxs_Runtime::pxs_Lua, "deplua"));
+
+        for _ in 0..2 {
+            std::thread::spawn(|| {
+                pxs_startthread();
+                utils::setup_pxs();
+                test_runtime(pxs_Runtime::pxs_JavaScript, "if (require('depjs').n !== 1) throw new Error('js');");
+                test_runtime(pxs_Runtime::pxs_Lua, "assert(require('deplua').n == 1)");
+                pxs_stopthread();
+            })
+            .join()
+            .unwrap();
+        }
+
+        assert!(has_chunk(pxs_Runtime::pxs_JavaScript, "depjs"));
+        assert!(has_chunk(pxs_Runtime::pxs_Lua, "deplua"));
+        // Scripts are not imports.
+        assert!(!has_chunk(pxs_Runtime::pxs_JavaScript, "<importcache>"));
+
+        pxs_finalize();
+    }
+}
@@ -0,0 +1,64 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_initoptions --no-default-features --features "lua,python,js,include-core,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use pixelscript::{
+        pxs_finalize, pxs_freevar, pxs_initialize_with, pxs_startupstats,
+        shared::{pxs_Runtime, startup::pxs_InitOptions, utils},
+    };
+
+    /// Has a `start` phase of `runtime` been recorded?
+    fn started(runtime: &str) -> bool {
+        let stats = pxs_startupstats();
+        let phases = unsafe { &*stats }.get_map().unwrap().get_str("phases").unwrap().get_list().unwrap();
+        let started = phases.vars.iter().any(|phase| {
+            let phase = phase.get_map().unwrap();
+            phase.get_str("name").unwrap().get_string().unwrap() == "start"
+                && phase.get_str("runtime").unwrap().get_string().unwrap() == runtime
+        });
+        pxs_freevar(stats);
+        started
+    }
+
+    fn test_runtime(runtime: pxs_Runtime, code: &str) {
+        let res = utils::execute_code(code, "<initoptions>", runtime);
+        assert!(res.is_null(), "Error is not null: {:#?}", res);
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        let options = pxs_InitOptions { parallel: true, deferred: 1 << pxs_Runtime::pxs_Python.into_i64() };
+        pxs_initialize_with(&options);
+        // Kept for Python until it starts.
+        utils::setup_pxs();
+
+        assert!(started("lua") && started("js"));
+        assert!(!started("python"));
+
+        // Started on other threads, the core modules still call into this threads lookup.
+        test_runtime(
+            pxs_Runtime::pxs_Lua,
+            "local pxs = require('pxs')\nassert(pxs.num == 1)\nassert(pxs_json.decode('[1,2]')[2] == 2)",
+        );
+        test_runtime(
+            pxs_Runtime::pxs_JavaScript,
+            "import * as pxs from 'pxs';\nimport * as pxs_json from 'pxs_json';\nif (pxs.num !== 1 || pxs_json.decode('[1,2]')[1] !== 2) throw new Error('js');",
+        );
+        assert!(!started("python"));
+
+        test_runtime(pxs_Runtime::pxs_Python, "import pxs\nassert pxs.num == 1\nassert pxs_json.decode('[1,2]')[1] == 2");
+        assert!(started("python"));
+
+        pxs_finalize();
+    }
+}
@@ -0,0 +1,73 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_intern --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use std::sync::atomic::{AtomicU32, Ordering};
+
+    use etffi::{borrow_string, cstring::CStringSafe};
+    use pixelscript::{
+        pxs_addfunc, pxs_addmod, pxs_atomname, pxs_finalize, pxs_initialize, pxs_intern, pxs_listget, pxs_newint,
+        pxs_newmod, pxs_objectget_atom, pxs_objectset_atom,
+        shared::{pxs_Runtime, utils, var::pxs_VarT},
+    };
+
+    static HP: AtomicU32 = AtomicU32::new(0);
+
+    /// Set `hp` to 10 on the object and read it back.
+    extern "C" fn poke(args: pxs_VarT) -> pxs_VarT {
+        let rt = pxs_listget(args, 0);
+        let obj = pxs_listget(args, 1);
+        let hp = HP.load(Ordering::Relaxed);
+        assert!(pxs_objectset_atom(rt, obj, hp, pxs_newint(10)));
+        pxs_objectget_atom(rt, obj, hp)
+    }
+
+    fn test_runtime(runtime: pxs_Runtime, code: &str) {
+        let res = utils::execute_code(code, "<intern>", runtime);
+        assert!(res.is_null(), "Error is not null: {:#?}", res);
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        let mut cstrgen = CStringSafe::new();
+        let hp = pxs_intern(cstrgen.new_string("hp"));
+        assert_ne!(hp, 0);
+        assert_eq!(pxs_intern(cstrgen.new_string("hp")), hp);
+        assert_ne!(pxs_intern(cstrgen.new_string("mp")), hp);
+        assert_eq!(borrow_string!(pxs_atomname(hp)), "hp");
+        assert!(pxs_atomname(0).is_null());
+
+        // Same atom on another thread.
+        let other = std::thread::spawn(|| {
+            let mut cstrgen = CStringSafe::new();
+            pxs_intern(cstrgen.new_string("hp"))
+        })
+        .join()
+        .unwrap();
+        assert_eq!(other, hp);
+
+        HP.store(hp, Ordering::Relaxed);
+        let test_mod = pxs_newmod(cstrgen.new_string("test"));
+        pxs_addfunc(test_mod, cstrgen.new_string("poke"), poke);
+        pxs_addmod(test_mod);
+
+        test_runtime(pxs_Runtime::pxs_Lua, "local poke = require('test').poke\nlocal t = {}\nassert(poke(t) == 10 and t.hp == 10)");
+        test_runtime(pxs_Runtime::pxs_Python, "from test import poke\nclass A:\n    pass\na = A()\nassert poke(a) == 10 and a.hp == 10");
+        test_runtime(pxs_Runtime::pxs_JavaScript, "import {poke} from 'test';\nlet o = {};\nif (poke(o) !== 10 || o.hp !== 10) { throw new Error('atom get/set failed'); }");
+
+        pxs_finalize();
+    }
+}
@@ -0,0 +1,154 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_json --no-default-features --features "lua,python,js,pxs_json,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use pixelscript::{
+        pxs_core::pxs_json::{decode_str, encode_var, pxs_JsonStream},
+        pxs_finalize, pxs_initialize,
+        shared::{pxs_Runtime, utils, var::pxs_Var},
+    };
+
+    fn test_runtime(runtime: pxs_Runtime, code: &str) {
+        let res = utils::execute_code(code, "<json>", runtime);
+        assert!(res.is_null(), "Error is not null: {:#?}", res);
+    }
+
+    fn test_host() {
+        let var = decode_str(r#"{"a": [1, -2, 18446744073709551615, 1.5e3, true, null], "b": "x\tyé😀"}"#).unwrap();
+        let map = var.get_map().unwrap();
+        let a = map.get_item(&pxs_Var::new_string("a".to_string())).unwrap().get_list().unwrap();
+        assert_eq!(a.len(), 6);
+        assert_eq!(a.get_item(0).unwrap().get_i64().unwrap(), 1);
+        assert_eq!(a.get_item(1).unwrap().get_i64().unwrap(), -2);
+        assert_eq!(a.get_item(2).unwrap().get_u64().unwrap(), u64::MAX);
+        assert_eq!(a.get_item(3).unwrap().get_f64().unwrap(), 1500.0);
+        assert!(a.get_item(4).unwrap().get_bool().unwrap());
+        assert!(a.get_item(5).unwrap().is_null());
+        let b = map.get_item(&pxs_Var::new_string("b".to_string())).unwrap();
+        assert_eq!(b.get_string().unwrap(), "x\ty\u{e9}\u{1F600}");
+
+        // Longer than one block so the scan carries strings and escapes over.
+        let long = format!("[\"{}\\\"{}\"]", "a".repeat(61), "b".repeat(70));
+        let var = decode_str(&long).unwrap();
+        let text = var.get_list().unwrap().get_item(0).unwrap().get_string().unwrap();
+        assert_eq!(text, format!("{}\"{}", "a".repeat(61), "b".repeat(70)));
+        assert_eq!(encode_var(None, &var).unwrap(), long);
+
+        let text = encode_var(None, &decode_str("[1,2.5,\"a\\nb\",[],{}]").unwrap()).unwrap();
+        assert_eq!(text, "[1,2.5,\"a\\nb\",[],{}]");
+
+        // Objects keep the document order.
+        let text = r#"{"z":1,"a":{"y":true,"b":null},"m":"x"}"#;
+        assert_eq!(encode_var(None, &decode_str(text).unwrap()).unwrap(), text);
+
+        for bad in ["", "[1,", "{\"a\" 1}", "\"abc", "01", "1.", "[1]x", "tru", "\"\u{1}\"", "{1: 2}"] {
+            assert!(decode_str(bad).is_err(), "{bad} should not decode");
+        }
+    }
+
+    /// Stream `text` in chunks of `size` bytes.
+    fn stream(text: &str, pointer: &str, size: usize) -> Result<pxs_Var, String> {
+        let mut stream = pxs_JsonStream::new(pointer);
+        for chunk in text.as_bytes().chunks(size) {
+            if stream.feed(chunk).is_err() {
+                break;
+            }
+        }
+        stream.finish()
+    }
+
+    fn test_stream() {
+        let text = r#"{"mods": [{"name": "a\"b", "tags": []}, {"name": "é😀", "size": -1.5e2}], "count": 2, "~/x": true}"#;
+        let list = r#"[1, "a\"b\u00e9", [true, null, {}], -2.5e1, "é😀", 18446744073709551615]"#;
+        let whole = encode_var(None, &decode_str(list).unwrap()).unwrap();
+        // Chunks split escapes, numbers and UTF-8 characters.
+        for size in [1, 2, 3, 7, 64, 1000] {
+            assert_eq!(encode_var(None, &stream(list, "", size).unwrap()).unwrap(), whole);
+            assert_eq!(stream(text, "", size).unwrap().get_map().unwrap().len(), 3);
+            assert_eq!(stream(text, "/mods/1/name", size).unwrap().get_string().unwrap(), "é😀");
+            assert_eq!(stream(text, "/mods/1/size", size).unwrap().get_f64().unwrap(), -150.0);
+            assert_eq!(stream(text, "/count", size).unwrap().get_i64().unwrap(), 2);
+            assert!(stream(text, "/~0~1x", size).unwrap().get_bool().unwrap());
+            let tags = stream(text, "/mods/0/tags", size).unwrap();
+            assert_eq!(tags.get_list().unwrap().len(), 0);
+        }
+        assert_eq!(stream("42", "", 1).unwrap().get_i64().unwrap(), 42);
+
+        assert!(stream(text, "/mods/2", 5).is_err());
+        assert!(stream(text, "/mods/01", 5).is_err());
+        assert!(stream(text, "mods", 5).is_err());
+        for bad in ["", "[1,", "{\"a\" 1}", "\"abc", "01", "[1]x", "tru", "{\"a\": [1}"] {
+            assert!(stream(bad, "", 2).is_err(), "{bad} should not decode");
+        }
+        // Skipped values are checked too.
+        assert!(stream("{\"a\": [nul], \"b\": 1}", "/b", 3).is_err());
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        test_host();
+        test_stream();
+
+        test_runtime(
+            pxs_Runtime::pxs_Lua,
+            r#"
+local value = pxs_json.decode('{"name": "pxs", "list": [1, 2, 3], "nested": {"ok": true}}')
+assert(value.name == "pxs")
+assert(#value.list == 3 and value.list[3] == 3)
+assert(value.nested.ok == true)
+local again = pxs_json.decode(pxs_json.encode(value))
+assert(again.name == "pxs" and again.list[2] == 2)
+assert(pxs_json.encode({1, 2, "three"}) == '[1,2,"three"]')
+assert(not pcall(pxs_json.decode, '{"a":'))
+"#,
+        );
+
+        test_runtime(
+            pxs_Runtime::pxs_Python,
+            r#"
+import pxs_json
+value = pxs_json.decode('{"name": "pxs", "list": [1, 2, 3], "nested": {"ok": true}}')
+assert value["name"] == "pxs"
+assert len(value["list"]) == 3
+assert value["nested"]["ok"] == True
+again = pxs_json.decode(pxs_json.encode({"name": "pxs", "list": [1, 2.5, None]}))
+assert again["list"][1] == 2.5
+assert again["list"][2] is None
+assert pxs_json.encode([1, "two", False]) == '[1,"two",false]'
+"#,
+        );
+
+        test_runtime(
+            pxs_Runtime::pxs_JavaScript,
+            r#"
+import * as pxs_json from 'pxs_json';
+let value = pxs_json.decode('{"name": "pxs", "list": [1, 2, 3], "nested": {"ok": true}}');
+if (value.name != "pxs" || value.list[2] != 3 || value.nested.ok != true) {
+    throw new Error("bad decode");
+}
+let again = pxs_json.decode(pxs_json.encode({name: "pxs", list: [1, "two"]}));
+if (again.name != "pxs" || again.list[1] != "two") {
+    throw new Error("bad round trip");
+}
+if (pxs_json.encode([1, null, true]) != '[1,null,true]') {
+    throw new Error("bad encode");
+}
+"#,
+        );
+
+        pxs_finalize();
+    }
+}
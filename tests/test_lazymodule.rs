@@ -0,0 +1,82 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_lazymodule --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use pixelscript::{
+        pxs_add_submod, pxs_addfunc, pxs_addmod, pxs_addvar, pxs_finalize, pxs_freevar, pxs_initialize, pxs_newint,
+        pxs_newmod, pxs_runtimestats,
+        shared::{pxs_Runtime, utils, var::{pxs_Var, pxs_VarT}},
+    };
+
+    /// `lazy.answer()`
+    extern "C" fn answer(_args: pxs_VarT) -> pxs_VarT {
+        pxs_newint(42)
+    }
+
+    fn js_modules() -> (i64, i64) {
+        let stats = pxs_runtimestats(pxs_Runtime::pxs_JavaScript);
+        let map = unsafe { &*stats }.get_map().unwrap();
+        let counts = (
+            map.get_str("modules").unwrap().get_i64().unwrap(),
+            map.get_str("lazy_modules").unwrap().get_i64().unwrap(),
+        );
+        pxs_freevar(stats);
+        counts
+    }
+
+    fn test_runtime(runtime: pxs_Runtime, code: &str) {
+        let res = utils::execute_code(code, "<lazymodule>", runtime);
+        assert!(res.is_null(), "Error is not null: {:#?}", res);
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        let (modules, lazy) = js_modules();
+        let module = pxs_newmod(c"lazy".as_ptr());
+        pxs_addfunc(module, c"answer".as_ptr(), answer);
+        pxs_addvar(module, c"version".as_ptr(), pxs_newint(3));
+        let sub = pxs_newmod(c"sub".as_ptr());
+        pxs_addfunc(sub, c"answer".as_ptr(), answer);
+        pxs_add_submod(module, sub);
+        pxs_addmod(module);
+
+        // Nothing is defined until imported.
+        assert_eq!(js_modules(), (modules, lazy + 2));
+        test_runtime(pxs_Runtime::pxs_Lua, "assert(package.loaded['lazy'] == nil)");
+
+        test_runtime(
+            pxs_Runtime::pxs_Lua,
+            "local lazy = require('lazy')\nassert(lazy.answer() == 42 and lazy.version == 3)\nassert(require('lazy') == lazy)\nassert(require('lazy.sub').answer() == 42)",
+        );
+        test_runtime(
+            pxs_Runtime::pxs_Python,
+            "import lazy\nassert lazy.answer() == 42 and lazy.version == 3\nfrom lazy.sub import answer\nassert answer() == 42",
+        );
+        test_runtime(
+            pxs_Runtime::pxs_JavaScript,
+            "import { answer, version } from 'lazy';\nif (answer() !== 42 || version !== 3) throw new Error('lazy');",
+        );
+        // Only `lazy` was imported.
+        assert_eq!(js_modules(), (modules + 1, lazy + 1));
+        test_runtime(
+            pxs_Runtime::pxs_JavaScript,
+            "import { answer } from 'lazy.sub';\nif (answer() !== 42) throw new Error('lazy.sub');",
+        );
+        assert_eq!(js_modules(), (modules + 2, lazy));
+
+        pxs_finalize();
+    }
+}
@@ -0,0 +1,101 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_listops --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use pixelscript::{
+        pxs_finalize, pxs_freevar, pxs_initialize, pxs_list_copy_i64, pxs_listadd, pxs_listclear, pxs_listextend,
+        pxs_listlen, pxs_listreserve, pxs_listsplice, pxs_newcopy, pxs_newint, pxs_newlist_i64,
+        pxs_newlist_with_capacity,
+        shared::{
+            utils,
+            var::{pxs_Var, pxs_VarT},
+        },
+    };
+
+    fn items(list: pxs_VarT) -> Vec<i64> {
+        let mut out = vec![0; pxs_listlen(list).max(0) as usize];
+        let copied = pxs_list_copy_i64(list, out.as_mut_ptr(), out.len());
+        out.truncate(copied.max(0) as usize);
+        out
+    }
+
+    fn new_list(values: &[i64]) -> pxs_VarT {
+        pxs_newlist_i64(values.as_ptr(), values.len())
+    }
+
+    fn capacity(list: pxs_VarT) -> usize {
+        unsafe { (*list).get_list().unwrap().vars.capacity() }
+    }
+
+    fn test_capacity() {
+        let list = pxs_newlist_with_capacity(100);
+        assert_eq!(pxs_listlen(list), 0);
+        assert!(capacity(list) >= 100);
+        for i in 0..100 {
+            pxs_listadd(list, pxs_newint(i));
+        }
+        assert!(capacity(list) < 200, "grew while adding into the reserved room");
+        pxs_listreserve(list, 50);
+        assert!(capacity(list) >= 150);
+
+        pxs_listclear(list);
+        assert_eq!(pxs_listlen(list), 0);
+        assert!(capacity(list) >= 150, "clear keeps the memory");
+        pxs_freevar(list);
+    }
+
+    fn test_extend() {
+        let list = new_list(&[1, 2]);
+        assert!(pxs_listextend(list, new_list(&[3, 4])));
+        assert_eq!(items(list), [1, 2, 3, 4]);
+
+        // A copy shares its items, they are copied instead of moved.
+        let shared = new_list(&[5]);
+        let copy = pxs_newcopy(shared);
+        assert!(pxs_listextend(list, copy));
+        assert_eq!(items(shared), [5]);
+        pxs_freevar(shared);
+
+        assert!(pxs_listextend(list, list));
+        assert_eq!(items(list), [1, 2, 3, 4, 5, 1, 2, 3, 4, 5]);
+        assert!(!pxs_listextend(list, pxs_newint(1)));
+        pxs_freevar(list);
+    }
+
+    fn test_splice() {
+        let list = new_list(&[1, 2, 3, 4, 5]);
+        assert!(pxs_listsplice(list, 1, 2, new_list(&[7, 8, 9])));
+        assert_eq!(items(list), [1, 7, 8, 9, 4, 5]);
+        assert!(pxs_listsplice(list, 4, 100, std::ptr::null_mut()));
+        assert_eq!(items(list), [1, 7, 8, 9]);
+        assert!(pxs_listsplice(list, 4, 0, new_list(&[10])));
+        assert_eq!(items(list), [1, 7, 8, 9, 10]);
+        assert!(pxs_listsplice(list, 0, 1, list));
+        assert_eq!(items(list), [1, 7, 8, 9, 10, 7, 8, 9, 10]);
+        assert!(!pxs_listsplice(list, 10, 0, new_list(&[1])));
+        assert_eq!(pxs_listlen(list), 9);
+        pxs_freevar(list);
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        test_capacity();
+        test_extend();
+        test_splice();
+
+        pxs_finalize();
+    }
+}
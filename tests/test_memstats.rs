@@ -0,0 +1,117 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_memstats --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use etffi::cstring::CStringSafe;
+    use pixelscript::{
+        own_var, pxs_addfunc, pxs_addmod, pxs_finalize, pxs_garbagecollect, pxs_initialize, pxs_memstats, pxs_newint,
+        pxs_newlist, pxs_listadd, pxs_newmod, pxs_setmemlimit,
+        shared::{pxs_Runtime, utils, var::{pxs_Var, pxs_VarT}},
+    };
+
+    /// A list of a lot more than the limit, made while Lua waits on the bridge.
+    extern "C" fn big(_args: pxs_VarT) -> pxs_VarT {
+        let list = pxs_newlist();
+        for i in 0..200_000 {
+            pxs_listadd(list, pxs_newint(i));
+        }
+        list
+    }
+
+    /// Going over the limit in a host callback does not raise there, the script fails on its next allocation.
+    fn test_lua_bridge() {
+        let mut cstrgen = CStringSafe::new();
+        let test_mod = pxs_newmod(cstrgen.new_string("test"));
+        pxs_addfunc(test_mod, cstrgen.new_string("big"), big);
+        pxs_addmod(test_mod);
+
+        let limit = stat(pxs_Runtime::pxs_Lua, "bytes") as usize + (1 << 20);
+        assert!(pxs_setmemlimit(pxs_Runtime::pxs_Lua, limit));
+
+        let res = utils::execute_code(
+            "local t = require('test').big()\nassert(#t == 200000)\nlocal s = {}\nfor i = 1, 1000 do s[i] = 'item' .. i end",
+            "<memstats>",
+            pxs_Runtime::pxs_Lua,
+        );
+        assert!(res.is_exception(), "Allocation over the limit did not fail: {:#?}", res);
+        assert!(res.get_string().unwrap().contains("not enough memory"), "Not a memory error: {:#?}", res);
+        pxs_garbagecollect();
+
+        let res = utils::execute_code("local x = 'still' .. ' working'", "<memstats>", pxs_Runtime::pxs_Lua);
+        assert!(res.is_null(), "Error is not null: {:#?}", res);
+
+        assert!(pxs_setmemlimit(pxs_Runtime::pxs_Lua, 0));
+    }
+
+    fn stat(runtime: pxs_Runtime, key: &str) -> i64 {
+        let stats = own_var!(pxs_memstats(runtime));
+        let map = stats.get_map().expect("Expected a map");
+        map.get_item(&pxs_Var::new_string(key.to_string()))
+            .and_then(|v| v.as_i64())
+            .expect("Missing stat")
+    }
+
+    fn test_runtime(runtime: pxs_Runtime, hungry: &str, small: &str) {
+        let bytes = stat(runtime.clone(), "bytes");
+        assert!(bytes > 0, "No memory counted");
+        assert!(stat(runtime.clone(), "peak") >= bytes);
+
+        let cycles = stat(runtime.clone(), "gc_cycles");
+        pxs_garbagecollect();
+        assert_eq!(stat(runtime.clone(), "gc_cycles"), cycles + 1);
+
+        // Room for small scripts, not for a table of a million strings.
+        let limit = stat(runtime.clone(), "bytes") as usize + (1 << 20);
+        assert!(pxs_setmemlimit(runtime.clone(), limit));
+        assert_eq!(stat(runtime.clone(), "limit"), limit as i64);
+
+        let res = utils::execute_code(hungry, "<memstats>", runtime.clone());
+        assert!(res.is_exception(), "Allocation over the limit did not fail: {:#?}", res);
+        pxs_garbagecollect();
+        assert!(stat(runtime.clone(), "bytes") as usize <= limit);
+
+        // The state is still usable.
+        let res = utils::execute_code(small, "<memstats>", runtime.clone());
+        assert!(res.is_null(), "Error is not null: {:#?}", res);
+
+        assert!(pxs_setmemlimit(runtime, 0));
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        test_runtime(
+            pxs_Runtime::pxs_Lua,
+            "local t = {}\nfor i = 1, 1000000 do t[i] = 'item' .. i end",
+            "local x = 'still' .. ' working'",
+        );
+        test_lua_bridge();
+        test_runtime(
+            pxs_Runtime::pxs_JavaScript,
+            "let t = []; for (let i = 0; i < 1000000; i++) { t.push('item' + i); }",
+            "let x = 'still' + ' working';",
+        );
+
+        assert!(stat(pxs_Runtime::pxs_Python, "bytes") > 0);
+        assert!(!pxs_setmemlimit(pxs_Runtime::pxs_Python, 1 << 20));
+
+        let vars = stat(pxs_Runtime::pxs_Lua, "vars");
+        let held: Vec<_> = (0..10).map(|i| pxs_Var::new_i64(i)).collect();
+        assert_eq!(stat(pxs_Runtime::pxs_Lua, "vars"), vars + 10);
+        drop(held);
+
+        pxs_finalize();
+    }
+}
@@ -18,7 +18,7 @@ mod tests {
         pxs_addobject, pxs_finalize, pxs_freearena, pxs_gethost, pxs_getint, pxs_getstring,
         pxs_getuint, pxs_initialize, pxs_listadd, pxs_listget, pxs_listlen, pxs_newarena,
         pxs_newcopy, pxs_newhost, pxs_newint, pxs_newlist, pxs_newmod, pxs_newnull, pxs_newobject,
-        pxs_newstring, pxs_newuint, pxs_object_addfunc, pxs_object_addprop,
+        pxs_newstring, pxs_newuint, pxs_object_addfield, pxs_object_addfunc, pxs_object_addprop,
         shared::{
             module::pxs_Module,
             pxs_Runtime,
@@ -96,6 +96,9 @@ mod tests {
 
         pxs_object_addprop(obj, cstrgen.new_string("name"), person_name_prop);
         pxs_object_addprop(obj, cstrgen.new_string("age"), person_age_prop);
+        // Plain data, scripts never call back for these.
+        pxs_object_addfield(obj, cstrgen.new_string("kind"), pxs_newstring(cstrgen.new_string("human")), false);
+        pxs_object_addfield(obj, cstrgen.new_string("score"), pxs_newint(0), true);
         pxs_object_addfunc(obj, cstrgen.new_string("__str__"), person_string);
         pxs_object_addfunc(obj, cstrgen.new_string("__tostring"), person_string);
         pxs_object_addfunc(obj, cstrgen.new_string("toString"), person_string);
@@ -210,6 +213,17 @@ print(d.owner)
 print(p.name)
 p.age += 1
 print(p.age)
+
+assert p.kind == "human"
+p.score += 5
+assert p.score == 5
+assert Person('Evelyn', 21).score == 0
+assigned = True
+try:
+    p.kind = "robot"
+except Exception:
+    assigned = False
+assert not assigned and p.kind == "human"
 "#;
 
         let res = utils::execute_code(script, "<test>", pxs_Runtime::pxs_Python);
@@ -239,6 +253,13 @@ pxs.print(p.name)
 p.age = p.age + 1
 pxs.print(p.age)
 
+assert(p.kind == 'human')
+p.score = p.score + 5
+assert(p.score == 5)
+assert(test.Person('Evelyn', 21).score == 0)
+assert(not pcall(function() p.kind = 'robot' end))
+assert(p.kind == 'human')
+
 "#;
         let res = utils::execute_code(script, "<test>", pxs_Runtime::pxs_Lua);
         assert!(res.is_null(), "Error: {:#?}", res);
@@ -259,6 +280,13 @@ pxs.print(d.toString());
 pxs.print(p.name);
 p.age += 1;
 pxs.print(p.age);
+
+if (p.kind !== 'human') throw new Error('kind');
+p.score += 5;
+if (p.score !== 5 || test.Person('Evelyn', 21).score !== 0) throw new Error('score');
+let assigned = true;
+try { p.kind = 'robot'; } catch (e) { assigned = false; }
+if (assigned || p.kind !== 'human') throw new Error('kind is read only');
 "#;
         let res = utils::execute_code(script, "<test>", pxs_Runtime::pxs_JavaScript);
         assert!(res.is_null(), "JS error is not null: {:#?}", res);
@@ -0,0 +1,86 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_objstats --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use std::{ffi::c_void, ptr};
+
+    use pixelscript::{
+        pxs_finalize, pxs_freevar, pxs_getidx, pxs_initialize, pxs_newhost, pxs_newobject, pxs_objstats,
+        pxs_objstats_enable, pxs_objstats_reset,
+        shared::{utils, var::{pxs_VarObject, pxs_VarT}},
+    };
+
+    extern "C" fn free_nothing(_ptr: *mut c_void) {}
+
+    /// A host object of `type_name` and the language object holding its first reference. Its pointer is never used.
+    fn new_host(type_name: &std::ffi::CStr) -> pxs_VarObject {
+        let object = pxs_newobject(8 as *mut c_void, free_nothing, type_name.as_ptr());
+        let host = pxs_newhost(object);
+        let holder = pxs_VarObject::new_as_host(ptr::null_mut(), pxs_getidx(host));
+        pxs_freevar(host);
+        holder
+    }
+
+    fn int(stats: pxs_VarT, type_name: &str, key: &str) -> i64 {
+        let stats = unsafe { &*stats };
+        let entry = stats.get_map().unwrap().get_str(type_name).expect(type_name);
+        entry.get_map().unwrap().get_str(key).expect(key).get_i64().unwrap()
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        // Not followed while off.
+        let early = new_host(c"Early");
+        pxs_objstats_enable(true);
+        drop(early.clone());
+        drop(early);
+
+        // 10 bullets, each held twice more for a moment.
+        let mut bullets = vec![];
+        for _ in 0..10 {
+            let bullet = new_host(c"Bullet");
+            drop(bullet.clone());
+            drop(bullet.clone());
+            bullets.push(bullet);
+        }
+        let player = new_host(c"Player");
+        bullets.truncate(3);
+
+        let stats = pxs_objstats();
+        assert!(unsafe { &*stats }.get_map().unwrap().get_str("Early").is_none());
+        assert_eq!(int(stats, "Bullet", "created"), 10);
+        assert_eq!(int(stats, "Bullet", "destroyed"), 7);
+        assert_eq!(int(stats, "Bullet", "live"), 3);
+        assert_eq!(int(stats, "Bullet", "peak"), 10);
+        // Created, 2 references taken and let go, destroyed.
+        assert_eq!(int(stats, "Bullet", "ref_ops"), 10 + 10 * 4 + 7);
+        assert_eq!((int(stats, "Player", "created"), int(stats, "Player", "live")), (1, 1));
+        pxs_freevar(stats);
+
+        // Reset keeps the live ones.
+        pxs_objstats_reset();
+        drop(player);
+        let stats = pxs_objstats();
+        assert_eq!(int(stats, "Bullet", "created"), 0);
+        assert_eq!((int(stats, "Bullet", "live"), int(stats, "Bullet", "peak")), (3, 3));
+        assert_eq!((int(stats, "Player", "destroyed"), int(stats, "Player", "live")), (1, 0));
+        pxs_freevar(stats);
+
+        drop(bullets);
+        pxs_objstats_enable(false);
+        pxs_finalize();
+    }
+}
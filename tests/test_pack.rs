@@ -0,0 +1,132 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_pack --no-default-features --features "lua,python,js,pxs_pack,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use pixelscript::{
+        pxs_core::pxs_pack::{pack_var, unpack_bytes},
+        pxs_finalize, pxs_freevar, pxs_getbuffer, pxs_initialize, pxs_newbytes_borrowed, pxs_newint, pxs_pack, pxs_unpack,
+        shared::{
+            pxs_Opaque, pxs_Runtime, utils,
+            var::{pxs_Var, pxs_VarMap, pxs_VarType},
+        },
+    };
+
+    fn test_runtime(runtime: pxs_Runtime, code: &str) {
+        let res = utils::execute_code(code, "<pack>", runtime);
+        assert!(res.is_null(), "Error is not null: {:#?}", res);
+    }
+
+    fn test_host() {
+        // Types pick their own formats.
+        assert_eq!(pack_var(None, &pxs_Var::new_i64(1)).unwrap(), [0x01]);
+        assert_eq!(pack_var(None, &pxs_Var::new_i64(-1)).unwrap(), [0xff]);
+        assert_eq!(pack_var(None, &pxs_Var::new_u64(1)).unwrap(), [0xcc, 0x01]);
+        assert_eq!(pack_var(None, &pxs_Var::new_byte(7)).unwrap(), [0xd4, 0x01, 0x07]);
+        assert_eq!(pack_var(None, &pxs_Var::new_string("a".to_string())).unwrap(), [0xa1, b'a']);
+
+        let mut map = pxs_VarMap::new();
+        map.add_item(pxs_Var::new_i64(-300), pxs_Var::new_string("x".repeat(40)));
+        map.add_item(pxs_Var::new_bool(true), pxs_Var::new_u64(u64::MAX));
+        map.add_item(
+            pxs_Var::new_string("list".to_string()),
+            pxs_Var::new_list_with(vec![pxs_Var::new_f64(0.1), pxs_Var::new_null(), pxs_Var::new_i64(i64::MIN)]),
+        );
+        map.add_item(
+            pxs_Var::new_string("bytes".to_string()),
+            pxs_Var::new_list_with((0..=255).map(pxs_Var::new_byte).collect()),
+        );
+        let packed = pack_var(None, &pxs_Var::new_map_with(map)).unwrap();
+
+        let var = unpack_bytes(&packed).unwrap();
+        let map = var.get_map().unwrap();
+        assert_eq!(map.len(), 4);
+        assert_eq!(map.get_item(&pxs_Var::new_i64(-300)).unwrap().get_string().unwrap(), "x".repeat(40));
+        assert_eq!(map.get_item(&pxs_Var::new_bool(true)).unwrap().get_u64().unwrap(), u64::MAX);
+        let list = map.get_item(&pxs_Var::new_string("list".to_string())).unwrap().get_list().unwrap();
+        assert_eq!(list.get_item(0).unwrap().get_f64().unwrap(), 0.1);
+        assert!(list.get_item(1).unwrap().is_null());
+        assert_eq!(list.get_item(2).unwrap().get_i64().unwrap(), i64::MIN);
+        let bytes = map.get_item(&pxs_Var::new_string("bytes".to_string())).unwrap().get_list().unwrap();
+        assert_eq!(bytes.len(), 256);
+        assert_eq!(bytes.get_item(255).unwrap().get_byte().unwrap(), 255);
+
+        for bad in [&[][..], &[0x92, 0x01], &[0xa3, b'a'], &[0xc1], &[0x01, 0x02], &[0x81, 0x90, 0x01]] {
+            assert!(unpack_bytes(bad).is_err(), "{bad:?} should not unpack");
+        }
+
+        // Through the C API, pxs_newbytes_borrowed like a file the host read.
+        let int = pxs_newint(42);
+        let packed = pxs_pack(std::ptr::null_mut(), int);
+        let mut len = 0;
+        let data = pxs_getbuffer(packed, &mut len);
+        let bytes = pxs_newbytes_borrowed(data, len, None);
+        let var = pxs_unpack(bytes);
+        assert_eq!(unsafe { (*var).get_i64().unwrap() }, 42);
+        pxs_freevar(var);
+        pxs_freevar(bytes);
+        pxs_freevar(packed);
+        pxs_freevar(int);
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        test_host();
+
+        test_runtime(
+            pxs_Runtime::pxs_Lua,
+            r#"
+local packed = pxs_pack.pack({name = "pxs", list = {1, 2.5, "three"}, [10] = true})
+assert(#packed > 0)
+local value = pxs_pack.unpack(packed)
+assert(value.name == "pxs")
+assert(value.list[2] == 2.5 and value.list[3] == "three")
+assert(value[10] == true)
+assert(not pcall(pxs_pack.unpack, "\193"))
+"#,
+        );
+
+        test_runtime(
+            pxs_Runtime::pxs_Python,
+            r#"
+import pxs_pack
+packed = pxs_pack.pack({"name": "pxs", 1: [1, 2.5, None]})
+value = pxs_pack.unpack(packed)
+assert value["name"] == "pxs"
+assert value[1][1] == 2.5
+assert value[1][2] is None
+value = pxs_pack.unpack(packed.tobytes())
+assert value["name"] == "pxs"
+"#,
+        );
+
+        test_runtime(
+            pxs_Runtime::pxs_JavaScript,
+            r#"
+import * as pxs_pack from 'pxs_pack';
+let packed = pxs_pack.pack({name: "pxs", list: [1, 2.5]});
+if (!(packed instanceof ArrayBuffer)) {
+    throw new Error("not a ArrayBuffer");
+}
+let value = pxs_pack.unpack(packed);
+if (value.name != "pxs" || value.list[1] != 2.5) {
+    throw new Error("bad round trip");
+}
+"#,
+        );
+
+        pxs_finalize();
+    }
+}
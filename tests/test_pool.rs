@@ -0,0 +1,73 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_pool --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use pixelscript::{
+        pxs_finalize, pxs_initialize, pxs_pool_acquire, pxs_pool_create, pxs_pool_free, pxs_pool_release,
+        shared::{pool::pxs_RuntimePool, pxs_Opaque, pxs_Runtime, utils},
+    };
+
+    unsafe extern "C" fn setup(_opaque: pxs_Opaque) {
+        utils::setup_pxs();
+    }
+
+    fn run(script: &str, runtime: pxs_Runtime) -> bool {
+        utils::execute_code(script, "<test>", runtime).is_null()
+    }
+
+    fn test_scripts() {
+        assert!(run("local pxs = require('pxs')\npxs.print('Working Lua')\nleaked = 1", pxs_Runtime::pxs_Lua));
+        assert!(run("from pxs import *\nprint('Working Python')\nleaked = 1", pxs_Runtime::pxs_Python));
+        assert!(run("import * as pxs from 'pxs';\npxs.print('Working JS');\nglobalThis.leaked = 1;", pxs_Runtime::pxs_JavaScript));
+    }
+
+    fn test_reset() {
+        // Globals from the last user are gone, the module is still loaded.
+        assert!(run("assert(leaked == nil)\nlocal pxs = require('pxs')", pxs_Runtime::pxs_Lua));
+        assert!(run("assert 'leaked' not in globals()\nfrom pxs import *", pxs_Runtime::pxs_Python));
+        assert!(run("if (globalThis.leaked !== undefined) { throw new Error('leaked'); }", pxs_Runtime::pxs_JavaScript));
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        let pool = pxs_pool_create(2, Some(setup), std::ptr::null_mut());
+
+        for i in 0..8 {
+            // Raw pointers are not `Send`.
+            let addr = pool as usize;
+            let handle = std::thread::spawn(move || {
+                let pool = addr as *mut pxs_RuntimePool;
+                assert!(pxs_pool_acquire(pool));
+                // One set per thread.
+                assert!(!pxs_pool_acquire(pool));
+                if i > 0 {
+                    test_reset();
+                }
+                test_scripts();
+                assert!(pxs_pool_release(pool));
+                assert!(!pxs_pool_release(pool));
+            });
+
+            handle.join().unwrap();
+        }
+
+        // The main thread keeps its own state.
+        test_scripts();
+
+        pxs_pool_free(pool);
+        pxs_finalize();
+    }
+}
@@ -0,0 +1,75 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_profiler --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use etffi::own_string;
+    use pixelscript::{
+        pxs_addfunc, pxs_addmod, pxs_finalize, pxs_initialize, pxs_newmod, pxs_newnull, pxs_profiler_start,
+        pxs_profiler_stop,
+        shared::{pxs_Runtime, utils, var::pxs_VarT},
+    };
+
+    /// `test.nap()` time spent in the host.
+    extern "C" fn nap(_args: pxs_VarT) -> pxs_VarT {
+        std::thread::sleep(std::time::Duration::from_millis(30));
+        pxs_newnull()
+    }
+
+    fn test_runtime(runtime: pxs_Runtime, code: &str) {
+        let res = utils::execute_code(code, "<profiler>", runtime);
+        assert!(res.is_null(), "Error is not null: {:#?}", res);
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        let module = pxs_newmod(c"test".as_ptr());
+        pxs_addfunc(module, c"nap".as_ptr(), nap);
+        pxs_addmod(module);
+
+        assert!(!pxs_profiler_start(0));
+        assert!(pxs_profiler_start(1000));
+        assert!(!pxs_profiler_start(1000));
+
+        test_runtime(
+            pxs_Runtime::pxs_Lua,
+            "local t = require('test')\nlocal function busy_lua(n)\n  local x = 0\n  for i = 1, n do x = x + i % 7 end\n  return x\nend\nbusy_lua(20000000)\nt.nap()",
+        );
+        test_runtime(
+            pxs_Runtime::pxs_Python,
+            "import test\ndef busy_python(n):\n    x = 0\n    for i in range(n):\n        x += i % 7\n    return x\nbusy_python(1000000)\ntest.nap()",
+        );
+        test_runtime(
+            pxs_Runtime::pxs_JavaScript,
+            "import * as t from 'test';\nfunction busy_js(n) { let x = 0; for (let i = 0; i < n; i++) { x += i % 7; } return x; }\nbusy_js(20000000);\nt.nap();",
+        );
+
+        let stacks = own_string!(pxs_profiler_stop());
+        println!("{stacks}");
+        for line in stacks.lines() {
+            let count = line.rsplit(' ').next().unwrap();
+            assert!(count.parse::<u64>().unwrap() > 0, "bad line: {line}");
+        }
+        assert!(stacks.lines().any(|line| line.starts_with("[lua]") && line.contains("busy_lua")));
+        assert!(stacks.lines().any(|line| line.starts_with("[python]") && line.contains("busy_python")));
+        assert!(stacks.lines().any(|line| line.starts_with("[js]") && line.contains("busy_js")));
+        assert!(stacks.contains("[host] _testnap"));
+
+        // Not running anymore.
+        assert!(own_string!(pxs_profiler_stop()).is_empty());
+
+        pxs_finalize();
+    }
+}
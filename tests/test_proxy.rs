@@ -0,0 +1,95 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_proxy --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use etffi::cstring::CStringSafe;
+    use pixelscript::{
+        pxs_addfunc, pxs_addmod, pxs_finalize, pxs_freevar, pxs_getproxy, pxs_initialize, pxs_listadd, pxs_listget,
+        pxs_listlen, pxs_map_addpair, pxs_newbool, pxs_newint, pxs_newlist, pxs_newmap, pxs_newmod, pxs_newproxy,
+        pxs_newstring, pxs_varis,
+        shared::{pxs_Runtime, utils, var::{pxs_VarT, pxs_VarType}},
+    };
+
+    /// [10, 20, 30]
+    fn new_list() -> pxs_VarT {
+        let list = pxs_newlist();
+        for i in 1..=3 {
+            pxs_listadd(list, pxs_newint(i * 10));
+        }
+        list
+    }
+
+    /// {"a": 1, "b": [10, 20, 30]}
+    fn new_map() -> pxs_VarT {
+        let mut cstrgen = CStringSafe::new();
+        let map = pxs_newmap();
+        pxs_map_addpair(map, pxs_newstring(cstrgen.new_string("a")), pxs_newint(1));
+        pxs_map_addpair(map, pxs_newstring(cstrgen.new_string("b")), new_list());
+        map
+    }
+
+    extern "C" fn list(_args: pxs_VarT) -> pxs_VarT {
+        pxs_newproxy(new_list())
+    }
+
+    extern "C" fn map(_args: pxs_VarT) -> pxs_VarT {
+        pxs_newproxy(new_map())
+    }
+
+    /// Did the proxy come back as a proxy?
+    extern "C" fn same(args: pxs_VarT) -> pxs_VarT {
+        pxs_newbool(!pxs_getproxy(pxs_listget(args, 1)).is_null())
+    }
+
+    fn test_runtime(runtime: pxs_Runtime, code: &str) {
+        let res = utils::execute_code(code, "<proxy>", runtime);
+        assert!(res.is_null(), "Error is not null: {:#?}", res);
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        // Host side.
+        let proxy = pxs_newproxy(new_list());
+        assert!(pxs_varis(proxy, pxs_VarType::pxs_Proxy));
+        assert_eq!(pxs_listlen(pxs_getproxy(proxy)), 3);
+        pxs_freevar(proxy);
+        let not_a_container = pxs_newproxy(pxs_newint(1));
+        assert!(pxs_varis(not_a_container, pxs_VarType::pxs_Exception));
+        pxs_freevar(not_a_container);
+
+        let mut cstrgen = CStringSafe::new();
+        let test_mod = pxs_newmod(cstrgen.new_string("test"));
+        pxs_addfunc(test_mod, cstrgen.new_string("list"), list);
+        pxs_addfunc(test_mod, cstrgen.new_string("map"), map);
+        pxs_addfunc(test_mod, cstrgen.new_string("same"), same);
+        pxs_addmod(test_mod);
+
+        test_runtime(
+            pxs_Runtime::pxs_Lua,
+            "local t = require('test')\nlocal l = t.list()\nassert(#l == 3 and l[1] == 10 and l[3] == 30 and l[4] == nil and l[0] == nil)\nlocal m = t.map()\nassert(#m == 2 and m.a == 1 and m.b[2] == 20 and m.c == nil)\nassert(t.same(l) and t.same(m))",
+        );
+        test_runtime(
+            pxs_Runtime::pxs_Python,
+            "from test import list, map, same\nl = list()\nassert len(l) == 3 and l[0] == 10 and l[-1] == 30\ntry:\n    l[3]\n    assert False\nexcept IndexError:\n    pass\nm = map()\nassert len(m) == 2 and m['a'] == 1 and m['b'][1] == 20\ntry:\n    m['c']\n    assert False\nexcept KeyError:\n    pass\nassert same(l) and same(m)",
+        );
+        test_runtime(
+            pxs_Runtime::pxs_JavaScript,
+            "import {list, map, same} from 'test';\nconst l = list();\nif (l.length !== 3 || l[0] !== 10 || l[2] !== 30 || l[3] !== undefined) { throw new Error('bad list'); }\nconst m = map();\nif (m.a !== 1 || m.b[1] !== 20 || m.c !== undefined) { throw new Error('bad map'); }\nif (!same(l) || !same(m)) { throw new Error('not a proxy'); }",
+        );
+
+        pxs_finalize();
+    }
+}
@@ -0,0 +1,100 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_publish --no-default-features --features "lua,python,js,pxs_data,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use etffi::cstring::CStringSafe;
+    use pixelscript::{
+        pxs_addfunc, pxs_addmod, pxs_finalize, pxs_freevar, pxs_getint, pxs_getproxy, pxs_initialize, pxs_listadd, pxs_listget,
+        pxs_map_addpair, pxs_mapget, pxs_newbool, pxs_newint, pxs_newlist, pxs_newmap, pxs_newmod, pxs_newstring,
+        pxs_publish, pxs_published, pxs_unpublish, pxs_varis,
+        shared::{pxs_Runtime, utils, var::{pxs_VarT, pxs_VarType}},
+    };
+
+    /// {"sword": {"damage": 5, "tags": ["sharp", "iron"]}, "greeting": "hi"}
+    fn new_items(damage: i64) -> pxs_VarT {
+        let mut cstrgen = CStringSafe::new();
+        let tags = pxs_newlist();
+        pxs_listadd(tags, pxs_newstring(cstrgen.new_string("sharp")));
+        pxs_listadd(tags, pxs_newstring(cstrgen.new_string("iron")));
+        let sword = pxs_newmap();
+        pxs_map_addpair(sword, pxs_newstring(cstrgen.new_string("damage")), pxs_newint(damage));
+        pxs_map_addpair(sword, pxs_newstring(cstrgen.new_string("tags")), tags);
+        let items = pxs_newmap();
+        pxs_map_addpair(items, pxs_newstring(cstrgen.new_string("sword")), sword);
+        pxs_map_addpair(items, pxs_newstring(cstrgen.new_string("greeting")), pxs_newstring(cstrgen.new_string("hi")));
+        items
+    }
+
+    /// Did the value come in as a view?
+    extern "C" fn is_view(args: pxs_VarT) -> pxs_VarT {
+        pxs_newbool(!pxs_getproxy(pxs_listget(args, 1)).is_null())
+    }
+
+    fn test_runtime(runtime: pxs_Runtime, code: &str) {
+        let res = utils::execute_code(code, "<publish>", runtime);
+        assert!(res.is_null(), "Error is not null: {:#?}", res);
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        let mut cstrgen = CStringSafe::new();
+        assert!(pxs_publish(cstrgen.new_string("items"), new_items(5)));
+        assert!(!pxs_publish(cstrgen.new_string("number"), pxs_newint(1)));
+
+        // Host side, nested containers are views too. `sword` is borrowed from `items`.
+        let items = pxs_published(cstrgen.new_string("items"));
+        assert!(pxs_varis(items, pxs_VarType::pxs_Proxy));
+        let key = pxs_newstring(cstrgen.new_string("sword"));
+        let sword = pxs_mapget(pxs_getproxy(items), key);
+        assert!(pxs_varis(sword, pxs_VarType::pxs_Proxy));
+        pxs_freevar(key);
+        let missing = pxs_published(cstrgen.new_string("missing"));
+        assert!(pxs_varis(missing, pxs_VarType::pxs_Null));
+        pxs_freevar(missing);
+
+        let test_mod = pxs_newmod(cstrgen.new_string("test"));
+        pxs_addfunc(test_mod, cstrgen.new_string("is_view"), is_view);
+        pxs_addmod(test_mod);
+
+        test_runtime(
+            pxs_Runtime::pxs_Lua,
+            "local t = require('test')\nlocal items = pxs_data.get('items')\nassert(items.sword.damage == 5 and items.sword.tags[2] == 'iron' and items.greeting == 'hi')\nassert(t.is_view(items.sword) and t.is_view(items.sword.tags))\nlocal keys = pxs_data.keys(items)\nassert(keys[1] == 'sword' and keys[2] == 'greeting')\nassert(pxs_data.get('missing') == nil)",
+        );
+        test_runtime(
+            pxs_Runtime::pxs_Python,
+            "import pxs_data\nfrom test import is_view\nitems = pxs_data.get('items')\nassert items['sword']['damage'] == 5 and items['sword']['tags'][-1] == 'iron'\nassert is_view(items['sword']['tags'])\nassert pxs_data.keys(items) == ['sword', 'greeting']\nassert 'items' in pxs_data.names()",
+        );
+        test_runtime(
+            pxs_Runtime::pxs_JavaScript,
+            "import * as pxs_data from 'pxs_data';\nimport {is_view} from 'test';\nconst items = pxs_data.get('items');\nif (items.sword.damage !== 5 || items.sword.tags[0] !== 'sharp' || items.sword.tags.length !== 2) { throw new Error('bad items'); }\nif (!is_view(items.sword)) { throw new Error('not a view'); }\nif (pxs_data.keys(items).join() !== 'sword,greeting') { throw new Error('bad keys'); }",
+        );
+
+        // Publishing again replaces the data, old views keep theirs.
+        assert!(pxs_publish(cstrgen.new_string("items"), new_items(7)));
+        test_runtime(pxs_Runtime::pxs_Lua, "assert(pxs_data.get('items').sword.damage == 7)");
+        let key = pxs_newstring(cstrgen.new_string("damage"));
+        let damage = pxs_mapget(pxs_getproxy(sword), key);
+        assert_eq!(pxs_getint(damage), 5);
+        pxs_freevar(key);
+        pxs_freevar(items);
+
+        assert!(pxs_unpublish(cstrgen.new_string("items")));
+        assert!(!pxs_unpublish(cstrgen.new_string("items")));
+        test_runtime(pxs_Runtime::pxs_Python, "import pxs_data\nassert pxs_data.get('items') is None");
+
+        pxs_finalize();
+    }
+}
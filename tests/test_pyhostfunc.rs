@@ -0,0 +1,60 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_pyhostfunc --no-default-features --features "python,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use pixelscript::{
+        pxs_add_submod, pxs_addfunc, pxs_addmod, pxs_finalize, pxs_initialize, pxs_newint, pxs_newmod,
+        shared::{pxs_Runtime, utils, var::pxs_VarT},
+    };
+
+    extern "C" fn one(_args: pxs_VarT) -> pxs_VarT {
+        pxs_newint(1)
+    }
+
+    extern "C" fn two(_args: pxs_VarT) -> pxs_VarT {
+        pxs_newint(2)
+    }
+
+    fn test_python(code: &str) {
+        let res = utils::execute_code(code, "<pyhostfunc>", pxs_Runtime::pxs_Python);
+        assert!(res.is_null(), "Error is not null: {:#?}", res);
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        let module = pxs_newmod(c"hostfns".as_ptr());
+        pxs_addfunc(module, c"one".as_ptr(), one);
+        let sub = pxs_newmod(c"sub".as_ptr());
+        pxs_addfunc(sub, c"two".as_ptr(), two);
+        pxs_add_submod(module, sub);
+        pxs_addmod(module);
+
+        // Functions are one shared native type, callable like any function and passed around as one.
+        test_python(
+            r#"
+import hostfns
+from hostfns.sub import two
+assert type(hostfns.one).__name__ == 'pxs_hostfunc'
+assert callable(hostfns.one)
+f = hostfns.one
+assert f() + two() == 3
+assert list(map(lambda g: g(), [hostfns.one, two])) == [1, 2]
+"#,
+        );
+
+        pxs_finalize();
+    }
+}
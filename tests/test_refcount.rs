@@ -15,9 +15,9 @@ mod tests {
 
     use pixelscript::{
         own_var, pxs_addmod, pxs_addobject,
-        pxs_finalize, pxs_freearena, pxs_gethost, pxs_getstring, pxs_initialize, pxs_listget,
+        pxs_finalize, pxs_freearena, pxs_freevar, pxs_gethost, pxs_getstring, pxs_initialize, pxs_listget,
         pxs_newarena, pxs_newhost, pxs_newmod, pxs_newobject, pxs_newstring, pxs_object_addfunc,
-        shared::{module::pxs_Module, pxs_Runtime, utils, var::pxs_VarT},
+        shared::{module::pxs_Module, pxs_Runtime, utils, var::{pxs_Var, pxs_VarT}},
     };
     use etffi::{cstring::CStringSafe, borrow_string, create_raw_string, free_raw_string, own_string, ptr_magic::PtrMagic};
 
@@ -108,6 +108,34 @@ print(p.get_name())
         assert!(res.is_null(), "lua error is not null: {:#?}", res);
     }
 
+    fn new_host(name: &str) -> pxs_VarT {
+        let person = Person { name: name.to_string() };
+        let person_name = create_raw_string!("Person");
+        let object = pxs_newobject(person.into_raw() as *mut c_void, free_person, person_name);
+        unsafe {
+            free_raw_string!(person_name);
+        }
+        pxs_newhost(object)
+    }
+
+    fn test_stale_handle() {
+        let first = new_host("First");
+        let first_idx = unsafe { pxs_Var::from_borrow(first) }.get_host_idx();
+        pxs_freevar(first);
+
+        // Reuses the slot, with a new generation.
+        let second = new_host("Second");
+        let second_idx = unsafe { pxs_Var::from_borrow(second) }.get_host_idx();
+        assert_ne!(first_idx, second_idx);
+
+        // The old id finds nothing, dropping it does not touch the new object.
+        let stale = pxs_Var::new_host_object(first_idx);
+        assert!(stale.get_host_ptr().is_null());
+        drop(stale);
+        assert!(!unsafe { pxs_Var::from_borrow(second) }.get_host_ptr().is_null());
+        pxs_freevar(second);
+    }
+
     #[test]
     fn run_test() {
         pxs_initialize();
@@ -126,6 +154,8 @@ print(p.get_name())
         test_lua();
         print_helper("JavaScript");
         test_js();
+        print_helper("Stale handle");
+        test_stale_handle();
 
         pxs_finalize();
     }
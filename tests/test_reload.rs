@@ -0,0 +1,91 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_reload --no-default-features --features "lua,python,js,js_commonjs,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use std::{
+        ffi::{CStr, c_char},
+        sync::atomic::{AtomicI64, Ordering},
+    };
+
+    use pixelscript::{
+        pxs_filecache_enable, pxs_finalize, pxs_freevar, pxs_initialize, pxs_newnull, pxs_reload_module,
+        pxs_set_filereader,
+        shared::{pxs_Runtime, utils, var::{pxs_Var, pxs_VarT}},
+    };
+
+    /// Version of the files, 0 is a syntax error.
+    static VERSION: AtomicI64 = AtomicI64::new(1);
+
+    unsafe extern "C" fn file_loader(file_path: *const c_char) -> pxs_VarT {
+        let file_path = unsafe { CStr::from_ptr(file_path) }.to_str().unwrap();
+        let n = VERSION.load(Ordering::Relaxed);
+        let code = match file_path {
+            _ if n == 0 => "this is ( not code".to_string(),
+            "hot" => format!("return {{ n = {n} }}"),
+            "hot.py" => format!("n = {n}"),
+            "hotjs" => format!("export const n = {n};"),
+            _ => return pxs_newnull(),
+        };
+        pxs_Var::new_string(code).into_raw()
+    }
+
+    fn test_runtime(runtime: pxs_Runtime, code: &str) {
+        let res = utils::execute_code(code, "<reload>", runtime);
+        assert!(res.is_null(), "Error is not null: {:#?}", res);
+    }
+
+    fn reload(runtime: pxs_Runtime, name: &CStr) -> bool {
+        let res = pxs_reload_module(runtime, name.as_ptr());
+        let ok = unsafe { &*res }.is_null();
+        pxs_freevar(res);
+        ok
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+        pxs_set_filereader(file_loader);
+        // Reloads read past the cache.
+        pxs_filecache_enable(true);
+
+        test_runtime(pxs_Runtime::pxs_Lua, "held = require('hot')\nassert(held.n == 1)");
+        test_runtime(pxs_Runtime::pxs_Python, "import hot\nassert hot.n == 1");
+        test_runtime(pxs_Runtime::pxs_JavaScript, "if (require('hotjs').n !== 1) throw new Error('js');");
+
+        VERSION.store(2, Ordering::Relaxed);
+        assert!(reload(pxs_Runtime::pxs_Lua, c"hot"));
+        assert!(reload(pxs_Runtime::pxs_Python, c"hot"));
+        assert!(reload(pxs_Runtime::pxs_JavaScript, c"hotjs"));
+
+        // The old module sees the new code, host modules are kept.
+        test_runtime(
+            pxs_Runtime::pxs_Lua,
+            "assert(held.n == 2 and require('hot') == held)\nassert(require('pxs').num == 1)",
+        );
+        test_runtime(pxs_Runtime::pxs_Python, "import pxs\nassert hot.n == 2 and pxs.num == 1");
+        test_runtime(pxs_Runtime::pxs_JavaScript, "if (require('hotjs').n !== 2) throw new Error('js');");
+
+        // A failed reload keeps the old module.
+        VERSION.store(0, Ordering::Relaxed);
+        assert!(!reload(pxs_Runtime::pxs_Lua, c"hot"));
+        assert!(!reload(pxs_Runtime::pxs_JavaScript, c"hotjs"));
+        test_runtime(pxs_Runtime::pxs_Lua, "assert(held.n == 2)");
+        test_runtime(pxs_Runtime::pxs_JavaScript, "if (require('hotjs').n !== 2) throw new Error('js');");
+
+        assert!(!reload(pxs_Runtime::pxs_Lua, c"missing"));
+
+        pxs_filecache_enable(false);
+        pxs_finalize();
+    }
+}
@@ -0,0 +1,92 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_runtimestats --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use pixelscript::{
+        pxs_finalize, pxs_freevar, pxs_initialize, pxs_newint, pxs_newmap, pxs_runtimestats, pxs_statsdiff, pxs_varis,
+        shared::{
+            pxs_Runtime, utils,
+            var::{pxs_Var, pxs_VarType},
+        },
+    };
+
+    fn int(stats: &pxs_Var, key: &str) -> i64 {
+        stats.get_map().unwrap().get_str(key).expect(key).get_i64().unwrap()
+    }
+
+    fn test_runtime(runtime: pxs_Runtime, code: &str) {
+        let res = utils::execute_code(code, "<runtimestats>", runtime);
+        assert!(res.is_null(), "Error is not null: {:#?}", res);
+    }
+
+    fn test_common() {
+        for runtime in [pxs_Runtime::pxs_Lua, pxs_Runtime::pxs_Python, pxs_Runtime::pxs_JavaScript] {
+            let stats = pxs_runtimestats(runtime);
+            let stats_ref = unsafe { &*stats };
+            for key in ["bytes", "peak", "limit", "gc_cycles", "vars", "host_objects", "functions"] {
+                assert!(int(stats_ref, key) >= 0, "{key}");
+            }
+            assert!(int(stats_ref, "bytes") > 0);
+            pxs_freevar(stats);
+        }
+
+        let stats = pxs_runtimestats(pxs_Runtime::pxs_Lua);
+        let stats_ref = unsafe { &*stats };
+        assert_eq!(int(stats_ref, "stack_depth"), 0);
+        assert!(int(stats_ref, "registry_size") > 0);
+        assert!(int(stats_ref, "globals") > 0);
+        pxs_freevar(stats);
+
+        let stats = pxs_runtimestats(pxs_Runtime::pxs_Python);
+        assert!(int(unsafe { &*stats }, "objects_collected") >= 0);
+        pxs_freevar(stats);
+    }
+
+    fn test_diff() {
+        let before = pxs_runtimestats(pxs_Runtime::pxs_JavaScript);
+        test_runtime(pxs_Runtime::pxs_JavaScript, "globalThis.kept = []; for (let i = 0; i < 1000; i++) { kept.push({ i }); }");
+        let after = pxs_runtimestats(pxs_Runtime::pxs_JavaScript);
+        let diff = pxs_statsdiff(before, after);
+        let diff_ref = unsafe { &*diff };
+        assert!(int(diff_ref, "obj_count") >= 1000);
+        assert!(int(diff_ref, "bytes") > 0);
+        assert_eq!(int(diff_ref, "limit"), 0);
+        pxs_freevar(diff);
+
+        // Keys missing in `before` count from 0.
+        let empty = pxs_newmap();
+        let diff = pxs_statsdiff(empty, after);
+        assert_eq!(int(unsafe { &*diff }, "obj_count"), int(unsafe { &*after }, "obj_count"));
+        pxs_freevar(diff);
+
+        let not_map = pxs_newint(1);
+        let diff = pxs_statsdiff(before, not_map);
+        assert!(pxs_varis(diff, pxs_VarType::pxs_Exception));
+        pxs_freevar(diff);
+        pxs_freevar(not_map);
+        pxs_freevar(empty);
+        pxs_freevar(before);
+        pxs_freevar(after);
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        test_common();
+        test_diff();
+
+        pxs_finalize();
+    }
+}
@@ -0,0 +1,59 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_scheduler --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use pixelscript::{
+        own_var, pxs_finalize, pxs_freefuture, pxs_freescheduler, pxs_future_ready, pxs_future_wait,
+        pxs_initialize, pxs_map_addpair, pxs_newint, pxs_newmap, pxs_newscheduler, pxs_newstring, pxs_submit,
+        shared::{pxs_Opaque, pxs_Runtime, utils, var::pxs_Var},
+    };
+    use etffi::{cstring::CStringSafe, ptr_magic::PtrMagic};
+
+    unsafe extern "C" fn setup(_opaque: pxs_Opaque) {
+        utils::setup_pxs();
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        let mut cstr = CStringSafe::new();
+        let scheduler = pxs_newscheduler(4, Some(setup), std::ptr::null_mut());
+
+        let code = cstr.new_string("local pxs = require('pxs')\nreturn n * 2");
+        let futures: Vec<_> = (0..100)
+            .map(|i| {
+                let args = pxs_newmap();
+                pxs_map_addpair(args, pxs_newstring(cstr.new_string("n")), pxs_newint(i));
+                pxs_submit(scheduler, pxs_Runtime::pxs_Lua, code, args)
+            })
+            .collect();
+
+        for (i, future) in futures.into_iter().enumerate() {
+            let res = own_var!(pxs_future_wait(future));
+            assert!(pxs_future_ready(future));
+            assert_eq!(res.as_i64().unwrap(), i as i64 * 2, "Job failed: {:#?}", res);
+            pxs_freefuture(future);
+        }
+
+        // A Lua table can not leave the worker that made it.
+        let bad = pxs_submit(scheduler, pxs_Runtime::pxs_Lua, cstr.new_string("return {}"), std::ptr::null_mut());
+        let res = own_var!(pxs_future_wait(bad));
+        assert!(res.is_exception());
+        pxs_freefuture(bad);
+
+        pxs_freescheduler(scheduler);
+        pxs_finalize();
+    }
+}
@@ -0,0 +1,67 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_snapshot --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use pixelscript::{
+        pxs_finalize, pxs_freesnapshot, pxs_initialize, pxs_snapshot_load, pxs_snapshot_save,
+        shared::{pxs_Runtime, utils},
+    };
+
+    fn test_lua() {
+        let script = r#"
+local pxs = require('pxs')
+local data = pxs_json.encode({a = 1})
+pxs.print('Working Lua ' .. data)
+"#;
+        let res = utils::execute_code(script, "<snapshot>", pxs_Runtime::pxs_Lua);
+        assert!(res.is_null(), "Lua error is not null: {:#?}", res);
+    }
+
+    fn test_js() {
+        let script = r#"
+import * as pxs from 'pxs';
+import * as json from 'pxs_json';
+
+pxs.print('Working JS');
+"#;
+        let res = utils::execute_code(script, "<snapshot>", pxs_Runtime::pxs_JavaScript);
+        assert!(res.is_null(), "JS error is not null: {:#?}", res);
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+        test_lua();
+        test_js();
+
+        for runtime in [pxs_Runtime::pxs_Lua, pxs_Runtime::pxs_JavaScript] {
+            let mut len = 0;
+            let data = pxs_snapshot_save(runtime.clone(), &mut len);
+            assert!(len > 0);
+
+            // Loads into the same version, the next compile of the same source uses the bytecode.
+            assert!(pxs_snapshot_load(runtime.clone(), data, len));
+            // Wrong runtime.
+            assert!(!pxs_snapshot_load(pxs_Runtime::pxs_Python, data, len));
+            // Truncated.
+            assert!(!pxs_snapshot_load(runtime, data, len / 2));
+            pxs_freesnapshot(data, len);
+        }
+
+        test_lua();
+        test_js();
+
+        pxs_finalize();
+    }
+}
@@ -0,0 +1,86 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_startup --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use pixelscript::{
+        pxs_add_submod, pxs_addfunc, pxs_addmod, pxs_finalize, pxs_freevar, pxs_initialize, pxs_newmod, pxs_newnull,
+        pxs_startupbegin, pxs_startupend, pxs_startupstats,
+        shared::{utils, var::{pxs_Var, pxs_VarT}},
+    };
+
+    extern "C" fn noop(_args: pxs_VarT) -> pxs_VarT {
+        pxs_newnull()
+    }
+
+    fn get<'a>(var: &'a pxs_Var, key: &str) -> &'a pxs_Var {
+        var.get_map().unwrap().get_str(key).expect(key)
+    }
+
+    fn int(var: &pxs_Var, key: &str) -> i64 {
+        get(var, key).get_i64().unwrap()
+    }
+
+    fn string(var: &pxs_Var, key: &str) -> String {
+        get(var, key).get_string().unwrap()
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        pxs_startupbegin(c"host".as_ptr());
+        let module = pxs_newmod(c"startup".as_ptr());
+        pxs_addfunc(module, c"a".as_ptr(), noop);
+        pxs_addfunc(module, c"b".as_ptr(), noop);
+        let sub = pxs_newmod(c"sub".as_ptr());
+        pxs_addfunc(sub, c"c".as_ptr(), noop);
+        pxs_add_submod(module, sub);
+        pxs_addmod(module);
+        assert!(pxs_startupend());
+        assert!(!pxs_startupend());
+
+        let stats = pxs_startupstats();
+        let stats_ref = unsafe { &*stats };
+        assert!(int(get(stats_ref, "initialize"), "ns") > 0);
+
+        let phases = get(stats_ref, "phases").get_list().unwrap();
+        let phases: Vec<(String, String, i64, i64)> = phases
+            .vars
+            .iter()
+            .map(|phase| (string(phase, "name"), string(phase, "runtime"), int(phase, "depth"), int(phase, "ns")))
+            .collect();
+        println!("{phases:#?}");
+        for runtime in ["lua", "python", "js"] {
+            let start = phases.iter().position(|phase| phase.0 == "start" && phase.1 == runtime).expect(runtime);
+            assert_eq!(phases[start].2, 0);
+            assert!(phases[start].3 > 0);
+            // Its steps come right after it, one deeper.
+            let steps: Vec<&str> =
+                phases[start + 1..].iter().take_while(|phase| phase.2 == 1).map(|phase| phase.0.as_str()).collect();
+            assert!(steps.contains(&"vm") && steps.contains(&"globals"), "{runtime}: {steps:?}");
+        }
+        assert!(phases.iter().any(|phase| phase.0 == "host" && phase.1.is_empty() && phase.2 == 0));
+
+        let modules = get(stats_ref, "modules").get_list().unwrap();
+        let module = modules.vars.iter().find(|module| string(module, "name") == "startup").unwrap();
+        assert_eq!(int(module, "functions"), 3);
+        let runtimes = get(module, "runtimes");
+        let per_runtime: i64 = ["lua", "python", "js"].iter().map(|runtime| int(get(runtimes, runtime), "ns")).sum();
+        assert_eq!(int(module, "ns"), per_runtime);
+        assert!(int(get(stats_ref, "modules_total"), "ns") >= per_runtime);
+        pxs_freevar(stats);
+
+        pxs_finalize();
+    }
+}
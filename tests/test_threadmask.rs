@@ -0,0 +1,79 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_threadmask --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use pixelscript::{
+        pxs_finalize, pxs_freevar, pxs_initialize, pxs_startthread_with, pxs_startupstats, pxs_stopthread,
+        shared::{pxs_Runtime, utils},
+    };
+
+    /// `start_thread` phases of `runtime` recorded so far.
+    fn thread_starts(runtime: &str) -> usize {
+        let stats = pxs_startupstats();
+        let phases = unsafe { &*stats }.get_map().unwrap().get_str("phases").unwrap().get_list().unwrap();
+        let count = phases
+            .vars
+            .iter()
+            .filter(|phase| {
+                let phase = phase.get_map().unwrap();
+                phase.get_str("name").unwrap().get_string().unwrap() == "start_thread"
+                    && phase.get_str("runtime").unwrap().get_string().unwrap() == runtime
+            })
+            .count();
+        pxs_freevar(stats);
+        count
+    }
+
+    fn test_runtime(runtime: pxs_Runtime, code: &str) {
+        let res = utils::execute_code(code, "<threadmask>", runtime);
+        assert!(res.is_null(), "Error is not null: {:#?}", res);
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        // Lua only workers.
+        for _ in 0..4 {
+            std::thread::spawn(|| {
+                pxs_startthread_with(1 << pxs_Runtime::pxs_Lua.into_i64());
+                utils::setup_pxs();
+                test_runtime(pxs_Runtime::pxs_Lua, "local pxs = require('pxs')\nassert(pxs.num == 1)");
+                pxs_stopthread();
+            })
+            .join()
+            .unwrap();
+        }
+        assert_eq!((thread_starts("lua"), thread_starts("python"), thread_starts("js")), (4, 0, 0));
+
+        // The others still start when used, with the modules added before.
+        std::thread::spawn(|| {
+            pxs_startthread_with(0);
+            utils::setup_pxs();
+            assert_eq!(thread_starts("python"), 0);
+            test_runtime(pxs_Runtime::pxs_Python, "import pxs\nassert pxs.num == 1");
+            test_runtime(
+                pxs_Runtime::pxs_JavaScript,
+                "import * as pxs from 'pxs';\nif (pxs.num !== 1) throw new Error('js');",
+            );
+            pxs_stopthread();
+        })
+        .join()
+        .unwrap();
+        assert_eq!((thread_starts("lua"), thread_starts("python"), thread_starts("js")), (4, 1, 1));
+
+        test_runtime(pxs_Runtime::pxs_Python, "import pxs\nassert pxs.num == 1");
+        pxs_finalize();
+    }
+}
@@ -0,0 +1,50 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_trace --no-default-features --features "lua,python,js,testing,pxs_trace" -- --nocapture --test-threads=1
+
+#[cfg(all(test, feature = "pxs_trace"))]
+#[allow(unused)]
+mod tests {
+    use etffi::{cstring::CStringSafe, own_string};
+    use pixelscript::{
+        pxs_finalize, pxs_freevar, pxs_initialize, pxs_leakreport, pxs_listadd, pxs_newint, pxs_newlist,
+        pxs_settracetag, shared::utils,
+    };
+
+    fn report() -> String {
+        own_string!(pxs_leakreport())
+    }
+
+    #[test]
+    fn run_test() {
+        pxs_initialize();
+        utils::setup_pxs();
+
+        let mut cstrgen = CStringSafe::new();
+        pxs_settracetag(cstrgen.new_string("leaky"));
+        let leaked = pxs_newint(1);
+        let list = pxs_newlist();
+        // Moved into the list, so no longer the host's.
+        pxs_listadd(list, pxs_newint(2));
+        pxs_settracetag(std::ptr::null());
+
+        let res = report();
+        println!("{res}");
+        let lines: Vec<&str> = res.lines().filter(|line| line.ends_with("leaky")).collect();
+        assert_eq!(lines.len(), 2, "{res}");
+        assert!(lines.iter().any(|line| line.trim_start().starts_with("1  pxs_Int64")), "{res}");
+        assert!(lines.iter().any(|line| line.trim_start().starts_with("1  pxs_List")), "{res}");
+
+        pxs_freevar(leaked);
+        pxs_freevar(list);
+        assert!(!report().contains("leaky"));
+
+        pxs_finalize();
+    }
+}
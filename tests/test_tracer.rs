@@ -0,0 +1,106 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_tracer --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use std::{ffi::{CStr, c_char}, sync::Mutex};
+
+    use etffi::own_string;
+    use pixelscript::{
+        pxs_addfunc, pxs_addmod, pxs_exec, pxs_finalize, pxs_freevar, pxs_garbagecollect, pxs_initialize, pxs_newmod,
+        pxs_newnull, pxs_settracer, pxs_tracebegin, pxs_traceend, pxs_tracewriter_start, pxs_tracewriter_stop,
+        shared::{
+            pxs_Opaque, pxs_Runtime,
+            tracer::{pxs_TraceKind, pxs_Tracer},
+            utils,
+            var::pxs_VarT,
+        },
+    };
+
+    /// Events seen by the tracer: (begin, kind, runtime, name).
+    static EVENTS: Mutex<Vec<(bool, pxs_TraceKind, i32, String)>> = Mutex::new(vec![]);
+
+    unsafe extern "C" fn on_begin(_opaque: pxs_Opaque, kind: pxs_TraceKind, runtime: i32, name: *const c_char) {
+        let name = unsafe { CStr::from_ptr(name) }.to_string_lossy().to_string();
+        EVENTS.lock().unwrap().push((true, kind, runtime, name));
+    }
+
+    unsafe extern "C" fn on_end(_opaque: pxs_Opaque, kind: pxs_TraceKind, runtime: i32, name: *const c_char) {
+        let name = unsafe { CStr::from_ptr(name) }.to_string_lossy().to_string();
+        EVENTS.lock().unwrap().push((false, kind, runtime, name));
+    }
+
+    /// `test.tick()`
+    extern "C" fn tick(_args: pxs_VarT) -> pxs_VarT {
+        pxs_newnull()
+    }
+
+    fn exec(runtime: pxs_Runtime, code: &std::ffi::CStr) {
+        let res = pxs_exec(runtime, code.as_ptr(), c"<tracer>".as_ptr());
+        assert!(res.is_null(), "Error is not null");
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        let module = pxs_newmod(c"test".as_ptr());
+        pxs_addfunc(module, c"tick".as_ptr(), tick);
+        pxs_addmod(module);
+
+        let tracer = pxs_Tracer { begin: Some(on_begin), end: Some(on_end), opaque: std::ptr::null_mut() };
+        pxs_settracer(&tracer);
+        assert!(!pxs_tracewriter_start(0));
+        assert!(pxs_tracewriter_start(1000));
+        assert!(!pxs_tracewriter_start(1000));
+
+        pxs_tracebegin(c"frame \"1\"".as_ptr());
+        exec(pxs_Runtime::pxs_Lua, c"local t = require('test')\nt.tick()");
+        exec(pxs_Runtime::pxs_JavaScript, c"import * as t from 'test';\nt.tick();");
+        pxs_garbagecollect();
+        pxs_traceend(c"frame \"1\"".as_ptr());
+        pxs_settracer(std::ptr::null());
+
+        let events = std::mem::take(&mut *EVENTS.lock().unwrap());
+        let begins = events.iter().filter(|event| event.0).count();
+        assert_eq!(begins * 2, events.len(), "every begin has a end");
+        assert_eq!(events.first().unwrap(), &(true, pxs_TraceKind::pxs_TraceMark, -1, "frame \"1\"".to_string()));
+        assert!(events.contains(&(true, pxs_TraceKind::pxs_TraceExec, 0, "<tracer>".to_string())));
+        assert!(events.contains(&(true, pxs_TraceKind::pxs_TraceHost, 0, "_testtick".to_string())));
+        assert!(events.contains(&(false, pxs_TraceKind::pxs_TraceHost, 2, "_testtick".to_string())));
+        assert!(events.contains(&(true, pxs_TraceKind::pxs_TraceGC, 1, "collect".to_string())));
+
+        // Host calls are nested in their exec.
+        let exec_begin = events.iter().position(|event| event.0 && event.1 == pxs_TraceKind::pxs_TraceExec).unwrap();
+        let host_begin = events.iter().position(|event| event.1 == pxs_TraceKind::pxs_TraceHost).unwrap();
+        let exec_end = events.iter().position(|event| !event.0 && event.1 == pxs_TraceKind::pxs_TraceExec).unwrap();
+        assert!(exec_begin < host_begin && host_begin < exec_end);
+
+        let json = own_string!(pxs_tracewriter_stop());
+        println!("{json}");
+        assert!(json.starts_with("{\"traceEvents\":["));
+        assert!(json.contains("\"name\":\"frame \\\"1\\\"\",\"cat\":\"mark\",\"ph\":\"B\""));
+        assert!(json.contains("\"name\":\"_testtick\",\"cat\":\"host\",\"ph\":\"E\""));
+        assert!(json.contains("\"args\":{\"runtime\":\"js\"}"));
+        assert!(json.contains("\"dropped\":0"));
+        assert!(own_string!(pxs_tracewriter_stop()).is_empty());
+
+        // Full writers count what they drop.
+        assert!(pxs_tracewriter_start(2));
+        exec(pxs_Runtime::pxs_Lua, c"local t = require('test')\nt.tick()");
+        let json = own_string!(pxs_tracewriter_stop());
+        assert!(json.contains("\"dropped\":2"));
+
+        pxs_finalize();
+    }
+}
@@ -0,0 +1,151 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_varmap --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use etffi::cstring::CStringSafe;
+    use pixelscript::{
+        pxs_finalize, pxs_freevar, pxs_initialize, pxs_listget, pxs_listlen,
+        pxs_listspan, pxs_map_addpair, pxs_map_delitem, pxs_mapget, pxs_mapiter_begin, pxs_mapiter_next, pxs_mapkeys,
+        pxs_newint, pxs_newlist_i64, pxs_newmap_ordered, pxs_newstring, pxs_varis,
+        shared::{
+            map::pxs_MapIter,
+            utils,
+            var::{pxs_Var, pxs_VarMap, pxs_VarT, pxs_VarType},
+        },
+    };
+
+    fn keys(map: &pxs_VarMap) -> Vec<String> {
+        map.iter().map(|(key, _)| key.to_var().get_string().unwrap()).collect()
+    }
+
+    fn test_string_keys() {
+        let mut map = pxs_VarMap::new();
+        // Past the size that is scanned, long keys are not inline.
+        for i in 0..100 {
+            map.add_str(&format!("key{i}"), pxs_Var::new_i64(i));
+        }
+        map.add_item(pxs_Var::new_string("a much longer key than fits inline".to_string()), pxs_Var::new_i64(-1));
+        map.add_str("key5", pxs_Var::new_i64(50));
+        assert_eq!(map.len(), 101);
+        assert_eq!(map.get_str("key5").unwrap().get_i64().unwrap(), 50);
+        assert_eq!(map.get_item(&pxs_Var::new_string("key99".to_string())).unwrap().get_i64().unwrap(), 99);
+        assert_eq!(map.get_str("a much longer key than fits inline").unwrap().get_i64().unwrap(), -1);
+        assert!(map.get_str("key100").is_none());
+        assert!(map.get_item(&pxs_Var::new_i64(5)).is_none());
+        // Insertion order.
+        assert_eq!(keys(&map)[..3], ["key0", "key1", "key2"]);
+
+        for i in (0..100).step_by(2) {
+            map.del_item(&pxs_Var::new_string(format!("key{i}")));
+        }
+        assert_eq!(map.len(), 51);
+        for i in 0..100 {
+            assert_eq!(map.get_str(&format!("key{i}")).is_some(), i % 2 == 1, "key{i}");
+        }
+
+        // Other keys move the string keys into vars, lookups keep working.
+        map.add_item(pxs_Var::new_i64(7), pxs_Var::new_i64(70));
+        map.add_item(pxs_Var::new_f64(-0.0), pxs_Var::new_i64(0));
+        assert_eq!(map.get_item(&pxs_Var::new_i64(7)).unwrap().get_i64().unwrap(), 70);
+        assert_eq!(map.get_item(&pxs_Var::new_f64(0.0)).unwrap().get_i64().unwrap(), 0);
+        assert_eq!(map.get_str("key99").unwrap().get_i64().unwrap(), 99);
+        assert!(map.get_item(&pxs_Var::new_u64(7)).is_none());
+        assert_eq!(map.len(), 53);
+
+        // Copies share until one changes.
+        let mut copy = map.clone();
+        copy.add_str("new", pxs_Var::new_null());
+        assert!(map.get_str("new").is_none());
+        assert!(!map.is_shared());
+    }
+
+    fn test_ordered() {
+        let mut cstrgen = CStringSafe::new();
+        let map = pxs_newmap_ordered();
+        for (i, key) in ["c", "a", "b", "d"].iter().enumerate() {
+            pxs_map_addpair(map, pxs_newstring(cstrgen.new_string(key)), pxs_newint(i as i64));
+        }
+        let key = pxs_newstring(cstrgen.new_string("a"));
+        pxs_map_delitem(map, key);
+        let missing = pxs_mapget(map, key);
+        assert!(pxs_varis(missing, pxs_VarType::pxs_Exception));
+        pxs_freevar(missing);
+        pxs_freevar(key);
+
+        let list = pxs_mapkeys(map);
+        assert_eq!(pxs_listlen(list), 3);
+        let found: Vec<String> = (0..3).map(|i| unsafe { (*pxs_listget(list, i)).get_string().unwrap() }).collect();
+        assert_eq!(found, ["c", "b", "d"]);
+        pxs_freevar(list);
+
+        assert!(unsafe { (*map).get_map().unwrap().is_ordered() });
+        pxs_freevar(map);
+    }
+
+    /// Keys and values of a iteration, as seen by the host.
+    fn iterate(map: pxs_VarT) -> Vec<(String, i64)> {
+        let mut iter = std::mem::MaybeUninit::<pxs_MapIter>::uninit();
+        assert!(pxs_mapiter_begin(map, iter.as_mut_ptr()));
+        let mut iter = unsafe { iter.assume_init() };
+        let mut key: pxs_VarT = std::ptr::null_mut();
+        let mut value: pxs_VarT = std::ptr::null_mut();
+        let mut pairs = vec![];
+        while pxs_mapiter_next(&mut iter, &mut key, &mut value) {
+            let key = unsafe { &*key };
+            let key = if key.is_string() { key.get_string().unwrap() } else { format!("#{}", key.get_i64().unwrap()) };
+            pairs.push((key, unsafe { (*value).get_i64().unwrap() }));
+        }
+        pairs
+    }
+
+    fn test_iter() {
+        let mut cstrgen = CStringSafe::new();
+        let map = pxs_newmap_ordered();
+        for (i, key) in ["x", "a much longer key than fits inline", "y"].iter().enumerate() {
+            pxs_map_addpair(map, pxs_newstring(cstrgen.new_string(key)), pxs_newint(i as i64));
+        }
+        assert_eq!(iterate(map), [("x".to_string(), 0), ("a much longer key than fits inline".to_string(), 1), ("y".to_string(), 2)]);
+        // Keys that are not strings come from the map itself.
+        pxs_map_addpair(map, pxs_newint(9), pxs_newint(3));
+        assert_eq!(iterate(map)[3], ("#9".to_string(), 3));
+        pxs_freevar(map);
+
+        let not_a_map = pxs_newint(1);
+        let mut iter = std::mem::MaybeUninit::<pxs_MapIter>::uninit();
+        assert!(!pxs_mapiter_begin(not_a_map, iter.as_mut_ptr()));
+        assert!(!pxs_mapiter_next(iter.as_mut_ptr(), std::ptr::null_mut(), std::ptr::null_mut()));
+
+        // Lists are one span.
+        let list = pxs_newlist_i64([4, 5, 6].as_ptr(), 3);
+        let mut len = 0;
+        let span = pxs_listspan(list, &mut len);
+        let items: Vec<i64> = (0..len).map(|i| unsafe { (*span.add(i)).get_i64().unwrap() }).collect();
+        assert_eq!(items, [4, 5, 6]);
+        assert!(pxs_listspan(not_a_map, &mut len).is_null());
+        assert_eq!(len, 0);
+        pxs_freevar(list);
+        pxs_freevar(not_a_map);
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        test_string_keys();
+        test_ordered();
+        test_iter();
+
+        pxs_finalize();
+    }
+}
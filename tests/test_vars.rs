@@ -16,7 +16,7 @@ mod tests {
         pxs_getfloat, pxs_getint, pxs_getstring, pxs_getuint, pxs_initialize, pxs_listadd,
         pxs_listget, pxs_map_addpair, pxs_newarena, pxs_newbool, pxs_newexception, pxs_newfloat,
         pxs_newint, pxs_newlist, pxs_newmap, pxs_newmod, pxs_newnull, pxs_newstring, pxs_newuint,
-        pxs_varcall, pxs_varis,
+        pxs_freevar, pxs_varcall, pxs_varis,
         shared::{
             module::pxs_Module,
             pxs_Runtime,
@@ -185,6 +185,23 @@ vars.asrt(vars.test_map({0:'JS Map'}).name == 'Jordan dayo!')
         assert!(res.is_null(), "JS error is not null: {:#?}", res);
     }
 
+    fn test_pooled() {
+        // Freed nodes are reused, values must not leak between them.
+        for i in 0..1000 {
+            let num = pxs_newint(i);
+            assert_eq!(pxs_getint(num), i);
+            pxs_freevar(num);
+
+            let flag = pxs_newbool(i % 2 == 0);
+            assert_eq!(pxs_getbool(flag), i % 2 == 0);
+            // Pooled nodes can still be transferred like any var.
+            let list = pxs_newlist();
+            pxs_listadd(list, flag);
+            pxs_listadd(list, pxs_newnull());
+            pxs_freevar(list);
+        }
+    }
+
     #[test]
     fn run_test() {
         println!();
@@ -211,6 +228,8 @@ vars.asrt(vars.test_map({0:'JS Map'}).name == 'Jordan dayo!')
         test_lua();
         print_helper("JS");
         test_js();
+        print_helper("POOLED");
+        test_pooled();
 
         pxs_finalize();
     }
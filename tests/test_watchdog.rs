@@ -0,0 +1,115 @@
+// Copyright 2026 Jordan Castro <jordan@grupojvm.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the specific language governing permissions and limitations under the License.
+//
+// cargo test --test test_watchdog --no-default-features --features "lua,python,js,testing" -- --nocapture --test-threads=1
+
+#[cfg(test)]
+#[allow(unused)]
+mod tests {
+    use std::{
+        ffi::{CStr, c_char},
+        sync::Mutex,
+    };
+
+    use pixelscript::{
+        pxs_call, pxs_exec, pxs_finalize, pxs_freevar, pxs_initialize, pxs_newint, pxs_newlist, pxs_setwatchdog,
+        pxs_watchdog_frame,
+        shared::{
+            pxs_Opaque, pxs_Runtime, utils,
+            watchdog::{pxs_SlowCall, pxs_Watchdog},
+        },
+    };
+
+    /// Reports seen: (runtime, file, function, ns, frame_calls, call_ns).
+    static SLOW: Mutex<Vec<(i32, String, String, u64, u32, u64)>> = Mutex::new(vec![]);
+
+    unsafe extern "C" fn on_slow(_opaque: pxs_Opaque, call: *const pxs_SlowCall) {
+        let call = unsafe { &*call };
+        let file = unsafe { CStr::from_ptr(call.file) }.to_string_lossy().to_string();
+        let function = unsafe { CStr::from_ptr(call.function) }.to_string_lossy().to_string();
+        SLOW.lock().unwrap().push((call.runtime, file, function, call.ns, call.frame_calls, call.call_ns));
+    }
+
+    fn exec(runtime: pxs_Runtime, code: &CStr, file: &CStr) {
+        let res = pxs_exec(runtime, code.as_ptr(), file.as_ptr());
+        assert!(res.is_null(), "Error is not null");
+    }
+
+    fn call(runtime: pxs_Runtime, method: &CStr) {
+        let rt = pxs_newint(runtime.into_i64());
+        let res = pxs_call(rt, method.as_ptr(), pxs_newlist());
+        pxs_freevar(res);
+        pxs_freevar(rt);
+    }
+
+    fn take() -> Vec<(i32, String, String, u64, u32, u64)> {
+        std::mem::take(&mut *SLOW.lock().unwrap())
+    }
+
+    #[test]
+    fn run_test() {
+        println!();
+        pxs_initialize();
+        utils::setup_pxs();
+
+        exec(
+            pxs_Runtime::pxs_Lua,
+            c"function fast() end\nfunction slow() local x = 0 for i = 1, 20000000 do x = x + i end end",
+            c"mods/slow.lua",
+        );
+
+        // 20ms for a call, 1s for a frame.
+        let watchdog = pxs_Watchdog { call_us: 20_000, frame_us: 1_000_000, slow: Some(on_slow), opaque: std::ptr::null_mut() };
+        pxs_setwatchdog(&watchdog);
+
+        call(pxs_Runtime::pxs_Lua, c"fast");
+        exec(pxs_Runtime::pxs_Lua, c"local y = 1", c"mods/fast.lua");
+        assert!(take().is_empty());
+
+        call(pxs_Runtime::pxs_Lua, c"slow");
+        exec(pxs_Runtime::pxs_Lua, c"slow()", c"mods/update.lua");
+        let slow = take();
+        assert_eq!(slow.len(), 2, "{:?}", slow);
+        assert_eq!(slow[0].0, pxs_Runtime::pxs_Lua.into_i64() as i32);
+        assert_eq!((slow[0].1.as_str(), slow[0].2.as_str()), ("", "slow"));
+        assert!(slow[0].3 >= 20_000_000);
+        assert_eq!((slow[0].4, slow[0].5), (0, slow[0].3));
+        // The call inside the exec is part of it.
+        assert_eq!((slow[1].1.as_str(), slow[1].2.as_str()), ("mods/update.lua", ""));
+
+        // Under the frame threshold.
+        let ns = pxs_watchdog_frame();
+        assert!(ns >= slow[0].3 + slow[1].3);
+        assert!(take().is_empty());
+
+        // Only frames, the slowest call of it is reported.
+        let watchdog = pxs_Watchdog { call_us: 0, frame_us: 1, slow: Some(on_slow), opaque: std::ptr::null_mut() };
+        pxs_setwatchdog(&watchdog);
+        call(pxs_Runtime::pxs_Lua, c"fast");
+        call(pxs_Runtime::pxs_Lua, c"slow");
+        call(pxs_Runtime::pxs_Lua, c"fast");
+        assert!(take().is_empty());
+        pxs_watchdog_frame();
+        let slow = take();
+        assert_eq!(slow.len(), 1, "{:?}", slow);
+        assert_eq!(slow[0].2, "slow");
+        assert_eq!(slow[0].4, 3);
+        assert!(slow[0].3 >= slow[0].5);
+        // A frame without calls is not reported.
+        assert_eq!(pxs_watchdog_frame(), 0);
+        assert!(take().is_empty());
+
+        // Off.
+        pxs_setwatchdog(std::ptr::null());
+        call(pxs_Runtime::pxs_Lua, c"slow");
+        assert_eq!(pxs_watchdog_frame(), 0);
+        assert!(take().is_empty());
+
+        pxs_finalize();
+    }
+}
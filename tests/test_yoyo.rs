@@ -12,7 +12,7 @@
 #[allow(unused)]
 mod tests {
     use pixelscript::{
-        pxs_finalize, pxs_freearena, pxs_initialize, pxs_newarena, pxs_newmod, pxs_yoyoinit, shared::{module::pxs_Module, pxs_Runtime, utils, var::pxs_VarT},
+        pxs_finalize, pxs_freearena, pxs_initialize, pxs_newarena, pxs_newmod, pxs_yoyofilecache, pxs_yoyoinit, pxs_yoyochannel, pxs_yoyochannelsend, pxs_yoyopump, pxs_yoyochannelrecv, pxs_newint, pxs_getint, pxs_freevar, shared::{module::pxs_Module, pxs_Runtime, utils, var::pxs_VarT},
     };
     use etffi::{cstring::CStringSafe, borrow_string, create_raw_string, free_raw_string, own_string, ptr_magic::PtrMagic};
 
@@ -29,14 +29,211 @@ mod tests {
         execute_yoyo("from yoyo import print, println\nprint('test 1 Python ')\nprintln('test 2 Python')", pxs_Runtime::pxs_Python, "core_py");
         execute_yoyo("local yoyo = require('yoyo') yoyo.print('test 1 Lua ') yoyo.println('test 2 Lua')", pxs_Runtime::pxs_Lua, "core_lua");
         execute_yoyo("import * as yoyo from 'yoyo'; yoyo.print('test 1 JS '); yoyo.println('test 2 JS');", pxs_Runtime::pxs_JavaScript, "core_js");
+        execute_yoyo("from yoyo import log, flush, LOG_DEBUG, LOG_WARN\nlog(LOG_WARN, 'test 3 Python', 3)\nlog(LOG_DEBUG, 'filtered')\nflush()", pxs_Runtime::pxs_Python, "core_log_py");
     }
 
     fn test_net() {
         execute_yoyo(include_str!("../core/yoyo/tests/net.py"), pxs_Runtime::pxs_Python, "net_py");
     }
 
-    // fn test_net() {
-    // }
+    /// Send `request` to the loopback server on `port` and read until it closes the connection.
+    fn http_roundtrip(port: u16, request: &str) -> String {
+        use std::io::{Read, Write};
+        let mut stream = std::net::TcpStream::connect(("127.0.0.1", port)).expect("Could not connect to net.serve");
+        stream.set_read_timeout(Some(std::time::Duration::from_secs(5))).unwrap();
+        stream.write_all(request.as_bytes()).unwrap();
+        let mut response = String::new();
+        stream.read_to_string(&mut response).expect("net.serve did not answer");
+        response
+    }
+
+    /// Split a response into its status line, lowercased headers and body.
+    fn split_response(response: &str) -> (String, Vec<(String, String)>, String) {
+        let (head, body) = response.split_once("\r\n\r\n").expect("No end of headers");
+        let mut lines = head.split("\r\n");
+        let status = lines.next().unwrap().to_string();
+        let headers = lines
+            .filter_map(|line| line.split_once(':'))
+            .map(|(name, value)| (name.trim().to_lowercase(), value.trim().to_string()))
+            .collect();
+        (status, headers, body.to_string())
+    }
+
+    fn header<'a>(headers: &'a [(String, String)], name: &str) -> Option<&'a str> {
+        headers.iter().find(|(n, _)| n == name).map(|(_, v)| v.as_str())
+    }
+
+    fn test_serve() {
+        let name = create_raw_string!("_yoyo_serve");
+        let ch = pxs_yoyochannel(name, 1);
+        unsafe { free_raw_string!(name) };
+
+        execute_yoyo(include_str!("../core/yoyo/tests/serve.py"), pxs_Runtime::pxs_Python, "serve_py");
+        let port_var = pxs_yoyochannelrecv(ch);
+        assert!(!port_var.is_null(), "serve.py did not send its port");
+        let port = pxs_getint(port_var) as u16;
+        pxs_freevar(port_var);
+
+        // Published paths are answered by the I/O thread, no pump needed.
+        let response = http_roundtrip(port, "GET /metrics HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+        let (status, headers, body) = split_response(&response);
+        assert_eq!(status, "HTTP/1.1 200 OK");
+        assert_eq!(header(&headers, "content-length"), Some("11"));
+        assert_eq!(body, "requests 0\n");
+
+        // Other requests wait for the handler, which runs from the pump on this thread.
+        let client = std::thread::spawn(move || {
+            http_roundtrip(
+                port,
+                "POST /echo?x=1 HTTP/1.1\r\nHost: localhost\r\nX-Test: yes\r\nContent-Length: 5\r\nConnection: close\r\n\r\nhello",
+            )
+        });
+        let deadline = std::time::Instant::now() + std::time::Duration::from_secs(5);
+        while !client.is_finished() && std::time::Instant::now() < deadline {
+            pxs_yoyopump();
+            std::thread::sleep(std::time::Duration::from_millis(1));
+        }
+        let response = client.join().unwrap();
+        let (status, headers, body) = split_response(&response);
+        assert_eq!(status, "HTTP/1.1 201 Created");
+        assert_eq!(header(&headers, "x-yoyo"), Some("yes"));
+        assert_eq!(header(&headers, "content-type"), Some("text/x-yoyo"));
+        assert_eq!(header(&headers, "connection"), Some("close"));
+        assert_eq!(body, "POST /echo x=1 hello");
+        assert_eq!(header(&headers, "content-length"), Some(body.len().to_string().as_str()));
+
+        execute_yoyo("server.close()", pxs_Runtime::pxs_Python, "serve_close_py");
+    }
+
+    fn test_fs() {
+        execute_yoyo(include_str!("../core/yoyo/tests/fs.py"), pxs_Runtime::pxs_Python, "fs_py");
+    }
+
+    fn test_zip() {
+        execute_yoyo(include_str!("../core/yoyo/tests/zip.py"), pxs_Runtime::pxs_Python, "zip_py");
+    }
+
+    fn test_yaml() {
+        execute_yoyo(include_str!("../core/yoyo/tests/yaml.py"), pxs_Runtime::pxs_Python, "yaml_py");
+        execute_yoyo(
+            r#"
+local yaml = require('yoyo').yaml
+local value = yaml.load("name: mod\nlist: [1, 2.5, x]\n")
+assert(value.name == "mod" and value.list[2] == 2.5 and value.list[3] == "x")
+assert(yaml.load(yaml.dump(value)).list[1] == 1)
+assert(not pcall(yaml.load, "a: [1}"))
+"#,
+            pxs_Runtime::pxs_Lua,
+            "yaml_lua",
+        );
+    }
+
+    fn test_array() {
+        execute_yoyo(include_str!("../core/yoyo/tests/array.py"), pxs_Runtime::pxs_Python, "array_py");
+        execute_yoyo(
+            r#"
+local array = require('yoyo').array
+local a = array.of(array.F64, {1, 2, 3})
+a:add(a)
+assert(a:sum() == 12 and a:get(-1) == 6)
+assert(not pcall(a.get, a, 3))
+"#,
+            pxs_Runtime::pxs_Lua,
+            "array_lua",
+        );
+    }
+
+    fn test_pxs() {
+        execute_yoyo(
+            r#"
+from yoyo import pxs
+
+code = pxs.compile(pxs.LUA, "assert(n > 0)")
+assert code.runtime == pxs.LUA
+for i in range(1, 4):
+    pxs.run(code, {"n": i})
+try:
+    pxs.run(code, {"n": 0})
+    assert False
+except Exception:
+    pass
+assert pxs.eval(pxs.LUA, "return 1 + 2") == 3
+"#,
+            pxs_Runtime::pxs_Python,
+            "pxs_py",
+        );
+    }
+
+    fn test_task() {
+        // The workers require the module from disk.
+        pxs_yoyofilecache(1 << 20);
+        execute_yoyo(include_str!("../core/yoyo/tests/task.py"), pxs_Runtime::pxs_Python, "task_py");
+    }
+
+    fn test_channel() {
+        let name = create_raw_string!("_yoyo_test");
+        let ch = pxs_yoyochannel(name, 8);
+        unsafe { free_raw_string!(name) };
+        let value = pxs_newint(42);
+        assert!(pxs_yoyochannelsend(ch, value));
+        pxs_freevar(value);
+
+        execute_yoyo(include_str!("../core/yoyo/tests/channel.py"), pxs_Runtime::pxs_Python, "channel_py");
+
+        let back = pxs_yoyochannelrecv(ch);
+        assert!(!back.is_null());
+        assert_eq!(pxs_getint(back), 7);
+        pxs_freevar(back);
+        assert!(pxs_yoyochannelrecv(ch).is_null());
+    }
+
+    fn test_time() {
+        execute_yoyo(include_str!("../core/yoyo/tests/time.py"), pxs_Runtime::pxs_Python, "time_py");
+
+        let name = create_raw_string!("_yoyo_time");
+        let ch = pxs_yoyochannel(name, 0);
+        unsafe { free_raw_string!(name) };
+
+        let mut fired = vec![];
+        for _ in 0..3 {
+            std::thread::sleep(std::time::Duration::from_millis(5));
+            pxs_yoyopump();
+            loop {
+                let value = pxs_yoyochannelrecv(ch);
+                if value.is_null() {
+                    break;
+                }
+                fired.push(pxs_getint(value));
+                pxs_freevar(value);
+            }
+        }
+        assert_eq!(fired.iter().filter(|&&v| v == 1).count(), 1);
+        // At most once per pump.
+        assert_eq!(fired.iter().filter(|&&v| v == 2).count(), 3);
+        assert!(!fired.contains(&3));
+    }
+
+    fn test_shm() {
+        execute_yoyo(include_str!("../core/yoyo/tests/shm.py"), pxs_Runtime::pxs_Python, "shm_py");
+    }
+
+    fn test_compress() {
+        execute_yoyo(include_str!("../core/yoyo/tests/compress.py"), pxs_Runtime::pxs_Python, "compress_py");
+    }
+
+    fn test_hash() {
+        execute_yoyo(include_str!("../core/yoyo/tests/hash.py"), pxs_Runtime::pxs_Python, "hash_py");
+    }
+
+    fn test_os() {
+        execute_yoyo(include_str!("../core/yoyo/tests/os.py"), pxs_Runtime::pxs_Python, "os_py");
+    }
+
+    fn test_shell() {
+        // Uses `sh`.
+        #[cfg(unix)]
+        execute_yoyo(include_str!("../core/yoyo/tests/shell.py"), pxs_Runtime::pxs_Python, "shell_py");
+    }
 
     #[test]
     fn run_test() {
@@ -51,8 +248,34 @@ mod tests {
         print_helper("net");
         // test_net();
         // print_helper("net");
-        // print_helper("fs");
-        // print_helper("zip");
+        print_helper("serve");
+        test_serve();
+        print_helper("fs");
+        test_fs();
+        print_helper("zip");
+        test_zip();
+        print_helper("yaml");
+        test_yaml();
+        print_helper("array");
+        test_array();
+        print_helper("pxs");
+        test_pxs();
+        print_helper("task");
+        test_task();
+        print_helper("channel");
+        test_channel();
+        print_helper("time");
+        test_time();
+        print_helper("shm");
+        test_shm();
+        print_helper("compress");
+        test_compress();
+        print_helper("hash");
+        test_hash();
+        print_helper("os");
+        test_os();
+        print_helper("shell");
+        test_shell();
 
         pxs_finalize();
     }